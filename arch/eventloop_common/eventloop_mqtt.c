@@ -71,8 +71,11 @@ static ssize_t mqtt_pal_recvall(mqtt_pal_socket_handle fd, void* buf, size_t buf
 #include "../../deps/mqtt-c/src/mqtt.c"
 
 #define MQTT_MESSAGE_MAXLEN (1u << 20) /* 1MB */
-#define MQTT_PARAMETERSSIZE 8
-#define MQTT_BROKERPARAMETERSSIZE 5 /* Parameters shared by topic connections
+#define MQTT_SENDBUFFER_DEFAULT (1u << 16) /* 64kB */
+#define MQTT_SENDBUFFER_MIN 1024
+#define MQTT_MAXINFLIGHT_DEFAULT 64
+#define MQTT_PARAMETERSSIZE 11
+#define MQTT_BROKERPARAMETERSSIZE 7 /* Parameters shared by topic connections
                                      * connected to the same broker */
 
 static const struct {
@@ -85,9 +88,12 @@ static const struct {
     {{0, UA_STRING_STATIC("keep-alive")}, &UA_TYPES[UA_TYPES_UINT16], false},
     {{0, UA_STRING_STATIC("username")}, &UA_TYPES[UA_TYPES_STRING], false},
     {{0, UA_STRING_STATIC("password")}, &UA_TYPES[UA_TYPES_STRING], false},
+    {{0, UA_STRING_STATIC("send-buffer-size")}, &UA_TYPES[UA_TYPES_UINT32], false},
+    {{0, UA_STRING_STATIC("max-inflight")}, &UA_TYPES[UA_TYPES_UINT16], false},
     {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false},
     {{0, UA_STRING_STATIC("subscribe")}, &UA_TYPES[UA_TYPES_BOOLEAN], false},
-    {{0, UA_STRING_STATIC("topic")}, &UA_TYPES[UA_TYPES_STRING], true}
+    {{0, UA_STRING_STATIC("topic")}, &UA_TYPES[UA_TYPES_STRING], true},
+    {{0, UA_STRING_STATIC("qos")}, &UA_TYPES[UA_TYPES_BYTE], false}
 };
 
 /* The BrokerConnection is a stateful connection to the broker that aggregates
@@ -108,6 +114,21 @@ struct MQTTBrokerConnection {
     UA_UInt16 keepalive;      /* Seconds between keepalives */
     UA_UInt64 keepAliveCallbackId; /* Registered callback to send the keepalive */
 
+    /* The published messages are queued in the MQTT client. All queued
+     * messages are flushed with a single TCP send once per EventLoop
+     * iteration. */
+    UA_UInt32 sendBufferSize; /* Memory budget of the send queue */
+    UA_UInt16 maxInflight;    /* Published messages queued or awaiting the
+                               * PUBACK */
+    UA_Boolean flushScheduled;
+    UA_DelayedCallback flushCallback;
+    UA_Boolean batching;      /* Collect the packets in the batch buffer */
+    UA_ByteString batch;
+    size_t batchLength;
+    UA_UInt64 publishedMessages;
+    UA_UInt64 rejectedMessages;
+    UA_UInt64 flushes;
+
     /* Topic connections sharing the same connection to a broker */
     LIST_HEAD(, MQTTTopicConnection) topicConnections;
     uintptr_t lastTopicConnectionId;
@@ -128,6 +149,7 @@ struct MQTTTopicConnection {
 
     UA_String topic;      /* Name of the topic */
     UA_Boolean subscribe; /* Subscribe or publish? */
+    UA_Byte qos;          /* QoS level for publishing */
 
     /* Backpointer to the connection to the broker (is always set) */
     MQTTBrokerConnection *brokerConnection;
@@ -155,6 +177,16 @@ mqtt_pal_sendall(MQTTBrokerConnection *bc, const void* buf, size_t len, int flag
     if(bc->tcpConnectionState != UA_CONNECTIONSTATE_ESTABLISHED)
         return MQTT_ERROR_SOCKET_ERROR;
 
+    /* Append to the batch during the flush. The batch buffer is large enough
+     * for all messages in the send queue. */
+    if(bc->batching) {
+        if(bc->batchLength + len > bc->batch.length)
+            return MQTT_ERROR_SOCKET_ERROR;
+        memcpy(&bc->batch.data[bc->batchLength], buf, len);
+        bc->batchLength += len;
+        return (ssize_t)len;
+    }
+
     UA_ByteString msg = UA_BYTESTRING_NULL;
     UA_ConnectionManager *tcpCM = bc->mcm->tcpCM;
     UA_StatusCode res = tcpCM->allocNetworkBuffer(tcpCM, bc->tcpConnectionId, &msg, len);
@@ -178,6 +210,80 @@ mqtt_pal_recvall(MQTTBrokerConnection *bc, void* buf, size_t bufsz, int flags) {
     return 0;
 }
 
+/* Send all queued packets with a single TCP send. The sent packets are at most
+ * the used part of the send queue. */
+static void
+flushBrokerConnection(MQTTBrokerConnection *bc) {
+    if(bc->tcpConnectionState != UA_CONNECTIONSTATE_ESTABLISHED)
+        return;
+    struct mqtt_message_queue *mq = &bc->client.mq;
+    size_t used = (size_t)(mq->curr - (uint8_t*)mq->mem_start);
+    if(used == 0)
+        return;
+
+    /* Allocate the batch buffer. Send the packets individually if that
+     * fails. */
+    UA_ConnectionManager *tcpCM = bc->mcm->tcpCM;
+    UA_StatusCode res =
+        tcpCM->allocNetworkBuffer(tcpCM, bc->tcpConnectionId, &bc->batch, used);
+    if(res != UA_STATUSCODE_GOOD) {
+        __mqtt_send(&bc->client);
+        return;
+    }
+
+    /* Collect the packets */
+    bc->batching = true;
+    bc->batchLength = 0;
+    __mqtt_send(&bc->client);
+    bc->batching = false;
+    if(bc->batchLength == 0) {
+        tcpCM->freeNetworkBuffer(tcpCM, bc->tcpConnectionId, &bc->batch);
+        return;
+    }
+
+    /* Send out */
+    bc->batch.length = bc->batchLength;
+    tcpCM->sendWithConnection(tcpCM, bc->tcpConnectionId,
+                              &UA_KEYVALUEMAP_NULL, &bc->batch);
+    bc->batch = UA_BYTESTRING_NULL;
+    bc->lastSendTime = UA_DateTime_nowMonotonic();
+    bc->flushes++;
+}
+
+static void
+flushBrokerConnectionDelayed(void *application, void *context) {
+    MQTTBrokerConnection *bc = (MQTTBrokerConnection*)context;
+    bc->flushScheduled = false;
+    flushBrokerConnection(bc);
+}
+
+/* Count the published messages in the send queue */
+static void
+countQueuedMessages(MQTTBrokerConnection *bc, size_t *inflight, size_t *queued) {
+    *inflight = 0;
+    *queued = 0;
+    struct mqtt_message_queue *mq = &bc->client.mq;
+    ssize_t len = mqtt_mq_length(mq);
+    for(ssize_t i = 0; i < len; i++) {
+        struct mqtt_queued_message *qm = mqtt_mq_get(mq, i);
+        if(qm->control_type != MQTT_CONTROL_PUBLISH)
+            continue;
+        if(qm->state == MQTT_QUEUED_AWAITING_ACK)
+            (*inflight)++;
+        else if(qm->state == MQTT_QUEUED_UNSENT)
+            (*queued)++;
+    }
+}
+
+/* Size of the PUBLISH packet in the send queue */
+static size_t
+publishPacketSize(const MQTTTopicConnection *tc, size_t msgLength) {
+    size_t remaining = 2 + tc->topic.length + ((tc->qos > 0) ? 2 : 0) + msgLength;
+    size_t lengthBytes = (remaining < 128) ? 1 : (remaining < 16384) ? 2 :
+        (remaining < 2097152) ? 3 : 4;
+    return 1 + lengthBytes + remaining;
+}
+
 static UA_StatusCode
 MQTT_eventSourceStart(UA_ConnectionManager *cm) {
     MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
@@ -335,10 +441,12 @@ removeBrokerConnection(MQTTBrokerConnection *bc) {
     UA_LOG_DEBUG(bc->mcm->cm.eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
                  "MQTT-TCP %u\t| Removing the broker connection", (unsigned)bc->tcpConnectionId);
 
-    /* Remove the keepalive callback */
+    /* Remove the keepalive callback and the pending flush */
     if(bc->keepAliveCallbackId > 0)
         el->removeCyclicCallback(el, bc->keepAliveCallbackId);
-    
+    if(bc->flushScheduled)
+        el->removeDelayedCallback(el, &bc->flushCallback);
+
     /* Remove from linked list */
     LIST_REMOVE(bc, next);
 
@@ -366,7 +474,8 @@ findIdenticalBrokerConnection(MQTTConnectionManager *mcm, const UA_KeyValueMap *
     LIST_FOREACH(bc, &mcm->connections, next) {
         UA_Boolean found = true;
         for(size_t i = 0; i < MQTT_BROKERPARAMETERSSIZE; i++) {
-            const UA_Variant *v1 = UA_KeyValueMap_get(kvm, MQTTConnectionParameters[i].name);
+            const UA_Variant *v1 =
+                UA_KeyValueMap_get(&bc->params, MQTTConnectionParameters[i].name);
             const UA_Variant *v2 = UA_KeyValueMap_get(kvm, MQTTConnectionParameters[i].name);
             if(v1 == v2)
                 continue;
@@ -501,7 +610,7 @@ MQTTNetworkCallback(UA_ConnectionManager *tcpCM, uintptr_t connectionId,
         /* Initialize the MQTT client. We have to call mqtt_connect right afterward.
          * Otherwise the client lock is not released. */
         mqtt_init(&bc->client, bc,
-                  (uint8_t*)UA_calloc(1,1024), 1024,
+                  (uint8_t*)UA_calloc(1, bc->sendBufferSize), bc->sendBufferSize,
                   (uint8_t*)UA_calloc(1,1024), 1024,
                   MQTTPublishResponseCallback);
 
@@ -618,6 +727,28 @@ createBrokerConnection(MQTTConnectionManager *mcm, const UA_KeyValueMap *params,
     if(keepAlive && *keepAlive > 0)
         bc->keepalive = *keepAlive;
 
+    /* Configure the send queue */
+    const UA_UInt32 *sendBufferSize = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params,
+                                 UA_QUALIFIEDNAME(0, "send-buffer-size"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    bc->sendBufferSize = MQTT_SENDBUFFER_DEFAULT;
+    if(sendBufferSize)
+        bc->sendBufferSize = (*sendBufferSize > MQTT_SENDBUFFER_MIN) ?
+            *sendBufferSize : MQTT_SENDBUFFER_MIN;
+
+    const UA_UInt16 *maxInflight = (const UA_UInt16*)
+        UA_KeyValueMap_getScalar(params,
+                                 UA_QUALIFIEDNAME(0, "max-inflight"),
+                                 &UA_TYPES[UA_TYPES_UINT16]);
+    bc->maxInflight = MQTT_MAXINFLIGHT_DEFAULT;
+    if(maxInflight && *maxInflight > 0)
+        bc->maxInflight = *maxInflight;
+
+    bc->flushCallback.callback = flushBrokerConnectionDelayed;
+    bc->flushCallback.application = NULL;
+    bc->flushCallback.context = bc;
+
     /* Open the Connection. This also sets the broker connection id to the TCP id. */
     UA_KeyValuePair tcpParams[3];
     tcpParams[0].key = UA_QUALIFIEDNAME(0, "address");
@@ -675,6 +806,16 @@ createTopicConnection(MQTTConnectionManager *mcm, MQTTBrokerConnection *bc,
     if(topic->length == 0)
         return NULL;
 
+    /* QoS 2 is not supported */
+    UA_Byte qos = 0;
+    const UA_Byte *_qos = (const UA_Byte*)
+        UA_KeyValueMap_getScalar(params, UA_QUALIFIEDNAME(0, "qos"),
+                                 &UA_TYPES[UA_TYPES_BYTE]);
+    if(_qos)
+        qos = *_qos;
+    if(qos > 1)
+        return NULL;
+
     MQTTTopicConnection *tc = (MQTTTopicConnection*)
         UA_calloc(1, sizeof(MQTTTopicConnection));
     if(!tc)
@@ -685,6 +826,7 @@ createTopicConnection(MQTTConnectionManager *mcm, MQTTBrokerConnection *bc,
     tc->brokerConnection = bc;
     tc->topicConnectionId = (bc->tcpConnectionId * 1000) + (++bc->lastTopicConnectionId);
     tc->subscribe = subscribe;
+    tc->qos = qos;
 
     /* Make a null-terminated copy of the topic string to forward to the MQTT client. */
     tc->topic.data = (UA_Byte*)UA_malloc(topic->length + 1);
@@ -802,12 +944,72 @@ MQTT_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                  "a message with %u bytes", (unsigned)tc->topicConnectionId,
                  (char*)tc->topic.data, (unsigned)buf->length);
 
+    /* Check the in-flight window */
+    size_t inflight, queued;
+    countQueuedMessages(bc, &inflight, &queued);
+    if(inflight + queued >= bc->maxInflight) {
+        bc->rejectedMessages++;
+        UA_ByteString_clear(buf);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+
+    /* Check the memory budget of the send queue. Free the space of completed
+     * messages and flush if required. The message must not be packed into a
+     * full send queue. That is a permanent error in the MQTT client. */
+    struct mqtt_message_queue *mq = &bc->client.mq;
+    size_t packetSize = publishPacketSize(tc, buf->length);
+    if((size_t)mqtt_mq_currsz(mq) < packetSize) {
+        flushBrokerConnection(bc);
+        mqtt_mq_clean(mq);
+    }
+    if((size_t)mqtt_mq_currsz(mq) < packetSize) {
+        bc->rejectedMessages++;
+        UA_ByteString_clear(buf);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+
+    /* Queue the message */
+    uint8_t flags = (tc->qos > 0) ? MQTT_PUBLISH_QOS_1 : MQTT_PUBLISH_QOS_0;
     enum MQTTErrors res = mqtt_publish(&bc->client, (const char*)tc->topic.data,
-                                       buf->data, buf->length, 0);
-    if(UA_LIKELY(res == MQTT_OK))
-        res = (enum MQTTErrors)__mqtt_send(&bc->client);
+                                       buf->data, buf->length, flags);
     UA_ByteString_clear(buf);
-    return (res == MQTT_OK) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADINTERNALERROR;
+    if(res != MQTT_OK)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    bc->publishedMessages++;
+
+    /* Flush in the next EventLoop iteration. Messages published until then
+     * are sent together. */
+    if(!bc->flushScheduled) {
+        UA_EventLoop *el = mcm->cm.eventSource.eventLoop;
+        el->addDelayedCallback(el, &bc->flushCallback);
+        bc->flushScheduled = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ConnectionManager_MQTT_getStatistics(UA_ConnectionManager *cm,
+                                        uintptr_t connectionId,
+                                        UA_MQTTConnectionStatistics *stats) {
+    MQTTConnectionManager *mcm = (MQTTConnectionManager*)cm;
+    MQTTTopicConnection *tc = findTopicConnection(mcm, connectionId);
+    if(!tc)
+        return UA_STATUSCODE_BADNOTFOUND;
+
+    memset(stats, 0, sizeof(UA_MQTTConnectionStatistics));
+    MQTTBrokerConnection *bc = tc->brokerConnection;
+    stats->queueCapacity = bc->sendBufferSize;
+    stats->publishedMessages = bc->publishedMessages;
+    stats->rejectedMessages = bc->rejectedMessages;
+    stats->flushes = bc->flushes;
+
+    /* The MQTT client is initialized when the TCP connection is established */
+    if(bc->client.mq.mem_start) {
+        countQueuedMessages(bc, &stats->inflight, &stats->queued);
+        stats->queueBytes = (size_t)(bc->client.mq.curr -
+                                     (uint8_t*)bc->client.mq.mem_start);
+    }
+    return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
@@ -9,21 +9,129 @@
 #include "timer.h"
 
 static enum ZIP_CMP
-cmpDateTime(const UA_DateTime *a, const UA_DateTime *b) {
+cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
     if(*a == *b)
         return ZIP_CMP_EQ;
     return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
 }
 
+ZIP_FUNCTIONS(UA_TimerIdTree, UA_TimerEntry, idTreeEntry, UA_UInt64, id, cmpId)
+
+#ifndef UA_ENABLE_TIMER_WHEEL
+
 static enum ZIP_CMP
-cmpId(const UA_UInt64 *a, const UA_UInt64 *b) {
+cmpDateTime(const UA_DateTime *a, const UA_DateTime *b) {
     if(*a == *b)
         return ZIP_CMP_EQ;
     return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
 }
 
 ZIP_FUNCTIONS(UA_TimerTree, UA_TimerEntry, treeEntry, UA_DateTime, nextTime, cmpDateTime)
-ZIP_FUNCTIONS(UA_TimerIdTree, UA_TimerEntry, idTreeEntry, UA_UInt64, id, cmpId)
+
+static void
+timeInsert(UA_Timer *t, UA_TimerEntry *te) {
+    ZIP_INSERT(UA_TimerTree, &t->tree, te);
+}
+
+/* Returns false if the entry is currently processed (not in the tree) */
+static UA_Boolean
+timeRemove(UA_Timer *t, UA_TimerEntry *te) {
+    return (ZIP_REMOVE(UA_TimerTree, &t->tree, te) != NULL);
+}
+
+static UA_Boolean
+isProcessing(UA_Timer *t, UA_TimerEntry *te) {
+    return (t->processTree.root != NULL);
+}
+
+static UA_DateTime
+timeNext(UA_Timer *t) {
+    UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
+    return (first) ? first->nextTime : UA_INT64_MAX;
+}
+
+#else /* UA_ENABLE_TIMER_WHEEL */
+
+static UA_Int64
+toTick(UA_DateTime time) {
+    return (time > 0) ? time / UA_TIMER_WHEEL_TICK : 0;
+}
+
+static void
+timeInsert(UA_Timer *t, UA_TimerEntry *te) {
+    /* Entries in the past are added to the current slot */
+    UA_Int64 tick = toTick(te->nextTime);
+    if(tick < t->currentTick)
+        tick = t->currentTick;
+
+    /* Select the level. Entries beyond the range of the highest level are added
+     * to its last slot. They are put back where they belong when the slot is
+     * cascaded. */
+    UA_UInt64 delta = (UA_UInt64)(tick - t->currentTick);
+    UA_Byte level = 0;
+    while(level < UA_TIMER_WHEEL_LEVELS - 1 &&
+          delta >= ((UA_UInt64)1 << (UA_TIMER_WHEEL_BITS * (level + 1))))
+        level++;
+    unsigned shift = UA_TIMER_WHEEL_BITS * level;
+    if(delta >= ((UA_UInt64)1 << (shift + UA_TIMER_WHEEL_BITS)))
+        tick = t->currentTick + ((UA_Int64)(UA_TIMER_WHEEL_SLOTS - 1) << shift);
+
+    size_t slot = (size_t)(tick >> shift) & (UA_TIMER_WHEEL_SLOTS - 1);
+    te->level = level;
+    te->processing = false;
+    LIST_INSERT_HEAD(&t->wheel[level][slot], te, slotEntry);
+    t->levelCount[level]++;
+}
+
+static UA_Boolean
+timeRemove(UA_Timer *t, UA_TimerEntry *te) {
+    if(te->processing)
+        return false;
+    LIST_REMOVE(te, slotEntry);
+    t->levelCount[te->level]--;
+    return true;
+}
+
+static UA_Boolean
+isProcessing(UA_Timer *t, UA_TimerEntry *te) {
+    return te->processing;
+}
+
+/* Returns the earliest time when an entry can be due. For level 0 this is
+ * exact. For the higher levels this is the time when the next slot is
+ * cascaded. (The blocks of the higher levels can begin before the last slot of
+ * level 0.) */
+static UA_DateTime
+timeNext(UA_Timer *t) {
+    UA_DateTime next = UA_INT64_MAX;
+    for(size_t level = 0; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        if(t->levelCount[level] == 0)
+            continue;
+        unsigned shift = (unsigned)(UA_TIMER_WHEEL_BITS * level);
+        UA_Int64 current = t->currentTick >> shift;
+        /* The current block of the higher levels is already cascaded */
+        for(UA_Int64 i = (level == 0) ? 0 : 1; i <= UA_TIMER_WHEEL_SLOTS; i++) {
+            size_t slot = (size_t)(current + i) & (UA_TIMER_WHEEL_SLOTS - 1);
+            UA_TimerEntry *te = LIST_FIRST(&t->wheel[level][slot]);
+            if(!te)
+                continue;
+            if(level > 0) {
+                UA_DateTime start = ((current + i) << shift) * UA_TIMER_WHEEL_TICK;
+                if(start < next)
+                    next = start;
+                break;
+            }
+            for(; te; te = LIST_NEXT(te, slotEntry)) {
+                if(te->nextTime < next)
+                    next = te->nextTime;
+            }
+            break;
+        }
+    }
+    return next;
+}
+
+#endif /* UA_ENABLE_TIMER_WHEEL */
 
 static UA_DateTime
 calculateNextTime(UA_DateTime currentTime, UA_DateTime baseTime,
@@ -75,7 +183,13 @@ addCallback(UA_Timer *t, UA_ApplicationCallback callback, void *application,
     if(callbackId)
         *callbackId = te->id;
 
-    ZIP_INSERT(UA_TimerTree, &t->tree, te);
+#ifdef UA_ENABLE_TIMER_WHEEL
+    /* Don't start the empty wheel at tick zero */
+    if(!t->idTree.root && !t->processing)
+        t->currentTick = toTick(nextTime);
+#endif
+
+    timeInsert(t, te);
     ZIP_INSERT(UA_TimerIdTree, &t->idTree, te);
     return UA_STATUSCODE_GOOD;
 }
@@ -145,7 +259,7 @@ UA_Timer_changeRepeatedCallback(UA_Timer *t, UA_UInt64 callbackId,
     /* Try to remove from the time-sorted tree. If not found, then the entry is
      * in the processTree. If that is the case, leave it there and only adjust
      * the interval and nextTime (if the TimerPolicy uses a basetime). */
-    UA_Boolean normalTree = (ZIP_REMOVE(UA_TimerTree, &t->tree, te) != NULL);
+    UA_Boolean normalTree = timeRemove(t, te);
 
     /* Compute the next time for execution. The logic is identical to the
      * creation of a new repeated callback. */
@@ -160,7 +274,7 @@ UA_Timer_changeRepeatedCallback(UA_Timer *t, UA_UInt64 callbackId,
     te->timerPolicy = timerPolicy;
 
     if(normalTree)
-        ZIP_INSERT(UA_TimerTree, &t->tree, te);
+        timeInsert(t, te);
 
     UA_UNLOCK(&t->timerMutex);
     return UA_STATUSCODE_GOOD;
@@ -171,9 +285,9 @@ UA_Timer_removeCallback(UA_Timer *t, UA_UInt64 callbackId) {
     UA_LOCK(&t->timerMutex);
     UA_TimerEntry *te = ZIP_FIND(UA_TimerIdTree, &t->idTree, &callbackId);
     if(UA_LIKELY(te != NULL)) {
-        if(t->processTree.root == NULL) {
+        if(!isProcessing(t, te)) {
             /* Remove/free the entry */
-            ZIP_REMOVE(UA_TimerTree, &t->tree, te);
+            timeRemove(t, te);
             ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
             UA_free(te);
         } else {
@@ -186,23 +300,41 @@ UA_Timer_removeCallback(UA_Timer *t, UA_UInt64 callbackId) {
     UA_UNLOCK(&t->timerMutex);
 }
 
-struct TimerProcessContext {
-    UA_Timer *t;
-    UA_DateTime now;
-};
-
-static void *
-processEntryCallback(void *context, UA_TimerEntry *te) {
-    struct TimerProcessContext *tpc = (struct TimerProcessContext*)context;
-    UA_Timer *t = tpc->t;
-
+static void
+processEntry(UA_Timer *t, UA_TimerEntry *te, UA_DateTime now) {
     /* Execute the callback. The memory is not freed during the callback.
-     * Instead, whenever t->processTree != NULL, the entries are only marked for
-     * deletion by setting elm->callback to NULL. */
+     * Instead, whenever the entry is processed, it is only marked for deletion
+     * by setting elm->callback to NULL. */
     if(te->callback) {
+        UA_UInt64 lag = (now > te->nextTime) ? (UA_UInt64)(now - te->nextTime) : 0;
+        t->callbackCount++;
+        t->lag += lag;
+        if(lag > t->maxLag)
+            t->maxLag = lag;
+        size_t bucket = 0;
+        while(bucket < UA_EVENTLOOP_LAGBUCKETS - 1 && (lag >> (bucket + 1)) > 0)
+            bucket++;
+        t->lagBuckets[bucket]++;
+
+        /* Copy the callback. The entry can be modified during the callback. */
+        UA_ApplicationCallback cb = te->callback;
+        void *application = te->application;
+        UA_DateTime threshold = t->slowThreshold;
         UA_UNLOCK(&t->timerMutex);
-        te->callback(te->application, te->data);
-        UA_LOCK(&t->timerMutex);
+        if(threshold <= 0) {
+            cb(application, te->data);
+            UA_LOCK(&t->timerMutex);
+        } else {
+            UA_DateTime start = UA_DateTime_nowMonotonic();
+            cb(application, te->data);
+            UA_DateTime runtime = UA_DateTime_nowMonotonic() - start;
+            if(runtime >= threshold && t->slowCallback)
+                t->slowCallback(t->slowContext, cb, application,
+                                runtime, (UA_DateTime)lag);
+            UA_LOCK(&t->timerMutex);
+            if(runtime >= threshold)
+                t->slowCount++;
+        }
     }
 
     /* Remove and free the entry if marked for deletion or a one-time timed
@@ -210,7 +342,7 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
     if(!te->callback || te->interval == 0) {
         ZIP_REMOVE(UA_TimerIdTree, &t->idTree, te);
         UA_free(te);
-        return NULL;
+        return;
     }
 
     /* Set the time for the next regular execution */
@@ -224,16 +356,29 @@ processEntryCallback(void *context, UA_TimerEntry *te) {
      * which the spec says: The sampling interval indicates the fastest rate
      * at which the Server should sample its underlying source for data
      * changes. (Part 4, 5.12.1.2) */
-    if(te->nextTime < tpc->now) {
+    if(te->nextTime < now) {
         if(te->timerPolicy == UA_TIMER_HANDLE_CYCLEMISS_WITH_BASETIME)
-            te->nextTime = calculateNextTime(tpc->now, te->nextTime,
+            te->nextTime = calculateNextTime(now, te->nextTime,
                                               (UA_DateTime)te->interval);
         else
-            te->nextTime = tpc->now + (UA_DateTime)te->interval;
+            te->nextTime = now + (UA_DateTime)te->interval;
     }
 
     /* Insert back into the time-sorted tree */
-    ZIP_INSERT(UA_TimerTree, &t->tree, te);
+    timeInsert(t, te);
+}
+
+#ifndef UA_ENABLE_TIMER_WHEEL
+
+struct TimerProcessContext {
+    UA_Timer *t;
+    UA_DateTime now;
+};
+
+static void *
+processEntryCallback(void *context, UA_TimerEntry *te) {
+    struct TimerProcessContext *tpc = (struct TimerProcessContext*)context;
+    processEntry(tpc->t, te, tpc->now);
     return NULL;
 }
 
@@ -262,17 +407,107 @@ UA_Timer_process(UA_Timer *t, UA_DateTime now) {
     }
 
     /* Compute the timestamp of the earliest next callback */
-    UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
-    UA_DateTime next = (first) ? first->nextTime : UA_INT64_MAX;
+    UA_DateTime next = timeNext(t);
     UA_UNLOCK(&t->timerMutex);
     return next;
 }
 
+#else /* UA_ENABLE_TIMER_WHEEL */
+
+/* Process the due entries in the slot of the current tick */
+static void
+processCurrentTick(UA_Timer *t, UA_DateTime now) {
+    /* Detach the slot */
+    size_t slot = (size_t)t->currentTick & (UA_TIMER_WHEEL_SLOTS - 1);
+    UA_TimerEntry *te, *te_tmp;
+    LIST_FOREACH_SAFE(te, &t->wheel[0][slot], slotEntry, te_tmp) {
+        LIST_REMOVE(te, slotEntry);
+        t->levelCount[0]--;
+        te->processing = true;
+        LIST_INSERT_HEAD(&t->processSlot, te, slotEntry);
+    }
+
+    /* Entries can be removed from the process list in the callbacks (they are
+     * only marked as deleted). Entries that are not yet due (in the current
+     * tick) go back. */
+    while((te = LIST_FIRST(&t->processSlot))) {
+        LIST_REMOVE(te, slotEntry);
+        if(te->callback && te->nextTime > now) {
+            timeInsert(t, te);
+            continue;
+        }
+        processEntry(t, te, now);
+    }
+}
+
+/* Move the entries of the higher-level slots that begin at the current tick to
+ * the lower levels */
+static void
+cascade(UA_Timer *t) {
+    for(size_t level = 1; level < UA_TIMER_WHEEL_LEVELS; level++) {
+        unsigned shift = (unsigned)(UA_TIMER_WHEEL_BITS * level);
+        if(t->currentTick & (((UA_Int64)1 << shift) - 1))
+            return;
+        size_t slot = (size_t)(t->currentTick >> shift) & (UA_TIMER_WHEEL_SLOTS - 1);
+        UA_TimerEntry *te, *te_tmp;
+        LIST_FOREACH_SAFE(te, &t->wheel[level][slot], slotEntry, te_tmp) {
+            LIST_REMOVE(te, slotEntry);
+            t->levelCount[level]--;
+            timeInsert(t, te);
+        }
+    }
+}
+
+/* Advance the current tick towards the target. Skip ahead to the next cascade
+ * boundary if the lower levels are empty. Then no slot in between can contain
+ * an entry. */
+static void
+advance(UA_Timer *t, UA_Int64 target) {
+    size_t empty = 0;
+    while(empty < UA_TIMER_WHEEL_LEVELS && t->levelCount[empty] == 0)
+        empty++;
+    UA_Int64 next = t->currentTick + 1;
+    if(empty == UA_TIMER_WHEEL_LEVELS) {
+        next = target;
+    } else if(empty > 0) {
+        UA_Int64 span = (UA_Int64)1 << (UA_TIMER_WHEEL_BITS * empty);
+        next = (t->currentTick | (span - 1)) + 1;
+        if(next > target)
+            next = target;
+    }
+    t->currentTick = next;
+    cascade(t);
+}
+
+UA_DateTime
+UA_Timer_process(UA_Timer *t, UA_DateTime now) {
+    UA_LOCK(&t->timerMutex);
+
+    /* Not reentrant. Don't call _process from within _process. */
+    if(!t->processing) {
+        t->processing = true;
+        UA_Int64 target = toTick(now);
+        while(true) {
+            processCurrentTick(t, now);
+            if(t->currentTick >= target)
+                break;
+            advance(t, target);
+        }
+        t->processing = false;
+    }
+
+    /* Compute the timestamp of the earliest next callback */
+    UA_DateTime next = timeNext(t);
+    UA_UNLOCK(&t->timerMutex);
+    return next;
+}
+
+#endif /* UA_ENABLE_TIMER_WHEEL */
+
 UA_DateTime
 UA_Timer_nextRepeatedTime(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
-    UA_TimerEntry *first = ZIP_MIN(UA_TimerTree, &t->tree);
-    UA_DateTime next = (first) ? first->nextTime : UA_INT64_MAX;
+    UA_DateTime next = timeNext(t);
     UA_UNLOCK(&t->timerMutex);
     return next;
 }
@@ -288,7 +523,12 @@ UA_Timer_clear(UA_Timer *t) {
     UA_LOCK(&t->timerMutex);
 
     ZIP_ITER(UA_TimerIdTree, &t->idTree, freeEntryCallback, NULL);
+#ifdef UA_ENABLE_TIMER_WHEEL
+    memset(t->wheel, 0, sizeof(t->wheel));
+    memset(t->levelCount, 0, sizeof(t->levelCount));
+#else
     t->tree.root = NULL;
+#endif
     t->idTree.root = NULL;
     t->idCounter = 0;
 
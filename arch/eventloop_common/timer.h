@@ -12,6 +12,7 @@
 #include <open62541/types.h>
 #include <open62541/plugin/eventloop.h>
 #include "ziptree.h"
+#include "../../deps/open62541_queue.h"
 
 _UA_BEGIN_DECLS
 
@@ -26,8 +27,26 @@ _UA_BEGIN_DECLS
 /* Callback where the application is either a client or a server */
 typedef void (*UA_ApplicationCallback)(void *application, void *data);
 
+/* With UA_ENABLE_TIMER_WHEEL, the entries are kept in a hierarchical timing
+ * wheel instead of the time-sorted tree. Level 0 has one slot per tick (1ms)
+ * for the next 256 ticks. Every further level has slots that are 256 times as
+ * long. When the current tick reaches the beginning of a slot in a higher level,
+ * its entries are moved down ("cascaded"). So adding, removing and rescheduling
+ * an entry is O(1). All entries of the current tick are processed as one
+ * batch. */
+#define UA_TIMER_WHEEL_TICK UA_DATETIME_MSEC
+#define UA_TIMER_WHEEL_BITS 8
+#define UA_TIMER_WHEEL_SLOTS (1 << UA_TIMER_WHEEL_BITS)
+#define UA_TIMER_WHEEL_LEVELS 4
+
 typedef struct UA_TimerEntry {
+#ifdef UA_ENABLE_TIMER_WHEEL
+    LIST_ENTRY(UA_TimerEntry) slotEntry;
+    UA_Byte level;                   /* Level of the slot in the wheel */
+    UA_Boolean processing;           /* Detached from the wheel for processing */
+#else
     ZIP_ENTRY(UA_TimerEntry) treeEntry;
+#endif
     UA_TimerPolicy timerPolicy;      /* Timer policy to handle cycle misses */
     UA_DateTime nextTime;            /* The next time when the callback is to be
                                       * executed */
@@ -46,9 +65,18 @@ typedef struct UA_TimerEntry {
 
 typedef ZIP_HEAD(UA_TimerTree, UA_TimerEntry) UA_TimerTree;
 typedef ZIP_HEAD(UA_TimerIdTree, UA_TimerEntry) UA_TimerIdTree;
+typedef LIST_HEAD(UA_TimerSlot, UA_TimerEntry) UA_TimerSlot;
 
 typedef struct {
+#ifdef UA_ENABLE_TIMER_WHEEL
+    UA_TimerSlot wheel[UA_TIMER_WHEEL_LEVELS][UA_TIMER_WHEEL_SLOTS];
+    size_t levelCount[UA_TIMER_WHEEL_LEVELS];
+    UA_Int64 currentTick;      /* All ticks before were processed */
+    UA_TimerSlot processSlot;  /* The entries of the tick that is processed */
+    UA_Boolean processing;
+#else
     UA_TimerTree tree;     /* The root of the time-sorted tree */
+#endif
     UA_TimerIdTree idTree; /* The root of the id-sorted tree */
     UA_UInt64 idCounter;   /* Generate unique identifiers. Identifiers are
                             * always above zero. */
@@ -56,9 +84,27 @@ typedef struct {
     UA_Lock timerMutex;
 #endif
 
+    /* Statistics of the executed callbacks. The lag is the delay between the
+     * scheduled time and the time of processing. */
+    UA_UInt64 callbackCount;
+    UA_UInt64 lag; /* cumulated */
+    UA_UInt64 maxLag;
+    UA_UInt64 lagBuckets[UA_EVENTLOOP_LAGBUCKETS];
+
+    /* Callbacks with a runtime of at least the slowThreshold are counted and
+     * reported to the slowCallback hook (called without holding the timer
+     * mutex). The runtime is not measured if the threshold is zero. */
+    UA_DateTime slowThreshold;
+    UA_UInt64 slowCount;
+    void *slowContext;
+    void (*slowCallback)(void *slowContext, UA_ApplicationCallback callback,
+                         void *application, UA_DateTime runtime, UA_DateTime lag);
+
+#ifndef UA_ENABLE_TIMER_WHEEL
     UA_TimerTree processTree; /* When the timer is processed, all entries that
                                * need processing now are moved to processTree.
                                * Then we iterate over that tree. */
+#endif
 } UA_Timer;
 
 void
@@ -13,6 +13,59 @@
 #include <time.h>
 #endif
 
+/* Resolve the symbol names of slow callbacks where possible */
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#include <stdlib.h> /* free for the libc-allocated symbols */
+#define UA_HAVE_BACKTRACE_SYMBOLS 1
+#endif
+
+/***********/
+/* Tracing */
+/***********/
+
+static void
+symbolizeCallback(UA_Callback callback, char *buf, size_t bufSize) {
+    void *addr = (void*)(uintptr_t)callback;
+#ifdef UA_HAVE_BACKTRACE_SYMBOLS
+    /* Only exported symbols are resolved. Otherwise the output contains the
+     * binary and the offset. */
+    char **symbols = backtrace_symbols(&addr, 1);
+    if(symbols) {
+        mp_snprintf(buf, bufSize, "%s", symbols[0]);
+        free(symbols); /* Allocated by libc with malloc */
+        return;
+    }
+#endif
+    mp_snprintf(buf, bufSize, "%p", addr);
+}
+
+/* Called without holding a lock */
+static void
+reportSlowCallback(UA_EventLoopPOSIX *el, UA_EventLoopCallbackType type,
+                   UA_Callback callback, void *application,
+                   UA_DateTime runtime, UA_DateTime lag) {
+    if(el->eventLoop.traceSlowCallback) {
+        el->eventLoop.traceSlowCallback(&el->eventLoop, el->eventLoop.traceContext,
+                                        type, callback, application, runtime, lag);
+        return;
+    }
+    char symbol[256];
+    symbolizeCallback(callback, symbol, sizeof(symbol));
+    UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                   "Slow %s callback %s took %.3fms (started %.3fms late)",
+                   (type == UA_EVENTLOOPCALLBACK_TIMER) ? "timer" : "delayed",
+                   symbol, (UA_Double)runtime / UA_DATETIME_MSEC,
+                   (UA_Double)lag / UA_DATETIME_MSEC);
+}
+
+static void
+slowTimerCallback(void *context, UA_ApplicationCallback callback,
+                  void *application, UA_DateTime runtime, UA_DateTime lag) {
+    reportSlowCallback((UA_EventLoopPOSIX*)context, UA_EVENTLOOPCALLBACK_TIMER,
+                       callback, application, runtime, lag);
+}
+
 /*********/
 /* Timer */
 /*********/
@@ -68,14 +121,169 @@ UA_EventLoopPOSIX_removeCyclicCallback(UA_EventLoop *public_el,
     UA_Timer_removeCallback(&el->timer, callbackId);
 }
 
+/**********/
+/* Wakeup */
+/**********/
+
+#ifdef UA_HAVE_WAKEUPFD
+
+/* Interrupt the poll. At most one wakeup is outstanding. */
+static void
+wakeup(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    if(!el->polling || el->wakeupSent || el->wakeupWriteFD == UA_INVALID_FD)
+        return;
+#if defined(UA_HAVE_KQUEUE_USER)
+    struct kevent kev;
+    EV_SET(&kev, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+    int err = (kevent(el->wakeupWriteFD, &kev, 1, NULL, 0, NULL) == -1) ? 0 : 1;
+#elif defined(UA_HAVE_EPOLL)
+    uint64_t one = 1;
+    ssize_t err = write(el->wakeupWriteFD, &one, sizeof(one));
+#else
+    ssize_t err = write(el->wakeupWriteFD, ".", 1);
+#endif
+    if(err <= 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "Eventloop\t| Could not signal the wakeup (%s)",
+                           errno_str));
+        return;
+    }
+    el->wakeupSent = true;
+}
+
+#ifndef UA_HAVE_KQUEUE_USER
+static void
+consumeWakeup(UA_EventSource *es, UA_RegisteredFD *rfd, short event) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)
+        ((uintptr_t)rfd - offsetof(UA_EventLoopPOSIX, wakeupFD));
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    char buf[64]; /* At least the eight bytes of the eventfd counter */
+    ssize_t i;
+    do {
+        i = read(rfd->fd, buf, sizeof(buf));
+    } while(i > 0);
+    el->wakeupSent = false;
+}
+#endif
+
+static void
+openWakeup(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+#ifdef UA_HAVE_KQUEUE_USER
+    /* The user event is triggered directly in the kqueue of the EventLoop. It
+     * is consumed in UA_EventLoopPOSIX_pollFDs. */
+    struct kevent kev;
+    EV_SET(&kev, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    if(kevent(el->kqueuefd, &kev, 1, NULL, 0, NULL) == -1) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not add the wakeup event (%s). "
+                          "Delayed callbacks from other threads wait for "
+                          "the poll timeout.", errno_str));
+        el->wakeupWriteFD = UA_INVALID_FD;
+        return;
+    }
+    el->wakeupFD.fd = UA_INVALID_FD;
+    el->wakeupWriteFD = el->kqueuefd;
+    el->wakeupSent = false;
+#else
+    UA_FD fds[2];
+#ifdef UA_HAVE_EPOLL
+    fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    fds[1] = fds[0];
+    int err = (fds[0] == UA_INVALID_FD) ? -1 : 0;
+#else
+    int err = pipe(fds);
+    if(err == 0 &&
+       (UA_EventLoopPOSIX_setNonBlocking(fds[0]) != UA_STATUSCODE_GOOD ||
+        UA_EventLoopPOSIX_setNonBlocking(fds[1]) != UA_STATUSCODE_GOOD)) {
+        UA_close(fds[0]);
+        UA_close(fds[1]);
+        err = -1;
+    }
+#endif
+    if(err != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not open the wakeup socket (%s). "
+                          "Delayed callbacks from other threads wait for "
+                          "the poll timeout.", errno_str));
+        return;
+    }
+
+    memset(&el->wakeupFD, 0, sizeof(UA_RegisteredFD));
+    el->wakeupFD.fd = fds[0];
+    el->wakeupFD.listenEvents = UA_FDEVENT_IN;
+    el->wakeupFD.eventSourceCB = consumeWakeup;
+    if(UA_EventLoopPOSIX_registerFD(el, &el->wakeupFD) != UA_STATUSCODE_GOOD) {
+        UA_close(fds[0]);
+        if(fds[1] != fds[0])
+            UA_close(fds[1]);
+        el->wakeupFD.fd = UA_INVALID_FD;
+        return;
+    }
+    el->wakeupWriteFD = fds[1];
+    el->wakeupSent = false;
+#endif
+}
+
+static void
+closeWakeup(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    if(el->wakeupWriteFD == UA_INVALID_FD)
+        return;
+#ifndef UA_HAVE_KQUEUE_USER
+    UA_EventLoopPOSIX_deregisterFD(el, &el->wakeupFD);
+    if(el->wakeupWriteFD != el->wakeupFD.fd)
+        UA_close(el->wakeupWriteFD);
+    UA_close(el->wakeupFD.fd);
+    el->wakeupFD.fd = UA_INVALID_FD;
+#endif
+    /* The kqueue user event is removed together with the kqueue */
+    el->wakeupWriteFD = UA_INVALID_FD;
+}
+
+#endif /* UA_HAVE_WAKEUPFD */
+
+/* Move the delayed callbacks submitted from other threads to the list. The
+ * queue has the newest entry first, the same as the list. */
+static void
+takeDelayedQueue(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_DelayedCallback *dc = (UA_DelayedCallback*)
+        UA_atomic_xchg((void * volatile *)&el->delayedQueue, NULL);
+    if(!dc)
+        return;
+    UA_DelayedCallback *last = dc;
+    while(last->next)
+        last = last->next;
+    last->next = el->delayedCallbacks;
+    el->delayedCallbacks = dc;
+}
+
+/* Delayed callbacks can be added from any thread. They are pushed to a
+ * lock-free queue, so that producer threads don't contend for the elMutex.
+ * Only the first entry after the queue was emptied takes the lock to wake up
+ * the EventLoop if it is waiting in the poll. */
 static void
 UA_EventLoopPOSIX_addDelayedCallback(UA_EventLoop *public_el,
                                      UA_DelayedCallback *dc) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
-    UA_LOCK(&el->elMutex);
-    dc->next = el->delayedCallbacks;
-    el->delayedCallbacks = dc;
-    UA_UNLOCK(&el->elMutex);
+    UA_DelayedCallback *head;
+    do {
+        head = el->delayedQueue;
+        dc->next = head;
+    } while(UA_atomic_cmpxchg((void * volatile *)&el->delayedQueue,
+                              head, dc) != head);
+#ifdef UA_HAVE_WAKEUPFD
+    if(head == NULL) {
+        UA_LOCK(&el->elMutex);
+        wakeup(el);
+        UA_UNLOCK(&el->elMutex);
+    }
+#endif
 }
 
 static void
@@ -83,6 +291,7 @@ UA_EventLoopPOSIX_removeDelayedCallback(UA_EventLoop *public_el,
                                      UA_DelayedCallback *dc) {
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)public_el;
     UA_LOCK(&el->elMutex);
+    takeDelayedQueue(el);
     UA_DelayedCallback **prev = &el->delayedCallbacks;
     while(*prev) {
         if(*prev == dc) {
@@ -106,9 +315,11 @@ processDelayed(UA_EventLoopPOSIX *el) {
     /* First empty the linked list in the el. So a delayed callback can add
      * (itself) to the list. New entries are then processed during the next
      * iteration. */
+    takeDelayedQueue(el);
     UA_DelayedCallback *dc = el->delayedCallbacks, *next = NULL;
     el->delayedCallbacks = NULL;
 
+    UA_DateTime threshold = el->eventLoop.slowCallbackThreshold;
     for(; dc; dc = next) {
         next = dc->next;
         /* Delayed Callbacks might have no callback set. We don't return a
@@ -116,8 +327,24 @@ processDelayed(UA_EventLoopPOSIX *el) {
         if(!dc->callback)
             continue;
         UA_UNLOCK(&el->elMutex);
-        dc->callback(dc->application, dc->context);
+        if(threshold <= 0) {
+            dc->callback(dc->application, dc->context);
+            UA_LOCK(&el->elMutex);
+            continue;
+        }
+        /* The dc can be freed in the callback. Copy the content first. */
+        UA_Callback callback = dc->callback;
+        void *application = dc->application;
+        UA_DateTime start = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+        callback(application, dc->context);
+        UA_DateTime runtime =
+            el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - start;
+        if(runtime >= threshold)
+            reportSlowCallback(el, UA_EVENTLOOPCALLBACK_DELAYED,
+                               callback, application, runtime, 0);
         UA_LOCK(&el->elMutex);
+        if(runtime >= threshold)
+            el->slowDelayedCount++;
     }
 }
 
@@ -166,7 +393,12 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
     }
 #endif
 
-#ifdef UA_HAVE_EPOLL
+#if defined(UA_HAVE_IOURING)
+    if(UA_EventLoopPOSIX_openRing(el) != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#elif defined(UA_HAVE_EPOLL)
     el->epollfd = epoll_create1(0);
     if(el->epollfd == -1) {
         UA_LOG_SOCKET_ERRNO_WRAP(
@@ -176,6 +408,20 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
+#elif defined(UA_HAVE_KQUEUE)
+    el->kqueuefd = kqueue();
+    if(el->kqueuefd == -1) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "Eventloop\t| Could not create the kqueue (%s)",
+                          errno_str));
+        UA_UNLOCK(&el->elMutex);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+#endif
+
+#ifdef UA_HAVE_WAKEUPFD
+    openWakeup(el);
 #endif
 
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -187,6 +433,11 @@ UA_EventLoopPOSIX_start(UA_EventLoopPOSIX *el) {
         es = es->next;
     }
 
+    /* Take over the tracing configuration */
+    UA_LOCK(&el->timer.timerMutex);
+    el->timer.slowThreshold = el->eventLoop.slowCallbackThreshold;
+    UA_UNLOCK(&el->timer.timerMutex);
+
     /* Dirty-write the state that is const "from the outside" */
     *(UA_EventLoopState*)(uintptr_t)&el->eventLoop.state =
         UA_EVENTLOOPSTATE_STARTED;
@@ -207,16 +458,24 @@ checkClosed(UA_EventLoopPOSIX *el) {
     }
 
     /* Not closed until all delayed callbacks are processed */
-    if(el->delayedCallbacks != NULL)
+    if(el->delayedCallbacks != NULL || el->delayedQueue != NULL)
         return;
 
     /* Dirty-write the state that is const "from the outside" */
     *(UA_EventLoopState*)(uintptr_t)&el->eventLoop.state =
         UA_EVENTLOOPSTATE_STOPPED;
 
-    /* Close the epoll/IOCP socket once all EventSources have shut down */
-#ifdef UA_HAVE_EPOLL
+#ifdef UA_HAVE_WAKEUPFD
+    closeWakeup(el);
+#endif
+
+    /* Close the epoll/kqueue fd once all EventSources have shut down */
+#if defined(UA_HAVE_IOURING)
+    UA_EventLoopPOSIX_closeRing(el);
+#elif defined(UA_HAVE_EPOLL)
     close(el->epollfd);
+#elif defined(UA_HAVE_KQUEUE)
+    close(el->kqueuefd);
 #endif
 
     UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
@@ -285,11 +544,14 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
                  "Iterate the EventLoop");
 
     /* Process cyclic callbacks */
+    el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
     UA_DateTime dateBefore =
         el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
 
     UA_UNLOCK(&el->elMutex);
     UA_DateTime dateNext = UA_Timer_process(&el->timer, dateBefore);
+    UA_DateTime dateTimer =
+        el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
     UA_LOCK(&el->elMutex);
 
     /* Process delayed callbacks here:
@@ -298,12 +560,14 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
      *   cyclic callback. So we want to do little work between the timeout
      *   running out and executing the due cyclic callbacks. */
     processDelayed(el);
+    UA_DateTime dateDelayed =
+        el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
 
     /* A delayed callback could create another delayed callback (or re-add
      * itself). In that case we don't want to wait (indefinitely) for an event
      * to happen. Process queued events but don't sleep. Then process the
      * delayed callbacks in the next iteration. */
-    if(el->delayedCallbacks != NULL)
+    if(el->delayedCallbacks != NULL || el->delayedQueue != NULL)
         timeout = 0;
 
     /* Compute the remaining time */
@@ -317,14 +581,40 @@ UA_EventLoopPOSIX_run(UA_EventLoopPOSIX *el, UA_UInt32 timeout) {
 
     /* Listen on the active file-descriptors (sockets) from the
      * ConnectionManagers */
+    el->pollTime = 0;
     UA_StatusCode rv = UA_EventLoopPOSIX_pollFDs(el, listenTimeout);
 
+    /* Update the statistics */
+    UA_EventLoopIterationTrace trace;
+    trace.start = dateBefore;
+    trace.timerTime = dateTimer - dateBefore;
+    trace.delayedTime = dateDelayed - dateTimer;
+    trace.waitTime = el->pollTime;
+    trace.eventTime = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) -
+        dateDelayed - el->pollTime;
+    if(trace.eventTime < 0)
+        trace.eventTime = 0;
+    UA_DateTime busy = trace.timerTime + trace.delayedTime + trace.eventTime;
+    el->iterationCount++;
+    el->busyTime += (UA_UInt64)busy;
+    if((UA_UInt64)busy > el->maxBusyTime)
+        el->maxBusyTime = (UA_UInt64)busy;
+    el->timerTime += (UA_UInt64)trace.timerTime;
+    el->delayedTime += (UA_UInt64)trace.delayedTime;
+    el->eventTime += (UA_UInt64)trace.eventTime;
+    el->waitTime += (UA_UInt64)trace.waitTime;
+
     /* Check if the last EventSource was successfully stopped */
     if(el->eventLoop.state == UA_EVENTLOOPSTATE_STOPPING)
         checkClosed(el);
 
+    el->nowCached = 0;
     el->executing = false;
     UA_UNLOCK(&el->elMutex);
+
+    if(el->eventLoop.traceIteration)
+        el->eventLoop.traceIteration(&el->eventLoop, el->eventLoop.traceContext,
+                                     &trace);
     return rv;
 }
 
@@ -428,12 +718,48 @@ UA_EventLoopPOSIX_DateTime_nowMonotonic(UA_EventLoop *el) {
 #endif
 }
 
+static UA_DateTime
+UA_EventLoopPOSIX_DateTime_nowCached(UA_EventLoop *el) {
+    /* The cached time is reset when the iteration waits for events or
+     * returns. Then other threads calling into the server would see a stale
+     * time. Fall back to reading the clock. */
+    UA_EventLoopPOSIX *pel = (UA_EventLoopPOSIX*)el;
+    UA_DateTime now = pel->nowCached;
+    if(now != 0)
+        return now;
+    return el->dateTime_now(el);
+}
+
 static UA_Int64
 UA_EventLoopPOSIX_DateTime_localTimeUtcOffset(UA_EventLoop *el) {
     /* TODO: Fix for custom clock sources */
     return UA_DateTime_localTimeUtcOffset();
 }
 
+static void
+UA_EventLoopPOSIX_getStatistics(UA_EventLoopPOSIX *el,
+                                UA_EventLoopStatistics *stats) {
+    UA_LOCK(&el->elMutex);
+    stats->iterationCount = el->iterationCount;
+    stats->busyTime = el->busyTime;
+    stats->maxBusyTime = el->maxBusyTime;
+    stats->timerTime = el->timerTime;
+    stats->delayedTime = el->delayedTime;
+    stats->eventTime = el->eventTime;
+    stats->waitTime = el->waitTime;
+    stats->slowCallbackCount = el->slowDelayedCount;
+    UA_UNLOCK(&el->elMutex);
+
+    UA_LOCK(&el->timer.timerMutex);
+    stats->timerCallbackCount = el->timer.callbackCount;
+    stats->timerLag = el->timer.lag;
+    stats->maxTimerLag = el->timer.maxLag;
+    memcpy(stats->timerLagBuckets, el->timer.lagBuckets,
+           sizeof(stats->timerLagBuckets));
+    stats->slowCallbackCount += el->timer.slowCount;
+    UA_UNLOCK(&el->timer.timerMutex);
+}
+
 /*************************/
 /* Initialize and Delete */
 /*************************/
@@ -489,6 +815,12 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
 
     UA_LOCK_INIT(&el->elMutex);
     UA_Timer_init(&el->timer);
+    el->timer.slowContext = el;
+    el->timer.slowCallback = slowTimerCallback;
+#ifdef UA_HAVE_WAKEUPFD
+    el->wakeupFD.fd = UA_INVALID_FD;
+    el->wakeupWriteFD = UA_INVALID_FD;
+#endif
 
 #ifdef _WIN32
     /* Start the WSA networking subsystem on Windows */
@@ -509,6 +841,7 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
         UA_EventLoopPOSIX_DateTime_nowMonotonic;
     el->eventLoop.dateTime_localTimeUtcOffset =
         UA_EventLoopPOSIX_DateTime_localTimeUtcOffset;
+    el->eventLoop.dateTime_nowCached = UA_EventLoopPOSIX_DateTime_nowCached;
 
     el->eventLoop.nextCyclicTime = UA_EventLoopPOSIX_nextCyclicTime;
     el->eventLoop.addCyclicCallback = UA_EventLoopPOSIX_addCyclicCallback;
@@ -525,6 +858,10 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger) {
         (UA_StatusCode (*)(UA_EventLoop*, UA_EventSource*))
         UA_EventLoopPOSIX_deregisterEventSource;
 
+    el->eventLoop.getStatistics =
+        (void (*)(UA_EventLoop*, UA_EventLoopStatistics*))
+        UA_EventLoopPOSIX_getStatistics;
+
     return &el->eventLoop;
 }
 
@@ -636,11 +973,95 @@ UA_EventLoopPOSIX_setReusable(UA_FD sockfd) {
 #endif
 }
 
-/************************/
-/* Select / epoll Logic */
-/************************/
+/*************************/
+/* Select / poll / epoll */
+/*************************/
+
+static int
+cmpFDValue(const void *a, const void *b) {
+    UA_FD fa = *(const UA_FD*)a;
+    UA_FD fb = *(const UA_FD*)b;
+    return (fa < fb) ? -1 : (fa > fb) ? 1 : 0;
+}
+
+void
+UA_EventLoopPOSIX_sortFDs(UA_FD *fds, size_t fdsSize) {
+    if(fdsSize > 1)
+        qsort(fds, fdsSize, sizeof(UA_FD), cmpFDValue);
+}
+
+UA_Boolean
+UA_EventLoopPOSIX_containsFD(const UA_FD *fds, size_t fdsSize, UA_FD fd) {
+    if(fdsSize == 0)
+        return false;
+    return (bsearch(&fd, fds, fdsSize, sizeof(UA_FD), cmpFDValue) != NULL);
+}
+
+#if defined(UA_HAVE_POLL)
+
+static short
+pollEvents(const UA_RegisteredFD *rfd) {
+    short events = 0;
+    if(rfd->listenEvents & UA_FDEVENT_IN)
+        events |= UA_POLLIN;
+    if(rfd->listenEvents & UA_FDEVENT_OUT)
+        events |= UA_POLLOUT;
+    return events;
+}
+
+/* The pollfd array is read (and the revents written) by the kernel while
+ * another thread can hold the elMutex. Then the changes are applied only to the
+ * fds array and the pollfds are rebuilt after the poll returned. */
+static UA_Boolean
+pollfdsInUse(UA_EventLoopPOSIX *el) {
+#ifdef UA_HAVE_WAKEUPFD
+    if(el->polling) {
+        el->pollfdsDirty = true;
+        wakeup(el);
+        return true;
+    }
+#endif
+    return el->pollfdsDirty;
+}
+
+/* Grow or shrink the arrays to the new capacity. The entries up to fdsSize are
+ * retained. */
+static UA_StatusCode
+resizeFDs(UA_EventLoopPOSIX *el, size_t capacity, UA_Boolean inUse) {
+    UA_RegisteredFD **fds_tmp = (UA_RegisteredFD**)
+        UA_realloc(el->fds, sizeof(UA_RegisteredFD*) * capacity);
+    if(!fds_tmp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    el->fds = fds_tmp;
+    el->fdsCapacity = capacity;
+    if(inUse)
+        return UA_STATUSCODE_GOOD;
+    struct pollfd *pollfds_tmp = (struct pollfd*)
+        UA_realloc(el->pollfds, sizeof(struct pollfd) * capacity);
+    if(!pollfds_tmp) {
+        el->pollfdsDirty = true; /* Retry the allocation before polling */
+        return UA_STATUSCODE_GOOD;
+    }
+    el->pollfds = pollfds_tmp;
+    return UA_STATUSCODE_GOOD;
+}
 
-#if !defined(UA_HAVE_EPOLL)
+/* Rebuild the pollfd array after changes from another thread */
+static UA_StatusCode
+rebuildPollFDs(UA_EventLoopPOSIX *el) {
+    struct pollfd *pollfds_tmp = (struct pollfd*)
+        UA_realloc(el->pollfds, sizeof(struct pollfd) * el->fdsCapacity);
+    if(!pollfds_tmp && el->fdsCapacity > 0)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    el->pollfds = pollfds_tmp;
+    for(size_t i = 0; i < el->fdsSize; i++) {
+        el->pollfds[i].fd = el->fds[i]->fd;
+        el->pollfds[i].events = pollEvents(el->fds[i]);
+        el->pollfds[i].revents = 0;
+    }
+    el->pollfdsDirty = false;
+    return UA_STATUSCODE_GOOD;
+}
 
 UA_StatusCode
 UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
@@ -648,24 +1069,36 @@ UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                  "Registering fd: %u", (unsigned)rfd->fd);
 
-    /* Realloc */
-    UA_RegisteredFD **fds_tmp = (UA_RegisteredFD**)
-        UA_realloc(el->fds, sizeof(UA_RegisteredFD*) * (el->fdsSize + 1));
-    if(!fds_tmp) {
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_Boolean inUse = pollfdsInUse(el);
+
+    /* Double the capacity if required */
+    if(el->fdsSize == el->fdsCapacity) {
+        size_t capacity = (el->fdsCapacity > 0) ? el->fdsCapacity * 2 : 16;
+        UA_StatusCode res = resizeFDs(el, capacity, inUse);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        inUse |= el->pollfdsDirty;
     }
-    el->fds = fds_tmp;
 
     /* Add to the last entry */
     el->fds[el->fdsSize] = rfd;
+    rfd->pollIndex = el->fdsSize;
+    if(!inUse) {
+        struct pollfd *pfd = &el->pollfds[el->fdsSize];
+        pfd->fd = rfd->fd;
+        pfd->events = pollEvents(rfd);
+        pfd->revents = 0;
+    }
     el->fdsSize++;
     return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
 UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
-    /* Do nothing, it is enough if the data was changed in the rfd */
     UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_assert(rfd->pollIndex < el->fdsSize && el->fds[rfd->pollIndex] == rfd);
+    if(!pollfdsInUse(el))
+        el->pollfds[rfd->pollIndex].events = pollEvents(rfd);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -675,60 +1108,35 @@ UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                  "Unregistering fd: %u", (unsigned)rfd->fd);
 
-    /* Find the entry */
-    size_t i = 0;
-    for(; i < el->fdsSize; i++) {
-        if(el->fds[i] == rfd)
-            break;
-    }
-
-    /* Not found? */
-    if(i == el->fdsSize)
+    /* Not registered? */
+    size_t i = rfd->pollIndex;
+    if(i >= el->fdsSize || el->fds[i] != rfd)
         return;
 
-    if(el->fdsSize > 1) {
-        /* Move the last entry in the ith slot and realloc. */
-        el->fdsSize--;
+    UA_Boolean inUse = pollfdsInUse(el);
+
+    /* Move the last entry into the ith slot. This keeps the array compact. The
+     * pollfd is moved together with its revents, so that pending events are
+     * still processed in the current iteration. */
+    el->fdsSize--;
+    if(i != el->fdsSize) {
         el->fds[i] = el->fds[el->fdsSize];
-        UA_RegisteredFD **fds_tmp = (UA_RegisteredFD**)
-            UA_realloc(el->fds, sizeof(UA_RegisteredFD*) * el->fdsSize);
-        /* if realloc fails the fds are still in a correct state with
-         * possibly lost memory, so failing silently here is ok */
-        if(fds_tmp)
-            el->fds = fds_tmp;
-    } else {
-        /* Remove the last entry */
-        UA_free(el->fds);
-        el->fds = NULL;
-        el->fdsSize = 0;
+        el->fds[i]->pollIndex = i;
+        if(!inUse)
+            el->pollfds[i] = el->pollfds[el->fdsSize];
     }
-}
-
-static UA_FD
-setFDSets(UA_EventLoopPOSIX *el, fd_set *readset, fd_set *writeset, fd_set *errset) {
-    UA_LOCK_ASSERT(&el->elMutex, 1);
-
-    FD_ZERO(readset);
-    FD_ZERO(writeset);
-    FD_ZERO(errset);
-    UA_FD highestfd = UA_INVALID_FD;
-    for(size_t i = 0; i < el->fdsSize; i++) {
-        UA_FD currentFD = el->fds[i]->fd;
-
-        /* Add to the fd_sets */
-        if(el->fds[i]->listenEvents & UA_FDEVENT_IN)
-            FD_SET(currentFD, readset);
-        if(el->fds[i]->listenEvents & UA_FDEVENT_OUT)
-            FD_SET(currentFD, writeset);
-
-        /* Always return errors */
-        FD_SET(currentFD, errset);
 
-        /* Highest fd? */
-        if(currentFD > highestfd || highestfd == UA_INVALID_FD)
-            highestfd = currentFD;
+    /* Release the memory if empty. Shrink if the array is mostly unused. If
+     * the realloc fails, the arrays are still in a correct state. */
+    if(el->fdsSize == 0 && !inUse) {
+        UA_free(el->fds);
+        UA_free(el->pollfds);
+        el->fds = NULL;
+        el->pollfds = NULL;
+        el->fdsCapacity = 0;
+    } else if(el->fdsCapacity > 16 && el->fdsSize <= el->fdsCapacity / 4) {
+        resizeFDs(el, el->fdsCapacity / 2, inUse);
     }
-    return highestfd;
 }
 
 UA_StatusCode
@@ -736,57 +1144,77 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
     UA_assert(listenTimeout >= 0);
     UA_LOCK_ASSERT(&el->elMutex, 1);
 
-    fd_set readset, writeset, errset;
-    UA_FD highestfd = setFDSets(el, &readset, &writeset, &errset);
+    /* Apply the changes made by other threads during the last poll */
+    if(el->pollfdsDirty && rebuildPollFDs(el) != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Cannot allocate the pollfd array");
+        return UA_STATUSCODE_GOOD;
+    }
 
     /* Nothing to do? */
-    if(highestfd == UA_INVALID_FD) {
+    if(el->fdsSize == 0) {
         UA_LOG_TRACE(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                      "No valid FDs for processing");
         return UA_STATUSCODE_GOOD;
     }
 
-    struct timeval tmptv = {
-#ifndef _WIN32
-        (time_t)(listenTimeout / UA_DATETIME_SEC),
-        (suseconds_t)((listenTimeout % UA_DATETIME_SEC) / UA_DATETIME_USEC)
-#else
-        (long)(listenTimeout / UA_DATETIME_SEC),
-        (long)((listenTimeout % UA_DATETIME_SEC) / UA_DATETIME_USEC)
-#endif
-    };
+    /* Round up to full milliseconds. Otherwise we spin until the next timer
+     * is due. */
+    UA_DateTime timeoutMs = (listenTimeout + UA_DATETIME_MSEC - 1) / UA_DATETIME_MSEC;
+    if(timeoutMs > UA_INT32_MAX)
+        timeoutMs = UA_INT32_MAX;
 
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = true;
+#endif
+    UA_DateTime pollStart = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    el->nowCached = 0; /* Invalid while waiting */
+    struct pollfd *pollfds = el->pollfds;
+    size_t pollfdsSize = el->fdsSize;
     UA_UNLOCK(&el->elMutex);
-    int selectStatus = UA_select(highestfd+1, &readset, &writeset, &errset, &tmptv);
+    int pollStatus = UA_poll(pollfds, (nfds_t)pollfdsSize, (int)timeoutMs);
     UA_LOCK(&el->elMutex);
-    if(selectStatus < 0) {
+    el->pollTime = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - pollStart;
+    el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = false;
+#endif
+    if(pollStatus < 0) {
         /* We will retry, only log the error */
         UA_LOG_SOCKET_ERRNO_WRAP(
             UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
-                           "Error during select: %s", errno_str));
+                           "Error during poll: %s", errno_str));
         return UA_STATUSCODE_GOOD;
     }
 
-    /* Loop over all registered FD to see if an event arrived. Yes, this is why
-     * select is slow for many open sockets. */
-    for(size_t i = 0; i < el->fdsSize; i++) {
-        UA_RegisteredFD *rfd = el->fds[i];
+    /* The fds were changed from another thread during the poll. The revents no
+     * longer match the fds. They are signaled again in the next iteration. */
+    if(el->pollfdsDirty)
+        return UA_STATUSCODE_GOOD;
+
+    /* Process the signaled fds. Stop early once all reported events were
+     * handled. */
+    for(size_t i = 0; i < el->fdsSize && pollStatus > 0; i++) {
+        short revents = el->pollfds[i].revents;
+        if(revents == 0)
+            continue;
+        el->pollfds[i].revents = 0;
+        pollStatus--;
 
         /* The rfd is already registered for removal. Don't process incoming
          * events any longer. */
+        UA_RegisteredFD *rfd = el->fds[i];
         if(rfd->dc.callback)
             continue;
 
         /* Event signaled for the fd? */
-        short event = 0;
-        if(FD_ISSET(rfd->fd, &readset)) {
+        short event;
+        if(revents & UA_POLLIN) {
             event = UA_FDEVENT_IN;
-        } else if(FD_ISSET(rfd->fd, &writeset)) {
+        } else if(revents & UA_POLLOUT) {
             event = UA_FDEVENT_OUT;
-        } else if(FD_ISSET(rfd->fd, &errset)) {
-            event = UA_FDEVENT_ERR;
         } else {
-            continue;
+            event = UA_FDEVENT_ERR; /* POLLERR, POLLHUP or POLLNVAL */
         }
 
         UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
@@ -796,43 +1224,1020 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
         /* Call the EventSource callback */
         rfd->eventSourceCB(rfd->es, rfd, event);
 
-        /* The fd has removed itself */
+        /* The pollfds became stale during the callback (failed allocation) */
+        if(el->pollfdsDirty)
+            break;
+
+        /* The fd has removed itself. The last entry was moved into the slot. */
         if(i == el->fdsSize || rfd != el->fds[i])
             i--;
     }
     return UA_STATUSCODE_GOOD;
 }
 
-#else /* defined(UA_HAVE_EPOLL) */
-
-UA_StatusCode
-UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
-    struct epoll_event event;
-    memset(&event, 0, sizeof(struct epoll_event));
-    event.data.ptr = rfd;
-    event.events = 0;
-    if(rfd->listenEvents & UA_FDEVENT_IN)
-        event.events |= EPOLLIN;
-    if(rfd->listenEvents & UA_FDEVENT_OUT)
-        event.events |= EPOLLOUT;
+#elif defined(UA_HAVE_KQUEUE)
 
-    int err = epoll_ctl(el->epollfd, EPOLL_CTL_ADD, rfd->fd, &event);
-    if(err != 0) {
+/* Every fd has a read and a write filter. They are enabled and disabled
+ * according to the listenEvents. EV_ADD modifies already existing filters. */
+static UA_StatusCode
+setKqueueFilters(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    struct kevent changes[2];
+    EV_SET(&changes[0], rfd->fd, EVFILT_READ, EV_ADD |
+           ((rfd->listenEvents & UA_FDEVENT_IN) ? EV_ENABLE : EV_DISABLE),
+           0, 0, rfd);
+    EV_SET(&changes[1], rfd->fd, EVFILT_WRITE, EV_ADD |
+           ((rfd->listenEvents & UA_FDEVENT_OUT) ? EV_ENABLE : EV_DISABLE),
+           0, 0, rfd);
+    int err = kevent(el->kqueuefd, changes, 2, NULL, 0, NULL);
+    if(err == -1) {
         UA_LOG_SOCKET_ERRNO_WRAP(
-           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                          "TCP %u\t| Could not register for epoll (%s)",
-                          rfd->fd, errno_str));
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not register the fd %u in the "
+                          "kqueue (%s)", (unsigned)rfd->fd, errno_str));
         return UA_STATUSCODE_BADINTERNALERROR;
     }
     return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
-UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
-    struct epoll_event event;
-    memset(&event, 0, sizeof(struct epoll_event));
-    event.data.ptr = rfd;
-    event.events = 0;
+UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "Registering fd: %u", (unsigned)rfd->fd);
+    return setKqueueFilters(el, rfd);
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    return setKqueueFilters(el, rfd);
+}
+
+void
+UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "Unregistering fd: %u", (unsigned)rfd->fd);
+
+    /* Delete the filters one by one. Otherwise the first failure (the filter
+     * was already removed) aborts the processing of the changelist. */
+    struct kevent change;
+    EV_SET(&change, rfd->fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    kevent(el->kqueuefd, &change, 1, NULL, 0, NULL);
+    EV_SET(&change, rfd->fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    kevent(el->kqueuefd, &change, 1, NULL, 0, NULL);
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
+    UA_assert(listenTimeout >= 0);
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+    /* kevent takes the timeout with nanosecond precision */
+    struct timespec timeout = {
+        (time_t)(listenTimeout / UA_DATETIME_SEC),
+        (long)((listenTimeout % UA_DATETIME_SEC) * 100)
+    };
+
+    /* Poll the registered sockets */
+    struct kevent kevents[UA_MAXKQUEUEEVENTS];
+    int kqueuefd = el->kqueuefd;
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = true;
+#endif
+    UA_DateTime pollStart = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    el->nowCached = 0; /* Invalid while waiting */
+    UA_UNLOCK(&el->elMutex);
+    int events = kevent(kqueuefd, NULL, 0, kevents, UA_MAXKQUEUEEVENTS, &timeout);
+    UA_LOCK(&el->elMutex);
+    el->pollTime = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - pollStart;
+    el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = false;
+#endif
+
+    /* Handle error conditions */
+    if(events == -1) {
+        if(errno == EINTR) {
+            /* We will retry, only log the error */
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "Timeout during poll");
+            return UA_STATUSCODE_GOOD;
+        }
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Error %s during kevent", errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Process all received events */
+    for(int i = 0; i < events; i++) {
+#ifdef UA_HAVE_KQUEUE_USER
+        /* Consume the wakeup. The user event is reset with EV_CLEAR. */
+        if(kevents[i].filter == EVFILT_USER) {
+            el->wakeupSent = false;
+            continue;
+        }
+#endif
+
+        UA_RegisteredFD *rfd = (UA_RegisteredFD*)kevents[i].udata;
+
+        /* The rfd is already registered for removal. Don't process incoming
+         * events any longer. */
+        if(rfd->dc.callback)
+            continue;
+
+        /* Get the event. The read and write filter of an fd are reported as
+         * separate events. */
+        short revent = 0;
+        if(kevents[i].flags & EV_ERROR) {
+            revent = UA_FDEVENT_ERR;
+        } else if(kevents[i].filter == EVFILT_READ) {
+            revent = UA_FDEVENT_IN;
+        } else {
+            revent = UA_FDEVENT_OUT;
+        }
+
+        /* Call the EventSource callback */
+        rfd->eventSourceCB(rfd->es, rfd, revent);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+#elif !defined(UA_HAVE_EPOLL)
+
+UA_StatusCode
+UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "Registering fd: %u", (unsigned)rfd->fd);
+
+    /* Realloc */
+    UA_RegisteredFD **fds_tmp = (UA_RegisteredFD**)
+        UA_realloc(el->fds, sizeof(UA_RegisteredFD*) * (el->fdsSize + 1));
+    if(!fds_tmp) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    el->fds = fds_tmp;
+
+    /* Add to the last entry */
+    el->fds[el->fdsSize] = rfd;
+    el->fdsSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    /* It is enough if the data was changed in the rfd. But the fd sets are
+     * built before select. Interrupt a select that is running in another
+     * thread, so that the change is considered. */
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+#ifdef UA_HAVE_WAKEUPFD
+    wakeup(el);
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                 "Unregistering fd: %u", (unsigned)rfd->fd);
+
+    /* Find the entry */
+    size_t i = 0;
+    for(; i < el->fdsSize; i++) {
+        if(el->fds[i] == rfd)
+            break;
+    }
+
+    /* Not found? */
+    if(i == el->fdsSize)
+        return;
+
+    if(el->fdsSize > 1) {
+        /* Move the last entry in the ith slot and realloc. */
+        el->fdsSize--;
+        el->fds[i] = el->fds[el->fdsSize];
+        UA_RegisteredFD **fds_tmp = (UA_RegisteredFD**)
+            UA_realloc(el->fds, sizeof(UA_RegisteredFD*) * el->fdsSize);
+        /* if realloc fails the fds are still in a correct state with
+         * possibly lost memory, so failing silently here is ok */
+        if(fds_tmp)
+            el->fds = fds_tmp;
+    } else {
+        /* Remove the last entry */
+        UA_free(el->fds);
+        el->fds = NULL;
+        el->fdsSize = 0;
+    }
+}
+
+static UA_FD
+setFDSets(UA_EventLoopPOSIX *el, fd_set *readset, fd_set *writeset, fd_set *errset) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+    FD_ZERO(readset);
+    FD_ZERO(writeset);
+    FD_ZERO(errset);
+    UA_FD highestfd = UA_INVALID_FD;
+    for(size_t i = 0; i < el->fdsSize; i++) {
+        UA_FD currentFD = el->fds[i]->fd;
+
+#ifdef _WIN32
+        /* FD_SET scans the array for duplicates. Every fd is registered only
+         * once. So append directly instead of taking quadratic time. */
+        if(i >= FD_SETSIZE) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "More than FD_SETSIZE (%u) sockets registered. "
+                           "The remaining sockets are not polled.",
+                           (unsigned)FD_SETSIZE);
+            break;
+        }
+        if(el->fds[i]->listenEvents & UA_FDEVENT_IN)
+            readset->fd_array[readset->fd_count++] = currentFD;
+        if(el->fds[i]->listenEvents & UA_FDEVENT_OUT)
+            writeset->fd_array[writeset->fd_count++] = currentFD;
+        errset->fd_array[errset->fd_count++] = currentFD;
+#else
+        /* Add to the fd_sets */
+        if(el->fds[i]->listenEvents & UA_FDEVENT_IN)
+            FD_SET(currentFD, readset);
+        if(el->fds[i]->listenEvents & UA_FDEVENT_OUT)
+            FD_SET(currentFD, writeset);
+
+        /* Always return errors */
+        FD_SET(currentFD, errset);
+#endif
+
+        /* Highest fd? */
+        if(currentFD > highestfd || highestfd == UA_INVALID_FD)
+            highestfd = currentFD;
+    }
+    return highestfd;
+}
+
+#ifdef _WIN32
+/* FD_ISSET scans the fd_array of the winsock fd_set. Testing every registered
+ * socket that way takes quadratic time. After select, the sets contain only
+ * the signaled sockets. They are sorted once and searched with bsearch. */
+static void
+sortFDSet(fd_set *set) {
+    UA_EventLoopPOSIX_sortFDs(set->fd_array, set->fd_count);
+}
+
+static UA_Boolean
+isSetFD(UA_FD fd, fd_set *set) {
+    return UA_EventLoopPOSIX_containsFD(set->fd_array, set->fd_count, fd);
+}
+#else
+static UA_Boolean
+isSetFD(UA_FD fd, fd_set *set) {
+    return (FD_ISSET(fd, set) != 0);
+}
+#endif
+
+UA_StatusCode
+UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
+    UA_assert(listenTimeout >= 0);
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+#ifdef _WIN32
+    fd_set *readset = &el->readset, *writeset = &el->writeset;
+    fd_set *errset = &el->errset;
+#else
+    fd_set readset_s, writeset_s, errset_s;
+    fd_set *readset = &readset_s, *writeset = &writeset_s;
+    fd_set *errset = &errset_s;
+#endif
+    UA_FD highestfd = setFDSets(el, readset, writeset, errset);
+
+    /* Nothing to do? */
+    if(highestfd == UA_INVALID_FD) {
+        UA_LOG_TRACE(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                     "No valid FDs for processing");
+        return UA_STATUSCODE_GOOD;
+    }
+
+    struct timeval tmptv = {
+#ifndef _WIN32
+        (time_t)(listenTimeout / UA_DATETIME_SEC),
+        (suseconds_t)((listenTimeout % UA_DATETIME_SEC) / UA_DATETIME_USEC)
+#else
+        (long)(listenTimeout / UA_DATETIME_SEC),
+        (long)((listenTimeout % UA_DATETIME_SEC) / UA_DATETIME_USEC)
+#endif
+    };
+
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = true;
+#endif
+    UA_DateTime pollStart = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    el->nowCached = 0; /* Invalid while waiting */
+    UA_UNLOCK(&el->elMutex);
+    int selectStatus = UA_select(highestfd+1, readset, writeset, errset, &tmptv);
+    UA_LOCK(&el->elMutex);
+    el->pollTime = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - pollStart;
+    el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = false;
+#endif
+    if(selectStatus < 0) {
+        /* We will retry, only log the error */
+        UA_LOG_SOCKET_ERRNO_WRAP(
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                           "Error during select: %s", errno_str));
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Timeout without events */
+    if(selectStatus == 0)
+        return UA_STATUSCODE_GOOD;
+
+#ifdef _WIN32
+    sortFDSet(readset);
+    sortFDSet(writeset);
+    sortFDSet(errset);
+#endif
+
+    /* Loop over the registered fds to see if an event arrived. selectStatus
+     * is the number of set entries. Stop when all of them are handled. */
+    for(size_t i = 0; i < el->fdsSize && selectStatus > 0; i++) {
+        UA_RegisteredFD *rfd = el->fds[i];
+
+        /* Event signaled for the fd? */
+        UA_Boolean in = isSetFD(rfd->fd, readset);
+        UA_Boolean out = isSetFD(rfd->fd, writeset);
+        UA_Boolean err = isSetFD(rfd->fd, errset);
+        selectStatus -= (int)in + (int)out + (int)err;
+        short event = 0;
+        if(in) {
+            event = UA_FDEVENT_IN;
+        } else if(out) {
+            event = UA_FDEVENT_OUT;
+        } else if(err) {
+            event = UA_FDEVENT_ERR;
+        } else {
+            continue;
+        }
+
+        /* The rfd is already registered for removal. Don't process incoming
+         * events any longer. */
+        if(rfd->dc.callback)
+            continue;
+
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                     "Processing event %u on fd %u", (unsigned)event,
+                     (unsigned)rfd->fd);
+
+        /* Call the EventSource callback */
+        rfd->eventSourceCB(rfd->es, rfd, event);
+
+        /* The fd has removed itself */
+        if(i == el->fdsSize || rfd != el->fds[i])
+            i--;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+#elif defined(UA_HAVE_IOURING)
+
+/* There is no io_uring wrapper in the C library. Use the raw syscalls. */
+static int
+ringSetup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int
+ringEnter(UA_FD fd, unsigned toSubmit, unsigned minComplete,
+          unsigned flags, void *arg, size_t argSize) {
+    return (int)syscall(__NR_io_uring_enter, fd, toSubmit, minComplete,
+                        flags, arg, argSize);
+}
+
+static void *
+ringMap(UA_FD fd, size_t size, off_t offset) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, offset);
+    return (ptr == MAP_FAILED) ? NULL : ptr;
+}
+
+#ifdef UA_HAVE_IOURING_RECV
+
+/* Hand the buffer back to the kernel */
+static void
+recycleRxBuffer(UA_IOUring *ring, UA_UInt16 bid) {
+    struct io_uring_buf *buf =
+        &ring->rxRing->bufs[ring->rxTail & (UA_IOURING_RXBUFFERS - 1)];
+    buf->addr = (UA_UInt64)(uintptr_t)
+        (ring->rxBufs + ((size_t)bid * UA_IOURING_RXBUFSIZE));
+    buf->len = UA_IOURING_RXBUFSIZE;
+    buf->bid = bid;
+    ring->rxTail++;
+    __atomic_store_n(&ring->rxRing->tail, ring->rxTail, __ATOMIC_RELEASE);
+}
+
+/* Register the provided buffers (Linux >= 5.19). The kernel picks one of them
+ * for every received message. Without them, the sockets are only polled for
+ * readiness. */
+static void
+setupRxBuffers(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    ring->rxRingSize = UA_IOURING_RXBUFFERS * sizeof(struct io_uring_buf);
+    void *rxRing = mmap(NULL, ring->rxRingSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ring->rxBufs = (UA_Byte*)
+        UA_malloc((size_t)UA_IOURING_RXBUFFERS * UA_IOURING_RXBUFSIZE);
+    if(rxRing == MAP_FAILED || !ring->rxBufs)
+        goto error;
+    ring->rxRing = (struct io_uring_buf_ring*)rxRing;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(struct io_uring_buf_reg));
+    reg.ring_addr = (UA_UInt64)(uintptr_t)rxRing;
+    reg.ring_entries = UA_IOURING_RXBUFFERS;
+    reg.bgid = 0;
+    if(syscall(__NR_io_uring_register, ring->fd,
+               IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Eventloop\t| No provided buffers in the io_uring (%s). "
+                       "Receive after polling the sockets.", errno_str));
+        goto error;
+    }
+
+    for(UA_UInt16 i = 0; i < UA_IOURING_RXBUFFERS; i++)
+        recycleRxBuffer(ring, i);
+    return;
+
+ error:
+    if(rxRing != MAP_FAILED)
+        munmap(rxRing, ring->rxRingSize);
+    UA_free(ring->rxBufs);
+    ring->rxRing = NULL;
+    ring->rxBufs = NULL;
+}
+
+#endif
+
+UA_StatusCode
+UA_EventLoopPOSIX_openRing(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    memset(ring, 0, sizeof(UA_IOUring));
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(struct io_uring_params));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = UA_IOURING_ENTRIES * UA_IOURING_CQFACTOR;
+    ring->fd = ringSetup(UA_IOURING_ENTRIES, &p);
+    if(ring->fd == UA_INVALID_FD) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not set up the io_uring (%s)",
+                          errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* The timeout of the wait is passed as an extended argument */
+    if(!(p.features & IORING_FEAT_EXT_ARG)) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Eventloop\t| The io_uring has no timeout for waiting "
+                       "(requires Linux >= 5.11)");
+        UA_EventLoopPOSIX_closeRing(el);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    /* Map the queues shared with the kernel */
+    ring->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->sqRing = ringMap(ring->fd, ring->sqRingSize, IORING_OFF_SQ_RING);
+    ring->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    ring->cqRing = ringMap(ring->fd, ring->cqRingSize, IORING_OFF_CQ_RING);
+    ring->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)
+        ringMap(ring->fd, ring->sqesSize, (off_t)IORING_OFF_SQES);
+    if(!ring->sqRing || !ring->cqRing || !ring->sqes) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not map the io_uring (%s)",
+                          errno_str));
+        UA_EventLoopPOSIX_closeRing(el);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    char *sq = (char*)ring->sqRing;
+    ring->sqHead = (unsigned*)(sq + p.sq_off.head);
+    ring->sqTail = (unsigned*)(sq + p.sq_off.tail);
+    ring->sqArray = (unsigned*)(sq + p.sq_off.array);
+    ring->sqMask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    ring->sqEntries = p.sq_entries;
+
+    char *cq = (char*)ring->cqRing;
+    ring->cqHead = (unsigned*)(cq + p.cq_off.head);
+    ring->cqTail = (unsigned*)(cq + p.cq_off.tail);
+    ring->cqMask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+#ifdef UA_HAVE_IOURING_RECV
+    setupRxBuffers(el);
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_EventLoopPOSIX_closeRing(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    if(ring->sqes)
+        munmap(ring->sqes, ring->sqesSize);
+    if(ring->cqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    if(ring->sqRing)
+        munmap(ring->sqRing, ring->sqRingSize);
+    if(ring->fd != UA_INVALID_FD)
+        UA_close(ring->fd);
+#ifdef UA_HAVE_IOURING_RECV
+    if(ring->rxRing)
+        munmap(ring->rxRing, ring->rxRingSize);
+    UA_free(ring->rxBufs);
+#endif
+    UA_free(ring->slots);
+    UA_free(ring->freeSlots);
+    memset(ring, 0, sizeof(UA_IOUring));
+    ring->fd = UA_INVALID_FD;
+}
+
+/* Number of queued requests not yet consumed by the kernel */
+static unsigned
+ringPending(UA_IOUring *ring) {
+    return *ring->sqTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE);
+}
+
+/* Submit the queued requests without waiting for completions */
+static UA_StatusCode
+flushRing(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    unsigned pending = ringPending(ring);
+    if(pending == 0)
+        return UA_STATUSCODE_GOOD;
+    int res;
+    do {
+        res = ringEnter(ring->fd, pending, 0, 0, NULL, 0);
+    } while(res < 0 && errno == EINTR);
+    if(res < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                          "Eventloop\t| Could not submit to the io_uring (%s)",
+                          errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_ringSubmit(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    return flushRing(el);
+}
+
+/* Get the next free submission entry. Flush the queue if it is full. */
+static struct io_uring_sqe *
+getSQE(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    if(ringPending(ring) >= ring->sqEntries &&
+       (flushRing(el) != UA_STATUSCODE_GOOD ||
+        ringPending(ring) >= ring->sqEntries))
+        return NULL;
+    unsigned index = *ring->sqTail & ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sqArray[index] = index;
+    return sqe;
+}
+
+/* Queue the entry from getSQE. The requests are submitted together with the
+ * next wait for completions. But if another thread is already waiting, the
+ * request is submitted right away. */
+static void
+pushSQE(UA_EventLoopPOSIX *el) {
+    UA_IOUring *ring = &el->ring;
+    __atomic_store_n(ring->sqTail, *ring->sqTail + 1, __ATOMIC_RELEASE);
+#ifdef UA_HAVE_WAKEUPFD
+    if(el->polling)
+        flushRing(el);
+#endif
+}
+
+/* The user_data holds the tag, the operation and the slot */
+#define UA_RINGSLOT_MAX (1u << 24)
+
+static UA_UInt64
+ringUserData(const UA_RegisteredFD *rfd, UA_Byte op) {
+    return ((UA_UInt64)rfd->ringTag << 32) | ((UA_UInt32)op << 24) | rfd->ringSlot;
+}
+
+/* Submit a oneshot poll request. Like epoll without EPOLLET, the request
+ * completes right away if the fd is already ready. If only read-events are of
+ * interest, a multishot receive or accept can be used instead. It stays armed
+ * across many completions. */
+static UA_StatusCode
+armPoll(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    struct io_uring_sqe *sqe = getSQE(el);
+    if(!sqe) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Eventloop\t| The io_uring submission queue is full, "
+                       "cannot poll fd %u", (unsigned)rfd->fd);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+#ifdef UA_HAVE_IOURING_RECV
+    UA_IOUring *ring = &el->ring;
+    if(rfd->ringCB && rfd->listenEvents == UA_FDEVENT_IN && !ring->noMultishot) {
+        if(rfd->ringReadOp == UA_RINGOP_RECV && ring->rxRing) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->fd = rfd->fd;
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+            sqe->flags = IOSQE_BUFFER_SELECT;
+            sqe->buf_group = 0;
+            sqe->user_data = ringUserData(rfd, UA_RINGOP_RECV);
+            rfd->ringArmed = true;
+            rfd->ringArmedOp = UA_RINGOP_RECV;
+            pushSQE(el);
+            return UA_STATUSCODE_GOOD;
+        }
+        if(rfd->ringReadOp == UA_RINGOP_ACCEPT) {
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->fd = rfd->fd;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->accept_flags = SOCK_NONBLOCK;
+            sqe->user_data = ringUserData(rfd, UA_RINGOP_ACCEPT);
+            rfd->ringArmed = true;
+            rfd->ringArmedOp = UA_RINGOP_ACCEPT;
+            pushSQE(el);
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+#endif
+
+    UA_UInt32 events = 0;
+    if(rfd->listenEvents & UA_FDEVENT_IN)
+        events |= POLLIN;
+    if(rfd->listenEvents & UA_FDEVENT_OUT)
+        events |= POLLOUT;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    events = (events << 16) | (events >> 16); /* Expected by the kernel */
+#endif
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = rfd->fd;
+    sqe->poll32_events = events;
+    sqe->user_data = ringUserData(rfd, UA_RINGOP_POLL);
+    rfd->ringArmed = true;
+    rfd->ringArmedOp = UA_RINGOP_POLL;
+    pushSQE(el);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Cancel the poll, receive or accept request. The user_data of the
+ * cancellation itself is zero and its completion is ignored. */
+static void
+cancelPoll(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    struct io_uring_sqe *sqe = getSQE(el);
+    if(!sqe) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Eventloop\t| The io_uring submission queue is full, "
+                       "cannot cancel the poll for fd %u", (unsigned)rfd->fd);
+        return;
+    }
+    sqe->opcode = (rfd->ringArmedOp == UA_RINGOP_POLL) ?
+        IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = ringUserData(rfd, rfd->ringArmedOp);
+    pushSQE(el);
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_ringSendMsg(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                              struct msghdr *msg) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    struct io_uring_sqe *sqe = getSQE(el);
+    if(!sqe) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                       "Eventloop\t| The io_uring submission queue is full, "
+                       "cannot send on fd %u", (unsigned)rfd->fd);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = rfd->fd;
+    sqe->addr = (UA_UInt64)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = ringUserData(rfd, UA_RINGOP_SEND);
+    pushSQE(el);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_IOUring *ring = &el->ring;
+
+    /* Grow the slots and the free-list together */
+    if(ring->freeSlotsSize == 0 && ring->slotsSize == ring->slotsCapacity) {
+        if(ring->slotsCapacity >= UA_RINGSLOT_MAX)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        size_t capacity = (ring->slotsCapacity == 0) ? 16 : ring->slotsCapacity * 2;
+        UA_RegisteredFD **slots_tmp = (UA_RegisteredFD**)
+            UA_realloc(ring->slots, sizeof(UA_RegisteredFD*) * capacity);
+        if(!slots_tmp)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        ring->slots = slots_tmp;
+        UA_UInt32 *free_tmp = (UA_UInt32*)
+            UA_realloc(ring->freeSlots, sizeof(UA_UInt32) * capacity);
+        if(!free_tmp)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        ring->freeSlots = free_tmp;
+        ring->slotsCapacity = capacity;
+    }
+
+    /* Take a slot and a new tag */
+    UA_UInt32 slot = (ring->freeSlotsSize > 0) ?
+        ring->freeSlots[--ring->freeSlotsSize] : (UA_UInt32)ring->slotsSize++;
+    ring->slots[slot] = rfd;
+    ring->lastTag++;
+    if(ring->lastTag == 0)
+        ring->lastTag = 1; /* Zero is used for the cancellations */
+    rfd->ringSlot = slot;
+    rfd->ringTag = ring->lastTag;
+    rfd->ringArmed = false;
+
+    UA_StatusCode res = armPoll(el, rfd);
+    if(res != UA_STATUSCODE_GOOD) {
+        ring->slots[slot] = NULL;
+        ring->freeSlots[ring->freeSlotsSize++] = slot;
+    }
+    return res;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    /* The poll request is resubmitted with the new events when its
+     * cancellation completes. Without a request in flight, the fd is in its
+     * callback right now. The request is resubmitted afterwards. */
+    if(rfd->ringArmed)
+        cancelPoll(el, rfd);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_IOUring *ring = &el->ring;
+    if(rfd->ringSlot >= ring->slotsSize || ring->slots[rfd->ringSlot] != rfd)
+        return; /* Not registered */
+    /* The request in flight holds a reference to the socket. Cancel right
+     * away, so that closing the fd releases the socket (and its port). */
+    if(rfd->ringArmed) {
+        cancelPoll(el, rfd);
+        flushRing(el);
+    }
+    rfd->ringArmed = false;
+    ring->slots[rfd->ringSlot] = NULL;
+    ring->freeSlots[ring->freeSlotsSize++] = rfd->ringSlot;
+}
+
+/* Completion of a multishot receive or accept. Returns whether the request
+ * has to be resubmitted. */
+static UA_Boolean
+processReadCompletion(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd, UA_Byte op,
+                      int result, UA_ByteString data) {
+    /* Closing. Also a shut down listen socket fails with EINVAL. Close the
+     * connections accepted in the meantime. */
+    if(rfd->dc.callback) {
+        if(op == UA_RINGOP_ACCEPT && result >= 0)
+            UA_close((UA_FD)result);
+        return false;
+    }
+
+    /* The kernel does not support the request. Fall back to polling for all
+     * fds. The EventSources then read after the readiness was signaled. */
+    if(result == -EINVAL || result == -EOPNOTSUPP) {
+#ifdef UA_HAVE_IOURING_RECV
+        if(!el->ring.noMultishot) {
+            UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                        "Eventloop\t| No multishot requests in the io_uring. "
+                        "Receive after polling the sockets.");
+            el->ring.noMultishot = true;
+        }
+#endif
+        return true;
+    }
+
+    /* Cancelled by modifyFD or the provided buffers ran out */
+    if(result == -ECANCELED || result == -ENOBUFS)
+        return true;
+
+    rfd->ringCB(rfd->es, rfd, op, result, data);
+    return true;
+}
+
+static void
+processCompletion(UA_EventLoopPOSIX *el, UA_UInt64 userData,
+                  int result, UA_UInt32 flags) {
+    UA_IOUring *ring = &el->ring;
+    UA_UInt32 slot = (UA_UInt32)userData & (UA_RINGSLOT_MAX - 1);
+    UA_Byte op = (UA_Byte)((UA_UInt32)userData >> 24);
+    UA_UInt32 tag = (UA_UInt32)(userData >> 32);
+    if(tag == 0)
+        return; /* Cancellation */
+
+    /* The received data is in a provided buffer */
+    UA_ByteString data = UA_BYTESTRING_NULL;
+#ifdef UA_HAVE_IOURING_RECV
+    UA_UInt16 bid = 0;
+    UA_Boolean hasBuffer = ((flags & IORING_CQE_F_BUFFER) != 0);
+    if(hasBuffer) {
+        bid = (UA_UInt16)(flags >> IORING_CQE_BUFFER_SHIFT);
+        data.data = ring->rxBufs + ((size_t)bid * UA_IOURING_RXBUFSIZE);
+        data.length = (result > 0) ? (size_t)result : 0;
+    }
+#endif
+
+    /* The fd was deregistered in the meantime */
+    UA_RegisteredFD *rfd = (slot < ring->slotsSize) ? ring->slots[slot] : NULL;
+    if(!rfd || rfd->ringTag != tag) {
+        if(op == UA_RINGOP_ACCEPT && result >= 0)
+            UA_close((UA_FD)result);
+        goto recycle;
+    }
+
+    /* The EventSource owns the memory of the send. Signal the completion also
+     * when the fd is closing. */
+    if(op == UA_RINGOP_SEND) {
+        rfd->ringCB(rfd->es, rfd, op, result, data);
+        goto recycle;
+    }
+
+    /* A multishot request stays armed while the kernel signals more
+     * completions */
+    if(!(flags & IORING_CQE_F_MORE) && rfd->ringArmedOp == op)
+        rfd->ringArmed = false;
+
+    if(op != UA_RINGOP_POLL) {
+        if(!processReadCompletion(el, rfd, op, result, data))
+            goto recycle;
+    } else {
+        /* The rfd is already registered for removal. Don't process incoming
+         * events any longer. */
+        if(rfd->dc.callback)
+            goto recycle;
+
+        /* Cancelled by modifyFD. Resubmit with the new events. */
+        if(result != -ECANCELED) {
+            /* Get the event */
+            short revent = 0;
+            if(result < 0) {
+                revent = UA_FDEVENT_ERR;
+            } else if((result & POLLIN) == POLLIN) {
+                revent = UA_FDEVENT_IN;
+            } else if((result & POLLOUT) == POLLOUT) {
+                revent = UA_FDEVENT_OUT;
+            } else {
+                revent = UA_FDEVENT_ERR;
+            }
+
+            /* Call the EventSource callback */
+            rfd->eventSourceCB(rfd->es, rfd, revent);
+        }
+    }
+
+    /* Deregistered, closing or still/already armed */
+    if(ring->slots[slot] == rfd && rfd->ringTag == tag &&
+       !rfd->ringArmed && !rfd->dc.callback)
+        armPoll(el, rfd);
+
+ recycle:
+#ifdef UA_HAVE_IOURING_RECV
+    if(hasBuffer)
+        recycleRxBuffer(ring, bid);
+#endif
+    return;
+}
+
+/* Process the completions up to the current tail. Completions of requests
+ * submitted by the callbacks are processed in the next iteration. Returns the
+ * number of completions other than for sends. */
+size_t
+UA_EventLoopPOSIX_ringReap(UA_EventLoopPOSIX *el) {
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+    UA_IOUring *ring = &el->ring;
+    size_t events = 0;
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    while(head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & ring->cqMask];
+        UA_UInt64 userData = cqe->user_data;
+        int result = cqe->res;
+        UA_UInt32 flags = cqe->flags;
+        head++;
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        if((UA_Byte)((UA_UInt32)userData >> 24) != UA_RINGOP_SEND)
+            events++;
+        processCompletion(el, userData, result, flags);
+    }
+    return events;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
+    UA_assert(listenTimeout >= 0);
+    UA_IOUring *ring = &el->ring;
+
+    /* Submit the queued requests and wait in a single syscall. Continue to
+     * wait until the timeout if only sends have completed, like the other
+     * backends. */
+    UA_DateTime waited = 0;
+    size_t events = 0;
+    int res = 0;
+    do {
+        struct __kernel_timespec timeout;
+        timeout.tv_sec = (listenTimeout - waited) / UA_DATETIME_SEC;
+        timeout.tv_nsec = ((listenTimeout - waited) % UA_DATETIME_SEC) * 100;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(struct io_uring_getevents_arg));
+        arg.ts = (UA_UInt64)(uintptr_t)&timeout;
+        unsigned toSubmit = ringPending(ring);
+
+#ifdef UA_HAVE_WAKEUPFD
+        el->polling = true;
+#endif
+        UA_DateTime pollStart = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+        el->nowCached = 0; /* Invalid while waiting */
+        UA_UNLOCK(&el->elMutex);
+        res = ringEnter(ring->fd, toSubmit, 1,
+                        IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                        &arg, sizeof(struct io_uring_getevents_arg));
+        int err = errno;
+        UA_LOCK(&el->elMutex);
+        waited += el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - pollStart;
+        el->pollTime = waited;
+        el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
+#ifdef UA_HAVE_WAKEUPFD
+        el->polling = false;
+#endif
+
+        /* Handle error conditions. The timeout and interruptions are normal.
+         * With EBUSY the completion queue overflowed. Then take out the
+         * completions and retry the submission in the next iteration. */
+        if(res < 0 && err != ETIME && err != EINTR &&
+           err != EBUSY && err != EAGAIN) {
+            errno = err;
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
+                              "Eventloop\t| Error %s when waiting for the io_uring",
+                              errno_str));
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        events = UA_EventLoopPOSIX_ringReap(el);
+    } while(events == 0 && res >= 0 && waited < listenTimeout);
+
+    /* Submit the sends and the rearmed requests of the callbacks. Sends to
+     * writable sockets complete right away. Their completion queues the
+     * remainder of the send queue. Repeat until everything is submitted. */
+    while(ringPending(ring) > 0 && flushRing(el) == UA_STATUSCODE_GOOD)
+        UA_EventLoopPOSIX_ringReap(el);
+    return UA_STATUSCODE_GOOD;
+}
+
+#else /* defined(UA_HAVE_EPOLL) */
+
+UA_StatusCode
+UA_EventLoopPOSIX_registerFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.data.ptr = rfd;
+    event.events = 0;
+    if(rfd->listenEvents & UA_FDEVENT_IN)
+        event.events |= EPOLLIN;
+    if(rfd->listenEvents & UA_FDEVENT_OUT)
+        event.events |= EPOLLOUT;
+
+    int err = epoll_ctl(el->epollfd, EPOLL_CTL_ADD, rfd->fd, &event);
+    if(err != 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                          "TCP %u\t| Could not register for epoll (%s)",
+                          rfd->fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_EventLoopPOSIX_modifyFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(struct epoll_event));
+    event.data.ptr = rfd;
+    event.events = 0;
     if(rfd->listenEvents & UA_FDEVENT_IN)
         event.events |= EPOLLIN;
     if(rfd->listenEvents & UA_FDEVENT_OUT)
@@ -865,10 +2270,15 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
     UA_assert(listenTimeout >= 0);
 
     /* Poll the registered sockets */
-    struct epoll_event epoll_events[64];
+    struct epoll_event epoll_events[UA_MAXEPOLLEVENTS];
     int epollfd = el->epollfd;
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = true;
+#endif
+    UA_DateTime pollStart = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop);
+    el->nowCached = 0; /* Invalid while waiting */
     UA_UNLOCK(&el->elMutex);
-    int events = epoll_wait(epollfd, epoll_events, 64,
+    int events = epoll_wait(epollfd, epoll_events, UA_MAXEPOLLEVENTS,
                             (int)(listenTimeout / UA_DATETIME_MSEC));
     /* TODO: Replace with pwait2 for higher-precision timeouts once this is
      * available in the standard library.
@@ -877,9 +2287,14 @@ UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout) {
      *  (long)(listenTimeout / UA_DATETIME_SEC),
      *   (long)((listenTimeout % UA_DATETIME_SEC) * 100)
      * };
-     * int events = epoll_pwait2(epollfd, epoll_events, 64,
+     * int events = epoll_pwait2(epollfd, epoll_events, UA_MAXEPOLLEVENTS,
      *                        precisionTimeout, NULL); */
     UA_LOCK(&el->elMutex);
+    el->pollTime = el->eventLoop.dateTime_nowMonotonic(&el->eventLoop) - pollStart;
+    el->nowCached = el->eventLoop.dateTime_now(&el->eventLoop);
+#ifdef UA_HAVE_WAKEUPFD
+    el->polling = false;
+#endif
 
     /* Handle error conditions */
     if(events == -1) {
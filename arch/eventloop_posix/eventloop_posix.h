@@ -38,6 +38,14 @@ _UA_BEGIN_DECLS
 
 #include <stdlib.h>
 #include <stdio.h>
+
+/* The default of 64 sockets for select is too small for servers with many
+ * connections. The winsock fd_set is an array of sockets (not a bitmap indexed
+ * by the fd). So the capacity can be raised at compile time. */
+#ifndef FD_SETSIZE
+# define FD_SETSIZE 4096
+#endif
+
 #include <winsock2.h>
 #include <windows.h>
 #include <ws2tcpip.h>
@@ -114,6 +122,7 @@ typedef SSIZE_T ssize_t;
 #include <poll.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/uio.h>
 
 #if defined(__unix__) || (defined(__APPLE__) && defined(__MACH__))
 # include <sys/param.h>
@@ -161,6 +170,52 @@ typedef SSIZE_T ssize_t;
 #if defined(__linux__) && !defined(__TINYC__)
 # define UA_HAVE_EPOLL
 # include <sys/epoll.h>
+/* Maximum number of events taken from one epoll_wait. With many connections,
+ * more events are handled per iteration of the EventLoop. */
+# ifndef UA_MAXEPOLLEVENTS
+#  define UA_MAXEPOLLEVENTS 512
+# endif
+/* With UA_ENABLE_IOURING the fds are polled with an io_uring instead of the
+ * epoll fd. The Linux-specific eventfd and signalfd are used as with epoll. */
+# ifdef UA_ENABLE_IOURING
+#  define UA_HAVE_IOURING
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+/* Number of entries in the submission queue. The completion queue has
+ * UA_IOURING_CQFACTOR times as many entries. */
+#  ifndef UA_IOURING_ENTRIES
+#   define UA_IOURING_ENTRIES 256
+#  endif
+#  define UA_IOURING_CQFACTOR 16
+#  ifndef IORING_CQE_F_MORE
+#   define IORING_CQE_F_MORE (1U << 1) /* Only set by multishot requests */
+#  endif
+/* Buffers provided to the kernel for the multishot receive (Linux >= 6.0).
+ * The number of buffers must be a power of two. */
+#  ifdef IORING_RECV_MULTISHOT
+#   define UA_HAVE_IOURING_RECV
+#   ifndef UA_IOURING_RXBUFFERS
+#    define UA_IOURING_RXBUFFERS 64
+#   endif
+#   ifndef UA_IOURING_RXBUFSIZE
+#    define UA_IOURING_RXBUFSIZE (1u << 16)
+#   endif
+#  endif
+# endif
+#elif defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__OpenBSD__) || defined(__DragonFly__)
+/* kqueue is the scalable counterpart of epoll on macOS and the BSDs */
+# define UA_HAVE_KQUEUE
+# include <sys/event.h>
+# include <time.h>
+# ifndef UA_MAXKQUEUEEVENTS
+#  define UA_MAXKQUEUEEVENTS 512
+# endif
+#else
+/* Use poll() where epoll is not available. Unlike select, it is not limited to
+ * FD_SETSIZE and the pollfd array is kept between the iterations. */
+# define UA_HAVE_POLL
 #endif
 
 #endif
@@ -181,6 +236,18 @@ typedef SSIZE_T ssize_t;
 #define MSG_DONTWAIT 0
 #endif
 
+/* Wake up a waiting EventLoop from other threads. Uses an eventfd on Linux, a
+ * user event for kqueue (where available) and the self-pipe trick otherwise. */
+#if UA_MULTITHREADING >= 100 && !defined(_WIN32)
+# define UA_HAVE_WAKEUPFD
+# ifdef UA_HAVE_EPOLL
+#  include <sys/eventfd.h>
+# endif
+# if defined(UA_HAVE_KQUEUE) && defined(EVFILT_USER)
+#  define UA_HAVE_KQUEUE_USER
+# endif
+#endif
+
 /* POSIX events are based on sockets / file descriptors. The EventSources can
  * register their fd in the EventLoop so that they are considered by the
  * EventLoop dropping into "poll" to wait for events. */
@@ -200,6 +267,20 @@ typedef struct UA_RegisteredFD UA_RegisteredFD;
 
 typedef void (*UA_FDCallback)(UA_EventSource *es, UA_RegisteredFD *rfd, short event);
 
+#ifdef UA_HAVE_IOURING
+/* Operations of a registered fd in the io_uring */
+#define UA_RINGOP_POLL 0   /* Readiness, signaled to the eventSourceCB */
+#define UA_RINGOP_RECV 1   /* Multishot receive into the provided buffers */
+#define UA_RINGOP_ACCEPT 2 /* Multishot accept */
+#define UA_RINGOP_SEND 3   /* Send from memory owned by the EventSource */
+
+/* Completion of a receive, accept or send in the io_uring. The result is that
+ * of the syscall (negative errno on failure). Received data lies in a buffer
+ * of the EventLoop. It is handed back to the kernel after the callback. */
+typedef void (*UA_RingCallback)(UA_EventSource *es, UA_RegisteredFD *rfd,
+                                UA_Byte op, int result, UA_ByteString data);
+#endif
+
 struct UA_RegisteredFD {
     UA_DelayedCallback dc; /* Used for async closing. Must be the first member
                             * because the rfd is freed by the delayed callback
@@ -211,6 +292,19 @@ struct UA_RegisteredFD {
 
     UA_EventSource *es; /* Backpointer to the EventSource */
     UA_FDCallback eventSourceCB;
+
+#ifdef UA_HAVE_POLL
+    size_t pollIndex; /* Position in the pollfd array of the EventLoop */
+#endif
+#ifdef UA_HAVE_IOURING
+    UA_UInt32 ringSlot;   /* Position in the slots array of the io_uring */
+    UA_UInt32 ringTag;    /* Distinguishes the users of a reused slot */
+    UA_Boolean ringArmed; /* A poll, receive or accept request is submitted */
+    UA_Byte ringArmedOp;  /* Operation of the submitted request */
+    UA_Byte ringReadOp;   /* Used instead of polling if only listening for
+                           * UA_FDEVENT_IN (requires the ringCB) */
+    UA_RingCallback ringCB;
+#endif
 };
 
 enum ZIP_CMP cmpFD(const UA_FD *a, const UA_FD *b);
@@ -227,11 +321,60 @@ typedef struct {
     UA_ByteString rxBuffer;
     UA_ByteString txBuffer;
 
+    /* Number of datagrams received with one syscall (only used for UDP) */
+    size_t rxBatchSize;
+
+    /* Maximum bytes in the send queue of a connection (only used for TCP) */
+    size_t txQueueLimit;
+
     /* Sorted tree of the FDs */
     size_t fdsSize;
     UA_FDTree fds;
 } UA_POSIXConnectionManager;
 
+#ifdef UA_HAVE_IOURING
+/* The submission and completion queues are shared with the kernel. Each
+ * registered fd has (at most) one oneshot poll or multishot receive/accept
+ * request in flight. The request is resubmitted after its final completion
+ * was processed. The user_data of the requests carries the slot, operation and
+ * tag of the fd. Completions for fds that were deregistered in the meantime
+ * are detected and dropped. */
+typedef struct {
+    UA_FD fd;
+    void *sqRing;
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqArray;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    UA_RegisteredFD **slots; /* NULL for unused slots */
+    UA_UInt32 *freeSlots;    /* Same capacity as the slots */
+    size_t slotsSize;
+    size_t slotsCapacity;
+    size_t freeSlotsSize;
+    UA_UInt32 lastTag;
+
+#ifdef UA_HAVE_IOURING_RECV
+    /* Ring of the buffers provided to the kernel. NULL if not supported. */
+    struct io_uring_buf_ring *rxRing;
+    size_t rxRingSize;
+    UA_Byte *rxBufs;
+    UA_UInt16 rxTail;
+    UA_Boolean noMultishot; /* Requests failed, poll for readiness instead */
+#endif
+} UA_IOUring;
+#endif
+
 typedef struct {
     UA_EventLoop eventLoop;
 
@@ -241,26 +384,79 @@ typedef struct {
     /* Linked List of Delayed Callbacks */
     UA_DelayedCallback *delayedCallbacks;
 
+    /* Lock-free submission of delayed callbacks from other threads. Pushed with
+     * an atomic compare-and-swap. Moved in one piece to the delayedCallbacks
+     * list with the elMutex held. */
+    UA_DelayedCallback * volatile delayedQueue;
+
     /* Flag determining whether the eventloop is currently within the
      * "run" method */
     UA_Boolean executing;
 
+    /* Statistics of the iterations. The pollTime is the time waiting for
+     * events in the current iteration. */
+    UA_UInt64 iterationCount;
+    UA_UInt64 busyTime;
+    UA_UInt64 maxBusyTime;
+    UA_UInt64 timerTime;
+    UA_UInt64 delayedTime;
+    UA_UInt64 eventTime;
+    UA_UInt64 waitTime;
+    UA_UInt64 slowDelayedCount;
+    UA_DateTime pollTime;
+
+    /* Wallclock time refreshed at the start of each iteration and after
+     * polling. Returned by dateTime_nowCached while executing. */
+    UA_DateTime nowCached;
+
 #if defined(UA_ARCHITECTURE_POSIX) && !defined(__APPLE__) && !defined(__MACH__)
     /* Clocks for the eventloop's time domain */
     UA_Int32 clockSource;
     UA_Int32 clockSourceMonotonic;
 #endif
 
-#if defined(UA_HAVE_EPOLL)
+#if defined(UA_HAVE_IOURING)
+    UA_IOUring ring;
+#elif defined(UA_HAVE_EPOLL)
     UA_FD epollfd;
+#elif defined(UA_HAVE_KQUEUE)
+    UA_FD kqueuefd;
+#elif defined(UA_HAVE_POLL)
+    /* The registered fds and the matching pollfd entries at the same index.
+     * Updated incrementally when fds are (de)registered or modified. Changes
+     * from other threads while polling only touch the fds array and mark the
+     * pollfds as dirty. They are rebuilt before the next poll. */
+    UA_RegisteredFD **fds;
+    struct pollfd *pollfds;
+    size_t fdsSize;
+    size_t fdsCapacity;
+    UA_Boolean pollfdsDirty;
 #else
+    /* select is used on Windows. The readiness of all sockets is tested in
+     * each iteration. There is no completion-based backend (IOCP). */
     UA_RegisteredFD **fds;
     size_t fdsSize;
+# ifdef _WIN32
+    /* Large with the raised FD_SETSIZE. Kept here instead of the stack. */
+    fd_set readset;
+    fd_set writeset;
+    fd_set errset;
+# endif
 #endif
 
 #if UA_MULTITHREADING >= 100
     UA_Lock elMutex;
 #endif
+
+#ifdef UA_HAVE_WAKEUPFD
+    /* Interrupts the poll when a delayed callback is added from another thread.
+     * The RegisteredFD has no EventSource. */
+    UA_RegisteredFD wakeupFD;
+    UA_FD wakeupWriteFD;    /* Same as the read-side for an eventfd. The
+                             * kqueue fd for a kqueue user event. */
+    UA_Boolean polling;     /* Waiting in poll with the elMutex released */
+    UA_Boolean wakeupSent;  /* Not yet consumed */
+#endif
 } UA_EventLoopPOSIX;
 
 /* The following functions differ between epoll and normal select */
@@ -280,6 +476,41 @@ UA_EventLoopPOSIX_deregisterFD(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd);
 UA_StatusCode
 UA_EventLoopPOSIX_pollFDs(UA_EventLoopPOSIX *el, UA_DateTime listenTimeout);
 
+/* Sort an array of fds and search in it. The select backend on Windows uses
+ * them for the fd_array of the winsock fd_set. They are compiled on all
+ * platforms, so they are covered by the unit tests. */
+void
+UA_EventLoopPOSIX_sortFDs(UA_FD *fds, size_t fdsSize);
+
+UA_Boolean
+UA_EventLoopPOSIX_containsFD(const UA_FD *fds, size_t fdsSize, UA_FD fd);
+
+#ifdef UA_HAVE_IOURING
+/* Set up the io_uring when the EventLoop starts */
+UA_StatusCode
+UA_EventLoopPOSIX_openRing(UA_EventLoopPOSIX *el);
+
+/* Release the io_uring once all EventSources have stopped */
+void
+UA_EventLoopPOSIX_closeRing(UA_EventLoopPOSIX *el);
+
+/* Queue a sendmsg for the fd. It is submitted with the next wait of the
+ * EventLoop. The message and its buffers must remain valid until the
+ * completion is signaled to the ringCB. */
+UA_StatusCode
+UA_EventLoopPOSIX_ringSendMsg(UA_EventLoopPOSIX *el, UA_RegisteredFD *rfd,
+                              struct msghdr *msg);
+
+/* Submit the queued requests right away */
+UA_StatusCode
+UA_EventLoopPOSIX_ringSubmit(UA_EventLoopPOSIX *el);
+
+/* Process the available completions without waiting. Returns the number of
+ * completions other than for sends. */
+size_t
+UA_EventLoopPOSIX_ringReap(UA_EventLoopPOSIX *el);
+#endif
+
 /* Helper functions across EventSources */
 
 UA_StatusCode
@@ -16,6 +16,7 @@
 #include <net/ethernet.h> /* ETH_P_*/
 #include <linux/if_packet.h>
 #include <linux/net_tstamp.h> /* txtime */
+#include <sys/mman.h> /* packet ring */
 
 /* Configuration parameters */
 
@@ -26,7 +27,7 @@ static UA_KeyValueRestriction ethManagerParams[ETH_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
-#define ETH_PARAMETERSSIZE 15
+#define ETH_PARAMETERSSIZE 16
 #define ETH_PARAMINDEX_ADDR 0
 #define ETH_PARAMINDEX_LISTEN 1
 #define ETH_PARAMINDEX_IFACE 2
@@ -42,6 +43,7 @@ static UA_KeyValueRestriction ethManagerParams[ETH_MANAGERPARAMS] = {
 #define ETH_PARAMINDEX_TXTIME_PICO 12
 #define ETH_PARAMINDEX_TXTIME_DROP 13
 #define ETH_PARAMINDEX_VALIDATE 14
+#define ETH_PARAMINDEX_RING 15
 
 static UA_KeyValueRestriction ethConnectionParams[ETH_PARAMETERSSIZE+1] = {
     {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], false, true, false},
@@ -59,12 +61,20 @@ static UA_KeyValueRestriction ethConnectionParams[ETH_PARAMETERSSIZE+1] = {
     {{0, UA_STRING_STATIC("txtime-pico")}, &UA_TYPES[UA_TYPES_UINT16], false, true, false},
     {{0, UA_STRING_STATIC("txtime-drop-late")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
+    {{0, UA_STRING_STATIC("packet-ring")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
     /* Duplicated address parameter with a scalar value required. For the send-socket case. */
     {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], true, true, false},
 };
 
 #define UA_ETH_MAXHEADERLENGTH (2*ETHER_ADDR_LEN)+4+2+2
 
+/* Frames in the PACKET_MMAP ring have a fixed size. The payload of a tx frame
+ * starts after the tpacket header. The largest Ethernet frame that can be sent
+ * or received via the ring is ETH_RINGFRAMESIZE - ETH_RINGTXOFFSET. */
+#define ETH_RINGFRAMESIZE 2048
+#define ETH_RINGMAXFRAMES 4096
+#define ETH_RINGTXOFFSET (TPACKET2_HDRLEN - sizeof(struct sockaddr_ll))
+
 typedef struct {
     UA_RegisteredFD rfd;
 
@@ -84,8 +94,96 @@ typedef struct {
     unsigned char lengthOffset; /* No length field if zero */
 
     UA_Boolean txtimeEnabled;
+
+    /* PACKET_MMAP ring shared with the kernel (not used if NULL). Listen
+     * connections use an rx ring, send connections a tx ring. */
+    UA_Byte *ring;
+    size_t ringSize;       /* Size of the mapped memory */
+    unsigned ringFrames;
+    unsigned ringHead;     /* Next frame to read (rx) or to fill (tx) */
+    unsigned ringClaim;    /* Frame handed out by allocNetworkBuffer (tx) */
+    UA_Boolean ringClaimed;
 } ETH_FD;
 
+static struct tpacket2_hdr *
+ETH_ringFrame(ETH_FD *conn, unsigned index) {
+    return (struct tpacket2_hdr*)(conn->ring + ((size_t)index * ETH_RINGFRAMESIZE));
+}
+
+static UA_Boolean
+ETH_isRingBuffer(ETH_FD *conn, const UA_ByteString *buf) {
+    return (conn->ring && buf->data >= conn->ring &&
+            buf->data < conn->ring + conn->ringSize);
+}
+
+/* Set up a PACKET_MMAP ring with (at least) the given number of frames. The
+ * memory is divided into page-sized blocks that hold several frames. */
+static UA_StatusCode
+ETH_setupRing(UA_EventLoopPOSIX *el, ETH_FD *conn, UA_UInt32 frames,
+              UA_Boolean tx) {
+    long pageSize = sysconf(_SC_PAGESIZE);
+    if(pageSize < ETH_RINGFRAMESIZE)
+        pageSize = ETH_RINGFRAMESIZE;
+    unsigned framesPerBlock = (unsigned)pageSize / ETH_RINGFRAMESIZE;
+    if(frames > ETH_RINGMAXFRAMES)
+        frames = ETH_RINGMAXFRAMES;
+
+    struct tpacket_req req;
+    memset(&req, 0, sizeof(struct tpacket_req));
+    req.tp_block_size = (unsigned)pageSize;
+    req.tp_block_nr = (frames + framesPerBlock - 1) / framesPerBlock;
+    req.tp_frame_size = ETH_RINGFRAMESIZE;
+    req.tp_frame_nr = req.tp_block_nr * framesPerBlock;
+
+    int version = TPACKET_V2;
+    int loss = 1; /* Skip malformed tx frames instead of blocking the ring */
+    if(setsockopt(conn->rfd.fd, SOL_PACKET, PACKET_VERSION,
+                  &version, sizeof(version)) < 0 ||
+       (tx && setsockopt(conn->rfd.fd, SOL_PACKET, PACKET_LOSS,
+                         &loss, sizeof(loss)) < 0) ||
+       setsockopt(conn->rfd.fd, SOL_PACKET, tx ? PACKET_TX_RING : PACKET_RX_RING,
+                  &req, sizeof(req)) < 0) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Could not set up the packet ring (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    size_t size = (size_t)req.tp_block_size * req.tp_block_nr;
+    void *ring = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_LOCKED, conn->rfd.fd, 0);
+    if(ring == MAP_FAILED) /* Retry if locking the pages is not permitted */
+        ring = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, conn->rfd.fd, 0);
+    if(ring == MAP_FAILED) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Could not map the packet ring (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    conn->ring = (UA_Byte*)ring;
+    conn->ringSize = size;
+    conn->ringFrames = req.tp_frame_nr;
+    conn->ringHead = 0;
+    conn->ringClaimed = false;
+
+    UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                "ETH %u\t| Using a packet %s ring with %u frames",
+                (unsigned)conn->rfd.fd, tx ? "tx" : "rx", conn->ringFrames);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+ETH_clearRing(ETH_FD *conn) {
+    if(!conn->ring)
+        return;
+    munmap(conn->ring, conn->ringSize);
+    conn->ring = NULL;
+    conn->ringSize = 0;
+}
+
 /* The format of a Ethernet address is six groups of hexadecimal digits,
  * separated by hyphens (e.g. 01-23-45-67-89-ab). */
 static UA_StatusCode
@@ -216,6 +314,22 @@ ETH_allocNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
     if(!erfd)
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
 
+    /* Hand out the next frame of the tx ring. The message is then encoded
+     * in-place and the frame is submitted in sendWithConnection. Only one frame
+     * can be handed out at a time. Otherwise fall back to a normal buffer. */
+    if(erfd->ring && !erfd->ringClaimed &&
+       bufSize + erfd->headerSize <= ETH_RINGFRAMESIZE - ETH_RINGTXOFFSET) {
+        struct tpacket2_hdr *hdr = ETH_ringFrame(erfd, erfd->ringHead);
+        if(hdr->tp_status == TP_STATUS_AVAILABLE) {
+            erfd->ringClaim = erfd->ringHead;
+            erfd->ringClaimed = true;
+            erfd->ringHead = (erfd->ringHead + 1) % erfd->ringFrames;
+            buf->data = (UA_Byte*)hdr + ETH_RINGTXOFFSET + erfd->headerSize;
+            buf->length = bufSize;
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+
     /* Allocate the buffer with the hidden Ethernet header in front */
     UA_StatusCode res =
         UA_EventLoopPOSIX_allocNetworkBuffer(cm, connectionId, buf,
@@ -237,6 +351,19 @@ ETH_freeNetworkBuffer(UA_ConnectionManager *cm, uintptr_t connectionId,
     if(!erfd)
         return;
 
+    /* Release the tx frame. It is submitted with an invalid length and skipped
+     * by the kernel (PACKET_LOSS), so that the following frames are not
+     * blocked. */
+    if(ETH_isRingBuffer(erfd, buf)) {
+        struct tpacket2_hdr *hdr = ETH_ringFrame(erfd, erfd->ringClaim);
+        hdr->tp_len = ETH_RINGFRAMESIZE;
+        __sync_synchronize();
+        hdr->tp_status = TP_STATUS_SEND_REQUEST;
+        erfd->ringClaimed = false;
+        UA_ByteString_init(buf);
+        return;
+    }
+
     /* Unhide the Ethernet header and free */
     buf->data   -= erfd->headerSize;
     buf->length += erfd->headerSize;
@@ -284,7 +411,8 @@ ETH_close(UA_POSIXConnectionManager *pcm, ETH_FD *conn) {
                         &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
     UA_LOCK(&el->elMutex);
 
-    /* Close the socket */
+    /* Unmap the packet ring and close the socket */
+    ETH_clearRing(conn);
     int ret = UA_close(conn->rfd.fd);
     if(ret == 0) {
         UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
@@ -318,6 +446,98 @@ ETH_delayedClose(void *application, void *context) {
     UA_free(conn);
 }
 
+/* Parse the Ethernet header and forward the frame to the application */
+static void
+ETH_deliver(UA_ConnectionManager *cm, ETH_FD *conn, UA_ByteString response) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    /* Parse the Ethernet header */
+    unsigned char destAddr[ETHER_ADDR_LEN];
+    unsigned char sourceAddr[ETHER_ADDR_LEN];
+    UA_UInt16 etherType = 0;
+    UA_UInt16 vid = 0;
+    UA_Byte pcp = 0;
+    UA_Boolean dei = 0;
+    size_t headerSize = parseETHHeader(&response, destAddr, sourceAddr,
+                                       &etherType, &vid, &pcp, &dei);
+    if(headerSize == 0)
+        return;
+
+    /* Set up the parameter arguments passed to the application */
+    unsigned char destAddrBytes[18];
+    unsigned char sourceAddrBytes[18];
+    setAddrString(destAddrBytes, destAddr);
+    setAddrString(sourceAddrBytes, sourceAddr);
+    UA_String destAddrStr = {17, destAddrBytes};
+    UA_String sourceAddrStr = {17, sourceAddrBytes};
+
+    size_t paramsSize = 2;
+    UA_KeyValuePair params[6];
+    params[0].key = UA_QUALIFIEDNAME(0, "destination-address");
+    UA_Variant_setScalar(&params[0].value, &destAddrStr, &UA_TYPES[UA_TYPES_STRING]);
+    params[1].key = UA_QUALIFIEDNAME(0, "source-address");
+    UA_Variant_setScalar(&params[1].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
+
+    if(etherType > 0) {
+        params[2].key = UA_QUALIFIEDNAME(0, "ethertype");
+        UA_Variant_setScalar(&params[1].value, &etherType, &UA_TYPES[UA_TYPES_UINT16]);
+        paramsSize++;
+    }
+
+    if(vid > 0) {
+        params[paramsSize].key = UA_QUALIFIEDNAME(0, "vid");
+        UA_Variant_setScalar(&params[paramsSize].value, &vid, &UA_TYPES[UA_TYPES_UINT16]);
+        params[paramsSize+1].key = UA_QUALIFIEDNAME(0, "pcp");
+        UA_Variant_setScalar(&params[paramsSize+1].value, &pcp, &UA_TYPES[UA_TYPES_BYTE]);
+        params[paramsSize+2].key = UA_QUALIFIEDNAME(0, "dei");
+        UA_Variant_setScalar(&params[paramsSize+2].value, &dei, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        paramsSize += 3;
+    }
+
+    /* Callback to the application layer with the Ethernet header hidden */
+    UA_KeyValueMap map = {paramsSize, params};
+    response.data += headerSize;
+    response.length -= headerSize;
+    UA_UNLOCK(&el->elMutex);
+    conn->applicationCB(cm, (uintptr_t)conn->rfd.fd, conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED, &map, response);
+    UA_LOCK(&el->elMutex);
+}
+
+/* Process the frames the kernel has placed in the rx ring. The frames are
+ * handed to the application in-place and then returned to the kernel. */
+static void
+ETH_receiveRing(UA_ConnectionManager *cm, ETH_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    for(unsigned i = 0; i < conn->ringFrames; i++) {
+        struct tpacket2_hdr *hdr = ETH_ringFrame(conn, conn->ringHead);
+        if(!(hdr->tp_status & TP_STATUS_USER))
+            return;
+        __sync_synchronize();
+
+        if(hdr->tp_snaplen < hdr->tp_len) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                           "ETH %u\t| Dropping a frame of size %u that is larger "
+                           "than the packet ring frames",
+                           (unsigned)conn->rfd.fd, (unsigned)hdr->tp_len);
+        } else {
+            UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                         "ETH %u\t| Received message of size %u",
+                         (unsigned)conn->rfd.fd, (unsigned)hdr->tp_snaplen);
+            UA_ByteString response = {hdr->tp_snaplen, (UA_Byte*)hdr + hdr->tp_mac};
+            ETH_deliver(cm, conn, response);
+        }
+
+        /* Return the frame to the kernel */
+        __sync_synchronize();
+        hdr->tp_status = TP_STATUS_KERNEL;
+        conn->ringHead = (conn->ringHead + 1) % conn->ringFrames;
+
+        /* The connection was shut down from within the callback */
+        if(conn->rfd.dc.callback)
+            return;
+    }
+}
+
 /* Gets called when a socket receives data or closes */
 static void
 ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
@@ -337,8 +557,13 @@ ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
         return;
     }
 
+    if(conn->ring) {
+        ETH_receiveRing(cm, conn);
+        return;
+    }
+
     /* Use the already allocated receive-buffer */
-    UA_ByteString response = pcm->rxBuffer;;
+    UA_ByteString response = pcm->rxBuffer;
 
     /* Receive */
 #ifndef _WIN32
@@ -372,59 +597,7 @@ ETH_connectionSocketCallback(UA_ConnectionManager *cm, UA_RegisteredFD *rfd,
 
     response.length = (size_t)ret;
 
-    /* Parse the Ethernet header */
-    unsigned char destAddr[ETHER_ADDR_LEN];
-    unsigned char sourceAddr[ETHER_ADDR_LEN];
-    UA_UInt16 etherType = 0;
-    UA_UInt16 vid = 0;
-    UA_Byte pcp = 0;
-    UA_Boolean dei = 0;
-    size_t headerSize = parseETHHeader(&response, destAddr, sourceAddr,
-                                       &etherType, &vid, &pcp, &dei);
-    if(headerSize == 0)
-        return;
-
-    /* Set up the parameter arguments passed to the application */
-    unsigned char destAddrBytes[18];
-    unsigned char sourceAddrBytes[18];
-    setAddrString(destAddrBytes, destAddr);
-    setAddrString(sourceAddrBytes, sourceAddr);
-    UA_String destAddrStr = {17, destAddrBytes};
-    UA_String sourceAddrStr = {17, sourceAddrBytes};
-
-    size_t paramsSize = 2;
-    UA_KeyValuePair params[6];
-    params[0].key = UA_QUALIFIEDNAME(0, "destination-address");
-    UA_Variant_setScalar(&params[0].value, &destAddrStr, &UA_TYPES[UA_TYPES_STRING]);
-    params[1].key = UA_QUALIFIEDNAME(0, "source-address");
-    UA_Variant_setScalar(&params[1].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
-
-    if(etherType > 0) {
-        params[2].key = UA_QUALIFIEDNAME(0, "ethertype");
-        UA_Variant_setScalar(&params[1].value, &etherType, &UA_TYPES[UA_TYPES_UINT16]);
-        paramsSize++;
-    }
-
-    if(vid > 0) {
-        params[paramsSize].key = UA_QUALIFIEDNAME(0, "vid");
-        UA_Variant_setScalar(&params[paramsSize].value, &vid, &UA_TYPES[UA_TYPES_UINT16]);
-        params[paramsSize+1].key = UA_QUALIFIEDNAME(0, "pcp");
-        UA_Variant_setScalar(&params[paramsSize+1].value, &pcp, &UA_TYPES[UA_TYPES_BYTE]);
-        params[paramsSize+2].key = UA_QUALIFIEDNAME(0, "dei");
-        UA_Variant_setScalar(&params[paramsSize+2].value, &dei, &UA_TYPES[UA_TYPES_BOOLEAN]);
-        paramsSize += 3;
-    }
-
-    /* Callback to the application layer with the Ethernet header hidden */
-    UA_KeyValueMap map = {paramsSize, params};
-    response.data += headerSize;
-    response.length -= headerSize;
-    UA_UNLOCK(&el->elMutex);
-    conn->applicationCB(cm, (uintptr_t)rfd->fd, conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED, &map, response);
-    UA_LOCK(&el->elMutex);
-    response.data -= headerSize;
-    response.length += headerSize;
+    ETH_deliver(cm, conn, response);
 }
 
 static UA_StatusCode
@@ -697,7 +870,6 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
         UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
-    res |= UA_EventLoopPOSIX_setReusable(sockfd);
     res |= UA_EventLoopPOSIX_setNonBlocking(sockfd);
     res |= UA_EventLoopPOSIX_setNoSigPipe(sockfd);
     if(res != UA_STATUSCODE_GOOD)
@@ -743,6 +915,17 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     if(validate || res != UA_STATUSCODE_GOOD)
         goto cleanup;
 
+    /* Set up the packet ring */
+    const UA_UInt32 *ringFrames = (const UA_UInt32*)
+        UA_KeyValueMap_getScalar(params,
+                                 ethConnectionParams[ETH_PARAMINDEX_RING].name,
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(ringFrames && *ringFrames > 0) {
+        res = ETH_setupRing(el, conn, *ringFrames, !listen || !*listen);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
     /* Register in the EventLoop */
     res = UA_EventLoopPOSIX_registerFD(el, &conn->rfd);
     if(res != UA_STATUSCODE_GOOD)
@@ -760,6 +943,8 @@ ETH_openConnection(UA_ConnectionManager *cm, const UA_KeyValueMap *params,
     return UA_STATUSCODE_GOOD;
 
  cleanup:
+    if(conn)
+        ETH_clearRing(conn);
     UA_close(sockfd);
     UA_free(conn);
     UA_UNLOCK(&el->elMutex);
@@ -884,6 +1069,86 @@ send_txtime(UA_EventLoopPOSIX *el, ETH_FD *conn, const UA_KeyValueMap *params,
 }
 #endif
 
+/* Submit a frame to the tx ring. Buffers that were not handed out from the ring
+ * are copied into the next frame. The kernel transmits the frames in the order
+ * of the ring. So a frame that is handed out but not yet sent delays the
+ * transmission of all later frames. */
+static UA_StatusCode
+ETH_sendRing(UA_POSIXConnectionManager *pcm, ETH_FD *conn,
+             const UA_KeyValueMap *params, const UA_DateTime *txtime,
+             UA_ByteString *buf) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    uintptr_t connectionId = (uintptr_t)conn->rfd.fd;
+    size_t frameLength = buf->length + conn->headerSize;
+    struct tpacket2_hdr *hdr;
+    if(ETH_isRingBuffer(conn, buf)) {
+        hdr = ETH_ringFrame(conn, conn->ringClaim);
+        conn->ringClaimed = false;
+    } else {
+        if(frameLength > ETH_RINGFRAMESIZE - ETH_RINGTXOFFSET ||
+           (conn->ringClaimed && conn->ringClaim == conn->ringHead)) {
+            UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                         "ETH %u\t| Cannot place the message in the packet ring",
+                         (unsigned)connectionId);
+            ETH_freeNetworkBuffer(&pcm->cm, connectionId, buf);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        /* Wait until the kernel has released the frame */
+        hdr = ETH_ringFrame(conn, conn->ringHead);
+        struct pollfd tmp_poll_fd;
+        tmp_poll_fd.fd = conn->rfd.fd;
+        tmp_poll_fd.events = UA_POLLOUT;
+        while(hdr->tp_status != TP_STATUS_AVAILABLE) {
+            if(UA_poll(&tmp_poll_fd, 1, 100) < 0 && UA_ERRNO != UA_INTERRUPTED) {
+                ETH_freeNetworkBuffer(&pcm->cm, connectionId, buf);
+                ETH_shutdown(pcm, conn);
+                return UA_STATUSCODE_BADCONNECTIONCLOSED;
+            }
+        }
+        __sync_synchronize();
+
+        memcpy((UA_Byte*)hdr + ETH_RINGTXOFFSET + conn->headerSize,
+               buf->data, buf->length);
+        ETH_freeNetworkBuffer(&pcm->cm, connectionId, buf);
+        conn->ringHead = (conn->ringHead + 1) % conn->ringFrames;
+    }
+    UA_ByteString_init(buf);
+
+    /* Set the Ethernet header and submit the frame */
+    UA_Byte *frame = (UA_Byte*)hdr + ETH_RINGTXOFFSET;
+    memcpy(frame, conn->header, conn->headerSize);
+    if(conn->lengthOffset) {
+        UA_UInt16 *ethLength =  (UA_UInt16*)&frame[conn->lengthOffset];
+        *ethLength = htons((UA_UInt16)(frameLength - conn->headerSize));
+    }
+    hdr->tp_len = (__u32)frameLength;
+    __sync_synchronize();
+    hdr->tp_status = TP_STATUS_SEND_REQUEST;
+
+    /* Notify the kernel. This also transmits earlier frames that are still
+     * pending in the ring. */
+    ssize_t n;
+    do {
+#ifdef SO_TXTIME
+        if(txtime)
+            n = send_txtime(el, conn, params, *txtime, NULL, 0);
+        else
+#endif
+            n = UA_sendto(conn->rfd.fd, NULL, 0, MSG_NOSIGNAL,
+                          (struct sockaddr*)&conn->sll, sizeof(conn->sll));
+    } while(n < 0 && UA_ERRNO == UA_INTERRUPTED);
+    if(n < 0 && UA_ERRNO != UA_WOULDBLOCK && UA_ERRNO != UA_AGAIN) {
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "ETH %u\t| Send failed with error %s",
+                        (unsigned)connectionId, errno_str));
+        ETH_shutdown(pcm, conn);
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params, UA_ByteString *buf) {
@@ -901,15 +1166,6 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADCONNECTIONREJECTED;
     }
 
-    /* Uncover and set the Ethernet header */
-    buf->data -= conn->headerSize;
-    buf->length += conn->headerSize;
-    memcpy(buf->data, conn->header, conn->headerSize);
-    if(conn->lengthOffset) {
-        UA_UInt16 *ethLength =  (UA_UInt16*)&buf->data[conn->lengthOffset];
-        *ethLength = htons((UA_UInt16)(buf->length - conn->headerSize));
-    }
-
     /* Was a txtime configured? */
     const UA_DateTime *txtime = (const UA_DateTime*)
         UA_KeyValueMap_getScalar(params, ethConnectionParams[ETH_PARAMINDEX_TXTIME].name,
@@ -919,10 +1175,26 @@ ETH_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                      "ETH %u\t| txtime was not configured for the connection",
                      (unsigned)connectionId);
         UA_UNLOCK(&el->elMutex);
-        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        ETH_freeNetworkBuffer(cm, connectionId, buf);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Submit to the tx ring */
+    if(conn->ring) {
+        UA_StatusCode res = ETH_sendRing(pcm, conn, params, txtime, buf);
+        UA_UNLOCK(&el->elMutex);
+        return res;
+    }
+
+    /* Uncover and set the Ethernet header */
+    buf->data -= conn->headerSize;
+    buf->length += conn->headerSize;
+    memcpy(buf->data, conn->header, conn->headerSize);
+    if(conn->lengthOffset) {
+        UA_UInt16 *ethLength =  (UA_UInt16*)&buf->data[conn->lengthOffset];
+        *ethLength = htons((UA_UInt16)(buf->length - conn->headerSize));
+    }
+
     /* Prevent OS signals when sending to a closed socket */
     int flags = MSG_NOSIGNAL;
 
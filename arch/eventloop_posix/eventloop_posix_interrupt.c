@@ -399,11 +399,12 @@ startPOSIXInterruptManager(UA_EventSource *es) {
 
 #ifndef UA_HAVE_EPOLL
     //UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX *)es->eventLoop;
-    /* Set the global pointer */
-    if(singletonIM != NULL) {
+    /* The global pointer is set when the InterruptManager is created */
+    if(singletonIM != (UA_POSIXInterruptManager *)es) {
         UA_LOG_ERROR(es->eventLoop->logger, UA_LOGCATEGORY_EVENTLOOP,
                      "Interrupt\t| There can be at most one active "
                      "InterruptManager at a time");
+        UA_UNLOCK(&el->elMutex);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 #endif
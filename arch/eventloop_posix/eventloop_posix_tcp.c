@@ -10,11 +10,12 @@
 #include "eventloop_posix.h"
 
 /* Configuration parameters */
-#define TCP_MANAGERPARAMS 2
+#define TCP_MANAGERPARAMS 3
 
 static UA_KeyValueRestriction tcpManagerParams[TCP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("send-queue-limit")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
 #define TCP_PARAMETERSSIZE 5
@@ -32,17 +33,66 @@ static UA_KeyValueRestriction tcpConnectionParams[TCP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("reuse")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+/* Max number of buffers handed to a single sendmsg call */
+#define TCP_MAXIOV 64
+
+/* Buffer in the send queue. The position marks the bytes already sent. */
+typedef struct TCP_QueuedBuffer {
+    struct TCP_QueuedBuffer *next;
+    UA_ByteString buf;
+    size_t pos;
+} TCP_QueuedBuffer;
+
 typedef struct {
     UA_RegisteredFD rfd;
 
     UA_ConnectionManager_connectionCallback applicationCB;
     void *application;
     void *context;
+
+    /* Buffers that could not be sent without blocking. They are sent when the
+     * socket becomes writable. */
+    TCP_QueuedBuffer *sendQueue;
+    TCP_QueuedBuffer *sendQueueLast;
+    size_t sendQueueBytes;
+
+#ifdef UA_HAVE_IOURING
+    /* Within an iteration of the EventLoop, the buffers are batched in the
+     * send queue. The kernel uses the message and the queued buffers until the
+     * send completes. */
+    struct msghdr ringMsg;
+    struct iovec ringIov[TCP_MAXIOV];
+    UA_Boolean ringSending;
+    UA_Boolean ringBacklog; /* The socket did not take all data */
+#endif
 } TCP_FD;
 
 static void
 TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn);
 
+static void
+TCP_flushSendQueue(UA_ConnectionManager *cm, TCP_FD *conn);
+
+#ifdef UA_HAVE_IOURING
+static void
+TCP_ringCallback(UA_ConnectionManager *cm, TCP_FD *conn, UA_Byte op,
+                 int result, UA_ByteString data);
+#endif
+
+static void
+TCP_clearSendQueue(UA_ConnectionManager *cm, TCP_FD *conn) {
+    TCP_QueuedBuffer *qb = conn->sendQueue;
+    while(qb) {
+        TCP_QueuedBuffer *next = qb->next;
+        UA_ByteString_clear(&qb->buf);
+        UA_free(qb);
+        qb = next;
+    }
+    conn->sendQueue = NULL;
+    conn->sendQueueLast = NULL;
+    conn->sendQueueBytes = 0;
+}
+
 /* Do not merge packets on the socket (disable Nagle's algorithm) */
 static UA_StatusCode
 TCP_setNoNagle(UA_FD sockfd) {
@@ -75,6 +125,20 @@ TCP_delayedClose(void *application, void *context) {
 
     UA_LOCK(&el->elMutex); //UA_LOG_DEBUG( el->eventLoop.logger, UA_LOGCATEGORY_NETWORK, "(%zx)lock", (size_t)&el->elMutex );
 
+#ifdef UA_HAVE_IOURING
+    /* The kernel still uses the buffers of the send in flight. The socket is
+     * shut down, so the send completes right away. Take the completion if it
+     * is available. Otherwise retry in the next iteration. */
+    if(conn->ringSending)
+        UA_EventLoopPOSIX_ringReap(el);
+    if(conn->ringSending) {
+        conn->rfd.dc.next = el->delayedCallbacks;
+        el->delayedCallbacks = &conn->rfd.dc;
+        UA_UNLOCK(&el->elMutex);
+        return;
+    }
+#endif
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_EVENTLOOP,
                  "TCP %u\t| Delayed closing of the connection",
                  (unsigned)conn->rfd.fd);
@@ -95,6 +159,9 @@ TCP_delayedClose(void *application, void *context) {
                         &UA_KEYVALUEMAP_NULL, UA_BYTESTRING_NULL);
     UA_LOCK(&el->elMutex); //UA_LOG_DEBUG( el->eventLoop.logger, UA_LOGCATEGORY_NETWORK, "(%zx)lock", (size_t)&el->elMutex );
 
+    /* Drop the unsent buffers */
+    TCP_clearSendQueue(cm, conn);
+
     /* Close the socket */
     int ret = UA_close(conn->rfd.fd);
     if(ret == 0) {
@@ -149,6 +216,14 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
         return;
     }
 
+    /* Continue sending the queued buffers. Receive events take precedence over
+     * write events. So also try to send before receiving. */
+    if(conn->sendQueue) {
+        TCP_flushSendQueue(cm, conn);
+        if(event == UA_FDEVENT_OUT)
+            return;
+    }
+
     /* Write-Event, a new connection has opened. But some errors come as an
      * out-event. For example if the remote side could not be reached to
      * initiate the connection. So we check manually for error conditions on
@@ -229,10 +304,13 @@ TCP_connectionSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn,
 		UA_LOCK(&el->elMutex); //UA_LOG_DEBUG( el->eventLoop.logger, UA_LOGCATEGORY_NETWORK, "(%zx)lock", (size_t)&el->elMutex );
 }
 
+static void
+TCP_openAcceptedConnection(UA_ConnectionManager *cm, TCP_FD *conn,
+                           UA_FD newsockfd, struct sockaddr_storage *remote);
+
 /* Gets called when a new connection opens or if the listenSocket is closed */
 static void
 TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
-    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
     UA_LOCK_ASSERT(&el->elMutex, 1);
 
@@ -261,9 +339,20 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
         return;
     }
 
+    TCP_openAcceptedConnection(cm, conn, newsockfd, &remote);
+}
+
+/* Set up a connection accepted from the listen socket */
+static void
+TCP_openAcceptedConnection(UA_ConnectionManager *cm, TCP_FD *conn,
+                           UA_FD newsockfd, struct sockaddr_storage *remote) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
     /* Log the name of the remote host */
     char hoststr[UA_MAXHOSTNAME_LENGTH];
-    int get_res = UA_getnameinfo((struct sockaddr *)&remote, sizeof(remote),
+    int get_res = UA_getnameinfo((struct sockaddr *)remote, sizeof(*remote),
                                  hoststr, sizeof(hoststr),
                                  NULL, 0, NI_NUMERICHOST);
     if(get_res != 0) {
@@ -305,6 +394,10 @@ TCP_listenSocketCallback(UA_ConnectionManager *cm, TCP_FD *conn, short event) {
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &cm->eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
+#ifdef UA_HAVE_IOURING
+    newConn->rfd.ringCB = (UA_RingCallback)TCP_ringCallback;
+    newConn->rfd.ringReadOp = UA_RINGOP_RECV;
+#endif
     newConn->applicationCB = conn->applicationCB;
     newConn->application = conn->application;
     newConn->context = conn->context;
@@ -464,6 +557,10 @@ TCP_registerListenSocket(UA_POSIXConnectionManager *pcm, struct addrinfo *ai,
     newConn->rfd.listenEvents = UA_FDEVENT_IN;
     newConn->rfd.es = &pcm->cm.eventSource;
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_listenSocketCallback;
+#ifdef UA_HAVE_IOURING
+    newConn->rfd.ringCB = (UA_RingCallback)TCP_ringCallback;
+    newConn->rfd.ringReadOp = UA_RINGOP_ACCEPT;
+#endif
     newConn->applicationCB = connectionCallback;
     newConn->application = application;
     newConn->context = context;
@@ -575,6 +672,12 @@ TCP_shutdown(UA_ConnectionManager *cm, TCP_FD *conn) {
         return;
     }
 
+#ifdef UA_HAVE_IOURING
+    /* Hand the queued send to the kernel before the socket is shut down */
+    if(conn->ringSending)
+        UA_EventLoopPOSIX_ringSubmit(el);
+#endif
+
     /* Shutdown the socket to cancel the current select/epoll */
     shutdown(conn->rfd.fd, UA_SHUT_RDWR);
 
@@ -616,63 +719,464 @@ TCP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Send as much as possible without blocking. Returns the number of bytes
+ * written. Only fatal socket errors return an error code. */
 static UA_StatusCode
-TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
-                       const UA_KeyValueMap *params, UA_ByteString *buf) {
-    /* Don't have a lock and don't take a lock. As the connectionId is the fd,
-     * no need to to a lookup and access internal data strucures. */
-    UA_LOCK_ASSERT(&((UA_EventLoopPOSIX*)cm->eventSource.eventLoop)->elMutex, 0);
-
-    /* Prevent OS signals when sending to a closed socket */
-    int flags = MSG_NOSIGNAL;
-
-    struct pollfd tmp_poll_fd;
-    tmp_poll_fd.fd = (UA_FD)connectionId;
-    tmp_poll_fd.events = UA_POLLOUT;
-
-    /* Send the full buffer. This may require several calls to send */
-    size_t nWritten = 0;
-    do {
-        ssize_t n = 0;
-        do {
-            UA_LOG_DEBUG(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
-                         "TCP %u\t| Attempting to send", (unsigned)connectionId);
-            size_t bytes_to_send = buf->length - nWritten;
-            n = UA_send((UA_FD)connectionId,
-                        (const char*)buf->data + nWritten,
-                        bytes_to_send, flags);
-            if(n < 0) {
-                /* An error we cannot recover from? */
-                if(UA_ERRNO != UA_INTERRUPTED && UA_ERRNO != UA_WOULDBLOCK &&
-                   UA_ERRNO != UA_AGAIN)
-                    goto shutdown;
-
-                /* Poll for the socket resources to become available and retry
-                 * (blocking) */
-                int poll_ret;
-                do {
-                    poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
-                    if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
-                        goto shutdown;
-                } while(poll_ret <= 0);
+TCP_sendNonBlocking(UA_FD fd, const UA_ByteString *bufs, size_t bufsSize,
+                    size_t *written) {
+    size_t total = 0;
+    size_t idx = 0; /* Current buffer */
+    size_t pos = 0; /* Position in the current buffer */
+    while(idx < bufsSize) {
+        if(pos >= bufs[idx].length) {
+            idx++;
+            pos = 0;
+            continue;
+        }
+
+#ifndef _WIN32
+        struct iovec iov[TCP_MAXIOV];
+        size_t iovcnt = 0;
+        for(size_t i = idx; i < bufsSize && iovcnt < TCP_MAXIOV; i++) {
+            size_t offset = (i == idx) ? pos : 0;
+            iov[iovcnt].iov_base = bufs[i].data + offset;
+            iov[iovcnt].iov_len = bufs[i].length - offset;
+            iovcnt++;
+        }
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(struct msghdr));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+#else
+        int n = UA_send(fd, (const char*)bufs[idx].data + pos,
+                        bufs[idx].length - pos, MSG_NOSIGNAL);
+#endif
+        if(n < 0) {
+            if(UA_ERRNO == UA_INTERRUPTED)
+                continue;
+            if(UA_ERRNO == UA_WOULDBLOCK || UA_ERRNO == UA_AGAIN)
+                break; /* The socket cannot take more data right now */
+            *written = total;
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+
+        /* Advance over the buffers that were sent completely */
+        size_t w = (size_t)n;
+        total += w;
+        while(w > 0) {
+            size_t rest = bufs[idx].length - pos;
+            if(w < rest) {
+                pos += w;
+                break;
             }
-        } while(n < 0);
-        nWritten += (size_t)n;
-    } while(nWritten < buf->length);
+            w -= rest;
+            idx++;
+            pos = 0;
+        }
+    }
 
-    /* Clean up and return */
-    UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+    *written = total;
     return UA_STATUSCODE_GOOD;
+}
+
+/* Move the unsent part of the buffer to the end of the send queue. The static
+ * send buffer of the ConnectionManager is reused and has to be copied. */
+static UA_StatusCode
+TCP_enqueue(UA_POSIXConnectionManager *pcm, TCP_FD *conn,
+            UA_ByteString *buf, size_t pos) {
+    TCP_QueuedBuffer *qb = (TCP_QueuedBuffer*)UA_calloc(1, sizeof(TCP_QueuedBuffer));
+    if(!qb)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    if(buf->data == pcm->txBuffer.data) {
+        UA_StatusCode res = UA_ByteString_allocBuffer(&qb->buf, buf->length - pos);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(qb);
+            return res;
+        }
+        memcpy(qb->buf.data, buf->data + pos, buf->length - pos);
+    } else {
+        qb->buf = *buf;
+        qb->pos = pos;
+        UA_ByteString_init(buf);
+    }
+
+    if(conn->sendQueueLast)
+        conn->sendQueueLast->next = qb;
+    else
+        conn->sendQueue = qb;
+    conn->sendQueueLast = qb;
+    conn->sendQueueBytes += qb->buf.length - qb->pos;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Remove the sent bytes from the front of the send queue */
+static void
+TCP_dequeue(TCP_FD *conn, size_t written) {
+    conn->sendQueueBytes -= written;
+    while(written > 0) {
+        TCP_QueuedBuffer *qb = conn->sendQueue;
+        size_t rest = qb->buf.length - qb->pos;
+        if(written < rest) {
+            qb->pos += written;
+            break;
+        }
+        written -= rest;
+        conn->sendQueue = qb->next;
+        UA_ByteString_clear(&qb->buf);
+        UA_free(qb);
+    }
+    if(!conn->sendQueue)
+        conn->sendQueueLast = NULL;
+}
+
+#ifdef UA_HAVE_IOURING
+
+/* Within an iteration of the EventLoop, the sends are batched in the io_uring.
+ * Sends from outside of the EventLoop and while it is waiting go out right
+ * away. */
+static UA_Boolean
+TCP_ringBatching(UA_EventLoopPOSIX *el, TCP_FD *conn) {
+    if(!conn->rfd.ringCB || !el->executing)
+        return false;
+#ifdef UA_HAVE_WAKEUPFD
+    if(el->polling)
+        return false;
+#endif
+    return true;
+}
+
+/* Submit a send of the queued buffers to the io_uring. The batched sends of
+ * all connections are submitted together at the end of the iteration. */
+static void
+TCP_ringSend(UA_ConnectionManager *cm, TCP_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+    size_t iovcnt = 0;
+    for(TCP_QueuedBuffer *qb = conn->sendQueue;
+        qb && iovcnt < TCP_MAXIOV; qb = qb->next) {
+        conn->ringIov[iovcnt].iov_base = qb->buf.data + qb->pos;
+        conn->ringIov[iovcnt].iov_len = qb->buf.length - qb->pos;
+        iovcnt++;
+    }
+    memset(&conn->ringMsg, 0, sizeof(struct msghdr));
+    conn->ringMsg.msg_iov = conn->ringIov;
+    conn->ringMsg.msg_iovlen = iovcnt;
+
+    UA_StatusCode res =
+        UA_EventLoopPOSIX_ringSendMsg(el, &conn->rfd, &conn->ringMsg);
+    if(res != UA_STATUSCODE_GOOD) {
+        TCP_shutdown(cm, conn);
+        return;
+    }
+    conn->ringSending = true;
+    if(!TCP_ringBatching(el, conn))
+        UA_EventLoopPOSIX_ringSubmit(el);
+
+    /* No longer wait for the socket to become writable */
+    if(conn->rfd.listenEvents == (UA_FDEVENT_IN | UA_FDEVENT_OUT)) {
+        conn->rfd.listenEvents = UA_FDEVENT_IN;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+    }
+}
+
+static void
+TCP_ringSendCompleted(UA_ConnectionManager *cm, TCP_FD *conn, int result) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    conn->ringSending = false;
+
+    /* Closing. The queue is dropped with the connection. */
+    if(conn->rfd.dc.callback)
+        return;
+
+    /* The socket cannot take more data. Send again once it is writable. */
+    if(result == -EAGAIN || result == -EINTR) {
+        conn->ringBacklog = true;
+        if(!(conn->rfd.listenEvents & UA_FDEVENT_OUT)) {
+            conn->rfd.listenEvents |= UA_FDEVENT_OUT;
+            UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+        }
+        return;
+    }
+
+    if(result < 0) {
+        errno = -result;
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP %u\t| Send failed with error %s",
+                        (unsigned)conn->rfd.fd, errno_str));
+        TCP_shutdown(cm, conn);
+        return;
+    }
+
+    /* Continue with the remainder. Also with the buffers queued while the
+     * send was in flight. */
+    size_t submitted = 0;
+    for(size_t i = 0; i < conn->ringMsg.msg_iovlen; i++)
+        submitted += conn->ringIov[i].iov_len;
+    if((size_t)result < submitted)
+        conn->ringBacklog = true;
+    TCP_dequeue(conn, (size_t)result);
+    if(!conn->sendQueue) {
+        conn->ringBacklog = false;
+        return;
+    }
+    TCP_ringSend(cm, conn);
+}
+
+/* Completions of the receive, accept and send requests in the io_uring */
+static void
+TCP_ringCallback(UA_ConnectionManager *cm, TCP_FD *conn, UA_Byte op,
+                 int result, UA_ByteString data) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+    if(op == UA_RINGOP_SEND) {
+        TCP_ringSendCompleted(cm, conn, result);
+        return;
+    }
 
- shutdown:
-    /* Error -> shutdown the connection  */
-    UA_LOG_SOCKET_ERRNO_WRAP(
-       UA_LOG_ERROR(cm->eventSource.eventLoop->logger, UA_LOGCATEGORY_NETWORK,
-                    "TCP %u\t| Send failed with error %s",
-                    (unsigned)connectionId, errno_str));
-    TCP_shutdownConnection(cm, connectionId);
-    UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
-    return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    /* A new connection on the listen socket */
+    if(op == UA_RINGOP_ACCEPT) {
+        if(result < 0) {
+            /* Temporary error -- the accept stays armed */
+            if(result == -EINTR || result == -EAGAIN || result == -ECONNABORTED)
+                return;
+            errno = -result;
+            if(cm->eventSource.state != UA_EVENTSOURCESTATE_STOPPING) {
+                UA_LOG_SOCKET_ERRNO_WRAP(
+                    UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                                   "TCP %u\t| Error %s, closing the server socket",
+                                   (unsigned)conn->rfd.fd, errno_str));
+            }
+            TCP_shutdown(cm, conn);
+            return;
+        }
+        struct sockaddr_storage remote;
+        socklen_t remote_size = sizeof(remote);
+        memset(&remote, 0, sizeof(remote));
+        getpeername((UA_FD)result, (struct sockaddr*)&remote, &remote_size);
+        TCP_openAcceptedConnection(cm, conn, (UA_FD)result, &remote);
+        return;
+    }
+
+    /* Receive has failed or the remote side has shut down the connection */
+    if(result <= 0) {
+        if(result == -EINTR || result == -EAGAIN)
+            return;
+        errno = -result;
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "TCP %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        TCP_shutdown(cm, conn);
+        return;
+    }
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "TCP %u\t| Received message of size %u",
+                 (unsigned)conn->rfd.fd, (unsigned)data.length);
+
+    /* Callback to the application layer. The buffer of the EventLoop is only
+     * valid during the callback (like the rxBuffer). */
+    UA_UNLOCK(&el->elMutex);
+    conn->applicationCB(cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED,
+                        &UA_KEYVALUEMAP_NULL, data);
+    UA_LOCK(&el->elMutex);
+}
+
+#endif /* UA_HAVE_IOURING */
+
+/* Send from the queue when the socket has become writable */
+static void
+TCP_flushSendQueue(UA_ConnectionManager *cm, TCP_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK_ASSERT(&el->elMutex, 1);
+
+#ifdef UA_HAVE_IOURING
+    if(conn->rfd.ringCB) {
+        if(!conn->ringSending)
+            TCP_ringSend(cm, conn);
+        return;
+    }
+#endif
+
+    UA_ByteString bufs[TCP_MAXIOV];
+    while(conn->sendQueue) {
+        /* Collect the unsent parts of the queued buffers */
+        size_t bufsSize = 0;
+        size_t total = 0;
+        for(TCP_QueuedBuffer *qb = conn->sendQueue;
+            qb && bufsSize < TCP_MAXIOV; qb = qb->next) {
+            bufs[bufsSize].data = qb->buf.data + qb->pos;
+            bufs[bufsSize].length = qb->buf.length - qb->pos;
+            total += bufs[bufsSize].length;
+            bufsSize++;
+        }
+
+        size_t written = 0;
+        UA_StatusCode res =
+            TCP_sendNonBlocking(conn->rfd.fd, bufs, bufsSize, &written);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)conn->rfd.fd, errno_str));
+            TCP_shutdown(cm, conn);
+            return;
+        }
+
+        /* Remove the buffers that were sent completely */
+        UA_Boolean blocked = (written < total);
+        TCP_dequeue(conn, written);
+
+        /* The socket cannot take more data */
+        if(blocked)
+            break;
+    }
+
+    /* Everything sent. Only listen for read-events again. */
+    if(!conn->sendQueue && (conn->rfd.listenEvents & UA_FDEVENT_OUT)) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| The send queue has drained",
+                     (unsigned)conn->rfd.fd);
+        conn->rfd.listenEvents = UA_FDEVENT_IN;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+    }
+}
+
+/* Send the buffers without blocking. What cannot be sent right away is queued
+ * and sent when the socket becomes writable. If the queue grows beyond the
+ * configured limit, the receiver is too slow and the connection is closed. */
+static UA_StatusCode
+TCP_sendBuffers(UA_ConnectionManager *cm, uintptr_t connectionId,
+                UA_ByteString *bufs, size_t bufsSize) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_FD fd = (UA_FD)connectionId;
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    if(!conn || conn->rfd.dc.callback) {
+        res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+        goto cleanup;
+    }
+
+    /* Send directly if nothing is queued. Otherwise the order of the messages
+     * would change. Within an iteration of the EventLoop, the sends with the
+     * io_uring are batched in the queue. */
+    size_t written = 0;
+#ifdef UA_HAVE_IOURING
+    if(!conn->sendQueue && !TCP_ringBatching(el, conn)) {
+#else
+    if(!conn->sendQueue) {
+#endif
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Attempting to send %u buffers",
+                     (unsigned)connectionId, (unsigned)bufsSize);
+        res = TCP_sendNonBlocking(fd, bufs, bufsSize, &written);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "TCP %u\t| Send failed with error %s",
+                            (unsigned)connectionId, errno_str));
+            TCP_shutdown(cm, conn);
+            goto cleanup;
+        }
+    }
+
+    /* Queue the remainder */
+    for(size_t i = 0; i < bufsSize; i++) {
+        if(written >= bufs[i].length) {
+            written -= bufs[i].length;
+            continue;
+        }
+        res = TCP_enqueue(pcm, conn, &bufs[i], written);
+        written = 0;
+        if(res != UA_STATUSCODE_GOOD) {
+            TCP_shutdown(cm, conn);
+            res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+            goto cleanup;
+        }
+    }
+
+    if(!conn->sendQueue)
+        goto cleanup;
+
+    if(pcm->txQueueLimit > 0 && conn->sendQueueBytes > pcm->txQueueLimit) {
+        UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                       "TCP %u\t| The send queue exceeds the limit of %u bytes. "
+                       "Closing the connection.", (unsigned)connectionId,
+                       (unsigned)pcm->txQueueLimit);
+        TCP_shutdown(cm, conn);
+        res = UA_STATUSCODE_BADCONNECTIONCLOSED;
+        goto cleanup;
+    }
+
+#ifdef UA_HAVE_IOURING
+    if(conn->rfd.ringCB) {
+        if(!TCP_ringBatching(el, conn))
+            conn->ringBacklog = true; /* Not everything was sent right away */
+        if(!conn->ringSending)
+            TCP_ringSend(cm, conn);
+        goto cleanup;
+    }
+#endif
+
+    /* Wait for the socket to become writable */
+    if(!(conn->rfd.listenEvents & UA_FDEVENT_OUT)) {
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "TCP %u\t| Queued %u bytes for sending",
+                     (unsigned)connectionId, (unsigned)conn->sendQueueBytes);
+        conn->rfd.listenEvents |= UA_FDEVENT_OUT;
+        UA_EventLoopPOSIX_modifyFD(el, &conn->rfd);
+    }
+
+ cleanup:
+    UA_UNLOCK(&el->elMutex);
+    /* The queued buffers were moved out */
+    for(size_t i = 0; i < bufsSize; i++)
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, &bufs[i]);
+    return res;
+}
+
+static UA_StatusCode
+TCP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
+                       const UA_KeyValueMap *params, UA_ByteString *buf) {
+    return TCP_sendBuffers(cm, connectionId, buf, 1);
+}
+
+#ifndef _WIN32
+
+static UA_StatusCode
+TCP_sendWithConnectionVector(UA_ConnectionManager *cm, uintptr_t connectionId,
+                             const UA_KeyValueMap *params,
+                             UA_ByteString *bufs, size_t bufsSize) {
+    return TCP_sendBuffers(cm, connectionId, bufs, bufsSize);
+}
+
+#endif /* !_WIN32 */
+
+static size_t
+TCP_getSendQueueSize(UA_ConnectionManager *cm, uintptr_t connectionId) {
+    UA_POSIXConnectionManager *pcm = (UA_POSIXConnectionManager*)cm;
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)cm->eventSource.eventLoop;
+    UA_LOCK(&el->elMutex);
+    UA_FD fd = (UA_FD)connectionId;
+    TCP_FD *conn = (TCP_FD*)ZIP_FIND(UA_FDTree, &pcm->fds, &fd);
+    size_t size = (conn) ? conn->sendQueueBytes : 0;
+#ifdef UA_HAVE_IOURING
+    /* With the io_uring, the queue also holds the batched sends. Only report
+     * the backlog once the socket did not take all data. */
+    if(conn && conn->rfd.ringCB && !conn->ringBacklog)
+        size = 0;
+#endif
+    UA_UNLOCK(&el->elMutex);
+    return size;
 }
 
 /* Create a listen-socket that waits for incoming connections */
@@ -856,6 +1360,10 @@ TCP_openActiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *p
     newConn->rfd.eventSourceCB = (UA_FDCallback)TCP_connectionSocketCallback;
     newConn->rfd.listenEvents = UA_FDEVENT_OUT; /* Switched to _IN once the
                                                  * connection is open */
+#ifdef UA_HAVE_IOURING
+    newConn->rfd.ringCB = (UA_RingCallback)TCP_ringCallback;
+    newConn->rfd.ringReadOp = UA_RINGOP_RECV;
+#endif
     newConn->applicationCB = connectionCallback;
     newConn->application = application;
     newConn->context = context;
@@ -976,6 +1484,19 @@ TCP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+    /* Limit for the bytes queued per connection (0 means no limit) */
+    const UA_UInt32 *txQueueLimit = (const UA_UInt32 *)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 UA_QUALIFIEDNAME(0, "send-queue-limit"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    pcm->txQueueLimit = (txQueueLimit) ? *txQueueLimit : 0;
+
+#ifndef _WIN32
+    /* Vectored sending needs a distinct buffer for every chunk */
+    cm->sendWithConnectionVector =
+        (pcm->txBuffer.length == 0) ? TCP_sendWithConnectionVector : NULL;
+#endif
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -1051,6 +1572,7 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName) {
     cm->cm.allocNetworkBuffer = UA_EventLoopPOSIX_allocNetworkBuffer;
     cm->cm.freeNetworkBuffer = UA_EventLoopPOSIX_freeNetworkBuffer;
     cm->cm.sendWithConnection = TCP_sendWithConnection;
+    cm->cm.getSendQueueSize = TCP_getSendQueueSize;
     cm->cm.closeConnection = TCP_shutdownConnection;
     return &cm->cm;
 }
@@ -18,13 +18,26 @@
 
 /* Configuration parameters */
 
-#define UDP_MANAGERPARAMS 2
+#define UDP_MANAGERPARAMS 3
 
 static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
     {{0, UA_STRING_STATIC("recv-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
-    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
+    {{0, UA_STRING_STATIC("send-bufsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
+    {{0, UA_STRING_STATIC("recv-batchsize")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false}
 };
 
+/* Receive several datagrams with one syscall */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+# define UDP_HAVE_RECVMMSG 1
+#endif
+#define UDP_MAXRECVBATCH 64
+
+/* Send one datagram to several destinations with one syscall */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+# define UDP_HAVE_SENDMMSG 1
+#endif
+#define UDP_MAXSENDBATCH 64
+
 #define UDP_PARAMETERSSIZE 9
 #define UDP_PARAMINDEX_LISTEN 0
 #define UDP_PARAMINDEX_ADDR 1
@@ -39,7 +52,7 @@ static UA_KeyValueRestriction udpManagerParams[UDP_MANAGERPARAMS] = {
 static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("listen")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
     {{0, UA_STRING_STATIC("address")}, &UA_TYPES[UA_TYPES_STRING], false, true, true},
-    {{0, UA_STRING_STATIC("port")}, &UA_TYPES[UA_TYPES_UINT16], true, true, false},
+    {{0, UA_STRING_STATIC("port")}, &UA_TYPES[UA_TYPES_UINT16], true, true, true},
     {{0, UA_STRING_STATIC("interface")}, &UA_TYPES[UA_TYPES_STRING], false, true, false},
     {{0, UA_STRING_STATIC("ttl")}, &UA_TYPES[UA_TYPES_UINT32], false, true, false},
     {{0, UA_STRING_STATIC("loopback")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false},
@@ -48,6 +61,15 @@ static UA_KeyValueRestriction udpConnectionParams[UDP_PARAMETERSSIZE] = {
     {{0, UA_STRING_STATIC("validate")}, &UA_TYPES[UA_TYPES_BOOLEAN], false, true, false}
 };
 
+typedef struct {
+    struct sockaddr_storage addr;
+#ifdef _WIN32
+    size_t addrLength;
+#else
+    socklen_t addrLength;
+#endif
+} UDP_Destination;
+
 /* A registered file descriptor with an additional method pointer */
 typedef struct {
     UA_RegisteredFD rfd;
@@ -62,6 +84,12 @@ typedef struct {
 #else
     socklen_t sendAddrLength;
 #endif
+
+    /* Fan-out send connections are opened with an array of addresses. Every
+     * buffer is sent to all destinations. The first destination is also the
+     * sendAddr. */
+    UDP_Destination *fanout;
+    size_t fanoutSize;
 } UDP_FD;
 
 typedef enum {
@@ -150,28 +178,59 @@ setupMulticastRequest(UA_FD socket, IpMulticastRequest *req, const UA_KeyValueMa
     return UA_STATUSCODE_BADINTERNALERROR;
 }
 
+/* Number of entries of a scalar or array parameter */
+static size_t
+getParamSize(const UA_KeyValueMap *params, size_t paramIndex) {
+    const UA_Variant *v =
+        UA_KeyValueMap_get(params, udpConnectionParams[paramIndex].name);
+    if(!v || !v->data)
+        return 0;
+    if(UA_Variant_isScalar(v))
+        return 1;
+    return v->arrayLength;
+}
+
+/* Returns the entry at the index of a scalar or array parameter. A scalar
+ * applies to all indices. */
+static const void *
+getParamEntry(const UA_KeyValueMap *params, size_t paramIndex, size_t index) {
+    const UA_Variant *v =
+        UA_KeyValueMap_get(params, udpConnectionParams[paramIndex].name);
+    if(!v || !v->data)
+        return NULL;
+    if(UA_Variant_isScalar(v))
+        return v->data;
+    if(index >= v->arrayLength)
+        return NULL;
+    return (const UA_Byte*)v->data + (index * v->type->memSize);
+}
+
 /* Retrieves hostname and port from given key value parameters.
  *
  * @param[in] params the parameter map to retrieve from
+ * @param[in] index the index for fan-out connections with an array of addresses
  * @param[out] hostname the retrieved hostname when present, NULL otherwise
  * @param[out] portStr the retrieved port when present, NULL otherwise
  * @param[in] logger the logger to log information
  * @return -1 upon error, 0 if there was no host or port parameter, 1 if
  *         host and port are present */
 static int
-getHostAndPortFromParams(const UA_KeyValueMap *params,
+getHostAndPortFromParams(const UA_KeyValueMap *params, size_t index,
                          char *hostname, char *portStr, const UA_Logger *logger) {
     /* Prepare the port parameter as a string */
     const UA_UInt16 *port = (const UA_UInt16*)
-        UA_KeyValueMap_getScalar(params, udpConnectionParams[UDP_PARAMINDEX_PORT].name,
-                                 &UA_TYPES[UA_TYPES_UINT16]);
-    UA_assert(port); /* checked before */
+        getParamEntry(params, UDP_PARAMINDEX_PORT, index);
+    if(!port) {
+        UA_LOG_ERROR(logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP\t| No port configured for the address %u",
+                     (unsigned)index);
+        return -1;
+    }
     mp_snprintf(portStr, UA_MAXPORTSTR_LENGTH, "%d", *port);
 
     /* Prepare the hostname string */
     const UA_String *host = (const UA_String*)
-        UA_KeyValueMap_getScalar(params, udpConnectionParams[UDP_PARAMINDEX_ADDR].name,
-                                 &UA_TYPES[UA_TYPES_STRING]);
+        getParamEntry(params, UDP_PARAMINDEX_ADDR, index);
     if(!host) {
         UA_LOG_DEBUG(logger, UA_LOGCATEGORY_NETWORK,
                      "UDP\t| No address configured");
@@ -188,10 +247,10 @@ getHostAndPortFromParams(const UA_KeyValueMap *params,
 }
 
 static int
-getConnectionInfoFromParams(const UA_KeyValueMap *params,
+getConnectionInfoFromParams(const UA_KeyValueMap *params, size_t index,
                             char *hostname, char *portStr,
                             struct addrinfo **info, const UA_Logger *logger) {
-    int foundParams = getHostAndPortFromParams(params, hostname, portStr, logger);
+    int foundParams = getHostAndPortFromParams(params, index, hostname, portStr, logger);
     if(foundParams < 0)
         return -1;
 
@@ -484,6 +543,7 @@ UDP_close(UA_POSIXConnectionManager *pcm, UDP_FD *conn) {
                           (unsigned)conn->rfd.fd, errno_str));
     }
 
+    UA_free(conn->fanout);
     UA_free(conn);
 
     /* Stop if the ucm is stopping and this was the last open socket */
@@ -503,6 +563,117 @@ UDP_delayedClose(void *application, void *context) {
     UA_UNLOCK(&el->elMutex);
 }
 
+/* Forward a received datagram to the application */
+static void
+UDP_deliver(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
+            const struct sockaddr_storage *source, UA_ByteString response) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+
+    /* Extract message source and port */
+    char sourceAddr[64];
+    UA_UInt16 sourcePort;
+    switch(source->ss_family) {
+        case AF_INET:
+            inet_ntop(AF_INET, &((const struct sockaddr_in *)source)->sin_addr,
+                    sourceAddr, 64);
+            sourcePort = htons(((const struct sockaddr_in *)source)->sin_port);
+            break;
+        case AF_INET6:
+            inet_ntop(AF_INET6, &(((const struct sockaddr_in6 *)source)->sin6_addr),
+                    sourceAddr, 64);
+            sourcePort = htons(((const struct sockaddr_in6 *)source)->sin6_port);
+            break;
+        default:
+            sourceAddr[0] = 0;
+            sourcePort = 0;
+    }
+
+    UA_String sourceAddrStr = UA_STRING(sourceAddr);
+    UA_KeyValuePair kvp[2];
+    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
+    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
+    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
+    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap kvm = {2, kvp};
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "UDP %u\t| Received message of size %u from %s on port %u",
+                 (unsigned)conn->rfd.fd, (unsigned)response.length,
+                 sourceAddr, sourcePort);
+
+    /* Callback to the application layer */
+    UA_UNLOCK(&el->elMutex);
+    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
+                        conn->application, &conn->context,
+                        UA_CONNECTIONSTATE_ESTABLISHED,
+                        &kvm, response);
+    UA_LOCK(&el->elMutex);
+}
+
+#ifdef UDP_HAVE_RECVMMSG
+/* Receive up to rxBatchSize datagrams with a single recvmmsg call. The receive
+ * buffer is split evenly between the datagrams. Each datagram is delivered
+ * individually, so the callback contract for the application is unchanged. */
+static void
+UDP_receiveBatch(UA_POSIXConnectionManager *pcm, UDP_FD *conn) {
+    UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
+    size_t batch = pcm->rxBatchSize;
+    size_t slice = pcm->rxBuffer.length / batch;
+
+    struct mmsghdr msgs[UDP_MAXRECVBATCH];
+    struct iovec iovs[UDP_MAXRECVBATCH];
+    struct sockaddr_storage sources[UDP_MAXRECVBATCH];
+    memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+    for(size_t i = 0; i < batch; i++) {
+        iovs[i].iov_base = pcm->rxBuffer.data + (i * slice);
+        iovs[i].iov_len = slice;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &sources[i];
+        msgs[i].msg_hdr.msg_namelen = (socklen_t)sizeof(struct sockaddr_storage);
+    }
+
+    int ret = recvmmsg(conn->rfd.fd, msgs, (unsigned int)batch,
+                       MSG_DONTWAIT, NULL);
+
+    /* Receive has failed */
+    if(ret <= 0) {
+        if(UA_ERRNO == UA_INTERRUPTED || UA_ERRNO == UA_AGAIN)
+            return;
+        UA_LOG_SOCKET_ERRNO_WRAP(
+           UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                        "UDP %u\t| recv signaled the socket was shutdown (%s)",
+                        (unsigned)conn->rfd.fd, errno_str));
+        UDP_close(pcm, conn);
+        return;
+    }
+
+    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                 "UDP %u\t| Received a batch of %u messages",
+                 (unsigned)conn->rfd.fd, (unsigned)ret);
+
+    for(int i = 0; i < ret; i++) {
+        /* The connection was shut down from within the callback */
+        if(conn->rfd.dc.callback)
+            return;
+
+        /* The datagram did not fit into the slice of the buffer */
+        if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                           "UDP %u\t| Dropping a message that is larger than "
+                           "the batch receive buffer of %u bytes",
+                           (unsigned)conn->rfd.fd, (unsigned)slice);
+            continue;
+        }
+        if(msgs[i].msg_len == 0)
+            continue;
+
+        UA_ByteString response = {msgs[i].msg_len, (UA_Byte*)iovs[i].iov_base};
+        UDP_deliver(pcm, conn, &sources[i], response);
+    }
+}
+#endif
+
 /* Gets called when a socket receives data or closes */
 static void
 UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
@@ -523,6 +694,13 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
         return;
     }
 
+#ifdef UDP_HAVE_RECVMMSG
+    if(pcm->rxBatchSize > 1) {
+        UDP_receiveBatch(pcm, conn);
+        return;
+    }
+#endif
+
     UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                  "UDP %u\t| Allocate receive buffer", (unsigned)conn->rfd.fd);
 
@@ -559,45 +737,7 @@ UDP_connectionSocketCallback(UA_POSIXConnectionManager *pcm, UDP_FD *conn,
 
     response.length = (size_t)ret; /* Set the length of the received buffer */
 
-    /* Extract message source and port */
-    char sourceAddr[64];
-    UA_UInt16 sourcePort;
-    switch(source.ss_family) {
-        case AF_INET:
-            inet_ntop(AF_INET, &((struct sockaddr_in *)&source)->sin_addr,
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in *)&source)->sin_port);
-            break;
-        case AF_INET6:
-            inet_ntop(AF_INET6, &(((struct sockaddr_in6 *)&source)->sin6_addr),
-                    sourceAddr, 64);
-            sourcePort = htons(((struct sockaddr_in6 *)&source)->sin6_port);
-            break;
-        default:
-            sourceAddr[0] = 0;
-            sourcePort = 0;
-    }
-
-    UA_String sourceAddrStr = UA_STRING(sourceAddr);
-    UA_KeyValuePair kvp[2];
-    kvp[0].key = UA_QUALIFIEDNAME(0, "remote-address");
-    UA_Variant_setScalar(&kvp[0].value, &sourceAddrStr, &UA_TYPES[UA_TYPES_STRING]);
-    kvp[1].key = UA_QUALIFIEDNAME(0, "remote-port");
-    UA_Variant_setScalar(&kvp[1].value, &sourcePort, &UA_TYPES[UA_TYPES_UINT16]);
-    UA_KeyValueMap kvm = {2, kvp};
-
-    UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
-                 "UDP %u\t| Received message of size %u from %s on port %u",
-                 (unsigned)conn->rfd.fd, (unsigned)ret,
-                 sourceAddr, sourcePort);
-
-    /* Callback to the application layer */
-    UA_UNLOCK(&el->elMutex);
-    conn->applicationCB(&pcm->cm, (uintptr_t)conn->rfd.fd,
-                        conn->application, &conn->context,
-                        UA_CONNECTIONSTATE_ESTABLISHED,
-                        &kvm, response);
-    UA_LOCK(&el->elMutex);
+    UDP_deliver(pcm, conn, &source, response);
 }
 
 static UA_StatusCode
@@ -846,6 +986,91 @@ UDP_shutdownConnection(UA_ConnectionManager *cm, uintptr_t connectionId) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* Poll until the socket can send again. Returns false if polling failed. */
+static UA_Boolean
+UDP_waitWritable(UA_FD fd) {
+    int poll_ret;
+    struct pollfd tmp_poll_fd;
+    tmp_poll_fd.fd = fd;
+    tmp_poll_fd.events = UA_POLLOUT;
+    do {
+        poll_ret = UA_poll(&tmp_poll_fd, 1, 100);
+        if(poll_ret < 0 && UA_ERRNO != UA_INTERRUPTED)
+            return false;
+    } while(poll_ret <= 0);
+    return true;
+}
+
+/* Send the same buffer to all fan-out destinations. The encoded bytes are
+ * shared between the datagrams. With sendmmsg, up to UDP_MAXSENDBATCH
+ * datagrams are sent with one syscall. */
+static UA_StatusCode
+UDP_sendFanout(UA_EventLoopPOSIX *el, UDP_FD *conn, const UA_ByteString *buf) {
+    UA_FD fd = conn->rfd.fd;
+    size_t total = conn->fanoutSize;
+    size_t sent = 0;
+
+#ifdef UDP_HAVE_SENDMMSG
+    struct mmsghdr msgs[UDP_MAXSENDBATCH];
+    struct iovec iov;
+    iov.iov_base = buf->data;
+    iov.iov_len = buf->length;
+    while(sent < total) {
+        size_t batch = total - sent;
+        if(batch > UDP_MAXSENDBATCH)
+            batch = UDP_MAXSENDBATCH;
+        memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+        for(size_t i = 0; i < batch; i++) {
+            UDP_Destination *d = &conn->fanout[sent + i];
+            msgs[i].msg_hdr.msg_name = &d->addr;
+            msgs[i].msg_hdr.msg_namelen = d->addrLength;
+            msgs[i].msg_hdr.msg_iov = &iov;
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        UA_LOG_DEBUG(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP %u	| Attempting to send to %u destinations",
+                     (unsigned)fd, (unsigned)batch);
+        int n = sendmmsg(fd, msgs, (unsigned int)batch, MSG_NOSIGNAL);
+        if(n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+#else
+    while(sent < total) {
+        const UDP_Destination *d = &conn->fanout[sent];
+        ssize_t n = UA_sendto(fd, (const char*)buf->data, buf->length, MSG_NOSIGNAL,
+                              (const struct sockaddr*)&d->addr, d->addrLength);
+        if(n >= 0) {
+            sent++;
+            continue;
+        }
+#endif
+
+        /* An error we cannot recover from? */
+        if(UA_ERRNO != UA_INTERRUPTED &&
+           UA_ERRNO != UA_WOULDBLOCK &&
+           UA_ERRNO != UA_AGAIN) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "UDP %u\t| Send to destination %u failed with error %s",
+                            (unsigned)fd, (unsigned)sent, errno_str));
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+
+        /* Poll for the socket resources to become available and retry
+         * (blocking) */
+        if(!UDP_waitWritable(fd)) {
+            UA_LOG_SOCKET_ERRNO_WRAP(
+               UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                            "UDP %u\t| Send failed with error %s",
+                            (unsigned)fd, errno_str));
+            return UA_STATUSCODE_BADCONNECTIONCLOSED;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
                        const UA_KeyValueMap *params,
@@ -864,6 +1089,16 @@ UDP_sendWithConnection(UA_ConnectionManager *cm, uintptr_t connectionId,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Fan-out to several destinations */
+    if(conn->fanoutSize > 0) {
+        UA_StatusCode res = UDP_sendFanout(el, conn, buf);
+        if(res != UA_STATUSCODE_GOOD)
+            UDP_shutdown(cm, &conn->rfd);
+        UA_UNLOCK(&el->elMutex);
+        UA_EventLoopPOSIX_freeNetworkBuffer(cm, connectionId, buf);
+        return res;
+    }
+
     /* Send the full buffer. This may require several calls to send */
     size_t nWritten = 0;
     do {
@@ -959,6 +1194,48 @@ registerSocketAndDestinationForSend(const UA_KeyValueMap *params,
     return UA_STATUSCODE_GOOD;
 }
 
+/* The first destination is already resolved into the sendAddr. All
+ * destinations need to use the address family of the socket. */
+static UA_StatusCode
+UDP_resolveFanout(const UA_KeyValueMap *params, size_t addrsSize, int family,
+                  UDP_FD *conn, const UA_Logger *logger) {
+    conn->fanout = (UDP_Destination*)UA_calloc(addrsSize, sizeof(UDP_Destination));
+    if(!conn->fanout)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    memcpy(&conn->fanout[0].addr, &conn->sendAddr, sizeof(struct sockaddr_storage));
+    conn->fanout[0].addrLength = conn->sendAddrLength;
+
+    for(size_t i = 1; i < addrsSize; i++) {
+        char hostname[UA_MAXHOSTNAME_LENGTH];
+        char portStr[UA_MAXPORTSTR_LENGTH];
+        struct addrinfo *info = NULL;
+        int error = getConnectionInfoFromParams(params, i, hostname,
+                                                portStr, &info, logger);
+        if(error < 0 || info == NULL) {
+            if(info != NULL)
+                freeaddrinfo(info);
+            return UA_STATUSCODE_BADCONNECTIONREJECTED;
+        }
+
+        struct addrinfo *ai = info;
+        while(ai && ai->ai_family != family)
+            ai = ai->ai_next;
+        if(!ai) {
+            UA_LOG_ERROR(logger, UA_LOGCATEGORY_NETWORK,
+                         "UDP\t| The fan-out destination \"%s\" has a different "
+                         "address family than the first destination", hostname);
+            freeaddrinfo(info);
+            return UA_STATUSCODE_BADCONNECTIONREJECTED;
+        }
+        memcpy(&conn->fanout[i].addr, ai->ai_addr, ai->ai_addrlen);
+        conn->fanout[i].addrLength = ai->ai_addrlen;
+        freeaddrinfo(info);
+    }
+
+    conn->fanoutSize = addrsSize;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *params,
                        void *application, void *context,
@@ -972,7 +1249,7 @@ UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *par
     char portStr[UA_MAXPORTSTR_LENGTH];
     struct addrinfo *info = NULL;
 
-    int error = getConnectionInfoFromParams(params, hostname,
+    int error = getConnectionInfoFromParams(params, 0, hostname,
                                             portStr, &info, el->eventLoop.logger);
     if(error < 0 || info == NULL) {
         if(info != NULL) {
@@ -999,16 +1276,28 @@ UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *par
         registerSocketAndDestinationForSend(params, hostname, info,
                                             error, conn, &newSock,
                                             el->eventLoop.logger);
+    int family = info->ai_family;
     freeaddrinfo(info);
+
+    /* Resolve the additional destinations of a fan-out connection */
+    size_t addrsSize = getParamSize(params, UDP_PARAMINDEX_ADDR);
+    if(res == UA_STATUSCODE_GOOD && addrsSize > 1) {
+        res = UDP_resolveFanout(params, addrsSize, family, conn, el->eventLoop.logger);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_close(newSock);
+    }
+
     if(validate && res == UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                     "UDP %u\t| Connection validated to \"%s\" on port %s",
                     (unsigned)newSock, hostname, portStr);
         UA_close(newSock);
+        UA_free(conn->fanout);
         UA_free(conn);
         return UA_STATUSCODE_GOOD;
     }
     if(res != UA_STATUSCODE_GOOD) {
+        UA_free(conn->fanout);
         UA_free(conn);
         return res;
     }
@@ -1027,6 +1316,7 @@ UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *par
         UA_LOG_WARNING(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                        "UDP\t| Registering the socket for %s failed", hostname);
         UA_close(newSock);
+        UA_free(conn->fanout);
         UA_free(conn);
         return res;
     }
@@ -1038,6 +1328,10 @@ UDP_openSendConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *par
     UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
                 "UDP %u\t| New connection to \"%s\" on port %s",
                 (unsigned)newSock, hostname, portStr);
+    if(conn->fanoutSize > 0)
+        UA_LOG_INFO(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                    "UDP %u\t| Fan-out to %u destinations",
+                    (unsigned)newSock, (unsigned)conn->fanoutSize);
 
     /* Signal the connection as opening. The connection fully opens in the next
      * iteration of the EventLoop */
@@ -1058,11 +1352,15 @@ UDP_openReceiveConnection(UA_POSIXConnectionManager *pcm, const UA_KeyValueMap *
     UA_EventLoopPOSIX *el = (UA_EventLoopPOSIX*)pcm->cm.eventSource.eventLoop;
     UA_LOCK_ASSERT(&el->elMutex, 1);
 
-    /* Get the port */
+    /* Get the port. Only send connections can have an array of ports. */
     const UA_UInt16 *port = (const UA_UInt16*)
         UA_KeyValueMap_getScalar(params, udpConnectionParams[UDP_PARAMINDEX_PORT].name,
                                  &UA_TYPES[UA_TYPES_UINT16]);
-    UA_assert(port); /* checked before */
+    if(!port) {
+        UA_LOG_ERROR(el->eventLoop.logger, UA_LOGCATEGORY_NETWORK,
+                     "UDP\t| Listen connections require a single port");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
 
     /* Get the hostname configuration */
     const UA_Variant *addrs =
@@ -1184,6 +1482,16 @@ UDP_eventSourceStart(UA_ConnectionManager *cm) {
     if(res != UA_STATUSCODE_GOOD)
         goto finish;
 
+    /* Configure the batched receive */
+    pcm->rxBatchSize = 1;
+    const UA_UInt32 *batchSize = (const UA_UInt32 *)
+        UA_KeyValueMap_getScalar(&cm->eventSource.params,
+                                 UA_QUALIFIEDNAME(0, "recv-batchsize"),
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+    if(batchSize && *batchSize > 1)
+        pcm->rxBatchSize = (*batchSize > UDP_MAXRECVBATCH) ?
+            UDP_MAXRECVBATCH : (size_t)*batchSize;
+
     /* Set the EventSource to the started state */
     cm->eventSource.state = UA_EVENTSOURCESTATE_STARTED;
 
@@ -70,24 +70,14 @@ static const uint32_t from_b64[256] = {
     0,  26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
     41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51};
 
-unsigned char *
-UA_unbase64(const unsigned char *src, size_t len, size_t *out_len) {
-    // we need a minimum length
-    if(len <= 2) {
-        *out_len = 0;
-        return (unsigned char*)UA_EMPTY_ARRAY_SENTINEL;
-    }
-
+size_t
+UA_unbase64_buf(const unsigned char *src, size_t len, unsigned char *out) {
     const unsigned char *p = src;
     size_t pad1 = len % 4 || p[len - 1] == '=';
     size_t pad2 = pad1 && (len % 4 > 2 || p[len - 2] != '=');
     const size_t last = (len - pad1) / 4 << 2;
 
-    unsigned char *str = (unsigned char*)UA_malloc(last / 4 * 3 + pad1 + pad2);
-    if(!str)
-        return NULL;
-
-    unsigned char *pos = str;
+    unsigned char *pos = out;
     for(size_t i = 0; i < last; i += 4) {
         uint32_t n = from_b64[p[i]] << 18 | from_b64[p[i + 1]] << 12 |
                      from_b64[p[i + 2]] << 6 | from_b64[p[i + 3]];
@@ -97,24 +87,42 @@ UA_unbase64(const unsigned char *src, size_t len, size_t *out_len) {
     }
 
     if(pad1) {
-        if (last + 1 >= len) {
-            UA_free(str);
-            *out_len = 0;
-            return (unsigned char*)UA_EMPTY_ARRAY_SENTINEL;
-        }
+        if (last + 1 >= len)
+            return 0;
         uint32_t n = from_b64[p[last]] << 18 | from_b64[p[last + 1]] << 12;
         *pos++ = (unsigned char)(n >> 16);
         if(pad2) {
-            if (last + 2 >= len) {
-                UA_free(str);
-                *out_len = 0;
-                return (unsigned char*)UA_EMPTY_ARRAY_SENTINEL;
-            }
+            if (last + 2 >= len)
+                return 0;
             n |= from_b64[p[last + 2]] << 6;
             *pos++ = (unsigned char)(n >> 8 & 0xFF);
         }
     }
 
-    *out_len = (uintptr_t)(pos - str);
+    return (uintptr_t)(pos - out);
+}
+
+unsigned char *
+UA_unbase64(const unsigned char *src, size_t len, size_t *out_len) {
+    // we need a minimum length
+    if(len <= 2) {
+        *out_len = 0;
+        return (unsigned char*)UA_EMPTY_ARRAY_SENTINEL;
+    }
+
+    const unsigned char *p = src;
+    size_t pad1 = len % 4 || p[len - 1] == '=';
+    size_t pad2 = pad1 && (len % 4 > 2 || p[len - 2] != '=');
+    const size_t last = (len - pad1) / 4 << 2;
+
+    unsigned char *str = (unsigned char*)UA_malloc(last / 4 * 3 + pad1 + pad2);
+    if(!str)
+        return NULL;
+
+    *out_len = UA_unbase64_buf(src, len, str);
+    if(*out_len == 0) {
+        UA_free(str);
+        return (unsigned char*)UA_EMPTY_ARRAY_SENTINEL;
+    }
     return str;
 }
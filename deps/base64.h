@@ -32,6 +32,14 @@ UA_base64_buf(const unsigned char *src, size_t len, unsigned char *out);
 unsigned char *
 UA_unbase64(const unsigned char *src, size_t len, size_t *out_len);
 
+/* Requires as input a buffer of length at least 3*(len/4) + 2 and len > 2.
+ * Returns the actual size. Zero if the input is truncated. The output can be
+ * the input buffer itself for in-place decoding. Each group of four characters
+ * is read before its three bytes are written, so the output never overtakes
+ * the input. */
+size_t
+UA_unbase64_buf(const unsigned char *src, size_t len, unsigned char *out);
+
 _UA_END_DECLS
 
 #endif /* UA_BASE64_H_ */
@@ -364,6 +364,37 @@ unsigned dtoa(double d, char* buffer) {
         }
     }
 
+    /* Fast path for integral values that are exact in the mantissa. The
+     * digits of the integer are the shortest representation. Integers with
+     * eight or more trailing zeros are printed in scientific notation
+     * below. */
+    if(exponent >= 1023 && exponent < 1023 + mantissa_bits) {
+        unsigned shift = mantissa_bits - (exponent - 1023);
+        uint64_t m = mantissa | (1ull << mantissa_bits);
+        if((m & ((1ull << shift) - 1)) == 0) {
+            uint64_t n = m >> shift;
+            char tmp[20];
+            unsigned len = 0;
+            unsigned zeros = 0;
+            bool lead = true;
+            while(n > 0) {
+                char c = (char)('0' + (n % 10));
+                if(lead && c == '0')
+                    zeros++;
+                else
+                    lead = false;
+                tmp[len++] = c;
+                n /= 10;
+            }
+            if(zeros < 8) {
+                for(unsigned i = 0; i < len; i++)
+                    buffer[i] = tmp[len - 1 - i];
+                memcpy(buffer + len, ".0", 2);
+                return pos + len + 2;
+            }
+        }
+    }
+
     int K = 0;
     char digits[18];
     memset(digits, 0, 18);
@@ -97,6 +97,9 @@ parseInt64(const char *str, size_t size, int64_t *result) {
 }
 
 size_t parseDouble(const char *str, size_t size, double *result) {
+    /* strtod requires a null-terminated string. Parse the bounded copy. The
+     * input is usually a token inside a larger document and strtod must not
+     * continue past its end. */
     char buf[2000];
     if(size >= 2000)
         return 0;
@@ -104,8 +107,8 @@ size_t parseDouble(const char *str, size_t size, double *result) {
     buf[size] = 0;
     errno = 0;
     char *endptr;
-    *result = strtod(str, &endptr);
+    *result = strtod(buf, &endptr);
     if(errno != 0 && errno != ERANGE)
         return 0;
-    return (uintptr_t)endptr - (uintptr_t)str;
+    return (uintptr_t)endptr - (uintptr_t)buf;
 }
@@ -240,6 +240,110 @@ __ZIP_ITER_KEY(zip_cmp_cb cmp, unsigned short fieldoffset,
     return NULL;
 }
 
+void *
+__ZIP_ITER_RANGE(zip_cmp_cb cmp, unsigned short fieldoffset,
+                 unsigned short keyoffset, const void *min, const void *max,
+                 zip_iter_cb cb, void *context, void *elm) {
+    if(!elm)
+        return NULL;
+
+    void *res;
+    enum ZIP_CMP lo = cmp(min, ZIP_KEY_PTR(elm));
+    enum ZIP_CMP hi = cmp(max, ZIP_KEY_PTR(elm));
+    if(lo != ZIP_CMP_MORE) {
+        res = __ZIP_ITER_RANGE(cmp, fieldoffset, keyoffset, min, max,
+                               cb, context, ZIP_ENTRY_PTR(elm)->left);
+        if(res)
+            return res;
+    }
+
+    if(lo != ZIP_CMP_MORE && hi != ZIP_CMP_LESS) {
+        res = cb(context, elm);
+        if(res)
+            return res;
+    }
+
+    if(hi != ZIP_CMP_LESS) {
+        res = __ZIP_ITER_RANGE(cmp, fieldoffset, keyoffset, min, max,
+                               cb, context, ZIP_ENTRY_PTR(elm)->right);
+        if(res)
+            return res;
+    }
+
+    return NULL;
+}
+
+/* Elements with the same key are ordered by their pointer. So the next element
+ * is the smallest element that is "more" in the unique order. This works also
+ * if elm itself is no longer contained in the tree. */
+void *
+__ZIP_NEXT(zip_cmp_cb cmp, unsigned short fieldoffset,
+           unsigned short keyoffset, void *h, void *elm) {
+    zip_elem *next = NULL;
+    zip_elem *cur = ((zip_head*)h)->root;
+    const void *key = ZIP_KEY_PTR(elm);
+    while(cur) {
+        if(__ZIP_UNIQUE_CMP(cmp, key, ZIP_KEY_PTR(cur)) == ZIP_CMP_LESS) {
+            next = cur;
+            cur = ZIP_ENTRY_PTR(cur)->left;
+        } else {
+            cur = ZIP_ENTRY_PTR(cur)->right;
+        }
+    }
+    return next;
+}
+
+void *
+__ZIP_PREV(zip_cmp_cb cmp, unsigned short fieldoffset,
+           unsigned short keyoffset, void *h, void *elm) {
+    zip_elem *prev = NULL;
+    zip_elem *cur = ((zip_head*)h)->root;
+    const void *key = ZIP_KEY_PTR(elm);
+    while(cur) {
+        if(__ZIP_UNIQUE_CMP(cmp, key, ZIP_KEY_PTR(cur)) == ZIP_CMP_MORE) {
+            prev = cur;
+            cur = ZIP_ENTRY_PTR(cur)->right;
+        } else {
+            cur = ZIP_ENTRY_PTR(cur)->left;
+        }
+    }
+    return prev;
+}
+
+/* The tree is unique for the given order and the ranks. So it can be built
+ * left-to-right in linear time (like a cartesian tree). The right spine of the
+ * tree that is built so far is kept as a stack of candidate parents for the
+ * next element. While building, the right-pointers on the spine point upwards
+ * (towards the root). This avoids an additional stack allocation. They are
+ * reversed once an element leaves the spine and in the end. */
+void *
+__ZIP_BUILD(unsigned short fieldoffset, void **elms, size_t n) {
+    zip_elem *top = NULL; /* Lowest element of the right spine */
+    for(size_t i = 0; i < n; i++) {
+        zip_elem *x = (zip_elem*)elms[i];
+        zip_elem *last = NULL;
+        while(top && __ZIP_RANK_CMP(top, x) == ZIP_CMP_LESS) {
+            zip_elem *up = ZIP_ENTRY_PTR(top)->right;
+            ZIP_ENTRY_PTR(top)->right = last;
+            last = top;
+            top = up;
+        }
+        ZIP_ENTRY_PTR(x)->left = last;
+        ZIP_ENTRY_PTR(x)->right = top;
+        top = x;
+    }
+
+    /* Reverse the pointers along the right spine */
+    zip_elem *root = NULL;
+    while(top) {
+        zip_elem *up = ZIP_ENTRY_PTR(top)->right;
+        ZIP_ENTRY_PTR(top)->right = root;
+        root = top;
+        top = up;
+    }
+    return root;
+}
+
 void *
 __ZIP_ZIP(unsigned short fieldoffset, void *left, void *right) {
     if(!left)
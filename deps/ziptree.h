@@ -96,6 +96,28 @@ typedef void * (*zip_iter_cb)(void *context, void *elm);
 /* Same as _ITER, but only visits elements with the given key */
 #define ZIP_ITER_KEY(name, head, key, cb, ctx) name##_ZIP_ITER_KEY(head, key, cb, ctx)
 
+/* Same as _ITER, but only visits elements with min <= key <= max */
+#define ZIP_ITER_RANGE(name, head, min, max, cb, ctx) \
+    name##_ZIP_ITER_RANGE(head, min, max, cb, ctx)
+
+/* Returns the first element with a key >= the given key. NULL if there is
+ * none. */
+#define ZIP_LOWER_BOUND(name, head, key) name##_ZIP_LOWER_BOUND(head, key)
+
+/* Returns the next (previous) element in the order of the tree. NULL if elm is
+ * the last (first) element. Together with ZIP_MIN (ZIP_MAX) this iterates over
+ * the tree without recursion and without a callback. Every step is a lookup
+ * from the root. */
+#define ZIP_NEXT(name, head, elm) name##_ZIP_NEXT(head, elm)
+#define ZIP_PREV(name, head, elm) name##_ZIP_PREV(head, elm)
+
+/* Build the tree from an array of n elements in O(n). This replaces the
+ * previous content of the tree. The elements need to be sorted in ascending
+ * key order. Elements with the same key must be sorted by their (ascending)
+ * pointer value. This is the order that ZIP_INSERT uses internally. The
+ * resulting tree is the same as if the elements were inserted one by one. */
+#define ZIP_BUILD(name, head, elms, n) name##_ZIP_BUILD(head, elms, n)
+
 /* Macro to generate typed ziptree methods */
 #define ZIP_FUNCTIONS(name, type, field, keytype, keyfield, cmp)        \
                                                                         \
@@ -166,6 +188,49 @@ name##_ZIP_ITER_KEY(struct name *head, const keytype *key,              \
                           (zip_iter_cb)cb, context, ZIP_ROOT(head));    \
 }                                                                       \
                                                                         \
+ZIP_UNUSED static ZIP_INLINE void *                                     \
+name##_ZIP_ITER_RANGE(struct name *head, const keytype *min,            \
+                      const keytype *max, name##_cb cb, void *context) { \
+    return __ZIP_ITER_RANGE((zip_cmp_cb)cmp, offsetof(struct type, field), \
+                            offsetof(struct type, keyfield), min, max,  \
+                            (zip_iter_cb)cb, context, ZIP_ROOT(head));  \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_ZIP_LOWER_BOUND(struct name *head, const keytype *key) {         \
+    struct type *cur = ZIP_ROOT(head);                                  \
+    struct type *res = NULL;                                            \
+    while(cur) {                                                        \
+        if(cmp(key, &cur->keyfield) != ZIP_CMP_MORE) {                  \
+            res = cur;                                                  \
+            cur = ZIP_LEFT(cur, field);                                 \
+        } else {                                                        \
+            cur = ZIP_RIGHT(cur, field);                                \
+        }                                                               \
+    }                                                                   \
+    return res;                                                         \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_ZIP_NEXT(struct name *head, struct type *elm) {                  \
+    return (struct type*)                                               \
+        __ZIP_NEXT((zip_cmp_cb)cmp, offsetof(struct type, field),       \
+                   offsetof(struct type, keyfield), head, elm);         \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE struct type *                              \
+name##_ZIP_PREV(struct name *head, struct type *elm) {                  \
+    return (struct type*)                                               \
+        __ZIP_PREV((zip_cmp_cb)cmp, offsetof(struct type, field),       \
+                   offsetof(struct type, keyfield), head, elm);         \
+}                                                                       \
+                                                                        \
+ZIP_UNUSED static ZIP_INLINE void                                       \
+name##_ZIP_BUILD(struct name *head, struct type **elms, size_t n) {     \
+    head->root = (struct type*)                                         \
+        __ZIP_BUILD(offsetof(struct type, field), (void**)elms, n);     \
+}                                                                       \
+                                                                        \
 ZIP_UNUSED static ZIP_INLINE struct type *                              \
 name##_ZIP_ZIP(struct type *left, struct type *right) {                 \
     return (struct type*)                                               \
@@ -199,6 +264,22 @@ __ZIP_ITER_KEY(zip_cmp_cb cmp, unsigned short fieldoffset,
                unsigned short keyoffset, const void *key,
                zip_iter_cb cb, void *context, void *elm);
 
+void *
+__ZIP_ITER_RANGE(zip_cmp_cb cmp, unsigned short fieldoffset,
+                 unsigned short keyoffset, const void *min, const void *max,
+                 zip_iter_cb cb, void *context, void *elm);
+
+void *
+__ZIP_NEXT(zip_cmp_cb cmp, unsigned short fieldoffset,
+           unsigned short keyoffset, void *h, void *elm);
+
+void *
+__ZIP_PREV(zip_cmp_cb cmp, unsigned short fieldoffset,
+           unsigned short keyoffset, void *h, void *elm);
+
+void *
+__ZIP_BUILD(unsigned short fieldoffset, void **elms, size_t n);
+
 void *
 __ZIP_ZIP(unsigned short fieldoffset, void *left, void *right);
 
@@ -0,0 +1,49 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information. */
+
+/* Converts a Json5 server configuration into the compact binary configuration.
+ * Run this at build time and load the result on the target with
+ * UA_Server_newFromBinaryConfig. The target then needs neither the Json5
+ * parser nor file system access for the certificates. */
+
+#include <stdlib.h>
+#include <open62541/server.h>
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/server_config_file_based.h>
+
+#include "common.h"
+
+int main(int argc, char** argv) {
+    if(argc < 3) {
+        UA_LOG_FATAL(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Missing argument. Usage: %s "
+                     "<server-config.json5> <server-config.bin>", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    UA_ByteString json_config = loadFile(argv[1]);
+    if(json_config.length == 0) {
+        UA_LOG_FATAL(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Cannot read %s", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    UA_ByteString binary_config = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_ServerConfig_jsonToBinary(json_config, &binary_config);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = writeFile(argv[2], binary_config);
+    if(retval == UA_STATUSCODE_GOOD)
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Wrote %lu bytes to %s",
+                    (unsigned long)binary_config.length, argv[2]);
+    else
+        UA_LOG_FATAL(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Conversion failed with error code %s",
+                     UA_StatusCode_name(retval));
+
+    /* clean up */
+    UA_ByteString_clear(&json_config);
+    UA_ByteString_clear(&binary_config);
+
+    return retval == UA_STATUSCODE_GOOD ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -58,6 +58,7 @@ int main(void) {
 
     /* Now we define the settings for our node */
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
 
     /* There is a memory based database plugin. We will use that. We just
      * reserve space for 3 nodes with 10 values each. This will NOT automatically grow
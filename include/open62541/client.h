@@ -31,6 +31,9 @@
 struct UA_ClientConfig;
 typedef struct UA_ClientConfig UA_ClientConfig;
 
+struct UA_ClientEndpointCache;
+typedef struct UA_ClientEndpointCache UA_ClientEndpointCache;
+
 _UA_BEGIN_DECLS
 
 /**
@@ -139,6 +142,16 @@ struct UA_ClientConfig {
      */
     UA_String applicationUri;
 
+    /**
+     * The Endpoint and UserTokenPolicy selected during the discovery can be
+     * cached for the EndpointUrl. Later connections to the same EndpointUrl
+     * (also from other clients that share the cache) then skip the FindServers
+     * and GetEndpoints round-trips and directly open the SecureChannel with the
+     * cached server certificate. See the section on the endpoint cache below.
+     * The cache is not owned by the configuration and has to outlive the
+     * clients that use it. */
+    UA_ClientEndpointCache *endpointCache;
+
     /**
      * The following settings are specific to OPC UA with TCP transport. */
     UA_Boolean tcpReuseAddr;
@@ -206,6 +219,56 @@ struct UA_ClientConfig {
     /* Number of PublishResponse queued up in the server */
     UA_UInt16 outStandingPublishRequests;
 
+    /* Upper limit for an adaptive number of outstanding PublishRequests. If
+     * greater than outStandingPublishRequests, more PublishRequests are kept
+     * in flight while the server reports moreNotifications and while the
+     * measured round-trip time exceeds the shortest publishing interval. The
+     * number shrinks back with every keep-alive message. Zero (the default)
+     * disables the adaptation. */
+    UA_UInt16 maxOutStandingPublishRequests;
+
+    /* Decode the PublishResponses into an arena whose memory is reused for the
+     * next response. Then the notification callbacks must not take ownership
+     * of (parts of) the values they receive. Values can be copied. */
+    UA_Boolean publishResponseArena;
+
+    /* Recovery of the Subscriptions after a connection loss. When the
+     * SecureChannel is reopened, the existing Session is activated again and
+     * the Subscriptions continue. NotificationMessages that were lost on the
+     * way are requested with Republish. Newer messages are held back until
+     * the missing ones were processed. If the Session was lost as well, the
+     * Subscriptions are moved to the new Session with TransferSubscriptions.
+     * The MonitoredItems remain untouched in both cases. Subscriptions that
+     * cannot be transferred are deleted locally. With noSubscriptionTransfer,
+     * the Subscriptions of a lost Session are always deleted. */
+    UA_Boolean noSubscriptionTransfer;
+
+    /* Coalescing of async operations. If enabled, async Read and Write
+     * requests with a single item (e.g. from ``UA_Client_readAttribute_async``)
+     * are collected and sent as one request with many items. Every callback
+     * receives a response with only its own item. Requests with a manually
+     * defined requestHandle, returnDiagnostics or an additionalHeader are sent
+     * directly.
+     *
+     * A collected call is not sent yet when the async function returns. So
+     * the returned requestId is zero and the callback receives the requestId
+     * of the combined request.
+     *
+     * asyncBatchingWindow is the time in ms during which operations are
+     * collected. With zero they are sent in the next iteration of the
+     * EventLoop, for example in the next ``UA_Client_run_iterate``. The
+     * collected operations are sent right away when the maximum number of
+     * items for a request is reached. Set these to the MaxNodesPerRead and
+     * MaxNodesPerWrite OperationLimits of the server. Zero means no limit. */
+    UA_Boolean asyncBatching;
+    UA_Double asyncBatchingWindow;
+    UA_UInt32 asyncBatchingMaxNodesPerRead;
+    UA_UInt32 asyncBatchingMaxNodesPerWrite;
+
+    /* Maximum number of nodes in the node cache. Zero (the default) disables
+     * the cache. See the section on the node cache below. */
+    UA_UInt32 nodeCacheSize;
+
     /* If the client does not receive a PublishResponse after the defined delay
      * of ``(sub->publishingInterval * sub->maxKeepAliveCount) +
      * client->config.timeout)``, then subscriptionInactivityCallback is called
@@ -274,6 +337,34 @@ UA_ClientConfig_setAuthenticationUsername(UA_ClientConfig *config,
     return UA_STATUSCODE_GOOD;
 })
 
+/**
+ * Endpoint Cache
+ * ~~~~~~~~~~~~~~
+ * An entry is added when a Session is activated with an Endpoint from the
+ * discovery. Entries are used only if they are compatible with the
+ * configuration of the connecting client (SecurityMode, SecurityPolicy,
+ * ApplicationUri and the type of the user identity token). If the connection
+ * with a cached Endpoint fails after the TCP connection was established (e.g.
+ * because the server certificate has changed), the entry is removed and the
+ * client runs the full discovery instead. The cache is thread-safe and can be
+ * shared by clients in different threads. */
+
+/* Entries older than maxAge (in ms) are not used. Zero for no limit. */
+UA_EXPORT UA_ClientEndpointCache *
+UA_ClientEndpointCache_new(UA_UInt32 maxAge);
+
+UA_EXPORT void
+UA_ClientEndpointCache_delete(UA_ClientEndpointCache *cache);
+
+/* Remove the entry for the EndpointUrl */
+UA_EXPORT void
+UA_ClientEndpointCache_remove(UA_ClientEndpointCache *cache,
+                              const UA_String endpointUrl);
+
+/* Number of cached EndpointUrls */
+UA_EXPORT size_t
+UA_ClientEndpointCache_getSize(UA_ClientEndpointCache *cache);
+
 /**
  * Client Lifecycle
  * ---------------- */
@@ -638,6 +729,32 @@ UA_Client_Service_write(UA_Client *client, const UA_WriteRequest request) ,{
     return response;
 })
 
+/* Prepared Read
+ * ~~~~~~~~~~~~~
+ * For cyclic polling of the same set of values. The ReadRequest is encoded
+ * only once when it is prepared. For every call, only the RequestHeader is
+ * encoded anew (with the current AuthenticationToken, timestamp and a fresh
+ * RequestHandle). The response is decoded into memory that is reused between
+ * the calls. The node cache of the client is not used for prepared reads.
+ *
+ * The returned response remains valid until the next call to
+ * UA_Client_readPrepared or until the prepared read is deleted. It must not be
+ * cleared by the caller. Only one thread at a time may use the same prepared
+ * read. */
+
+struct UA_PreparedRead;
+typedef struct UA_PreparedRead UA_PreparedRead;
+
+UA_EXPORT UA_StatusCode
+UA_Client_prepareRead(UA_Client *client, const UA_ReadRequest *request,
+                      UA_PreparedRead **pr);
+
+UA_EXPORT UA_THREADSAFE const UA_ReadResponse *
+UA_Client_readPrepared(UA_Client *client, UA_PreparedRead *pr);
+
+UA_EXPORT void
+UA_PreparedRead_delete(UA_PreparedRead *pr);
+
 /*
 * Historical Access Service Set
 * ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ */
@@ -894,6 +1011,49 @@ UA_Client_run_iterate(UA_Client *client, UA_UInt32 timeout);
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Client_renewSecureChannel(UA_Client *client);
 
+/**
+ * Node Cache
+ * ----------
+ * The client can cache static metadata of the server nodes. With
+ * ``nodeCacheSize`` set in the configuration, synchronous Read requests for
+ * the attributes except for the Value (but including the Value of the
+ * NamespaceArray) and Browse requests without a View and continuation are
+ * answered from the cache if all their results are cached. The affected nodes
+ * are invalidated when the client sends Write requests for non-Value
+ * attributes or changes the references. DeleteNodes clears the cache.
+ *
+ * The cache is bound to the NamespaceArray of the server. Within every new
+ * Session, the NamespaceArray is read for the first cached request. If it
+ * differs from the NamespaceArray of the cached entries, the cache is cleared.
+ * So a cache that was saved and loaded again (e.g. from disk between runs) is
+ * only used for the same server address space.
+ *
+ * Changes of the address space by other clients are not detected
+ * automatically. Forward the ``Changes`` field of GeneralModelChangeEvents from
+ * an Event MonitoredItem to ``UA_Client_NodeCache_processModelChange``. */
+
+/* Remove all cached entries */
+void UA_EXPORT UA_THREADSAFE
+UA_Client_NodeCache_clear(UA_Client *client);
+
+/* Remove the cached entries of a node */
+void UA_EXPORT UA_THREADSAFE
+UA_Client_NodeCache_invalidate(UA_Client *client, const UA_NodeId nodeId);
+
+/* Invalidate the nodes from an array of ModelChangeStructureDataType. An empty
+ * or unknown value (e.g. from a BaseModelChangeEvent) clears the cache. */
+void UA_EXPORT UA_THREADSAFE
+UA_Client_NodeCache_processModelChange(UA_Client *client,
+                                       const UA_Variant *changes);
+
+/* Encode the cache content to a ByteString that is allocated */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_NodeCache_save(UA_Client *client, UA_ByteString *out);
+
+/* Replace the cache content with a previously saved one */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_NodeCache_load(UA_Client *client, const UA_ByteString *data);
+
 /**
  * Timed Callbacks
  * ---------------
@@ -954,9 +1114,24 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId);
 
 /* Lookup a datatype by its NodeId. Takes the custom types in the client
  * configuration into account. Return NULL if none found. */
-UA_EXPORT const UA_DataType *
+UA_EXPORT const UA_DataType * UA_THREADSAFE
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId);
 
+/* Generate the data type descriptions for custom structures and enumerations
+ * of the server from their DataTypeDefinition attribute. The data types of the
+ * structure fields are loaded as well if they are unknown. The generated types
+ * are prepended to the customDataTypes of the configuration. From then on,
+ * ExtensionObjects with these types are decoded when they are received.
+ *
+ * If no typeIds are given, all subtypes of Structure and Enumeration outside
+ * of namespace zero are loaded. Supported are Structures (also with optional
+ * fields) and Unions whose fields are scalars or one-dimensional arrays. The
+ * generated memory layout corresponds to a C struct with the members in the
+ * order of the definition. Optional scalar fields are pointers. */
+UA_EXPORT UA_StatusCode UA_THREADSAFE
+UA_Client_loadDataTypes(UA_Client *client, size_t typeIdsSize,
+                        const UA_NodeId *typeIds);
+
 /**
  * .. toctree::
  *
@@ -254,6 +254,26 @@ UA_Client_HistoryRead_modified(
     UA_UInt32 numValuesPerNode, UA_TimestampsToReturn timestampsToReturn,
     void *callbackContext);
 
+/* Read the raw history of many nodes. Up to nodesPerRequest nodes are read
+ * in one HistoryRead request and up to maxRequestsInFlight requests are
+ * pending at the same time. The callback is called for every page as it
+ * arrives. Continuation points are followed as long as the callback returns
+ * true, and released otherwise. The pages of different nodes interleave.
+ *
+ * The function blocks until all nodes are read and must not be called from a
+ * client callback. nodesPerRequest zero reads all nodes in one request.
+ * results is optional. If set, it has nodesSize entries and receives the
+ * status of every node. The return value is the status of the connection, or
+ * else the first bad status of a node. */
+UA_StatusCode UA_EXPORT
+UA_Client_HistoryRead_rawBatch(
+    UA_Client *client, size_t nodesSize, const UA_NodeId *nodeIds,
+    const UA_HistoricalIteratorCallback callback, UA_DateTime startTime,
+    UA_DateTime endTime, UA_String indexRange, UA_Boolean returnBounds,
+    UA_UInt32 numValuesPerNode, UA_TimestampsToReturn timestampsToReturn,
+    size_t nodesPerRequest, size_t maxRequestsInFlight,
+    UA_StatusCode *results, void *callbackContext);
+
 UA_StatusCode UA_EXPORT
 UA_Client_HistoryUpdate_insert(
     UA_Client *client, const UA_NodeId *nodeId, UA_DataValue *value);
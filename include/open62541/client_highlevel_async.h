@@ -85,6 +85,45 @@ UA_Client_sendAsyncBrowseNextRequest(
         &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE], userdata, reqId);
 })
 
+/**
+ * Recursive Browse
+ * ^^^^^^^^^^^^^^^^
+ *
+ * Browse the address space recursively, starting from the node in the
+ * BrowseDescription. The other fields of the BrowseDescription are used for
+ * every browsed node. Up to nodesPerRequest nodes are browsed in one request
+ * and up to maxRequestsInFlight Browse and BrowseNext requests are pending at
+ * the same time. Continuation points are followed before new nodes are
+ * browsed. Nodes for which the server has no free continuation point
+ * (BadNoContinuationPoints) are browsed again once the pending continuation
+ * points are released.
+ *
+ * The callback is called for every reference as the results arrive. The
+ * target nodes of the references are browsed once, also if several references
+ * point to them. Targets in other servers are not browsed. Return false from
+ * the callback to stop. Then the open continuation points are released.
+ *
+ * The doneCallback (optional) is called once when no requests are left. The
+ * status is the first service error (e.g. the connection was lost), else the
+ * first bad status of a node. The client has to be run (e.g. with
+ * UA_Client_run_iterate) for the requests to proceed. */
+
+typedef UA_Boolean
+(*UA_ClientBrowseRecursiveCallback)(UA_Client *client, void *userdata,
+                                    const UA_NodeId *sourceNodeId,
+                                    const UA_ReferenceDescription *rd);
+
+typedef void
+(*UA_ClientBrowseRecursiveDoneCallback)(UA_Client *client, void *userdata,
+                                        UA_StatusCode status);
+
+UA_StatusCode UA_EXPORT
+UA_Client_browseRecursive_async(UA_Client *client, const UA_BrowseDescription *bd,
+                                size_t nodesPerRequest, size_t maxRequestsInFlight,
+                                UA_ClientBrowseRecursiveCallback callback,
+                                UA_ClientBrowseRecursiveDoneCallback doneCallback,
+                                void *userdata);
+
 /**
  * Asynchronous Operations
  * ^^^^^^^^^^^^^^^^^^^^^^^
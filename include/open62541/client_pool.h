@@ -0,0 +1,87 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_CLIENT_POOL_H_
+#define UA_CLIENT_POOL_H_
+
+#include <open62541/client.h>
+
+_UA_BEGIN_DECLS
+
+/**
+ * .. _client_pool:
+ *
+ * Client Pool
+ * -----------
+ *
+ * A client pool connects several clients to the same server. Every client has
+ * its own SecureChannel, TCP connection and Session. So service calls that are
+ * distributed over the clients are processed in parallel by the server and
+ * their chunks are not serialized on one channel.
+ *
+ * The clients share the plugins of the pool configuration. These are the
+ * EventLoop, the logger, the SecurityPolicies (with the certificate and the
+ * private key), the certificate verification and the custom data types. They
+ * exist only once in memory.
+ *
+ * By default all clients run in the shared EventLoop. Then
+ * ``UA_ClientPool_run_iterate`` processes the network events of all clients in
+ * one thread. To run every client in its own thread, give each client a
+ * dedicated EventLoop with ``UA_ClientPool_setEventLoop`` before connecting.
+ * Then call ``UA_Client_run_iterate`` for each client from its thread. */
+
+typedef struct UA_ClientPool UA_ClientPool;
+
+/* Creates a pool with clientsSize clients. Moves the config into the pool with
+ * a shallow copy. The config content is cleared together with the pool. If
+ * NULL is returned, the config is left untouched. */
+UA_ClientPool UA_EXPORT *
+UA_ClientPool_new(const UA_ClientConfig *config, size_t clientsSize);
+
+/* Disconnects and deletes all clients of the pool */
+void UA_EXPORT
+UA_ClientPool_delete(UA_ClientPool *pool);
+
+/* Use a dedicated EventLoop for the client with the index. The client takes
+ * ownership of the EventLoop. Must be called before connecting. */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_setEventLoop(UA_ClientPool *pool, size_t index, UA_EventLoop *el);
+
+/* Connects all clients in parallel and waits until every Session is activated.
+ * If one of the clients cannot connect, all clients are disconnected and the
+ * error is returned. */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_connect(UA_ClientPool *pool, const char *endpointUrl);
+
+void UA_EXPORT
+UA_ClientPool_disconnect(UA_ClientPool *pool);
+
+size_t UA_EXPORT
+UA_ClientPool_getSize(const UA_ClientPool *pool);
+
+/* Returns the client with the index or NULL */
+UA_Client UA_EXPORT *
+UA_ClientPool_getClient(UA_ClientPool *pool, size_t index);
+
+typedef enum {
+    UA_CLIENTPOOLSTRATEGY_ROUNDROBIN = 0, /* The clients take turns */
+    UA_CLIENTPOOLSTRATEGY_LEASTLOADED = 1 /* The client with the fewest
+                                           * pending async calls */
+} UA_ClientPoolStrategy;
+
+/* Select the client for the next service call. Only clients with an activated
+ * Session are considered. Returns NULL if there is none. */
+UA_Client UA_EXPORT *
+UA_ClientPool_next(UA_ClientPool *pool, UA_ClientPoolStrategy strategy);
+
+/* Process the network events and async responses of all clients. The timeout
+ * applies to the shared EventLoop. Dedicated EventLoops are iterated without
+ * waiting. Returns the first bad connection status of a client. */
+UA_StatusCode UA_EXPORT
+UA_ClientPool_run_iterate(UA_ClientPool *pool, UA_UInt32 timeout);
+
+_UA_END_DECLS
+
+#endif /* UA_CLIENT_POOL_H_ */
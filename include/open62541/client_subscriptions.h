@@ -153,6 +153,26 @@ typedef void (*UA_Client_DataChangeNotificationCallback)
      UA_UInt32 monId, void *monContext,
      UA_DataValue *value);
 
+/* A DataChange notification as passed to the batch callback */
+typedef struct {
+    UA_UInt32 monId;
+    void *monContext;
+    const UA_DataValue *value;
+} UA_Client_DataChange;
+
+/* Callback for all DataChange notifications of a NotificationMessage. The
+ * array and the values are only valid during the callback. */
+typedef void (*UA_Client_DataChangeBatchCallback)
+    (UA_Client *client, UA_UInt32 subId, void *subContext,
+     size_t dataChangesSize, const UA_Client_DataChange *dataChanges);
+
+/* If a batch callback is set for the Subscription, it is called instead of the
+ * individual DataChange callbacks of the MonitoredItems. The callback is
+ * removed with NULL. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Client_Subscriptions_setDataChangeBatchCallback(UA_Client *client,
+    UA_UInt32 subscriptionId, UA_Client_DataChangeBatchCallback callback);
+
 /* Callback for Event notifications */
 typedef void (*UA_Client_EventNotificationCallback)
     (UA_Client *client, UA_UInt32 subId, void *subContext,
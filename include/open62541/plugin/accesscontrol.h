@@ -32,6 +32,13 @@ struct UA_AccessControl {
     void *context;
     void (*clear)(UA_AccessControl *ac);
 
+    /* If true, the server caches the results of getUserRightsMask,
+     * getUserAccessLevel, getUserExecutable and allowBrowseNode per session
+     * and node. The cached decisions of a session are dropped when it is
+     * (re-)activated. Otherwise the plugin has to signal changes with
+     * UA_Server_invalidateAccessCache. */
+    UA_Boolean cacheDecisions;
+
     /* Supported login mechanisms. The server endpoints are created from here. */
     size_t userTokenPoliciesSize;
     UA_UserTokenPolicy *userTokenPolicies;
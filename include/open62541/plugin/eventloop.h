@@ -83,6 +83,49 @@ typedef enum {
                                 * cycles to finish */
 } UA_EventLoopState;
 
+/* Statistics of an EventLoop. The times are in UA_DateTime units (100ns). The
+ * busy time of an iteration excludes the time spent waiting for events. The
+ * busy time is split up into the processing of timed and cyclic callbacks
+ * (timerTime), of delayed callbacks (delayedTime) and of network and other
+ * events (eventTime). The timer lag is the delay between the scheduled time of
+ * a timed or cyclic callback and the time when the due callbacks are
+ * processed. Bucket i of the lag distribution counts the lags d with 2^i <= d
+ * < 2^(i+1). The first bucket also counts zero lags and the last bucket all
+ * longer lags. */
+#define UA_EVENTLOOP_LAGBUCKETS 32
+
+typedef struct {
+    UA_UInt64 iterationCount;
+    UA_UInt64 busyTime; /* cumulated */
+    UA_UInt64 maxBusyTime;
+    UA_UInt64 timerTime; /* cumulated */
+    UA_UInt64 delayedTime; /* cumulated */
+    UA_UInt64 eventTime; /* cumulated */
+    UA_UInt64 waitTime; /* cumulated */
+    UA_UInt64 timerCallbackCount;
+    UA_UInt64 timerLag; /* cumulated */
+    UA_UInt64 maxTimerLag;
+    UA_UInt64 timerLagBuckets[UA_EVENTLOOP_LAGBUCKETS];
+    UA_UInt64 slowCallbackCount; /* See slowCallbackThreshold below */
+} UA_EventLoopStatistics;
+
+/* Timing of one iteration of the EventLoop for the tracing hook. The start is
+ * taken from the monotonic clock of the EventLoop. The other fields are
+ * durations in UA_DateTime units (100ns). */
+typedef struct {
+    UA_DateTime start;
+    UA_DateTime timerTime;
+    UA_DateTime delayedTime;
+    UA_DateTime eventTime;
+    UA_DateTime waitTime;
+} UA_EventLoopIterationTrace;
+
+/* Callback types that are reported by the slow-callback hook */
+typedef enum {
+    UA_EVENTLOOPCALLBACK_TIMER,  /* Timed and cyclic callbacks */
+    UA_EVENTLOOPCALLBACK_DELAYED
+} UA_EventLoopCallbackType;
+
 struct UA_EventLoop {
     /* Configuration
      * ~~~~~~~~~~~~~~~
@@ -147,6 +190,16 @@ struct UA_EventLoop {
     UA_DateTime (*dateTime_nowMonotonic)(UA_EventLoop *el);
     UA_Int64    (*dateTime_localTimeUtcOffset)(UA_EventLoop *el);
 
+    /* Coarse variant of dateTime_now. While the EventLoop is executing, this
+     * returns the wallclock time taken once when the current iteration
+     * started and again after waiting for events. So all callbacks processed
+     * together see the same time without reading the clock again. Outside of
+     * the EventLoop, the current time is returned. Use this only where a
+     * deviation by the processing time of one iteration is acceptable (e.g.
+     * for response timestamps). Can be NULL if the EventLoop does not
+     * implement caching. Then dateTime_now is used instead. */
+    UA_DateTime (*dateTime_nowCached)(UA_EventLoop *el);
+
     /* Timed Callbacks
      * ~~~~~~~~~~~~~~~
      * Cyclic callbacks are executed regularly with an interval.
@@ -185,7 +238,10 @@ struct UA_EventLoop {
      * The delayed callbacks are processed in each of the cycle of the EventLoop
      * between the handling of timed cyclic callbacks and polling for (network)
      * events. The memory for the delayed callback is *NOT* automatically freed
-     * after the execution. */
+     * after the execution.
+     *
+     * Delayed callbacks can be added from other threads. An EventLoop that
+     * waits for events should then wake up to process them right away. */
 
     void (*addDelayedCallback)(UA_EventLoop *el, UA_DelayedCallback *dc);
     void (*removeDelayedCallback)(UA_EventLoop *el, UA_DelayedCallback *dc);
@@ -208,6 +264,38 @@ struct UA_EventLoop {
     /* Stops the EventSource before deregistrering it */
     UA_StatusCode
     (*deregisterEventSource)(UA_EventLoop *el, UA_EventSource *es);
+
+    /* Statistics
+     * ~~~~~~~~~~
+     * Optional, can be NULL. */
+
+    void (*getStatistics)(UA_EventLoop *el, UA_EventLoopStatistics *stats);
+
+    /* Tracing
+     * ~~~~~~~
+     * Optional hooks to diagnose the timing of the EventLoop (e.g. the jitter
+     * of cyclic PubSub callbacks). They are set before the EventLoop is
+     * started and are called from within the run method. The hooks must not
+     * call into the EventLoop.
+     *
+     * The traceIteration hook is called at the end of every iteration.
+     *
+     * Timed, cyclic and delayed callbacks with a runtime of at least the
+     * slowCallbackThreshold (UA_DateTime units, zero disables the
+     * measurement) are counted and reported to the traceSlowCallback hook.
+     * The lag is the delay after the scheduled time (zero for delayed
+     * callbacks). Without a traceSlowCallback hook, the EventLoop logs a
+     * warning with the callback pointer (and its symbol name where the
+     * platform can resolve it). */
+
+    void *traceContext;
+    void (*traceIteration)(UA_EventLoop *el, void *traceContext,
+                           const UA_EventLoopIterationTrace *trace);
+    UA_DateTime slowCallbackThreshold;
+    void (*traceSlowCallback)(UA_EventLoop *el, void *traceContext,
+                              UA_EventLoopCallbackType type, UA_Callback callback,
+                              void *application, UA_DateTime runtime,
+                              UA_DateTime lag);
 };
 
 /**
@@ -374,6 +462,27 @@ struct UA_ConnectionManager {
     void
     (*freeNetworkBuffer)(UA_ConnectionManager *cm, uintptr_t connectionId,
                          UA_ByteString *buf);
+
+    /* Vectored Send
+     * ~~~~~~~~~~~~~
+     * Send several buffers at once (optional, can be NULL). The buffers are
+     * sent in order, same as with individual calls to sendWithConnection. But
+     * this requires fewer system calls. Every buffer is allocated with
+     * allocNetworkBuffer and all of them are released internally (also if
+     * sending fails). ConnectionManagers that hand out a static send buffer
+     * from allocNetworkBuffer cannot provide this method. */
+    UA_StatusCode
+    (*sendWithConnectionVector)(UA_ConnectionManager *cm, uintptr_t connectionId,
+                                const UA_KeyValueMap *params,
+                                UA_ByteString *bufs, size_t bufsSize);
+
+    /* Send Queue
+     * ~~~~~~~~~~
+     * Returns the number of bytes that were handed over for sending but are not
+     * yet written to the network (optional, can be NULL). The application can
+     * hold back further messages until the queue has drained. */
+    size_t
+    (*getSendQueueSize)(UA_ConnectionManager *cm, uintptr_t connectionId);
 };
 
 /**
@@ -461,6 +570,10 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  * socket is reused for each new connection. But the key-value parameters for
  * the first callback are different between server and client connections.
  *
+ * Sending never blocks the EventLoop. If the socket cannot take more data, the
+ * remaining buffers are queued for the connection and sent once the socket
+ * becomes writable. The size of the queue is returned by `getSendQueueSize`.
+ *
  * **Configuration parameters for the ConnectionManager (set before start)**
  *
  * 0:recv-bufsize [uint32]
@@ -472,6 +585,11 @@ UA_EventLoop_new_POSIX(const UA_Logger *logger);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:send-queue-limit [uint32]
+ *    Maximum number of bytes queued for a connection whose socket cannot take
+ *    more data. The connection is closed when the limit is exceeded (default:
+ *    0, no limit).
+ *
  * **Open Connection Parameters:**
  *
  * 0:address [string | array of string]
@@ -527,18 +645,28 @@ UA_ConnectionManager_new_POSIX_TCP(const UA_String eventSourceName);
  *    becomes an upper bound for the message size. If undefined a fresh buffer
  *    is allocated for every `allocNetworkBuffer` (default: no buffer).
  *
+ * 0:recv-batchsize [uint32]
+ *    Maximum number of datagrams that are received with a single syscall
+ *    (recvmmsg on Linux). The receive buffer is split evenly between the
+ *    datagrams of a batch. Every datagram is still delivered with an
+ *    individual callback. Ignored where recvmmsg is not available (default: 1,
+ *    maximum: 64).
+ *
  * **Open Connection Parameters:**
  *
  * 0:listen [boolean]
  *    Use the connection for listening or for sending (default: false)
  *
  * 0:address [string | string array]
- *    Hostname (or IPv4/v6 address) for sending or receiving. A scalar is
- *    required for sending. For listening a string array for the list-hostnames
- *    is possible as well (default: list on all hostnames).
+ *    Hostname (or IPv4/v6 address) for sending or receiving. For listening a
+ *    string array for the list-hostnames is possible as well (default: list on
+ *    all hostnames). A string array for sending opens a fan-out connection.
+ *    Every buffer is then sent to all addresses (with sendmmsg on Linux). The
+ *    addresses need to resolve to the same address family.
  *
- * 0:port [uint16]
- *    Port for sending or listening (required).
+ * 0:port [uint16 | uint16 array]
+ *    Port for sending or listening (required). Fan-out connections can use an
+ *    array with one port per address.
  *
  * 0:interface [string]
  *    Network interface for listening or sending (e.g. when using multicast
@@ -633,6 +761,15 @@ UA_ConnectionManager_new_POSIX_UDP(const UA_String eventSourceName);
  * 0:dei [bool]
  *    1-bit drop eligible indicator (optional for send connections).
  *
+ * 0:packet-ring [uint32]
+ *    Number of frames in a PACKET_MMAP ring that is shared with the kernel
+ *    (default: 0, no ring). Listen connections get an rx ring and frames are
+ *    delivered to the application without copying. Send connections get a tx
+ *    ring and `allocNetworkBuffer` hands out a frame of the ring, so that the
+ *    message is encoded in-place. Only one frame is handed out at a time,
+ *    further buffers are copied into the ring when they are sent. The frames
+ *    have a fixed size of 2kB, which limits the message size.
+ *
  * 0:validate [boolean]
  *    If true, the connection setup will act as a dry-run without actually
  *    creating any connection but solely validating the provided parameters
@@ -694,6 +831,17 @@ UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
  * 0:keep-alive [uint16]
  *   Number of seconds for the keep-alive (ping) (default: 400).
  *
+ * 0:send-buffer-size [uint32]
+ *    Memory budget in bytes for the send queue of the broker connection
+ *    (default: 65536, minimum: 1024). The queue contains the messages waiting
+ *    for the next flush and the QoS 1 messages waiting for the PUBACK.
+ *    Publishing fails with BadResourceUnavailable if the queue is full.
+ *
+ * 0:max-inflight [uint16]
+ *    Maximum number of published messages of the broker connection that are
+ *    queued or wait for the PUBACK (default: 64). Publishing fails with
+ *    BadResourceUnavailable if the window is full.
+ *
  * 0:validate [boolean]
  *    If true, the connection setup will act as a dry-run without actually
  *    creating any connection but solely validating the provided parameters
@@ -706,6 +854,15 @@ UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
  *    Subscribe to the topic (default: false). Otherwise it is only possible to
  *    publish on the topic. Subscribed topics can also be published to.
  *
+ * 0:qos [byte]
+ *    QoS level for publishing on the topic. Either 0 (at most once) or 1 (at
+ *    least once) (default: 0). QoS 1 messages are pipelined. The next messages
+ *    are sent without waiting for the PUBACK of the previous ones.
+ *
+ * The published messages are not sent right away. All messages queued for a
+ * broker connection are flushed with a single TCP send in the next iteration
+ * of the EventLoop.
+ *
  * **Connection Callback Parameters:**
  *
  * 0:topic [string]
@@ -720,6 +877,23 @@ UA_ConnectionManager_new_POSIX_Ethernet(const UA_String eventSourceName);
 UA_EXPORT UA_ConnectionManager *
 UA_ConnectionManager_new_MQTT(const UA_String eventSourceName);
 
+/* Statistics of the broker connection used by an MQTT connection. The
+ * connections to the same broker share the statistics. */
+typedef struct {
+    size_t inflight;      /* Sent with QoS 1 and waiting for the PUBACK */
+    size_t queued;        /* Waiting for the next flush */
+    size_t queueBytes;    /* Used memory of the send queue */
+    size_t queueCapacity; /* Memory budget of the send queue */
+    UA_UInt64 publishedMessages;
+    UA_UInt64 rejectedMessages; /* In-flight window or send queue full */
+    UA_UInt64 flushes;          /* Coalesced sends on the TCP connection */
+} UA_MQTTConnectionStatistics;
+
+UA_EXPORT UA_StatusCode
+UA_ConnectionManager_MQTT_getStatistics(UA_ConnectionManager *cm,
+                                        uintptr_t connectionId,
+                                        UA_MQTTConnectionStatistics *stats);
+
 /**
  * Signal Interrupt Manager
  * ~~~~~~~~~~~~~~~~~~~~~~~~
@@ -41,7 +41,8 @@ struct UA_HistoryDatabase {
 
     /* This function will be called when an event is triggered.
      * Use it to insert data into your event database.
-     * No default implementation is provided by UA_HistoryDatabase_default.
+     * UA_HistoryDatabase_default_events stores the events in a
+     * UA_HistoryEventBackend.
      *
      * server is the server this node lives in.
      * hdbContext is the context of the UA_HistoryDatabase.
@@ -112,8 +113,8 @@ struct UA_HistoryDatabase {
                UA_HistoryReadResponse *response,
                UA_HistoryModifiedData * const * const historyData);
 
-    /* No default implementation is provided by UA_HistoryDatabase_default
-     * for the following function */
+    /* UA_HistoryDatabase_default_events applies the EventFilter of the request
+     * to the stored events */
     void
     (*readEvent)(UA_Server *server,
                void *hdbContext,
@@ -128,8 +129,9 @@ struct UA_HistoryDatabase {
                UA_HistoryReadResponse *response,
                UA_HistoryEvent * const * const historyData);
 
-    /* No default implementation is provided by UA_HistoryDatabase_default
-     * for the following function */
+    /* UA_HistoryDatabase_default computes the Interpolative, Average,
+     * TimeAverage, Minimum, Maximum and Count aggregates from the raw values
+     * of backends implementing the low level interface */
     void
     (*readProcessed)(UA_Server *server,
                void *hdbContext,
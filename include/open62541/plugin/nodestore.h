@@ -25,6 +25,8 @@ _UA_BEGIN_DECLS
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 struct UA_MonitoredItem;
 typedef struct UA_MonitoredItem UA_MonitoredItem;
+
+struct UA_SamplingGroup;
 #endif
 
 /**
@@ -319,6 +321,12 @@ typedef struct {
     UA_NodePointer targetId;  /* Has to be the first entry */
     UA_UInt32 targetNameHash; /* Hash of the target's BrowseName. Set to zero
                                * if the target is remote. */
+
+    /* Direct pointer to the target node that can be cached by the Nodestore
+     * (see ``getNodeFromTarget``). The pointer is only valid for the Nodestore
+     * generation. It is set to NULL when the target is created or copied. */
+    UA_UInt32 targetGeneration;
+    const UA_NodeHead *targetNode;
 } UA_ReferenceTarget;
 
 typedef struct UA_ReferenceTargetTreeElem {
@@ -340,12 +348,17 @@ typedef struct UA_ReferenceTargetTreeElem {
  * reference target structure internally. The nodestore implementations may
  * switch internally when a node is updated.
  *
- * The recommendation is to switch to a tree once the number of refs > 8. */
+ * The recommendation is to switch to a tree once the number of refs is larger
+ * than UA_NODEREFERENCEKIND_TREETHRESHOLD. A tree element takes three times
+ * the memory of an array entry plus the allocation overhead. */
+#define UA_NODEREFERENCEKIND_TREETHRESHOLD 64
+
 typedef struct {
     union {
-        /* Organize the references in an array. Uses less memory, but incurs
-         * lookups in linear time. Recommended if the number of references is
-         * known to be small. */
+        /* Organize the references in a packed array. Uses less memory. The
+         * array is sorted by UA_NodePointer_order for lookups in logarithmic
+         * time. Insertions and removals are linear. Use UA_Node_addReference
+         * and UA_Node_deleteReference to keep the order. */
         UA_ReferenceTarget *array;
 
         /* Organize the references in a tree for fast lookup. Use
@@ -417,6 +430,7 @@ struct UA_NodeHead {
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     UA_MonitoredItem *monitoredItems; /* MonitoredItems for Events and immediate
                                        * DataChanges (no sampling interval). */
+    struct UA_SamplingGroup *samplingGroups; /* For event-driven sampling */
 #endif
 };
 
@@ -482,6 +496,9 @@ typedef struct {
      * memory being cleaned up. Don't forget to also set `value->hasValue` to
      * true to indicate the presence of a value.
      *
+     * Cyclic MonitoredItems that sample the same value share the read. Then
+     * the read is done with the sessionId of the admin session.
+     *
      * @param server The server executing the callback
      * @param sessionId The identifier of the session
      * @param sessionContext Additional data attached to the session in the
@@ -499,7 +516,9 @@ typedef struct {
      *        sourcetimestamp.
      * @return Returns a status code for logging. Error codes intended for the
      *         original caller are set in the value. If an error is returned,
-     *         then no releasing of the value is done
+     *         then no releasing of the value is done. With multithreading,
+     *         UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY defers the result
+     *         (see UA_Server_getAsyncReadId).
      */
     UA_StatusCode (*read)(UA_Server *server, const UA_NodeId *sessionId,
                           void *sessionContext, const UA_NodeId *nodeId,
@@ -649,12 +668,26 @@ typedef UA_StatusCode
                      const UA_Variant *input, size_t outputSize,
                      UA_Variant *output);
 
+/* Executes all calls of the same method that follow each other in a
+ * CallRequest at once. Every call was validated individually before. Calls
+ * whose result has a bad statusCode were rejected and have to be skipped. For
+ * the other calls, the outputArguments array of the result is allocated
+ * according to the OutputArguments definition and the statusCode has to be
+ * set. The calls contain the type-adjusted input arguments. */
+typedef void
+(*UA_MethodBatchCallback)(UA_Server *server, const UA_NodeId *sessionId,
+                          void *sessionContext, const UA_NodeId *methodId,
+                          void *methodContext, size_t callsSize,
+                          const UA_CallMethodRequest *calls,
+                          UA_CallMethodResult *results);
+
 typedef struct {
     UA_NodeHead head;
     UA_Boolean executable;
 
     /* Members specific to open62541 */
     UA_MethodCallback method;
+    UA_MethodBatchCallback methodBatch; /* Used instead of method if defined */
 #if UA_MULTITHREADING >= 100
     UA_Boolean async; /* Indicates an async method call */
 #endif
@@ -749,6 +782,44 @@ typedef union {
 
 typedef void (*UA_NodestoreVisitor)(void *visitorCtx, const UA_Node *node);
 
+/* Memory used by nodes. The node bytes contain the node structure and the
+ * per-node overhead of the Nodestore. The reference bytes contain the
+ * ReferenceKinds and the storage of the reference targets. */
+typedef struct {
+    size_t nodeCount;
+    size_t nodeBytes;
+    size_t referenceBytes;
+} UA_NodestoreMemoryUsage;
+
+typedef struct {
+    UA_NodestoreMemoryUsage total;
+
+    /* Indexed by the bit position of the NodeClass (Object = 0, Variable = 1,
+     * Method = 2, ..., View = 7) */
+    UA_NodestoreMemoryUsage nodeClasses[8];
+
+    /* Indexed by the namespace index */
+    size_t namespacesSize;
+    UA_NodestoreMemoryUsage *namespaces;
+
+    /* Number of reference targets per ReferenceTypeIndex. Use
+     * ``getReferenceTypeId`` to get the NodeId of the ReferenceType. */
+    size_t referenceTargets[UA_REFERENCETYPESET_MAX];
+
+    /* Memory reserved by the Nodestore, including free node slots and the
+     * lookup index. Zero if the nodes are allocated individually. */
+    size_t allocatedBytes;
+} UA_NodestoreStatistics;
+
+/* Account a node in the statistics. The nodeSize is the memory that the
+ * Nodestore uses for the node (and its entry). */
+UA_StatusCode UA_EXPORT
+UA_NodestoreStatistics_addNode(UA_NodestoreStatistics *stats,
+                               const UA_Node *node, size_t nodeSize);
+
+void UA_EXPORT
+UA_NodestoreStatistics_clear(UA_NodestoreStatistics *stats);
+
 typedef struct {
     /* Nodestore context and lifecycle */
     void *context;
@@ -789,8 +860,20 @@ typedef struct {
                                       UA_ReferenceTypeSet references,
                                       UA_BrowseDirection referenceDirections);
 
-    /* Release a node that has been retrieved with ``getNode`` or
-     * ``getNodeFromPtr``. */
+    /* Similar to ``getNodeFromPtr``. But the Nodestore can cache a direct
+     * pointer to the target node in the reference target. Then the lookup of
+     * the NodeId is skipped the next time. The Nodestore has to detect when the
+     * cached pointer is no longer valid, e.g. with a generation counter that
+     * is increased when nodes are removed or replaced. The reference target is
+     * modified only if the Nodestore does not allow concurrent reads.
+     * Optional, can be NULL. */
+    const UA_Node * (*getNodeFromTarget)(void *nsCtx, UA_ReferenceTarget *target,
+                                         UA_UInt32 attributeMask,
+                                         UA_ReferenceTypeSet references,
+                                         UA_BrowseDirection referenceDirections);
+
+    /* Release a node that has been retrieved with ``getNode``,
+     * ``getNodeFromPtr`` or ``getNodeFromTarget``. */
     void (*releaseNode)(void *nsCtx, const UA_Node *node);
 
     /* Returns an editable copy of a node (needs to be deleted with the
@@ -822,6 +905,16 @@ typedef struct {
     /* Execute a callback for every node in the nodestore. */
     void (*iterate)(void *nsCtx, UA_NodestoreVisitor visitor,
                     void *visitorCtx);
+
+    /* ``getNode``, ``getNodeFromPtr`` and ``releaseNode`` can be called from
+     * several threads at the same time (the modifying methods are always
+     * called exclusively). Then the server processes the read-only services
+     * (Read, Browse, ...) in parallel with multithreading enabled. */
+    UA_Boolean concurrentReads;
+
+    /* Memory statistics of the nodes (optional, can be NULL). The statistics
+     * are initialized by the caller and are added to. */
+    UA_StatusCode (*getStatistics)(void *nsCtx, UA_NodestoreStatistics *stats);
 } UA_Nodestore;
 
 /* Attributes must be of a matching type (VariableAttributes, ObjectAttributes,
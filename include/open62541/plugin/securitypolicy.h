@@ -144,6 +144,19 @@ typedef struct {
     /* The algorithm used to encrypt and decrypt messages. */
     UA_SecurityPolicyEncryptionAlgorithm encryptionAlgorithm;
 
+    /* Optional. Decrypts the chunk in place after the offset and verifies the
+     * signature in the same pass over the data. The signature is located at
+     * the end of the plaintext and covers the chunk up to the signature
+     * (including the unencrypted header before the offset). The chunk length
+     * is not changed. Only used by the symmetric module for messages that are
+     * signed and encrypted. If not set, the chunk is first decrypted and the
+     * signature is verified afterwards.
+     *
+     * @param channelContext the channelContext with the keys of the remote side.
+     * @param chunk the complete chunk including the header.
+     * @param offset the start of the encrypted part of the chunk. */
+    UA_StatusCode (*decryptAndVerify)(void *channelContext, UA_ByteString *chunk,
+                                      size_t offset) UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 } UA_SecurityPolicyCryptoModule;
 
 typedef struct {
@@ -370,6 +383,17 @@ struct UA_PubSubSecurityPolicy {
                        const UA_ByteString *nonce)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+    /* Optional (can be NULL). For counter-mode ciphers the keystream depends
+     * only on the keys and the message nonce. Compute the keystream for a
+     * message nonce ahead of time, outside the critical path of the send
+     * cycle. When the nonce is set later on, the encryption is reduced to an
+     * XOR with the precomputed keystream for the first length bytes. The
+     * precomputed keystream is discarded when the keys change. */
+    UA_StatusCode
+    (*precomputeKeystream)(void *wgContext,
+                           const UA_ByteString *nonce,
+                           size_t length);
+
     const UA_Logger *logger;
 
     /* Deletes the dynamic content of the policy */
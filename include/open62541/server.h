@@ -140,6 +140,9 @@ struct UA_ServerConfig {
      * See the section on :ref:`generic-types`. Examples for working with custom
      * data types are provided in ``/examples/custom_datatype/``. */
     const UA_DataTypeArray *customDataTypes;
+    UA_Boolean externalCustomDataTypes; /* Owned elsewhere (e.g. by a shared
+                                         * Nodestore image). Not cleaned up
+                                         * with the config. */
 
     /**
      * .. note:: See the section on :ref:`generic-types`. Examples for working
@@ -180,6 +183,31 @@ struct UA_ServerConfig {
                               * (default: 0 -> unbounded) */
     UA_Boolean tcpReuseAddr;
 
+#if UA_MULTITHREADING >= 100
+    /**
+     * With multithreading, the TCP connections can be sharded over additional
+     * network EventLoops. If set, the server sockets are opened on every
+     * network EventLoop instead of the main EventLoop (with SO_REUSEPORT, so
+     * the kernel distributes the incoming connections). Each network
+     * EventLoop is run by the application in its own thread, e.g. pinned to a
+     * core. The chunk decoding and decryption of a connection happen on its
+     * thread. The service processing takes the server lock. The asymmetric
+     * crypto runs under the shared side of the lock, concurrently on the
+     * network EventLoops: the certificate verification and decryption of the
+     * OPN requests, the OPN responses for new SecureChannels, the
+     * CreateSession signature and the ActivateSession signature checks and
+     * user token decryption. So the SecurityPolicies and the certificate
+     * verification must support concurrent use from the network EventLoops
+     * (with mbedTLS this requires MBEDTLS_THREADING_C).
+     *
+     * The network EventLoops are not deleted with the config. The server
+     * starts them if required. They must be kept running until
+     * ``UA_Server_run_shutdown`` has returned. Reverse connections are not
+     * available in this mode. */
+    UA_EventLoop **networkEventLoops;
+    size_t networkEventLoopsSize;
+#endif
+
     /**
      * Security and Encryption
      * ^^^^^^^^^^^^^^^^^^^^^^^ */
@@ -241,6 +269,12 @@ struct UA_ServerConfig {
     UA_UInt16 maxSecureChannels;
     UA_UInt32 maxSecurityTokenLifetime; /* in ms */
 
+    /* Throttle new connections during connect storms. At most this many
+     * connections are accepted per second (in bursts of up to the same
+     * number). Other new connections are closed right away. The established
+     * SecureChannels are not affected. 0 -> unlimited */
+    UA_UInt16 maxNewSecureChannelsPerSecond;
+
     /* Limits for Sessions */
     UA_UInt16 maxSessions;
     UA_Double maxSessionTimeout; /* in ms */
@@ -251,6 +285,13 @@ struct UA_ServerConfig {
     UA_UInt32 maxNodesPerMethodCall;
     UA_UInt32 maxNodesPerBrowse;
     UA_UInt32 maxNodesPerRegisterNodes;
+    UA_UInt32 maxRegisteredNodesPerSession; /* RegisterNodes returns numeric
+                                             * alias NodeIds for up to this
+                                             * many nodes per Session. Read
+                                             * and Write access them without
+                                             * the Nodestore lookup.
+                                             * 0 -> the NodeIds are returned
+                                             * unchanged. */
     UA_UInt32 maxNodesPerTranslateBrowsePathsToNodeIds;
     UA_UInt32 maxNodesPerNodeManagement;
     UA_UInt32 maxMonitoredItemsPerCall;
@@ -258,6 +299,53 @@ struct UA_ServerConfig {
     /* Limits for Requests */
     UA_UInt32 maxReferencesPerNode;
 
+    /* Upper limit for the memory (in bytes) used by the Browse
+     * ContinuationPoints of all Sessions. The least recently used
+     * ContinuationPoints are evicted to stay below the limit. A BrowseNext
+     * with an evicted ContinuationPoint returns
+     * BadContinuationPointInvalid. 0 -> unlimited */
+    UA_UInt32 maxBrowseContinuationPointsMemory;
+
+    /* Scheduling of bulk requests. Browse, TranslateBrowsePathsToNodeIds and
+     * HistoryRead requests with more operations than bulkRequestSliceSize are
+     * processed in slices of that many operations. The first slice is
+     * processed right away. The others are processed in the background
+     * between the iterations of the EventLoop. The Sessions take turns for
+     * their next slice. All other requests (e.g. Publish, Read and Write) are
+     * processed when they arrive. So they are not held up by bulk requests
+     * of other clients. The background processing takes up to
+     * bulkRequestTimeSlice (in ms) per EventLoop iteration, but at least one
+     * slice. bulkRequestSliceSize 0 -> disabled */
+    UA_UInt32 bulkRequestSliceSize;
+    UA_Double bulkRequestTimeSlice;
+
+    /* Number of slots in the cache for Browse results. A result is cached if
+     * it is complete in the first response (no ContinuationPoint). The cache
+     * is invalidated when references or nodes are added or removed and when a
+     * DisplayName is written. Call UA_Server_invalidateBrowseCache after
+     * changing the Nodestore directly. 0 -> disabled. */
+    UA_UInt32 browseCacheSize;
+
+    /* Number of slots in the cache for TranslateBrowsePathsToNodeIds results.
+     * Invalidated together with the Browse cache. 0 -> disabled. */
+    UA_UInt32 translateBrowsePathCacheSize;
+
+    /* Number of slots in the cache for GetEndpoints responses. The endpoints
+     * are kept in their binary encoding, keyed by the EndpointUrl and the
+     * ProfileUris of the request. The cache is invalidated when a certificate
+     * is updated. Call UA_Server_invalidateEndpointsCache after changing the
+     * endpoints, SecurityPolicies or ApplicationDescription in the config at
+     * runtime. 0 -> disabled. */
+    UA_UInt32 endpointsCacheSize;
+
+    /* Values written to a VariableNode (stored in the node) are converted into
+     * a shared payload with a reference count if their binary encoding has at
+     * least this many bytes (see UA_Variant_share). Then reading the value,
+     * sampling it for MonitoredItems and writing it into the history only
+     * increase the reference count instead of copying the data. Writes with
+     * an IndexRange are not shared. 0 -> disabled. */
+    UA_UInt32 sharedValueMinSize;
+
     /**
      * Async Operations
      * ^^^^^^^^^^^^^^^^
@@ -267,6 +355,28 @@ struct UA_ServerConfig {
     size_t maxAsyncOperationQueueSize; /* 0 => unlimited */
     /* Notify workers when an async operation was enqueued */
     UA_Server_AsyncOperationNotifyCallback asyncOperationNotifyCallback;
+    /* Number of worker threads started by the server to process the async
+     * operations. 0 => the application takes the operations with
+     * UA_Server_getAsyncOperationNonBlocking. */
+    UA_UInt16 asyncOperationWorkers;
+
+    /* Number of worker threads that expand the large levels of
+     * UA_Server_browseRecursive in parallel. The results are then returned in
+     * breadth-first order. This requires a Nodestore that can be read from
+     * several threads at once, such as the default HashMap Nodestore with
+     * UA_ENABLE_IMMUTABLE_NODES. Ignored without UA_ENABLE_IMMUTABLE_NODES.
+     * 0 => disabled */
+    UA_UInt16 browseRecursiveWorkers;
+
+    /* Admission control for the requests that can be answered asynchronously
+     * (Read and Call). New requests are rejected with Bad_TooManyOperations
+     * while the Session has maxPendingRequestsPerSession requests in flight.
+     * They are rejected with Bad_ResourceUnavailable while the server has
+     * maxPendingRequests in flight overall. With maxPendingRequests set, also
+     * while the queue of async operations is full (maxAsyncOperationQueueSize).
+     * So the latency remains bounded under overload. 0 => unlimited */
+    UA_UInt32 maxPendingRequestsPerSession;
+    UA_UInt32 maxPendingRequests;
 #endif
 
     /**
@@ -308,6 +418,23 @@ struct UA_ServerConfig {
     UA_UInt32 maxRetransmissionQueueSize; /* 0 -> unlimited size */
 # ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     UA_UInt32 maxEventsPerNode; /* 0 -> unlimited size */
+
+    /* Node and reference changes are collected for the interval (in ms) and
+     * then emitted as a single GeneralModelChangeEvent from the Server object.
+     * The NodeVersion properties of the affected nodes are incremented once
+     * per interval. With more than maxModelChangesPerEvent affected nodes, a
+     * BaseModelChangeEvent without the list of changes is emitted instead.
+     * 0 -> no ModelChangeEvents / no limit. */
+    UA_Double modelChangeEventInterval;
+    UA_UInt32 maxModelChangesPerEvent;
+# endif
+# ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    /* A ConditionRefresh adds at most this many retained Conditions per
+     * MonitoredItem and publish cycle. It then resumes in the next publish
+     * cycle. The RefreshEndEvent follows after the last Condition. The chunks
+     * are also limited by the free space in the queue of the MonitoredItem.
+     * 0 -> all retained Conditions are added at once. */
+    UA_UInt32 maxConditionRefreshPerPublish;
 # endif
 
     /* Limits for MonitoredItems */
@@ -319,6 +446,24 @@ struct UA_ServerConfig {
     /* Limits for PublishRequests */
     UA_UInt32 maxPublishReqPerSession;
 
+    /* Event-driven sampling. Cyclic MonitoredItems on the Value attribute
+     * sample only after the value was written or after
+     * UA_Server_notifyValueChanged was called for the node. Enable this only
+     * if all DataSources and external value backends signal their changes. */
+    UA_Boolean eventDrivenSampling;
+
+    /* MonitoredItems keep only a 64-bit hash of the last sampled value for
+     * the change detection of arrays and structures. This saves the copy of
+     * large values. Values with an absolute deadband filter are always kept. */
+    UA_Boolean hashedChangeDetection;
+
+    /* Samples of DataSource variables with a value cache (see
+     * UA_Server_setVariableNode_dataSourceCache) take the cached value if it
+     * is not older than this (in ms). So MonitoredItems that sample faster
+     * than the source changes don't call the read callback every time.
+     * 0 -> always call the read callback. */
+    UA_Double samplingCacheMaxAge;
+
     /* Register MonitoredItem in Userland
      *
      * @param server Allows the access to the server object
@@ -382,6 +527,20 @@ struct UA_ServerConfig {
      * ^^^^^^^^^^^^^^^ */
     UA_UInt32 reverseReconnectInterval; /* Default is 15000 ms */
 
+    /**
+     * Statistics
+     * ^^^^^^^^^^
+     * Collect latency histograms for every service (see
+     * :ref:`UA_Server_getServiceStatistics<statistics>`). This takes a few
+     * additional clock readings per request and about 1KB of memory per
+     * service. Evaluated when the server is started. */
+    UA_Boolean serviceStatistics;
+
+    /* Measure the CPU time spent in the service processing for each Session
+     * (see the ``serviceCpuTime`` session attribute). This takes two readings
+     * of the per-thread CPU clock per request. */
+    UA_Boolean sessionCpuTime;
+
     /**
      * Certificate Password Callback
      * ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ */
@@ -555,6 +714,25 @@ UA_Server_removeCallback(UA_Server *server, UA_UInt64 callbackId);
 UA_EXPORT UA_StatusCode UA_THREADSAFE
 UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId);
 
+/* Drop the AccessControl decisions cached by the server (if enabled with
+ * ``cacheDecisions`` in the AccessControl plugin). A NULL sessionId matches
+ * all sessions and a NULL nodeId matches all nodes. Call this when the rights
+ * of a user or the context of a node change. */
+void UA_EXPORT UA_THREADSAFE
+UA_Server_invalidateAccessCache(UA_Server *server, const UA_NodeId *sessionId,
+                                const UA_NodeId *nodeId);
+
+/* Drop the Browse and TranslateBrowsePath results cached by the server (if
+ * enabled with ``browseCacheSize`` and ``translateBrowsePathCacheSize`` in the
+ * server config). */
+void UA_EXPORT UA_THREADSAFE
+UA_Server_invalidateBrowseCache(UA_Server *server);
+
+/* Drop the GetEndpoints responses cached by the server (if enabled with
+ * ``endpointsCacheSize`` in the server config). */
+void UA_EXPORT UA_THREADSAFE
+UA_Server_invalidateEndpointsCache(UA_Server *server);
+
 /**
  * Session attributes: Besides the user-definable session context pointer (set
  * by the AccessControl plugin when the Session is created), a session carries
@@ -567,7 +745,16 @@ UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId);
  * - 0:localeIds [UA_String]: List of preferred languages (read-only)
  * - 0:clientDescription [UA_ApplicationDescription]: Client description (read-only)
  * - 0:sessionName [String] Client-defined name of the session (read-only)
- * - 0:clientUserId [String] User identifier used to activate the session (read-only) */
+ * - 0:clientUserId [String] User identifier used to activate the session (read-only)
+ *
+ * The resource usage of the session is also available as (read-only)
+ * attributes. They can be used to throttle or disconnect misbehaving clients.
+ *
+ * - 0:serviceCpuTime [UInt64] CPU time of the service processing in 100ns
+ *   ticks (only if ``sessionCpuTime`` is enabled in the server config)
+ * - 0:bytesDecoded [UInt64] Size of the decoded service requests
+ * - 0:bytesEncoded [UInt64] Size of the encoded service and publish responses
+ * - 0:notifications [UInt64] Notifications generated by the MonitoredItems */
 
 /* Returns a shallow copy of the attribute. Don't _clear or _delete the value
  * variant. Don't use the value once the Session could be already closed in the
@@ -885,6 +1072,17 @@ UA_Server_writeDataValue(UA_Server *server, const UA_NodeId nodeId,
                              &UA_TYPES[UA_TYPES_DATAVALUE], &value);
 })
 
+/**
+ * Writes the DataValues of many variable/variableType nodes. This is
+ * equivalent to calling UA_Server_writeDataValue for each entry. But the
+ * server lock is taken only once for the entire batch. The results array is
+ * optional. If defined, it has to have the same size and receives the
+ * StatusCode of each write. The first bad StatusCode is returned (or
+ * ``UA_STATUSCODE_GOOD``). */
+UA_EXPORT UA_THREADSAFE UA_StatusCode
+UA_Server_writeValues(UA_Server *server, size_t size, const UA_NodeId *nodeIds,
+                      const UA_DataValue *values, UA_StatusCode *results);
+
 UA_INLINABLE( UA_THREADSAFE UA_StatusCode
 UA_Server_writeDataType(UA_Server *server, const UA_NodeId nodeId,
                         const UA_NodeId dataType) ,{
@@ -968,7 +1166,10 @@ UA_Server_browseNext(UA_Server *server, UA_Boolean releaseContinuationPoint,
  * BrowseDescription. However, child nodes are still recursed into if the
  * NodeClass does not match. So it is possible, for example, to get all
  * VariableNodes below a certain ObjectNode, with additional objects in the
- * hierarchy below. */
+ * hierarchy below.
+ *
+ * With the browseRecursiveWorkers server setting, the tree is walked level by
+ * level and the results are in breadth-first order. Otherwise depth-first. */
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
                           size_t *resultsSize, UA_ExpandedNodeId **results);
@@ -1137,6 +1338,17 @@ UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                                      const UA_DataSource dataSource);
 
+/* Keep the last value read from the DataSource in a cache. A Read with a
+ * maxAge (in ms) returns the cached value if it is not older than the maxAge.
+ * A maxAge of zero always calls the read callback. The cached value is then
+ * renewed. MonitoredItems sample with the ``samplingCacheMaxAge`` from the
+ * server config. Only reads of the full value (without an IndexRange) renew
+ * the cache. Writing to the variable and UA_Server_notifyValueChanged drop the
+ * cached value. The hits and misses are counted in the server statistics. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setVariableNode_dataSourceCache(UA_Server *server, const UA_NodeId nodeId,
+                                          UA_Boolean enabled);
+
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_setVariableNode_valueCallback(UA_Server *server,
                                         const UA_NodeId nodeId,
@@ -1168,6 +1380,13 @@ UA_Server_setVariableNode_valueBackend(UA_Server *server,
 UA_StatusCode UA_EXPORT UA_THREADSAFE
 UA_Server_deleteMonitoredItem(UA_Server *server, UA_UInt32 monitoredItemId);
 
+/* Signal that the value of a node has changed without a write. For example
+ * when a DataSource has new data. MonitoredItems with a zero sampling
+ * interval are sampled right away. With ``eventDrivenSampling`` in the server
+ * config, the cyclic MonitoredItems sample the node at their next interval. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_notifyValueChanged(UA_Server *server, const UA_NodeId nodeId);
+
 typedef void (*UA_Server_DataChangeNotificationCallback)
     (UA_Server *server, UA_UInt32 monitoredItemId, void *monitoredItemContext,
      const UA_NodeId *nodeId, void *nodeContext, UA_UInt32 attributeId,
@@ -1200,6 +1419,24 @@ UA_Server_createDataChangeMonitoredItem(UA_Server *server,
           void *monitoredItemContext,
           UA_Server_DataChangeNotificationCallback callback);
 
+/* Create a local MonitoredItem with a direct callback. The callback is called
+ * right away from within the sampling (or from within the Write service for a
+ * sampling interval of zero) instead of from a delayed callback. No
+ * Notifications are queued and the value is not copied. The value is borrowed
+ * and can not be used after the callback returns.
+ *
+ * The callback is executed while the server is locked. It must not call any
+ * method of the server. Use this for internal components that process a high
+ * rate of value changes. The MonitoringMode must be Reporting for the callback
+ * to be called. Otherwise the parameters are identical to
+ * UA_Server_createDataChangeMonitoredItem. */
+UA_MonitoredItemCreateResult UA_EXPORT UA_THREADSAFE
+UA_Server_createDataChangeMonitoredItemDirect(UA_Server *server,
+          UA_TimestampsToReturn timestampsToReturn,
+          const UA_MonitoredItemCreateRequest item,
+          void *monitoredItemContext,
+          UA_Server_DataChangeNotificationCallback callback);
+
 /**
  * See the section on :ref`events` for how to emit events in the server.
  *
@@ -1296,6 +1533,15 @@ UA_Server_getMethodNodeCallback(UA_Server *server,
                                 const UA_NodeId methodNodeId,
                                 UA_MethodCallback *outMethodCallback);
 
+/* Set a callback that receives all consecutive calls of the method in a
+ * CallRequest at once. Clients that call the same method many times in one
+ * request then cause only one invocation. The batch callback takes precedence
+ * over the regular method callback. Set to NULL to disable. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setMethodNodeBatchCallback(UA_Server *server,
+                                     const UA_NodeId methodNodeId,
+                                     UA_MethodBatchCallback batchCallback);
+
 UA_CallMethodResult UA_EXPORT UA_THREADSAFE
 UA_Server_call(UA_Server *server, const UA_CallMethodRequest *request);
 #endif
@@ -1671,6 +1917,47 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
                        const UA_NodeId originId, UA_ByteString *outEventId,
                        const UA_Boolean deleteEventNode);
 
+/* Triggers a transient event that has no node representation. This avoids
+ * adding and removing nodes for each event. The EventFilters resolve the
+ * select- and where-clauses directly from the map of event fields. The keys
+ * are the BrowseNames of the fields, e.g. 0:Severity and 0:Message. Only
+ * fields with a single-element browse path (the properties of the event) can
+ * be selected. Fields that are not defined in the map are empty.
+ *
+ * The EventId, EventType, SourceNode and ReceiveTime are set automatically.
+ * The Time is set to the current time if it is not defined in the map.
+ * Condition events need a node representation and cannot be transient.
+ *
+ * @param server The server object
+ * @param eventType The type of the event (a subtype of BaseEventType)
+ * @param originId The node from which the event is emitted
+ * @param eventFields The fields of the event. Can be NULL.
+ * @param outEventId the EventId of the new event. Can be NULL.
+ * @return The StatusCode of the UA_Server_triggerEventFields method */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId originId,
+                             const UA_KeyValueMap *eventFields,
+                             UA_ByteString *outEventId);
+
+/* Applies an EventFilter to an event given by the map of its fields, e.g. a
+ * stored historical event. The fields are resolved as for transient events
+ * (see UA_Server_triggerEventFields). The values are read with the rights of
+ * the admin session.
+ *
+ * @param server The server object
+ * @param eventType The type of the event (a subtype of BaseEventType)
+ * @param eventFields The fields of the event. Can be NULL.
+ * @param filter The EventFilter with the select- and where-clauses
+ * @param efl The selected fields (copies) if the event matches
+ * @return UA_STATUSCODE_GOOD if the event matches the where-clause,
+ *         UA_STATUSCODE_BADNOMATCH if not, or an error code */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_filterEventFields(UA_Server *server, const UA_NodeId eventType,
+                            const UA_KeyValueMap *eventFields,
+                            const UA_EventFilter *filter,
+                            UA_EventFieldList *efl);
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
 /**
@@ -1928,7 +2215,13 @@ UA_Server_getNamespaceByIndex(UA_Server *server, const size_t namespaceIndex,
  * the usage.
  *
  * Note that the operation can time out (see the asyncOperationTimeout setting in
- * the server config) also when it has been retrieved by the worker. */
+ * the server config) also when it has been retrieved by the worker.
+ *
+ * Instead of running its own workers, the application can let the server start
+ * a pool of worker threads (see the asyncOperationWorkers setting in the server
+ * config). The workers wait for new operations, execute the method callback
+ * (with the admin Session, as in UA_Server_call) and send out the response as
+ * soon as all operations of a request are done. */
 
 #if UA_MULTITHREADING >= 100
 
@@ -1939,9 +2232,12 @@ UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id,
 
 typedef enum {
     UA_ASYNCOPERATIONTYPE_INVALID, /* 0, the default */
-    UA_ASYNCOPERATIONTYPE_CALL
+    UA_ASYNCOPERATIONTYPE_CALL,
     /* UA_ASYNCOPERATIONTYPE_READ, */
     /* UA_ASYNCOPERATIONTYPE_WRITE, */
+    UA_ASYNCOPERATIONTYPE_READ_DATASOURCE /* Completed with
+                                           * UA_Server_setAsyncReadResult. Not
+                                           * handed to the workers. */
 } UA_AsyncOperationType;
 
 typedef union {
@@ -1988,22 +2284,374 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
                                   const UA_AsyncOperationResponse *response,
                                   void *context);
 
+/* Async DataSource reads
+ *
+ * The read callback of a DataSource can return
+ * UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY without setting the value, for
+ * example to wait for a slow fieldbus. Before returning, the callback gets the
+ * id of the operation with UA_Server_getAsyncReadId. The result is submitted
+ * later with UA_Server_setAsyncReadResult. The ReadResponse is sent when the
+ * last async operation of the request is done. The synchronous results of
+ * the same request are kept until then. The operation can time out (see
+ * asyncOperationTimeout) and be cancelled.
+ *
+ * Only Read requests from clients wait for the async completion. Local reads
+ * and the sampling of MonitoredItems return the status
+ * GoodCompletesAsynchronously without a value.
+ *
+ * The result can be submitted as soon as the id is known, also before the
+ * read callback has returned.
+ *
+ * @param server The server object
+ * @param value The DataValue pointer that was handed to the read callback.
+ *        It is only used to look up the operation and not dereferenced.
+ * @return The id of the operation. Zero if the read cannot complete
+ *         asynchronously. For example for a local read or if the queue of
+ *         async operations is full. */
+UA_UInt32 UA_EXPORT UA_THREADSAFE
+UA_Server_getAsyncReadId(UA_Server *server, const UA_DataValue *value);
+
+/* Submit the result of an async DataSource read
+ *
+ * @param server The server object
+ * @param operationId The id from UA_Server_getAsyncReadId
+ * @param result The result is copied
+ * @return BadNotFound if the operation has timed out or was cancelled */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_setAsyncReadResult(UA_Server *server, UA_UInt32 operationId,
+                             const UA_DataValue *result);
+
 #endif /* !UA_MULTITHREADING >= 100 */
 
 /**
+ * .. _statistics:
+ *
  * Statistics
  * ----------
  * Statistic counters keeping track of the current state of the stack. Counters
  * are structured per OPC UA communication layer. */
 
+#if UA_MULTITHREADING >= 100
+/* Requests are processed under the service lock. Read, Browse, BrowseNext and
+ * TranslateBrowsePathsToNodeIds of an activated Session take the shared side
+ * if the Nodestore supports concurrent reads. All other requests take the
+ * exclusive side. The hold times are in UA_DateTime units (100ns). */
+typedef struct {
+    UA_UInt64 sharedCount;
+    UA_UInt64 sharedHoldTime; /* cumulated */
+    UA_UInt64 sharedMaxHoldTime;
+    UA_UInt64 exclusiveCount;
+    UA_UInt64 exclusiveHoldTime; /* cumulated */
+    UA_UInt64 exclusiveMaxHoldTime;
+} UA_ServiceLockStatistics;
+
+/* Async operations that were returned by a worker. The queue time is from the
+ * enqueue to the dispatch to a worker. The processing time is from the
+ * dispatch until the result is returned. In UA_DateTime units (100ns). */
+typedef struct {
+    UA_UInt64 operationCount;
+    UA_UInt64 timeoutCount;
+    UA_UInt64 queueTime; /* cumulated */
+    UA_UInt64 maxQueueTime;
+    UA_UInt64 processingTime; /* cumulated */
+    UA_UInt64 maxProcessingTime;
+} UA_AsyncOperationStatistics;
+#endif
+
+/* Counters for the internal hot paths. Rates (e.g. sampling callbacks per
+ * second) are computed from the difference of two readings. */
+typedef struct {
+    UA_UInt64 chunkCount;            /* Received chunks */
+    UA_UInt64 messageCount;          /* Received messages (assembled from the
+                                      * chunks) */
+    UA_UInt64 samplingCount;         /* Values sampled for MonitoredItems (a
+                                      * SamplingGroup samples once for all
+                                      * its MonitoredItems) */
+    UA_UInt64 notificationCount;     /* Notifications enqueued in
+                                      * MonitoredItems */
+    UA_UInt64 notificationDropCount; /* Notifications removed because the
+                                      * MonitoredItem queue was full */
+    UA_UInt64 dataSourceCacheHitCount;  /* DataSource reads with a maxAge
+                                         * that took the cached value */
+    UA_UInt64 dataSourceCacheMissCount; /* DataSource reads with a maxAge
+                                         * that called the read callback */
+} UA_ServerCounterStatistics;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+/* Current size of the Subscriptions and their queues */
+typedef struct {
+    size_t currentSubscriptionCount;
+    size_t currentMonitoredItemCount;
+    size_t lateSubscriptionCount;
+    size_t notificationQueueSize;   /* Notifications waiting to be published */
+    size_t retransmissionQueueSize; /* Sent NotificationMessages kept for
+                                     * republishing */
+    size_t publishRequestQueueSize; /* PublishRequests waiting in the
+                                     * Sessions */
+} UA_SubscriptionStatistics;
+#endif
+
 typedef struct {
    UA_SecureChannelStatistics scs;
    UA_SessionStatistics ss;
+#if UA_MULTITHREADING >= 100
+   UA_ServiceLockStatistics sls;
+   UA_AsyncOperationStatistics aos;
+#endif
+   UA_ServerCounterStatistics cs;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+   UA_SubscriptionStatistics subs;
+#endif
 } UA_ServerStatistics;
 
 UA_ServerStatistics UA_EXPORT
 UA_Server_getStatistics(UA_Server *server);
 
+/* Histogram with logarithmic buckets for durations in UA_DateTime units
+ * (100ns). Bucket i counts the durations d with 2^i <= d < 2^(i+1). The first
+ * bucket also counts zero durations and the last bucket all longer
+ * durations. */
+#define UA_LATENCYHISTOGRAM_BUCKETS 32
+
+typedef struct {
+    UA_UInt64 count;
+    UA_UInt64 sum;
+    UA_UInt64 max;
+    UA_UInt64 buckets[UA_LATENCYHISTOGRAM_BUCKETS];
+} UA_LatencyHistogram;
+
+/* Returns an upper bound for the quantile q (0 < q <= 1) of the durations in
+ * the histogram. For example q = 0.99 for the 99th percentile. The result is
+ * the upper limit of the bucket that contains the quantile, capped at the
+ * maximum duration. Returns zero for an empty histogram. */
+UA_UInt64 UA_EXPORT
+UA_LatencyHistogram_quantile(const UA_LatencyHistogram *h, UA_Double q);
+
+/* Timing of the requests for one service. The phases are measured for every
+ * request received over a SecureChannel. The lockWaitTime is the time until
+ * the service lock was taken. The sendTime includes the encoding of the
+ * response. Asynchronous responses are not included in the sendTime. */
+typedef struct {
+    UA_UInt64 requestCount;
+    UA_UInt64 faultCount; /* Bad serviceResult in the response */
+    UA_LatencyHistogram decodeTime;
+    UA_LatencyHistogram lockWaitTime;
+    UA_LatencyHistogram executionTime;
+    UA_LatencyHistogram sendTime;
+} UA_ServiceStatistics;
+
+/* Get the statistics of the service with the given request type (e.g.
+ * &UA_TYPES[UA_TYPES_READREQUEST]). Returns UA_STATUSCODE_BADNOTSUPPORTED if
+ * the serviceStatistics are not enabled in the server configuration and
+ * UA_STATUSCODE_BADSERVICEUNSUPPORTED if the service is unknown. */
+UA_StatusCode UA_EXPORT
+UA_Server_getServiceStatistics(UA_Server *server,
+                               const UA_DataType *requestType,
+                               UA_ServiceStatistics *stats);
+
+/* Memory used for the references of the nodes in the Nodestore. The bytes
+ * count the ReferenceKinds and the storage of the targets (array entries or
+ * tree elements). Not included are non-numeric NodeIds of the targets that are
+ * allocated separately. */
+typedef struct {
+    size_t nodeCount;
+    size_t referenceKindCount;
+    size_t targetCount;
+    size_t treeTargetCount; /* Targets stored in a tree */
+    size_t referenceBytes;
+} UA_ReferenceStatistics;
+
+/* Iterates over the Nodestore. The statistics are reported per NodeClass. The
+ * array index is the bit position of the NodeClass (Object = 0, Variable = 1,
+ * Method = 2, ..., View = 7). */
+void UA_EXPORT
+UA_Server_getReferenceStatistics(UA_Server *server,
+                                 UA_ReferenceStatistics stats[8]);
+
+/* Memory statistics of the Nodestore per namespace, NodeClass and
+ * ReferenceType. Returns UA_STATUSCODE_BADNOTSUPPORTED if the Nodestore does
+ * not implement the ``getStatistics`` hook. Clean up the result with
+ * UA_NodestoreStatistics_clear. */
+UA_StatusCode UA_EXPORT
+UA_Server_getNodestoreStatistics(UA_Server *server,
+                                 UA_NodestoreStatistics *stats);
+
+#ifdef UA_DEBUG_ALLOC_PROFILE
+/* Allocation profiling (build option UA_DEBUG_ALLOC_PROFILE). The calls of
+ * UA_malloc, UA_calloc and UA_realloc are counted with the requested bytes
+ * per call site and per processing phase. The phase is set by the server while
+ * it decodes a request, executes a service, encodes the response, samples
+ * MonitoredItems and publishes (Subscriptions and PubSub). Nested phases count
+ * for the innermost phase. The counters are global for the process and are
+ * shared between all server instances. */
+typedef enum {
+    UA_ALLOCPHASE_OTHER = 0,
+    UA_ALLOCPHASE_DECODE,
+    UA_ALLOCPHASE_SERVICE,
+    UA_ALLOCPHASE_ENCODE,
+    UA_ALLOCPHASE_SAMPLING,
+    UA_ALLOCPHASE_PUBLISH
+} UA_AllocPhase;
+
+#define UA_ALLOCPHASES 6
+
+typedef struct {
+    UA_UInt64 count;
+    UA_UInt64 bytes;
+} UA_AllocCounter;
+
+typedef struct {
+    const char *file; /* Static string from __FILE__ */
+    UA_UInt32 line;
+    UA_AllocCounter counter;
+} UA_AllocSiteStatistics;
+
+typedef struct {
+    UA_AllocCounter phases[UA_ALLOCPHASES]; /* Indexed by UA_AllocPhase */
+    UA_AllocCounter untracked; /* Call sites that did not fit into the table */
+    size_t sitesSize;
+    UA_AllocSiteStatistics *sites; /* Sorted by count, descending */
+} UA_AllocStatistics;
+
+/* Clean up the result with UA_AllocStatistics_clear */
+UA_StatusCode UA_EXPORT
+UA_Server_getAllocStatistics(UA_Server *server, UA_AllocStatistics *stats);
+
+void UA_EXPORT
+UA_AllocStatistics_clear(UA_AllocStatistics *stats);
+
+/* Set all counters to zero. For example after the startup, so that only the
+ * allocations of the steady state are counted. */
+void UA_EXPORT
+UA_Server_resetAllocStatistics(UA_Server *server);
+#endif
+
+/**
+ * Address Space Snapshot
+ * ----------------------
+ * A snapshot contains all nodes and references of the Nodestore in a compact
+ * binary format. Restoring a snapshot bulk-inserts the nodes without calling
+ * the constructors and without the consistency checks of the AddNodes service
+ * (similar to the bootstrapping of namespace zero). This is much faster than
+ * loading a large information model from a nodeset.
+ *
+ * Only the standard attributes are saved. Node contexts, method callbacks,
+ * type lifecycles and value callbacks are not part of the snapshot. Variables
+ * with a DataSource or an external value backend are saved without the value.
+ * The namespaces of the snapshot are added to the server and the namespace
+ * indices of NodeIds and BrowseNames are adjusted. NodeIds inside the values
+ * are not adjusted.
+ *
+ * Nodes that already exist in the server are replaced. They keep their
+ * context, callbacks and value source. So the snapshot can be loaded after the
+ * application has set up its callbacks. Loading is not transactional, the
+ * address space can be partially restored if an error occurs. */
+
+/* Encode the address space. The snapshot is allocated and has to be freed
+ * with UA_ByteString_clear. */
+UA_StatusCode UA_EXPORT
+UA_Server_saveSnapshot(UA_Server *server, UA_ByteString *snapshot);
+
+UA_StatusCode UA_EXPORT
+UA_Server_loadSnapshot(UA_Server *server, const UA_ByteString *snapshot);
+
+/**
+ * Nodeset Tables
+ * --------------
+ * The ``open62541_tables`` backend of the nodeset compiler generates a nodeset
+ * as constant tables instead of one function per node. The tables are placed
+ * in read-only memory and are loaded by a single loop in the server. This
+ * keeps the binary small for large nodesets such as namespace zero.
+ *
+ * The loader adds the nodes in the order of the table with the same semantics
+ * as the generated functions: The nodes are added with
+ * ``UA_Server_addNode_begin``, their references are added, and finally all
+ * nodes are finished in reverse order. ReferenceTypes are finished right away.
+ *
+ * NodeIds are stored once in a separate table and referred to by their index.
+ * Index zero is the null NodeId. The namespace indices in the tables (also
+ * inside the values) refer to the namespace mapping that is passed to the
+ * loader. Values are stored in the binary encoding of their DataType. */
+
+typedef struct {
+    UA_UInt16 namespaceIndex; /* Index in the namespace mapping */
+    UA_UInt32 numeric;
+    const char *string;       /* String identifier if not NULL */
+} UA_NodesetTableNodeId;
+
+typedef struct {
+    UA_UInt32 referenceTypeId; /* Index in the NodeId table */
+    UA_UInt32 targetId;        /* Index in the NodeId table */
+    UA_Boolean isForward;
+} UA_NodesetTableReference;
+
+#define UA_NODESETTABLE_ISABSTRACT      0x01
+#define UA_NODESETTABLE_SYMMETRIC       0x02
+#define UA_NODESETTABLE_EXECUTABLE      0x04
+#define UA_NODESETTABLE_USEREXECUTABLE  0x08
+#define UA_NODESETTABLE_HISTORIZING     0x10
+#define UA_NODESETTABLE_CONTAINSNOLOOPS 0x20
+#define UA_NODESETTABLE_METHODCALLS     0x40 /* Skipped without method calls */
+#define UA_NODESETTABLE_VALUEDIMENSIONS 0x80 /* ArrayDimensions of the value */
+
+typedef struct {
+    UA_NodeClass nodeClass;
+    UA_Byte flags;
+    UA_Byte eventNotifier;
+    UA_Byte accessLevel;
+    UA_Byte userAccessLevel;
+
+    /* Indices in the NodeId table */
+    UA_UInt32 nodeId;
+    UA_UInt32 parentNodeId;
+    UA_UInt32 referenceTypeId;
+    UA_UInt32 typeDefinition;
+    UA_UInt32 dataType;
+
+    /* Strings are NULL if not defined */
+    UA_UInt16 browseNameNamespace;
+    const char *browseName;
+    const char *displayNameLocale;
+    const char *displayName;
+    const char *descriptionLocale;
+    const char *description;
+    const char *inverseName;
+
+    UA_UInt32 writeMask;
+    UA_UInt32 userWriteMask;
+    UA_Double minimumSamplingInterval;
+    UA_Int32 valueRank;
+    UA_UInt32 arrayDimensionsSize;
+    const UA_UInt32 *arrayDimensions;
+
+    /* The value is not set if the type is NULL. The array length is -1 for
+     * scalars. The encoded elements are concatenated. */
+    const UA_DataType *valueType;
+    UA_Int32 valueArrayLength;
+    UA_UInt32 valueSize;
+    const UA_Byte *value;
+
+    /* The references of the node follow the references of the previous node
+     * in the reference table */
+    UA_UInt32 referencesSize;
+} UA_NodesetTableNode;
+
+typedef struct {
+    size_t nodeIdsSize;
+    const UA_NodesetTableNodeId *nodeIds;
+    size_t nodesSize;
+    const UA_NodesetTableNode *nodes;
+    size_t referencesSize;
+    const UA_NodesetTableReference *references;
+} UA_NodesetTable;
+
+/* Add the nodes of the table. The namespaces array maps the namespace indices
+ * of the table to the namespace indices of the server. All nodes are
+ * processed, the StatusCodes of the individual operations are combined. */
+UA_StatusCode UA_EXPORT UA_THREADSAFE
+UA_Server_loadNodesetTable(UA_Server *server, const UA_NodesetTable *table,
+                           const UA_UInt16 *namespaces, size_t namespacesSize);
+
 /**
  * Reverse Connect
  * ---------------
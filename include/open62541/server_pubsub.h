@@ -229,6 +229,14 @@ struct UA_PubSubConfiguration {
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     UA_Boolean enableInformationModelMethods;
+
+    /* Add the nodes of DataSetWriters and DataSetReaders to the information
+     * model only on demand. Their NodeId is reserved when they are created.
+     * But the nodes are only added when the parent WriterGroup/ReaderGroup (or
+     * the component itself) is first browsed with the Browse or the
+     * TranslateBrowsePathsToNodeIds service. This makes adding many readers and
+     * writers much cheaper if the information model is rarely inspected. */
+    UA_Boolean lazyInformationModel;
 #endif
 
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
@@ -480,10 +488,15 @@ typedef enum {
  * buffers and use only memcopy operations to generate requested PubSub packages.
  * ---> Requirements: DataSetFields with variable size cannot be used within this mode.
  * ---> Restrictions: The configuration must be frozen and changes are not allowed while the WriterGroup is 'Operational'.
- * UA_PUBSUB_RT_DETERMINISTIC (Preview - not implemented)
- * ---> Description: -
- * ---> Requirements: -
- * ---> Restrictions: -
+ * UA_PUBSUB_RT_DETERMINISTIC
+ * ---> Description: Extends UA_PUBSUB_RT_FIXED_SIZE. The publish cycle uses only the frozen configuration and the
+ * buffers preallocated at freeze time. It does not access the information model and runs without the server lock.
+ * If the UADP message settings contain a PublishingOffset, the NetworkMessage is sent with a "txtime" launch time
+ * at that offset within the cycle (aligned to the publishing interval on the monotonic clock of the EventLoop).
+ * ---> Requirements: Same as UA_PUBSUB_RT_FIXED_SIZE. The publish callback must be registered with a custom
+ * 'pubsubManagerCallback' that executes it from a dedicated (scheduled, pinned) application thread. For the
+ * launch time, the connection must be opened with the "txtime-enable" parameter.
+ * ---> Restrictions: The custom callback must be removed before the WriterGroup is changed or deleted.
  *
  * WARNING! For hard real time requirements the underlying system must be rt-capable.
  *
@@ -504,6 +517,15 @@ typedef struct {
     UA_Byte priority;
     UA_ExtensionObject transportSettings;
     UA_ExtensionObject messageSettings;
+    /* For UDP unicast, the groupProperty "fanout-addresses" (array of
+     * opc.udp:// URLs) adds destinations to the address of the
+     * TransportSettings. The NetworkMessage is encoded once and sent to all
+     * destinations.
+     *
+     * With UA_ENABLE_PUBSUB_COMPRESSION, the groupProperty "compression"
+     * (String "deflate") compresses JSON NetworkMessages. The preset
+     * dictionary is generated from the DataSetMetaData. Subscribers detect
+     * and decompress the messages automatically. */
     UA_KeyValueMap groupProperties;
     UA_PubSubEncodingType encodingMimeType;
     /* PubSub Manager Callback */
@@ -670,7 +692,12 @@ typedef struct {
      * If the beforeWrite method pointer is set, it will be called before a memcpy update
      * to the value. But param externalDataValue already contains the new value.
      * If the afterWrite method pointer is set, it will be called after a memcpy update
-     * to the value. */
+     * to the value.
+     * For non-RT ReaderGroups the memcpy is used if the received value has a
+     * pointer-free type and the same type and array length as the external
+     * value. Otherwise the Write service is used. The application can
+     * synchronize concurrent access (e.g. swap between buffers) in the
+     * beforeWrite/afterWrite callbacks. */
     UA_DataValue **externalDataValue;
     void *targetVariableContext; /* user-defined pointer */
     void (*beforeWrite)(UA_Server *server,
@@ -414,6 +414,15 @@ UA_NodeId_print(const UA_NodeId *id, UA_String *output);
 UA_StatusCode UA_EXPORT
 UA_NodeId_parse(UA_NodeId *id, const UA_String str);
 
+/* Parse without heap allocations. The identifiers of String and ByteString
+ * NodeIds are written to the front of the caller-provided buffer and point into
+ * it afterwards. The buffer is advanced past the used memory, so that several
+ * NodeIds can be parsed into the same buffer. Returns
+ * UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED if the buffer is too small. The
+ * NodeId must not be cleared. */
+UA_StatusCode UA_EXPORT
+UA_NodeId_parseBuf(UA_NodeId *id, const UA_String str, UA_ByteString *buf);
+
 UA_INLINABLE(UA_NodeId
              UA_NODEID(const char *chars), {
     UA_NodeId id;
@@ -528,6 +537,12 @@ UA_ExpandedNodeId_print(const UA_ExpandedNodeId *id, UA_String *output);
 UA_StatusCode UA_EXPORT
 UA_ExpandedNodeId_parse(UA_ExpandedNodeId *id, const UA_String str);
 
+/* Parse without heap allocations into the caller-provided buffer. This also
+ * applies to the NamespaceUri. See UA_NodeId_parseBuf. */
+UA_StatusCode UA_EXPORT
+UA_ExpandedNodeId_parseBuf(UA_ExpandedNodeId *id, const UA_String str,
+                           UA_ByteString *buf);
+
 UA_INLINABLE(UA_ExpandedNodeId
              UA_EXPANDEDNODEID(const char *chars), {
     UA_ExpandedNodeId id;
@@ -730,9 +745,14 @@ typedef struct UA_DataType UA_DataType;
 
 typedef enum {
     UA_VARIANT_DATA,         /* The data has the same lifecycle as the variant */
-    UA_VARIANT_DATA_NODELETE /* The data is "borrowed" by the variant and is
-                              * not deleted when the variant is cleared up.
-                              * The array dimensions also borrowed. */
+    UA_VARIANT_DATA_NODELETE, /* The data is "borrowed" by the variant and is
+                               * not deleted when the variant is cleared up.
+                               * The array dimensions also borrowed. */
+    UA_VARIANT_DATA_SHARED   /* The data is immutable and shared between
+                              * variants with a reference count. Copying the
+                              * variant increases the count, clearing it
+                              * decreases the count. The array dimensions are
+                              * not shared. See UA_Variant_share. */
 } UA_VariantStorageType;
 
 typedef struct {
@@ -827,6 +847,22 @@ UA_StatusCode UA_EXPORT
 UA_Variant_setArrayCopy(UA_Variant *v, const void * UA_RESTRICT array,
                         size_t arraySize, const UA_DataType *type);
 
+/* Convert the data of the variant into a shared payload with a reference
+ * count. Afterwards, copies of the variant (also within DataValues) only
+ * increase the reference count instead of copying the data. Large values that
+ * are copied many times (to the node, the MonitoredItems, the notifications
+ * and the history) are then held in memory only once.
+ *
+ * The shared data must not be modified. Writing a range into a shared variant
+ * (UA_Variant_setRange) first takes a private copy of the data. Owned data is
+ * moved into the shared payload. Borrowed data (UA_VARIANT_DATA_NODELETE) is
+ * copied. Empty variants and empty arrays are not changed.
+ *
+ * @param v The variant
+ * @return Indicates whether the operation succeeded or returns an error code */
+UA_StatusCode UA_EXPORT
+UA_Variant_share(UA_Variant *v);
+
 /* Copy the variant, but use only a subset of the (multidimensional) array into
  * a variant. Returns an error code if the variant is not an array or if the
  * indicated range does not fit.
@@ -1088,6 +1124,10 @@ typedef struct UA_DataTypeArray {
                            containing it is cleaned up */
 } UA_DataTypeArray;
 
+/* Frees the arrays in the linked list that have the cleanup flag set */
+UA_EXPORT void
+UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes);
+
 /* Returns the offset and type of a structure member. The return value is false
  * if the member was not found.
  *
@@ -1125,6 +1165,29 @@ const UA_DataType UA_EXPORT *
 UA_findDataTypeWithCustom(const UA_NodeId *typeId,
                           const UA_DataTypeArray *customTypes);
 
+/**
+ * The lookup of the methods above is a linear search. A hash index over the
+ * builtin types and a list of custom types finds the data types by their
+ * identifier and by their binary encoding identifier in constant time. The
+ * index has to be rebuilt when the custom types change. If types with the same
+ * identifier exist, the index returns the same type as the linear search. */
+
+struct UA_DataTypeIndex;
+typedef struct UA_DataTypeIndex UA_DataTypeIndex;
+
+UA_DataTypeIndex UA_EXPORT *
+UA_DataTypeIndex_new(const UA_DataTypeArray *customTypes);
+
+void UA_EXPORT
+UA_DataTypeIndex_delete(UA_DataTypeIndex *index);
+
+const UA_DataType UA_EXPORT *
+UA_DataTypeIndex_find(const UA_DataTypeIndex *index, const UA_NodeId *typeId);
+
+const UA_DataType UA_EXPORT *
+UA_DataTypeIndex_findBinary(const UA_DataTypeIndex *index,
+                            const UA_NodeId *binaryEncodingId);
+
 /** The following functions are used for generic handling of data types. */
 
 /* Allocates and initializes a variable of type dataType
@@ -1235,12 +1298,48 @@ UA_EXPORT UA_StatusCode
 UA_encodeBinary(const void *p, const UA_DataType *type,
                 UA_ByteString *outBuf);
 
+/* Arena allocator. Memory is taken from larger blocks with a bump pointer and
+ * can only be released all at once. Values decoded into an arena must not be
+ * cleaned up with _clear or _delete. Instead the arena is cleared when they
+ * are no longer needed. A zeroed-out UA_Arena is valid (and empty). */
+struct UA_ArenaBlock;
+typedef struct {
+    struct UA_ArenaBlock *blocks; /* The current block first */
+    size_t blockSize;             /* Minimum block size. Zero for default. */
+} UA_Arena;
+
+/* Frees all blocks. The arena can be reused afterwards. */
+UA_EXPORT void
+UA_Arena_clear(UA_Arena *arena);
+
 /* The structure with the decoding options may be extended in the future.
  * Zero-out the entire structure initially to ensure code-compatibility when
  * more fields are added in a later release. */
 typedef struct {
     const UA_DataTypeArray *customTypes; /* Begin of a linked list with custom
                                           * datatype definitions */
+
+    /* Variant arrays of overlayable types (e.g. ByteArrays) point into the
+     * input buffer instead of being copied. They have the storagetype
+     * UA_VARIANT_DATA_NODELETE and are not freed by _clear. The input buffer
+     * must then outlive the decoded value. Arrays with dimensions or on an
+     * unaligned buffer position are copied as usual. */
+    UA_Boolean zeroCopy;
+
+    /* Allocate all memory of the decoded value from the arena. Also on
+     * failure, the decoded value is not cleaned up individually. */
+    UA_Arena *arena;
+
+    /* Look up the types of ExtensionObjects in the index instead of the
+     * linear search. The index has to be built for the customTypes. */
+    const UA_DataTypeIndex *typeIndex;
+
+    /* Keep the body of ExtensionObjects as UA_EXTENSIONOBJECT_ENCODED_BYTESTRING
+     * instead of decoding known types. This also applies to ExtensionObjects
+     * inside Variants, which then have the type ExtensionObject. Re-encoding
+     * the undecoded content is a plain copy of the body. Use
+     * UA_ExtensionObject_ensureDecoded to decode on first access. */
+    UA_Boolean lazyExtensionObjects;
 } UA_DecodeBinaryOptions;
 
 /* Decodes a data structure from the input buffer in the binary format. It is
@@ -1251,6 +1350,16 @@ UA_decodeBinary(const UA_ByteString *inBuf,
                 void *p, const UA_DataType *type,
                 const UA_DecodeBinaryOptions *options);
 
+/* Decodes the body of an ExtensionObject with the encoding
+ * UA_EXTENSIONOBJECT_ENCODED_BYTESTRING in-place. Does nothing if the content
+ * is already decoded. Returns UA_STATUSCODE_BADDATATYPEIDUNKNOWN if the type is
+ * not found in the builtin types or the custom types of the options. The
+ * ExtensionObject is left unchanged if decoding fails. If the ExtensionObject
+ * was decoded into an arena, the same arena must be set in the options. */
+UA_EXPORT UA_StatusCode
+UA_ExtensionObject_ensureDecoded(UA_ExtensionObject *eo,
+                                 const UA_DecodeBinaryOptions *options);
+
 /**
  * JSON En/Decoding
  * ----------------
@@ -1302,7 +1411,9 @@ UA_calcSizeJson(const void *src, const UA_DataType *type,
  * @param src The value. Must not be NULL.
  * @param type The value type. Must not be NULL.
  * @param outBuf Pointer to ByteString containing the result if the encoding
- *        was successful
+ *        was successful. If the ByteString is empty, a buffer is allocated
+ *        and grown as required during the encoding. Otherwise the encoding
+ *        must fit into the existing buffer.
  * @return Returns a statuscode whether encoding succeeded. */
 UA_StatusCode UA_EXPORT
 UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
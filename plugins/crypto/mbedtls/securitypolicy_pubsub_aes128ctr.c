@@ -37,6 +37,8 @@
 /* counter block=keynonce(4Byte)+Messagenonce(8Byte)+counter(4Byte) see Part14
  * 7.2.2.2.3.2 for details */
 #define UA_AES128CTR_COUNTERBLOCK_SIZE 16
+/* Upper limit for the precomputed keystream (the maximum UDP payload) */
+#define UA_AES128CTR_MAX_KEYSTREAM_LENGTH 65536
 
 typedef struct {
     const UA_PubSubSecurityPolicy *securityPolicy;
@@ -51,6 +53,14 @@ typedef struct {
     UA_Byte encryptingKey[UA_AES128CTR_KEY_LENGTH];
     UA_Byte keyNonce[UA_AES128CTR_KEYNONCE_LENGTH];
     UA_Byte messageNonce[UA_AES128CTR_MESSAGENONCE_LENGTH];
+    mbedtls_aes_context aesContext; /* Key schedule for the encryptingKey */
+
+    /* Keystream precomputed for keystreamNonce. The keystreamLength is a
+     * multiple of the block size and zero if no keystream is prepared. */
+    UA_Byte keystreamNonce[UA_AES128CTR_MESSAGENONCE_LENGTH];
+    UA_Byte *keystream;
+    size_t keystreamSize; /* Allocated size */
+    size_t keystreamLength;
 } PUBSUB_AES128CTR_ChannelContext;
 
 /*******************/
@@ -124,6 +134,22 @@ getPlainTextBlockSize_sp_pubsub_aes128ctr(const void *channelContext) {
     return UA_AES128CTR_PLAIN_TEXT_BLOCK_SIZE;
 }
 
+/* The counter block is keyNonce | messageNonce | blockCounter (big-endian) */
+static void
+setCounterBlock_sp_pubsub_aes128ctr(const PUBSUB_AES128CTR_ChannelContext *cc,
+                               const UA_Byte *messageNonce, UA_UInt32 blockCounter,
+                               UA_Byte counterBlock[UA_AES128CTR_COUNTERBLOCK_SIZE]) {
+    memcpy(counterBlock, cc->keyNonce, UA_AES128CTR_KEYNONCE_LENGTH);
+    memcpy(counterBlock + UA_AES128CTR_KEYNONCE_LENGTH,
+           messageNonce, UA_AES128CTR_MESSAGENONCE_LENGTH);
+    UA_Byte *counter = counterBlock + UA_AES128CTR_KEYNONCE_LENGTH +
+        UA_AES128CTR_MESSAGENONCE_LENGTH;
+    counter[0] = (UA_Byte)(blockCounter >> 24);
+    counter[1] = (UA_Byte)(blockCounter >> 16);
+    counter[2] = (UA_Byte)(blockCounter >> 8);
+    counter[3] = (UA_Byte)blockCounter;
+}
+
 static UA_StatusCode
 encrypt_sp_pubsub_aes128ctr(const PUBSUB_AES128CTR_ChannelContext *cc,
                             UA_ByteString *data) {
@@ -132,29 +158,35 @@ encrypt_sp_pubsub_aes128ctr(const PUBSUB_AES128CTR_ChannelContext *cc,
 
     /* CTR mode does not need padding */
 
-    /* Decode the header to Extract the message nonce */
-
-    /* Keylength in bits */
-    unsigned int keylength = (unsigned int)(UA_AES128CTR_KEY_LENGTH * 8);
-    mbedtls_aes_context aesContext;
-    int mbedErr = mbedtls_aes_setkey_enc(&aesContext, cc->encryptingKey, keylength);
-    if(mbedErr)
-        return UA_STATUSCODE_BADINTERNALERROR;
+    /* Use the precomputed keystream if it was prepared for the current
+     * message nonce */
+    size_t done = 0;
+    if(cc->keystreamLength > 0 &&
+       memcmp(cc->keystreamNonce, cc->messageNonce,
+              UA_AES128CTR_MESSAGENONCE_LENGTH) == 0) {
+        done = (data->length < cc->keystreamLength) ?
+            data->length : cc->keystreamLength;
+        for(size_t i = 0; i < done; i++)
+            data->data[i] ^= cc->keystream[i];
+        if(done == data->length)
+            return UA_STATUSCODE_GOOD;
+    }
 
-    /* Prepare the counterBlock required for encryption/decryption 
-     * Block counter starts at 1 according to part 14 (7.2.2.4.3.2)*/
-    UA_Byte counterBlockCopy[UA_AES128CTR_ENCRYPTION_BLOCK_SIZE];
-    UA_Byte counterInitialValue[4] = {0,0,0,1};
-    memcpy(counterBlockCopy, cc->keyNonce, UA_AES128CTR_KEYNONCE_LENGTH);
-    memcpy(counterBlockCopy + UA_AES128CTR_KEYNONCE_LENGTH,
-           cc->messageNonce, UA_AES128CTR_MESSAGENONCE_LENGTH);
-    memcpy(counterBlockCopy + UA_AES128CTR_KEYNONCE_LENGTH +
-           UA_AES128CTR_MESSAGENONCE_LENGTH, &counterInitialValue, 4);
+    /* Prepare the counterBlock required for encryption/decryption.
+     * Block counter starts at 1 according to part 14 (7.2.2.4.3.2). If a
+     * prefix was covered by the precomputed keystream, continue with the
+     * following block. The keystreamLength is a multiple of the block size. */
+    UA_Byte counterBlockCopy[UA_AES128CTR_COUNTERBLOCK_SIZE];
+    setCounterBlock_sp_pubsub_aes128ctr(cc, cc->messageNonce,
+        (UA_UInt32)(1 + done / UA_AES128CTR_ENCRYPTION_BLOCK_SIZE), counterBlockCopy);
 
     size_t counterblockoffset = 0;
     UA_Byte aesBuffer[UA_AES128CTR_ENCRYPTION_BLOCK_SIZE];
-    mbedErr = mbedtls_aes_crypt_ctr(&aesContext, data->length, &counterblockoffset,
-                                    counterBlockCopy, aesBuffer, data->data, data->data);
+    /* The key schedule is not modified during encryption */
+    mbedtls_aes_context *aesContext = (mbedtls_aes_context*)(uintptr_t)&cc->aesContext;
+    int mbedErr = mbedtls_aes_crypt_ctr(aesContext, data->length - done,
+                                        &counterblockoffset, counterBlockCopy,
+                                        aesBuffer, data->data + done, data->data + done);
     if(mbedErr)
         return UA_STATUSCODE_BADINTERNALERROR;
     return UA_STATUSCODE_GOOD;
@@ -195,9 +227,22 @@ generateNonce_sp_pubsub_aes128ctr(void *policyContext, UA_ByteString *out) {
 
 static void
 channelContext_deleteContext_sp_pubsub_aes128ctr(PUBSUB_AES128CTR_ChannelContext *cc) {
+    mbedtls_aes_free(&cc->aesContext);
+    UA_free(cc->keystream);
     UA_free(cc);
 }
 
+/* Precompute the key schedule when the keys are set. Then it is not computed
+ * again for every message. */
+static UA_StatusCode
+updateKeySchedule_sp_pubsub_aes128ctr(PUBSUB_AES128CTR_ChannelContext *cc) {
+    int mbedErr = mbedtls_aes_setkey_enc(&cc->aesContext, cc->encryptingKey,
+                                         (unsigned int)(UA_AES128CTR_KEY_LENGTH * 8));
+    if(mbedErr)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 channelContext_newContext_sp_pubsub_aes128ctr(void *policyContext,
                                               const UA_ByteString *signingKey,
@@ -217,12 +262,17 @@ channelContext_newContext_sp_pubsub_aes128ctr(void *policyContext,
 
     /* Initialize the channel context */
     cc->policyContext = (PUBSUB_AES128CTR_PolicyContext *)policyContext;
+    mbedtls_aes_init(&cc->aesContext);
     if(signingKey)
         memcpy(cc->signingKey, signingKey->data, signingKey->length);
     if(encryptingKey)
         memcpy(cc->encryptingKey, encryptingKey->data, encryptingKey->length);
     if(keyNonce)
         memcpy(cc->keyNonce, keyNonce->data, keyNonce->length);
+    if(updateKeySchedule_sp_pubsub_aes128ctr(cc) != UA_STATUSCODE_GOOD) {
+        channelContext_deleteContext_sp_pubsub_aes128ctr(cc);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
     *wgContext = cc;
     return UA_STATUSCODE_GOOD;
 }
@@ -241,7 +291,8 @@ channelContext_setKeys_sp_pubsub_aes128ctr(PUBSUB_AES128CTR_ChannelContext *cc,
     memcpy(cc->signingKey, signingKey->data, signingKey->length);
     memcpy(cc->encryptingKey, encryptingKey->data, encryptingKey->length);
     memcpy(cc->keyNonce, keyNonce->data, keyNonce->length);
-    return UA_STATUSCODE_GOOD;
+    cc->keystreamLength = 0; /* The keystream depends on the keys */
+    return updateKeySchedule_sp_pubsub_aes128ctr(cc);
 }
 
 static UA_StatusCode
@@ -253,6 +304,50 @@ channelContext_setMessageNonce_sp_pubsub_aes128ctr(PUBSUB_AES128CTR_ChannelConte
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+channelContext_precomputeKeystream_sp_pubsub_aes128ctr(PUBSUB_AES128CTR_ChannelContext *cc,
+                                                       const UA_ByteString *nonce,
+                                                       size_t length) {
+    if(!cc || !nonce || nonce->length != UA_AES128CTR_MESSAGENONCE_LENGTH)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+
+    /* Invalidate the current keystream until the new one is ready */
+    cc->keystreamLength = 0;
+
+    /* Round up to full blocks. Longer messages continue the counter from
+     * there. */
+    if(length > UA_AES128CTR_MAX_KEYSTREAM_LENGTH)
+        length = UA_AES128CTR_MAX_KEYSTREAM_LENGTH;
+    length = (length + UA_AES128CTR_ENCRYPTION_BLOCK_SIZE - 1) /
+        UA_AES128CTR_ENCRYPTION_BLOCK_SIZE * UA_AES128CTR_ENCRYPTION_BLOCK_SIZE;
+    if(length == 0)
+        return UA_STATUSCODE_GOOD;
+
+    if(length > cc->keystreamSize) {
+        UA_Byte *keystream = (UA_Byte*)UA_realloc(cc->keystream, length);
+        if(!keystream)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        cc->keystream = keystream;
+        cc->keystreamSize = length;
+    }
+
+    /* The keystream is the encryption of zeros */
+    memset(cc->keystream, 0, length);
+    UA_Byte counterBlock[UA_AES128CTR_COUNTERBLOCK_SIZE];
+    setCounterBlock_sp_pubsub_aes128ctr(cc, nonce->data, 1, counterBlock);
+    size_t counterblockoffset = 0;
+    UA_Byte aesBuffer[UA_AES128CTR_ENCRYPTION_BLOCK_SIZE];
+    int mbedErr = mbedtls_aes_crypt_ctr(&cc->aesContext, length, &counterblockoffset,
+                                        counterBlock, aesBuffer,
+                                        cc->keystream, cc->keystream);
+    if(mbedErr)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    memcpy(cc->keystreamNonce, nonce->data, UA_AES128CTR_MESSAGENONCE_LENGTH);
+    cc->keystreamLength = length;
+    return UA_STATUSCODE_GOOD;
+}
+
 static void
 deleteMembers_sp_pubsub_aes128ctr(UA_PubSubSecurityPolicy *securityPolicy) {
     if(securityPolicy == NULL)
@@ -390,6 +485,8 @@ UA_PubSubSecurityPolicy_Aes128Ctr(UA_PubSubSecurityPolicy *policy,
             channelContext_setKeys_sp_pubsub_aes128ctr;
     policy->setMessageNonce = (UA_StatusCode(*)(void *, const UA_ByteString *))
         channelContext_setMessageNonce_sp_pubsub_aes128ctr;
+    policy->precomputeKeystream = (UA_StatusCode(*)(void *, const UA_ByteString *, size_t))
+        channelContext_precomputeKeystream_sp_pubsub_aes128ctr;
     policy->clear = deleteMembers_sp_pubsub_aes128ctr;
     policy->policyContext = NULL;
 
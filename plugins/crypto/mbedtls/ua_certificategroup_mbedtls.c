@@ -17,6 +17,7 @@
 
 #include <mbedtls/x509.h>
 #include <mbedtls/x509_crt.h>
+#include <mbedtls/sha256.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/error.h>
 #include <mbedtls/version.h>
@@ -88,6 +89,23 @@ static UA_ByteString copyDataFormatAware(const UA_ByteString *data)
     return result;
 }
 
+/* Verification results are cached per certificate thumbprint. Reconnecting
+ * clients then do not pay for the full path validation every time. An entry is
+ * stale once the trust list, the issuer list or the CRLs have changed (tracked
+ * by the generation counter) or after a maximum age. The maximum age bounds how
+ * long a certificate is still accepted after it has expired. */
+#define UA_CERTIFICATECACHE_SIZE 16
+#define UA_CERTIFICATECACHE_MAXAGE (5 * 60 * UA_DATETIME_SEC)
+#define UA_CERTIFICATECACHE_THUMBPRINTLENGTH 32 /* SHA-256 */
+
+typedef struct {
+    UA_Byte thumbprint[UA_CERTIFICATECACHE_THUMBPRINTLENGTH];
+    UA_StatusCode result;
+    UA_UInt32 generation;
+    UA_DateTime verifiedAt; /* Monotonic clock */
+    UA_UInt64 lastUsed;     /* For the LRU replacement */
+} CertCacheEntry;
+
 typedef struct {
     /* If the folders are defined, we use them to reload the certificates during
      * runtime */
@@ -99,12 +117,27 @@ typedef struct {
     mbedtls_x509_crt certificateTrustList;
     mbedtls_x509_crt certificateIssuerList;
     mbedtls_x509_crl certificateRevocationList;
+
+    /* File names, sizes and modification times of the folders at the last
+     * reload. The certificates are only reloaded when they change. */
+    UA_ByteString foldersFingerprint;
+    UA_Boolean foldersLoaded;
+
+    UA_UInt32 generation;
+    UA_UInt64 cacheCounter;
+    size_t cacheSize;
+    CertCacheEntry cache[UA_CERTIFICATECACHE_SIZE];
+
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock; /* Verification may run on several threads */
+#endif
 } CertInfo;
 
 #ifdef __linux__ /* Linux only so far */
 
 #include <dirent.h>
 #include <limits.h>
+#include <sys/stat.h>
 
 static UA_StatusCode
 fileNamesFromFolder(const UA_String *folder, size_t *pathsSize, UA_String **paths) {
@@ -152,12 +185,80 @@ fileNamesFromFolder(const UA_String *folder, size_t *pathsSize, UA_String **path
     return UA_STATUSCODE_GOOD;
 }
 
+typedef struct {
+    off_t size;
+    time_t mtime;
+    long mtimeNsec;
+} FileFingerprint;
+
+/* Append the name, size and modification time of the files in the folder */
+static UA_StatusCode
+folderFingerprint(const UA_String *folder, UA_ByteString *fingerprint) {
+    if(folder->length == 0)
+        return UA_STATUSCODE_GOOD;
+
+    size_t pathsSize = 0;
+    UA_String *paths = NULL;
+    UA_StatusCode res = fileNamesFromFolder(folder, &pathsSize, &paths);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    for(size_t i = 0; i < pathsSize; i++) {
+        char f[PATH_MAX + 1];
+        memcpy(f, paths[i].data, paths[i].length);
+        f[paths[i].length] = 0;
+
+        struct stat st;
+        FileFingerprint ffp;
+        memset(&ffp, 0, sizeof(FileFingerprint));
+        if(stat(f, &st) == 0) {
+            ffp.size = st.st_size;
+            ffp.mtime = st.st_mtim.tv_sec;
+            ffp.mtimeNsec = st.st_mtim.tv_nsec;
+        }
+
+        /* Path with terminating zero, followed by the file attributes */
+        size_t len = fingerprint->length + paths[i].length + 1 + sizeof(FileFingerprint);
+        UA_Byte *data = (UA_Byte*)UA_realloc(fingerprint->data, len);
+        if(!data) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        memcpy(&data[fingerprint->length], f, paths[i].length + 1);
+        memcpy(&data[fingerprint->length + paths[i].length + 1], &ffp,
+               sizeof(FileFingerprint));
+        fingerprint->data = data;
+        fingerprint->length = len;
+    }
+    UA_Array_delete(paths, pathsSize, &UA_TYPES[UA_TYPES_STRING]);
+    return res;
+}
+
 static UA_StatusCode
 reloadCertificates(const UA_CertificateGroup *certGroup, CertInfo *ci) {
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     int err = 0;
     int internalErrorFlag = 0;
 
+    /* Skip the reload if the folder content has not changed since */
+    UA_ByteString fingerprint = UA_BYTESTRING_NULL;
+    retval = folderFingerprint(&ci->trustListFolder, &fingerprint);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = folderFingerprint(&ci->issuerListFolder, &fingerprint);
+    if(retval == UA_STATUSCODE_GOOD)
+        retval = folderFingerprint(&ci->revocationListFolder, &fingerprint);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&fingerprint);
+        return retval;
+    }
+    if(ci->foldersLoaded && UA_ByteString_equal(&fingerprint, &ci->foldersFingerprint)) {
+        UA_ByteString_clear(&fingerprint);
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_ByteString_clear(&ci->foldersFingerprint);
+    ci->foldersFingerprint = fingerprint;
+    ci->foldersLoaded = false;
+
     /* Load the trustlists */
     if(ci->trustListFolder.length > 0) {
         UA_LOG_INFO(certGroup->logging, UA_LOGCATEGORY_SERVER, "Reloading the trust-list");
@@ -237,6 +338,10 @@ reloadCertificates(const UA_CertificateGroup *certGroup, CertInfo *ci) {
 
     if(internalErrorFlag) {
         retval = UA_STATUSCODE_BADINTERNALERROR;
+    } else {
+        /* Invalidate the cached verification results */
+        ci->foldersLoaded = true;
+        ci->generation++;
     }
     return retval;
 }
@@ -244,22 +349,8 @@ reloadCertificates(const UA_CertificateGroup *certGroup, CertInfo *ci) {
 #endif
 
 static UA_StatusCode
-certificateGroup_verify(UA_CertificateGroup *certGroup,
-                        const UA_ByteString *certificate) {
-    CertInfo *ci;
-    if(!certGroup)
-        return UA_STATUSCODE_BADINTERNALERROR;
-    ci = (CertInfo*)certGroup->context;
-    if(!ci)
-        return UA_STATUSCODE_BADINTERNALERROR;
-
-#ifdef __linux__ /* Reload certificates if folder paths are specified */
-    UA_StatusCode certFlag = reloadCertificates(certGroup, ci);
-    if(certFlag != UA_STATUSCODE_GOOD) {
-        return certFlag;
-    }
-#endif
-
+certificateGroup_verifyChain(UA_CertificateGroup *certGroup, CertInfo *ci,
+                             const UA_ByteString *certificate) {
     if(ci->trustListFolder.length == 0 &&
        ci->issuerListFolder.length == 0 &&
        ci->revocationListFolder.length == 0 &&
@@ -515,6 +606,84 @@ certificateGroup_verify(UA_CertificateGroup *certGroup,
     return retval;
 }
 
+static CertCacheEntry *
+certCache_find(CertInfo *ci, const UA_Byte *thumbprint, UA_DateTime now) {
+    for(size_t i = 0; i < ci->cacheSize; i++) {
+        CertCacheEntry *entry = &ci->cache[i];
+        if(entry->generation != ci->generation ||
+           now - entry->verifiedAt > UA_CERTIFICATECACHE_MAXAGE ||
+           memcmp(entry->thumbprint, thumbprint,
+                  UA_CERTIFICATECACHE_THUMBPRINTLENGTH) != 0)
+            continue;
+        entry->lastUsed = ++ci->cacheCounter;
+        return entry;
+    }
+    return NULL;
+}
+
+static void
+certCache_add(CertInfo *ci, const UA_Byte *thumbprint,
+              UA_StatusCode result, UA_DateTime now) {
+    /* Replace the least recently used entry if the cache is full */
+    CertCacheEntry *entry = &ci->cache[0];
+    if(ci->cacheSize < UA_CERTIFICATECACHE_SIZE) {
+        entry = &ci->cache[ci->cacheSize++];
+    } else {
+        for(size_t i = 1; i < UA_CERTIFICATECACHE_SIZE; i++) {
+            if(ci->cache[i].lastUsed < entry->lastUsed)
+                entry = &ci->cache[i];
+        }
+    }
+    memcpy(entry->thumbprint, thumbprint, UA_CERTIFICATECACHE_THUMBPRINTLENGTH);
+    entry->result = result;
+    entry->generation = ci->generation;
+    entry->verifiedAt = now;
+    entry->lastUsed = ++ci->cacheCounter;
+}
+
+static UA_StatusCode
+certificateGroup_verify(UA_CertificateGroup *certGroup,
+                        const UA_ByteString *certificate) {
+    CertInfo *ci;
+    if(!certGroup)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    ci = (CertInfo*)certGroup->context;
+    if(!ci)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_Byte thumbprint[UA_CERTIFICATECACHE_THUMBPRINTLENGTH];
+#if MBEDTLS_VERSION_NUMBER >= 0x02070000 && MBEDTLS_VERSION_NUMBER < 0x03000000
+    mbedtls_sha256_ret(certificate->data, certificate->length, thumbprint, 0);
+#else
+    mbedtls_sha256(certificate->data, certificate->length, thumbprint, 0);
+#endif
+
+    UA_LOCK(&ci->lock);
+
+#ifdef __linux__ /* Reload certificates if folder paths are specified */
+    UA_StatusCode certFlag = reloadCertificates(certGroup, ci);
+    if(certFlag != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&ci->lock);
+        return certFlag;
+    }
+#endif
+
+    /* Reuse the cached result */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    CertCacheEntry *entry = certCache_find(ci, thumbprint, now);
+    if(entry) {
+        UA_StatusCode retval = entry->result;
+        UA_UNLOCK(&ci->lock);
+        return retval;
+    }
+
+    /* Verify and cache the result */
+    UA_StatusCode retval = certificateGroup_verifyChain(certGroup, ci, certificate);
+    certCache_add(ci, thumbprint, retval, now);
+    UA_UNLOCK(&ci->lock);
+    return retval;
+}
+
 static void
 certificateGroup_clear(UA_CertificateGroup *certGroup) {
     CertInfo *ci = (CertInfo*)certGroup->context;
@@ -529,6 +698,8 @@ certificateGroup_clear(UA_CertificateGroup *certGroup) {
 #ifdef UA_ENABLE_CERT_REJECTED_DIR
     UA_String_clear(&ci->rejectedListFolder);
 #endif
+    UA_ByteString_clear(&ci->foldersFingerprint);
+    UA_LOCK_DESTROY(&ci->lock);
     UA_free(ci);
     certGroup->context = NULL;
 }
@@ -557,6 +728,7 @@ UA_CertificateVerification_Trustlist(UA_CertificateGroup *certGroup,
     mbedtls_x509_crt_init(&ci->certificateTrustList);
     mbedtls_x509_crl_init(&ci->certificateRevocationList);
     mbedtls_x509_crt_init(&ci->certificateIssuerList);
+    UA_LOCK_INIT(&ci->lock);
 
     certGroup->context = (void*)ci;
     certGroup->verifyCertificate = certificateGroup_verify;
@@ -638,6 +810,7 @@ UA_CertificateVerification_CertFolders(UA_CertificateGroup *certGroup,
     mbedtls_x509_crt_init(&ci->certificateTrustList);
     mbedtls_x509_crl_init(&ci->certificateRevocationList);
     mbedtls_x509_crt_init(&ci->certificateIssuerList);
+    UA_LOCK_INIT(&ci->lock);
 
     /* Only set the folder paths. They will be reloaded during runtime.
      * TODO: Add a more efficient reloading of only the changes */
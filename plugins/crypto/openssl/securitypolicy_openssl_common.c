@@ -629,199 +629,355 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
                                         RSA_PKCS1_PSS_PADDING, outSignature);
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
-                               const UA_ByteString *     key,
-                               const UA_ByteString *     signature
-                              ) {
-    unsigned char buf[SHA256_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA256_DIGEST_LENGTH, buf};
+/* The symmetric cipher and HMAC contexts are kept in the SecureChannel
+ * context of the policies. They are (re-)keyed lazily when a different key is
+ * used. For every message only the IV is reset on the cipher context (keeping
+ * the key schedule) and the HMAC digest states after absorbing the inner and
+ * outer pads are copied. Without a cache, temporary contexts are used. */
 
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data, message->length,
-              mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
+void
+UA_OpenSSL_SymContext_init(UA_OpenSSL_SymContext *sc) {
+    memset(sc, 0, sizeof(UA_OpenSSL_SymContext));
 }
 
-UA_StatusCode
-UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
-                             const UA_ByteString *     key,
-                             UA_ByteString *           signature
-                             ) {
-    if (HMAC (EVP_sha256(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
+static void
+UA_OpenSSL_CipherCache_clear(UA_OpenSSL_CipherCache *cache) {
+    if(cache->ctx)
+        EVP_CIPHER_CTX_free(cache->ctx);
+    OPENSSL_cleanse(cache, sizeof(UA_OpenSSL_CipherCache));
 }
 
-static UA_StatusCode
-UA_OpenSSL_Decrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/) {
-    UA_ByteString    ivCopy    = {0, NULL};
-    UA_ByteString    cipherTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx       = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
+static void
+UA_OpenSSL_HMACCache_clear(UA_OpenSSL_HMACCache *cache) {
+    if(cache->inner)
+        EVP_MD_CTX_free(cache->inner);
+    if(cache->outer)
+        EVP_MD_CTX_free(cache->outer);
+    if(cache->work)
+        EVP_MD_CTX_free(cache->work);
+    OPENSSL_cleanse(cache, sizeof(UA_OpenSSL_HMACCache));
+}
 
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
+void
+UA_OpenSSL_SymContext_clear(UA_OpenSSL_SymContext *sc) {
+    UA_OpenSSL_CipherCache_clear(&sc->encrypt);
+    UA_OpenSSL_CipherCache_clear(&sc->decrypt);
+    UA_OpenSSL_HMACCache_clear(&sc->sign);
+    UA_OpenSSL_HMACCache_clear(&sc->verify);
+}
 
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+static UA_Boolean
+cachedKeyEqual(const UA_Byte *cachedKey, size_t cachedKeyLength,
+               const UA_ByteString *key) {
+    return (cachedKeyLength > 0 && cachedKeyLength == key->length &&
+            memcmp(cachedKey, key->data, key->length) == 0);
+}
 
-    ret = UA_ByteString_copy (data, &cipherTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+static UA_StatusCode
+UA_OpenSSL_HMACCache_setKey(UA_OpenSSL_HMACCache *cache, const EVP_MD *md,
+                            const UA_ByteString *key) {
+    if(cache->md == md && cachedKeyEqual(cache->key, cache->keyLength, key))
+        return UA_STATUSCODE_GOOD;
 
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
+    if(!cache->inner)
+        cache->inner = EVP_MD_CTX_new();
+    if(!cache->outer)
+        cache->outer = EVP_MD_CTX_new();
+    if(!cache->work)
+        cache->work = EVP_MD_CTX_new();
+    if(!cache->inner || !cache->outer || !cache->work)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    cache->keyLength = 0;
 
-    /* call EVP_* to decrypt */
+    /* Keys longer than the block size are hashed first */
+    UA_Byte k[UA_OPENSSL_HMAC_MAXBLOCKSIZE];
+    UA_Byte pad[UA_OPENSSL_HMAC_MAXBLOCKSIZE];
+    size_t blockSize = (size_t)EVP_MD_block_size(md);
+    if(blockSize > UA_OPENSSL_HMAC_MAXBLOCKSIZE)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    memset(k, 0, blockSize);
+    if(key->length > blockSize) {
+        if(EVP_Digest(key->data, key->length, k, NULL, md, NULL) != 1)
+            return UA_STATUSCODE_BADINTERNALERROR;
+    } else {
+        memcpy(k, key->data, key->length);
+    }
 
-    opensslRet = EVP_DecryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
+    /* Absorb the inner and outer pads */
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < blockSize; i++)
+        pad[i] = k[i] ^ 0x36;
+    if(EVP_DigestInit_ex(cache->inner, md, NULL) != 1 ||
+       EVP_DigestUpdate(cache->inner, pad, blockSize) != 1)
         ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    /* EVP_DecryptFinal() will return an error code if padding is enabled
-     * and the final block is not correctly formatted.
-     */
-    EVP_CIPHER_CTX_set_padding (ctx, 0);
-    opensslRet = EVP_DecryptUpdate (ctx, data->data, &outLen,
-                                    cipherTxt.data, (int) cipherTxt.length);
-    if (opensslRet != 1) {
+    for(size_t i = 0; i < blockSize; i++)
+        pad[i] = k[i] ^ 0x5c;
+    if(EVP_DigestInit_ex(cache->outer, md, NULL) != 1 ||
+       EVP_DigestUpdate(cache->outer, pad, blockSize) != 1)
         ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+    OPENSSL_cleanse(k, sizeof(k));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+
+    /* Remember the key. Longer keys are not cached and the pads are computed
+     * again for the next message. */
+    cache->md = md;
+    if(key->length <= UA_OPENSSL_SYMKEY_MAXLENGTH) {
+        memcpy(cache->key, key->data, key->length);
+        cache->keyLength = key->length;
     }
-    opensslRet = EVP_DecryptFinal_ex (ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_OpenSSL_HMAC(UA_OpenSSL_HMACCache *cache, const EVP_MD *md,
+                const UA_ByteString *message, const UA_ByteString *key,
+                UA_Byte *out, size_t *outLen) {
+    UA_OpenSSL_HMACCache tmp;
+    if(!cache) {
+        memset(&tmp, 0, sizeof(UA_OpenSSL_HMACCache));
+        cache = &tmp;
+    }
+
+    UA_Byte innerHash[EVP_MAX_MD_SIZE];
+    unsigned int innerLen = 0;
+    unsigned int len = 0;
+    UA_StatusCode ret = UA_OpenSSL_HMACCache_setKey(cache, md, key);
+    if(ret != UA_STATUSCODE_GOOD)
+        goto errout;
+
+    if(EVP_MD_CTX_copy_ex(cache->work, cache->inner) != 1 ||
+       EVP_DigestUpdate(cache->work, message->data, message->length) != 1 ||
+       EVP_DigestFinal_ex(cache->work, innerHash, &innerLen) != 1 ||
+       EVP_MD_CTX_copy_ex(cache->work, cache->outer) != 1 ||
+       EVP_DigestUpdate(cache->work, innerHash, innerLen) != 1 ||
+       EVP_DigestFinal_ex(cache->work, out, &len) != 1) {
         ret = UA_STATUSCODE_BADINTERNALERROR;
         goto errout;
     }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    *outLen = len;
 
 errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&cipherTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
+    if(cache == &tmp)
+        UA_OpenSSL_HMACCache_clear(&tmp);
     return ret;
 }
 
 static UA_StatusCode
-UA_OpenSSL_Encrypt (const UA_ByteString * iv,
-                    const UA_ByteString * key,
-                    const EVP_CIPHER *    cipherAlg,
-                    UA_ByteString *       data  /* [in/out]*/
-                    ) {
-
-    UA_ByteString    ivCopy   = {0, NULL};
-    UA_ByteString    plainTxt = {0, NULL};
-    EVP_CIPHER_CTX * ctx      = NULL;
-    UA_StatusCode    ret;
-    int              opensslRet;
-    int              outLen;
-    int              tmpLen;
-
-    /* copy the IV because the AES_cbc_encrypt function overwrites it. */
+UA_OpenSSL_HMAC_Verify(UA_OpenSSL_HMACCache *cache, const EVP_MD *md,
+                       const UA_ByteString *message, const UA_ByteString *key,
+                       const UA_ByteString *signature) {
+    UA_Byte mac[EVP_MAX_MD_SIZE];
+    size_t macLen = 0;
+    UA_StatusCode ret = UA_OpenSSL_HMAC(cache, md, message, key, mac, &macLen);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if(signature->length != macLen ||
+       CRYPTO_memcmp(signature->data, mac, macLen) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
 
-    ret = UA_ByteString_copy (iv, &ivCopy);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+static UA_StatusCode
+UA_OpenSSL_HMAC_Sign(UA_OpenSSL_HMACCache *cache, const EVP_MD *md,
+                     const UA_ByteString *message, const UA_ByteString *key,
+                     UA_ByteString *signature) {
+    UA_Byte mac[EVP_MAX_MD_SIZE];
+    size_t macLen = 0;
+    UA_StatusCode ret = UA_OpenSSL_HMAC(cache, md, message, key, mac, &macLen);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if(signature->length < macLen)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    memcpy(signature->data, mac, macLen);
+    signature->length = macLen;
+    return UA_STATUSCODE_GOOD;
+}
 
-    ret = UA_ByteString_copy (data, &plainTxt);
-    if (ret != UA_STATUSCODE_GOOD) {
-        goto errout;
-    }
+UA_StatusCode
+UA_OpenSSL_HMAC_SHA256_Verify (const UA_ByteString *     message,
+                               const UA_ByteString *     key,
+                               const UA_ByteString *     signature,
+                               UA_OpenSSL_HMACCache *    cache
+                              ) {
+    return UA_OpenSSL_HMAC_Verify(cache, EVP_sha256(), message, key, signature);
+}
 
-    ctx = EVP_CIPHER_CTX_new ();
-    if (ctx == NULL) {
-        ret = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto errout;
-    }
+UA_StatusCode
+UA_OpenSSL_HMAC_SHA256_Sign (const UA_ByteString *     message,
+                             const UA_ByteString *     key,
+                             UA_ByteString *           signature,
+                             UA_OpenSSL_HMACCache *    cache
+                             ) {
+    return UA_OpenSSL_HMAC_Sign(cache, EVP_sha256(), message, key, signature);
+}
 
-    /* call EVP_* to encrypt */
+/* Set up the cached cipher context for the key and reset the IV */
+static UA_StatusCode
+UA_OpenSSL_CipherCache_start(UA_OpenSSL_CipherCache *cache,
+                             const UA_ByteString *iv, const UA_ByteString *key,
+                             const EVP_CIPHER *cipherAlg, int enc,
+                             const UA_ByteString *data) {
+    if(key->length != (size_t)EVP_CIPHER_key_length(cipherAlg) ||
+       iv->length < (size_t)EVP_CIPHER_iv_length(cipherAlg) ||
+       data->length % (size_t)EVP_CIPHER_block_size(cipherAlg) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
 
-    opensslRet = EVP_EncryptInit_ex (ctx, cipherAlg, NULL, key->data, ivCopy.data);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+    if(!cache->ctx) {
+        cache->ctx = EVP_CIPHER_CTX_new();
+        if(!cache->ctx)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* Disable padding. Padding is done in the stack before calling encryption.
-     * Ensure that we have a multiple of the block size */
-    if(data->length % (size_t)EVP_CIPHER_CTX_block_size(ctx)) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
-    }
-    opensslRet = EVP_CIPHER_CTX_set_padding(ctx, 0);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
-        goto errout;
+    /* Set up the key schedule if the key has changed. Padding is disabled, as
+     * it is done in the stack before calling encryption. */
+    if(cache->cipher != cipherAlg ||
+       !cachedKeyEqual(cache->key, cache->keyLength, key)) {
+        cache->keyLength = 0;
+        if(EVP_CipherInit_ex(cache->ctx, cipherAlg, NULL, key->data, NULL, enc) != 1 ||
+           EVP_CIPHER_CTX_set_padding(cache->ctx, 0) != 1)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        cache->cipher = cipherAlg;
+        if(key->length <= UA_OPENSSL_SYMKEY_MAXLENGTH) {
+            memcpy(cache->key, key->data, key->length);
+            cache->keyLength = key->length;
+        }
     }
 
-    /* Encrypt the data */
-    opensslRet = EVP_EncryptUpdate (ctx, data->data, &outLen,
-                                    plainTxt.data, (int) plainTxt.length);
-    if (opensslRet != 1) {
-        ret = UA_STATUSCODE_BADINTERNALERROR;
+    /* Reset the IV */
+    if(EVP_CipherInit_ex(cache->ctx, NULL, NULL, NULL, iv->data, enc) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encrypt or decrypt in-place with AES-CBC. The stack adds the padding. */
+static UA_StatusCode
+UA_OpenSSL_Cipher (UA_OpenSSL_CipherCache * cache,
+                   const UA_ByteString *    iv,
+                   const UA_ByteString *    key,
+                   const EVP_CIPHER *       cipherAlg,
+                   int                      enc,
+                   UA_ByteString *          data  /* [in/out]*/) {
+    UA_OpenSSL_CipherCache tmp;
+    if(!cache) {
+        memset(&tmp, 0, sizeof(UA_OpenSSL_CipherCache));
+        cache = &tmp;
+    }
+
+    int outLen = 0;
+    int tmpLen = 0;
+    UA_StatusCode ret =
+        UA_OpenSSL_CipherCache_start(cache, iv, key, cipherAlg, enc, data);
+    if(ret != UA_STATUSCODE_GOOD)
         goto errout;
-    }
 
-    /* Encrypt-final does nothing as padding is disabled */
-    opensslRet = EVP_EncryptFinal_ex(ctx, data->data + outLen, &tmpLen);
-    if (opensslRet != 1) {
+    /* Process the data in-place */
+    if(EVP_CipherUpdate(cache->ctx, data->data, &outLen,
+                        data->data, (int)data->length) != 1 ||
+       EVP_CipherFinal_ex(cache->ctx, data->data + outLen, &tmpLen) != 1) {
         ret = UA_STATUSCODE_BADINTERNALERROR;
         goto errout;
     }
-    outLen += tmpLen;
-    data->length = (size_t) outLen;
-    ret = UA_STATUSCODE_GOOD;
+    data->length = (size_t)(outLen + tmpLen);
 
 errout:
-    UA_ByteString_clear (&ivCopy);
-    UA_ByteString_clear (&plainTxt);
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
-    }
+    if(cache == &tmp)
+        UA_OpenSSL_CipherCache_clear(&tmp);
     return ret;
 }
 
+/* Decrypt in-place with AES-CBC and compute the HMAC over the decrypted bytes
+ * in the same pass. The chunk is processed in slices that fit into the L1
+ * cache. So the plaintext is hashed before it is evicted and every byte is
+ * loaded from memory only once. The signature at the end of the plaintext is
+ * compared in constant time. */
+#define UA_OPENSSL_DECRYPTVERIFY_SLICE 2048
+
+UA_StatusCode
+UA_OpenSSL_CBC_HMAC_DecryptAndVerify(UA_OpenSSL_SymContext *sc,
+                                     const EVP_CIPHER *cipherAlg,
+                                     const EVP_MD *md,
+                                     const UA_ByteString *iv,
+                                     const UA_ByteString *encryptingKey,
+                                     const UA_ByteString *signingKey,
+                                     UA_ByteString *chunk, size_t offset) {
+    size_t sigSize = (size_t)EVP_MD_size(md);
+    if(offset > chunk->length || chunk->length - offset <= sigSize)
+        return UA_STATUSCODE_BADSECURITYCHECKSFAILED;
+    UA_ByteString cipher = {chunk->length - offset, chunk->data + offset};
+    UA_StatusCode ret = UA_OpenSSL_CipherCache_start(&sc->decrypt, iv, encryptingKey,
+                                                     cipherAlg, 0, &cipher);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+
+    /* The header before the offset is signed but not encrypted */
+    UA_OpenSSL_HMACCache *hc = &sc->verify;
+    ret = UA_OpenSSL_HMACCache_setKey(hc, md, signingKey);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+    if(EVP_MD_CTX_copy_ex(hc->work, hc->inner) != 1 ||
+       EVP_DigestUpdate(hc->work, chunk->data, offset) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_Byte *sig = chunk->data + chunk->length - sigSize;
+    UA_Byte *in = cipher.data;
+    UA_Byte *out = cipher.data;
+    UA_Byte *end = chunk->data + chunk->length;
+    while(in < end) {
+        size_t len = (size_t)(end - in);
+        if(len > UA_OPENSSL_DECRYPTVERIFY_SLICE)
+            len = UA_OPENSSL_DECRYPTVERIFY_SLICE;
+        int outLen = 0;
+        if(EVP_CipherUpdate(sc->decrypt.ctx, out, &outLen, in, (int)len) != 1)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        in += len;
+
+        /* Hash the new plaintext up to the signature */
+        UA_Byte *hashEnd = out + outLen;
+        if(hashEnd > sig)
+            hashEnd = sig;
+        if(hashEnd > out &&
+           EVP_DigestUpdate(hc->work, out, (size_t)(hashEnd - out)) != 1)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        out += outLen;
+    }
+    int tmpLen = 0;
+    if(EVP_CipherFinal_ex(sc->decrypt.ctx, out, &tmpLen) != 1 ||
+       out + tmpLen != end)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    /* Finish the HMAC and compare */
+    UA_Byte innerHash[EVP_MAX_MD_SIZE];
+    UA_Byte mac[EVP_MAX_MD_SIZE];
+    unsigned int innerLen = 0;
+    unsigned int macLen = 0;
+    if(EVP_DigestFinal_ex(hc->work, innerHash, &innerLen) != 1 ||
+       EVP_MD_CTX_copy_ex(hc->work, hc->outer) != 1 ||
+       EVP_DigestUpdate(hc->work, innerHash, innerLen) != 1 ||
+       EVP_DigestFinal_ex(hc->work, mac, &macLen) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(macLen != sigSize || CRYPTO_memcmp(sig, mac, macLen) != 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
 UA_StatusCode
 UA_OpenSSL_AES_256_CBC_Decrypt (const UA_ByteString * iv,
                                 const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
+                                UA_ByteString *       data, /* [in/out]*/
+                                UA_OpenSSL_CipherCache * cache
                                 ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_256_cbc (), data);
+    return UA_OpenSSL_Cipher (cache, iv, key, EVP_aes_256_cbc (), 0, data);
 }
 
 UA_StatusCode
 UA_OpenSSL_AES_256_CBC_Encrypt (const UA_ByteString * iv,
-                            const UA_ByteString * key,
-                            UA_ByteString *       data  /* [in/out]*/
-                            ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_256_cbc (), data);
+                                const UA_ByteString * key,
+                                UA_ByteString *       data, /* [in/out]*/
+                                UA_OpenSSL_CipherCache * cache
+                                ) {
+    return UA_OpenSSL_Cipher (cache, iv, key, EVP_aes_256_cbc (), 1, data);
 }
 
 UA_StatusCode
@@ -939,34 +1095,19 @@ UA_Openssl_Random_Key_PSHA1_Derive (const UA_ByteString *     secret,
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA1_Verify (const UA_ByteString *     message,
                              const UA_ByteString *     key,
-                             const UA_ByteString *     signature
+                             const UA_ByteString *     signature,
+                             UA_OpenSSL_HMACCache *    cache
                              ) {
-    unsigned char buf[SHA1_DIGEST_LENGTH] = {0};
-    UA_ByteString mac = {SHA1_DIGEST_LENGTH, buf};
-
-    if(HMAC (EVP_sha1(), key->data, (int) key->length, message->data, message->length,
-             mac.data, (unsigned int *) &mac.length) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    if (UA_ByteString_equal (signature, &mac)) {
-        return UA_STATUSCODE_GOOD;
-    }
-    else {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
+    return UA_OpenSSL_HMAC_Verify(cache, EVP_sha1(), message, key, signature);
 }
 
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA1_Sign (const UA_ByteString *     message,
                            const UA_ByteString *     key,
-                           UA_ByteString *           signature
+                           UA_ByteString *           signature,
+                           UA_OpenSSL_HMACCache *    cache
                            ) {
-    if (HMAC (EVP_sha1(), key->data, (int) key->length, message->data,
-              message->length,
-              signature->data, (unsigned int *) &(signature->length)) == NULL) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    return UA_STATUSCODE_GOOD;
+    return UA_OpenSSL_HMAC_Sign(cache, EVP_sha1(), message, key, signature);
 }
 
 UA_StatusCode
@@ -996,17 +1137,19 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt (UA_ByteString * data,
 UA_StatusCode
 UA_OpenSSL_AES_128_CBC_Decrypt (const UA_ByteString * iv,
                                 const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
+                                UA_ByteString *       data, /* [in/out]*/
+                                UA_OpenSSL_CipherCache * cache
                                 ) {
-    return UA_OpenSSL_Decrypt (iv, key, EVP_aes_128_cbc (), data);
+    return UA_OpenSSL_Cipher (cache, iv, key, EVP_aes_128_cbc (), 0, data);
 }
 
 UA_StatusCode
 UA_OpenSSL_AES_128_CBC_Encrypt (const UA_ByteString * iv,
                                 const UA_ByteString * key,
-                                UA_ByteString *       data  /* [in/out]*/
+                                UA_ByteString *       data, /* [in/out]*/
+                                UA_OpenSSL_CipherCache * cache
                                 ) {
-    return UA_OpenSSL_Encrypt (iv, key, EVP_aes_128_cbc (), data);
+    return UA_OpenSSL_Cipher (cache, iv, key, EVP_aes_128_cbc (), 1, data);
 }
 
 EVP_PKEY *
@@ -20,6 +20,38 @@
 
 _UA_BEGIN_DECLS
 
+/* Symmetric crypto state kept per SecureChannel. The contexts are keyed on
+ * first use and re-keyed when a different key is passed. */
+
+#define UA_OPENSSL_SYMKEY_MAXLENGTH 64
+#define UA_OPENSSL_HMAC_MAXBLOCKSIZE 128
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    const EVP_CIPHER *cipher;
+    UA_Byte key[UA_OPENSSL_SYMKEY_MAXLENGTH];
+    size_t keyLength;
+} UA_OpenSSL_CipherCache;
+
+typedef struct {
+    EVP_MD_CTX *inner; /* Digest state after absorbing the inner pad */
+    EVP_MD_CTX *outer; /* Digest state after absorbing the outer pad */
+    EVP_MD_CTX *work;
+    const EVP_MD *md;
+    UA_Byte key[UA_OPENSSL_SYMKEY_MAXLENGTH];
+    size_t keyLength;
+} UA_OpenSSL_HMACCache;
+
+typedef struct {
+    UA_OpenSSL_CipherCache encrypt;
+    UA_OpenSSL_CipherCache decrypt;
+    UA_OpenSSL_HMACCache sign;
+    UA_OpenSSL_HMACCache verify;
+} UA_OpenSSL_SymContext;
+
+void UA_OpenSSL_SymContext_init(UA_OpenSSL_SymContext *sc);
+void UA_OpenSSL_SymContext_clear(UA_OpenSSL_SymContext *sc);
+
 void saveDataToFile(const char *fileName, const UA_ByteString *str);
 void UA_Openssl_Init(void);
 
@@ -80,22 +112,37 @@ UA_Openssl_RSA_PSS_SHA256_Sign (const UA_ByteString * message,
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA256_Verify(const UA_ByteString *message,
                               const UA_ByteString *key,
-                              const UA_ByteString *signature);
+                              const UA_ByteString *signature,
+                              UA_OpenSSL_HMACCache *cache);
 
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA256_Sign(const UA_ByteString *message,
                             const UA_ByteString *key,
-                            UA_ByteString *signature);
+                            UA_ByteString *signature,
+                            UA_OpenSSL_HMACCache *cache);
 
 UA_StatusCode
 UA_OpenSSL_AES_256_CBC_Decrypt(const UA_ByteString *iv,
                                const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+                               UA_ByteString *data, /* [in/out]*/
+                               UA_OpenSSL_CipherCache *cache);
 
 UA_StatusCode
 UA_OpenSSL_AES_256_CBC_Encrypt(const UA_ByteString *iv,
                                const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+                               UA_ByteString *data, /* [in/out]*/
+                               UA_OpenSSL_CipherCache *cache);
+
+/* Decrypt the chunk after the offset in-place and verify the HMAC signature
+ * at the end of the plaintext in the same pass */
+UA_StatusCode
+UA_OpenSSL_CBC_HMAC_DecryptAndVerify(UA_OpenSSL_SymContext *sc,
+                                     const EVP_CIPHER *cipherAlg,
+                                     const EVP_MD *md,
+                                     const UA_ByteString *iv,
+                                     const UA_ByteString *encryptingKey,
+                                     const UA_ByteString *signingKey,
+                                     UA_ByteString *chunk, size_t offset);
 
 UA_StatusCode
 UA_OpenSSL_X509_compare(const UA_ByteString *cert, const X509 *b);
@@ -120,12 +167,14 @@ UA_Openssl_Random_Key_PSHA1_Derive(const UA_ByteString *secret,
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA1_Verify(const UA_ByteString *message,
                             const UA_ByteString *key,
-                            const UA_ByteString *signature);
+                            const UA_ByteString *signature,
+                            UA_OpenSSL_HMACCache *cache);
 
 UA_StatusCode
 UA_OpenSSL_HMAC_SHA1_Sign(const UA_ByteString *message,
                           const UA_ByteString *key,
-                          UA_ByteString *signature);
+                          UA_ByteString *signature,
+                          UA_OpenSSL_HMACCache *cache);
 
 UA_StatusCode
 UA_Openssl_RSA_PKCS1_V15_Decrypt(UA_ByteString *data,
@@ -139,12 +188,14 @@ UA_Openssl_RSA_PKCS1_V15_Encrypt(UA_ByteString *data,
 UA_StatusCode
 UA_OpenSSL_AES_128_CBC_Decrypt(const UA_ByteString *iv,
                                const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+                               UA_ByteString *data, /* [in/out]*/
+                               UA_OpenSSL_CipherCache *cache);
 
 UA_StatusCode
 UA_OpenSSL_AES_128_CBC_Encrypt(const UA_ByteString *iv,
                                const UA_ByteString *key,
-                               UA_ByteString *data  /* [in/out]*/);
+                               UA_ByteString *data, /* [in/out]*/
+                               UA_OpenSSL_CipherCache *cache);
 
 EVP_PKEY *
 UA_OpenSSL_LoadPrivateKey(const UA_ByteString *privateKey);
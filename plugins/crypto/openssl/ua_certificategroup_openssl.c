@@ -17,6 +17,7 @@
 #include <openssl/x509_vfy.h>
 #include <openssl/x509v3.h>
 #include <openssl/pem.h>
+#include <openssl/sha.h>
 
 #include "ua_openssl_version_abstraction.h"
 #include "libc_time.h"
@@ -62,6 +63,22 @@ UA_Bstrstr(const unsigned char *s1, size_t l1, const unsigned char *s2, size_t l
     return NULL;
 }
 
+/* Verification results are cached per certificate thumbprint. Reconnecting
+ * clients then do not pay for the full path validation every time. An entry is
+ * stale once the trust list, the issuer list or the CRLs have changed (tracked
+ * by the generation counter) or after a maximum age. The maximum age bounds how
+ * long a certificate is still accepted after it has expired. */
+#define UA_CERTIFICATECACHE_SIZE 16
+#define UA_CERTIFICATECACHE_MAXAGE (5 * 60 * UA_DATETIME_SEC)
+
+typedef struct {
+    UA_Byte thumbprint[SHA256_DIGEST_LENGTH];
+    UA_StatusCode result;
+    UA_UInt32 generation;
+    UA_DateTime verifiedAt; /* Monotonic clock */
+    UA_UInt64 lastUsed;     /* For the LRU replacement */
+} CertCacheEntry;
+
 typedef struct {
     /*
      * If the folders are defined, we use them to reload the certificates during
@@ -78,6 +95,20 @@ typedef struct {
     STACK_OF(X509) *      skTrusted;
     STACK_OF(X509_CRL) *  skCrls; /* Revocation list*/
 
+    /* File names, sizes and modification times of the folders at the last
+     * reload. The certificates are only reloaded when they change. */
+    UA_ByteString         foldersFingerprint;
+    UA_Boolean            foldersLoaded;
+
+    UA_UInt32             generation;
+    UA_UInt64             cacheCounter;
+    size_t                cacheSize;
+    CertCacheEntry        cache[UA_CERTIFICATECACHE_SIZE];
+
+#if UA_MULTITHREADING >= 100
+    UA_Lock               lock; /* Verification may run on several threads */
+#endif
+
     UA_CertificateGroup *certGroup;
 } CertContext;
 
@@ -107,6 +138,8 @@ UA_CertContext_Init (CertContext * context, UA_CertificateGroup *certGroup) {
     UA_ByteString_init (&context->issuerListFolder);
     UA_ByteString_init (&context->revocationListFolder);
     UA_ByteString_init (&context->rejectedListFolder);
+    UA_ByteString_init (&context->foldersFingerprint);
+    UA_LOCK_INIT (&context->lock);
 
     context->certGroup = certGroup;
 
@@ -126,6 +159,8 @@ UA_CertificateGroup_clear (UA_CertificateGroup *certGroup) {
     UA_ByteString_clear (&context->issuerListFolder);
     UA_ByteString_clear (&context->revocationListFolder);
     UA_ByteString_clear (&context->rejectedListFolder);
+    UA_ByteString_clear (&context->foldersFingerprint);
+    UA_LOCK_DESTROY (&context->lock);
 
     UA_CertContext_sk_free (context);
     context->certGroup = NULL;
@@ -204,6 +239,7 @@ UA_skCrls_Cert2X509 (const UA_ByteString *   certificateRevocationList,
 
 #ifdef __linux__
 #include <dirent.h>
+#include <sys/stat.h>
 
 static int UA_Certificate_Filter_der_pem (const struct dirent * entry) {
     /* ignore hidden files */
@@ -281,6 +317,66 @@ UA_loadCertFromFile (const char *     fileName,
     return UA_STATUSCODE_GOOD;
 }
 
+typedef struct {
+    off_t  size;
+    time_t mtime;
+    long   mtimeNsec;
+} FileFingerprint;
+
+/* Append the name, size and modification time of the matching files */
+static UA_StatusCode
+UA_FolderFingerprint (const UA_String * folder,
+                      int (*filter) (const struct dirent *),
+                      UA_ByteString * fingerprint) {
+    if (folder->length == 0)
+        return UA_STATUSCODE_GOOD;
+    if (folder->length >= PATH_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    char folderPath[PATH_MAX];
+    char file[PATH_MAX];
+    memcpy (folderPath, folder->data, folder->length);
+    folderPath[folder->length] = 0;
+
+    struct dirent ** dirlist = NULL;
+    int numFiles = scandir (folderPath, &dirlist, filter, alphasort);
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    for (int i = 0; i < numFiles; i++) {
+        if (ret != UA_STATUSCODE_GOOD) {
+            free (dirlist[i]);
+            continue;
+        }
+
+        struct stat st;
+        FileFingerprint ffp;
+        memset (&ffp, 0, sizeof (FileFingerprint));
+        if (UA_BuildFullPath (folderPath, dirlist[i]->d_name,
+                              PATH_MAX, file) == UA_STATUSCODE_GOOD &&
+            stat (file, &st) == 0) {
+            ffp.size = st.st_size;
+            ffp.mtime = st.st_mtim.tv_sec;
+            ffp.mtimeNsec = st.st_mtim.tv_nsec;
+        }
+
+        /* Name with terminating zero, followed by the file attributes */
+        size_t nameLen = strlen (dirlist[i]->d_name) + 1;
+        size_t len = fingerprint->length + nameLen + sizeof (FileFingerprint);
+        UA_Byte * data = (UA_Byte *) UA_realloc (fingerprint->data, len);
+        if (data == NULL) {
+            ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        } else {
+            memcpy (&data[fingerprint->length], dirlist[i]->d_name, nameLen);
+            memcpy (&data[fingerprint->length + nameLen], &ffp,
+                    sizeof (FileFingerprint));
+            fingerprint->data = data;
+            fingerprint->length = len;
+        }
+        free (dirlist[i]);
+    }
+    free (dirlist);
+    return ret;
+}
+
 static UA_StatusCode
 UA_ReloadCertFromFolder (CertContext * ctx) {
     UA_StatusCode    ret;
@@ -293,6 +389,29 @@ UA_ReloadCertFromFolder (CertContext * ctx) {
 
     UA_ByteString_init (&strCert);
 
+    /* Skip the reload if the folder content has not changed since */
+    UA_ByteString fingerprint = UA_BYTESTRING_NULL;
+    ret = UA_FolderFingerprint (&ctx->trustListFolder,
+                                UA_Certificate_Filter_der_pem, &fingerprint);
+    if (ret == UA_STATUSCODE_GOOD)
+        ret = UA_FolderFingerprint (&ctx->issuerListFolder,
+                                    UA_Certificate_Filter_der_pem, &fingerprint);
+    if (ret == UA_STATUSCODE_GOOD)
+        ret = UA_FolderFingerprint (&ctx->revocationListFolder,
+                                    UA_Certificate_Filter_crl, &fingerprint);
+    if (ret != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear (&fingerprint);
+        return ret;
+    }
+    if (ctx->foldersLoaded &&
+        UA_ByteString_equal (&fingerprint, &ctx->foldersFingerprint)) {
+        UA_ByteString_clear (&fingerprint);
+        return UA_STATUSCODE_GOOD;
+    }
+    UA_ByteString_clear (&ctx->foldersFingerprint);
+    ctx->foldersFingerprint = fingerprint;
+    ctx->foldersLoaded = false;
+
     if (ctx->trustListFolder.length > 0) {
         UA_LOG_INFO(ctx->certGroup->logging, UA_LOGCATEGORY_SERVER, "Reloading the trust-list");
 
@@ -399,6 +518,10 @@ UA_ReloadCertFromFolder (CertContext * ctx) {
         }
     }
 
+    /* Invalidate the cached verification results */
+    ctx->foldersLoaded = true;
+    ctx->generation++;
+
     ret = UA_STATUSCODE_GOOD;
     return ret;
 }
@@ -443,19 +566,13 @@ UA_X509_Store_CTX_Error_To_UAError (int opensslErr) {
     }
 
 static UA_StatusCode
-UA_CertificateGroup_Verify(UA_CertificateGroup *certGroup,
-                           const UA_ByteString *certificate) {
+UA_CertificateGroup_verifyChain(UA_CertificateGroup *certGroup, CertContext *ctx,
+                                const UA_ByteString *certificate) {
     X509_STORE_CTX *storeCtx = NULL;
     X509_STORE *store = NULL;
-    CertContext *ctx = NULL;
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
     int opensslRet;
 
-    if ((certGroup == NULL) || (certGroup->context == NULL)) {
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-    ctx = (CertContext *) certGroup->context;
-
     /* Parse the certificate */
     X509 *certificateX509 = UA_OpenSSL_LoadCertificate(certificate);
     if(!certificateX509) {
@@ -463,13 +580,6 @@ UA_CertificateGroup_Verify(UA_CertificateGroup *certGroup,
         goto cleanup;
     }
 
-    /* Reload PKI folder */
-#ifdef __linux__
-    ret = UA_ReloadCertFromFolder (ctx);
-    if(ret != UA_STATUSCODE_GOOD)
-        goto cleanup;
-#endif
-
     /* Accept the certificate without verification of no trust and issuer list
      * are loaded */
     if(sk_X509_CRL_num(ctx->skCrls) == 0 &&
@@ -602,6 +712,81 @@ cleanup:
     return ret;
 }
 
+static CertCacheEntry *
+UA_CertCache_find(CertContext *ctx, const UA_Byte *thumbprint, UA_DateTime now) {
+    for(size_t i = 0; i < ctx->cacheSize; i++) {
+        CertCacheEntry *entry = &ctx->cache[i];
+        if(entry->generation != ctx->generation ||
+           now - entry->verifiedAt > UA_CERTIFICATECACHE_MAXAGE ||
+           memcmp(entry->thumbprint, thumbprint, SHA256_DIGEST_LENGTH) != 0)
+            continue;
+        entry->lastUsed = ++ctx->cacheCounter;
+        return entry;
+    }
+    return NULL;
+}
+
+static void
+UA_CertCache_add(CertContext *ctx, const UA_Byte *thumbprint,
+                 UA_StatusCode result, UA_DateTime now) {
+    /* Replace the least recently used entry if the cache is full */
+    CertCacheEntry *entry = &ctx->cache[0];
+    if(ctx->cacheSize < UA_CERTIFICATECACHE_SIZE) {
+        entry = &ctx->cache[ctx->cacheSize++];
+    } else {
+        for(size_t i = 1; i < UA_CERTIFICATECACHE_SIZE; i++) {
+            if(ctx->cache[i].lastUsed < entry->lastUsed)
+                entry = &ctx->cache[i];
+        }
+    }
+    memcpy(entry->thumbprint, thumbprint, SHA256_DIGEST_LENGTH);
+    entry->result = result;
+    entry->generation = ctx->generation;
+    entry->verifiedAt = now;
+    entry->lastUsed = ++ctx->cacheCounter;
+}
+
+static UA_StatusCode
+UA_CertificateGroup_Verify(UA_CertificateGroup *certGroup,
+                           const UA_ByteString *certificate) {
+    if ((certGroup == NULL) || (certGroup->context == NULL)) {
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+    CertContext *ctx = (CertContext *) certGroup->context;
+
+    UA_Byte thumbprint[SHA256_DIGEST_LENGTH];
+    if(EVP_Digest(certificate->data, certificate->length, thumbprint,
+                  NULL, EVP_sha256(), NULL) != 1)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    UA_LOCK(&ctx->lock);
+
+    /* Reload PKI folder */
+#ifdef __linux__
+    ret = UA_ReloadCertFromFolder (ctx);
+    if(ret != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&ctx->lock);
+        return ret;
+    }
+#endif
+
+    /* Reuse the cached result */
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    CertCacheEntry *entry = UA_CertCache_find(ctx, thumbprint, now);
+    if(entry) {
+        ret = entry->result;
+        UA_UNLOCK(&ctx->lock);
+        return ret;
+    }
+
+    /* Verify and cache the result */
+    ret = UA_CertificateGroup_verifyChain(certGroup, ctx, certificate);
+    UA_CertCache_add(ctx, thumbprint, ret, now);
+    UA_UNLOCK(&ctx->lock);
+    return ret;
+}
+
 /* main entry */
 
 UA_StatusCode
@@ -45,6 +45,7 @@ typedef struct {
     Policy_Context_Aes128Sha256RsaOaep *policyContext;
     UA_ByteString remoteCertificate;
     X509 *remoteCertificateX509; /* X509 */
+    UA_OpenSSL_SymContext symContext;
 } Channel_Context_Aes128Sha256RsaOaep;
 
 /* create the policy context */
@@ -175,6 +176,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_New_Context(const UA_SecurityPolicy *securi
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymContext_init(&context->symContext);
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -218,6 +220,7 @@ UA_ChannelModule_Aes128Sha256RsaOaep_Delete_Context(void *channelContext) {
         UA_ByteString_clear(&cc->remoteSymSigningKey);
         UA_ByteString_clear(&cc->remoteSymEncryptingKey);
         UA_ByteString_clear(&cc->remoteSymIv);
+        UA_OpenSSL_SymContext_clear(&cc->symContext);
 
         UA_LOG_INFO(
             cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
@@ -487,7 +490,8 @@ UA_SymSig_Aes128Sha256RsaOaep_verify(void *channelContext, const UA_ByteString *
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature,
+                                         &cc->symContext.verify);
 }
 
 static UA_StatusCode
@@ -499,7 +503,8 @@ UA_SymSig_Aes128Sha256RsaOaep_sign(void *channelContext, const UA_ByteString *me
 
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature,
+                                       &cc->symContext.sign);
 }
 
 static size_t
@@ -514,7 +519,22 @@ UA_SymEn_Aes128Sha256RsaOaep_decrypt(void *channelContext, UA_ByteString *data)
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     return UA_OpenSSL_AES_128_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+                                          data,
+                                          &cc->symContext.decrypt);
+}
+
+static UA_StatusCode
+UA_SymEn_Aes128Sha256RsaOaep_decryptAndVerify(void *channelContext, UA_ByteString *chunk,
+                                              size_t offset) {
+    if(channelContext == NULL || chunk == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_Aes128Sha256RsaOaep *cc = (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
+    return UA_OpenSSL_CBC_HMAC_DecryptAndVerify(&cc->symContext,
+                                                EVP_aes_128_cbc(), EVP_sha256(),
+                                                &cc->remoteSymIv,
+                                                &cc->remoteSymEncryptingKey,
+                                                &cc->remoteSymSigningKey,
+                                                chunk, offset);
 }
 
 static UA_StatusCode
@@ -525,7 +545,8 @@ UA_SymEn_Aes128Sha256RsaOaep_encrypt(void *channelContext, UA_ByteString *data)
     Channel_Context_Aes128Sha256RsaOaep *cc =
         (Channel_Context_Aes128Sha256RsaOaep *)channelContext;
     return UA_OpenSSL_AES_128_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+                                          data,
+                                          &cc->symContext.encrypt);
 }
 
 static UA_StatusCode
@@ -662,6 +683,9 @@ UA_SecurityPolicy_Aes128Sha256RsaOaep(UA_SecurityPolicy *policy,
     symSignatureAlgorithm->sign = UA_SymSig_Aes128Sha256RsaOaep_sign;
     symSignatureAlgorithm->getLocalSignatureSize = UA_SymSig_Aes128Sha256RsaOaep_getLocalSignatureSize;
 
+    /* Decrypt and verify symmetric chunks in one pass */
+    symmetricModule->cryptoModule.decryptAndVerify = UA_SymEn_Aes128Sha256RsaOaep_decryptAndVerify;
+
     retval = UA_Policy_Aes128Sha256RsaOaep_New_Context(policy, localPrivateKey, logger);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_ByteString_clear(&policy->localCertificate);
@@ -45,6 +45,7 @@ typedef struct {
     Policy_Context_Aes256Sha256RsaPss *policyContext;
     UA_ByteString remoteCertificate;
     X509 *remoteCertificateX509; /* X509 */
+    UA_OpenSSL_SymContext symContext;
 } Channel_Context_Aes256Sha256RsaPss;
 
 /* create the policy context */
@@ -126,6 +127,7 @@ UA_ChannelModule_Aes256Sha256RsaPss_New_Context(const UA_SecurityPolicy *securit
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymContext_init(&context->symContext);
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -169,6 +171,7 @@ UA_ChannelModule_Aes256Sha256RsaPss_Delete_Context(void *channelContext) {
         UA_ByteString_clear(&cc->remoteSymSigningKey);
         UA_ByteString_clear(&cc->remoteSymEncryptingKey);
         UA_ByteString_clear(&cc->remoteSymIv);
+        UA_OpenSSL_SymContext_clear(&cc->symContext);
 
         UA_LOG_INFO(
             cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
@@ -489,7 +492,8 @@ UA_SymSig_Aes256Sha256RsaPss_verify(void *channelContext, const UA_ByteString *m
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature,
+                                         &cc->symContext.verify);
 }
 
 static UA_StatusCode
@@ -501,7 +505,8 @@ UA_SymSig_Aes256Sha256RsaPss_sign(void *channelContext, const UA_ByteString *mes
 
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature,
+                                       &cc->symContext.sign);
 }
 
 static size_t
@@ -516,7 +521,22 @@ UA_SymEn_Aes256Sha256RsaPss_decrypt(void *channelContext, UA_ByteString *data) {
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
     return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv, &cc->remoteSymEncryptingKey,
-                                          data);
+                                          data,
+                                          &cc->symContext.decrypt);
+}
+
+static UA_StatusCode
+UA_SymEn_Aes256Sha256RsaPss_decryptAndVerify(void *channelContext, UA_ByteString *chunk,
+                                             size_t offset) {
+    if(channelContext == NULL || chunk == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_Aes256Sha256RsaPss *cc = (Channel_Context_Aes256Sha256RsaPss *)channelContext;
+    return UA_OpenSSL_CBC_HMAC_DecryptAndVerify(&cc->symContext,
+                                                EVP_aes_256_cbc(), EVP_sha256(),
+                                                &cc->remoteSymIv,
+                                                &cc->remoteSymEncryptingKey,
+                                                &cc->remoteSymSigningKey,
+                                                chunk, offset);
 }
 
 static UA_StatusCode
@@ -527,7 +547,8 @@ UA_SymEn_Aes256Sha256RsaPss_encrypt(void *channelContext, UA_ByteString *data) {
     Channel_Context_Aes256Sha256RsaPss *cc =
         (Channel_Context_Aes256Sha256RsaPss *)channelContext;
     return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey,
-                                          data);
+                                          data,
+                                          &cc->symContext.encrypt);
 }
 
 static UA_StatusCode
@@ -666,6 +687,9 @@ UA_SecurityPolicy_Aes256Sha256RsaPss(UA_SecurityPolicy *policy,
     symSignatureAlgorithm->sign = UA_SymSig_Aes256Sha256RsaPss_sign;
     symSignatureAlgorithm->getLocalSignatureSize = UA_SymSig_Aes256Sha256RsaPss_getLocalSignatureSize;
 
+    /* Decrypt and verify symmetric chunks in one pass */
+    symmetricModule->cryptoModule.decryptAndVerify = UA_SymEn_Aes256Sha256RsaPss_decryptAndVerify;
+
     retval = UA_Policy_Aes256Sha256RsaPss_New_Context(policy, localPrivateKey, logger);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_ByteString_clear(&policy->localCertificate);
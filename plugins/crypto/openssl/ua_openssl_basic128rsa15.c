@@ -41,6 +41,7 @@ typedef struct {
     Policy_Context_Basic128Rsa15 * policyContext;
     UA_ByteString             remoteCertificate;
     X509 *                    remoteCertificateX509;
+    UA_OpenSSL_SymContext     symContext;
 } Channel_Context_Basic128Rsa15;
 
 static UA_StatusCode
@@ -168,6 +169,7 @@ UA_ChannelModule_Basic128Rsa15_New_Context (const UA_SecurityPolicy * securityPo
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymContext_init(&context->symContext);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate,
                                                remoteCertificate);
@@ -211,6 +213,7 @@ UA_ChannelModule_Basic128Rsa15_Delete_Context (void * channelContext) {
         UA_ByteString_clear (&cc->remoteSymSigningKey);
         UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
+        UA_OpenSSL_SymContext_clear(&cc->symContext);
         UA_LOG_INFO (cc->policyContext->logger,
                  UA_LOGCATEGORY_SECURITYPOLICY,
                  "The Basic128Rsa15 security policy channel with openssl is deleted.");
@@ -495,7 +498,8 @@ UA_SymEn_Basic128Rsa15_Encrypt (void *channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_AES_128_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_AES_128_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data,
+                                           &cc->symContext.encrypt);
 }
 
 static UA_StatusCode
@@ -504,7 +508,22 @@ UA_SymEn_Basic128Rsa15_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_AES_128_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_AES_128_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data,
+                                           &cc->symContext.decrypt);
+}
+
+static UA_StatusCode
+UA_SymEn_Basic128Rsa15_DecryptAndVerify(void *channelContext, UA_ByteString *chunk,
+                                        size_t offset) {
+    if(channelContext == NULL || chunk == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_Basic128Rsa15 *cc = (Channel_Context_Basic128Rsa15 *)channelContext;
+    return UA_OpenSSL_CBC_HMAC_DecryptAndVerify(&cc->symContext,
+                                                EVP_aes_128_cbc(), EVP_sha1(),
+                                                &cc->remoteSymIv,
+                                                &cc->remoteSymEncryptingKey,
+                                                &cc->remoteSymSigningKey,
+                                                chunk, offset);
 }
 
 static size_t
@@ -527,7 +546,8 @@ UA_SymSig_Basic128Rsa15_Verify (void *                    channelContext,
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
     return UA_OpenSSL_HMAC_SHA1_Verify (message,
                                         &cc->remoteSymSigningKey,
-                                        signature);
+                                        signature,
+                                        &cc->symContext.verify);
 }
 
 static UA_StatusCode
@@ -538,7 +558,8 @@ UA_SymSig_Basic128Rsa15_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic128Rsa15 * cc = (Channel_Context_Basic128Rsa15 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature,
+                                      &cc->symContext.sign);
 }
 
 /* the main entry of Basic128Rsa15 */
@@ -641,6 +662,9 @@ UA_SecurityPolicy_Basic128Rsa15 (UA_SecurityPolicy * policy,
     symSignatureAlgorithm->verify = UA_SymSig_Basic128Rsa15_Verify;
     symSignatureAlgorithm->sign = UA_SymSig_Basic128Rsa15_Sign;
 
+    /* Decrypt and verify symmetric chunks in one pass */
+    symmetricModule->cryptoModule.decryptAndVerify = UA_SymEn_Basic128Rsa15_DecryptAndVerify;
+
     /* set the policy context */
 
     retval = UA_Policy_Basic128Rsa15_New_Context (policy, localPrivateKey, logger);
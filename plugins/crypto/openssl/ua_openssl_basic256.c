@@ -39,6 +39,7 @@ typedef struct {
     Policy_Context_Basic256 * policyContext;
     UA_ByteString             remoteCertificate;
     X509 *                    remoteCertificateX509;
+    UA_OpenSSL_SymContext     symContext;
 } Channel_Context_Basic256;
 
 static UA_StatusCode
@@ -166,6 +167,7 @@ UA_ChannelModule_Basic256_New_Context (const UA_SecurityPolicy * securityPolicy,
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymContext_init(&context->symContext);
 
     UA_StatusCode retval = UA_copyCertificate (&context->remoteCertificate,
                                                remoteCertificate);
@@ -209,6 +211,7 @@ UA_ChannelModule_Basic256_Delete_Context (void * channelContext) {
         UA_ByteString_clear (&cc->remoteSymSigningKey);
         UA_ByteString_clear (&cc->remoteSymEncryptingKey);
         UA_ByteString_clear (&cc->remoteSymIv);
+        UA_OpenSSL_SymContext_clear(&cc->symContext);
         UA_LOG_INFO (cc->policyContext->logger,
                  UA_LOGCATEGORY_SECURITYPOLICY,
                  "The basic256 security policy channel with openssl is deleted.");
@@ -496,7 +499,8 @@ UA_SymEn_Basic256_Encrypt (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_AES_256_CBC_Encrypt (&cc->localSymIv, &cc->localSymEncryptingKey, data,
+                                           &cc->symContext.encrypt);
 }
 
 static UA_StatusCode
@@ -505,7 +509,22 @@ UA_SymEn_Basic256_Decrypt (void *                    channelContext,
     if(channelContext == NULL || data == NULL)
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data);
+    return UA_OpenSSL_AES_256_CBC_Decrypt (&cc->remoteSymIv, &cc->remoteSymEncryptingKey, data,
+                                           &cc->symContext.decrypt);
+}
+
+static UA_StatusCode
+UA_SymEn_Basic256_DecryptAndVerify(void *channelContext, UA_ByteString *chunk,
+                                   size_t offset) {
+    if(channelContext == NULL || chunk == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_Basic256 *cc = (Channel_Context_Basic256 *)channelContext;
+    return UA_OpenSSL_CBC_HMAC_DecryptAndVerify(&cc->symContext,
+                                                EVP_aes_256_cbc(), EVP_sha1(),
+                                                &cc->remoteSymIv,
+                                                &cc->remoteSymEncryptingKey,
+                                                &cc->remoteSymSigningKey,
+                                                chunk, offset);
 }
 
 static size_t
@@ -529,7 +548,8 @@ UA_SymSig_Basic256_Verify (void *                    channelContext,
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
     return UA_OpenSSL_HMAC_SHA1_Verify (message,
                                         &cc->remoteSymSigningKey,
-                                        signature);
+                                        signature,
+                                        &cc->symContext.verify);
 }
 
 static UA_StatusCode
@@ -540,7 +560,8 @@ UA_SymSig_Basic256_Sign (void *                    channelContext,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
 
     Channel_Context_Basic256 * cc = (Channel_Context_Basic256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA1_Sign (message, &cc->localSymSigningKey, signature,
+                                      &cc->symContext.sign);
 }
 
 /* the main entry of Basic256 */
@@ -641,6 +662,9 @@ UA_SecurityPolicy_Basic256 (UA_SecurityPolicy * policy,
     symSignatureAlgorithm->verify = UA_SymSig_Basic256_Verify;
     symSignatureAlgorithm->sign = UA_SymSig_Basic256_Sign;
 
+    /* Decrypt and verify symmetric chunks in one pass */
+    symmetricModule->cryptoModule.decryptAndVerify = UA_SymEn_Basic256_DecryptAndVerify;
+
     /* set the policy context */
 
     retval = UA_Policy_Basic256_New_Context (policy, localPrivateKey, logger);
@@ -46,6 +46,7 @@ typedef struct {
     Policy_Context_Basic256Sha256 *policyContext;
     UA_ByteString remoteCertificate;
     X509 *remoteCertificateX509; /* X509 */
+    UA_OpenSSL_SymContext symContext;
 } Channel_Context_Basic256Sha256;
 
 /* create the policy context */
@@ -165,6 +166,7 @@ UA_ChannelModule_New_Context(const UA_SecurityPolicy * securityPolicy,
     UA_ByteString_init(&context->remoteSymSigningKey);
     UA_ByteString_init(&context->remoteSymEncryptingKey);
     UA_ByteString_init(&context->remoteSymIv);
+    UA_OpenSSL_SymContext_init(&context->symContext);
 
     UA_StatusCode retval =
         UA_copyCertificate(&context->remoteCertificate, remoteCertificate);
@@ -207,6 +209,7 @@ UA_ChannelModule_Delete_Context(void * channelContext) {
     UA_ByteString_clear(&cc->remoteSymSigningKey);
     UA_ByteString_clear(&cc->remoteSymEncryptingKey);
     UA_ByteString_clear(&cc->remoteSymIv);
+    UA_OpenSSL_SymContext_clear(&cc->symContext);
 
     UA_LOG_INFO(cc->policyContext->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                 "The basic256sha256 security policy channel with openssl is deleted.");
@@ -462,7 +465,8 @@ UA_SymSig_Basic256Sha256_verify(void *channelContext, const UA_ByteString *messa
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Verify(message, &cc->remoteSymSigningKey, signature,
+                                         &cc->symContext.verify);
 }
 
 static UA_StatusCode
@@ -472,7 +476,8 @@ UA_SymSig_Basic256Sha256_sign(void *channelContext, const UA_ByteString *message
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature);
+    return UA_OpenSSL_HMAC_SHA256_Sign(message, &cc->localSymSigningKey, signature,
+                                       &cc->symContext.sign);
 }
 
 static size_t
@@ -486,7 +491,22 @@ UA_SymEn_Basic256Sha256_decrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
     return UA_OpenSSL_AES_256_CBC_Decrypt(&cc->remoteSymIv,
-                                          &cc->remoteSymEncryptingKey, data);
+                                          &cc->remoteSymEncryptingKey, data,
+                                          &cc->symContext.decrypt);
+}
+
+static UA_StatusCode
+UA_SymEn_Basic256Sha256_decryptAndVerify(void *channelContext, UA_ByteString *chunk,
+                                         size_t offset) {
+    if(channelContext == NULL || chunk == NULL)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    Channel_Context_Basic256Sha256 *cc = (Channel_Context_Basic256Sha256 *)channelContext;
+    return UA_OpenSSL_CBC_HMAC_DecryptAndVerify(&cc->symContext,
+                                                EVP_aes_256_cbc(), EVP_sha256(),
+                                                &cc->remoteSymIv,
+                                                &cc->remoteSymEncryptingKey,
+                                                &cc->remoteSymSigningKey,
+                                                chunk, offset);
 }
 
 static UA_StatusCode
@@ -495,7 +515,8 @@ UA_SymEn_Basic256Sha256_encrypt(void *channelContext, UA_ByteString *data) {
         return UA_STATUSCODE_BADINTERNALERROR;
 
     Channel_Context_Basic256Sha256 * cc = (Channel_Context_Basic256Sha256 *) channelContext;
-    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey, data);
+    return UA_OpenSSL_AES_256_CBC_Encrypt(&cc->localSymIv, &cc->localSymEncryptingKey, data,
+                                          &cc->symContext.encrypt);
 }
 
 static UA_StatusCode
@@ -621,6 +642,9 @@ UA_SecurityPolicy_Basic256Sha256(UA_SecurityPolicy *policy,
     symSignatureAlgorithm->getRemoteKeyLength =
         UA_SymSig_Basic256Sha256_getRemoteKeyLength;
 
+    /* Decrypt and verify symmetric chunks in one pass */
+    symmetricModule->cryptoModule.decryptAndVerify = UA_SymEn_Basic256Sha256_decryptAndVerify;
+
     policy->updateCertificateAndPrivateKey =
         updateCertificateAndPrivateKey_sp_basic256sha256;
     policy->clear = UA_Policy_Clear_Context;
@@ -17,7 +17,6 @@
 static pthread_mutex_t initLock128_g = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
-#define MAX_ENCRYPTION_SIZE 16
 #define SIGNATURE_LENGTH 32
 #define UA_AES128CTR_MESSAGENONCE_LENGTH 8
 #define UA_AES128CTR_KEYNONCE_LENGTH 4
@@ -25,6 +24,8 @@ static pthread_mutex_t initLock128_g = PTHREAD_MUTEX_INITIALIZER;
 // for details
 #define UA_AES128CTR_COUNTERBLOCK_SIZE 16
 
+static UA_Boolean cryptokiInitialized128_g = false;
+
 char *encryptionKeyLabel128_g;
 char *signingKeyLabel128_g;
 char *userPin128_g;
@@ -32,9 +33,16 @@ unsigned long slotId128_g;
 
 CK_MECHANISM smech_128 = {CKM_SHA256_HMAC, NULL_PTR, 0};
 
+/* Every round-trip to the token is expensive. So the session is opened and the
+ * key objects are looked up only once. They are shared by all channel contexts
+ * and released when the policy is cleared. */
 typedef struct {
     UA_PubSubSecurityPolicy *securityPolicy;
+    UA_Boolean sessionOpen;
     unsigned long sessionHandle;
+    UA_Boolean keysFound;
+    unsigned long signingKeyHandle;
+    unsigned long encryptingKeyHandle;
 } PUBSUB_AES128CTR_PolicyContext;
 
 typedef struct {
@@ -100,14 +108,13 @@ static UA_StatusCode getSessionHandle(unsigned long *session,
     unsigned long *pSlotList = NULL;
     unsigned long availableSlotId=0;
     unsigned long int slotCount=0;
-    static bool cryptokiInitialized = false;
     UA_StatusCode rv = UA_STATUSCODE_GOOD;
 
     /* Set locking flag */
     memset(&initArgs, 0, sizeof(initArgs));
     initArgs.flags = CKF_OS_LOCKING_OK;
 
-    if(!cryptokiInitialized) {
+    if(!cryptokiInitialized128_g) {
         /* Initializes the Cryptoki library */
         rv = (UA_StatusCode)C_Initialize(&initArgs);
         if (rv != UA_STATUSCODE_GOOD) {
@@ -115,7 +122,7 @@ static UA_StatusCode getSessionHandle(unsigned long *session,
                           "Failed to initialize 0x%.8lX", (long unsigned int)rv);
             return EXIT_FAILURE;
         }
-        cryptokiInitialized = true;
+        cryptokiInitialized128_g = true;
     }
 
     /* To obtain the address of the list of slots in the system */
@@ -187,7 +194,7 @@ static UA_StatusCode getSessionHandle(unsigned long *session,
     return rv;
 }
 
-static UA_StatusCode getSecurityKeys(PUBSUB_AES128CTR_ChannelContext *cc) {
+static UA_StatusCode getSecurityKeys(PUBSUB_AES128CTR_PolicyContext *pc) {
     UA_Boolean keyObjectFound = UA_FALSE;
     CK_OBJECT_CLASS keyClass = CKO_SECRET_KEY;
     CK_KEY_TYPE keyType = CKK_AES;
@@ -199,25 +206,25 @@ static UA_StatusCode getSecurityKeys(PUBSUB_AES128CTR_ChannelContext *cc) {
     };
 
     /* Initializes a search for token and session objects that match a template */
-    UA_StatusCode rv = (UA_StatusCode)C_FindObjectsInit(cc->policyContext->sessionHandle, attrTemplate, sizeof(attrTemplate)/sizeof (CK_ATTRIBUTE));
+    UA_StatusCode rv = (UA_StatusCode)C_FindObjectsInit(pc->sessionHandle, attrTemplate, sizeof(attrTemplate)/sizeof (CK_ATTRIBUTE));
     if (rv == UA_STATUSCODE_GOOD) {
-        keyObjectFound = pkcs11_find_object_by_label(cc->policyContext->securityPolicy,
-                                                     cc->policyContext->sessionHandle, encryptionKeyLabel128_g,
-                                                     &cc->encryptingKeyHandle);
+        keyObjectFound = pkcs11_find_object_by_label(pc->securityPolicy,
+                                                     pc->sessionHandle, encryptionKeyLabel128_g,
+                                                     &pc->encryptingKeyHandle);
         if (keyObjectFound == UA_FALSE)
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+            UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                          "Finding object failed");
 
         /* Terminates a search for token and session objects */
-        rv = (UA_StatusCode)C_FindObjectsFinal(cc->policyContext->sessionHandle);
+        rv = (UA_StatusCode)C_FindObjectsFinal(pc->sessionHandle);
         if (rv != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+            UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                          "Finding object failed 0x%.8lX", (long unsigned int)rv);
             return rv;
         }
 
     } else {
-        UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+        UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                      "Find object initialization failed 0x%.8lX", (long unsigned int)rv);
         return rv;
     }
@@ -231,24 +238,24 @@ static UA_StatusCode getSecurityKeys(PUBSUB_AES128CTR_ChannelContext *cc) {
         {CKA_LABEL, (void *)signingKeyLabel128_g, strlen(signingKeyLabel128_g)}
     };
 
-    rv = (UA_StatusCode)C_FindObjectsInit(cc->policyContext->sessionHandle, attrTemplateSigningKey, sizeof(attrTemplateSigningKey)/sizeof (CK_ATTRIBUTE));
+    rv = (UA_StatusCode)C_FindObjectsInit(pc->sessionHandle, attrTemplateSigningKey, sizeof(attrTemplateSigningKey)/sizeof (CK_ATTRIBUTE));
     if (rv == UA_STATUSCODE_GOOD) {
-        signingKeyObjectFound = pkcs11_find_object_by_label(cc->policyContext->securityPolicy,
-                                                            cc->policyContext->sessionHandle, signingKeyLabel128_g,
-                                                            &cc->signingKeyHandle);
+        signingKeyObjectFound = pkcs11_find_object_by_label(pc->securityPolicy,
+                                                            pc->sessionHandle, signingKeyLabel128_g,
+                                                            &pc->signingKeyHandle);
         if (signingKeyObjectFound == false){
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+            UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                          "Finding object signing key failed");
             return EXIT_FAILURE;
         }
 
-        rv = (UA_StatusCode)C_FindObjectsFinal(cc->policyContext->sessionHandle);
+        rv = (UA_StatusCode)C_FindObjectsFinal(pc->sessionHandle);
         if (rv != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+            UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                          "FindObjectsFinal failed for signing key 0x%.8lX", (long unsigned int)rv);
         }
     } else {
-        UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+        UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                      "Finding object signing key init failed 0x%.8lX", (long unsigned int)rv);
         return rv;
     }
@@ -269,32 +276,40 @@ channelContext_newContext_sp_pubsub_aes128ctr_tpm(void *policyContext,
     if(cc == NULL)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    cc->policyContext = (PUBSUB_AES128CTR_PolicyContext *)policyContext;
+    PUBSUB_AES128CTR_PolicyContext *pc = (PUBSUB_AES128CTR_PolicyContext *)policyContext;
+    cc->policyContext = pc;
 
 #if UA_MULTITHREADING >= 100
     pthread_mutex_lock(&initLock128_g);
 #endif
 
-    unsigned long session;
-    UA_StatusCode rv = getSessionHandle(&session, cc->policyContext);
-    if (rv != UA_STATUSCODE_GOOD)
-    {
-        UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                     "Initialize session failed 0x%.8lX", (long unsigned int)rv);
-        return rv;
+    /* Open the session only for the first context */
+    UA_StatusCode rv = UA_STATUSCODE_GOOD;
+    if(!pc->sessionOpen) {
+        unsigned long session = 0;
+        rv = getSessionHandle(&session, pc);
+        if(rv != UA_STATUSCODE_GOOD) {
+            UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                         "Initialize session failed 0x%.8lX", (long unsigned int)rv);
+            goto error;
+        }
+        pc->sessionHandle = session;
+        pc->sessionOpen = true;
     }
 
-    /* Initialize the channel context */
-    if(session)
-        memcpy(&cc->policyContext->sessionHandle, &session, sizeof(session));
-
-    if (signingKey->length == 0 && encryptingKey->length == 0) {
-        rv = getSecurityKeys(cc);
-        if (rv != UA_STATUSCODE_GOOD){
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                         "getSecurityKeys failed 0x%.8lX", (long unsigned int)rv);
-            return rv;
+    if(signingKey->length == 0 && encryptingKey->length == 0) {
+        /* Look up the key objects by their label only once */
+        if(!pc->keysFound) {
+            rv = getSecurityKeys(pc);
+            if(rv != UA_STATUSCODE_GOOD) {
+                UA_LOG_ERROR(pc->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
+                             "getSecurityKeys failed 0x%.8lX", (long unsigned int)rv);
+                goto error;
+            }
+            pc->keysFound = true;
         }
+        cc->encryptingKeyHandle = pc->encryptingKeyHandle;
+        cc->signingKeyHandle = pc->signingKeyHandle;
     } else {
         memcpy(&cc->encryptingKeyHandle, encryptingKey->data, sizeof(encryptingKey));
         memcpy(&cc->signingKeyHandle, signingKey->data, sizeof(signingKey));
@@ -309,18 +324,18 @@ channelContext_newContext_sp_pubsub_aes128ctr_tpm(void *policyContext,
 #endif
 
     return UA_STATUSCODE_GOOD;
+
+ error:
+#if UA_MULTITHREADING >= 100
+    pthread_mutex_unlock(&initLock128_g);
+#endif
+    UA_free(cc);
+    return rv;
 }
 
+/* The session and the key handles are owned by the policy context */
 static void
 channelContext_deleteContext_sp_pubsub_aes128ctr_tpm(PUBSUB_AES128CTR_ChannelContext *cc) {
-    /* Logs a user out from a token */
-    C_Logout(cc->policyContext->sessionHandle);
-    /* Closes a session between an application and a token */
-    C_CloseSession(cc->policyContext->sessionHandle);
-    /* Clean up miscellaneous Cryptoki-associated resources */
-    C_Finalize(NULL);
-
-    UA_free(cc->policyContext);
     UA_free(cc);
 }
 
@@ -383,73 +398,53 @@ verify_sp_pubsub_aes128ctr_tpm(PUBSUB_AES128CTR_ChannelContext *cc,
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+setCounterBlock_sp_pubsub_aes128ctr_tpm(const PUBSUB_AES128CTR_ChannelContext *cc,
+                                        CK_AES_CTR_PARAMS *params) {
+    /* Prepare the counterBlock required for en-/decryption */
+    UA_Byte counterBlock[UA_AES128CTR_COUNTERBLOCK_SIZE];
+    memcpy(counterBlock, &cc->keyNonceHandle, UA_AES128CTR_KEYNONCE_LENGTH);
+    memcpy(counterBlock + UA_AES128CTR_KEYNONCE_LENGTH,
+           &cc->messageNonceHandle, UA_AES128CTR_MESSAGENONCE_LENGTH);
+    memset(counterBlock + UA_AES128CTR_KEYNONCE_LENGTH +
+           UA_AES128CTR_MESSAGENONCE_LENGTH, 0, 4);
+
+    params->ulCounterBits = sizeof(params->cb) * 8;
+    memcpy(params->cb, counterBlock, sizeof(params->cb));
+}
+
+/* The message is en-/decrypted in-place with a single-part operation. That is
+ * one round-trip to the token per message instead of one per block. CTR mode
+ * does not need padding. */
 static UA_StatusCode
 encrypt_sp_pubsub_aes128ctr_tpm(const PUBSUB_AES128CTR_ChannelContext *cc, UA_ByteString *data) {
 
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    CK_BYTE sizeToEncrypt;
-    int partNumber     = 0;
-    CK_ULONG decLen    = 16;
-    CK_BYTE final      = 0;
-    CK_ULONG finalLen  = 0;
-    UA_StatusCode rv   = UA_STATUSCODE_GOOD;
-    CK_AES_CTR_PARAMS params_encrupt_128;
-
-    /* Prepare the counterBlock required for encryption */
-    UA_Byte counterBlockEncrypt[UA_AES128CTR_COUNTERBLOCK_SIZE];
-    memcpy(counterBlockEncrypt, &cc->keyNonceHandle, UA_AES128CTR_KEYNONCE_LENGTH);
-    memcpy(counterBlockEncrypt + UA_AES128CTR_KEYNONCE_LENGTH,
-           &cc->messageNonceHandle, UA_AES128CTR_MESSAGENONCE_LENGTH);
-    memset(counterBlockEncrypt + UA_AES128CTR_KEYNONCE_LENGTH +
-           UA_AES128CTR_MESSAGENONCE_LENGTH, 0, 4);
-
-    params_encrupt_128.ulCounterBits = sizeof(params_encrupt_128.cb) * 8;
-    memcpy(params_encrupt_128.cb, counterBlockEncrypt, sizeof(params_encrupt_128.cb));
-    CK_MECHANISM mech_128 = {CKM_AES_CTR, &params_encrupt_128, sizeof(params_encrupt_128)};
+    CK_AES_CTR_PARAMS params_encrypt_128;
+    setCounterBlock_sp_pubsub_aes128ctr_tpm(cc, &params_encrypt_128);
+    CK_MECHANISM mech_128 = {CKM_AES_CTR, &params_encrypt_128, sizeof(params_encrypt_128)};
 
     /* Initializes an encryption operation */
-    rv = (UA_StatusCode)C_EncryptInit(cc->policyContext->sessionHandle, &mech_128, cc->encryptingKeyHandle);
+    UA_StatusCode rv = (UA_StatusCode)
+        C_EncryptInit(cc->policyContext->sessionHandle, &mech_128, cc->encryptingKeyHandle);
     if (rv != UA_STATUSCODE_GOOD) {
          UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                       "Encrypt initialization failed 0x%.8lX", (long unsigned int)rv);
         return rv;
     }
 
-    if ((data->length % MAX_ENCRYPTION_SIZE) != 0)
-        sizeToEncrypt = (CK_BYTE)(data->length + (MAX_ENCRYPTION_SIZE - (data->length % MAX_ENCRYPTION_SIZE)));
-    else
-        sizeToEncrypt = (CK_BYTE)data->length;
-
-    CK_BYTE *cipherText = (CK_BYTE*)UA_malloc(sizeToEncrypt * sizeof(CK_BYTE));
-    while(rv == UA_STATUSCODE_GOOD && partNumber * MAX_ENCRYPTION_SIZE <= sizeToEncrypt - MAX_ENCRYPTION_SIZE) {
-        /* Continues a multiple-part encryption operation, processing another data part */
-        rv = (UA_StatusCode)C_EncryptUpdate(cc->policyContext->sessionHandle,
-                                            &data->data[partNumber*MAX_ENCRYPTION_SIZE], MAX_ENCRYPTION_SIZE,
-                                            &cipherText[partNumber*MAX_ENCRYPTION_SIZE], &decLen);
-        if (UA_STATUSCODE_GOOD != rv) {
-             UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                         "Encrypt update failed 0x%.8lX", (long unsigned int)rv);
-            goto cleanup;
-        }
-
-        partNumber++;
-    }
-
-    /* Finishes a multiple-part encryption operation */
-    rv = (UA_StatusCode)C_EncryptFinal(cc->policyContext->sessionHandle, &final, &finalLen);
-    if (UA_STATUSCODE_GOOD != rv) {
+    /* Encrypts single-part data */
+    CK_ULONG encLen = (CK_ULONG)data->length;
+    rv = (UA_StatusCode)C_Encrypt(cc->policyContext->sessionHandle,
+                                  data->data, (CK_ULONG)data->length,
+                                  data->data, &encLen);
+    if (rv != UA_STATUSCODE_GOOD) {
          UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                      "Encrypt final failed 0x%.8lX", (long unsigned int)rv);
-        goto cleanup;
+                      "Encrypt failed 0x%.8lX", (long unsigned int)rv);
+        return rv;
     }
-
-    for (int i=0; i< sizeToEncrypt; i++)
-        data->data[i] = cipherText[i];
-
-cleanup:
-    UA_free(cipherText);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -459,66 +454,28 @@ decrypt_sp_pubsub_aes128ctr_tpm(const PUBSUB_AES128CTR_ChannelContext *cc, UA_By
     if(cc == NULL || data == NULL)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    UA_StatusCode rv          = UA_STATUSCODE_GOOD;
-    int decodePartNumber      = 0;
-    CK_ULONG decodeDecLen     = 16;
-    CK_BYTE decodeFinal       = 0;
-    CK_ULONG decodeFinalLen   = 0;
-    CK_BYTE sizeToDecrypt;
     CK_AES_CTR_PARAMS params_decrypt_128;
-
-    /* Prepare the counterBlock required for decryption */
-    UA_Byte counterBlockDecrypt[UA_AES128CTR_COUNTERBLOCK_SIZE];
-    memcpy(counterBlockDecrypt, &cc->keyNonceHandle, UA_AES128CTR_KEYNONCE_LENGTH);
-    memcpy(counterBlockDecrypt + UA_AES128CTR_KEYNONCE_LENGTH,
-           &cc->messageNonceHandle, UA_AES128CTR_MESSAGENONCE_LENGTH);
-    memset(counterBlockDecrypt + UA_AES128CTR_KEYNONCE_LENGTH +
-           UA_AES128CTR_MESSAGENONCE_LENGTH, 0, 4);
-
-    params_decrypt_128.ulCounterBits = sizeof(params_decrypt_128.cb) * 8;
-    memcpy(params_decrypt_128.cb, counterBlockDecrypt, sizeof(params_decrypt_128.cb));
+    setCounterBlock_sp_pubsub_aes128ctr_tpm(cc, &params_decrypt_128);
     CK_MECHANISM mech_128 = {CKM_AES_CTR, &params_decrypt_128, sizeof(params_decrypt_128)};
 
-    rv = (UA_StatusCode)C_DecryptInit(cc->policyContext->sessionHandle, &mech_128, cc->encryptingKeyHandle);
+    UA_StatusCode rv = (UA_StatusCode)
+        C_DecryptInit(cc->policyContext->sessionHandle, &mech_128, cc->encryptingKeyHandle);
     if (rv != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
                      "Decrypt init failed 0x%.8lX", (long unsigned int)rv);
         return rv;
     }
 
-    if ((data->length % MAX_ENCRYPTION_SIZE) != 0)
-        sizeToDecrypt = (CK_BYTE)(data->length + (MAX_ENCRYPTION_SIZE - (data->length % MAX_ENCRYPTION_SIZE)));
-    else
-        sizeToDecrypt = (CK_BYTE)data->length;
-
-    CK_BYTE *decodeCiphertext = (CK_BYTE*)UA_malloc(sizeToDecrypt * sizeof(CK_BYTE));
-
-    while(rv == UA_STATUSCODE_GOOD && decodePartNumber * MAX_ENCRYPTION_SIZE <= sizeToDecrypt - MAX_ENCRYPTION_SIZE) {
-        rv = (UA_StatusCode)C_DecryptUpdate(cc->policyContext->sessionHandle,
-                                            &data->data[decodePartNumber*MAX_ENCRYPTION_SIZE], MAX_ENCRYPTION_SIZE,
-                                            &decodeCiphertext[decodePartNumber*MAX_ENCRYPTION_SIZE], &decodeDecLen);
-
-        if (rv != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                         "Decrypt update failed 0x%.8lX", (long unsigned int)rv);
-            goto cleanup;
-        }
-
-        decodePartNumber++;
-    }
-
-    rv = (UA_StatusCode)C_DecryptFinal(cc->policyContext->sessionHandle, &decodeFinal, &decodeFinalLen);
+    /* Decrypts encrypted data in a single part */
+    CK_ULONG decLen = (CK_ULONG)data->length;
+    rv = (UA_StatusCode)C_Decrypt(cc->policyContext->sessionHandle,
+                                  data->data, (CK_ULONG)data->length,
+                                  data->data, &decLen);
     if (rv != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(cc->policyContext->securityPolicy->logger, UA_LOGCATEGORY_SECURITYPOLICY,
-                     "Decrypt final failed 0x%.8lX", (long unsigned int)rv);
-        goto cleanup;
+                     "Decrypt failed 0x%.8lX", (long unsigned int)rv);
+        return rv;
     }
-
-    for (int i=0; i< sizeToDecrypt; i++)
-        data->data[i] = decodeCiphertext[i];
-
-cleanup:
-    UA_free(decodeCiphertext);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -538,7 +495,23 @@ getSignatureSize_sp_pubsub_aes128ctr_tpm(const void *channelContext) {
 
 static void
 deleteMembers_sp_pubsub_aes128ctr_tpm(UA_PubSubSecurityPolicy *policy) {
-    /* Can be used for future implementation */
+    PUBSUB_AES128CTR_PolicyContext *pc =
+        (PUBSUB_AES128CTR_PolicyContext *)policy->policyContext;
+    if(!pc)
+        return;
+
+    if(pc->sessionOpen) {
+        /* Logs a user out from a token */
+        C_Logout(pc->sessionHandle);
+        /* Closes a session between an application and a token */
+        C_CloseSession(pc->sessionHandle);
+        /* Clean up miscellaneous Cryptoki-associated resources */
+        C_Finalize(NULL);
+        cryptokiInitialized128_g = false;
+    }
+
+    UA_free(pc);
+    policy->policyContext = NULL;
 }
 
 static UA_StatusCode
@@ -0,0 +1,1239 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_data_backend_file.h>
+
+#if defined(__linux__) || defined(__unix__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FILE_INDEX_STRIDE 16       /* Values per index entry */
+#define FILE_BATCH_SIZE 65536      /* Pending bytes that trigger a write */
+#define FILE_MAP_MINSIZE (1 << 20) /* The mappings grow by doubling */
+
+/* Every record is aligned to 8 bytes */
+typedef struct {
+    UA_UInt32 length; /* Of the encoded DataValue */
+    UA_UInt32 reserved;
+    UA_DateTime timestamp;
+} UA_FileRecordHeader;
+
+#define RECORD_SIZE(len) \
+    (sizeof(UA_FileRecordHeader) + (((size_t)(len) + 7) & ~(size_t)7))
+
+typedef struct {
+    UA_DateTime timestamp;
+    UA_UInt64 offset;
+} UA_FileIndexEntry;
+
+/* A file that is appended to. The appended data is pending in memory until it
+ * is written. Reading is done from the read-only mapping. */
+typedef struct {
+    int fd;
+    size_t size; /* Bytes written to the file */
+    UA_Byte *map;
+    size_t mapSize;
+    UA_Byte *pending;
+    size_t pendingSize;
+    size_t pendingCapacity;
+} UA_AppendFile;
+
+typedef struct {
+    UA_NodeId nodeId;
+    char *path; /* Without the suffix */
+    UA_AppendFile seg;
+    UA_AppendFile idx;
+    size_t count;
+    UA_DateTime last;
+    UA_Boolean dirty; /* Written but not synced */
+    size_t version;   /* Incremented when the segment is rewritten */
+} UA_FileSeries;
+
+typedef struct {
+    char *directory;
+    UA_FileSeries **series;
+    size_t seriesSize;
+    UA_UInt32 syncInterval;
+    UA_DataValue scratch; /* Returned from getDataValue */
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+    pthread_t thread;
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t sleepCond;
+    UA_Boolean running;
+#else
+    UA_DateTime lastSync;
+#endif
+} UA_FileStoreContext;
+
+/***************/
+/* Append File */
+/***************/
+
+static UA_StatusCode
+UA_AppendFile_open(UA_AppendFile *f, const char *path, UA_Boolean truncate) {
+    memset(f, 0, sizeof(UA_AppendFile));
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+    if(truncate)
+        flags |= O_TRUNC;
+    f->fd = open(path, flags, 0644);
+    if(f->fd < 0)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    struct stat st;
+    if(fstat(f->fd, &st) != 0) {
+        close(f->fd);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+    f->size = (size_t)st.st_size;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+UA_AppendFile_close(UA_AppendFile *f) {
+    if(f->map)
+        munmap(f->map, f->mapSize);
+    if(f->fd >= 0)
+        close(f->fd);
+    UA_free(f->pending);
+    memset(f, 0, sizeof(UA_AppendFile));
+    f->fd = -1;
+}
+
+/* Returns zeroed space at the end of the pending data */
+static UA_Byte *
+UA_AppendFile_reserve(UA_AppendFile *f, size_t len) {
+    if(f->pendingSize + len > f->pendingCapacity) {
+        size_t cap = (f->pendingCapacity > 0) ? f->pendingCapacity : 1024;
+        while(cap < f->pendingSize + len)
+            cap *= 2;
+        UA_Byte *p = (UA_Byte*)UA_realloc(f->pending, cap);
+        if(!p)
+            return NULL;
+        f->pending = p;
+        f->pendingCapacity = cap;
+    }
+    UA_Byte *pos = &f->pending[f->pendingSize];
+    memset(pos, 0, len);
+    f->pendingSize += len;
+    return pos;
+}
+
+static UA_StatusCode
+UA_AppendFile_write(UA_AppendFile *f) {
+    size_t done = 0;
+    while(done < f->pendingSize) {
+        ssize_t n = pwrite(f->fd, &f->pending[done], f->pendingSize - done,
+                           (off_t)(f->size + done));
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0) {
+            /* Keep the rest pending */
+            memmove(f->pending, &f->pending[done], f->pendingSize - done);
+            f->pendingSize -= done;
+            f->size += done;
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+        done += (size_t)n;
+    }
+    f->size += done;
+    f->pendingSize = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+UA_AppendFile_truncate(UA_AppendFile *f, size_t size) {
+    if(ftruncate(f->fd, (off_t)size) != 0)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    f->size = size;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Ensure the mapping covers the written part of the file. The mapping is
+ * larger than the file, so that it does not need to be renewed for every
+ * write. Only the part within the file size is accessed. */
+static UA_StatusCode
+UA_AppendFile_map(UA_AppendFile *f) {
+    if(f->size <= f->mapSize)
+        return UA_STATUSCODE_GOOD;
+    if(f->map)
+        munmap(f->map, f->mapSize);
+    f->map = NULL;
+    f->mapSize = 0;
+    size_t len = FILE_MAP_MINSIZE;
+    while(len < f->size * 2)
+        len *= 2;
+    void *m = mmap(NULL, len, PROT_READ, MAP_SHARED, f->fd, 0);
+    if(m == MAP_FAILED)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    f->map = (UA_Byte*)m;
+    f->mapSize = len;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**********/
+/* Series */
+/**********/
+
+static UA_FileRecordHeader
+readHeader(const UA_FileSeries *s, size_t offset) {
+    UA_FileRecordHeader hdr;
+    memcpy(&hdr, &s->seg.map[offset], sizeof(UA_FileRecordHeader));
+    return hdr;
+}
+
+static UA_FileIndexEntry
+readIndexEntry(const UA_FileSeries *s, size_t entry) {
+    UA_FileIndexEntry e;
+    memcpy(&e, &s->idx.map[entry * sizeof(UA_FileIndexEntry)],
+           sizeof(UA_FileIndexEntry));
+    return e;
+}
+
+static UA_StatusCode
+addIndexEntry(UA_FileSeries *s, UA_DateTime timestamp, size_t offset) {
+    if(s->count % FILE_INDEX_STRIDE != 0)
+        return UA_STATUSCODE_GOOD;
+    UA_Byte *pos = UA_AppendFile_reserve(&s->idx, sizeof(UA_FileIndexEntry));
+    if(!pos)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_FileIndexEntry e;
+    e.timestamp = timestamp;
+    e.offset = offset;
+    memcpy(pos, &e, sizeof(UA_FileIndexEntry));
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+appendRecord(UA_FileSeries *s, const UA_DataValue *value, UA_DateTime timestamp) {
+    size_t len = UA_calcSizeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(len == 0 || len > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADENCODINGERROR;
+    size_t recSize = RECORD_SIZE(len);
+    size_t offset = s->seg.size + s->seg.pendingSize;
+    UA_Byte *pos = UA_AppendFile_reserve(&s->seg, recSize);
+    if(!pos)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_FileRecordHeader hdr;
+    memset(&hdr, 0, sizeof(UA_FileRecordHeader));
+    hdr.length = (UA_UInt32)len;
+    hdr.timestamp = timestamp;
+    memcpy(pos, &hdr, sizeof(UA_FileRecordHeader));
+    UA_ByteString buf = {len, &pos[sizeof(UA_FileRecordHeader)]};
+    UA_StatusCode res = UA_encodeBinary(value, &UA_TYPES[UA_TYPES_DATAVALUE], &buf);
+    if(res == UA_STATUSCODE_GOOD)
+        res = addIndexEntry(s, timestamp, offset);
+    if(res != UA_STATUSCODE_GOOD) {
+        s->seg.pendingSize -= recSize;
+        return res;
+    }
+    s->count++;
+    s->last = timestamp;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Copy an encoded record from another segment */
+static UA_StatusCode
+appendRawRecord(UA_FileSeries *s, const UA_Byte *record) {
+    UA_FileRecordHeader hdr;
+    memcpy(&hdr, record, sizeof(UA_FileRecordHeader));
+    size_t recSize = RECORD_SIZE(hdr.length);
+    size_t offset = s->seg.size + s->seg.pendingSize;
+    UA_Byte *pos = UA_AppendFile_reserve(&s->seg, recSize);
+    if(!pos)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    memcpy(pos, record, recSize);
+    UA_StatusCode res = addIndexEntry(s, hdr.timestamp, offset);
+    if(res != UA_STATUSCODE_GOOD) {
+        s->seg.pendingSize -= recSize;
+        return res;
+    }
+    s->count++;
+    s->last = hdr.timestamp;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The segment is written first. So the index never points beyond it. */
+static UA_StatusCode
+writePending(UA_FileSeries *s) {
+    if(s->seg.pendingSize == 0 && s->idx.pendingSize == 0)
+        return UA_STATUSCODE_GOOD;
+    s->dirty = true;
+    UA_StatusCode res = UA_AppendFile_write(&s->seg);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return UA_AppendFile_write(&s->idx);
+}
+
+static UA_StatusCode
+prepareRead(UA_FileSeries *s) {
+    UA_StatusCode res = writePending(s);
+    res |= UA_AppendFile_map(&s->seg);
+    res |= UA_AppendFile_map(&s->idx);
+    return res;
+}
+
+static size_t
+recordOffset(const UA_FileSeries *s, size_t index) {
+    size_t offset = (size_t)readIndexEntry(s, index / FILE_INDEX_STRIDE).offset;
+    for(size_t i = index % FILE_INDEX_STRIDE; i > 0; i--)
+        offset += RECORD_SIZE(readHeader(s, offset).length);
+    return offset;
+}
+
+static UA_StatusCode
+decodeRecord(const UA_FileSeries *s, size_t offset, UA_DataValue *dv) {
+    UA_FileRecordHeader hdr = readHeader(s, offset);
+    UA_ByteString buf = {hdr.length, &s->seg.map[offset + sizeof(UA_FileRecordHeader)]};
+    return UA_decodeBinary(&buf, dv, &UA_TYPES[UA_TYPES_DATAVALUE], NULL);
+}
+
+/* Index of the first value with a timestamp >= the given timestamp. The
+ * series must be prepared for reading. */
+static size_t
+lowerBound(const UA_FileSeries *s, UA_DateTime timestamp, UA_Boolean *equal) {
+    *equal = false;
+    if(s->count == 0)
+        return 0;
+
+    /* Find the first index entry at or after the timestamp */
+    size_t lo = 0;
+    size_t hi = (s->count + FILE_INDEX_STRIDE - 1) / FILE_INDEX_STRIDE;
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(readIndexEntry(s, mid).timestamp < timestamp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Scan the records from the previous entry */
+    size_t entry = (lo > 0) ? lo - 1 : 0;
+    size_t index = entry * FILE_INDEX_STRIDE;
+    size_t offset = (size_t)readIndexEntry(s, entry).offset;
+    for(; index < s->count; index++) {
+        UA_FileRecordHeader hdr = readHeader(s, offset);
+        if(hdr.timestamp >= timestamp) {
+            *equal = (hdr.timestamp == timestamp);
+            return index;
+        }
+        offset += RECORD_SIZE(hdr.length);
+    }
+    return s->count;
+}
+
+/* Count the records and cut off a torn write at the end. Rebuild the index if
+ * it does not match the segment. */
+static UA_StatusCode
+recoverSeries(UA_FileSeries *s) {
+    UA_StatusCode res = UA_AppendFile_map(&s->seg);
+    res |= UA_AppendFile_map(&s->idx);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    size_t entries = s->idx.size / sizeof(UA_FileIndexEntry);
+    UA_Boolean indexValid = (s->idx.size % sizeof(UA_FileIndexEntry) == 0);
+    size_t offset = 0;
+    size_t count = 0;
+    UA_DateTime last = LLONG_MIN;
+    while(offset + sizeof(UA_FileRecordHeader) <= s->seg.size) {
+        UA_FileRecordHeader hdr = readHeader(s, offset);
+        size_t recSize = RECORD_SIZE(hdr.length);
+        if(hdr.length == 0 || recSize > s->seg.size - offset || hdr.timestamp < last)
+            break;
+        if(count % FILE_INDEX_STRIDE == 0 && indexValid) {
+            size_t j = count / FILE_INDEX_STRIDE;
+            if(j >= entries) {
+                indexValid = false;
+            } else {
+                UA_FileIndexEntry e = readIndexEntry(s, j);
+                indexValid = (e.timestamp == hdr.timestamp && e.offset == offset);
+            }
+        }
+        last = hdr.timestamp;
+        offset += recSize;
+        count++;
+    }
+    if(offset < s->seg.size) {
+        res = UA_AppendFile_truncate(&s->seg, offset);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    if(entries != (count + FILE_INDEX_STRIDE - 1) / FILE_INDEX_STRIDE)
+        indexValid = false;
+
+    if(!indexValid) {
+        res = UA_AppendFile_truncate(&s->idx, 0);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        s->count = 0;
+        offset = 0;
+        for(size_t i = 0; i < count; i++) {
+            UA_FileRecordHeader hdr = readHeader(s, offset);
+            res = addIndexEntry(s, hdr.timestamp, offset);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+            s->count++;
+            offset += RECORD_SIZE(hdr.length);
+        }
+        res = UA_AppendFile_write(&s->idx);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        s->dirty = true;
+    }
+    s->count = count;
+    s->last = last;
+    return UA_STATUSCODE_GOOD;
+}
+
+static char *
+filePath(const char *base, const char *suffix) {
+    size_t len = strlen(base) + strlen(suffix) + 1;
+    char *path = (char*)UA_malloc(len);
+    if(path)
+        snprintf(path, len, "%s%s", base, suffix);
+    return path;
+}
+
+/* The printed NodeId with all unsafe characters escaped */
+static char *
+seriesPath(const char *directory, const UA_NodeId *nodeId) {
+    UA_String id = UA_STRING_NULL;
+    if(UA_NodeId_print(nodeId, &id) != UA_STATUSCODE_GOOD)
+        return NULL;
+    size_t dirLen = strlen(directory);
+    char *path = (char*)UA_malloc(dirLen + 1 + id.length * 3 + 1);
+    if(!path) {
+        UA_String_clear(&id);
+        return NULL;
+    }
+    memcpy(path, directory, dirLen);
+    size_t pos = dirLen;
+    path[pos++] = '/';
+    for(size_t i = 0; i < id.length; i++) {
+        UA_Byte c = id.data[i];
+        if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' ||
+           c == '=' || c == ';') {
+            path[pos++] = (char)c;
+        } else {
+            snprintf(&path[pos], 4, "%%%02X", c);
+            pos += 3;
+        }
+    }
+    path[pos] = 0;
+    UA_String_clear(&id);
+    return path;
+}
+
+static void
+UA_FileSeries_delete(UA_FileSeries *s) {
+    UA_AppendFile_close(&s->seg);
+    UA_AppendFile_close(&s->idx);
+    UA_NodeId_clear(&s->nodeId);
+    UA_free(s->path);
+    UA_free(s);
+}
+
+static UA_StatusCode
+openSeriesFiles(UA_FileSeries *s, const char *segSuffix, const char *idxSuffix,
+                UA_Boolean truncate) {
+    char *segPath = filePath(s->path, segSuffix);
+    char *idxPath = filePath(s->path, idxSuffix);
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    if(segPath && idxPath) {
+        res = UA_AppendFile_open(&s->seg, segPath, truncate);
+        if(res == UA_STATUSCODE_GOOD) {
+            res = UA_AppendFile_open(&s->idx, idxPath, truncate);
+            if(res != UA_STATUSCODE_GOOD)
+                UA_AppendFile_close(&s->seg);
+        }
+    }
+    UA_free(segPath);
+    UA_free(idxPath);
+    return res;
+}
+
+static UA_FileSeries *
+findSeries(UA_FileStoreContext *ctx, const UA_NodeId *nodeId) {
+    for(size_t i = 0; i < ctx->seriesSize; i++) {
+        if(UA_NodeId_equal(nodeId, &ctx->series[i]->nodeId))
+            return ctx->series[i];
+    }
+    return NULL;
+}
+
+/* Open the files of the node. If create is false, only existing files are
+ * opened. */
+static UA_FileSeries *
+getSeries(UA_FileStoreContext *ctx, const UA_NodeId *nodeId, UA_Boolean create) {
+    UA_FileSeries *s = findSeries(ctx, nodeId);
+    if(s)
+        return s;
+
+    s = (UA_FileSeries*)UA_calloc(1, sizeof(UA_FileSeries));
+    if(!s)
+        return NULL;
+    s->seg.fd = -1;
+    s->idx.fd = -1;
+    s->last = LLONG_MIN;
+    s->path = seriesPath(ctx->directory, nodeId);
+    if(!s->path || UA_NodeId_copy(nodeId, &s->nodeId) != UA_STATUSCODE_GOOD)
+        goto error;
+
+    if(!create) {
+        char *segPath = filePath(s->path, ".seg");
+        int exists = (segPath && access(segPath, F_OK) == 0);
+        UA_free(segPath);
+        if(!exists)
+            goto error;
+    }
+
+    if(openSeriesFiles(s, ".seg", ".idx", false) != UA_STATUSCODE_GOOD ||
+       recoverSeries(s) != UA_STATUSCODE_GOOD)
+        goto error;
+
+    UA_FileSeries **series = (UA_FileSeries**)
+        UA_realloc(ctx->series, (ctx->seriesSize + 1) * sizeof(UA_FileSeries*));
+    if(!series)
+        goto error;
+    ctx->series = series;
+    ctx->series[ctx->seriesSize++] = s;
+    return s;
+
+ error:
+    UA_FileSeries_delete(s);
+    return NULL;
+}
+
+/* Replace the values [from, to) with the value (if defined). The segment is
+ * rewritten into temporary files that replace the original. */
+static UA_StatusCode
+rewriteSeries(UA_FileSeries *s, size_t from, size_t to,
+              const UA_DataValue *value, UA_DateTime timestamp) {
+    UA_StatusCode res = prepareRead(s);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_FileSeries n;
+    memset(&n, 0, sizeof(UA_FileSeries));
+    n.path = s->path;
+    n.last = LLONG_MIN;
+    res = openSeriesFiles(&n, ".seg.tmp", ".idx.tmp", true);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    size_t offset = 0;
+    for(size_t i = 0; i <= s->count && res == UA_STATUSCODE_GOOD; i++) {
+        if(i == from && value)
+            res |= appendRecord(&n, value, timestamp);
+        if(i == s->count)
+            break;
+        if(i < from || i >= to)
+            res |= appendRawRecord(&n, &s->seg.map[offset]);
+        offset += RECORD_SIZE(readHeader(s, offset).length);
+        if(n.seg.pendingSize >= FILE_BATCH_SIZE)
+            res |= writePending(&n);
+    }
+    res |= writePending(&n);
+    if(res == UA_STATUSCODE_GOOD &&
+       (fsync(n.seg.fd) != 0 || fsync(n.idx.fd) != 0))
+        res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+
+    /* Replace the files. If the index is not renamed, it is rebuilt when the
+     * files are opened the next time. */
+    char *segTmp = filePath(s->path, ".seg.tmp");
+    char *idxTmp = filePath(s->path, ".idx.tmp");
+    char *segPath = filePath(s->path, ".seg");
+    char *idxPath = filePath(s->path, ".idx");
+    if(!segTmp || !idxTmp || !segPath || !idxPath)
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+    if(res == UA_STATUSCODE_GOOD &&
+       (rename(segTmp, segPath) != 0 || rename(idxTmp, idxPath) != 0))
+        res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    if(res != UA_STATUSCODE_GOOD) {
+        if(segTmp)
+            unlink(segTmp);
+        if(idxTmp)
+            unlink(idxTmp);
+        UA_AppendFile_close(&n.seg);
+        UA_AppendFile_close(&n.idx);
+    } else {
+        UA_AppendFile_close(&s->seg);
+        UA_AppendFile_close(&s->idx);
+        s->seg = n.seg;
+        s->idx = n.idx;
+        s->count = n.count;
+        s->last = n.last;
+        s->dirty = false;
+        ++s->version;
+    }
+    UA_free(segTmp);
+    UA_free(idxTmp);
+    UA_free(segPath);
+    UA_free(idxPath);
+    return res;
+}
+
+/********/
+/* Sync */
+/********/
+
+/* Write the pending values and sync the files. The sync is done outside of the
+ * lock on duplicated descriptors. They remain valid if a rewrite replaces the
+ * files in the meantime. */
+static UA_StatusCode
+syncAll(UA_FileStoreContext *ctx) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&ctx->lock);
+    int *fds = (ctx->seriesSize > 0) ?
+        (int*)UA_malloc(ctx->seriesSize * 2 * sizeof(int)) : NULL;
+    size_t fdsSize = 0;
+    for(size_t i = 0; i < ctx->seriesSize; i++) {
+        UA_FileSeries *s = ctx->series[i];
+        res |= writePending(s);
+        if(!s->dirty)
+            continue;
+        s->dirty = false;
+        if(fds) {
+            fds[fdsSize++] = dup(s->seg.fd);
+            fds[fdsSize++] = dup(s->idx.fd);
+        } else if(fsync(s->seg.fd) != 0 || fsync(s->idx.fd) != 0) {
+            res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+    }
+#if UA_MULTITHREADING < 100
+    ctx->lastSync = UA_DateTime_nowMonotonic();
+#endif
+    UA_UNLOCK(&ctx->lock);
+
+    for(size_t i = 0; i < fdsSize; i++) {
+        if(fds[i] < 0 || fsync(fds[i]) != 0)
+            res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        if(fds[i] >= 0)
+            close(fds[i]);
+    }
+    UA_free(fds);
+    return res;
+}
+
+#if UA_MULTITHREADING >= 100
+
+static void *
+syncThread(void *p) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)p;
+    pthread_mutex_lock(&ctx->sleepMutex);
+    while(ctx->running) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += (time_t)(ctx->syncInterval / 1000);
+        ts.tv_nsec += (long)(ctx->syncInterval % 1000) * 1000000L;
+        if(ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&ctx->sleepCond, &ctx->sleepMutex, &ts);
+        if(!ctx->running)
+            break;
+        pthread_mutex_unlock(&ctx->sleepMutex);
+        syncAll(ctx);
+        pthread_mutex_lock(&ctx->sleepMutex);
+    }
+    pthread_mutex_unlock(&ctx->sleepMutex);
+    return NULL;
+}
+
+#else
+
+/* Without a background thread, the sync is done during the writes */
+static void
+syncIfDue(UA_FileStoreContext *ctx) {
+    if(UA_DateTime_nowMonotonic() - ctx->lastSync >=
+       (UA_DateTime)ctx->syncInterval * UA_DATETIME_MSEC)
+        syncAll(ctx);
+}
+
+#endif
+
+static void
+UA_FileStoreContext_delete(UA_FileStoreContext *ctx) {
+#if UA_MULTITHREADING >= 100
+    if(ctx->running) {
+        pthread_mutex_lock(&ctx->sleepMutex);
+        ctx->running = false;
+        pthread_cond_signal(&ctx->sleepCond);
+        pthread_mutex_unlock(&ctx->sleepMutex);
+        pthread_join(ctx->thread, NULL);
+    }
+#endif
+    syncAll(ctx);
+    for(size_t i = 0; i < ctx->seriesSize; i++)
+        UA_FileSeries_delete(ctx->series[i]);
+    UA_free(ctx->series);
+    UA_free(ctx->directory);
+    UA_DataValue_clear(&ctx->scratch);
+#if UA_MULTITHREADING >= 100
+    pthread_cond_destroy(&ctx->sleepCond);
+    pthread_mutex_destroy(&ctx->sleepMutex);
+    UA_LOCK_DESTROY(&ctx->lock);
+#endif
+    UA_free(ctx);
+}
+
+/*******************/
+/* Backend Methods */
+/*******************/
+
+static UA_DateTime
+valueTimestamp(const UA_DataValue *value) {
+    if(value->hasSourceTimestamp)
+        return value->sourceTimestamp;
+    if(value->hasServerTimestamp)
+        return value->serverTimestamp;
+    return UA_DateTime_now();
+}
+
+/* The stored value always has a server timestamp, as in the memory backend */
+static UA_DataValue
+storedValue(const UA_DataValue *value, UA_DateTime timestamp) {
+    UA_DataValue v = *value;
+    if(!v.hasServerTimestamp) {
+        v.serverTimestamp = timestamp;
+        v.hasServerTimestamp = true;
+    }
+    return v;
+}
+
+/* Must be called with the lock held */
+static UA_StatusCode
+setHistoryData(UA_FileStoreContext *ctx, const UA_NodeId *nodeId,
+               const UA_DataValue *value) {
+    UA_FileSeries *s = getSeries(ctx, nodeId, true);
+    if(!s)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    UA_DateTime timestamp = valueTimestamp(value);
+    UA_DataValue v = storedValue(value, timestamp);
+    if(s->count == 0 || timestamp >= s->last) {
+        UA_StatusCode res = appendRecord(s, &v, timestamp);
+        if(res == UA_STATUSCODE_GOOD && s->seg.pendingSize >= FILE_BATCH_SIZE)
+            res = writePending(s);
+        return res;
+    }
+
+    /* Out of order */
+    UA_StatusCode res = prepareRead(s);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Boolean equal;
+    size_t index = lowerBound(s, timestamp, &equal);
+    return rewriteSeries(s, index, index, &v, timestamp);
+}
+
+static UA_StatusCode
+serverSetHistoryData_backend_file(UA_Server *server,
+                                  void *context,
+                                  const UA_NodeId *sessionId,
+                                  void *sessionContext,
+                                  const UA_NodeId *nodeId,
+                                  UA_Boolean historizing,
+                                  const UA_DataValue *value) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    UA_StatusCode res = setHistoryData(ctx, nodeId, value);
+    UA_UNLOCK(&ctx->lock);
+#if UA_MULTITHREADING < 100
+    syncIfDue(ctx);
+#endif
+    return res;
+}
+
+static void
+setHistoryDataBatch_backend_file(UA_Server *server,
+                                 void *context,
+                                 size_t valuesSize,
+                                 const UA_NodeId *nodeIds,
+                                 const UA_DataValue *values,
+                                 UA_StatusCode *results) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    for(size_t i = 0; i < valuesSize; i++)
+        results[i] = setHistoryData(ctx, &nodeIds[i], &values[i]);
+    UA_UNLOCK(&ctx->lock);
+#if UA_MULTITHREADING < 100
+    syncIfDue(ctx);
+#endif
+}
+
+/* Returns the series prepared for reading or NULL */
+static UA_FileSeries *
+getReadSeries(UA_FileStoreContext *ctx, const UA_NodeId *nodeId) {
+    UA_FileSeries *s = getSeries(ctx, nodeId, false);
+    if(!s || prepareRead(s) != UA_STATUSCODE_GOOD)
+        return NULL;
+    return s;
+}
+
+static size_t
+getDateTimeMatch_backend_file(UA_Server *server,
+                              void *context,
+                              const UA_NodeId *sessionId,
+                              void *sessionContext,
+                              const UA_NodeId *nodeId,
+                              const UA_DateTime timestamp,
+                              const MatchStrategy strategy) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    size_t result = 0;
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    if(!s)
+        goto out;
+    UA_Boolean equal;
+    size_t current = lowerBound(s, timestamp, &equal);
+    result = s->count;
+    if((strategy == MATCH_EQUAL ||
+        strategy == MATCH_EQUAL_OR_AFTER ||
+        strategy == MATCH_EQUAL_OR_BEFORE) && equal) {
+        result = current;
+        goto out;
+    }
+    switch(strategy) {
+    case MATCH_AFTER:
+        result = (equal) ? current + 1 : current;
+        break;
+    case MATCH_EQUAL_OR_AFTER:
+        result = current;
+        break;
+    case MATCH_EQUAL_OR_BEFORE:
+        /* equal is handled before */
+    case MATCH_BEFORE:
+        if(current > 0)
+            result = current - 1;
+        break;
+    default:
+        break;
+    }
+ out:
+    UA_UNLOCK(&ctx->lock);
+    return result;
+}
+
+static size_t
+getEnd_backend_file(UA_Server *server,
+                    void *context,
+                    const UA_NodeId *sessionId,
+                    void *sessionContext,
+                    const UA_NodeId *nodeId) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getSeries(ctx, nodeId, false);
+    size_t end = (s) ? s->count : 0;
+    UA_UNLOCK(&ctx->lock);
+    return end;
+}
+
+static size_t
+lastIndex_backend_file(UA_Server *server,
+                       void *context,
+                       const UA_NodeId *sessionId,
+                       void *sessionContext,
+                       const UA_NodeId *nodeId) {
+    size_t end = getEnd_backend_file(server, context, sessionId,
+                                     sessionContext, nodeId);
+    return (end > 0) ? end - 1 : 0;
+}
+
+static size_t
+firstIndex_backend_file(UA_Server *server,
+                        void *context,
+                        const UA_NodeId *sessionId,
+                        void *sessionContext,
+                        const UA_NodeId *nodeId) {
+    return 0;
+}
+
+static size_t
+resultSize_backend_file(UA_Server *server,
+                        void *context,
+                        const UA_NodeId *sessionId,
+                        void *sessionContext,
+                        const UA_NodeId *nodeId,
+                        size_t startIndex,
+                        size_t endIndex) {
+    size_t end = getEnd_backend_file(server, context, sessionId,
+                                     sessionContext, nodeId);
+    if(end == 0 || startIndex == end || endIndex == end)
+        return 0;
+    return endIndex - startIndex + 1;
+}
+
+static UA_Boolean
+boundSupported_backend_file(UA_Server *server,
+                            void *context,
+                            const UA_NodeId *sessionId,
+                            void *sessionContext,
+                            const UA_NodeId *nodeId) {
+    return true;
+}
+
+static UA_Boolean
+timestampsToReturnSupported_backend_file(UA_Server *server,
+                                         void *context,
+                                         const UA_NodeId *sessionId,
+                                         void *sessionContext,
+                                         const UA_NodeId *nodeId,
+                                         const UA_TimestampsToReturn timestampsToReturn) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_Boolean supported = true;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    if(!s || s->count == 0)
+        goto out;
+    UA_DataValue first;
+    if(decodeRecord(s, 0, &first) != UA_STATUSCODE_GOOD) {
+        supported = false;
+        goto out;
+    }
+    if(timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER ||
+       timestampsToReturn == UA_TIMESTAMPSTORETURN_INVALID ||
+       (timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER &&
+        !first.hasServerTimestamp) ||
+       (timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE &&
+        !first.hasSourceTimestamp) ||
+       (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH &&
+        !(first.hasSourceTimestamp && first.hasServerTimestamp)))
+        supported = false;
+    UA_DataValue_clear(&first);
+ out:
+    UA_UNLOCK(&ctx->lock);
+    return supported;
+}
+
+/* The returned value remains valid until the next call */
+static const UA_DataValue *
+getDataValue_backend_file(UA_Server *server,
+                          void *context,
+                          const UA_NodeId *sessionId,
+                          void *sessionContext,
+                          const UA_NodeId *nodeId,
+                          size_t index) {
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    UA_DataValue_clear(&ctx->scratch);
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    if(s && index < s->count &&
+       decodeRecord(s, recordOffset(s, index), &ctx->scratch) != UA_STATUSCODE_GOOD)
+        UA_DataValue_init(&ctx->scratch);
+    UA_UNLOCK(&ctx->lock);
+    return &ctx->scratch;
+}
+
+static void
+copyRecord(const UA_FileSeries *s, size_t offset,
+           const UA_NumericRange range, UA_DataValue *dst) {
+    if(decodeRecord(s, offset, dst) != UA_STATUSCODE_GOOD || range.dimensionsSize == 0)
+        return;
+    UA_Variant value = dst->value;
+    UA_Variant_init(&dst->value);
+    if(dst->hasValue)
+        UA_Variant_copyRange(&value, &dst->value, range);
+    UA_Variant_clear(&value);
+}
+
+/* The continuation point is a cursor to the next record. The offset is used
+ * directly if the segment was not rewritten since. Otherwise the record is
+ * found again by its timestamp. */
+typedef struct {
+    size_t index;
+    size_t offset;
+    size_t version;
+    UA_DateTime timestamp;
+} UA_FileCursor;
+
+static UA_StatusCode
+copyDataValues_backend_file(UA_Server *server,
+                            void *context,
+                            const UA_NodeId *sessionId,
+                            void *sessionContext,
+                            const UA_NodeId *nodeId,
+                            size_t startIndex,
+                            size_t endIndex,
+                            UA_Boolean reverse,
+                            size_t maxValues,
+                            UA_NumericRange range,
+                            UA_Boolean releaseContinuationPoints,
+                            const UA_ByteString *continuationPoint,
+                            UA_ByteString *outContinuationPoint,
+                            size_t *providedValues,
+                            UA_DataValue *values) {
+    UA_FileCursor cursor;
+    memset(&cursor, 0, sizeof(UA_FileCursor));
+    if(continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(UA_FileCursor))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&cursor, continuationPoint->data, sizeof(UA_FileCursor));
+    }
+
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)context;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    size_t count = (s) ? s->count : 0;
+    size_t index = startIndex;
+    size_t offset = 0;
+    UA_Boolean haveOffset = false;
+    if(s && continuationPoint->length > 0) {
+        if(cursor.version == s->version && cursor.index < count) {
+            index = cursor.index;
+            offset = cursor.offset;
+            haveOffset = true;
+        } else {
+            UA_Boolean equal;
+            index = lowerBound(s, cursor.timestamp, &equal);
+            if(reverse && !equal)
+                index = (index > 0) ? index - 1 : count;
+        }
+    }
+
+    size_t counter = 0;
+    if(reverse) {
+        while(index >= endIndex && index < count && counter < maxValues) {
+            copyRecord(s, recordOffset(s, index), range, &values[counter++]);
+            if(index == 0) {
+                index = count;
+                break;
+            }
+            --index;
+        }
+        haveOffset = false;
+    } else if(index < count) {
+        /* Walk forward through the mapped segment */
+        if(!haveOffset)
+            offset = recordOffset(s, index);
+        while(index <= endIndex && index < count && counter < maxValues) {
+            copyRecord(s, offset, range, &values[counter++]);
+            offset += RECORD_SIZE(readHeader(s, offset).length);
+            ++index;
+        }
+        haveOffset = true;
+    }
+
+    /* There are more values in the range */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(index < count &&
+       ((!reverse && index <= endIndex) || (reverse && index >= endIndex))) {
+        cursor.index = index;
+        cursor.offset = (haveOffset) ? offset : recordOffset(s, index);
+        cursor.version = s->version;
+        cursor.timestamp = readHeader(s, cursor.offset).timestamp;
+        res = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(UA_FileCursor));
+        if(res == UA_STATUSCODE_GOOD)
+            memcpy(outContinuationPoint->data, &cursor, sizeof(UA_FileCursor));
+    }
+    UA_UNLOCK(&ctx->lock);
+
+    if(providedValues)
+        *providedValues = counter;
+    return res;
+}
+
+static UA_StatusCode
+insertDataValue_backend_file(UA_Server *server,
+                             void *hdbContext,
+                             const UA_NodeId *sessionId,
+                             void *sessionContext,
+                             const UA_NodeId *nodeId,
+                             const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    UA_StatusCode res;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getSeries(ctx, nodeId, true);
+    if(!s || prepareRead(s) != UA_STATUSCODE_GOOD) {
+        res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        goto out;
+    }
+    UA_DateTime timestamp = valueTimestamp(value);
+    UA_Boolean equal;
+    size_t index = lowerBound(s, timestamp, &equal);
+    if(equal) {
+        res = UA_STATUSCODE_BADENTRYEXISTS;
+        goto out;
+    }
+    UA_DataValue v = storedValue(value, timestamp);
+    if(index == s->count)
+        res = appendRecord(s, &v, timestamp);
+    else
+        res = rewriteSeries(s, index, index, &v, timestamp);
+ out:
+    UA_UNLOCK(&ctx->lock);
+    return res;
+}
+
+static UA_StatusCode
+replaceDataValue_backend_file(UA_Server *server,
+                              void *hdbContext,
+                              const UA_NodeId *sessionId,
+                              void *sessionContext,
+                              const UA_NodeId *nodeId,
+                              const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    UA_StatusCode res = UA_STATUSCODE_BADNOENTRYEXISTS;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    if(s) {
+        UA_DateTime timestamp = valueTimestamp(value);
+        UA_Boolean equal;
+        size_t index = lowerBound(s, timestamp, &equal);
+        if(equal) {
+            UA_DataValue v = storedValue(value, timestamp);
+            res = rewriteSeries(s, index, index + 1, &v, timestamp);
+        }
+    }
+    UA_UNLOCK(&ctx->lock);
+    return res;
+}
+
+static UA_StatusCode
+updateDataValue_backend_file(UA_Server *server,
+                             void *hdbContext,
+                             const UA_NodeId *sessionId,
+                             void *sessionContext,
+                             const UA_NodeId *nodeId,
+                             const UA_DataValue *value) {
+    UA_StatusCode ret =
+        replaceDataValue_backend_file(server, hdbContext, sessionId,
+                                      sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYREPLACED;
+
+    ret = insertDataValue_backend_file(server, hdbContext, sessionId,
+                                       sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYINSERTED;
+    return ret;
+}
+
+static UA_StatusCode
+removeDataValue_backend_file(UA_Server *server,
+                             void *hdbContext,
+                             const UA_NodeId *sessionId,
+                             void *sessionContext,
+                             const UA_NodeId *nodeId,
+                             UA_DateTime startTimestamp,
+                             UA_DateTime endTimestamp) {
+    if(startTimestamp > endTimestamp)
+        return UA_STATUSCODE_BADTIMESTAMPNOTSUPPORTED;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)hdbContext;
+    UA_StatusCode res = UA_STATUSCODE_BADNODATA;
+    UA_LOCK(&ctx->lock);
+    UA_FileSeries *s = getReadSeries(ctx, nodeId);
+    if(!s)
+        goto out;
+
+    /* The first index which is deleted and the first index which is not */
+    UA_Boolean equal;
+    size_t index1 = lowerBound(s, startTimestamp, &equal);
+    size_t index2;
+    if(startTimestamp == endTimestamp) {
+        if(!equal)
+            goto out;
+        index2 = index1 + 1;
+    } else {
+        /* The end timestamp is excluded */
+        index2 = lowerBound(s, endTimestamp, &equal);
+        if(index1 >= index2)
+            goto out;
+    }
+    res = rewriteSeries(s, index1, index2, NULL, 0);
+ out:
+    UA_UNLOCK(&ctx->lock);
+    return res;
+}
+
+static void
+deleteMembers_backend_file(UA_HistoryDataBackend *backend) {
+    if(backend == NULL || backend->context == NULL)
+        return;
+    UA_FileStoreContext_delete((UA_FileStoreContext*)backend->context);
+}
+
+UA_HistoryDataBackend
+UA_HistoryDataBackend_File(const char *directory, UA_UInt32 syncInterval) {
+    UA_HistoryDataBackend result;
+    memset(&result, 0, sizeof(UA_HistoryDataBackend));
+    struct stat st;
+    if(!directory || stat(directory, &st) != 0 || !S_ISDIR(st.st_mode))
+        return result;
+    UA_FileStoreContext *ctx = (UA_FileStoreContext*)
+        UA_calloc(1, sizeof(UA_FileStoreContext));
+    if(!ctx)
+        return result;
+    size_t len = strlen(directory) + 1;
+    ctx->directory = (char*)UA_malloc(len);
+    if(!ctx->directory) {
+        UA_free(ctx);
+        return result;
+    }
+    memcpy(ctx->directory, directory, len);
+    ctx->syncInterval = (syncInterval > 0) ? syncInterval : FILE_BACKEND_SYNC_INTERVAL;
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_INIT(&ctx->lock);
+    pthread_mutex_init(&ctx->sleepMutex, NULL);
+    pthread_cond_init(&ctx->sleepCond, NULL);
+    ctx->running = true;
+    if(pthread_create(&ctx->thread, NULL, syncThread, ctx) != 0) {
+        ctx->running = false;
+        UA_FileStoreContext_delete(ctx);
+        return result;
+    }
+#else
+    ctx->lastSync = UA_DateTime_nowMonotonic();
+#endif
+
+    result.serverSetHistoryData = &serverSetHistoryData_backend_file;
+    result.setHistoryDataBatch = &setHistoryDataBatch_backend_file;
+    result.resultSize = &resultSize_backend_file;
+    result.getEnd = &getEnd_backend_file;
+    result.lastIndex = &lastIndex_backend_file;
+    result.firstIndex = &firstIndex_backend_file;
+    result.getDateTimeMatch = &getDateTimeMatch_backend_file;
+    result.copyDataValues = &copyDataValues_backend_file;
+    result.getDataValue = &getDataValue_backend_file;
+    result.boundSupported = &boundSupported_backend_file;
+    result.timestampsToReturnSupported = &timestampsToReturnSupported_backend_file;
+    result.insertDataValue = &insertDataValue_backend_file;
+    result.updateDataValue = &updateDataValue_backend_file;
+    result.replaceDataValue = &replaceDataValue_backend_file;
+    result.removeDataValue = &removeDataValue_backend_file;
+    result.deleteMembers = &deleteMembers_backend_file;
+    result.getHistoryData = NULL;
+    result.context = ctx;
+    return result;
+}
+
+UA_StatusCode
+UA_HistoryDataBackend_File_flush(UA_HistoryDataBackend *backend) {
+    if(!backend->context)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    return syncAll((UA_FileStoreContext*)backend->context);
+}
+
+void
+UA_HistoryDataBackend_File_clear(UA_HistoryDataBackend *backend) {
+    if(backend->context)
+        UA_FileStoreContext_delete((UA_FileStoreContext*)backend->context);
+    memset(backend, 0, sizeof(UA_HistoryDataBackend));
+}
+
+#endif /* defined(__linux__) || defined(__unix__) */
@@ -29,6 +29,9 @@ typedef struct {
     size_t storeSize;
     /* New field useful for circular buffer management */
     size_t lastInserted;
+    /* Incremented when the index of stored values changes. Appending at the
+     * end keeps the indices. */
+    size_t version;
 } UA_NodeIdStoreContextItem_backend_memory;
 
 static void
@@ -41,22 +44,98 @@ UA_NodeIdStoreContextItem_clear(UA_NodeIdStoreContextItem_backend_memory* item)
     UA_free(item->dataStore);
 }
 
+/* The node contexts are allocated individually. So pointers to them remain
+ * valid when the store grows and can be cached by the gathering. */
 typedef struct {
-    UA_NodeIdStoreContextItem_backend_memory *dataStore;
+    UA_NodeIdStoreContextItem_backend_memory **dataStore;
     size_t storeEnd;
     size_t storeSize;
     size_t initialStoreSize;
+    /* Hash index over the node contexts with linear probing. An entry is the
+     * position in dataStore plus one. Zero marks an empty slot. */
+    size_t *index;
+    size_t indexSize; /* Power of two */
 } UA_MemoryStoreContext;
 
 static void
 UA_MemoryStoreContext_clear(UA_MemoryStoreContext* ctx) {
     for (size_t i = 0; i < ctx->storeEnd; ++i) {
-        UA_NodeIdStoreContextItem_clear(&ctx->dataStore[i]);
+        UA_NodeIdStoreContextItem_clear(ctx->dataStore[i]);
+        UA_free(ctx->dataStore[i]);
     }
     UA_free(ctx->dataStore);
+    UA_free(ctx->index);
     memset(ctx, 0, sizeof(UA_MemoryStoreContext));
 }
 
+static UA_NodeIdStoreContextItem_backend_memory *
+findNodeIdStoreContextItem_backend_memory(const UA_MemoryStoreContext *ctx,
+                                          const UA_NodeId *nodeId) {
+    if (ctx->indexSize == 0)
+        return NULL;
+    size_t mask = ctx->indexSize - 1;
+    for (size_t h = UA_NodeId_hash(nodeId) & mask; ctx->index[h] != 0; h = (h + 1) & mask) {
+        UA_NodeIdStoreContextItem_backend_memory *item = ctx->dataStore[ctx->index[h] - 1];
+        if (UA_NodeId_equal(nodeId, &item->nodeId))
+            return item;
+    }
+    return NULL;
+}
+
+static void
+insertIndex_backend_memory(size_t *index, size_t indexSize,
+                           const UA_NodeId *nodeId, size_t pos) {
+    size_t mask = indexSize - 1;
+    size_t h = UA_NodeId_hash(nodeId) & mask;
+    while (index[h] != 0)
+        h = (h + 1) & mask;
+    index[h] = pos + 1;
+}
+
+/* Keep the index at most half full */
+static UA_StatusCode
+growIndex_backend_memory(UA_MemoryStoreContext *ctx) {
+    if ((ctx->storeEnd + 1) * 2 <= ctx->indexSize)
+        return UA_STATUSCODE_GOOD;
+    size_t newSize = (ctx->indexSize > 0) ? ctx->indexSize * 2 : 16;
+    while ((ctx->storeEnd + 1) * 2 > newSize)
+        newSize *= 2;
+    size_t *newIndex = (size_t*)UA_calloc(newSize, sizeof(size_t));
+    if (!newIndex)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for (size_t i = 0; i < ctx->storeEnd; ++i)
+        insertIndex_backend_memory(newIndex, newSize, &ctx->dataStore[i]->nodeId, i);
+    UA_free(ctx->index);
+    ctx->index = newIndex;
+    ctx->indexSize = newSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The store must have space for the new node context */
+static UA_NodeIdStoreContextItem_backend_memory *
+appendNodeIdContext_backend_memory(UA_MemoryStoreContext *ctx,
+                                   const UA_NodeId *nodeId) {
+    if (growIndex_backend_memory(ctx) != UA_STATUSCODE_GOOD)
+        return NULL;
+    UA_NodeIdStoreContextItem_backend_memory *item = (UA_NodeIdStoreContextItem_backend_memory*)
+        UA_calloc(1, sizeof(UA_NodeIdStoreContextItem_backend_memory));
+    if (!item)
+        return NULL;
+    UA_DataValueMemoryStoreItem ** store = (UA_DataValueMemoryStoreItem **)UA_calloc(ctx->initialStoreSize, sizeof(UA_DataValueMemoryStoreItem*));
+    if (!store || UA_NodeId_copy(nodeId, &item->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(store);
+        UA_free(item);
+        return NULL;
+    }
+    item->dataStore = store;
+    item->storeSize = ctx->initialStoreSize;
+    item->storeEnd = 0;
+    ctx->dataStore[ctx->storeEnd] = item;
+    insertIndex_backend_memory(ctx->index, ctx->indexSize, nodeId, ctx->storeEnd);
+    ++ctx->storeEnd;
+    return item;
+}
+
 static UA_NodeIdStoreContextItem_backend_memory *
 getNewNodeIdContext_backend_memory(UA_MemoryStoreContext* context,
                                    UA_Server *server,
@@ -66,25 +145,13 @@ getNewNodeIdContext_backend_memory(UA_MemoryStoreContext* context,
         size_t newStoreSize = ctx->storeSize * 2;
         if (newStoreSize == 0)
             return NULL;
-        ctx->dataStore = (UA_NodeIdStoreContextItem_backend_memory*)UA_realloc(ctx->dataStore,  (newStoreSize * sizeof(UA_NodeIdStoreContextItem_backend_memory)));
-        if (!ctx->dataStore) {
-            ctx->storeSize = 0;
+        UA_NodeIdStoreContextItem_backend_memory **newStore = (UA_NodeIdStoreContextItem_backend_memory**)UA_realloc(ctx->dataStore,  (newStoreSize * sizeof(UA_NodeIdStoreContextItem_backend_memory*)));
+        if (!newStore)
             return NULL;
-        }
+        ctx->dataStore = newStore;
         ctx->storeSize = newStoreSize;
     }
-    UA_NodeIdStoreContextItem_backend_memory *item = &ctx->dataStore[ctx->storeEnd];
-    UA_NodeId_copy(nodeId, &item->nodeId);
-    UA_DataValueMemoryStoreItem ** store = (UA_DataValueMemoryStoreItem **)UA_calloc(ctx->initialStoreSize, sizeof(UA_DataValueMemoryStoreItem*));
-    if (!store) {
-        UA_NodeIdStoreContextItem_clear(item);
-        return NULL;
-    }
-    item->dataStore = store;
-    item->storeSize = ctx->initialStoreSize;
-    item->storeEnd = 0;
-    ++ctx->storeEnd;
-    return item;
+    return appendNodeIdContext_backend_memory(ctx, nodeId);
 }
 
 static UA_NodeIdStoreContextItem_backend_memory *
@@ -92,11 +159,10 @@ getNodeIdStoreContextItem_backend_memory(UA_MemoryStoreContext* context,
                                          UA_Server *server,
                                          const UA_NodeId *nodeId)
 {
-    for (size_t i = 0; i < context->storeEnd; ++i) {
-        if (UA_NodeId_equal(nodeId, &context->dataStore[i].nodeId)) {
-            return &context->dataStore[i];
-        }
-    }
+    UA_NodeIdStoreContextItem_backend_memory *item =
+        findNodeIdStoreContextItem_backend_memory(context, nodeId);
+    if (item)
+        return item;
     return getNewNodeIdContext_backend_memory(context, server, nodeId);
 }
 
@@ -148,14 +214,9 @@ resultSize_backend_memory(UA_Server *server,
 }
 
 static size_t
-getDateTimeMatch_backend_memory(UA_Server *server,
-                                void *context,
-                                const UA_NodeId *sessionId,
-                                void *sessionContext,
-                                const UA_NodeId * nodeId,
-                                const UA_DateTime timestamp,
-                                const MatchStrategy strategy) {
-    const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
+getDateTimeMatchItem_backend_memory(const UA_NodeIdStoreContextItem_backend_memory *item,
+                                    const UA_DateTime timestamp,
+                                    const MatchStrategy strategy) {
     size_t current;
     UA_Boolean retval = binarySearch_backend_memory(item, timestamp, &current);
 
@@ -185,18 +246,23 @@ getDateTimeMatch_backend_memory(UA_Server *server,
     return item->storeEnd;
 }
 
+static size_t
+getDateTimeMatch_backend_memory(UA_Server *server,
+                                void *context,
+                                const UA_NodeId *sessionId,
+                                void *sessionContext,
+                                const UA_NodeId * nodeId,
+                                const UA_DateTime timestamp,
+                                const MatchStrategy strategy) {
+    const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
+    return getDateTimeMatchItem_backend_memory(item, timestamp, strategy);
+}
+
 
 static UA_StatusCode
-serverSetHistoryData_backend_memory(UA_Server *server,
-                                    void *context,
-                                    const UA_NodeId *sessionId,
-                                    void *sessionContext,
-                                    const UA_NodeId * nodeId,
-                                    UA_Boolean historizing,
-                                    const UA_DataValue *value)
+setHistoryDataItem_backend_memory(UA_NodeIdStoreContextItem_backend_memory *item,
+                                  const UA_DataValue *value)
 {
-    UA_NodeIdStoreContextItem_backend_memory *item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
-
     if (item->storeEnd >= item->storeSize) {
         size_t newStoreSize = item->storeSize == 0 ? INITIAL_MEMORY_STORE_SIZE : item->storeSize * 2;
         item->dataStore = (UA_DataValueMemoryStoreItem **)UA_realloc(item->dataStore,  (newStoreSize * sizeof(UA_DataValueMemoryStoreItem*)));
@@ -221,21 +287,51 @@ serverSetHistoryData_backend_memory(UA_Server *server,
         newItem->value.serverTimestamp = timestamp;
         newItem->value.hasServerTimestamp = true;
     }
-    size_t index = getDateTimeMatch_backend_memory(server,
-                                                   context,
-                                                   NULL,
-                                                   NULL,
-                                                   nodeId,
-                                                   timestamp,
-                                                   MATCH_EQUAL_OR_AFTER);
+    size_t index = getDateTimeMatchItem_backend_memory(item, timestamp, MATCH_EQUAL_OR_AFTER);
     if (item->storeEnd > 0 && index < item->storeEnd) {
         memmove(&item->dataStore[index+1], &item->dataStore[index], sizeof(UA_DataValueMemoryStoreItem*) * (item->storeEnd - index));
+        ++item->version;
     }
     item->dataStore[index] = newItem;
     ++item->storeEnd;
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+serverSetHistoryData_backend_memory(UA_Server *server,
+                                    void *context,
+                                    const UA_NodeId *sessionId,
+                                    void *sessionContext,
+                                    const UA_NodeId * nodeId,
+                                    UA_Boolean historizing,
+                                    const UA_DataValue *value)
+{
+    UA_NodeIdStoreContextItem_backend_memory *item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
+    if (!item)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    return setHistoryDataItem_backend_memory(item, value);
+}
+
+static UA_StatusCode
+serverSetHistoryDataCached_backend_memory(UA_Server *server,
+                                          void *context,
+                                          const UA_NodeId *sessionId,
+                                          void *sessionContext,
+                                          const UA_NodeId *nodeId,
+                                          void **nodeContext,
+                                          UA_Boolean historizing,
+                                          const UA_DataValue *value)
+{
+    UA_NodeIdStoreContextItem_backend_memory *item = (UA_NodeIdStoreContextItem_backend_memory*)*nodeContext;
+    if (!item) {
+        item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
+        if (!item)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        *nodeContext = item;
+    }
+    return setHistoryDataItem_backend_memory(item, value);
+}
+
 static void
 UA_MemoryStoreContext_delete(UA_MemoryStoreContext* ctx) {
     UA_MemoryStoreContext_clear(ctx);
@@ -327,6 +423,15 @@ UA_DataValue_backend_copyRange(const UA_DataValue *src, UA_DataValue *dst,
     return UA_STATUSCODE_BADDATAUNAVAILABLE;
 }
 
+/* The continuation point is a cursor to the next value. It is used directly
+ * if the indices did not change since. Otherwise the next value is found again
+ * by its timestamp. */
+typedef struct {
+    size_t index;
+    size_t version;
+    UA_DateTime timestamp;
+} UA_MemoryCursor_backend_memory;
+
 static UA_StatusCode
 copyDataValues_backend_memory(UA_Server *server,
                               void *context,
@@ -344,40 +449,39 @@ copyDataValues_backend_memory(UA_Server *server,
                               size_t * providedValues,
                               UA_DataValue * values)
 {
-    size_t skip = 0;
+    const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
+    size_t index = startIndex;
     if (continuationPoint->length > 0) {
-        if (continuationPoint->length == sizeof(size_t)) {
-            skip = *((size_t*)(continuationPoint->data));
-        } else {
+        if (continuationPoint->length != sizeof(UA_MemoryCursor_backend_memory))
             return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        UA_MemoryCursor_backend_memory cursor;
+        memcpy(&cursor, continuationPoint->data, sizeof(UA_MemoryCursor_backend_memory));
+        if (cursor.version == item->version && cursor.index < item->storeEnd) {
+            index = cursor.index;
+        } else {
+            index = getDateTimeMatchItem_backend_memory(item, cursor.timestamp,
+                                                        reverse ? MATCH_EQUAL_OR_BEFORE : MATCH_EQUAL_OR_AFTER);
         }
     }
-    const UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)context, server, nodeId);
-    size_t index = startIndex;
     size_t counter = 0;
-    size_t skipedValues = 0;
     if (reverse) {
         while (index >= endIndex && index < item->storeEnd && counter < maxValues) {
-            if (skipedValues++ >= skip) {
-                if (range.dimensionsSize > 0) {
-                    UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
-                } else {
-                    UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
-                }
-                ++counter;
+            if (range.dimensionsSize > 0) {
+                UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
+            } else {
+                UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
             }
+            ++counter;
             --index;
         }
     } else {
-        while (index <= endIndex && counter < maxValues) {
-            if (skipedValues++ >= skip) {
-                if (range.dimensionsSize > 0) {
-                    UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
-                } else {
-                    UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
-                }
-                ++counter;
+        while (index <= endIndex && index < item->storeEnd && counter < maxValues) {
+            if (range.dimensionsSize > 0) {
+                UA_DataValue_backend_copyRange(&item->dataStore[index]->value, &values[counter], range);
+            } else {
+                UA_DataValue_copy(&item->dataStore[index]->value, &values[counter]);
             }
+            ++counter;
             ++index;
         }
     }
@@ -385,11 +489,18 @@ copyDataValues_backend_memory(UA_Server *server,
     if (providedValues)
         *providedValues = counter;
 
-    if ((!reverse && (endIndex-startIndex-skip+1) > counter) || (reverse && (startIndex-endIndex-skip+1) > counter)) {
-        outContinuationPoint->length = sizeof(size_t);
-        size_t t = sizeof(size_t);
-        outContinuationPoint->data = (UA_Byte*)UA_malloc(t);
-        *((size_t*)(outContinuationPoint->data)) = skip + counter;
+    /* There are more values in the range. Index zero is decremented to
+     * SIZE_MAX in reverse. */
+    if (index < item->storeEnd &&
+        ((!reverse && index <= endIndex) || (reverse && index >= endIndex))) {
+        UA_MemoryCursor_backend_memory cursor;
+        cursor.index = index;
+        cursor.version = item->version;
+        cursor.timestamp = item->dataStore[index]->timestamp;
+        UA_StatusCode ret = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(UA_MemoryCursor_backend_memory));
+        if (ret != UA_STATUSCODE_GOOD)
+            return ret;
+        memcpy(outContinuationPoint->data, &cursor, sizeof(UA_MemoryCursor_backend_memory));
     }
 
     return UA_STATUSCODE_GOOD;
@@ -437,12 +548,152 @@ insertDataValue_backend_memory(UA_Server *server,
 
     if (item->storeEnd > 0 && index < item->storeEnd) {
         memmove(&item->dataStore[index+1], &item->dataStore[index], sizeof(UA_DataValueMemoryStoreItem*) * (item->storeEnd - index));
+        ++item->version;
     }
     item->dataStore[index] = newItem;
     ++item->storeEnd;
     return UA_STATUSCODE_GOOD;
 }
 
+/* Bulk insert. The values are sorted once and merged into the store in a
+ * single pass from the back. */
+
+typedef struct {
+    UA_DateTime timestamp;
+    size_t pos; /* In the inserted values */
+} UA_InsertEntry_backend_memory;
+
+/* Stable bottom-up merge sort by timestamp */
+static void
+sortInsertEntries_backend_memory(UA_InsertEntry_backend_memory *entries,
+                                 UA_InsertEntry_backend_memory *tmp, size_t n) {
+    UA_InsertEntry_backend_memory *src = entries;
+    UA_InsertEntry_backend_memory *dst = tmp;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = (lo + width < n) ? lo + width : n;
+            size_t hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi)
+                dst[k++] = (src[j].timestamp < src[i].timestamp) ? src[j++] : src[i++];
+            while (i < mid)
+                dst[k++] = src[i++];
+            while (j < hi)
+                dst[k++] = src[j++];
+        }
+        UA_InsertEntry_backend_memory *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != entries)
+        memcpy(entries, src, n * sizeof(UA_InsertEntry_backend_memory));
+}
+
+static void
+insertDataValues_backend_memory(UA_Server *server,
+                                void *hdbContext,
+                                const UA_NodeId *sessionId,
+                                void *sessionContext,
+                                const UA_NodeId *nodeId,
+                                size_t valuesSize,
+                                const UA_DataValue *values,
+                                UA_StatusCode *results)
+{
+    UA_NodeIdStoreContextItem_backend_memory* item = getNodeIdStoreContextItem_backend_memory((UA_MemoryStoreContext*)hdbContext, server, nodeId);
+    UA_InsertEntry_backend_memory *entries = (UA_InsertEntry_backend_memory*)
+        UA_malloc(2 * valuesSize * sizeof(UA_InsertEntry_backend_memory));
+    UA_DataValueMemoryStoreItem **newItems = (UA_DataValueMemoryStoreItem**)
+        UA_malloc(valuesSize * sizeof(UA_DataValueMemoryStoreItem*));
+    if (!item || !entries || !newItems) {
+        for (size_t i = 0; i < valuesSize; ++i)
+            results[i] = UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_free(entries);
+        UA_free(newItems);
+        return;
+    }
+
+    size_t entriesSize = 0;
+    for (size_t i = 0; i < valuesSize; ++i) {
+        const UA_DataValue *value = &values[i];
+        if (!value->hasSourceTimestamp && !value->hasServerTimestamp) {
+            results[i] = UA_STATUSCODE_BADINVALIDTIMESTAMP;
+            continue;
+        }
+        results[i] = UA_STATUSCODE_GOOD;
+        entries[entriesSize].timestamp = value->hasSourceTimestamp ? value->sourceTimestamp : value->serverTimestamp;
+        entries[entriesSize].pos = i;
+        ++entriesSize;
+    }
+    sortInsertEntries_backend_memory(entries, &entries[valuesSize], entriesSize);
+
+    /* Drop the values whose timestamp exists. The sort is stable, so the
+     * first of the values with the same timestamp is inserted. */
+    size_t accepted = 0;
+    size_t s = 0;
+    for (size_t j = 0; j < entriesSize; ++j) {
+        const UA_InsertEntry_backend_memory e = entries[j];
+        while (s < item->storeEnd && item->dataStore[s]->timestamp < e.timestamp)
+            ++s;
+        if ((accepted > 0 && entries[accepted-1].timestamp == e.timestamp) ||
+            (s < item->storeEnd && item->dataStore[s]->timestamp == e.timestamp)) {
+            results[e.pos] = UA_STATUSCODE_BADENTRYEXISTS;
+            continue;
+        }
+        entries[accepted++] = e;
+    }
+
+    /* Grow the store geometrically */
+    if (item->storeEnd + accepted > item->storeSize) {
+        size_t newStoreSize = item->storeSize == 0 ? INITIAL_MEMORY_STORE_SIZE : item->storeSize;
+        while (newStoreSize < item->storeEnd + accepted)
+            newStoreSize *= 2;
+        UA_DataValueMemoryStoreItem **newStore = (UA_DataValueMemoryStoreItem **)
+            UA_realloc(item->dataStore, newStoreSize * sizeof(UA_DataValueMemoryStoreItem*));
+        if (!newStore) {
+            for (size_t j = 0; j < accepted; ++j)
+                results[entries[j].pos] = UA_STATUSCODE_BADOUTOFMEMORY;
+            accepted = 0;
+        } else {
+            item->dataStore = newStore;
+            item->storeSize = newStoreSize;
+        }
+    }
+
+    size_t newItemsSize = 0;
+    for (size_t j = 0; j < accepted; ++j) {
+        UA_DataValueMemoryStoreItem *newItem = (UA_DataValueMemoryStoreItem *)UA_calloc(1, sizeof(UA_DataValueMemoryStoreItem));
+        if (!newItem ||
+            UA_DataValue_copy(&values[entries[j].pos], &newItem->value) != UA_STATUSCODE_GOOD) {
+            UA_free(newItem);
+            results[entries[j].pos] = UA_STATUSCODE_BADOUTOFMEMORY;
+            continue;
+        }
+        newItem->timestamp = entries[j].timestamp;
+        if(!newItem->value.hasServerTimestamp) {
+            newItem->value.serverTimestamp = newItem->timestamp;
+            newItem->value.hasServerTimestamp = true;
+        }
+        newItems[newItemsSize++] = newItem;
+    }
+
+    /* Merge from the back */
+    size_t i = item->storeEnd;
+    size_t j = newItemsSize;
+    size_t k = item->storeEnd + newItemsSize;
+    while (j > 0) {
+        if (i > 0 && item->dataStore[i-1]->timestamp > newItems[j-1]->timestamp)
+            item->dataStore[--k] = item->dataStore[--i];
+        else
+            item->dataStore[--k] = newItems[--j];
+    }
+    if (i != item->storeEnd)
+        ++item->version;
+    item->storeEnd += newItemsSize;
+
+    UA_free(entries);
+    UA_free(newItems);
+}
+
 static UA_StatusCode
 replaceDataValue_backend_memory(UA_Server *server,
                     void *hdbContext,
@@ -559,6 +810,7 @@ removeDataValue_backend_memory(UA_Server *server,
     }
     memmove(&item->dataStore[index1], &item->dataStore[index2], sizeof(UA_DataValueMemoryStoreItem*) * (item->storeEnd - index2));
     item->storeEnd -= index2 - index1;
+    ++item->version;
 #else
     (void)index1;
     (void)index2;
@@ -588,11 +840,16 @@ UA_HistoryDataBackend_Memory(size_t initialNodeIdStoreSize, size_t initialDataSt
     UA_MemoryStoreContext *ctx = (UA_MemoryStoreContext *)UA_calloc(1, sizeof(UA_MemoryStoreContext));
     if (!ctx)
         return result;
-    ctx->dataStore = (UA_NodeIdStoreContextItem_backend_memory*)UA_calloc(initialNodeIdStoreSize, sizeof(UA_NodeIdStoreContextItem_backend_memory));
+    ctx->dataStore = (UA_NodeIdStoreContextItem_backend_memory**)UA_calloc(initialNodeIdStoreSize, sizeof(UA_NodeIdStoreContextItem_backend_memory*));
+    if (!ctx->dataStore) {
+        UA_free(ctx);
+        return result;
+    }
     ctx->initialStoreSize = initialDataStoreSize;
     ctx->storeSize = initialNodeIdStoreSize;
     ctx->storeEnd = 0;
     result.serverSetHistoryData = &serverSetHistoryData_backend_memory;
+    result.serverSetHistoryDataCached = &serverSetHistoryDataCached_backend_memory;
     result.resultSize = &resultSize_backend_memory;
     result.getEnd = &getEnd_backend_memory;
     result.lastIndex = &lastIndex_backend_memory;
@@ -606,6 +863,7 @@ UA_HistoryDataBackend_Memory(size_t initialNodeIdStoreSize, size_t initialDataSt
     result.updateDataValue =  &updateDataValue_backend_memory;
     result.replaceDataValue =  &replaceDataValue_backend_memory;
     result.removeDataValue =  &removeDataValue_backend_memory;
+    result.insertDataValues = &insertDataValues_backend_memory;
     result.deleteMembers = &deleteMembers_backend_memory;
     result.getHistoryData = NULL;
     result.context = ctx;
@@ -630,44 +888,23 @@ getNewNodeIdContext_backend_memory_Circular(UA_MemoryStoreContext *context,
     if(ctx->storeEnd >= ctx->storeSize) {
         return NULL;
     }
-    UA_NodeIdStoreContextItem_backend_memory *item = &ctx->dataStore[ctx->storeEnd];
-    UA_NodeId_copy(nodeId, &item->nodeId);
-    UA_DataValueMemoryStoreItem **store = (UA_DataValueMemoryStoreItem **)UA_calloc(ctx->initialStoreSize, sizeof(UA_DataValueMemoryStoreItem *));
-    if(!store) {
-        UA_NodeIdStoreContextItem_clear(item);
-        return NULL;
-    }
-    item->dataStore = store;
-    item->storeSize = ctx->initialStoreSize;
-    item->storeEnd = 0;
-    ++ctx->storeEnd;
-    return item;
+    return appendNodeIdContext_backend_memory(ctx, nodeId);
 }
 
 static UA_NodeIdStoreContextItem_backend_memory *
 getNodeIdStoreContextItem_backend_memory_Circular(UA_MemoryStoreContext *context,
                                                   UA_Server *server,
                                                   const UA_NodeId *nodeId) {
-    for(size_t i = 0; i < context->storeEnd; ++i) {
-        if(UA_NodeId_equal(nodeId, &context->dataStore[i].nodeId)) {
-            return &context->dataStore[i];
-        }
-    }
+    UA_NodeIdStoreContextItem_backend_memory *item =
+        findNodeIdStoreContextItem_backend_memory(context, nodeId);
+    if(item)
+        return item;
     return getNewNodeIdContext_backend_memory_Circular(context, server, nodeId);
 }
 
 static UA_StatusCode
-serverSetHistoryData_backend_memory_Circular(UA_Server *server,
-                                             void *context,
-                                             const UA_NodeId *sessionId,
-                                             void *sessionContext,
-                                             const UA_NodeId *nodeId,
-                                             UA_Boolean historizing,
-                                             const UA_DataValue *value) {
-    UA_NodeIdStoreContextItem_backend_memory *item = getNodeIdStoreContextItem_backend_memory_Circular((UA_MemoryStoreContext *)context, server, nodeId);
-    if(item == NULL) {
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    }
+setHistoryDataItem_backend_memory_Circular(UA_NodeIdStoreContextItem_backend_memory *item,
+                                           const UA_DataValue *value) {
     if(item->lastInserted >= item->storeSize) {
         /* If the buffer size is overcomed, push new elements from the start of the buffer */
         item->lastInserted = 0;
@@ -705,6 +942,41 @@ serverSetHistoryData_backend_memory_Circular(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+serverSetHistoryData_backend_memory_Circular(UA_Server *server,
+                                             void *context,
+                                             const UA_NodeId *sessionId,
+                                             void *sessionContext,
+                                             const UA_NodeId *nodeId,
+                                             UA_Boolean historizing,
+                                             const UA_DataValue *value) {
+    UA_NodeIdStoreContextItem_backend_memory *item = getNodeIdStoreContextItem_backend_memory_Circular((UA_MemoryStoreContext *)context, server, nodeId);
+    if(item == NULL) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    return setHistoryDataItem_backend_memory_Circular(item, value);
+}
+
+static UA_StatusCode
+serverSetHistoryDataCached_backend_memory_Circular(UA_Server *server,
+                                                   void *context,
+                                                   const UA_NodeId *sessionId,
+                                                   void *sessionContext,
+                                                   const UA_NodeId *nodeId,
+                                                   void **nodeContext,
+                                                   UA_Boolean historizing,
+                                                   const UA_DataValue *value) {
+    UA_NodeIdStoreContextItem_backend_memory *item = (UA_NodeIdStoreContextItem_backend_memory *)*nodeContext;
+    if(item == NULL) {
+        item = getNodeIdStoreContextItem_backend_memory_Circular((UA_MemoryStoreContext *)context, server, nodeId);
+        if(item == NULL) {
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        *nodeContext = item;
+    }
+    return setHistoryDataItem_backend_memory_Circular(item, value);
+}
+
 static size_t
 getResultSize_service_Circular(const UA_HistoryDataBackend *backend, UA_Server *server,
                                const UA_NodeId *sessionId, void *sessionContext,
@@ -879,6 +1151,9 @@ UA_HistoryDataBackend
 UA_HistoryDataBackend_Memory_Circular(size_t initialNodeIdStoreSize, size_t initialDataStoreSize) {
     UA_HistoryDataBackend result = UA_HistoryDataBackend_Memory(initialNodeIdStoreSize, initialDataStoreSize);
     result.serverSetHistoryData = &serverSetHistoryData_backend_memory_Circular;
+    result.serverSetHistoryDataCached = &serverSetHistoryDataCached_backend_memory_Circular;
     result.getHistoryData = &getHistoryData_service_Circular;
+    /* The circular buffer is not sorted */
+    result.insertDataValues = NULL;
     return result;
 }
@@ -0,0 +1,1504 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_data_backend_memory_compressed.h>
+
+#include <string.h>
+
+#if defined(__linux__) || defined(__unix__)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define SAMPLE_HASVALUE           0x01
+#define SAMPLE_HASSTATUS          0x02
+#define SAMPLE_HASSOURCETIMESTAMP 0x04
+
+/* Uncompressed form of a sample. The timestamp is the source timestamp if
+ * present and the server timestamp otherwise. */
+typedef struct {
+    UA_DateTime timestamp;
+    UA_DateTime serverTimestamp;
+    UA_UInt64 value; /* Bit pattern of the numeric value */
+    UA_StatusCode status;
+    UA_Byte flags;
+} UA_CompressedSample;
+
+/* The last block of a series is open. It keeps the samples uncompressed until
+ * it is full. All other blocks are sealed and only hold the bit stream. With
+ * tiering, the bit stream of a sealed block can be evicted to the file. Then
+ * data is NULL and the block is read back when it is accessed. */
+typedef struct {
+    UA_DateTime first;
+    UA_DateTime last;
+    size_t start; /* Index of the first sample in the series */
+    size_t count;
+    UA_CompressedSample *samples; /* Open block */
+    UA_Byte *data;                /* Sealed block */
+    size_t dataSize;
+    UA_UInt64 fileOffset;  /* Of the copy in the file */
+    UA_Boolean onFile;     /* The file holds the current bit stream */
+    UA_Boolean referenced; /* Accessed since the clock hand passed */
+} UA_CompressedBlock;
+
+typedef struct {
+    UA_NodeId nodeId;
+    const UA_DataType *type; /* Set with the first value */
+    UA_CompressedBlock *blocks;
+    size_t blocksSize;
+    size_t count;
+    size_t version; /* Incremented when the index of samples changes */
+} UA_CompressedSeries;
+
+typedef struct {
+    UA_CompressedSeries *series;
+    size_t seriesEnd;
+    size_t seriesSize;
+    size_t blockSize;
+
+    /* The most recently decoded sealed block. Every change of the store
+     * invalidates the cache. */
+    const UA_CompressedBlock *cachedBlock;
+    UA_CompressedSample *cache;
+
+    /* Returned from getDataValue */
+    UA_DataValue scratch;
+    UA_UInt64 scratchValue;
+
+    /* Tiering of the sealed blocks to a file. The bit streams in memory are
+     * limited to memoryLimit bytes. Blocks are evicted with the clock
+     * (second chance) approximation of LRU. */
+    int fd; /* -1 without tiering */
+    char *path;
+    UA_UInt64 fileEnd;
+    size_t memoryLimit;
+    size_t memoryBytes;
+    size_t clockSeries; /* Position of the clock hand */
+    size_t clockBlock;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} UA_CompressedStoreContext;
+
+/**************/
+/* Bit Stream */
+/**************/
+
+typedef struct {
+    UA_Byte *data;
+    size_t pos; /* In bits */
+    size_t length; /* In bytes */
+    UA_Boolean error;
+} UA_BitStream;
+
+static void
+writeBits(UA_BitStream *s, UA_UInt64 v, UA_Byte n) {
+    while(n > 0) {
+        UA_Byte avail = (UA_Byte)(8 - (s->pos & 7));
+        UA_Byte take = (n < avail) ? n : avail;
+        UA_Byte chunk = (UA_Byte)((v >> (n - take)) & ((1u << take) - 1));
+        s->data[s->pos >> 3] |= (UA_Byte)(chunk << (avail - take));
+        s->pos += take;
+        n = (UA_Byte)(n - take);
+    }
+}
+
+static UA_UInt64
+readBits(UA_BitStream *s, UA_Byte n) {
+    if(s->pos + n > s->length * 8) {
+        s->error = true;
+        return 0;
+    }
+    UA_UInt64 v = 0;
+    while(n > 0) {
+        UA_Byte avail = (UA_Byte)(8 - (s->pos & 7));
+        UA_Byte take = (n < avail) ? n : avail;
+        UA_Byte chunk = (UA_Byte)((s->data[s->pos >> 3] >> (avail - take)) &
+                                  ((1u << take) - 1));
+        v = (v << take) | chunk;
+        s->pos += take;
+        n = (UA_Byte)(n - take);
+    }
+    return v;
+}
+
+/* Worst case number of bits for the encoding of a sample */
+#define SAMPLE_MAXBITS ((5 + 64) * 2 + (2 + 12 + 64) + (8 + 32 + 16))
+
+/****************************/
+/* Delta-of-Delta Timestamp */
+/****************************/
+
+/* Buckets of the zigzag encoded delta-of-delta. The timestamps have a 100ns
+ * resolution. So the buckets are wider than the second-based original. */
+static const UA_Byte dodBits[5] = {7, 12, 20, 32, 64};
+
+typedef struct {
+    UA_UInt64 prev;
+    UA_UInt64 prevDelta;
+} UA_DoDState;
+
+static void
+encodeDoD(UA_BitStream *s, UA_DoDState *st, UA_Int64 value, size_t i) {
+    UA_UInt64 v = (UA_UInt64)value;
+    if(i == 0) {
+        writeBits(s, v, 64);
+    } else {
+        UA_UInt64 delta = v - st->prev;
+        UA_UInt64 dod = delta - st->prevDelta;
+        UA_UInt64 zz = (dod << 1) ^ (0 - (dod >> 63));
+        if(zz == 0) {
+            writeBits(s, 0, 1);
+        } else {
+            UA_Byte b = 0;
+            while(b < 4 && zz >= ((UA_UInt64)1 << dodBits[b]))
+                b++;
+            /* Prefix of b+1 one-bits, terminated with a zero-bit except for
+             * the last bucket */
+            writeBits(s, ((UA_UInt64)1 << (b + 1)) - 1, (UA_Byte)(b + 1));
+            if(b < 4)
+                writeBits(s, 0, 1);
+            writeBits(s, zz, dodBits[b]);
+        }
+        st->prevDelta = delta;
+    }
+    st->prev = v;
+}
+
+static UA_Int64
+decodeDoD(UA_BitStream *s, UA_DoDState *st, size_t i) {
+    if(i == 0) {
+        st->prev = readBits(s, 64);
+        return (UA_Int64)st->prev;
+    }
+    UA_UInt64 dod = 0;
+    if(readBits(s, 1) != 0) {
+        UA_Byte b = 0;
+        while(b < 4 && readBits(s, 1) != 0)
+            b++;
+        UA_UInt64 zz = readBits(s, dodBits[b]);
+        dod = (zz >> 1) ^ (0 - (zz & 1));
+    }
+    st->prevDelta += dod;
+    st->prev += st->prevDelta;
+    return (UA_Int64)st->prev;
+}
+
+/**********************/
+/* XOR Value Encoding */
+/**********************/
+
+typedef struct {
+    UA_UInt64 prev;
+    UA_Byte lead;
+    UA_Byte trail;
+    UA_Boolean window;
+} UA_XorState;
+
+static UA_Byte
+leadingZeros(UA_UInt64 x) {
+    UA_Byte n = 0;
+    while(n < 64 && !(x & ((UA_UInt64)1 << (63 - n))))
+        n++;
+    return n;
+}
+
+static UA_Byte
+trailingZeros(UA_UInt64 x) {
+    UA_Byte n = 0;
+    while(n < 64 && !(x & ((UA_UInt64)1 << n)))
+        n++;
+    return n;
+}
+
+static void
+encodeXor(UA_BitStream *s, UA_XorState *st, UA_UInt64 v, size_t i) {
+    if(i == 0) {
+        writeBits(s, v, 64);
+        st->prev = v;
+        return;
+    }
+    UA_UInt64 x = v ^ st->prev;
+    st->prev = v;
+    if(x == 0) {
+        writeBits(s, 0, 1);
+        return;
+    }
+    writeBits(s, 1, 1);
+    UA_Byte lead = leadingZeros(x);
+    UA_Byte trail = trailingZeros(x);
+    if(st->window && lead >= st->lead && trail >= st->trail) {
+        /* The meaningful bits fit into the previous window */
+        writeBits(s, 0, 1);
+        writeBits(s, x >> st->trail, (UA_Byte)(64 - st->lead - st->trail));
+        return;
+    }
+    UA_Byte len = (UA_Byte)(64 - lead - trail);
+    writeBits(s, 1, 1);
+    writeBits(s, lead, 6);
+    writeBits(s, (UA_UInt64)(len - 1), 6);
+    writeBits(s, x >> trail, len);
+    st->lead = lead;
+    st->trail = trail;
+    st->window = true;
+}
+
+static UA_UInt64
+decodeXor(UA_BitStream *s, UA_XorState *st, size_t i) {
+    if(i == 0) {
+        st->prev = readBits(s, 64);
+        return st->prev;
+    }
+    if(readBits(s, 1) == 0)
+        return st->prev;
+    if(readBits(s, 1) != 0) {
+        st->lead = (UA_Byte)readBits(s, 6);
+        UA_Byte len = (UA_Byte)(readBits(s, 6) + 1);
+        if(st->lead + len > 64) {
+            s->error = true;
+            return 0;
+        }
+        st->trail = (UA_Byte)(64 - st->lead - len);
+        st->window = true;
+    } else if(!st->window) {
+        s->error = true;
+        return 0;
+    }
+    UA_UInt64 x = readBits(s, (UA_Byte)(64 - st->lead - st->trail));
+    st->prev ^= x << st->trail;
+    return st->prev;
+}
+
+/***************/
+/* Block Codec */
+/***************/
+
+static UA_StatusCode
+encodeBlock(UA_CompressedBlock *block, const UA_CompressedSample *samples,
+            size_t count) {
+    UA_BitStream s;
+    memset(&s, 0, sizeof(UA_BitStream));
+    s.length = (count * SAMPLE_MAXBITS + 7) / 8;
+    s.data = (UA_Byte*)UA_calloc(s.length, 1);
+    if(!s.data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Timestamps */
+    UA_DoDState dod;
+    memset(&dod, 0, sizeof(UA_DoDState));
+    for(size_t i = 0; i < count; i++)
+        encodeDoD(&s, &dod, samples[i].timestamp, i);
+
+    /* Server timestamps as the offset to the timestamp */
+    memset(&dod, 0, sizeof(UA_DoDState));
+    for(size_t i = 0; i < count; i++)
+        encodeDoD(&s, &dod, (UA_Int64)((UA_UInt64)samples[i].serverTimestamp -
+                                       (UA_UInt64)samples[i].timestamp), i);
+
+    /* Values */
+    UA_XorState xs;
+    memset(&xs, 0, sizeof(UA_XorState));
+    for(size_t i = 0; i < count; i++)
+        encodeXor(&s, &xs, samples[i].value, i);
+
+    /* Runs of flags and StatusCode */
+    for(size_t i = 0; i < count;) {
+        size_t run = 1;
+        while(i + run < count &&
+              samples[i + run].status == samples[i].status &&
+              samples[i + run].flags == samples[i].flags)
+            run++;
+        writeBits(&s, samples[i].flags, 8);
+        writeBits(&s, samples[i].status, 32);
+        writeBits(&s, run, 16);
+        i += run;
+    }
+
+    /* Shrink to the used size */
+    size_t used = (s.pos + 7) / 8;
+    UA_Byte *data = (UA_Byte*)UA_realloc(s.data, used);
+    if(!data) {
+        UA_free(s.data);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_free(block->data);
+    block->data = data;
+    block->dataSize = used;
+    block->count = count;
+    block->first = samples[0].timestamp;
+    block->last = samples[count - 1].timestamp;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+decodeBlock(const UA_CompressedBlock *block, UA_CompressedSample *samples) {
+    UA_BitStream s;
+    memset(&s, 0, sizeof(UA_BitStream));
+    s.data = block->data;
+    s.length = block->dataSize;
+    size_t count = block->count;
+
+    UA_DoDState dod;
+    memset(&dod, 0, sizeof(UA_DoDState));
+    for(size_t i = 0; i < count; i++)
+        samples[i].timestamp = decodeDoD(&s, &dod, i);
+
+    memset(&dod, 0, sizeof(UA_DoDState));
+    for(size_t i = 0; i < count; i++)
+        samples[i].serverTimestamp = (UA_DateTime)
+            ((UA_UInt64)samples[i].timestamp + (UA_UInt64)decodeDoD(&s, &dod, i));
+
+    UA_XorState xs;
+    memset(&xs, 0, sizeof(UA_XorState));
+    for(size_t i = 0; i < count; i++)
+        samples[i].value = decodeXor(&s, &xs, i);
+
+    for(size_t i = 0; i < count;) {
+        UA_Byte flags = (UA_Byte)readBits(&s, 8);
+        UA_StatusCode status = (UA_StatusCode)readBits(&s, 32);
+        size_t run = (size_t)readBits(&s, 16);
+        if(s.error || run == 0 || i + run > count)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        for(size_t j = 0; j < run; j++, i++) {
+            samples[i].flags = flags;
+            samples[i].status = status;
+        }
+    }
+    return (s.error) ? UA_STATUSCODE_BADINTERNALERROR : UA_STATUSCODE_GOOD;
+}
+
+/*****************/
+/* Numeric Value */
+/*****************/
+
+static UA_Boolean
+isCompressibleType(const UA_DataType *type) {
+    return type->typeKind <= UA_DATATYPEKIND_DOUBLE &&
+        type == &UA_TYPES[type->typeKind];
+}
+
+static UA_UInt64
+valueToBits(const UA_Variant *v) {
+    const void *p = v->data;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: return *(const UA_Boolean*)p ? 1 : 0;
+    case UA_DATATYPEKIND_SBYTE: return (UA_UInt64)(UA_Int64)*(const UA_SByte*)p;
+    case UA_DATATYPEKIND_BYTE: return *(const UA_Byte*)p;
+    case UA_DATATYPEKIND_INT16: return (UA_UInt64)(UA_Int64)*(const UA_Int16*)p;
+    case UA_DATATYPEKIND_UINT16: return *(const UA_UInt16*)p;
+    case UA_DATATYPEKIND_INT32: return (UA_UInt64)(UA_Int64)*(const UA_Int32*)p;
+    case UA_DATATYPEKIND_UINT32: return *(const UA_UInt32*)p;
+    case UA_DATATYPEKIND_INT64: return (UA_UInt64)*(const UA_Int64*)p;
+    case UA_DATATYPEKIND_UINT64: return *(const UA_UInt64*)p;
+    case UA_DATATYPEKIND_FLOAT: {
+        UA_UInt32 b;
+        memcpy(&b, p, sizeof(UA_UInt32));
+        return b;
+    }
+    default: {
+        UA_UInt64 b;
+        memcpy(&b, p, sizeof(UA_UInt64));
+        return b;
+    }
+    }
+}
+
+static void
+bitsToValue(const UA_DataType *type, UA_UInt64 bits, void *p) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: *(UA_Boolean*)p = (bits != 0); break;
+    case UA_DATATYPEKIND_SBYTE: *(UA_SByte*)p = (UA_SByte)(UA_Int64)bits; break;
+    case UA_DATATYPEKIND_BYTE: *(UA_Byte*)p = (UA_Byte)bits; break;
+    case UA_DATATYPEKIND_INT16: *(UA_Int16*)p = (UA_Int16)(UA_Int64)bits; break;
+    case UA_DATATYPEKIND_UINT16: *(UA_UInt16*)p = (UA_UInt16)bits; break;
+    case UA_DATATYPEKIND_INT32: *(UA_Int32*)p = (UA_Int32)(UA_Int64)bits; break;
+    case UA_DATATYPEKIND_UINT32: *(UA_UInt32*)p = (UA_UInt32)bits; break;
+    case UA_DATATYPEKIND_INT64: *(UA_Int64*)p = (UA_Int64)bits; break;
+    case UA_DATATYPEKIND_UINT64: *(UA_UInt64*)p = bits; break;
+    case UA_DATATYPEKIND_FLOAT: {
+        UA_UInt32 b = (UA_UInt32)bits;
+        memcpy(p, &b, sizeof(UA_UInt32));
+        break;
+    }
+    default:
+        memcpy(p, &bits, sizeof(UA_UInt64));
+        break;
+    }
+}
+
+static UA_StatusCode
+sampleFromDataValue(UA_CompressedSeries *series, const UA_DataValue *value,
+                    UA_DateTime timestamp, UA_CompressedSample *sample) {
+    memset(sample, 0, sizeof(UA_CompressedSample));
+    if(value->hasValue) {
+        if(!UA_Variant_isScalar(&value->value) ||
+           !isCompressibleType(value->value.type))
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        if(series->type && series->type != value->value.type)
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        series->type = value->value.type;
+        sample->value = valueToBits(&value->value);
+        sample->flags |= SAMPLE_HASVALUE;
+    }
+    if(value->hasStatus) {
+        sample->status = value->status;
+        sample->flags |= SAMPLE_HASSTATUS;
+    }
+    if(value->hasSourceTimestamp)
+        sample->flags |= SAMPLE_HASSOURCETIMESTAMP;
+    sample->timestamp = timestamp;
+    sample->serverTimestamp =
+        (value->hasServerTimestamp) ? value->serverTimestamp : timestamp;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The returned DataValue points to the value storage. The server timestamp is
+ * always set, as in the memory backend. */
+static void
+sampleToDataValue(const UA_CompressedSeries *series,
+                  const UA_CompressedSample *sample,
+                  UA_DataValue *dv, void *valueStorage) {
+    UA_DataValue_init(dv);
+    if((sample->flags & SAMPLE_HASVALUE) && series->type) {
+        bitsToValue(series->type, sample->value, valueStorage);
+        UA_Variant_setScalar(&dv->value, valueStorage, series->type);
+        dv->value.storageType = UA_VARIANT_DATA_NODELETE;
+        dv->hasValue = true;
+    }
+    if(sample->flags & SAMPLE_HASSTATUS) {
+        dv->status = sample->status;
+        dv->hasStatus = true;
+    }
+    if(sample->flags & SAMPLE_HASSOURCETIMESTAMP) {
+        dv->sourceTimestamp = sample->timestamp;
+        dv->hasSourceTimestamp = true;
+    }
+    dv->serverTimestamp = sample->serverTimestamp;
+    dv->hasServerTimestamp = true;
+}
+
+/**********/
+/* Series */
+/**********/
+
+static void
+UA_CompressedBlock_clear(UA_CompressedBlock *block) {
+    UA_free(block->samples);
+    UA_free(block->data);
+    memset(block, 0, sizeof(UA_CompressedBlock));
+}
+
+static void
+UA_CompressedSeries_clear(UA_CompressedSeries *series) {
+    UA_NodeId_clear(&series->nodeId);
+    for(size_t i = 0; i < series->blocksSize; i++)
+        UA_CompressedBlock_clear(&series->blocks[i]);
+    UA_free(series->blocks);
+    memset(series, 0, sizeof(UA_CompressedSeries));
+}
+
+static void
+UA_CompressedStoreContext_delete(UA_CompressedStoreContext *ctx) {
+    for(size_t i = 0; i < ctx->seriesEnd; i++)
+        UA_CompressedSeries_clear(&ctx->series[i]);
+    UA_free(ctx->series);
+    UA_free(ctx->cache);
+#if defined(__linux__) || defined(__unix__)
+    if(ctx->fd >= 0) {
+        close(ctx->fd);
+        unlink(ctx->path);
+    }
+#endif
+    UA_free(ctx->path);
+    UA_free(ctx);
+}
+
+/***********/
+/* Tiering */
+/***********/
+
+#if defined(__linux__) || defined(__unix__)
+
+static UA_StatusCode
+writeFile(int fd, UA_UInt64 offset, const UA_Byte *data, size_t size) {
+    while(size > 0) {
+        ssize_t n = pwrite(fd, data, size, (off_t)offset);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        data += n;
+        size -= (size_t)n;
+        offset += (UA_UInt64)n;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readFile(int fd, UA_UInt64 offset, UA_Byte *data, size_t size) {
+    while(size > 0) {
+        ssize_t n = pread(fd, data, size, (off_t)offset);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        data += n;
+        size -= (size_t)n;
+        offset += (UA_UInt64)n;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+#else
+
+static UA_StatusCode
+writeFile(int fd, UA_UInt64 offset, const UA_Byte *data, size_t size) {
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+}
+
+static UA_StatusCode
+readFile(int fd, UA_UInt64 offset, UA_Byte *data, size_t size) {
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+}
+
+#endif
+
+/* Moves the bit stream of the block to the file. Unchanged blocks that were
+ * evicted before are not written again. Rewritten blocks are appended, the
+ * space of their old copy is not reused. */
+static UA_StatusCode
+evictBlock(UA_CompressedStoreContext *ctx, UA_CompressedBlock *block) {
+    if(!block->onFile) {
+        UA_StatusCode res = writeFile(ctx->fd, ctx->fileEnd, block->data, block->dataSize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        block->fileOffset = ctx->fileEnd;
+        block->onFile = true;
+        ctx->fileEnd += block->dataSize;
+    }
+    UA_free(block->data);
+    block->data = NULL;
+    ctx->memoryBytes -= block->dataSize;
+    ctx->evictions++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Advance the clock hand over the sealed blocks in memory. Referenced blocks
+ * get a second chance. The except block is not evicted. */
+static void
+enforceMemoryLimit(UA_CompressedStoreContext *ctx, const UA_CompressedBlock *except) {
+    if(ctx->fd < 0 || ctx->memoryBytes <= ctx->memoryLimit)
+        return;
+    size_t steps = 0, maxSteps = 0;
+    for(size_t i = 0; i < ctx->seriesEnd; i++)
+        maxSteps += ctx->series[i].blocksSize;
+    maxSteps *= 2; /* Clear the references in the first round */
+    while(ctx->memoryBytes > ctx->memoryLimit && steps++ < maxSteps) {
+        if(ctx->clockSeries >= ctx->seriesEnd) {
+            ctx->clockSeries = 0;
+            ctx->clockBlock = 0;
+        }
+        UA_CompressedSeries *series = &ctx->series[ctx->clockSeries];
+        if(ctx->clockBlock >= series->blocksSize) {
+            ctx->clockSeries++;
+            ctx->clockBlock = 0;
+            steps--; /* Not a block */
+            continue;
+        }
+        UA_CompressedBlock *block = &series->blocks[ctx->clockBlock++];
+        if(!block->data || block == except)
+            continue;
+        if(block->referenced) {
+            block->referenced = false;
+            continue;
+        }
+        if(evictBlock(ctx, block) != UA_STATUSCODE_GOOD)
+            return;
+    }
+}
+
+/* Accounts the bit stream of a block after it was (re-)encoded */
+static void
+blockEncoded(UA_CompressedStoreContext *ctx, UA_CompressedBlock *block,
+             size_t oldSize) {
+    ctx->memoryBytes = ctx->memoryBytes - oldSize + block->dataSize;
+    block->onFile = false;
+    block->referenced = true;
+    enforceMemoryLimit(ctx, block);
+}
+
+static UA_CompressedSeries *
+findSeries(UA_CompressedStoreContext *ctx, const UA_NodeId *nodeId) {
+    for(size_t i = 0; i < ctx->seriesEnd; i++) {
+        if(UA_NodeId_equal(nodeId, &ctx->series[i].nodeId))
+            return &ctx->series[i];
+    }
+    return NULL;
+}
+
+static UA_CompressedSeries *
+getSeries(UA_CompressedStoreContext *ctx, const UA_NodeId *nodeId) {
+    UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(series)
+        return series;
+    if(ctx->seriesEnd >= ctx->seriesSize) {
+        size_t newSize = (ctx->seriesSize == 0) ? 1 : ctx->seriesSize * 2;
+        UA_CompressedSeries *s = (UA_CompressedSeries*)
+            UA_realloc(ctx->series, newSize * sizeof(UA_CompressedSeries));
+        if(!s)
+            return NULL;
+        ctx->series = s;
+        ctx->seriesSize = newSize;
+    }
+    series = &ctx->series[ctx->seriesEnd];
+    memset(series, 0, sizeof(UA_CompressedSeries));
+    if(UA_NodeId_copy(nodeId, &series->nodeId) != UA_STATUSCODE_GOOD)
+        return NULL;
+    ctx->seriesEnd++;
+    return series;
+}
+
+static void
+updateBlockStarts(UA_CompressedSeries *series, size_t from) {
+    size_t start = (from > 0) ?
+        series->blocks[from - 1].start + series->blocks[from - 1].count : 0;
+    for(size_t i = from; i < series->blocksSize; i++) {
+        series->blocks[i].start = start;
+        start += series->blocks[i].count;
+    }
+    series->count = start;
+}
+
+/* Index of the block containing the sample */
+static size_t
+findBlock(const UA_CompressedSeries *series, size_t index) {
+    size_t min = 0;
+    size_t max = series->blocksSize;
+    while(max - min > 1) {
+        size_t mid = (min + max) / 2;
+        if(series->blocks[mid].start <= index)
+            min = mid;
+        else
+            max = mid;
+    }
+    return min;
+}
+
+/* Returns the samples of a block. Sealed blocks are decoded into the cache.
+ * Evicted blocks are read back from the file first. Paging changes only the
+ * residency of the block and not its content. */
+static const UA_CompressedSample *
+getBlockSamples(UA_CompressedStoreContext *ctx, const UA_CompressedBlock *block) {
+    if(block->samples)
+        return block->samples;
+    UA_CompressedBlock *b = (UA_CompressedBlock*)(uintptr_t)block;
+    b->referenced = true;
+    if(!b->data) {
+        b->data = (UA_Byte*)UA_malloc(b->dataSize);
+        if(!b->data)
+            return NULL;
+        if(readFile(ctx->fd, b->fileOffset, b->data, b->dataSize) != UA_STATUSCODE_GOOD) {
+            UA_free(b->data);
+            b->data = NULL;
+            return NULL;
+        }
+        ctx->misses++;
+        ctx->memoryBytes += b->dataSize;
+        enforceMemoryLimit(ctx, b);
+    } else {
+        ctx->hits++;
+    }
+    if(ctx->cachedBlock == block)
+        return ctx->cache;
+    ctx->cachedBlock = NULL;
+    if(decodeBlock(block, ctx->cache) != UA_STATUSCODE_GOOD)
+        return NULL;
+    ctx->cachedBlock = block;
+    return ctx->cache;
+}
+
+static UA_StatusCode
+insertBlock(UA_CompressedSeries *series, size_t index) {
+    UA_CompressedBlock *blocks = (UA_CompressedBlock*)
+        UA_realloc(series->blocks, (series->blocksSize + 1) * sizeof(UA_CompressedBlock));
+    if(!blocks)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    series->blocks = blocks;
+    memmove(&blocks[index + 1], &blocks[index],
+            (series->blocksSize - index) * sizeof(UA_CompressedBlock));
+    memset(&blocks[index], 0, sizeof(UA_CompressedBlock));
+    series->blocksSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeBlock(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series, size_t index) {
+    if(series->blocks[index].data)
+        ctx->memoryBytes -= series->blocks[index].dataSize;
+    UA_CompressedBlock_clear(&series->blocks[index]);
+    memmove(&series->blocks[index], &series->blocks[index + 1],
+            (series->blocksSize - index - 1) * sizeof(UA_CompressedBlock));
+    series->blocksSize--;
+}
+
+static UA_StatusCode
+sealBlock(UA_CompressedStoreContext *ctx, UA_CompressedBlock *block) {
+    UA_StatusCode res = encodeBlock(block, block->samples, block->count);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_free(block->samples);
+    block->samples = NULL;
+    blockEncoded(ctx, block, 0);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encode a sealed block that was read before. Its bit stream may have been
+ * evicted in the meantime. */
+static UA_StatusCode
+reencodeBlock(UA_CompressedStoreContext *ctx, UA_CompressedBlock *block,
+              const UA_CompressedSample *samples, size_t count) {
+    size_t oldSize = (block->data) ? block->dataSize : 0;
+    UA_StatusCode res = encodeBlock(block, samples, count);
+    if(res == UA_STATUSCODE_GOOD)
+        blockEncoded(ctx, block, oldSize);
+    return res;
+}
+
+/* Replace the content of a sealed block. The samples buffer can hold up to two
+ * blocks. A block above the blockSize is split in two. */
+static UA_StatusCode
+rewriteBlock(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series,
+             size_t index, const UA_CompressedSample *samples, size_t count) {
+    ctx->cachedBlock = NULL;
+    if(count == 0) {
+        removeBlock(ctx, series, index);
+        return UA_STATUSCODE_GOOD;
+    }
+    if(count <= ctx->blockSize)
+        return reencodeBlock(ctx, &series->blocks[index], samples, count);
+    size_t half = count / 2;
+    UA_StatusCode res = insertBlock(series, index + 1);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = reencodeBlock(ctx, &series->blocks[index + 1], &samples[half], count - half);
+    if(res != UA_STATUSCODE_GOOD) {
+        removeBlock(ctx, series, index + 1);
+        return res;
+    }
+    return reencodeBlock(ctx, &series->blocks[index], samples, half);
+}
+
+/* Append to the open block at the end of the series */
+static UA_StatusCode
+appendSample(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series,
+             const UA_CompressedSample *sample) {
+    UA_CompressedBlock *block = (series->blocksSize > 0) ?
+        &series->blocks[series->blocksSize - 1] : NULL;
+    if(!block || !block->samples) {
+        UA_CompressedSample *samples = (UA_CompressedSample*)
+            UA_malloc(ctx->blockSize * sizeof(UA_CompressedSample));
+        if(!samples)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        ctx->cachedBlock = NULL; /* The blocks may move */
+        UA_StatusCode res = insertBlock(series, series->blocksSize);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(samples);
+            return res;
+        }
+        block = &series->blocks[series->blocksSize - 1];
+        block->samples = samples;
+        block->start = series->count;
+        block->first = sample->timestamp;
+    }
+    block->samples[block->count++] = *sample;
+    block->last = sample->timestamp;
+    series->count++;
+    if(block->count == ctx->blockSize)
+        return sealBlock(ctx, block);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Insert at the index into the series */
+static UA_StatusCode
+insertSample(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series,
+             size_t index, const UA_CompressedSample *sample) {
+    if(index >= series->count)
+        return appendSample(ctx, series, sample);
+
+    series->version++;
+    size_t b = findBlock(series, index);
+    UA_CompressedBlock *block = &series->blocks[b];
+    size_t pos = index - block->start;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(block->samples) {
+        /* The open block is never full */
+        memmove(&block->samples[pos + 1], &block->samples[pos],
+                (block->count - pos) * sizeof(UA_CompressedSample));
+        block->samples[pos] = *sample;
+        block->count++;
+        block->first = block->samples[0].timestamp;
+        block->last = block->samples[block->count - 1].timestamp;
+        if(block->count == ctx->blockSize)
+            res = sealBlock(ctx, block);
+    } else {
+        const UA_CompressedSample *s = getBlockSamples(ctx, block);
+        if(!s)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        size_t count = block->count;
+        UA_CompressedSample *tmp = (UA_CompressedSample*)
+            UA_malloc((count + 1) * sizeof(UA_CompressedSample));
+        if(!tmp)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memcpy(tmp, s, pos * sizeof(UA_CompressedSample));
+        tmp[pos] = *sample;
+        memcpy(&tmp[pos + 1], &s[pos], (count - pos) * sizeof(UA_CompressedSample));
+        res = rewriteBlock(ctx, series, b, tmp, count + 1);
+        UA_free(tmp);
+    }
+    updateBlockStarts(series, b);
+    return res;
+}
+
+static UA_StatusCode
+replaceSample(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series,
+              size_t index, const UA_CompressedSample *sample) {
+    size_t b = findBlock(series, index);
+    UA_CompressedBlock *block = &series->blocks[b];
+    size_t pos = index - block->start;
+    if(block->samples) {
+        block->samples[pos] = *sample;
+        return UA_STATUSCODE_GOOD;
+    }
+    const UA_CompressedSample *s = getBlockSamples(ctx, block);
+    if(!s)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    size_t count = block->count;
+    UA_CompressedSample *tmp = (UA_CompressedSample*)
+        UA_malloc(count * sizeof(UA_CompressedSample));
+    if(!tmp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    memcpy(tmp, s, count * sizeof(UA_CompressedSample));
+    tmp[pos] = *sample;
+    UA_StatusCode res = rewriteBlock(ctx, series, b, tmp, count);
+    UA_free(tmp);
+    return res;
+}
+
+/* Remove the samples [index1, index2) */
+static UA_StatusCode
+removeSamples(UA_CompressedStoreContext *ctx, UA_CompressedSeries *series,
+              size_t index1, size_t index2) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    series->version++;
+    size_t first = findBlock(series, index1);
+    size_t b = findBlock(series, index2 - 1) + 1;
+    while(b > first) {
+        b--;
+        UA_CompressedBlock *block = &series->blocks[b];
+        size_t from = (index1 > block->start) ? index1 - block->start : 0;
+        size_t to = index2 - block->start;
+        if(to > block->count)
+            to = block->count;
+        if(block->samples) {
+            memmove(&block->samples[from], &block->samples[to],
+                    (block->count - to) * sizeof(UA_CompressedSample));
+            block->count -= to - from;
+            if(block->count == 0) {
+                ctx->cachedBlock = NULL;
+                removeBlock(ctx, series, b);
+                continue;
+            }
+            block->first = block->samples[0].timestamp;
+            block->last = block->samples[block->count - 1].timestamp;
+            continue;
+        }
+        const UA_CompressedSample *s = getBlockSamples(ctx, block);
+        if(!s)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        size_t count = block->count;
+        UA_CompressedSample *tmp = (UA_CompressedSample*)
+            UA_malloc(count * sizeof(UA_CompressedSample));
+        if(!tmp)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memcpy(tmp, s, from * sizeof(UA_CompressedSample));
+        memcpy(&tmp[from], &s[to], (count - to) * sizeof(UA_CompressedSample));
+        res |= rewriteBlock(ctx, series, b, tmp, count - (to - from));
+        UA_free(tmp);
+    }
+    updateBlockStarts(series, first);
+    return res;
+}
+
+/* Index of the first sample with a timestamp >= the given timestamp */
+static size_t
+lowerBound(UA_CompressedStoreContext *ctx, const UA_CompressedSeries *series,
+           UA_DateTime timestamp, UA_Boolean *equal) {
+    *equal = false;
+    /* Find the first block that ends at or after the timestamp */
+    size_t min = 0;
+    size_t max = series->blocksSize;
+    while(min < max) {
+        size_t mid = (min + max) / 2;
+        if(series->blocks[mid].last < timestamp)
+            min = mid + 1;
+        else
+            max = mid;
+    }
+    if(min == series->blocksSize)
+        return series->count;
+
+    /* Search inside the block. Only this block is decoded. */
+    const UA_CompressedBlock *block = &series->blocks[min];
+    const UA_CompressedSample *s = getBlockSamples(ctx, block);
+    if(!s)
+        return series->count;
+    size_t lo = 0;
+    size_t hi = block->count;
+    while(lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if(s[mid].timestamp < timestamp)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *equal = (lo < block->count && s[lo].timestamp == timestamp);
+    return block->start + lo;
+}
+
+static const UA_CompressedSample *
+getSample(UA_CompressedStoreContext *ctx, const UA_CompressedSeries *series,
+          size_t index) {
+    if(index >= series->count)
+        return NULL;
+    const UA_CompressedBlock *block = &series->blocks[findBlock(series, index)];
+    const UA_CompressedSample *s = getBlockSamples(ctx, block);
+    return (s) ? &s[index - block->start] : NULL;
+}
+
+/*******************/
+/* Backend Methods */
+/*******************/
+
+static size_t
+getDateTimeMatch_backend_memory_compressed(UA_Server *server,
+                                           void *context,
+                                           const UA_NodeId *sessionId,
+                                           void *sessionContext,
+                                           const UA_NodeId *nodeId,
+                                           const UA_DateTime timestamp,
+                                           const MatchStrategy strategy) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    const UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return 0;
+    UA_Boolean equal;
+    size_t current = lowerBound(ctx, series, timestamp, &equal);
+
+    if((strategy == MATCH_EQUAL ||
+        strategy == MATCH_EQUAL_OR_AFTER ||
+        strategy == MATCH_EQUAL_OR_BEFORE) && equal)
+        return current;
+    switch(strategy) {
+    case MATCH_AFTER:
+        if(equal)
+            return current + 1;
+        return current;
+    case MATCH_EQUAL_OR_AFTER:
+        return current;
+    case MATCH_EQUAL_OR_BEFORE:
+        /* equal is handled before */
+    case MATCH_BEFORE:
+        if(current > 0)
+            return current - 1;
+        return series->count;
+    default:
+        break;
+    }
+    return series->count;
+}
+
+static UA_StatusCode
+serverSetHistoryData_backend_memory_compressed(UA_Server *server,
+                                               void *context,
+                                               const UA_NodeId *sessionId,
+                                               void *sessionContext,
+                                               const UA_NodeId *nodeId,
+                                               UA_Boolean historizing,
+                                               const UA_DataValue *value) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    UA_CompressedSeries *series = getSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_DateTime timestamp;
+    if(value->hasSourceTimestamp)
+        timestamp = value->sourceTimestamp;
+    else if(value->hasServerTimestamp)
+        timestamp = value->serverTimestamp;
+    else
+        timestamp = UA_DateTime_now();
+
+    UA_CompressedSample sample;
+    UA_StatusCode res = sampleFromDataValue(series, value, timestamp, &sample);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Fast path for samples arriving in order */
+    if(series->count == 0 ||
+       series->blocks[series->blocksSize - 1].last < timestamp)
+        return appendSample(ctx, series, &sample);
+
+    UA_Boolean equal;
+    size_t index = lowerBound(ctx, series, timestamp, &equal);
+    return insertSample(ctx, series, index, &sample);
+}
+
+static size_t
+resultSize_backend_memory_compressed(UA_Server *server,
+                                     void *context,
+                                     const UA_NodeId *sessionId,
+                                     void *sessionContext,
+                                     const UA_NodeId *nodeId,
+                                     size_t startIndex,
+                                     size_t endIndex) {
+    const UA_CompressedSeries *series =
+        findSeries((UA_CompressedStoreContext*)context, nodeId);
+    if(!series || series->count == 0 ||
+       startIndex == series->count || endIndex == series->count)
+        return 0;
+    return endIndex - startIndex + 1;
+}
+
+static size_t
+getEnd_backend_memory_compressed(UA_Server *server,
+                                 void *context,
+                                 const UA_NodeId *sessionId,
+                                 void *sessionContext,
+                                 const UA_NodeId *nodeId) {
+    const UA_CompressedSeries *series =
+        findSeries((UA_CompressedStoreContext*)context, nodeId);
+    return (series) ? series->count : 0;
+}
+
+static size_t
+lastIndex_backend_memory_compressed(UA_Server *server,
+                                    void *context,
+                                    const UA_NodeId *sessionId,
+                                    void *sessionContext,
+                                    const UA_NodeId *nodeId) {
+    const UA_CompressedSeries *series =
+        findSeries((UA_CompressedStoreContext*)context, nodeId);
+    if(!series || series->count == 0)
+        return 0;
+    return series->count - 1;
+}
+
+static size_t
+firstIndex_backend_memory_compressed(UA_Server *server,
+                                     void *context,
+                                     const UA_NodeId *sessionId,
+                                     void *sessionContext,
+                                     const UA_NodeId *nodeId) {
+    return 0;
+}
+
+static UA_Boolean
+boundSupported_backend_memory_compressed(UA_Server *server,
+                                         void *context,
+                                         const UA_NodeId *sessionId,
+                                         void *sessionContext,
+                                         const UA_NodeId *nodeId) {
+    return true;
+}
+
+static UA_Boolean
+timestampsToReturnSupported_backend_memory_compressed(UA_Server *server,
+                                                      void *context,
+                                                      const UA_NodeId *sessionId,
+                                                      void *sessionContext,
+                                                      const UA_NodeId *nodeId,
+                                                      const UA_TimestampsToReturn timestampsToReturn) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    const UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series || series->count == 0)
+        return true;
+    if(timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER ||
+       timestampsToReturn == UA_TIMESTAMPSTORETURN_INVALID)
+        return false;
+    /* The server timestamp is always stored */
+    if(timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER)
+        return true;
+    const UA_CompressedSample *s = getSample(ctx, series, 0);
+    return (s && (s->flags & SAMPLE_HASSOURCETIMESTAMP));
+}
+
+static const UA_DataValue *
+getDataValue_backend_memory_compressed(UA_Server *server,
+                                       void *context,
+                                       const UA_NodeId *sessionId,
+                                       void *sessionContext,
+                                       const UA_NodeId *nodeId,
+                                       size_t index) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    UA_DataValue_init(&ctx->scratch);
+    const UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return &ctx->scratch;
+    const UA_CompressedSample *s = getSample(ctx, series, index);
+    if(s)
+        sampleToDataValue(series, s, &ctx->scratch, &ctx->scratchValue);
+    return &ctx->scratch;
+}
+
+static UA_StatusCode
+copySample(const UA_CompressedSeries *series, const UA_CompressedSample *s,
+           const UA_NumericRange range, UA_DataValue *dst) {
+    UA_UInt64 storage;
+    UA_DataValue tmp;
+    sampleToDataValue(series, s, &tmp, &storage);
+    if(range.dimensionsSize > 0) {
+        *dst = tmp;
+        UA_Variant_init(&dst->value);
+        if(tmp.hasValue)
+            return UA_Variant_copyRange(&tmp.value, &dst->value, range);
+        return UA_STATUSCODE_BADDATAUNAVAILABLE;
+    }
+    return UA_DataValue_copy(&tmp, dst);
+}
+
+/* The continuation point is a cursor to the next sample. The index is used
+ * directly if the indices did not change since. Otherwise the sample is found
+ * again by its timestamp. */
+typedef struct {
+    size_t index;
+    size_t version;
+    UA_DateTime timestamp;
+} UA_CompressedCursor;
+
+static UA_StatusCode
+copyDataValues_backend_memory_compressed(UA_Server *server,
+                                         void *context,
+                                         const UA_NodeId *sessionId,
+                                         void *sessionContext,
+                                         const UA_NodeId *nodeId,
+                                         size_t startIndex,
+                                         size_t endIndex,
+                                         UA_Boolean reverse,
+                                         size_t maxValues,
+                                         UA_NumericRange range,
+                                         UA_Boolean releaseContinuationPoints,
+                                         const UA_ByteString *continuationPoint,
+                                         UA_ByteString *outContinuationPoint,
+                                         size_t *providedValues,
+                                         UA_DataValue *values) {
+    UA_CompressedCursor cursor;
+    memset(&cursor, 0, sizeof(UA_CompressedCursor));
+    if(continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(UA_CompressedCursor))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&cursor, continuationPoint->data, sizeof(UA_CompressedCursor));
+    }
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)context;
+    const UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    size_t storeEnd = (series) ? series->count : 0;
+
+    size_t index = startIndex;
+    if(series && continuationPoint->length > 0) {
+        if(cursor.version == series->version && cursor.index < storeEnd) {
+            index = cursor.index;
+        } else {
+            UA_Boolean equal;
+            index = lowerBound(ctx, series, cursor.timestamp, &equal);
+            if(reverse && !equal)
+                index = (index > 0) ? index - 1 : storeEnd;
+        }
+    }
+
+    /* Walk the samples block by block. Only the blocks between startIndex and
+     * endIndex are decoded. */
+    size_t counter = 0;
+    const UA_CompressedBlock *block = NULL;
+    const UA_CompressedSample *s = NULL;
+    while(index < storeEnd && counter < maxValues &&
+          ((reverse && index >= endIndex) || (!reverse && index <= endIndex))) {
+        if(!block || index < block->start ||
+           index >= block->start + block->count) {
+            block = &series->blocks[findBlock(series, index)];
+            s = getBlockSamples(ctx, block);
+            if(!s)
+                return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        copySample(series, &s[index - block->start], range, &values[counter]);
+        ++counter;
+        if(reverse) {
+            if(index == 0) {
+                index = storeEnd;
+                break;
+            }
+            --index;
+        } else {
+            ++index;
+        }
+    }
+
+    if(providedValues)
+        *providedValues = counter;
+
+    /* There are more values in the range */
+    if(index < storeEnd &&
+       ((!reverse && index <= endIndex) || (reverse && index >= endIndex))) {
+        const UA_CompressedSample *next = getSample(ctx, series, index);
+        if(!next)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        cursor.index = index;
+        cursor.version = series->version;
+        cursor.timestamp = next->timestamp;
+        UA_StatusCode res = UA_ByteString_allocBuffer(outContinuationPoint,
+                                                      sizeof(UA_CompressedCursor));
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        memcpy(outContinuationPoint->data, &cursor, sizeof(UA_CompressedCursor));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+insertDataValue_backend_memory_compressed(UA_Server *server,
+                                          void *hdbContext,
+                                          const UA_NodeId *sessionId,
+                                          void *sessionContext,
+                                          const UA_NodeId *nodeId,
+                                          const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    const UA_DateTime timestamp = value->hasSourceTimestamp ?
+        value->sourceTimestamp : value->serverTimestamp;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    UA_CompressedSeries *series = getSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_Boolean equal;
+    size_t index = lowerBound(ctx, series, timestamp, &equal);
+    if(equal)
+        return UA_STATUSCODE_BADENTRYEXISTS;
+
+    UA_CompressedSample sample;
+    UA_StatusCode res = sampleFromDataValue(series, value, timestamp, &sample);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return insertSample(ctx, series, index, &sample);
+}
+
+static UA_StatusCode
+replaceDataValue_backend_memory_compressed(UA_Server *server,
+                                           void *hdbContext,
+                                           const UA_NodeId *sessionId,
+                                           void *sessionContext,
+                                           const UA_NodeId *nodeId,
+                                           const UA_DataValue *value) {
+    if(!value->hasSourceTimestamp && !value->hasServerTimestamp)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMP;
+    const UA_DateTime timestamp = value->hasSourceTimestamp ?
+        value->sourceTimestamp : value->serverTimestamp;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+
+    UA_Boolean equal;
+    size_t index = lowerBound(ctx, series, timestamp, &equal);
+    if(!equal)
+        return UA_STATUSCODE_BADNOENTRYEXISTS;
+
+    UA_CompressedSample sample;
+    UA_StatusCode res = sampleFromDataValue(series, value, timestamp, &sample);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return replaceSample(ctx, series, index, &sample);
+}
+
+static UA_StatusCode
+updateDataValue_backend_memory_compressed(UA_Server *server,
+                                          void *hdbContext,
+                                          const UA_NodeId *sessionId,
+                                          void *sessionContext,
+                                          const UA_NodeId *nodeId,
+                                          const UA_DataValue *value) {
+    /* We first try to replace, because it is cheap */
+    UA_StatusCode ret =
+        replaceDataValue_backend_memory_compressed(server, hdbContext, sessionId,
+                                                   sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYREPLACED;
+
+    ret = insertDataValue_backend_memory_compressed(server, hdbContext, sessionId,
+                                                    sessionContext, nodeId, value);
+    if(ret == UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_GOODENTRYINSERTED;
+    return ret;
+}
+
+static UA_StatusCode
+removeDataValue_backend_memory_compressed(UA_Server *server,
+                                          void *hdbContext,
+                                          const UA_NodeId *sessionId,
+                                          void *sessionContext,
+                                          const UA_NodeId *nodeId,
+                                          UA_DateTime startTimestamp,
+                                          UA_DateTime endTimestamp) {
+    if(startTimestamp > endTimestamp)
+        return UA_STATUSCODE_BADTIMESTAMPNOTSUPPORTED;
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)hdbContext;
+    UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNODATA;
+
+    /* The first index which is deleted and the first index which is not */
+    UA_Boolean equal;
+    size_t index1 = lowerBound(ctx, series, startTimestamp, &equal);
+    size_t index2;
+    if(startTimestamp == endTimestamp) {
+        if(!equal)
+            return UA_STATUSCODE_BADNODATA;
+        index2 = index1 + 1;
+    } else {
+        /* The end timestamp is excluded */
+        index2 = lowerBound(ctx, series, endTimestamp, &equal);
+        if(index1 >= index2)
+            return UA_STATUSCODE_BADNODATA;
+    }
+    return removeSamples(ctx, series, index1, index2);
+}
+
+static void
+deleteMembers_backend_memory_compressed(UA_HistoryDataBackend *backend) {
+    if(backend == NULL || backend->context == NULL)
+        return;
+    UA_CompressedStoreContext_delete((UA_CompressedStoreContext*)backend->context);
+}
+
+UA_HistoryDataBackend
+UA_HistoryDataBackend_Memory_Compressed(size_t initialNodeIdStoreSize,
+                                        size_t blockSize) {
+    if(initialNodeIdStoreSize == 0)
+        initialNodeIdStoreSize = 1;
+    if(blockSize == 0)
+        blockSize = COMPRESSED_MEMORY_BLOCK_SIZE;
+    if(blockSize > COMPRESSED_MEMORY_MAX_BLOCK_SIZE)
+        blockSize = COMPRESSED_MEMORY_MAX_BLOCK_SIZE;
+    UA_HistoryDataBackend result;
+    memset(&result, 0, sizeof(UA_HistoryDataBackend));
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)
+        UA_calloc(1, sizeof(UA_CompressedStoreContext));
+    if(!ctx)
+        return result;
+    ctx->series = (UA_CompressedSeries*)
+        UA_calloc(initialNodeIdStoreSize, sizeof(UA_CompressedSeries));
+    ctx->cache = (UA_CompressedSample*)
+        UA_malloc(blockSize * sizeof(UA_CompressedSample));
+    if(!ctx->series || !ctx->cache) {
+        UA_CompressedStoreContext_delete(ctx);
+        return result;
+    }
+    ctx->seriesSize = initialNodeIdStoreSize;
+    ctx->blockSize = blockSize;
+    ctx->fd = -1;
+    result.serverSetHistoryData = &serverSetHistoryData_backend_memory_compressed;
+    result.resultSize = &resultSize_backend_memory_compressed;
+    result.getEnd = &getEnd_backend_memory_compressed;
+    result.lastIndex = &lastIndex_backend_memory_compressed;
+    result.firstIndex = &firstIndex_backend_memory_compressed;
+    result.getDateTimeMatch = &getDateTimeMatch_backend_memory_compressed;
+    result.copyDataValues = &copyDataValues_backend_memory_compressed;
+    result.getDataValue = &getDataValue_backend_memory_compressed;
+    result.boundSupported = &boundSupported_backend_memory_compressed;
+    result.timestampsToReturnSupported =
+        &timestampsToReturnSupported_backend_memory_compressed;
+    result.insertDataValue = &insertDataValue_backend_memory_compressed;
+    result.updateDataValue = &updateDataValue_backend_memory_compressed;
+    result.replaceDataValue = &replaceDataValue_backend_memory_compressed;
+    result.removeDataValue = &removeDataValue_backend_memory_compressed;
+    result.deleteMembers = &deleteMembers_backend_memory_compressed;
+    result.getHistoryData = NULL;
+    result.context = ctx;
+    return result;
+}
+
+void
+UA_HistoryDataBackend_Memory_Compressed_clear(UA_HistoryDataBackend *backend) {
+    if(backend->context)
+        UA_CompressedStoreContext_delete((UA_CompressedStoreContext*)backend->context);
+    memset(backend, 0, sizeof(UA_HistoryDataBackend));
+}
+
+#if defined(__linux__) || defined(__unix__)
+
+UA_HistoryDataBackend
+UA_HistoryDataBackend_Memory_Tiered(const char *path, size_t initialNodeIdStoreSize,
+                                    size_t blockSize, size_t memoryLimit) {
+    UA_HistoryDataBackend result =
+        UA_HistoryDataBackend_Memory_Compressed(initialNodeIdStoreSize, blockSize);
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)result.context;
+    if(!ctx || !path)
+        goto error;
+    size_t pathLen = strlen(path);
+    ctx->path = (char*)UA_malloc(pathLen + 1);
+    if(!ctx->path)
+        goto error;
+    memcpy(ctx->path, path, pathLen + 1);
+    ctx->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(ctx->fd < 0)
+        goto error;
+    ctx->memoryLimit = memoryLimit;
+    return result;
+
+ error:
+    UA_HistoryDataBackend_Memory_Compressed_clear(&result);
+    return result;
+}
+
+UA_StatusCode
+UA_HistoryDataBackend_Memory_Tiered_getStatistics(const UA_HistoryDataBackend *backend,
+                                                  UA_HistoryDataBackend_TieredStatistics *stats) {
+    const UA_CompressedStoreContext *ctx =
+        (const UA_CompressedStoreContext*)backend->context;
+    if(!ctx || ctx->fd < 0)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    stats->hits = ctx->hits;
+    stats->misses = ctx->misses;
+    stats->evictions = ctx->evictions;
+    stats->memoryBytes = ctx->memoryBytes;
+    stats->fileBytes = (size_t)ctx->fileEnd;
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif
+
+UA_StatusCode
+UA_HistoryDataBackend_Memory_Compressed_getUsage(const UA_HistoryDataBackend *backend,
+                                                 const UA_NodeId *nodeId,
+                                                 size_t *samples, size_t *bytes) {
+    UA_CompressedStoreContext *ctx = (UA_CompressedStoreContext*)backend->context;
+    if(!ctx)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    const UA_CompressedSeries *series = findSeries(ctx, nodeId);
+    if(!series)
+        return UA_STATUSCODE_BADNOTFOUND;
+    size_t used = series->blocksSize * sizeof(UA_CompressedBlock);
+    for(size_t i = 0; i < series->blocksSize; i++) {
+        const UA_CompressedBlock *block = &series->blocks[i];
+        if(block->data)
+            used += block->dataSize;
+        if(block->samples)
+            used += ctx->blockSize * sizeof(UA_CompressedSample);
+    }
+    if(samples)
+        *samples = series->count;
+    if(bytes)
+        *bytes = used;
+    return UA_STATUSCODE_GOOD;
+}
@@ -12,18 +12,368 @@
 
 #include <string.h>
 
+/* The asynchronous gathering uses a background writer thread if possible.
+ * Otherwise the queue is drained during the enqueueing. */
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+# define UA_GATHERING_WRITER_THREAD 1
+# include <time.h>
+#endif
+
+#define ASYNC_GATHERING_BATCH_SIZE 64
+
+typedef struct UA_GatheringRecord {
+    struct UA_GatheringRecord *next;
+    void (*setHistoryDataBatch)(UA_Server *server, void *hdbContext,
+                                size_t valuesSize, const UA_NodeId *nodeIds,
+                                const UA_DataValue *values, UA_StatusCode *results);
+    void *hdbContext;
+    UA_NodeId nodeId;
+    UA_DataValue value;
+} UA_GatheringRecord;
+
+/* Producers push records onto a lock-free stack. The single consumer takes the
+ * entire stack at once (so there is no ABA problem) and reverses it into the
+ * order of arrival. */
+typedef struct {
+    void * volatile head;
+    volatile uint32_t size;
+    volatile uint32_t dropped;
+    uint32_t capacity;
+    UA_UInt32 batchInterval;
+    UA_Server *server;
+
+    /* Only accessed by the consumer */
+#if UA_MULTITHREADING >= 100
+    UA_Lock drainLock;
+#endif
+    UA_DateTime lastDrain;
+    size_t written;
+    size_t failed;
+    size_t batches;
+    size_t maxBacklog;
+    UA_NodeId batchNodeIds[ASYNC_GATHERING_BATCH_SIZE];
+    UA_DataValue batchValues[ASYNC_GATHERING_BATCH_SIZE];
+    UA_StatusCode batchResults[ASYNC_GATHERING_BATCH_SIZE];
+
+#ifdef UA_GATHERING_WRITER_THREAD
+    pthread_t thread;
+    pthread_mutex_t sleepMutex;
+    pthread_cond_t sleepCond;
+    volatile UA_Boolean running;
+#endif
+} UA_GatheringQueue;
+
+/* State of the exception deadband and the swinging-door trending. The slopes
+ * of the door are in value units per millisecond since the stored value. */
+typedef struct {
+    UA_Boolean hasException;
+    UA_Double exceptionValue;
+    UA_Boolean hasStored;
+    UA_DateTime storedTime;
+    UA_Double storedValue;
+    UA_DateTime heldTime;
+    UA_DataValue held; /* hasValue is false if no value is held back */
+    UA_Double lowerSlope;
+    UA_Double upperSlope;
+} UA_GatheringCompression;
+
 typedef struct {
     UA_NodeId nodeId;
     UA_HistorizingNodeIdSettings setting;
     UA_MonitoredItemCreateResult monitoredResult;
+    UA_GatheringQueue *queue; /* NULL if the gathering is synchronous */
+    void *backendNodeContext; /* Cached by serverSetHistoryDataCached */
+    UA_GatheringCompression compression;
 } UA_NodeIdStoreContextItem_gathering_default;
 
 typedef struct {
     UA_NodeIdStoreContextItem_gathering_default *dataStore;
     size_t storeEnd;
     size_t storeSize;
+    UA_GatheringQueue *queue;
 } UA_NodeIdStoreContext;
 
+static void
+writeBatch(UA_GatheringQueue *q, UA_GatheringRecord *first, size_t batchSize) {
+    UA_GatheringRecord *rec = first;
+    for(size_t i = 0; i < batchSize; i++, rec = rec->next) {
+        q->batchNodeIds[i] = rec->nodeId;
+        q->batchValues[i] = rec->value;
+        q->batchResults[i] = UA_STATUSCODE_GOOD;
+    }
+    first->setHistoryDataBatch(q->server, first->hdbContext, batchSize,
+                               q->batchNodeIds, q->batchValues, q->batchResults);
+    for(size_t i = 0; i < batchSize; i++) {
+        if(q->batchResults[i] != UA_STATUSCODE_GOOD)
+            q->failed++;
+    }
+    q->written += batchSize;
+    q->batches++;
+}
+
+/* Write all queued values. Consecutive values for the same backend are written
+ * in one batch. */
+static void
+drainQueue(UA_GatheringQueue *q) {
+    UA_LOCK(&q->drainLock);
+    q->lastDrain = UA_DateTime_nowMonotonic();
+    UA_GatheringRecord *rec = (UA_GatheringRecord*)UA_atomic_xchg(&q->head, NULL);
+
+    /* Reverse */
+    UA_GatheringRecord *list = NULL;
+    size_t count = 0;
+    while(rec) {
+        UA_GatheringRecord *next = rec->next;
+        rec->next = list;
+        list = rec;
+        rec = next;
+        count++;
+    }
+    if(count == 0)
+        goto out;
+    UA_atomic_subUInt32(&q->size, (uint32_t)count);
+    if(count > q->maxBacklog)
+        q->maxBacklog = count;
+
+    while(list) {
+        size_t batchSize = 1;
+        UA_GatheringRecord *last = list;
+        while(last->next && batchSize < ASYNC_GATHERING_BATCH_SIZE &&
+              last->next->setHistoryDataBatch == list->setHistoryDataBatch &&
+              last->next->hdbContext == list->hdbContext) {
+            last = last->next;
+            batchSize++;
+        }
+        writeBatch(q, list, batchSize);
+        UA_GatheringRecord *next = last->next;
+        while(list != next) {
+            rec = list->next;
+            UA_NodeId_clear(&list->nodeId);
+            UA_DataValue_clear(&list->value);
+            UA_free(list);
+            list = rec;
+        }
+    }
+ out:
+    UA_UNLOCK(&q->drainLock);
+}
+
+static void
+enqueueValue(UA_Server *server, UA_GatheringQueue *q,
+             const UA_HistoryDataBackend *backend,
+             const UA_NodeId *nodeId, const UA_DataValue *value) {
+    /* Backpressure: Drop the value if the queue is full */
+    uint32_t size = UA_atomic_addUInt32(&q->size, 1);
+    if(size > q->capacity)
+        goto drop;
+
+    UA_GatheringRecord *rec = (UA_GatheringRecord*)UA_malloc(sizeof(UA_GatheringRecord));
+    if(!rec)
+        goto drop;
+    rec->setHistoryDataBatch = backend->setHistoryDataBatch;
+    rec->hdbContext = backend->context;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &rec->nodeId);
+    res |= UA_DataValue_copy(value, &rec->value);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&rec->nodeId);
+        UA_DataValue_clear(&rec->value);
+        UA_free(rec);
+        goto drop;
+    }
+    q->server = server;
+
+    void *old;
+    do {
+        old = q->head;
+        rec->next = (UA_GatheringRecord*)old;
+    } while(UA_atomic_cmpxchg(&q->head, old, rec) != old);
+
+#ifdef UA_GATHERING_WRITER_THREAD
+    /* Wake up the writer. A lost wakeup only delays until the timeout. */
+    if(size == ASYNC_GATHERING_BATCH_SIZE)
+        pthread_cond_signal(&q->sleepCond);
+#else
+    if(size >= ASYNC_GATHERING_BATCH_SIZE ||
+       UA_DateTime_nowMonotonic() - q->lastDrain >=
+       (UA_DateTime)q->batchInterval * UA_DATETIME_MSEC)
+        drainQueue(q);
+#endif
+    return;
+
+ drop:
+    UA_atomic_subUInt32(&q->size, 1);
+    UA_atomic_addUInt32(&q->dropped, 1);
+}
+
+static void
+writeValue(UA_Server *server,
+           UA_NodeIdStoreContextItem_gathering_default *item,
+           const UA_NodeId *sessionId,
+           void *sessionContext,
+           const UA_NodeId *nodeId,
+           UA_Boolean historizing,
+           const UA_DataValue *value) {
+    const UA_HistoryDataBackend *backend = &item->setting.historizingBackend;
+    if(item->queue && backend->setHistoryDataBatch) {
+        enqueueValue(server, item->queue, backend, nodeId, value);
+        return;
+    }
+    if(backend->serverSetHistoryDataCached) {
+        backend->serverSetHistoryDataCached(server, backend->context, sessionId,
+                                            sessionContext, nodeId,
+                                            &item->backendNodeContext,
+                                            historizing, value);
+        return;
+    }
+    backend->serverSetHistoryData(server, backend->context, sessionId,
+                                  sessionContext, nodeId, historizing, value);
+}
+
+static UA_Boolean
+numericValue(const UA_Variant *v, UA_Double *out) {
+    if(!UA_Variant_isScalar(v))
+        return false;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_SBYTE:   *out = *(UA_SByte*)v->data; break;
+    case UA_DATATYPEKIND_BYTE:    *out = *(UA_Byte*)v->data; break;
+    case UA_DATATYPEKIND_INT16:   *out = *(UA_Int16*)v->data; break;
+    case UA_DATATYPEKIND_UINT16:  *out = *(UA_UInt16*)v->data; break;
+    case UA_DATATYPEKIND_INT32:   *out = *(UA_Int32*)v->data; break;
+    case UA_DATATYPEKIND_UINT32:  *out = *(UA_UInt32*)v->data; break;
+    case UA_DATATYPEKIND_INT64:   *out = (UA_Double)*(UA_Int64*)v->data; break;
+    case UA_DATATYPEKIND_UINT64:  *out = (UA_Double)*(UA_UInt64*)v->data; break;
+    case UA_DATATYPEKIND_FLOAT:   *out = *(UA_Float*)v->data; break;
+    case UA_DATATYPEKIND_DOUBLE:  *out = *(UA_Double*)v->data; break;
+    default: return false;
+    }
+    return true;
+}
+
+static UA_DateTime
+valueTime(const UA_DataValue *value) {
+    if(value->hasSourceTimestamp)
+        return value->sourceTimestamp;
+    if(value->hasServerTimestamp)
+        return value->serverTimestamp;
+    return UA_DateTime_now();
+}
+
+/* Write the value that was held back by the swinging door. It becomes the
+ * starting point of the next door. */
+static void
+flushHeld(UA_Server *server, UA_NodeIdStoreContextItem_gathering_default *item) {
+    UA_GatheringCompression *c = &item->compression;
+    if(!c->held.hasValue)
+        return;
+    writeValue(server, item, NULL, NULL, &item->nodeId, true, &c->held);
+    c->hasStored = numericValue(&c->held.value, &c->storedValue);
+    c->storedTime = c->heldTime;
+    UA_DataValue_clear(&c->held);
+}
+
+static void
+resetCompression(UA_GatheringCompression *c) {
+    UA_DataValue_clear(&c->held);
+    memset(c, 0, sizeof(UA_GatheringCompression));
+}
+
+/* Open a new door from the stored value to the current value */
+static void
+openDoor(UA_GatheringCompression *c, UA_Double dev, UA_Double v, UA_Double dt) {
+    c->upperSlope = (v + dev - c->storedValue) / dt;
+    c->lowerSlope = (v - dev - c->storedValue) / dt;
+}
+
+static void
+storeValue(UA_Server *server,
+           UA_NodeIdStoreContextItem_gathering_default *item,
+           const UA_NodeId *sessionId,
+           void *sessionContext,
+           const UA_NodeId *nodeId,
+           UA_Boolean historizing,
+           const UA_DataValue *value) {
+    const UA_HistorizingCompression *settings = &item->setting.compression;
+    UA_GatheringCompression *c = &item->compression;
+    if(settings->exceptionDeviation <= 0.0 && settings->compressionDeviation <= 0.0) {
+        writeValue(server, item, sessionId, sessionContext, nodeId, historizing, value);
+        return;
+    }
+
+    /* Values that cannot be compressed are always stored */
+    UA_Double v;
+    UA_DateTime t = valueTime(value);
+    if(!value->hasValue || (value->hasStatus && !UA_StatusCode_isGood(value->status)) ||
+       !numericValue(&value->value, &v)) {
+        flushHeld(server, item);
+        resetCompression(c);
+        writeValue(server, item, sessionId, sessionContext, nodeId, historizing, value);
+        return;
+    }
+
+    /* Out-of-order values restart the compression */
+    if(c->hasStored && (t <= c->storedTime || (c->held.hasValue && t <= c->heldTime))) {
+        flushHeld(server, item);
+        resetCompression(c);
+    }
+
+    UA_Double dt = (UA_Double)(t - c->storedTime) / (UA_Double)UA_DATETIME_MSEC;
+    UA_Boolean expired = (c->hasStored && settings->compressionMaxInterval > 0.0 &&
+                          dt > settings->compressionMaxInterval);
+
+    /* Exception deadband */
+    if(settings->exceptionDeviation > 0.0 && c->hasException && !expired) {
+        UA_Double diff = (v > c->exceptionValue) ?
+            v - c->exceptionValue : c->exceptionValue - v;
+        if(diff <= settings->exceptionDeviation)
+            return;
+    }
+    c->hasException = true;
+    c->exceptionValue = v;
+
+    /* Swinging door disabled or first value */
+    UA_Double dev = settings->compressionDeviation;
+    if(dev <= 0.0 || !c->hasStored) {
+        flushHeld(server, item);
+        writeValue(server, item, sessionId, sessionContext, nodeId, historizing, value);
+        c->hasStored = true;
+        c->storedValue = v;
+        c->storedTime = t;
+        return;
+    }
+
+    if(c->held.hasValue) {
+        /* The line from the stored value to the current value leaves the
+         * door. Store the held value and open a new door from there. */
+        UA_Double slope = (v - c->storedValue) / dt;
+        if(expired || slope > c->upperSlope || slope < c->lowerSlope) {
+            flushHeld(server, item);
+            dt = (UA_Double)(t - c->storedTime) / (UA_Double)UA_DATETIME_MSEC;
+            openDoor(c, dev, v, dt);
+        } else {
+            /* Narrow the door */
+            UA_Double upper = (v + dev - c->storedValue) / dt;
+            UA_Double lower = (v - dev - c->storedValue) / dt;
+            if(upper < c->upperSlope)
+                c->upperSlope = upper;
+            if(lower > c->lowerSlope)
+                c->lowerSlope = lower;
+        }
+        UA_DataValue_clear(&c->held);
+    } else {
+        openDoor(c, dev, v, dt);
+    }
+
+    /* Hold back the current value */
+    if(UA_DataValue_copy(value, &c->held) != UA_STATUSCODE_GOOD) {
+        /* Store directly if the value cannot be held */
+        writeValue(server, item, sessionId, sessionContext, nodeId, historizing, value);
+        c->storedValue = v;
+        c->storedTime = t;
+        return;
+    }
+    c->heldTime = t;
+}
+
 static void
 dataChangeCallback_gathering_default(UA_Server *server,
                                      UA_UInt32 monitoredItemId,
@@ -34,13 +384,7 @@ dataChangeCallback_gathering_default(UA_Server *server,
                                      const UA_DataValue *value)
 {
     UA_NodeIdStoreContextItem_gathering_default *context = (UA_NodeIdStoreContextItem_gathering_default*)monitoredItemContext;
-    context->setting.historizingBackend.serverSetHistoryData(server,
-                                                             context->setting.historizingBackend.context,
-                                                             NULL,
-                                                             NULL,
-                                                             nodeId,
-                                                             UA_TRUE,
-                                                             value);
+    storeValue(server, context, NULL, NULL, nodeId, UA_TRUE, value);
 }
 
 static UA_NodeIdStoreContextItem_gathering_default*
@@ -74,6 +418,7 @@ startPoll(UA_Server *server, UA_NodeIdStoreContextItem_gathering_default *item)
 static UA_StatusCode
 stopPoll(UA_Server *server, UA_NodeIdStoreContextItem_gathering_default *item)
 {
+    flushHeld(server, item);
     UA_StatusCode retval = UA_Server_deleteMonitoredItem(server, item->monitoredResult.monitoredItemId);
     UA_MonitoredItemCreateResult_init(&item->monitoredResult);
     return retval;
@@ -136,6 +481,8 @@ registerNodeId_gathering_default(UA_Server *server,
     UA_NodeId_copy(nodeId, &ctx->dataStore[ctx->storeEnd].nodeId);
     size_t current = ctx->storeEnd;
     ctx->dataStore[current].setting = setting;
+    ctx->dataStore[current].queue = ctx->queue;
+    ctx->dataStore[current].backendNodeContext = NULL;
     ++ctx->storeEnd;
     return UA_STATUSCODE_GOOD;
 }
@@ -161,6 +508,7 @@ deleteMembers_gathering_default(UA_HistoryDataGathering *gathering)
     UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering->context;
     for (size_t i = 0; i < ctx->storeEnd; ++i) {
         UA_NodeId_clear(&ctx->dataStore[i].nodeId);
+        UA_DataValue_clear(&ctx->dataStore[i].compression.held);
         // There is still a monitored item present for this gathering
         // You need to remove it with UA_Server_deleteMonitoredItem
         UA_assert(ctx->dataStore[i].monitoredResult.monitoredItemId == 0);
@@ -181,7 +529,13 @@ updateNodeIdSetting_gathering_default(UA_Server *server,
         return false;
     }
     stopPoll_gathering_default(server, context, nodeId);
+    flushHeld(server, item);
+    resetCompression(&item->compression);
+    /* Write the values queued for the previous backend */
+    if(item->queue)
+        drainQueue(item->queue);
     item->setting = setting;
+    item->backendNodeContext = NULL;
     return true;
 }
 
@@ -200,13 +554,7 @@ setValue_gathering_default(UA_Server *server,
         return;
     }
     if (item->setting.historizingUpdateStrategy == UA_HISTORIZINGUPDATESTRATEGY_VALUESET) {
-        item->setting.historizingBackend.serverSetHistoryData(server,
-                                                              item->setting.historizingBackend.context,
-                                                              sessionId,
-                                                              sessionContext,
-                                                              nodeId,
-                                                              historizing,
-                                                              value);
+        storeValue(server, item, sessionId, sessionContext, nodeId, historizing, value);
     }
 }
 
@@ -246,6 +594,8 @@ registerNodeId_gathering_circular(UA_Server *server, void *context,
     UA_NodeId_copy(nodeId, &ctx->dataStore[ctx->storeEnd].nodeId);
     size_t current = ctx->storeEnd;
     ctx->dataStore[current].setting = setting;
+    ctx->dataStore[current].queue = ctx->queue;
+    ctx->dataStore[current].backendNodeContext = NULL;
     ++ctx->storeEnd;
     return UA_STATUSCODE_GOOD;
 }
@@ -256,3 +606,117 @@ UA_HistoryDataGathering_Circular(size_t initialNodeIdStoreSize) {
     gathering.registerNodeId = &registerNodeId_gathering_circular;
     return gathering;
 }
+
+/* Asynchronous implementation */
+
+#ifdef UA_GATHERING_WRITER_THREAD
+static void *
+writerThread(void *p) {
+    UA_GatheringQueue *q = (UA_GatheringQueue*)p;
+    while(q->running) {
+        pthread_mutex_lock(&q->sleepMutex);
+        if(q->running && q->size < ASYNC_GATHERING_BATCH_SIZE) {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += (time_t)(q->batchInterval / 1000);
+            ts.tv_nsec += (long)(q->batchInterval % 1000) * 1000000L;
+            if(ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&q->sleepCond, &q->sleepMutex, &ts);
+        }
+        pthread_mutex_unlock(&q->sleepMutex);
+        drainQueue(q);
+    }
+    return NULL;
+}
+#endif
+
+static void
+deleteMembers_gathering_async(UA_HistoryDataGathering *gathering) {
+    if(gathering == NULL || gathering->context == NULL)
+        return;
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering->context;
+    UA_GatheringQueue *q = ctx->queue;
+    if(q) {
+#ifdef UA_GATHERING_WRITER_THREAD
+        if(q->running) {
+            pthread_mutex_lock(&q->sleepMutex);
+            q->running = false;
+            pthread_cond_signal(&q->sleepCond);
+            pthread_mutex_unlock(&q->sleepMutex);
+            pthread_join(q->thread, NULL);
+        }
+        pthread_cond_destroy(&q->sleepCond);
+        pthread_mutex_destroy(&q->sleepMutex);
+#endif
+        drainQueue(q);
+        UA_LOCK_DESTROY(&q->drainLock);
+        UA_free(q);
+    }
+    deleteMembers_gathering_default(gathering);
+}
+
+UA_HistoryDataGathering
+UA_HistoryDataGathering_Async(size_t initialNodeIdStoreSize, size_t queueSize,
+                              UA_UInt32 batchInterval) {
+    UA_HistoryDataGathering gathering =
+        UA_HistoryDataGathering_Default(initialNodeIdStoreSize);
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering.context;
+    if(!ctx)
+        return gathering;
+    UA_GatheringQueue *q = (UA_GatheringQueue*)UA_calloc(1, sizeof(UA_GatheringQueue));
+    if(!q)
+        return gathering; /* Fall back to the synchronous gathering */
+    if(queueSize == 0)
+        queueSize = ASYNC_GATHERING_QUEUE_SIZE;
+    q->capacity = (queueSize > UA_UINT32_MAX / 2) ?
+        UA_UINT32_MAX / 2 : (uint32_t)queueSize;
+    q->batchInterval = (batchInterval > 0) ? batchInterval : ASYNC_GATHERING_BATCH_INTERVAL;
+    q->lastDrain = UA_DateTime_nowMonotonic();
+    UA_LOCK_INIT(&q->drainLock);
+#ifdef UA_GATHERING_WRITER_THREAD
+    pthread_mutex_init(&q->sleepMutex, NULL);
+    pthread_cond_init(&q->sleepCond, NULL);
+    q->running = true;
+    if(pthread_create(&q->thread, NULL, writerThread, q) != 0) {
+        q->running = false;
+        pthread_cond_destroy(&q->sleepCond);
+        pthread_mutex_destroy(&q->sleepMutex);
+        UA_LOCK_DESTROY(&q->drainLock);
+        UA_free(q);
+        return gathering;
+    }
+#endif
+    ctx->queue = q;
+    gathering.deleteMembers = &deleteMembers_gathering_async;
+    return gathering;
+}
+
+UA_StatusCode
+UA_HistoryDataGathering_Async_flush(UA_HistoryDataGathering *gathering) {
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering->context;
+    if(!ctx || !ctx->queue)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    drainQueue(ctx->queue);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_HistoryDataGathering_Async_getStatistics(UA_HistoryDataGathering *gathering,
+                                            UA_HistoryDataGatheringStatistics *stats) {
+    UA_NodeIdStoreContext *ctx = (UA_NodeIdStoreContext*)gathering->context;
+    if(!ctx || !ctx->queue)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_GatheringQueue *q = ctx->queue;
+    UA_LOCK(&q->drainLock);
+    stats->queued = q->size;
+    stats->dropped = q->dropped;
+    stats->written = q->written;
+    stats->failed = q->failed;
+    stats->batches = q->batches;
+    stats->maxBacklog = q->maxBacklog;
+    UA_UNLOCK(&q->drainLock);
+    return UA_STATUSCODE_GOOD;
+}
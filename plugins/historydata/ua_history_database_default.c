@@ -12,6 +12,10 @@
 
 typedef struct {
     UA_HistoryDataGathering gathering;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    UA_HistoryEventBackend eventBackend;
+    size_t maxHistoryEventResponseSize;
+#endif
 } UA_HistoryDatabaseContext_default;
 
 static size_t
@@ -294,6 +298,61 @@ getHistoryData_service_default(const UA_HistoryDataBackend* backend,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Insert the values allowed by the access control with one call to the
+ * backend */
+static void
+insertDataValues_service_default(UA_Server *server,
+                                 const UA_HistorizingNodeIdSettings *setting,
+                                 const UA_NodeId *sessionId,
+                                 void *sessionContext,
+                                 const UA_UpdateDataDetails *details,
+                                 UA_HistoryUpdateResult *result)
+{
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_DataValue *values = (UA_DataValue*)UA_malloc(details->updateValuesSize * sizeof(UA_DataValue));
+    size_t *positions = (size_t*)UA_malloc(details->updateValuesSize * sizeof(size_t));
+    UA_StatusCode *results = (UA_StatusCode*)UA_malloc(details->updateValuesSize * sizeof(UA_StatusCode));
+    if (!values || !positions || !results) {
+        for (size_t i = 0; i < details->updateValuesSize; ++i)
+            result->operationResults[i] = UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_free(values);
+        UA_free(positions);
+        UA_free(results);
+        return;
+    }
+
+    /* Shallow copies of the allowed values */
+    size_t valuesSize = 0;
+    for (size_t i = 0; i < details->updateValuesSize; ++i) {
+        if (config->accessControl.allowHistoryUpdateUpdateData &&
+            !config->accessControl.allowHistoryUpdateUpdateData(server, &config->accessControl, sessionId, sessionContext,
+                                                                &details->nodeId, details->performInsertReplace,
+                                                                &details->updateValues[i])) {
+            result->operationResults[i] = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+        values[valuesSize] = details->updateValues[i];
+        positions[valuesSize] = i;
+        ++valuesSize;
+    }
+
+    if (valuesSize > 0)
+        setting->historizingBackend.insertDataValues(server,
+                                                     setting->historizingBackend.context,
+                                                     sessionId,
+                                                     sessionContext,
+                                                     &details->nodeId,
+                                                     valuesSize,
+                                                     values,
+                                                     results);
+    for (size_t i = 0; i < valuesSize; ++i)
+        result->operationResults[positions[i]] = results[i];
+
+    UA_free(values);
+    UA_free(positions);
+    UA_free(results);
+}
+
 static void
 updateData_service_default(UA_Server *server,
                            void *hdbContext,
@@ -334,6 +393,21 @@ updateData_service_default(UA_Server *server,
     UA_ServerConfig *config = UA_Server_getConfig(server);
     result->operationResultsSize = details->updateValuesSize;
     result->operationResults = (UA_StatusCode*)UA_Array_new(result->operationResultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    if (!result->operationResults) {
+        result->operationResultsSize = 0;
+        result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+
+    /* Insert many values at once */
+    if (details->performInsertReplace == UA_PERFORMUPDATETYPE_INSERT &&
+        details->updateValuesSize > 1 &&
+        setting->historizingBackend.insertDataValues) {
+        insertDataValues_service_default(server, setting, sessionId, sessionContext,
+                                         details, result);
+        return;
+    }
+
     for (size_t i = 0; i < details->updateValuesSize; ++i) {
         if (config->accessControl.allowHistoryUpdateUpdateData &&
             !config->accessControl.allowHistoryUpdateUpdateData(server, &config->accessControl, sessionId, sessionContext,
@@ -578,6 +652,987 @@ readRaw_service_default(UA_Server *server,
     return;
 }
 
+/* Processed history (aggregates)
+ * ------------------------------
+ * The aggregates are computed in a single forward pass over the raw values.
+ * The values are copied from the backend in chunks and converted to arrays of
+ * doubles. The sums and extrema of the values in an interval are reduced over
+ * these arrays with independent accumulators, which lets the compiler
+ * vectorize the loops. Times are relative to the start of the request. */
+
+#define AGGREGATE_CHUNK_SIZE 1024
+
+typedef enum {
+    UA_AGGREGATE_INTERPOLATIVE,
+    UA_AGGREGATE_AVERAGE,
+    UA_AGGREGATE_TIMEAVERAGE,
+    UA_AGGREGATE_MINIMUM,
+    UA_AGGREGATE_MAXIMUM,
+    UA_AGGREGATE_COUNT
+} UA_Aggregate;
+
+static UA_StatusCode
+getAggregate(const UA_NodeId *aggregateType, UA_Aggregate *aggregate) {
+    if(aggregateType->namespaceIndex != 0 ||
+       aggregateType->identifierType != UA_NODEIDTYPE_NUMERIC)
+        return UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+    switch(aggregateType->identifier.numeric) {
+    case UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE:
+        *aggregate = UA_AGGREGATE_INTERPOLATIVE; break;
+    case UA_NS0ID_AGGREGATEFUNCTION_AVERAGE:
+        *aggregate = UA_AGGREGATE_AVERAGE; break;
+    case UA_NS0ID_AGGREGATEFUNCTION_TIMEAVERAGE:
+        *aggregate = UA_AGGREGATE_TIMEAVERAGE; break;
+    case UA_NS0ID_AGGREGATEFUNCTION_MINIMUM:
+        *aggregate = UA_AGGREGATE_MINIMUM; break;
+    case UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM:
+        *aggregate = UA_AGGREGATE_MAXIMUM; break;
+    case UA_NS0ID_AGGREGATEFUNCTION_COUNT:
+        *aggregate = UA_AGGREGATE_COUNT; break;
+    default:
+        return UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+numericValue(const UA_Variant *v, UA_Double *out) {
+    if(!UA_Variant_isScalar(v))
+        return false;
+    switch(v->type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN: *out = *(UA_Boolean*)v->data ? 1.0 : 0.0; break;
+    case UA_DATATYPEKIND_SBYTE:   *out = *(UA_SByte*)v->data; break;
+    case UA_DATATYPEKIND_BYTE:    *out = *(UA_Byte*)v->data; break;
+    case UA_DATATYPEKIND_INT16:   *out = *(UA_Int16*)v->data; break;
+    case UA_DATATYPEKIND_UINT16:  *out = *(UA_UInt16*)v->data; break;
+    case UA_DATATYPEKIND_INT32:   *out = *(UA_Int32*)v->data; break;
+    case UA_DATATYPEKIND_UINT32:  *out = *(UA_UInt32*)v->data; break;
+    case UA_DATATYPEKIND_INT64:   *out = (UA_Double)*(UA_Int64*)v->data; break;
+    case UA_DATATYPEKIND_UINT64:  *out = (UA_Double)*(UA_UInt64*)v->data; break;
+    case UA_DATATYPEKIND_FLOAT:   *out = *(UA_Float*)v->data; break;
+    case UA_DATATYPEKIND_DOUBLE:  *out = *(UA_Double*)v->data; break;
+    default: return false;
+    }
+    return true;
+}
+
+static UA_Double
+sumDoubles(const UA_Double *v, size_t n) {
+    UA_Double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        s0 += v[i]; s1 += v[i+1];
+        s2 += v[i+2]; s3 += v[i+3];
+    }
+    for(; i < n; i++)
+        s0 += v[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/* Twice the integral of the polyline through the points */
+static UA_Double
+trapezoidDoubles(const UA_Double *t, const UA_Double *v, size_t n) {
+    UA_Double s0 = 0.0, s1 = 0.0;
+    size_t i = 1;
+    for(; i + 2 <= n; i += 2) {
+        s0 += (t[i] - t[i-1]) * (v[i] + v[i-1]);
+        s1 += (t[i+1] - t[i]) * (v[i+1] + v[i]);
+    }
+    for(; i < n; i++)
+        s0 += (t[i] - t[i-1]) * (v[i] + v[i-1]);
+    return s0 + s1;
+}
+
+/* Index of the first minimum (or maximum) */
+static size_t
+extremumDoubles(const UA_Double *v, size_t n, UA_Boolean max) {
+    UA_Double m0 = v[0], m1 = v[0], m2 = v[0], m3 = v[0];
+    size_t i = 0;
+    if(max) {
+        for(; i + 4 <= n; i += 4) {
+            m0 = (v[i] > m0) ? v[i] : m0;
+            m1 = (v[i+1] > m1) ? v[i+1] : m1;
+            m2 = (v[i+2] > m2) ? v[i+2] : m2;
+            m3 = (v[i+3] > m3) ? v[i+3] : m3;
+        }
+        for(; i < n; i++)
+            m0 = (v[i] > m0) ? v[i] : m0;
+        m0 = (m1 > m0) ? m1 : m0;
+        m2 = (m3 > m2) ? m3 : m2;
+        m0 = (m2 > m0) ? m2 : m0;
+    } else {
+        for(; i + 4 <= n; i += 4) {
+            m0 = (v[i] < m0) ? v[i] : m0;
+            m1 = (v[i+1] < m1) ? v[i+1] : m1;
+            m2 = (v[i+2] < m2) ? v[i+2] : m2;
+            m3 = (v[i+3] < m3) ? v[i+3] : m3;
+        }
+        for(; i < n; i++)
+            m0 = (v[i] < m0) ? v[i] : m0;
+        m0 = (m1 < m0) ? m1 : m0;
+        m2 = (m3 < m2) ? m3 : m2;
+        m0 = (m2 < m0) ? m2 : m0;
+    }
+    for(i = 0; i < n; i++) {
+        if(v[i] == m0)
+            break;
+    }
+    return i;
+}
+
+static UA_Double
+interpolate(UA_Double t0, UA_Double v0, UA_Double t1, UA_Double v1, UA_Double t) {
+    if(t1 <= t0)
+        return v1;
+    return v0 + (v1 - v0) * (t - t0) / (t1 - t0);
+}
+
+typedef struct {
+    size_t count;
+    UA_Double sum;
+    UA_Double area; /* Twice the integral from the first to the last point */
+    UA_Double min, max;
+    UA_DateTime minTime, maxTime;
+    UA_Double firstT, firstV;
+    UA_Double lastT, lastV;
+} UA_AggregateInterval;
+
+typedef struct {
+    UA_Aggregate aggregate;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_DateTime start;    /* Of the request */
+    UA_DateTime end;      /* Of the request */
+    UA_DateTime interval; /* Length of the intervals */
+    size_t index;         /* Current interval */
+    size_t firstIndex;    /* First interval of the response */
+    size_t endIndex;      /* First interval after the response */
+    UA_DataValue *results;
+
+    UA_Boolean haveBefore; /* Last good value before the current interval */
+    UA_Double beforeT, beforeV;
+    UA_AggregateInterval acc;
+
+    /* Chunk of good values */
+    UA_Double t[AGGREGATE_CHUNK_SIZE];
+    UA_Double v[AGGREGATE_CHUNK_SIZE];
+    UA_DateTime ts[AGGREGATE_CHUNK_SIZE];
+} UA_AggregateState;
+
+static UA_DateTime
+intervalStart(const UA_AggregateState *st, size_t index) {
+    return st->start + (UA_DateTime)index * st->interval;
+}
+
+static UA_DateTime
+intervalEnd(const UA_AggregateState *st, size_t index) {
+    UA_DateTime e = intervalStart(st, index) + st->interval;
+    return (e < st->end) ? e : st->end;
+}
+
+static void
+addPoints(UA_AggregateInterval *a, const UA_Double *t, const UA_Double *v,
+          const UA_DateTime *ts, size_t n) {
+    if(a->count > 0) {
+        a->area += (t[0] - a->lastT) * (v[0] + a->lastV);
+    } else {
+        a->firstT = t[0];
+        a->firstV = v[0];
+    }
+    a->area += trapezoidDoubles(t, v, n);
+    a->sum += sumDoubles(v, n);
+    size_t i = extremumDoubles(v, n, false);
+    if(a->count == 0 || v[i] < a->min) {
+        a->min = v[i];
+        a->minTime = ts[i];
+    }
+    i = extremumDoubles(v, n, true);
+    if(a->count == 0 || v[i] > a->max) {
+        a->max = v[i];
+        a->maxTime = ts[i];
+    }
+    a->lastT = t[n-1];
+    a->lastV = v[n-1];
+    a->count += n;
+}
+
+/* The value at the interval start. Returns false if it is unknown. */
+static UA_Boolean
+startValue(const UA_AggregateState *st, UA_Double s, UA_Boolean hasNext,
+           UA_Double nextT, UA_Double nextV, UA_Double *value,
+           UA_StatusCode *status) {
+    const UA_AggregateInterval *a = &st->acc;
+    if(a->count > 0 && a->firstT == s) {
+        *value = a->firstV;
+        return true;
+    }
+    if(!st->haveBefore)
+        return false;
+    if(a->count > 0) {
+        *value = interpolate(st->beforeT, st->beforeV, a->firstT, a->firstV, s);
+    } else if(hasNext) {
+        *value = interpolate(st->beforeT, st->beforeV, nextT, nextV, s);
+    } else {
+        /* Stepped extrapolation */
+        *value = st->beforeV;
+        *status = UA_STATUSCODE_UNCERTAINDATASUBNORMAL;
+    }
+    return true;
+}
+
+static void
+finishInterval(UA_AggregateState *st, UA_Boolean hasNext,
+               UA_Double nextT, UA_Double nextV) {
+    UA_DataValue *dv = &st->results[st->index - st->firstIndex];
+    UA_AggregateInterval *a = &st->acc;
+    UA_DateTime timestamp = intervalStart(st, st->index);
+    UA_Double s = (UA_Double)(timestamp - st->start);
+    UA_Double e = (UA_Double)(intervalEnd(st, st->index) - st->start);
+    UA_StatusCode status = UA_STATUSCODE_GOOD;
+    UA_Double result = 0.0;
+
+    switch(st->aggregate) {
+    case UA_AGGREGATE_COUNT: {
+        UA_Int32 count = (UA_Int32)a->count;
+        UA_Variant_setScalarCopy(&dv->value, &count, &UA_TYPES[UA_TYPES_INT32]);
+        break;
+    }
+    case UA_AGGREGATE_AVERAGE:
+        if(a->count == 0)
+            status = UA_STATUSCODE_BADNODATA;
+        else
+            result = a->sum / (UA_Double)a->count;
+        break;
+    case UA_AGGREGATE_MINIMUM:
+        if(a->count == 0) {
+            status = UA_STATUSCODE_BADNODATA;
+        } else {
+            result = a->min;
+            timestamp = a->minTime;
+        }
+        break;
+    case UA_AGGREGATE_MAXIMUM:
+        if(a->count == 0) {
+            status = UA_STATUSCODE_BADNODATA;
+        } else {
+            result = a->max;
+            timestamp = a->maxTime;
+        }
+        break;
+    case UA_AGGREGATE_INTERPOLATIVE:
+        if(!startValue(st, s, hasNext, nextT, nextV, &result, &status))
+            status = UA_STATUSCODE_BADNODATA;
+        break;
+    case UA_AGGREGATE_TIMEAVERAGE: {
+        UA_Double vs = 0.0;
+        UA_Boolean known = startValue(st, s, hasNext, nextT, nextV, &vs, &status);
+        if(a->count == 0) {
+            if(!known) {
+                status = UA_STATUSCODE_BADNODATA;
+                break;
+            }
+            UA_Double ve = vs;
+            if(hasNext)
+                ve = interpolate(st->beforeT, st->beforeV, nextT, nextV, e);
+            else
+                status = UA_STATUSCODE_UNCERTAINDATASUBNORMAL;
+            result = (vs + ve) / 2.0;
+            break;
+        }
+        UA_Double area = a->area;
+        UA_Double from = s;
+        if(known) {
+            area += (a->firstT - s) * (a->firstV + vs);
+        } else {
+            /* The interval is only partially covered */
+            from = a->firstT;
+            status = UA_STATUSCODE_UNCERTAINDATASUBNORMAL;
+        }
+        UA_Double ve = a->lastV;
+        if(hasNext)
+            ve = interpolate(a->lastT, a->lastV, nextT, nextV, e);
+        else
+            status = UA_STATUSCODE_UNCERTAINDATASUBNORMAL;
+        area += (e - a->lastT) * (a->lastV + ve);
+        result = (e > from) ? area / (2.0 * (e - from)) : a->firstV;
+        break;
+    }
+    default:
+        break;
+    }
+
+    if(st->aggregate != UA_AGGREGATE_COUNT && status < UA_STATUSCODE_BAD)
+        UA_Variant_setScalarCopy(&dv->value, &result, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv->hasValue = (status < UA_STATUSCODE_BAD);
+    dv->status = status;
+    dv->hasStatus = true;
+    if(st->timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE ||
+       st->timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH) {
+        dv->sourceTimestamp = timestamp;
+        dv->hasSourceTimestamp = true;
+    }
+    if(st->timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER ||
+       st->timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH) {
+        dv->serverTimestamp = timestamp;
+        dv->hasServerTimestamp = true;
+    }
+
+    /* Continue with the next interval */
+    if(a->count > 0) {
+        st->haveBefore = true;
+        st->beforeT = a->lastT;
+        st->beforeV = a->lastV;
+    }
+    memset(a, 0, sizeof(UA_AggregateInterval));
+    st->index++;
+}
+
+/* Feed the next n good values (sorted by time) */
+static void
+processPoints(UA_AggregateState *st, size_t n) {
+    size_t i = 0;
+    while(i < n && st->index < st->endIndex) {
+        UA_Double s = (UA_Double)(intervalStart(st, st->index) - st->start);
+        UA_Double e = (UA_Double)(intervalEnd(st, st->index) - st->start);
+        size_t j = i;
+        if(st->t[i] < s) {
+            /* Before the first interval of the response */
+            while(j < n && st->t[j] < s)
+                j++;
+            st->haveBefore = true;
+            st->beforeT = st->t[j-1];
+            st->beforeV = st->v[j-1];
+            i = j;
+            continue;
+        }
+        while(j < n && st->t[j] < e)
+            j++;
+        if(j > i)
+            addPoints(&st->acc, &st->t[i], &st->v[i], &st->ts[i], j - i);
+        i = j;
+        if(i < n)
+            finishInterval(st, true, st->t[i], st->v[i]);
+    }
+}
+
+static UA_StatusCode
+getProcessedData_service_default(const UA_HistoryDataBackend *backend,
+                                 const UA_ReadProcessedDetails *details,
+                                 UA_Aggregate aggregate,
+                                 UA_Server *server,
+                                 const UA_NodeId *sessionId,
+                                 void *sessionContext,
+                                 const UA_NodeId *nodeId,
+                                 size_t maxSize,
+                                 UA_TimestampsToReturn timestampsToReturn,
+                                 UA_Boolean releaseContinuationPoints,
+                                 const UA_ByteString *continuationPoint,
+                                 UA_ByteString *outContinuationPoint,
+                                 size_t *resultSize,
+                                 UA_DataValue **result)
+{
+    if (details->startTime >= details->endTime)
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (releaseContinuationPoints)
+        return UA_STATUSCODE_GOOD;
+
+    /* Zero is one interval for the entire time range */
+    UA_DateTime duration = details->endTime - details->startTime;
+    UA_DateTime interval = duration;
+    if (details->processingInterval > 0.0 &&
+        details->processingInterval * UA_DATETIME_MSEC < (UA_Double)duration)
+        interval = (UA_DateTime)(details->processingInterval * UA_DATETIME_MSEC);
+    if (interval <= 0)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    size_t intervals = (size_t)((duration + interval - 1) / interval);
+
+    size_t skip = 0;
+    if (continuationPoint->length > 0) {
+        if (continuationPoint->length != sizeof(size_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        skip = *((size_t*)(continuationPoint->data));
+        if (skip >= intervals)
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+    }
+
+    size_t count = intervals - skip;
+    if (maxSize > 0 && count > maxSize)
+        count = maxSize;
+
+    UA_AggregateState *st = (UA_AggregateState*)UA_calloc(1, sizeof(UA_AggregateState));
+    if (!st)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DataValue *values = (UA_DataValue*)UA_malloc(AGGREGATE_CHUNK_SIZE * sizeof(UA_DataValue));
+    st->results = (UA_DataValue*)UA_Array_new(count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if (!values || !st->results) {
+        UA_free(values);
+        UA_free(st->results);
+        UA_free(st);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    st->aggregate = aggregate;
+    st->timestampsToReturn = timestampsToReturn;
+    st->start = details->startTime;
+    st->end = details->endTime;
+    st->interval = interval;
+    st->index = skip;
+    st->firstIndex = skip;
+    st->endIndex = skip + count;
+
+    /* Include the values before and after the processed intervals for the
+     * interpolation */
+    UA_Boolean treatUncertainAsBad = details->aggregateConfiguration.useServerCapabilitiesDefaults ||
+        details->aggregateConfiguration.treatUncertainAsBad;
+    UA_DateTime from = intervalStart(st, st->firstIndex);
+    UA_DateTime to = intervalEnd(st, st->endIndex - 1);
+    size_t storeEnd = backend->getEnd(server, backend->context, sessionId, sessionContext, nodeId);
+    size_t index = backend->getDateTimeMatch(server, backend->context, sessionId, sessionContext,
+                                             nodeId, from, MATCH_BEFORE);
+    if (index == storeEnd)
+        index = backend->getDateTimeMatch(server, backend->context, sessionId, sessionContext,
+                                          nodeId, from, MATCH_EQUAL_OR_AFTER);
+    size_t last = backend->getDateTimeMatch(server, backend->context, sessionId, sessionContext,
+                                            nodeId, to, MATCH_EQUAL_OR_AFTER);
+    if (last == storeEnd)
+        last = backend->lastIndex(server, backend->context, sessionId, sessionContext, nodeId);
+
+    UA_StatusCode ret = UA_STATUSCODE_GOOD;
+    UA_NumericRange range = {0, NULL};
+    UA_ByteString noContinuationPoint = UA_BYTESTRING_NULL;
+    while (index != storeEnd && index <= last && st->index < st->endIndex) {
+        size_t chunk = last - index + 1;
+        if (chunk > AGGREGATE_CHUNK_SIZE)
+            chunk = AGGREGATE_CHUNK_SIZE;
+        size_t provided = 0;
+        UA_ByteString backendContinuationPoint = UA_BYTESTRING_NULL;
+        memset(values, 0, chunk * sizeof(UA_DataValue));
+        ret = backend->copyDataValues(server, backend->context, sessionId, sessionContext,
+                                      nodeId, index, last, false, chunk, range, false,
+                                      &noContinuationPoint, &backendContinuationPoint,
+                                      &provided, values);
+        UA_ByteString_clear(&backendContinuationPoint);
+        if (ret != UA_STATUSCODE_GOOD || provided == 0)
+            break;
+
+        /* Keep the good numeric values */
+        size_t n = 0;
+        for (size_t i = 0; i < provided; ++i) {
+            const UA_DataValue *dv = &values[i];
+            UA_StatusCode status = dv->hasStatus ? dv->status : UA_STATUSCODE_GOOD;
+            UA_Boolean usable = (status < UA_STATUSCODE_UNCERTAIN) ||
+                (status < UA_STATUSCODE_BAD && !treatUncertainAsBad);
+            if (usable && dv->hasValue && numericValue(&dv->value, &st->v[n])) {
+                st->ts[n] = dv->hasSourceTimestamp ? dv->sourceTimestamp : dv->serverTimestamp;
+                st->t[n] = (UA_Double)(st->ts[n] - st->start);
+                ++n;
+            }
+        }
+        UA_Array_delete(values, provided, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        values = (UA_DataValue*)UA_malloc(AGGREGATE_CHUNK_SIZE * sizeof(UA_DataValue));
+        if (!values) {
+            ret = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        processPoints(st, n);
+        index += provided;
+    }
+    UA_free(values);
+
+    if (ret != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(st->results, count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        UA_free(st);
+        return ret;
+    }
+
+    /* No more values */
+    while (st->index < st->endIndex)
+        finishInterval(st, false, 0.0, 0.0);
+
+    if (st->endIndex < intervals) {
+        ret = UA_ByteString_allocBuffer(outContinuationPoint, sizeof(size_t));
+        if (ret != UA_STATUSCODE_GOOD) {
+            UA_Array_delete(st->results, count, &UA_TYPES[UA_TYPES_DATAVALUE]);
+            UA_free(st);
+            return ret;
+        }
+        *((size_t*)(outContinuationPoint->data)) = st->endIndex;
+    }
+    *result = st->results;
+    *resultSize = count;
+    UA_free(st);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+readProcessed_service_default(UA_Server *server,
+                              void *context,
+                              const UA_NodeId *sessionId,
+                              void *sessionContext,
+                              const UA_RequestHeader *requestHeader,
+                              const UA_ReadProcessedDetails *historyReadDetails,
+                              UA_TimestampsToReturn timestampsToReturn,
+                              UA_Boolean releaseContinuationPoints,
+                              size_t nodesToReadSize,
+                              const UA_HistoryReadValueId *nodesToRead,
+                              UA_HistoryReadResponse *response,
+                              UA_HistoryData * const * const historyData)
+{
+    if (historyReadDetails->aggregateTypeSize != nodesToReadSize) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADAGGREGATELISTMISMATCH;
+        return;
+    }
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    for (size_t i = 0; i < nodesToReadSize; ++i) {
+        UA_Aggregate aggregate;
+        UA_StatusCode res = getAggregate(&historyReadDetails->aggregateType[i], &aggregate);
+        if (res != UA_STATUSCODE_GOOD) {
+            response->results[i].statusCode = res;
+            continue;
+        }
+
+        UA_Byte accessLevel = 0;
+        UA_Server_readAccessLevel(server,
+                                  nodesToRead[i].nodeId,
+                                  &accessLevel);
+        if (!(accessLevel & UA_ACCESSLEVELMASK_HISTORYREAD)) {
+            response->results[i].statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+
+        UA_Boolean historizing = false;
+        UA_Server_readHistorizing(server,
+                                  nodesToRead[i].nodeId,
+                                  &historizing);
+        if (!historizing) {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONINVALID;
+            continue;
+        }
+
+        const UA_HistorizingNodeIdSettings *setting = ctx->gathering.getHistorizingSetting(
+                    server,
+                    ctx->gathering.context,
+                    &nodesToRead[i].nodeId);
+        if (!setting) {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONINVALID;
+            continue;
+        }
+
+        /* The aggregates are computed over the sorted values of the low level
+         * interface */
+        if (setting->historizingBackend.getHistoryData ||
+            !setting->historizingBackend.copyDataValues) {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+
+        res = getProcessedData_service_default(
+                    &setting->historizingBackend,
+                    historyReadDetails,
+                    aggregate,
+                    server,
+                    sessionId,
+                    sessionContext,
+                    &nodesToRead[i].nodeId,
+                    setting->maxHistoryDataResponseSize,
+                    timestampsToReturn,
+                    releaseContinuationPoints,
+                    &nodesToRead[i].continuationPoint,
+                    &response->results[i].continuationPoint,
+                    &historyData[i]->dataValuesSize,
+                    &historyData[i]->dataValues);
+        if (res != UA_STATUSCODE_GOOD)
+            response->results[i].statusCode = res;
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+
+/* Historical events
+ * -----------------
+ * The fields selected by the HistoricalEventFilter of the emitter are stored
+ * as a map keyed by their BrowseName. ReadEvent applies the EventFilter of the
+ * request to the stored maps in the same way as for transient events. OfType
+ * and SourceNode equality conditions of the where-clause are extracted
+ * beforehand, so that the backend only visits the indexed candidate events. */
+
+#define EVENT_FILTER_MAXDEPTH 16
+
+static void
+setEvent_service_default(UA_Server *server,
+                         void *context,
+                         const UA_NodeId *originId,
+                         const UA_NodeId *emitterId,
+                         const UA_EventFilter *historicalEventFilter,
+                         UA_EventFieldList *fieldList)
+{
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    if (!historicalEventFilter)
+        return;
+
+    /* Only the properties of the event can be stored in the map. The values
+     * in the field list can be borrowed and are copied. */
+    UA_KeyValueMap fields = UA_KEYVALUEMAP_NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t fieldsSize = historicalEventFilter->selectClausesSize;
+    if (fieldsSize > fieldList->eventFieldsSize)
+        fieldsSize = fieldList->eventFieldsSize;
+    for (size_t i = 0; i < fieldsSize && res == UA_STATUSCODE_GOOD; ++i) {
+        const UA_SimpleAttributeOperand *sao = &historicalEventFilter->selectClauses[i];
+        if (sao->browsePathSize != 1 || sao->attributeId != UA_ATTRIBUTEID_VALUE ||
+            UA_Variant_isEmpty(&fieldList->eventFields[i]))
+            continue;
+        res = UA_KeyValueMap_set(&fields, sao->browsePath[0], &fieldList->eventFields[i]);
+    }
+    if (res == UA_STATUSCODE_GOOD &&
+        !UA_KeyValueMap_contains(&fields, UA_QUALIFIEDNAME(0, "SourceNode")))
+        res = UA_KeyValueMap_setScalar(&fields, UA_QUALIFIEDNAME(0, "SourceNode"),
+                                       (void*)(uintptr_t)originId,
+                                       &UA_TYPES[UA_TYPES_NODEID]);
+    if (res != UA_STATUSCODE_GOOD) {
+        UA_KeyValueMap_clear(&fields);
+        return;
+    }
+    ctx->eventBackend.setEvent(server, ctx->eventBackend.context, emitterId, &fields);
+}
+
+/* Candidate keys for the index of the backend. Not set if the where-clause
+ * does not restrict the EventTypes or SourceNodes. */
+typedef struct {
+    UA_Boolean hasTypes;
+    size_t typesSize;
+    UA_NodeId *types;
+    UA_Boolean hasSources;
+    size_t sourcesSize;
+    UA_NodeId *sources;
+} UA_EventIndexKeys;
+
+static void
+UA_EventIndexKeys_clear(UA_EventIndexKeys *keys)
+{
+    UA_Array_delete(keys->types, keys->typesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_Array_delete(keys->sources, keys->sourcesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    memset(keys, 0, sizeof(UA_EventIndexKeys));
+}
+
+static UA_StatusCode
+addIndexKey(UA_NodeId **ids, size_t *idsSize, const UA_NodeId *id)
+{
+    for (size_t i = 0; i < *idsSize; ++i) {
+        if (UA_NodeId_equal(&(*ids)[i], id))
+            return UA_STATUSCODE_GOOD;
+    }
+    return UA_Array_appendCopy((void**)ids, idsSize, id, &UA_TYPES[UA_TYPES_NODEID]);
+}
+
+static const UA_NodeId *
+literalNodeId(const UA_ExtensionObject *operand)
+{
+    if (operand->encoding != UA_EXTENSIONOBJECT_DECODED ||
+        operand->content.decoded.type != &UA_TYPES[UA_TYPES_LITERALOPERAND])
+        return NULL;
+    const UA_LiteralOperand *lo = (const UA_LiteralOperand*)operand->content.decoded.data;
+    if (!UA_Variant_hasScalarType(&lo->value, &UA_TYPES[UA_TYPES_NODEID]))
+        return NULL;
+    return (const UA_NodeId*)lo->value.data;
+}
+
+static UA_Boolean
+isSourceNodeOperand(const UA_ExtensionObject *operand)
+{
+    if (operand->encoding != UA_EXTENSIONOBJECT_DECODED ||
+        operand->content.decoded.type != &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND])
+        return false;
+    const UA_SimpleAttributeOperand *sao =
+        (const UA_SimpleAttributeOperand*)operand->content.decoded.data;
+    UA_QualifiedName sourceNode = UA_QUALIFIEDNAME(0, "SourceNode");
+    return sao->browsePathSize == 1 && sao->attributeId == UA_ATTRIBUTEID_VALUE &&
+        UA_QualifiedName_equal(&sao->browsePath[0], &sourceNode);
+}
+
+static UA_StatusCode
+addEventTypeKeys(UA_Server *server, UA_EventIndexKeys *keys, const UA_NodeId *eventType)
+{
+    /* OfType also matches the subtypes */
+    UA_StatusCode res = addIndexKey(&keys->types, &keys->typesSize, eventType);
+    if (res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = *eventType;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE);
+    bd.includeSubtypes = false;
+    bd.nodeClassMask = UA_NODECLASS_OBJECTTYPE;
+    size_t subtypesSize = 0;
+    UA_ExpandedNodeId *subtypes = NULL;
+    res = UA_Server_browseRecursive(server, &bd, &subtypesSize, &subtypes);
+    if (res != UA_STATUSCODE_GOOD)
+        return res;
+    for (size_t i = 0; i < subtypesSize && res == UA_STATUSCODE_GOOD; ++i)
+        res = addIndexKey(&keys->types, &keys->typesSize, &subtypes[i].nodeId);
+    UA_Array_delete(subtypes, subtypesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    keys->hasTypes = true;
+    return res;
+}
+
+static UA_StatusCode
+mergeIndexKeys(UA_NodeId **ids, size_t *idsSize, UA_NodeId *other, size_t otherSize)
+{
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for (size_t i = 0; i < otherSize && res == UA_STATUSCODE_GOOD; ++i)
+        res = addIndexKey(ids, idsSize, &other[i]);
+    return res;
+}
+
+/* A matching event must satisfy the keys. The keys of an And-element are
+ * taken from either operand. The keys of an Or-element are the union of the
+ * keys of both operands. */
+static UA_StatusCode
+extractIndexKeys(UA_Server *server, const UA_ContentFilter *filter, size_t index,
+                 size_t depth, UA_EventIndexKeys *keys)
+{
+    if (index >= filter->elementsSize || depth > EVENT_FILTER_MAXDEPTH)
+        return UA_STATUSCODE_GOOD;
+    const UA_ContentFilterElement *elm = &filter->elements[index];
+    const UA_NodeId *id;
+    switch (elm->filterOperator) {
+    case UA_FILTEROPERATOR_OFTYPE:
+        if (elm->filterOperandsSize != 1)
+            return UA_STATUSCODE_GOOD;
+        id = literalNodeId(&elm->filterOperands[0]);
+        return (id) ? addEventTypeKeys(server, keys, id) : UA_STATUSCODE_GOOD;
+    case UA_FILTEROPERATOR_EQUALS:
+        if (elm->filterOperandsSize != 2)
+            return UA_STATUSCODE_GOOD;
+        if (isSourceNodeOperand(&elm->filterOperands[0]))
+            id = literalNodeId(&elm->filterOperands[1]);
+        else if (isSourceNodeOperand(&elm->filterOperands[1]))
+            id = literalNodeId(&elm->filterOperands[0]);
+        else
+            return UA_STATUSCODE_GOOD;
+        if (!id)
+            return UA_STATUSCODE_GOOD;
+        keys->hasSources = true;
+        return addIndexKey(&keys->sources, &keys->sourcesSize, id);
+    case UA_FILTEROPERATOR_AND:
+    case UA_FILTEROPERATOR_OR:
+        break;
+    default:
+        return UA_STATUSCODE_GOOD;
+    }
+
+    if (elm->filterOperandsSize != 2)
+        return UA_STATUSCODE_GOOD;
+    UA_EventIndexKeys sub[2];
+    memset(sub, 0, sizeof(sub));
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for (size_t i = 0; i < 2 && res == UA_STATUSCODE_GOOD; ++i) {
+        const UA_ExtensionObject *op = &elm->filterOperands[i];
+        if (op->encoding != UA_EXTENSIONOBJECT_DECODED ||
+            op->content.decoded.type != &UA_TYPES[UA_TYPES_ELEMENTOPERAND])
+            continue;
+        const UA_ElementOperand *eo = (const UA_ElementOperand*)op->content.decoded.data;
+        res = extractIndexKeys(server, filter, eo->index, depth + 1, &sub[i]);
+    }
+
+    if (res == UA_STATUSCODE_GOOD && elm->filterOperator == UA_FILTEROPERATOR_AND) {
+        UA_EventIndexKeys *t = (sub[0].hasTypes) ? &sub[0] : &sub[1];
+        UA_EventIndexKeys *s = (sub[0].hasSources) ? &sub[0] : &sub[1];
+        if (t->hasTypes) {
+            keys->hasTypes = true;
+            res |= mergeIndexKeys(&keys->types, &keys->typesSize, t->types, t->typesSize);
+        }
+        if (s->hasSources) {
+            keys->hasSources = true;
+            res |= mergeIndexKeys(&keys->sources, &keys->sourcesSize,
+                                  s->sources, s->sourcesSize);
+        }
+    } else if (res == UA_STATUSCODE_GOOD) {
+        if (sub[0].hasTypes && sub[1].hasTypes) {
+            keys->hasTypes = true;
+            res |= mergeIndexKeys(&keys->types, &keys->typesSize,
+                                  sub[0].types, sub[0].typesSize);
+            res |= mergeIndexKeys(&keys->types, &keys->typesSize,
+                                  sub[1].types, sub[1].typesSize);
+        }
+        if (sub[0].hasSources && sub[1].hasSources) {
+            keys->hasSources = true;
+            res |= mergeIndexKeys(&keys->sources, &keys->sourcesSize,
+                                  sub[0].sources, sub[0].sourcesSize);
+            res |= mergeIndexKeys(&keys->sources, &keys->sourcesSize,
+                                  sub[1].sources, sub[1].sourcesSize);
+        }
+    }
+    UA_EventIndexKeys_clear(&sub[0]);
+    UA_EventIndexKeys_clear(&sub[1]);
+    return res;
+}
+
+/* Moves the selected fields of a matching event into the result */
+static UA_StatusCode
+filterHistoryEvent(UA_Server *server, const UA_EventFilter *filter,
+                   const UA_KeyValueMap *fields, UA_HistoryEvent *historyEvent,
+                   size_t *eventsCapacity)
+{
+    UA_NodeId eventType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    const UA_Variant *v = UA_KeyValueMap_get(fields, UA_QUALIFIEDNAME(0, "EventType"));
+    if (v && UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_NODEID]))
+        eventType = *(UA_NodeId*)v->data;
+
+    UA_EventFieldList efl;
+    UA_StatusCode res = UA_Server_filterEventFields(server, eventType, fields, filter, &efl);
+    if (res == UA_STATUSCODE_BADNOMATCH)
+        return UA_STATUSCODE_GOOD;
+    if (res != UA_STATUSCODE_GOOD)
+        return res;
+
+    if (historyEvent->eventsSize == *eventsCapacity) {
+        size_t cap = (*eventsCapacity > 0) ? *eventsCapacity * 2 : 16;
+        UA_HistoryEventFieldList *events = (UA_HistoryEventFieldList*)
+            UA_realloc(historyEvent->events, cap * sizeof(UA_HistoryEventFieldList));
+        if (!events) {
+            UA_EventFieldList_clear(&efl);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        historyEvent->events = events;
+        *eventsCapacity = cap;
+    }
+    UA_HistoryEventFieldList *hefl = &historyEvent->events[historyEvent->eventsSize++];
+    hefl->eventFieldsSize = efl.eventFieldsSize;
+    hefl->eventFields = efl.eventFields;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+getHistoryEvents_service_default(UA_HistoryDatabaseContext_default *ctx,
+                                 UA_Server *server,
+                                 const UA_ReadEventDetails *details,
+                                 const UA_EventIndexKeys *keys,
+                                 const UA_NodeId *nodeId,
+                                 const UA_ByteString *continuationPoint,
+                                 UA_ByteString *outContinuationPoint,
+                                 UA_HistoryEvent *historyEvent)
+{
+    /* Map the request to an inclusive time range. The endTime is excluded. If
+     * only one time is given, read from there in the direction of the other. */
+    UA_DateTime first, last;
+    UA_Boolean reverse;
+    if (details->startTime == LLONG_MIN && details->endTime == LLONG_MIN) {
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    } else if (details->startTime == LLONG_MIN) {
+        first = LLONG_MIN;
+        last = details->endTime;
+        reverse = true;
+    } else if (details->endTime == LLONG_MIN) {
+        first = details->startTime;
+        last = LLONG_MAX;
+        reverse = false;
+    } else if (details->startTime <= details->endTime) {
+        first = details->startTime;
+        last = details->endTime - 1;
+        reverse = false;
+    } else {
+        first = details->endTime + 1;
+        last = details->startTime;
+        reverse = true;
+    }
+
+    size_t pageSize = (details->numValuesPerNode > 0) ?
+        details->numValuesPerNode : SIZE_MAX;
+    if (ctx->maxHistoryEventResponseSize > 0 && pageSize > ctx->maxHistoryEventResponseSize)
+        pageSize = ctx->maxHistoryEventResponseSize;
+
+    /* Fetch the candidates in batches until the page is full. The continuation
+     * point of the backend is forwarded. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t eventsCapacity = 0;
+    UA_ByteString cp = UA_BYTESTRING_NULL;
+    res = UA_ByteString_copy(continuationPoint, &cp);
+    while (res == UA_STATUSCODE_GOOD) {
+        size_t batchSize = 0;
+        UA_KeyValueMap *batch = NULL;
+        UA_ByteString nextCp = UA_BYTESTRING_NULL;
+        res = ctx->eventBackend.getEvents(server, ctx->eventBackend.context, nodeId,
+                                          first, last, reverse,
+                                          keys->typesSize, keys->types,
+                                          keys->sourcesSize, keys->sources,
+                                          pageSize - historyEvent->eventsSize,
+                                          &cp, &nextCp, &batchSize, &batch);
+        UA_ByteString_clear(&cp);
+        for (size_t i = 0; i < batchSize; ++i) {
+            if (res == UA_STATUSCODE_GOOD)
+                res = filterHistoryEvent(server, &details->filter, &batch[i],
+                                         historyEvent, &eventsCapacity);
+            UA_KeyValueMap_clear(&batch[i]);
+        }
+        UA_free(batch);
+        cp = nextCp;
+        if (res != UA_STATUSCODE_GOOD || cp.length == 0)
+            break;
+        if (historyEvent->eventsSize == pageSize) {
+            *outContinuationPoint = cp;
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+    UA_ByteString_clear(&cp);
+    return res;
+}
+
+static void
+readEvent_service_default(UA_Server *server,
+                          void *context,
+                          const UA_NodeId *sessionId,
+                          void *sessionContext,
+                          const UA_RequestHeader *requestHeader,
+                          const UA_ReadEventDetails *historyReadDetails,
+                          UA_TimestampsToReturn timestampsToReturn,
+                          UA_Boolean releaseContinuationPoints,
+                          size_t nodesToReadSize,
+                          const UA_HistoryReadValueId *nodesToRead,
+                          UA_HistoryReadResponse *response,
+                          UA_HistoryEvent * const * const historyData)
+{
+    UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)context;
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+    /* The continuation points hold no resources */
+    if (releaseContinuationPoints)
+        return;
+    if (historyReadDetails->filter.selectClausesSize == 0) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADEVENTFILTERINVALID;
+        return;
+    }
+
+    /* The keys are the same for all nodes */
+    UA_EventIndexKeys keys;
+    memset(&keys, 0, sizeof(UA_EventIndexKeys));
+    UA_StatusCode res =
+        extractIndexKeys(server, &historyReadDetails->filter.whereClause, 0, 0, &keys);
+    if (res != UA_STATUSCODE_GOOD) {
+        UA_EventIndexKeys_clear(&keys);
+        response->responseHeader.serviceResult = res;
+        return;
+    }
+
+    for (size_t i = 0; i < nodesToReadSize; ++i) {
+        UA_Byte eventNotifier = 0;
+        UA_Server_readEventNotifier(server, nodesToRead[i].nodeId, &eventNotifier);
+        if (!(eventNotifier & UA_EVENTNOTIFIER_HISTORY_READ)) {
+            response->results[i].statusCode = UA_STATUSCODE_BADUSERACCESSDENIED;
+            continue;
+        }
+        res = getHistoryEvents_service_default(ctx, server, historyReadDetails, &keys,
+                                               &nodesToRead[i].nodeId,
+                                               &nodesToRead[i].continuationPoint,
+                                               &response->results[i].continuationPoint,
+                                               historyData[i]);
+        if (res != UA_STATUSCODE_GOOD)
+            response->results[i].statusCode = res;
+    }
+    UA_EventIndexKeys_clear(&keys);
+}
+
+#endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
+
 static void
 setValue_service_default(UA_Server *server,
                          void *context,
@@ -605,6 +1660,10 @@ clear_service_default(UA_HistoryDatabase *hdb)
         return;
     UA_HistoryDatabaseContext_default *ctx = (UA_HistoryDatabaseContext_default*)hdb->context;
     ctx->gathering.deleteMembers(&ctx->gathering);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if (ctx->eventBackend.deleteMembers)
+        ctx->eventBackend.deleteMembers(&ctx->eventBackend);
+#endif
     UA_free(ctx);
 }
 
@@ -619,9 +1678,27 @@ UA_HistoryDatabase_default(UA_HistoryDataGathering gathering)
     context->gathering = gathering;
     hdb.context = context;
     hdb.readRaw = &readRaw_service_default;
+    hdb.readProcessed = &readProcessed_service_default;
     hdb.setValue = &setValue_service_default;
     hdb.updateData = &updateData_service_default;
     hdb.deleteRawModified = &deleteRawModified_service_default;
     hdb.clear = clear_service_default;
     return hdb;
 }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+UA_HistoryDatabase
+UA_HistoryDatabase_default_events(UA_HistoryDataGathering gathering,
+                                  UA_HistoryEventBackend eventBackend,
+                                  size_t maxHistoryEventResponseSize)
+{
+    UA_HistoryDatabase hdb = UA_HistoryDatabase_default(gathering);
+    UA_HistoryDatabaseContext_default *context =
+            (UA_HistoryDatabaseContext_default*)hdb.context;
+    context->eventBackend = eventBackend;
+    context->maxHistoryEventResponseSize = maxHistoryEventResponseSize;
+    hdb.setEvent = &setEvent_service_default;
+    hdb.readEvent = &readEvent_service_default;
+    return hdb;
+}
+#endif
@@ -0,0 +1,650 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/plugin/historydata/history_event_backend_memory.h>
+
+#include <string.h>
+
+/* Events with the same Time are ordered by their arrival */
+typedef struct {
+    UA_DateTime time;
+    UA_UInt64 seq;
+    UA_NodeId eventType;
+    UA_NodeId sourceNode;
+    UA_KeyValueMap fields;
+} UA_StoredEvent_memory;
+
+/* List of events sorted by (time, seq). The events are owned by the partition
+ * and referenced from several lists. */
+typedef struct {
+    UA_NodeId key; /* EventType or SourceNode, unused for the list of all */
+    UA_StoredEvent_memory **events;
+    size_t eventsSize;
+    size_t eventsCapacity;
+} UA_EventList_memory;
+
+typedef struct {
+    UA_Int64 key; /* Time divided by the partition interval */
+    UA_EventList_memory all;
+    UA_EventList_memory *types;
+    size_t typesSize;
+    UA_EventList_memory *sources;
+    size_t sourcesSize;
+} UA_EventPartition_memory;
+
+typedef struct {
+    UA_NodeId emitterId;
+    UA_EventPartition_memory **partitions; /* Sorted by key */
+    size_t partitionsSize;
+    UA_DateTime newest;
+} UA_EventEmitter_memory;
+
+typedef struct {
+    UA_Int64 interval;  /* In DateTime ticks */
+    UA_Int64 retention; /* In DateTime ticks, zero keeps all */
+    UA_UInt64 nextSeq;
+    UA_EventEmitter_memory **emitters;
+    size_t emittersSize;
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+#endif
+} UA_EventMemoryContext;
+
+/* The continuation point is the position of the next event */
+typedef struct {
+    UA_DateTime time;
+    UA_UInt64 seq;
+} UA_EventCursor_memory;
+
+static void
+UA_StoredEvent_memory_delete(UA_StoredEvent_memory *e) {
+    UA_NodeId_clear(&e->eventType);
+    UA_NodeId_clear(&e->sourceNode);
+    UA_KeyValueMap_clear(&e->fields);
+    UA_free(e);
+}
+
+static void
+UA_EventList_memory_clear(UA_EventList_memory *list) {
+    UA_NodeId_clear(&list->key);
+    UA_free(list->events);
+}
+
+static void
+UA_EventPartition_memory_delete(UA_EventPartition_memory *p) {
+    for(size_t i = 0; i < p->all.eventsSize; i++)
+        UA_StoredEvent_memory_delete(p->all.events[i]);
+    UA_EventList_memory_clear(&p->all);
+    for(size_t i = 0; i < p->typesSize; i++)
+        UA_EventList_memory_clear(&p->types[i]);
+    UA_free(p->types);
+    for(size_t i = 0; i < p->sourcesSize; i++)
+        UA_EventList_memory_clear(&p->sources[i]);
+    UA_free(p->sources);
+    UA_free(p);
+}
+
+static void
+UA_EventEmitter_memory_delete(UA_EventEmitter_memory *em) {
+    for(size_t i = 0; i < em->partitionsSize; i++)
+        UA_EventPartition_memory_delete(em->partitions[i]);
+    UA_free(em->partitions);
+    UA_NodeId_clear(&em->emitterId);
+    UA_free(em);
+}
+
+static int
+compareEvent(UA_DateTime time, UA_UInt64 seq, const UA_StoredEvent_memory *e) {
+    if(time != e->time)
+        return (time < e->time) ? -1 : 1;
+    if(seq != e->seq)
+        return (seq < e->seq) ? -1 : 1;
+    return 0;
+}
+
+/* Position of the first event not before (time, seq) */
+static size_t
+lowerBound(const UA_EventList_memory *list, UA_DateTime time, UA_UInt64 seq) {
+    size_t lo = 0, hi = list->eventsSize;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(compareEvent(time, seq, list->events[mid]) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static UA_StatusCode
+insertIntoList(UA_EventList_memory *list, UA_StoredEvent_memory *e) {
+    if(list->eventsSize == list->eventsCapacity) {
+        size_t cap = (list->eventsCapacity > 0) ? list->eventsCapacity * 2 : 8;
+        UA_StoredEvent_memory **events = (UA_StoredEvent_memory**)
+            UA_realloc(list->events, cap * sizeof(UA_StoredEvent_memory*));
+        if(!events)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        list->events = events;
+        list->eventsCapacity = cap;
+    }
+    /* Events mostly arrive in order and are appended */
+    size_t pos = list->eventsSize;
+    if(pos > 0 && compareEvent(e->time, e->seq, list->events[pos - 1]) < 0)
+        pos = lowerBound(list, e->time, e->seq);
+    memmove(&list->events[pos + 1], &list->events[pos],
+            (list->eventsSize - pos) * sizeof(UA_StoredEvent_memory*));
+    list->events[pos] = e;
+    list->eventsSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeFromList(UA_EventList_memory *list, const UA_StoredEvent_memory *e) {
+    size_t pos = lowerBound(list, e->time, e->seq);
+    if(pos >= list->eventsSize || list->events[pos] != e)
+        return;
+    list->eventsSize--;
+    memmove(&list->events[pos], &list->events[pos + 1],
+            (list->eventsSize - pos) * sizeof(UA_StoredEvent_memory*));
+}
+
+static UA_EventList_memory *
+findList(UA_EventList_memory *lists, size_t listsSize, const UA_NodeId *key) {
+    for(size_t i = 0; i < listsSize; i++) {
+        if(UA_NodeId_equal(&lists[i].key, key))
+            return &lists[i];
+    }
+    return NULL;
+}
+
+static UA_EventList_memory *
+getList(UA_EventList_memory **lists, size_t *listsSize, const UA_NodeId *key) {
+    UA_EventList_memory *list = findList(*lists, *listsSize, key);
+    if(list)
+        return list;
+    UA_EventList_memory *newLists = (UA_EventList_memory*)
+        UA_realloc(*lists, (*listsSize + 1) * sizeof(UA_EventList_memory));
+    if(!newLists)
+        return NULL;
+    *lists = newLists;
+    list = &newLists[*listsSize];
+    memset(list, 0, sizeof(UA_EventList_memory));
+    if(UA_NodeId_copy(key, &list->key) != UA_STATUSCODE_GOOD)
+        return NULL;
+    (*listsSize)++;
+    return list;
+}
+
+static UA_Int64
+partitionKey(const UA_EventMemoryContext *ctx, UA_DateTime time) {
+    UA_Int64 key = time / ctx->interval;
+    if(time % ctx->interval < 0)
+        key--; /* Round towards negative infinity */
+    return key;
+}
+
+/* Position of the first partition with a key not below the given key */
+static size_t
+partitionLowerBound(const UA_EventEmitter_memory *em, UA_Int64 key) {
+    size_t lo = 0, hi = em->partitionsSize;
+    while(lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if(em->partitions[mid]->key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static UA_EventPartition_memory *
+getPartition(UA_EventEmitter_memory *em, UA_Int64 key) {
+    size_t pos = partitionLowerBound(em, key);
+    if(pos < em->partitionsSize && em->partitions[pos]->key == key)
+        return em->partitions[pos];
+    UA_EventPartition_memory **partitions = (UA_EventPartition_memory**)
+        UA_realloc(em->partitions,
+                   (em->partitionsSize + 1) * sizeof(UA_EventPartition_memory*));
+    if(!partitions)
+        return NULL;
+    em->partitions = partitions;
+    UA_EventPartition_memory *p = (UA_EventPartition_memory*)
+        UA_calloc(1, sizeof(UA_EventPartition_memory));
+    if(!p)
+        return NULL;
+    p->key = key;
+    memmove(&partitions[pos + 1], &partitions[pos],
+            (em->partitionsSize - pos) * sizeof(UA_EventPartition_memory*));
+    partitions[pos] = p;
+    em->partitionsSize++;
+    return p;
+}
+
+static UA_EventEmitter_memory *
+findEmitter(const UA_EventMemoryContext *ctx, const UA_NodeId *emitterId) {
+    for(size_t i = 0; i < ctx->emittersSize; i++) {
+        if(UA_NodeId_equal(&ctx->emitters[i]->emitterId, emitterId))
+            return ctx->emitters[i];
+    }
+    return NULL;
+}
+
+static UA_EventEmitter_memory *
+getEmitter(UA_EventMemoryContext *ctx, const UA_NodeId *emitterId) {
+    UA_EventEmitter_memory *em = findEmitter(ctx, emitterId);
+    if(em)
+        return em;
+    UA_EventEmitter_memory **emitters = (UA_EventEmitter_memory**)
+        UA_realloc(ctx->emitters,
+                   (ctx->emittersSize + 1) * sizeof(UA_EventEmitter_memory*));
+    if(!emitters)
+        return NULL;
+    ctx->emitters = emitters;
+    em = (UA_EventEmitter_memory*)UA_calloc(1, sizeof(UA_EventEmitter_memory));
+    if(!em)
+        return NULL;
+    if(UA_NodeId_copy(emitterId, &em->emitterId) != UA_STATUSCODE_GOOD) {
+        UA_free(em);
+        return NULL;
+    }
+    em->newest = UA_INT64_MIN;
+    emitters[ctx->emittersSize++] = em;
+    return em;
+}
+
+/* Drops the partitions that end before the retention time */
+static void
+applyRetention(const UA_EventMemoryContext *ctx, UA_EventEmitter_memory *em) {
+    if(ctx->retention <= 0 || em->newest == UA_INT64_MIN)
+        return;
+    UA_Int64 oldestKey = partitionKey(ctx, em->newest - ctx->retention);
+    size_t drop = partitionLowerBound(em, oldestKey);
+    if(drop == 0)
+        return;
+    for(size_t i = 0; i < drop; i++)
+        UA_EventPartition_memory_delete(em->partitions[i]);
+    em->partitionsSize -= drop;
+    memmove(em->partitions, &em->partitions[drop],
+            em->partitionsSize * sizeof(UA_EventPartition_memory*));
+}
+
+static UA_StatusCode
+addEvent(UA_EventMemoryContext *ctx, UA_EventEmitter_memory *em,
+         UA_StoredEvent_memory *e) {
+    UA_EventPartition_memory *p = getPartition(em, partitionKey(ctx, e->time));
+    if(!p)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_EventList_memory *type = getList(&p->types, &p->typesSize, &e->eventType);
+    UA_EventList_memory *source =
+        getList(&p->sources, &p->sourcesSize, &e->sourceNode);
+    if(!type || !source)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = insertIntoList(&p->all, e);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = insertIntoList(type, e);
+    if(res == UA_STATUSCODE_GOOD) {
+        res = insertIntoList(source, e);
+        if(res == UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_GOOD;
+        removeFromList(type, e);
+    }
+    removeFromList(&p->all, e);
+    return res;
+}
+
+static UA_StatusCode
+setEvent_backend_memory(UA_Server *server, void *hebContext,
+                        const UA_NodeId *emitterId, UA_KeyValueMap *fields) {
+    UA_EventMemoryContext *ctx = (UA_EventMemoryContext*)hebContext;
+    UA_StoredEvent_memory *e = (UA_StoredEvent_memory*)
+        UA_calloc(1, sizeof(UA_StoredEvent_memory));
+    if(!e) {
+        UA_KeyValueMap_clear(fields);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    e->fields = *fields;
+    *fields = UA_KEYVALUEMAP_NULL;
+
+    /* The Time and SourceNode are added if not defined */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    const UA_Variant *v = UA_KeyValueMap_get(&e->fields, UA_QUALIFIEDNAME(0, "Time"));
+    if(v && UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_DATETIME])) {
+        e->time = *(UA_DateTime*)v->data;
+    } else {
+        e->time = UA_DateTime_now();
+        res |= UA_KeyValueMap_setScalar(&e->fields, UA_QUALIFIEDNAME(0, "Time"),
+                                        &e->time, &UA_TYPES[UA_TYPES_DATETIME]);
+    }
+    v = UA_KeyValueMap_get(&e->fields, UA_QUALIFIEDNAME(0, "SourceNode"));
+    if(v && UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_NODEID])) {
+        res |= UA_NodeId_copy((UA_NodeId*)v->data, &e->sourceNode);
+    } else {
+        res |= UA_NodeId_copy(emitterId, &e->sourceNode);
+        res |= UA_KeyValueMap_setScalar(&e->fields, UA_QUALIFIEDNAME(0, "SourceNode"),
+                                        (void*)(uintptr_t)emitterId,
+                                        &UA_TYPES[UA_TYPES_NODEID]);
+    }
+    v = UA_KeyValueMap_get(&e->fields, UA_QUALIFIEDNAME(0, "EventType"));
+    if(v && UA_Variant_hasScalarType(v, &UA_TYPES[UA_TYPES_NODEID]))
+        res |= UA_NodeId_copy((UA_NodeId*)v->data, &e->eventType);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_StoredEvent_memory_delete(e);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    UA_LOCK(&ctx->lock);
+    UA_EventEmitter_memory *em = getEmitter(ctx, emitterId);
+    if(!em) {
+        UA_UNLOCK(&ctx->lock);
+        UA_StoredEvent_memory_delete(e);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* Events older than the retention time are not stored */
+    if(ctx->retention > 0 && em->newest != UA_INT64_MIN &&
+       e->time < em->newest - ctx->retention) {
+        UA_UNLOCK(&ctx->lock);
+        UA_StoredEvent_memory_delete(e);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    e->seq = ctx->nextSeq++;
+    res = addEvent(ctx, em, e);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&ctx->lock);
+        UA_StoredEvent_memory_delete(e);
+        return res;
+    }
+    if(e->time > em->newest) {
+        em->newest = e->time;
+        applyRetention(ctx, em);
+    }
+    UA_UNLOCK(&ctx->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Boolean
+containsNodeId(size_t idsSize, const UA_NodeId *ids, const UA_NodeId *id) {
+    for(size_t i = 0; i < idsSize; i++) {
+        if(UA_NodeId_equal(&ids[i], id))
+            return true;
+    }
+    return false;
+}
+
+/* Merges the selected lists of a partition. The lists are disjoint. */
+typedef struct {
+    UA_EventList_memory **lists;
+    size_t *pos; /* Next position. Reverse: Position after the next. */
+    size_t listsSize;
+} UA_EventMerge_memory;
+
+static UA_StatusCode
+initMerge(UA_EventMerge_memory *m, UA_EventPartition_memory *p,
+          size_t eventTypesSize, const UA_NodeId *eventTypes,
+          size_t sourceNodesSize, const UA_NodeId *sourceNodes,
+          UA_DateTime time, UA_UInt64 seq, UA_Boolean reverse) {
+    /* Without a restriction, all events are merged. Otherwise use the index
+     * with fewer candidate events. */
+    UA_EventList_memory *lists = &p->all;
+    size_t listsSize = 1;
+    size_t keysSize = 0;
+    const UA_NodeId *keys = NULL;
+    if(eventTypesSize > 0 || sourceNodesSize > 0) {
+        size_t typeCount = 0, sourceCount = 0;
+        for(size_t i = 0; i < eventTypesSize; i++) {
+            UA_EventList_memory *l = findList(p->types, p->typesSize, &eventTypes[i]);
+            typeCount += (l) ? l->eventsSize : 0;
+        }
+        for(size_t i = 0; i < sourceNodesSize; i++) {
+            UA_EventList_memory *l = findList(p->sources, p->sourcesSize, &sourceNodes[i]);
+            sourceCount += (l) ? l->eventsSize : 0;
+        }
+        if(eventTypesSize > 0 && (sourceNodesSize == 0 || typeCount <= sourceCount)) {
+            lists = p->types;
+            listsSize = p->typesSize;
+            keysSize = eventTypesSize;
+            keys = eventTypes;
+        } else {
+            lists = p->sources;
+            listsSize = p->sourcesSize;
+            keysSize = sourceNodesSize;
+            keys = sourceNodes;
+        }
+    }
+
+    /* The positions are allocated behind the list pointers */
+    m->listsSize = 0;
+    m->lists = NULL;
+    m->pos = NULL;
+    if(listsSize == 0)
+        return UA_STATUSCODE_GOOD;
+    m->lists = (UA_EventList_memory**)
+        UA_malloc(listsSize * (sizeof(UA_EventList_memory*) + sizeof(size_t)));
+    if(!m->lists)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    m->pos = (size_t*)&m->lists[listsSize];
+    for(size_t i = 0; i < listsSize; i++) {
+        UA_EventList_memory *l = &lists[i];
+        if(keys && !containsNodeId(keysSize, keys, &l->key))
+            continue;
+        size_t pos;
+        if(!reverse)
+            pos = lowerBound(l, time, seq);
+        else if(seq == UA_UINT64_MAX)
+            pos = lowerBound(l, time + 1, 0);
+        else
+            pos = lowerBound(l, time, seq + 1);
+        m->lists[m->listsSize] = l;
+        m->pos[m->listsSize] = pos;
+        m->listsSize++;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StoredEvent_memory *
+nextMerge(UA_EventMerge_memory *m, UA_Boolean reverse) {
+    UA_StoredEvent_memory *best = NULL;
+    size_t bestList = 0;
+    for(size_t i = 0; i < m->listsSize; i++) {
+        UA_EventList_memory *l = m->lists[i];
+        UA_StoredEvent_memory *e;
+        if(!reverse) {
+            if(m->pos[i] >= l->eventsSize)
+                continue;
+            e = l->events[m->pos[i]];
+        } else {
+            if(m->pos[i] == 0)
+                continue;
+            e = l->events[m->pos[i] - 1];
+        }
+        if(!best || (compareEvent(e->time, e->seq, best) < 0) != reverse) {
+            best = e;
+            bestList = i;
+        }
+    }
+    if(best) {
+        if(!reverse)
+            m->pos[bestList]++;
+        else
+            m->pos[bestList]--;
+    }
+    return best;
+}
+
+static UA_StatusCode
+getEvents_backend_memory(UA_Server *server, void *hebContext,
+                         const UA_NodeId *emitterId,
+                         UA_DateTime firstTime, UA_DateTime lastTime,
+                         UA_Boolean reverse,
+                         size_t eventTypesSize, const UA_NodeId *eventTypes,
+                         size_t sourceNodesSize, const UA_NodeId *sourceNodes,
+                         size_t maxEvents,
+                         const UA_ByteString *continuationPoint,
+                         UA_ByteString *outContinuationPoint,
+                         size_t *eventsSize, UA_KeyValueMap **events) {
+    UA_EventMemoryContext *ctx = (UA_EventMemoryContext*)hebContext;
+    *eventsSize = 0;
+    *events = NULL;
+    if(firstTime > lastTime)
+        return UA_STATUSCODE_GOOD;
+
+    /* Start position */
+    UA_EventCursor_memory cursor;
+    if(continuationPoint && continuationPoint->length > 0) {
+        if(continuationPoint->length != sizeof(UA_EventCursor_memory))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&cursor, continuationPoint->data, sizeof(UA_EventCursor_memory));
+    } else if(!reverse) {
+        cursor.time = firstTime;
+        cursor.seq = 0;
+    } else {
+        cursor.time = lastTime;
+        cursor.seq = UA_UINT64_MAX;
+    }
+
+    UA_LOCK(&ctx->lock);
+    UA_EventEmitter_memory *em = findEmitter(ctx, emitterId);
+    if(!em) {
+        UA_UNLOCK(&ctx->lock);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Visit the partitions of the time range in order */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t eventsCapacity = 0;
+    UA_Boolean done = false;
+    UA_Int64 cursorKey = partitionKey(ctx, cursor.time);
+    size_t pi = partitionLowerBound(em, cursorKey);
+    if(reverse && (pi == em->partitionsSize || em->partitions[pi]->key > cursorKey)) {
+        if(pi == 0)
+            done = true;
+        pi--;
+    }
+    UA_Int64 firstKey = partitionKey(ctx, firstTime);
+    UA_Int64 lastKey = partitionKey(ctx, lastTime);
+    while(!done && pi < em->partitionsSize) {
+        UA_EventPartition_memory *p = em->partitions[pi];
+        if((!reverse && p->key > lastKey) || (reverse && p->key < firstKey))
+            break;
+        UA_EventMerge_memory m;
+        res = initMerge(&m, p, eventTypesSize, eventTypes,
+                        sourceNodesSize, sourceNodes, cursor.time, cursor.seq, reverse);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        UA_StoredEvent_memory *e;
+        while((e = nextMerge(&m, reverse))) {
+            if((!reverse && e->time > lastTime) || (reverse && e->time < firstTime)) {
+                done = true;
+                break;
+            }
+            /* The index covers one of the restrictions. Check the other. */
+            if(eventTypesSize > 0 &&
+               !containsNodeId(eventTypesSize, eventTypes, &e->eventType))
+                continue;
+            if(sourceNodesSize > 0 &&
+               !containsNodeId(sourceNodesSize, sourceNodes, &e->sourceNode))
+                continue;
+
+            /* Enough events. Continue here next time. */
+            if(*eventsSize == maxEvents) {
+                if(outContinuationPoint) {
+                    UA_EventCursor_memory next = {e->time, e->seq};
+                    UA_ByteString cp = {sizeof(UA_EventCursor_memory), (UA_Byte*)&next};
+                    res = UA_ByteString_copy(&cp, outContinuationPoint);
+                }
+                done = true;
+                break;
+            }
+
+            if(*eventsSize == eventsCapacity) {
+                size_t cap = (eventsCapacity > 0) ? eventsCapacity * 2 : 16;
+                if(cap > maxEvents)
+                    cap = maxEvents;
+                UA_KeyValueMap *newEvents = (UA_KeyValueMap*)
+                    UA_realloc(*events, cap * sizeof(UA_KeyValueMap));
+                if(!newEvents) {
+                    res = UA_STATUSCODE_BADOUTOFMEMORY;
+                    done = true;
+                    break;
+                }
+                *events = newEvents;
+                eventsCapacity = cap;
+            }
+            res = UA_KeyValueMap_copy(&e->fields, &(*events)[*eventsSize]);
+            if(res != UA_STATUSCODE_GOOD) {
+                done = true;
+                break;
+            }
+            (*eventsSize)++;
+        }
+        UA_free(m.lists);
+
+        /* Reset the cursor to the border of the next partition */
+        if(!reverse) {
+            pi++;
+            cursor.seq = 0;
+            if(pi < em->partitionsSize)
+                cursor.time = em->partitions[pi]->key * ctx->interval;
+        } else {
+            if(pi == 0)
+                break;
+            pi--;
+            cursor.seq = UA_UINT64_MAX;
+            cursor.time = (em->partitions[pi]->key + 1) * ctx->interval - 1;
+        }
+    }
+    UA_UNLOCK(&ctx->lock);
+
+    if(res != UA_STATUSCODE_GOOD) {
+        for(size_t i = 0; i < *eventsSize; i++)
+            UA_KeyValueMap_clear(&(*events)[i]);
+        UA_free(*events);
+        *events = NULL;
+        *eventsSize = 0;
+    }
+    return res;
+}
+
+static void
+deleteMembers_backend_memory(UA_HistoryEventBackend *backend) {
+    if(!backend || !backend->context)
+        return;
+    UA_EventMemoryContext *ctx = (UA_EventMemoryContext*)backend->context;
+    for(size_t i = 0; i < ctx->emittersSize; i++)
+        UA_EventEmitter_memory_delete(ctx->emitters[i]);
+    UA_free(ctx->emitters);
+    UA_LOCK_DESTROY(&ctx->lock);
+    UA_free(ctx);
+    backend->context = NULL;
+}
+
+UA_HistoryEventBackend
+UA_HistoryEventBackend_Memory(UA_Duration partitionInterval, UA_Duration retention) {
+    UA_HistoryEventBackend result;
+    memset(&result, 0, sizeof(UA_HistoryEventBackend));
+    UA_EventMemoryContext *ctx = (UA_EventMemoryContext*)
+        UA_calloc(1, sizeof(UA_EventMemoryContext));
+    if(!ctx)
+        return result;
+    if(partitionInterval <= 0.0)
+        partitionInterval = EVENT_MEMORY_PARTITION_INTERVAL;
+    ctx->interval = (UA_Int64)(partitionInterval * UA_DATETIME_MSEC);
+    if(ctx->interval <= 0)
+        ctx->interval = 1;
+    ctx->retention = (retention > 0.0) ? (UA_Int64)(retention * UA_DATETIME_MSEC) : 0;
+    UA_LOCK_INIT(&ctx->lock);
+    result.context = ctx;
+    result.deleteMembers = &deleteMembers_backend_memory;
+    result.setEvent = &setEvent_backend_memory;
+    result.getEvents = &getEvents_backend_memory;
+    return result;
+}
+
+void
+UA_HistoryEventBackend_Memory_clear(UA_HistoryEventBackend *backend) {
+    deleteMembers_backend_memory(backend);
+}
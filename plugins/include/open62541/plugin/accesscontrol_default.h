@@ -30,7 +30,11 @@ typedef UA_StatusCode (*UA_UsernamePasswordLoginCallback)
  * cannot be used for other purposes.
  *
  * The certificate verification plugin lifecycle is moved to the access control
- * system. So it is cleared up eventually together with the AccessControl. */
+ * system. So it is cleared up eventually together with the AccessControl.
+ *
+ * Applications that replace the node-based callbacks afterwards (for example to
+ * look up the rights in a directory service) can set ``cacheDecisions`` in the
+ * AccessControl to have the server remember the decisions per session. */
 UA_EXPORT UA_StatusCode
 UA_AccessControl_default(UA_ServerConfig *config,
                          UA_Boolean allowAnonymous,
@@ -50,6 +50,44 @@ struct UA_HistoryDataBackend {
                             UA_Boolean historizing,
                             const UA_DataValue *value);
 
+    /* This optional function is the fast path of serverSetHistoryData. The
+     * gathering caches a pointer to the backend's context for the node and
+     * passes it in nodeContext. If *nodeContext is NULL, the backend looks up
+     * the node and sets *nodeContext. The pointer must remain valid for the
+     * lifetime of the backend. So no lookup happens for the following values
+     * of the node.
+     *
+     * The other arguments are the same as for serverSetHistoryData. */
+    UA_StatusCode
+    (*serverSetHistoryDataCached)(UA_Server *server,
+                                  void *hdbContext,
+                                  const UA_NodeId *sessionId,
+                                  void *sessionContext,
+                                  const UA_NodeId *nodeId,
+                                  void **nodeContext,
+                                  UA_Boolean historizing,
+                                  const UA_DataValue *value);
+
+    /* This optional function stores a batch of DataValues. It is used by the
+     * asynchronous gathering (see UA_HistoryDataGathering_Async) instead of
+     * serverSetHistoryData. With multithreading enabled, it is called from a
+     * background thread concurrently to the other functions of the backend.
+     * Set it only if the backend synchronizes internally.
+     *
+     * server is the server the nodes live in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * valuesSize is the number of values in the batch.
+     * nodeIds are the nodes for which the values shall be stored.
+     * values are the values which shall be stored, in the order of arrival.
+     * results are set to the StatusCode for each value. */
+    void
+    (*setHistoryDataBatch)(UA_Server *server,
+                           void *hdbContext,
+                           size_t valuesSize,
+                           const UA_NodeId *nodeIds,
+                           const UA_DataValue *values,
+                           UA_StatusCode *results);
+
     /* This function is the high level interface for the ReadRaw operation. Set
      * it to NULL if you use the low level API for your plugin. It should be
      * used if the low level interface does not suite your database. It is more
@@ -187,6 +225,8 @@ struct UA_HistoryDataBackend {
      * range is the numeric range which shall be copied for every data value.
      * releaseContinuationPoints determines if the continuation points shall be released.
      * continuationPoint is a continuation point the client wants to release or start from.
+     *                   It should let the backend continue without walking the
+     *                   values that were already copied.
      * outContinuationPoint is a continuation point which will be passed to the client.
      * providedValues contains the number of values that were copied.
      * values contains the values that have been copied from the database. */
@@ -284,6 +324,29 @@ struct UA_HistoryDataBackend {
                        const UA_NodeId *nodeId,
                        UA_DateTime startTimestamp,
                        UA_DateTime endTimestamp);
+
+    /* This optional function inserts many values into the history of a node.
+     * It is used by the HistoryUpdate service for inserts with more than one
+     * value instead of calling insertDataValue for each value. The result for
+     * each value must be the same as with insertDataValue called in the order
+     * of the values.
+     *
+     * server is the server the node lives in.
+     * hdbContext is the context of the UA_HistoryDataBackend.
+     * sessionId and sessionContext identify the session that wants to insert.
+     * nodeId is the node id of the node for which the values shall be inserted.
+     * valuesSize is the number of values.
+     * values are the values which shall be inserted. They need not be sorted.
+     * results are set to the StatusCode for each value. */
+    void
+    (*insertDataValues)(UA_Server *server,
+                        void *hdbContext,
+                        const UA_NodeId *sessionId,
+                        void *sessionContext,
+                        const UA_NodeId *nodeId,
+                        size_t valuesSize,
+                        const UA_DataValue *values,
+                        UA_StatusCode *results);
 };
 
 _UA_END_DECLS
@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYDATABACKEND_FILE_H_
+#define UA_HISTORYDATABACKEND_FILE_H_
+
+#include "history_data_backend.h"
+
+_UA_BEGIN_DECLS
+
+#define FILE_BACKEND_SYNC_INTERVAL 1000 /* ms */
+
+/* This function constructs a UA_HistoryDataBackend which persists the history
+ * in files. It is only available on Linux and Unices.
+ *
+ * The binary encoded DataValues of every node are appended to a segment file
+ * <directory>/<nodeid>.seg. A sparse index <directory>/<nodeid>.idx holds the
+ * timestamp and file offset of every 16th value. Both files are memory-mapped
+ * for reading. A torn write at the end of the segment is cut off and the
+ * index is rebuilt when the files are opened again.
+ *
+ * New values are collected in memory and written in batches. The files are
+ * synced with fsync at most every syncInterval milliseconds. With
+ * multithreading enabled, the sync runs in a background thread. Otherwise it
+ * is done during the write operations and with
+ * UA_HistoryDataBackend_File_flush.
+ *
+ * Values arriving out of order and the HistoryUpdate operations rewrite the
+ * segment of the node. They are much slower than appending.
+ *
+ * The backend synchronizes internally and implements setHistoryDataBatch for
+ * the asynchronous gathering.
+ *
+ * directory is the existing directory for the files.
+ * syncInterval is the maximum time in milliseconds between the writing of a
+ *              value and the sync. Zero selects FILE_BACKEND_SYNC_INTERVAL. */
+UA_HistoryDataBackend UA_EXPORT
+UA_HistoryDataBackend_File(const char *directory, UA_UInt32 syncInterval);
+
+/* Writes the pending values and syncs the files of all nodes */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_File_flush(UA_HistoryDataBackend *backend);
+
+/* Flushes and closes the files */
+void UA_EXPORT
+UA_HistoryDataBackend_File_clear(UA_HistoryDataBackend *backend);
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYDATABACKEND_FILE_H_ */
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYDATABACKEND_MEMORY_COMPRESSED_H_
+#define UA_HISTORYDATABACKEND_MEMORY_COMPRESSED_H_
+
+#include "history_data_backend.h"
+
+_UA_BEGIN_DECLS
+
+#define COMPRESSED_MEMORY_BLOCK_SIZE 256
+#define COMPRESSED_MEMORY_MAX_BLOCK_SIZE 4096
+
+/* This function constructs a UA_HistoryDataBackend which stores the history of
+ * scalar numeric values (Boolean, the integer types, Float and Double) in
+ * memory, column-wise and compressed.
+ *
+ * The samples of a node are kept in blocks of blockSize samples. The newest
+ * block is kept uncompressed until it is full. Then it is sealed and encoded as
+ * a bit stream with
+ * - delta-of-delta encoded timestamps,
+ * - server timestamps encoded as delta-of-delta offsets to the timestamps,
+ * - XOR (Gorilla) compressed values and
+ * - run-length encoded StatusCodes.
+ * A slowly changing Double sampled at a fixed rate needs a few bits per sample
+ * instead of a full UA_DataValue on the heap. Reading decodes only the blocks
+ * covered by the request.
+ *
+ * All values of a node must have the same DataType. Other values are rejected
+ * with UA_STATUSCODE_BADTYPEMISMATCH. The picoseconds of the timestamps are not
+ * stored.
+ *
+ * initialNodeIdStoreSize is the initial number of NodeIds that will be
+ *                        historized. The store grows if required.
+ * blockSize is the number of samples per block. Zero selects
+ *           COMPRESSED_MEMORY_BLOCK_SIZE. The size is limited to
+ *           COMPRESSED_MEMORY_MAX_BLOCK_SIZE. */
+UA_HistoryDataBackend UA_EXPORT
+UA_HistoryDataBackend_Memory_Compressed(size_t initialNodeIdStoreSize,
+                                        size_t blockSize);
+
+void UA_EXPORT
+UA_HistoryDataBackend_Memory_Compressed_clear(UA_HistoryDataBackend *backend);
+
+/* Returns the number of samples stored for a node and the number of bytes of
+ * heap memory used for them. */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_Memory_Compressed_getUsage(const UA_HistoryDataBackend *backend,
+                                                 const UA_NodeId *nodeId,
+                                                 size_t *samples, size_t *bytes);
+
+#if defined(__linux__) || defined(__unix__)
+
+/* This function constructs a compressed memory backend (see above) that keeps
+ * at most memoryLimit bytes of sealed blocks in memory. It is only available
+ * on Linux and Unices.
+ *
+ * Sealed blocks that were not accessed recently are evicted to a file (clock
+ * approximation of LRU). An evicted block is read back transparently when a
+ * request touches it. The open blocks with the newest samples always stay in
+ * memory. So the recent history is served from memory, while the memory used
+ * for older history is bounded.
+ *
+ * The file is created (or truncated) at path and removed by
+ * UA_HistoryDataBackend_Memory_Compressed_clear. Rewritten blocks are
+ * appended to the file. The space of their old copy is not reused.
+ *
+ * path is the path of the file for the evicted blocks.
+ * initialNodeIdStoreSize and blockSize are as for the compressed backend.
+ * memoryLimit is the maximum number of bytes of sealed blocks in memory. */
+UA_HistoryDataBackend UA_EXPORT
+UA_HistoryDataBackend_Memory_Tiered(const char *path, size_t initialNodeIdStoreSize,
+                                    size_t blockSize, size_t memoryLimit);
+
+typedef struct {
+    size_t hits;        /* Accesses to sealed blocks in memory */
+    size_t misses;      /* Accesses to sealed blocks read from the file */
+    size_t evictions;   /* Blocks evicted from memory */
+    size_t memoryBytes; /* Sealed blocks in memory */
+    size_t fileBytes;   /* Size of the file */
+} UA_HistoryDataBackend_TieredStatistics;
+
+UA_StatusCode UA_EXPORT
+UA_HistoryDataBackend_Memory_Tiered_getStatistics(const UA_HistoryDataBackend *backend,
+                                                  UA_HistoryDataBackend_TieredStatistics *stats);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYDATABACKEND_MEMORY_COMPRESSED_H_ */
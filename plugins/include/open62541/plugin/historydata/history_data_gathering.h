@@ -24,6 +24,31 @@ typedef enum {
                                                      equal to the old value. */
 } UA_HistorizingUpdateStrategy;
 
+/* Compression of the gathered values. Only scalar numeric values with a good
+ * StatusCode are compressed. Other values are always stored and restart the
+ * compression. A deviation of zero disables the respective stage.
+ *
+ * The exception deadband drops values that deviate less than
+ * exceptionDeviation from the last value that passed the deadband.
+ *
+ * The swinging-door trending then stores a value only if the straight line
+ * from the last stored value to the current value would deviate more than
+ * compressionDeviation from one of the values received in between. The values
+ * in between are dropped and can be reconstructed with the Interpolative
+ * aggregate.
+ *
+ * The last received value is held back until the next value decides whether
+ * it is stored. It is written out when the gathering settings of the node are
+ * updated or the polling is stopped. */
+typedef struct {
+    UA_Double exceptionDeviation;
+    UA_Double compressionDeviation;
+    UA_Double compressionMaxInterval; /* Store at least one value in this
+                                       * interval (in ms). Zero for no limit. */
+} UA_HistorizingCompression;
+
+/* Zero-initialize the settings before use. Members added later are then
+ * disabled by default. */
 typedef struct {
     UA_HistoryDataBackend historizingBackend; /* The database backend used for this node. */
     size_t maxHistoryDataResponseSize; /* The maximum number of values returned by the server in one response.
@@ -31,6 +56,8 @@ typedef struct {
     UA_HistorizingUpdateStrategy historizingUpdateStrategy; /* Defines how the values in the database will be updated.
                                                                See UA_HistorizingUpdateStrategy for details. */
     size_t pollingInterval; /* The polling interval for UA_HISTORIZINGUPDATESTRATEGY_POLL. */
+    UA_HistorizingCompression compression; /* Compression of the values before they
+                                            * are stored. See above. */
     void *userContext; /* A pointer to store your own settings. */
 } UA_HistorizingNodeIdSettings;
 
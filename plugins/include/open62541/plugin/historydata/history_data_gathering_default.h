@@ -23,6 +23,48 @@ UA_HistoryDataGathering_Default(size_t initialNodeIdStoreSize);
 UA_HistoryDataGathering UA_EXPORT
 UA_HistoryDataGathering_Circular(size_t initialNodeIdStoreSize);
 
+#define ASYNC_GATHERING_QUEUE_SIZE 65536
+#define ASYNC_GATHERING_BATCH_INTERVAL 100 /* ms */
+
+/* This function constructs a UA_HistoryDataGathering which stores the values
+ * asynchronously. The values of nodes whose backend implements
+ * setHistoryDataBatch are copied into a lock-free queue in the sampling
+ * callback. With multithreading enabled, a writer thread drains the queue in
+ * batches to the backends. Otherwise the queue is drained during the
+ * enqueueing once a batch is full or batchInterval has elapsed. The values of
+ * nodes with other backends are stored synchronously.
+ *
+ * If the queue is full, new values are dropped and counted in the
+ * statistics. The backends must remain valid until the gathering is deleted.
+ * The remaining values are written when the gathering is deleted.
+ *
+ * initialNodeIdStoreSize is the initial number of NodeIds that will be
+ *                        historized. The store grows if required.
+ * queueSize is the maximum number of queued values. Zero selects
+ *           ASYNC_GATHERING_QUEUE_SIZE.
+ * batchInterval is the maximum time in milliseconds a value waits in the
+ *               queue. Zero selects ASYNC_GATHERING_BATCH_INTERVAL. */
+UA_HistoryDataGathering UA_EXPORT
+UA_HistoryDataGathering_Async(size_t initialNodeIdStoreSize, size_t queueSize,
+                              UA_UInt32 batchInterval);
+
+/* Writes all queued values to the backends */
+UA_StatusCode UA_EXPORT
+UA_HistoryDataGathering_Async_flush(UA_HistoryDataGathering *gathering);
+
+typedef struct {
+    size_t queued;     /* Values currently waiting in the queue */
+    size_t dropped;    /* Values dropped because the queue was full */
+    size_t written;    /* Values handed to the backends */
+    size_t failed;     /* Values the backends did not accept */
+    size_t batches;    /* Calls of setHistoryDataBatch */
+    size_t maxBacklog; /* Most values found in the queue at once */
+} UA_HistoryDataGatheringStatistics;
+
+UA_StatusCode UA_EXPORT
+UA_HistoryDataGathering_Async_getStatistics(UA_HistoryDataGathering *gathering,
+                                            UA_HistoryDataGatheringStatistics *stats);
+
 _UA_END_DECLS
 
 #endif /* UA_HISTORYDATAGATHERING_DEFAULT_H_ */
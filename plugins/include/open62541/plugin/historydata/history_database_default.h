@@ -11,12 +11,30 @@
 #include <open62541/plugin/historydatabase.h>
 
 #include "history_data_gathering.h"
+#include "history_event_backend.h"
 
 _UA_BEGIN_DECLS
 
 UA_HistoryDatabase UA_EXPORT
 UA_HistoryDatabase_default(UA_HistoryDataGathering gathering);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* Also stores the historical events and serves ReadEvent requests. The events
+ * are filtered by the HistoricalEventFilter property of the emitter. Only the
+ * selected fields with a single-element browse path are stored. To make use of
+ * the index of the backend, the HistoricalEventFilter should select the Time,
+ * EventType and SourceNode. ReadEvent requires the HistoryRead bit in the
+ * EventNotifier of the emitter.
+ *
+ * eventBackend is the backend for the events. The database takes ownership.
+ * maxHistoryEventResponseSize is the maximum number of events per node in a
+ *                             response. Zero for no limit. */
+UA_HistoryDatabase UA_EXPORT
+UA_HistoryDatabase_default_events(UA_HistoryDataGathering gathering,
+                                  UA_HistoryEventBackend eventBackend,
+                                  size_t maxHistoryEventResponseSize);
+#endif
+
 _UA_END_DECLS
 
 #endif /* UA_HISTORYDATASERVICE_DEFAULT_H_ */
@@ -0,0 +1,80 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_PLUGIN_HISTORY_EVENT_BACKEND_H_
+#define UA_PLUGIN_HISTORY_EVENT_BACKEND_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/* A stored event is a map of its fields. The keys are the BrowseNames of the
+ * fields, e.g. 0:Time, 0:EventType, 0:SourceNode and 0:Severity. This is the
+ * same representation as for transient events (see
+ * UA_Server_triggerEventFields). The EventType, SourceNode and Time fields are
+ * used to index the events. */
+
+typedef struct UA_HistoryEventBackend UA_HistoryEventBackend;
+
+struct UA_HistoryEventBackend {
+    /* Context of the backend */
+    void *context;
+
+    void
+    (*deleteMembers)(UA_HistoryEventBackend *backend);
+
+    /* This function stores an event of an emitter. The backend takes ownership
+     * of the fields, also if an error is returned.
+     *
+     * server is the server the emitter lives in.
+     * hebContext is the context of the UA_HistoryEventBackend.
+     * emitterId is the node id of the node that emits the event.
+     * fields are the fields of the event. */
+    UA_StatusCode
+    (*setEvent)(UA_Server *server,
+                void *hebContext,
+                const UA_NodeId *emitterId,
+                UA_KeyValueMap *fields);
+
+    /* This function copies the events of an emitter with a Time between
+     * firstTime and lastTime (both included), ordered by their Time.
+     *
+     * server is the server the emitter lives in.
+     * hebContext is the context of the UA_HistoryEventBackend.
+     * emitterId is the node id of the node that emits the events.
+     * firstTime and lastTime define the time range.
+     * reverse returns the newest events first.
+     * eventTypes restricts the events to those with one of the EventTypes.
+     *            No restriction if eventTypesSize is zero. Subtypes are not
+     *            considered.
+     * sourceNodes restricts the events to those with one of the SourceNodes.
+     *             No restriction if sourceNodesSize is zero.
+     * maxEvents is the maximum number of events to copy.
+     * continuationPoint is the position to continue from. It is empty for the
+     *                   first call.
+     * outContinuationPoint is set if there are more events in the range.
+     * eventsSize and events are set to the copied events. The caller clears
+     *                   the maps and frees the array. */
+    UA_StatusCode
+    (*getEvents)(UA_Server *server,
+                 void *hebContext,
+                 const UA_NodeId *emitterId,
+                 UA_DateTime firstTime,
+                 UA_DateTime lastTime,
+                 UA_Boolean reverse,
+                 size_t eventTypesSize,
+                 const UA_NodeId *eventTypes,
+                 size_t sourceNodesSize,
+                 const UA_NodeId *sourceNodes,
+                 size_t maxEvents,
+                 const UA_ByteString *continuationPoint,
+                 UA_ByteString *outContinuationPoint,
+                 size_t *eventsSize,
+                 UA_KeyValueMap **events);
+};
+
+_UA_END_DECLS
+
+#endif /* UA_PLUGIN_HISTORY_EVENT_BACKEND_H_ */
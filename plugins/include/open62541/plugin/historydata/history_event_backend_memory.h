@@ -0,0 +1,35 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_HISTORYEVENTBACKEND_MEMORY_H_
+#define UA_HISTORYEVENTBACKEND_MEMORY_H_
+
+#include "history_event_backend.h"
+
+_UA_BEGIN_DECLS
+
+#define EVENT_MEMORY_PARTITION_INTERVAL 3600000.0 /* ms, one hour */
+
+/* This function constructs a UA_HistoryEventBackend which stores the events
+ * in memory.
+ *
+ * The events of an emitter are partitioned by their Time. A query only visits
+ * the partitions of its time range. Every partition indexes its events by
+ * EventType and by SourceNode. A query restricted to EventTypes or SourceNodes
+ * only visits the indexed events. Old partitions are dropped as a whole.
+ *
+ * partitionInterval is the time range covered by a partition in milliseconds.
+ *                   Zero selects EVENT_MEMORY_PARTITION_INTERVAL.
+ * retention is the time in milliseconds for which events are kept, relative
+ *           to the newest event of the emitter. Zero keeps all events. */
+UA_HistoryEventBackend UA_EXPORT
+UA_HistoryEventBackend_Memory(UA_Duration partitionInterval, UA_Duration retention);
+
+void UA_EXPORT
+UA_HistoryEventBackend_Memory_clear(UA_HistoryEventBackend *backend);
+
+_UA_END_DECLS
+
+#endif /* UA_HISTORYEVENTBACKEND_MEMORY_H_ */
@@ -0,0 +1,54 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_LOG_ASYNC_H_
+#define UA_LOG_ASYNC_H_
+
+#include <open62541/types.h>
+#include <open62541/plugin/log.h>
+
+_UA_BEGIN_DECLS
+
+/* Asynchronous Logger
+ * -------------------
+ * The logging thread only formats the message into a record (level, category,
+ * timestamp and message text) and pushes it into a lock-free ring buffer. A
+ * background thread takes the records from the ring buffer and writes them in
+ * batches to a file descriptor. The output has the same format as the stdout
+ * logger. Colors are used only if the file descriptor is a terminal.
+ *
+ * Logging never blocks. If the ring buffer is full, then the message is
+ * dropped and a counter is incremented. The writer thread reports the number
+ * of dropped messages in the log output. Messages longer than
+ * UA_LOG_ASYNC_MSGSIZE bytes are truncated.
+ *
+ * The asynchronous logger is available for POSIX with multithreading
+ * enabled. */
+
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+
+#define UA_LOG_ASYNC_MSGSIZE 256
+
+/* Returns a logger for messages up to the specified level that writes to the
+ * file descriptor (e.g. STDOUT_FILENO). The capacity (number of records in
+ * the ring buffer) is rounded up to a power of two. Use zero for the default
+ * of 1024 records. The _clear method of the logger writes the remaining
+ * records, stops the background thread and frees the memory. The file
+ * descriptor is not closed. */
+UA_EXPORT UA_Logger *
+UA_Log_Async_new(UA_LogLevel minlevel, int fd, size_t capacity);
+
+/* Blocks until all records that were logged before the call are written */
+UA_EXPORT void
+UA_Log_Async_flush(const UA_Logger *logger);
+
+/* Number of messages dropped so far because the ring buffer was full */
+UA_EXPORT UA_UInt64
+UA_Log_Async_getDropped(const UA_Logger *logger);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_LOG_ASYNC_H_ */
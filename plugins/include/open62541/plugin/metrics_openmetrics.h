@@ -0,0 +1,75 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_METRICS_OPENMETRICS_H_
+#define UA_METRICS_OPENMETRICS_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/* OpenMetrics Exporter
+ * --------------------
+ * Serves the server statistics in the OpenMetrics text format (as scraped by
+ * Prometheus) over HTTP. The exporter listens on a separate TCP port with the
+ * TCP ConnectionManager of the server EventLoop. Every GET request for
+ * ``/metrics`` is answered with the current values and the connection is
+ * closed afterwards.
+ *
+ * The exported metrics are:
+ *
+ * - SecureChannels, Sessions and the internal counters (UA_ServerStatistics)
+ * - Subscriptions, MonitoredItems and the size of their queues
+ * - Request counts and latency histograms per service (if the
+ *   ``serviceStatistics`` are enabled in the server configuration)
+ * - EventLoop iterations, the time per phase and the timer lag distribution
+ *   (if the EventLoop implements ``getStatistics``)
+ * - Nodes and memory of the Nodestore (if the Nodestore implements
+ *   ``getStatistics``)
+ *
+ * The statistics are copied with short critical sections. The response is then
+ * encoded and sent in chunks without holding a lock. Counting the Nodestore
+ * iterates over all nodes. The Nodestore statistics are therefore cached and
+ * refreshed at most once per ``nodestoreInterval``.
+ *
+ * The exporter uses the server EventLoop. The start and stop methods must not
+ * be called concurrently to an iteration of the EventLoop. */
+
+typedef struct {
+    UA_UInt16 port;              /* Default: 9464 */
+    UA_String address;           /* Listen hostname. Empty for all
+                                  * interfaces. */
+    UA_Double nodestoreInterval; /* Minimum time in ms between two refreshes
+                                  * of the Nodestore statistics. Negative to
+                                  * disable the Nodestore metrics.
+                                  * Default: 60000 */
+} UA_OpenMetricsExporterConfig;
+
+typedef struct UA_OpenMetricsExporter UA_OpenMetricsExporter;
+
+/* The config can be NULL for the defaults. The address in the config is
+ * copied. */
+UA_EXPORT UA_OpenMetricsExporter *
+UA_OpenMetricsExporter_new(UA_Server *server,
+                           const UA_OpenMetricsExporterConfig *config);
+
+/* Opens the listen socket. If the EventLoop is not yet started (e.g. before
+ * UA_Server_run), then the socket is opened in the first iteration. */
+UA_EXPORT UA_StatusCode
+UA_OpenMetricsExporter_start(UA_OpenMetricsExporter *exporter);
+
+/* Closes the listen socket and the open connections. Closing completes in the
+ * following iterations of the EventLoop. Stopping the server also closes all
+ * connections. */
+UA_EXPORT void
+UA_OpenMetricsExporter_stop(UA_OpenMetricsExporter *exporter);
+
+/* Stops the exporter. The memory is released once all connections are
+ * closed. */
+UA_EXPORT void
+UA_OpenMetricsExporter_delete(UA_OpenMetricsExporter *exporter);
+
+_UA_END_DECLS
+
+#endif /* UA_METRICS_OPENMETRICS_H_ */
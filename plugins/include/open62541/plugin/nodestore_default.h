@@ -18,6 +18,62 @@ _UA_BEGIN_DECLS
 UA_EXPORT UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns);
 
+/* Make a HashMap Nodestore read-only. Nodes of a frozen Nodestore are no longer
+ * reference-counted. So it can be read concurrently by several layered
+ * Nodestores (also from different threads). Insert, replace and remove return
+ * UA_STATUSCODE_BADNOTWRITABLE afterwards. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMap_freeze(UA_Nodestore *ns);
+
+/* A HashMap Nodestore layered on top of a frozen HashMap Nodestore. The nodes
+ * of the base are visible in the layered Nodestore. Nodes that are added,
+ * replaced or removed at runtime only change the layered Nodestore. Replaced
+ * nodes from the base are shadowed by the new version, removed nodes are
+ * hidden. The base is not cleared with the layered Nodestore and has to
+ * outlive it. Use this to set up the static nodes (e.g. namespace zero) once
+ * and share them between several server instances. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMapLayered(UA_Nodestore *ns, const UA_Nodestore *base);
+
+/* A refcounted image of a frozen HashMap Nodestore together with the custom
+ * DataTypes used by its nodes. Layered Nodestores created from the image hold
+ * a reference. So the image is freed when the last server using it is deleted
+ * and after the creator has released its own reference.
+ *
+ * _new freezes the Nodestore and takes ownership of it and of the custom
+ * DataTypes (may be NULL). The Nodestore is zeroed out. Returns NULL if the
+ * Nodestore is not a HashMap or cannot be frozen. The caller holds the first
+ * reference. */
+typedef struct UA_NodestoreImage UA_NodestoreImage;
+
+UA_EXPORT UA_NodestoreImage *
+UA_NodestoreImage_new(UA_Nodestore *ns, const UA_DataTypeArray *customTypes);
+
+UA_EXPORT const UA_DataTypeArray *
+UA_NodestoreImage_getCustomDataTypes(const UA_NodestoreImage *image);
+
+UA_EXPORT void
+UA_NodestoreImage_release(UA_NodestoreImage *image);
+
+/* A layered HashMap Nodestore on top of the image. Holds a reference to the
+ * image until the Nodestore is cleared. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMapImage(UA_Nodestore *ns, UA_NodestoreImage *image);
+
+/* Keep the nodes of a namespace in a compact binary encoding. The nodes are
+ * decoded when they are accessed. At most cacheSize decoded nodes are kept
+ * (zero for no limit). The least recently used decoded node is encoded again
+ * when the limit is reached. Nodes that are edited stay decoded. Use this for
+ * large namespaces that are rarely browsed, e.g. namespace zero. Call after
+ * the nodes are added and before the server is started.
+ *
+ * Only nodes without a context, callbacks or custom value types are compacted.
+ * Returns UA_STATUSCODE_BADNOTSUPPORTED for builds with concurrent readers and
+ * UA_STATUSCODE_BADNOTWRITABLE for a frozen Nodestore. */
+UA_EXPORT UA_StatusCode
+UA_Nodestore_HashMap_compact(UA_Nodestore *ns, UA_UInt16 namespaceIndex,
+                             size_t cacheSize);
+
 /* The ZipTree Nodestore holds all nodes in RAM in a tree structure. The lookup
  * time is about O(log n). Adding/removing nodes does not require resizing of
  * the underlying array with the linear overhead.
@@ -0,0 +1,98 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_PROCESSIMAGE_H_
+#define UA_PROCESSIMAGE_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/* Process Image in Shared Memory
+ * ------------------------------
+ * A process image is a region of POSIX shared memory (shm_open) that holds
+ * the current values of many variables. For example the inputs and outputs of
+ * a PLC. The region starts with a UA_ProcessImageHeader, followed by the data
+ * bytes. The writer (for example the PLC runtime in another process) publishes
+ * a new process image with a sequence lock:
+ *
+ *   UA_ProcessImage_beginWrite(pi);
+ *   ... write into UA_ProcessImage_data(pi) ...
+ *   UA_ProcessImage_endWrite(pi);
+ *
+ * The sequence counter is odd while a write is ongoing. There must be only
+ * one writer at a time. Writers that do not link against open62541 can
+ * implement the same protocol on the header layout below.
+ *
+ * Variable nodes are mapped to an offset in the data region. The reads (and
+ * samples for MonitoredItems) of mapped variables come from a snapshot of the
+ * entire data region. The snapshot is renewed only if the writer published a
+ * new process image in the meantime. So all values of the same process image
+ * are consistent with each other. The source timestamp is the time of the
+ * last publication. The server never blocks on the writer. If no consistent
+ * snapshot can be taken after a few attempts, then the read returns the
+ * status BadResourceUnavailable.
+ *
+ * The process image is available for POSIX. */
+
+#if defined(UA_ARCHITECTURE_POSIX)
+
+#define UA_PROCESSIMAGE_MAGIC 0x55415049 /* "UAPI" */
+
+typedef struct {
+    UA_UInt32 magic;
+    UA_UInt32 size;              /* Size of the data region in bytes */
+    volatile UA_UInt64 sequence; /* Odd while a write is ongoing */
+    UA_DateTime timestamp;       /* Time of the last publication */
+} UA_ProcessImageHeader;
+
+struct UA_ProcessImage;
+typedef struct UA_ProcessImage UA_ProcessImage;
+
+/* Open the shared memory region with the name (e.g. "/plc1", see shm_open).
+ * With create, a new region with size bytes of data is created (or an
+ * existing region is reset). Otherwise an existing region is opened and its
+ * data region must have at least size bytes. */
+UA_EXPORT UA_StatusCode
+UA_ProcessImage_open(const char *name, size_t size, UA_Boolean create,
+                     UA_ProcessImage **pi);
+
+/* Unmaps the region. The shared memory object is removed with unlink. Close
+ * the process image only after all mapped variables were deleted (or the
+ * server was deleted). */
+UA_EXPORT void
+UA_ProcessImage_close(UA_ProcessImage *pi, UA_Boolean unlink);
+
+/* Pointer to the data region for the writer */
+UA_EXPORT void *
+UA_ProcessImage_data(UA_ProcessImage *pi);
+
+UA_EXPORT void
+UA_ProcessImage_beginWrite(UA_ProcessImage *pi);
+
+/* Publish the changes and set the timestamp to the current time */
+UA_EXPORT void
+UA_ProcessImage_endWrite(UA_ProcessImage *pi);
+
+/* Copy a consistent snapshot of the entire data region to dst */
+UA_EXPORT UA_StatusCode
+UA_ProcessImage_read(UA_ProcessImage *pi, void *dst);
+
+/* Map the value of a variable node to the data region at the offset. The
+ * DataType must have a fixed size without pointers (e.g. the numerical types,
+ * Boolean and DateTime). For an arrayLength > 0, the variable is an array of
+ * that length. Otherwise it is a scalar.
+ *
+ * The variable gets a DataSource backend and the node context is replaced by
+ * the mapping. Writing to the variable via OPC UA is not supported. */
+UA_EXPORT UA_StatusCode
+UA_ProcessImage_addVariable(UA_ProcessImage *pi, UA_Server *server,
+                            const UA_NodeId nodeId, size_t offset,
+                            const UA_DataType *type, size_t arrayLength);
+
+#endif
+
+_UA_END_DECLS
+
+#endif /* UA_PROCESSIMAGE_H_ */
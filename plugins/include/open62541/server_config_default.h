@@ -11,6 +11,7 @@
 #define UA_SERVER_CONFIG_DEFAULT_H_
 
 #include <open62541/server.h>
+#include <open62541/plugin/nodestore_default.h>
 
 _UA_BEGIN_DECLS
 
@@ -259,6 +260,30 @@ UA_ServerConfig_addAllEndpoints(UA_ServerConfig *config);
 UA_EXPORT UA_StatusCode
 UA_ServerConfig_addAllSecureEndpoints(UA_ServerConfig *config);
 
+/* Uses a shared Nodestore image for the nodes and custom DataTypes of the
+ * config. The previous Nodestore and custom DataTypes are cleaned up. Call
+ * before the server is created with UA_Server_newWithConfig. Only the nodes
+ * that are added or changed by the server instance are held by its Nodestore.
+ *
+ * @param config The configuration to manipulate
+ * @param image The image. The config takes an own reference.
+ */
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_setNodestoreImage(UA_ServerConfig *config,
+                                  UA_NodestoreImage *image);
+
+/* Moves the nodes and custom DataTypes of a server into a new image. The server
+ * continues with a layered Nodestore on top of it. Create the image right after
+ * UA_Server_new and before the server is started. Additional namespaces are
+ * not registered in the servers using the image.
+ *
+ * Several server instances (e.g. sharing an external EventLoop) can then be
+ * created from the image without a copy of namespace zero each. Returns NULL
+ * if the server does not use a HashMap Nodestore. The caller has to release
+ * the returned reference. */
+UA_EXPORT UA_NodestoreImage *
+UA_Server_createNodestoreImage(UA_Server *server);
+
 _UA_END_DECLS
 
 #endif /* UA_SERVER_CONFIG_DEFAULT_H_ */
@@ -13,6 +13,8 @@
 
 _UA_BEGIN_DECLS
 
+#ifdef UA_ENABLE_JSON_ENCODING
+
 /* Loads the server configuration from a Json5 file into the server.
  *
  * @param json The configuration in json5 format.
@@ -28,6 +30,39 @@ UA_Server_newFromFile(const UA_ByteString json_config);
 UA_EXPORT UA_StatusCode
 UA_ServerConfig_updateFromFile(UA_ServerConfig *config, const UA_ByteString json_config);
 
+/* Converts the Json5 configuration into the compact binary configuration. The
+ * certificates and private keys of the SecurityPolicies and the certificates
+ * in the PKI folders are read from the file system and embedded. So the binary
+ * configuration contains secrets and has to be protected like the private key
+ * files. Only the settings that differ from the default configuration are
+ * written. Use this at build time. The target then loads the configuration
+ * without the Json5 parser and without file system access.
+ *
+ * @param json_config The configuration in json5 format.
+ * @param binary_config The encoded binary configuration. */
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_jsonToBinary(const UA_ByteString json_config,
+                             UA_ByteString *binary_config);
+
+#endif
+
+/* Loads the binary server configuration from UA_ServerConfig_jsonToBinary
+ * into a new server. The settings are decoded directly into the fields of the
+ * default server configuration.
+ *
+ * @param binary_config The binary configuration. */
+UA_EXPORT UA_Server *
+UA_Server_newFromBinaryConfig(const UA_ByteString binary_config);
+
+/* Updates the server configuration with the settings of the binary
+ * configuration.
+ *
+ * @param config The server configuration.
+ * @param binary_config The binary configuration. */
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_updateFromBinary(UA_ServerConfig *config,
+                                 const UA_ByteString binary_config);
+
 _UA_END_DECLS
 
 #endif //UA_SERVER_CONFIG_FILE_BASED_H
@@ -311,6 +311,9 @@ UA_AccessControl_default(UA_ServerConfig *config, UA_Boolean allowAnonymous,
     ac->allowAddReference = allowAddReference_default;
     ac->allowBrowseNode = allowBrowseNode_default;
 
+    /* The default decisions are constant. Caching them makes no difference. */
+    ac->cacheDecisions = false;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     ac->allowTransferSubscription = allowTransferSubscription_default;
 #endif
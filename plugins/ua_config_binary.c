@@ -0,0 +1,738 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/server_config_file_based.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/log_stdout.h>
+#ifdef UA_ENABLE_ENCRYPTION
+#include <open62541/plugin/certificategroup_default.h>
+#endif
+
+#include "ua_config_binary.h"
+
+#include <stddef.h>
+
+/* The binary configuration starts with a magic number and the format version.
+ * Then follows a sequence of records. Every record has a tag, the length of the
+ * payload and the payload in the OPC UA binary encoding. The payload is decoded
+ * directly into the field of the server configuration. Records with an unknown
+ * tag are skipped. So a binary configuration can be loaded by builds where
+ * some features are disabled. */
+
+#define BINARYCONFIG_MAGIC 0x42435541 /* "UACB" */
+#define BINARYCONFIG_VERSION 1
+#define BINARYCONFIG_HEADERSIZE 8
+#define BINARYCONFIG_RECORDHEADERSIZE 6
+
+/* The tags must never change. Add new tags at the end. */
+enum {
+    TAG_BUILDINFO = 1,
+    TAG_APPLICATIONDESCRIPTION,
+    TAG_SHUTDOWNDELAY,
+    TAG_VERIFYREQUESTTIMESTAMP,
+    TAG_ALLOWEMPTYVARIABLES,
+    TAG_SERVERURLS,
+    TAG_TCPENABLED,
+    TAG_TCPBUFSIZE,
+    TAG_TCPMAXMSGSIZE,
+    TAG_TCPMAXCHUNKS,
+    TAG_SECURITYPOLICYNONEDISCOVERYONLY,
+    TAG_MODELLINGRULESONINSTANCES,
+    TAG_MAXSECURECHANNELS,
+    TAG_MAXSECURITYTOKENLIFETIME,
+    TAG_MAXSESSIONS,
+    TAG_MAXSESSIONTIMEOUT,
+    TAG_MAXNODESPERREAD,
+    TAG_MAXNODESPERWRITE,
+    TAG_MAXNODESPERMETHODCALL,
+    TAG_MAXNODESPERBROWSE,
+    TAG_MAXNODESPERREGISTERNODES,
+    TAG_MAXNODESPERTRANSLATEBROWSEPATHSTONODEIDS,
+    TAG_MAXNODESPERNODEMANAGEMENT,
+    TAG_MAXMONITOREDITEMSPERCALL,
+    TAG_MAXREFERENCESPERNODE,
+    TAG_BROWSECACHESIZE,
+    TAG_TRANSLATEBROWSEPATHCACHESIZE,
+    TAG_REVERSERECONNECTINTERVAL,
+    TAG_ASYNCOPERATIONTIMEOUT,
+    TAG_MAXASYNCOPERATIONQUEUESIZE,
+    TAG_ASYNCOPERATIONWORKERS,
+    TAG_DISCOVERYCLEANUPTIMEOUT,
+    TAG_MDNSENABLED,
+    TAG_MDNSCONFIG,
+    TAG_MDNSINTERFACEIP,
+    TAG_MDNSIPADDRESSLIST,
+    TAG_SUBSCRIPTIONSENABLED,
+    TAG_MAXSUBSCRIPTIONS,
+    TAG_MAXSUBSCRIPTIONSPERSESSION,
+    TAG_PUBLISHINGINTERVALLIMITS_MIN,
+    TAG_PUBLISHINGINTERVALLIMITS_MAX,
+    TAG_LIFETIMECOUNTLIMITS_MIN,
+    TAG_LIFETIMECOUNTLIMITS_MAX,
+    TAG_KEEPALIVECOUNTLIMITS_MIN,
+    TAG_KEEPALIVECOUNTLIMITS_MAX,
+    TAG_MAXNOTIFICATIONSPERPUBLISH,
+    TAG_ENABLERETRANSMISSIONQUEUE,
+    TAG_MAXRETRANSMISSIONQUEUESIZE,
+    TAG_MAXEVENTSPERNODE,
+    TAG_MAXMONITOREDITEMS,
+    TAG_MAXMONITOREDITEMSPERSUBSCRIPTION,
+    TAG_SAMPLINGINTERVALLIMITS_MIN,
+    TAG_SAMPLINGINTERVALLIMITS_MAX,
+    TAG_QUEUESIZELIMITS_MIN,
+    TAG_QUEUESIZELIMITS_MAX,
+    TAG_MAXPUBLISHREQPERSESSION,
+    TAG_PUBSUBENABLED,
+    TAG_ENABLEDELTAFRAMES,
+    TAG_ENABLEINFORMATIONMODELMETHODS,
+    TAG_HISTORIZINGENABLED,
+    TAG_ACCESSHISTORYDATACAPABILITY,
+    TAG_MAXRETURNDATAVALUES,
+    TAG_ACCESSHISTORYEVENTSCAPABILITY,
+    TAG_MAXRETURNEVENTVALUES,
+    TAG_INSERTDATACAPABILITY,
+    TAG_INSERTEVENTCAPABILITY,
+    TAG_INSERTANNOTATIONSCAPABILITY,
+    TAG_REPLACEDATACAPABILITY,
+    TAG_REPLACEEVENTCAPABILITY,
+    TAG_UPDATEDATACAPABILITY,
+    TAG_UPDATEEVENTCAPABILITY,
+    TAG_DELETERAWCAPABILITY,
+    TAG_DELETEEVENTCAPABILITY,
+    TAG_DELETEATTIMEDATACAPABILITY,
+    TAG_SERVICESTATISTICS,
+    TAG_ENDPOINTSCACHESIZE,
+    TAG_MAXREGISTEREDNODESPERSESSION,
+    TAG_MAXNEWSECURECHANNELSPERSECOND,
+    TAG_MAXPENDINGREQUESTSPERSESSION,
+    TAG_MAXPENDINGREQUESTS,
+    TAG_BULKREQUESTSLICESIZE,
+    TAG_BULKREQUESTTIMESLICE,
+    TAG_MODELCHANGEEVENTINTERVAL,
+    TAG_MAXMODELCHANGESPEREVENT,
+    TAG_LAZYINFORMATIONMODEL,
+    TAG_MAXBROWSECONTINUATIONPOINTSMEMORY,
+    TAG_BROWSERECURSIVEWORKERS,
+    TAG_SHAREDVALUEMINSIZE,
+
+    /* Security records with the embedded certificates and keys */
+    TAG_SECURITYPOLICY = 0x100,
+    TAG_SECURECHANNELPKI_TRUSTLIST,
+    TAG_SECURECHANNELPKI_ISSUERLIST,
+    TAG_SECURECHANNELPKI_REVOCATIONLIST,
+    TAG_SESSIONPKI_TRUSTLIST,
+    TAG_SESSIONPKI_ISSUERLIST,
+    TAG_SESSIONPKI_REVOCATIONLIST
+};
+
+typedef enum {
+    BINARYCONFIG_SCALAR,
+    BINARYCONFIG_ARRAY, /* Encoded as a Variant */
+    BINARYCONFIG_SIZE   /* size_t encoded as a UInt64 */
+} BinaryConfigFieldKind;
+
+typedef struct {
+    UA_UInt16 tag;
+    BinaryConfigFieldKind kind;
+    size_t offset;
+    size_t sizeOffset; /* Only for arrays */
+    const UA_DataType *type;
+} BinaryConfigField;
+
+#define SCALAR(TAG, FIELD, TYPE)                                        \
+    {TAG, BINARYCONFIG_SCALAR, offsetof(UA_ServerConfig, FIELD), 0,     \
+     &UA_TYPES[TYPE]}
+#define ARRAY(TAG, FIELD, SIZEFIELD, TYPE)                              \
+    {TAG, BINARYCONFIG_ARRAY, offsetof(UA_ServerConfig, FIELD),         \
+     offsetof(UA_ServerConfig, SIZEFIELD), &UA_TYPES[TYPE]}
+#define SIZE(TAG, FIELD)                                                \
+    {TAG, BINARYCONFIG_SIZE, offsetof(UA_ServerConfig, FIELD), 0,       \
+     &UA_TYPES[UA_TYPES_UINT64]}
+
+/* The same fields as in the Json5 configuration */
+static const BinaryConfigField binaryConfigFields[] = {
+    SCALAR(TAG_BUILDINFO, buildInfo, UA_TYPES_BUILDINFO),
+    SCALAR(TAG_APPLICATIONDESCRIPTION, applicationDescription,
+           UA_TYPES_APPLICATIONDESCRIPTION),
+    SCALAR(TAG_SHUTDOWNDELAY, shutdownDelay, UA_TYPES_DOUBLE),
+    SCALAR(TAG_VERIFYREQUESTTIMESTAMP, verifyRequestTimestamp, UA_TYPES_INT32),
+    SCALAR(TAG_ALLOWEMPTYVARIABLES, allowEmptyVariables, UA_TYPES_INT32),
+    ARRAY(TAG_SERVERURLS, serverUrls, serverUrlsSize, UA_TYPES_STRING),
+    SCALAR(TAG_TCPENABLED, tcpEnabled, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_TCPBUFSIZE, tcpBufSize, UA_TYPES_UINT32),
+    SCALAR(TAG_TCPMAXMSGSIZE, tcpMaxMsgSize, UA_TYPES_UINT32),
+    SCALAR(TAG_TCPMAXCHUNKS, tcpMaxChunks, UA_TYPES_UINT32),
+    SCALAR(TAG_SECURITYPOLICYNONEDISCOVERYONLY, securityPolicyNoneDiscoveryOnly,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MODELLINGRULESONINSTANCES, modellingRulesOnInstances,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MAXSECURECHANNELS, maxSecureChannels, UA_TYPES_UINT16),
+    SCALAR(TAG_MAXSECURITYTOKENLIFETIME, maxSecurityTokenLifetime, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXSESSIONS, maxSessions, UA_TYPES_UINT16),
+    SCALAR(TAG_MAXSESSIONTIMEOUT, maxSessionTimeout, UA_TYPES_DOUBLE),
+    SCALAR(TAG_MAXNODESPERREAD, maxNodesPerRead, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERWRITE, maxNodesPerWrite, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERMETHODCALL, maxNodesPerMethodCall, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERBROWSE, maxNodesPerBrowse, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERREGISTERNODES, maxNodesPerRegisterNodes, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERTRANSLATEBROWSEPATHSTONODEIDS,
+           maxNodesPerTranslateBrowsePathsToNodeIds, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNODESPERNODEMANAGEMENT, maxNodesPerNodeManagement, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXMONITOREDITEMSPERCALL, maxMonitoredItemsPerCall, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXREFERENCESPERNODE, maxReferencesPerNode, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXBROWSECONTINUATIONPOINTSMEMORY, maxBrowseContinuationPointsMemory,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_BULKREQUESTSLICESIZE, bulkRequestSliceSize, UA_TYPES_UINT32),
+    SCALAR(TAG_BULKREQUESTTIMESLICE, bulkRequestTimeSlice, UA_TYPES_DOUBLE),
+    SCALAR(TAG_BROWSECACHESIZE, browseCacheSize, UA_TYPES_UINT32),
+    SCALAR(TAG_TRANSLATEBROWSEPATHCACHESIZE, translateBrowsePathCacheSize,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_REVERSERECONNECTINTERVAL, reverseReconnectInterval, UA_TYPES_UINT32),
+    SCALAR(TAG_SERVICESTATISTICS, serviceStatistics, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_ENDPOINTSCACHESIZE, endpointsCacheSize, UA_TYPES_UINT32),
+    SCALAR(TAG_SHAREDVALUEMINSIZE, sharedValueMinSize, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXREGISTEREDNODESPERSESSION, maxRegisteredNodesPerSession,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNEWSECURECHANNELSPERSECOND, maxNewSecureChannelsPerSecond,
+           UA_TYPES_UINT16),
+#if UA_MULTITHREADING >= 100
+    SCALAR(TAG_ASYNCOPERATIONTIMEOUT, asyncOperationTimeout, UA_TYPES_DOUBLE),
+    SIZE(TAG_MAXASYNCOPERATIONQUEUESIZE, maxAsyncOperationQueueSize),
+    SCALAR(TAG_ASYNCOPERATIONWORKERS, asyncOperationWorkers, UA_TYPES_UINT16),
+    SCALAR(TAG_BROWSERECURSIVEWORKERS, browseRecursiveWorkers, UA_TYPES_UINT16),
+    SCALAR(TAG_MAXPENDINGREQUESTSPERSESSION, maxPendingRequestsPerSession,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_MAXPENDINGREQUESTS, maxPendingRequests, UA_TYPES_UINT32),
+#endif
+#ifdef UA_ENABLE_DISCOVERY
+    SCALAR(TAG_DISCOVERYCLEANUPTIMEOUT, discoveryCleanupTimeout, UA_TYPES_UINT32),
+# ifdef UA_ENABLE_DISCOVERY_MULTICAST
+    SCALAR(TAG_MDNSENABLED, mdnsEnabled, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MDNSCONFIG, mdnsConfig, UA_TYPES_MDNSDISCOVERYCONFIGURATION),
+    SCALAR(TAG_MDNSINTERFACEIP, mdnsInterfaceIP, UA_TYPES_STRING),
+#  if !defined(UA_HAS_GETIFADDR)
+    ARRAY(TAG_MDNSIPADDRESSLIST, mdnsIpAddressList, mdnsIpAddressListSize,
+          UA_TYPES_UINT32),
+#  endif
+# endif
+#endif
+    SCALAR(TAG_SUBSCRIPTIONSENABLED, subscriptionsEnabled, UA_TYPES_BOOLEAN),
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    SCALAR(TAG_MAXSUBSCRIPTIONS, maxSubscriptions, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXSUBSCRIPTIONSPERSESSION, maxSubscriptionsPerSession,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_PUBLISHINGINTERVALLIMITS_MIN, publishingIntervalLimits.min,
+           UA_TYPES_DOUBLE),
+    SCALAR(TAG_PUBLISHINGINTERVALLIMITS_MAX, publishingIntervalLimits.max,
+           UA_TYPES_DOUBLE),
+    SCALAR(TAG_LIFETIMECOUNTLIMITS_MIN, lifeTimeCountLimits.min, UA_TYPES_UINT32),
+    SCALAR(TAG_LIFETIMECOUNTLIMITS_MAX, lifeTimeCountLimits.max, UA_TYPES_UINT32),
+    SCALAR(TAG_KEEPALIVECOUNTLIMITS_MIN, keepAliveCountLimits.min, UA_TYPES_UINT32),
+    SCALAR(TAG_KEEPALIVECOUNTLIMITS_MAX, keepAliveCountLimits.max, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXNOTIFICATIONSPERPUBLISH, maxNotificationsPerPublish,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_ENABLERETRANSMISSIONQUEUE, enableRetransmissionQueue,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MAXRETRANSMISSIONQUEUESIZE, maxRetransmissionQueueSize,
+           UA_TYPES_UINT32),
+# ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    SCALAR(TAG_MAXEVENTSPERNODE, maxEventsPerNode, UA_TYPES_UINT32),
+    SCALAR(TAG_MODELCHANGEEVENTINTERVAL, modelChangeEventInterval,
+           UA_TYPES_DOUBLE),
+    SCALAR(TAG_MAXMODELCHANGESPEREVENT, maxModelChangesPerEvent,
+           UA_TYPES_UINT32),
+# endif
+    SCALAR(TAG_MAXMONITOREDITEMS, maxMonitoredItems, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXMONITOREDITEMSPERSUBSCRIPTION, maxMonitoredItemsPerSubscription,
+           UA_TYPES_UINT32),
+    SCALAR(TAG_SAMPLINGINTERVALLIMITS_MIN, samplingIntervalLimits.min,
+           UA_TYPES_DOUBLE),
+    SCALAR(TAG_SAMPLINGINTERVALLIMITS_MAX, samplingIntervalLimits.max,
+           UA_TYPES_DOUBLE),
+    SCALAR(TAG_QUEUESIZELIMITS_MIN, queueSizeLimits.min, UA_TYPES_UINT32),
+    SCALAR(TAG_QUEUESIZELIMITS_MAX, queueSizeLimits.max, UA_TYPES_UINT32),
+    SCALAR(TAG_MAXPUBLISHREQPERSESSION, maxPublishReqPerSession, UA_TYPES_UINT32),
+#endif
+    SCALAR(TAG_PUBSUBENABLED, pubsubEnabled, UA_TYPES_BOOLEAN),
+#ifdef UA_ENABLE_PUBSUB
+    SCALAR(TAG_ENABLEDELTAFRAMES, pubSubConfig.enableDeltaFrames, UA_TYPES_BOOLEAN),
+# ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    SCALAR(TAG_ENABLEINFORMATIONMODELMETHODS,
+           pubSubConfig.enableInformationModelMethods, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_LAZYINFORMATIONMODEL,
+           pubSubConfig.lazyInformationModel, UA_TYPES_BOOLEAN),
+# endif
+#endif
+    SCALAR(TAG_HISTORIZINGENABLED, historizingEnabled, UA_TYPES_BOOLEAN),
+#ifdef UA_ENABLE_HISTORIZING
+    SCALAR(TAG_ACCESSHISTORYDATACAPABILITY, accessHistoryDataCapability,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MAXRETURNDATAVALUES, maxReturnDataValues, UA_TYPES_UINT32),
+    SCALAR(TAG_ACCESSHISTORYEVENTSCAPABILITY, accessHistoryEventsCapability,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_MAXRETURNEVENTVALUES, maxReturnEventValues, UA_TYPES_UINT32),
+    SCALAR(TAG_INSERTDATACAPABILITY, insertDataCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_INSERTEVENTCAPABILITY, insertEventCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_INSERTANNOTATIONSCAPABILITY, insertAnnotationsCapability,
+           UA_TYPES_BOOLEAN),
+    SCALAR(TAG_REPLACEDATACAPABILITY, replaceDataCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_REPLACEEVENTCAPABILITY, replaceEventCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_UPDATEDATACAPABILITY, updateDataCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_UPDATEEVENTCAPABILITY, updateEventCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_DELETERAWCAPABILITY, deleteRawCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_DELETEEVENTCAPABILITY, deleteEventCapability, UA_TYPES_BOOLEAN),
+    SCALAR(TAG_DELETEATTIMEDATACAPABILITY, deleteAtTimeDataCapability,
+           UA_TYPES_BOOLEAN),
+#endif
+};
+
+#define BINARYCONFIG_FIELDS \
+    (sizeof(binaryConfigFields) / sizeof(BinaryConfigField))
+
+/************/
+/* Encoding */
+/************/
+
+typedef struct {
+    UA_ByteString buf; /* NULL data to only count the required length */
+    size_t pos;
+} BinaryConfigWriter;
+
+static UA_StatusCode
+writeValue(BinaryConfigWriter *w, const void *p, const UA_DataType *type) {
+    size_t len = UA_calcSizeBinary(p, type);
+    if(w->buf.data) {
+        UA_ByteString out = {len, &w->buf.data[w->pos]};
+        UA_StatusCode res = UA_encodeBinary(p, type, &out);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    w->pos += len;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+writeRecord(BinaryConfigWriter *w, UA_UInt16 tag,
+            const void *p, const UA_DataType *type) {
+    size_t len = UA_calcSizeBinary(p, type);
+    if(len > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    UA_UInt32 len32 = (UA_UInt32)len;
+    UA_StatusCode res = writeValue(w, &tag, &UA_TYPES[UA_TYPES_UINT16]);
+    res |= writeValue(w, &len32, &UA_TYPES[UA_TYPES_UINT32]);
+    res |= writeValue(w, p, type);
+    return res;
+}
+
+static UA_StatusCode
+writeArrayRecord(BinaryConfigWriter *w, UA_UInt16 tag, const void *array,
+                 size_t arraySize, const UA_DataType *type) {
+    UA_Variant v;
+    UA_Variant_setArray(&v, (void*)(uintptr_t)array, arraySize, type);
+    if(!v.data)
+        v.data = UA_EMPTY_ARRAY_SENTINEL;
+    return writeRecord(w, tag, &v, &UA_TYPES[UA_TYPES_VARIANT]);
+}
+
+static UA_Boolean
+fieldDiffers(const BinaryConfigField *f, const UA_ServerConfig *config,
+             const UA_ServerConfig *defaults) {
+    const UA_Byte *a = (const UA_Byte*)config + f->offset;
+    const UA_Byte *b = (const UA_Byte*)defaults + f->offset;
+    switch(f->kind) {
+    case BINARYCONFIG_SCALAR:
+        return (UA_order(a, b, f->type) != UA_ORDER_EQ);
+    case BINARYCONFIG_SIZE:
+        return (*(const size_t*)a != *(const size_t*)b);
+    case BINARYCONFIG_ARRAY:
+    default: {
+        size_t aSize = *(const size_t*)((const UA_Byte*)config + f->sizeOffset);
+        size_t bSize = *(const size_t*)((const UA_Byte*)defaults + f->sizeOffset);
+        if(aSize != bSize)
+            return true;
+        const UA_Byte *aArr = *(UA_Byte * const *)(uintptr_t)a;
+        const UA_Byte *bArr = *(UA_Byte * const *)(uintptr_t)b;
+        for(size_t i = 0; i < aSize; i++) {
+            if(UA_order(aArr + (i * f->type->memSize), bArr + (i * f->type->memSize),
+                        f->type) != UA_ORDER_EQ)
+                return true;
+        }
+        return false;
+    }
+    }
+}
+
+static UA_StatusCode
+writePki(BinaryConfigWriter *w, const BinaryConfigPki *pki, UA_UInt16 firstTag) {
+    if(!pki->set)
+        return UA_STATUSCODE_GOOD;
+    const UA_DataType *bsType = &UA_TYPES[UA_TYPES_BYTESTRING];
+    UA_StatusCode res =
+        writeArrayRecord(w, firstTag, pki->trustList, pki->trustListSize, bsType);
+    res |= writeArrayRecord(w, (UA_UInt16)(firstTag + 1), pki->issuerList,
+                            pki->issuerListSize, bsType);
+    res |= writeArrayRecord(w, (UA_UInt16)(firstTag + 2), pki->revocationList,
+                            pki->revocationListSize, bsType);
+    return res;
+}
+
+static UA_StatusCode
+writeBinaryConfig(BinaryConfigWriter *w, const UA_ServerConfig *config,
+                  const UA_ServerConfig *defaults,
+                  const BinaryConfigSecurity *sec) {
+    UA_UInt32 magic = BINARYCONFIG_MAGIC;
+    UA_UInt32 version = BINARYCONFIG_VERSION;
+    UA_StatusCode res = writeValue(w, &magic, &UA_TYPES[UA_TYPES_UINT32]);
+    res |= writeValue(w, &version, &UA_TYPES[UA_TYPES_UINT32]);
+
+    for(size_t i = 0; i < BINARYCONFIG_FIELDS; i++) {
+        const BinaryConfigField *f = &binaryConfigFields[i];
+        if(!fieldDiffers(f, config, defaults))
+            continue;
+        const UA_Byte *field = (const UA_Byte*)config + f->offset;
+        if(f->kind == BINARYCONFIG_SCALAR) {
+            res |= writeRecord(w, f->tag, field, f->type);
+        } else if(f->kind == BINARYCONFIG_SIZE) {
+            UA_UInt64 size = (UA_UInt64)*(const size_t*)field;
+            res |= writeRecord(w, f->tag, &size, f->type);
+        } else {
+            size_t size = *(const size_t*)((const UA_Byte*)config + f->sizeOffset);
+            res |= writeArrayRecord(w, f->tag, *(void * const *)(uintptr_t)field,
+                                    size, f->type);
+        }
+    }
+
+    if(!sec)
+        return res;
+
+    /* The policy uri, certificate and private key as a ByteString array */
+    for(size_t i = 0; i < sec->policiesSize; i++) {
+        const BinaryConfigPolicy *p = &sec->policies[i];
+        UA_ByteString policy[3] = {p->policyUri, p->certificate, p->privateKey};
+        res |= writeArrayRecord(w, TAG_SECURITYPOLICY, policy, 3,
+                                &UA_TYPES[UA_TYPES_BYTESTRING]);
+    }
+    res |= writePki(w, &sec->secureChannelPki, TAG_SECURECHANNELPKI_TRUSTLIST);
+    res |= writePki(w, &sec->sessionPki, TAG_SESSIONPKI_TRUSTLIST);
+    return res;
+}
+
+UA_StatusCode
+encodeBinaryConfig(const UA_ServerConfig *config, const UA_ServerConfig *defaults,
+                   const BinaryConfigSecurity *sec, UA_ByteString *out) {
+    /* Compute the length */
+    BinaryConfigWriter w;
+    memset(&w, 0, sizeof(BinaryConfigWriter));
+    UA_StatusCode res = writeBinaryConfig(&w, config, defaults, sec);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Encode */
+    res = UA_ByteString_allocBuffer(&w.buf, w.pos);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    w.pos = 0;
+    res = writeBinaryConfig(&w, config, defaults, sec);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&w.buf);
+        return res;
+    }
+    *out = w.buf;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+BinaryConfigPki_clear(BinaryConfigPki *pki) {
+    UA_Array_delete(pki->trustList, pki->trustListSize,
+                    &UA_TYPES[UA_TYPES_BYTESTRING]);
+    UA_Array_delete(pki->issuerList, pki->issuerListSize,
+                    &UA_TYPES[UA_TYPES_BYTESTRING]);
+    UA_Array_delete(pki->revocationList, pki->revocationListSize,
+                    &UA_TYPES[UA_TYPES_BYTESTRING]);
+    memset(pki, 0, sizeof(BinaryConfigPki));
+}
+
+void
+BinaryConfigSecurity_clear(BinaryConfigSecurity *sec) {
+    for(size_t i = 0; i < sec->policiesSize; i++) {
+        UA_String_clear(&sec->policies[i].policyUri);
+        UA_ByteString_clear(&sec->policies[i].certificate);
+        UA_ByteString_clear(&sec->policies[i].privateKey);
+    }
+    UA_free(sec->policies);
+    BinaryConfigPki_clear(&sec->secureChannelPki);
+    BinaryConfigPki_clear(&sec->sessionPki);
+    memset(sec, 0, sizeof(BinaryConfigSecurity));
+}
+
+/************/
+/* Decoding */
+/************/
+
+static const BinaryConfigField *
+findField(UA_UInt16 tag) {
+    for(size_t i = 0; i < BINARYCONFIG_FIELDS; i++) {
+        if(binaryConfigFields[i].tag == tag)
+            return &binaryConfigFields[i];
+    }
+    return NULL;
+}
+
+/* Decode a Variant array of the expected type. Moves the array out of the
+ * Variant. */
+static UA_StatusCode
+readArray(const UA_ByteString *payload, const UA_DataType *type,
+          void **array, size_t *arraySize) {
+    UA_Variant v;
+    UA_StatusCode res =
+        UA_decodeBinary(payload, &v, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(UA_Variant_isEmpty(&v)) {
+        *array = NULL;
+        *arraySize = 0;
+        return UA_STATUSCODE_GOOD;
+    }
+    if(v.type != type || UA_Variant_isScalar(&v)) {
+        UA_Variant_clear(&v);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+    *array = v.data;
+    *arraySize = v.arrayLength;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+readField(UA_ServerConfig *config, const BinaryConfigField *f,
+          const UA_ByteString *payload) {
+    UA_Byte *field = (UA_Byte*)config + f->offset;
+    if(f->kind == BINARYCONFIG_ARRAY) {
+        void *array;
+        size_t arraySize;
+        UA_StatusCode res = readArray(payload, f->type, &array, &arraySize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        size_t *fieldSize = (size_t*)((UA_Byte*)config + f->sizeOffset);
+        UA_Array_delete(*(void**)field, *fieldSize, f->type);
+        *(void**)field = array;
+        *fieldSize = arraySize;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Decode into a temporary value so that the field is unchanged if the
+     * decoding fails */
+    void *tmp = UA_new(f->type);
+    if(!tmp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_decodeBinary(payload, tmp, f->type, NULL);
+    if(res == UA_STATUSCODE_GOOD) {
+        if(f->kind == BINARYCONFIG_SIZE) {
+            *(size_t*)field = (size_t)*(UA_UInt64*)tmp;
+        } else {
+            UA_clear(field, f->type);
+            memcpy(field, tmp, f->type->memSize);
+        }
+    }
+    UA_free(tmp);
+    return res;
+}
+
+#ifdef UA_ENABLE_ENCRYPTION
+static UA_StatusCode
+addSecurityPolicy(UA_ServerConfig *config, const UA_String *policy,
+                  const UA_ByteString *certificate, const UA_ByteString *privateKey) {
+    UA_String noneuri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#None");
+    UA_String basic128Rsa15uri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic128Rsa15");
+    UA_String basic256uri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic256");
+    UA_String basic256Sha256uri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    UA_String aes128sha256rsaoaepuri = UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Aes128_Sha256_RsaOaep");
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(UA_String_equal(policy, &noneuri)) {
+        /* Nothing to do! */
+    } else if(UA_String_equal(policy, &basic128Rsa15uri)) {
+        res = UA_ServerConfig_addSecurityPolicyBasic128Rsa15(config, certificate, privateKey);
+    } else if(UA_String_equal(policy, &basic256uri)) {
+        res = UA_ServerConfig_addSecurityPolicyBasic256(config, certificate, privateKey);
+    } else if(UA_String_equal(policy, &basic256Sha256uri)) {
+        res = UA_ServerConfig_addSecurityPolicyBasic256Sha256(config, certificate, privateKey);
+    } else if(UA_String_equal(policy, &aes128sha256rsaoaepuri)) {
+        res = UA_ServerConfig_addSecurityPolicyAes128Sha256RsaOaep(config, certificate, privateKey);
+    } else {
+        UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_USERLAND,
+                       "Unknown Security Policy.");
+        return UA_STATUSCODE_GOOD;
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_USERLAND,
+                       "Could not add SecurityPolicy %.*s with error code %s",
+                       (int)policy->length, (const char*)policy->data,
+                       UA_StatusCode_name(res));
+    return res;
+}
+
+static UA_StatusCode
+setPki(UA_CertificateGroup *certGroup, const BinaryConfigPki *pki) {
+    if(!pki->set)
+        return UA_STATUSCODE_GOOD;
+    if(certGroup->clear)
+        certGroup->clear(certGroup);
+    return UA_CertificateVerification_Trustlist(certGroup,
+                                                pki->trustList, pki->trustListSize,
+                                                pki->issuerList, pki->issuerListSize,
+                                                pki->revocationList,
+                                                pki->revocationListSize);
+}
+#endif
+
+static UA_StatusCode
+readSecurityRecord(UA_ServerConfig *config, UA_UInt16 tag,
+                   const UA_ByteString *payload, UA_Boolean *policiesAdded,
+                   BinaryConfigPki *secureChannelPki, BinaryConfigPki *sessionPki) {
+#ifndef UA_ENABLE_ENCRYPTION
+    (void)tag, (void)payload, (void)policiesAdded;
+    (void)secureChannelPki, (void)sessionPki;
+    UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_USERLAND,
+                   "Encryption is not enabled. Skipping the security settings.");
+    return UA_STATUSCODE_GOOD;
+#else
+    void *array = NULL;
+    size_t arraySize = 0;
+    UA_StatusCode res =
+        readArray(payload, &UA_TYPES[UA_TYPES_BYTESTRING], &array, &arraySize);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_ByteString *bs = (UA_ByteString*)array;
+
+    if(tag == TAG_SECURITYPOLICY) {
+        if(arraySize == 3) {
+            res = addSecurityPolicy(config, &bs[0], &bs[1], &bs[2]);
+            *policiesAdded = true;
+        } else {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+        }
+        UA_Array_delete(array, arraySize, &UA_TYPES[UA_TYPES_BYTESTRING]);
+        return res;
+    }
+
+    BinaryConfigPki *pki = (tag < TAG_SESSIONPKI_TRUSTLIST) ?
+        secureChannelPki : sessionPki;
+    UA_UInt16 list = (UA_UInt16)((tag - TAG_SECURECHANNELPKI_TRUSTLIST) % 3);
+    pki->set = true;
+    if(list == 0) {
+        UA_Array_delete(pki->trustList, pki->trustListSize,
+                        &UA_TYPES[UA_TYPES_BYTESTRING]);
+        pki->trustList = bs;
+        pki->trustListSize = arraySize;
+    } else if(list == 1) {
+        UA_Array_delete(pki->issuerList, pki->issuerListSize,
+                        &UA_TYPES[UA_TYPES_BYTESTRING]);
+        pki->issuerList = bs;
+        pki->issuerListSize = arraySize;
+    } else {
+        UA_Array_delete(pki->revocationList, pki->revocationListSize,
+                        &UA_TYPES[UA_TYPES_BYTESTRING]);
+        pki->revocationList = bs;
+        pki->revocationListSize = arraySize;
+    }
+    return UA_STATUSCODE_GOOD;
+#endif
+}
+
+UA_StatusCode
+UA_ServerConfig_updateFromBinary(UA_ServerConfig *config,
+                                 const UA_ByteString binary_config) {
+    /* Check the header */
+    if(binary_config.length < BINARYCONFIG_HEADERSIZE)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_UInt32 magic = 0, version = 0;
+    UA_ByteString part = {4, binary_config.data};
+    UA_decodeBinary(&part, &magic, &UA_TYPES[UA_TYPES_UINT32], NULL);
+    part.data += 4;
+    UA_decodeBinary(&part, &version, &UA_TYPES[UA_TYPES_UINT32], NULL);
+    if(magic != BINARYCONFIG_MAGIC || version != BINARYCONFIG_VERSION) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_USERLAND,
+                     "Not a binary server configuration or unsupported version");
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
+    UA_Boolean policiesAdded = false;
+    BinaryConfigPki secureChannelPki, sessionPki;
+    memset(&secureChannelPki, 0, sizeof(BinaryConfigPki));
+    memset(&sessionPki, 0, sizeof(BinaryConfigPki));
+
+    /* Decode the records */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t pos = BINARYCONFIG_HEADERSIZE;
+    while(pos < binary_config.length) {
+        if(binary_config.length - pos < BINARYCONFIG_RECORDHEADERSIZE) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+        UA_UInt16 tag = 0;
+        UA_UInt32 len = 0;
+        part.data = &binary_config.data[pos];
+        part.length = 2;
+        UA_decodeBinary(&part, &tag, &UA_TYPES[UA_TYPES_UINT16], NULL);
+        part.data += 2;
+        part.length = 4;
+        UA_decodeBinary(&part, &len, &UA_TYPES[UA_TYPES_UINT32], NULL);
+        pos += BINARYCONFIG_RECORDHEADERSIZE;
+        if(binary_config.length - pos < len) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+
+        /* The payload points into the binary configuration */
+        UA_ByteString payload = {len, &binary_config.data[pos]};
+        pos += len;
+
+        if(tag >= TAG_SECURITYPOLICY && tag <= TAG_SESSIONPKI_REVOCATIONLIST) {
+            res = readSecurityRecord(config, tag, &payload, &policiesAdded,
+                                     &secureChannelPki, &sessionPki);
+        } else {
+            const BinaryConfigField *f = findField(tag);
+            if(!f) {
+                UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_USERLAND,
+                               "Skipping the unknown configuration record %u. "
+                               "Maybe the feature is not enabled.", (unsigned)tag);
+                continue;
+            }
+            res = readField(config, f, &payload);
+        }
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+#ifdef UA_ENABLE_ENCRYPTION
+    if(res == UA_STATUSCODE_GOOD)
+        res = setPki(&config->secureChannelPKI, &secureChannelPki);
+    if(res == UA_STATUSCODE_GOOD)
+        res = setPki(&config->sessionPKI, &sessionPki);
+    if(res == UA_STATUSCODE_GOOD && policiesAdded)
+        res = UA_ServerConfig_addAllEndpoints(config);
+#endif
+    BinaryConfigPki_clear(&secureChannelPki);
+    BinaryConfigPki_clear(&sessionPki);
+
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_USERLAND,
+                     "Could not load the binary configuration with error code %s",
+                     UA_StatusCode_name(res));
+    return res;
+}
+
+UA_Server *
+UA_Server_newFromBinaryConfig(const UA_ByteString binary_config) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_ServerConfig_setDefault(&config);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_ServerConfig_updateFromBinary(&config, binary_config);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ServerConfig_clean(&config);
+        return NULL;
+    }
+    return UA_Server_newWithConfig(&config);
+}
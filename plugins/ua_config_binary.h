@@ -0,0 +1,52 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#ifndef UA_CONFIG_BINARY_H_
+#define UA_CONFIG_BINARY_H_
+
+#include <open62541/server.h>
+
+_UA_BEGIN_DECLS
+
+/* Certificates, private keys and trust lists are referenced by file and folder
+ * names in the Json5 configuration. The converter loads the file contents and
+ * embeds them in the binary configuration. */
+
+typedef struct {
+    UA_String policyUri;
+    UA_ByteString certificate;
+    UA_ByteString privateKey;
+} BinaryConfigPolicy;
+
+typedef struct {
+    UA_Boolean set;
+    size_t trustListSize;
+    UA_ByteString *trustList;
+    size_t issuerListSize;
+    UA_ByteString *issuerList;
+    size_t revocationListSize;
+    UA_ByteString *revocationList;
+} BinaryConfigPki;
+
+typedef struct {
+    size_t policiesSize;
+    BinaryConfigPolicy *policies;
+    BinaryConfigPki secureChannelPki;
+    BinaryConfigPki sessionPki;
+} BinaryConfigSecurity;
+
+void
+BinaryConfigSecurity_clear(BinaryConfigSecurity *sec);
+
+/* Encode the binary configuration. Only the fields of config that differ from
+ * defaults are written. */
+UA_StatusCode
+encodeBinaryConfig(const UA_ServerConfig *config,
+                   const UA_ServerConfig *defaults,
+                   const BinaryConfigSecurity *sec,
+                   UA_ByteString *out);
+
+_UA_END_DECLS
+
+#endif /* UA_CONFIG_BINARY_H_ */
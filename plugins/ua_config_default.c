@@ -449,6 +449,10 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
     conf->maxSessions = 100;
     conf->maxSessionTimeout = 60.0 * 60.0 * 1000.0; /* 1h */
 
+    /* Scheduling of bulk requests */
+    conf->bulkRequestSliceSize = 0; /* disabled */
+    conf->bulkRequestTimeSlice = 5.0; /* 5ms per EventLoop iteration */
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* Limits for Subscriptions */
     conf->publishingIntervalLimits = UA_DURATIONRANGE(100.0, 3600.0 * 1000.0);
@@ -459,6 +463,11 @@ setDefaultConfig(UA_ServerConfig *conf, UA_UInt16 portNumber) {
     conf->maxRetransmissionQueueSize = 0; /* unlimited */
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     conf->maxEventsPerNode = 0; /* unlimited */
+    conf->modelChangeEventInterval = 0.0; /* disabled */
+    conf->maxModelChangesPerEvent = 1000;
+#endif
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    conf->maxConditionRefreshPerPublish = 0; /* all at once */
 #endif
 
     /* Limits for MonitoredItems */
@@ -623,6 +632,59 @@ UA_ServerConfig_addAllSecureEndpoints(UA_ServerConfig *config) {
     return UA_STATUSCODE_GOOD;
 }
 
+UA_EXPORT UA_StatusCode
+UA_ServerConfig_setNodestoreImage(UA_ServerConfig *config,
+                                  UA_NodestoreImage *image) {
+    UA_Nodestore ns;
+    memset(&ns, 0, sizeof(UA_Nodestore));
+    UA_StatusCode res = UA_Nodestore_HashMapImage(&ns, image);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Replace the Nodestore */
+    if(config->nodestore.context && config->nodestore.clear)
+        config->nodestore.clear(config->nodestore.context);
+    config->nodestore = ns;
+
+    /* Use the custom types of the image. They live as long as the image and
+     * thus longer than the nodes of the layered Nodestore. */
+    if(!config->externalCustomDataTypes)
+        UA_cleanupDataTypeWithCustom(config->customDataTypes);
+    config->customDataTypes = UA_NodestoreImage_getCustomDataTypes(image);
+    config->externalCustomDataTypes = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_EXPORT UA_NodestoreImage *
+UA_Server_createNodestoreImage(UA_Server *server) {
+    if(UA_Server_getLifecycleState(server) != UA_LIFECYCLESTATE_STOPPED)
+        return NULL;
+
+    /* Custom types that are owned elsewhere cannot be moved into the image */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    if(config->externalCustomDataTypes)
+        return NULL;
+
+    /* Move the nodes and types into the image */
+    UA_NodestoreImage *image =
+        UA_NodestoreImage_new(&config->nodestore, config->customDataTypes);
+    if(!image)
+        return NULL;
+    config->externalCustomDataTypes = true;
+
+    /* Continue the server on top of the image */
+    UA_StatusCode res = UA_ServerConfig_setNodestoreImage(config, image);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "Could not layer the Nodestore on top of the image "
+                     "with StatusCode %s", UA_StatusCode_name(res));
+        UA_NodestoreImage_release(image);
+        config->customDataTypes = NULL;
+        return NULL;
+    }
+    return image;
+}
+
 UA_EXPORT UA_StatusCode
 UA_ServerConfig_setMinimalCustomBuffer(UA_ServerConfig *config, UA_UInt16 portNumber,
                                        const UA_ByteString *certificate,
@@ -11,6 +11,12 @@
 #ifdef UA_ENABLE_ENCRYPTION
 #include "open62541/plugin/certificategroup_default.h"
 #endif
+#include "ua_config_binary.h"
+
+#if defined(UA_ENABLE_ENCRYPTION) && defined(__linux__)
+#include <dirent.h>
+#include <limits.h>
+#endif
 
 #define MAX_TOKENS 256
 
@@ -21,6 +27,10 @@ typedef struct {
     unsigned int tokensSize;
     size_t index;
     UA_Byte depth;
+    UA_ServerConfig *config;
+    /* If set, the certificates and keys are collected for the binary
+     * configuration instead of being added to the server configuration */
+    BinaryConfigSecurity *capture;
 } ParsingCtx;
 
 static UA_ByteString
@@ -48,6 +58,12 @@ typedef UA_StatusCode
 #ifdef UA_ENABLE_ENCRYPTION
 static UA_ByteString
 loadCertificateFile(const char *const path);
+
+#if defined(UA_ENABLE_ENCRYPTION) && defined(__linux__)
+static UA_StatusCode
+loadCertificateFolder(const UA_String folder, UA_ByteString **files,
+                      size_t *filesSize);
+#endif
 #endif
 
 /* The DataType "kind" is an internal type classification. It is used to
@@ -497,6 +513,10 @@ PARSE_JSON(SubscriptionConfigurationField) {
 # ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
             else if(strcmp(field_str, "maxEventsPerNode") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxEventsPerNode, NULL);
+            else if(strcmp(field_str, "modelChangeEventInterval") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](ctx, &config->modelChangeEventInterval, NULL);
+            else if(strcmp(field_str, "maxModelChangesPerEvent") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxModelChangesPerEvent, NULL);
 # endif
             else if(strcmp(field_str, "maxMonitoredItems") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](ctx, &config->maxMonitoredItems, NULL);
@@ -567,6 +587,8 @@ PARSE_JSON(PubsubConfigurationField) {
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
             else if(strcmp(field_str, "enableInformationModelMethods") == 0)
                 parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](ctx, &field->enableInformationModelMethods, NULL);
+            else if(strcmp(field_str, "lazyInformationModel") == 0)
+                parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](ctx, &field->lazyInformationModel, NULL);
 #endif
             else {
                 UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Unknown field name.");
@@ -708,6 +730,26 @@ PARSE_JSON(SecurityPolciesField) {
                 UA_ByteString_clear(&privateKey);
             return UA_STATUSCODE_BADINTERNALERROR;
         }
+
+        /* Keep the file contents for the binary configuration */
+        if(ctx->capture) {
+            BinaryConfigSecurity *sec = ctx->capture;
+            BinaryConfigPolicy *policies = (BinaryConfigPolicy*)
+                UA_realloc(sec->policies, (sec->policiesSize + 1) * sizeof(BinaryConfigPolicy));
+            if(!policies) {
+                UA_String_clear(&policy);
+                UA_ByteString_clear(&certificate);
+                UA_ByteString_clear(&privateKey);
+                return UA_STATUSCODE_BADOUTOFMEMORY;
+            }
+            sec->policies = policies;
+            policies[sec->policiesSize].policyUri = policy;
+            policies[sec->policiesSize].certificate = certificate;
+            policies[sec->policiesSize].privateKey = privateKey;
+            sec->policiesSize++;
+            continue;
+        }
+
         UA_StatusCode retval = UA_STATUSCODE_GOOD;
         if(UA_String_equal(&policy, &noneuri)) {
             /* Nothing to do! */
@@ -793,6 +835,27 @@ PARSE_JSON(SecurityPkiField) {
     (void)field;
     return UA_STATUSCODE_GOOD;
 #else
+    /* Embed the certificates of the folders in the binary configuration */
+    if(ctx->capture) {
+        BinaryConfigPki *pki = (field == &ctx->config->secureChannelPKI) ?
+            &ctx->capture->secureChannelPki : &ctx->capture->sessionPki;
+        UA_StatusCode retval = UA_STATUSCODE_GOOD;
+        pki->set = true;
+        if(trustListFolder.length > 0)
+            retval |= loadCertificateFolder(trustListFolder, &pki->trustList,
+                                            &pki->trustListSize);
+        if(issuerListFolder.length > 0)
+            retval |= loadCertificateFolder(issuerListFolder, &pki->issuerList,
+                                            &pki->issuerListSize);
+        if(revocationListFolder.length > 0)
+            retval |= loadCertificateFolder(revocationListFolder, &pki->revocationList,
+                                            &pki->revocationListSize);
+        UA_String_clear(&trustListFolder);
+        UA_String_clear(&issuerListFolder);
+        UA_String_clear(&revocationListFolder);
+        return retval;
+    }
+
     /* set server config field */
     char *sTrustListFolder = NULL;
     char *sIssuerListFolder = NULL;
@@ -892,7 +955,8 @@ const parseJsonSignature parseJsonJumpTable[UA_SERVERCONFIGFIELDKINDS] = {
 };
 
 static UA_StatusCode
-parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
+parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config,
+                BinaryConfigSecurity *capture) {
     // Parsing json config
     const char *json = (const char*)json_config.data;
     cj5_token tokens[MAX_TOKENS];
@@ -904,6 +968,8 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
     ctx.tokens = r.tokens;
     ctx.tokensSize = r.num_tokens;
     ctx.index = 1; // The first token is ignored because it is known and not needed.
+    ctx.config = config;
+    ctx.capture = capture;
 
     size_t serverConfigSize = 0;
     if(ctx.tokens)
@@ -940,6 +1006,8 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->maxSecureChannels, NULL);
                 else if(strcmp(field, "maxSecurityTokenLifetime") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxSecurityTokenLifetime, NULL);
+                else if(strcmp(field, "maxNewSecureChannelsPerSecond") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->maxNewSecureChannelsPerSecond, NULL);
                 else if(strcmp(field, "maxSessions") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->maxSessions, NULL);
                 else if(strcmp(field, "maxSessionTimeout") == 0)
@@ -954,6 +1022,8 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxNodesPerBrowse, NULL);
                 else if(strcmp(field, "maxNodesPerRegisterNodes") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxNodesPerRegisterNodes, NULL);
+                else if(strcmp(field, "maxRegisteredNodesPerSession") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxRegisteredNodesPerSession, NULL);
                 else if(strcmp(field, "maxNodesPerTranslateBrowsePathsToNodeIds") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxNodesPerTranslateBrowsePathsToNodeIds, NULL);
                 else if(strcmp(field, "maxNodesPerNodeManagement") == 0)
@@ -962,14 +1032,38 @@ parseJSONConfig(UA_ServerConfig *config, UA_ByteString json_config) {
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxMonitoredItemsPerCall, NULL);
                 else if(strcmp(field, "maxReferencesPerNode") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxReferencesPerNode, NULL);
+                else if(strcmp(field, "maxBrowseContinuationPointsMemory") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxBrowseContinuationPointsMemory, NULL);
+                else if(strcmp(field, "bulkRequestSliceSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->bulkRequestSliceSize, NULL);
+                else if(strcmp(field, "bulkRequestTimeSlice") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](&ctx, &config->bulkRequestTimeSlice, NULL);
+                else if(strcmp(field, "browseCacheSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->browseCacheSize, NULL);
+                else if(strcmp(field, "translateBrowsePathCacheSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->translateBrowsePathCacheSize, NULL);
+                else if(strcmp(field, "endpointsCacheSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->endpointsCacheSize, NULL);
+                else if(strcmp(field, "sharedValueMinSize") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->sharedValueMinSize, NULL);
                 else if(strcmp(field, "reverseReconnectInterval") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->reverseReconnectInterval, NULL);
+                else if(strcmp(field, "serviceStatistics") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_BOOLEAN](&ctx, &config->serviceStatistics, NULL);
 
 #if UA_MULTITHREADING >= 100
                 else if(strcmp(field, "asyncOperationTimeout") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_DOUBLE](&ctx, &config->asyncOperationTimeout, NULL);
                 else if(strcmp(field, "maxAsyncOperationQueueSize") == 0)
                     retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT64](&ctx, &config->maxAsyncOperationQueueSize, NULL);
+                else if(strcmp(field, "asyncOperationWorkers") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->asyncOperationWorkers, NULL);
+                else if(strcmp(field, "browseRecursiveWorkers") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT16](&ctx, &config->browseRecursiveWorkers, NULL);
+                else if(strcmp(field, "maxPendingRequestsPerSession") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxPendingRequestsPerSession, NULL);
+                else if(strcmp(field, "maxPendingRequests") == 0)
+                    retval = parseJsonJumpTable[UA_SERVERCONFIGFIELD_UINT32](&ctx, &config->maxPendingRequests, NULL);
 #endif
 
 #ifdef UA_ENABLE_DISCOVERY
@@ -1038,7 +1132,7 @@ UA_Server_newFromFile(const UA_ByteString json_config) {
     UA_ServerConfig config;
     memset(&config, 0, sizeof(UA_ServerConfig));
     UA_StatusCode res = UA_ServerConfig_setDefault(&config);
-    res |= parseJSONConfig(&config, json_config);
+    res |= parseJSONConfig(&config, json_config, NULL);
     if(res != UA_STATUSCODE_GOOD)
         return NULL;
     return UA_Server_newWithConfig(&config);
@@ -1046,7 +1140,32 @@ UA_Server_newFromFile(const UA_ByteString json_config) {
 
 UA_StatusCode
 UA_ServerConfig_updateFromFile(UA_ServerConfig *config, const UA_ByteString json_config) {
-    UA_StatusCode res = parseJSONConfig(config, json_config);
+    UA_StatusCode res = parseJSONConfig(config, json_config, NULL);
+    return res;
+}
+
+UA_StatusCode
+UA_ServerConfig_jsonToBinary(const UA_ByteString json_config,
+                             UA_ByteString *binary_config) {
+    /* Parse into a default configuration and only encode what has changed */
+    UA_ServerConfig defaults;
+    UA_ServerConfig config;
+    memset(&defaults, 0, sizeof(UA_ServerConfig));
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_ServerConfig_setDefault(&defaults);
+    res |= UA_ServerConfig_setDefault(&config);
+    config.buildInfo.buildDate = defaults.buildInfo.buildDate;
+
+    BinaryConfigSecurity sec;
+    memset(&sec, 0, sizeof(BinaryConfigSecurity));
+    if(res == UA_STATUSCODE_GOOD)
+        res = parseJSONConfig(&config, json_config, &sec);
+    if(res == UA_STATUSCODE_GOOD)
+        res = encodeBinaryConfig(&config, &defaults, &sec, binary_config);
+
+    BinaryConfigSecurity_clear(&sec);
+    UA_ServerConfig_clean(&config);
+    UA_ServerConfig_clean(&defaults);
     return res;
 }
 
@@ -1079,3 +1198,44 @@ loadCertificateFile(const char *const path) {
     return fileContents;
 }
 #endif
+
+#if defined(UA_ENABLE_ENCRYPTION) && defined(__linux__)
+static UA_StatusCode
+loadCertificateFolder(const UA_String folder, UA_ByteString **files,
+                      size_t *filesSize) {
+    char path[PATH_MAX];
+    if(folder.length >= PATH_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    memcpy(path, folder.data, folder.length);
+    path[folder.length] = '\0';
+
+    DIR *dir = opendir(path);
+    if(!dir) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Cannot open the certificate folder %s", path);
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    struct dirent *ent;
+    while((ent = readdir(dir)) != NULL) {
+        if(ent->d_name[0] == '.')
+            continue;
+        char filePath[PATH_MAX];
+        int len = snprintf(filePath, PATH_MAX, "%s/%s", path, ent->d_name);
+        if(len < 0 || len >= PATH_MAX)
+            continue;
+        UA_ByteString file = loadCertificateFile(filePath);
+        if(file.length == 0)
+            continue;
+        retval = UA_Array_append((void**)files, filesSize, &file,
+                                 &UA_TYPES[UA_TYPES_BYTESTRING]);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_ByteString_clear(&file);
+            break;
+        }
+    }
+    closedir(dir);
+    return retval;
+}
+#endif
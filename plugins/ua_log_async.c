@@ -0,0 +1,306 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/log_async.h>
+#include <open62541/types.h>
+
+#if UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX)
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RED     "\x1b[31m"
+#define ANSI_COLOR_MAGENTA "\x1b[35m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define LOG_ASYNC_DEFAULT_CAPACITY 1024
+#define LOG_ASYNC_BUFSIZE 65536
+#define LOG_ASYNC_INTERVAL 10 /* ms */
+
+static const char *asyncLevelNames[6] =
+    {"trace", "debug", "info", "warn", "error", "fatal"};
+static const char *asyncLevelColors[6] =
+    {"", "", ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW,
+     ANSI_COLOR_RED, ANSI_COLOR_MAGENTA};
+static const char *
+asyncCategoryNames[UA_LOGCATEGORIES] =
+    {"network", "channel", "session", "server", "client",
+     "userland", "securitypolicy", "eventloop", "pubsub", "discovery"};
+
+/* The slot is free for the producer with position pos if seq == pos. It holds
+ * the record for the consumer if seq == pos + 1. */
+typedef struct {
+    volatile uint64_t seq;
+    UA_DateTime time;
+    UA_LogLevel level;
+    UA_LogCategory category;
+    char msg[UA_LOG_ASYNC_MSGSIZE];
+} UA_LogRecord;
+
+/* Bounded multi-producer single-consumer ring buffer (after Dmitry Vyukov).
+ * The producers reserve a slot with a compare-and-swap on the enqueue
+ * position. The writer thread is the only consumer. */
+typedef struct {
+    UA_LogLevel minLevel;
+    int fd;
+    UA_Boolean colors;
+
+    uint64_t mask;
+    volatile uint64_t enqueuePos;
+    volatile uint64_t dropped;
+    UA_LogRecord *records;
+
+    /* Only accessed by the writer thread */
+    uint64_t dequeuePos;
+    uint64_t reportedDropped;
+    size_t bufLen;
+    char buf[LOG_ASYNC_BUFSIZE];
+
+    /* Protected by the mutex */
+    uint64_t writtenPos;
+    UA_Boolean running;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t wakeCond;  /* Wake up the writer thread */
+    pthread_cond_t doneCond;  /* Signal progress of writtenPos for _flush */
+} UA_LogQueue;
+
+/* Writer Thread */
+
+static void
+writeBuffer(UA_LogQueue *q) {
+    size_t pos = 0;
+    while(pos < q->bufLen) {
+        ssize_t n = write(q->fd, &q->buf[pos], q->bufLen - pos);
+        if(n < 0) {
+            if(errno == EINTR)
+                continue;
+            break; /* Nowhere to report the error. Drop the output. */
+        }
+        pos += (size_t)n;
+    }
+    q->bufLen = 0;
+}
+
+static void
+appendLine(UA_LogQueue *q, UA_Int64 tOffset, UA_DateTime time,
+           UA_LogLevel level, UA_LogCategory category, const char *msg) {
+    /* Make space for the longest possible line */
+    if(LOG_ASYNC_BUFSIZE - q->bufLen < UA_LOG_ASYNC_MSGSIZE + 128)
+        writeBuffer(q);
+
+    int slot = ((int)level / 100) - 1;
+    if(slot < 0 || slot > 5)
+        slot = 5; /* Set to fatal if the level is outside the range */
+    const char *cat = ((size_t)category < UA_LOGCATEGORIES) ?
+        asyncCategoryNames[category] : "unknown";
+    UA_DateTimeStruct dts = UA_DateTime_toStruct(time + tOffset);
+    int n = snprintf(&q->buf[q->bufLen], LOG_ASYNC_BUFSIZE - q->bufLen,
+                     "[%04u-%02u-%02u %02u:%02u:%02u.%03u (UTC%+05d)] %s%s/%s%s\t%s\n",
+                     dts.year, dts.month, dts.day, dts.hour, dts.min, dts.sec,
+                     dts.milliSec, (int)(tOffset / UA_DATETIME_SEC / 36),
+                     q->colors ? asyncLevelColors[slot] : "", asyncLevelNames[slot],
+                     cat, q->colors ? ANSI_COLOR_RESET : "", msg);
+    if(n < 0)
+        return;
+    q->bufLen += (size_t)n;
+    if(q->bufLen > LOG_ASYNC_BUFSIZE - 1)
+        q->bufLen = LOG_ASYNC_BUFSIZE - 1; /* Truncated by snprintf */
+}
+
+/* Returns the number of processed records */
+static size_t
+drainQueue(UA_LogQueue *q) {
+    UA_Int64 tOffset = UA_DateTime_localTimeUtcOffset();
+    size_t count = 0;
+    while(true) {
+        UA_LogRecord *r = &q->records[q->dequeuePos & q->mask];
+        /* Load the sequence number with a full barrier */
+        uint64_t seq = UA_atomic_cmpxchgUInt64(&r->seq, q->dequeuePos + 1,
+                                               q->dequeuePos + 1);
+        if(seq != q->dequeuePos + 1)
+            break; /* Empty or the producer has not finished the record yet */
+        appendLine(q, tOffset, r->time, r->level, r->category, r->msg);
+        /* Release the slot for the next round of the producers */
+        UA_atomic_cmpxchgUInt64(&r->seq, q->dequeuePos + 1,
+                                q->dequeuePos + q->mask + 1);
+        q->dequeuePos++;
+        count++;
+    }
+
+    /* Report dropped messages */
+    uint64_t dropped = UA_atomic_addUInt64(&q->dropped, 0);
+    if(dropped != q->reportedDropped) {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "%lu log messages dropped",
+                 (unsigned long)(dropped - q->reportedDropped));
+        appendLine(q, tOffset, UA_DateTime_now(), UA_LOGLEVEL_WARNING,
+                   UA_LOGCATEGORY_USERLAND, msg);
+        q->reportedDropped = dropped;
+    }
+
+    if(q->bufLen > 0)
+        writeBuffer(q);
+    return count;
+}
+
+static void *
+writerThread(void *p) {
+    UA_LogQueue *q = (UA_LogQueue*)p;
+    pthread_mutex_lock(&q->mutex);
+    while(true) {
+        UA_Boolean running = q->running;
+        pthread_mutex_unlock(&q->mutex);
+
+        drainQueue(q);
+
+        pthread_mutex_lock(&q->mutex);
+        q->writtenPos = q->dequeuePos;
+        pthread_cond_broadcast(&q->doneCond);
+        if(!running)
+            break; /* Drained after the stop was requested */
+        if(!q->running)
+            continue;
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += LOG_ASYNC_INTERVAL * 1000000L;
+        if(ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&q->wakeCond, &q->mutex, &ts);
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return NULL;
+}
+
+/* Logging */
+
+#ifdef __clang__
+__attribute__((__format__(__printf__, 7 , 0)))
+#endif
+static void
+UA_Log_Async_log(void *context, UA_LogLevel level, UA_LogCategory category,
+                 const char *file, const char *function, uint_least32_t line,
+                 const char *msg, va_list args) {
+    UA_LogQueue *q = (UA_LogQueue*)context;
+    if(q->minLevel > level)
+        return;
+
+    /* Reserve a slot */
+    uint64_t pos = q->enqueuePos;
+    UA_LogRecord *r;
+    while(true) {
+        r = &q->records[pos & q->mask];
+        int64_t diff = (int64_t)(r->seq - pos);
+        if(diff == 0) {
+            uint64_t old = UA_atomic_cmpxchgUInt64(&q->enqueuePos, pos, pos + 1);
+            if(old == pos)
+                break;
+            pos = old; /* Another producer was faster */
+        } else if(diff < 0) {
+            /* The consumer has not yet released the slot. Drop the message. */
+            UA_atomic_addUInt64(&q->dropped, 1);
+            return;
+        } else {
+            pos = q->enqueuePos;
+        }
+    }
+
+    /* Fill and publish the record */
+    r->time = UA_DateTime_now();
+    r->level = level;
+    r->category = category;
+    vsnprintf(r->msg, UA_LOG_ASYNC_MSGSIZE, msg, args);
+    UA_atomic_cmpxchgUInt64(&r->seq, pos, pos + 1);
+}
+
+static void
+UA_Log_Async_clear(UA_Logger *logger) {
+    UA_LogQueue *q = (UA_LogQueue*)logger->context;
+    pthread_mutex_lock(&q->mutex);
+    q->running = false;
+    pthread_cond_signal(&q->wakeCond);
+    pthread_mutex_unlock(&q->mutex);
+    pthread_join(q->thread, NULL);
+    pthread_cond_destroy(&q->doneCond);
+    pthread_cond_destroy(&q->wakeCond);
+    pthread_mutex_destroy(&q->mutex);
+    UA_free(q->records);
+    UA_free(q);
+    UA_free(logger);
+}
+
+UA_Logger *
+UA_Log_Async_new(UA_LogLevel minlevel, int fd, size_t capacity) {
+    if(capacity == 0)
+        capacity = LOG_ASYNC_DEFAULT_CAPACITY;
+    size_t cap = 2;
+    while(cap < capacity && cap < ((size_t)1 << 24))
+        cap <<= 1;
+
+    UA_Logger *logger = (UA_Logger*)UA_malloc(sizeof(UA_Logger));
+    UA_LogQueue *q = (UA_LogQueue*)UA_calloc(1, sizeof(UA_LogQueue));
+    UA_LogRecord *records = (UA_LogRecord*)UA_calloc(cap, sizeof(UA_LogRecord));
+    if(!logger || !q || !records) {
+        UA_free(records);
+        UA_free(q);
+        UA_free(logger);
+        return NULL;
+    }
+    for(size_t i = 0; i < cap; i++)
+        records[i].seq = i;
+
+    q->minLevel = minlevel;
+    q->fd = fd;
+    q->colors = (isatty(fd) == 1);
+    q->mask = cap - 1;
+    q->records = records;
+    q->running = true;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->wakeCond, NULL);
+    pthread_cond_init(&q->doneCond, NULL);
+    if(pthread_create(&q->thread, NULL, writerThread, q) != 0) {
+        pthread_cond_destroy(&q->doneCond);
+        pthread_cond_destroy(&q->wakeCond);
+        pthread_mutex_destroy(&q->mutex);
+        UA_free(records);
+        UA_free(q);
+        UA_free(logger);
+        return NULL;
+    }
+
+    logger->log = UA_Log_Async_log;
+    logger->context = q;
+    logger->clear = UA_Log_Async_clear;
+    return logger;
+}
+
+void
+UA_Log_Async_flush(const UA_Logger *logger) {
+    UA_LogQueue *q = (UA_LogQueue*)logger->context;
+    uint64_t target = UA_atomic_addUInt64(&q->enqueuePos, 0);
+    pthread_mutex_lock(&q->mutex);
+    pthread_cond_signal(&q->wakeCond);
+    /* Records that are reserved but never published cannot happen outside of
+     * a logging call. So the writer thread makes progress up to the target. */
+    while(q->running && (int64_t)(q->writtenPos - target) < 0)
+        pthread_cond_wait(&q->doneCond, &q->mutex);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+UA_UInt64
+UA_Log_Async_getDropped(const UA_Logger *logger) {
+    UA_LogQueue *q = (UA_LogQueue*)logger->context;
+    return UA_atomic_addUInt64(&q->dropped, 0);
+}
+
+#endif /* UA_MULTITHREADING >= 100 && defined(UA_ARCHITECTURE_POSIX) */
@@ -0,0 +1,766 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/metrics_openmetrics.h>
+#include <open62541/plugin/log.h>
+
+#include "../deps/mp_printf.h"
+#include "../deps/open62541_queue.h"
+
+#include <string.h>
+
+#define OPENMETRICS_DEFAULTPORT 9464
+#define OPENMETRICS_MAXLISTEN 8
+#define OPENMETRICS_MAXREQUEST 2048
+#define OPENMETRICS_CHUNKSIZE 16384
+#define OPENMETRICS_MAXSERVICES 64
+
+/* A connection from a scraper. The HTTP request is collected until the end of
+ * the header. */
+typedef struct MetricsConnection {
+    LIST_ENTRY(MetricsConnection) pointers;
+    uintptr_t connectionId;
+    UA_Boolean responded;
+    size_t requestLength;
+    char request[OPENMETRICS_MAXREQUEST];
+} MetricsConnection;
+
+struct UA_OpenMetricsExporter {
+    UA_Server *server;
+    UA_UInt16 port;
+    UA_String address;
+    UA_Double nodestoreInterval;
+
+    UA_Boolean running;
+    UA_Boolean deleted; /* Free when the last connection has closed */
+    UA_UInt64 openCallbackId;
+
+    /* The listen sockets have the exporter as the connection context. The
+     * accepted connections inherit it and get their own context in the first
+     * callback. */
+    UA_ConnectionManager *cm;
+    size_t listenConnectionsSize;
+    uintptr_t listenConnections[OPENMETRICS_MAXLISTEN];
+    LIST_HEAD(, MetricsConnection) connections;
+
+    /* Cached Nodestore statistics */
+    UA_Boolean nodestoreValid;
+    UA_DateTime nodestoreTime;
+    UA_NodestoreStatistics nodestoreStats;
+};
+
+/**********/
+/* Writer */
+/**********/
+
+/* The response is written into network buffers of a fixed size. Full buffers
+ * are sent right away. */
+typedef struct {
+    UA_ConnectionManager *cm;
+    uintptr_t connectionId;
+    UA_ByteString buf;
+    size_t pos;
+    UA_StatusCode res;
+} MetricsWriter;
+
+static void
+flushWriter(MetricsWriter *w) {
+    if(w->buf.length == 0)
+        return;
+    if(w->res != UA_STATUSCODE_GOOD || w->pos == 0) {
+        w->cm->freeNetworkBuffer(w->cm, w->connectionId, &w->buf);
+        w->pos = 0;
+        return;
+    }
+    w->buf.length = w->pos;
+    w->res = w->cm->sendWithConnection(w->cm, w->connectionId,
+                                       &UA_KEYVALUEMAP_NULL, &w->buf);
+    UA_ByteString_init(&w->buf);
+    w->pos = 0;
+}
+
+static void ATTR_PRINTF(2, 3)
+emit(MetricsWriter *w, const char *format, ...) {
+    while(w->res == UA_STATUSCODE_GOOD) {
+        if(w->buf.length == 0) {
+            w->res = w->cm->allocNetworkBuffer(w->cm, w->connectionId, &w->buf,
+                                               OPENMETRICS_CHUNKSIZE);
+            w->pos = 0;
+            continue;
+        }
+
+        size_t space = w->buf.length - w->pos;
+        va_list args;
+        va_start(args, format);
+        int len = mp_vsnprintf((char*)w->buf.data + w->pos, space, format, args);
+        va_end(args);
+        if(len < 0) {
+            w->res = UA_STATUSCODE_BADENCODINGERROR;
+            return;
+        }
+        if((size_t)len < space) {
+            w->pos += (size_t)len;
+            return;
+        }
+
+        /* Does not fit. Send the buffer and retry in a new buffer. */
+        if(w->pos == 0) {
+            w->res = UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            return;
+        }
+        flushWriter(w);
+    }
+}
+
+static void
+emitFamily(MetricsWriter *w, const char *name, const char *type,
+           const char *help) {
+    emit(w, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+static void
+emitCounter(MetricsWriter *w, const char *name, const char *help,
+            UA_UInt64 value) {
+    emitFamily(w, name, "counter", help);
+    emit(w, "%s_total %llu\n", name, (unsigned long long)value);
+}
+
+static void
+emitGauge(MetricsWriter *w, const char *name, const char *help,
+          UA_UInt64 value) {
+    emitFamily(w, name, "gauge", help);
+    emit(w, "%s %llu\n", name, (unsigned long long)value);
+}
+
+/* Durations are in UA_DateTime units (100ns) and exported in seconds */
+static void
+emitSecondsCounter(MetricsWriter *w, const char *name, const char *help,
+                   UA_UInt64 duration) {
+    emitFamily(w, name, "counter", help);
+    emit(w, "%s_total %.7f\n", name, (UA_Double)duration / UA_DATETIME_SEC);
+}
+
+static void
+emitSecondsGauge(MetricsWriter *w, const char *name, const char *help,
+                 UA_UInt64 duration) {
+    emitFamily(w, name, "gauge", help);
+    emit(w, "%s %.7f\n", name, (UA_Double)duration / UA_DATETIME_SEC);
+}
+
+/***********/
+/* Metrics */
+/***********/
+
+static void
+emitServerStatistics(MetricsWriter *w, const UA_ServerStatistics *st) {
+    const UA_SecureChannelStatistics *scs = &st->scs;
+    emitGauge(w, "opcua_securechannels", "Open SecureChannels",
+              scs->currentChannelCount);
+    emitCounter(w, "opcua_securechannels_opened", "Opened SecureChannels",
+                scs->cumulatedChannelCount);
+    emitCounter(w, "opcua_securechannels_rejected", "Rejected SecureChannels",
+                scs->rejectedChannelCount);
+    emitCounter(w, "opcua_securechannels_timedout",
+                "SecureChannels closed after a timeout", scs->channelTimeoutCount);
+    emitCounter(w, "opcua_securechannels_aborted",
+                "SecureChannels closed with an error", scs->channelAbortCount);
+    emitCounter(w, "opcua_securechannels_purged",
+                "SecureChannels closed to make room for new ones",
+                scs->channelPurgeCount);
+
+    const UA_SessionStatistics *ss = &st->ss;
+    emitGauge(w, "opcua_sessions", "Activated Sessions", ss->currentSessionCount);
+    emitCounter(w, "opcua_sessions_created", "Created Sessions",
+                ss->cumulatedSessionCount);
+    emitCounter(w, "opcua_sessions_rejected", "Rejected Sessions",
+                ss->rejectedSessionCount);
+    emitCounter(w, "opcua_sessions_security_rejected",
+                "Sessions rejected for security reasons",
+                ss->securityRejectedSessionCount);
+    emitCounter(w, "opcua_sessions_timedout", "Sessions closed after a timeout",
+                ss->sessionTimeoutCount);
+    emitCounter(w, "opcua_sessions_aborted", "Sessions closed with an error",
+                ss->sessionAbortCount);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    const UA_SubscriptionStatistics *subs = &st->subs;
+    emitGauge(w, "opcua_subscriptions", "Subscriptions",
+              subs->currentSubscriptionCount);
+    emitGauge(w, "opcua_subscriptions_late",
+              "Subscriptions waiting for a PublishRequest",
+              subs->lateSubscriptionCount);
+    emitGauge(w, "opcua_monitoreditems", "MonitoredItems",
+              subs->currentMonitoredItemCount);
+    emitGauge(w, "opcua_notification_queue_size",
+              "Notifications waiting to be published",
+              subs->notificationQueueSize);
+    emitGauge(w, "opcua_retransmission_queue_size",
+              "NotificationMessages kept for republishing",
+              subs->retransmissionQueueSize);
+    emitGauge(w, "opcua_publish_request_queue_size",
+              "PublishRequests waiting in the Sessions",
+              subs->publishRequestQueueSize);
+#endif
+
+    const UA_ServerCounterStatistics *cs = &st->cs;
+    emitCounter(w, "opcua_chunks_received", "Received chunks", cs->chunkCount);
+    emitCounter(w, "opcua_messages_received", "Received messages",
+                cs->messageCount);
+    emitCounter(w, "opcua_samples", "Values sampled for MonitoredItems",
+                cs->samplingCount);
+    emitCounter(w, "opcua_notifications", "Notifications enqueued",
+                cs->notificationCount);
+    emitCounter(w, "opcua_notifications_dropped",
+                "Notifications dropped because the queue was full",
+                cs->notificationDropCount);
+
+#if UA_MULTITHREADING >= 100
+    const UA_ServiceLockStatistics *sls = &st->sls;
+    emitCounter(w, "opcua_service_lock_shared", "Shared service lock acquisitions",
+                sls->sharedCount);
+    emitSecondsCounter(w, "opcua_service_lock_shared_hold_seconds",
+                       "Time the shared service lock was held",
+                       sls->sharedHoldTime);
+    emitSecondsGauge(w, "opcua_service_lock_shared_hold_max_seconds",
+                     "Longest hold of the shared service lock",
+                     sls->sharedMaxHoldTime);
+    emitCounter(w, "opcua_service_lock_exclusive",
+                "Exclusive service lock acquisitions", sls->exclusiveCount);
+    emitSecondsCounter(w, "opcua_service_lock_exclusive_hold_seconds",
+                       "Time the exclusive service lock was held",
+                       sls->exclusiveHoldTime);
+    emitSecondsGauge(w, "opcua_service_lock_exclusive_hold_max_seconds",
+                     "Longest hold of the exclusive service lock",
+                     sls->exclusiveMaxHoldTime);
+
+    const UA_AsyncOperationStatistics *aos = &st->aos;
+    emitCounter(w, "opcua_async_operations", "Completed async operations",
+                aos->operationCount);
+    emitCounter(w, "opcua_async_operations_timedout", "Timed out async operations",
+                aos->timeoutCount);
+    emitSecondsCounter(w, "opcua_async_queue_seconds",
+                       "Time async operations waited for a worker",
+                       aos->queueTime);
+    emitSecondsGauge(w, "opcua_async_queue_max_seconds",
+                     "Longest wait of an async operation for a worker",
+                     aos->maxQueueTime);
+    emitSecondsCounter(w, "opcua_async_processing_seconds",
+                       "Time async operations were processed by a worker",
+                       aos->processingTime);
+    emitSecondsGauge(w, "opcua_async_processing_max_seconds",
+                     "Longest processing of an async operation",
+                     aos->maxProcessingTime);
+#endif
+}
+
+static void
+serviceLabel(const UA_DataType *type, char *label, size_t labelSize) {
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    /* Strip the "Request" suffix */
+    size_t len = strlen(type->typeName);
+    if(len > 7 && strcmp(&type->typeName[len - 7], "Request") == 0)
+        len -= 7;
+    mp_snprintf(label, labelSize, "%.*s", (int)len, type->typeName);
+#else
+    mp_snprintf(label, labelSize, "i=%u", (unsigned)type->typeId.identifier.numeric);
+#endif
+}
+
+typedef enum {
+    SERVICEPHASE_DECODE,
+    SERVICEPHASE_LOCKWAIT,
+    SERVICEPHASE_EXECUTION,
+    SERVICEPHASE_SEND
+} ServicePhase;
+
+static const char *servicePhaseNames[4] = {
+    "opcua_service_decode_seconds", "opcua_service_lock_wait_seconds",
+    "opcua_service_execution_seconds", "opcua_service_send_seconds"};
+
+static const char *servicePhaseHelp[4] = {
+    "Time to decode the request", "Time waiting for the service lock",
+    "Time to execute the service", "Time to encode and send the response"};
+
+static void
+emitHistogram(MetricsWriter *w, const char *name, const char *label,
+              const UA_LatencyHistogram *h) {
+    /* The buckets are cumulative. The count is taken from the buckets to be
+     * consistent if the histogram was updated while it was copied. */
+    UA_UInt64 count = 0;
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS - 1; i++) {
+        count += h->buckets[i];
+        UA_Double le = (UA_Double)((UA_UInt64)2 << i) / UA_DATETIME_SEC;
+        emit(w, "%s_bucket{service=\"%s\",le=\"%.7f\"} %llu\n",
+             name, label, le, (unsigned long long)count);
+    }
+    count += h->buckets[UA_LATENCYHISTOGRAM_BUCKETS - 1];
+    emit(w, "%s_bucket{service=\"%s\",le=\"+Inf\"} %llu\n",
+         name, label, (unsigned long long)count);
+    emit(w, "%s_count{service=\"%s\"} %llu\n",
+         name, label, (unsigned long long)count);
+    emit(w, "%s_sum{service=\"%s\"} %.7f\n",
+         name, label, (UA_Double)h->sum / UA_DATETIME_SEC);
+}
+
+/* Only the services that were used are exported. The statistics are read
+ * without a lock. */
+static void
+emitServiceStatistics(MetricsWriter *w, UA_Server *server) {
+    const UA_DataType *services[OPENMETRICS_MAXSERVICES];
+    size_t servicesSize = 0;
+    UA_ServiceStatistics stats;
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        UA_StatusCode res =
+            UA_Server_getServiceStatistics(server, &UA_TYPES[i], &stats);
+        if(res == UA_STATUSCODE_BADNOTSUPPORTED)
+            return; /* Service statistics are not enabled */
+        if(res != UA_STATUSCODE_GOOD || stats.requestCount == 0)
+            continue;
+        services[servicesSize++] = &UA_TYPES[i];
+        if(servicesSize == OPENMETRICS_MAXSERVICES)
+            break;
+    }
+
+    char label[64];
+    emitFamily(w, "opcua_service_requests", "counter", "Received requests");
+    for(size_t i = 0; i < servicesSize; i++) {
+        UA_Server_getServiceStatistics(server, services[i], &stats);
+        serviceLabel(services[i], label, sizeof(label));
+        emit(w, "opcua_service_requests_total{service=\"%s\"} %llu\n",
+             label, (unsigned long long)stats.requestCount);
+    }
+
+    emitFamily(w, "opcua_service_faults", "counter",
+               "Responses with a bad ServiceResult");
+    for(size_t i = 0; i < servicesSize; i++) {
+        UA_Server_getServiceStatistics(server, services[i], &stats);
+        serviceLabel(services[i], label, sizeof(label));
+        emit(w, "opcua_service_faults_total{service=\"%s\"} %llu\n",
+             label, (unsigned long long)stats.faultCount);
+    }
+
+    for(size_t phase = 0; phase < 4; phase++) {
+        emitFamily(w, servicePhaseNames[phase], "histogram",
+                   servicePhaseHelp[phase]);
+        for(size_t i = 0; i < servicesSize; i++) {
+            UA_Server_getServiceStatistics(server, services[i], &stats);
+            serviceLabel(services[i], label, sizeof(label));
+            const UA_LatencyHistogram *h;
+            switch(phase) {
+            case SERVICEPHASE_DECODE: h = &stats.decodeTime; break;
+            case SERVICEPHASE_LOCKWAIT: h = &stats.lockWaitTime; break;
+            case SERVICEPHASE_EXECUTION: h = &stats.executionTime; break;
+            default: h = &stats.sendTime; break;
+            }
+            emitHistogram(w, servicePhaseNames[phase], label, h);
+        }
+    }
+}
+
+static void
+emitEventLoopStatistics(MetricsWriter *w, UA_EventLoop *el) {
+    if(!el->getStatistics)
+        return;
+    UA_EventLoopStatistics els;
+    el->getStatistics(el, &els);
+    emitCounter(w, "opcua_eventloop_iterations", "EventLoop iterations",
+                els.iterationCount);
+    emitSecondsCounter(w, "opcua_eventloop_busy_seconds",
+                       "Time the EventLoop was not waiting for events",
+                       els.busyTime);
+    emitSecondsGauge(w, "opcua_eventloop_busy_max_seconds",
+                     "Longest EventLoop iteration without the wait for events",
+                     els.maxBusyTime);
+    emitFamily(w, "opcua_eventloop_phase_seconds", "counter",
+               "Time of the EventLoop per phase of the iterations");
+    emit(w, "opcua_eventloop_phase_seconds_total{phase=\"timer\"} %.7f\n"
+         "opcua_eventloop_phase_seconds_total{phase=\"delayed\"} %.7f\n"
+         "opcua_eventloop_phase_seconds_total{phase=\"events\"} %.7f\n"
+         "opcua_eventloop_phase_seconds_total{phase=\"wait\"} %.7f\n",
+         (UA_Double)els.timerTime / UA_DATETIME_SEC,
+         (UA_Double)els.delayedTime / UA_DATETIME_SEC,
+         (UA_Double)els.eventTime / UA_DATETIME_SEC,
+         (UA_Double)els.waitTime / UA_DATETIME_SEC);
+    emitCounter(w, "opcua_timer_callbacks", "Executed timed and cyclic callbacks",
+                els.timerCallbackCount);
+    emitCounter(w, "opcua_eventloop_slow_callbacks",
+                "Callbacks above the slowCallbackThreshold of the EventLoop",
+                els.slowCallbackCount);
+
+    /* Same bucket limits as the service latency histograms */
+    emitFamily(w, "opcua_timer_lag_seconds", "histogram",
+               "Delay of the callbacks after their scheduled time");
+    UA_UInt64 count = 0;
+    for(size_t i = 0; i < UA_EVENTLOOP_LAGBUCKETS - 1; i++) {
+        count += els.timerLagBuckets[i];
+        UA_Double le = (UA_Double)((UA_UInt64)2 << i) / UA_DATETIME_SEC;
+        emit(w, "opcua_timer_lag_seconds_bucket{le=\"%.7f\"} %llu\n",
+             le, (unsigned long long)count);
+    }
+    count += els.timerLagBuckets[UA_EVENTLOOP_LAGBUCKETS - 1];
+    emit(w, "opcua_timer_lag_seconds_bucket{le=\"+Inf\"} %llu\n"
+         "opcua_timer_lag_seconds_count %llu\n"
+         "opcua_timer_lag_seconds_sum %.7f\n",
+         (unsigned long long)count, (unsigned long long)count,
+         (UA_Double)els.timerLag / UA_DATETIME_SEC);
+    emitSecondsGauge(w, "opcua_timer_lag_max_seconds",
+                     "Longest delay of a callback after its scheduled time",
+                     els.maxTimerLag);
+}
+
+static void
+emitNodestoreStatistics(MetricsWriter *w, UA_OpenMetricsExporter *e,
+                        UA_EventLoop *el) {
+    if(e->nodestoreInterval < 0.0)
+        return;
+
+    /* Refresh the cached statistics */
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(!e->nodestoreValid || now - e->nodestoreTime >=
+       (UA_DateTime)(e->nodestoreInterval * UA_DATETIME_MSEC)) {
+        UA_NodestoreStatistics_clear(&e->nodestoreStats);
+        UA_StatusCode res =
+            UA_Server_getNodestoreStatistics(e->server, &e->nodestoreStats);
+        e->nodestoreValid = (res == UA_STATUSCODE_GOOD);
+        e->nodestoreTime = now;
+    }
+    if(!e->nodestoreValid)
+        return;
+
+    const UA_NodestoreStatistics *ns = &e->nodestoreStats;
+    emitFamily(w, "opcua_nodestore_nodes", "gauge", "Nodes per namespace");
+    for(size_t i = 0; i < ns->namespacesSize; i++)
+        emit(w, "opcua_nodestore_nodes{namespace=\"%u\"} %llu\n", (unsigned)i,
+             (unsigned long long)ns->namespaces[i].nodeCount);
+    emitFamily(w, "opcua_nodestore_node_bytes", "gauge",
+               "Memory of the nodes per namespace");
+    for(size_t i = 0; i < ns->namespacesSize; i++)
+        emit(w, "opcua_nodestore_node_bytes{namespace=\"%u\"} %llu\n", (unsigned)i,
+             (unsigned long long)ns->namespaces[i].nodeBytes);
+    emitFamily(w, "opcua_nodestore_reference_bytes", "gauge",
+               "Memory of the references per namespace");
+    for(size_t i = 0; i < ns->namespacesSize; i++)
+        emit(w, "opcua_nodestore_reference_bytes{namespace=\"%u\"} %llu\n",
+             (unsigned)i, (unsigned long long)ns->namespaces[i].referenceBytes);
+    emitGauge(w, "opcua_nodestore_allocated_bytes",
+              "Memory reserved by the Nodestore", ns->allocatedBytes);
+}
+
+/********/
+/* HTTP */
+/********/
+
+static const char *httpNotFound =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 10\r\n"
+    "Connection: close\r\n\r\n"
+    "Not Found\n";
+
+static const char *httpBadRequest =
+    "HTTP/1.1 400 Bad Request\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 12\r\n"
+    "Connection: close\r\n\r\n"
+    "Bad Request\n";
+
+/* The body is delimited by closing the connection. So it can be sent in chunks
+ * before the full length is known. */
+static const char *httpMetricsHeader =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+    "Connection: close\r\n\r\n";
+
+static void
+respond(UA_OpenMetricsExporter *e, MetricsConnection *mc) {
+    MetricsWriter w;
+    memset(&w, 0, sizeof(MetricsWriter));
+    w.cm = e->cm;
+    w.connectionId = mc->connectionId;
+
+    /* Parse the request line */
+    const char *path = NULL;
+    size_t pathLen = 0;
+    if(mc->requestLength > 4 && strncmp(mc->request, "GET ", 4) == 0) {
+        path = &mc->request[4];
+        while(path + pathLen < &mc->request[mc->requestLength] &&
+              path[pathLen] != ' ' && path[pathLen] != '?' &&
+              path[pathLen] != '\r')
+            pathLen++;
+    }
+
+    if(!path) {
+        emit(&w, "%s", httpBadRequest);
+    } else if(pathLen != 8 || strncmp(path, "/metrics", 8) != 0) {
+        emit(&w, "%s", httpNotFound);
+    } else {
+        UA_ServerConfig *config = UA_Server_getConfig(e->server);
+        UA_ServerStatistics st = UA_Server_getStatistics(e->server);
+        emit(&w, "%s", httpMetricsHeader);
+        emitServerStatistics(&w, &st);
+        emitServiceStatistics(&w, e->server);
+        emitEventLoopStatistics(&w, config->eventLoop);
+        emitNodestoreStatistics(&w, e, config->eventLoop);
+        emit(&w, "# EOF\n");
+    }
+    flushWriter(&w);
+
+    if(w.res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(UA_Server_getConfig(e->server)->logging,
+                       UA_LOGCATEGORY_SERVER,
+                       "OpenMetrics | Sending the response failed with %s",
+                       UA_StatusCode_name(w.res));
+
+    mc->responded = true;
+    e->cm->closeConnection(e->cm, mc->connectionId);
+}
+
+/**************/
+/* Connection */
+/**************/
+
+static void
+freeIfDeleted(UA_OpenMetricsExporter *e) {
+    if(!e->deleted || e->listenConnectionsSize > 0 ||
+       !LIST_EMPTY(&e->connections))
+        return;
+    UA_NodestoreStatistics_clear(&e->nodestoreStats);
+    UA_String_clear(&e->address);
+    UA_free(e);
+}
+
+static UA_Boolean
+isListenConnection(UA_OpenMetricsExporter *e, uintptr_t connectionId) {
+    for(size_t i = 0; i < e->listenConnectionsSize; i++) {
+        if(e->listenConnections[i] == connectionId)
+            return true;
+    }
+    return false;
+}
+
+static void
+removeListenConnection(UA_OpenMetricsExporter *e, uintptr_t connectionId) {
+    for(size_t i = 0; i < e->listenConnectionsSize; i++) {
+        if(e->listenConnections[i] != connectionId)
+            continue;
+        e->listenConnectionsSize--;
+        e->listenConnections[i] = e->listenConnections[e->listenConnectionsSize];
+        return;
+    }
+}
+
+static void
+metricsConnectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                          void *application, void **connectionContext,
+                          UA_ConnectionState state, const UA_KeyValueMap *params,
+                          UA_ByteString msg) {
+    UA_OpenMetricsExporter *e = (UA_OpenMetricsExporter*)application;
+
+    /* A new listen socket */
+    if(*connectionContext == NULL) {
+        if(state == UA_CONNECTIONSTATE_CLOSING ||
+           state == UA_CONNECTIONSTATE_CLOSED)
+            return;
+        if(e->listenConnectionsSize == OPENMETRICS_MAXLISTEN || !e->running) {
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        e->listenConnections[e->listenConnectionsSize++] = connectionId;
+        *connectionContext = e;
+        return;
+    }
+
+    /* A listen socket or a connection without a context */
+    if(*connectionContext == e) {
+        if(state == UA_CONNECTIONSTATE_CLOSING) {
+            removeListenConnection(e, connectionId);
+            freeIfDeleted(e);
+            return;
+        }
+        if(isListenConnection(e, connectionId))
+            return;
+
+        /* A new connection was accepted */
+        MetricsConnection *mc = (MetricsConnection*)
+            UA_calloc(1, sizeof(MetricsConnection));
+        if(!mc || !e->running) {
+            UA_free(mc);
+            cm->closeConnection(cm, connectionId);
+            return;
+        }
+        mc->connectionId = connectionId;
+        LIST_INSERT_HEAD(&e->connections, mc, pointers);
+        *connectionContext = mc;
+        if(msg.length == 0)
+            return;
+    }
+
+    MetricsConnection *mc = (MetricsConnection*)*connectionContext;
+
+    /* The connection has closed */
+    if(state == UA_CONNECTIONSTATE_CLOSING) {
+        LIST_REMOVE(mc, pointers);
+        UA_free(mc);
+        freeIfDeleted(e);
+        return;
+    }
+
+    /* Collect the request until the end of the header */
+    if(mc->responded || msg.length == 0)
+        return;
+    if(msg.length >= OPENMETRICS_MAXREQUEST - mc->requestLength) {
+        UA_LOG_WARNING(UA_Server_getConfig(e->server)->logging,
+                       UA_LOGCATEGORY_SERVER,
+                       "OpenMetrics | The request is too long");
+        mc->responded = true;
+        cm->closeConnection(cm, connectionId);
+        return;
+    }
+    memcpy(&mc->request[mc->requestLength], msg.data, msg.length);
+    mc->requestLength += msg.length;
+    mc->request[mc->requestLength] = 0;
+    if(!strstr(mc->request, "\r\n\r\n"))
+        return;
+
+    respond(e, mc);
+}
+
+static UA_StatusCode
+openListenConnection(UA_OpenMetricsExporter *e) {
+    UA_ServerConfig *config = UA_Server_getConfig(e->server);
+    UA_EventLoop *el = config->eventLoop;
+
+    /* Find the TCP ConnectionManager */
+    UA_String tcpString = UA_STRING("tcp");
+    e->cm = NULL;
+    for(UA_EventSource *es = el->eventSources; es != NULL; es = es->next) {
+        if(es->eventSourceType != UA_EVENTSOURCETYPE_CONNECTIONMANAGER)
+            continue;
+        UA_ConnectionManager *cm = (UA_ConnectionManager*)es;
+        if(UA_String_equal(&tcpString, &cm->protocol)) {
+            e->cm = cm;
+            break;
+        }
+    }
+    if(!e->cm) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "OpenMetrics | No TCP ConnectionManager in the EventLoop");
+        return UA_STATUSCODE_BADINTERNALERROR;
+    }
+
+    UA_Boolean listen = true;
+    UA_Boolean reuse = true;
+    UA_KeyValuePair params[4];
+    size_t paramsSize = 3;
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &e->port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "reuse");
+    UA_Variant_setScalar(&params[2].value, &reuse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    if(e->address.length > 0) {
+        params[3].key = UA_QUALIFIEDNAME(0, "address");
+        UA_Variant_setArray(&params[3].value, &e->address, 1,
+                            &UA_TYPES[UA_TYPES_STRING]);
+        paramsSize = 4;
+    }
+    UA_KeyValueMap paramsMap = {paramsSize, params};
+
+    UA_StatusCode res = e->cm->openConnection(e->cm, &paramsMap, e, NULL,
+                                              metricsConnectionCallback);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "OpenMetrics | Could not listen on port %u (%s)",
+                     (unsigned)e->port, UA_StatusCode_name(res));
+        return res;
+    }
+    UA_LOG_INFO(config->logging, UA_LOGCATEGORY_SERVER,
+                "OpenMetrics | Serving the metrics on port %u", (unsigned)e->port);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+openCallback(void *application, void *context) {
+    UA_OpenMetricsExporter *e = (UA_OpenMetricsExporter*)application;
+    e->openCallbackId = 0;
+    if(e->running && openListenConnection(e) != UA_STATUSCODE_GOOD)
+        e->running = false;
+}
+
+/*************/
+/* Lifecycle */
+/*************/
+
+UA_OpenMetricsExporter *
+UA_OpenMetricsExporter_new(UA_Server *server,
+                           const UA_OpenMetricsExporterConfig *config) {
+    UA_OpenMetricsExporter *e = (UA_OpenMetricsExporter*)
+        UA_calloc(1, sizeof(UA_OpenMetricsExporter));
+    if(!e)
+        return NULL;
+    e->server = server;
+    e->port = OPENMETRICS_DEFAULTPORT;
+    e->nodestoreInterval = 60000.0;
+    if(config) {
+        if(config->port != 0)
+            e->port = config->port;
+        e->nodestoreInterval = config->nodestoreInterval;
+        if(UA_String_copy(&config->address, &e->address) != UA_STATUSCODE_GOOD) {
+            UA_free(e);
+            return NULL;
+        }
+    }
+    LIST_INIT(&e->connections);
+    return e;
+}
+
+UA_StatusCode
+UA_OpenMetricsExporter_start(UA_OpenMetricsExporter *e) {
+    if(e->running)
+        return UA_STATUSCODE_GOOD;
+    UA_EventLoop *el = UA_Server_getConfig(e->server)->eventLoop;
+    e->running = true;
+
+    /* Open right away if the EventLoop is started */
+    if(el->state == UA_EVENTLOOPSTATE_STARTED) {
+        UA_StatusCode res = openListenConnection(e);
+        if(res != UA_STATUSCODE_GOOD)
+            e->running = false;
+        return res;
+    }
+
+    /* Open in the first iteration of the EventLoop */
+    UA_StatusCode res =
+        el->addTimedCallback(el, openCallback, e, NULL,
+                             el->dateTime_nowMonotonic(el), &e->openCallbackId);
+    if(res != UA_STATUSCODE_GOOD)
+        e->running = false;
+    return res;
+}
+
+void
+UA_OpenMetricsExporter_stop(UA_OpenMetricsExporter *e) {
+    e->running = false;
+    if(e->openCallbackId != 0) {
+        UA_EventLoop *el = UA_Server_getConfig(e->server)->eventLoop;
+        el->removeCyclicCallback(el, e->openCallbackId);
+        e->openCallbackId = 0;
+    }
+    for(size_t i = 0; i < e->listenConnectionsSize; i++)
+        e->cm->closeConnection(e->cm, e->listenConnections[i]);
+    MetricsConnection *mc;
+    LIST_FOREACH(mc, &e->connections, pointers) {
+        if(!mc->responded) {
+            mc->responded = true;
+            e->cm->closeConnection(e->cm, mc->connectionId);
+        }
+    }
+}
+
+void
+UA_OpenMetricsExporter_delete(UA_OpenMetricsExporter *e) {
+    UA_OpenMetricsExporter_stop(e);
+    e->deleted = true;
+    freeIfDeleted(e);
+}
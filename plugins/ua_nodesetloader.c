@@ -11,14 +11,39 @@
 #include <NodesetLoader/dataTypes.h>
 #include <open62541/server.h>
 
+/* Number of nodes in the nodestore. Zero if the nodestore has no statistics. */
+static size_t
+countNodes(UA_Server *server) {
+    UA_NodestoreStatistics stats;
+    if(UA_Server_getNodestoreStatistics(server, &stats) != UA_STATUSCODE_GOOD)
+        return 0;
+    size_t count = stats.total.nodeCount;
+    UA_NodestoreStatistics_clear(&stats);
+    return count;
+}
+
 UA_StatusCode
 UA_Server_loadNodeset(UA_Server *server, const char *nodeset2XmlFilePath,
                       UA_NodeSetLoaderOptions *options) {
+    const UA_Logger *logger = UA_Server_getConfig(server)->logging;
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    size_t nodesBefore = countNodes(server);
+
     if(!NodesetLoader_loadFile(server,
                                nodeset2XmlFilePath,
                                (NodesetLoader_ExtensionInterface*)options)) {
+        UA_LOG_ERROR(logger, UA_LOGCATEGORY_SERVER,
+                     "Loading the nodeset %s failed", nodeset2XmlFilePath);
         return UA_STATUSCODE_BAD;
     }
 
+    /* Report the progress for servers that load several nodesets */
+    UA_DateTime duration = UA_DateTime_nowMonotonic() - start;
+    size_t nodesAfter = countNodes(server);
+    UA_LOG_INFO(logger, UA_LOGCATEGORY_SERVER,
+                "Loaded the nodeset %s with %lu nodes in %.3f s",
+                nodeset2XmlFilePath,
+                (long unsigned)(nodesAfter - nodesBefore),
+                (double)duration / (double)UA_DATETIME_SEC);
     return UA_STATUSCODE_GOOD;
 }
@@ -14,142 +14,255 @@
     (type *)((uintptr_t)ptr - offsetof(type,member))
 #endif
 
-/* The default Nodestore is simply a hash-map from NodeIds to Nodes. To find an
- * entry, iterate over candidate positions according to the NodeId hash.
+/* The default Nodestore is simply a hash-map from NodeIds to Nodes. The
+ * hash-map uses open addressing with a "structure of arrays" layout. Every slot
+ * has a control byte, a key and a pointer to the entry. The three are stored in
+ * separate arrays. So the probing only touches the (densely packed) control
+ * bytes and keys. The entry is dereferenced only for the final comparison.
  *
- * - Tombstone or non-matching NodeId: continue searching
- * - Matching NodeId: Return the entry
- * - NULL: Abort the search */
+ * - The control byte is either EMPTY, DELETED or contains a 7-bit tag from the
+ *   hash.
+ * - The slots are probed in groups of eight. The control bytes of a group are
+ *   loaded into a 64bit integer and compared to the tag all at once. Only slots
+ *   with a matching tag are inspected further. The search ends after a group
+ *   with an EMPTY slot.
+ * - The key of numeric NodeIds is the NodeId itself (namespace and numeric
+ *   identifier). These are the vast majority of NodeIds. They are matched
+ *   without dereferencing the entry. For other NodeIds the key contains the
+ *   hash. */
+
+/* Concurrent readers
+ * ~~~~~~~~~~~~~~~~~~
+ * With multithreading and immutable nodes, getNode/releaseNode do not take a
+ * lock and can run concurrently to each other and to one writer. The writers
+ * (insert, replace, remove) still need to be serialized by the caller. Nodes
+ * are never edited in-place. Replaced and removed entries as well as the slot
+ * tables from previous resizes are "retired". They are freed only after all
+ * readers that could have seen them have left.
+ *
+ * The readers announce themselves in one of two counters, depending on the
+ * current epoch. A writer advances the epoch when the counter of the next
+ * epoch (has been the previous-but-one) is zero. Then everything that was
+ * retired during the previous-but-one epoch is no longer reachable by any
+ * reader and can be freed. Retired entries with a refCount > 0 are kept until
+ * the readers release them. */
+#if UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES)
+#define UA_NODEMAP_CONCURRENT 1
+#endif
 
 typedef struct UA_NodeMapEntry {
     struct UA_NodeMapEntry *orig; /* the version this is a copy from (or NULL) */
+#ifdef UA_NODEMAP_CONCURRENT
+    struct UA_NodeMapEntry *retiredNext;
+    volatile uint32_t refCount;
+#else
     UA_UInt16 refCount; /* How many consumers have a reference to the node? */
+#endif
     UA_Boolean deleted; /* Node was marked as deleted and can be deleted when refCount == 0 */
+    UA_Boolean frozen; /* Part of a frozen nodemap. Not refcounted. */
+    UA_Boolean whiteout; /* Hides the node with the same NodeId in the base.
+                          * Only the NodeId is allocated. */
+    UA_Boolean compact; /* The node is encoded in a UA_NodeMapCompactEntry */
+    UA_Boolean decoded; /* Decoded from a compact entry. Allocated individually
+                         * and can be compacted again. */
+    UA_Boolean tracked; /* Decoded node in the cache */
+    UA_Boolean recent;  /* Tracked node was accessed since the last sweep */
     UA_Node node;
 } UA_NodeMapEntry;
 
-#define UA_NODEMAP_MINSIZE 64
-#define UA_NODEMAP_TOMBSTONE ((UA_NodeMapEntry*)0x01)
-
+/* Only the NodeHead of the entry is allocated. The NodeId and NodeClass are
+ * set. See the section on compact nodes below. */
 typedef struct {
-    UA_NodeMapEntry *entry;
-    UA_UInt32 nodeIdHash;
-} UA_NodeMapSlot;
+    UA_ByteString encoded;
+    UA_NodeMapEntry entry;
+} UA_NodeMapCompactEntry;
+
+#define UA_NODEMAP_COMPACTSIZE                                          \
+    (offsetof(UA_NodeMapCompactEntry, entry) + sizeof(UA_NodeMapEntry) - \
+     sizeof(UA_Node) + sizeof(UA_NodeHead))
+
+#define UA_NODEMAP_MINSIZE 64 /* Power of two */
+#define UA_NODEMAP_GROUPSIZE 8
+#define UA_NODEMAP_EMPTY 0x80
+#define UA_NODEMAP_DELETED 0xfe
+#define UA_NODEMAP_HASHKEY ((UA_UInt64)1 << 63) /* Key is the hash, not the NodeId */
+
+/* The slot arrays are allocated together with the table header. So that
+ * readers always see a consistent size. */
+typedef struct UA_NodeMapTable {
+    struct UA_NodeMapTable *retiredNext;
+    UA_UInt32 size;       /* Power of two */
+    UA_UInt32 tombstones; /* Number of DELETED control bytes */
+    UA_UInt64 *keys;
+    UA_NodeMapEntry * volatile *entries;
+    UA_Byte *ctrl;
+} UA_NodeMapTable;
+
+/* The entries are allocated from slabs with a pool per NodeClass. Free entries
+ * are kept in a list for reuse. The slabs are only released together with the
+ * nodemap. Entries are allocated and freed on the writer side only. In the
+ * UA_NODEMAP_CONCURRENT mode, removed entries are returned to the pool in
+ * reclaim after the readers have left. */
+#define UA_NODEMAP_SLABENTRIES 64
+
+typedef struct UA_NodeMapSlab {
+    struct UA_NodeMapSlab *next;
+    size_t size; /* Bytes including the header */
+} UA_NodeMapSlab;
 
 typedef struct {
-    UA_NodeMapSlot *slots;
-    UA_UInt32 size;
+    size_t entrySize;
+    UA_NodeMapSlab *slabs;
+    void *freeList; /* Linked via the first pointer of the free entries */
+} UA_NodeMapPool;
+
+typedef struct UA_NodeMap {
+    UA_NodeMapTable * volatile table;
     UA_UInt32 count;
-    UA_UInt32 sizePrimeIndex;
+
+    /* Indexed by the bit position of the NodeClass */
+    UA_NodeMapPool pools[8];
+
+    /* A frozen nodemap is read-only. It can be used as the base of
+     * several layered nodemaps at the same time. */
+    UA_Boolean frozen;
+    const struct UA_NodeMap *base;
+    UA_NodestoreImage *image; /* Reference released with the nodemap */
 
     /* Maps ReferenceTypeIndex to the NodeId of the ReferenceType */
     UA_NodeId referenceTypeIds[UA_REFERENCETYPESET_MAX];
     UA_Byte referenceTypeCounter;
+
+    /* Materialized compact nodes (CLOCK cache) */
+    UA_NodeMapEntry **cache;
+    size_t cacheSize;
+    size_t cacheHand;
+
+    /* Increased whenever an entry can be freed or moved. The pointers to
+     * target nodes cached in the references are valid only for the
+     * generation they were cached in. */
+    UA_UInt32 generation;
+
+#ifdef UA_NODEMAP_CONCURRENT
+    volatile uint32_t epoch; /* The lowest bit selects the reader counter */
+    volatile uint32_t readers[2];
+    UA_NodeMapEntry *retiredEntries[2];
+    UA_NodeMapTable *retiredTables[2];
+#endif
 } UA_NodeMap;
 
 /*********************/
 /* HashMap Utilities */
 /*********************/
 
-/* The size of the hash-map is always a prime number. They are chosen to be
- * close to the next power of 2. So the size ca. doubles with each prime. */
-static UA_UInt32 const primes[] = {
-    7,         13,         31,         61,         127,         251,
-    509,       1021,       2039,       4093,       8191,        16381,
-    32749,     65521,      131071,     262139,     524287,      1048573,
-    2097143,   4194301,    8388593,    16777213,   33554393,    67108859,
-    134217689, 268435399,  536870909,  1073741789, 2147483647,  4294967291
-};
+/* UA_NodeId_hash ends with an avalanche step. So the lower bits can be
+ * masked for the slot and the upper bits are used for the tag. */
+static UA_UInt32
+slotHash(const UA_NodeId *nodeid) {
+    return UA_NodeId_hash(nodeid);
+}
 
-static UA_UInt32 mod(UA_UInt32 h, UA_UInt32 size) { return h % size; }
-static UA_UInt32 mod2(UA_UInt32 h, UA_UInt32 size) { return 1 + (h % (size - 2)); }
-
-static UA_UInt16
-higher_prime_index(UA_UInt32 n) {
-    UA_UInt16 low  = 0;
-    UA_UInt16 high = (UA_UInt16)(sizeof(primes) / sizeof(UA_UInt32));
-    while(low != high) {
-        UA_UInt16 mid = (UA_UInt16)(low + ((high - low) / 2));
-        if(n > primes[mid])
-            low = (UA_UInt16)(mid + 1);
-        else
-            high = mid;
-    }
-    return low;
-}
-
-/* Returns an empty slot or null if the nodeid exists or if no empty slot is found. */
-static UA_NodeMapSlot *
-findFreeSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow  */
-    UA_UInt32 startIdx = (UA_UInt32)idx;
-    UA_UInt32 hash2 = mod2(h, size);
-
-    UA_NodeMapSlot *candidate = NULL;
-    do {
-        UA_NodeMapSlot *slot = &ns->slots[(UA_UInt32)idx];
-
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
-            /* A Node with the NodeId does already exist */
-            if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
-                return NULL;
-        } else {
-            /* Found a candidate node */
-            if(!candidate)
-                candidate = slot;
-            /* No matching node can come afterwards */
-            if(slot->entry == NULL)
-                return candidate;
-        }
+static UA_Byte hashTag(UA_UInt32 h) { return (UA_Byte)(h >> 25); }
 
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx);
+static UA_UInt64
+slotKey(const UA_NodeId *nodeid, UA_UInt32 h) {
+    if(nodeid->identifierType == UA_NODEIDTYPE_NUMERIC)
+        return ((UA_UInt64)nodeid->namespaceIndex << 32) | nodeid->identifier.numeric;
+    return UA_NODEMAP_HASHKEY | h;
+}
 
-    return candidate;
+#define UA_NODEMAP_LSB 0x0101010101010101ull
+#define UA_NODEMAP_MSB 0x8080808080808080ull
+
+/* Non-zero if any of the eight control bytes equals c. The position of the
+ * flag bits is not exact. So the candidates are checked one by one. */
+static UA_UInt64
+groupMatch(const UA_Byte *ctrl, UA_Byte c) {
+    UA_UInt64 g;
+    memcpy(&g, ctrl, UA_NODEMAP_GROUPSIZE);
+    g ^= UA_NODEMAP_LSB * c;
+    return (g - UA_NODEMAP_LSB) & ~g & UA_NODEMAP_MSB;
 }
 
-/* The occupancy of the table after the call will be about 50% */
-static UA_StatusCode
-expand(UA_NodeMap *ns) {
-    UA_UInt32 osize = ns->size;
-    UA_UInt32 count = ns->count;
-    /* Resize only when table after removal of unused elements is either too
-       full or too empty */
-    if(count * 2 < osize && (count * 8 > osize || osize <= UA_NODEMAP_MINSIZE))
-        return UA_STATUSCODE_GOOD;
-
-    UA_NodeMapSlot *oslots = ns->slots;
-    UA_UInt32 nindex = higher_prime_index(count * 2);
-    UA_UInt32 nsize = primes[nindex];
-    UA_NodeMapSlot *nslots= (UA_NodeMapSlot*)UA_calloc(nsize, sizeof(UA_NodeMapSlot));
-    if(!nslots)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+/* The smallest power of two with an occupancy of at most 50% */
+static UA_UInt32
+tableSize(UA_UInt32 count) {
+    UA_UInt64 size = UA_NODEMAP_MINSIZE;
+    while(size < (UA_UInt64)count * 2 && size < ((UA_UInt64)1 << 31))
+        size <<= 1;
+    return (UA_UInt32)size;
+}
 
-    ns->slots = nslots;
-    ns->size = nsize;
-    ns->sizePrimeIndex = nindex;
+static UA_NodeMapTable *
+newTable(UA_UInt32 size) {
+    /* The arrays are in the order of their alignment */
+    size_t keysOff = (sizeof(UA_NodeMapTable) + 7) & ~(size_t)7;
+    size_t entriesOff = keysOff + (size * sizeof(UA_UInt64));
+    size_t ctrlOff = entriesOff + (size * sizeof(UA_NodeMapEntry*));
+    UA_Byte *mem = (UA_Byte*)UA_malloc(ctrlOff + size);
+    if(!mem)
+        return NULL;
+    UA_NodeMapTable *t = (UA_NodeMapTable*)mem;
+    t->retiredNext = NULL;
+    t->size = size;
+    t->tombstones = 0;
+    t->keys = (UA_UInt64*)(mem + keysOff);
+    t->entries = (UA_NodeMapEntry * volatile *)(mem + entriesOff);
+    t->ctrl = mem + ctrlOff;
+    memset(mem + entriesOff, 0, size * sizeof(UA_NodeMapEntry*));
+    memset(t->ctrl, UA_NODEMAP_EMPTY, size);
+    return t;
+}
 
-    /* recompute the position of every entry and insert the pointer */
-    for(size_t i = 0, j = 0; i < osize && j < count; ++i) {
-        if(oslots[i].entry <= UA_NODEMAP_TOMBSTONE)
-            continue;
-        UA_NodeMapSlot *s = findFreeSlot(ns, &oslots[i].entry->node.head.nodeId);
-        UA_assert(s);
-        *s = oslots[i];
-        ++j;
-    }
+/* Returns the index of an empty slot. Or UA_UINT32_MAX if the nodeid exists
+ * (or if no empty slot is found). */
+static UA_UInt32
+findFreeSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid, UA_UInt32 h) {
+    UA_Byte tag = hashTag(h);
+    UA_UInt64 key = slotKey(nodeid, h);
+    UA_UInt32 candidate = UA_UINT32_MAX;
+    UA_UInt32 groups = t->size / UA_NODEMAP_GROUPSIZE;
+    UA_UInt32 g = h & (groups - 1);
+    /* Probe the groups with triangular steps (1, 2, 3, ...). For a
+     * power-of-two number of groups, this visits every group exactly once. */
+    for(UA_UInt32 step = 1; step <= groups; step++) {
+        UA_UInt32 base = g * UA_NODEMAP_GROUPSIZE;
+        const UA_Byte *ctrl = &t->ctrl[base];
+        /* A Node with the NodeId does already exist? */
+        if(groupMatch(ctrl, tag)) {
+            for(UA_UInt32 j = 0; j < UA_NODEMAP_GROUPSIZE; j++) {
+                if(ctrl[j] == tag && t->keys[base + j] == key &&
+                   UA_NodeId_equal(&t->entries[base + j]->node.head.nodeId, nodeid))
+                    return UA_UINT32_MAX;
+            }
+        }
 
-    UA_free(oslots);
-    return UA_STATUSCODE_GOOD;
+        /* Remember the first EMPTY or DELETED slot as a candidate */
+        if(candidate == UA_UINT32_MAX) {
+            for(UA_UInt32 j = 0; j < UA_NODEMAP_GROUPSIZE; j++) {
+                if(ctrl[j] & 0x80) {
+                    candidate = base + j;
+                    break;
+                }
+            }
+        }
+
+        /* No matching node can come afterwards */
+        if(groupMatch(ctrl, UA_NODEMAP_EMPTY))
+            return candidate;
+        g = (g + step) & (groups - 1);
+    }
+    return candidate;
 }
 
-static UA_NodeMapEntry *
-createEntry(UA_NodeClass nodeClass) {
+/********************/
+/* Entry Allocation */
+/********************/
+
+/* Returns zero for an unknown NodeClass. Rounded up to keep the entries in
+ * the slab aligned. */
+static size_t
+entrySize(UA_NodeClass nodeClass) {
     size_t size = sizeof(UA_NodeMapEntry) - sizeof(UA_Node);
     switch(nodeClass) {
     case UA_NODECLASS_OBJECT:
@@ -177,70 +290,987 @@ createEntry(UA_NodeClass nodeClass) {
         size += sizeof(UA_ViewNode);
         break;
     default:
-        return NULL;
+        return 0;
     }
-    UA_NodeMapEntry *entry = (UA_NodeMapEntry*)UA_calloc(1, size);
-    if(!entry)
+    return (size + 15) & ~(size_t)15;
+}
+
+static UA_NodeMapPool *
+getPool(UA_NodeMap *ns, UA_NodeClass nodeClass) {
+    size_t i = 0;
+    while(i < 7 && !((UA_UInt32)nodeClass & (1u << i)))
+        i++;
+    return &ns->pools[i];
+}
+
+static UA_NodeMapEntry *
+createEntry(UA_NodeMap *ns, UA_NodeClass nodeClass) {
+    size_t size = entrySize(nodeClass);
+    if(size == 0)
         return NULL;
+    UA_NodeMapPool *pool = getPool(ns, nodeClass);
+
+    /* Add a slab and put its entries into the free list */
+    if(!pool->freeList) {
+        size_t slabSize = sizeof(UA_NodeMapSlab) + (size * UA_NODEMAP_SLABENTRIES);
+        UA_NodeMapSlab *slab = (UA_NodeMapSlab*)UA_malloc(slabSize);
+        if(!slab)
+            return NULL;
+        slab->size = slabSize;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        pool->entrySize = size;
+        UA_Byte *pos = (UA_Byte*)slab + sizeof(UA_NodeMapSlab);
+        for(size_t i = 0; i < UA_NODEMAP_SLABENTRIES; i++) {
+            *(void**)pos = pool->freeList;
+            pool->freeList = pos;
+            pos += size;
+        }
+    }
+
+    UA_NodeMapEntry *entry = (UA_NodeMapEntry*)pool->freeList;
+    pool->freeList = *(void**)entry;
+    memset(entry, 0, size);
     entry->node.head.nodeClass = nodeClass;
     return entry;
 }
 
+#ifndef UA_NODEMAP_CONCURRENT
 static void
-deleteNodeMapEntry(UA_NodeMapEntry *entry) {
-    UA_Node_clear(&entry->node);
-    UA_free(entry);
+untrackEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    for(size_t i = 0; i < ns->cacheSize; i++) {
+        if(ns->cache[i] == entry) {
+            ns->cache[i] = NULL;
+            break;
+        }
+    }
+    entry->tracked = false;
 }
 
+/* The tracked entries stay decoded until they are tracked again */
 static void
-cleanupNodeMapEntry(UA_NodeMapEntry *entry) {
-    if(entry->refCount > 0)
+clearCache(UA_NodeMap *ns) {
+    for(size_t i = 0; i < ns->cacheSize; i++) {
+        if(ns->cache[i])
+            ns->cache[i]->tracked = false;
+    }
+    UA_free(ns->cache);
+    ns->cache = NULL;
+    ns->cacheSize = 0;
+    ns->cacheHand = 0;
+}
+#endif
+
+/* Whiteouts and compact entries only contain the NodeHead. They are allocated
+ * individually, as well as the decoded entries. */
+static void
+deleteNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    if(entry->whiteout) {
+        UA_Node_clear(&entry->node);
+        UA_free(entry);
         return;
-    if(entry->deleted) {
-        deleteNodeMapEntry(entry);
+    }
+    if(entry->compact) {
+        UA_NodeMapCompactEntry *ce =
+            container_of(entry, UA_NodeMapCompactEntry, entry);
+        UA_NodeId_clear(&entry->node.head.nodeId);
+        UA_ByteString_clear(&ce->encoded);
+        UA_free(ce);
+        return;
+    }
+#ifndef UA_NODEMAP_CONCURRENT
+    if(entry->decoded) {
+        if(entry->tracked)
+            untrackEntry(ns, entry);
+        UA_Node_clear(&entry->node);
+        UA_free(entry);
         return;
     }
+#endif
+    UA_NodeMapPool *pool = getPool(ns, entry->node.head.nodeClass);
+    UA_Node_clear(&entry->node);
+    *(void**)entry = pool->freeList;
+    pool->freeList = entry;
+}
+
+/* Release all slabs at once. The nodes have to be cleared before. */
+static void
+clearPools(UA_NodeMap *ns) {
+    for(size_t i = 0; i < 8; i++) {
+        UA_NodeMapSlab *slab = ns->pools[i].slabs;
+        while(slab) {
+            UA_NodeMapSlab *next = slab->next;
+            UA_free(slab);
+            slab = next;
+        }
+        ns->pools[i].slabs = NULL;
+        ns->pools[i].freeList = NULL;
+    }
+}
+
+#ifdef UA_NODEMAP_CONCURRENT
+
+static UA_UInt32
+readerEnter(UA_NodeMap *ns) {
+    while(true) {
+        UA_UInt32 e = ns->epoch & 0x01;
+        UA_atomic_addUInt32(&ns->readers[e], 1);
+        if((ns->epoch & 0x01) == e)
+            return e;
+        /* The epoch was advanced in between. Try again. */
+        UA_atomic_subUInt32(&ns->readers[e], 1);
+    }
+}
+
+static void
+readerLeave(UA_NodeMap *ns, UA_UInt32 e) {
+    UA_atomic_subUInt32(&ns->readers[e], 1);
+}
+
+static void
+retireEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    UA_UInt32 e = ns->epoch & 0x01;
+    entry->deleted = true;
+    entry->retiredNext = ns->retiredEntries[e];
+    ns->retiredEntries[e] = entry;
+}
+
+/* Called by the writer. Frees what was retired during the previous-but-one
+ * epoch if no reader from that epoch remains. */
+static void
+reclaim(UA_NodeMap *ns) {
+    UA_UInt32 next = (ns->epoch + 1) & 0x01;
+    if(ns->readers[next] > 0)
+        return; /* Try again later */
+
+    UA_NodeMapTable *t = ns->retiredTables[next];
+    ns->retiredTables[next] = NULL;
+    while(t) {
+        UA_NodeMapTable *tnext = t->retiredNext;
+        UA_free(t);
+        t = tnext;
+    }
+
+    /* Entries that are still referenced remain in the list. They become
+     * unreachable for new readers right away. */
+    UA_NodeMapEntry *entry = ns->retiredEntries[next];
+    ns->retiredEntries[next] = NULL;
+    while(entry) {
+        UA_NodeMapEntry *enext = entry->retiredNext;
+        if(entry->refCount == 0) {
+            deleteNodeMapEntry(ns, entry);
+        } else {
+            entry->retiredNext = ns->retiredEntries[next];
+            ns->retiredEntries[next] = entry;
+        }
+        entry = enext;
+    }
+
+    UA_atomic_addUInt32(&ns->epoch, 1);
+}
+
+#endif /* UA_NODEMAP_CONCURRENT */
+
+/* Store the slot entry. The key is set before and the control byte afterwards.
+ * Compare-and-swap is a full barrier. So the readers see the node content once
+ * they see the entry. (There is only one writer and the swap always
+ * succeeds.) */
+static void
+setSlotEntry(UA_NodeMapTable *t, UA_UInt32 idx, UA_NodeMapEntry *entry) {
+#ifdef UA_NODEMAP_CONCURRENT
+    UA_atomic_cmpxchg((void * volatile *)&t->entries[idx], t->entries[idx], entry);
+#else
+    t->entries[idx] = entry;
+#endif
+}
+
+static void
+occupySlot(UA_NodeMapTable *t, UA_UInt32 idx, const UA_NodeId *nodeid,
+           UA_UInt32 h, UA_NodeMapEntry *entry) {
+    if(t->ctrl[idx] == UA_NODEMAP_DELETED)
+        t->tombstones--;
+    t->keys[idx] = slotKey(nodeid, h);
+    setSlotEntry(t, idx, entry);
+    t->ctrl[idx] = hashTag(h);
+}
+
+/* Rebuild the table without the tombstones. The occupancy of the table after
+ * the call will be about 25-50%. */
+static UA_StatusCode
+expand(UA_NodeMap *ns) {
+    UA_NodeMapTable *ot = ns->table;
+    UA_UInt32 count = ns->count;
+    UA_NodeMapTable *nt = newTable(tableSize(count));
+    if(!nt)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* recompute the position of every entry and insert the pointer */
+    for(size_t i = 0, j = 0; i < ot->size && j < count; ++i) {
+        if(ot->ctrl[i] & 0x80)
+            continue;
+        UA_NodeMapEntry *entry = ot->entries[i];
+        UA_UInt32 h = slotHash(&entry->node.head.nodeId);
+        UA_UInt32 idx = findFreeSlot(nt, &entry->node.head.nodeId, h);
+        UA_assert(idx != UA_UINT32_MAX);
+        nt->keys[idx] = ot->keys[i];
+        nt->entries[idx] = entry;
+        nt->ctrl[idx] = ot->ctrl[i];
+        ++j;
+    }
+
+    /* Publish the new table. Readers may still be in the old table. */
+#ifdef UA_NODEMAP_CONCURRENT
+    UA_atomic_cmpxchg((void * volatile *)&ns->table, ot, nt);
+    UA_UInt32 e = ns->epoch & 0x01;
+    ot->retiredNext = ns->retiredTables[e];
+    ns->retiredTables[e] = ot;
+#else
+    ns->table = nt;
+    UA_free(ot);
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Use a tree for the references if there are many of them */
+static void
+switchReferenceKinds(UA_NodeMapEntry *entry) {
     for(size_t i = 0; i < entry->node.head.referencesSize; i++) {
         UA_NodeReferenceKind *rk = &entry->node.head.references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
+        if(rk->targetsSize > UA_NODEREFERENCEKIND_TREETHRESHOLD &&
+           !rk->hasRefTree)
             UA_NodeReferenceKind_switch(rk);
     }
 }
 
-static UA_NodeMapSlot *
-findOccupiedSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid) {
-    UA_UInt32 h = UA_NodeId_hash(nodeid);
-    UA_UInt32 size = ns->size;
-    UA_UInt64 idx = mod(h, size); /* Use 64bit container to avoid overflow */
-    UA_UInt32 hash2 = mod2(h, size);
-    UA_UInt32 startIdx = (UA_UInt32)idx;
+/* In the UA_NODEMAP_CONCURRENT mode, published nodes might be read at any time.
+ * The references are switched before publishing and the entries are freed in
+ * reclaim. */
+#ifndef UA_NODEMAP_CONCURRENT
+static void
+cleanupNodeMapEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    if(entry->refCount > 0)
+        return;
+    if(entry->deleted) {
+        deleteNodeMapEntry(ns, entry);
+        return;
+    }
+    switchReferenceKinds(entry);
+}
+#endif
 
-    do {
-        UA_NodeMapSlot *slot= &ns->slots[(UA_UInt32)idx];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
-            if(slot->nodeIdHash == h &&
-               UA_NodeId_equal(&slot->entry->node.head.nodeId, nodeid))
-                return slot;
-        } else {
-            if(slot->entry == NULL)
-                return NULL; /* No further entry possible */
+/* The entry was removed from the table */
+static void
+dropEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+#ifdef UA_NODEMAP_CONCURRENT
+    retireEntry(ns, entry);
+#else
+    entry->deleted = true;
+    cleanupNodeMapEntry(ns, entry);
+#endif
+}
+
+static UA_NodeMapEntry *
+createWhiteout(const UA_NodeId *nodeid) {
+    UA_NodeMapEntry *entry = (UA_NodeMapEntry*)
+        UA_calloc(1, sizeof(UA_NodeMapEntry) - sizeof(UA_Node) + sizeof(UA_NodeHead));
+    if(!entry)
+        return NULL;
+    if(UA_NodeId_copy(nodeid, &entry->node.head.nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(entry);
+        return NULL;
+    }
+    entry->whiteout = true;
+    return entry;
+}
+
+/* Returns the slot index or UA_UINT32_MAX. The entry of the slot is returned
+ * as well. It is read only once, as the slot can be changed concurrently (in
+ * UA_NODEMAP_CONCURRENT mode). Then the control byte and the key are only
+ * used as a filter and the NodeId of the entry is always compared. */
+static UA_UInt32
+findOccupiedSlot(const UA_NodeMapTable *t, const UA_NodeId *nodeid,
+                 UA_NodeMapEntry **outEntry) {
+    UA_UInt32 h = slotHash(nodeid);
+    UA_Byte tag = hashTag(h);
+    UA_UInt64 key = slotKey(nodeid, h);
+    UA_UInt32 groups = t->size / UA_NODEMAP_GROUPSIZE;
+    UA_UInt32 g = h & (groups - 1);
+    for(UA_UInt32 step = 1; step <= groups; step++) {
+        UA_UInt32 base = g * UA_NODEMAP_GROUPSIZE;
+        const UA_Byte *ctrl = &t->ctrl[base];
+        if(groupMatch(ctrl, tag)) {
+            for(UA_UInt32 j = 0; j < UA_NODEMAP_GROUPSIZE; j++) {
+                if(ctrl[j] != tag || t->keys[base + j] != key)
+                    continue;
+                UA_NodeMapEntry *entry = t->entries[base + j];
+                if(!entry)
+                    continue;
+#ifndef UA_NODEMAP_CONCURRENT
+                if(!(key & UA_NODEMAP_HASHKEY)) {
+                    *outEntry = entry; /* The key is the numeric NodeId */
+                    return base + j;
+                }
+#endif
+                if(UA_NodeId_equal(&entry->node.head.nodeId, nodeid)) {
+                    *outEntry = entry;
+                    return base + j;
+                }
+            }
+        }
+        if(groupMatch(ctrl, UA_NODEMAP_EMPTY))
+            return UA_UINT32_MAX; /* No further entry possible */
+        g = (g + step) & (groups - 1);
+    }
+    return UA_UINT32_MAX;
+}
+
+/*****************/
+/* Compact Nodes */
+/*****************/
+
+/* Rarely used nodes (e.g. most of namespace zero) can be kept in a compact
+ * binary encoding. The slot then points to a compact entry where only the
+ * NodeHead with the NodeId and NodeClass is allocated. The node is
+ * materialized when it is accessed. Materialized nodes are tracked in a cache
+ * with the CLOCK algorithm. When the cache is full, the next node that was not
+ * accessed since the last sweep is compacted again, including the changes of
+ * in-situ edits. Nodes that are replaced (getNodeCopy and replaceNode) are
+ * allocated from the pools and stay materialized.
+ *
+ * The attributes are encoded as an array of Variants. Only nodes without
+ * open62541-specific members (context, callbacks, lifecycle, MonitoredItems)
+ * are compacted. The values need to use the standard types, as the Nodestore
+ * does not know the custom types of the server.
+ *
+ * Materializing modifies the table during getNode. So this is not available
+ * with concurrent readers. */
+
+#ifndef UA_NODEMAP_CONCURRENT
+
+/* Position of the attributes in the array of Variants. The attributes of the
+ * NodeClass follow. */
+enum {
+    UA_COMPACT_BROWSENAME = 0,
+    UA_COMPACT_DISPLAYNAME,   /* LocalizedText[] */
+    UA_COMPACT_DESCRIPTION,   /* LocalizedText[] */
+    UA_COMPACT_WRITEMASK,
+    UA_COMPACT_CONSTRUCTED,
+    UA_COMPACT_REFTYPES,      /* Byte[] ReferenceTypeIndex per ReferenceKind */
+    UA_COMPACT_REFINVERSE,    /* Boolean[] per ReferenceKind */
+    UA_COMPACT_REFSIZES,      /* UInt32[] number of targets per ReferenceKind */
+    UA_COMPACT_TARGETS,       /* ExpandedNodeId[] of all ReferenceKinds */
+    UA_COMPACT_TARGETHASHES,  /* UInt32[] BrowseName hash of the targets */
+    UA_COMPACT_HEADSIZE
+};
+
+#define UA_COMPACT_MAXFIELDS (UA_COMPACT_HEADSIZE + 8)
+
+static UA_Boolean
+isStandardValue(const UA_DataValue *v) {
+    const UA_DataType *type = v->value.type;
+    if(!v->hasValue || !type)
+        return true;
+    if(type < &UA_TYPES[0] || type >= &UA_TYPES[UA_TYPES_COUNT])
+        return false;
+    /* Nested values can contain custom types */
+    return (type != &UA_TYPES[UA_TYPES_VARIANT] &&
+            type != &UA_TYPES[UA_TYPES_EXTENSIONOBJECT] &&
+            type != &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static UA_Boolean
+isCompactable(const UA_NodeMapEntry *entry) {
+    const UA_Node *node = &entry->node;
+    if(entry->frozen || entry->whiteout || entry->compact ||
+       entry->refCount > 0 || node->head.context)
+        return false;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(node->head.monitoredItems || node->head.samplingGroups)
+        return false;
+#endif
+    switch(node->head.nodeClass) {
+    case UA_NODECLASS_VARIABLE:
+    case UA_NODECLASS_VARIABLETYPE: {
+        const UA_VariableNode *vn = &node->variableNode;
+        if(vn->valueSource != UA_VALUESOURCE_DATA ||
+           vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE ||
+           vn->value.data.callback.onRead || vn->value.data.callback.onWrite ||
+           !isStandardValue(&vn->value.data.value))
+            return false;
+        if(node->head.nodeClass == UA_NODECLASS_VARIABLE)
+            return true;
+        return (!node->variableTypeNode.lifecycle.constructor &&
+                !node->variableTypeNode.lifecycle.destructor);
+    }
+    case UA_NODECLASS_OBJECTTYPE:
+        return (!node->objectTypeNode.lifecycle.constructor &&
+                !node->objectTypeNode.lifecycle.destructor);
+    case UA_NODECLASS_METHOD:
+        return (!node->methodNode.method && !node->methodNode.methodBatch);
+    case UA_NODECLASS_REFERENCETYPE:
+        return false; /* Used for every browse. Also small in number. */
+    default:
+        return true;
+    }
+}
+
+typedef struct {
+    UA_ExpandedNodeId *targets;
+    UA_UInt32 *hashes;
+    size_t pos;
+} CompactTargets;
+
+static void *
+collectTarget(void *context, UA_ReferenceTarget *t) {
+    CompactTargets *ct = (CompactTargets*)context;
+    ct->targets[ct->pos] = UA_NodePointer_toExpandedNodeId(t->targetId);
+    ct->hashes[ct->pos] = t->targetNameHash;
+    ct->pos++;
+    return NULL;
+}
+
+static size_t
+countLocalizedTexts(const UA_LocalizedTextListEntry *lt) {
+    size_t count = 0;
+    for(; lt; lt = lt->next)
+        count++;
+    return count;
+}
+
+static void
+setScalarField(UA_Variant *field, const void *p, size_t typeIndex) {
+    UA_Variant_setScalar(field, (void*)(uintptr_t)p, &UA_TYPES[typeIndex]);
+}
+
+/* Empty arrays need the sentinel. Otherwise they are taken for scalars. */
+static void
+setArrayField(UA_Variant *field, const void *p, size_t size, size_t typeIndex) {
+    if(size == 0)
+        p = UA_EMPTY_ARRAY_SENTINEL;
+    UA_Variant_setArray(field, (void*)(uintptr_t)p, size, &UA_TYPES[typeIndex]);
+}
+
+static size_t
+setVariableFields(UA_Variant *fields, const UA_VariableNode *vn) {
+    setScalarField(&fields[0], &vn->dataType, UA_TYPES_NODEID);
+    setScalarField(&fields[1], &vn->valueRank, UA_TYPES_INT32);
+    setArrayField(&fields[2], vn->arrayDimensions, vn->arrayDimensionsSize,
+                  UA_TYPES_UINT32);
+    setScalarField(&fields[3], &vn->value.data.value, UA_TYPES_DATAVALUE);
+    return 4;
+}
+
+/* The fields point into the node. Only the arrays for the lists and the
+ * references are allocated temporarily. */
+static UA_StatusCode
+encodeCompact(const UA_Node *node, UA_ByteString *encoded) {
+    const UA_NodeHead *head = &node->head;
+    UA_Variant fields[UA_COMPACT_MAXFIELDS];
+    memset(fields, 0, sizeof(fields));
+
+    /* Allocate the temporary arrays at once. The types with the largest
+     * alignment come first. */
+    size_t dnSize = countLocalizedTexts(head->displayName);
+    size_t descSize = countLocalizedTexts(head->description);
+    size_t refsSize = head->referencesSize;
+    size_t targetsSize = 0;
+    for(size_t i = 0; i < refsSize; i++)
+        targetsSize += head->references[i].targetsSize;
+    size_t bufSize = (targetsSize * sizeof(UA_ExpandedNodeId)) +
+        ((dnSize + descSize) * sizeof(UA_LocalizedText)) +
+        ((targetsSize + refsSize) * sizeof(UA_UInt32)) +
+        (refsSize * (sizeof(UA_Byte) + sizeof(UA_Boolean)));
+    UA_Byte *buf = (UA_Byte*)UA_malloc(bufSize + 1);
+    if(!buf)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    CompactTargets ct;
+    ct.targets = (UA_ExpandedNodeId*)buf;
+    UA_LocalizedText *dn = (UA_LocalizedText*)&ct.targets[targetsSize];
+    UA_LocalizedText *desc = &dn[dnSize];
+    ct.hashes = (UA_UInt32*)&desc[descSize];
+    UA_UInt32 *refSizes = &ct.hashes[targetsSize];
+    UA_Byte *refTypes = (UA_Byte*)&refSizes[refsSize];
+    UA_Boolean *refInverse = (UA_Boolean*)&refTypes[refsSize];
+    ct.pos = 0;
+
+    size_t i = 0;
+    for(const UA_LocalizedTextListEntry *lt = head->displayName; lt; lt = lt->next)
+        dn[i++] = lt->localizedText;
+    i = 0;
+    for(const UA_LocalizedTextListEntry *lt = head->description; lt; lt = lt->next)
+        desc[i++] = lt->localizedText;
+    for(i = 0; i < refsSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        refTypes[i] = rk->referenceTypeIndex;
+        refInverse[i] = rk->isInverse;
+        refSizes[i] = (UA_UInt32)rk->targetsSize;
+        UA_NodeReferenceKind_iterate(rk, collectTarget, &ct);
+    }
+
+    setScalarField(&fields[UA_COMPACT_BROWSENAME], &head->browseName,
+                   UA_TYPES_QUALIFIEDNAME);
+    setArrayField(&fields[UA_COMPACT_DISPLAYNAME], dn, dnSize,
+                  UA_TYPES_LOCALIZEDTEXT);
+    setArrayField(&fields[UA_COMPACT_DESCRIPTION], desc, descSize,
+                  UA_TYPES_LOCALIZEDTEXT);
+    setScalarField(&fields[UA_COMPACT_WRITEMASK], &head->writeMask, UA_TYPES_UINT32);
+    setScalarField(&fields[UA_COMPACT_CONSTRUCTED], &head->constructed,
+                   UA_TYPES_BOOLEAN);
+    setArrayField(&fields[UA_COMPACT_REFTYPES], refTypes, refsSize, UA_TYPES_BYTE);
+    setArrayField(&fields[UA_COMPACT_REFINVERSE], refInverse, refsSize,
+                  UA_TYPES_BOOLEAN);
+    setArrayField(&fields[UA_COMPACT_REFSIZES], refSizes, refsSize, UA_TYPES_UINT32);
+    setArrayField(&fields[UA_COMPACT_TARGETS], ct.targets, targetsSize,
+                  UA_TYPES_EXPANDEDNODEID);
+    setArrayField(&fields[UA_COMPACT_TARGETHASHES], ct.hashes, targetsSize,
+                  UA_TYPES_UINT32);
+
+    UA_Variant *cf = &fields[UA_COMPACT_HEADSIZE];
+    size_t fieldsSize = UA_COMPACT_HEADSIZE;
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        const UA_VariableNode *vn = &node->variableNode;
+        fieldsSize += setVariableFields(cf, vn);
+        setScalarField(&cf[4], &vn->accessLevel, UA_TYPES_BYTE);
+        setScalarField(&cf[5], &vn->minimumSamplingInterval, UA_TYPES_DOUBLE);
+        setScalarField(&cf[6], &vn->historizing, UA_TYPES_BOOLEAN);
+        setScalarField(&cf[7], &vn->isDynamic, UA_TYPES_BOOLEAN);
+        fieldsSize += 4;
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        fieldsSize += setVariableFields(cf, &node->variableNode);
+        setScalarField(&cf[4], &node->variableTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        fieldsSize += 1;
+        break;
+    case UA_NODECLASS_METHOD:
+        setScalarField(&cf[0], &node->methodNode.executable, UA_TYPES_BOOLEAN);
+        fieldsSize += 1;
+        break;
+    case UA_NODECLASS_OBJECT:
+        setScalarField(&cf[0], &node->objectNode.eventNotifier, UA_TYPES_BYTE);
+        fieldsSize += 1;
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        setScalarField(&cf[0], &node->objectTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        fieldsSize += 1;
+        break;
+    case UA_NODECLASS_DATATYPE:
+        setScalarField(&cf[0], &node->dataTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        fieldsSize += 1;
+        break;
+    case UA_NODECLASS_VIEW:
+        setScalarField(&cf[0], &node->viewNode.eventNotifier, UA_TYPES_BYTE);
+        setScalarField(&cf[1], &node->viewNode.containsNoLoops, UA_TYPES_BOOLEAN);
+        fieldsSize += 2;
+        break;
+    default:
+        UA_free(buf);
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
+    UA_Variant all;
+    UA_Variant_setArray(&all, fields, fieldsSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    UA_ByteString_init(encoded);
+    UA_StatusCode res = UA_encodeBinary(&all, &UA_TYPES[UA_TYPES_VARIANT], encoded);
+    UA_free(buf);
+    return res;
+}
+
+/* Move the scalar out of the decoded field */
+static UA_StatusCode
+takeScalar(UA_Variant *field, void *dst, size_t typeIndex) {
+    const UA_DataType *type = &UA_TYPES[typeIndex];
+    if(field->type != type || !UA_Variant_isScalar(field))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    memcpy(dst, field->data, type->memSize);
+    memset(field->data, 0, type->memSize);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+checkArray(const UA_Variant *field, size_t typeIndex, size_t size) {
+    if(field->type != &UA_TYPES[typeIndex] || UA_Variant_isScalar(field) ||
+       field->arrayLength != size)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Move the LocalizedTexts into the list. Prepend in reverse order to keep the
+ * order of the list. */
+static UA_StatusCode
+takeLocalizedTexts(UA_Variant *field, UA_LocalizedTextListEntry **list) {
+    if(field->type != &UA_TYPES[UA_TYPES_LOCALIZEDTEXT] || UA_Variant_isScalar(field))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_LocalizedText *lts = (UA_LocalizedText*)field->data;
+    for(size_t i = field->arrayLength; i > 0; i--) {
+        UA_LocalizedTextListEntry *lt = (UA_LocalizedTextListEntry*)
+            UA_malloc(sizeof(UA_LocalizedTextListEntry));
+        if(!lt)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        lt->localizedText = lts[i-1];
+        UA_LocalizedText_init(&lts[i-1]);
+        lt->next = *list;
+        *list = lt;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+takeReferences(UA_Variant *fields, UA_Node *node) {
+    UA_Variant *types = &fields[UA_COMPACT_REFTYPES];
+    if(types->type != &UA_TYPES[UA_TYPES_BYTE] || UA_Variant_isScalar(types))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    size_t refsSize = types->arrayLength;
+    UA_Variant *targets = &fields[UA_COMPACT_TARGETS];
+    if(targets->type != &UA_TYPES[UA_TYPES_EXPANDEDNODEID] ||
+       UA_Variant_isScalar(targets))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    size_t targetsSize = targets->arrayLength;
+    UA_StatusCode res = checkArray(&fields[UA_COMPACT_REFINVERSE],
+                                   UA_TYPES_BOOLEAN, refsSize);
+    res |= checkArray(&fields[UA_COMPACT_REFSIZES], UA_TYPES_UINT32, refsSize);
+    res |= checkArray(&fields[UA_COMPACT_TARGETHASHES], UA_TYPES_UINT32, targetsSize);
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    const UA_Byte *refTypes = (const UA_Byte*)types->data;
+    const UA_Boolean *refInverse = (const UA_Boolean*)fields[UA_COMPACT_REFINVERSE].data;
+    const UA_UInt32 *refSizes = (const UA_UInt32*)fields[UA_COMPACT_REFSIZES].data;
+    const UA_ExpandedNodeId *ts = (const UA_ExpandedNodeId*)targets->data;
+    const UA_UInt32 *hashes = (const UA_UInt32*)fields[UA_COMPACT_TARGETHASHES].data;
+    size_t pos = 0;
+    for(size_t i = 0; i < refsSize; i++) {
+        if(refSizes[i] > targetsSize - pos)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        for(size_t j = 0; j < refSizes[i]; j++, pos++) {
+            res = UA_Node_addReference(node, refTypes[i], !refInverse[i],
+                                       &ts[pos], hashes[pos]);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
         }
+    }
+    return UA_STATUSCODE_GOOD;
+}
 
-        idx += hash2;
-        if(idx >= size)
-            idx -= size;
-    } while((UA_UInt32)idx != startIdx);
+static UA_StatusCode
+takeVariableFields(UA_Variant *cf, size_t cfSize, UA_VariableNode *vn) {
+    if(cfSize < 4)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    UA_StatusCode res = takeScalar(&cf[0], &vn->dataType, UA_TYPES_NODEID);
+    res |= takeScalar(&cf[1], &vn->valueRank, UA_TYPES_INT32);
+    res |= takeScalar(&cf[3], &vn->value.data.value, UA_TYPES_DATAVALUE);
+    if(cf[2].type != &UA_TYPES[UA_TYPES_UINT32] || UA_Variant_isScalar(&cf[2]))
+        return UA_STATUSCODE_BADDECODINGERROR;
+    if(cf[2].arrayLength > 0) {
+        vn->arrayDimensions = (UA_UInt32*)cf[2].data;
+        vn->arrayDimensionsSize = cf[2].arrayLength;
+        cf[2].data = NULL;
+        cf[2].arrayLength = 0;
+    }
+    return res;
+}
 
+/* Decode into the node. The NodeId and NodeClass are already set. The node is
+ * cleaned up by the caller if this fails. */
+static UA_StatusCode
+decodeCompact(const UA_ByteString *encoded, UA_Node *node) {
+    UA_Variant all;
+    UA_StatusCode res =
+        UA_decodeBinary(encoded, &all, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Variant *fields = (UA_Variant*)all.data;
+    if(all.type != &UA_TYPES[UA_TYPES_VARIANT] || UA_Variant_isScalar(&all) ||
+       all.arrayLength < UA_COMPACT_HEADSIZE) {
+        UA_Variant_clear(&all);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+
+    UA_NodeHead *head = &node->head;
+    res |= takeScalar(&fields[UA_COMPACT_BROWSENAME], &head->browseName,
+                      UA_TYPES_QUALIFIEDNAME);
+    res |= takeScalar(&fields[UA_COMPACT_WRITEMASK], &head->writeMask,
+                      UA_TYPES_UINT32);
+    res |= takeScalar(&fields[UA_COMPACT_CONSTRUCTED], &head->constructed,
+                      UA_TYPES_BOOLEAN);
+    if(res == UA_STATUSCODE_GOOD)
+        res = takeLocalizedTexts(&fields[UA_COMPACT_DISPLAYNAME], &head->displayName);
+    if(res == UA_STATUSCODE_GOOD)
+        res = takeLocalizedTexts(&fields[UA_COMPACT_DESCRIPTION], &head->description);
+    if(res == UA_STATUSCODE_GOOD)
+        res = takeReferences(fields, node);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Variant_clear(&all);
+        return res;
+    }
+
+    UA_Variant *cf = &fields[UA_COMPACT_HEADSIZE];
+    size_t cfSize = all.arrayLength - UA_COMPACT_HEADSIZE;
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        UA_VariableNode *vn = &node->variableNode;
+        res = takeVariableFields(cf, cfSize, vn);
+        if(cfSize < 8) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+        res |= takeScalar(&cf[4], &vn->accessLevel, UA_TYPES_BYTE);
+        res |= takeScalar(&cf[5], &vn->minimumSamplingInterval, UA_TYPES_DOUBLE);
+        res |= takeScalar(&cf[6], &vn->historizing, UA_TYPES_BOOLEAN);
+        res |= takeScalar(&cf[7], &vn->isDynamic, UA_TYPES_BOOLEAN);
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        res = takeVariableFields(cf, cfSize, &node->variableNode);
+        if(cfSize < 5) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+        res |= takeScalar(&cf[4], &node->variableTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        break;
+    case UA_NODECLASS_METHOD:
+        res = takeScalar(&cf[0], &node->methodNode.executable, UA_TYPES_BOOLEAN);
+        break;
+    case UA_NODECLASS_OBJECT:
+        res = takeScalar(&cf[0], &node->objectNode.eventNotifier, UA_TYPES_BYTE);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        res = takeScalar(&cf[0], &node->objectTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        break;
+    case UA_NODECLASS_DATATYPE:
+        res = takeScalar(&cf[0], &node->dataTypeNode.isAbstract, UA_TYPES_BOOLEAN);
+        break;
+    case UA_NODECLASS_VIEW:
+        if(cfSize < 2) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            break;
+        }
+        res = takeScalar(&cf[0], &node->viewNode.eventNotifier, UA_TYPES_BYTE);
+        res |= takeScalar(&cf[1], &node->viewNode.containsNoLoops, UA_TYPES_BOOLEAN);
+        break;
+    default:
+        res = UA_STATUSCODE_BADDECODINGERROR;
+        break;
+    }
+    UA_Variant_clear(&all);
+    return (res != UA_STATUSCODE_GOOD) ? UA_STATUSCODE_BADDECODINGERROR : res;
+}
+
+/* Decode a compact entry into a new (unpublished) entry. Not taken from the
+ * pools. A new slab for a few decoded nodes would take more memory than the
+ * compaction saves. */
+static UA_NodeMapEntry *
+decodeEntry(UA_NodeMap *ns, const UA_NodeMapEntry *compact) {
+    const UA_NodeMapCompactEntry *ce =
+        container_of(compact, UA_NodeMapCompactEntry, entry);
+    UA_NodeClass nodeClass = compact->node.head.nodeClass;
+    UA_NodeMapEntry *entry = (UA_NodeMapEntry*)UA_calloc(1, entrySize(nodeClass));
+    if(!entry)
+        return NULL;
+    entry->node.head.nodeClass = nodeClass;
+    entry->decoded = true;
+    UA_StatusCode res =
+        UA_NodeId_copy(&compact->node.head.nodeId, &entry->node.head.nodeId);
+    if(res == UA_STATUSCODE_GOOD)
+        res = decodeCompact(&ce->encoded, &entry->node);
+    if(res != UA_STATUSCODE_GOOD) {
+        deleteNodeMapEntry(ns, entry);
+        return NULL;
+    }
+    switchReferenceKinds(entry);
+    return entry;
+}
+
+/* Replace the entry in the slot with a compact entry */
+static UA_StatusCode
+compactEntry(UA_NodeMap *ns, UA_UInt32 idx, UA_NodeMapEntry *entry) {
+    if(!isCompactable(entry))
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    UA_NodeMapCompactEntry *ce = (UA_NodeMapCompactEntry*)
+        UA_calloc(1, UA_NODEMAP_COMPACTSIZE);
+    if(!ce)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = encodeCompact(&entry->node, &ce->encoded);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_NodeId_copy(&entry->node.head.nodeId, &ce->entry.node.head.nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&ce->encoded);
+        UA_free(ce);
+        return res;
+    }
+    ce->entry.node.head.nodeClass = entry->node.head.nodeClass;
+    ce->entry.compact = true;
+    setSlotEntry(ns->table, idx, &ce->entry);
+    deleteNodeMapEntry(ns, entry);
+    ns->generation++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Add to the cache. Sweep over the cache until a node is found that was not
+ * accessed since the last sweep. That node is compacted again. If all tracked
+ * nodes are in use, the new node is not tracked and stays materialized. */
+static void
+trackEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    for(size_t i = 0; i < 2 * ns->cacheSize; i++) {
+        size_t pos = ns->cacheHand;
+        ns->cacheHand = (ns->cacheHand + 1) % ns->cacheSize;
+        UA_NodeMapEntry *old = ns->cache[pos];
+        if(old) {
+            if(old->recent) {
+                old->recent = false;
+                continue;
+            }
+            if(old->refCount > 0)
+                continue;
+            old->tracked = false;
+            UA_NodeMapEntry *found = NULL;
+            UA_UInt32 idx = findOccupiedSlot(ns->table, &old->node.head.nodeId, &found);
+            if(idx != UA_UINT32_MAX && found == old)
+                compactEntry(ns, idx, old); /* Stays materialized if this fails */
+        }
+        ns->cache[pos] = entry;
+        entry->tracked = true;
+        entry->recent = true;
+        return;
+    }
+}
+
+static UA_NodeMapEntry *
+materializeEntry(UA_NodeMap *ns, UA_UInt32 idx, UA_NodeMapEntry *compact) {
+    UA_NodeMapEntry *entry = decodeEntry(ns, compact);
+    if(!entry)
+        return NULL;
+    setSlotEntry(ns->table, idx, entry);
+    deleteNodeMapEntry(ns, compact);
+    if(ns->cacheSize > 0)
+        trackEntry(ns, entry);
+    return entry;
+}
+
+/* The entries of compacted nodes are returned to the free list of the pool.
+ * But the slabs are only released when the nodemap is deleted. Move the
+ * remaining entries into new slabs and release the old slabs. Only possible if
+ * no node is in use, as the entries change their address. */
+static void
+repackPools(UA_NodeMap *ns) {
+    UA_NodeMapTable *t = ns->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        if(t->entries[i] && t->entries[i]->refCount > 0)
+            return;
+    }
+
+    ns->generation++;
+    UA_NodeMapPool old[8];
+    memcpy(old, ns->pools, sizeof(old));
+    memset(ns->pools, 0, sizeof(ns->pools));
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->entries[i];
+        if(!entry || entry->whiteout || entry->compact || entry->decoded)
+            continue;
+        UA_NodeClass nodeClass = entry->node.head.nodeClass;
+        UA_NodeMapEntry *moved = createEntry(ns, nodeClass);
+        if(!moved) {
+            /* Out of memory. Keep the old slabs with the unmoved entries. The
+             * entries in their free lists are lost until the nodemap is
+             * deleted. */
+            for(size_t j = 0; j < 8; j++) {
+                UA_NodeMapSlab **last = &ns->pools[j].slabs;
+                while(*last)
+                    last = &(*last)->next;
+                *last = old[j].slabs;
+                if(old[j].entrySize > 0)
+                    ns->pools[j].entrySize = old[j].entrySize;
+            }
+            return;
+        }
+        memcpy(moved, entry, entrySize(nodeClass));
+        setSlotEntry(t, i, moved);
+    }
+
+    for(size_t j = 0; j < 8; j++) {
+        UA_NodeMapSlab *slab = old[j].slabs;
+        while(slab) {
+            UA_NodeMapSlab *next = slab->next;
+            UA_free(slab);
+            slab = next;
+        }
+    }
+}
+
+#endif /* UA_NODEMAP_CONCURRENT */
+
+/* Find the entry in the nodemap or in its base. Compact entries are
+ * materialized. */
+static UA_NodeMapEntry *
+findEntry(UA_NodeMap *ns, const UA_NodeId *nodeid) {
+    UA_NodeMapEntry *entry = NULL;
+    UA_UInt32 idx = findOccupiedSlot(ns->table, nodeid, &entry);
+    if(idx != UA_UINT32_MAX) {
+        if(entry->whiteout)
+            return NULL;
+#ifndef UA_NODEMAP_CONCURRENT
+        if(entry->compact)
+            return materializeEntry(ns, idx, entry);
+        if(entry->tracked)
+            entry->recent = true;
+        else if(entry->decoded && ns->cacheSize > 0)
+            trackEntry(ns, entry);
+#endif
+        return entry;
+    }
+    if(ns->base && findOccupiedSlot(ns->base->table, nodeid, &entry) != UA_UINT32_MAX)
+        return entry;
     return NULL;
 }
 
+/* Returns the slot for a new node. Or UA_UINT32_MAX if the NodeId is taken
+ * (also if taken in the base). If the NodeId is hidden by a whiteout, the slot
+ * of the whiteout is returned together with the whiteout entry. */
+static UA_UInt32
+insertSlot(const UA_NodeMap *ns, const UA_NodeId *nodeid, UA_UInt32 h,
+           UA_NodeMapEntry **whiteout) {
+    *whiteout = NULL;
+    if(ns->base) {
+        UA_NodeMapEntry *entry = NULL;
+        UA_UInt32 idx = findOccupiedSlot(ns->table, nodeid, &entry);
+        if(idx != UA_UINT32_MAX) {
+            if(!entry->whiteout)
+                return UA_UINT32_MAX;
+            *whiteout = entry;
+            return idx;
+        }
+        if(findOccupiedSlot(ns->base->table, nodeid, &entry) != UA_UINT32_MAX)
+            return UA_UINT32_MAX;
+    }
+    return findFreeSlot(ns->table, nodeid, h);
+}
+
+/* Add an entry whose NodeId is not yet in the table */
+static UA_StatusCode
+addEntry(UA_NodeMap *ns, UA_NodeMapEntry *entry) {
+    if(ns->table->size * 3 <= (ns->count + ns->table->tombstones) * 4) {
+        UA_StatusCode res = expand(ns);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    const UA_NodeId *nodeid = &entry->node.head.nodeId;
+    UA_UInt32 h = slotHash(nodeid);
+    UA_UInt32 idx = findFreeSlot(ns->table, nodeid, h);
+    if(idx == UA_UINT32_MAX)
+        return UA_STATUSCODE_BADNODEIDEXISTS;
+    occupySlot(ns->table, idx, nodeid, h, entry);
+    ++ns->count;
+    return UA_STATUSCODE_GOOD;
+}
+
 /***********************/
 /* Interface functions */
 /***********************/
 
 static UA_Node *
 UA_NodeMap_newNode(void *context, UA_NodeClass nodeClass) {
-    UA_NodeMapEntry *entry = createEntry(nodeClass);
+    UA_NodeMapEntry *entry = createEntry((UA_NodeMap*)context, nodeClass);
     if(!entry)
         return NULL;
     return &entry->node;
@@ -248,9 +1278,10 @@ UA_NodeMap_newNode(void *context, UA_NodeClass nodeClass) {
 
 static void
 UA_NodeMap_deleteNode(void *context, UA_Node *node) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_assert(&entry->node == node);
-    deleteNodeMapEntry(entry);
+    deleteNodeMapEntry(ns, entry);
 }
 
 static const UA_Node *
@@ -259,11 +1290,23 @@ UA_NodeMap_getNode(void *context, const UA_NodeId *nodeid,
                    UA_ReferenceTypeSet references,
                    UA_BrowseDirection referenceDirections) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    UA_NodeMapEntry *entry = NULL;
+#ifdef UA_NODEMAP_CONCURRENT
+    UA_UInt32 e = readerEnter(ns);
+    entry = findEntry(ns, nodeid);
+    if(entry && !entry->frozen)
+        UA_atomic_addUInt32(&entry->refCount, 1);
+    readerLeave(ns, e);
+    if(!entry)
         return NULL;
-    ++slot->entry->refCount;
-    return &slot->entry->node;
+#else
+    entry = findEntry(ns, nodeid);
+    if(!entry)
+        return NULL;
+    if(!entry->frozen)
+        ++entry->refCount;
+#endif
+    return &entry->node;
 }
 
 static const UA_Node *
@@ -277,26 +1320,65 @@ UA_NodeMap_getNodeFromPtr(void *context, UA_NodePointer ptr,
     return UA_NodeMap_getNode(context, &id, attributeMask, references, referenceDirections);
 }
 
+#ifndef UA_NODEMAP_CONCURRENT
+/* Use the pointer to the target node cached in the reference if the generation
+ * is unchanged. Nodes of a frozen base can be shared between several layered
+ * nodemaps. So no pointers are cached in layered nodemaps. */
+static const UA_Node *
+UA_NodeMap_getNodeFromTarget(void *context, UA_ReferenceTarget *target,
+                             UA_UInt32 attributeMask,
+                             UA_ReferenceTypeSet references,
+                             UA_BrowseDirection referenceDirections) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    UA_Boolean cache = (!ns->base && !ns->frozen);
+    if(cache && target->targetNode && target->targetGeneration == ns->generation) {
+        UA_NodeMapEntry *entry =
+            container_of(target->targetNode, UA_NodeMapEntry, node);
+        if(entry->tracked)
+            entry->recent = true;
+        if(!entry->frozen)
+            ++entry->refCount;
+        return &entry->node;
+    }
+
+    const UA_Node *node =
+        UA_NodeMap_getNodeFromPtr(context, target->targetId, attributeMask,
+                                  references, referenceDirections);
+    if(node && cache) {
+        target->targetNode = &node->head;
+        target->targetGeneration = ns->generation;
+    }
+    return node;
+}
+#endif
+
 static void
 UA_NodeMap_releaseNode(void *context, const UA_Node *node) {
     if (!node)
         return;
     UA_NodeMapEntry *entry = container_of(node, UA_NodeMapEntry, node);
     UA_assert(&entry->node == node);
+    if(entry->frozen)
+        return;
     UA_assert(entry->refCount > 0);
+#ifdef UA_NODEMAP_CONCURRENT
+    (void)context;
+    UA_atomic_subUInt32(&entry->refCount, 1);
+#else
+    UA_NodeMap *ns = (UA_NodeMap*)context;
     --entry->refCount;
-    cleanupNodeMapEntry(entry);
+    cleanupNodeMapEntry(ns, entry);
+#endif
 }
 
 static UA_StatusCode
 UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
                        UA_Node **outNode) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    UA_NodeMapEntry *entry = findEntry(ns, nodeid);
+    if(!entry)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
-    UA_NodeMapEntry *entry = slot->entry;
-    UA_NodeMapEntry *newItem = createEntry(entry->node.head.nodeClass);
+    UA_NodeMapEntry *newItem = createEntry(ns, entry->node.head.nodeClass);
     if(!newItem)
         return UA_STATUSCODE_BADOUTOFMEMORY;
     UA_StatusCode retval = UA_Node_copy(&entry->node, &newItem->node);
@@ -304,7 +1386,7 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
         newItem->orig = entry; /* Store the pointer to the original */
         *outNode = &newItem->node;
     } else {
-        deleteNodeMapEntry(newItem);
+        deleteNodeMapEntry(ns, newItem);
     }
     return retval;
 }
@@ -312,18 +1394,52 @@ UA_NodeMap_getNodeCopy(void *context, const UA_NodeId *nodeid,
 static UA_StatusCode
 UA_NodeMap_removeNode(void *context, const UA_NodeId *nodeid) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, nodeid);
-    if(!slot)
+    if(ns->frozen)
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    UA_NodeMapEntry *entry = NULL;
+    UA_NodeMapTable *t = ns->table;
+    UA_UInt32 idx = findOccupiedSlot(t, nodeid, &entry);
+    if(idx != UA_UINT32_MAX && entry->whiteout)
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
 
-    UA_NodeMapEntry *entry = slot->entry;
-    slot->entry = UA_NODEMAP_TOMBSTONE;
-    entry->deleted = true;
-    cleanupNodeMapEntry(entry);
+    /* The node is (also) in the base. Hide it with a whiteout. */
+    UA_NodeMapEntry *baseEntry = NULL;
+    if(ns->base)
+        findOccupiedSlot(ns->base->table, nodeid, &baseEntry);
+    if(baseEntry) {
+        UA_NodeMapEntry *whiteout = createWhiteout(nodeid);
+        if(!whiteout)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        if(idx != UA_UINT32_MAX) {
+            setSlotEntry(t, idx, whiteout);
+            dropEntry(ns, entry);
+        } else {
+            res = addEntry(ns, whiteout);
+            if(res != UA_STATUSCODE_GOOD)
+                deleteNodeMapEntry(ns, whiteout);
+        }
+#ifdef UA_NODEMAP_CONCURRENT
+        reclaim(ns);
+#endif
+        return res;
+    }
+
+    if(idx == UA_UINT32_MAX)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+
+    setSlotEntry(t, idx, NULL);
+    t->ctrl[idx] = UA_NODEMAP_DELETED;
+    t->tombstones++;
+    dropEntry(ns, entry);
     --ns->count;
+    ns->generation++;
     /* Downsize the hashmap if it is very empty */
-    if(ns->count * 8 < ns->size && ns->size > UA_NODEMAP_MINSIZE)
+    if(ns->count * 8 < t->size && t->size > UA_NODEMAP_MINSIZE)
         expand(ns); /* Can fail. Just continue with the bigger hashmap. */
+#ifdef UA_NODEMAP_CONCURRENT
+    reclaim(ns);
+#endif
     return UA_STATUSCODE_GOOD;
 }
 
@@ -335,34 +1451,45 @@ static UA_StatusCode
 UA_NodeMap_insertNode(void *context, UA_Node *node,
                       UA_NodeId *addedNodeId) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    if(ns->size * 3 <= ns->count * 4) {
+    if(ns->frozen) {
+        deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    }
+#ifdef UA_NODEMAP_CONCURRENT
+    reclaim(ns);
+#endif
+    UA_NodeMapTable *t = ns->table;
+    if(t->size * 3 <= (ns->count + t->tombstones) * 4) {
         if(expand(ns) != UA_STATUSCODE_GOOD){
-            deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
+            deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
         }
+        t = ns->table;
     }
 
-    UA_NodeMapSlot *slot;
+    UA_UInt32 h = 0, idx;
+    UA_NodeMapEntry *whiteout = NULL;
     if(node->head.nodeId.identifierType == UA_NODEIDTYPE_NUMERIC &&
        node->head.nodeId.identifier.numeric == 0) {
         /* Create a random nodeid: Start at least with 50,000 to make sure we
          * don not conflict with nodes from the spec. If we find a conflict, we
          * just try another identifier until we have tried all possible
-         * identifiers. Since the size is prime and we don't change the increase
-         * val, we will reach the starting id again. E.g. adding a nodeset will
+         * identifiers. Since the size is a power of two and the increase val is
+         * odd, we will reach the starting id again. E.g. adding a nodeset will
          * create children while there are still other nodes which need to be
          * created. Thus the node ids may collide. */
-        UA_UInt32 size = ns->size;
-        UA_UInt64 identifier = mod(50000 + size+1, UA_UINT32_MAX); /* Use 64bit to
-                                                                    * avoid overflow */
-        UA_UInt32 increase = mod2(ns->count+1, size);
-        UA_UInt32 startId = (UA_UInt32)identifier; /* mod ensures us that the id
-                                                    * is a valid 32 bit integer */
+        UA_UInt32 size = t->size;
+        UA_UInt64 identifier = 50000 + size + 1; /* Use 64bit to avoid overflow */
+        UA_UInt32 increase = (1 + ((ns->count + 1) % (size - 2))) | 0x01;
+        UA_UInt32 startId = (UA_UInt32)identifier; /* The size is at most 2^31.
+                                                    * So the id is a valid 32
+                                                    * bit integer */
 
         do {
             node->head.nodeId.identifier.numeric = (UA_UInt32)identifier;
-            slot = findFreeSlot(ns, &node->head.nodeId);
-            if(slot)
+            h = slotHash(&node->head.nodeId);
+            idx = insertSlot(ns, &node->head.nodeId, h, &whiteout);
+            if(idx != UA_UINT32_MAX)
                 break;
             identifier += increase;
             if(identifier >= size)
@@ -376,11 +1503,12 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 #endif
         } while((UA_UInt32)identifier != startId);
     } else {
-        slot = findFreeSlot(ns, &node->head.nodeId);
+        h = slotHash(&node->head.nodeId);
+        idx = insertSlot(ns, &node->head.nodeId, h, &whiteout);
     }
 
-    if(!slot) {
-        deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
+    if(idx == UA_UINT32_MAX) {
+        deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
         return UA_STATUSCODE_BADNODEIDEXISTS;
     }
 
@@ -389,7 +1517,7 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
     if(addedNodeId) {
         retval = UA_NodeId_copy(&node->head.nodeId, addedNodeId);
         if(retval != UA_STATUSCODE_GOOD) {
-            deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
+            deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
             return retval;
         }
     }
@@ -398,13 +1526,13 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
     if(node->head.nodeClass == UA_NODECLASS_REFERENCETYPE) {
         UA_ReferenceTypeNode *refNode = &node->referenceTypeNode;
         if(ns->referenceTypeCounter >= UA_REFERENCETYPESET_MAX) {
-            deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
+            deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
         }
 
         retval = UA_NodeId_copy(&node->head.nodeId, &ns->referenceTypeIds[ns->referenceTypeCounter]);
         if(retval != UA_STATUSCODE_GOOD) {
-            deleteNodeMapEntry(container_of(node, UA_NodeMapEntry, node));
+            deleteNodeMapEntry(ns, container_of(node, UA_NodeMapEntry, node));
             return UA_STATUSCODE_BADINTERNALERROR;
         }
 
@@ -417,8 +1545,15 @@ UA_NodeMap_insertNode(void *context, UA_Node *node,
 
     /* Insert the node */
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
-    slot->nodeIdHash = UA_NodeId_hash(&node->head.nodeId);
-    slot->entry = newEntry;
+#ifdef UA_NODEMAP_CONCURRENT
+    switchReferenceKinds(newEntry);
+#endif
+    if(whiteout) {
+        setSlotEntry(t, idx, newEntry);
+        dropEntry(ns, whiteout);
+        return retval;
+    }
+    occupySlot(t, idx, &node->head.nodeId, h, newEntry);
     ++ns->count;
     return retval;
 }
@@ -427,25 +1562,46 @@ static UA_StatusCode
 UA_NodeMap_replaceNode(void *context, UA_Node *node) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
     UA_NodeMapEntry *newEntry = container_of(node, UA_NodeMapEntry, node);
+    if(ns->frozen) {
+        deleteNodeMapEntry(ns, newEntry);
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    }
 
-    /* Find the node */
-    UA_NodeMapSlot *slot = findOccupiedSlot(ns, &node->head.nodeId);
-    if(!slot) {
-        deleteNodeMapEntry(newEntry);
+    /* Find the node. Also in the base. */
+    UA_NodeMapEntry *oldEntry = NULL;
+    UA_UInt32 idx = findOccupiedSlot(ns->table, &node->head.nodeId, &oldEntry);
+    if(idx == UA_UINT32_MAX && ns->base)
+        findOccupiedSlot(ns->base->table, &node->head.nodeId, &oldEntry);
+    if(!oldEntry || oldEntry->whiteout) {
+        deleteNodeMapEntry(ns, newEntry);
         return UA_STATUSCODE_BADNODEIDUNKNOWN;
     }
 
     /* The node was already updated since the copy was made? */
-    UA_NodeMapEntry *oldEntry = slot->entry;
     if(oldEntry != newEntry->orig) {
-        deleteNodeMapEntry(newEntry);
+        deleteNodeMapEntry(ns, newEntry);
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+#ifdef UA_NODEMAP_CONCURRENT
+    switchReferenceKinds(newEntry);
+#endif
+
+    /* Shadow the node of the base */
+    if(idx == UA_UINT32_MAX) {
+        UA_StatusCode res = addEntry(ns, newEntry);
+        if(res != UA_STATUSCODE_GOOD)
+            deleteNodeMapEntry(ns, newEntry);
+        return res;
+    }
+
     /* Replace the entry */
-    slot->entry = newEntry;
-    oldEntry->deleted = true;
-    cleanupNodeMapEntry(oldEntry);
+    setSlotEntry(ns->table, idx, newEntry);
+    dropEntry(ns, oldEntry);
+    ns->generation++;
+#ifdef UA_NODEMAP_CONCURRENT
+    reclaim(ns);
+#endif
     return UA_STATUSCODE_GOOD;
 }
 
@@ -461,16 +1617,53 @@ static void
 UA_NodeMap_iterate(void *context, UA_NodestoreVisitor visitor,
                    void *visitorContext) {
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    for(UA_UInt32 i = 0; i < ns->size; ++i) {
-        UA_NodeMapSlot *slot = &ns->slots[i];
-        if(slot->entry > UA_NODEMAP_TOMBSTONE) {
+    for(UA_UInt32 i = 0; i < ns->table->size; ++i) {
+        UA_NodeMapEntry *entry = ns->table->entries[i];
+        if(!entry || entry->whiteout)
+            continue;
+        if(entry->frozen) {
+            visitor(visitorContext, &entry->node);
+            continue;
+        }
+#ifndef UA_NODEMAP_CONCURRENT
+        /* Visit a temporary decoding. Materializing all nodes would undo the
+         * compaction. */
+        if(entry->compact) {
+            UA_NodeMapEntry *tmp = decodeEntry(ns, entry);
+            if(tmp) {
+                visitor(visitorContext, &tmp->node);
+                deleteNodeMapEntry(ns, tmp);
+            }
+            continue;
+        }
+#endif
+        {
             /* The visitor can delete the node. So refcount here. */
-            slot->entry->refCount++;
-            visitor(visitorContext, &slot->entry->node);
-            slot->entry->refCount--;
-            cleanupNodeMapEntry(slot->entry);
+#ifdef UA_NODEMAP_CONCURRENT
+            UA_atomic_addUInt32(&entry->refCount, 1);
+            visitor(visitorContext, &entry->node);
+            UA_atomic_subUInt32(&entry->refCount, 1);
+#else
+            entry->refCount++;
+            visitor(visitorContext, &entry->node);
+            entry->refCount--;
+            cleanupNodeMapEntry(ns, entry);
+#endif
         }
     }
+
+    /* Nodes of the base that are not shadowed (or hidden by a whiteout) */
+    if(!ns->base)
+        return;
+    const UA_NodeMapTable *bt = ns->base->table;
+    for(UA_UInt32 i = 0; i < bt->size; ++i) {
+        UA_NodeMapEntry *entry = bt->entries[i];
+        UA_NodeMapEntry *upper = NULL;
+        if(!entry ||
+           findOccupiedSlot(ns->table, &entry->node.head.nodeId, &upper) != UA_UINT32_MAX)
+            continue;
+        visitor(visitorContext, &entry->node);
+    }
 }
 
 static void
@@ -480,43 +1673,97 @@ UA_NodeMap_delete(void *context) {
         return;
 
     UA_NodeMap *ns = (UA_NodeMap*)context;
-    UA_UInt32 size = ns->size;
-    UA_NodeMapSlot *slots = ns->slots;
-    for(UA_UInt32 i = 0; i < size; ++i) {
-        if(slots[i].entry > UA_NODEMAP_TOMBSTONE) {
+#ifndef UA_NODEMAP_CONCURRENT
+    clearCache(ns);
+#endif
+    UA_NodeMapTable *t = ns->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        if(t->entries[i]) {
             /* On debugging builds, check that all nodes were release */
-            UA_assert(slots[i].entry->refCount == 0);
+            UA_assert(t->entries[i]->frozen || t->entries[i]->refCount == 0);
             /* Delete the node */
-            deleteNodeMapEntry(slots[i].entry);
+            deleteNodeMapEntry(ns, t->entries[i]);
         }
     }
-    UA_free(ns->slots);
+    UA_free(ns->table);
+
+#ifdef UA_NODEMAP_CONCURRENT
+    /* No more readers. Free everything that was retired. */
+    for(size_t e = 0; e < 2; e++) {
+        UA_NodeMapTable *t = ns->retiredTables[e];
+        while(t) {
+            UA_NodeMapTable *tnext = t->retiredNext;
+            UA_free(t);
+            t = tnext;
+        }
+        UA_NodeMapEntry *entry = ns->retiredEntries[e];
+        while(entry) {
+            UA_NodeMapEntry *enext = entry->retiredNext;
+            deleteNodeMapEntry(ns, entry);
+            entry = enext;
+        }
+    }
+#endif
+
+    /* All nodes are cleared. Release the slabs in bulk. */
+    clearPools(ns);
 
     /* Clean up the ReferenceTypes index array */
     for(size_t i = 0; i < ns->referenceTypeCounter; i++)
         UA_NodeId_clear(&ns->referenceTypeIds[i]);
 
+    UA_NodestoreImage *image = ns->image;
     UA_free(ns);
+    if(image)
+        UA_NodestoreImage_release(image);
+}
+
+/* Counts the nodes of this layer only. The nodes of a frozen base are reported
+ * by the base nodestore. */
+static UA_StatusCode
+UA_NodeMap_getStatistics(void *context, UA_NodestoreStatistics *stats) {
+    UA_NodeMap *ns = (UA_NodeMap*)context;
+    UA_NodeMapTable *t = ns->table;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    size_t singleBytes = 0; /* Not allocated from the pools */
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->entries[i];
+        if(!entry || entry->whiteout)
+            continue;
+        size_t nodeSize = entrySize(entry->node.head.nodeClass);
+        if(entry->compact) {
+            UA_NodeMapCompactEntry *ce =
+                container_of(entry, UA_NodeMapCompactEntry, entry);
+            nodeSize = UA_NODEMAP_COMPACTSIZE + ce->encoded.length;
+        }
+        if(entry->compact || entry->decoded)
+            singleBytes += nodeSize;
+        res = UA_NodestoreStatistics_addNode(stats, &entry->node, nodeSize);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    stats->allocatedBytes = sizeof(UA_NodeMap) + sizeof(UA_NodeMapTable) +
+        (t->size * (sizeof(UA_UInt64) + sizeof(UA_NodeMapEntry*) + 1)) +
+        (ns->cacheSize * sizeof(UA_NodeMapEntry*)) + singleBytes;
+    for(size_t i = 0; i < 8; i++) {
+        for(UA_NodeMapSlab *slab = ns->pools[i].slabs; slab; slab = slab->next)
+            stats->allocatedBytes += slab->size;
+    }
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
 UA_Nodestore_HashMap(UA_Nodestore *ns) {
     /* Allocate and initialize the nodemap */
-    UA_NodeMap *nodemap = (UA_NodeMap*)UA_malloc(sizeof(UA_NodeMap));
+    UA_NodeMap *nodemap = (UA_NodeMap*)UA_calloc(1, sizeof(UA_NodeMap));
     if(!nodemap)
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    nodemap->sizePrimeIndex = higher_prime_index(UA_NODEMAP_MINSIZE);
-    nodemap->size = primes[nodemap->sizePrimeIndex];
-    nodemap->count = 0;
-    nodemap->slots = (UA_NodeMapSlot*)
-        UA_calloc(nodemap->size, sizeof(UA_NodeMapSlot));
-    if(!nodemap->slots) {
+    nodemap->table = newTable(UA_NODEMAP_MINSIZE);
+    if(!nodemap->table) {
         UA_free(nodemap);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    nodemap->referenceTypeCounter = 0;
-
     /* Populate the nodestore */
     ns->context = nodemap;
     ns->clear = UA_NodeMap_delete;
@@ -524,6 +1771,11 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->deleteNode = UA_NodeMap_deleteNode;
     ns->getNode = UA_NodeMap_getNode;
     ns->getNodeFromPtr = UA_NodeMap_getNodeFromPtr;
+#ifndef UA_NODEMAP_CONCURRENT
+    ns->getNodeFromTarget = UA_NodeMap_getNodeFromTarget;
+#else
+    ns->getNodeFromTarget = NULL;
+#endif
     ns->releaseNode = UA_NodeMap_releaseNode;
     ns->getNodeCopy = UA_NodeMap_getNodeCopy;
     ns->insertNode = UA_NodeMap_insertNode;
@@ -531,5 +1783,152 @@ UA_Nodestore_HashMap(UA_Nodestore *ns) {
     ns->removeNode = UA_NodeMap_removeNode;
     ns->getReferenceTypeId = UA_NodeMap_getReferenceTypeId;
     ns->iterate = UA_NodeMap_iterate;
+    ns->getStatistics = UA_NodeMap_getStatistics;
+#ifdef UA_NODEMAP_CONCURRENT
+    ns->concurrentReads = true;
+#else
+    ns->concurrentReads = false;
+#endif
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Nodestore_HashMap_freeze(UA_Nodestore *ns) {
+    if(ns->getNode != UA_NodeMap_getNode)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_NodeMap *nodemap = (UA_NodeMap*)ns->context;
+    if(nodemap->base)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_NodeMapTable *t = nodemap->table;
+#ifndef UA_NODEMAP_CONCURRENT
+    /* Frozen nodes are shared without refcounting. Materialize all. */
+    clearCache(nodemap);
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->entries[i];
+        if(entry && entry->compact && !materializeEntry(nodemap, i, entry))
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+#endif
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->entries[i];
+        if(!entry)
+            continue;
+        switchReferenceKinds(entry);
+        entry->frozen = true;
+    }
+    nodemap->frozen = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Nodestore_HashMapLayered(UA_Nodestore *ns, const UA_Nodestore *base) {
+    if(base->getNode != UA_NodeMap_getNode ||
+       !((const UA_NodeMap*)base->context)->frozen)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_StatusCode res = UA_Nodestore_HashMap(ns);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Continue the ReferenceTypeIndex of the base */
+    UA_NodeMap *nodemap = (UA_NodeMap*)ns->context;
+    const UA_NodeMap *basemap = (const UA_NodeMap*)base->context;
+    nodemap->base = basemap;
+    for(size_t i = 0; i < basemap->referenceTypeCounter; i++)
+        res |= UA_NodeId_copy(&basemap->referenceTypeIds[i],
+                              &nodemap->referenceTypeIds[i]);
+    nodemap->referenceTypeCounter = basemap->referenceTypeCounter;
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NodeMap_delete(nodemap);
+        ns->context = NULL;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Nodestore Image */
+
+struct UA_NodestoreImage {
+    volatile uint32_t refCount;
+    UA_Nodestore ns; /* Frozen */
+    const UA_DataTypeArray *customTypes;
+};
+
+UA_NodestoreImage *
+UA_NodestoreImage_new(UA_Nodestore *ns, const UA_DataTypeArray *customTypes) {
+    UA_NodestoreImage *image = (UA_NodestoreImage*)
+        UA_calloc(1, sizeof(UA_NodestoreImage));
+    if(!image)
+        return NULL;
+    if(UA_Nodestore_HashMap_freeze(ns) != UA_STATUSCODE_GOOD) {
+        UA_free(image);
+        return NULL;
+    }
+    image->refCount = 1;
+    image->ns = *ns;
+    image->customTypes = customTypes;
+    memset(ns, 0, sizeof(UA_Nodestore));
+    return image;
+}
+
+const UA_DataTypeArray *
+UA_NodestoreImage_getCustomDataTypes(const UA_NodestoreImage *image) {
+    return image->customTypes;
+}
+
+void
+UA_NodestoreImage_release(UA_NodestoreImage *image) {
+    if(UA_atomic_subUInt32(&image->refCount, 1) > 0)
+        return;
+    /* The frozen nodes can use the custom types. Clear them first. */
+    image->ns.clear(image->ns.context);
+    UA_cleanupDataTypeWithCustom(image->customTypes);
+    UA_free(image);
+}
+
+UA_StatusCode
+UA_Nodestore_HashMapImage(UA_Nodestore *ns, UA_NodestoreImage *image) {
+    UA_StatusCode res = UA_Nodestore_HashMapLayered(ns, &image->ns);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_atomic_addUInt32(&image->refCount, 1);
+    ((UA_NodeMap*)ns->context)->image = image;
     return UA_STATUSCODE_GOOD;
 }
+
+UA_StatusCode
+UA_Nodestore_HashMap_compact(UA_Nodestore *ns, UA_UInt16 namespaceIndex,
+                             size_t cacheSize) {
+    if(ns->getNode != UA_NodeMap_getNode)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+#ifdef UA_NODEMAP_CONCURRENT
+    (void)namespaceIndex;
+    (void)cacheSize;
+    return UA_STATUSCODE_BADNOTSUPPORTED;
+#else
+    UA_NodeMap *nodemap = (UA_NodeMap*)ns->context;
+    if(nodemap->frozen)
+        return UA_STATUSCODE_BADNOTWRITABLE;
+
+    /* Set up the cache. The previously cached nodes stay materialized until
+     * they are compacted below. */
+    clearCache(nodemap);
+    if(cacheSize > 0) {
+        nodemap->cache = (UA_NodeMapEntry**)
+            UA_calloc(cacheSize, sizeof(UA_NodeMapEntry*));
+        if(!nodemap->cache)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        nodemap->cacheSize = cacheSize;
+    }
+
+    /* Compact the eligible nodes. Nodes that cannot be encoded are skipped. */
+    UA_NodeMapTable *t = nodemap->table;
+    for(UA_UInt32 i = 0; i < t->size; ++i) {
+        UA_NodeMapEntry *entry = t->entries[i];
+        if(!entry || entry->node.head.nodeId.namespaceIndex != namespaceIndex)
+            continue;
+        compactEntry(nodemap, i, entry);
+    }
+    repackPools(nodemap);
+    return UA_STATUSCODE_GOOD;
+#endif
+}
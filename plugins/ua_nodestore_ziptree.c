@@ -58,8 +58,9 @@ typedef struct {
 
 ZIP_FUNCTIONS(NodeTree, NodeEntry, zipfields, NodeEntry, zipfields, cmpNodeId)
 
-static NodeEntry *
-newEntry(UA_NodeClass nodeClass) {
+/* Returns zero for an unknown NodeClass */
+static size_t
+entrySize(UA_NodeClass nodeClass) {
     size_t size = sizeof(NodeEntry) - sizeof(UA_NodeId);
     switch(nodeClass) {
     case UA_NODECLASS_OBJECT:
@@ -87,8 +88,16 @@ newEntry(UA_NodeClass nodeClass) {
         size += sizeof(UA_ViewNode);
         break;
     default:
-        return NULL;
+        return 0;
     }
+    return size;
+}
+
+static NodeEntry *
+newEntry(UA_NodeClass nodeClass) {
+    size_t size = entrySize(nodeClass);
+    if(size == 0)
+        return NULL;
     NodeEntry *entry = (NodeEntry*)UA_calloc(1, size);
     if(!entry)
         return NULL;
@@ -114,7 +123,8 @@ cleanupEntry(NodeEntry *entry) {
     UA_NodeHead *head = (UA_NodeHead*)&entry->nodeId;
     for(size_t i = 0; i < head->referencesSize; i++) {
         UA_NodeReferenceKind *rk = &head->references[i];
-        if(rk->targetsSize > 16 && !rk->hasRefTree)
+        if(rk->targetsSize > UA_NODEREFERENCEKIND_TREETHRESHOLD &&
+           !rk->hasRefTree)
             UA_NodeReferenceKind_switch(rk);
     }
 }
@@ -354,6 +364,22 @@ zipNsIterate(void *nsCtx, UA_NodestoreVisitor visitor,
     ZIP_ITER(NodeTree, &ns->root, nodeVisitor, &d);
 }
 
+static void *
+statisticsVisitor(void *data, NodeEntry *entry) {
+    const UA_Node *node = (const UA_Node*)&entry->nodeId;
+    UA_StatusCode res =
+        UA_NodestoreStatistics_addNode((UA_NodestoreStatistics*)data, node,
+                                       entrySize(node->head.nodeClass));
+    return (res == UA_STATUSCODE_GOOD) ? NULL : (void*)(uintptr_t)res;
+}
+
+static UA_StatusCode
+zipNsGetStatistics(void *nsCtx, UA_NodestoreStatistics *stats) {
+    ZipContext *ns = (ZipContext*)nsCtx;
+    return (UA_StatusCode)(uintptr_t)
+        ZIP_ITER(NodeTree, &ns->root, statisticsVisitor, stats);
+}
+
 static void *
 deleteNodeVisitor(void *data, NodeEntry *entry) {
     deleteEntry(entry);
@@ -395,6 +421,7 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     ns->deleteNode = zipNsDeleteNode;
     ns->getNode = zipNsGetNode;
     ns->getNodeFromPtr = zipNsGetNodeFromPtr;
+    ns->getNodeFromTarget = NULL;
     ns->releaseNode = zipNsReleaseNode;
     ns->getNodeCopy = zipNsGetNodeCopy;
     ns->insertNode = zipNsInsertNode;
@@ -402,6 +429,8 @@ UA_Nodestore_ZipTree(UA_Nodestore *ns) {
     ns->removeNode = zipNsRemoveNode;
     ns->getReferenceTypeId = zipNsGetReferenceTypeId;
     ns->iterate = zipNsIterate;
+    ns->concurrentReads = false;
+    ns->getStatistics = zipNsGetStatistics;
 
     return UA_STATUSCODE_GOOD;
 }
@@ -0,0 +1,277 @@
+/* This work is licensed under a Creative Commons CCZero 1.0 Universal License.
+ * See http://creativecommons.org/publicdomain/zero/1.0/ for more information.
+ */
+
+#include <open62541/plugin/processimage.h>
+#include <open62541/types.h>
+
+#if defined(UA_ARCHITECTURE_POSIX)
+
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Attempts to take a consistent snapshot before giving up */
+#define PROCESSIMAGE_MAXTRIES 64
+
+/* The sequence counter is shared with another process. So the memory
+ * ordering is required also without multithreading in the server. */
+#define SEQ_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define SEQ_LOAD_RELAXED(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define SEQ_STORE_RELAXED(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define SEQ_STORE_RELEASE(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
+#define FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+typedef struct UA_ProcessImageVariable {
+    struct UA_ProcessImageVariable *next;
+    UA_ProcessImage *pi;
+    size_t offset;
+    const UA_DataType *type;
+    size_t arrayLength;
+} UA_ProcessImageVariable;
+
+struct UA_ProcessImage {
+    char *name;
+    UA_ProcessImageHeader *header;
+    UA_Byte *data;
+    size_t size;
+    size_t mapSize;
+
+    /* Reads come from the snapshot. It is renewed when the sequence counter
+     * differs. snapshotSeq is odd as long as there is no snapshot. */
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+#endif
+    UA_Byte *snapshot;
+    UA_UInt64 snapshotSeq;
+    UA_DateTime snapshotTime;
+
+    UA_ProcessImageVariable *variables;
+};
+
+UA_StatusCode
+UA_ProcessImage_open(const char *name, size_t size, UA_Boolean create,
+                     UA_ProcessImage **pi) {
+    if(!name || !pi || size > UA_UINT32_MAX)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    int flags = (create) ? (O_RDWR | O_CREAT) : O_RDWR;
+    int fd = shm_open(name, flags, 0600);
+    if(fd < 0)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+
+    /* Get the size of the region */
+    size_t mapSize = sizeof(UA_ProcessImageHeader) + size;
+    if(create) {
+        if(ftruncate(fd, (off_t)mapSize) != 0) {
+            close(fd);
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+    } else {
+        struct stat st;
+        if(fstat(fd, &st) != 0 || (size_t)st.st_size < mapSize) {
+            close(fd);
+            return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        }
+        mapSize = (size_t)st.st_size;
+    }
+
+    void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); /* The mapping remains valid */
+    if(map == MAP_FAILED)
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+
+    UA_ProcessImageHeader *header = (UA_ProcessImageHeader*)map;
+    if(create) {
+        memset(map, 0, mapSize);
+        header->magic = UA_PROCESSIMAGE_MAGIC;
+        header->size = (UA_UInt32)size;
+    } else if(header->magic != UA_PROCESSIMAGE_MAGIC ||
+              header->size < size ||
+              header->size > mapSize - sizeof(UA_ProcessImageHeader)) {
+        munmap(map, mapSize);
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    }
+
+    UA_ProcessImage *newPi = (UA_ProcessImage*)UA_calloc(1, sizeof(UA_ProcessImage));
+    size_t nameLen = strlen(name);
+    char *nameCopy = (char*)UA_malloc(nameLen + 1);
+    UA_Byte *snapshot = (UA_Byte*)UA_malloc(header->size + 1);
+    if(!newPi || !nameCopy || !snapshot) {
+        UA_free(snapshot);
+        UA_free(nameCopy);
+        UA_free(newPi);
+        munmap(map, mapSize);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    memcpy(nameCopy, name, nameLen + 1);
+
+    newPi->name = nameCopy;
+    newPi->header = header;
+    newPi->data = (UA_Byte*)map + sizeof(UA_ProcessImageHeader);
+    newPi->size = header->size;
+    newPi->mapSize = mapSize;
+    newPi->snapshot = snapshot;
+    newPi->snapshotSeq = 1;
+    UA_LOCK_INIT(&newPi->lock);
+    *pi = newPi;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_ProcessImage_close(UA_ProcessImage *pi, UA_Boolean unlink) {
+    if(!pi)
+        return;
+    UA_ProcessImageVariable *pv = pi->variables;
+    while(pv) {
+        UA_ProcessImageVariable *next = pv->next;
+        UA_free(pv);
+        pv = next;
+    }
+    munmap(pi->header, pi->mapSize);
+    if(unlink)
+        shm_unlink(pi->name);
+    UA_LOCK_DESTROY(&pi->lock);
+    UA_free(pi->snapshot);
+    UA_free(pi->name);
+    UA_free(pi);
+}
+
+void *
+UA_ProcessImage_data(UA_ProcessImage *pi) {
+    return pi->data;
+}
+
+void
+UA_ProcessImage_beginWrite(UA_ProcessImage *pi) {
+    UA_UInt64 seq = SEQ_LOAD_RELAXED(&pi->header->sequence);
+    SEQ_STORE_RELAXED(&pi->header->sequence, seq + 1);
+    FENCE_RELEASE(); /* The odd counter is visible before the data changes */
+}
+
+void
+UA_ProcessImage_endWrite(UA_ProcessImage *pi) {
+    pi->header->timestamp = UA_DateTime_now();
+    UA_UInt64 seq = SEQ_LOAD_RELAXED(&pi->header->sequence);
+    SEQ_STORE_RELEASE(&pi->header->sequence, seq + 1);
+}
+
+/* Copy the data region if the sequence counter is even and unchanged during
+ * the copy */
+static UA_Boolean
+readConsistent(UA_ProcessImage *pi, void *dst, UA_UInt64 knownSeq,
+               UA_UInt64 *outSeq, UA_DateTime *outTime) {
+    UA_ProcessImageHeader *header = pi->header;
+    for(size_t i = 0; i < PROCESSIMAGE_MAXTRIES; i++) {
+        UA_UInt64 seq = SEQ_LOAD_ACQUIRE(&header->sequence);
+        if(seq & 1) {
+            sched_yield(); /* The writer is active */
+            continue;
+        }
+        if(seq == knownSeq)
+            return true; /* dst is up to date */
+        memcpy(dst, pi->data, pi->size);
+        UA_DateTime time = header->timestamp;
+        FENCE_ACQUIRE(); /* Finish the copy before checking the counter */
+        if(SEQ_LOAD_RELAXED(&header->sequence) != seq)
+            continue;
+        *outSeq = seq;
+        *outTime = time;
+        return true;
+    }
+    return false;
+}
+
+UA_StatusCode
+UA_ProcessImage_read(UA_ProcessImage *pi, void *dst) {
+    UA_UInt64 seq;
+    UA_DateTime time;
+    return (readConsistent(pi, dst, 1, &seq, &time)) ?
+        UA_STATUSCODE_GOOD : UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+}
+
+static UA_StatusCode
+readVariable(UA_Server *server, const UA_NodeId *sessionId,
+             void *sessionContext, const UA_NodeId *nodeId,
+             void *nodeContext, UA_Boolean includeSourceTimeStamp,
+             const UA_NumericRange *range, UA_DataValue *value) {
+    UA_ProcessImageVariable *pv = (UA_ProcessImageVariable*)nodeContext;
+    UA_ProcessImage *pi = pv->pi;
+
+    UA_LOCK(&pi->lock);
+
+    /* Renew the snapshot if the writer has published since */
+    if(!readConsistent(pi, pi->snapshot, pi->snapshotSeq,
+                       &pi->snapshotSeq, &pi->snapshotTime)) {
+        UA_UNLOCK(&pi->lock);
+        value->hasStatus = true;
+        value->status = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Copy out of the snapshot */
+    UA_Variant v;
+    void *src = &pi->snapshot[pv->offset];
+    if(pv->arrayLength > 0)
+        UA_Variant_setArray(&v, src, pv->arrayLength, pv->type);
+    else
+        UA_Variant_setScalar(&v, src, pv->type);
+    UA_StatusCode res = (range) ?
+        UA_Variant_copyRange(&v, &value->value, *range) :
+        UA_Variant_copy(&v, &value->value);
+    if(res == UA_STATUSCODE_GOOD) {
+        value->hasValue = true;
+        if(includeSourceTimeStamp) {
+            value->hasSourceTimestamp = true;
+            value->sourceTimestamp = pi->snapshotTime;
+        }
+    } else {
+        value->hasStatus = true;
+        value->status = res;
+    }
+
+    UA_UNLOCK(&pi->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ProcessImage_addVariable(UA_ProcessImage *pi, UA_Server *server,
+                            const UA_NodeId nodeId, size_t offset,
+                            const UA_DataType *type, size_t arrayLength) {
+    /* Only fixed-size types can be copied out of the region */
+    if(!pi || !type || !type->pointerFree)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    size_t elements = (arrayLength > 0) ? arrayLength : 1;
+    if(offset > pi->size || elements > (pi->size - offset) / type->memSize)
+        return UA_STATUSCODE_BADOUTOFRANGE;
+
+    UA_ProcessImageVariable *pv = (UA_ProcessImageVariable*)
+        UA_malloc(sizeof(UA_ProcessImageVariable));
+    if(!pv)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    pv->pi = pi;
+    pv->offset = offset;
+    pv->type = type;
+    pv->arrayLength = arrayLength;
+
+    UA_DataSource ds;
+    ds.read = readVariable;
+    ds.write = NULL;
+    UA_StatusCode res = UA_Server_setNodeContext(server, nodeId, pv);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_setVariableNode_dataSource(server, nodeId, ds);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(pv);
+        return res;
+    }
+
+    pv->next = pi->variables;
+    pi->variables = pv;
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* defined(UA_ARCHITECTURE_POSIX) */
@@ -70,12 +70,21 @@ UA_ClientConfig_copy(UA_ClientConfig const *src, UA_ClientConfig *dst) {
     dst->eventLoop = src->eventLoop;
     dst->externalEventLoop = src->externalEventLoop;
     dst->inactivityCallback = src->inactivityCallback;
+    dst->asyncBatching = src->asyncBatching;
+    dst->asyncBatchingWindow = src->asyncBatchingWindow;
+    dst->asyncBatchingMaxNodesPerRead = src->asyncBatchingMaxNodesPerRead;
+    dst->asyncBatchingMaxNodesPerWrite = src->asyncBatchingMaxNodesPerWrite;
+    dst->nodeCacheSize = src->nodeCacheSize;
+    dst->endpointCache = src->endpointCache;
     dst->localConnectionConfig = src->localConnectionConfig;
     dst->logging = src->logging;
     if(src->certificateVerification.logging == NULL)
         dst->certificateVerification.logging = dst->logging;
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     dst->outStandingPublishRequests = src->outStandingPublishRequests;
+    dst->maxOutStandingPublishRequests = src->maxOutStandingPublishRequests;
+    dst->publishResponseArena = src->publishResponseArena;
+    dst->noSubscriptionTransfer = src->noSubscriptionTransfer;
 #endif
     dst->requestedSessionTimeout = src->requestedSessionTimeout;
     dst->secureChannelLifeTime = src->secureChannelLifeTime;
@@ -222,6 +231,12 @@ UA_Client_clear(UA_Client *client) {
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     __Client_Subscriptions_clean(client);
 #endif
+    UA_Arena_clear(&client->publishArena);
+
+    __Client_NodeCache_clear(&client->nodeCache);
+    UA_DataTypeIndex_delete(client->typeIndex);
+    client->typeIndex = NULL;
+    client->typeIndexTypes = NULL;
 
     /* Remove the internal regular callback */
     UA_Client_removeCallback(client, client->houseKeepingCallbackId);
@@ -331,10 +346,32 @@ notifyClientState(UA_Client *client) {
 /* Raw Services */
 /****************/
 
-/* For both synchronous and asynchronous service calls */
+/* Encode the RequestHeader followed by the already encoded request body */
+static UA_StatusCode
+sendEncodedRequest(UA_SecureChannel *channel, UA_UInt32 requestId,
+                   const UA_RequestHeader *rr, const UA_DataType *requestType,
+                   const UA_ByteString *body) {
+    if(channel->state != UA_SECURECHANNELSTATE_OPEN)
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+    UA_MessageContext mc;
+    UA_StatusCode res = UA_MessageContext_begin(&mc, channel, requestId,
+                                                UA_MESSAGETYPE_MSG);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encode(&mc, &requestType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encode(&mc, rr, &UA_TYPES[UA_TYPES_REQUESTHEADER]);
+    UA_CHECK_STATUS(res, return res);
+    res = UA_MessageContext_encodeRaw(&mc, body);
+    UA_CHECK_STATUS(res, return res);
+    return UA_MessageContext_finish(&mc);
+}
+
+/* For both synchronous and asynchronous service calls. If the body is
+ * defined, then only the RequestHeader of the request is encoded. */
 static UA_StatusCode
 sendRequest(UA_Client *client, const void *request, const UA_DataType *requestType,
-            UA_UInt32 *requestId) {
+            const UA_ByteString *body, UA_UInt32 *requestId) {
     UA_LOCK_ASSERT(&client->clientMutex, 1);
 
     /* Renew SecureChannel if necessary */
@@ -367,6 +404,9 @@ sendRequest(UA_Client *client, const void *request, const UA_DataType *requestTy
     /* Generate the request id */
     UA_UInt32 rqId = ++client->requestId;
 
+    /* Invalidate cached nodes that are modified by the request */
+    __Client_NodeCache_invalidateRequest(client, request, requestType);
+
 #ifdef UA_ENABLE_TYPEDESCRIPTION
     UA_LOG_DEBUG_CHANNEL(client->config.logging, &client->channel,
                          "Sending request with RequestId %u of type %s", (unsigned)rqId,
@@ -379,8 +419,10 @@ sendRequest(UA_Client *client, const void *request, const UA_DataType *requestTy
 #endif
 
     /* Send the message */
-    UA_StatusCode retval = UA_SecureChannel_sendSymmetricMessage(
-        &client->channel, rqId, UA_MESSAGETYPE_MSG, rr, requestType);
+    UA_StatusCode retval = (body) ?
+        sendEncodedRequest(&client->channel, rqId, rr, requestType, body) :
+        UA_SecureChannel_sendSymmetricMessage(&client->channel, rqId,
+                                              UA_MESSAGETYPE_MSG, rr, requestType);
 
     rr->authenticationToken = oldToken; /* Set back to the original token */
 
@@ -395,18 +437,55 @@ sendRequest(UA_Client *client, const void *request, const UA_DataType *requestTy
     return retval;
 }
 
+static enum ZIP_CMP
+cmpRequestId(const UA_UInt32 *a, const UA_UInt32 *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_AsyncServiceIdTree, AsyncServiceCall, idTreeEntry,
+              UA_UInt32, requestId, cmpRequestId)
+
+static enum ZIP_CMP
+cmpDeadline(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_AsyncServiceDeadlineTree, AsyncServiceCall, deadlineTreeEntry,
+              UA_DateTime, deadline, cmpDeadline)
+
+static void
+asyncServiceCall_add(UA_Client *client, AsyncServiceCall *ac) {
+    ZIP_INSERT(UA_AsyncServiceIdTree, &client->asyncServiceCalls, ac);
+    ZIP_INSERT(UA_AsyncServiceDeadlineTree, &client->asyncServiceDeadlines, ac);
+    client->asyncServiceCallsSize++;
+}
+
+static void
+asyncServiceCall_remove(UA_Client *client, AsyncServiceCall *ac) {
+    ZIP_REMOVE(UA_AsyncServiceIdTree, &client->asyncServiceCalls, ac);
+    ZIP_REMOVE(UA_AsyncServiceDeadlineTree, &client->asyncServiceDeadlines, ac);
+    client->asyncServiceCallsSize--;
+}
+
+static AsyncServiceCall *
+asyncServiceCall_find(UA_Client *client, UA_UInt32 requestId) {
+    return ZIP_FIND(UA_AsyncServiceIdTree, &client->asyncServiceCalls, &requestId);
+}
+
 static const UA_NodeId serviceFaultId = {
     0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_SERVICEFAULT_ENCODING_DEFAULTBINARY}};
 
-/* Look for the async callback in the linked list, execute and delete it */
+/* Look for the async callback by the requestId, execute and delete it */
+/* Multi-chunk messages are decoded from the segments of the chunk payloads */
 static UA_StatusCode
-processMSGResponse(UA_Client *client, UA_UInt32 requestId, const UA_ByteString *msg) {
+processMSGResponse(UA_Client *client, UA_UInt32 requestId,
+                   const UA_ByteString *msg, size_t msgSegments) {
     /* Find the callback */
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId == requestId)
-            break;
-    }
+    AsyncServiceCall *ac = asyncServiceCall_find(client, requestId);
 
     /* Part 6, 6.7.6: After the security validation is complete the receiver
      * shall verify the RequestId and the SequenceNumber. If these checks fail a
@@ -424,12 +503,17 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId, const UA_ByteString *
     const UA_DataType *responseType = ac->responseType;
 
     /* Dequeue ac. We might disconnect the client (remove all ac) in the callback. */
-    LIST_REMOVE(ac, pointers);
+    asyncServiceCall_remove(client, ac);
+
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
 
     /* Decode the response type */
     size_t offset = 0;
     UA_NodeId responseTypeId;
-    UA_StatusCode retval = UA_NodeId_decodeBinary(msg, &offset, &responseTypeId);
+    UA_StatusCode retval =
+        UA_decodeBinaryInternalSegments(msg, msgSegments, &offset, &responseTypeId,
+                                        &UA_TYPES[UA_TYPES_NODEID], NULL);
     if(retval != UA_STATUSCODE_GOOD)
         goto process;
 
@@ -460,8 +544,19 @@ processMSGResponse(UA_Client *client, UA_UInt32 requestId, const UA_ByteString *
     UA_LOG_DEBUG(client->config.logging, UA_LOGCATEGORY_CLIENT,
                  "Decode a message of type %" PRIu32, responseTypeId.identifier.numeric);
 #endif
-    retval = UA_decodeBinaryInternal(msg, &offset, response, responseType,
-                                     client->config.customDataTypes);
+    opts.customTypes = client->config.customDataTypes;
+    opts.typeIndex = __Client_getTypeIndex(client);
+    opts.arena = ac->arena;
+    /* A nested PublishResponse (processed from within a callback) cannot use
+     * the arena while it is in use */
+    if(client->config.publishResponseArena && !ac->syncResponse &&
+       responseType == &UA_TYPES[UA_TYPES_PUBLISHRESPONSE] &&
+       !client->publishArenaInUse) {
+        opts.arena = &client->publishArena;
+        client->publishArenaInUse = true;
+    }
+    retval = UA_decodeBinaryInternalSegments(msg, msgSegments, &offset,
+                                             response, responseType, &opts);
 
 process:
     /* Process the received MSG response */
@@ -478,7 +573,7 @@ process:
        (response->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONIDINVALID ||
         response->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONCLOSED)) {
         /* Clean up the session information and reset the state */
-        cleanupSession(client);
+        lostSession(client);
 
         if(client->config.noNewSession) {
             /* Configuration option to not create a new Session. Disconnect the
@@ -507,7 +602,12 @@ process:
     /* Clean up */
     UA_NodeId_clear(&responseTypeId);
     if(!ac->syncResponse) {
-        UA_clear(response, ac->responseType);
+        if(opts.arena) {
+            UA_Arena_reset(&client->publishArena);
+            client->publishArenaInUse = false;
+        } else {
+            UA_clear(response, ac->responseType);
+        }
         UA_free(ac);
     } else {
         ac->syncResponse = NULL; /* Indicate that response was received */
@@ -518,7 +618,7 @@ process:
 UA_StatusCode
 processServiceResponse(void *application, UA_SecureChannel *channel,
                        UA_MessageType messageType, UA_UInt32 requestId,
-                       UA_ByteString *message) {
+                       UA_ByteString *message, size_t messageSegments) {
     UA_Client *client = (UA_Client *)application;
 
     if(!UA_SecureChannel_isConnected(channel)) {
@@ -558,7 +658,7 @@ processServiceResponse(void *application, UA_SecureChannel *channel,
                                  "Process MSG message "
                                  "with RequestId %u",
                                  requestId);
-            return processMSGResponse(client, requestId, message);
+            return processMSGResponse(client, requestId, message, messageSegments);
         default:
             UA_LOG_TRACE_CHANNEL(client->config.logging, channel, "Invalid message type");
             channel->state = UA_SECURECHANNELSTATE_CLOSING;
@@ -566,9 +666,11 @@ processServiceResponse(void *application, UA_SecureChannel *channel,
     }
 }
 
-void
-__Client_Service(UA_Client *client, const void *request, const UA_DataType *requestType,
-                 void *response, const UA_DataType *responseType) {
+static void
+sendSyncServiceInternal(UA_Client *client, const void *request,
+                        const UA_DataType *requestType, const UA_ByteString *body,
+                        void *response, const UA_DataType *responseType,
+                        UA_Arena *arena) {
     UA_ResponseHeader *respHeader = (UA_ResponseHeader *)response;
 
     /* Initialize. Response is valied in case of aborting. */
@@ -599,7 +701,7 @@ __Client_Service(UA_Client *client, const void *request, const UA_DataType *requ
 
     /* Send the request */
     UA_UInt32 requestId = 0;
-    UA_StatusCode retval = sendRequest(client, request, requestType, &requestId);
+    UA_StatusCode retval = sendRequest(client, request, requestType, body, &requestId);
     if(retval != UA_STATUSCODE_GOOD) {
         /* If sending failed, the status is set to closing. The SecureChannel is
          * the actually closed in the next iteration of the EventLoop. */
@@ -620,21 +722,24 @@ __Client_Service(UA_Client *client, const void *request, const UA_DataType *requ
     ac.userdata = NULL;
     ac.responseType = responseType;
     ac.syncResponse = (UA_Response *)response;
+    ac.arena = arena;
     ac.requestId = requestId;
-    ac.start = el->dateTime_nowMonotonic(el); /* Start timeout after sending */
-    ac.timeout = rh->timeoutHint;
     ac.requestHandle = rh->requestHandle;
-    if(ac.timeout == 0)
-        ac.timeout = UA_UINT32_MAX; /* 0 -> unlimited */
+    UA_UInt32 timeout = rh->timeoutHint;
+    if(timeout == 0)
+        timeout = UA_UINT32_MAX; /* 0 -> unlimited */
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, &ac, pointers);
+    /* Time until which the request has to be answered. Start the timeout after
+     * sending. */
+    UA_DateTime maxDate = el->dateTime_nowMonotonic(el) +
+        ((UA_DateTime)timeout * UA_DATETIME_MSEC);
+    ac.deadline = maxDate;
 
-    /* Time until which the request has to be answered */
-    UA_DateTime maxDate = ac.start + ((UA_DateTime)ac.timeout * UA_DATETIME_MSEC);
+    asyncServiceCall_add(client, &ac);
 
     /* Run the EventLoop until the request was processed, the request has timed
      * out or the client connection fails */
-    UA_UInt32 timeout_remaining = ac.timeout;
+    UA_UInt32 timeout_remaining = timeout;
     while(true) {
         /* Unlock before dropping into the EventLoop. The client lock is
          * re-taken in the network callback if an event occurs. */
@@ -666,7 +771,7 @@ __Client_Service(UA_Client *client, const void *request, const UA_DataType *requ
         }
 
         /* Update the remaining timeout or break */
-        UA_DateTime now = ac.start = el->dateTime_nowMonotonic(el);
+        UA_DateTime now = el->dateTime_nowMonotonic(el);
         if(now > maxDate) {
             retval = UA_STATUSCODE_BADTIMEOUT;
             break;
@@ -674,13 +779,67 @@ __Client_Service(UA_Client *client, const void *request, const UA_DataType *requ
         timeout_remaining = (UA_UInt32)((maxDate - now) / UA_DATETIME_MSEC);
     }
 
-    /* Detach from the internal async service list */
-    LIST_REMOVE(&ac, pointers);
+    /* Detach from the internal async service index */
+    asyncServiceCall_remove(client, &ac);
 
     /* Return the status code */
     respHeader->serviceResult = retval;
 }
 
+static void
+sendSyncService(UA_Client *client, const void *request, const UA_DataType *requestType,
+                void *response, const UA_DataType *responseType) {
+    sendSyncServiceInternal(client, request, requestType, NULL,
+                            response, responseType, NULL);
+}
+
+/* Read the NamespaceArray once per Session to check that the cached entries
+ * belong to the address space of the server. Returns false if the cache cannot
+ * be used. */
+static UA_Boolean
+validateNodeCache(UA_Client *client) {
+    if(client->nodeCache.validated)
+        return true;
+    UA_ReadValueId rvid;
+    UA_ReadValueId_init(&rvid);
+    rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY);
+    rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    req.nodesToRead = &rvid;
+    req.nodesToReadSize = 1;
+    UA_ReadResponse resp;
+    sendSyncService(client, &req, &UA_TYPES[UA_TYPES_READREQUEST],
+                    &resp, &UA_TYPES[UA_TYPES_READRESPONSE]);
+    UA_Boolean valid = (resp.responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+                        resp.resultsSize == 1 && resp.results[0].hasValue);
+    if(valid)
+        __Client_NodeCache_validate(client, &resp.results[0].value);
+    UA_ReadResponse_clear(&resp);
+    return valid;
+}
+
+void
+__Client_Service(UA_Client *client, const void *request, const UA_DataType *requestType,
+                 void *response, const UA_DataType *responseType) {
+    /* Only Read and Browse are answered from the node cache */
+    if(client->config.nodeCacheSize == 0 ||
+       (requestType != &UA_TYPES[UA_TYPES_READREQUEST] &&
+        requestType != &UA_TYPES[UA_TYPES_BROWSEREQUEST])) {
+        sendSyncService(client, request, requestType, response, responseType);
+        return;
+    }
+
+    UA_Boolean useCache = validateNodeCache(client);
+    if(useCache && __Client_NodeCache_lookup(client, request, requestType, response))
+        return;
+    sendSyncService(client, request, requestType, response, responseType);
+    const UA_ResponseHeader *respHeader = (const UA_ResponseHeader *)response;
+    if(useCache && respHeader->serviceResult == UA_STATUSCODE_GOOD)
+        __Client_NodeCache_store(client, request, requestType, response);
+}
+
 void
 __UA_Client_Service(UA_Client *client, const void *request,
                     const UA_DataType *requestType, void *response,
@@ -690,6 +849,74 @@ __UA_Client_Service(UA_Client *client, const void *request,
     UA_UNLOCK(&client->clientMutex);
 }
 
+/*****************/
+/* Prepared Read */
+/*****************/
+
+struct UA_PreparedRead {
+    UA_ReadRequest request; /* Only the RequestHeader is encoded per call */
+    UA_ByteString body;     /* The encoded request without the header */
+    UA_ReadResponse response;
+    UA_Arena arena;         /* Memory of the decoded response */
+};
+
+UA_StatusCode
+UA_Client_prepareRead(UA_Client *client, const UA_ReadRequest *request,
+                      UA_PreparedRead **pr) {
+    (void)client;
+    if(!request || !pr)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_PreparedRead *p = (UA_PreparedRead*)UA_calloc(1, sizeof(UA_PreparedRead));
+    if(!p)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Encode the entire request. Then drop the encoded RequestHeader. */
+    UA_StatusCode res = UA_ReadRequest_copy(request, &p->request);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_encodeBinary(request, &UA_TYPES[UA_TYPES_READREQUEST], &p->body);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_PreparedRead_delete(p);
+        return res;
+    }
+    size_t headerSize = UA_calcSizeBinary(&request->requestHeader,
+                                          &UA_TYPES[UA_TYPES_REQUESTHEADER]);
+    p->body.length -= headerSize;
+    memmove(p->body.data, &p->body.data[headerSize], p->body.length);
+    *pr = p;
+    return UA_STATUSCODE_GOOD;
+}
+
+const UA_ReadResponse *
+UA_Client_readPrepared(UA_Client *client, UA_PreparedRead *pr) {
+    /* Reuse the memory of the previous response */
+    UA_Arena_reset(&pr->arena);
+
+    /* A new RequestHandle for every call */
+    UA_RequestHeader *rh = &pr->request.requestHeader;
+    UA_UInt32 requestHandle = rh->requestHandle;
+    UA_UInt32 timeoutHint = rh->timeoutHint;
+
+    UA_LOCK(&client->clientMutex);
+    sendSyncServiceInternal(client, &pr->request, &UA_TYPES[UA_TYPES_READREQUEST],
+                            &pr->body, &pr->response,
+                            &UA_TYPES[UA_TYPES_READRESPONSE], &pr->arena);
+    UA_UNLOCK(&client->clientMutex);
+
+    rh->requestHandle = requestHandle;
+    rh->timeoutHint = timeoutHint;
+    return &pr->response;
+}
+
+void
+UA_PreparedRead_delete(UA_PreparedRead *pr) {
+    if(!pr)
+        return;
+    UA_ReadRequest_clear(&pr->request);
+    UA_ByteString_clear(&pr->body);
+    UA_Arena_clear(&pr->arena);
+    UA_free(pr);
+}
+
 /***********************************/
 /* Handling of Async Service Calls */
 /***********************************/
@@ -721,20 +948,26 @@ __Client_AsyncService_cancel(UA_Client *client, AsyncServiceCall *ac,
     UA_free(ac);
 }
 
+static void
+asyncBatch_removeAll(UA_Client *client, UA_StatusCode statusCode);
+
 void
 __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode) {
+    /* Cancel the collected operations that were not sent yet */
+    asyncBatch_removeAll(client, statusCode);
+
     /* Make this function reentrant. One of the async callbacks could indirectly
-     * operate on the list. Moving all elements to a local list before iterating
-     * that. */
-    UA_AsyncServiceList asyncServiceCalls = client->asyncServiceCalls;
-    LIST_INIT(&client->asyncServiceCalls);
-    if(asyncServiceCalls.lh_first)
-        asyncServiceCalls.lh_first->pointers.le_prev = &asyncServiceCalls.lh_first;
-
-    /* Cancel and remove the elements from the local list */
-    AsyncServiceCall *ac, *ac_tmp;
-    LIST_FOREACH_SAFE(ac, &asyncServiceCalls, pointers, ac_tmp) {
-        LIST_REMOVE(ac, pointers);
+     * operate on the index. Moving all elements to a local tree before
+     * iterating that. */
+    UA_AsyncServiceDeadlineTree deadlines = client->asyncServiceDeadlines;
+    ZIP_INIT(&client->asyncServiceCalls);
+    ZIP_INIT(&client->asyncServiceDeadlines);
+    client->asyncServiceCallsSize = 0;
+
+    /* Cancel and remove the elements from the local tree */
+    AsyncServiceCall *ac;
+    while((ac = ZIP_MIN(UA_AsyncServiceDeadlineTree, &deadlines))) {
+        ZIP_REMOVE(UA_AsyncServiceDeadlineTree, &deadlines, ac);
         __Client_AsyncService_cancel(client, ac, statusCode);
     }
 }
@@ -743,26 +976,23 @@ UA_StatusCode
 UA_Client_modifyAsyncCallback(UA_Client *client, UA_UInt32 requestId, void *userdata,
                               UA_ClientAsyncServiceCallback callback) {
     UA_LOCK(&client->clientMutex);
-    AsyncServiceCall *ac;
     UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId == requestId) {
-            ac->callback = callback;
-            ac->userdata = userdata;
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
+    AsyncServiceCall *ac = asyncServiceCall_find(client, requestId);
+    if(ac) {
+        ac->callback = callback;
+        ac->userdata = userdata;
+        res = UA_STATUSCODE_GOOD;
     }
     UA_UNLOCK(&client->clientMutex);
     return res;
 }
 
-UA_StatusCode
-__Client_AsyncService(UA_Client *client, const void *request,
-                      const UA_DataType *requestType,
-                      UA_ClientAsyncServiceCallback callback,
-                      const UA_DataType *responseType, void *userdata,
-                      UA_UInt32 *requestId) {
+static UA_StatusCode
+sendAsyncService(UA_Client *client, const void *request,
+                 const UA_DataType *requestType,
+                 UA_ClientAsyncServiceCallback callback,
+                 const UA_DataType *responseType, void *userdata,
+                 UA_UInt32 *requestId) {
     UA_LOCK_ASSERT(&client->clientMutex, 1);
 
     /* Is the SecureChannel connected? */
@@ -778,7 +1008,7 @@ __Client_AsyncService(UA_Client *client, const void *request,
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Call the service and set the requestId */
-    UA_StatusCode retval = sendRequest(client, request, requestType, &ac->requestId);
+    UA_StatusCode retval = sendRequest(client, request, requestType, NULL, &ac->requestId);
     if(retval != UA_STATUSCODE_GOOD) {
         /* If sending failed, the status is set to closing. The SecureChannel is
          * the actually closed in the next iteration of the EventLoop. */
@@ -796,13 +1026,15 @@ __Client_AsyncService(UA_Client *client, const void *request,
     ac->responseType = responseType;
     ac->userdata = userdata;
     ac->syncResponse = NULL;
-    ac->start = el->dateTime_nowMonotonic(el);
-    ac->timeout = rh->timeoutHint;
+    ac->arena = NULL;
     ac->requestHandle = rh->requestHandle;
-    if(ac->timeout == 0)
-        ac->timeout = UA_UINT32_MAX; /* 0 -> unlimited */
+    UA_UInt32 timeout = rh->timeoutHint;
+    if(timeout == 0)
+        timeout = UA_UINT32_MAX; /* 0 -> unlimited */
+    ac->deadline = el->dateTime_nowMonotonic(el) +
+        ((UA_DateTime)timeout * UA_DATETIME_MSEC);
 
-    LIST_INSERT_HEAD(&client->asyncServiceCalls, ac, pointers);
+    asyncServiceCall_add(client, ac);
 
     /* Return the generated request id */
     if(requestId)
@@ -814,6 +1046,287 @@ __Client_AsyncService(UA_Client *client, const void *request,
     return UA_STATUSCODE_GOOD;
 }
 
+/*************************************/
+/* Coalescing of Async Service Calls */
+/*************************************/
+
+/* The collected calls of a combined request that was sent */
+typedef struct {
+    const UA_DataType *responseType;
+    size_t callsSize;
+    AsyncBatchedCall *calls;
+} AsyncBatchSent;
+
+/* Call back every collected call with its own item of the combined response */
+static void
+asyncBatch_dispatch(UA_Client *client, const UA_DataType *responseType,
+                    size_t callsSize, AsyncBatchedCall *calls,
+                    UA_UInt32 requestId, void *response) {
+    /* Read and Write responses have the same layout. Only the type of the
+     * results differs. */
+    UA_ReadResponse *rr = (UA_ReadResponse*)response;
+    UA_StatusCode res = rr->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && rr->resultsSize != callsSize)
+        res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    UA_Boolean withDiagnostics = (rr->diagnosticInfosSize == callsSize);
+    size_t resultSize = (responseType == &UA_TYPES[UA_TYPES_READRESPONSE]) ?
+        sizeof(UA_DataValue) : sizeof(UA_StatusCode);
+
+    for(size_t i = 0; i < callsSize; i++) {
+        if(!calls[i].callback)
+            continue;
+        UA_ReadResponse single;
+        UA_ReadResponse_init(&single);
+        single.responseHeader = rr->responseHeader;
+        single.responseHeader.serviceResult = res;
+        if(res == UA_STATUSCODE_GOOD) {
+            single.resultsSize = 1;
+            single.results = (UA_DataValue*)(void*)
+                ((uintptr_t)rr->results + (i * resultSize));
+            if(withDiagnostics) {
+                single.diagnosticInfosSize = 1;
+                single.diagnosticInfos = &rr->diagnosticInfos[i];
+            }
+        }
+        calls[i].callback(client, calls[i].userdata, requestId, &single);
+    }
+}
+
+static void
+asyncBatch_responseCallback(UA_Client *client, void *userdata,
+                            UA_UInt32 requestId, void *response) {
+    AsyncBatchSent *sent = (AsyncBatchSent*)userdata;
+    asyncBatch_dispatch(client, sent->responseType, sent->callsSize,
+                        sent->calls, requestId, response);
+    UA_free(sent->calls);
+    UA_free(sent);
+}
+
+/* Call back the collected calls with an error */
+static void
+asyncBatch_fail(UA_Client *client, const UA_DataType *responseType,
+                size_t callsSize, AsyncBatchedCall *calls, UA_StatusCode res) {
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    response.responseHeader.serviceResult = res;
+    UA_UNLOCK(&client->clientMutex);
+    asyncBatch_dispatch(client, responseType, callsSize, calls, 0, &response);
+    UA_LOCK(&client->clientMutex);
+    UA_free(calls);
+}
+
+/* Send the collected calls as one request */
+static void
+asyncBatch_flush(UA_Client *client, AsyncBatch *batch,
+                 const UA_DataType *requestType) {
+    if(batch->itemsSize == 0)
+        return;
+
+    /* Take the calls out of the batch. A callback could add new calls. */
+    AsyncBatch b = *batch;
+    memset(batch, 0, sizeof(AsyncBatch));
+
+    UA_ReadRequest readRequest;
+    UA_WriteRequest writeRequest;
+    const void *request;
+    const UA_DataType *responseType;
+    const UA_DataType *itemType;
+    UA_RequestHeader *rh;
+    if(requestType == &UA_TYPES[UA_TYPES_READREQUEST]) {
+        UA_ReadRequest_init(&readRequest);
+        readRequest.nodesToRead = (UA_ReadValueId*)b.items;
+        readRequest.nodesToReadSize = b.itemsSize;
+        readRequest.timestampsToReturn = b.timestampsToReturn;
+        readRequest.maxAge = b.maxAge;
+        rh = &readRequest.requestHeader;
+        request = &readRequest;
+        responseType = &UA_TYPES[UA_TYPES_READRESPONSE];
+        itemType = &UA_TYPES[UA_TYPES_READVALUEID];
+    } else {
+        UA_WriteRequest_init(&writeRequest);
+        writeRequest.nodesToWrite = (UA_WriteValue*)b.items;
+        writeRequest.nodesToWriteSize = b.itemsSize;
+        rh = &writeRequest.requestHeader;
+        request = &writeRequest;
+        responseType = &UA_TYPES[UA_TYPES_WRITERESPONSE];
+        itemType = &UA_TYPES[UA_TYPES_WRITEVALUE];
+    }
+    rh->timeoutHint = b.timeoutHint;
+
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    AsyncBatchSent *sent = (AsyncBatchSent*)UA_malloc(sizeof(AsyncBatchSent));
+    if(sent) {
+        sent->responseType = responseType;
+        sent->callsSize = b.itemsSize;
+        sent->calls = b.calls;
+        res = sendAsyncService(client, request, requestType,
+                               asyncBatch_responseCallback, responseType,
+                               sent, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            UA_free(sent);
+    }
+
+    /* The request was encoded. Clean up the items. */
+    UA_Array_delete(b.items, b.itemsSize, itemType);
+    if(res != UA_STATUSCODE_GOOD)
+        asyncBatch_fail(client, responseType, b.itemsSize, b.calls, res);
+}
+
+static void
+asyncBatch_flushCallback(UA_Client *client, void *_) {
+    UA_LOCK(&client->clientMutex);
+    client->batchFlushCallbackId = 0;
+    asyncBatch_flush(client, &client->readBatch, &UA_TYPES[UA_TYPES_READREQUEST]);
+    asyncBatch_flush(client, &client->writeBatch, &UA_TYPES[UA_TYPES_WRITEREQUEST]);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+static void
+asyncBatch_removeAll(UA_Client *client, UA_StatusCode statusCode) {
+    if(client->batchFlushCallbackId != 0) {
+        UA_EventLoop *el = client->config.eventLoop;
+        el->removeCyclicCallback(el, client->batchFlushCallbackId);
+        client->batchFlushCallbackId = 0;
+    }
+
+    AsyncBatch rb = client->readBatch;
+    AsyncBatch wb = client->writeBatch;
+    memset(&client->readBatch, 0, sizeof(AsyncBatch));
+    memset(&client->writeBatch, 0, sizeof(AsyncBatch));
+    UA_Array_delete(rb.items, rb.itemsSize, &UA_TYPES[UA_TYPES_READVALUEID]);
+    UA_Array_delete(wb.items, wb.itemsSize, &UA_TYPES[UA_TYPES_WRITEVALUE]);
+    if(rb.itemsSize > 0)
+        asyncBatch_fail(client, &UA_TYPES[UA_TYPES_READRESPONSE],
+                        rb.itemsSize, rb.calls, statusCode);
+    else
+        UA_free(rb.calls);
+    if(wb.itemsSize > 0)
+        asyncBatch_fail(client, &UA_TYPES[UA_TYPES_WRITERESPONSE],
+                        wb.itemsSize, wb.calls, statusCode);
+    else
+        UA_free(wb.calls);
+}
+
+/* Returns the batch if the request can be coalesced */
+static AsyncBatch *
+asyncBatch_select(UA_Client *client, const void *request,
+                  const UA_DataType *requestType) {
+    if(!client->config.asyncBatching)
+        return NULL;
+    const UA_RequestHeader *rh = (const UA_RequestHeader *)request;
+    if(rh->requestHandle != 0 || rh->returnDiagnostics != 0 ||
+       rh->additionalHeader.encoding != UA_EXTENSIONOBJECT_ENCODED_NOBODY)
+        return NULL;
+    if(requestType == &UA_TYPES[UA_TYPES_READREQUEST]) {
+        const UA_ReadRequest *rr = (const UA_ReadRequest*)request;
+        return (rr->nodesToReadSize == 1) ? &client->readBatch : NULL;
+    }
+    if(requestType == &UA_TYPES[UA_TYPES_WRITEREQUEST]) {
+        const UA_WriteRequest *wr = (const UA_WriteRequest*)request;
+        return (wr->nodesToWriteSize == 1) ? &client->writeBatch : NULL;
+    }
+    return NULL;
+}
+
+static UA_StatusCode
+asyncBatch_add(UA_Client *client, AsyncBatch *batch, const void *request,
+               const UA_DataType *requestType,
+               UA_ClientAsyncServiceCallback callback, void *userdata) {
+    const UA_DataType *itemType;
+    const void *item;
+    UA_UInt32 maxItems;
+    if(batch == &client->readBatch) {
+        const UA_ReadRequest *rr = (const UA_ReadRequest*)request;
+        /* Reads with other parameters are sent separately */
+        if(batch->itemsSize > 0 &&
+           (batch->timestampsToReturn != rr->timestampsToReturn ||
+            batch->maxAge != rr->maxAge))
+            asyncBatch_flush(client, batch, requestType);
+        batch->timestampsToReturn = rr->timestampsToReturn;
+        batch->maxAge = rr->maxAge;
+        itemType = &UA_TYPES[UA_TYPES_READVALUEID];
+        item = rr->nodesToRead;
+        maxItems = client->config.asyncBatchingMaxNodesPerRead;
+    } else {
+        const UA_WriteRequest *wr = (const UA_WriteRequest*)request;
+        itemType = &UA_TYPES[UA_TYPES_WRITEVALUE];
+        item = wr->nodesToWrite;
+        maxItems = client->config.asyncBatchingMaxNodesPerWrite;
+    }
+
+    /* Grow the batch */
+    if(batch->itemsSize == batch->itemsCapacity) {
+        size_t newCapacity = (batch->itemsCapacity == 0) ? 16 : batch->itemsCapacity * 2;
+        void *newItems = UA_realloc(batch->items, newCapacity * itemType->memSize);
+        if(!newItems)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        batch->items = newItems;
+        AsyncBatchedCall *newCalls = (AsyncBatchedCall*)
+            UA_realloc(batch->calls, newCapacity * sizeof(AsyncBatchedCall));
+        if(!newCalls)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        batch->calls = newCalls;
+        batch->itemsCapacity = newCapacity;
+    }
+
+    /* Copy the item */
+    void *dst = (void*)((uintptr_t)batch->items + (batch->itemsSize * itemType->memSize));
+    UA_StatusCode res = UA_copy(item, dst, itemType);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    batch->calls[batch->itemsSize].callback = callback;
+    batch->calls[batch->itemsSize].userdata = userdata;
+    batch->itemsSize++;
+
+    /* The combined request times out with the earliest operation */
+    const UA_RequestHeader *rh = (const UA_RequestHeader *)request;
+    if(rh->timeoutHint != 0 &&
+       (batch->timeoutHint == 0 || rh->timeoutHint < batch->timeoutHint))
+        batch->timeoutHint = rh->timeoutHint;
+
+    /* The batch is full */
+    if(maxItems > 0 && batch->itemsSize >= maxItems) {
+        asyncBatch_flush(client, batch, requestType);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Schedule sending the batch */
+    if(client->batchFlushCallbackId == 0) {
+        UA_EventLoop *el = client->config.eventLoop;
+        UA_DateTime date = el->dateTime_nowMonotonic(el) +
+            (UA_DateTime)(client->config.asyncBatchingWindow * UA_DATETIME_MSEC);
+        res = el->addTimedCallback(el, (UA_Callback)asyncBatch_flushCallback,
+                                   client, NULL, date, &client->batchFlushCallbackId);
+        if(res != UA_STATUSCODE_GOOD)
+            asyncBatch_flush(client, batch, requestType);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+__Client_AsyncService(UA_Client *client, const void *request,
+                      const UA_DataType *requestType,
+                      UA_ClientAsyncServiceCallback callback,
+                      const UA_DataType *responseType, void *userdata,
+                      UA_UInt32 *requestId) {
+    UA_LOCK_ASSERT(&client->clientMutex, 1);
+
+    /* Collect single-item operations for a combined request */
+    AsyncBatch *batch = asyncBatch_select(client, request, requestType);
+    if(!batch)
+        return sendAsyncService(client, request, requestType, callback,
+                                responseType, userdata, requestId);
+
+    if(client->channel.state != UA_SECURECHANNELSTATE_OPEN) {
+        UA_LOG_ERROR(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                     "SecureChannel must be connected to send request");
+        return UA_STATUSCODE_BADSERVERNOTCONNECTED;
+    }
+    if(requestId)
+        *requestId = 0;
+    return asyncBatch_add(client, batch, request, requestType, callback, userdata);
+}
+
 UA_StatusCode
 __UA_Client_AsyncService(UA_Client *client, const void *request,
                          const UA_DataType *requestType,
@@ -858,13 +1371,9 @@ UA_Client_cancelByRequestId(UA_Client *client, UA_UInt32 requestId,
                             UA_UInt32 *cancelCount) {
     UA_LOCK(&client->clientMutex);
     UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    AsyncServiceCall *ac;
-    LIST_FOREACH(ac, &client->asyncServiceCalls, pointers) {
-        if(ac->requestId != requestId)
-            continue;
+    AsyncServiceCall *ac = asyncServiceCall_find(client, requestId);
+    if(ac)
         res = cancelByRequestHandle(client, ac->requestHandle, cancelCount);
-        break;
-    }
     UA_UNLOCK(&client->clientMutex);
     return res;
 }
@@ -924,28 +1433,30 @@ UA_Client_removeCallback(UA_Client *client, UA_UInt64 callbackId) {
 /* Housekeeping Tasks */
 /**********************/
 
+static void *
+removeFromIdTree(void *context, AsyncServiceCall *ac) {
+    UA_Client *client = (UA_Client*)context;
+    ZIP_REMOVE(UA_AsyncServiceIdTree, &client->asyncServiceCalls, ac);
+    client->asyncServiceCallsSize--;
+    return NULL;
+}
+
 static void
 asyncServiceTimeoutCheck(UA_Client *client) {
     /* Make this function reentrant. One of the async callbacks could indirectly
-     * operate on the list. Moving all elements to a local list before iterating
-     * that. */
+     * operate on the index. Split off the expired calls into a local tree
+     * before iterating that. Only the expired calls are visited. */
     UA_EventLoop *el = client->config.eventLoop;
     UA_DateTime now = el->dateTime_nowMonotonic(el);
-    UA_AsyncServiceList asyncServiceCalls;
-    AsyncServiceCall *ac, *ac_tmp;
-    LIST_INIT(&asyncServiceCalls);
-    LIST_FOREACH_SAFE(ac, &client->asyncServiceCalls, pointers, ac_tmp) {
-        if(!ac->timeout)
-            continue;
-        if(ac->start + (UA_DateTime)(ac->timeout * UA_DATETIME_MSEC) <= now) {
-            LIST_REMOVE(ac, pointers);
-            LIST_INSERT_HEAD(&asyncServiceCalls, ac, pointers);
-        }
-    }
+    UA_AsyncServiceDeadlineTree expired;
+    ZIP_UNZIP(UA_AsyncServiceDeadlineTree, &client->asyncServiceDeadlines, &now,
+              &expired, &client->asyncServiceDeadlines);
+    ZIP_ITER(UA_AsyncServiceDeadlineTree, &expired, removeFromIdTree, client);
 
-    /* Cancel and remove the elements from the local list */
-    LIST_FOREACH_SAFE(ac, &asyncServiceCalls, pointers, ac_tmp) {
-        LIST_REMOVE(ac, pointers);
+    /* Cancel and remove the elements from the local tree */
+    AsyncServiceCall *ac;
+    while((ac = ZIP_MIN(UA_AsyncServiceDeadlineTree, &expired))) {
+        ZIP_REMOVE(UA_AsyncServiceDeadlineTree, &expired, ac);
         __Client_AsyncService_cancel(client, ac, UA_STATUSCODE_BADTIMEOUT);
     }
 }
@@ -1071,9 +1582,30 @@ UA_Client_run_iterate(UA_Client *client, UA_UInt32 timeout) {
     return client->connectStatus;
 }
 
+const UA_DataTypeIndex *
+__Client_getTypeIndex(UA_Client *client) {
+    const UA_DataTypeArray *customTypes = client->config.customDataTypes;
+    if(client->typeIndex && client->typeIndexTypes == customTypes)
+        return client->typeIndex;
+    UA_DataTypeIndex_delete(client->typeIndex);
+    client->typeIndex = NULL;
+    client->typeIndexTypes = NULL;
+    if(!customTypes)
+        return NULL;
+    client->typeIndex = UA_DataTypeIndex_new(customTypes);
+    if(client->typeIndex)
+        client->typeIndexTypes = customTypes;
+    return client->typeIndex;
+}
+
 const UA_DataType *
 UA_Client_findDataType(UA_Client *client, const UA_NodeId *typeId) {
-    return UA_findDataTypeWithCustom(typeId, client->config.customDataTypes);
+    UA_LOCK(&client->clientMutex);
+    const UA_DataTypeIndex *index = __Client_getTypeIndex(client);
+    const UA_DataType *type = (index) ? UA_DataTypeIndex_find(index, typeId) :
+        UA_findDataTypeWithCustom(typeId, client->config.customDataTypes);
+    UA_UNLOCK(&client->clientMutex);
+    return type;
 }
 
 /*************************/
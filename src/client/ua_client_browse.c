@@ -0,0 +1,375 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/client_highlevel_async.h>
+
+#include "open62541_queue.h"
+#include "ziptree.h"
+
+/* Recursive Browse with several pipelined requests. Every node is browsed at
+ * most once. The visited nodes are kept in a tree ordered by the NodeId hash.
+ * Nodes with a continuation point are sent in BrowseNext requests first. So
+ * the references of a node are complete before more continuation points are
+ * opened in the server. */
+
+typedef struct {
+    UA_UInt32 hash;
+    UA_NodeId nodeId;
+} BrowseNodeKey;
+
+typedef struct BrowseNode {
+    ZIP_ENTRY(BrowseNode) treeEntry;
+    SIMPLEQ_ENTRY(BrowseNode) queueEntry; /* In the browse or the next queue */
+    BrowseNodeKey key;
+    UA_ByteString continuationPoint;
+} BrowseNode;
+
+static enum ZIP_CMP
+cmpBrowseNodeKey(const BrowseNodeKey *a, const BrowseNodeKey *b) {
+    if(a->hash != b->hash)
+        return (a->hash < b->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&a->nodeId, &b->nodeId);
+}
+
+typedef ZIP_HEAD(BrowseNodeTree, BrowseNode) BrowseNodeTree;
+ZIP_FUNCTIONS(BrowseNodeTree, BrowseNode, treeEntry,
+              BrowseNodeKey, key, cmpBrowseNodeKey)
+
+typedef struct {
+    UA_BrowseDescription bd; /* Template for the nodes to browse */
+    size_t nodesPerRequest;
+    size_t maxRequestsInFlight;
+    UA_ClientBrowseRecursiveCallback callback;
+    UA_ClientBrowseRecursiveDoneCallback doneCallback;
+    void *userdata;
+
+    BrowseNodeTree visited;
+    SIMPLEQ_HEAD(, BrowseNode) browseQueue; /* Not browsed yet */
+    SIMPLEQ_HEAD(, BrowseNode) nextQueue;   /* With a continuation point */
+    size_t inFlight;
+
+    UA_Boolean aborted;
+    UA_StatusCode status;     /* Service-level error */
+    UA_StatusCode nodeStatus; /* First bad status of a node */
+} BrowseRecursive;
+
+/* The nodes of a pending request. Allocated together with the array. */
+typedef struct {
+    BrowseRecursive *br;
+    size_t nodesSize;
+    BrowseNode **nodes;
+} BrowseRecursiveRequest;
+
+static UA_StatusCode
+addBrowseNode(BrowseRecursive *br, const UA_NodeId *nodeId) {
+    BrowseNodeKey key;
+    key.hash = UA_NodeId_hash(nodeId);
+    key.nodeId = *nodeId;
+    if(ZIP_FIND(BrowseNodeTree, &br->visited, &key))
+        return UA_STATUSCODE_GOOD;
+
+    BrowseNode *node = (BrowseNode*)UA_calloc(1, sizeof(BrowseNode));
+    if(!node)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    node->key.hash = key.hash;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &node->key.nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(node);
+        return res;
+    }
+    ZIP_INSERT(BrowseNodeTree, &br->visited, node);
+    SIMPLEQ_INSERT_TAIL(&br->browseQueue, node, queueEntry);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void *
+deleteBrowseNode(void *context, BrowseNode *node) {
+    UA_NodeId_clear(&node->key.nodeId);
+    UA_ByteString_clear(&node->continuationPoint);
+    UA_free(node);
+    return NULL;
+}
+
+static void
+browseRecursive_abort(BrowseRecursive *br, UA_StatusCode status) {
+    if(br->aborted)
+        return;
+    br->aborted = true;
+    br->status = status;
+}
+
+/* Release the remaining continuation points in the server. The response is
+ * not awaited. Then notify the user and clean up. */
+static void
+browseRecursive_finish(UA_Client *client, BrowseRecursive *br) {
+    BrowseNode *node;
+    while(!SIMPLEQ_EMPTY(&br->nextQueue)) {
+        UA_ByteString cps[16];
+        size_t cpsSize = 0;
+        while(cpsSize < 16 && !SIMPLEQ_EMPTY(&br->nextQueue)) {
+            node = SIMPLEQ_FIRST(&br->nextQueue);
+            SIMPLEQ_REMOVE_HEAD(&br->nextQueue, queueEntry);
+            cps[cpsSize++] = node->continuationPoint;
+        }
+        UA_BrowseNextRequest request;
+        UA_BrowseNextRequest_init(&request);
+        request.releaseContinuationPoints = true;
+        request.continuationPoints = cps;
+        request.continuationPointsSize = cpsSize;
+        UA_UInt32 requestId;
+        __UA_Client_AsyncService(client, &request,
+                                 &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST], NULL,
+                                 &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE],
+                                 NULL, &requestId);
+    }
+
+    UA_StatusCode status = br->status;
+    if(status == UA_STATUSCODE_GOOD)
+        status = br->nodeStatus;
+    if(br->doneCallback)
+        br->doneCallback(client, br->userdata, status);
+
+    ZIP_ITER(BrowseNodeTree, &br->visited, deleteBrowseNode, NULL);
+    UA_BrowseDescription_clear(&br->bd);
+    UA_free(br);
+}
+
+static void browseRecursive_send(UA_Client *client, BrowseRecursive *br);
+
+static void
+browseRecursive_process(UA_Client *client, BrowseRecursiveRequest *req,
+                        UA_StatusCode serviceResult,
+                        UA_BrowseResult *results, size_t resultsSize) {
+    BrowseRecursive *br = req->br;
+    br->inFlight--;
+
+    if(serviceResult == UA_STATUSCODE_GOOD && resultsSize != req->nodesSize)
+        serviceResult = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    if(serviceResult != UA_STATUSCODE_GOOD) {
+        browseRecursive_abort(br, serviceResult);
+        resultsSize = 0;
+    }
+
+    /* Does the walk hold continuation points that are released later? */
+    UA_Boolean holdsCPs = (br->inFlight > 0 || !SIMPLEQ_EMPTY(&br->nextQueue));
+    for(size_t i = 0; i < resultsSize && !holdsCPs; i++)
+        holdsCPs = (results[i].continuationPoint.length > 0);
+
+    for(size_t i = 0; i < resultsSize; i++) {
+        BrowseNode *node = req->nodes[i];
+        UA_BrowseResult *r = &results[i];
+
+        /* The continuation points of the session are used up by the pipelined
+         * requests. The server returns no references then. Browse the node
+         * again after the pending continuation points were released. */
+        if(r->statusCode == UA_STATUSCODE_BADNOCONTINUATIONPOINTS &&
+           holdsCPs && !br->aborted) {
+            SIMPLEQ_INSERT_TAIL(&br->browseQueue, node, queueEntry);
+            continue;
+        }
+
+        if(r->statusCode != UA_STATUSCODE_GOOD) {
+            if(br->nodeStatus == UA_STATUSCODE_GOOD)
+                br->nodeStatus = r->statusCode;
+            continue;
+        }
+
+        /* Take the continuation point. Also when aborted, so that it is
+         * released in the server. */
+        if(r->continuationPoint.length > 0) {
+            node->continuationPoint = r->continuationPoint;
+            UA_ByteString_init(&r->continuationPoint);
+            SIMPLEQ_INSERT_TAIL(&br->nextQueue, node, queueEntry);
+        }
+
+        for(size_t j = 0; j < r->referencesSize && !br->aborted; j++) {
+            UA_ReferenceDescription *rd = &r->references[j];
+            if(!br->callback(client, br->userdata, &node->key.nodeId, rd)) {
+                browseRecursive_abort(br, UA_STATUSCODE_GOOD);
+                break;
+            }
+
+            /* Only follow nodes in the same server */
+            if(rd->nodeId.serverIndex != 0 || rd->nodeId.namespaceUri.length > 0)
+                continue;
+            UA_StatusCode res = addBrowseNode(br, &rd->nodeId.nodeId);
+            if(res != UA_STATUSCODE_GOOD) {
+                browseRecursive_abort(br, res);
+                break;
+            }
+        }
+    }
+
+    UA_free(req);
+    browseRecursive_send(client, br);
+    if(br->inFlight == 0)
+        browseRecursive_finish(client, br);
+}
+
+static void
+browseRecursive_browseCallback(UA_Client *client, void *userdata,
+                               UA_UInt32 requestId, UA_BrowseResponse *response) {
+    browseRecursive_process(client, (BrowseRecursiveRequest*)userdata,
+                            response->responseHeader.serviceResult,
+                            response->results, response->resultsSize);
+}
+
+static void
+browseRecursive_browseNextCallback(UA_Client *client, void *userdata,
+                                   UA_UInt32 requestId,
+                                   UA_BrowseNextResponse *response) {
+    browseRecursive_process(client, (BrowseRecursiveRequest*)userdata,
+                            response->responseHeader.serviceResult,
+                            response->results, response->resultsSize);
+}
+
+static BrowseRecursiveRequest *
+browseRecursive_newRequest(BrowseRecursive *br) {
+    BrowseRecursiveRequest *req = (BrowseRecursiveRequest*)
+        UA_malloc(sizeof(BrowseRecursiveRequest) +
+                  (br->nodesPerRequest * sizeof(BrowseNode*)));
+    if(!req)
+        return NULL;
+    req->br = br;
+    req->nodes = (BrowseNode**)(uintptr_t)&req[1];
+    req->nodesSize = 0;
+    return req;
+}
+
+static UA_StatusCode
+browseRecursive_sendBrowse(UA_Client *client, BrowseRecursive *br) {
+    BrowseRecursiveRequest *req = browseRecursive_newRequest(br);
+    UA_BrowseDescription *bds = (UA_BrowseDescription*)
+        UA_malloc(br->nodesPerRequest * sizeof(UA_BrowseDescription));
+    if(!req || !bds) {
+        UA_free(req);
+        UA_free(bds);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    while(req->nodesSize < br->nodesPerRequest && !SIMPLEQ_EMPTY(&br->browseQueue)) {
+        BrowseNode *node = SIMPLEQ_FIRST(&br->browseQueue);
+        SIMPLEQ_REMOVE_HEAD(&br->browseQueue, queueEntry);
+        bds[req->nodesSize] = br->bd;
+        bds[req->nodesSize].nodeId = node->key.nodeId;
+        req->nodes[req->nodesSize++] = node;
+    }
+
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.nodesToBrowse = bds;
+    request.nodesToBrowseSize = req->nodesSize;
+
+    /* The request is encoded right away. The descriptions only point into the
+     * template and the nodes. */
+    UA_UInt32 requestId;
+    UA_StatusCode res =
+        __UA_Client_AsyncService(client, &request, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                                 (UA_ClientAsyncServiceCallback)
+                                 browseRecursive_browseCallback,
+                                 &UA_TYPES[UA_TYPES_BROWSERESPONSE], req, &requestId);
+    UA_free(bds);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(req);
+        return res;
+    }
+    br->inFlight++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+browseRecursive_sendBrowseNext(UA_Client *client, BrowseRecursive *br) {
+    BrowseRecursiveRequest *req = browseRecursive_newRequest(br);
+    UA_ByteString *cps = (UA_ByteString*)
+        UA_malloc(br->nodesPerRequest * sizeof(UA_ByteString));
+    if(!req || !cps) {
+        UA_free(req);
+        UA_free(cps);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    while(req->nodesSize < br->nodesPerRequest && !SIMPLEQ_EMPTY(&br->nextQueue)) {
+        BrowseNode *node = SIMPLEQ_FIRST(&br->nextQueue);
+        SIMPLEQ_REMOVE_HEAD(&br->nextQueue, queueEntry);
+        cps[req->nodesSize] = node->continuationPoint;
+        req->nodes[req->nodesSize++] = node;
+    }
+
+    UA_BrowseNextRequest request;
+    UA_BrowseNextRequest_init(&request);
+    request.continuationPoints = cps;
+    request.continuationPointsSize = req->nodesSize;
+
+    UA_UInt32 requestId;
+    UA_StatusCode res =
+        __UA_Client_AsyncService(client, &request,
+                                 &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST],
+                                 (UA_ClientAsyncServiceCallback)
+                                 browseRecursive_browseNextCallback,
+                                 &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE],
+                                 req, &requestId);
+    UA_free(cps);
+
+    /* The continuation points were sent and are no longer needed. Also if the
+     * sending failed. Then they are released with the session. */
+    for(size_t i = 0; i < req->nodesSize; i++)
+        UA_ByteString_clear(&req->nodes[i]->continuationPoint);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(req);
+        return res;
+    }
+    br->inFlight++;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Fill up the window of pending requests */
+static void
+browseRecursive_send(UA_Client *client, BrowseRecursive *br) {
+    while(!br->aborted && br->inFlight < br->maxRequestsInFlight) {
+        UA_StatusCode res;
+        if(!SIMPLEQ_EMPTY(&br->nextQueue))
+            res = browseRecursive_sendBrowseNext(client, br);
+        else if(!SIMPLEQ_EMPTY(&br->browseQueue))
+            res = browseRecursive_sendBrowse(client, br);
+        else
+            break;
+        if(res != UA_STATUSCODE_GOOD)
+            browseRecursive_abort(br, res);
+    }
+}
+
+UA_StatusCode
+UA_Client_browseRecursive_async(UA_Client *client, const UA_BrowseDescription *bd,
+                                size_t nodesPerRequest, size_t maxRequestsInFlight,
+                                UA_ClientBrowseRecursiveCallback callback,
+                                UA_ClientBrowseRecursiveDoneCallback doneCallback,
+                                void *userdata) {
+    if(!bd || !callback)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    BrowseRecursive *br = (BrowseRecursive*)UA_calloc(1, sizeof(BrowseRecursive));
+    if(!br)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    br->nodesPerRequest = (nodesPerRequest > 0) ? nodesPerRequest : 1;
+    br->maxRequestsInFlight = (maxRequestsInFlight > 0) ? maxRequestsInFlight : 1;
+    br->callback = callback;
+    br->doneCallback = doneCallback;
+    br->userdata = userdata;
+    ZIP_INIT(&br->visited);
+    SIMPLEQ_INIT(&br->browseQueue);
+    SIMPLEQ_INIT(&br->nextQueue);
+
+    UA_StatusCode res = UA_BrowseDescription_copy(bd, &br->bd);
+    if(res == UA_STATUSCODE_GOOD)
+        res = addBrowseNode(br, &bd->nodeId);
+    if(res == UA_STATUSCODE_GOOD)
+        res = browseRecursive_sendBrowse(client, br);
+    if(res != UA_STATUSCODE_GOOD) {
+        ZIP_ITER(BrowseNodeTree, &br->visited, deleteBrowseNode, NULL);
+        UA_BrowseDescription_clear(&br->bd);
+        UA_free(br);
+    }
+    return res;
+}
@@ -0,0 +1,706 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_client_internal.h"
+#include "ua_types_encoding_binary.h"
+
+#define UA_NODECACHE_VERSION 1
+
+static enum ZIP_CMP
+cmpNodeCacheEntry(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_NodeCacheTree, UA_NodeCacheEntry, zipfields,
+              UA_NodeId, nodeId, cmpNodeCacheEntry)
+
+static const UA_NodeId namespaceArrayId =
+    {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_SERVER_NAMESPACEARRAY}};
+
+/*********************/
+/* Entry Maintenance */
+/*********************/
+
+static void *
+deleteNodeCacheEntry(void *context, UA_NodeCacheEntry *entry) {
+    UA_NodeId_clear(&entry->nodeId);
+    UA_Array_delete(entry->attributeIds, entry->attributesSize,
+                    &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Array_delete(entry->attributes, entry->attributesSize,
+                    &UA_TYPES[UA_TYPES_DATAVALUE]);
+    for(size_t i = 0; i < entry->browsesSize; i++) {
+        UA_BrowseDescription_clear(&entry->browses[i].description);
+        UA_BrowseResult_clear(&entry->browses[i].result);
+    }
+    UA_free(entry->browses);
+    UA_free(entry);
+    return NULL;
+}
+
+void
+__Client_NodeCache_removeAll(UA_NodeCache *nc) {
+    ZIP_ITER(UA_NodeCacheTree, &nc->entries, deleteNodeCacheEntry, NULL);
+    ZIP_INIT(&nc->entries);
+    nc->entriesSize = 0;
+}
+
+void
+__Client_NodeCache_clear(UA_NodeCache *nc) {
+    __Client_NodeCache_removeAll(nc);
+    UA_Array_delete(nc->namespaces, nc->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
+    nc->namespaces = NULL;
+    nc->namespacesSize = 0;
+    nc->validated = false;
+}
+
+static void
+removeNode(UA_NodeCache *nc, const UA_NodeId *nodeId) {
+    UA_NodeCacheEntry *entry = ZIP_FIND(UA_NodeCacheTree, &nc->entries, nodeId);
+    if(!entry)
+        return;
+    ZIP_REMOVE(UA_NodeCacheTree, &nc->entries, entry);
+    nc->entriesSize--;
+    deleteNodeCacheEntry(NULL, entry);
+}
+
+/* Nodes on other servers are not cached */
+static void
+removeExpandedNode(UA_NodeCache *nc, const UA_ExpandedNodeId *nodeId) {
+    if(nodeId->serverIndex == 0 && nodeId->namespaceUri.length == 0)
+        removeNode(nc, &nodeId->nodeId);
+}
+
+static UA_NodeCacheEntry *
+getEntry(UA_Client *client, const UA_NodeId *nodeId) {
+    UA_NodeCache *nc = &client->nodeCache;
+    UA_NodeCacheEntry *entry = ZIP_FIND(UA_NodeCacheTree, &nc->entries, nodeId);
+    if(entry)
+        return entry;
+
+    /* Start over instead of tracking the least recently used entries */
+    if(nc->entriesSize >= client->config.nodeCacheSize)
+        __Client_NodeCache_removeAll(nc);
+
+    entry = (UA_NodeCacheEntry*)UA_calloc(1, sizeof(UA_NodeCacheEntry));
+    if(!entry)
+        return NULL;
+    if(UA_NodeId_copy(nodeId, &entry->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(entry);
+        return NULL;
+    }
+    ZIP_INSERT(UA_NodeCacheTree, &nc->entries, entry);
+    nc->entriesSize++;
+    return entry;
+}
+
+static const UA_DataValue *
+findAttribute(const UA_NodeCacheEntry *entry, UA_UInt32 attributeId) {
+    for(size_t i = 0; i < entry->attributesSize; i++) {
+        if(entry->attributeIds[i] == attributeId)
+            return &entry->attributes[i];
+    }
+    return NULL;
+}
+
+static const UA_BrowseResult *
+findBrowse(const UA_NodeCacheEntry *entry, const UA_BrowseDescription *bd) {
+    for(size_t i = 0; i < entry->browsesSize; i++) {
+        if(UA_equal(&entry->browses[i].description, bd,
+                    &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]))
+            return &entry->browses[i].result;
+    }
+    return NULL;
+}
+
+static void
+setAttribute(UA_NodeCacheEntry *entry, UA_UInt32 attributeId,
+             const UA_DataValue *value) {
+    UA_DataValue *dv = (UA_DataValue*)(uintptr_t)findAttribute(entry, attributeId);
+    if(dv) {
+        UA_DataValue copy;
+        if(UA_DataValue_copy(value, &copy) != UA_STATUSCODE_GOOD)
+            return;
+        UA_DataValue_clear(dv);
+        *dv = copy;
+        return;
+    }
+
+    size_t size = entry->attributesSize;
+    UA_StatusCode res =
+        UA_Array_appendCopy((void**)&entry->attributes, &size, value,
+                            &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(res != UA_STATUSCODE_GOOD)
+        return;
+    size = entry->attributesSize;
+    res = UA_Array_appendCopy((void**)&entry->attributeIds, &size, &attributeId,
+                              &UA_TYPES[UA_TYPES_UINT32]);
+    if(res != UA_STATUSCODE_GOOD) {
+        /* Keep both arrays at the same length */
+        UA_DataValue_clear(&entry->attributes[entry->attributesSize]);
+        return;
+    }
+    entry->attributesSize++;
+}
+
+static void
+setBrowse(UA_NodeCacheEntry *entry, const UA_BrowseDescription *bd,
+          const UA_BrowseResult *br) {
+    if(findBrowse(entry, bd))
+        return;
+    UA_NodeCacheBrowse *browses = (UA_NodeCacheBrowse*)
+        UA_realloc(entry->browses, (entry->browsesSize + 1) * sizeof(UA_NodeCacheBrowse));
+    if(!browses)
+        return;
+    entry->browses = browses;
+    UA_NodeCacheBrowse *b = &browses[entry->browsesSize];
+    UA_StatusCode res = UA_BrowseDescription_copy(bd, &b->description);
+    res |= UA_BrowseResult_copy(br, &b->result);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_BrowseDescription_clear(&b->description);
+        UA_BrowseResult_clear(&b->result);
+        return;
+    }
+    entry->browsesSize++;
+}
+
+/*******************/
+/* Service Results */
+/*******************/
+
+/* The Value attribute is dynamic. Except for the NamespaceArray that is used
+ * to validate the cache. */
+static UA_Boolean
+isCacheableRead(const UA_ReadValueId *rvid) {
+    if(rvid->indexRange.length > 0 || !UA_QualifiedName_isNull(&rvid->dataEncoding))
+        return false;
+    if(rvid->attributeId != UA_ATTRIBUTEID_VALUE)
+        return true;
+    return UA_NodeId_equal(&rvid->nodeId, &namespaceArrayId);
+}
+
+/* Only complete results for the entire address space */
+static UA_Boolean
+isCacheableBrowseRequest(const UA_BrowseRequest *req) {
+    return (req->requestedMaxReferencesPerNode == 0 &&
+            UA_NodeId_isNull(&req->view.viewId) &&
+            req->view.timestamp == 0 && req->view.viewVersion == 0);
+}
+
+static void
+initResponseHeader(UA_Client *client, const UA_RequestHeader *rh,
+                   UA_ResponseHeader *respHeader) {
+    UA_EventLoop *el = client->config.eventLoop;
+    respHeader->timestamp = el->dateTime_now(el);
+    respHeader->requestHandle = rh->requestHandle;
+}
+
+static UA_Boolean
+lookupRead(UA_Client *client, const UA_ReadRequest *req, UA_ReadResponse *resp) {
+    if(req->nodesToReadSize == 0)
+        return false;
+
+    /* All results must be cached */
+    UA_NodeCache *nc = &client->nodeCache;
+    for(size_t i = 0; i < req->nodesToReadSize; i++) {
+        const UA_ReadValueId *rvid = &req->nodesToRead[i];
+        if(!isCacheableRead(rvid))
+            return false;
+        UA_NodeCacheEntry *entry =
+            ZIP_FIND(UA_NodeCacheTree, &nc->entries, &rvid->nodeId);
+        if(!entry || !findAttribute(entry, rvid->attributeId))
+            return false;
+    }
+
+    resp->results = (UA_DataValue*)
+        UA_Array_new(req->nodesToReadSize, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!resp->results)
+        return false;
+    resp->resultsSize = req->nodesToReadSize;
+    for(size_t i = 0; i < req->nodesToReadSize; i++) {
+        const UA_ReadValueId *rvid = &req->nodesToRead[i];
+        UA_NodeCacheEntry *entry =
+            ZIP_FIND(UA_NodeCacheTree, &nc->entries, &rvid->nodeId);
+        if(UA_DataValue_copy(findAttribute(entry, rvid->attributeId),
+                             &resp->results[i]) != UA_STATUSCODE_GOOD) {
+            UA_ReadResponse_clear(resp);
+            return false;
+        }
+    }
+    initResponseHeader(client, &req->requestHeader, &resp->responseHeader);
+    return true;
+}
+
+static UA_Boolean
+lookupBrowse(UA_Client *client, const UA_BrowseRequest *req,
+             UA_BrowseResponse *resp) {
+    if(req->nodesToBrowseSize == 0 || !isCacheableBrowseRequest(req))
+        return false;
+
+    UA_NodeCache *nc = &client->nodeCache;
+    for(size_t i = 0; i < req->nodesToBrowseSize; i++) {
+        const UA_BrowseDescription *bd = &req->nodesToBrowse[i];
+        UA_NodeCacheEntry *entry =
+            ZIP_FIND(UA_NodeCacheTree, &nc->entries, &bd->nodeId);
+        if(!entry || !findBrowse(entry, bd))
+            return false;
+    }
+
+    resp->results = (UA_BrowseResult*)
+        UA_Array_new(req->nodesToBrowseSize, &UA_TYPES[UA_TYPES_BROWSERESULT]);
+    if(!resp->results)
+        return false;
+    resp->resultsSize = req->nodesToBrowseSize;
+    for(size_t i = 0; i < req->nodesToBrowseSize; i++) {
+        const UA_BrowseDescription *bd = &req->nodesToBrowse[i];
+        UA_NodeCacheEntry *entry =
+            ZIP_FIND(UA_NodeCacheTree, &nc->entries, &bd->nodeId);
+        if(UA_BrowseResult_copy(findBrowse(entry, bd),
+                                &resp->results[i]) != UA_STATUSCODE_GOOD) {
+            UA_BrowseResponse_clear(resp);
+            return false;
+        }
+    }
+    initResponseHeader(client, &req->requestHeader, &resp->responseHeader);
+    return true;
+}
+
+UA_Boolean
+__Client_NodeCache_lookup(UA_Client *client, const void *request,
+                          const UA_DataType *requestType, void *response) {
+    if(requestType == &UA_TYPES[UA_TYPES_READREQUEST]) {
+        UA_ReadResponse_init((UA_ReadResponse*)response);
+        return lookupRead(client, (const UA_ReadRequest*)request,
+                          (UA_ReadResponse*)response);
+    }
+    if(requestType == &UA_TYPES[UA_TYPES_BROWSEREQUEST]) {
+        UA_BrowseResponse_init((UA_BrowseResponse*)response);
+        return lookupBrowse(client, (const UA_BrowseRequest*)request,
+                            (UA_BrowseResponse*)response);
+    }
+    return false;
+}
+
+static void
+storeRead(UA_Client *client, const UA_ReadRequest *req,
+          const UA_ReadResponse *resp) {
+    if(resp->resultsSize != req->nodesToReadSize)
+        return;
+    for(size_t i = 0; i < req->nodesToReadSize; i++) {
+        const UA_ReadValueId *rvid = &req->nodesToRead[i];
+        const UA_DataValue *dv = &resp->results[i];
+        if(!isCacheableRead(rvid))
+            continue;
+        /* The node exists. Also remember attributes that are not defined for
+         * its NodeClass. */
+        if(dv->hasStatus && dv->status != UA_STATUSCODE_GOOD &&
+           dv->status != UA_STATUSCODE_BADATTRIBUTEIDINVALID)
+            continue;
+        UA_NodeCacheEntry *entry = getEntry(client, &rvid->nodeId);
+        if(entry)
+            setAttribute(entry, rvid->attributeId, dv);
+    }
+}
+
+static void
+storeBrowse(UA_Client *client, const UA_BrowseRequest *req,
+            const UA_BrowseResponse *resp) {
+    if(resp->resultsSize != req->nodesToBrowseSize || !isCacheableBrowseRequest(req))
+        return;
+    for(size_t i = 0; i < req->nodesToBrowseSize; i++) {
+        const UA_BrowseResult *br = &resp->results[i];
+        if(br->statusCode != UA_STATUSCODE_GOOD || br->continuationPoint.length > 0)
+            continue;
+        const UA_BrowseDescription *bd = &req->nodesToBrowse[i];
+        UA_NodeCacheEntry *entry = getEntry(client, &bd->nodeId);
+        if(entry)
+            setBrowse(entry, bd, br);
+    }
+}
+
+void
+__Client_NodeCache_store(UA_Client *client, const void *request,
+                         const UA_DataType *requestType, const void *response) {
+    if(client->config.nodeCacheSize == 0)
+        return;
+    if(requestType == &UA_TYPES[UA_TYPES_READREQUEST])
+        storeRead(client, (const UA_ReadRequest*)request,
+                  (const UA_ReadResponse*)response);
+    else if(requestType == &UA_TYPES[UA_TYPES_BROWSEREQUEST])
+        storeBrowse(client, (const UA_BrowseRequest*)request,
+                    (const UA_BrowseResponse*)response);
+}
+
+void
+__Client_NodeCache_invalidateRequest(UA_Client *client, const void *request,
+                                     const UA_DataType *requestType) {
+    UA_NodeCache *nc = &client->nodeCache;
+    if(nc->entriesSize == 0)
+        return;
+
+    if(requestType == &UA_TYPES[UA_TYPES_WRITEREQUEST]) {
+        const UA_WriteRequest *req = (const UA_WriteRequest*)request;
+        for(size_t i = 0; i < req->nodesToWriteSize; i++) {
+            const UA_WriteValue *wv = &req->nodesToWrite[i];
+            if(wv->attributeId != UA_ATTRIBUTEID_VALUE) {
+                removeNode(nc, &wv->nodeId);
+            } else if(UA_NodeId_equal(&wv->nodeId, &namespaceArrayId)) {
+                /* Compare the NamespaceArray before the next lookup */
+                removeNode(nc, &wv->nodeId);
+                nc->validated = false;
+            }
+        }
+    } else if(requestType == &UA_TYPES[UA_TYPES_ADDNODESREQUEST]) {
+        const UA_AddNodesRequest *req = (const UA_AddNodesRequest*)request;
+        for(size_t i = 0; i < req->nodesToAddSize; i++) {
+            removeExpandedNode(nc, &req->nodesToAdd[i].parentNodeId);
+            removeExpandedNode(nc, &req->nodesToAdd[i].typeDefinition);
+        }
+    } else if(requestType == &UA_TYPES[UA_TYPES_ADDREFERENCESREQUEST]) {
+        const UA_AddReferencesRequest *req = (const UA_AddReferencesRequest*)request;
+        for(size_t i = 0; i < req->referencesToAddSize; i++) {
+            removeNode(nc, &req->referencesToAdd[i].sourceNodeId);
+            removeExpandedNode(nc, &req->referencesToAdd[i].targetNodeId);
+        }
+    } else if(requestType == &UA_TYPES[UA_TYPES_DELETEREFERENCESREQUEST]) {
+        const UA_DeleteReferencesRequest *req =
+            (const UA_DeleteReferencesRequest*)request;
+        for(size_t i = 0; i < req->referencesToDeleteSize; i++) {
+            removeNode(nc, &req->referencesToDelete[i].sourceNodeId);
+            removeExpandedNode(nc, &req->referencesToDelete[i].targetNodeId);
+        }
+    } else if(requestType == &UA_TYPES[UA_TYPES_DELETENODESREQUEST]) {
+        /* The references of other nodes point to the deleted nodes */
+        __Client_NodeCache_removeAll(nc);
+    }
+}
+
+void
+__Client_NodeCache_validate(UA_Client *client, const UA_Variant *namespaceArray) {
+    UA_NodeCache *nc = &client->nodeCache;
+    UA_String *namespaces = (UA_String*)namespaceArray->data;
+    size_t namespacesSize = namespaceArray->arrayLength;
+    if(!UA_Variant_hasArrayType(namespaceArray, &UA_TYPES[UA_TYPES_STRING])) {
+        namespaces = NULL;
+        namespacesSize = 0;
+    }
+    nc->validated = true;
+
+    /* Unchanged */
+    if(namespacesSize == nc->namespacesSize) {
+        size_t i = 0;
+        for(; i < namespacesSize; i++) {
+            if(!UA_String_equal(&namespaces[i], &nc->namespaces[i]))
+                break;
+        }
+        if(i == namespacesSize)
+            return;
+    }
+
+    /* The namespace indices of the cached NodeIds are no longer valid */
+    UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                "The NamespaceArray of the server has changed. "
+                "Clearing the node cache.");
+    __Client_NodeCache_removeAll(nc);
+    UA_Array_delete(nc->namespaces, nc->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
+    nc->namespaces = NULL;
+    nc->namespacesSize = 0;
+    UA_StatusCode res = UA_Array_copy(namespaces, namespacesSize,
+                                      (void**)&nc->namespaces,
+                                      &UA_TYPES[UA_TYPES_STRING]);
+    if(res == UA_STATUSCODE_GOOD)
+        nc->namespacesSize = namespacesSize;
+    else
+        nc->validated = false;
+}
+
+/**************/
+/* Public API */
+/**************/
+
+void
+UA_Client_NodeCache_clear(UA_Client *client) {
+    UA_LOCK(&client->clientMutex);
+    __Client_NodeCache_removeAll(&client->nodeCache);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+void
+UA_Client_NodeCache_invalidate(UA_Client *client, const UA_NodeId nodeId) {
+    UA_LOCK(&client->clientMutex);
+    removeNode(&client->nodeCache, &nodeId);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* ModelChangeStructureDataType is not part of every generated type set. The
+ * encoding starts with the Affected and AffectedType NodeIds and the Verb. */
+#define UA_MODELCHANGEVERB_NODEDELETED 0x02
+
+static UA_Boolean
+processModelChangeStructure(UA_NodeCache *nc, const UA_ExtensionObject *eo) {
+    UA_NodeId affected;
+    UA_NodeId affectedType;
+    UA_Byte verb;
+    if(eo->encoding == UA_EXTENSIONOBJECT_ENCODED_BYTESTRING) {
+        if(eo->content.encoded.typeId.namespaceIndex != 0 ||
+           eo->content.encoded.typeId.identifierType != UA_NODEIDTYPE_NUMERIC ||
+           eo->content.encoded.typeId.identifier.numeric !=
+           UA_NS0ID_MODELCHANGESTRUCTUREDATATYPE_ENCODING_DEFAULTBINARY)
+            return false;
+        size_t offset = 0;
+        UA_NodeId_init(&affected);
+        UA_NodeId_init(&affectedType);
+        UA_StatusCode res =
+            UA_decodeBinaryInternal(&eo->content.encoded.body, &offset, &affected,
+                                    &UA_TYPES[UA_TYPES_NODEID], NULL);
+        res |= UA_decodeBinaryInternal(&eo->content.encoded.body, &offset,
+                                       &affectedType, &UA_TYPES[UA_TYPES_NODEID], NULL);
+        res |= UA_decodeBinaryInternal(&eo->content.encoded.body, &offset, &verb,
+                                       &UA_TYPES[UA_TYPES_BYTE], NULL);
+        if(res == UA_STATUSCODE_GOOD) {
+            if(verb & UA_MODELCHANGEVERB_NODEDELETED)
+                __Client_NodeCache_removeAll(nc);
+            else
+                removeNode(nc, &affected);
+        }
+        UA_NodeId_clear(&affected);
+        UA_NodeId_clear(&affectedType);
+        return (res == UA_STATUSCODE_GOOD);
+    }
+
+    if(eo->encoding != UA_EXTENSIONOBJECT_DECODED &&
+       eo->encoding != UA_EXTENSIONOBJECT_DECODED_NODELETE)
+        return false;
+    const UA_DataType *type = eo->content.decoded.type;
+    if(!type || type->typeId.namespaceIndex != 0 ||
+       type->typeId.identifierType != UA_NODEIDTYPE_NUMERIC ||
+       type->typeId.identifier.numeric != UA_NS0ID_MODELCHANGESTRUCTUREDATATYPE)
+        return false;
+    const UA_NodeId *nodeIds = (const UA_NodeId*)eo->content.decoded.data;
+    verb = *(const UA_Byte*)&nodeIds[2];
+    if(verb & UA_MODELCHANGEVERB_NODEDELETED)
+        __Client_NodeCache_removeAll(nc);
+    else
+        removeNode(nc, &nodeIds[0]);
+    return true;
+}
+
+void
+UA_Client_NodeCache_processModelChange(UA_Client *client,
+                                       const UA_Variant *changes) {
+    UA_LOCK(&client->clientMutex);
+    UA_NodeCache *nc = &client->nodeCache;
+    size_t changesSize = UA_Variant_isScalar(changes) ? 1 : changes->arrayLength;
+    if(!changes->data || changesSize == 0 ||
+       changes->type != &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]) {
+        __Client_NodeCache_removeAll(nc);
+        UA_UNLOCK(&client->clientMutex);
+        return;
+    }
+    const UA_ExtensionObject *eo = (const UA_ExtensionObject*)changes->data;
+    for(size_t i = 0; i < changesSize; i++) {
+        if(!processModelChangeStructure(nc, &eo[i])) {
+            __Client_NodeCache_removeAll(nc);
+            break;
+        }
+    }
+    UA_UNLOCK(&client->clientMutex);
+}
+
+/* The encoding is first run without a buffer to compute the length */
+typedef struct {
+    UA_Byte *pos;
+    const UA_Byte *end;
+    size_t length;
+    UA_StatusCode res;
+} NodeCacheEncodeCtx;
+
+static void
+encodeValue(NodeCacheEncodeCtx *ctx, const void *p, const UA_DataType *type) {
+    if(ctx->res != UA_STATUSCODE_GOOD)
+        return;
+    if(!ctx->pos) {
+        ctx->length += UA_calcSizeBinary(p, type);
+        return;
+    }
+    ctx->res = UA_encodeBinaryInternal(p, type, &ctx->pos, &ctx->end, NULL, NULL);
+}
+
+static void
+encodeSize(NodeCacheEncodeCtx *ctx, size_t size) {
+    UA_UInt32 s = (UA_UInt32)size;
+    encodeValue(ctx, &s, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void *
+encodeEntry(void *context, UA_NodeCacheEntry *entry) {
+    NodeCacheEncodeCtx *ctx = (NodeCacheEncodeCtx*)context;
+    encodeValue(ctx, &entry->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    encodeSize(ctx, entry->attributesSize);
+    for(size_t i = 0; i < entry->attributesSize; i++) {
+        encodeValue(ctx, &entry->attributeIds[i], &UA_TYPES[UA_TYPES_UINT32]);
+        encodeValue(ctx, &entry->attributes[i], &UA_TYPES[UA_TYPES_DATAVALUE]);
+    }
+    encodeSize(ctx, entry->browsesSize);
+    for(size_t i = 0; i < entry->browsesSize; i++) {
+        encodeValue(ctx, &entry->browses[i].description,
+                    &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+        encodeValue(ctx, &entry->browses[i].result, &UA_TYPES[UA_TYPES_BROWSERESULT]);
+    }
+    return NULL;
+}
+
+static void
+encodeNodeCache(NodeCacheEncodeCtx *ctx, UA_NodeCache *nc) {
+    encodeSize(ctx, UA_NODECACHE_VERSION);
+    encodeSize(ctx, nc->namespacesSize);
+    for(size_t i = 0; i < nc->namespacesSize; i++)
+        encodeValue(ctx, &nc->namespaces[i], &UA_TYPES[UA_TYPES_STRING]);
+    encodeSize(ctx, nc->entriesSize);
+    ZIP_ITER(UA_NodeCacheTree, &nc->entries, encodeEntry, ctx);
+}
+
+UA_StatusCode
+UA_Client_NodeCache_save(UA_Client *client, UA_ByteString *out) {
+    UA_LOCK(&client->clientMutex);
+    UA_NodeCache *nc = &client->nodeCache;
+    NodeCacheEncodeCtx ctx;
+    memset(&ctx, 0, sizeof(NodeCacheEncodeCtx));
+    encodeNodeCache(&ctx, nc);
+    UA_StatusCode res = UA_ByteString_allocBuffer(out, ctx.length);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&client->clientMutex);
+        return res;
+    }
+    ctx.pos = out->data;
+    ctx.end = out->data + out->length;
+    encodeNodeCache(&ctx, nc);
+    UA_UNLOCK(&client->clientMutex);
+    if(ctx.res != UA_STATUSCODE_GOOD)
+        UA_ByteString_clear(out);
+    return ctx.res;
+}
+
+static UA_StatusCode
+decodeSize(const UA_ByteString *data, size_t *offset, size_t *size) {
+    UA_UInt32 s = 0;
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(data, offset, &s, &UA_TYPES[UA_TYPES_UINT32], NULL);
+    /* Every element has at least one byte */
+    if(res == UA_STATUSCODE_GOOD && s > data->length - *offset)
+        res = UA_STATUSCODE_BADDECODINGERROR;
+    *size = s;
+    return res;
+}
+
+static UA_StatusCode
+decodeEntry(const UA_ByteString *data, size_t *offset, UA_NodeCacheEntry *entry) {
+    UA_StatusCode res =
+        UA_decodeBinaryInternal(data, offset, &entry->nodeId,
+                                &UA_TYPES[UA_TYPES_NODEID], NULL);
+    size_t size = 0;
+    res |= decodeSize(data, offset, &size);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(size > 0) {
+        entry->attributeIds = (UA_UInt32*)
+            UA_Array_new(size, &UA_TYPES[UA_TYPES_UINT32]);
+        entry->attributes = (UA_DataValue*)
+            UA_Array_new(size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if(!entry->attributeIds || !entry->attributes)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        entry->attributesSize = size;
+    }
+    for(size_t i = 0; i < entry->attributesSize; i++) {
+        res |= UA_decodeBinaryInternal(data, offset, &entry->attributeIds[i],
+                                       &UA_TYPES[UA_TYPES_UINT32], NULL);
+        res |= UA_decodeBinaryInternal(data, offset, &entry->attributes[i],
+                                       &UA_TYPES[UA_TYPES_DATAVALUE], NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    res = decodeSize(data, offset, &size);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(size > 0) {
+        entry->browses = (UA_NodeCacheBrowse*)
+            UA_calloc(size, sizeof(UA_NodeCacheBrowse));
+        if(!entry->browses)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        entry->browsesSize = size;
+    }
+    for(size_t i = 0; i < entry->browsesSize; i++) {
+        res |= UA_decodeBinaryInternal(data, offset, &entry->browses[i].description,
+                                       &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION], NULL);
+        res |= UA_decodeBinaryInternal(data, offset, &entry->browses[i].result,
+                                       &UA_TYPES[UA_TYPES_BROWSERESULT], NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+decodeNodeCache(const UA_ByteString *data, UA_NodeCache *nc) {
+    size_t offset = 0;
+    size_t version = 0;
+    UA_StatusCode res = decodeSize(data, &offset, &version);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(version != UA_NODECACHE_VERSION)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    size_t size = 0;
+    res = decodeSize(data, &offset, &size);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(size > 0) {
+        nc->namespaces = (UA_String*)UA_Array_new(size, &UA_TYPES[UA_TYPES_STRING]);
+        if(!nc->namespaces)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        nc->namespacesSize = size;
+    }
+    for(size_t i = 0; i < nc->namespacesSize; i++) {
+        res = UA_decodeBinaryInternal(data, &offset, &nc->namespaces[i],
+                                      &UA_TYPES[UA_TYPES_STRING], NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    res = decodeSize(data, &offset, &size);
+    for(size_t i = 0; i < size && res == UA_STATUSCODE_GOOD; i++) {
+        UA_NodeCacheEntry *entry = (UA_NodeCacheEntry*)
+            UA_calloc(1, sizeof(UA_NodeCacheEntry));
+        if(!entry)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        res = decodeEntry(data, &offset, entry);
+        if(res != UA_STATUSCODE_GOOD ||
+           ZIP_FIND(UA_NodeCacheTree, &nc->entries, &entry->nodeId)) {
+            deleteNodeCacheEntry(NULL, entry);
+            return UA_STATUSCODE_BADDECODINGERROR;
+        }
+        ZIP_INSERT(UA_NodeCacheTree, &nc->entries, entry);
+        nc->entriesSize++;
+    }
+    return res;
+}
+
+UA_StatusCode
+UA_Client_NodeCache_load(UA_Client *client, const UA_ByteString *data) {
+    UA_NodeCache nc;
+    memset(&nc, 0, sizeof(UA_NodeCache));
+    UA_StatusCode res = decodeNodeCache(data, &nc);
+    if(res != UA_STATUSCODE_GOOD) {
+        __Client_NodeCache_clear(&nc);
+        return res;
+    }
+
+    /* The NamespaceArray is compared before the first lookup */
+    UA_LOCK(&client->clientMutex);
+    __Client_NodeCache_clear(&client->nodeCache);
+    client->nodeCache = nc;
+    UA_UNLOCK(&client->clientMutex);
+    return UA_STATUSCODE_GOOD;
+}
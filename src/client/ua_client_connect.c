@@ -92,6 +92,238 @@ fallbackEndpointUrl(UA_Client *client) {
     }
 }
 
+/******************/
+/* Endpoint Cache */
+/******************/
+
+typedef struct UA_ClientEndpointCacheEntry {
+    LIST_ENTRY(UA_ClientEndpointCacheEntry) pointers;
+    UA_String endpointUrl; /* Key: EndpointUrl of the client config */
+    UA_DateTime created;   /* Monotonic time */
+    UA_String discoveryUrl;
+    UA_EndpointDescription endpoint;
+    UA_UserTokenPolicy userTokenPolicy;
+    UA_String authSecurityPolicyUri;
+} UA_ClientEndpointCacheEntry;
+
+struct UA_ClientEndpointCache {
+    UA_UInt32 maxAge;
+    size_t entriesSize;
+    LIST_HEAD(, UA_ClientEndpointCacheEntry) entries;
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock;
+#endif
+};
+
+UA_ClientEndpointCache *
+UA_ClientEndpointCache_new(UA_UInt32 maxAge) {
+    UA_ClientEndpointCache *cache = (UA_ClientEndpointCache*)
+        UA_calloc(1, sizeof(UA_ClientEndpointCache));
+    if(!cache)
+        return NULL;
+    cache->maxAge = maxAge;
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_INIT(&cache->lock);
+#endif
+    return cache;
+}
+
+static void
+endpointCacheEntry_delete(UA_ClientEndpointCache *cache,
+                          UA_ClientEndpointCacheEntry *entry) {
+    LIST_REMOVE(entry, pointers);
+    cache->entriesSize--;
+    UA_String_clear(&entry->endpointUrl);
+    UA_String_clear(&entry->discoveryUrl);
+    UA_EndpointDescription_clear(&entry->endpoint);
+    UA_UserTokenPolicy_clear(&entry->userTokenPolicy);
+    UA_String_clear(&entry->authSecurityPolicyUri);
+    UA_free(entry);
+}
+
+static UA_ClientEndpointCacheEntry *
+endpointCache_find(UA_ClientEndpointCache *cache, const UA_String *endpointUrl) {
+    UA_ClientEndpointCacheEntry *entry;
+    LIST_FOREACH(entry, &cache->entries, pointers) {
+        if(UA_String_equal(&entry->endpointUrl, endpointUrl))
+            return entry;
+    }
+    return NULL;
+}
+
+void
+UA_ClientEndpointCache_delete(UA_ClientEndpointCache *cache) {
+    if(!cache)
+        return;
+    UA_ClientEndpointCacheEntry *entry, *entry_tmp;
+    LIST_FOREACH_SAFE(entry, &cache->entries, pointers, entry_tmp)
+        endpointCacheEntry_delete(cache, entry);
+#if UA_MULTITHREADING >= 100
+    UA_LOCK_DESTROY(&cache->lock);
+#endif
+    UA_free(cache);
+}
+
+void
+UA_ClientEndpointCache_remove(UA_ClientEndpointCache *cache,
+                              const UA_String endpointUrl) {
+    UA_LOCK(&cache->lock);
+    UA_ClientEndpointCacheEntry *entry = endpointCache_find(cache, &endpointUrl);
+    if(entry)
+        endpointCacheEntry_delete(cache, entry);
+    UA_UNLOCK(&cache->lock);
+}
+
+size_t
+UA_ClientEndpointCache_getSize(UA_ClientEndpointCache *cache) {
+    UA_LOCK(&cache->lock);
+    size_t size = cache->entriesSize;
+    UA_UNLOCK(&cache->lock);
+    return size;
+}
+
+static UA_SecurityPolicy *
+getSecurityPolicy(UA_Client *client, UA_String policyUri);
+
+/* Can the cached Endpoint be used with the client configuration? Mirrors the
+ * filters applied in responseGetEndpoints. */
+static UA_Boolean
+cachedEndpointMatches(UA_Client *client, const UA_ClientEndpointCacheEntry *entry) {
+    const UA_ClientConfig *cc = &client->config;
+    const UA_EndpointDescription *ep = &entry->endpoint;
+    if(cc->securityMode > 0 && cc->securityMode != ep->securityMode)
+        return false;
+    if(cc->securityPolicyUri.length > 0 &&
+       !UA_String_equal(&cc->securityPolicyUri, &ep->securityPolicyUri))
+        return false;
+    if(cc->applicationUri.length > 0 &&
+       !UA_String_equal(&cc->applicationUri, &ep->server.applicationUri))
+        return false;
+    if(!getSecurityPolicy(client, ep->securityPolicyUri))
+        return false;
+
+    const UA_UserTokenPolicy *tp = &entry->userTokenPolicy;
+    if(tp->tokenType != UA_USERTOKENTYPE_ANONYMOUS &&
+       tp->securityPolicyUri.length > 0 &&
+       !getSecurityPolicy(client, tp->securityPolicyUri))
+        return false;
+    const UA_DataType *tokenType = cc->userIdentityToken.content.decoded.type;
+    switch(tp->tokenType) {
+    case UA_USERTOKENTYPE_ANONYMOUS:
+        return (!tokenType || tokenType == &UA_TYPES[UA_TYPES_ANONYMOUSIDENTITYTOKEN]);
+    case UA_USERTOKENTYPE_USERNAME:
+        return (tokenType == &UA_TYPES[UA_TYPES_USERNAMEIDENTITYTOKEN]);
+    case UA_USERTOKENTYPE_CERTIFICATE:
+        return (tokenType == &UA_TYPES[UA_TYPES_X509IDENTITYTOKEN]);
+    case UA_USERTOKENTYPE_ISSUEDTOKEN:
+        return (tokenType == &UA_TYPES[UA_TYPES_ISSUEDIDENTITYTOKEN]);
+    default:
+        return false;
+    }
+}
+
+/* Take over the discovery results from the cache before connecting */
+static void
+loadCachedEndpoint(UA_Client *client) {
+    /* A manually configured UserTokenPolicy is not overridden */
+    UA_UserTokenPolicy emptyPolicy;
+    UA_UserTokenPolicy_init(&emptyPolicy);
+    if(!UA_equal(&emptyPolicy, &client->config.userTokenPolicy,
+                 &UA_TYPES[UA_TYPES_USERTOKENPOLICY]))
+        return;
+
+    UA_ClientEndpointCache *cache = client->config.endpointCache;
+    UA_EventLoop *el = client->config.eventLoop;
+    UA_LOCK(&cache->lock);
+    UA_ClientEndpointCacheEntry *entry =
+        endpointCache_find(cache, &client->config.endpointUrl);
+    if(!entry)
+        goto out;
+
+    /* Expired */
+    if(cache->maxAge > 0 &&
+       el->dateTime_nowMonotonic(el) - entry->created >
+       (UA_DateTime)cache->maxAge * UA_DATETIME_MSEC) {
+        endpointCacheEntry_delete(cache, entry);
+        goto out;
+    }
+
+    if(!cachedEndpointMatches(client, entry))
+        goto out;
+
+    UA_ClientConfig *cc = &client->config;
+    UA_StatusCode res = UA_EndpointDescription_copy(&entry->endpoint, &cc->endpoint);
+    res |= UA_UserTokenPolicy_copy(&entry->userTokenPolicy, &cc->userTokenPolicy);
+    UA_String_clear(&client->discoveryUrl);
+    res |= UA_String_copy(&entry->discoveryUrl, &client->discoveryUrl);
+    if(UA_String_isEmpty(&cc->authSecurityPolicyUri))
+        res |= UA_String_copy(&entry->authSecurityPolicyUri, &cc->authSecurityPolicyUri);
+    UA_ApplicationDescription_clear(&client->serverDescription);
+    res |= UA_ApplicationDescription_copy(&entry->endpoint.server,
+                                          &client->serverDescription);
+    if(res != UA_STATUSCODE_GOOD) {
+        /* Fall back to the discovery */
+        UA_EndpointDescription_clear(&cc->endpoint);
+        UA_UserTokenPolicy_clear(&cc->userTokenPolicy);
+        UA_String_clear(&client->discoveryUrl);
+        goto out;
+    }
+
+    client->endpointFromCache = true;
+    UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                "Use the cached Endpoint for %.*s",
+                (int)cc->endpointUrl.length, cc->endpointUrl.data);
+
+ out:
+    UA_UNLOCK(&cache->lock);
+}
+
+/* Store the discovery results once they have led to an activated Session */
+static void
+storeCachedEndpoint(UA_Client *client) {
+    UA_ClientEndpointCache *cache = client->config.endpointCache;
+    UA_ClientConfig *cc = &client->config;
+    UA_EventLoop *el = cc->eventLoop;
+    UA_ClientEndpointCacheEntry *entry = (UA_ClientEndpointCacheEntry*)
+        UA_calloc(1, sizeof(UA_ClientEndpointCacheEntry));
+    if(!entry)
+        return;
+    UA_StatusCode res = UA_String_copy(&cc->endpointUrl, &entry->endpointUrl);
+    res |= UA_String_copy(&client->discoveryUrl, &entry->discoveryUrl);
+    res |= UA_EndpointDescription_copy(&cc->endpoint, &entry->endpoint);
+    res |= UA_UserTokenPolicy_copy(&cc->userTokenPolicy, &entry->userTokenPolicy);
+    res |= UA_String_copy(&cc->authSecurityPolicyUri, &entry->authSecurityPolicyUri);
+    entry->created = el->dateTime_nowMonotonic(el);
+
+    /* Replace an existing entry */
+    UA_LOCK(&cache->lock);
+    UA_ClientEndpointCacheEntry *old = endpointCache_find(cache, &cc->endpointUrl);
+    if(old)
+        endpointCacheEntry_delete(cache, old);
+    LIST_INSERT_HEAD(&cache->entries, entry, pointers);
+    cache->entriesSize++;
+    if(res != UA_STATUSCODE_GOOD)
+        endpointCacheEntry_delete(cache, entry);
+    UA_UNLOCK(&cache->lock);
+}
+
+/* The connection with the cached Endpoint failed. Remove the cache entry and
+ * restart with the discovery. */
+static void
+discardCachedEndpoint(UA_Client *client) {
+    client->endpointFromCache = false;
+    UA_ClientConfig *cc = &client->config;
+    UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                   "Connecting with the cached Endpoint for %.*s failed. "
+                   "Restart with the discovery.",
+                   (int)cc->endpointUrl.length, cc->endpointUrl.data);
+    UA_ClientEndpointCache_remove(cc->endpointCache, cc->endpointUrl);
+    UA_EndpointDescription_clear(&cc->endpoint);
+    UA_UserTokenPolicy_clear(&cc->userTokenPolicy);
+    UA_String_clear(&client->discoveryUrl);
+    client->connectStatus = UA_STATUSCODE_GOOD;
+}
+
 static UA_SecurityPolicy *
 getSecurityPolicy(UA_Client *client, UA_String policyUri) {
     for(size_t i = 0; i < client->config.securityPoliciesSize; i++) {
@@ -710,8 +942,13 @@ responseActivateSession(UA_Client *client, void *userdata, UA_UInt32 requestId,
 
     UA_ActivateSessionResponse *ar = (UA_ActivateSessionResponse *)response;
     if(ar->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
-        /* Activating the Session failed */
-        cleanupSession(client);
+        /* Activating the Session failed. If the Session no longer exists, the
+         * Subscriptions are kept for the transfer to a new Session. */
+        if(ar->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONIDINVALID ||
+           ar->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONCLOSED)
+            lostSession(client);
+        else
+            cleanupSession(client);
 
         /* Configuration option to not create a new Session */
         if(client->config.noNewSession) {
@@ -753,11 +990,19 @@ responseActivateSession(UA_Client *client, void *userdata, UA_UInt32 requestId,
     UA_ByteString_init(&ar->serverNonce);
 
     client->sessionState = UA_SESSIONSTATE_ACTIVATED;
+
+    /* The discovery results are confirmed */
+    if(client->config.endpointCache && !client->endpointFromCache)
+        storeCachedEndpoint(client);
+    client->endpointFromCache = false;
+
     notifyClientState(client);
 
     /* Immediately check if publish requests are outstanding - for example when
-     * an existing Session has been reattached / activated. */
+     * an existing Session has been reattached / activated. The Subscriptions
+     * of a lost Session are transferred first. */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
+    __Client_Subscriptions_transfer(client);
     __Client_Subscriptions_backgroundPublish(client);
 #endif
 
@@ -1595,6 +1840,10 @@ __Client_networkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
            client->connectStatus == UA_STATUSCODE_GOOD)
             client->connectStatus = fallbackEndpointUrl(client);
 
+        /* The server was reached but did not accept the cached Endpoint */
+        if(client->endpointFromCache && oldState != UA_SECURECHANNELSTATE_CONNECTING)
+            discardCachedEndpoint(client);
+
         /* Try to reconnect */
         goto continue_connect;
     }
@@ -1642,6 +1891,10 @@ __Client_networkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         return;
     }
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    __Client_Subscriptions_refillPublish(client);
+#endif
+
 continue_connect:
     /* Trigger the next action from our end to fully open up the connection */
     if(!isFullyConnected(client))
@@ -1673,6 +1926,11 @@ initConnect(UA_Client *client) {
     client->channel.certificateVerification = &client->config.certificateVerification;
     client->channel.processOPNHeader = verifyClientSecureChannelHeader;
 
+    /* Skip the discovery if the Endpoint is cached */
+    if(client->config.endpointCache && !client->config.noSession &&
+       endpointUnconfigured(client))
+        loadCachedEndpoint(client);
+
     /* Initialize the SecurityPolicy */
     client->connectStatus = initSecurityPolicy(client);
     if(client->connectStatus != UA_STATUSCODE_GOOD)
@@ -2169,14 +2427,17 @@ sendCloseSession(UA_Client *client) {
     client->sessionState = UA_SESSIONSTATE_CLOSING;
 }
 
-void
-cleanupSession(UA_Client *client) {
+static void
+cleanupSessionInternal(UA_Client *client, UA_Boolean keepSubscriptions) {
     UA_NodeId_clear(&client->authenticationToken);
     client->requestHandle = 0;
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* We need to clean up the subscriptions */
-    __Client_Subscriptions_clean(client);
+    if(keepSubscriptions)
+        __Client_Subscriptions_detach(client);
+    else
+        __Client_Subscriptions_clean(client);
 #endif
 
     /* Delete outstanding async services */
@@ -2186,14 +2447,31 @@ cleanupSession(UA_Client *client) {
     client->currentlyOutStandingPublishRequests = 0;
 #endif
 
+    /* The server may have changed until the next Session */
+    client->nodeCache.validated = false;
+
     client->sessionState = UA_SESSIONSTATE_CLOSED;
 }
 
+void
+cleanupSession(UA_Client *client) {
+    cleanupSessionInternal(client, false);
+}
+
+void
+lostSession(UA_Client *client) {
+    cleanupSessionInternal(client, !client->config.noNewSession &&
+                           !client->config.noSubscriptionTransfer);
+}
+
 static void
 disconnectSecureChannel(UA_Client *client, UA_Boolean sync) {
     /* Clean the DiscoveryUrl when the connection is explicitly closed */
     UA_String_clear(&client->discoveryUrl);
 
+    /* Closing explicitly does not invalidate the cached Endpoint */
+    client->endpointFromCache = false;
+
     /* Close the SecureChannel */
     closeSecureChannel(client);
 
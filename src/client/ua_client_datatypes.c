@@ -0,0 +1,705 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_client_internal.h"
+
+/* Limit the depth of the dependencies between the loaded types */
+#define UA_LOADDATATYPES_MAXROUNDS 16
+
+/**********/
+/* Layout */
+/**********/
+
+/* The alignment of a type is the offset after a single byte in a struct. This
+ * corresponds to the layout the compiler uses for the generated types. */
+typedef struct { UA_Byte c; UA_Int16 x; } AlignInt16;
+typedef struct { UA_Byte c; UA_Int32 x; } AlignInt32;
+typedef struct { UA_Byte c; UA_Int64 x; } AlignInt64;
+typedef struct { UA_Byte c; UA_Double x; } AlignDouble;
+typedef struct { UA_Byte c; void *x; } AlignPtr;
+typedef struct { UA_Byte c; size_t x; } AlignSize;
+
+#define UA_ALIGNMENT(T) offsetof(T, x)
+#define UA_MAXALIGN(a, b) (((a) > (b)) ? (a) : (b))
+
+static size_t
+typeAlignment(const UA_DataType *type, size_t depth);
+
+/* Arrays are stored as the size_t length followed by the pointer. Optional
+ * scalars are stored as a pointer. */
+static size_t
+memberAlignment(const UA_DataTypeMember *m, size_t depth) {
+    if(m->isArray)
+        return UA_MAXALIGN(UA_ALIGNMENT(AlignSize), UA_ALIGNMENT(AlignPtr));
+    if(m->isOptional)
+        return UA_ALIGNMENT(AlignPtr);
+    return typeAlignment(m->memberType, depth + 1);
+}
+
+static size_t
+typeAlignment(const UA_DataType *type, size_t depth) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:
+    case UA_DATATYPEKIND_SBYTE:
+    case UA_DATATYPEKIND_BYTE:
+        return 1;
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+        return UA_ALIGNMENT(AlignInt16);
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_FLOAT:
+    case UA_DATATYPEKIND_STATUSCODE:
+    case UA_DATATYPEKIND_ENUM:
+    case UA_DATATYPEKIND_GUID:
+        return UA_ALIGNMENT(AlignInt32);
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_DATETIME:
+        return UA_ALIGNMENT(AlignInt64);
+    case UA_DATATYPEKIND_DOUBLE:
+        return UA_ALIGNMENT(AlignDouble);
+    case UA_DATATYPEKIND_DATAVALUE:
+        return UA_MAXALIGN(UA_ALIGNMENT(AlignPtr), UA_ALIGNMENT(AlignInt64));
+    case UA_DATATYPEKIND_STRUCTURE:
+    case UA_DATATYPEKIND_OPTSTRUCT:
+    case UA_DATATYPEKIND_UNION: {
+        size_t align = (type->typeKind == UA_DATATYPEKIND_UNION) ?
+            UA_ALIGNMENT(AlignInt32) : 1; /* The switchfield */
+        if(depth > UA_LOADDATATYPES_MAXROUNDS)
+            return UA_MAXALIGN(align, UA_ALIGNMENT(AlignPtr));
+        for(size_t i = 0; i < type->membersSize; i++) {
+            size_t ma = memberAlignment(&type->members[i], depth);
+            align = UA_MAXALIGN(align, ma);
+        }
+        return align;
+    }
+    default:
+        /* Strings, NodeIds, Variants, ... contain a pointer */
+        return UA_MAXALIGN(UA_ALIGNMENT(AlignPtr), UA_ALIGNMENT(AlignSize));
+    }
+}
+
+static size_t
+memberSize(const UA_DataTypeMember *m) {
+    if(m->isArray)
+        return sizeof(size_t) + sizeof(void*);
+    if(m->isOptional)
+        return sizeof(void*);
+    return m->memberType->memSize;
+}
+
+static size_t
+alignOffset(size_t offset, size_t align) {
+    return (offset + align - 1) / align * align;
+}
+
+/* Set the padding of the members, the memSize and pointerFree */
+static UA_StatusCode
+computeLayout(UA_DataType *type) {
+    size_t offset = 0;
+    size_t align = 1;
+    UA_Boolean pointerFree = true;
+
+    if(type->typeKind == UA_DATATYPEKIND_UNION) {
+        /* The members overlap after the switchfield */
+        align = UA_ALIGNMENT(AlignInt32);
+        for(size_t i = 0; i < type->membersSize; i++) {
+            size_t ma = memberAlignment(&type->members[i], 0);
+            align = UA_MAXALIGN(align, ma);
+        }
+        size_t unionStart = alignOffset(sizeof(UA_UInt32), align);
+        offset = unionStart;
+        for(size_t i = 0; i < type->membersSize; i++) {
+            UA_DataTypeMember *m = &type->members[i];
+            if(unionStart > 63)
+                return UA_STATUSCODE_BADNOTSUPPORTED;
+            m->padding = (UA_Byte)unionStart;
+            size_t end = unionStart + memberSize(m);
+            offset = UA_MAXALIGN(offset, end);
+            if(m->isArray || !m->memberType->pointerFree)
+                pointerFree = false;
+        }
+    } else {
+        for(size_t i = 0; i < type->membersSize; i++) {
+            UA_DataTypeMember *m = &type->members[i];
+            size_t ma = memberAlignment(m, 0);
+            size_t start = alignOffset(offset, ma);
+            if(start - offset > 63)
+                return UA_STATUSCODE_BADNOTSUPPORTED;
+            m->padding = (UA_Byte)(start - offset);
+            offset = start + memberSize(m);
+            align = UA_MAXALIGN(align, ma);
+            if(m->isArray || m->isOptional || !m->memberType->pointerFree)
+                pointerFree = false;
+        }
+    }
+
+    offset = alignOffset(offset, align);
+    if(offset == 0 || offset > 0xFFFF)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    type->memSize = (UA_UInt16)offset;
+    type->pointerFree = pointerFree;
+    type->overlayable = false;
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********/
+/* Loading */
+/***********/
+
+typedef enum {
+    LOADENTRY_PENDING,
+    LOADENTRY_STRUCTURE,
+    LOADENTRY_ENUM,
+    LOADENTRY_ALIAS /* Simple subtype of another type */
+} LoadEntryKind;
+
+typedef struct {
+    LoadEntryKind kind;
+    UA_NodeId typeId;
+    UA_QualifiedName browseName;
+    UA_StructureDefinition definition; /* For structures */
+    UA_NodeId superTypeId;             /* For aliases */
+    size_t typeIndex;                  /* Position in the generated array */
+    UA_Byte layout;                    /* 0: open, 1: ongoing, 2: done */
+} LoadEntry;
+
+typedef struct {
+    UA_Client *client;
+    size_t entriesSize;
+    LoadEntry *entries;
+    size_t typesSize;
+    UA_DataType *types;
+} LoadCtx;
+
+/* Enumerations without an EnumDefinition are encoded as Int32 */
+static const UA_DataType *
+findKnownType(LoadCtx *ctx, const UA_NodeId *typeId) {
+    const UA_NodeId enumeration = UA_NODEID_NUMERIC(0, UA_NS0ID_ENUMERATION);
+    if(UA_NodeId_equal(typeId, &enumeration))
+        return &UA_TYPES[UA_TYPES_INT32];
+    return UA_findDataTypeWithCustom(typeId, ctx->client->config.customDataTypes);
+}
+
+static LoadEntry *
+findEntry(LoadCtx *ctx, const UA_NodeId *typeId) {
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        if(UA_NodeId_equal(&ctx->entries[i].typeId, typeId))
+            return &ctx->entries[i];
+    }
+    return NULL;
+}
+
+/* Add the type to the loading if it is not yet known */
+static UA_StatusCode
+requireType(LoadCtx *ctx, const UA_NodeId *typeId) {
+    if(findKnownType(ctx, typeId) || findEntry(ctx, typeId))
+        return UA_STATUSCODE_GOOD;
+    LoadEntry *entries = (LoadEntry*)
+        UA_realloc(ctx->entries, (ctx->entriesSize + 1) * sizeof(LoadEntry));
+    if(!entries)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx->entries = entries;
+    LoadEntry *e = &entries[ctx->entriesSize];
+    memset(e, 0, sizeof(LoadEntry));
+    UA_StatusCode res = UA_NodeId_copy(typeId, &e->typeId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    ctx->entriesSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+LoadCtx_clear(LoadCtx *ctx) {
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        UA_NodeId_clear(&e->typeId);
+        UA_QualifiedName_clear(&e->browseName);
+        UA_StructureDefinition_clear(&e->definition);
+        UA_NodeId_clear(&e->superTypeId);
+    }
+    UA_free(ctx->entries);
+    ctx->entries = NULL;
+    ctx->entriesSize = 0;
+}
+
+/* Browse the references of the nodes. Continuation points are not followed,
+ * the number of subtypes and encodings per node is small. */
+static UA_StatusCode
+browseReferences(UA_Client *client, size_t nodesSize, const UA_NodeId **nodes,
+                 UA_UInt32 referenceTypeId, UA_BrowseDirection direction,
+                 UA_BrowseResponse *response) {
+    UA_BrowseDescription *bd = (UA_BrowseDescription*)
+        UA_calloc(nodesSize, sizeof(UA_BrowseDescription));
+    if(!bd)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < nodesSize; i++) {
+        bd[i].nodeId = *nodes[i];
+        bd[i].referenceTypeId = UA_NODEID_NUMERIC(0, referenceTypeId);
+        bd[i].browseDirection = direction;
+        bd[i].resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    }
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.nodesToBrowse = bd;
+    request.nodesToBrowseSize = nodesSize;
+    __Client_Service(client, &request, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                     response, &UA_TYPES[UA_TYPES_BROWSERESPONSE]);
+    UA_free(bd);
+    UA_StatusCode res = response->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && response->resultsSize != nodesSize)
+        res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    return res;
+}
+
+/* Collect all custom subtypes of Structure and Enumeration */
+static UA_StatusCode
+collectCustomTypes(LoadCtx *ctx) {
+    UA_NodeId roots[2] = {UA_NODEID_NUMERIC(0, UA_NS0ID_STRUCTURE),
+                          UA_NODEID_NUMERIC(0, UA_NS0ID_ENUMERATION)};
+    size_t frontierSize = 2;
+    UA_NodeId *frontier = NULL;
+    UA_StatusCode res = UA_Array_copy(roots, 2, (void**)&frontier,
+                                      &UA_TYPES[UA_TYPES_NODEID]);
+    for(size_t round = 0; res == UA_STATUSCODE_GOOD && frontierSize > 0 &&
+            round < UA_LOADDATATYPES_MAXROUNDS; round++) {
+        const UA_NodeId **nodes = (const UA_NodeId**)
+            UA_malloc(frontierSize * sizeof(UA_NodeId*));
+        if(!nodes) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        for(size_t i = 0; i < frontierSize; i++)
+            nodes[i] = &frontier[i];
+        UA_BrowseResponse resp;
+        res = browseReferences(ctx->client, frontierSize, nodes, UA_NS0ID_HASSUBTYPE,
+                               UA_BROWSEDIRECTION_FORWARD, &resp);
+        UA_free(nodes);
+        UA_Array_delete(frontier, frontierSize, &UA_TYPES[UA_TYPES_NODEID]);
+        frontier = NULL;
+        frontierSize = 0;
+
+        /* The subtypes are the next frontier */
+        for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < resp.resultsSize; i++) {
+            const UA_BrowseResult *br = &resp.results[i];
+            for(size_t j = 0; j < br->referencesSize; j++) {
+                const UA_NodeId *subtype = &br->references[j].nodeId.nodeId;
+                if(subtype->namespaceIndex != 0) {
+                    res = requireType(ctx, subtype);
+                    if(res != UA_STATUSCODE_GOOD)
+                        break;
+                }
+                res = UA_Array_appendCopy((void**)&frontier, &frontierSize, subtype,
+                                          &UA_TYPES[UA_TYPES_NODEID]);
+                if(res != UA_STATUSCODE_GOOD)
+                    break;
+            }
+        }
+        UA_BrowseResponse_clear(&resp);
+    }
+    UA_Array_delete(frontier, frontierSize, &UA_TYPES[UA_TYPES_NODEID]);
+    return res;
+}
+
+/* Read the definition of the pending entries. The types of the structure
+ * fields are added as pending entries for the next round. */
+static UA_StatusCode
+readDefinitions(LoadCtx *ctx, UA_Boolean *done) {
+    size_t pending = 0;
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        if(ctx->entries[i].kind == LOADENTRY_PENDING)
+            pending++;
+    }
+    *done = (pending == 0);
+    if(pending == 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* Remember the positions. New entries are appended while processing. */
+    size_t *positions = (size_t*)UA_malloc(pending * sizeof(size_t));
+    UA_ReadValueId *rvids = (UA_ReadValueId*)
+        UA_calloc(pending * 2, sizeof(UA_ReadValueId));
+    if(!positions || !rvids) {
+        UA_free(positions);
+        UA_free(rvids);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0, p = 0; i < ctx->entriesSize; i++) {
+        if(ctx->entries[i].kind != LOADENTRY_PENDING)
+            continue;
+        positions[p] = i;
+        rvids[p * 2].nodeId = ctx->entries[i].typeId;
+        rvids[p * 2].attributeId = UA_ATTRIBUTEID_DATATYPEDEFINITION;
+        rvids[p * 2 + 1].nodeId = ctx->entries[i].typeId;
+        rvids[p * 2 + 1].attributeId = UA_ATTRIBUTEID_BROWSENAME;
+        p++;
+    }
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_NEITHER;
+    request.nodesToRead = rvids;
+    request.nodesToReadSize = pending * 2;
+    UA_ReadResponse resp;
+    __Client_Service(ctx->client, &request, &UA_TYPES[UA_TYPES_READREQUEST],
+                     &resp, &UA_TYPES[UA_TYPES_READRESPONSE]);
+    UA_free(rvids);
+    UA_StatusCode res = resp.responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && resp.resultsSize != pending * 2)
+        res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+
+    size_t aliases = 0;
+    for(size_t p = 0; res == UA_STATUSCODE_GOOD && p < pending; p++) {
+        LoadEntry *e = &ctx->entries[positions[p]];
+        UA_DataValue *def = &resp.results[p * 2];
+        UA_DataValue *name = &resp.results[p * 2 + 1];
+        if(!UA_Variant_hasScalarType(&name->value, &UA_TYPES[UA_TYPES_QUALIFIEDNAME])) {
+            res = UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+            break;
+        }
+        UA_QualifiedName_clear(&e->browseName);
+        e->browseName = *(UA_QualifiedName*)name->value.data;
+        UA_QualifiedName_init((UA_QualifiedName*)name->value.data);
+
+        if(UA_Variant_hasScalarType(&def->value, &UA_TYPES[UA_TYPES_ENUMDEFINITION])) {
+            e->kind = LOADENTRY_ENUM;
+            continue;
+        }
+        if(!UA_Variant_hasScalarType(&def->value,
+                                     &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION])) {
+            /* No definition. A simple subtype of a builtin type. */
+            e->kind = LOADENTRY_ALIAS;
+            aliases++;
+            continue;
+        }
+        e->kind = LOADENTRY_STRUCTURE;
+        e->definition = *(UA_StructureDefinition*)def->value.data;
+        UA_StructureDefinition_init((UA_StructureDefinition*)def->value.data);
+        size_t fieldsSize = e->definition.fieldsSize;
+        for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < fieldsSize; i++) {
+            /* e may be moved by the realloc */
+            UA_NodeId fieldType = ctx->entries[positions[p]].definition.fields[i].dataType;
+            res = requireType(ctx, &fieldType);
+        }
+    }
+    UA_ReadResponse_clear(&resp);
+
+    /* Look up the supertype of the simple types */
+    if(res == UA_STATUSCODE_GOOD && aliases > 0) {
+        const UA_NodeId **nodes = (const UA_NodeId**)
+            UA_malloc(aliases * sizeof(UA_NodeId*));
+        if(!nodes) {
+            UA_free(positions);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        size_t a = 0;
+        for(size_t p = 0; p < pending; p++) {
+            if(ctx->entries[positions[p]].kind == LOADENTRY_ALIAS)
+                nodes[a++] = &ctx->entries[positions[p]].typeId;
+        }
+        UA_BrowseResponse bresp;
+        res = browseReferences(ctx->client, aliases, nodes, UA_NS0ID_HASSUBTYPE,
+                               UA_BROWSEDIRECTION_INVERSE, &bresp);
+        UA_free(nodes);
+        a = 0;
+        for(size_t p = 0; res == UA_STATUSCODE_GOOD && p < pending; p++) {
+            if(ctx->entries[positions[p]].kind != LOADENTRY_ALIAS)
+                continue;
+            const UA_BrowseResult *br = &bresp.results[a++];
+            if(br->referencesSize == 0) {
+                res = UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+                break;
+            }
+            UA_NodeId superTypeId = br->references[0].nodeId.nodeId;
+            res = UA_NodeId_copy(&superTypeId, &ctx->entries[positions[p]].superTypeId);
+            if(res == UA_STATUSCODE_GOOD)
+                res = requireType(ctx, &superTypeId);
+        }
+        UA_BrowseResponse_clear(&bresp);
+    }
+
+    UA_free(positions);
+    return res;
+}
+
+/* Find the "Default Binary" encoding if it is missing in the definition */
+static UA_StatusCode
+readEncodingIds(LoadCtx *ctx) {
+    size_t missing = 0;
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind == LOADENTRY_STRUCTURE &&
+           UA_NodeId_isNull(&e->definition.defaultEncodingId))
+            missing++;
+    }
+    if(missing == 0)
+        return UA_STATUSCODE_GOOD;
+
+    const UA_NodeId **nodes = (const UA_NodeId**)UA_malloc(missing * sizeof(UA_NodeId*));
+    if(!nodes)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t m = 0;
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind == LOADENTRY_STRUCTURE &&
+           UA_NodeId_isNull(&e->definition.defaultEncodingId))
+            nodes[m++] = &e->typeId;
+    }
+    UA_BrowseResponse resp;
+    UA_StatusCode res = browseReferences(ctx->client, missing, nodes, UA_NS0ID_HASENCODING,
+                                         UA_BROWSEDIRECTION_FORWARD, &resp);
+    UA_free(nodes);
+
+    const UA_QualifiedName defaultBinary = UA_QUALIFIEDNAME(0, "Default Binary");
+    m = 0;
+    for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind != LOADENTRY_STRUCTURE ||
+           !UA_NodeId_isNull(&e->definition.defaultEncodingId))
+            continue;
+        const UA_BrowseResult *br = &resp.results[m++];
+        for(size_t j = 0; j < br->referencesSize; j++) {
+            if(UA_QualifiedName_equal(&br->references[j].browseName, &defaultBinary)) {
+                res = UA_NodeId_copy(&br->references[j].nodeId.nodeId,
+                                     &e->definition.defaultEncodingId);
+                break;
+            }
+        }
+        if(UA_NodeId_isNull(&e->definition.defaultEncodingId))
+            res = UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+    }
+    UA_BrowseResponse_clear(&resp);
+    return res;
+}
+
+static const UA_DataType *
+resolveType(LoadCtx *ctx, const UA_NodeId *typeId, size_t depth) {
+    const UA_DataType *type = findKnownType(ctx, typeId);
+    if(type)
+        return type;
+    LoadEntry *e = findEntry(ctx, typeId);
+    if(!e || depth > UA_LOADDATATYPES_MAXROUNDS)
+        return NULL;
+    if(e->kind == LOADENTRY_ALIAS)
+        return resolveType(ctx, &e->superTypeId, depth + 1);
+    if(e->kind == LOADENTRY_STRUCTURE || e->kind == LOADENTRY_ENUM)
+        return &ctx->types[e->typeIndex];
+    return NULL;
+}
+
+static char *
+copyName(const UA_String *name) {
+    char *s = (char*)UA_malloc(name->length + 1);
+    if(!s)
+        return NULL;
+    if(name->length > 0)
+        memcpy(s, name->data, name->length);
+    s[name->length] = 0;
+    return s;
+}
+
+static void
+clearGeneratedTypes(UA_DataType *types, size_t typesSize) {
+    for(size_t i = 0; i < typesSize; i++) {
+        UA_DataType *type = &types[i];
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        UA_free((void*)(uintptr_t)type->typeName);
+        for(size_t j = 0; type->members && j < type->membersSize; j++)
+            UA_free((void*)(uintptr_t)type->members[j].memberName);
+#endif
+        UA_free(type->members);
+        UA_NodeId_clear(&type->typeId);
+        UA_NodeId_clear(&type->binaryEncodingId);
+    }
+    UA_free(types);
+}
+
+/* Set up the type description without the layout */
+static UA_StatusCode
+initType(LoadCtx *ctx, LoadEntry *e) {
+    UA_DataType *type = &ctx->types[e->typeIndex];
+    UA_StatusCode res = UA_NodeId_copy(&e->typeId, &type->typeId);
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+    type->typeName = copyName(&e->browseName.name);
+    if(!type->typeName)
+        res |= UA_STATUSCODE_BADOUTOFMEMORY;
+#endif
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    if(e->kind == LOADENTRY_ENUM) {
+        type->memSize = sizeof(UA_Int32);
+        type->typeKind = UA_DATATYPEKIND_ENUM;
+        type->pointerFree = true;
+        type->overlayable = UA_BINARY_OVERLAYABLE_INTEGER;
+        e->layout = 2;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    const UA_StructureDefinition *def = &e->definition;
+    switch(def->structureType) {
+    case UA_STRUCTURETYPE_STRUCTURE:
+        type->typeKind = UA_DATATYPEKIND_STRUCTURE;
+        break;
+    case UA_STRUCTURETYPE_STRUCTUREWITHOPTIONALFIELDS:
+        type->typeKind = UA_DATATYPEKIND_OPTSTRUCT;
+        break;
+    case UA_STRUCTURETYPE_UNION:
+        type->typeKind = UA_DATATYPEKIND_UNION;
+        break;
+    default:
+        return UA_STATUSCODE_BADNOTSUPPORTED; /* Subtyped values */
+    }
+    if(def->fieldsSize > 255 ||
+       (def->fieldsSize > 32 && type->typeKind == UA_DATATYPEKIND_OPTSTRUCT))
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+
+    res = UA_NodeId_copy(&def->defaultEncodingId, &type->binaryEncodingId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(def->fieldsSize > 0) {
+        type->members = (UA_DataTypeMember*)
+            UA_calloc(def->fieldsSize, sizeof(UA_DataTypeMember));
+        if(!type->members)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    type->membersSize = (UA_Byte)def->fieldsSize;
+
+    for(size_t i = 0; i < def->fieldsSize; i++) {
+        const UA_StructureField *field = &def->fields[i];
+        UA_DataTypeMember *m = &type->members[i];
+#ifdef UA_ENABLE_TYPEDESCRIPTION
+        m->memberName = copyName(&field->name);
+        if(!m->memberName)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+#endif
+        m->memberType = resolveType(ctx, &field->dataType, 0);
+        if(!m->memberType)
+            return UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+        if(field->valueRank == UA_VALUERANK_ONE_DIMENSION)
+            m->isArray = true;
+        else if(field->valueRank != UA_VALUERANK_SCALAR)
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        m->isOptional = (type->typeKind == UA_DATATYPEKIND_OPTSTRUCT &&
+                         field->isOptional);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The size of scalar members has to be known first */
+static UA_StatusCode
+layoutType(LoadCtx *ctx, LoadEntry *e) {
+    if(e->layout == 2)
+        return UA_STATUSCODE_GOOD;
+    if(e->layout == 1)
+        return UA_STATUSCODE_BADNOTSUPPORTED; /* Contains itself as a scalar */
+    e->layout = 1;
+    UA_DataType *type = &ctx->types[e->typeIndex];
+    for(size_t i = 0; i < type->membersSize; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        if(m->isArray || m->isOptional)
+            continue;
+        if(m->memberType < ctx->types || m->memberType >= &ctx->types[ctx->typesSize])
+            continue; /* Not generated */
+        size_t pos = (size_t)(m->memberType - ctx->types);
+        for(size_t j = 0; j < ctx->entriesSize; j++) {
+            LoadEntry *dep = &ctx->entries[j];
+            if((dep->kind == LOADENTRY_STRUCTURE || dep->kind == LOADENTRY_ENUM) &&
+               dep->typeIndex == pos) {
+                UA_StatusCode res = layoutType(ctx, dep);
+                if(res != UA_STATUSCODE_GOOD)
+                    return res;
+                break;
+            }
+        }
+    }
+    e->layout = 2;
+    return computeLayout(type);
+}
+
+static UA_StatusCode
+generateTypes(LoadCtx *ctx) {
+    for(size_t i = 0; i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind == LOADENTRY_STRUCTURE || e->kind == LOADENTRY_ENUM)
+            e->typeIndex = ctx->typesSize++;
+    }
+    if(ctx->typesSize == 0)
+        return UA_STATUSCODE_GOOD;
+    ctx->types = (UA_DataType*)UA_calloc(ctx->typesSize, sizeof(UA_DataType));
+    if(!ctx->types)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind == LOADENTRY_STRUCTURE || e->kind == LOADENTRY_ENUM)
+            res = initType(ctx, e);
+    }
+    for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < ctx->entriesSize; i++) {
+        LoadEntry *e = &ctx->entries[i];
+        if(e->kind == LOADENTRY_STRUCTURE)
+            res = layoutType(ctx, e);
+    }
+    return res;
+}
+
+static UA_StatusCode
+loadDataTypes(LoadCtx *ctx, size_t typeIdsSize, const UA_NodeId *typeIds) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(typeIdsSize == 0)
+        res = collectCustomTypes(ctx);
+    for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < typeIdsSize; i++)
+        res = requireType(ctx, &typeIds[i]);
+
+    UA_Boolean done = false;
+    for(size_t round = 0; res == UA_STATUSCODE_GOOD && !done; round++) {
+        if(round >= UA_LOADDATATYPES_MAXROUNDS)
+            return UA_STATUSCODE_BADNOTSUPPORTED;
+        res = readDefinitions(ctx, &done);
+    }
+    if(res == UA_STATUSCODE_GOOD)
+        res = readEncodingIds(ctx);
+    if(res == UA_STATUSCODE_GOOD)
+        res = generateTypes(ctx);
+    return res;
+}
+
+UA_StatusCode
+UA_Client_loadDataTypes(UA_Client *client, size_t typeIdsSize,
+                        const UA_NodeId *typeIds) {
+    UA_LOCK(&client->clientMutex);
+    LoadCtx ctx;
+    memset(&ctx, 0, sizeof(LoadCtx));
+    ctx.client = client;
+    UA_StatusCode res = loadDataTypes(&ctx, typeIdsSize, typeIds);
+    if(res != UA_STATUSCODE_GOOD || ctx.typesSize == 0)
+        goto cleanup;
+
+    /* Prepend to the custom types. The member types point into the array. */
+    UA_DataTypeArray *array = (UA_DataTypeArray*)UA_malloc(sizeof(UA_DataTypeArray));
+    if(!array) {
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
+    UA_DataTypeArray init = {client->config.customDataTypes, ctx.typesSize,
+                             ctx.types, true};
+    memcpy(array, &init, sizeof(UA_DataTypeArray));
+    client->config.customDataTypes = array;
+    ctx.types = NULL;
+    UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                "Loaded %u data types from the server", (unsigned)ctx.typesSize);
+
+ cleanup:
+    if(ctx.types)
+        clearGeneratedTypes(ctx.types, ctx.typesSize);
+    LoadCtx_clear(&ctx);
+    UA_UNLOCK(&client->clientMutex);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Loading the data types failed with StatusCode %s",
+                       UA_StatusCode_name(res));
+    return res;
+}
@@ -624,6 +624,330 @@ UA_Client_HistoryRead_modified(UA_Client *client, const UA_NodeId *nodeId,
                                                   true, timestampsToReturn, callbackContext);
 }
 
+/* Batched HistoryRead over many nodes. Every request reads up to
+ * nodesPerRequest nodes and up to maxRequestsInFlight requests are pending at
+ * the same time. Nodes with a continuation point are served before the nodes
+ * that were not read yet. So the data of a node is complete before too many
+ * continuation points are opened in the server. */
+
+typedef struct UA_HistoryReadBatch UA_HistoryReadBatch;
+
+typedef struct {
+    UA_HistoryReadBatch *batch;
+    UA_UInt32 requestId;
+    UA_Boolean pending;
+    size_t indicesSize;
+    size_t *indices;
+} UA_HistoryReadBatchRequest;
+
+struct UA_HistoryReadBatch {
+    size_t nodesSize;
+    const UA_NodeId *nodeIds;
+    UA_ByteString *continuationPoints;
+    UA_StatusCode *results;
+
+    /* Ring buffer of the nodes with a continuation point. A node is contained
+     * at most once. */
+    size_t *queue;
+    size_t queueStart;
+    size_t queueSize;
+    size_t nextNode; /* Next node that was not read yet */
+
+    size_t nodesPerRequest;
+    size_t requestsSize;
+    UA_HistoryReadBatchRequest *requests;
+    size_t inFlight;
+    UA_HistoryReadValueId *items; /* Scratch space to encode a request */
+
+    UA_ExtensionObject *details;
+    UA_String indexRange;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_HistoricalIteratorCallback callback;
+    void *callbackContext;
+};
+
+static UA_StatusCode
+historyReadBatch_send(UA_Client *client, UA_HistoryReadBatch *batch,
+                      size_t *indices, size_t indicesSize, UA_Boolean release,
+                      UA_ClientAsyncServiceCallback callback, void *userdata,
+                      UA_UInt32 *requestId) {
+    for(size_t i = 0; i < indicesSize; i++) {
+        UA_HistoryReadValueId *item = &batch->items[i];
+        UA_HistoryReadValueId_init(item);
+        item->nodeId = batch->nodeIds[indices[i]];
+        item->indexRange = batch->indexRange;
+        item->continuationPoint = batch->continuationPoints[indices[i]];
+        item->dataEncoding = UA_QUALIFIEDNAME(0, "");
+    }
+
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    request.nodesToRead = batch->items;
+    request.nodesToReadSize = indicesSize;
+    request.timestampsToReturn = batch->timestampsToReturn;
+    request.releaseContinuationPoints = release;
+    request.historyReadDetails = *batch->details;
+
+    /* The request is encoded right away. The items only point into the batch. */
+    return __UA_Client_AsyncService(client, &request,
+                                    &UA_TYPES[UA_TYPES_HISTORYREADREQUEST],
+                                    callback, &UA_TYPES[UA_TYPES_HISTORYREADRESPONSE],
+                                    userdata, requestId);
+}
+
+/* Release the continuation points of the nodes in the server. The response is
+ * not awaited. */
+static void
+historyReadBatch_release(UA_Client *client, UA_HistoryReadBatch *batch,
+                         size_t *indices, size_t indicesSize) {
+    if(indicesSize == 0)
+        return;
+    UA_UInt32 requestId;
+    historyReadBatch_send(client, batch, indices, indicesSize, true,
+                          NULL, NULL, &requestId);
+    for(size_t i = 0; i < indicesSize; i++)
+        UA_ByteString_clear(&batch->continuationPoints[indices[i]]);
+}
+
+static void
+historyReadBatch_callback(UA_Client *client, void *userdata,
+                          UA_UInt32 requestId, void *r) {
+    UA_HistoryReadBatchRequest *req = (UA_HistoryReadBatchRequest*)userdata;
+    UA_HistoryReadBatch *batch = req->batch;
+    UA_HistoryReadResponse *response = (UA_HistoryReadResponse*)r;
+    req->pending = false;
+    batch->inFlight--;
+
+    UA_StatusCode res = response->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && response->resultsSize != req->indicesSize)
+        res = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    if(res != UA_STATUSCODE_GOOD) {
+        for(size_t i = 0; i < req->indicesSize; i++) {
+            batch->results[req->indices[i]] = res;
+            UA_ByteString_clear(&batch->continuationPoints[req->indices[i]]);
+        }
+        return;
+    }
+
+    /* The nodes whose continuation point is no longer needed are collected in
+     * the indices of the request. The request slot is reused afterwards. */
+    size_t releaseSize = 0;
+    for(size_t i = 0; i < req->indicesSize; i++) {
+        size_t node = req->indices[i];
+        UA_HistoryReadResult *hr = &response->results[i];
+        UA_ByteString_clear(&batch->continuationPoints[node]);
+        batch->results[node] = hr->statusCode;
+        if(!UA_StatusCode_isEqualTop(hr->statusCode, UA_STATUSCODE_GOOD))
+            continue;
+
+        /* Take the new continuation point */
+        batch->continuationPoints[node] = hr->continuationPoint;
+        UA_ByteString_init(&hr->continuationPoint);
+        UA_Boolean moreDataAvailable = (batch->continuationPoints[node].length > 0);
+
+        /* Client callback with possibility to request further values */
+        UA_Boolean fetchMore =
+            batch->callback(client, &batch->nodeIds[node], moreDataAvailable,
+                            &hr->historyData, batch->callbackContext);
+        if(!moreDataAvailable)
+            continue;
+        if(fetchMore) {
+            size_t pos = (batch->queueStart + batch->queueSize) % batch->nodesSize;
+            batch->queue[pos] = node;
+            batch->queueSize++;
+        } else {
+            req->indices[releaseSize++] = node;
+        }
+    }
+    historyReadBatch_release(client, batch, req->indices, releaseSize);
+}
+
+/* Send the next request with the nodes from the queue first */
+static void
+historyReadBatch_next(UA_Client *client, UA_HistoryReadBatch *batch,
+                      UA_HistoryReadBatchRequest *req) {
+    req->indicesSize = 0;
+    while(req->indicesSize < batch->nodesPerRequest && batch->queueSize > 0) {
+        req->indices[req->indicesSize++] = batch->queue[batch->queueStart];
+        batch->queueStart = (batch->queueStart + 1) % batch->nodesSize;
+        batch->queueSize--;
+    }
+    while(req->indicesSize < batch->nodesPerRequest &&
+          batch->nextNode < batch->nodesSize)
+        req->indices[req->indicesSize++] = batch->nextNode++;
+
+    UA_StatusCode res =
+        historyReadBatch_send(client, batch, req->indices, req->indicesSize, false,
+                              historyReadBatch_callback, req, &req->requestId);
+    if(res != UA_STATUSCODE_GOOD) {
+        for(size_t i = 0; i < req->indicesSize; i++) {
+            batch->results[req->indices[i]] = res;
+            UA_ByteString_clear(&batch->continuationPoints[req->indices[i]]);
+        }
+        return;
+    }
+    req->pending = true;
+    batch->inFlight++;
+}
+
+static UA_StatusCode
+__UA_Client_HistoryRead_batch(UA_Client *client, size_t nodesSize,
+                              const UA_NodeId *nodeIds,
+                              const UA_HistoricalIteratorCallback callback,
+                              UA_ExtensionObject *details, UA_String indexRange,
+                              UA_TimestampsToReturn timestampsToReturn,
+                              size_t nodesPerRequest, size_t maxRequestsInFlight,
+                              UA_StatusCode *results, void *callbackContext) {
+    if(nodesSize == 0)
+        return UA_STATUSCODE_GOOD;
+    if(!nodeIds || !callback)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    if(nodesPerRequest == 0 || nodesPerRequest > nodesSize)
+        nodesPerRequest = nodesSize;
+    if(maxRequestsInFlight == 0)
+        maxRequestsInFlight = 1;
+
+    UA_HistoryReadBatch batch;
+    memset(&batch, 0, sizeof(UA_HistoryReadBatch));
+    batch.nodesSize = nodesSize;
+    batch.nodeIds = nodeIds;
+    batch.nodesPerRequest = nodesPerRequest;
+    batch.requestsSize = maxRequestsInFlight;
+    batch.details = details;
+    batch.indexRange = indexRange;
+    batch.timestampsToReturn = timestampsToReturn;
+    batch.callback = callback;
+    batch.callbackContext = callbackContext;
+
+    UA_StatusCode retval = UA_STATUSCODE_BADOUTOFMEMORY;
+    batch.continuationPoints = (UA_ByteString*)
+        UA_calloc(nodesSize, sizeof(UA_ByteString));
+    batch.results = (UA_StatusCode*)UA_calloc(nodesSize, sizeof(UA_StatusCode));
+    batch.queue = (size_t*)UA_malloc(nodesSize * sizeof(size_t));
+    batch.items = (UA_HistoryReadValueId*)
+        UA_malloc(nodesPerRequest * sizeof(UA_HistoryReadValueId));
+    batch.requests = (UA_HistoryReadBatchRequest*)
+        UA_calloc(maxRequestsInFlight, sizeof(UA_HistoryReadBatchRequest));
+    if(!batch.continuationPoints || !batch.results || !batch.queue ||
+       !batch.items || !batch.requests)
+        goto cleanup;
+    for(size_t i = 0; i < maxRequestsInFlight; i++) {
+        batch.requests[i].batch = &batch;
+        batch.requests[i].indices = (size_t*)
+            UA_malloc(nodesPerRequest * sizeof(size_t));
+        if(!batch.requests[i].indices)
+            goto cleanup;
+    }
+
+    retval = UA_STATUSCODE_GOOD;
+    while(true) {
+        /* Fill up the free request slots */
+        for(size_t i = 0; i < maxRequestsInFlight; i++) {
+            if(batch.requests[i].pending)
+                continue;
+            if(batch.queueSize == 0 && batch.nextNode == nodesSize)
+                break;
+            historyReadBatch_next(client, &batch, &batch.requests[i]);
+        }
+        if(batch.inFlight == 0)
+            break;
+
+        /* Process the responses */
+        retval = UA_Client_run_iterate(client, 100);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
+    }
+
+    /* The connection broke down. Detach the pending requests from the batch on
+     * the stack. */
+    for(size_t i = 0; i < maxRequestsInFlight && batch.inFlight > 0; i++) {
+        UA_HistoryReadBatchRequest *req = &batch.requests[i];
+        if(!req->pending)
+            continue;
+        UA_Client_modifyAsyncCallback(client, req->requestId, NULL, NULL);
+        req->pending = false;
+        batch.inFlight--;
+        for(size_t j = 0; j < req->indicesSize; j++)
+            batch.results[req->indices[j]] = retval;
+    }
+
+    /* Release the remaining continuation points */
+    while(batch.queueSize > 0) {
+        size_t count = 0;
+        while(count < nodesPerRequest && batch.queueSize > 0) {
+            size_t node = batch.queue[batch.queueStart];
+            batch.queueStart = (batch.queueStart + 1) % nodesSize;
+            batch.queueSize--;
+            if(retval != UA_STATUSCODE_GOOD)
+                batch.results[node] = retval;
+            batch.requests[0].indices[count++] = node;
+        }
+        if(retval == UA_STATUSCODE_GOOD) {
+            historyReadBatch_release(client, &batch, batch.requests[0].indices, count);
+        } else {
+            for(size_t j = 0; j < count; j++)
+                UA_ByteString_clear(&batch.continuationPoints[batch.requests[0].indices[j]]);
+        }
+    }
+
+    /* Nodes that were never read */
+    for(size_t i = batch.nextNode; i < nodesSize; i++)
+        batch.results[i] = retval;
+
+    /* Return the first error of a node if the connection did not fail */
+    if(retval == UA_STATUSCODE_GOOD) {
+        for(size_t i = 0; i < nodesSize; i++) {
+            if(!UA_StatusCode_isEqualTop(batch.results[i], UA_STATUSCODE_GOOD)) {
+                retval = batch.results[i];
+                break;
+            }
+        }
+    }
+    if(results)
+        memcpy(results, batch.results, nodesSize * sizeof(UA_StatusCode));
+
+ cleanup:
+    if(batch.requests) {
+        for(size_t i = 0; i < maxRequestsInFlight; i++)
+            UA_free(batch.requests[i].indices);
+    }
+    UA_free(batch.requests);
+    UA_free(batch.items);
+    UA_free(batch.queue);
+    UA_free(batch.results);
+    UA_free(batch.continuationPoints);
+    return retval;
+}
+
+UA_StatusCode
+UA_Client_HistoryRead_rawBatch(UA_Client *client, size_t nodesSize,
+                               const UA_NodeId *nodeIds,
+                               const UA_HistoricalIteratorCallback callback,
+                               UA_DateTime startTime, UA_DateTime endTime,
+                               UA_String indexRange, UA_Boolean returnBounds,
+                               UA_UInt32 numValuesPerNode,
+                               UA_TimestampsToReturn timestampsToReturn,
+                               size_t nodesPerRequest, size_t maxRequestsInFlight,
+                               UA_StatusCode *results, void *callbackContext) {
+    UA_ReadRawModifiedDetails details;
+    UA_ReadRawModifiedDetails_init(&details);
+    details.returnBounds = returnBounds;
+    details.numValuesPerNode = numValuesPerNode;
+    details.startTime = startTime;
+    details.endTime = endTime;
+
+    UA_ExtensionObject detailsExtensionObject;
+    UA_ExtensionObject_init(&detailsExtensionObject);
+    detailsExtensionObject.content.decoded.type = &UA_TYPES[UA_TYPES_READRAWMODIFIEDDETAILS];
+    detailsExtensionObject.content.decoded.data = &details;
+    detailsExtensionObject.encoding = UA_EXTENSIONOBJECT_DECODED;
+
+    return __UA_Client_HistoryRead_batch(client, nodesSize, nodeIds, callback,
+                                         &detailsExtensionObject, indexRange,
+                                         timestampsToReturn, nodesPerRequest,
+                                         maxRequestsInFlight, results, callbackContext);
+}
+
 static UA_HistoryUpdateResponse
 __UA_Client_HistoryUpdate(UA_Client *client, void *details, size_t typeId) {
     UA_HistoryUpdateRequest request;
@@ -36,6 +36,7 @@ typedef struct UA_Client_NotificationsAckNumber {
 
 typedef struct UA_Client_MonitoredItem {
     ZIP_ENTRY(UA_Client_MonitoredItem) zipfields;
+    struct UA_Client_Subscription *sub;
     UA_UInt32 monitoredItemId;
     UA_UInt32 clientHandle;
     void *context;
@@ -50,6 +51,13 @@ typedef struct UA_Client_MonitoredItem {
 ZIP_HEAD(MonitorItemsTree, UA_Client_MonitoredItem);
 typedef struct MonitorItemsTree MonitorItemsTree;
 
+/* NotificationMessage that is held back until the missing messages before it
+ * were republished */
+typedef struct UA_Client_HeldMessage {
+    SIMPLEQ_ENTRY(UA_Client_HeldMessage) next;
+    UA_NotificationMessage msg;
+} UA_Client_HeldMessage;
+
 typedef struct UA_Client_Subscription {
     LIST_ENTRY(UA_Client_Subscription) listEntry;
     UA_UInt32 subscriptionId;
@@ -58,14 +66,32 @@ typedef struct UA_Client_Subscription {
     UA_UInt32 maxKeepAliveCount;
     UA_Client_StatusChangeNotificationCallback statusChangeCallback;
     UA_Client_DeleteSubscriptionCallback deleteCallback;
+    UA_Client_DataChangeBatchCallback dataChangeBatchCallback;
     UA_UInt32 sequenceNumber;
     UA_DateTime lastActivity;
     MonitorItemsTree monitoredItems;
+
+    /* Recovery of lost NotificationMessages with Republish. The sequence
+     * numbers from republishNext up to (excluding) republishEnd are missing.
+     * republishNext is zero when no recovery is ongoing. */
+    UA_UInt32 republishNext;
+    UA_UInt32 republishEnd;
+    SIMPLEQ_HEAD(, UA_Client_HeldMessage) heldMessages;
 } UA_Client_Subscription;
 
 void
 __Client_Subscriptions_clean(UA_Client *client);
 
+/* The Session was lost. Keep the Subscriptions and MonitoredItems for a
+ * transfer to the next Session. */
+void
+__Client_Subscriptions_detach(UA_Client *client);
+
+/* Send the TransferSubscriptionsRequest for the Subscriptions of the lost
+ * Session. Called when the new Session is activated. */
+void
+__Client_Subscriptions_transfer(UA_Client *client);
+
 /* Exposed for fuzzing */
 UA_StatusCode
 __Client_preparePublishRequest(UA_Client *client, UA_PublishRequest *request);
@@ -73,6 +99,11 @@ __Client_preparePublishRequest(UA_Client *client, UA_PublishRequest *request);
 void
 __Client_Subscriptions_backgroundPublish(UA_Client *client);
 
+/* Send the PublishRequests that were deferred while processing the responses
+ * from a received buffer */
+void
+__Client_Subscriptions_refillPublish(UA_Client *client);
+
 void
 __Client_Subscriptions_backgroundPublishInactivityCheck(UA_Client *client);
 
@@ -80,26 +111,116 @@ __Client_Subscriptions_backgroundPublishInactivityCheck(UA_Client *client);
 /* Client */
 /**********/
 
+/* The pending service calls are indexed by their requestId and by their
+ * deadline. So a response is matched and the timeouts are processed without
+ * scanning all pending calls. */
 typedef struct AsyncServiceCall {
-    LIST_ENTRY(AsyncServiceCall) pointers;
+    ZIP_ENTRY(AsyncServiceCall) idTreeEntry;
+    ZIP_ENTRY(AsyncServiceCall) deadlineTreeEntry;
     UA_UInt32 requestId;     /* Unique id */
     UA_UInt32 requestHandle; /* Potentially non-unique if manually defined in
                               * the request header*/
     UA_ClientAsyncServiceCallback callback;
     const UA_DataType *responseType;
     void *userdata;
-    UA_DateTime start;
-    UA_UInt32 timeout;
+    UA_DateTime deadline;    /* Monotonic time when the call times out */
     UA_Response *syncResponse; /* If non-null, then this is the synchronous
                                 * response to be filled. Set back to null to
                                 * indicate that the response was filled. */
+    UA_Arena *arena;           /* Decode the synchronous response into the
+                                * arena (optional) */
 } AsyncServiceCall;
 
-typedef LIST_HEAD(UA_AsyncServiceList, AsyncServiceCall) UA_AsyncServiceList;
+typedef ZIP_HEAD(UA_AsyncServiceIdTree, AsyncServiceCall) UA_AsyncServiceIdTree;
+typedef ZIP_HEAD(UA_AsyncServiceDeadlineTree, AsyncServiceCall)
+    UA_AsyncServiceDeadlineTree;
 
 void
 __Client_AsyncService_removeAll(UA_Client *client, UA_StatusCode statusCode);
 
+/* Single-item Read or Write operations that are collected for one combined
+ * request (see the asyncBatching client config) */
+typedef struct {
+    UA_ClientAsyncServiceCallback callback;
+    void *userdata;
+} AsyncBatchedCall;
+
+typedef struct {
+    size_t itemsSize;
+    size_t itemsCapacity;
+    void *items; /* ReadValueIds or WriteValues */
+    AsyncBatchedCall *calls;
+    UA_UInt32 timeoutHint; /* Smallest defined timeoutHint of the items */
+    UA_TimestampsToReturn timestampsToReturn; /* Only for Read */
+    UA_Double maxAge;                         /* Only for Read */
+} AsyncBatch;
+
+/**************/
+/* Node Cache */
+/**************/
+
+/* Browse result for one BrowseDescription */
+typedef struct {
+    UA_BrowseDescription description;
+    UA_BrowseResult result;
+} UA_NodeCacheBrowse;
+
+/* The cached attributes and browse results of a node */
+typedef struct UA_NodeCacheEntry {
+    ZIP_ENTRY(UA_NodeCacheEntry) zipfields;
+    UA_NodeId nodeId;
+    size_t attributesSize;
+    UA_UInt32 *attributeIds;
+    UA_DataValue *attributes;
+    size_t browsesSize;
+    UA_NodeCacheBrowse *browses;
+} UA_NodeCacheEntry;
+
+typedef ZIP_HEAD(UA_NodeCacheTree, UA_NodeCacheEntry) UA_NodeCacheTree;
+
+typedef struct {
+    UA_NodeCacheTree entries;
+    size_t entriesSize;
+
+    /* The NamespaceArray of the server for which the entries were cached */
+    size_t namespacesSize;
+    UA_String *namespaces;
+
+    /* The NamespaceArray was compared within the current Session */
+    UA_Boolean validated;
+} UA_NodeCache;
+
+/* Removes the entries, but keeps the NamespaceArray */
+void
+__Client_NodeCache_removeAll(UA_NodeCache *nc);
+
+void
+__Client_NodeCache_clear(UA_NodeCache *nc);
+
+/* Returns true if the Read or Browse request was answered from the cache */
+UA_Boolean
+__Client_NodeCache_lookup(UA_Client *client, const void *request,
+                          const UA_DataType *requestType, void *response);
+
+/* Store the static parts of a Read or Browse response */
+void
+__Client_NodeCache_store(UA_Client *client, const void *request,
+                         const UA_DataType *requestType, const void *response);
+
+/* Invalidate the entries of the nodes that are modified by the request */
+void
+__Client_NodeCache_invalidateRequest(UA_Client *client, const void *request,
+                                     const UA_DataType *requestType);
+
+/* Compare with the current NamespaceArray of the server. The entries are
+ * removed if it has changed. */
+void
+__Client_NodeCache_validate(UA_Client *client, const UA_Variant *namespaceArray);
+
+/* Returns NULL if there are no custom data types */
+const UA_DataTypeIndex *
+__Client_getTypeIndex(UA_Client *client);
+
 typedef struct CustomCallback {
     UA_UInt32 callbackId;
 
@@ -125,6 +246,8 @@ struct UA_Client {
 
     UA_Boolean findServersHandshake;   /* Ongoing FindServers */
     UA_Boolean endpointsHandshake;     /* Ongoing GetEndpoints */
+    UA_Boolean endpointFromCache;      /* Endpoint taken from the endpoint cache
+                                        * and not yet confirmed by a Session */
 
     /* The discoveryUrl can be different from the EndpointUrl in the client
      * configuration. The EndpointUrl is used to connect initially, then the
@@ -154,13 +277,50 @@ struct UA_Client {
     UA_Boolean pendingConnectivityCheck;
 
     /* Async Service */
-    UA_AsyncServiceList asyncServiceCalls;
+    UA_AsyncServiceIdTree asyncServiceCalls;
+    UA_AsyncServiceDeadlineTree asyncServiceDeadlines;
+    size_t asyncServiceCallsSize;
+
+    /* Coalescing of async operations */
+    AsyncBatch readBatch;
+    AsyncBatch writeBatch;
+    UA_UInt64 batchFlushCallbackId; /* Zero if no flush is scheduled */
+
+    /* Cached static attributes and browse results */
+    UA_NodeCache nodeCache;
+
+    /* Hash index over the builtin and custom data types. Rebuilt when the
+     * customDataTypes in the config have changed. */
+    UA_DataTypeIndex *typeIndex;
+    const UA_DataTypeArray *typeIndexTypes;
 
     /* Subscriptions */
     LIST_HEAD(, UA_Client_NotificationsAckNumber) pendingNotificationsAcks;
     LIST_HEAD(, UA_Client_Subscription) subscriptions;
     UA_UInt32 monitoredItemHandles;
+
+    /* The clientHandles are reused after a MonitoredItem was deleted. So the
+     * lookup table that is indexed by the clientHandle remains dense. */
+    UA_Client_MonitoredItem **monitoredItemsByHandle;
+    size_t monitoredItemsByHandleSize;
+    UA_UInt32 *freeHandles;
+    size_t freeHandlesSize;
+
+    /* Reused for every call of a DataChangeBatchCallback. Detached from the
+     * client while in use. */
+    UA_Client_DataChange *dataChanges;
+    size_t dataChangesSize;
+
+    /* The PublishResponses are decoded into the arena if enabled in the
+     * config. Its memory is kept between the responses. */
+    UA_Arena publishArena;
+    UA_Boolean publishArenaInUse;
     UA_UInt16 currentlyOutStandingPublishRequests;
+    UA_UInt16 publishWindow; /* Adaptive target of outstanding PublishRequests */
+    UA_Double publishRtt; /* Smoothed round-trip time in ms. Zero if unknown. */
+    UA_Boolean publishRefillPending; /* Refill after the received buffer */
+    UA_Boolean subscriptionsTransferPending; /* Transfer to the next Session */
+    UA_Boolean subscriptionsTransferSent;
 
     /* Internal locking for thread-safety. Methods starting with UA_Client_ that
      * are marked with UA_THREADSAFE take the lock. The lock is released before
@@ -193,7 +353,7 @@ __Client_renewSecureChannel(UA_Client *client);
 UA_StatusCode
 processServiceResponse(void *application, UA_SecureChannel *channel,
                        UA_MessageType messageType, UA_UInt32 requestId,
-                       UA_ByteString *message);
+                       UA_ByteString *message, size_t messageSegments);
 
 UA_StatusCode connectInternal(UA_Client *client, UA_Boolean async);
 UA_StatusCode connectSecureChannel(UA_Client *client, const char *endpointUrl);
@@ -207,6 +367,11 @@ void processOPNResponse(UA_Client *client, const UA_ByteString *message);
 void closeSecureChannel(UA_Client *client);
 void cleanupSession(UA_Client *client);
 
+/* The Session is no longer valid in the server. In difference to
+ * cleanupSession, the Subscriptions are kept for a transfer to the next
+ * Session (unless this is disabled in the config). */
+void lostSession(UA_Client *client);
+
 void
 Client_warnEndpointsResult(UA_Client *client,
                            const UA_GetEndpointsResponse *response,
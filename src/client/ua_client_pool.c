@@ -0,0 +1,270 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/client_pool.h>
+
+#include "ua_client_internal.h"
+
+struct UA_ClientPool {
+    /* Owns the plugins that are shared by the clients */
+    UA_ClientConfig config;
+
+    /* The clients log with a copy of the shared logger that is not cleared
+     * together with the client */
+    UA_Logger clientLogger;
+
+    size_t clientsSize;
+    UA_Client **clients;
+    size_t next; /* Position for round-robin */
+};
+
+/* Copy the configuration for a client. The members owned by the client are
+ * deep-copied. The plugins point to the pool configuration. */
+static UA_StatusCode
+copyClientConfig(UA_ClientPool *pool, UA_ClientConfig *dst) {
+    const UA_ClientConfig *src = &pool->config;
+    *dst = *src;
+    UA_ApplicationDescription_init(&dst->clientDescription);
+    UA_String_init(&dst->endpointUrl);
+    UA_ExtensionObject_init(&dst->userIdentityToken);
+    UA_String_init(&dst->securityPolicyUri);
+    UA_String_init(&dst->authSecurityPolicyUri);
+    UA_EndpointDescription_init(&dst->endpoint);
+    UA_UserTokenPolicy_init(&dst->userTokenPolicy);
+    UA_String_init(&dst->applicationUri);
+    UA_String_init(&dst->sessionName);
+    dst->sessionLocaleIds = NULL;
+    dst->sessionLocaleIdsSize = 0;
+
+    UA_StatusCode res =
+        UA_ApplicationDescription_copy(&src->clientDescription, &dst->clientDescription);
+    res |= UA_String_copy(&src->endpointUrl, &dst->endpointUrl);
+    res |= UA_ExtensionObject_copy(&src->userIdentityToken, &dst->userIdentityToken);
+    res |= UA_String_copy(&src->securityPolicyUri, &dst->securityPolicyUri);
+    res |= UA_String_copy(&src->authSecurityPolicyUri, &dst->authSecurityPolicyUri);
+    res |= UA_EndpointDescription_copy(&src->endpoint, &dst->endpoint);
+    res |= UA_UserTokenPolicy_copy(&src->userTokenPolicy, &dst->userTokenPolicy);
+    res |= UA_String_copy(&src->applicationUri, &dst->applicationUri);
+    res |= UA_String_copy(&src->sessionName, &dst->sessionName);
+    res |= UA_Array_copy(src->sessionLocaleIds, src->sessionLocaleIdsSize,
+                         (void **)&dst->sessionLocaleIds, &UA_TYPES[UA_TYPES_LOCALEID]);
+    if(res == UA_STATUSCODE_GOOD)
+        dst->sessionLocaleIdsSize = src->sessionLocaleIdsSize;
+
+    /* Shared plugins */
+    dst->externalEventLoop = true;
+    if(src->logging) {
+        dst->logging = &pool->clientLogger;
+        if(src->certificateVerification.logging == src->logging)
+            dst->certificateVerification.logging = &pool->clientLogger;
+    }
+    dst->certificateVerification.clear = NULL;
+    return res;
+}
+
+/* Detach the shared plugins before the client is deleted */
+static void
+deleteClient(UA_Client *client) {
+    UA_Client_disconnect(client);
+    UA_ClientConfig *cc = &client->config;
+    cc->securityPolicies = NULL;
+    cc->securityPoliciesSize = 0;
+    cc->authSecurityPolicies = NULL;
+    cc->authSecurityPoliciesSize = 0;
+    cc->customDataTypes = NULL;
+    UA_Client_delete(client);
+}
+
+UA_ClientPool *
+UA_ClientPool_new(const UA_ClientConfig *config, size_t clientsSize) {
+    if(!config || clientsSize == 0)
+        return NULL;
+    UA_ClientPool *pool = (UA_ClientPool*)UA_calloc(1, sizeof(UA_ClientPool));
+    if(!pool)
+        return NULL;
+    pool->config = *config;
+    if(config->logging) {
+        pool->clientLogger = *config->logging;
+        pool->clientLogger.clear = NULL;
+    }
+
+    pool->clients = (UA_Client**)UA_calloc(clientsSize, sizeof(UA_Client*));
+    if(!pool->clients)
+        goto error;
+    for(; pool->clientsSize < clientsSize; pool->clientsSize++) {
+        UA_ClientConfig cc;
+        UA_StatusCode res = copyClientConfig(pool, &cc);
+        UA_Client *client = NULL;
+        if(res == UA_STATUSCODE_GOOD)
+            client = UA_Client_newWithConfig(&cc);
+        if(!client) {
+            cc.securityPolicies = NULL;
+            cc.securityPoliciesSize = 0;
+            cc.authSecurityPolicies = NULL;
+            cc.authSecurityPoliciesSize = 0;
+            cc.customDataTypes = NULL;
+            UA_ClientConfig_clear(&cc);
+            goto error;
+        }
+        pool->clients[pool->clientsSize] = client;
+    }
+    return pool;
+
+ error:
+    /* The config remains with the caller */
+    for(size_t i = 0; i < pool->clientsSize; i++)
+        deleteClient(pool->clients[i]);
+    UA_free(pool->clients);
+    UA_free(pool);
+    return NULL;
+}
+
+void
+UA_ClientPool_delete(UA_ClientPool *pool) {
+    if(!pool)
+        return;
+    for(size_t i = 0; i < pool->clientsSize; i++)
+        deleteClient(pool->clients[i]);
+    UA_free(pool->clients);
+    UA_ClientConfig_clear(&pool->config);
+    UA_free(pool);
+}
+
+UA_StatusCode
+UA_ClientPool_setEventLoop(UA_ClientPool *pool, size_t index, UA_EventLoop *el) {
+    if(!el || index >= pool->clientsSize)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_Client *client = pool->clients[index];
+    UA_SecureChannelState channelState;
+    UA_Client_getState(client, &channelState, NULL, NULL);
+    if(channelState != UA_SECURECHANNELSTATE_CLOSED)
+        return UA_STATUSCODE_BADINVALIDSTATE;
+
+    /* Replace a previously set dedicated EventLoop */
+    UA_ClientConfig *cc = &client->config;
+    if(!cc->externalEventLoop && cc->eventLoop)
+        cc->eventLoop->free(cc->eventLoop);
+    cc->eventLoop = el;
+    cc->externalEventLoop = false;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ClientPool_connect(UA_ClientPool *pool, const char *endpointUrl) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        res = UA_Client_connectAsync(pool->clients[i], endpointUrl);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+    }
+
+    /* Process the handshakes of all clients at the same time */
+    while(true) {
+        UA_Boolean activated = true;
+        for(size_t i = 0; i < pool->clientsSize; i++) {
+            UA_SessionState sessionState;
+            UA_Client_getState(pool->clients[i], NULL, &sessionState, &res);
+            if(res != UA_STATUSCODE_GOOD)
+                goto error;
+            if(sessionState != UA_SESSIONSTATE_ACTIVATED)
+                activated = false;
+        }
+        if(activated)
+            return UA_STATUSCODE_GOOD;
+        res = UA_ClientPool_run_iterate(pool, 100);
+        if(res != UA_STATUSCODE_GOOD)
+            goto error;
+    }
+
+ error:
+    UA_ClientPool_disconnect(pool);
+    return res;
+}
+
+void
+UA_ClientPool_disconnect(UA_ClientPool *pool) {
+    for(size_t i = 0; i < pool->clientsSize; i++)
+        UA_Client_disconnect(pool->clients[i]);
+}
+
+size_t
+UA_ClientPool_getSize(const UA_ClientPool *pool) {
+    return pool->clientsSize;
+}
+
+UA_Client *
+UA_ClientPool_getClient(UA_ClientPool *pool, size_t index) {
+    if(index >= pool->clientsSize)
+        return NULL;
+    return pool->clients[index];
+}
+
+static UA_Boolean
+isActivated(UA_Client *client) {
+    UA_SessionState sessionState;
+    UA_Client_getState(client, NULL, &sessionState, NULL);
+    return (sessionState == UA_SESSIONSTATE_ACTIVATED);
+}
+
+/* Pending async calls including the collected operations not sent yet */
+static size_t
+getLoad(UA_Client *client) {
+    UA_LOCK(&client->clientMutex);
+    size_t load = client->asyncServiceCallsSize +
+        client->readBatch.itemsSize + client->writeBatch.itemsSize;
+    UA_UNLOCK(&client->clientMutex);
+    return load;
+}
+
+UA_Client *
+UA_ClientPool_next(UA_ClientPool *pool, UA_ClientPoolStrategy strategy) {
+    /* Start after the last selected client. So clients with the same load take
+     * turns. */
+    UA_Client *selected = NULL;
+    size_t selectedIndex = 0;
+    size_t selectedLoad = 0;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        size_t index = (pool->next + i) % pool->clientsSize;
+        UA_Client *client = pool->clients[index];
+        if(!isActivated(client))
+            continue;
+        if(strategy == UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) {
+            selected = client;
+            selectedIndex = index;
+            break;
+        }
+        size_t load = getLoad(client);
+        if(!selected || load < selectedLoad) {
+            selected = client;
+            selectedIndex = index;
+            selectedLoad = load;
+        }
+    }
+    if(selected)
+        pool->next = selectedIndex + 1;
+    return selected;
+}
+
+UA_StatusCode
+UA_ClientPool_run_iterate(UA_ClientPool *pool, UA_UInt32 timeout) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Boolean sharedDone = false;
+    for(size_t i = 0; i < pool->clientsSize; i++) {
+        UA_Client *client = pool->clients[i];
+        UA_StatusCode clientRes;
+        if(client->config.eventLoop != pool->config.eventLoop) {
+            clientRes = UA_Client_run_iterate(client, 0);
+        } else if(!sharedDone) {
+            /* Iterating the shared EventLoop processes all its clients */
+            clientRes = UA_Client_run_iterate(client, timeout);
+            sharedDone = true;
+        } else {
+            UA_Client_getState(client, NULL, NULL, &clientRes);
+        }
+        if(res == UA_STATUSCODE_GOOD)
+            res = clientRes;
+    }
+    return res;
+}
@@ -46,6 +46,63 @@ UA_ClientHandle_cmp(const void *a, const void *b) {
 ZIP_FUNCTIONS(MonitorItemsTree, UA_Client_MonitoredItem, zipfields,
               UA_Client_MonitoredItem, zipfields, UA_ClientHandle_cmp)
 
+/* Take a clientHandle of a deleted MonitoredItem or a new one */
+static UA_UInt32
+takeClientHandle(UA_Client *client) {
+    if(client->freeHandlesSize > 0)
+        return client->freeHandles[--client->freeHandlesSize];
+    return ++client->monitoredItemHandles;
+}
+
+static void
+releaseClientHandle(UA_Client *client, UA_UInt32 handle) {
+    if((client->freeHandlesSize & (client->freeHandlesSize - 1)) == 0) {
+        /* Grow to the next power of two */
+        size_t cap = (client->freeHandlesSize == 0) ? 8 : client->freeHandlesSize * 2;
+        UA_UInt32 *fh = (UA_UInt32*)
+            UA_realloc(client->freeHandles, cap * sizeof(UA_UInt32));
+        if(!fh)
+            return; /* The handle is not reused */
+        client->freeHandles = fh;
+    }
+    client->freeHandles[client->freeHandlesSize++] = handle;
+}
+
+/* The MonitoredItem is also in the tree of the Subscription. So a failed
+ * insertion only affects the lookup speed. */
+static void
+addToHandleTable(UA_Client *client, UA_Client_MonitoredItem *mon) {
+    if(mon->clientHandle >= client->monitoredItemsByHandleSize) {
+        size_t size = client->monitoredItemsByHandleSize * 2;
+        if(size <= mon->clientHandle)
+            size = (size_t)mon->clientHandle + 16;
+        UA_Client_MonitoredItem **t = (UA_Client_MonitoredItem**)
+            UA_realloc(client->monitoredItemsByHandle,
+                       size * sizeof(UA_Client_MonitoredItem*));
+        if(!t)
+            return;
+        memset(&t[client->monitoredItemsByHandleSize], 0,
+               (size - client->monitoredItemsByHandleSize) *
+               sizeof(UA_Client_MonitoredItem*));
+        client->monitoredItemsByHandle = t;
+        client->monitoredItemsByHandleSize = size;
+    }
+    client->monitoredItemsByHandle[mon->clientHandle] = mon;
+}
+
+static UA_Client_MonitoredItem *
+findMonitoredItem(UA_Client *client, UA_Client_Subscription *sub,
+                  UA_UInt32 clientHandle) {
+    if(clientHandle < client->monitoredItemsByHandleSize) {
+        UA_Client_MonitoredItem *mon = client->monitoredItemsByHandle[clientHandle];
+        if(mon)
+            return (mon->sub == sub) ? mon : NULL;
+    }
+    UA_Client_MonitoredItem dummy;
+    dummy.clientHandle = clientHandle;
+    return ZIP_FIND(MonitorItemsTree, &sub->monitoredItems, &dummy);
+}
+
 static void
 MonitoredItem_delete(UA_Client *client, UA_Client_Subscription *sub,
                      UA_Client_MonitoredItem *mon);
@@ -62,6 +119,10 @@ ua_Subscriptions_create(UA_Client *client, UA_Client_Subscription *newSub,
     newSub->lastActivity = el->dateTime_nowMonotonic(el);
     newSub->publishingInterval = response->revisedPublishingInterval;
     newSub->maxKeepAliveCount = response->revisedMaxKeepAliveCount;
+    newSub->dataChangeBatchCallback = NULL;
+    newSub->republishNext = 0;
+    newSub->republishEnd = 0;
+    SIMPLEQ_INIT(&newSub->heldMessages);
     ZIP_INIT(&newSub->monitoredItems);
     LIST_INSERT_HEAD(&client->subscriptions, newSub, listEntry);
 
@@ -292,6 +353,14 @@ __Client_Subscription_deleteInternal(UA_Client *client,
         UA_LOCK(&client->clientMutex);
     }
 
+    /* Drop the messages held back for a republish */
+    UA_Client_HeldMessage *hm;
+    while((hm = SIMPLEQ_FIRST(&sub->heldMessages))) {
+        SIMPLEQ_REMOVE_HEAD(&sub->heldMessages, next);
+        UA_NotificationMessage_clear(&hm->msg);
+        UA_free(hm);
+    }
+
     /* Remove */
     LIST_REMOVE(sub, listEntry);
     UA_free(sub);
@@ -420,6 +489,18 @@ UA_Client_Subscriptions_deleteSingle(UA_Client *client, UA_UInt32 subscriptionId
     return retval;
 }
 
+UA_StatusCode
+UA_Client_Subscriptions_setDataChangeBatchCallback(UA_Client *client,
+                                                   UA_UInt32 subscriptionId,
+                                                   UA_Client_DataChangeBatchCallback callback) {
+    UA_LOCK(&client->clientMutex);
+    UA_Client_Subscription *sub = findSubscription(client, subscriptionId);
+    if(sub)
+        sub->dataChangeBatchCallback = callback;
+    UA_UNLOCK(&client->clientMutex);
+    return (sub) ? UA_STATUSCODE_GOOD : UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
+}
+
 /******************/
 /* MonitoredItems */
 /******************/
@@ -430,6 +511,10 @@ MonitoredItem_delete(UA_Client *client, UA_Client_Subscription *sub,
     UA_LOCK_ASSERT(&client->clientMutex, 1);
 
     ZIP_REMOVE(MonitorItemsTree, &sub->monitoredItems, mon);
+    if(mon->clientHandle < client->monitoredItemsByHandleSize &&
+       client->monitoredItemsByHandle[mon->clientHandle] == mon)
+        client->monitoredItemsByHandle[mon->clientHandle] = NULL;
+    releaseClientHandle(client, mon->clientHandle);
     if(mon->deleteCallback) {
         void *subC = sub->context;
         void *monC = mon->context;
@@ -482,6 +567,9 @@ ua_MonitoredItems_create(UA_Client *client, MonitoredItems_CreateData *data,
     /* Add internally */
     for(size_t i = 0; i < request->itemsToCreateSize; i++) {
         if(response->results[i].statusCode != UA_STATUSCODE_GOOD) {
+            /* Not created in the server. The clientHandle can be reused. */
+            releaseClientHandle(client,
+                                request->itemsToCreate[i].requestedParameters.clientHandle);
             void *subC = sub->context;
             UA_UInt32 subId = sub->subscriptionId;
             UA_UNLOCK(&client->clientMutex);
@@ -503,6 +591,7 @@ ua_MonitoredItems_create(UA_Client *client, MonitoredItems_CreateData *data,
             continue;
         }
 
+        newMon->sub = sub;
         newMon->monitoredItemId = response->results[i].monitoredItemId;
         newMon->clientHandle = request->itemsToCreate[i].requestedParameters.clientHandle;
         newMon->context = data->contexts[i];
@@ -513,6 +602,7 @@ ua_MonitoredItems_create(UA_Client *client, MonitoredItems_CreateData *data,
         newMon->isEventMonitoredItem =
             (request->itemsToCreate[i].itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER);
         ZIP_INSERT(MonitorItemsTree, &sub->monitoredItems, newMon);
+        addToHandleTable(client, newMon);
 
         UA_LOG_DEBUG(client->config.logging, UA_LOGCATEGORY_CLIENT,
                      "Subscription %" PRIu32 " | Added a MonitoredItem with handle %" PRIu32,
@@ -586,7 +676,7 @@ MonitoredItems_CreateData_prepare(UA_Client *client,
     /* Set the clientHandle */
     for(size_t i = 0; i < data->request.itemsToCreateSize; i++)
         data->request.itemsToCreate[i].requestedParameters.clientHandle =
-            ++client->monitoredItemHandles;
+            takeClientHandle(client);
 
     return UA_STATUSCODE_GOOD;
 
@@ -1054,33 +1144,99 @@ __nextSequenceNumber(UA_UInt32 sequenceNumber) {
     return nextSequenceNumber;
 }
 
+static UA_Client_MonitoredItem *
+findDataChangeMonitoredItem(UA_Client *client, UA_Client_Subscription *sub,
+                            UA_UInt32 clientHandle) {
+    UA_Client_MonitoredItem *mon = findMonitoredItem(client, sub, clientHandle);
+    if(!mon) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Could not process a notification with clienthandle %" PRIu32
+                       " on subscription %" PRIu32, clientHandle, sub->subscriptionId);
+        return NULL;
+    }
+    if(mon->isEventMonitoredItem) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "MonitoredItem is configured for Events. But received a "
+                       "DataChangeNotification.");
+        return NULL;
+    }
+    return mon;
+}
+
+/* Call the batch callback once for all notifications. The array is reused
+ * between the calls. */
+static void
+processDataChangeBatch(UA_Client *client, UA_Client_Subscription *sub,
+                       UA_DataChangeNotification *dataChangeNotification) {
+    /* Detach the array. A nested call from within the callback uses its own. */
+    size_t size = dataChangeNotification->monitoredItemsSize;
+    UA_Client_DataChange *dcs = client->dataChanges;
+    size_t dcsSize = client->dataChangesSize;
+    client->dataChanges = NULL;
+    client->dataChangesSize = 0;
+    if(dcsSize < size) {
+        UA_Client_DataChange *newDcs = (UA_Client_DataChange*)
+            UA_realloc(dcs, size * sizeof(UA_Client_DataChange));
+        if(newDcs) {
+            dcs = newDcs;
+            dcsSize = size;
+        }
+    }
+
+    /* Without memory, the notifications are passed in smaller batches */
+    UA_Client_DataChange single;
+    UA_Client_DataChange *batch = (dcsSize > 0) ? dcs : &single;
+    size_t batchSize = (dcsSize > 0) ? dcsSize : 1;
+
+    size_t j = 0;
+    while(j < size) {
+        size_t n = 0;
+        for(; j < size && n < batchSize; j++) {
+            UA_MonitoredItemNotification *min = &dataChangeNotification->monitoredItems[j];
+            UA_Client_MonitoredItem *mon =
+                findDataChangeMonitoredItem(client, sub, min->clientHandle);
+            if(!mon)
+                continue;
+            batch[n].monId = mon->monitoredItemId;
+            batch[n].monContext = mon->context;
+            batch[n].value = &min->value;
+            n++;
+        }
+        if(n == 0)
+            continue;
+        void *subC = sub->context;
+        UA_UInt32 subId = sub->subscriptionId;
+        UA_Client_DataChangeBatchCallback cb = sub->dataChangeBatchCallback;
+        UA_UNLOCK(&client->clientMutex);
+        cb(client, subId, subC, n, batch);
+        UA_LOCK(&client->clientMutex);
+    }
+
+    /* Reattach the array */
+    if(!client->dataChanges) {
+        client->dataChanges = dcs;
+        client->dataChangesSize = dcsSize;
+    } else {
+        UA_free(dcs);
+    }
+}
+
 static void
 processDataChangeNotification(UA_Client *client, UA_Client_Subscription *sub,
                               UA_DataChangeNotification *dataChangeNotification) {
     UA_LOCK_ASSERT(&client->clientMutex, 1);
 
+    if(sub->dataChangeBatchCallback) {
+        processDataChangeBatch(client, sub, dataChangeNotification);
+        return;
+    }
+
     for(size_t j = 0; j < dataChangeNotification->monitoredItemsSize; ++j) {
         UA_MonitoredItemNotification *min = &dataChangeNotification->monitoredItems[j];
-
-        /* Find the MonitoredItem */
-        UA_Client_MonitoredItem *mon;
-        UA_Client_MonitoredItem dummy;
-        dummy.clientHandle = min->clientHandle;
-        mon = ZIP_FIND(MonitorItemsTree, &sub->monitoredItems, &dummy);
-
-        if(!mon) {
-            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
-                           "Could not process a notification with clienthandle %" PRIu32
-                           " on subscription %" PRIu32, min->clientHandle, sub->subscriptionId);
+        UA_Client_MonitoredItem *mon =
+            findDataChangeMonitoredItem(client, sub, min->clientHandle);
+        if(!mon)
             continue;
-        }
-
-        if(mon->isEventMonitoredItem) {
-            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
-                           "MonitoredItem is configured for Events. But received a "
-                           "DataChangeNotification.");
-            continue;
-        }
 
         if(mon->handler.dataChangeCallback) {
             void *subC = sub->context;
@@ -1103,10 +1259,8 @@ processEventNotification(UA_Client *client, UA_Client_Subscription *sub,
         UA_EventFieldList *eventFieldList = &eventNotificationList->events[j];
 
         /* Find the MonitoredItem */
-        UA_Client_MonitoredItem *mon;
-        UA_Client_MonitoredItem dummy;
-        dummy.clientHandle = eventFieldList->clientHandle;
-        mon = ZIP_FIND(MonitorItemsTree, &sub->monitoredItems, &dummy);
+        UA_Client_MonitoredItem *mon =
+            findMonitoredItem(client, sub, eventFieldList->clientHandle);
 
         if(!mon) {
             UA_LOG_DEBUG(client->config.logging, UA_LOGCATEGORY_CLIENT,
@@ -1180,6 +1334,180 @@ processNotificationMessage(UA_Client *client, UA_Client_Subscription *sub,
                    "Unknown notification message type");
 }
 
+/* The number of PublishRequests that are kept in flight */
+static UA_UInt16
+getPublishWindow(UA_Client *client) {
+    UA_UInt16 lo = client->config.outStandingPublishRequests;
+    UA_UInt16 hi = client->config.maxOutStandingPublishRequests;
+    if(hi <= lo || client->publishWindow < lo)
+        return lo;
+    if(client->publishWindow > hi)
+        return hi;
+    return client->publishWindow;
+}
+
+/* Upper limit for the number of missing NotificationMessages that are
+ * requested with Republish after a gap in the sequence numbers */
+#define UA_CLIENT_MAXREPUBLISH 256
+
+static void
+addAck(UA_Client *client, UA_UInt32 subscriptionId, UA_UInt32 sequenceNumber) {
+    UA_Client_NotificationsAckNumber *tmpAck = (UA_Client_NotificationsAckNumber*)
+        UA_malloc(sizeof(UA_Client_NotificationsAckNumber));
+    if(!tmpAck) {
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Not enough memory to store the acknowledgement for a publish "
+                       "message on subscription %" PRIu32, subscriptionId);
+        return;
+    }
+    tmpAck->subAck.sequenceNumber = sequenceNumber;
+    tmpAck->subAck.subscriptionId = subscriptionId;
+    LIST_INSERT_HEAD(&client->pendingNotificationsAcks, tmpAck, listEntry);
+}
+
+/* Returns false if the Subscription was deleted from within the callbacks */
+static UA_Boolean
+processMessage(UA_Client *client, UA_Client_Subscription *sub,
+               UA_NotificationMessage *msg) {
+    /* According to f), a keep-alive message contains no notifications and has
+     * the sequence number of the next NotificationMessage that is to be sent =>
+     * More than one consecutive keep-alive message or a NotificationMessage
+     * following a keep-alive message will share the same sequence number. */
+    if(msg->notificationDataSize == 0)
+        return true;
+    sub->sequenceNumber = msg->sequenceNumber;
+
+    /* Process the notification messages */
+    UA_UInt32 subId = sub->subscriptionId;
+    for(size_t k = 0; k < msg->notificationDataSize; ++k)
+        processNotificationMessage(client, sub, &msg->notificationData[k]);
+    return (findSubscription(client, subId) == sub);
+}
+
+/* Process the messages that were held back during the republish */
+static void
+finishRepublish(UA_Client *client, UA_Client_Subscription *sub) {
+    sub->republishNext = 0;
+    UA_Client_HeldMessage *hm;
+    while((hm = SIMPLEQ_FIRST(&sub->heldMessages))) {
+        SIMPLEQ_REMOVE_HEAD(&sub->heldMessages, next);
+        UA_Boolean exists = processMessage(client, sub, &hm->msg);
+        UA_NotificationMessage_clear(&hm->msg);
+        UA_free(hm);
+        if(!exists)
+            return;
+    }
+}
+
+static UA_Boolean
+sendRepublish(UA_Client *client, UA_Client_Subscription *sub);
+
+static void
+processRepublishResponseAsync(UA_Client *client, void *userdata,
+                              UA_UInt32 requestId, void *r) {
+    UA_RepublishResponse *response = (UA_RepublishResponse*)r;
+    UA_UInt32 subId = (UA_UInt32)(uintptr_t)userdata;
+
+    UA_LOCK(&client->clientMutex);
+
+    UA_Client_Subscription *sub = findSubscription(client, subId);
+    if(!sub || sub->republishNext == 0)
+        goto done;
+
+    UA_StatusCode res = response->responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_NotificationMessage *msg = &response->notificationMessage;
+        addAck(client, subId, msg->sequenceNumber);
+        if(!processMessage(client, sub, msg))
+            goto done;
+    } else if(res == UA_STATUSCODE_BADMESSAGENOTAVAILABLE) {
+        /* The message is lost for good */
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Subscription %" PRIu32 " | The NotificationMessage with "
+                       "sequence number %" PRIu32 " is no longer available",
+                       subId, sub->republishNext);
+        sub->sequenceNumber = sub->republishNext;
+    } else {
+        /* Abort. Process the held back messages without the missing ones. */
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Subscription %" PRIu32 " | Republish failed with %s",
+                       subId, UA_StatusCode_name(res));
+        finishRepublish(client, sub);
+        goto done;
+    }
+
+    /* Request the next missing message */
+    sub->republishNext = __nextSequenceNumber(sub->republishNext);
+    if(sub->republishNext == sub->republishEnd || !sendRepublish(client, sub))
+        finishRepublish(client, sub);
+
+ done:
+    UA_UNLOCK(&client->clientMutex);
+}
+
+static UA_Boolean
+sendRepublish(UA_Client *client, UA_Client_Subscription *sub) {
+    UA_RepublishRequest request;
+    UA_RepublishRequest_init(&request);
+    request.subscriptionId = sub->subscriptionId;
+    request.retransmitSequenceNumber = sub->republishNext;
+    UA_StatusCode res =
+        __Client_AsyncService(client, &request, &UA_TYPES[UA_TYPES_REPUBLISHREQUEST],
+                              processRepublishResponseAsync,
+                              &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE],
+                              (void*)(uintptr_t)sub->subscriptionId, NULL);
+    return (res == UA_STATUSCODE_GOOD);
+}
+
+static void
+adaptPublishWindow(UA_Client *client, UA_PublishRequest *request,
+                   UA_PublishResponse *response) {
+    UA_UInt16 lo = client->config.outStandingPublishRequests;
+    UA_UInt16 hi = client->config.maxOutStandingPublishRequests;
+    if(hi <= lo)
+        return;
+
+    UA_UInt16 window = getPublishWindow(client);
+    if(response->moreNotifications) {
+        /* The server answered right away from its backlog. So the elapsed
+         * time is the round-trip time. Smoothed as for TCP (RFC 6298). */
+        UA_EventLoop *el = client->config.eventLoop;
+        UA_Double rtt = (UA_Double)(el->dateTime_now(el) -
+                                    request->requestHeader.timestamp) / UA_DATETIME_MSEC;
+        if(rtt >= 0.0)
+            client->publishRtt = (client->publishRtt > 0.0) ?
+                (client->publishRtt * 0.875) + (rtt * 0.125) : rtt;
+        if(window < hi)
+            window++;
+    } else if(response->notificationMessage.notificationDataSize == 0) {
+        /* Keep-alive, the server had nothing to send */
+        if(window > lo)
+            window--;
+    }
+
+    /* Serve the fastest Subscription during the round-trip of the
+     * PublishRequest that replaces the answered one */
+    UA_Double interval = 0.0;
+    UA_Client_Subscription *sub;
+    LIST_FOREACH(sub, &client->subscriptions, listEntry) {
+        if(sub->publishingInterval > 0.0 &&
+           (interval == 0.0 || sub->publishingInterval < interval))
+            interval = sub->publishingInterval;
+    }
+    if(client->publishRtt > 0.0 && interval > 0.0) {
+        UA_Double ratio = client->publishRtt / interval;
+        UA_UInt32 needed = 1 + (UA_UInt32)ratio;
+        if((UA_Double)(needed - 1) < ratio)
+            needed++;
+        if(needed > hi)
+            needed = hi;
+        if(window < needed)
+            window = (UA_UInt16)needed;
+    }
+
+    client->publishWindow = window;
+}
+
 static void
 __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishRequest *request,
                                               UA_PublishResponse *response) {
@@ -1190,6 +1518,18 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
     client->currentlyOutStandingPublishRequests--;
 
     if(response->responseHeader.serviceResult == UA_STATUSCODE_BADTOOMANYPUBLISHREQUESTS) {
+        /* Lower the limit of the adaptive window to what the server accepts */
+        if(getPublishWindow(client) > client->config.outStandingPublishRequests) {
+            UA_UInt16 window = client->currentlyOutStandingPublishRequests;
+            if(window < client->config.outStandingPublishRequests)
+                window = client->config.outStandingPublishRequests;
+            client->publishWindow = window;
+            client->config.maxOutStandingPublishRequests = window;
+            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                           "Too many publishrequest, reduce maxOutStandingPublishRequests "
+                           "to %" PRId16, window);
+            return;
+        }
         if(client->config.outStandingPublishRequests > 1) {
             client->config.outStandingPublishRequests--;
             UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
@@ -1230,7 +1570,8 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
     }
 
     if(response->responseHeader.serviceResult == UA_STATUSCODE_BADSESSIONCLOSED) {
-        if(client->sessionState != UA_SESSIONSTATE_ACTIVATED) {
+        if(client->sessionState != UA_SESSIONSTATE_ACTIVATED &&
+           !client->subscriptionsTransferPending) {
             UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
                            "Received Publish Response with code %s",
                            UA_StatusCode_name(response->responseHeader.serviceResult));
@@ -1262,46 +1603,54 @@ __Client_Subscriptions_processPublishResponse(UA_Client *client, UA_PublishReque
     UA_EventLoop *el = client->config.eventLoop;
     sub->lastActivity = el->dateTime_nowMonotonic(el);
 
+    adaptPublishWindow(client, request, response);
+
+    /* Add to the list of pending acks. Before processing, as the
+     * Subscription might be deleted from within the callbacks. */
+    for(size_t i = 0; i < response->availableSequenceNumbersSize; i++) {
+        if(response->availableSequenceNumbers[i] != msg->sequenceNumber)
+            continue;
+        addAck(client, sub->subscriptionId, msg->sequenceNumber);
+        break;
+    }
+
     /* Detect missing message - OPC Unified Architecture, Part 4 5.13.1.1 e) */
-    if(__nextSequenceNumber(sub->sequenceNumber) != msg->sequenceNumber) {
+    UA_UInt32 expected = __nextSequenceNumber(sub->sequenceNumber);
+    if(expected != msg->sequenceNumber && sub->republishNext == 0) {
         UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
                        "Invalid subscription sequence number: expected %" PRIu32
-                       " but got %" PRIu32, __nextSequenceNumber(sub->sequenceNumber),
-                       msg->sequenceNumber);
-        /* This is an error. But we do not abort the connection. Some server
-         * SDKs misbehave from time to time and send out-of-order sequence
-         * numbers. (Probably some multi-threading synchronization issue.) */
-        /* UA_Client_disconnect(client);
-           return; */
+                       " but got %" PRIu32, expected, msg->sequenceNumber);
+        /* Request the missing messages from the retransmission queue of the
+         * server. Out-of-order sequence numbers (from behind) are not an
+         * error. Some server SDKs misbehave from time to time. (Probably some
+         * multi-threading synchronization issue.) */
+        if(sub->sequenceNumber != 0 &&
+           msg->sequenceNumber - expected <= UA_CLIENT_MAXREPUBLISH) {
+            sub->republishNext = expected;
+            sub->republishEnd = msg->sequenceNumber;
+            if(!sendRepublish(client, sub))
+                sub->republishNext = 0;
+        }
     }
-    /* According to f), a keep-alive message contains no notifications and has
-     * the sequence number of the next NotificationMessage that is to be sent =>
-     * More than one consecutive keep-alive message or a NotificationMessage
-     * following a keep-alive message will share the same sequence number. */
-    if (msg->notificationDataSize)
-        sub->sequenceNumber = msg->sequenceNumber;
 
-    /* Process the notification messages */
-    for(size_t k = 0; k < msg->notificationDataSize; ++k)
-        processNotificationMessage(client, sub, &msg->notificationData[k]);
-
-    /* Add to the list of pending acks */
-    for(size_t i = 0; i < response->availableSequenceNumbersSize; i++) {
-        if(response->availableSequenceNumbers[i] != msg->sequenceNumber)
-            continue;
-        UA_Client_NotificationsAckNumber *tmpAck = (UA_Client_NotificationsAckNumber*)
-            UA_malloc(sizeof(UA_Client_NotificationsAckNumber));
-        if(!tmpAck) {
-            UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
-                           "Not enough memory to store the acknowledgement for a publish "
-                           "message on subscription %" PRIu32, sub->subscriptionId);
-            break;
+    /* Hold the message back until the missing messages were processed */
+    if(sub->republishNext != 0) {
+        if(msg->notificationDataSize == 0)
+            return; /* Keep-alive */
+        UA_Client_HeldMessage *hm = (UA_Client_HeldMessage*)
+            UA_malloc(sizeof(UA_Client_HeldMessage));
+        if(hm && UA_NotificationMessage_copy(msg, &hm->msg) == UA_STATUSCODE_GOOD) {
+            SIMPLEQ_INSERT_TAIL(&sub->heldMessages, hm, next);
+            return;
         }
-        tmpAck->subAck.sequenceNumber = msg->sequenceNumber;
-        tmpAck->subAck.subscriptionId = sub->subscriptionId;
-        LIST_INSERT_HEAD(&client->pendingNotificationsAcks, tmpAck, listEntry);
-        break;
+        UA_free(hm);
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Subscription %" PRIu32 " | Cannot hold back the message "
+                       "during the republish. Process it out of order.",
+                       sub->subscriptionId);
     }
+
+    processMessage(client, sub, msg);
 }
 
 static void
@@ -1318,14 +1667,28 @@ processPublishResponseAsync(UA_Client *client, void *userdata,
     /* Delete the cached request */
     UA_PublishRequest_delete(req);
 
-    /* Fill up the outstanding publish requests */
-    __Client_Subscriptions_backgroundPublish(client);
+    /* Fill up the outstanding publish requests. While at least half of them
+     * are still queued in the server, wait until all responses of the received
+     * buffer are processed. Then their acknowledgements are sent together in
+     * the first new PublishRequest. */
+    if(client->currentlyOutStandingPublishRequests * 2 > getPublishWindow(client)) {
+        client->publishRefillPending = true;
+    } else {
+        client->publishRefillPending = false;
+        __Client_Subscriptions_backgroundPublish(client);
+    }
 
     UA_UNLOCK(&client->clientMutex);
 }
 
 void
 __Client_Subscriptions_clean(UA_Client *client) {
+    client->publishRefillPending = false;
+    client->publishWindow = 0;
+    client->publishRtt = 0.0;
+    client->subscriptionsTransferPending = false;
+    client->subscriptionsTransferSent = false;
+
     UA_Client_NotificationsAckNumber *n;
     UA_Client_NotificationsAckNumber *tmp;
     LIST_FOREACH_SAFE(n, &client->pendingNotificationsAcks, listEntry, tmp) {
@@ -1339,6 +1702,138 @@ __Client_Subscriptions_clean(UA_Client *client) {
         __Client_Subscription_deleteInternal(client, sub); /* force local removal */
 
     client->monitoredItemHandles = 0;
+    UA_free(client->monitoredItemsByHandle);
+    client->monitoredItemsByHandle = NULL;
+    client->monitoredItemsByHandleSize = 0;
+    UA_free(client->freeHandles);
+    client->freeHandles = NULL;
+    client->freeHandlesSize = 0;
+    UA_free(client->dataChanges);
+    client->dataChanges = NULL;
+    client->dataChangesSize = 0;
+}
+
+void
+__Client_Subscriptions_detach(UA_Client *client) {
+    client->publishRefillPending = false;
+    client->publishWindow = 0;
+    client->publishRtt = 0.0;
+
+    /* The acknowledgements remain valid for the transferred Subscriptions */
+    if(!LIST_FIRST(&client->subscriptions))
+        return;
+    client->subscriptionsTransferPending = true;
+    client->subscriptionsTransferSent = false;
+    UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                "The Session was lost. Keep the Subscriptions for a transfer "
+                "to the next Session.");
+}
+
+static void
+processTransferResponseAsync(UA_Client *client, void *userdata,
+                             UA_UInt32 requestId, void *r) {
+    UA_TransferSubscriptionsRequest *request =
+        (UA_TransferSubscriptionsRequest*)userdata;
+    UA_TransferSubscriptionsResponse *response =
+        (UA_TransferSubscriptionsResponse*)r;
+
+    UA_LOCK(&client->clientMutex);
+
+    client->subscriptionsTransferSent = false;
+    UA_StatusCode res = response->responseHeader.serviceResult;
+
+    /* The connection was lost again. Retry with the next Session. */
+    if(res == UA_STATUSCODE_BADSECURECHANNELCLOSED ||
+       res == UA_STATUSCODE_BADCONNECTIONCLOSED ||
+       res == UA_STATUSCODE_BADSESSIONCLOSED ||
+       res == UA_STATUSCODE_BADSESSIONIDINVALID ||
+       res == UA_STATUSCODE_BADTIMEOUT) {
+        if(!client->subscriptionsTransferPending)
+            goto done; /* The Subscriptions were cleaned up in the meantime */
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "TransferSubscriptions failed with %s. Retry with the "
+                       "next Session.", UA_StatusCode_name(res));
+        goto done;
+    }
+
+    /* Delete the Subscriptions that could not be transferred */
+    client->subscriptionsTransferPending = false;
+    for(size_t i = 0; i < request->subscriptionIdsSize; i++) {
+        UA_Client_Subscription *sub =
+            findSubscription(client, request->subscriptionIds[i]);
+        if(!sub)
+            continue;
+        UA_StatusCode subRes = res;
+        if(subRes == UA_STATUSCODE_GOOD)
+            subRes = (i < response->resultsSize) ?
+                response->results[i].statusCode : UA_STATUSCODE_BADUNEXPECTEDERROR;
+        if(subRes == UA_STATUSCODE_GOOD) {
+            UA_LOG_INFO(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                        "Subscription %" PRIu32 " | Transferred to the new Session",
+                        sub->subscriptionId);
+            continue;
+        }
+        UA_LOG_WARNING(client->config.logging, UA_LOGCATEGORY_CLIENT,
+                       "Subscription %" PRIu32 " | Could not be transferred to "
+                       "the new Session (%s). Delete the Subscription.",
+                       sub->subscriptionId, UA_StatusCode_name(subRes));
+        __Client_Subscription_deleteInternal(client, sub);
+    }
+
+    /* Start publishing for the transferred Subscriptions */
+    __Client_Subscriptions_backgroundPublish(client);
+
+ done:
+    UA_TransferSubscriptionsRequest_delete(request);
+    UA_UNLOCK(&client->clientMutex);
+}
+
+void
+__Client_Subscriptions_transfer(UA_Client *client) {
+    UA_LOCK_ASSERT(&client->clientMutex, 1);
+
+    if(!client->subscriptionsTransferPending || client->subscriptionsTransferSent)
+        return;
+
+    /* Collect the SubscriptionIds */
+    size_t count = 0;
+    UA_Client_Subscription *sub;
+    LIST_FOREACH(sub, &client->subscriptions, listEntry)
+        count++;
+    if(count == 0) {
+        client->subscriptionsTransferPending = false;
+        return;
+    }
+
+    UA_TransferSubscriptionsRequest *request = UA_TransferSubscriptionsRequest_new();
+    if(!request)
+        return;
+    request->subscriptionIds = (UA_UInt32*)
+        UA_Array_new(count, &UA_TYPES[UA_TYPES_UINT32]);
+    if(!request->subscriptionIds) {
+        UA_TransferSubscriptionsRequest_delete(request);
+        return;
+    }
+    request->subscriptionIdsSize = count;
+    size_t i = 0;
+    LIST_FOREACH(sub, &client->subscriptions, listEntry)
+        request->subscriptionIds[i++] = sub->subscriptionId;
+
+    /* The server sends the current values of the MonitoredItems with the next
+     * PublishResponse. So nothing is missed while the Session was lost. */
+    request->sendInitialValues = true;
+
+    UA_StatusCode res =
+        __Client_AsyncService(client, request,
+                              &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSREQUEST],
+                              processTransferResponseAsync,
+                              &UA_TYPES[UA_TYPES_TRANSFERSUBSCRIPTIONSRESPONSE],
+                              request, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_TransferSubscriptionsRequest_delete(request);
+        return;
+    }
+    client->subscriptionsTransferSent = true;
 }
 
 void
@@ -1377,6 +1872,15 @@ __Client_Subscriptions_backgroundPublishInactivityCheck(UA_Client *client) {
     }
 }
 
+void
+__Client_Subscriptions_refillPublish(UA_Client *client) {
+    UA_LOCK_ASSERT(&client->clientMutex, 1);
+    if(!client->publishRefillPending)
+        return;
+    client->publishRefillPending = false;
+    __Client_Subscriptions_backgroundPublish(client);
+}
+
 void
 __Client_Subscriptions_backgroundPublish(UA_Client *client) {
     UA_LOCK_ASSERT(&client->clientMutex, 1);
@@ -1384,11 +1888,15 @@ __Client_Subscriptions_backgroundPublish(UA_Client *client) {
     if(client->sessionState != UA_SESSIONSTATE_ACTIVATED)
         return;
 
+    /* Wait until the Subscriptions were transferred to the Session */
+    if(client->subscriptionsTransferPending)
+        return;
+
     /* The session must have at least one subscription */
     if(!LIST_FIRST(&client->subscriptions))
         return;
 
-    while(client->currentlyOutStandingPublishRequests < client->config.outStandingPublishRequests) {
+    while(client->currentlyOutStandingPublishRequests < getPublishWindow(client)) {
         UA_PublishRequest *request = UA_PublishRequest_new();
         if(!request)
             return;
@@ -24,6 +24,10 @@
 #include "mp_printf.h"
 #include "ua_pubsub_networkmessage.h"
 
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+#include "ua_pubsub_bufmalloc.h"
+#endif
+
 #ifdef UA_ENABLE_PUBSUB_SKS
 #include <ua_pubsub_keystorage.h>
 #endif
@@ -108,12 +112,45 @@ typedef struct UA_SecurityGroup UA_SecurityGroup;
 const char *
 UA_PubSubState_name(UA_PubSubState state);
 
+/**********************************************/
+/*              Component Index               */
+/**********************************************/
+
+/* All components are indexed by their NodeId in the PubSubManager. So the
+ * lookup does not have to walk the (nested) lists of components. The index
+ * entry is embedded in the component. */
+
+typedef enum {
+    UA_PUBSUBINDEX_CONNECTION,
+    UA_PUBSUBINDEX_WRITERGROUP,
+    UA_PUBSUBINDEX_DATASETWRITER,
+    UA_PUBSUBINDEX_READERGROUP,
+    UA_PUBSUBINDEX_DATASETREADER,
+    UA_PUBSUBINDEX_PUBLISHEDDATASET,
+    UA_PUBSUBINDEX_SUBSCRIBEDDATASET
+} UA_PubSubIndexType;
+
+typedef struct {
+    UA_UInt32 hash;
+    const UA_NodeId *id; /* Points to the identifier of the component */
+} UA_PubSubIndexKey;
+
+typedef struct UA_PubSubIndexEntry {
+    ZIP_ENTRY(UA_PubSubIndexEntry) treeEntry;
+    UA_PubSubIndexKey key;
+    UA_PubSubIndexType type;
+    void *component;
+} UA_PubSubIndexEntry;
+
+typedef ZIP_HEAD(UA_PubSubIndex, UA_PubSubIndexEntry) UA_PubSubIndex;
+
 /**********************************************/
 /*            PublishedDataSet                */
 /**********************************************/
 
 typedef struct UA_PublishedDataSet {
     TAILQ_ENTRY(UA_PublishedDataSet) listEntry;
+    UA_PubSubIndexEntry idEntry;
     TAILQ_HEAD(, UA_DataSetField) fields;
     UA_NodeId identifier;
     UA_String logIdString;
@@ -154,6 +191,7 @@ typedef struct UA_StandaloneSubscribedDataSet{
     UA_StandaloneSubscribedDataSetConfig config;
     UA_NodeId identifier;
     TAILQ_ENTRY(UA_StandaloneSubscribedDataSet) listEntry;
+    UA_PubSubIndexEntry idEntry;
     UA_NodeId connectedReader;
 } UA_StandaloneSubscribedDataSet;
 
@@ -192,10 +230,53 @@ UA_StandaloneSubscribedDataSet_clear(UA_Server *server,
 /*               Connection                   */
 /**********************************************/
 
+/* The WriterGroups of a connection with the same PublishingInterval share one
+ * cyclic callback of the EventLoop. All due WriterGroups are published in the
+ * same cycle. */
+typedef struct UA_PubSubPublishSchedule {
+    LIST_ENTRY(UA_PubSubPublishSchedule) listEntry;
+    struct UA_PubSubConnection *connection;
+    UA_Duration publishingInterval;
+    UA_UInt64 callbackId;
+    size_t writerGroupsSize;
+    UA_Boolean inCycle;    /* Currently executing the publish cycle */
+    UA_Boolean deleteFlag; /* Free when the current cycle is done */
+} UA_PubSubPublishSchedule;
+
+/* Offset-based decoding for the non-RT ReaderGroups. Publishers usually send
+ * NetworkMessages with the same layout in every cycle. A received layout
+ * becomes a decode template. When it was seen UA_PUBSUB_DECODETEMPLATE_STABLE
+ * times in a row, further messages with the identical layout are decoded
+ * directly at the known offsets. Every other message (and every failure of
+ * the offset-based decoding) goes through the full decoding. */
+#define UA_PUBSUB_DECODETEMPLATES 4
+#define UA_PUBSUB_DECODETEMPLATE_STABLE 8
+
+typedef struct {
+    UA_NetworkMessageOffsetBuffer offsetBuffer;
+    UA_ByteString layout; /* Message from which the template was taken */
+    UA_UInt32 matches;    /* Received messages with the same layout */
+} UA_PubSubDecodeTemplate;
+
+/* Index of the DataSetReaders of a connection by the identifiers they expect
+ * in the received NetworkMessages (PublisherId, WriterGroupId and
+ * DataSetWriterId) */
+typedef struct {
+    UA_UInt32 hash;
+    UA_PublisherIdType publisherIdType;
+    UA_UInt64 publisherId;       /* Numeric PublisherIds */
+    UA_String publisherIdString; /* Not copied, points to the config/message */
+    UA_UInt16 writerGroupId;
+    UA_UInt16 dataSetWriterId;
+} UA_DataSetReaderKey;
+
+typedef ZIP_HEAD(UA_DataSetReaderIndex, UA_DataSetReader) UA_DataSetReaderIndex;
+
 typedef struct UA_PubSubConnection {
     UA_PubSubComponentEnumType componentType;
 
     TAILQ_ENTRY(UA_PubSubConnection) listEntry;
+    UA_PubSubIndexEntry idEntry;
     UA_NodeId identifier;
     UA_String logIdString;
 
@@ -222,6 +303,11 @@ typedef struct UA_PubSubConnection {
 
     size_t readerGroupsSize;
     LIST_HEAD(, UA_ReaderGroup) readerGroups;
+    UA_DataSetReaderIndex readerIndex; /* DataSetReaders of all ReaderGroups */
+
+    LIST_HEAD(, UA_PubSubPublishSchedule) publishSchedules;
+
+    UA_PubSubDecodeTemplate decodeTemplates[UA_PUBSUB_DECODETEMPLATES];
 
     UA_UInt16 configurationFreezeCounter;
 
@@ -256,6 +342,14 @@ void
 UA_PubSubConnection_process(UA_Server *server, UA_PubSubConnection *c,
                             UA_ByteString msg);
 
+#ifdef UA_ENABLE_JSON_ENCODING
+/* Decode a received JSON NetworkMessage. The DataSetMetaData of the
+ * DataSetReaders of the connection is used for the schema-driven decoding of
+ * the DataSetMessages. Compressed messages are decompressed first. */
+UA_StatusCode
+UA_PubSubConnection_decodeJson(UA_PubSubConnection *c, UA_NetworkMessage *nm,
+                               const UA_ByteString *msg);
+#endif
 
 void
 UA_PubSubConnection_disconnect(UA_PubSubConnection *c);
@@ -303,6 +397,7 @@ typedef struct UA_DataSetWriter {
     UA_PubSubComponentEnumType componentType;
     UA_DataSetWriterConfig config;
     LIST_ENTRY(UA_DataSetWriter) listEntry;
+    UA_PubSubIndexEntry idEntry;
     UA_NodeId identifier;
     UA_String logIdString;
     UA_WriterGroup *linkedWriterGroup;
@@ -318,6 +413,10 @@ typedef struct UA_DataSetWriter {
     UA_UInt16 actualDataSetMessageSequenceCount;
     UA_Boolean configurationFrozen;
     UA_UInt64  pubSubStateTimerId;
+
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    UA_Boolean representationPending; /* Nodes not yet added (lazy mode) */
+#endif
 } UA_DataSetWriter;
 
 UA_StatusCode
@@ -386,6 +485,7 @@ struct UA_WriterGroup {
     UA_PubSubComponentEnumType componentType;
     UA_WriterGroupConfig config;
     LIST_ENTRY(UA_WriterGroup) listEntry;
+    UA_PubSubIndexEntry idEntry;
     UA_NodeId identifier;
     UA_String logIdString;
 
@@ -393,8 +493,15 @@ struct UA_WriterGroup {
     UA_UInt32 writersCount;
 
     UA_UInt64 publishCallbackId; /* registered if != 0 */
+    UA_PubSubPublishSchedule *publishSchedule; /* Shared with other WriterGroups
+                                                * if published via the EventLoop */
     UA_PubSubState state;
     UA_NetworkMessageOffsetBuffer bufferedMessage;
+#ifdef UA_ENABLE_JSON_ENCODING
+    /* Preformatted JSON NetworkMessages of the frozen configuration */
+    UA_NetworkMessageJsonTemplate *jsonTemplates;
+    size_t jsonTemplatesSize;
+#endif
     UA_UInt16 sequenceNumber; /* Increased after every succressuly sent message */
     UA_Boolean configurationFrozen;
     UA_DateTime lastPublishTimeStamp;
@@ -409,6 +516,14 @@ struct UA_WriterGroup {
     UA_UInt32 securityTokenId;
     UA_UInt32 nonceSequenceNumber; /* To be part of the MessageNonce */
     void *securityPolicyContext;
+    void *retiredSecurityPolicyContext; /* Reused for the next key rollover */
+
+    /* The MessageNonce of the next NetworkMessage is generated at the end of
+     * the publish cycle. Then the keystream for it is precomputed until the
+     * next cycle starts. */
+    UA_Byte nextMessageNonce[8];
+    UA_Boolean nextMessageNonceReady;
+    size_t lastEncryptedLength;
 #ifdef UA_ENABLE_PUBSUB_SKS
     UA_PubSubKeyStorage *keyStorage; /* non-owning pointer to keyStorage*/
 #endif
@@ -526,6 +641,20 @@ void
 UA_PubSubDataSetField_sampleValue(UA_Server *server, UA_DataSetField *field,
                                   UA_DataValue *value);
 
+/* Values read from the information model during a publish cycle with several
+ * WriterGroups. Fields that publish the same variable are read only once. */
+typedef struct UA_PubSubSample {
+    ZIP_ENTRY(UA_PubSubSample) treeEntry;
+    UA_UInt32 hash;
+    const UA_PublishedVariableDataType *params;
+    UA_DataValue value;
+} UA_PubSubSample;
+
+typedef ZIP_HEAD(UA_PubSubSampleTree, UA_PubSubSample) UA_PubSubSampleTree;
+
+void
+UA_PubSubSampleTree_clear(UA_PubSubSampleTree *samples);
+
 /**********************************************/
 /*               DataSetReader                */
 /**********************************************/
@@ -538,20 +667,34 @@ typedef struct UA_DataSetReader {
     UA_String logIdString;
     UA_ReaderGroup *linkedReaderGroup;
     LIST_ENTRY(UA_DataSetReader) listEntry;
+    UA_PubSubIndexEntry idEntry;
+    ZIP_ENTRY(UA_DataSetReader) indexEntry;
+    UA_DataSetReaderKey indexKey;
 
     UA_PubSubState state;
     UA_Boolean configurationFrozen;
     UA_NetworkMessageOffsetBuffer bufferedMessage;
 
 #ifdef UA_ENABLE_PUBSUB_MONITORING
-    /* MessageReceiveTimeout handling */
+    /* MessageReceiveTimeout handling. The deadline (monotonic time) is
+     * supervised by the ReaderGroup. Zero if no deadline is set. */
     UA_ServerCallback msgRcvTimeoutTimerCallback;
-    UA_UInt64 msgRcvTimeoutTimerId;
+    UA_DateTime msgRcvTimeoutDeadline;
     UA_Boolean msgRcvTimeoutTimerRunning;
 #endif
     UA_DateTime lastHeartbeatReceived;
+
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    UA_Boolean representationPending; /* Nodes not yet added (lazy mode) */
+#endif
 } UA_DataSetReader;
 
+enum ZIP_CMP
+cmpDataSetReaderKey(const UA_DataSetReaderKey *a, const UA_DataSetReaderKey *b);
+
+ZIP_FUNCTIONS(UA_DataSetReaderIndex, UA_DataSetReader, indexEntry,
+              UA_DataSetReaderKey, indexKey, cmpDataSetReaderKey)
+
 /* Process Network Message using DataSetReader */
 void
 UA_DataSetReader_process(UA_Server *server,
@@ -563,6 +706,13 @@ UA_DataSetReader_checkIdentifier(UA_Server *server, UA_NetworkMessage *msg,
                                  UA_DataSetReader *reader,
                                  UA_ReaderGroupConfig readerGroupConfig);
 
+/* Process a NetworkMessage only with the matching non-RT DataSetReaders from
+ * the index of the connection. Requires that the NetworkMessage contains the
+ * PublisherId, WriterGroupId and DataSetWriterIds. */
+UA_Boolean
+UA_DataSetReader_processIndexed(UA_Server *server, UA_PubSubConnection *c,
+                                UA_NetworkMessage *nm);
+
 UA_StatusCode
 UA_DataSetReader_create(UA_Server *server, UA_NodeId readerGroupIdentifier,
                         const UA_DataSetReaderConfig *dataSetReaderConfig,
@@ -631,6 +781,7 @@ struct UA_ReaderGroup {
     UA_NodeId identifier;
     UA_String logIdString;
     LIST_ENTRY(UA_ReaderGroup) listEntry;
+    UA_PubSubIndexEntry idEntry;
 
     LIST_HEAD(, UA_DataSetReader) readers;
     UA_UInt32 readersCount;
@@ -646,10 +797,24 @@ struct UA_ReaderGroup {
     size_t recvChannelsSize;
     UA_Boolean deleteFlag;
 
+#ifdef UA_ENABLE_PUBSUB_MONITORING
+    /* A single timer supervises the MessageReceiveTimeout of all readers. It
+     * fires at msgRcvTimeoutNextCheck, which is not later than the earliest
+     * deadline of the readers. */
+    UA_UInt64 msgRcvTimeoutTimerId;
+    UA_DateTime msgRcvTimeoutNextCheck;
+#endif
+
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+    /* The received headers are decoded into the arena of the ReaderGroup */
+    UA_PubSubArena arena;
+#endif
+
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
     UA_UInt32 securityTokenId;
     UA_UInt32 nonceSequenceNumber; /* To be part of the MessageNonce */
     void *securityPolicyContext;
+    void *retiredSecurityPolicyContext; /* Reused for the next key rollover */
 #ifdef UA_ENABLE_PUBSUB_SKS
     UA_PubSubKeyStorage *keyStorage;
 #endif
@@ -670,6 +835,13 @@ UA_ReaderGroup_connect(UA_Server *server, UA_ReaderGroup *rg, UA_Boolean validat
 void
 UA_ReaderGroup_disconnect(UA_ReaderGroup *rg);
 
+#ifdef UA_ENABLE_PUBSUB_MONITORING
+/* Remove the timer that supervises the MessageReceiveTimeout of the readers
+ * with the default monitoring callbacks */
+void
+UA_ReaderGroup_stopReceiveTimeoutCheck(UA_Server *server, UA_ReaderGroup *rg);
+#endif
+
 UA_StatusCode
 setReaderGroupEncryptionKeys(UA_Server *server, const UA_NodeId readerGroup,
                              UA_UInt32 securityTokenId,
@@ -703,6 +875,10 @@ UA_Boolean
 UA_ReaderGroup_decodeAndProcessRT(UA_Server *server, UA_ReaderGroup *readerGroup,
                                     UA_ByteString *buf);
 
+/* A message was received for the ReaderGroup */
+void
+UA_ReaderGroup_setReceived(UA_Server *server, UA_ReaderGroup *rg);
+
 UA_Boolean
 UA_ReaderGroup_process(UA_Server *server, UA_ReaderGroup *readerGroup,
                        UA_NetworkMessage *nm);
@@ -743,6 +919,23 @@ UA_StatusCode
 verifyAndDecryptNetworkMessage(const UA_Logger *logger, UA_ByteString *buffer,
                                size_t *currentPosition, UA_NetworkMessage *nm,
                                UA_ReaderGroup *readerGroup);
+
+/* Install new keys without touching the context that is currently in use. The
+ * keys are set in the retired context (or a new context is created). Then the
+ * active context pointer is swapped atomically. The RT publish path loads the
+ * active context once per message and never waits for a key rollover. The
+ * previous context is retired and only overwritten at the next rollover, a full
+ * key lifetime later. */
+UA_StatusCode
+rolloverSecurityKeys(const UA_PubSubSecurityPolicy *policy,
+                     void **activeContext, void **retiredContext,
+                     const UA_ByteString *signingKey,
+                     const UA_ByteString *encryptingKey,
+                     const UA_ByteString *keyNonce);
+
+void
+deleteSecurityContexts(const UA_PubSubSecurityPolicy *policy,
+                       void **activeContext, void **retiredContext);
 #endif
 
 /* Takes a value (and not a pointer) to the buffer. The original buffer is
@@ -832,6 +1025,12 @@ typedef struct UA_PubSubManager {
     size_t reserveIdsSize;
     UA_ReserveIdTree reserveIds;
 
+    /* All components by their NodeId */
+    UA_PubSubIndex componentIndex;
+
+    /* Set during the publish cycle of a UA_PubSubPublishSchedule */
+    UA_PubSubSampleTree *samples;
+
 #ifdef UA_ENABLE_PUBSUB_SKS
     LIST_HEAD(, UA_PubSubKeyStorage) pubSubKeyList;
 
@@ -839,6 +1038,12 @@ typedef struct UA_PubSubManager {
     TAILQ_HEAD(, UA_SecurityGroup) securityGroups;
 #endif
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    /* Writers and readers without nodes in the lazy information model */
+    size_t pendingRepresentations;
+    UA_Boolean materializing;
+#endif
+
 #ifndef UA_ENABLE_PUBSUB_INFORMATIONMODEL
     UA_UInt32 uniqueIdCount;
 #endif
@@ -856,6 +1061,21 @@ UA_PubSubManager_reserveIds(UA_Server *server, UA_NodeId sessionId, UA_UInt16 nu
 void
 UA_PubSubManager_freeIds(UA_Server *server);
 
+/* Add the component to the index. Call after its identifier is final. */
+void
+UA_PubSubManager_indexComponent(UA_PubSubManager *psm, UA_PubSubIndexEntry *entry,
+                                UA_PubSubIndexType type, const UA_NodeId *id,
+                                void *component);
+
+/* Ignored if the component is not indexed */
+void
+UA_PubSubManager_unindexComponent(UA_PubSubManager *psm, UA_PubSubIndexEntry *entry);
+
+/* Returns NULL if not found or if the component has a different type */
+void *
+UA_PubSubManager_findComponent(UA_PubSubManager *psm, UA_PubSubIndexType type,
+                               const UA_NodeId *id);
+
 void
 UA_PubSubManager_init(UA_Server *server, UA_PubSubManager *pubSubManager);
 
@@ -887,6 +1107,14 @@ UA_PubSubManager_getEncodedPubSubConfiguration(UA_Server *server,
 UA_Guid
 UA_PubSubManager_generateUniqueGuid(UA_Server *server);
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+/* Add the pending nodes of the lazy information model before the node is
+ * browsed. For a WriterGroup/ReaderGroup, the nodes of all its writers/readers
+ * are added. */
+void
+UA_PubSubManager_materializeNode(UA_Server *server, const UA_NodeId *nodeId);
+#endif
+
 UA_UInt32
 UA_PubSubConfigurationVersionTimeDifference(UA_DateTime now);
 
@@ -8,29 +8,48 @@
 #include "ua_pubsub_bufmalloc.h"
 #include <stdlib.h> /* for malloc, ...*/
 
-#define MALLOCMEMBUFSIZE 16384
+/* Every element has the memory layout [header (length) | buf (length * sizeof(char)) ... ].
+ * The header keeps the elements aligned for 64bit types. The pointer to buf is
+ * returned. */
+typedef union {
+    size_t length;
+    UA_UInt64 align64;
+    void *alignPtr;
+} ArenaHeader;
 
-/* If there are multiple PubSub threads the UA_MULTITHREADING build option needs to be set > 100
-    so that every thread has it's own thread-local memory buffer */
-static UA_THREAD_LOCAL char membuf[MALLOCMEMBUFSIZE];
-static UA_THREAD_LOCAL size_t pos;
+#define ARENA_ALIGN sizeof(ArenaHeader)
+
+/* The arena of the current thread. Set between _enter and _leave. */
+static UA_THREAD_LOCAL UA_PubSubArena *currentArena;
+
+static UA_Boolean
+inArena(const UA_PubSubArena *arena, const void *ptr) {
+    return ((uintptr_t)ptr >= (uintptr_t)arena->buf &&
+            (uintptr_t)ptr < (uintptr_t)arena->buf + arena->size);
+}
 
-/* Every element has the memory layout [length (size_t) | buf (length * sizeof(char)) ... ].
- * The pointer to buf is returned. */
 static void * membufMalloc(size_t size) {
-    if(pos + size + sizeof(size_t) > MALLOCMEMBUFSIZE)
+    UA_PubSubArena *arena = currentArena;
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if(aligned < size || arena->pos + aligned + ARENA_ALIGN > arena->size)
         return NULL;
-    char *begin = &membuf[pos];
-    *((size_t*)begin) = size;
-    pos += size + sizeof(size_t);
-    return &begin[sizeof(size_t)];
+    ArenaHeader *begin = (ArenaHeader*)&arena->buf[arena->pos];
+    begin->length = size;
+    arena->pos += aligned + ARENA_ALIGN;
+    return &begin[1];
 }
 
 static void membufFree(void *ptr) {
-    /* Don't do anyting */
+    /* Arena memory is released when the arena is reset. Memory from outside
+     * the arena (allocated before the arena was entered) is freed normally. */
+    UA_PubSubArena *arena = currentArena;
+    if(ptr && !inArena(arena, ptr))
+        arena->prevFree(ptr);
 }
 
 static void * membufCalloc(size_t nelem, size_t elsize) {
+    if(elsize > 0 && nelem > SIZE_MAX / elsize)
+        return NULL;
     size_t total = nelem * elsize;
     void *mem = membufMalloc(total);
     if(!mem)
@@ -40,36 +59,90 @@ static void * membufCalloc(size_t nelem, size_t elsize) {
 }
 
 static void * (membufRealloc)(void *ptr, size_t size) {
+    UA_PubSubArena *arena = currentArena;
+    if(ptr && !inArena(arena, ptr))
+        return arena->prevRealloc(ptr, size);
     size_t orig_size = 0;
-    if(ptr) {
-       orig_size = ((size_t*)ptr)[-1];
-    }
+    if(ptr)
+       orig_size = ((ArenaHeader*)ptr)[-1].length;
     if(size <= orig_size)
         return ptr;
     void *mem = membufMalloc(size);
     if(!mem)
         return NULL;
-    memcpy(mem, ptr, orig_size);
+    if(ptr)
+        memcpy(mem, ptr, orig_size);
     return mem;
 }
 
-void resetMembuf(void) {
-    pos = 0;
+UA_StatusCode
+UA_PubSubArena_init(UA_PubSubArena *arena, size_t size) {
+    memset(arena, 0, sizeof(UA_PubSubArena));
+    arena->buf = (char*)UA_malloc(size);
+    if(!arena->buf)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    arena->size = size;
+    return UA_STATUSCODE_GOOD;
 }
 
-/* Switch to memory allocation with static array */
-void useMembufAlloc(void) {
-    pos = 0;
+void
+UA_PubSubArena_clear(UA_PubSubArena *arena) {
+    UA_assert(currentArena != arena);
+    UA_free(arena->buf);
+    memset(arena, 0, sizeof(UA_PubSubArena));
+}
+
+void
+UA_PubSubArena_enter(UA_PubSubArena *arena) {
+    UA_assert(currentArena == NULL);
+    arena->pos = 0;
+    arena->prevMalloc = UA_mallocSingleton;
+    arena->prevFree = UA_freeSingleton;
+    arena->prevCalloc = UA_callocSingleton;
+    arena->prevRealloc = UA_reallocSingleton;
+    currentArena = arena;
     UA_mallocSingleton = membufMalloc;
     UA_freeSingleton = membufFree;
     UA_callocSingleton = membufCalloc;
     UA_reallocSingleton = membufRealloc;
 }
 
-/* Switch to normal memory allocation on heap */
+void
+UA_PubSubArena_leave(UA_PubSubArena *arena) {
+    UA_assert(currentArena == arena);
+    UA_mallocSingleton = arena->prevMalloc;
+    UA_freeSingleton = arena->prevFree;
+    UA_callocSingleton = arena->prevCalloc;
+    UA_reallocSingleton = arena->prevRealloc;
+    currentArena = NULL;
+}
+
+/* Legacy interface */
+
+#define MALLOCMEMBUFSIZE UA_PUBSUB_ARENASIZE
+
+/* If there are multiple PubSub threads the UA_MULTITHREADING build option needs to be set > 100
+    so that every thread has it's own thread-local memory buffer */
+static UA_THREAD_LOCAL ArenaHeader membuf[MALLOCMEMBUFSIZE / sizeof(ArenaHeader)];
+static UA_THREAD_LOCAL UA_PubSubArena membufArena;
+
+void resetMembuf(void) {
+    membufArena.pos = 0;
+}
+
+/* Switch to memory allocation with static array */
+void useMembufAlloc(void) {
+    if(currentArena == &membufArena) {
+        resetMembuf();
+        return;
+    }
+    membufArena.buf = (char*)membuf;
+    membufArena.size = sizeof(membuf);
+    UA_PubSubArena_enter(&membufArena);
+}
+
+/* Switch back to the allocation before useMembufAlloc */
 void useNormalAlloc(void) {
-    UA_mallocSingleton = malloc;
-    UA_freeSingleton = free;
-    UA_callocSingleton = calloc;
-    UA_reallocSingleton = realloc;
+    if(currentArena == &membufArena)
+        UA_PubSubArena_leave(&membufArena);
 }
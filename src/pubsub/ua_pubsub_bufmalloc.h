@@ -8,7 +8,7 @@
 #ifndef UA_PUBSUB_BUFMALLOC_H_
 #define UA_PUBSUB_BUFMALLOC_H_
 
-#include <open62541/config.h>
+#include <open62541/types.h>
 
 _UA_BEGIN_DECLS
 
@@ -16,10 +16,50 @@ _UA_BEGIN_DECLS
     This module provides a switch for memory allocation on heap or static array
     for faster memory operations */
 
+#define UA_PUBSUB_ARENASIZE 16384
+
+/* Bump allocator on a preallocated buffer. While an arena is entered, the
+ * allocator singletons of the current thread allocate from the arena. Memory
+ * that was not allocated in the arena is still freed with the previous
+ * allocator. The arena memory is released all at once when the arena is
+ * entered the next time.
+ *
+ * Every (ReaderGroup) thread uses its own arena. With UA_MULTITHREADING >= 100
+ * the allocator singletons are thread-local and the arenas of different
+ * threads can be used in parallel. */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t pos;
+
+    /* The allocators of the thread before the arena was entered */
+    void * (*prevMalloc)(size_t size);
+    void (*prevFree)(void *ptr);
+    void * (*prevCalloc)(size_t nelem, size_t elsize);
+    void * (*prevRealloc)(void *ptr, size_t size);
+} UA_PubSubArena;
+
+/* Allocates the arena buffer with the current allocator */
+UA_StatusCode
+UA_PubSubArena_init(UA_PubSubArena *arena, size_t size);
+
+void
+UA_PubSubArena_clear(UA_PubSubArena *arena);
+
+/* Reset the arena and allocate from it in the current thread */
+void
+UA_PubSubArena_enter(UA_PubSubArena *arena);
+
+/* Restore the previous allocators. The memory allocated in the arena remains
+ * valid until the arena is entered again. */
+void
+UA_PubSubArena_leave(UA_PubSubArena *arena);
+
+/* Legacy interface on a static thread-local arena */
 void resetMembuf(void);
 void useMembufAlloc(void);
 void useNormalAlloc(void);
 
 _UA_END_DECLS
 
-#endif /* UA_PUBSUB_BUFMALLOC_H_ */
\ No newline at end of file
+#endif /* UA_PUBSUB_BUFMALLOC_H_ */
@@ -0,0 +1,223 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_pubsub_compression.h"
+#include "server/ua_server_internal.h"
+
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+
+#include <zlib.h>
+
+/* Upper limit for the decompressed size. Protects against messages that expand
+ * to an excessive size. */
+#define UA_PUBSUB_COMPRESSION_MAXSIZE (1u << 24)
+
+/* Common keys of the JSON NetworkMessage. The field names are appended. The
+ * deflate window prefers recent matches, so the content specific to the
+ * DataSetMetaData comes last. */
+static const char *dictionaryPrefix =
+    "{\"MessageId\":\"\",\"MessageType\":\"ua-data\",\"PublisherId\":\"\","
+    "\"DataSetClassId\":\"\",\"Messages\":[{\"DataSetWriterId\":,"
+    "\"SequenceNumber\":,\"MetaDataVersion\":{\"MajorVersion\":,"
+    "\"MinorVersion\":},\"Timestamp\":\"\",\"Status\":,"
+    "\"MessageType\":\"ua-keyframe\",\"Payload\":{";
+
+static const char *dictionaryField =
+    "\":{\"Type\":,\"Body\":},\"Value\":,\"SourceTimestamp\":\"\","
+    "\"ServerTimestamp\":\"\",\"";
+
+UA_StatusCode
+UA_PubSub_compressionDictionary(const UA_DataSetMetaDataType *metaData,
+                                UA_ByteString *dict) {
+    size_t prefixLen = strlen(dictionaryPrefix);
+    size_t fieldLen = strlen(dictionaryField);
+    size_t len = prefixLen + 1;
+    for(size_t i = 0; i < metaData->fieldsSize; i++)
+        len += metaData->fields[i].name.length + fieldLen;
+
+    UA_StatusCode res = UA_ByteString_allocBuffer(dict, len);
+    UA_CHECK_STATUS(res, return res);
+
+    UA_Byte *pos = dict->data;
+    memcpy(pos, dictionaryPrefix, prefixLen);
+    pos += prefixLen;
+    *pos++ = '"';
+    for(size_t i = 0; i < metaData->fieldsSize; i++) {
+        const UA_String *name = &metaData->fields[i].name;
+        if(name->length > 0)
+            memcpy(pos, name->data, name->length);
+        pos += name->length;
+        memcpy(pos, dictionaryField, fieldLen);
+        pos += fieldLen;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_Boolean
+UA_WriterGroup_compressionEnabled(const UA_WriterGroup *wg) {
+    const UA_Variant *compression =
+        UA_KeyValueMap_get(&wg->config.groupProperties,
+                           UA_QUALIFIEDNAME(0, "compression"));
+    if(!compression || !UA_Variant_hasScalarType(compression, &UA_TYPES[UA_TYPES_STRING]))
+        return false;
+    UA_String deflate = UA_STRING("deflate");
+    return UA_String_equal((const UA_String*)compression->data, &deflate);
+}
+
+static UA_DataSetWriter *
+findWriter(UA_WriterGroup *wg, UA_UInt16 dataSetWriterId) {
+    UA_DataSetWriter *dsw;
+    LIST_FOREACH(dsw, &wg->writers, listEntry) {
+        if(dsw->config.dataSetWriterId == dataSetWriterId)
+            return dsw;
+    }
+    return NULL;
+}
+
+UA_StatusCode
+UA_WriterGroup_compress(UA_Server *server, UA_WriterGroup *wg,
+                        UA_UInt16 dataSetWriterId,
+                        const UA_ByteString *msg, UA_ByteString *out) {
+    /* Get the dictionary from the DataSetMetaData */
+    UA_ByteString dict = UA_BYTESTRING_NULL;
+    UA_DataSetWriter *dsw = findWriter(wg, dataSetWriterId);
+    UA_PublishedDataSet *pds = (dsw) ?
+        UA_PublishedDataSet_findPDSbyId(server, dsw->connectedDataSet) : NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(pds) {
+        res = UA_PubSub_compressionDictionary(&pds->dataSetMetaData, &dict);
+        UA_CHECK_STATUS(res, return res);
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(z_stream));
+    if(deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        UA_ByteString_clear(&dict);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    if(dict.length > 0 &&
+       deflateSetDictionary(&strm, dict.data, (uInt)dict.length) != Z_OK) {
+        res = UA_STATUSCODE_BADINTERNALERROR;
+        goto cleanup;
+    }
+
+    /* Single pass into a buffer of the worst-case size */
+    res = UA_ByteString_allocBuffer(out, deflateBound(&strm, (uLong)msg->length));
+    UA_CHECK_STATUS(res, goto cleanup);
+    strm.next_in = msg->data;
+    strm.avail_in = (uInt)msg->length;
+    strm.next_out = out->data;
+    strm.avail_out = (uInt)out->length;
+    if(deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+        UA_ByteString_clear(out);
+        res = UA_STATUSCODE_BADENCODINGERROR;
+        goto cleanup;
+    }
+    out->length = strm.total_out;
+
+ cleanup:
+    deflateEnd(&strm);
+    UA_ByteString_clear(&dict);
+    return res;
+}
+
+UA_Boolean
+UA_PubSub_isCompressed(const UA_ByteString *msg) {
+    /* Deflate with a window of up to 32kB (CMF) and the header checksum */
+    return (msg->length >= 2 && (msg->data[0] & 0x0f) == Z_DEFLATED &&
+            (msg->data[0] >> 4) <= 7 &&
+            ((msg->data[0] << 8) | msg->data[1]) % 31 == 0);
+}
+
+/* Find the dictionary of a DataSetReader with the given Adler-32 checksum */
+static UA_StatusCode
+findDictionary(UA_PubSubConnection *c, uLong dictId, UA_ByteString *dict) {
+    UA_ReaderGroup *rg;
+    UA_DataSetReader *dsr;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        LIST_FOREACH(dsr, &rg->readers, listEntry) {
+            UA_StatusCode res =
+                UA_PubSub_compressionDictionary(&dsr->config.dataSetMetaData, dict);
+            UA_CHECK_STATUS(res, return res);
+            if(adler32(adler32(0L, Z_NULL, 0), dict->data, (uInt)dict->length) == dictId)
+                return UA_STATUSCODE_GOOD;
+            UA_ByteString_clear(dict);
+        }
+    }
+    return UA_STATUSCODE_BADNOTFOUND;
+}
+
+UA_StatusCode
+UA_PubSubConnection_decompress(UA_PubSubConnection *c, const UA_ByteString *msg,
+                               UA_ByteString *out) {
+    z_stream strm;
+    memset(&strm, 0, sizeof(z_stream));
+    if(inflateInit(&strm) != Z_OK)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Start with four times the compressed size and grow as needed */
+    UA_StatusCode res = UA_ByteString_allocBuffer(out, msg->length * 4);
+    UA_CHECK_STATUS(res, goto cleanup);
+    strm.next_in = msg->data;
+    strm.avail_in = (uInt)msg->length;
+    strm.next_out = out->data;
+    strm.avail_out = (uInt)out->length;
+
+    while(true) {
+        int ret = inflate(&strm, Z_NO_FLUSH);
+        if(ret == Z_STREAM_END)
+            break;
+
+        /* Set the preset dictionary and continue */
+        if(ret == Z_NEED_DICT) {
+            UA_ByteString dict;
+            res = findDictionary(c, strm.adler, &dict);
+            UA_CHECK_STATUS(res, goto cleanup);
+            ret = inflateSetDictionary(&strm, dict.data, (uInt)dict.length);
+            UA_ByteString_clear(&dict);
+            if(ret != Z_OK) {
+                res = UA_STATUSCODE_BADDECODINGERROR;
+                goto cleanup;
+            }
+            continue;
+        }
+
+        if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
+
+        /* Truncated message */
+        if(strm.avail_out > 0) {
+            res = UA_STATUSCODE_BADDECODINGERROR;
+            goto cleanup;
+        }
+
+        /* Grow the output buffer */
+        size_t newLength = out->length * 2;
+        if(newLength > UA_PUBSUB_COMPRESSION_MAXSIZE) {
+            res = UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            goto cleanup;
+        }
+        UA_Byte *newData = (UA_Byte*)UA_realloc(out->data, newLength);
+        if(!newData) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            goto cleanup;
+        }
+        out->data = newData;
+        strm.next_out = &out->data[out->length];
+        strm.avail_out = (uInt)(newLength - out->length);
+        out->length = newLength;
+    }
+    out->length = strm.total_out;
+
+ cleanup:
+    inflateEnd(&strm);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_ByteString_clear(out);
+    return res;
+}
+
+#endif /* UA_ENABLE_PUBSUB_COMPRESSION */
@@ -0,0 +1,60 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef UA_PUBSUB_COMPRESSION_H_
+#define UA_PUBSUB_COMPRESSION_H_
+
+#include "ua_pubsub.h"
+
+_UA_BEGIN_DECLS
+
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+
+/* Compression of JSON NetworkMessages
+ * -----------------------------------
+ * The JSON encoding repeats the same keys and field names in every message.
+ * With the groupProperty "compression" set to "deflate", the WriterGroup
+ * compresses its JSON NetworkMessages in the zlib format. The preset dictionary
+ * is generated from the DataSetMetaData of the (first) DataSetWriter in the
+ * message. Then also small messages compress well.
+ *
+ * The zlib stream carries the Adler-32 checksum of the preset dictionary. The
+ * subscriber detects compressed messages from the zlib header. It selects the
+ * dictionary from the DataSetReader whose DataSetMetaData has the same
+ * checksum. */
+
+/* Preset dictionary with the common keys of the JSON NetworkMessage and the
+ * field names of the DataSetMetaData */
+UA_StatusCode
+UA_PubSub_compressionDictionary(const UA_DataSetMetaDataType *metaData,
+                                UA_ByteString *dict);
+
+/* Is "compression" = "deflate" set in the groupProperties? */
+UA_Boolean
+UA_WriterGroup_compressionEnabled(const UA_WriterGroup *wg);
+
+/* Compress the encoded message with the dictionary of the DataSetWriter with
+ * the given id. The output is allocated. */
+UA_StatusCode
+UA_WriterGroup_compress(UA_Server *server, UA_WriterGroup *wg,
+                        UA_UInt16 dataSetWriterId,
+                        const UA_ByteString *msg, UA_ByteString *out);
+
+/* Does the message start with a zlib header? JSON begins with '{' or
+ * whitespace. */
+UA_Boolean
+UA_PubSub_isCompressed(const UA_ByteString *msg);
+
+/* Decompress a message with the dictionaries of the DataSetReaders of the
+ * connection. The output is allocated. */
+UA_StatusCode
+UA_PubSubConnection_decompress(UA_PubSubConnection *c, const UA_ByteString *msg,
+                               UA_ByteString *out);
+
+#endif /* UA_ENABLE_PUBSUB_COMPRESSION */
+
+_UA_END_DECLS
+
+#endif /* UA_PUBSUB_COMPRESSION_H_ */
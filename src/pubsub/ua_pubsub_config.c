@@ -12,22 +12,33 @@
 #include "pubsub/ua_pubsub.h"
 #include "server/ua_server_internal.h"
 
+/* The PublishedDataSets are referenced by name from the DataSetWriters. They
+ * are indexed by name once for the entire configuration. */
+typedef struct {
+    const UA_String *name;
+    size_t index; /* In the configuration */
+} PublishedDataSetRef;
+
+typedef struct {
+    size_t pdsCount;
+    PublishedDataSetRef *pdsRefs; /* Sorted by name */
+    UA_NodeId *pdsIdent;          /* In the order of the configuration */
+} ConfigContext;
+
 static UA_StatusCode
 createPubSubConnection(UA_Server *server,
                        const UA_PubSubConnectionDataType *connection,
-                       UA_UInt32 pdsCount, UA_NodeId *pdsIdent);
+                       const ConfigContext *ctx);
 
 static UA_StatusCode
 createWriterGroup(UA_Server *server,
                   const UA_WriterGroupDataType *writerGroupParameters,
-                  UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                  const UA_NodeId *pdsIdent);
+                  UA_NodeId connectionIdent, const ConfigContext *ctx);
 
 static UA_StatusCode
 createDataSetWriter(UA_Server *server,
                     const UA_DataSetWriterDataType *dataSetWriterParameters,
-                    UA_NodeId writerGroupIdent, UA_UInt32 pdsCount,
-                    const UA_NodeId *pdsIdent);
+                    UA_NodeId writerGroupIdent, const ConfigContext *ctx);
 
 static UA_StatusCode
 createReaderGroup(UA_Server *server,
@@ -86,6 +97,138 @@ extractPubSubConfigFromExtensionObject(UA_Server *server,
     return UA_STATUSCODE_GOOD;
 }
 
+static int
+cmpPublishedDataSetRef(const void *a, const void *b) {
+    const PublishedDataSetRef *aa = (const PublishedDataSetRef*)a;
+    const PublishedDataSetRef *bb = (const PublishedDataSetRef*)b;
+    UA_Order o = UA_order(aa->name, bb->name, &UA_TYPES[UA_TYPES_STRING]);
+    if(o != UA_ORDER_EQ)
+        return (int)o;
+    /* The first PublishedDataSet with the name is used */
+    if(aa->index != bb->index)
+        return (aa->index < bb->index) ? -1 : 1;
+    return 0;
+}
+
+/* Returns the index of the first PublishedDataSet with the name in the
+ * configuration or ctx->pdsCount if not found */
+static size_t
+findPublishedDataSet(const ConfigContext *ctx, const UA_String *name) {
+    size_t lo = 0, hi = ctx->pdsCount;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(UA_order(ctx->pdsRefs[mid].name, name,
+                    &UA_TYPES[UA_TYPES_STRING]) == UA_ORDER_LESS)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if(lo < ctx->pdsCount && UA_String_equal(ctx->pdsRefs[lo].name, name))
+        return ctx->pdsRefs[lo].index;
+    return ctx->pdsCount;
+}
+
+static UA_StatusCode
+setConnectionPublisherId(UA_Server *server,
+                         const UA_PubSubConnectionDataType *src,
+                         UA_PubSubConnectionConfig *dst);
+
+static UA_StatusCode
+setWriterGroupEncodingType(UA_Server *server,
+                           const UA_WriterGroupDataType *writerGroupParameters,
+                           UA_WriterGroupConfig *config);
+
+static UA_StatusCode
+setPublishedDataSetType(UA_Server *server,
+                        const UA_PublishedDataSetDataType *pdsParams,
+                        UA_PublishedDataSetConfig *config);
+
+/* Validate the entire configuration before the current configuration is
+ * replaced. So that an invalid configuration is not partially applied. */
+static UA_StatusCode
+validatePubSubConfig(UA_Server *server,
+                     const UA_PubSubConfigurationDataType *cfg) {
+    for(size_t i = 0; i < cfg->publishedDataSetsSize; i++) {
+        const UA_PublishedDataSetDataType *pdsParams = &cfg->publishedDataSets[i];
+        UA_PublishedDataSetConfig pdsConfig;
+        memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+        UA_StatusCode res = setPublishedDataSetType(server, pdsParams, &pdsConfig);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        const UA_PublishedDataItemsDataType *pdItems = (const UA_PublishedDataItemsDataType*)
+            pdsParams->dataSetSource.content.decoded.data;
+        if(pdItems->publishedDataSize != pdsParams->dataSetMetaData.fieldsSize) {
+            UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                         "[UA_PubSubManager_validatePubSubConfig] The PublishedDataSet "
+                         "%.*s has a different number of fields and metadata fields",
+                         (int)pdsParams->name.length, (char*)pdsParams->name.data);
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+
+    for(size_t i = 0; i < cfg->connectionsSize; i++) {
+        const UA_PubSubConnectionDataType *connParams = &cfg->connections[i];
+        UA_PubSubConnectionConfig connConfig;
+        memset(&connConfig, 0, sizeof(UA_PubSubConnectionConfig));
+        UA_StatusCode res = setConnectionPublisherId(server, connParams, &connConfig);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+        if(connParams->address.encoding != UA_EXTENSIONOBJECT_DECODED) {
+            UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                         "[UA_PubSubManager_validatePubSubConfig] "
+                         "Reading connection address failed");
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+
+        for(size_t j = 0; j < connParams->writerGroupsSize; j++) {
+            UA_WriterGroupConfig wgConfig;
+            memset(&wgConfig, 0, sizeof(UA_WriterGroupConfig));
+            res = setWriterGroupEncodingType(server, &connParams->writerGroups[j],
+                                             &wgConfig);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+        }
+
+        for(size_t j = 0; j < connParams->readerGroupsSize; j++) {
+            const UA_ReaderGroupDataType *rgParams = &connParams->readerGroups[j];
+            for(size_t k = 0; k < rgParams->dataSetReadersSize; k++) {
+                const UA_ExtensionObject *sds = &rgParams->dataSetReaders[k].subscribedDataSet;
+                if(sds->encoding != UA_EXTENSIONOBJECT_DECODED ||
+                   sds->content.decoded.type != &UA_TYPES[UA_TYPES_TARGETVARIABLESDATATYPE]) {
+                    UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                                 "[UA_PubSubManager_validatePubSubConfig] Only "
+                                 "TargetVariables are supported for the SubscribedDataSet");
+                    return UA_STATUSCODE_BADINVALIDARGUMENT;
+                }
+            }
+        }
+    }
+
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Enable all groups in one pass after all components are created. So that
+ * the groups do not go operational while their readers and writers are still
+ * being added. */
+static void
+enablePubSubGroups(UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    UA_PubSubConnection *c;
+    TAILQ_FOREACH(c, &server->pubSubManager.connections, listEntry) {
+        if(c->deleteFlag)
+            continue;
+        UA_WriterGroup *wg;
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            UA_WriterGroup_setPubSubState(server, wg, UA_PUBSUBSTATE_OPERATIONAL);
+        }
+        UA_ReaderGroup *rg;
+        LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+            UA_ReaderGroup_setPubSubState(server, rg, UA_PUBSUBSTATE_OPERATIONAL);
+        }
+    }
+}
+
 /* Configures a PubSub Server with given PubSubConfigurationDataType object */
 static UA_StatusCode
 updatePubSubConfig(UA_Server *server,
@@ -98,25 +241,42 @@ updatePubSubConfig(UA_Server *server,
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
 
-    UA_PubSubManager_delete(server, &server->pubSubManager);
+    UA_StatusCode res = validatePubSubConfig(server, configurationParameters);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "[UA_PubSubManager_updatePubSubConfig] Invalid configuration, "
+                     "the current configuration is kept");
+        return res;
+    }
 
-    /* Configuration of Published DataSets: */
-    UA_UInt32 pdsCount = (UA_UInt32)configurationParameters->publishedDataSetsSize;
-    UA_NodeId *publishedDataSetIdent = (UA_NodeId*)UA_calloc(pdsCount, sizeof(UA_NodeId));
-    if(!publishedDataSetIdent)
+    /* Index the PublishedDataSets by name */
+    ConfigContext ctx;
+    ctx.pdsCount = configurationParameters->publishedDataSetsSize;
+    ctx.pdsRefs = (PublishedDataSetRef*)
+        UA_calloc(ctx.pdsCount + 1, sizeof(PublishedDataSetRef));
+    ctx.pdsIdent = (UA_NodeId*)UA_calloc(ctx.pdsCount + 1, sizeof(UA_NodeId));
+    if(!ctx.pdsRefs || !ctx.pdsIdent) {
+        UA_free(ctx.pdsRefs);
+        UA_free(ctx.pdsIdent);
         return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0; i < ctx.pdsCount; i++) {
+        ctx.pdsRefs[i].name = &configurationParameters->publishedDataSets[i].name;
+        ctx.pdsRefs[i].index = i;
+    }
+    qsort(ctx.pdsRefs, ctx.pdsCount, sizeof(PublishedDataSetRef), cmpPublishedDataSetRef);
 
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_PubSubManager_delete(server, &server->pubSubManager);
 
-    for(UA_UInt32 i = 0; i < pdsCount; i++) {
+    /* Configuration of Published DataSets: */
+    for(size_t i = 0; i < ctx.pdsCount; i++) {
         res = createPublishedDataSet(server,
                                      &configurationParameters->publishedDataSets[i],
-                                     &publishedDataSetIdent[i]);
+                                     &ctx.pdsIdent[i]);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                          "[UA_PubSubManager_updatePubSubConfig] PDS creation failed");
-            UA_free(publishedDataSetIdent);
-            return res;
+            goto cleanup;
         }
     }
 
@@ -125,20 +285,22 @@ updatePubSubConfig(UA_Server *server,
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
                        "[UA_PubSubManager_updatePubSubConfig] no connection in "
                        "UA_PubSubConfigurationDataType");
-        UA_free(publishedDataSetIdent);
-        return UA_STATUSCODE_GOOD;
+        goto cleanup;
     }
 
     for(size_t i = 0; i < configurationParameters->connectionsSize; i++) {
         res = createPubSubConnection(server,
-                                     &configurationParameters->connections[i],
-                                     pdsCount, publishedDataSetIdent);
+                                     &configurationParameters->connections[i], &ctx);
         if(res != UA_STATUSCODE_GOOD)
             break;
     }
 
-    UA_free(publishedDataSetIdent);
+    if(res == UA_STATUSCODE_GOOD)
+        enablePubSubGroups(server);
 
+ cleanup:
+    UA_free(ctx.pdsRefs);
+    UA_Array_delete(ctx.pdsIdent, ctx.pdsCount, &UA_TYPES[UA_TYPES_NODEID]);
     return res;
 }
 
@@ -176,15 +338,14 @@ setConnectionPublisherId(UA_Server *server,
 static UA_StatusCode
 createComponentsForConnection(UA_Server *server,
                               const UA_PubSubConnectionDataType *connParams,
-                              UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                              const UA_NodeId *pdsIdent) {
+                              UA_NodeId connectionIdent, const ConfigContext *ctx) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* WriterGroups configuration */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     for(size_t i = 0; i < connParams->writerGroupsSize; i++) {
         res = createWriterGroup(server, &connParams->writerGroups[i],
-                                connectionIdent, pdsCount, pdsIdent);
+                                connectionIdent, ctx);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                          "[UA_PubSubManager_createComponentsForConnection] "
@@ -211,11 +372,10 @@ createComponentsForConnection(UA_Server *server,
  *
  * @param server Server object that shall be configured
  * @param connParams PubSub connection configuration
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param ctx Index of the published DataSets */
 static UA_StatusCode
 createPubSubConnection(UA_Server *server, const UA_PubSubConnectionDataType *connParams,
-                       UA_UInt32 pdsCount, UA_NodeId *pdsIdent) {
+                       const ConfigContext *ctx) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_PubSubConnectionConfig config;
@@ -261,8 +421,7 @@ createPubSubConnection(UA_Server *server, const UA_PubSubConnectionDataType *con
     res = UA_PubSubConnection_create(server, &config, &connectionIdent);
     if(res == UA_STATUSCODE_GOOD) {
         /* Configuration of all Components that belong to this connection: */
-        res = createComponentsForConnection(server, connParams, connectionIdent,
-                                            pdsCount, pdsIdent);
+        res = createComponentsForConnection(server, connParams, connectionIdent, ctx);
     } else {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "[UA_PubSubManager_createPubSubConnection] "
@@ -309,13 +468,11 @@ setWriterGroupEncodingType(UA_Server *server,
  * @param server Server object that shall be configured
  * @param writerGroupParameters WriterGroup configuration
  * @param connectionIdent NodeId of the PubSub connection, the WriterGroup belongs to
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param ctx Index of the published DataSets */
 static UA_StatusCode
 createWriterGroup(UA_Server *server,
                   const UA_WriterGroupDataType *writerGroupParameters,
-                  UA_NodeId connectionIdent, UA_UInt32 pdsCount,
-                  const UA_NodeId *pdsIdent) {
+                  UA_NodeId connectionIdent, const ConfigContext *ctx) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_WriterGroupConfig config;
@@ -344,9 +501,6 @@ createWriterGroup(UA_Server *server,
     /* Load config into server: */
     UA_NodeId writerGroupIdent;
     res = UA_WriterGroup_create(server, connectionIdent, &config, &writerGroupIdent);
-    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroupIdent);
-    if(wg)
-        UA_WriterGroup_setPubSubState(server, wg, UA_PUBSUBSTATE_OPERATIONAL);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "[UA_PubSubManager_createWriterGroup] "
@@ -357,7 +511,7 @@ createWriterGroup(UA_Server *server,
     /* Configuration of all DataSetWriters that belong to this WriterGroup */
     for(size_t dsw = 0; dsw < writerGroupParameters->dataSetWritersSize; dsw++) {
         res = createDataSetWriter(server, &writerGroupParameters->dataSetWriters[dsw],
-                                  writerGroupIdent, pdsCount, pdsIdent);
+                                  writerGroupIdent, ctx);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                          "[UA_PubSubManager_createWriterGroup] "
@@ -375,56 +529,31 @@ createWriterGroup(UA_Server *server,
  * @param server UA_Server object that shall be configured
  * @param writerGroupIdent NodeId of writerGroup, the DataSetWriter belongs to
  * @param dsWriterConfig WriterGroup configuration
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param ctx Index of the published DataSets */
 static UA_StatusCode
 addDataSetWriterWithPdsReference(UA_Server *server, UA_NodeId writerGroupIdent,
                                  const UA_DataSetWriterConfig *dsWriterConfig,
-                                 UA_UInt32 pdsCount, const UA_NodeId *pdsIdent) {
+                                 const ConfigContext *ctx) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    UA_NodeId dataSetWriterIdent;
-    UA_PublishedDataSetConfig pdsConfig;
-    UA_Boolean pdsFound = false;
-
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
-    for(size_t pds = 0; pds < pdsCount && res == UA_STATUSCODE_GOOD; pds++) {
-        res = getPublishedDataSetConfig(server, pdsIdent[pds], &pdsConfig);
-        /* members of pdsConfig must be deleted manually */
-        if(res != UA_STATUSCODE_GOOD) {
-            UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
-                         "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
-                         "Getting pdsConfig from NodeId failed.");
-            return res;
-        }
-
-        if(dsWriterConfig->dataSetName.length == pdsConfig.name.length &&
-           0 == strncmp((const char *)dsWriterConfig->dataSetName.data,
-                        (const char *)pdsConfig.name.data,
-                        dsWriterConfig->dataSetName.length)) {
-            /* DSWriter will only be created, if a matching PDS is found: */
-            res = UA_DataSetWriter_create(server, writerGroupIdent, pdsIdent[pds],
-                                          dsWriterConfig, &dataSetWriterIdent);
-            if(res != UA_STATUSCODE_GOOD) {
-                UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
-                             "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
-                             "Adding DataSetWriter failed");
-            } else {
-                pdsFound = true;
-            }
-
-            UA_PublishedDataSetConfig_clear(&pdsConfig);
-            if(pdsFound)
-                break; /* break loop if corresponding publishedDataSet was found */
-        }
-    }
-
-    if(!pdsFound) {
+    size_t pds = findPublishedDataSet(ctx, &dsWriterConfig->dataSetName);
+    if(pds == ctx->pdsCount) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
                      "No matching DataSet found; no DataSetWriter created");
+        return UA_STATUSCODE_GOOD;
     }
 
+    /* DSWriter will only be created, if a matching PDS is found: */
+    UA_NodeId dataSetWriterIdent;
+    UA_StatusCode res =
+        UA_DataSetWriter_create(server, writerGroupIdent, ctx->pdsIdent[pds],
+                                dsWriterConfig, &dataSetWriterIdent);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "[UA_PubSubManager_addDataSetWriterWithPdsReference] "
+                     "Adding DataSetWriter failed");
+    }
     return res;
 }
 
@@ -433,13 +562,11 @@ addDataSetWriterWithPdsReference(UA_Server *server, UA_NodeId writerGroupIdent,
  * @param server UA_Server object that shall be configured
  * @param dataSetWriterParameters DataSetWriter Configuration
  * @param writerGroupIdent NodeId of writerGroup, the DataSetWriter belongs to
- * @param pdsCount Number of published DataSets
- * @param pdsIdent Array of NodeIds of the published DataSets */
+ * @param ctx Index of the published DataSets */
 static UA_StatusCode
 createDataSetWriter(UA_Server *server,
                     const UA_DataSetWriterDataType *dataSetWriterParameters,
-                    UA_NodeId writerGroupIdent, UA_UInt32 pdsCount,
-                    const UA_NodeId *pdsIdent) {
+                    UA_NodeId writerGroupIdent, const ConfigContext *ctx) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_DataSetWriterConfig config;
@@ -454,7 +581,7 @@ createDataSetWriter(UA_Server *server,
     config.dataSetWriterProperties.map = dataSetWriterParameters->dataSetWriterProperties;
 
     UA_StatusCode res = addDataSetWriterWithPdsReference(server, writerGroupIdent,
-                                                         &config, pdsCount, pdsIdent);
+                                                         &config, ctx);
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "[UA_PubSubManager_createDataSetWriter] "
@@ -503,10 +630,6 @@ createReaderGroup(UA_Server *server,
         }
     }
 
-    UA_ReaderGroup *rg = UA_ReaderGroup_findRGbyId(server, readerGroupIdent);
-    if(res == UA_STATUSCODE_GOOD && rg)
-        UA_ReaderGroup_setPubSubState(server, rg, UA_PUBSUBSTATE_OPERATIONAL);
-
     return res;
 }
 
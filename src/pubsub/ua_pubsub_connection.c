@@ -17,6 +17,10 @@
 #include "ua_pubsub_ns0.h"
 #endif
 
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+#include "ua_pubsub_compression.h"
+#endif
+
 #ifdef UA_ENABLE_PUBSUB /* conditional compilation */
 
 UA_StatusCode
@@ -131,12 +135,9 @@ UA_Server_getPubSubConnectionConfig(UA_Server *server, const UA_NodeId connectio
 
 UA_PubSubConnection *
 UA_PubSubConnection_findConnectionbyId(UA_Server *server, UA_NodeId connectionIdentifier) {
-    UA_PubSubConnection *pubSubConnection;
-    TAILQ_FOREACH(pubSubConnection, &server->pubSubManager.connections, listEntry){
-        if(UA_NodeId_equal(&connectionIdentifier, &pubSubConnection->identifier))
-            break;
-    }
-    return pubSubConnection;
+    return (UA_PubSubConnection*)
+        UA_PubSubManager_findComponent(&server->pubSubManager, UA_PUBSUBINDEX_CONNECTION,
+                                       &connectionIdentifier);
 }
 
 void
@@ -182,6 +183,8 @@ UA_PubSubConnection_create(UA_Server *server, const UA_PubSubConnectionConfig *c
     UA_PubSubManager *pubSubManager = &server->pubSubManager;
     TAILQ_INSERT_HEAD(&pubSubManager->connections, c, listEntry);
     pubSubManager->connectionsSize++;
+    UA_PubSubManager_indexComponent(pubSubManager, &c->idEntry,
+                                    UA_PUBSUBINDEX_CONNECTION, &c->identifier, c);
 
     /* Cache the log string */
     UA_String idStr = UA_STRING_NULL;
@@ -237,6 +240,131 @@ delayedPubSubConnection_delete(void *application, void *context) {
     UA_UNLOCK(&server->serviceMutex);
 }
 
+static void
+clearDecodeTemplate(UA_PubSubDecodeTemplate *t) {
+    UA_NetworkMessageOffsetBuffer_clear(&t->offsetBuffer);
+    UA_ByteString_clear(&t->layout);
+    memset(t, 0, sizeof(UA_PubSubDecodeTemplate));
+}
+
+/* The message has the layout of the template if it has the same length and
+ * all bytes are identical, except for the sequence numbers, timestamps and
+ * status at the known offsets and the payload fields. The sizes of the payload
+ * fields are checked during the offset-based decoding. */
+static UA_Boolean
+matchDecodeTemplate(const UA_PubSubDecodeTemplate *t, const UA_ByteString *msg) {
+    if(!t->offsetBuffer.nm || msg->length != t->layout.length)
+        return false;
+    size_t pos = 0;
+    size_t end = msg->length;
+    for(size_t i = 0; i < t->offsetBuffer.offsetsSize; i++) {
+        const UA_NetworkMessageOffset *o = &t->offsetBuffer.offsets[i];
+        size_t len;
+        switch(o->contentType) {
+        case UA_PUBSUB_OFFSETTYPE_NETWORKMESSAGE_SEQUENCENUMBER:
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+        case UA_PUBSUB_OFFSETTYPE_TIMESTAMP_PICOSECONDS:
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS:
+            len = 2;
+            break;
+        case UA_PUBSUB_OFFSETTYPE_TIMESTAMP:
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP:
+            len = 8;
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE:
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT:
+            end = o->offset; /* The payload follows until the end */
+            goto compare_rest;
+        default:
+            continue; /* Static content */
+        }
+        if(o->offset < pos || o->offset + len > msg->length ||
+           memcmp(&msg->data[pos], &t->layout.data[pos], o->offset - pos) != 0)
+            return false;
+        pos = o->offset + len;
+    }
+
+ compare_rest:
+    return (pos <= end &&
+            memcmp(&msg->data[pos], &t->layout.data[pos], end - pos) == 0);
+}
+
+/* Only plain DataSetMessages with a single KeyFrame can be decoded at fixed
+ * offsets. RawData fields need the DataSetMetaData of a Reader. */
+static UA_Boolean
+canUseDecodeTemplate(const UA_NetworkMessage *nm) {
+    if(nm->networkMessageType != UA_NETWORKMESSAGE_DATASET ||
+       nm->securityEnabled || nm->chunkMessage || nm->promotedFieldsEnabled ||
+       (nm->publisherIdEnabled && nm->publisherIdType == UA_PUBLISHERIDTYPE_STRING))
+        return false;
+    if(nm->payloadHeaderEnabled && nm->payloadHeader.dataSetPayloadHeader.count != 1)
+        return false;
+    const UA_DataSetMessage *dsm = nm->payload.dataSetPayload.dataSetMessages;
+    return (dsm && dsm->header.dataSetMessageValid &&
+            dsm->header.dataSetMessageType == UA_DATASETMESSAGE_DATAKEYFRAME &&
+            dsm->header.fieldEncoding != UA_FIELDENCODING_RAWDATA &&
+            !dsm->header.picoSecondsIncluded && dsm->data.keyFrameData.fieldCount > 0);
+}
+
+/* Take over the decoded NetworkMessage as a new template. Replaces the
+ * template with the fewest matches. */
+static void
+addDecodeTemplate(UA_PubSubConnection *c, UA_NetworkMessage *nm,
+                  const UA_ByteString *msg) {
+    if(!canUseDecodeTemplate(nm))
+        return;
+
+    UA_PubSubDecodeTemplate *t = &c->decodeTemplates[0];
+    for(size_t i = 1; i < UA_PUBSUB_DECODETEMPLATES; i++) {
+        if(c->decodeTemplates[i].matches < t->matches)
+            t = &c->decodeTemplates[i];
+    }
+
+    UA_NetworkMessage *tnm = (UA_NetworkMessage*)UA_malloc(sizeof(UA_NetworkMessage));
+    if(!tnm)
+        return;
+    clearDecodeTemplate(t);
+    *tnm = *nm;
+    memset(nm, 0, sizeof(UA_NetworkMessage)); /* Moved to the template */
+    t->offsetBuffer.nm = tnm;
+
+    size_t size = UA_NetworkMessage_calcSizeBinary(tnm, &t->offsetBuffer);
+    UA_StatusCode res = UA_ByteString_copy(msg, &t->layout);
+    if(size != msg->length || res != UA_STATUSCODE_GOOD)
+        clearDecodeTemplate(t);
+}
+
+/* Decode at the offsets of a stable template. Returns the NetworkMessage of
+ * the template or NULL if the full decoding is required. */
+static UA_NetworkMessage *
+decodeWithTemplate(UA_PubSubConnection *c, const UA_ByteString *msg) {
+#ifdef UA_ENABLE_PUBSUB_ENCRYPTION
+    /* Unsecured messages are not decoded via templates for secured
+     * ReaderGroups. They have to be rejected in the full decoding. */
+    UA_ReaderGroup *rg;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        if(rg->config.securityMode > UA_MESSAGESECURITYMODE_NONE)
+            return NULL;
+    }
+#endif
+
+    for(size_t i = 0; i < UA_PUBSUB_DECODETEMPLATES; i++) {
+        UA_PubSubDecodeTemplate *t = &c->decodeTemplates[i];
+        if(t->matches < UA_PUBSUB_DECODETEMPLATE_STABLE ||
+           !matchDecodeTemplate(t, msg))
+            continue;
+        size_t pos = 0;
+        UA_StatusCode res =
+            UA_NetworkMessage_updateBufferedNwMessage(&t->offsetBuffer, msg, &pos);
+        if(res == UA_STATUSCODE_GOOD && pos == msg->length)
+            return t->offsetBuffer.nm;
+        /* The layout has changed. Learn it again from the full decoding. */
+        clearDecodeTemplate(t);
+        return NULL;
+    }
+    return NULL;
+}
+
 /* Clean up the PubSubConnection. If no EventLoop connection is attached we can
  * immediately free. Otherwise we close the EventLoop connections and free in
  * the connection callback. */
@@ -296,9 +424,13 @@ UA_PubSubConnection_delete(UA_Server *server, UA_PubSubConnection *c) {
     /* Unlink from the server */
     TAILQ_REMOVE(&server->pubSubManager.connections, c, listEntry);
     server->pubSubManager.connectionsSize--;
+    UA_PubSubManager_unindexComponent(&server->pubSubManager, &c->idEntry);
 
     UA_LOG_INFO_CONNECTION(server->config.logging, c, "Connection deleted");
 
+    for(size_t i = 0; i < UA_PUBSUB_DECODETEMPLATES; i++)
+        clearDecodeTemplate(&c->decodeTemplates[i]);
+
     UA_PubSubConnectionConfig_clear(&c->config);
     UA_NodeId_clear(&c->identifier);
     UA_String_clear(&c->logIdString);
@@ -320,6 +452,80 @@ UA_Server_removePubSubConnection(UA_Server *server, const UA_NodeId connection)
     return UA_STATUSCODE_GOOD;
 }
 
+/* Process a decoded NetworkMessage with the non-RT ReaderGroups. The
+ * DataSetReaders are looked up in the index if the NetworkMessage contains all
+ * identifiers. Otherwise every DataSetReader checks the identifiers. */
+static UA_Boolean
+processReaderGroups(UA_Server *server, UA_PubSubConnection *c,
+                    UA_NetworkMessage *nm) {
+    UA_Boolean indexed = (nm->publisherIdEnabled && nm->payloadHeaderEnabled &&
+                          nm->groupHeaderEnabled &&
+                          nm->groupHeader.writerGroupIdEnabled);
+    UA_ReaderGroup *rg;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        /* JSON ReaderGroups check the identifiers differently */
+        if(rg->config.rtLevel != UA_PUBSUB_RT_FIXED_SIZE &&
+           rg->config.encodingMimeType != UA_PUBSUB_ENCODING_UADP)
+            indexed = false;
+    }
+
+    UA_Boolean processed = false;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        if(rg->state != UA_PUBSUBSTATE_OPERATIONAL &&
+           rg->state != UA_PUBSUBSTATE_PREOPERATIONAL)
+            continue;
+        if(rg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
+            continue;
+        if(indexed)
+            UA_ReaderGroup_setReceived(server, rg);
+        else
+            processed |= UA_ReaderGroup_process(server, rg, nm);
+    }
+
+    if(indexed)
+        processed = UA_DataSetReader_processIndexed(server, c, nm);
+    return processed;
+}
+
+#ifdef UA_ENABLE_JSON_ENCODING
+
+/* The DataSetMetaData of the first DataSetReader for the DataSetWriterId */
+static const UA_DataSetMetaDataType *
+findReaderMetaData(void *context, UA_UInt16 dataSetWriterId) {
+    UA_PubSubConnection *c = (UA_PubSubConnection*)context;
+    UA_ReaderGroup *rg;
+    UA_DataSetReader *dsr;
+    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+        if(rg->config.encodingMimeType != UA_PUBSUB_ENCODING_JSON)
+            continue;
+        LIST_FOREACH(dsr, &rg->readers, listEntry) {
+            if(dsr->config.dataSetWriterId == dataSetWriterId)
+                return &dsr->config.dataSetMetaData;
+        }
+    }
+    return NULL;
+}
+
+UA_StatusCode
+UA_PubSubConnection_decodeJson(UA_PubSubConnection *c, UA_NetworkMessage *nm,
+                               const UA_ByteString *msg) {
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+    if(UA_PubSub_isCompressed(msg)) {
+        /* The decoded NetworkMessage does not point into the buffer */
+        UA_ByteString inflated;
+        UA_StatusCode res = UA_PubSubConnection_decompress(c, msg, &inflated);
+        UA_CHECK_STATUS(res, return res);
+        res = UA_NetworkMessage_decodeJsonWithMetaData(nm, &inflated,
+                                                       findReaderMetaData, c);
+        UA_ByteString_clear(&inflated);
+        return res;
+    }
+#endif
+    return UA_NetworkMessage_decodeJsonWithMetaData(nm, msg, findReaderMetaData, c);
+}
+
+#endif /* UA_ENABLE_JSON_ENCODING */
+
 void
 UA_PubSubConnection_process(UA_Server *server, UA_PubSubConnection *c,
                             UA_ByteString msg) {
@@ -342,6 +548,15 @@ UA_PubSubConnection_process(UA_Server *server, UA_PubSubConnection *c,
     if(!nonRtRg)
         goto finish;
 
+    /* Decode at the offsets of a known layout */
+    if(nonRtRg->config.encodingMimeType == UA_PUBSUB_ENCODING_UADP) {
+        UA_NetworkMessage *tnm = decodeWithTemplate(c, &msg);
+        if(tnm) {
+            processed |= processReaderGroups(server, c, tnm);
+            goto finish;
+        }
+    }
+
     /* Decode the received message for the non-RT ReaderGroups */
     UA_StatusCode res;
     UA_NetworkMessage nm;
@@ -351,7 +566,7 @@ UA_PubSubConnection_process(UA_Server *server, UA_PubSubConnection *c,
         res = decodeNetworkMessage(server, &msg, &currentPosition, &nm, c);
     } else { /* if(writerGroup->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON) */
 #ifdef UA_ENABLE_JSON_ENCODING
-        res = UA_NetworkMessage_decodeJson(&nm, &msg);
+        res = UA_PubSubConnection_decodeJson(c, &nm, &msg);
 #else
         res = UA_STATUSCODE_BADNOTSUPPORTED;
 #endif
@@ -363,13 +578,20 @@ UA_PubSubConnection_process(UA_Server *server, UA_PubSubConnection *c,
     }
 
     /* Process the received message for the non-RT ReaderGroups */
-    LIST_FOREACH(rg, &c->readerGroups, listEntry) {
-        if(rg->state != UA_PUBSUBSTATE_OPERATIONAL &&
-           rg->state != UA_PUBSUBSTATE_PREOPERATIONAL)
-            continue;
-        if(rg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE)
-            continue;
-        processed |= UA_ReaderGroup_process(server, rg, &nm);
+    processed |= processReaderGroups(server, c, &nm);
+
+    /* Count the messages with the layout of a template. Or start a new
+     * template from the decoded message. */
+    if(nonRtRg->config.encodingMimeType == UA_PUBSUB_ENCODING_UADP) {
+        size_t i = 0;
+        for(; i < UA_PUBSUB_DECODETEMPLATES; i++) {
+            if(matchDecodeTemplate(&c->decodeTemplates[i], &msg)) {
+                c->decodeTemplates[i].matches++;
+                break;
+            }
+        }
+        if(i == UA_PUBSUB_DECODETEMPLATES)
+            addDecodeTemplate(c, &nm, &msg);
     }
     UA_NetworkMessage_clear(&nm);
 
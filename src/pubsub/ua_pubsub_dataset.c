@@ -104,12 +104,9 @@ UA_Server_getPublishedDataSetMetaData(UA_Server *server, const UA_NodeId pds,
 
 UA_PublishedDataSet *
 UA_PublishedDataSet_findPDSbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_PublishedDataSet *tmpPDS = NULL;
-    TAILQ_FOREACH(tmpPDS, &server->pubSubManager.publishedDataSets, listEntry) {
-        if(UA_NodeId_equal(&tmpPDS->identifier, &identifier))
-            break;
-    }
-    return tmpPDS;
+    return (UA_PublishedDataSet*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_PUBLISHEDDATASET, &identifier);
 }
 
 UA_PublishedDataSet *
@@ -579,6 +576,90 @@ UA_DataSetFieldConfig_clear(UA_DataSetFieldConfig *dataSetFieldConfig) {
     }
 }
 
+static UA_UInt32
+samplesHash(const UA_PublishedVariableDataType *params) {
+    UA_UInt32 h = UA_NodeId_hash(&params->publishedVariable);
+    h = UA_ByteString_hash(h, (const UA_Byte*)&params->attributeId,
+                           sizeof(UA_UInt32));
+    return UA_ByteString_hash(h, params->indexRange.data,
+                              params->indexRange.length);
+}
+
+static enum ZIP_CMP
+cmpPubSubSample(const void *a, const void *b) {
+    const UA_PubSubSample *aa = (const UA_PubSubSample*)a;
+    const UA_PubSubSample *bb = (const UA_PubSubSample*)b;
+    if(aa->hash != bb->hash)
+        return (aa->hash < bb->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(aa->params->attributeId != bb->params->attributeId)
+        return (aa->params->attributeId < bb->params->attributeId) ?
+            ZIP_CMP_LESS : ZIP_CMP_MORE;
+    UA_Order o = UA_order(&aa->params->indexRange, &bb->params->indexRange,
+                          &UA_TYPES[UA_TYPES_STRING]);
+    if(o != UA_ORDER_EQ)
+        return (enum ZIP_CMP)o;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->params->publishedVariable,
+                                         &bb->params->publishedVariable);
+}
+
+ZIP_FUNCTIONS(UA_PubSubSampleTree, UA_PubSubSample, treeEntry,
+              UA_PubSubSample, treeEntry, cmpPubSubSample)
+
+static void *
+deletePubSubSample(void *context, UA_PubSubSample *s) {
+    UA_DataValue_clear(&s->value);
+    UA_free(s);
+    return NULL;
+}
+
+void
+UA_PubSubSampleTree_clear(UA_PubSubSampleTree *samples) {
+    ZIP_ITER(UA_PubSubSampleTree, samples, deletePubSubSample, NULL);
+    ZIP_INIT(samples);
+}
+
+/* Read the value from the information model. During a publish cycle with
+ * several WriterGroups the value is read only once and copied out of the
+ * samples of the cycle afterwards. */
+static UA_DataValue
+readSampleValue(UA_Server *server, const UA_PublishedVariableDataType *params) {
+    UA_ReadValueId rvid;
+    UA_ReadValueId_init(&rvid);
+    rvid.nodeId = params->publishedVariable;
+    rvid.attributeId = params->attributeId;
+    rvid.indexRange = params->indexRange;
+
+    UA_PubSubSampleTree *samples = server->pubSubManager.samples;
+    if(!samples)
+        return readWithSession(server, &server->adminSession,
+                               &rvid, UA_TIMESTAMPSTORETURN_BOTH);
+
+    UA_DataValue value;
+    UA_PubSubSample dummy;
+    dummy.hash = samplesHash(params);
+    dummy.params = params;
+    UA_PubSubSample *s = ZIP_FIND(UA_PubSubSampleTree, samples, &dummy);
+    if(!s) {
+        s = (UA_PubSubSample*)UA_malloc(sizeof(UA_PubSubSample));
+        if(!s)
+            return readWithSession(server, &server->adminSession,
+                                   &rvid, UA_TIMESTAMPSTORETURN_BOTH);
+        s->hash = dummy.hash;
+        s->params = params;
+        s->value = readWithSession(server, &server->adminSession,
+                                   &rvid, UA_TIMESTAMPSTORETURN_BOTH);
+        ZIP_INSERT(UA_PubSubSampleTree, samples, s);
+    }
+
+    UA_StatusCode res = UA_DataValue_copy(&s->value, &value);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_DataValue_init(&value);
+        value.hasStatus = true;
+        value.status = res;
+    }
+    return value;
+}
+
 /* Obtain the latest value for a specific DataSetField. This method is currently
  * called inside the DataSetMessage generation process. */
 void
@@ -594,13 +675,7 @@ UA_PubSubDataSetField_sampleValue(UA_Server *server, UA_DataSetField *field,
         value->value.storageType = UA_VARIANT_DATA_NODELETE;
         UA_NODESTORE_RELEASE(server, (const UA_Node *) rtNode);
     } else if(field->config.field.variable.rtValueSource.rtFieldSourceEnabled == false){
-        UA_ReadValueId rvid;
-        UA_ReadValueId_init(&rvid);
-        rvid.nodeId = params->publishedVariable;
-        rvid.attributeId = params->attributeId;
-        rvid.indexRange = params->indexRange;
-        *value = readWithSession(server, &server->adminSession,
-                                 &rvid, UA_TIMESTAMPSTORETURN_BOTH);
+        *value = readSampleValue(server, params);
     } else {
         *value = **field->config.field.variable.rtValueSource.staticValueSource;
         value->value.storageType = UA_VARIANT_DATA_NODELETE;
@@ -717,6 +792,9 @@ UA_PublishedDataSet_create(UA_Server *server,
     /* Generate unique nodeId */
     UA_PubSubManager_generateUniqueNodeId(&server->pubSubManager, &newPDS->identifier);
 #endif
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newPDS->idEntry,
+                                    UA_PUBSUBINDEX_PUBLISHEDDATASET,
+                                    &newPDS->identifier, newPDS);
 
     /* Cache the log string */
     UA_String idStr = UA_STRING_NULL;
@@ -774,6 +852,7 @@ UA_PublishedDataSet_remove(UA_Server *server, UA_PublishedDataSet *publishedData
 
     UA_LOG_INFO_DATASET(server->config.logging, publishedDataSet, "DataSet deleted");
 
+    UA_PubSubManager_unindexComponent(&server->pubSubManager, &publishedDataSet->idEntry);
     UA_PublishedDataSet_clear(server, publishedDataSet);
     server->pubSubManager.publishedDataSetsSize--;
 
@@ -798,13 +877,9 @@ UA_Server_removePublishedDataSet(UA_Server *server, const UA_NodeId pds) {
 
 UA_StandaloneSubscribedDataSet *
 UA_StandaloneSubscribedDataSet_findSDSbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_StandaloneSubscribedDataSet *subscribedDataSet;
-    TAILQ_FOREACH(subscribedDataSet, &server->pubSubManager.subscribedDataSets,
-                  listEntry) {
-        if(UA_NodeId_equal(&identifier, &subscribedDataSet->identifier))
-            return subscribedDataSet;
-    }
-    return NULL;
+    return (UA_StandaloneSubscribedDataSet*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_SUBSCRIBEDDATASET, &identifier);
 }
 
 UA_StandaloneSubscribedDataSet *
@@ -552,14 +552,40 @@ UA_WriterGroup_connectUDPUnicast(UA_Server *server, UA_WriterGroup *wg,
     UA_NetworkAddressUrlDataType *addressUrl = (UA_NetworkAddressUrlDataType *)
         ts->address.content.decoded.data;
 
-    /* Extract hostname and port */
-    UA_String address;
-    UA_UInt16 port;
-    UA_StatusCode res = UA_parseEndpointUrl(&addressUrl->url, &address, &port, NULL);
+    /* Additional destinations for the fan-out to several unicast subscribers.
+     * The encoded NetworkMessage is sent once to all of them. */
+    const UA_Variant *fanout =
+        UA_KeyValueMap_get(&wg->config.groupProperties,
+                           UA_QUALIFIEDNAME(0, "fanout-addresses"));
+    size_t fanoutSize = 0;
+    if(fanout && fanout->type == &UA_TYPES[UA_TYPES_STRING] &&
+       !UA_Variant_isScalar(fanout))
+        fanoutSize = fanout->arrayLength;
+
+    /* Extract hostnames and ports. They point into the URLs. */
+    UA_String addressBuf;
+    UA_UInt16 portBuf;
+    UA_String *address = &addressBuf;
+    UA_UInt16 *port = &portBuf;
+    if(fanoutSize > 0) {
+        address = (UA_String*)UA_malloc((fanoutSize + 1) * sizeof(UA_String));
+        port = (UA_UInt16*)UA_malloc((fanoutSize + 1) * sizeof(UA_UInt16));
+        if(!address || !port) {
+            UA_free(address);
+            UA_free(port);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+    }
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i <= fanoutSize && res == UA_STATUSCODE_GOOD; i++) {
+        const UA_String *url = (i == 0) ?
+            &addressUrl->url : &((const UA_String*)fanout->data)[i - 1];
+        res = UA_parseEndpointUrl(url, &address[i], &port[i], NULL);
+    }
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR_WRITERGROUP(server->config.logging, wg,
                                 "Could not parse the UDP network URL");
-        return res;
+        goto cleanup;
     }
 
     /* Set up the connection parameters */
@@ -567,9 +593,16 @@ UA_WriterGroup_connectUDPUnicast(UA_Server *server, UA_WriterGroup *wg,
     UA_KeyValuePair kvp[5];
     UA_KeyValueMap kvm = {4, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "address");
-    UA_Variant_setScalar(&kvp[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
     kvp[1].key = UA_QUALIFIEDNAME(0, "port");
-    UA_Variant_setScalar(&kvp[1].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    if(fanoutSize > 0) {
+        UA_Variant_setArray(&kvp[0].value, address, fanoutSize + 1,
+                            &UA_TYPES[UA_TYPES_STRING]);
+        UA_Variant_setArray(&kvp[1].value, port, fanoutSize + 1,
+                            &UA_TYPES[UA_TYPES_UINT16]);
+    } else {
+        UA_Variant_setScalar(&kvp[0].value, address, &UA_TYPES[UA_TYPES_STRING]);
+        UA_Variant_setScalar(&kvp[1].value, port, &UA_TYPES[UA_TYPES_UINT16]);
+    }
     kvp[2].key = UA_QUALIFIEDNAME(0, "listen");
     UA_Variant_setScalar(&kvp[2].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
     kvp[3].key = UA_QUALIFIEDNAME(0, "validate");
@@ -590,6 +623,12 @@ UA_WriterGroup_connectUDPUnicast(UA_Server *server, UA_WriterGroup *wg,
         UA_LOG_ERROR_WRITERGROUP(server->config.logging, wg,
                                  "Could not open a UDP send channel");
     }
+
+ cleanup:
+    if(fanoutSize > 0) {
+        UA_free(address);
+        UA_free(port);
+    }
     return res;
 }
 
@@ -625,11 +664,15 @@ UA_WriterGroup_connectMQTT(UA_Server *server, UA_WriterGroup *wg,
         return res;
     }
 
+    /* Publish with QoS 1 for the at-least-once delivery guarantee */
+    UA_Byte qos = (transportSettings->requestedDeliveryGuarantee ==
+                   UA_BROKERTRANSPORTQUALITYOFSERVICE_ATLEASTONCE) ? 1 : 0;
+
     /* Set up the connection parameters.
      * TODO: Complete the MQTT parameters. */
     UA_Boolean listen = false;
-    UA_KeyValuePair kvp[5];
-    UA_KeyValueMap kvm = {5, kvp};
+    UA_KeyValuePair kvp[6];
+    UA_KeyValueMap kvm = {6, kvp};
     kvp[0].key = UA_QUALIFIEDNAME(0, "address");
     UA_Variant_setScalar(&kvp[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
     kvp[1].key = UA_QUALIFIEDNAME(0, "subscribe");
@@ -641,6 +684,8 @@ UA_WriterGroup_connectMQTT(UA_Server *server, UA_WriterGroup *wg,
                          &UA_TYPES[UA_TYPES_STRING]);
     kvp[4].key = UA_QUALIFIEDNAME(0, "validate");
     UA_Variant_setScalar(&kvp[4].value, &validate, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    kvp[5].key = UA_QUALIFIEDNAME(0, "qos");
+    UA_Variant_setScalar(&kvp[5].value, &qos, &UA_TYPES[UA_TYPES_BYTE]);
 
     /* Connect */
     UA_UNLOCK(&server->serviceMutex);
@@ -818,7 +863,7 @@ ReaderGroupChannelCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
                                    &nm, rg->linkedConnection);
     } else { /* if(writerGroup->config.encodingMimeType == UA_PUBSUB_ENCODING_JSON) */
 #ifdef UA_ENABLE_JSON_ENCODING
-        res = UA_NetworkMessage_decodeJson(&nm, &msg);
+        res = UA_PubSubConnection_decodeJson(rg->linkedConnection, &nm, &msg);
 #else
         res = UA_STATUSCODE_BADNOTSUPPORTED;
 #endif
@@ -253,6 +253,51 @@ UA_PubSubManager_reserveIds(UA_Server *server, UA_NodeId sessionId, UA_UInt16 nu
     return UA_STATUSCODE_GOOD;
 }
 
+/* Component Index */
+
+static enum ZIP_CMP
+cmpPubSubIndexKey(const void *a, const void *b) {
+    const UA_PubSubIndexKey *aa = (const UA_PubSubIndexKey*)a;
+    const UA_PubSubIndexKey *bb = (const UA_PubSubIndexKey*)b;
+    if(aa->hash != bb->hash)
+        return (aa->hash < bb->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(aa->id, bb->id);
+}
+
+ZIP_FUNCTIONS(UA_PubSubIndex, UA_PubSubIndexEntry, treeEntry,
+              UA_PubSubIndexKey, key, cmpPubSubIndexKey)
+
+void
+UA_PubSubManager_indexComponent(UA_PubSubManager *psm, UA_PubSubIndexEntry *entry,
+                                UA_PubSubIndexType type, const UA_NodeId *id,
+                                void *component) {
+    entry->key.hash = UA_NodeId_hash(id);
+    entry->key.id = id;
+    entry->type = type;
+    entry->component = component;
+    ZIP_INSERT(UA_PubSubIndex, &psm->componentIndex, entry);
+}
+
+void
+UA_PubSubManager_unindexComponent(UA_PubSubManager *psm, UA_PubSubIndexEntry *entry) {
+    if(!entry->component)
+        return; /* Not indexed */
+    ZIP_REMOVE(UA_PubSubIndex, &psm->componentIndex, entry);
+    entry->component = NULL;
+}
+
+void *
+UA_PubSubManager_findComponent(UA_PubSubManager *psm, UA_PubSubIndexType type,
+                               const UA_NodeId *id) {
+    UA_PubSubIndexKey key;
+    key.hash = UA_NodeId_hash(id);
+    key.id = id;
+    UA_PubSubIndexEntry *entry = ZIP_FIND(UA_PubSubIndex, &psm->componentIndex, &key);
+    if(!entry || entry->type != type)
+        return NULL;
+    return entry->component;
+}
+
 /* Calculate the time difference between current time and UTC (00:00) on January
  * 1, 2000. */
 UA_UInt32
@@ -301,6 +346,9 @@ addStandaloneSubscribedDataSet(UA_Server *server,
 #else
     UA_PubSubManager_generateUniqueNodeId(&server->pubSubManager, &newSubscribedDataSet->identifier);
 #endif
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newSubscribedDataSet->idEntry,
+                                    UA_PUBSUBINDEX_SUBSCRIBEDDATASET,
+                                    &newSubscribedDataSet->identifier, newSubscribedDataSet);
 
     if(sdsIdentifier)
         UA_NodeId_copy(&newSubscribedDataSet->identifier, sdsIdentifier);
@@ -349,6 +397,8 @@ removeStandaloneSubscribedDataSet(UA_Server *server, const UA_NodeId sds) {
     deleteNode(server, subscribedDataSet->identifier, true);
 #endif
 
+    UA_PubSubManager_unindexComponent(&server->pubSubManager,
+                                      &subscribedDataSet->idEntry);
     UA_StandaloneSubscribedDataSet_clear(server, subscribedDataSet);
     server->pubSubManager.subscribedDataSetsSize--;
 
@@ -521,17 +571,73 @@ UA_PubSubComponent_createMonitoring(UA_Server *server, UA_NodeId Id,
     return ret;
 }
 
+/* The MessageReceiveTimeout of all DataSetReaders in a ReaderGroup is
+ * supervised with a single timed callback. A received message only moves the
+ * deadline of the reader forward. The timer is left as is, as it fires before
+ * the new deadline anyway. When the timer fires, the readers with an expired
+ * deadline are signalled and the timer is re-armed for the earliest remaining
+ * deadline. So there is no timer churn for every received message. */
 static void
-monitoringReceiveTimeoutOnce(UA_Server *server, void *data) {
+monitoringReceiveTimeoutCheck(UA_Server *server, UA_ReaderGroup *rg);
+
+static UA_StatusCode
+scheduleReceiveTimeoutCheck(UA_Server *server, UA_ReaderGroup *rg,
+                            UA_DateTime deadline) {
+    /* The timer fires early enough */
+    if(rg->msgRcvTimeoutTimerId != 0 && rg->msgRcvTimeoutNextCheck <= deadline)
+        return UA_STATUSCODE_GOOD;
+
+    UA_EventLoop *el = server->config.eventLoop;
+    if(rg->msgRcvTimeoutTimerId != 0) {
+        el->removeCyclicCallback(el, rg->msgRcvTimeoutTimerId);
+        rg->msgRcvTimeoutTimerId = 0;
+    }
+    UA_StatusCode res =
+        el->addTimedCallback(el, (UA_Callback)monitoringReceiveTimeoutCheck,
+                             server, rg, deadline, &rg->msgRcvTimeoutTimerId);
+    if(res == UA_STATUSCODE_GOOD)
+        rg->msgRcvTimeoutNextCheck = deadline;
+    return res;
+}
+
+static void
+monitoringReceiveTimeoutCheck(UA_Server *server, UA_ReaderGroup *rg) {
     UA_LOCK(&server->serviceMutex);
-    UA_DataSetReader *reader = (UA_DataSetReader*)data;
-    reader->msgRcvTimeoutTimerCallback(server, reader);
+    rg->msgRcvTimeoutTimerId = 0; /* The timed callback is removed after it fired */
+
     UA_EventLoop *el = server->config.eventLoop;
-    el->removeCyclicCallback(el, reader->msgRcvTimeoutTimerId);
-    reader->msgRcvTimeoutTimerId = 0;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    UA_DateTime next = UA_INT64_MAX;
+    UA_DataSetReader *reader;
+    LIST_FOREACH(reader, &rg->readers, listEntry) {
+        if(reader->msgRcvTimeoutDeadline == 0)
+            continue;
+        if(reader->msgRcvTimeoutDeadline <= now) {
+            reader->msgRcvTimeoutDeadline = 0;
+            reader->msgRcvTimeoutTimerCallback(server, reader);
+            continue;
+        }
+        if(reader->msgRcvTimeoutDeadline < next)
+            next = reader->msgRcvTimeoutDeadline;
+    }
+
+    /* Re-arm for the earliest remaining deadline */
+    if(next != UA_INT64_MAX &&
+       scheduleReceiveTimeoutCheck(server, rg, next) != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR_READERGROUP(server->config.logging, rg,
+                                 "Could not schedule the MessageReceiveTimeout check");
     UA_UNLOCK(&server->serviceMutex);
 }
 
+void
+UA_ReaderGroup_stopReceiveTimeoutCheck(UA_Server *server, UA_ReaderGroup *rg) {
+    if(rg->msgRcvTimeoutTimerId == 0)
+        return;
+    UA_EventLoop *el = server->config.eventLoop;
+    el->removeCyclicCallback(el, rg->msgRcvTimeoutTimerId);
+    rg->msgRcvTimeoutTimerId = 0;
+}
+
 static UA_StatusCode
 UA_PubSubComponent_startMonitoring(UA_Server *server, UA_NodeId Id,
                                    UA_PubSubComponentEnumType eComponentType,
@@ -549,24 +655,22 @@ UA_PubSubComponent_startMonitoring(UA_Server *server, UA_NodeId Id,
                     if(reader->config.messageReceiveTimeout <= 0.0)
                         return UA_STATUSCODE_GOOD;
 
-                    /* use a timed callback, because one notification is enough,
-                     * we assume that MessageReceiveTimeout configuration is in
-                     * [ms], we do not handle or check fractions */
+                    /* Set the deadline. We assume that the MessageReceiveTimeout
+                     * configuration is in [ms]. */
                     UA_EventLoop *el = server->config.eventLoop;
-                    ret = el->addCyclicCallback(el, (UA_Callback)monitoringReceiveTimeoutOnce,
-                                                server, reader,
-                                                reader->config.messageReceiveTimeout, NULL,
-                                                UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME,
-                                                &reader->msgRcvTimeoutTimerId);
+                    reader->msgRcvTimeoutDeadline = el->dateTime_nowMonotonic(el) +
+                        (UA_DateTime)(reader->config.messageReceiveTimeout *
+                                      (UA_Double)UA_DATETIME_MSEC);
+                    ret = scheduleReceiveTimeoutCheck(server, reader->linkedReaderGroup,
+                                                      reader->msgRcvTimeoutDeadline);
                     if(ret == UA_STATUSCODE_GOOD) {
                         UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
                                      "UA_PubSubComponent_startMonitoring(): DataSetReader "
                                      "'%.*s'- MessageReceiveTimeout: "
-                                     "MessageReceiveTimeout = '%f' Timer Id = '%u'",
+                                     "MessageReceiveTimeout = '%f'",
                                      (UA_Int32)reader->config.name.length,
                                      reader->config.name.data,
-                                     reader->config.messageReceiveTimeout,
-                                     (UA_UInt32)reader->msgRcvTimeoutTimerId);
+                                     reader->config.messageReceiveTimeout);
                     } else {
                         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                                      "Error UA_PubSubComponent_startMonitoring(): "
@@ -612,15 +716,15 @@ UA_PubSubComponent_stopMonitoring(UA_Server *server, UA_NodeId Id,
             UA_DataSetReader *reader = (UA_DataSetReader*) data;
             switch (eMonitoringType) {
                 case UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT: {
-                    UA_EventLoop *el = server->config.eventLoop;
-                    el->removeCyclicCallback(el, reader->msgRcvTimeoutTimerId);
+                    /* The timer of the ReaderGroup is not touched. It finds
+                     * no deadline for the reader when it fires. */
+                    reader->msgRcvTimeoutDeadline = 0;
                     UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
                                  "UA_PubSubComponent_stopMonitoring(): DataSetReader '%.*s' - "
-                                 "MessageReceiveTimeout: MessageReceiveTimeout = '%f' "
-                                 "Timer Id = '%u'", (UA_Int32) reader->config.name.length,
+                                 "MessageReceiveTimeout: MessageReceiveTimeout = '%f'",
+                                 (UA_Int32) reader->config.name.length,
                                  reader->config.name.data,
-                                 reader->config.messageReceiveTimeout,
-                                 (UA_UInt32) reader->msgRcvTimeoutTimerId);
+                                 reader->config.messageReceiveTimeout);
                     break;
                 }
                 default:
@@ -659,19 +763,23 @@ UA_PubSubComponent_updateMonitoringInterval(UA_Server *server, UA_NodeId Id,
             UA_DataSetReader *reader = (UA_DataSetReader*) data;
             switch (eMonitoringType) {
                 case UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT: {
-                    UA_EventLoop *el = server->config.eventLoop;
-                    ret = el->modifyCyclicCallback(el, reader->msgRcvTimeoutTimerId,
-                                                   reader->config.messageReceiveTimeout, NULL,
-                                                   UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME);
+                    /* Restart the supervision with the new timeout */
+                    if(reader->msgRcvTimeoutDeadline != 0) {
+                        UA_EventLoop *el = server->config.eventLoop;
+                        reader->msgRcvTimeoutDeadline = el->dateTime_nowMonotonic(el) +
+                            (UA_DateTime)(reader->config.messageReceiveTimeout *
+                                          (UA_Double)UA_DATETIME_MSEC);
+                        ret = scheduleReceiveTimeoutCheck(server, reader->linkedReaderGroup,
+                                                          reader->msgRcvTimeoutDeadline);
+                    }
                     if(ret == UA_STATUSCODE_GOOD) {
                         UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
                                      "UA_PubSubComponent_updateMonitoringInterval(): "
                                      "DataSetReader '%.*s' - MessageReceiveTimeout: new "
-                                     "MessageReceiveTimeout = '%f' Timer Id = '%u'",
+                                     "MessageReceiveTimeout = '%f'",
                                      (UA_Int32) reader->config.name.length,
                                      reader->config.name.data,
-                                     reader->config.messageReceiveTimeout,
-                                     (UA_UInt32) reader->msgRcvTimeoutTimerId);
+                                     reader->config.messageReceiveTimeout);
                     } else {
                         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                                      "Error UA_PubSubComponent_updateMonitoringInterval(): "
@@ -718,10 +826,10 @@ UA_PubSubComponent_deleteMonitoring(UA_Server *server, UA_NodeId Id,
                 case UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT:
                     UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
                                  "UA_PubSubComponent_deleteMonitoring(): DataSetReader "
-                                 "'%.*s' - MessageReceiveTimeout: Timer Id = '%u'",
+                                 "'%.*s' - MessageReceiveTimeout",
                                  (UA_Int32)reader->config.name.length,
-                                 reader->config.name.data,
-                                 (UA_UInt32)reader->msgRcvTimeoutTimerId);
+                                 reader->config.name.data);
+                    reader->msgRcvTimeoutDeadline = 0;
                     break;
                 default:
                     UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
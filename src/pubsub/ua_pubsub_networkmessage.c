@@ -151,6 +151,18 @@ UA_NetworkMessage_updateBufferedNwMessage(UA_NetworkMessageOffsetBuffer *buffer,
         case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
             rv = UA_UInt16_decodeBinary(src, &pos, &dsm->header.dataSetMessageSequenceNr);
             break;
+        case UA_PUBSUB_OFFSETTYPE_TIMESTAMP:
+            rv = UA_DateTime_decodeBinary(src, &pos, &nm->timestamp);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_TIMESTAMP_PICOSECONDS:
+            rv = UA_UInt16_decodeBinary(src, &pos, &nm->picoseconds);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP:
+            rv = UA_DateTime_decodeBinary(src, &pos, &dsm->header.timestamp);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS:
+            rv = UA_UInt16_decodeBinary(src, &pos, &dsm->header.status);
+            break;
         case UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE:
             UA_DataValue_clear(&dsm->data.keyFrameData.dataSetFields[payloadCounter]);
             rv = UA_DataValue_decodeBinary(src, &pos,
@@ -178,6 +190,14 @@ UA_NetworkMessage_updateBufferedNwMessage(UA_NetworkMessageOffsetBuffer *buffer,
             return UA_STATUSCODE_BADNOTSUPPORTED;
         }
         UA_CHECK_STATUS(rv, return rv);
+
+        /* The encoded field must end where the next field begins. Otherwise
+         * the layout has changed. */
+        if(i + 1 < buffer->offsetsSize &&
+           (buffer->offsets[i].contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE ||
+            buffer->offsets[i].contentType == UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT) &&
+           pos != buffer->offsets[i+1].offset + *bufferPosition)
+            return UA_STATUSCODE_BADDECODINGERROR;
     }
 
     /* Check if the frame is of type "raw" payload. If yes, set the new buffer
@@ -1647,14 +1667,32 @@ UA_DataSetMessage_calcSizeBinary(UA_DataSetMessage* p,
         size += 2; /* UA_UInt16_calcSizeBinary(&p->header.dataSetMessageSequenceNr) */
     }
 
-    if(p->header.timestampEnabled)
+    if(p->header.timestampEnabled) {
+        if(offsetBuffer) {
+            size_t pos = offsetBuffer->offsetsSize;
+            if(!increaseOffsetArray(offsetBuffer))
+                return 0;
+            offsetBuffer->offsets[pos].offset = size;
+            offsetBuffer->offsets[pos].contentType =
+                UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP;
+        }
         size += 8; /* UA_DateTime_calcSizeBinary(&p->header.timestamp) */
+    }
 
     if(p->header.picoSecondsIncluded)
         size += 2; /* UA_UInt16_calcSizeBinary(&p->header.picoSeconds) */
 
-    if(p->header.statusEnabled)
+    if(p->header.statusEnabled) {
+        if(offsetBuffer) {
+            size_t pos = offsetBuffer->offsetsSize;
+            if(!increaseOffsetArray(offsetBuffer))
+                return 0;
+            offsetBuffer->offsets[pos].offset = size;
+            offsetBuffer->offsets[pos].contentType =
+                UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS;
+        }
         size += 2; /* UA_UInt16_calcSizeBinary(&p->header.status) */
+    }
 
     if(p->header.configVersionMajorVersionEnabled)
         size += 4; /* UA_UInt32_calcSizeBinary(&p->header.configVersionMajorVersion) */
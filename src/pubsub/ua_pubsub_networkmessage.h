@@ -192,7 +192,9 @@ typedef enum {
     /* For subscriber RT */
     UA_PUBSUB_OFFSETTYPE_PUBLISHERID,
     UA_PUBSUB_OFFSETTYPE_WRITERGROUPID,
-    UA_PUBSUB_OFFSETTYPE_DATASETWRITERID
+    UA_PUBSUB_OFFSETTYPE_DATASETWRITERID,
+    UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP,
+    UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS
     /* Add more offset types as needed */
 } UA_NetworkMessageOffsetType;
 
@@ -330,6 +332,14 @@ UA_NetworkMessage_encodeJson(const UA_NetworkMessage *src,
                              size_t namespaceSize, UA_String *serverUris,
                              size_t serverUriSize, UA_Boolean useReversible);
 
+/* Encode into a newly allocated buffer that grows during the encoding. The
+ * message is encoded once, without a preceding calcSizeJson. */
+UA_StatusCode
+UA_NetworkMessage_encodeJsonAlloc(const UA_NetworkMessage *src, UA_ByteString *outBuf,
+                                  UA_String *namespaces, size_t namespaceSize,
+                                  UA_String *serverUris, size_t serverUriSize,
+                                  UA_Boolean useReversible);
+
 size_t
 UA_NetworkMessage_calcSizeJson(const UA_NetworkMessage *src,
                                UA_String *namespaces, size_t namespaceSize,
@@ -337,6 +347,62 @@ UA_NetworkMessage_calcSizeJson(const UA_NetworkMessage *src,
                                UA_Boolean useReversible);
 
 UA_StatusCode UA_NetworkMessage_decodeJson(UA_NetworkMessage *dst, const UA_ByteString *src);
+
+/* Schema-driven decoding with the DataSetMetaData expected by the subscriber.
+ * The lookup returns the DataSetMetaData for a DataSetWriterId (or NULL). The
+ * payload keys of a DataSetMessage are matched in the order of the metadata
+ * fields. Scalar fields in the Variant encoding are decoded directly with the
+ * builtin type from the metadata. The fieldNames are not set in that case.
+ * DataSetMessages that deviate from the metadata are decoded generically. */
+typedef const UA_DataSetMetaDataType *
+(*UA_NetworkMessage_metaDataLookup)(void *context, UA_UInt16 dataSetWriterId);
+
+UA_StatusCode
+UA_NetworkMessage_decodeJsonWithMetaData(UA_NetworkMessage *dst, const UA_ByteString *src,
+                                         UA_NetworkMessage_metaDataLookup lookup,
+                                         void *lookupContext);
+
+/* Preformatted JSON NetworkMessage for the frozen configuration of a
+ * WriterGroup. The constant text (keys, header fields and field names) is
+ * encoded once. In every publish cycle only the values in the gaps between
+ * the text segments are encoded. The layout of the DataSetMessages is kept to
+ * detect NetworkMessages that don't match the template. The template uses the
+ * reversible encoding without namespace mapping. */
+typedef struct {
+    UA_NetworkMessageOffsetType contentType;
+    size_t textOffset; /* The gap follows the text up to this offset */
+    UA_Byte dsmIndex;
+    UA_UInt16 fieldIndex;
+} UA_NetworkMessageJsonGap;
+
+typedef struct {
+    UA_ByteString text;
+    UA_NetworkMessageJsonGap *gaps;
+    size_t gapsSize;
+    UA_Byte dsmCount;
+    UA_UInt16 *dataSetWriterIds;
+    UA_DataSetMessageHeader *headers;
+    UA_UInt16 *fieldCounts;
+    UA_ByteString buffer; /* Reused for encoding the messages */
+} UA_NetworkMessageJsonTemplate;
+
+UA_StatusCode
+UA_NetworkMessage_generateJsonTemplate(const UA_NetworkMessage *src,
+                                       UA_NetworkMessageJsonTemplate *tmpl);
+
+UA_Boolean
+UA_NetworkMessageJsonTemplate_matches(const UA_NetworkMessageJsonTemplate *tmpl,
+                                      const UA_NetworkMessage *src);
+
+/* The output points into the reused buffer of the template. It is valid until
+ * the template is used again. */
+UA_StatusCode
+UA_NetworkMessage_encodeJsonTemplate(UA_NetworkMessageJsonTemplate *tmpl,
+                                     const UA_NetworkMessage *src,
+                                     UA_ByteString *out);
+
+void
+UA_NetworkMessageJsonTemplate_clear(UA_NetworkMessageJsonTemplate *tmpl);
 #endif
 
 _UA_END_DECLS
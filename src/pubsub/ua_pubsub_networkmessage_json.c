@@ -36,10 +36,28 @@ static UA_StatusCode writeJsonKey_UA_String(CtxJson *ctx, UA_String *in) {
     return writeJsonKey(ctx, out);
 }
 
+/* Without a template the value is encoded. Otherwise a gap is left in the
+ * template text. The values for the gap are encoded in every publish cycle. */
+static UA_StatusCode
+writeJsonValueOrGap(CtxJson *ctx, UA_NetworkMessageJsonTemplate *tmpl,
+                    const void *value, const UA_DataType *type,
+                    UA_NetworkMessageOffsetType contentType,
+                    UA_Byte dsmIndex, UA_UInt16 fieldIndex) {
+    if(!tmpl)
+        return encodeJsonJumpTable[type->typeKind](ctx, value, type);
+    UA_NetworkMessageJsonGap *gap = &tmpl->gaps[tmpl->gapsSize++];
+    gap->contentType = contentType;
+    gap->textOffset = (size_t)((uintptr_t)ctx->pos - (uintptr_t)tmpl->text.data);
+    gap->dsmIndex = dsmIndex;
+    gap->fieldIndex = fieldIndex;
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
-                                      UA_UInt16 dataSetWriterId,
-                                      CtxJson *ctx) {
+                                      UA_UInt16 dataSetWriterId, CtxJson *ctx,
+                                      UA_NetworkMessageJsonTemplate *tmpl,
+                                      UA_Byte dsmIndex) {
     status rv = writeJsonObjStart(ctx);
 
     /* DataSetWriterId */
@@ -50,9 +68,11 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
 
     /* DataSetMessageSequenceNr */
     if(src->header.dataSetMessageSequenceNrEnabled) {
-        rv |= writeJsonObjElm(ctx, UA_DECODEKEY_SEQUENCENUMBER,
-                              &src->header.dataSetMessageSequenceNr,
-                              &UA_TYPES[UA_TYPES_UINT16]);
+        rv |= writeJsonKey(ctx, UA_DECODEKEY_SEQUENCENUMBER);
+        rv |= writeJsonValueOrGap(ctx, tmpl, &src->header.dataSetMessageSequenceNr,
+                                  &UA_TYPES[UA_TYPES_UINT16],
+                                  UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER,
+                                  dsmIndex, 0);
         if(rv != UA_STATUSCODE_GOOD)
             return rv;
     }
@@ -71,16 +91,22 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
 
     /* Timestamp */
     if(src->header.timestampEnabled) {
-        rv |= writeJsonObjElm(ctx, UA_DECODEKEY_TIMESTAMP, &src->header.timestamp,
-                              &UA_TYPES[UA_TYPES_DATETIME]);
+        rv |= writeJsonKey(ctx, UA_DECODEKEY_TIMESTAMP);
+        rv |= writeJsonValueOrGap(ctx, tmpl, &src->header.timestamp,
+                                  &UA_TYPES[UA_TYPES_DATETIME],
+                                  UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP,
+                                  dsmIndex, 0);
         if(rv != UA_STATUSCODE_GOOD)
             return rv;
     }
 
     /* Status */
     if(src->header.statusEnabled) {
-        rv |= writeJsonObjElm(ctx, UA_DECODEKEY_DSM_STATUS,
-                              &src->header.status, &UA_TYPES[UA_TYPES_UINT16]);
+        rv |= writeJsonKey(ctx, UA_DECODEKEY_DSM_STATUS);
+        rv |= writeJsonValueOrGap(ctx, tmpl, &src->header.status,
+                                  &UA_TYPES[UA_TYPES_UINT16],
+                                  UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS,
+                                  dsmIndex, 0);
         if(rv != UA_STATUSCODE_GOOD)
             return rv;
     }
@@ -101,8 +127,11 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
                 rv |= writeJsonKey_UA_String(ctx, &src->data.keyFrameData.fieldNames[i]);
             else
                 rv |= writeJsonKey(ctx, "");
-            rv |= encodeJsonJumpTable[UA_DATATYPEKIND_VARIANT]
-                (ctx, &src->data.keyFrameData.dataSetFields[i].value, NULL);
+            rv |= writeJsonValueOrGap(ctx, tmpl,
+                                      &src->data.keyFrameData.dataSetFields[i].value,
+                                      &UA_TYPES[UA_TYPES_VARIANT],
+                                      UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT,
+                                      dsmIndex, i);
             if(rv != UA_STATUSCODE_GOOD)
                 return rv;
         }
@@ -113,8 +142,10 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
                 rv |= writeJsonKey_UA_String(ctx, &src->data.keyFrameData.fieldNames[i]);
             else
                 rv |= writeJsonKey(ctx, "");
-            rv |= encodeJsonJumpTable[UA_DATATYPEKIND_DATAVALUE]
-                (ctx, &src->data.keyFrameData.dataSetFields[i], NULL);
+            rv |= writeJsonValueOrGap(ctx, tmpl, &src->data.keyFrameData.dataSetFields[i],
+                                      &UA_TYPES[UA_TYPES_DATAVALUE],
+                                      UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE,
+                                      dsmIndex, i);
             if(rv != UA_STATUSCODE_GOOD)
                 return rv;
         }
@@ -128,7 +159,8 @@ UA_DataSetMessage_encodeJson_internal(const UA_DataSetMessage* src,
 }
 
 static UA_StatusCode
-UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx) {
+UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx,
+                                      UA_NetworkMessageJsonTemplate *tmpl) {
     const UA_DataType *publisherIdType;
     /* currently only ua-data is supported, no discovery message implemented */
     if(src->networkMessageType != UA_NETWORKMESSAGE_DATASET)
@@ -198,7 +230,8 @@ UA_NetworkMessage_encodeJson_internal(const UA_NetworkMessage* src, CtxJson *ctx
         for(UA_UInt16 i = 0; i < count; i++) {
             rv |= writeJsonBeforeElement(ctx, true);
             rv |= UA_DataSetMessage_encodeJson_internal(&dataSetMessages[i],
-                                                        dataSetWriterIds[i], ctx);
+                                                        dataSetWriterIds[i], ctx,
+                                                        tmpl, (UA_Byte)i);
             if(rv != UA_STATUSCODE_GOOD)
                 return rv;
             /* comma is needed if more dsm are present */
@@ -230,13 +263,44 @@ UA_NetworkMessage_encodeJson(const UA_NetworkMessage *src,
     ctx.useReversible = useReversible;
     ctx.calcOnly = false;
 
-    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
 
     *bufPos = ctx.pos;
     *bufEnd = ctx.end;
     return ret;
 }
 
+UA_StatusCode
+UA_NetworkMessage_encodeJsonAlloc(const UA_NetworkMessage *src, UA_ByteString *outBuf,
+                                  UA_String *namespaces, size_t namespaceSize,
+                                  UA_String *serverUris, size_t serverUriSize,
+                                  UA_Boolean useReversible) {
+    UA_StatusCode ret =
+        UA_ByteString_allocBuffer(outBuf, UA_JSON_ENCODING_INITIALSIZE);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
+
+    /* Set up the context with a growing buffer */
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pos = outBuf->data;
+    ctx.end = &outBuf->data[outBuf->length];
+    ctx.growBuf = outBuf;
+    ctx.namespaces = namespaces;
+    ctx.namespacesSize = namespaceSize;
+    ctx.serverUris = serverUris;
+    ctx.serverUrisSize = serverUriSize;
+    ctx.useReversible = useReversible;
+
+    ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
+    if(ret != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(outBuf);
+        return ret;
+    }
+    outBuf->length = (size_t)(ctx.pos - outBuf->data);
+    return UA_STATUSCODE_GOOD;
+}
+
 size_t
 UA_NetworkMessage_calcSizeJson(const UA_NetworkMessage *src,
                                UA_String *namespaces, size_t namespaceSize,
@@ -255,12 +319,222 @@ UA_NetworkMessage_calcSizeJson(const UA_NetworkMessage *src,
     ctx.useReversible = useReversible;
     ctx.calcOnly = true;
 
-    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx);
+    status ret = UA_NetworkMessage_encodeJson_internal(src, &ctx, NULL);
     if(ret != UA_STATUSCODE_GOOD)
         return 0;
     return (size_t)ctx.pos;
 }
 
+/* -- json template encoding -- */
+
+UA_StatusCode
+UA_NetworkMessage_generateJsonTemplate(const UA_NetworkMessage *src,
+                                       UA_NetworkMessageJsonTemplate *tmpl) {
+    memset(tmpl, 0, sizeof(UA_NetworkMessageJsonTemplate));
+    UA_Byte count = src->payloadHeader.dataSetPayloadHeader.count;
+    const UA_DataSetMessage *dsm = src->payload.dataSetPayload.dataSetMessages;
+    if(count > 0 && (!dsm || !src->payloadHeader.dataSetPayloadHeader.dataSetWriterIds))
+        return UA_STATUSCODE_BADENCODINGERROR;
+
+    /* At most three header gaps and the fields for every DataSetMessage */
+    UA_StatusCode res = UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t maxGaps = 0;
+    for(size_t i = 0; i < count; i++)
+        maxGaps += 3 + (size_t)dsm[i].data.keyFrameData.fieldCount;
+    if(maxGaps > 0) {
+        tmpl->gaps = (UA_NetworkMessageJsonGap*)
+            UA_calloc(maxGaps, sizeof(UA_NetworkMessageJsonGap));
+        if(!tmpl->gaps)
+            goto error;
+    }
+
+    /* Compute the length of the text. The gaps are recorded again during the
+     * encoding. */
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pos = 0;
+    ctx.end = (const UA_Byte*)(uintptr_t)SIZE_MAX;
+    ctx.useReversible = true;
+    ctx.calcOnly = true;
+    res = UA_NetworkMessage_encodeJson_internal(src, &ctx, tmpl);
+    if(res != UA_STATUSCODE_GOOD)
+        goto error;
+
+    /* Encode the text */
+    res = UA_ByteString_allocBuffer(&tmpl->text, (size_t)ctx.pos);
+    if(res != UA_STATUSCODE_GOOD)
+        goto error;
+    tmpl->gapsSize = 0;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pos = tmpl->text.data;
+    ctx.end = &tmpl->text.data[tmpl->text.length];
+    ctx.useReversible = true;
+    res = UA_NetworkMessage_encodeJson_internal(src, &ctx, tmpl);
+    if(res != UA_STATUSCODE_GOOD)
+        goto error;
+
+    /* Store the layout to detect messages that don't match */
+    res = UA_STATUSCODE_BADOUTOFMEMORY;
+    tmpl->dsmCount = count;
+    if(count > 0) {
+        tmpl->dataSetWriterIds = (UA_UInt16*)UA_calloc(count, sizeof(UA_UInt16));
+        tmpl->headers = (UA_DataSetMessageHeader*)
+            UA_calloc(count, sizeof(UA_DataSetMessageHeader));
+        tmpl->fieldCounts = (UA_UInt16*)UA_calloc(count, sizeof(UA_UInt16));
+        if(!tmpl->dataSetWriterIds || !tmpl->headers || !tmpl->fieldCounts)
+            goto error;
+        memcpy(tmpl->dataSetWriterIds,
+               src->payloadHeader.dataSetPayloadHeader.dataSetWriterIds,
+               count * sizeof(UA_UInt16));
+        for(size_t i = 0; i < count; i++) {
+            tmpl->headers[i] = dsm[i].header;
+            tmpl->fieldCounts[i] = dsm[i].data.keyFrameData.fieldCount;
+        }
+    }
+
+    /* The reused buffer fits the current message */
+    res = UA_ByteString_allocBuffer(&tmpl->buffer,
+                                    UA_NetworkMessage_calcSizeJson(src, NULL, 0,
+                                                                   NULL, 0, true));
+    if(res != UA_STATUSCODE_GOOD)
+        goto error;
+    return UA_STATUSCODE_GOOD;
+
+ error:
+    UA_NetworkMessageJsonTemplate_clear(tmpl);
+    return res;
+}
+
+static UA_Boolean
+sameJsonLayout(const UA_DataSetMessageHeader *a, const UA_DataSetMessageHeader *b) {
+    return a->dataSetMessageType == b->dataSetMessageType &&
+        a->fieldEncoding == b->fieldEncoding &&
+        a->dataSetMessageSequenceNrEnabled == b->dataSetMessageSequenceNrEnabled &&
+        a->timestampEnabled == b->timestampEnabled &&
+        a->statusEnabled == b->statusEnabled &&
+        a->configVersionMajorVersionEnabled == b->configVersionMajorVersionEnabled &&
+        a->configVersionMinorVersionEnabled == b->configVersionMinorVersionEnabled &&
+        a->configVersionMajorVersion == b->configVersionMajorVersion &&
+        a->configVersionMinorVersion == b->configVersionMinorVersion;
+}
+
+UA_Boolean
+UA_NetworkMessageJsonTemplate_matches(const UA_NetworkMessageJsonTemplate *tmpl,
+                                      const UA_NetworkMessage *src) {
+    UA_Byte count = src->payloadHeader.dataSetPayloadHeader.count;
+    if(count != tmpl->dsmCount)
+        return false;
+    if(count == 0)
+        return true;
+    if(memcmp(tmpl->dataSetWriterIds,
+              src->payloadHeader.dataSetPayloadHeader.dataSetWriterIds,
+              count * sizeof(UA_UInt16)) != 0)
+        return false;
+    const UA_DataSetMessage *dsm = src->payload.dataSetPayload.dataSetMessages;
+    for(size_t i = 0; i < count; i++) {
+        if(!sameJsonLayout(&tmpl->headers[i], &dsm[i].header) ||
+           tmpl->fieldCounts[i] != dsm[i].data.keyFrameData.fieldCount)
+            return false;
+    }
+    return true;
+}
+
+static UA_StatusCode
+writeJsonTemplateText(CtxJson *ctx, const UA_NetworkMessageJsonTemplate *tmpl,
+                      size_t *textPos, size_t textEnd) {
+    size_t len = textEnd - *textPos;
+    if(ctx->pos + len > ctx->end)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    memcpy(ctx->pos, &tmpl->text.data[*textPos], len);
+    ctx->pos += len;
+    *textPos = textEnd;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+fillJsonTemplate(CtxJson *ctx, const UA_NetworkMessageJsonTemplate *tmpl,
+                 const UA_DataSetMessage *dsm) {
+    size_t textPos = 0;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < tmpl->gapsSize; i++) {
+        const UA_NetworkMessageJsonGap *gap = &tmpl->gaps[i];
+        res = writeJsonTemplateText(ctx, tmpl, &textPos, gap->textOffset);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+
+        const UA_DataSetMessage *m = &dsm[gap->dsmIndex];
+        switch(gap->contentType) {
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_SEQUENCENUMBER:
+            res = encodeJsonJumpTable[UA_DATATYPEKIND_UINT16]
+                (ctx, &m->header.dataSetMessageSequenceNr, &UA_TYPES[UA_TYPES_UINT16]);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_TIMESTAMP:
+            res = encodeJsonJumpTable[UA_DATATYPEKIND_DATETIME]
+                (ctx, &m->header.timestamp, &UA_TYPES[UA_TYPES_DATETIME]);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_DATASETMESSAGE_STATUS:
+            res = encodeJsonJumpTable[UA_DATATYPEKIND_UINT16]
+                (ctx, &m->header.status, &UA_TYPES[UA_TYPES_UINT16]);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_VARIANT:
+            res = encodeJsonJumpTable[UA_DATATYPEKIND_VARIANT]
+                (ctx, &m->data.keyFrameData.dataSetFields[gap->fieldIndex].value,
+                 &UA_TYPES[UA_TYPES_VARIANT]);
+            break;
+        case UA_PUBSUB_OFFSETTYPE_PAYLOAD_DATAVALUE:
+            res = encodeJsonJumpTable[UA_DATATYPEKIND_DATAVALUE]
+                (ctx, &m->data.keyFrameData.dataSetFields[gap->fieldIndex],
+                 &UA_TYPES[UA_TYPES_DATAVALUE]);
+            break;
+        default:
+            return UA_STATUSCODE_BADINTERNALERROR;
+        }
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return writeJsonTemplateText(ctx, tmpl, &textPos, tmpl->text.length);
+}
+
+UA_StatusCode
+UA_NetworkMessage_encodeJsonTemplate(UA_NetworkMessageJsonTemplate *tmpl,
+                                     const UA_NetworkMessage *src,
+                                     UA_ByteString *out) {
+    const UA_DataSetMessage *dsm = src->payload.dataSetPayload.dataSetMessages;
+    while(true) {
+        CtxJson ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.pos = tmpl->buffer.data;
+        ctx.end = &tmpl->buffer.data[tmpl->buffer.length];
+        ctx.useReversible = true;
+        UA_StatusCode res = fillJsonTemplate(&ctx, tmpl, dsm);
+        if(res == UA_STATUSCODE_GOOD) {
+            out->data = tmpl->buffer.data;
+            out->length = (size_t)(ctx.pos - tmpl->buffer.data);
+            return UA_STATUSCODE_GOOD;
+        }
+        if(res != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED)
+            return res;
+
+        /* The values have grown. Enlarge the reused buffer and retry. */
+        size_t length = (tmpl->buffer.length * 2) + tmpl->text.length;
+        UA_ByteString_clear(&tmpl->buffer);
+        res = UA_ByteString_allocBuffer(&tmpl->buffer, length);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+}
+
+void
+UA_NetworkMessageJsonTemplate_clear(UA_NetworkMessageJsonTemplate *tmpl) {
+    UA_ByteString_clear(&tmpl->text);
+    UA_ByteString_clear(&tmpl->buffer);
+    UA_free(tmpl->gaps);
+    UA_free(tmpl->dataSetWriterIds);
+    UA_free(tmpl->headers);
+    UA_free(tmpl->fieldCounts);
+    memset(tmpl, 0, sizeof(UA_NetworkMessageJsonTemplate));
+}
+
 /* decode json */
 static status
 MetaDataVersion_decodeJsonInternal(ParseCtx *ctx, void* cvd, const UA_DataType *type) {
@@ -268,9 +542,134 @@ MetaDataVersion_decodeJsonInternal(ParseCtx *ctx, void* cvd, const UA_DataType *
         (ctx, cvd, &UA_TYPES[UA_TYPES_CONFIGURATIONVERSIONDATATYPE]);
 }
 
+/* Lookup of the DataSetMetaData in ctx->customSchema */
+typedef struct {
+    UA_NetworkMessage_metaDataLookup lookup;
+    void *context;
+} MetaDataLookup;
+
+/* The payload is decoded after the DataSetWriterId if that comes first */
+typedef struct {
+    UA_DataSetMessage *dsm;
+    const UA_UInt16 *dataSetWriterId;
+    const UA_Boolean *dataSetWriterIdFound;
+} PayloadDecode;
+
+static UA_Boolean
+tokenEqualsString(const ParseCtx *ctx, size_t index, const UA_String *s) {
+    const cj5_token *t = &ctx->tokens[index];
+    return (getTokenLength(t) == s->length &&
+            (s->length == 0 || memcmp(&ctx->json5[t->start], s->data, s->length) == 0));
+}
+
+static UA_Boolean
+tokenEqualsNumber(const ParseCtx *ctx, size_t index, UA_UInt32 number) {
+    const cj5_token *t = &ctx->tokens[index];
+    if(t->type != CJ5_TOKEN_NUMBER)
+        return false;
+    size_t len = getTokenLength(t);
+    const char *pos = &ctx->json5[t->start];
+    UA_UInt32 n = 0;
+    for(size_t i = 0; i < len; i++) {
+        if(pos[i] < '0' || pos[i] > '9' || n > 0xffffff)
+            return false;
+        n = (n * 10) + (UA_UInt32)(pos[i] - '0');
+    }
+    return (len > 0 && n == number);
+}
+
+/* Decode {"Type":<builtInType>,"Body":<scalar>} with the builtin type from the
+ * FieldMetaData. Returns BADTYPEMISMATCH without changes to the context if the
+ * field has a different layout. */
+static status
+decodeScalarVariantField(ParseCtx *ctx, UA_Variant *v, const UA_FieldMetaData *fmd) {
+    if(fmd->valueRank != UA_VALUERANK_SCALAR || fmd->builtInType == 0 ||
+       fmd->builtInType > UA_TYPES_DIAGNOSTICINFO + 1)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    const UA_DataType *type = &UA_TYPES[fmd->builtInType - 1];
+    if(type->typeId.identifier.numeric != fmd->builtInType ||
+       type->typeKind == UA_DATATYPEKIND_VARIANT)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+
+    /* Exactly the two keys in the expected order */
+    size_t i = ctx->index;
+    const UA_String typeKey = UA_STRING_STATIC("Type");
+    const UA_String bodyKey = UA_STRING_STATIC("Body");
+    if(currentTokenType(ctx) != CJ5_TOKEN_OBJECT || ctx->tokens[i].size != 4 ||
+       i + 4 >= ctx->tokensSize ||
+       !tokenEqualsString(ctx, i + 1, &typeKey) ||
+       !tokenEqualsNumber(ctx, i + 2, fmd->builtInType) ||
+       !tokenEqualsString(ctx, i + 3, &bodyKey) ||
+       ctx->tokens[i + 4].type == CJ5_TOKEN_ARRAY ||
+       ctx->tokens[i + 4].type == CJ5_TOKEN_NULL)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+
+    void *data = UA_new(type);
+    if(!data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx->index = i + 4;
+    status ret = decodeJsonJumpTable[type->typeKind](ctx, data, type);
+    if(ret != UA_STATUSCODE_GOOD) {
+        UA_delete(data, type);
+        return ret;
+    }
+    UA_Variant_setScalar(v, data, type);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The keys must match the field names of the metadata in order. The field
+ * encoding is detected once from the first field. */
 static status
-DataSetPayload_decodeJsonInternal(ParseCtx *ctx, void* dsmP, const UA_DataType *type) {
-    UA_DataSetMessage* dsm = (UA_DataSetMessage*)dsmP;
+DataSetPayload_decodeJsonSchema(ParseCtx *ctx, UA_DataSetMessage *dsm,
+                                const UA_DataSetMetaDataType *md) {
+    size_t length = (size_t)(ctx->tokens[ctx->index].size) / 2;
+    if(length == 0 || length != md->fieldsSize || length > UA_UINT16_MAX)
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+
+    UA_DataValue *fields = (UA_DataValue *)
+        UA_Array_new(length, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(!fields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    dsm->data.keyFrameData.dataSetFields = fields;
+    dsm->data.keyFrameData.fieldCount = (UA_UInt16)length;
+
+    ctx->index++; /* Go to the first key */
+
+    status ret = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < length; ++i) {
+        if(!tokenEqualsString(ctx, ctx->index, &md->fields[i].name))
+            return UA_STATUSCODE_BADTYPEMISMATCH;
+        ctx->index++; /* Go to the value */
+
+        if(i == 0) {
+            size_t searchResult = 0;
+            dsm->header.fieldEncoding = UA_FIELDENCODING_DATAVALUE;
+            if(currentTokenType(ctx) == CJ5_TOKEN_OBJECT &&
+               lookAheadForKey(ctx, "Type", &searchResult) == UA_STATUSCODE_GOOD &&
+               lookAheadForKey(ctx, "Body", &searchResult) == UA_STATUSCODE_GOOD)
+                dsm->header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+        }
+
+        if(dsm->header.fieldEncoding == UA_FIELDENCODING_VARIANT) {
+            ret = decodeScalarVariantField(ctx, &fields[i].value, &md->fields[i]);
+            if(ret == UA_STATUSCODE_BADTYPEMISMATCH)
+                ret = decodeJsonJumpTable[UA_DATATYPEKIND_VARIANT]
+                    (ctx, &fields[i].value, &UA_TYPES[UA_TYPES_VARIANT]);
+        } else {
+            ret = decodeJsonJumpTable[UA_DATATYPEKIND_DATAVALUE]
+                (ctx, &fields[i], &UA_TYPES[UA_TYPES_DATAVALUE]);
+        }
+        if(ret != UA_STATUSCODE_GOOD)
+            return ret;
+        fields[i].hasValue = true;
+    }
+    return ret;
+}
+
+static status
+DataSetPayload_decodeJsonInternal(ParseCtx *ctx, void* pdP, const UA_DataType *type) {
+    PayloadDecode *pd = (PayloadDecode*)pdP;
+    UA_DataSetMessage* dsm = pd->dsm;
     dsm->header.dataSetMessageValid = true;
     if(currentTokenType(ctx) == CJ5_TOKEN_NULL) {
         ctx->index++;
@@ -280,6 +679,26 @@ DataSetPayload_decodeJsonInternal(ParseCtx *ctx, void* dsmP, const UA_DataType *
     if(currentTokenType(ctx) != CJ5_TOKEN_OBJECT)
         return UA_STATUSCODE_BADDECODINGERROR;
 
+    /* Schema-driven decoding with the expected DataSetMetaData. Fall back to
+     * the generic decoding if the payload deviates. */
+    const MetaDataLookup *mdl = (const MetaDataLookup*)ctx->customSchema;
+    if(mdl && *pd->dataSetWriterIdFound) {
+        const UA_DataSetMetaDataType *md =
+            mdl->lookup(mdl->context, *pd->dataSetWriterId);
+        if(md) {
+            size_t begin = ctx->index;
+            status res = DataSetPayload_decodeJsonSchema(ctx, dsm, md);
+            if(res == UA_STATUSCODE_GOOD)
+                return res;
+            UA_Array_delete(dsm->data.keyFrameData.dataSetFields,
+                            dsm->data.keyFrameData.fieldCount,
+                            &UA_TYPES[UA_TYPES_DATAVALUE]);
+            dsm->data.keyFrameData.dataSetFields = NULL;
+            dsm->data.keyFrameData.fieldCount = 0;
+            ctx->index = begin;
+        }
+    }
+
     /* The number of key-value pairs */
     UA_assert(ctx->tokens[ctx->index].size % 2 == 0);
     size_t length = (size_t)(ctx->tokens[ctx->index].size) / 2;
@@ -333,6 +752,7 @@ DatasetMessage_Payload_decodeJsonInternal(ParseCtx *ctx, UA_DataSetMessage* dsm,
                                           const UA_DataType *type) {
     UA_ConfigurationVersionDataType cvd;
     UA_UInt16 dataSetWriterId;
+    PayloadDecode pd = {dsm, &dataSetWriterId, NULL};
 
     dsm->header.fieldEncoding = UA_FIELDENCODING_DATAVALUE;
 
@@ -342,8 +762,9 @@ DatasetMessage_Payload_decodeJsonInternal(ParseCtx *ctx, UA_DataSetMessage* dsm,
         {UA_DECODEKEY_METADATAVERSION, &cvd, &MetaDataVersion_decodeJsonInternal, false, NULL},
         {UA_DECODEKEY_TIMESTAMP, &dsm->header.timestamp, NULL, false, &UA_TYPES[UA_TYPES_DATETIME]},
         {UA_DECODEKEY_DSM_STATUS, &dsm->header.status, NULL, false, &UA_TYPES[UA_TYPES_UINT16]},
-        {UA_DECODEKEY_PAYLOAD, dsm, &DataSetPayload_decodeJsonInternal, false, NULL}
+        {UA_DECODEKEY_PAYLOAD, &pd, &DataSetPayload_decodeJsonInternal, false, NULL}
     };
+    pd.dataSetWriterIdFound = &entries[0].found;
     status ret = decodeFields(ctx, entries, 6);
 
     /* Error or no DatasetWriterId found or no payload found */
@@ -508,19 +929,36 @@ NetworkMessage_decodeJsonInternal(ParseCtx *ctx, UA_NetworkMessage *dst) {
     return ret;
 }
 
-status
-UA_NetworkMessage_decodeJson(UA_NetworkMessage *dst, const UA_ByteString *src) {
+static status
+NetworkMessage_decodeJson(UA_NetworkMessage *dst, const UA_ByteString *src,
+                          const MetaDataLookup *mdl) {
     /* Set up the context */
+    cj5_token tokens[UA_JSON_MAXTOKENCOUNT];
     ParseCtx ctx;
     memset(&ctx, 0, sizeof(ParseCtx));
-    ctx.tokens = (cj5_token*)
-        UA_calloc(UA_JSON_MAXTOKENCOUNT, sizeof(cj5_token));
-    if(!ctx.tokens)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+    ctx.tokens = tokens;
+    ctx.customSchema = mdl;
     status ret = tokenize(&ctx, src, UA_JSON_MAXTOKENCOUNT);
-    if(ret != UA_STATUSCODE_GOOD)
-        return ret;
-    ret = NetworkMessage_decodeJsonInternal(&ctx, dst);
-    UA_free((void*)(uintptr_t)ctx.tokens);
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = NetworkMessage_decodeJsonInternal(&ctx, dst);
+
+    /* Free token array on the heap */
+    if(ctx.tokens != tokens)
+        UA_free((void*)(uintptr_t)ctx.tokens);
     return ret;
 }
+
+status
+UA_NetworkMessage_decodeJson(UA_NetworkMessage *dst, const UA_ByteString *src) {
+    return NetworkMessage_decodeJson(dst, src, NULL);
+}
+
+status
+UA_NetworkMessage_decodeJsonWithMetaData(UA_NetworkMessage *dst, const UA_ByteString *src,
+                                         UA_NetworkMessage_metaDataLookup lookup,
+                                         void *lookupContext) {
+    if(!lookup)
+        return NetworkMessage_decodeJson(dst, src, NULL);
+    MetaDataLookup mdl = {lookup, lookupContext};
+    return NetworkMessage_decodeJson(dst, src, &mdl);
+}
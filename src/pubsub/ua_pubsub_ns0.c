@@ -860,8 +860,9 @@ removeConnectionAction(UA_Server *server,
 /*               DataSetReader                */
 /**********************************************/
 
-UA_StatusCode
-addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReader){
+static UA_StatusCode
+addDataSetReaderNodes(UA_Server *server, UA_DataSetReader *dataSetReader,
+                      const UA_NodeId requestedId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     if(dataSetReader->config.name.length > 512)
@@ -876,7 +877,7 @@ addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReade
 
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", dsrName);
-    retVal = addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* create an id */
+    retVal = addNode(server, UA_NODECLASS_OBJECT, requestedId,
                      dataSetReader->linkedReaderGroup->identifier,
                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASDATASETREADER),
                      UA_QUALIFIEDNAME(0, dsrName),
@@ -947,6 +948,20 @@ addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReade
     return retVal;
 }
 
+UA_StatusCode
+addDataSetReaderRepresentation(UA_Server *server, UA_DataSetReader *dataSetReader) {
+    /* Only reserve the NodeId. The nodes are added on demand. */
+    if(server->config.pubSubConfig.lazyInformationModel) {
+        dataSetReader->identifier =
+            UA_NODEID_GUID(1, UA_PubSubManager_generateUniqueGuid(server));
+        dataSetReader->representationPending = true;
+        server->pubSubManager.pendingRepresentations++;
+        invalidateBrowseCache(server); /* Browse results are incomplete */
+        return UA_STATUSCODE_GOOD;
+    }
+    return addDataSetReaderNodes(server, dataSetReader, UA_NODEID_NUMERIC(1, 0));
+}
+
 static UA_StatusCode
 addDataSetReaderLocked(UA_Server *server,
                        const UA_NodeId *sessionId, void *sessionContext,
@@ -1824,9 +1839,9 @@ addSecurityGroupRepresentation(UA_Server *server, UA_SecurityGroup *securityGrou
 /*               DataSetWriter                */
 /**********************************************/
 
-UA_StatusCode
-addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWriter) {
-
+static UA_StatusCode
+addDataSetWriterNodes(UA_Server *server, UA_DataSetWriter *dataSetWriter,
+                      const UA_NodeId requestedId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
@@ -1839,7 +1854,7 @@ addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWrite
 
     UA_ObjectAttributes object_attr = UA_ObjectAttributes_default;
     object_attr.displayName = UA_LOCALIZEDTEXT("", dswName);
-    retVal = addNode(server, UA_NODECLASS_OBJECT, UA_NODEID_NUMERIC(1, 0), /* create an id */
+    retVal = addNode(server, UA_NODECLASS_OBJECT, requestedId,
                      dataSetWriter->linkedWriterGroup->identifier,
                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASDATASETWRITER),
                      UA_QUALIFIEDNAME(0, dswName),
@@ -1934,6 +1949,20 @@ addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWrite
     return retVal;
 }
 
+UA_StatusCode
+addDataSetWriterRepresentation(UA_Server *server, UA_DataSetWriter *dataSetWriter) {
+    /* Only reserve the NodeId. The nodes are added on demand. */
+    if(server->config.pubSubConfig.lazyInformationModel) {
+        dataSetWriter->identifier =
+            UA_NODEID_GUID(1, UA_PubSubManager_generateUniqueGuid(server));
+        dataSetWriter->representationPending = true;
+        server->pubSubManager.pendingRepresentations++;
+        invalidateBrowseCache(server); /* Browse results are incomplete */
+        return UA_STATUSCODE_GOOD;
+    }
+    return addDataSetWriterNodes(server, dataSetWriter, UA_NODEID_NUMERIC(1, 0));
+}
+
 static UA_StatusCode
 addDataSetWriterLocked(UA_Server *server,
                        const UA_NodeId *sessionId, void *sessionContext,
@@ -2654,4 +2683,97 @@ connectDataSetReaderToDataSet(UA_Server *server, UA_NodeId dsrId, UA_NodeId stan
     return retVal;
 }
 
+/* Lazy Information Model
+ * ~~~~~~~~~~~~~~~~~~~~~~
+ * With the lazyInformationModel option, the nodes of DataSetWriters and
+ * DataSetReaders are added when they are first needed for browsing. The
+ * reserved NodeIds are GUIDs. So they cannot collide with the numerical
+ * NodeIds created by the Nodestore in the meantime. */
+
+static void
+materializeDataSetWriter(UA_Server *server, UA_DataSetWriter *dsw) {
+    dsw->representationPending = false;
+    server->pubSubManager.pendingRepresentations--;
+    UA_StatusCode res = addDataSetWriterNodes(server, dsw, dsw->identifier);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING_WRITER(server->config.logging, dsw,
+                              "Adding the information model representation "
+                              "failed with StatusCode %s", UA_StatusCode_name(res));
+}
+
+static void
+materializeDataSetReader(UA_Server *server, UA_DataSetReader *dsr) {
+    dsr->representationPending = false;
+    server->pubSubManager.pendingRepresentations--;
+    UA_StatusCode res = addDataSetReaderNodes(server, dsr, dsr->identifier);
+    if(res == UA_STATUSCODE_GOOD &&
+       !UA_String_isEmpty(&dsr->config.linkedStandaloneSubscribedDataSetName)) {
+        UA_StandaloneSubscribedDataSet *sds =
+            UA_StandaloneSubscribedDataSet_findSDSbyName(server,
+                  dsr->config.linkedStandaloneSubscribedDataSetName);
+        if(sds)
+            connectDataSetReaderToDataSet(server, dsr->identifier, sds->identifier);
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING_READER(server->config.logging, dsr,
+                              "Adding the information model representation "
+                              "failed with StatusCode %s", UA_StatusCode_name(res));
+}
+
+void
+UA_PubSubManager_materializeNode(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    /* Nothing pending or already adding nodes (the browse is internal) */
+    UA_PubSubManager *psm = &server->pubSubManager;
+    if(psm->pendingRepresentations == 0 || psm->materializing)
+        return;
+    psm->materializing = true;
+
+    /* The groups have numeric NodeIds. The reserved NodeIds of the writers and
+     * readers are GUIDs. */
+    UA_Boolean component = (nodeId->identifierType == UA_NODEIDTYPE_GUID);
+    UA_PubSubConnection *c;
+    TAILQ_FOREACH(c, &psm->connections, listEntry) {
+        UA_WriterGroup *wg;
+        LIST_FOREACH(wg, &c->writerGroups, listEntry) {
+            UA_Boolean match = UA_NodeId_equal(&wg->identifier, nodeId);
+            UA_DataSetWriter *dsw;
+            LIST_FOREACH(dsw, &wg->writers, listEntry) {
+                if(!dsw->representationPending)
+                    continue;
+                if(match) {
+                    materializeDataSetWriter(server, dsw);
+                } else if(component && UA_NodeId_equal(&dsw->identifier, nodeId)) {
+                    materializeDataSetWriter(server, dsw);
+                    goto done;
+                }
+            }
+            if(match)
+                goto done;
+        }
+
+        UA_ReaderGroup *rg;
+        LIST_FOREACH(rg, &c->readerGroups, listEntry) {
+            UA_Boolean match = UA_NodeId_equal(&rg->identifier, nodeId);
+            UA_DataSetReader *dsr;
+            LIST_FOREACH(dsr, &rg->readers, listEntry) {
+                if(!dsr->representationPending)
+                    continue;
+                if(match) {
+                    materializeDataSetReader(server, dsr);
+                } else if(component && UA_NodeId_equal(&dsr->identifier, nodeId)) {
+                    materializeDataSetReader(server, dsr);
+                    goto done;
+                }
+            }
+            if(match)
+                goto done;
+        }
+    }
+
+ done:
+    psm->materializing = false;
+}
+
 #endif /* UA_ENABLE_PUBSUB_INFORMATIONMODEL */
@@ -61,6 +61,140 @@ publisherIdIsMatching(UA_NetworkMessage *msg, UA_Variant publisherId) {
     return true;
 }
 
+enum ZIP_CMP
+cmpDataSetReaderKey(const UA_DataSetReaderKey *a, const UA_DataSetReaderKey *b) {
+    if(a->hash != b->hash)
+        return (a->hash < b->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdType != b->publisherIdType)
+        return (a->publisherIdType < b->publisherIdType) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->writerGroupId != b->writerGroupId)
+        return (a->writerGroupId < b->writerGroupId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->dataSetWriterId != b->dataSetWriterId)
+        return (a->dataSetWriterId < b->dataSetWriterId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->publisherIdType != UA_PUBLISHERIDTYPE_STRING) {
+        if(a->publisherId == b->publisherId)
+            return ZIP_CMP_EQ;
+        return (a->publisherId < b->publisherId) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    }
+    return (enum ZIP_CMP)UA_order(&a->publisherIdString, &b->publisherIdString,
+                                  &UA_TYPES[UA_TYPES_STRING]);
+}
+
+static void
+hashDataSetReaderKey(UA_DataSetReaderKey *key) {
+    UA_UInt32 h = (UA_UInt32)key->publisherIdType;
+    if(key->publisherIdType == UA_PUBLISHERIDTYPE_STRING)
+        h = UA_ByteString_hash(h, key->publisherIdString.data,
+                               key->publisherIdString.length);
+    else
+        h = UA_ByteString_hash(h, (const UA_Byte*)&key->publisherId,
+                               sizeof(UA_UInt64));
+    h = UA_ByteString_hash(h, (const UA_Byte*)&key->writerGroupId, sizeof(UA_UInt16));
+    key->hash = UA_ByteString_hash(h, (const UA_Byte*)&key->dataSetWriterId,
+                                   sizeof(UA_UInt16));
+}
+
+/* Readers with a PublisherId of an unsupported type are not indexed. They
+ * cannot match a NetworkMessage that contains a PublisherId. */
+static UA_Boolean
+setDataSetReaderKey(UA_DataSetReader *dsr) {
+    UA_DataSetReaderKey *key = &dsr->indexKey;
+    memset(key, 0, sizeof(UA_DataSetReaderKey));
+    const UA_Variant *pid = &dsr->config.publisherId;
+    if(!UA_Variant_isScalar(pid))
+        return false;
+    if(pid->type == &UA_TYPES[UA_TYPES_BYTE]) {
+        key->publisherIdType = UA_PUBLISHERIDTYPE_BYTE;
+        key->publisherId = *(UA_Byte*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT16]) {
+        key->publisherIdType = UA_PUBLISHERIDTYPE_UINT16;
+        key->publisherId = *(UA_UInt16*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT32]) {
+        key->publisherIdType = UA_PUBLISHERIDTYPE_UINT32;
+        key->publisherId = *(UA_UInt32*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_UINT64]) {
+        key->publisherIdType = UA_PUBLISHERIDTYPE_UINT64;
+        key->publisherId = *(UA_UInt64*)pid->data;
+    } else if(pid->type == &UA_TYPES[UA_TYPES_STRING]) {
+        key->publisherIdType = UA_PUBLISHERIDTYPE_STRING;
+        key->publisherIdString = *(UA_String*)pid->data;
+    } else {
+        return false;
+    }
+    key->writerGroupId = dsr->config.writerGroupId;
+    key->dataSetWriterId = dsr->config.dataSetWriterId;
+    hashDataSetReaderKey(key);
+    return true;
+}
+
+static void
+addToReaderIndex(UA_DataSetReader *dsr) {
+    if(setDataSetReaderKey(dsr))
+        ZIP_INSERT(UA_DataSetReaderIndex,
+                   &dsr->linkedReaderGroup->linkedConnection->readerIndex, dsr);
+}
+
+static void
+removeFromReaderIndex(UA_DataSetReader *dsr) {
+    /* Not found (and ignored) if the reader was not indexed */
+    ZIP_REMOVE(UA_DataSetReaderIndex,
+               &dsr->linkedReaderGroup->linkedConnection->readerIndex, dsr);
+}
+
+typedef struct {
+    UA_Server *server;
+    UA_DataSetMessage *dsm;
+    UA_Boolean processed;
+} ProcessIndexedContext;
+
+static void *
+processIndexedReader(void *context, UA_DataSetReader *dsr) {
+    ProcessIndexedContext *ctx = (ProcessIndexedContext*)context;
+    UA_ReaderGroup *rg = dsr->linkedReaderGroup;
+    if(rg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE ||
+       (rg->state != UA_PUBSUBSTATE_OPERATIONAL &&
+        rg->state != UA_PUBSUBSTATE_PREOPERATIONAL) ||
+       (dsr->state != UA_PUBSUBSTATE_OPERATIONAL &&
+        dsr->state != UA_PUBSUBSTATE_PREOPERATIONAL))
+        return NULL;
+    ctx->processed = true;
+    UA_DataSetReader_process(ctx->server, dsr, ctx->dsm);
+    return NULL;
+}
+
+UA_Boolean
+UA_DataSetReader_processIndexed(UA_Server *server, UA_PubSubConnection *c,
+                                UA_NetworkMessage *nm) {
+    UA_assert(nm->publisherIdEnabled && nm->payloadHeaderEnabled &&
+              nm->groupHeaderEnabled && nm->groupHeader.writerGroupIdEnabled);
+
+    UA_DataSetReaderKey key;
+    memset(&key, 0, sizeof(UA_DataSetReaderKey));
+    key.publisherIdType = nm->publisherIdType;
+    switch(nm->publisherIdType) {
+    case UA_PUBLISHERIDTYPE_BYTE: key.publisherId = nm->publisherId.byte; break;
+    case UA_PUBLISHERIDTYPE_UINT16: key.publisherId = nm->publisherId.uint16; break;
+    case UA_PUBLISHERIDTYPE_UINT32: key.publisherId = nm->publisherId.uint32; break;
+    case UA_PUBLISHERIDTYPE_UINT64: key.publisherId = nm->publisherId.uint64; break;
+    case UA_PUBLISHERIDTYPE_STRING: key.publisherIdString = nm->publisherId.string; break;
+    default: return false;
+    }
+    key.writerGroupId = nm->groupHeader.writerGroupId;
+
+    ProcessIndexedContext ctx;
+    ctx.server = server;
+    ctx.processed = false;
+    UA_DataSetPayloadHeader *ph = &nm->payloadHeader.dataSetPayloadHeader;
+    for(UA_Byte i = 0; i < ph->count; i++) {
+        key.dataSetWriterId = ph->dataSetWriterIds[i];
+        hashDataSetReaderKey(&key);
+        ctx.dsm = &nm->payload.dataSetPayload.dataSetMessages[i];
+        ZIP_ITER_KEY(UA_DataSetReaderIndex, &c->readerIndex, &key,
+                     processIndexedReader, &ctx);
+    }
+    return ctx.processed;
+}
+
 UA_StatusCode
 UA_DataSetReader_checkIdentifier(UA_Server *server, UA_NetworkMessage *msg,
                                  UA_DataSetReader *reader,
@@ -186,6 +320,10 @@ UA_DataSetReader_create(UA_Server *server, UA_NodeId readerGroupIdentifier,
     /* Add the new reader to the group */
     LIST_INSERT_HEAD(&readerGroup->readers, newDataSetReader, listEntry);
     readerGroup->readersCount++;
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newDataSetReader->idEntry,
+                                    UA_PUBSUBINDEX_DATASETREADER,
+                                    &newDataSetReader->identifier, newDataSetReader);
+    addToReaderIndex(newDataSetReader);
 
     if(!UA_String_isEmpty(&newDataSetReader->config.linkedStandaloneSubscribedDataSetName)) {
         // find sds by name
@@ -238,8 +376,10 @@ UA_DataSetReader_create(UA_Server *server, UA_NodeId readerGroupIdentifier,
                     UA_free(targetVars);
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
-                    connectDataSetReaderToDataSet(server, newDataSetReader->identifier,
-                                                  subscribedDataSet->identifier);
+                    /* Connected when the pending nodes are added */
+                    if(!newDataSetReader->representationPending)
+                        connectDataSetReaderToDataSet(server, newDataSetReader->identifier,
+                                                      subscribedDataSet->identifier);
 #endif
                 }
             }
@@ -298,7 +438,10 @@ UA_DataSetReader_remove(UA_Server *server, UA_DataSetReader *dsr) {
     }
 
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
-    deleteNode(server, dsr->identifier, true);
+    if(dsr->representationPending)
+        server->pubSubManager.pendingRepresentations--;
+    else
+        deleteNode(server, dsr->identifier, true);
 #endif
 
 #ifdef UA_ENABLE_PUBSUB_MONITORING
@@ -336,6 +479,9 @@ UA_DataSetReader_remove(UA_Server *server, UA_DataSetReader *dsr) {
         }
     }
 
+    /* Remove from the index before the config is deleted */
+    removeFromReaderIndex(dsr);
+
     /* Delete DataSetReader config */
     UA_DataSetReaderConfig_clear(&dsr->config);
 
@@ -343,6 +489,7 @@ UA_DataSetReader_remove(UA_Server *server, UA_DataSetReader *dsr) {
     LIST_REMOVE(dsr, listEntry);
     UA_ReaderGroup *rg = dsr->linkedReaderGroup;
     rg->readersCount--;
+    UA_PubSubManager_unindexComponent(&server->pubSubManager, &dsr->idEntry);
 
     /* THe offset buffer is only set when the dsr is frozen
      * UA_NetworkMessageOffsetBuffer_clear(&dsr->bufferedMessage); */
@@ -395,10 +542,13 @@ DataSetReader_updateConfig(UA_Server *server, UA_ReaderGroup *rg, UA_DataSetRead
 
     /* The update functionality will be extended during the next PubSub batches.
      * Currently changes for writerGroupId, dataSetWriterId and TargetVariables are possible. */
-    if(dsr->config.writerGroupId != config->writerGroupId)
+    if(dsr->config.writerGroupId != config->writerGroupId ||
+       dsr->config.dataSetWriterId != config->dataSetWriterId) {
+        removeFromReaderIndex(dsr);
         dsr->config.writerGroupId = config->writerGroupId;
-    if(dsr->config.dataSetWriterId != config->dataSetWriterId)
         dsr->config.dataSetWriterId = config->dataSetWriterId;
+        addToReaderIndex(dsr);
+    }
 
     UA_TargetVariables *oldTV = &dsr->config.subscribedDataSet.subscribedDataSetTarget;
     const UA_TargetVariables *newTV = &config->subscribedDataSet.subscribedDataSetTarget;
@@ -422,7 +572,7 @@ DataSetReader_updateConfig(UA_Server *server, UA_ReaderGroup *rg, UA_DataSetRead
     if(dsr->config.messageReceiveTimeout != config->messageReceiveTimeout) {
         /* Update message receive timeout timer interval */
         dsr->config.messageReceiveTimeout = config->messageReceiveTimeout;
-        if(dsr->msgRcvTimeoutTimerId != 0) {
+        if(dsr->msgRcvTimeoutTimerRunning) {
             res = server->config.pubSubConfig.monitoringInterface.
                 updateMonitoringInterval(server, dsr->identifier,
                                          UA_PUBSUB_COMPONENT_DATASETREADER,
@@ -795,6 +945,39 @@ UA_Server_DataSetReader_createDataSetMirror(UA_Server *server, UA_String *parent
     return retval;
 }*/
 
+/* Copy the field directly into the external DataValue of the target variable.
+ * Returns false if the field cannot be copied with a memcpy. Then the Write
+ * service is used instead. */
+static UA_Boolean
+writeExternalTargetVariable(UA_Server *server, UA_DataSetReader *dsr,
+                            UA_FieldTargetVariable *tv, UA_DataValue *field) {
+    if(!tv->externalDataValue || !*tv->externalDataValue ||
+       tv->targetVariable.attributeId != UA_ATTRIBUTEID_VALUE ||
+       tv->targetVariable.receiverIndexRange.length > 0)
+        return false;
+
+    UA_Variant *ext = &(*tv->externalDataValue)->value;
+    const UA_Variant *val = &field->value;
+    if(!val->type || val->type != ext->type || !val->type->pointerFree ||
+       val->arrayLength != ext->arrayLength || val->arrayDimensionsSize > 0 ||
+       ext->data <= UA_EMPTY_ARRAY_SENTINEL || val->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return false;
+
+    if(tv->beforeWrite) {
+        UA_DataValue *tmp = field;
+        tv->beforeWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
+                        &tv->targetVariable.targetNodeId,
+                        tv->targetVariableContext, &tmp);
+    }
+    size_t count = (val->arrayLength > 0) ? val->arrayLength : 1;
+    memcpy(ext->data, val->data, val->type->memSize * count);
+    if(tv->afterWrite)
+        tv->afterWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
+                       &tv->targetVariable.targetNodeId,
+                       tv->targetVariableContext, tv->externalDataValue);
+    return true;
+}
+
 static void
 DataSetReader_processRaw(UA_Server *server, UA_DataSetReader *dsr,
                          UA_DataSetMessage* msg) {
@@ -903,7 +1086,8 @@ else
             UA_Variant_setScalar(&writeVal.value.value, value, type);
         }
         writeVal.value.hasValue = true;
-        Operation_Write(server, &server->adminSession, NULL, &writeVal, &res);
+        if(!writeExternalTargetVariable(server, dsr, tv, &writeVal.value))
+            Operation_Write(server, &server->adminSession, NULL, &writeVal, &res);
         UA_clear(value, type);
         if(res != UA_STATUSCODE_GOOD) {
             UA_LOG_INFO_READER(server->config.logging, dsr,
@@ -913,40 +1097,96 @@ else
     }
 }
 
+static void
+DataSetReader_processFixedSizeField(UA_Server *server, UA_DataSetReader *dsr,
+                                    UA_FieldTargetVariable *tv, UA_DataValue *field) {
+    if(tv->targetVariable.attributeId != UA_ATTRIBUTEID_VALUE)
+        return;
+
+    if(field->value.type != (*tv->externalDataValue)->value.type) {
+        UA_LOG_WARNING_READER(server->config.logging, dsr,
+                              "Mismatching type");
+        return;
+    }
+
+    if (tv->beforeWrite) {
+        UA_DataValue *tmp = field;
+        tv->beforeWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
+                        &tv->targetVariable.targetNodeId,
+                        tv->targetVariableContext, &tmp);
+    }
+    if(UA_LIKELY(tv->externalDataValue != NULL)) {
+        memcpy((**tv->externalDataValue).value.data,
+               field->value.data, field->value.type->memSize);
+    }
+    if(tv->afterWrite)
+        tv->afterWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
+                       &tv->targetVariable.targetNodeId,
+                       tv->targetVariableContext, tv->externalDataValue);
+}
+
 static void
 DataSetReader_processFixedSize(UA_Server *server, UA_DataSetReader *dsr,
                                UA_DataSetMessage *msg, size_t fieldCount) {
     for(size_t i = 0; i < fieldCount; i++) {
         if(!msg->data.keyFrameData.dataSetFields[i].hasValue)
             continue;
-
         UA_FieldTargetVariable *tv =
             &dsr->config.subscribedDataSet.subscribedDataSetTarget.targetVariables[i];
-        if(tv->targetVariable.attributeId != UA_ATTRIBUTEID_VALUE)
-            continue;
+        DataSetReader_processFixedSizeField(server, dsr, tv,
+                                            &msg->data.keyFrameData.dataSetFields[i]);
+    }
+}
 
-        if(msg->data.keyFrameData.dataSetFields[i].value.type !=
-           (*tv->externalDataValue)->value.type) {
-            UA_LOG_WARNING_READER(server->config.logging, dsr,
-                                  "Mismatching type");
-            continue;
-        }
+/* Write the field via the write service (non realtime) */
+static void
+DataSetReader_writeField(UA_Server *server, UA_DataSetReader *dsr,
+                         size_t index, UA_DataValue *field) {
+    UA_FieldTargetVariable *tv =
+        &dsr->config.subscribedDataSet.subscribedDataSetTarget.targetVariables[index];
+    if(writeExternalTargetVariable(server, dsr, tv, field))
+        return;
 
-        if (tv->beforeWrite) {
-            UA_DataValue *tmp = &msg->data.keyFrameData.dataSetFields[i];
-            tv->beforeWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
-                            &tv->targetVariable.targetNodeId,
-                            tv->targetVariableContext, &tmp);
+    UA_WriteValue writeVal;
+    UA_WriteValue_init(&writeVal);
+    writeVal.attributeId = tv->targetVariable.attributeId;
+    writeVal.indexRange = tv->targetVariable.receiverIndexRange;
+    writeVal.nodeId = tv->targetVariable.targetNodeId;
+    writeVal.value = *field;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    Operation_Write(server, &server->adminSession, NULL, &writeVal, &res);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_INFO_READER(server->config.logging, dsr,
+                           "Error writing field %u: %s",
+                           (unsigned)index, UA_StatusCode_name(res));
+}
+
+/* Delta frames contain only the changed fields. The other target variables
+ * keep the value from the last key frame (or delta frame). */
+static void
+DataSetReader_processDeltaFrame(UA_Server *server, UA_DataSetReader *dsr,
+                                UA_DataSetMessage *msg) {
+    size_t fieldsSize = dsr->config.dataSetMetaData.fieldsSize;
+    size_t targetsSize =
+        dsr->config.subscribedDataSet.subscribedDataSetTarget.targetVariablesSize;
+    UA_DataSetMessage_DataDeltaFrameData *dfd = &msg->data.deltaFrameData;
+    for(size_t i = 0; i < dfd->fieldCount; i++) {
+        UA_DataSetMessage_DeltaFrameField *f = &dfd->deltaFrameFields[i];
+        if(f->fieldIndex >= fieldsSize || f->fieldIndex >= targetsSize) {
+            UA_LOG_INFO_READER(server->config.logging, dsr,
+                               "DeltaFrame field index %u out of range",
+                               (unsigned)f->fieldIndex);
+            continue;
         }
-        if(UA_LIKELY(tv->externalDataValue != NULL)) {
-            memcpy((**tv->externalDataValue).value.data,
-                   msg->data.keyFrameData.dataSetFields[i].value.data,
-                   msg->data.keyFrameData.dataSetFields[i].value.type->memSize);
+        if(!f->fieldValue.hasValue)
+            continue;
+        if(dsr->linkedReaderGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
+            UA_FieldTargetVariable *tv = &dsr->config.subscribedDataSet.
+                subscribedDataSetTarget.targetVariables[f->fieldIndex];
+            DataSetReader_processFixedSizeField(server, dsr, tv, &f->fieldValue);
+        } else {
+            DataSetReader_writeField(server, dsr, f->fieldIndex, &f->fieldValue);
         }
-        if(tv->afterWrite)
-            tv->afterWrite(server, &dsr->identifier, &dsr->linkedReaderGroup->identifier,
-                           &tv->targetVariable.targetNodeId,
-                           tv->targetVariableContext, tv->externalDataValue);
     }
 }
 
@@ -1003,9 +1243,19 @@ UA_DataSetReader_process(UA_Server *server, UA_DataSetReader *dsr,
         return;
     }
 
+    /* Apply the changed fields of a delta frame */
+    if(msg->header.dataSetMessageType == UA_DATASETMESSAGE_DATADELTAFRAME) {
+        DataSetReader_processDeltaFrame(server, dsr, msg);
+#ifdef UA_ENABLE_PUBSUB_MONITORING
+        UA_DataSetReader_checkMessageReceiveTimeout(server, dsr);
+#endif
+        return;
+    }
+
     if(msg->header.dataSetMessageType != UA_DATASETMESSAGE_DATAKEYFRAME) {
         UA_LOG_WARNING_READER(server->config.logging, dsr,
-                       "DataSetMessage is discarded: Only keyframes are supported");
+                       "DataSetMessage is discarded: Only key and delta "
+                       "frames are supported");
         return;
     }
 
@@ -1037,25 +1287,10 @@ UA_DataSetReader_process(UA_Server *server, UA_DataSetReader *dsr,
     }
 
     /* Write the message fields via the write service (non realtime) */
-    UA_StatusCode res = UA_STATUSCODE_GOOD;
     for(size_t i = 0; i < fieldCount; i++) {
-        if(!msg->data.keyFrameData.dataSetFields[i].hasValue)
-            continue;
-
-        UA_FieldTargetVariable *tv =
-            &dsr->config.subscribedDataSet.subscribedDataSetTarget.targetVariables[i];
-
-        UA_WriteValue writeVal;
-        UA_WriteValue_init(&writeVal);
-        writeVal.attributeId = tv->targetVariable.attributeId;
-        writeVal.indexRange = tv->targetVariable.receiverIndexRange;
-        writeVal.nodeId = tv->targetVariable.targetNodeId;
-        writeVal.value = msg->data.keyFrameData.dataSetFields[i];
-        Operation_Write(server, &server->adminSession, NULL, &writeVal, &res);
-        if(res != UA_STATUSCODE_GOOD)
-            UA_LOG_INFO_READER(server->config.logging, dsr,
-                               "Error writing KeyFrame field %u: %s",
-                               (unsigned)i, UA_StatusCode_name(res));
+        if(msg->data.keyFrameData.dataSetFields[i].hasValue)
+            DataSetReader_writeField(server, dsr, i,
+                                     &msg->data.keyFrameData.dataSetFields[i]);
     }
 
 #ifdef UA_ENABLE_PUBSUB_MONITORING
@@ -1130,10 +1365,9 @@ UA_DataSetReader_handleMessageReceiveTimeout(UA_Server *server, UA_DataSetReader
     UA_LOG_DEBUG_READER(server->config.logging, dsr,
                         "UA_DataSetReader_handleMessageReceiveTimeout(): "
                         "MessageReceiveTimeout occurred at DataSetReader "
-                        "'%.*s': MessageReceiveTimeout = %f Timer Id = %u ",
+                        "'%.*s': MessageReceiveTimeout = %f",
                         (int)dsr->config.name.length, dsr->config.name.data,
-                        dsr->config.messageReceiveTimeout,
-                        (UA_UInt32) dsr->msgRcvTimeoutTimerId);
+                        dsr->config.messageReceiveTimeout);
 
     UA_DataSetReader_setPubSubState(server, dsr, UA_PUBSUBSTATE_ERROR);
 }
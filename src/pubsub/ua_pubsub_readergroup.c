@@ -21,31 +21,16 @@
 
 UA_ReaderGroup *
 UA_ReaderGroup_findRGbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_ReaderGroup *rg;
-    UA_PubSubConnection *psc;
-    TAILQ_FOREACH(psc, &server->pubSubManager.connections, listEntry) {
-        LIST_FOREACH(rg, &psc->readerGroups, listEntry) {
-            if(UA_NodeId_equal(&identifier, &rg->identifier))
-                return rg;
-        }
-    }
-    return NULL;
+    return (UA_ReaderGroup*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_READERGROUP, &identifier);
 }
 
 UA_DataSetReader *
 UA_ReaderGroup_findDSRbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_ReaderGroup *rg;
-    UA_PubSubConnection *psc;
-    UA_DataSetReader *tmpReader;
-    TAILQ_FOREACH(psc, &server->pubSubManager.connections, listEntry) {
-        LIST_FOREACH(rg, &psc->readerGroups, listEntry) {
-            LIST_FOREACH(tmpReader, &rg->readers, listEntry) {
-                if(UA_NodeId_equal(&tmpReader->identifier, &identifier))
-                    return tmpReader;
-            }
-        }
-    }
-    return NULL;
+    return (UA_DataSetReader*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_DATASETREADER, &identifier);
 }
 
 /* ReaderGroup Config Handling */
@@ -112,6 +97,15 @@ UA_ReaderGroup_create(UA_Server *server, UA_NodeId connectionId,
         return retval;
     }
 
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+    retval = UA_PubSubArena_init(&newGroup->arena, UA_PUBSUB_ARENASIZE);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_ReaderGroupConfig_clear(&newGroup->config);
+        UA_free(newGroup);
+        return retval;
+    }
+#endif
+
     /* Add to the connection */
     LIST_INSERT_HEAD(&connection->readerGroups, newGroup, listEntry);
     connection->readerGroupsSize++;
@@ -157,6 +151,9 @@ UA_ReaderGroup_create(UA_Server *server, UA_NodeId connectionId,
     UA_PubSubManager_generateUniqueNodeId(&server->pubSubManager,
                                           &newGroup->identifier);
 #endif
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newGroup->idEntry,
+                                    UA_PUBSUBINDEX_READERGROUP,
+                                    &newGroup->identifier, newGroup);
 
     /* Cache the log string */
     UA_String idStr = UA_STRING_NULL;
@@ -227,11 +224,14 @@ UA_ReaderGroup_remove(UA_Server *server, UA_ReaderGroup *rg) {
         UA_DataSetReader_remove(server, dsr);
     }
 
+#ifdef UA_ENABLE_PUBSUB_MONITORING
+    UA_ReaderGroup_stopReceiveTimeoutCheck(server, rg);
+#endif
+
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
-    if(rg->config.securityPolicy && rg->securityPolicyContext) {
-        rg->config.securityPolicy->deleteContext(rg->securityPolicyContext);
-        rg->securityPolicyContext = NULL;
-    }
+    if(rg->config.securityPolicy)
+        deleteSecurityContexts(rg->config.securityPolicy, &rg->securityPolicyContext,
+                               &rg->retiredSecurityPolicyContext);
 #endif
 
 #ifdef UA_ENABLE_PUBSUB_SKS
@@ -250,6 +250,7 @@ UA_ReaderGroup_remove(UA_Server *server, UA_ReaderGroup *rg) {
         /* Unlink from the connection */
         LIST_REMOVE(rg, listEntry);
         connection->readerGroupsSize--;
+        UA_PubSubManager_unindexComponent(&server->pubSubManager, &rg->idEntry);
         rg->linkedConnection = NULL;
 
         /* Actually remove the ReaderGroup */
@@ -262,6 +263,9 @@ UA_ReaderGroup_remove(UA_Server *server, UA_ReaderGroup *rg) {
         UA_ReaderGroupConfig_clear(&rg->config);
         UA_NodeId_clear(&rg->identifier);
         UA_String_clear(&rg->logIdString);
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+        UA_PubSubArena_clear(&rg->arena);
+#endif
         UA_free(rg);
     }
 
@@ -453,23 +457,20 @@ setReaderGroupEncryptionKeys(UA_Server *server, const UA_NodeId readerGroup,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Swap in the new keys. A message that is currently decoded in the RT
+     * receive path is verified with the previous keys. */
+    UA_StatusCode res =
+        rolloverSecurityKeys(rg->config.securityPolicy, &rg->securityPolicyContext,
+                             &rg->retiredSecurityPolicyContext,
+                             &signingKey, &encryptingKey, &keyNonce);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
     if(securityTokenId != rg->securityTokenId) {
         rg->securityTokenId = securityTokenId;
         rg->nonceSequenceNumber = 1;
     }
-
-    /* Create a new context */
-    if(!rg->securityPolicyContext) {
-        return rg->config.securityPolicy->
-            newContext(rg->config.securityPolicy->policyContext,
-                       &signingKey, &encryptingKey, &keyNonce,
-                       &rg->securityPolicyContext);
-    }
-
-    /* Update the context */
-    return rg->config.securityPolicy->
-        setSecurityKeys(rg->securityPolicyContext, &signingKey,
-                        &encryptingKey, &keyNonce);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -641,6 +642,13 @@ UA_Server_unfreezeReaderGroupConfiguration(UA_Server *server,
     return res;
 }
 
+void
+UA_ReaderGroup_setReceived(UA_Server *server, UA_ReaderGroup *rg) {
+    rg->hasReceived = true;
+    if(rg->state == UA_PUBSUBSTATE_PREOPERATIONAL)
+        UA_ReaderGroup_setPubSubState(server, rg, UA_PUBSUBSTATE_OPERATIONAL);
+}
+
 UA_Boolean
 UA_ReaderGroup_process(UA_Server *server, UA_ReaderGroup *readerGroup,
                        UA_NetworkMessage *nm) {
@@ -649,9 +657,7 @@ UA_ReaderGroup_process(UA_Server *server, UA_ReaderGroup *readerGroup,
        readerGroup->state != UA_PUBSUBSTATE_PREOPERATIONAL)
         return false;
 
-    readerGroup->hasReceived = true;
-    if(readerGroup->state == UA_PUBSUBSTATE_PREOPERATIONAL)
-        UA_ReaderGroup_setPubSubState(server, readerGroup, UA_PUBSUBSTATE_OPERATIONAL);
+    UA_ReaderGroup_setReceived(server, readerGroup);
 
     /* Safe iteration. The current Reader might be deleted in the ReaderGroup
      * _setPubSubState callback. */
@@ -712,18 +718,18 @@ UA_ReaderGroup_decodeAndProcessRT(UA_Server *server, UA_ReaderGroup *rg,
     memset(&currentNetworkMessage, 0, sizeof(UA_NetworkMessage));
 
     /* Decode headers necessary for matching identifiers. This can use malloc.
-     * So enable membufAlloc if you need RT timings. Reset back to the normal
-     * malloc before processing the message. The userland (callbacks) below
-     * might rely on that. It needs to be ensured that the membuf-memory is not
-     * reset (zeroed out) in "useNormalAlloc". So the decoded memory can be used
+     * So decode into the arena of the ReaderGroup if you need RT timings.
+     * Reset back to the previous allocator before processing the message. The
+     * userland (callbacks) below might rely on that. The arena memory is only
+     * reset when the arena is entered again. So the decoded memory can be used
      * until the end of this method. */
 #ifdef UA_ENABLE_PUBSUB_BUFMALLOC
-    useMembufAlloc();
+    UA_PubSubArena_enter(&rg->arena);
 #endif
     size_t pos = 0;
     UA_StatusCode rv = UA_NetworkMessage_decodeHeaders(buf, &pos, &currentNetworkMessage);
 #ifdef UA_ENABLE_PUBSUB_BUFMALLOC
-    useNormalAlloc();
+    UA_PubSubArena_leave(&rg->arena);
 #endif
     if(rv != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_READERGROUP(server->config.logging, rg,
@@ -151,3 +151,36 @@ verifyAndDecryptNetworkMessage(const UA_Logger *logger, UA_ByteString *buffer,
 
     return rv;
 }
+
+UA_StatusCode
+rolloverSecurityKeys(const UA_PubSubSecurityPolicy *policy,
+                     void **activeContext, void **retiredContext,
+                     const UA_ByteString *signingKey,
+                     const UA_ByteString *encryptingKey,
+                     const UA_ByteString *keyNonce) {
+    /* Prepare the context with the new keys */
+    void *context = *retiredContext;
+    UA_StatusCode res;
+    if(context)
+        res = policy->setSecurityKeys(context, signingKey, encryptingKey, keyNonce);
+    else
+        res = policy->newContext(policy->policyContext, signingKey,
+                                 encryptingKey, keyNonce, &context);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Publish the context and retire the previous one */
+    *retiredContext = UA_atomic_xchg(activeContext, context);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+deleteSecurityContexts(const UA_PubSubSecurityPolicy *policy,
+                       void **activeContext, void **retiredContext) {
+    if(*activeContext)
+        policy->deleteContext(*activeContext);
+    if(*retiredContext)
+        policy->deleteContext(*retiredContext);
+    *activeContext = NULL;
+    *retiredContext = NULL;
+}
@@ -71,19 +71,9 @@ UA_Server_DataSetWriter_getState(UA_Server *server, UA_NodeId dataSetWriterIdent
 
 UA_DataSetWriter *
 UA_DataSetWriter_findDSWbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_PubSubConnection *pubSubConnection;
-    TAILQ_FOREACH(pubSubConnection, &server->pubSubManager.connections, listEntry){
-        UA_WriterGroup *tmpWriterGroup;
-        LIST_FOREACH(tmpWriterGroup, &pubSubConnection->writerGroups, listEntry){
-            UA_DataSetWriter *tmpWriter;
-            LIST_FOREACH(tmpWriter, &tmpWriterGroup->writers, listEntry){
-                if(UA_NodeId_equal(&tmpWriter->identifier, &identifier)){
-                    return tmpWriter;
-                }
-            }
-        }
-    }
-    return NULL;
+    return (UA_DataSetWriter*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_DATASETWRITER, &identifier);
 }
 
 void
@@ -285,6 +275,9 @@ UA_DataSetWriter_create(UA_Server *server,
     UA_PubSubManager_generateUniqueNodeId(&server->pubSubManager,
                                           &newDataSetWriter->identifier);
 #endif
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newDataSetWriter->idEntry,
+                                    UA_PUBSUBINDEX_DATASETWRITER,
+                                    &newDataSetWriter->identifier, newDataSetWriter);
 
     /* Cache the log string */
     UA_String idStr = UA_STRING_NULL;
@@ -446,13 +439,17 @@ UA_DataSetWriter_remove(UA_Server *server, UA_DataSetWriter *dataSetWriter) {
 
     /* Remove from information model */
 #ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
-    deleteNode(server, dataSetWriter->identifier, true);
+    if(dataSetWriter->representationPending)
+        server->pubSubManager.pendingRepresentations--;
+    else
+        deleteNode(server, dataSetWriter->identifier, true);
 #endif
 
     /* Remove DataSetWriter from group */
     UA_WriterGroup *linkedWriterGroup = dataSetWriter->linkedWriterGroup;
     LIST_REMOVE(dataSetWriter, listEntry);
     linkedWriterGroup->writersCount--;
+    UA_PubSubManager_unindexComponent(&server->pubSubManager, &dataSetWriter->idEntry);
 
     UA_LOG_INFO_WRITER(server->config.logging, dataSetWriter, "Writer deleted");
 
@@ -492,57 +489,11 @@ UA_Server_removeDataSetWriter(UA_Server *server, const UA_NodeId dsw) {
 /*               PublishValues handling                  */
 /*********************************************************/
 
-/* Compare two variants. Internally used for value change detection. */
+/* Compare two variants. Internally used for value change detection. The
+ * values are compared in-place without encoding them first. */
 static UA_Boolean
-valueChangedVariant(UA_Variant *oldValue, UA_Variant *newValue) {
-    if(!oldValue || !newValue)
-        return false;
-
-    size_t oldValueEncodingSize = UA_calcSizeBinary(oldValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    size_t newValueEncodingSize = UA_calcSizeBinary(newValue, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(oldValueEncodingSize == 0 || newValueEncodingSize == 0)
-        return false;
-
-    if(oldValueEncodingSize != newValueEncodingSize)
-        return true;
-
-    UA_ByteString oldValueEncoding = UA_BYTESTRING_NULL;
-    UA_StatusCode res = UA_ByteString_allocBuffer(&oldValueEncoding, oldValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD)
-        return false;
-
-    UA_ByteString newValueEncoding = UA_BYTESTRING_NULL;
-    res = UA_ByteString_allocBuffer(&newValueEncoding, newValueEncodingSize);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_ByteString_clear(&oldValueEncoding);
-        return false;
-    }
-
-    UA_Byte *bufPosOldValue = oldValueEncoding.data;
-    const UA_Byte *bufEndOldValue = &oldValueEncoding.data[oldValueEncoding.length];
-    UA_Byte *bufPosNewValue = newValueEncoding.data;
-    const UA_Byte *bufEndNewValue = &newValueEncoding.data[newValueEncoding.length];
-
-    UA_Boolean compareResult = false; /* default */
-
-    res = UA_encodeBinaryInternal(oldValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosOldValue, &bufEndOldValue, NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    res = UA_encodeBinaryInternal(newValue, &UA_TYPES[UA_TYPES_VARIANT],
-                                  &bufPosNewValue, &bufEndNewValue, NULL, NULL);
-    if(res != UA_STATUSCODE_GOOD)
-        goto cleanup;
-
-    oldValueEncoding.length = (uintptr_t)bufPosOldValue - (uintptr_t)oldValueEncoding.data;
-    newValueEncoding.length = (uintptr_t)bufPosNewValue - (uintptr_t)newValueEncoding.data;
-    compareResult = !UA_ByteString_equal(&oldValueEncoding, &newValueEncoding);
-
- cleanup:
-    UA_ByteString_clear(&oldValueEncoding);
-    UA_ByteString_clear(&newValueEncoding);
-    return compareResult;
+valueChangedVariant(const UA_Variant *oldValue, const UA_Variant *newValue) {
+    return (UA_order(oldValue, newValue, &UA_TYPES[UA_TYPES_VARIANT]) != UA_ORDER_EQ);
 }
 
 static UA_StatusCode
@@ -634,8 +585,10 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_Server *server,
     if(currentDataSet->fieldSize == 0)
         return UA_STATUSCODE_GOOD;
 
+    /* Sample the fields and detect the changes */
     UA_DataSetField *dsf;
-    UA_UInt16 counter = 0;
+    size_t counter = 0;
+    UA_UInt16 changedCount = 0;
     TAILQ_FOREACH(dsf, &currentDataSet->fields, listEntry) {
         /* Sample the value */
         UA_DataValue value;
@@ -645,8 +598,7 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_Server *server,
         /* Check if the value has changed */
         UA_DataSetWriterSample *ls = &dataSetWriter->lastSamples[counter];
         if(valueChangedVariant(&ls->value.value, &value.value)) {
-            /* increase fieldCount for current delta message */
-            dataSetMessage->data.deltaFrameData.fieldCount++;
+            changedCount++;
             ls->valueChanged = true;
 
             /* Update last stored sample */
@@ -660,14 +612,18 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_Server *server,
         counter++;
     }
 
-    /* Allocate DeltaFrameFields */
+    /* No changes. Send a delta frame without fields. */
+    if(changedCount == 0)
+        return UA_STATUSCODE_GOOD;
+
+    /* Allocate DeltaFrameFields only for the changed fields */
     UA_DataSetMessage_DeltaFrameField *deltaFields = (UA_DataSetMessage_DeltaFrameField *)
-        UA_calloc(counter, sizeof(UA_DataSetMessage_DeltaFrameField));
+        UA_calloc(changedCount, sizeof(UA_DataSetMessage_DeltaFrameField));
     if(!deltaFields)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     dataSetMessage->data.deltaFrameData.deltaFrameFields = deltaFields;
-    dataSetMessage->data.deltaFrameData.fieldCount = counter;
+    dataSetMessage->data.deltaFrameData.fieldCount = changedCount;
 
     size_t currentDeltaField = 0;
     for(size_t i = 0; i < currentDataSet->fieldSize; i++) {
@@ -693,7 +649,7 @@ UA_PubSubDataSetWriter_generateDeltaFrameMessage(UA_Server *server,
             dff->fieldValue.hasSourceTimestamp = false;
         if(((u64)dataSetWriter->config.dataSetFieldContentMask &
             (u64)UA_DATASETFIELDCONTENTMASK_SOURCEPICOSECONDS) == 0)
-            dff->fieldValue.hasServerPicoseconds = false;
+            dff->fieldValue.hasSourcePicoseconds = false;
         if(((u64)dataSetWriter->config.dataSetFieldContentMask &
             (u64)UA_DATASETFIELDCONTENTMASK_SERVERTIMESTAMP) == 0)
             dff->fieldValue.hasServerTimestamp = false;
@@ -918,9 +874,11 @@ UA_DataSetWriter_generateDataSetMessage(UA_Server *server,
 
         /* The standard defines: if a PDS contains only one fields no delta messages
          * should be generated because they need more memory than a keyframe with 1
-         * field. */
+         * field. Every keyFrameCount'th message is a key frame. The RawData
+         * encoding has no delta frames. */
         if(currentDataSet->fieldSize > 1 && dataSetWriter->deltaFrameCounter > 0 &&
-           dataSetWriter->deltaFrameCounter <= dataSetWriter->config.keyFrameCount) {
+           dataSetWriter->deltaFrameCounter < dataSetWriter->config.keyFrameCount &&
+           dataSetMessage->header.fieldEncoding != UA_FIELDENCODING_RAWDATA) {
             UA_PubSubDataSetWriter_generateDeltaFrameMessage(server, dataSetMessage,
                                                              dataSetWriter);
             dataSetWriter->deltaFrameCounter++;
@@ -22,7 +22,12 @@
 #include "ua_pubsub_ns0.h"
 #endif
 
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+#include "ua_pubsub_compression.h"
+#endif
+
 #define UA_MAX_STACKBUF 128 /* Max size of network messages on the stack */
+#define UA_WRITERGROUP_MAXJSONTEMPLATES 8 /* Layouts of the frozen JSON publishing */
 
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
 static UA_StatusCode
@@ -39,6 +44,17 @@ generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
                        UA_ExtensionObject *transportSettings,
                        UA_NetworkMessage *networkMessage);
 
+static void
+clearJsonTemplates(UA_WriterGroup *wg) {
+#ifdef UA_ENABLE_JSON_ENCODING
+    for(size_t i = 0; i < wg->jsonTemplatesSize; i++)
+        UA_NetworkMessageJsonTemplate_clear(&wg->jsonTemplates[i]);
+    UA_free(wg->jsonTemplates);
+    wg->jsonTemplates = NULL;
+    wg->jsonTemplatesSize = 0;
+#endif
+}
+
 UA_Boolean
 UA_WriterGroup_canConnect(UA_WriterGroup *wg) {
     /* Already connected */
@@ -53,6 +69,94 @@ UA_WriterGroup_canConnect(UA_WriterGroup *wg) {
     return true;
 }
 
+static void
+publishWriterGroup(UA_Server *server, UA_WriterGroup *writerGroup);
+
+/* Publish all WriterGroups of the schedule in one cycle. If there are several
+ * WriterGroups, then the values read from the information model are shared
+ * between them. */
+static void
+publishScheduleCallback(UA_Server *server, UA_PubSubPublishSchedule *ps) {
+    UA_LOCK(&server->serviceMutex);
+
+    UA_PubSubSampleTree samples;
+    ZIP_INIT(&samples);
+    if(ps->writerGroupsSize > 1)
+        server->pubSubManager.samples = &samples;
+
+    ps->inCycle = true;
+    UA_WriterGroup *wg, *wg_tmp;
+    LIST_FOREACH_SAFE(wg, &ps->connection->writerGroups, listEntry, wg_tmp) {
+        if(wg->publishSchedule == ps)
+            publishWriterGroup(server, wg);
+    }
+    ps->inCycle = false;
+
+    server->pubSubManager.samples = NULL;
+    UA_PubSubSampleTree_clear(&samples);
+
+    /* The last WriterGroup was removed during the cycle */
+    if(ps->deleteFlag)
+        UA_free(ps);
+
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/* Attach the WriterGroup to the schedule of the connection with the same
+ * PublishingInterval. The schedule is created if it does not exist yet. */
+static UA_StatusCode
+addToPublishSchedule(UA_Server *server, UA_WriterGroup *wg) {
+    UA_PubSubConnection *c = wg->linkedConnection;
+    UA_PubSubPublishSchedule *ps;
+    LIST_FOREACH(ps, &c->publishSchedules, listEntry) {
+        if(ps->publishingInterval == wg->config.publishingInterval)
+            break;
+    }
+
+    if(!ps) {
+        ps = (UA_PubSubPublishSchedule*)UA_calloc(1, sizeof(UA_PubSubPublishSchedule));
+        if(!ps)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        ps->connection = c;
+        ps->publishingInterval = wg->config.publishingInterval;
+        UA_EventLoop *el = UA_PubSubConnection_getEL(server, c);
+        UA_StatusCode res =
+            el->addCyclicCallback(el, (UA_Callback)publishScheduleCallback,
+                                  server, ps, ps->publishingInterval,
+                                  NULL /* TODO: use basetime */,
+                                  UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME,
+                                  &ps->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(ps);
+            return res;
+        }
+        LIST_INSERT_HEAD(&c->publishSchedules, ps, listEntry);
+    }
+
+    ps->writerGroupsSize++;
+    wg->publishSchedule = ps;
+    wg->publishCallbackId = ps->callbackId;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeFromPublishSchedule(UA_Server *server, UA_WriterGroup *wg) {
+    UA_PubSubPublishSchedule *ps = wg->publishSchedule;
+    wg->publishSchedule = NULL;
+    ps->writerGroupsSize--;
+    if(ps->writerGroupsSize > 0)
+        return;
+
+    /* Remove the schedule with the last WriterGroup */
+    UA_EventLoop *el = UA_PubSubConnection_getEL(server, ps->connection);
+    el->removeCyclicCallback(el, ps->callbackId);
+    LIST_REMOVE(ps, listEntry);
+    if(ps->inCycle)
+        ps->deleteFlag = true;
+    else
+        UA_free(ps);
+}
+
 UA_StatusCode
 UA_WriterGroup_addPublishCallback(UA_Server *server, UA_WriterGroup *wg) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
@@ -71,13 +175,9 @@ UA_WriterGroup_addPublishCallback(UA_Server *server, UA_WriterGroup *wg) {
                               NULL, UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME,
                               &wg->publishCallbackId);
     } else {
-        /* Use EventLoop for cyclic callbacks */
-        UA_EventLoop *el = UA_PubSubConnection_getEL(server, wg->linkedConnection);
-        retval = el->addCyclicCallback(el, (UA_Callback)UA_WriterGroup_publishCallback,
-                                       server, wg, wg->config.publishingInterval,
-                                       NULL /* TODO: use basetime */,
-                                       UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME,
-                                       &wg->publishCallbackId);
+        /* Use the EventLoop for cyclic callbacks. Shared with the other
+         * WriterGroups of the connection with the same interval. */
+        retval = addToPublishSchedule(server, wg);
     }
 
     return retval;
@@ -90,9 +190,8 @@ UA_WriterGroup_removePublishCallback(UA_Server *server, UA_WriterGroup *wg) {
     if(wg->config.pubsubManagerCallback.removeCustomCallback) {
         wg->config.pubsubManagerCallback.
             removeCustomCallback(server, wg->identifier, wg->publishCallbackId);
-    } else {
-        UA_EventLoop *el = UA_PubSubConnection_getEL(server, wg->linkedConnection);
-        el->removeCyclicCallback(el, wg->publishCallbackId);
+    } else if(wg->publishSchedule) {
+        removeFromPublishSchedule(server, wg);
     }
     wg->publishCallbackId = 0;
 }
@@ -174,6 +273,9 @@ UA_WriterGroup_create(UA_Server *server, const UA_NodeId connection,
     UA_PubSubManager_generateUniqueNodeId(&server->pubSubManager,
                                           &newWriterGroup->identifier);
 #endif
+    UA_PubSubManager_indexComponent(&server->pubSubManager, &newWriterGroup->idEntry,
+                                    UA_PUBSUBINDEX_WRITERGROUP,
+                                    &newWriterGroup->identifier, newWriterGroup);
 
     /* Cache the log string */
     UA_String idStr = UA_STRING_NULL;
@@ -281,10 +383,9 @@ UA_WriterGroup_remove(UA_Server *server, UA_WriterGroup *wg) {
     }
 
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
-    if(wg->config.securityPolicy && wg->securityPolicyContext) {
-        wg->config.securityPolicy->deleteContext(wg->securityPolicyContext);
-        wg->securityPolicyContext = NULL;
-    }
+    if(wg->config.securityPolicy)
+        deleteSecurityContexts(wg->config.securityPolicy, &wg->securityPolicyContext,
+                               &wg->retiredSecurityPolicyContext);
 #endif
 
 #ifdef UA_ENABLE_PUBSUB_SKS
@@ -303,6 +404,7 @@ UA_WriterGroup_remove(UA_Server *server, UA_WriterGroup *wg) {
         /* Unlink from the connection */
         LIST_REMOVE(wg, listEntry);
         connection->writerGroupsSize--;
+        UA_PubSubManager_unindexComponent(&server->pubSubManager, &wg->idEntry);
         wg->linkedConnection = NULL;
 
         /* Actually remove the WriterGroup */
@@ -316,6 +418,7 @@ UA_WriterGroup_remove(UA_Server *server, UA_WriterGroup *wg) {
         UA_NodeId_clear(&wg->identifier);
         UA_String_clear(&wg->logIdString);
         UA_NetworkMessageOffsetBuffer_clear(&wg->bufferedMessage);
+        clearJsonTemplates(wg);
         UA_free(wg);
     }
 
@@ -359,7 +462,8 @@ UA_WriterGroup_freezeConfiguration(UA_Server *server, UA_WriterGroup *wg) {
     }
 
     /* Enabling RT? */
-    if(wg->config.rtLevel != UA_PUBSUB_RT_FIXED_SIZE)
+    if(wg->config.rtLevel != UA_PUBSUB_RT_FIXED_SIZE &&
+       wg->config.rtLevel != UA_PUBSUB_RT_DETERMINISTIC)
         return UA_STATUSCODE_GOOD;
 
     /* Check if RT is possible */
@@ -369,6 +473,17 @@ UA_WriterGroup_freezeConfiguration(UA_Server *server, UA_WriterGroup *wg) {
         return UA_STATUSCODE_BADNOTSUPPORTED;
     }
 
+    /* The deterministic publish cycle runs without the server lock. It must
+     * not be executed from the (shared) EventLoop but from the dedicated
+     * thread of the application. */
+    if(wg->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC &&
+       !wg->config.pubsubManagerCallback.addCustomCallback) {
+        UA_LOG_WARNING_WRITERGROUP(server->config.logging, wg,
+                                   "PubSub-RT configuration fail: The deterministic "
+                                   "RT level requires a custom publish callback.");
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+
     //TODO Clarify: should we only allow = maxEncapsulatedDataSetMessageCount == 1 with RT?
     //TODO Clarify: Behaviour if the finale size is more than MTU
 
@@ -490,6 +605,7 @@ UA_WriterGroup_unfreezeConfiguration(UA_Server *server, UA_WriterGroup *wg) {
     }
 
     UA_NetworkMessageOffsetBuffer_clear(&wg->bufferedMessage);
+    clearJsonTemplates(wg);
     wg->configurationFrozen = false;
 
     return UA_STATUSCODE_GOOD;
@@ -708,15 +824,9 @@ UA_WriterGroup_lastPublishTimestamp(UA_Server *server, const UA_NodeId writerGro
 
 UA_WriterGroup *
 UA_WriterGroup_findWGbyId(UA_Server *server, UA_NodeId identifier) {
-    UA_PubSubConnection *tmpConnection;
-    TAILQ_FOREACH(tmpConnection, &server->pubSubManager.connections, listEntry) {
-        UA_WriterGroup *tmpWriterGroup;
-        LIST_FOREACH(tmpWriterGroup, &tmpConnection->writerGroups, listEntry) {
-            if(UA_NodeId_equal(&identifier, &tmpWriterGroup->identifier))
-                return tmpWriterGroup;
-        }
-    }
-    return NULL;
+    return (UA_WriterGroup*)
+        UA_PubSubManager_findComponent(&server->pubSubManager,
+                                       UA_PUBSUBINDEX_WRITERGROUP, &identifier);
 }
 
 #ifdef UA_ENABLE_PUBSUB_ENCRYPTION
@@ -742,25 +852,22 @@ setWriterGroupEncryptionKeys(UA_Server *server, const UA_NodeId writerGroup,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+    /* Swap in the new keys. A concurrent RT publish cycle continues with the
+     * previous keys. */
+    res = rolloverSecurityKeys(wg->config.securityPolicy, &wg->securityPolicyContext,
+                               &wg->retiredSecurityPolicyContext,
+                               &signingKey, &encryptingKey, &keyNonce);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
     if(securityTokenId != wg->securityTokenId) {
         wg->securityTokenId = securityTokenId;
         wg->nonceSequenceNumber = 1;
     }
 
-    if(!wg->securityPolicyContext) {
-        /* Create a new context */
-        res = wg->config.securityPolicy->
-            newContext(wg->config.securityPolicy->policyContext,
-                       &signingKey, &encryptingKey, &keyNonce,
-                       &wg->securityPolicyContext);
-    } else {
-        /* Update the context */
-         res = wg->config.securityPolicy->
-            setSecurityKeys(wg->securityPolicyContext, &signingKey, &encryptingKey, &keyNonce);
-    }
+    /* The new context has no precomputed keystream */
+    wg->nextMessageNonceReady = false;
 
-    if(res != UA_STATUSCODE_GOOD)
-        return res;
     return UA_WriterGroup_setPubSubState(server, wg, wg->state);
 }
 
@@ -899,6 +1006,7 @@ encryptAndSign(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
         rv = wg->config.securityPolicy->symmetricModule.cryptoModule.encryptionAlgorithm.
             encrypt(channelContext, &toBeEncrypted);
         UA_CHECK_STATUS(rv, return rv);
+        wg->lastEncryptedLength = toBeEncrypted.length;
     }
 
     if(nm->securityHeader.networkMessageSigned) {
@@ -915,6 +1023,57 @@ encryptAndSign(UA_WriterGroup *wg, const UA_NetworkMessage *nm,
     }
     return UA_STATUSCODE_GOOD;
 }
+
+/* Four random bytes followed by a four-byte sequence number */
+static UA_StatusCode
+generateMessageNonce(UA_WriterGroup *wg, UA_Byte *messageNonce) {
+    UA_ByteString nonce = {4, messageNonce};
+    UA_StatusCode rv = wg->config.securityPolicy->symmetricModule.
+        generateNonce(wg->config.securityPolicy->policyContext, &nonce);
+    if(rv != UA_STATUSCODE_GOOD)
+        return rv;
+    UA_Byte *pos = &messageNonce[4];
+    const UA_Byte *end = &messageNonce[8];
+    return UA_UInt32_encodeBinary(&wg->nonceSequenceNumber, &pos, end);
+}
+
+/* Prepare the encryption of the next NetworkMessage after the current one was
+ * sent. The keystream of counter-mode ciphers depends only on the keys and the
+ * MessageNonce. So it is computed in the idle time between the publish cycles
+ * and the encryption in the next cycle is a single XOR pass. The length of the
+ * last encrypted message is used as the estimate for the next message. */
+static void
+precomputeNextKeystream(UA_WriterGroup *wg) {
+    const UA_PubSubSecurityPolicy *sp = wg->config.securityPolicy;
+    if(wg->config.securityMode != UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
+       !sp || !sp->precomputeKeystream || !wg->securityPolicyContext ||
+       wg->lastEncryptedLength == 0)
+        return;
+
+    if(wg->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE ||
+       wg->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC) {
+        /* The buffered message keeps its MessageNonce. Precompute only once
+         * (and again after a key rollover). */
+        const UA_NetworkMessage *nm = wg->bufferedMessage.nm;
+        if(!nm || nm->securityHeader.messageNonceSize != sizeof(wg->nextMessageNonce))
+            return;
+        if(wg->nextMessageNonceReady &&
+           memcmp(wg->nextMessageNonce, nm->securityHeader.messageNonce,
+                  sizeof(wg->nextMessageNonce)) == 0)
+            return;
+        memcpy(wg->nextMessageNonce, nm->securityHeader.messageNonce,
+               sizeof(wg->nextMessageNonce));
+    } else {
+        if(generateMessageNonce(wg, wg->nextMessageNonce) != UA_STATUSCODE_GOOD)
+            return;
+    }
+
+    /* Use the nonce also if the precomputation fails. Then the next
+     * encryption computes the keystream on the fly. */
+    wg->nextMessageNonceReady = true;
+    const UA_ByteString nonce = {sizeof(wg->nextMessageNonce), wg->nextMessageNonce};
+    sp->precomputeKeystream(wg->securityPolicyContext, &nonce, wg->lastEncryptedLength);
+}
 #endif
 
 static UA_StatusCode
@@ -949,19 +1108,24 @@ encodeNetworkMessage(UA_WriterGroup *wg, UA_NetworkMessage *nm,
 }
 
 static void
-sendNetworkMessageBuffer(UA_Server *server, UA_WriterGroup *wg, 
+sendNetworkMessageBuffer(UA_Server *server, UA_WriterGroup *wg,
                          UA_PubSubConnection *connection, uintptr_t connectionId,
-                         UA_ByteString *buffer) {
+                         const UA_KeyValueMap *params, UA_ByteString *buffer) {
     UA_StatusCode res = connection->cm->
-        sendWithConnection(connection->cm, connectionId,
-                           &UA_KEYVALUEMAP_NULL, buffer);
+        sendWithConnection(connection->cm, connectionId, params, buffer);
 
-    /* Failure, set the WriterGroup into an error mode */
+    /* Failure, set the WriterGroup into an error mode. The deterministic
+     * publish cycle runs without the server lock. Take it only here. */
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR_WRITERGROUP(server->config.logging, wg,
                                  "Sending NetworkMessage failed");
+        UA_Boolean lock = (wg->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC);
+        if(lock)
+            UA_LOCK(&server->serviceMutex);
         UA_WriterGroup_setPubSubState(server, wg, UA_PUBSUBSTATE_ERROR);
         UA_PubSubConnection_setPubSubState(server, connection, UA_PUBSUBSTATE_ERROR);
+        if(lock)
+            UA_UNLOCK(&server->serviceMutex);
         return;
     }
 
@@ -970,6 +1134,68 @@ sendNetworkMessageBuffer(UA_Server *server, UA_WriterGroup *wg,
 }
 
 #ifdef UA_ENABLE_JSON_ENCODING
+/* Returns the template for the layout of the NetworkMessage. A new template is
+ * generated for unknown layouts. The layouts only change if DataSetWriters drop
+ * out. So the number of templates is bounded. Returns NULL if no template can
+ * be used. */
+static UA_NetworkMessageJsonTemplate *
+getJsonTemplate(UA_Server *server, UA_WriterGroup *wg, const UA_NetworkMessage *nm) {
+    for(size_t i = 0; i < wg->jsonTemplatesSize; i++) {
+        if(UA_NetworkMessageJsonTemplate_matches(&wg->jsonTemplates[i], nm))
+            return &wg->jsonTemplates[i];
+    }
+
+    if(wg->jsonTemplatesSize >= UA_WRITERGROUP_MAXJSONTEMPLATES)
+        return NULL;
+    UA_NetworkMessageJsonTemplate *tmpls = (UA_NetworkMessageJsonTemplate*)
+        UA_realloc(wg->jsonTemplates, (wg->jsonTemplatesSize + 1) *
+                   sizeof(UA_NetworkMessageJsonTemplate));
+    if(!tmpls)
+        return NULL;
+    wg->jsonTemplates = tmpls;
+
+    UA_NetworkMessageJsonTemplate *tmpl = &tmpls[wg->jsonTemplatesSize];
+    UA_StatusCode res = UA_NetworkMessage_generateJsonTemplate(nm, tmpl);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_DEBUG_WRITERGROUP(server->config.logging, wg,
+                                 "Cannot generate the JSON template with "
+                                 "status code %s", UA_StatusCode_name(res));
+        return NULL;
+    }
+    wg->jsonTemplatesSize++;
+    return tmpl;
+}
+
+/* Copy the encoded JSON message into a network buffer and send. Compress
+ * first if configured for the WriterGroup. */
+static UA_StatusCode
+sendJsonBuffer(UA_Server *server, UA_WriterGroup *wg, UA_PubSubConnection *connection,
+               uintptr_t sendChannel, const UA_ByteString *msg, UA_UInt16 writerId) {
+    UA_ConnectionManager *cm = connection->cm;
+    UA_StatusCode res;
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+    UA_ByteString compressed = UA_BYTESTRING_NULL;
+    if(UA_WriterGroup_compressionEnabled(wg)) {
+        res = UA_WriterGroup_compress(server, wg, writerId, msg, &compressed);
+        UA_CHECK_STATUS(res, return res);
+        msg = &compressed;
+    }
+#endif
+
+    UA_ByteString buf;
+    res = cm->allocNetworkBuffer(cm, sendChannel, &buf, msg->length);
+    if(res == UA_STATUSCODE_GOOD)
+        memcpy(buf.data, msg->data, msg->length);
+#ifdef UA_ENABLE_PUBSUB_COMPRESSION
+    UA_ByteString_clear(&compressed);
+#endif
+    UA_CHECK_STATUS(res, return res);
+
+    sendNetworkMessageBuffer(server, wg, connection, sendChannel,
+                             &UA_KEYVALUEMAP_NULL, &buf);
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 sendNetworkMessageJson(UA_Server *server, UA_PubSubConnection *connection, UA_WriterGroup *wg,
                        UA_DataSetMessage *dsm, UA_UInt16 *writerIds, UA_Byte dsmCount) {
@@ -986,9 +1212,6 @@ sendNetworkMessageJson(UA_Server *server, UA_PubSubConnection *connection, UA_Wr
     nm.publisherIdType = connection->config.publisherIdType;
     nm.publisherId = connection->config.publisherId;
 
-    /* Compute the message length */
-    size_t msgSize = UA_NetworkMessage_calcSizeJson(&nm, NULL, 0, NULL, 0, true);
-
     UA_ConnectionManager *cm = connection->cm;
     if(!cm)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -1003,24 +1226,27 @@ sendNetworkMessageJson(UA_Server *server, UA_PubSubConnection *connection, UA_Wr
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Allocate the buffer */
-    UA_ByteString buf;
-    UA_StatusCode res = cm->allocNetworkBuffer(cm, sendChannel, &buf, msgSize);
-    UA_CHECK_STATUS(res, return res);
-
-    /* Encode the message */
-    UA_Byte *bufPos = buf.data;
-    const UA_Byte *bufEnd = &buf.data[msgSize];
-    res = UA_NetworkMessage_encodeJson(&nm, &bufPos, &bufEnd, NULL, 0, NULL, 0, true);
-    if(res != UA_STATUSCODE_GOOD) {
-        cm->freeNetworkBuffer(cm, sendChannel, &buf);
-        return res;
+    /* Frozen configuration. Only the values are encoded into the reused buffer
+     * of the template. Then copied into the network buffer. */
+    UA_StatusCode res;
+    UA_NetworkMessageJsonTemplate *tmpl = (wg->configurationFrozen) ?
+        getJsonTemplate(server, wg, &nm) : NULL;
+    if(tmpl) {
+        UA_ByteString msg;
+        res = UA_NetworkMessage_encodeJsonTemplate(tmpl, &nm, &msg);
+        UA_CHECK_STATUS(res, return res);
+        return sendJsonBuffer(server, wg, connection, sendChannel, &msg, writerIds[0]);
     }
-    UA_assert(bufPos == bufEnd);
 
-    /* Send the prepared messages */
-    sendNetworkMessageBuffer(server, wg, connection, sendChannel, &buf);
-    return UA_STATUSCODE_GOOD;
+    /* Encode the message once into a growing buffer. Copying it into the
+     * network buffer is cheaper than a calcSizeJson pass before the
+     * encoding. */
+    UA_ByteString msg;
+    res = UA_NetworkMessage_encodeJsonAlloc(&nm, &msg, NULL, 0, NULL, 0, true);
+    UA_CHECK_STATUS(res, return res);
+    res = sendJsonBuffer(server, wg, connection, sendChannel, &msg, writerIds[0]);
+    UA_ByteString_clear(&msg);
+    return res;
 }
 #endif
 
@@ -1079,16 +1305,18 @@ generateNetworkMessage(UA_PubSubConnection *connection, UA_WriterGroup *wg,
             networkMessage->securityHeader.networkMessageEncrypted = true;
         networkMessage->securityHeader.securityTokenId = wg->securityTokenId;
 
-        /* Generate the MessageNonce. Four random bytes followed by a four-byte
-         * sequence number */
-        UA_ByteString nonce = {4, networkMessage->securityHeader.messageNonce};
-        UA_StatusCode rv = wg->config.securityPolicy->symmetricModule.
-            generateNonce(wg->config.securityPolicy->policyContext, &nonce);
-        if(rv != UA_STATUSCODE_GOOD)
-            return rv;
-        UA_Byte *pos = &networkMessage->securityHeader.messageNonce[4];
-        const UA_Byte *end = &networkMessage->securityHeader.messageNonce[8];
-        UA_UInt32_encodeBinary(&wg->nonceSequenceNumber, &pos, end);
+        /* Use the MessageNonce prepared at the end of the last publish cycle.
+         * The keystream for it may already be precomputed. */
+        if(wg->nextMessageNonceReady) {
+            memcpy(networkMessage->securityHeader.messageNonce,
+                   wg->nextMessageNonce, sizeof(wg->nextMessageNonce));
+            wg->nextMessageNonceReady = false;
+        } else {
+            UA_StatusCode rv =
+                generateMessageNonce(wg, networkMessage->securityHeader.messageNonce);
+            if(rv != UA_STATUSCODE_GOOD)
+                return rv;
+        }
         networkMessage->securityHeader.messageNonceSize = 8;
     }
 #endif
@@ -1176,15 +1404,48 @@ sendNetworkMessageBinary(UA_Server *server, UA_PubSubConnection *connection, UA_
     }
 
     /* Send out the message */
-    sendNetworkMessageBuffer(server, wg, connection, sendChannel, &buf);
+    sendNetworkMessageBuffer(server, wg, connection, sendChannel,
+                             &UA_KEYVALUEMAP_NULL, &buf);
 
     UA_free(nm.payload.dataSetPayload.sizes);
     return UA_STATUSCODE_GOOD;
 }
 
+/* Compute the launch time of the NetworkMessage for the deterministic publish
+ * cycle. The cycles are aligned with the publishing interval on the monotonic
+ * clock of the EventLoop. The first PublishingOffset of the UADP message
+ * settings gives the position of the message within the cycle. Returns zero if
+ * no PublishingOffset is configured. */
+static UA_DateTime
+deterministicTxTime(UA_Server *server, UA_WriterGroup *wg) {
+    const UA_ExtensionObject *ms = &wg->config.messageSettings;
+    if(ms->encoding != UA_EXTENSIONOBJECT_DECODED ||
+       ms->content.decoded.type != &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE])
+        return 0;
+    const UA_UadpWriterGroupMessageDataType *uadp =
+        (const UA_UadpWriterGroupMessageDataType*)ms->content.decoded.data;
+    if(uadp->publishingOffsetSize == 0)
+        return 0;
+
+    UA_DateTime interval = (UA_DateTime)
+        (wg->config.publishingInterval * UA_DATETIME_MSEC);
+    if(interval <= 0)
+        return 0;
+    UA_DateTime offset = (UA_DateTime)(uadp->publishingOffset[0] * UA_DATETIME_MSEC);
+
+    /* Launch in the current cycle. Or in the next cycle if that is too late. */
+    UA_EventLoop *el = UA_PubSubConnection_getEL(server, wg->linkedConnection);
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    UA_DateTime txtime = now - (now % interval) + offset;
+    if(txtime <= now)
+        txtime += interval;
+    return txtime;
+}
+
 static void
 publishRT(UA_Server *server, UA_WriterGroup *writerGroup, UA_PubSubConnection *connection) {
-    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(writerGroup->config.rtLevel != UA_PUBSUB_RT_DETERMINISTIC)
+        UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_StatusCode res =
         UA_NetworkMessage_updateBufferedMessage(&writerGroup->bufferedMessage);
@@ -1247,7 +1508,23 @@ publishRT(UA_Server *server, UA_WriterGroup *writerGroup, UA_PubSubConnection *c
         return;
     }
     memcpy(outBuf.data, buf->data, buf->length);
-    sendNetworkMessageBuffer(server, writerGroup, connection, sendChannel, &outBuf);
+
+    /* Timed send for the deterministic publish cycle. The parameter map is
+     * kept on the stack, so that no allocation is required. */
+    UA_DateTime txtime = 0;
+    UA_KeyValuePair txtimeParam;
+    UA_KeyValueMap params = UA_KEYVALUEMAP_NULL;
+    if(writerGroup->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC)
+        txtime = deterministicTxTime(server, writerGroup);
+    if(txtime != 0) {
+        txtimeParam.key = UA_QUALIFIEDNAME(0, "txtime");
+        UA_Variant_setScalar(&txtimeParam.value, &txtime, &UA_TYPES[UA_TYPES_DATETIME]);
+        params.mapSize = 1;
+        params.map = &txtimeParam;
+    }
+
+    sendNetworkMessageBuffer(server, writerGroup, connection, sendChannel,
+                             &params, &outBuf);
 }
 
 static void
@@ -1277,20 +1554,16 @@ sendNetworkMessage(UA_Server *server, UA_WriterGroup *wg, UA_PubSubConnection *c
     }
 }
 
-/* This callback triggers the collection and publish of NetworkMessages and the
- * contained DataSetMessages. */
-void
-UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
-    UA_assert(writerGroup != NULL);
-    UA_assert(server != NULL);
-
-    UA_LOCK(&server->serviceMutex);
+/* Collect and publish the NetworkMessages and the contained DataSetMessages
+ * of the WriterGroup */
+static void
+publishWriterGroup(UA_Server *server, UA_WriterGroup *writerGroup) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_LOG_DEBUG_WRITERGROUP(server->config.logging, writerGroup, "Publish Callback");
 
     /* Nothing to do? */
     if(writerGroup->writersCount == 0) {
-        UA_UNLOCK(&server->serviceMutex);
         return;
     }
 
@@ -1300,14 +1573,13 @@ UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
         UA_LOG_ERROR_WRITERGROUP(server->config.logging, writerGroup,
                                  "Publish failed. PubSubConnection invalid");
         UA_WriterGroup_setPubSubState(server, writerGroup, UA_PUBSUBSTATE_ERROR);
-        UA_UNLOCK(&server->serviceMutex);
         return;
     }
 
     /* Realtime path - update the buffer message and send directly */
-    if(writerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE) {
+    if(writerGroup->config.rtLevel == UA_PUBSUB_RT_FIXED_SIZE ||
+       writerGroup->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC) {
         publishRT(server, writerGroup, connection);
-        UA_UNLOCK(&server->serviceMutex);
         return;
     }
 
@@ -1396,8 +1668,37 @@ UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
         }
         UA_DataSetMessage_clear(&dsmStore[i]);
     }
+}
+
+/* This callback triggers the collection and publish of NetworkMessages and the
+ * contained DataSetMessages. */
+void
+UA_WriterGroup_publishCallback(UA_Server *server, UA_WriterGroup *writerGroup) {
+    UA_assert(writerGroup != NULL);
+    UA_assert(server != NULL);
 
+    /* Deterministic path - The frozen configuration and the preallocated
+     * buffers are used without the server lock. All field values are read via
+     * the direct value pointers. */
+    UA_ALLOCPHASE_BEGIN(UA_ALLOCPHASE_PUBLISH);
+    if(writerGroup->config.rtLevel == UA_PUBSUB_RT_DETERMINISTIC &&
+       writerGroup->configurationFrozen && writerGroup->linkedConnection &&
+       writerGroup->writersCount > 0) {
+        publishRT(server, writerGroup, writerGroup->linkedConnection);
+#ifdef UA_ENABLE_PUBSUB_ENCRYPTION
+        precomputeNextKeystream(writerGroup);
+#endif
+        UA_ALLOCPHASE_END();
+        return;
+    }
+
+    UA_LOCK(&server->serviceMutex);
+    publishWriterGroup(server, writerGroup);
+#ifdef UA_ENABLE_PUBSUB_ENCRYPTION
+    precomputeNextKeystream(writerGroup);
+#endif
     UA_UNLOCK(&server->serviceMutex);
+    UA_ALLOCPHASE_END();
 }
 
 #endif /* UA_ENABLE_PUBSUB */
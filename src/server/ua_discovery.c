@@ -19,6 +19,94 @@
 
 #ifdef UA_ENABLE_DISCOVERY
 
+static enum ZIP_CMP
+cmpServerUri(const UA_String *a, const UA_String *b) {
+    return (enum ZIP_CMP)UA_order(a, b, &UA_TYPES[UA_TYPES_STRING]);
+}
+
+static enum ZIP_CMP
+cmpRegisteredServerTimeout(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_RegisteredServerUriTree, registeredServer, uriTreeEntry,
+              UA_String, registeredServer.serverUri, cmpServerUri)
+ZIP_FUNCTIONS(UA_RegisteredServerTimeoutTree, registeredServer, timeoutTreeEntry,
+              UA_DateTime, timeoutTreeKey, cmpRegisteredServerTimeout)
+
+registeredServer *
+UA_DiscoveryManager_findRegisteredServer(UA_DiscoveryManager *dm,
+                                         const UA_String *serverUri) {
+    return ZIP_FIND(UA_RegisteredServerUriTree, &dm->registeredServersByUri,
+                    serverUri);
+}
+
+UA_StatusCode
+UA_DiscoveryManager_addRegisteredServer(UA_DiscoveryManager *dm,
+                                        const UA_RegisteredServer *server,
+                                        UA_DateTime nowMonotonic) {
+    registeredServer *rs = (registeredServer*)
+        UA_calloc(1, sizeof(registeredServer));
+    if(!rs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_RegisteredServer_copy(server, &rs->registeredServer);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(rs);
+        return res;
+    }
+    rs->lastSeen = nowMonotonic;
+    rs->timeoutTreeKey = nowMonotonic;
+    LIST_INSERT_HEAD(&dm->registeredServers, rs, pointers);
+    ZIP_INSERT(UA_RegisteredServerUriTree, &dm->registeredServersByUri, rs);
+    ZIP_INSERT(UA_RegisteredServerTimeoutTree, &dm->registeredServersTimeout, rs);
+    dm->registeredServersSize++;
+    if(server->semaphoreFilePath.length > 0)
+        dm->registeredServersSemaphoreCount++;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_DiscoveryManager_updateRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs,
+                                           const UA_RegisteredServer *server,
+                                           UA_DateTime nowMonotonic) {
+    UA_assert(UA_String_equal(&rs->registeredServer.serverUri, &server->serverUri));
+
+    /* Copy first. The entry is unchanged if this fails. */
+    UA_RegisteredServer tmp;
+    UA_StatusCode res = UA_RegisteredServer_copy(server, &tmp);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    if(rs->registeredServer.semaphoreFilePath.length > 0)
+        dm->registeredServersSemaphoreCount--;
+    if(tmp.semaphoreFilePath.length > 0)
+        dm->registeredServersSemaphoreCount++;
+
+    /* The ServerUri (the key in the tree) has the same content */
+    UA_RegisteredServer_clear(&rs->registeredServer);
+    rs->registeredServer = tmp;
+
+    /* The timeout tree is updated lazily during the cleanup */
+    rs->lastSeen = nowMonotonic;
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_DiscoveryManager_removeRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs) {
+    LIST_REMOVE(rs, pointers);
+    ZIP_REMOVE(UA_RegisteredServerUriTree, &dm->registeredServersByUri, rs);
+    ZIP_REMOVE(UA_RegisteredServerTimeoutTree, &dm->registeredServersTimeout, rs);
+    dm->registeredServersSize--;
+    if(rs->registeredServer.semaphoreFilePath.length > 0)
+        dm->registeredServersSemaphoreCount--;
+    UA_RegisteredServer_clear(&rs->registeredServer);
+    UA_free(rs);
+}
+
 void
 UA_DiscoveryManager_setState(UA_Server *server,
                              UA_DiscoveryManager *dm,
@@ -62,15 +150,13 @@ UA_DiscoveryManager_free(UA_Server *server,
 
     registeredServer *rs, *rs_tmp;
     LIST_FOREACH_SAFE(rs, &dm->registeredServers, pointers, rs_tmp) {
-        LIST_REMOVE(rs, pointers);
-        UA_RegisteredServer_clear(&rs->registeredServer);
-        UA_free(rs);
+        UA_DiscoveryManager_removeRegisteredServer(dm, rs);
     }
 
 # ifdef UA_ENABLE_DISCOVERY_MULTICAST
     serverOnNetwork *son, *son_tmp;
-    LIST_FOREACH_SAFE(son, &dm->serverOnNetwork, pointers, son_tmp) {
-        LIST_REMOVE(son, pointers);
+    TAILQ_FOREACH_SAFE(son, &dm->serverOnNetwork, pointers, son_tmp) {
+        TAILQ_REMOVE(&dm->serverOnNetwork, son, pointers);
         UA_ServerOnNetwork_clear(&son->serverOnNetwork);
         if(son->pathTmp)
             UA_free(son->pathTmp);
@@ -108,52 +194,65 @@ UA_DiscoveryManager_cleanupTimedOut(UA_Server *server, void *data) {
     if(server->config.discoveryCleanupTimeout)
         timedOut -= server->config.discoveryCleanupTimeout * UA_DATETIME_SEC;
 
-    registeredServer *current, *temp;
-    LIST_FOREACH_SAFE(current, &dm->registeredServers, pointers, temp) {
-        UA_Boolean semaphoreDeleted = false;
+    /* Only visit the entries that were not seen since the timeout at the
+     * time they were (re)inserted into the timeout tree */
+    registeredServer *current;
+    while(server->config.discoveryCleanupTimeout &&
+          (current = ZIP_MIN(UA_RegisteredServerTimeoutTree,
+                             &dm->registeredServersTimeout)) &&
+          current->timeoutTreeKey < timedOut) {
+        /* The server registered again in the meantime. Reinsert. */
+        if(current->lastSeen >= timedOut) {
+            ZIP_REMOVE(UA_RegisteredServerTimeoutTree,
+                       &dm->registeredServersTimeout, current);
+            current->timeoutTreeKey = current->lastSeen;
+            ZIP_INSERT(UA_RegisteredServerTimeoutTree,
+                       &dm->registeredServersTimeout, current);
+            continue;
+        }
+
+        // cppcheck-suppress unreadVariable
+        UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                    "Registration of server with URI %.*s has timed out "
+                    "and is removed",
+                    (int)current->registeredServer.serverUri.length,
+                    current->registeredServer.serverUri.data);
+        UA_DiscoveryManager_removeRegisteredServer(dm, current);
+    }
 
 #ifdef UA_ENABLE_DISCOVERY_SEMAPHORE
-        if(current->registeredServer.semaphoreFilePath.length) {
+    /* Check the semaphore files. Skip the scan if no registration has one. */
+    registeredServer *temp;
+    if(dm->registeredServersSemaphoreCount > 0) {
+        LIST_FOREACH_SAFE(current, &dm->registeredServers, pointers, temp) {
+            if(current->registeredServer.semaphoreFilePath.length == 0)
+                continue;
             size_t fpSize = current->registeredServer.semaphoreFilePath.length+1;
             char* filePath = (char *)UA_malloc(fpSize);
-            if(filePath) {
-                memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
-                       current->registeredServer.semaphoreFilePath.length );
-                filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
-                semaphoreDeleted = UA_fileExists(filePath) == false;
-                UA_free(filePath);
-            } else {
+            if(!filePath) {
                 UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                              "Cannot check registration semaphore. Out of memory");
+                continue;
             }
-        }
-#endif
-
-        if(semaphoreDeleted ||
-           (server->config.discoveryCleanupTimeout &&
-            current->lastSeen < timedOut)) {
-            if(semaphoreDeleted) {
-                UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %.*s is removed because "
-                            "the semaphore file '%.*s' was deleted",
-                            (int)current->registeredServer.serverUri.length,
-                            current->registeredServer.serverUri.data,
-                            (int)current->registeredServer.semaphoreFilePath.length,
-                            current->registeredServer.semaphoreFilePath.data);
-            } else {
-                // cppcheck-suppress unreadVariable
-                UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
-                            "Registration of server with URI %.*s has timed out "
-                            "and is removed",
-                            (int)current->registeredServer.serverUri.length,
-                            current->registeredServer.serverUri.data);
-            }
-            LIST_REMOVE(current, pointers);
-            UA_RegisteredServer_clear(&current->registeredServer);
-            UA_free(current);
-            dm->registeredServersSize--;
+            memcpy(filePath, current->registeredServer.semaphoreFilePath.data,
+                   current->registeredServer.semaphoreFilePath.length );
+            filePath[current->registeredServer.semaphoreFilePath.length] = '\0';
+            UA_Boolean semaphoreDeleted = UA_fileExists(filePath) == false;
+            UA_free(filePath);
+            if(!semaphoreDeleted)
+                continue;
+
+            UA_LOG_INFO(server->config.logging, UA_LOGCATEGORY_SERVER,
+                        "Registration of server with URI %.*s is removed because "
+                        "the semaphore file '%.*s' was deleted",
+                        (int)current->registeredServer.serverUri.length,
+                        current->registeredServer.serverUri.data,
+                        (int)current->registeredServer.semaphoreFilePath.length,
+                        current->registeredServer.semaphoreFilePath.data);
+            UA_DiscoveryManager_removeRegisteredServer(dm, current);
         }
     }
+#endif
 
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
     /* Send out multicast */
@@ -219,6 +318,7 @@ UA_DiscoveryManager_new(UA_Server *server) {
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
     UA_EventLoop *el = server->config.eventLoop;
     dm->serverOnNetworkRecordIdLastReset = el->dateTime_now(el);
+    TAILQ_INIT(&dm->serverOnNetwork);
 #endif /* UA_ENABLE_DISCOVERY_MULTICAST */
 
     dm->sc.name = UA_STRING("discovery");
@@ -22,10 +22,24 @@ _UA_BEGIN_DECLS
 
 typedef struct registeredServer {
     LIST_ENTRY(registeredServer) pointers;
+
+    /* Indexed by the ServerUri. The timeout tree is ordered by lastSeen when
+     * the entry was (re)inserted. Servers re-register periodically. So the
+     * cleanup reinserts the refreshed entries lazily instead of updating the
+     * tree for every RegisterServer request. */
+    ZIP_ENTRY(registeredServer) uriTreeEntry;
+    ZIP_ENTRY(registeredServer) timeoutTreeEntry;
+    UA_DateTime timeoutTreeKey;
+
     UA_RegisteredServer registeredServer;
     UA_DateTime lastSeen;
 } registeredServer;
 
+typedef ZIP_HEAD(UA_RegisteredServerUriTree, registeredServer)
+    UA_RegisteredServerUriTree;
+typedef ZIP_HEAD(UA_RegisteredServerTimeoutTree, registeredServer)
+    UA_RegisteredServerTimeoutTree;
+
 /* Store async register service calls. So we can cancel outstanding requests
  * during shutdown. */
 typedef struct {
@@ -57,7 +71,7 @@ typedef struct {
  */
 
 typedef struct serverOnNetwork {
-    LIST_ENTRY(serverOnNetwork) pointers;
+    TAILQ_ENTRY(serverOnNetwork) pointers;
     UA_ServerOnNetwork serverOnNetwork;
     UA_DateTime created;
     UA_DateTime lastSeen;
@@ -66,6 +80,10 @@ typedef struct serverOnNetwork {
     char* pathTmp;
 } serverOnNetwork;
 
+/* The recordIds are assigned from a counter. Appending new entries at the tail
+ * keeps the queue sorted by ascending recordId. */
+typedef TAILQ_HEAD(serverOnNetworkQueue, serverOnNetwork) serverOnNetworkQueue;
+
 #define SERVER_ON_NETWORK_HASH_SIZE 1000
 typedef struct serverOnNetwork_hash_entry {
     serverOnNetwork *entry;
@@ -86,6 +104,10 @@ struct UA_DiscoveryManager {
 
     LIST_HEAD(, registeredServer) registeredServers;
     size_t registeredServersSize;
+    UA_RegisteredServerUriTree registeredServersByUri;
+    UA_RegisteredServerTimeoutTree registeredServersTimeout;
+    size_t registeredServersSemaphoreCount; /* Number of entries with a
+                                             * semaphore file */
     UA_Server_registerServerCallback registerServerCallback;
     void* registerServerCallbackData;
 
@@ -101,7 +123,7 @@ struct UA_DiscoveryManager {
      * message was from itself */
     UA_String selfFqdnMdnsRecord;
 
-    LIST_HEAD(, serverOnNetwork) serverOnNetwork;
+    serverOnNetworkQueue serverOnNetwork;
 
     UA_UInt32 serverOnNetworkRecordIdCounter;
     UA_DateTime serverOnNetworkRecordIdLastReset;
@@ -121,6 +143,30 @@ UA_DiscoveryManager_setState(UA_Server *server,
                              UA_DiscoveryManager *dm,
                              UA_LifecycleState state);
 
+/* Lookup in the index of the registered servers */
+registeredServer *
+UA_DiscoveryManager_findRegisteredServer(UA_DiscoveryManager *dm,
+                                         const UA_String *serverUri);
+
+/* Add a new entry to the list and the indexes */
+UA_StatusCode
+UA_DiscoveryManager_addRegisteredServer(UA_DiscoveryManager *dm,
+                                        const UA_RegisteredServer *server,
+                                        UA_DateTime nowMonotonic);
+
+/* Replace the content of an entry after the server registered again. The
+ * ServerUri does not change. */
+UA_StatusCode
+UA_DiscoveryManager_updateRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs,
+                                           const UA_RegisteredServer *server,
+                                           UA_DateTime nowMonotonic);
+
+/* Remove the entry from the list and the indexes and free it */
+void
+UA_DiscoveryManager_removeRegisteredServer(UA_DiscoveryManager *dm,
+                                           registeredServer *rs);
+
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
 
 /* Sends out a new mDNS package for the given server data. This Method is
@@ -129,7 +129,7 @@ UA_DiscoveryManager_addEntryToServersOnNetwork(UA_DiscoveryManager *dm,
     dm->serverOnNetworkHash[hashIdx] = newHashEntry;
     newHashEntry->entry = listEntry;
 
-    LIST_INSERT_HEAD(&dm->serverOnNetwork, listEntry, pointers);
+    TAILQ_INSERT_TAIL(&dm->serverOnNetwork, listEntry, pointers);
     if(addedEntry != NULL)
         *addedEntry = listEntry;
 
@@ -230,7 +230,7 @@ UA_DiscoveryManager_removeEntryFromServersOnNetwork(UA_DiscoveryManager *dm,
                                     dm->serverOnNetworkCallbackData);
 
     /* Remove from list */
-    LIST_REMOVE(entry, pointers);
+    TAILQ_REMOVE(&dm->serverOnNetwork, entry, pointers);
     UA_ServerOnNetwork_clear(&entry->serverOnNetwork);
     if(entry->pathTmp) {
         UA_free(entry->pathTmp);
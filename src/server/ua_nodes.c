@@ -14,6 +14,8 @@
 #include "ua_server_internal.h"
 #include "ua_types_encoding_binary.h"
 
+#include <stdlib.h> /* qsort */
+
 /*********************/
 /* ReferenceType Set */
 /*********************/
@@ -281,14 +283,75 @@ cmpRefTargetName(const void *a, const void *b) {
         ZIP_CMP_LESS : ZIP_CMP_MORE;
 }
 
-/* Move to the array in-order, also deletes the tree elements */
+static int
+cmpRefTargetIdPtr(const void *a, const void *b) {
+    return (int)cmpRefTargetId(*(void * const *)a, *(void * const *)b);
+}
+
+/* Elements with the same name hash are ordered by their pointer. This is the
+ * tie-breaking of the ziptree for equal keys. */
+static int
+cmpRefTargetNamePtr(const void *a, const void *b) {
+    const void *aa = *(void * const *)a;
+    const void *bb = *(void * const *)b;
+    enum ZIP_CMP order = cmpRefTargetName(aa, bb);
+    if(order == ZIP_CMP_EQ && aa != bb)
+        return (aa < bb) ? -1 : 1;
+    return (int)order;
+}
+
+/* Build the id and name tree from the elements in linear time after sorting.
+ * Replaces the previous trees. */
+static void
+buildRefTrees(UA_NodeReferenceKind *rk, UA_ReferenceTargetTreeElem **elems,
+              size_t elemsSize, UA_Boolean idSorted) {
+    if(!idSorted)
+        qsort(elems, elemsSize, sizeof(UA_ReferenceTargetTreeElem*),
+              cmpRefTargetIdPtr);
+    ZIP_BUILD(UA_ReferenceIdTree, (UA_ReferenceIdTree*)&rk->targets.tree.idRoot,
+              elems, elemsSize);
+    qsort(elems, elemsSize, sizeof(UA_ReferenceTargetTreeElem*),
+          cmpRefTargetNamePtr);
+    ZIP_BUILD(UA_ReferenceNameTree,
+              (UA_ReferenceNameTree*)&rk->targets.tree.nameRoot,
+              elems, elemsSize);
+    rk->targetsSize = elemsSize;
+}
+
+size_t
+refTargetArrayPos(const UA_NodeReferenceKind *rk, UA_NodePointer targetId,
+                  UA_Boolean *found) {
+    UA_assert(!rk->hasRefTree);
+    size_t lo = 0, hi = rk->targetsSize;
+    while(lo < hi) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(UA_NodePointer_order(rk->targets.array[mid].targetId,
+                                targetId) == UA_ORDER_LESS)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *found = (lo < rk->targetsSize &&
+              UA_NodePointer_equal(rk->targets.array[lo].targetId, targetId));
+    return lo;
+}
+
+/* Move to the array, also deletes the tree elements. The id tree is ordered by
+ * the hash first. Insert at the sorted position in the array. */
 static void
 moveTreeToArray(UA_ReferenceTarget *array, size_t *pos,
                 UA_ReferenceTargetTreeElem *elem) {
     if(!elem)
         return;
     moveTreeToArray(array, pos, elem->idTreeEntry.left);
-    array[*pos] = elem->target;
+    size_t i = *pos;
+    for(; i > 0; i--) {
+        if(UA_NodePointer_order(array[i-1].targetId,
+                                elem->target.targetId) != UA_ORDER_MORE)
+            break;
+        array[i] = array[i-1];
+    }
+    array[i] = elem->target;
     (*pos)++;
     moveTreeToArray(array, pos, elem->idTreeEntry.right);
     UA_free(elem);
@@ -319,27 +382,31 @@ UA_NodeReferenceKind_switch(UA_NodeReferenceKind *rk) {
         return UA_STATUSCODE_GOOD;
     }
 
-    /* From array to tree */
-    UA_NodeReferenceKind newRk = *rk;
-    newRk.hasRefTree = true;
-    newRk.targets.tree.idRoot = NULL;
-    newRk.targets.tree.nameRoot = NULL;
-    newRk.targetsSize = 0;
+    /* From array to tree. The targets are moved from the array into the tree
+     * elements. Then both trees are built in one pass each. */
+    UA_ReferenceTargetTreeElem **elems = (UA_ReferenceTargetTreeElem**)
+        UA_malloc(sizeof(UA_ReferenceTargetTreeElem*) * rk->targetsSize);
+    if(!elems)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
     for(size_t i = 0; i < rk->targetsSize; i++) {
-        UA_StatusCode res =
-            addReferenceTarget(&newRk, rk->targets.array[i].targetId,
-                               rk->targets.array[i].targetNameHash);
-        if(res != UA_STATUSCODE_GOOD) {
-            ZIP_ITER(UA_ReferenceIdTree,
-                     (UA_ReferenceIdTree*)&newRk.targets.tree.idRoot,
-                     removeTreeEntry, NULL);
-            return res;
+        elems[i] = (UA_ReferenceTargetTreeElem*)
+            UA_malloc(sizeof(UA_ReferenceTargetTreeElem));
+        if(!elems[i]) {
+            for(size_t j = 0; j < i; j++)
+                UA_free(elems[j]);
+            UA_free(elems);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
         }
+        elems[i]->target = rk->targets.array[i];
+        UA_ExpandedNodeId en =
+            UA_NodePointer_toExpandedNodeId(elems[i]->target.targetId);
+        elems[i]->targetIdHash = UA_ExpandedNodeId_hash(&en);
     }
-    for(size_t i = 0; i < rk->targetsSize; i++)
-        UA_NodePointer_clear(&rk->targets.array[i].targetId);
+
     UA_free(rk->targets.array);
-    *rk = newRk;
+    rk->hasRefTree = true;
+    buildRefTrees(rk, elems, rk->targetsSize, false);
+    UA_free(elems);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -374,15 +441,262 @@ UA_NodeReferenceKind_findTarget(const UA_NodeReferenceKind *rk,
         if(result)
             return &result->target;
     } else {
-        /* Return from the array */
-        for(size_t i = 0; i < rk->targetsSize; i++) {
-            if(UA_NodePointer_equal(targetP, rk->targets.array[i].targetId))
-                return &rk->targets.array[i];
-        }
+        /* Binary search in the sorted array */
+        UA_Boolean found;
+        size_t pos = refTargetArrayPos(rk, targetP, &found);
+        if(found)
+            return &rk->targets.array[pos];
     }
     return NULL;
 }
 
+/*******************/
+/* String Interning */
+/*******************/
+
+#ifdef UA_ENABLE_NODE_STRING_INTERNING
+
+/* Refcounted pool for the strings in the BrowseName, DisplayName and
+ * Description of the nodes. The pool is shared by all nodestores. A string is
+ * only returned to the pool if its data points into a pool entry. So strings
+ * that were set without the pool (e.g. by a custom nodestore) are cleared
+ * normally. */
+
+typedef struct InternedString {
+    struct InternedString *next;
+    UA_UInt32 hash;
+    UA_UInt32 refCount;
+    size_t length;
+    UA_Byte data[];
+} InternedString;
+
+static InternedString **internBuckets = NULL;
+static size_t internBucketsSize = 0;
+static size_t internCount = 0;
+
+/* The pool cannot be initialized statically with a UA_Lock */
+static void * volatile internSpinLock = NULL;
+
+static void
+internLock(void) {
+    while(UA_atomic_cmpxchg(&internSpinLock, NULL, (void*)0x1) != NULL) {}
+}
+
+static void
+internUnlock(void) {
+    UA_atomic_xchg(&internSpinLock, NULL);
+}
+
+/* Rehash into a larger bucket array. Ignore if out of memory, the chains just
+ * become longer. */
+static void
+internGrow(void) {
+    size_t newSize = (internBucketsSize == 0) ? 64 : internBucketsSize * 2;
+    InternedString **newBuckets = (InternedString**)
+        UA_calloc(newSize, sizeof(InternedString*));
+    if(!newBuckets)
+        return;
+    for(size_t i = 0; i < internBucketsSize; i++) {
+        InternedString *e = internBuckets[i];
+        while(e) {
+            InternedString *next = e->next;
+            InternedString **b = &newBuckets[e->hash & (newSize - 1)];
+            e->next = *b;
+            *b = e;
+            e = next;
+        }
+    }
+    UA_free(internBuckets);
+    internBuckets = newBuckets;
+    internBucketsSize = newSize;
+}
+
+static UA_StatusCode
+internString(const UA_String *src, UA_String *dst) {
+    if(src->length == 0)
+        return UA_String_copy(src, dst);
+
+    UA_UInt32 hash = UA_ByteString_hash(0, src->data, src->length);
+    internLock();
+
+    /* Lookup an existing entry */
+    InternedString *e = NULL;
+    if(internBucketsSize > 0) {
+        e = internBuckets[hash & (internBucketsSize - 1)];
+        for(; e; e = e->next) {
+            if(e->hash == hash && e->length == src->length &&
+               memcmp(e->data, src->data, src->length) == 0)
+                break;
+        }
+    }
+
+    if(e) {
+        /* The refcount is saturated. Make a normal copy instead. */
+        if(e->refCount == UA_UINT32_MAX) {
+            internUnlock();
+            return UA_String_copy(src, dst);
+        }
+        e->refCount++;
+    } else {
+        /* Add a new entry */
+        if(internCount >= internBucketsSize)
+            internGrow();
+        if(internBucketsSize == 0) {
+            internUnlock();
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        e = (InternedString*)UA_malloc(sizeof(InternedString) + src->length);
+        if(!e) {
+            internUnlock();
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        e->hash = hash;
+        e->refCount = 1;
+        e->length = src->length;
+        memcpy(e->data, src->data, src->length);
+        InternedString **b = &internBuckets[hash & (internBucketsSize - 1)];
+        e->next = *b;
+        *b = e;
+        internCount++;
+    }
+
+    internUnlock();
+    dst->length = e->length;
+    dst->data = e->data;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+releaseString(UA_String *s) {
+    if(s->length == 0 || s->data == NULL) {
+        UA_String_clear(s);
+        return;
+    }
+
+    UA_UInt32 hash = UA_ByteString_hash(0, s->data, s->length);
+    internLock();
+    InternedString *e = NULL;
+    InternedString **prev = NULL;
+    if(internBucketsSize > 0) {
+        prev = &internBuckets[hash & (internBucketsSize - 1)];
+        for(e = *prev; e; prev = &e->next, e = e->next) {
+            if(e->data == s->data)
+                break;
+        }
+    }
+
+    /* Not from the pool */
+    if(!e) {
+        internUnlock();
+        UA_String_clear(s);
+        return;
+    }
+
+    /* Remove the entry. Free the buckets once the pool is empty. */
+    if(--e->refCount == 0) {
+        *prev = e->next;
+        UA_free(e);
+        internCount--;
+        if(internCount == 0) {
+            UA_free(internBuckets);
+            internBuckets = NULL;
+            internBucketsSize = 0;
+        }
+    }
+    internUnlock();
+    UA_String_init(s);
+}
+
+static UA_StatusCode
+internLocalizedText(const UA_LocalizedText *src, UA_LocalizedText *dst) {
+    UA_StatusCode res = internString(&src->locale, &dst->locale);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = internString(&src->text, &dst->text);
+    if(res != UA_STATUSCODE_GOOD)
+        releaseString(&dst->locale);
+    return res;
+}
+
+static void
+releaseLocalizedText(UA_LocalizedText *lt) {
+    releaseString(&lt->locale);
+    releaseString(&lt->text);
+}
+
+#else
+
+# define internString(src, dst) UA_String_copy(src, dst)
+# define releaseString(s) UA_String_clear(s)
+# define internLocalizedText(src, dst) UA_LocalizedText_copy(src, dst)
+# define releaseLocalizedText(lt) UA_LocalizedText_clear(lt)
+
+#endif
+
+UA_StatusCode
+UA_Node_setBrowseName(UA_NodeHead *head, const UA_QualifiedName *browseName) {
+    UA_String name;
+    UA_StatusCode res = internString(&browseName->name, &name);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    releaseString(&head->browseName.name);
+    head->browseName.namespaceIndex = browseName->namespaceIndex;
+    head->browseName.name = name;
+    return UA_STATUSCODE_GOOD;
+}
+
+/**************/
+/* Statistics */
+/**************/
+
+UA_StatusCode
+UA_NodestoreStatistics_addNode(UA_NodestoreStatistics *stats,
+                               const UA_Node *node, size_t nodeSize) {
+    const UA_NodeHead *head = &node->head;
+
+    /* Grow the namespace array */
+    UA_UInt16 nsIndex = head->nodeId.namespaceIndex;
+    if(nsIndex >= stats->namespacesSize) {
+        UA_NodestoreMemoryUsage *ns = (UA_NodestoreMemoryUsage*)
+            UA_realloc(stats->namespaces,
+                       sizeof(UA_NodestoreMemoryUsage) * ((size_t)nsIndex + 1));
+        if(!ns)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        memset(&ns[stats->namespacesSize], 0, sizeof(UA_NodestoreMemoryUsage) *
+               ((size_t)nsIndex + 1 - stats->namespacesSize));
+        stats->namespaces = ns;
+        stats->namespacesSize = (size_t)nsIndex + 1;
+    }
+
+    /* Count the references */
+    size_t refBytes = sizeof(UA_NodeReferenceKind) * head->referencesSize;
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &head->references[i];
+        stats->referenceTargets[rk->referenceTypeIndex] += rk->targetsSize;
+        refBytes += rk->targetsSize * ((rk->hasRefTree) ?
+            sizeof(UA_ReferenceTargetTreeElem) : sizeof(UA_ReferenceTarget));
+    }
+
+    size_t classIndex = 0;
+    while(classIndex < 7 && !((UA_UInt32)head->nodeClass & (1u << classIndex)))
+        classIndex++;
+
+    UA_NodestoreMemoryUsage *usage[3] =
+        {&stats->total, &stats->nodeClasses[classIndex], &stats->namespaces[nsIndex]};
+    for(size_t i = 0; i < 3; i++) {
+        usage[i]->nodeCount++;
+        usage[i]->nodeBytes += nodeSize;
+        usage[i]->referenceBytes += refBytes;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_NodestoreStatistics_clear(UA_NodestoreStatistics *stats) {
+    UA_free(stats->namespaces);
+    memset(stats, 0, sizeof(UA_NodestoreStatistics));
+}
+
 /* General node handling methods. There is no UA_Node_new() method here.
  * Creating nodes is part of the Nodestore layer */
 
@@ -393,19 +707,20 @@ void UA_Node_clear(UA_Node *node) {
     /* Delete other head content */
     UA_NodeHead *head = &node->head;
     UA_NodeId_clear(&head->nodeId);
-    UA_QualifiedName_clear(&head->browseName);
+    releaseString(&head->browseName.name);
+    head->browseName.namespaceIndex = 0;
 
     UA_LocalizedTextListEntry *lt;
 
     while((lt = head->displayName)) {
         head->displayName = lt->next;
-        UA_LocalizedText_clear(&lt->localizedText);
+        releaseLocalizedText(&lt->localizedText);
         UA_free(lt);
     }
 
     while((lt = head->description)) {
         head->description = lt->next;
-        UA_LocalizedText_clear(&lt->localizedText);
+        releaseLocalizedText(&lt->localizedText);
         UA_free(lt);
     }
 
@@ -491,6 +806,7 @@ static UA_StatusCode
 UA_MethodNode_copy(const UA_MethodNode *src, UA_MethodNode *dst) {
     dst->executable = src->executable;
     dst->method = src->method;
+    dst->methodBatch = src->methodBatch;
 #if UA_MULTITHREADING >= 100
     dst->async = src->async;
 #endif
@@ -527,13 +843,56 @@ UA_ViewNode_copy(const UA_ViewNode *src, UA_ViewNode *dst) {
     return UA_STATUSCODE_GOOD;
 }
 
+typedef struct {
+    UA_ReferenceTargetTreeElem **elems;
+    size_t elemsSize;
+} RefTreeCopyContext;
+
 static void *
 copyTarget(void *context, UA_ReferenceTargetTreeElem *elm) {
-    UA_NodeReferenceKind *drefs = (UA_NodeReferenceKind*)context;
-    return (void*)(uintptr_t)
-        addReferenceTargetToTree(drefs, elm->target.targetId,
-                                 elm->targetIdHash,
-                                 elm->target.targetNameHash);
+    RefTreeCopyContext *ctx = (RefTreeCopyContext*)context;
+    UA_ReferenceTargetTreeElem *entry = (UA_ReferenceTargetTreeElem*)
+        UA_malloc(sizeof(UA_ReferenceTargetTreeElem));
+    if(!entry)
+        return (void*)(uintptr_t)UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res =
+        UA_NodePointer_copy(elm->target.targetId, &entry->target.targetId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(entry);
+        return (void*)(uintptr_t)res;
+    }
+    entry->targetIdHash = elm->targetIdHash;
+    entry->target.targetNameHash = elm->target.targetNameHash;
+    entry->target.targetGeneration = 0;
+    entry->target.targetNode = NULL;
+    ctx->elems[ctx->elemsSize++] = entry;
+    return NULL;
+}
+
+/* Copy the elements in the order of the source id tree. Then build the trees
+ * without re-inserting every element. */
+static UA_StatusCode
+copyRefTrees(const UA_NodeReferenceKind *srefs, UA_NodeReferenceKind *drefs) {
+    RefTreeCopyContext ctx;
+    ctx.elemsSize = 0;
+    ctx.elems = (UA_ReferenceTargetTreeElem**)
+        UA_malloc(sizeof(UA_ReferenceTargetTreeElem*) * srefs->targetsSize);
+    if(!ctx.elems)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    void *res = ZIP_ITER(UA_ReferenceIdTree,
+                         (UA_ReferenceIdTree*)(uintptr_t)&srefs->targets.tree.idRoot,
+                         copyTarget, &ctx);
+    if(res != NULL) {
+        for(size_t i = 0; i < ctx.elemsSize; i++) {
+            UA_NodePointer_clear(&ctx.elems[i]->target.targetId);
+            UA_free(ctx.elems[i]);
+        }
+        UA_free(ctx.elems);
+        return (UA_StatusCode)(uintptr_t)res;
+    }
+    buildRefTrees(drefs, ctx.elems, ctx.elemsSize, true);
+    UA_free(ctx.elems);
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -545,7 +904,8 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
 
     /* Copy standard content */
     UA_StatusCode retval = UA_NodeId_copy(&srchead->nodeId, &dsthead->nodeId);
-    retval |= UA_QualifiedName_copy(&srchead->browseName, &dsthead->browseName);
+    dsthead->browseName.namespaceIndex = srchead->browseName.namespaceIndex;
+    retval |= internString(&srchead->browseName.name, &dsthead->browseName.name);
 
     /* Copy the display name in several languages */
     for(UA_LocalizedTextListEntry *lt = srchead->displayName; lt != NULL; lt = lt->next) {
@@ -555,7 +915,7 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
             retval |= UA_STATUSCODE_BADOUTOFMEMORY;
             break;
         }
-        retval |= UA_LocalizedText_copy(&lt->localizedText, &newEntry->localizedText);
+        retval |= internLocalizedText(&lt->localizedText, &newEntry->localizedText);
 
         /* Add to the linked list possibly in reverse order */
         newEntry->next = dsthead->displayName;
@@ -570,7 +930,7 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
             retval |= UA_STATUSCODE_BADOUTOFMEMORY;
             break;
         }
-        retval |= UA_LocalizedText_copy(&lt->localizedText, &newEntry->localizedText);
+        retval |= internLocalizedText(&lt->localizedText, &newEntry->localizedText);
 
         /* Add to the linked list possibly in reverse order */
         newEntry->next = dsthead->description;
@@ -582,6 +942,7 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
     dsthead->constructed = srchead->constructed;
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     dsthead->monitoredItems = srchead->monitoredItems;
+    dsthead->samplingGroups = srchead->samplingGroups;
 #endif
     if(retval != UA_STATUSCODE_GOOD) {
         UA_Node_clear(dst);
@@ -617,6 +978,8 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
                 for(size_t j = 0; j < srefs->targetsSize; j++) {
                     drefs->targets.array[j].targetNameHash =
                         srefs->targets.array[j].targetNameHash;
+                    drefs->targets.array[j].targetGeneration = 0;
+                    drefs->targets.array[j].targetNode = NULL;
                     retval = UA_NodePointer_copy(srefs->targets.array[j].targetId,
                                                  &drefs->targets.array[j].targetId);
                     drefs->targetsSize++; /* avoid that targetsSize == 0 in error case */
@@ -626,12 +989,10 @@ UA_Node_copy(const UA_Node *src, UA_Node *dst) {
                     }
                 }
             } else {
-                void *res = ZIP_ITER(UA_ReferenceIdTree,
-                                     (UA_ReferenceIdTree*)&srefs->targets.tree.idRoot,
-                                     copyTarget, drefs);
-                if(res != NULL) {
+                retval = copyRefTrees(srefs, drefs);
+                if(retval != UA_STATUSCODE_GOOD) {
                     UA_Node_clear(dst);
-                    return (UA_StatusCode)(uintptr_t)res;
+                    return retval;
                 }
             }
 
@@ -910,6 +1271,8 @@ addReferenceTargetToTree(UA_NodeReferenceKind *rk, UA_NodePointer targetId,
 
     entry->targetIdHash = targetIdHash;
     entry->target.targetNameHash = targetNameHash;
+    entry->target.targetGeneration = 0;
+    entry->target.targetNode = NULL;
 
     ZIP_INSERT(UA_ReferenceIdTree,
                (UA_ReferenceIdTree*)&rk->targets.tree.idRoot, entry);
@@ -930,26 +1293,31 @@ addReferenceTarget(UA_NodeReferenceKind *rk, UA_NodePointer targetId,
                                         targetNameHash);
     }
 
-    /* Insert to the array */
+    /* Copy the target first */
+    UA_ReferenceTarget newTarget;
+    UA_StatusCode retval = UA_NodePointer_copy(targetId, &newTarget.targetId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    newTarget.targetNameHash = targetNameHash;
+    newTarget.targetGeneration = 0;
+    newTarget.targetNode = NULL;
+
+    /* Insert to the array at the sorted position */
     UA_ReferenceTarget *newRefs = (UA_ReferenceTarget*)
         UA_realloc(rk->targets.array,
                    sizeof(UA_ReferenceTarget) * (rk->targetsSize + 1));
-    if(!newRefs)
+    if(!newRefs) {
+        UA_NodePointer_clear(&newTarget.targetId);
         return UA_STATUSCODE_BADOUTOFMEMORY;
-    rk->targets.array = newRefs;
-
-    UA_StatusCode retval =
-        UA_NodePointer_copy(targetId,
-                            &rk->targets.array[rk->targetsSize].targetId);
-    rk->targets.array[rk->targetsSize].targetNameHash = targetNameHash;
-    if(retval != UA_STATUSCODE_GOOD) {
-        if(rk->targetsSize == 0) {
-            UA_free(rk->targets.array);
-            rk->targets.array = NULL;
-        }
-        return retval;
     }
+    rk->targets.array = newRefs;
 
+    UA_Boolean found;
+    size_t pos = refTargetArrayPos(rk, newTarget.targetId, &found);
+    if(pos < rk->targetsSize)
+        memmove(&newRefs[pos + 1], &newRefs[pos],
+                sizeof(UA_ReferenceTarget) * (rk->targetsSize - pos));
+    newRefs[pos] = newTarget;
     rk->targetsSize++;
     return UA_STATUSCODE_GOOD;
 }
@@ -1039,10 +1407,12 @@ UA_Node_deleteReference(UA_Node *node, UA_Byte refTypeIndex, UA_Boolean isForwar
             /* Remove from array */
             UA_NodePointer_clear(&target->targetId);
 
-            /* Elements remaining. Realloc. */
+            /* Elements remaining. Keep the array sorted. Realloc. */
             if(refs->targetsSize > 0) {
-                if(target != &refs->targets.array[refs->targetsSize])
-                    *target = refs->targets.array[refs->targetsSize];
+                size_t pos = (size_t)(target - refs->targets.array);
+                if(pos < refs->targetsSize)
+                    memmove(target, target + 1,
+                            sizeof(UA_ReferenceTarget) * (refs->targetsSize - pos));
                 UA_ReferenceTarget *newRefs = (UA_ReferenceTarget*)
                     UA_realloc(refs->targets.array,
                                sizeof(UA_ReferenceTarget) * refs->targetsSize);
@@ -1153,7 +1523,7 @@ UA_Node_insertOrUpdateLocale(UA_LocalizedTextListEntry **root,
                 *root = lt->next;
             else
                 prev->next = lt->next;
-            UA_LocalizedText_clear(&lt->localizedText);
+            releaseLocalizedText(&lt->localizedText);
             UA_free(lt);
             return UA_STATUSCODE_GOOD;
         }
@@ -1161,11 +1531,11 @@ UA_Node_insertOrUpdateLocale(UA_LocalizedTextListEntry **root,
         /* First make a copy of the text, if this succeeds replace the old
          * version */
         UA_String tmp;
-        res = UA_String_copy(&value->text, &tmp);
+        res = internString(&value->text, &tmp);
         if(res != UA_STATUSCODE_GOOD)
             return res;
 
-        UA_String_clear(&lt->localizedText.text);
+        releaseString(&lt->localizedText.text);
         lt->localizedText.text = tmp;
         return UA_STATUSCODE_GOOD;
     }
@@ -1181,7 +1551,7 @@ UA_Node_insertOrUpdateLocale(UA_LocalizedTextListEntry **root,
     if(!lt)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    res = UA_LocalizedText_copy(value, &lt->localizedText);
+    res = internLocalizedText(value, &lt->localizedText);
     if(res != UA_STATUSCODE_GOOD) {
         UA_free(lt);
         return res;
@@ -56,15 +56,31 @@ setupNs1Uri(UA_Server *server) {
     }
 }
 
+/* Returns namespacesSize if not found */
+static size_t
+findNamespace(UA_Server *server, const UA_String *name) {
+    size_t slot = UA_ByteString_hash(0, name->data, name->length) %
+        UA_NAMESPACECACHE_SIZE;
+    size_t i = server->namespaceCache[slot];
+    if(i < server->namespacesSize && UA_String_equal(name, &server->namespaces[i]))
+        return i;
+    for(i = 0; i < server->namespacesSize; ++i) {
+        if(UA_String_equal(name, &server->namespaces[i])) {
+            server->namespaceCache[slot] = (UA_UInt16)i;
+            break;
+        }
+    }
+    return i;
+}
+
 UA_UInt16 addNamespace(UA_Server *server, const UA_String name) {
     /* ensure that the uri for ns1 is set up from the app description */
     setupNs1Uri(server);
 
     /* Check if the namespace already exists in the server's namespace array */
-    for(size_t i = 0; i < server->namespacesSize; ++i) {
-        if(UA_String_equal(&name, &server->namespaces[i]))
-            return (UA_UInt16) i;
-    }
+    size_t i = findNamespace(server, &name);
+    if(i < server->namespacesSize)
+        return (UA_UInt16)i;
 
     /* Make the array bigger */
     UA_String *newNS = (UA_String*)UA_realloc(server->namespaces,
@@ -104,15 +120,11 @@ getNamespaceByName(UA_Server *server, const UA_String namespaceUri,
                    size_t *foundIndex) {
     /* ensure that the uri for ns1 is set up from the app description */
     setupNs1Uri(server);
-    UA_StatusCode res = UA_STATUSCODE_BADNOTFOUND;
-    for(size_t idx = 0; idx < server->namespacesSize; idx++) {
-        if(UA_String_equal(&server->namespaces[idx], &namespaceUri)) {
-            (*foundIndex) = idx;
-            res = UA_STATUSCODE_GOOD;
-            break;
-        }
-    }
-    return res;
+    size_t idx = findNamespace(server, &namespaceUri);
+    if(idx == server->namespacesSize)
+        return UA_STATUSCODE_BADNOTFOUND;
+    *foundIndex = idx;
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -260,6 +272,10 @@ UA_Server_delete(UA_Server *server) {
         UA_Server_removeSession(server, current, UA_SHUTDOWNREASON_CLOSE);
     }
     UA_Array_delete(server->namespaces, server->namespacesSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_BrowseCache_clear(server);
+    UA_EndpointsCache_clear(server);
+    UA_TypeHierarchy_clear(server);
+    UA_DataSourceCache_clear(server);
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* Remove subscriptions without a session */
@@ -282,6 +298,16 @@ UA_Server_delete(UA_Server *server) {
     UA_AsyncManager_clear(&server->asyncManager, server);
 #endif
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+    UA_BrowseWorkers_delete(server->browseWorkers);
+#endif
+
+    UA_Server_clearBulkRequests(server);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    clearModelChanges(server);
+#endif
+
     /* Clean up the Admin Session */
     UA_Session_clear(&server->adminSession, server);
 #ifdef UA_ENABLE_SUBSCRIPTIONS
@@ -301,6 +327,21 @@ UA_Server_delete(UA_Server *server) {
 
 #if UA_MULTITHREADING >= 100
     UA_LOCK_DESTROY(&server->serviceMutex);
+    UA_LOCK_DESTROY(&server->dataSourceCacheLock);
+    UA_LOCK_DESTROY(&server->viewCacheLock);
+    UA_LOCK_DESTROY(&server->continuationPointsLock);
+    UA_LOCK_DESTROY(&server->bulkRequestsLock);
+#endif
+
+    /* Wipe the unused random bytes */
+    memset(server->randomPool, 0, UA_RANDOMPOOL_SIZE);
+
+    UA_free(server->serviceStatistics);
+
+#ifdef UA_ENABLE_STATIC_POOLS
+    /* The delayed callbacks that return objects to the pools were processed
+     * when the EventLoop was deleted with the config */
+    UA_ServerPools_clear(server);
 #endif
 
     /* Delete the server itself and return */
@@ -339,12 +380,19 @@ UA_Server_init(UA_Server *server) {
      * UA_Server_run_startup() */
     server->startTime = 0;
 
+    /* The random pool is filled on first use */
+    server->randomPoolPos = UA_RANDOMPOOL_SIZE;
+
     /* Set a seed for non-cyptographic randomness */
 #ifndef UA_ENABLE_DETERMINISTIC_RNG
     UA_random_seed((UA_UInt64)UA_DateTime_now());
 #endif
 
     UA_LOCK_INIT(&server->serviceMutex);
+    UA_LOCK_INIT(&server->dataSourceCacheLock);
+    UA_LOCK_INIT(&server->viewCacheLock);
+    UA_LOCK_INIT(&server->continuationPointsLock);
+    UA_LOCK_INIT(&server->bulkRequestsLock);
     UA_LOCK(&server->serviceMutex);
 
     /* Initialize the adminSession */
@@ -356,9 +404,11 @@ UA_Server_init(UA_Server *server) {
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* Initialize the adminSubscription */
-    server->adminSubscription = UA_Subscription_new();
+    server->adminSubscription = UA_Subscription_new(server);
     UA_CHECK_MEM(server->adminSubscription, goto cleanup);
     UA_Session_attachSubscription(&server->adminSession, server->adminSubscription);
+    ZIP_INIT(&server->samplingGroups);
+    ZIP_INIT(&server->publishGroups);
 #endif
 
     /* Create Namespaces 0 and 1
@@ -372,12 +422,18 @@ UA_Server_init(UA_Server *server) {
 
     /* Initialize Session Management */
     LIST_INIT(&server->sessions);
+    ZIP_INIT(&server->sessionsByToken);
+    ZIP_INIT(&server->sessionsById);
+    ZIP_INIT(&server->sessionTimeouts);
     server->sessionCount = 0;
 
 #if UA_MULTITHREADING >= 100
     UA_AsyncManager_init(&server->asyncManager, server);
 #endif
 
+    TAILQ_INIT(&server->bulkRequests);
+    TAILQ_INIT(&server->continuationPoints);
+
     /* Initialize the binay protocol support */
     addServerComponent(server, UA_BinaryProtocolManager_new(server), NULL);
 
@@ -596,6 +652,10 @@ UA_Server_updateCertificate(UA_Server *server,
         i++;
     }
 
+    UA_LOCK(&server->serviceMutex);
+    invalidateEndpointsCache(server);
+    UA_UNLOCK(&server->serviceMutex);
+
     return UA_STATUSCODE_GOOD;
 }
 
@@ -650,9 +710,121 @@ UA_Server_getStatistics(UA_Server *server) {
     stat.ss.rejectedSessionCount = sds->rejectedSessionCount;
     stat.ss.sessionTimeoutCount = sds->sessionTimeoutCount;
     stat.ss.sessionAbortCount = sds->sessionAbortCount;
+#if UA_MULTITHREADING >= 100
+    stat.sls = server->serviceLockStatistics;
+    UA_LOCK(&server->asyncManager.queueLock);
+    stat.aos = server->asyncManager.stats;
+    UA_UNLOCK(&server->asyncManager.queueLock);
+#endif
+    stat.cs = server->counterStatistics;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* The queue sizes are summed up over the Subscriptions and Sessions */
+    UA_SubscriptionStatistics *subs = &stat.subs;
+    memset(subs, 0, sizeof(UA_SubscriptionStatistics));
+    UA_LOCK(&server->serviceMutex);
+    subs->currentSubscriptionCount = server->subscriptionsSize;
+    subs->currentMonitoredItemCount = server->monitoredItemsSize;
+    UA_Subscription *sub;
+    LIST_FOREACH(sub, &server->subscriptions, serverListEntry) {
+        if(sub->late)
+            subs->lateSubscriptionCount++;
+        subs->notificationQueueSize += sub->notificationQueueSize;
+        subs->retransmissionQueueSize += sub->retransmissionQueueSize;
+    }
+    session_list_entry *session;
+    LIST_FOREACH(session, &server->sessions, pointers) {
+        subs->publishRequestQueueSize += session->session.responseQueueSize;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+#endif
     return stat;
 }
 
+UA_UInt64
+UA_LatencyHistogram_quantile(const UA_LatencyHistogram *h, UA_Double q) {
+    if(h->count == 0)
+        return 0;
+    if(q > 1.0)
+        q = 1.0;
+    UA_UInt64 rank = (UA_UInt64)(q * (UA_Double)h->count);
+    if(rank == 0)
+        rank = 1;
+    UA_UInt64 seen = 0;
+    for(size_t i = 0; i < UA_LATENCYHISTOGRAM_BUCKETS - 1; i++) {
+        seen += h->buckets[i];
+        if(seen < rank)
+            continue;
+        UA_UInt64 upper = ((UA_UInt64)1 << (i + 1)) - 1;
+        return (upper < h->max) ? upper : h->max;
+    }
+    return h->max;
+}
+
+UA_StatusCode
+UA_Server_getServiceStatistics(UA_Server *server,
+                               const UA_DataType *requestType,
+                               UA_ServiceStatistics *stats) {
+    memset(stats, 0, sizeof(UA_ServiceStatistics));
+    if(!server->serviceStatistics)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    for(size_t i = 0; i < serviceDescriptionsSize; i++) {
+        if(serviceDescriptions[i].requestType != requestType)
+            continue;
+        /* The counters are updated with atomic operations. The copy is not an
+         * atomic snapshot across all counters. */
+        *stats = server->serviceStatistics[i];
+        return UA_STATUSCODE_GOOD;
+    }
+    return UA_STATUSCODE_BADSERVICEUNSUPPORTED;
+}
+
+static void
+referenceStatisticsVisitor(void *visitorCtx, const UA_Node *node) {
+    UA_ReferenceStatistics *stats = (UA_ReferenceStatistics*)visitorCtx;
+    size_t index = 0;
+    while(index < 7 && !((UA_UInt32)node->head.nodeClass & (1u << index)))
+        index++;
+    UA_ReferenceStatistics *s = &stats[index];
+    s->nodeCount++;
+    s->referenceKindCount += node->head.referencesSize;
+    s->referenceBytes += sizeof(UA_NodeReferenceKind) * node->head.referencesSize;
+    for(size_t i = 0; i < node->head.referencesSize; i++) {
+        const UA_NodeReferenceKind *rk = &node->head.references[i];
+        s->targetCount += rk->targetsSize;
+        if(rk->hasRefTree) {
+            s->treeTargetCount += rk->targetsSize;
+            s->referenceBytes += sizeof(UA_ReferenceTargetTreeElem) * rk->targetsSize;
+        } else {
+            s->referenceBytes += sizeof(UA_ReferenceTarget) * rk->targetsSize;
+        }
+    }
+}
+
+void
+UA_Server_getReferenceStatistics(UA_Server *server,
+                                 UA_ReferenceStatistics stats[8]) {
+    memset(stats, 0, sizeof(UA_ReferenceStatistics) * 8);
+    UA_LOCK(&server->serviceMutex);
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     referenceStatisticsVisitor, stats);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+UA_StatusCode
+UA_Server_getNodestoreStatistics(UA_Server *server,
+                                 UA_NodestoreStatistics *stats) {
+    memset(stats, 0, sizeof(UA_NodestoreStatistics));
+    if(!server->config.nodestore.getStatistics)
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = server->config.nodestore.
+        getStatistics(server->config.nodestore.context, stats);
+    UA_UNLOCK(&server->serviceMutex);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_NodestoreStatistics_clear(stats);
+    return res;
+}
+
 /********************/
 /* Main Server Loop */
 /********************/
@@ -722,8 +894,22 @@ UA_Server_run_startup(UA_Server *server) {
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
-    /* Start the EventLoop if not already started */
+    /* Allocate the service statistics. They are kept across restarts. */
+    if(config->serviceStatistics && !server->serviceStatistics) {
+        server->serviceStatistics = (UA_ServiceStatistics*)
+            UA_calloc(serviceDescriptionsSize, sizeof(UA_ServiceStatistics));
+        UA_CHECK_MEM(server->serviceStatistics,
+                     return UA_STATUSCODE_BADOUTOFMEMORY);
+    }
+
     UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+#ifdef UA_ENABLE_STATIC_POOLS
+    /* Allocate the object pools. They are kept across restarts. */
+    retVal = UA_ServerPools_init(server);
+    UA_CHECK_STATUS(retVal, return retVal);
+#endif
+
+    /* Start the EventLoop if not already started */
     UA_EventLoop *el = config->eventLoop;
     UA_CHECK_MEM_ERROR(el, return UA_STATUSCODE_BADINTERNALERROR,
                        config->logging, UA_LOGCATEGORY_SERVER,
@@ -734,6 +920,17 @@ UA_Server_run_startup(UA_Server *server) {
         UA_CHECK_STATUS(retVal, return retVal); /* Errors are logged internally */
     }
 
+#if UA_MULTITHREADING >= 100
+    /* Start the network EventLoops */
+    for(size_t i = 0; i < config->networkEventLoopsSize; i++) {
+        UA_EventLoop *nel = config->networkEventLoops[i];
+        if(nel->state == UA_EVENTLOOPSTATE_STARTED)
+            continue;
+        retVal = nel->start(nel);
+        UA_CHECK_STATUS(retVal, return retVal);
+    }
+#endif
+
     /* Take the server lock */
     UA_LOCK(&server->serviceMutex);
 
@@ -877,6 +1074,14 @@ UA_Server_run_shutdown(UA_Server *server) {
     UA_AsyncManager_stop(&server->asyncManager, server);
 #endif
 
+    /* Drop the bulk requests that are not finished */
+    UA_Server_clearBulkRequests(server);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Drop the pending model changes */
+    clearModelChanges(server);
+#endif
+
     /* Stop the regular housekeeping tasks */
     if(server->houseKeepingCallbackId != 0) {
         removeCallback(server, server->houseKeepingCallbackId);
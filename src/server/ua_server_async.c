@@ -10,13 +10,39 @@
 
 #if UA_MULTITHREADING >= 100
 
+#ifdef UA_ARCHITECTURE_WIN32
+# include <windows.h>
+#else
+# include <pthread.h>
+#endif
+
 static void
 UA_AsyncOperation_delete(UA_AsyncOperation *ar) {
     UA_CallMethodRequest_clear(&ar->request);
     UA_CallMethodResult_clear(&ar->response);
+    UA_DataValue_clear(&ar->readResult);
     UA_free(ar);
 }
 
+static const UA_DataType *
+asyncResponseType(const UA_AsyncResponse *ar) {
+    if(ar->operationType == UA_ASYNCOPERATIONTYPE_READ_DATASOURCE)
+        return &UA_TYPES[UA_TYPES_READRESPONSE];
+    return &UA_TYPES[UA_TYPES_CALLRESPONSE];
+}
+
+/* Set the status for a timeout or cancellation */
+static void
+setOperationStatus(UA_AsyncOperation *ao, UA_StatusCode status) {
+    if(ao->parent->operationType == UA_ASYNCOPERATIONTYPE_READ_DATASOURCE) {
+        UA_DataValue_clear(&ao->readResult);
+        ao->readResult.hasStatus = true;
+        ao->readResult.status = status;
+        return;
+    }
+    ao->response.statusCode = status;
+}
+
 static void
 UA_AsyncManager_sendAsyncResponse(UA_AsyncManager *am, UA_Server *server,
                                   UA_AsyncResponse *ar) {
@@ -54,7 +80,7 @@ UA_AsyncManager_sendAsyncResponse(UA_AsyncManager *am, UA_Server *server,
     /* Send the Response */
     UA_StatusCode res =
         sendResponse(server, channel, ar->requestId, (UA_Response *)&ar->response,
-                     &UA_TYPES[UA_TYPES_CALLRESPONSE]);
+                     asyncResponseType(ar));
     if(res != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "Async Response for Req# %" PRIu32 " failed "
@@ -64,6 +90,24 @@ UA_AsyncManager_sendAsyncResponse(UA_AsyncManager *am, UA_Server *server,
     UA_AsyncManager_removeAsyncResponse(&server->asyncManager, ar);
 }
 
+static void
+pushResult(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperation *ao);
+
+/* Move the result of an async read into the ReadResponse */
+static void
+setReadResult(UA_Server *server, const UA_AsyncResponse *ar,
+              UA_AsyncOperation *ao, UA_DataValue *dv) {
+    UA_DataValue_clear(dv);
+    *dv = ao->readResult;
+    UA_DataValue_init(&ao->readResult);
+    if(dv->hasValue && !dv->hasSourceTimestamp) {
+        UA_EventLoop *el = server->config.eventLoop;
+        dv->sourceTimestamp = el->dateTime_now(el);
+        dv->hasSourceTimestamp = true;
+    }
+    setReadTimestamps(server, ar->timestampsToReturn, dv);
+}
+
 /* Integrate operation result in the AsyncResponse and send out the response if
  * it is ready. */
 static UA_Boolean
@@ -73,6 +117,7 @@ integrateOperationResult(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperati
 
     /* Grab the open request, so we can continue to construct the response */
     UA_AsyncResponse *ar = ao->parent;
+    TAILQ_REMOVE(&ar->ops, ao, parentPointers);
 
     /* Reduce the number of open results */
     ar->opCountdown -= 1;
@@ -81,9 +126,15 @@ integrateOperationResult(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperati
                  "Return result in the server thread with %" PRIu32 " remaining",
                  ar->opCountdown);
 
-    /* Move the UA_CallMethodResult to UA_CallResponse */
-    ar->response.callResponse.results[ao->index] = ao->response;
-    UA_CallMethodResult_init(&ao->response);
+    if(ar->operationType == UA_ASYNCOPERATIONTYPE_READ_DATASOURCE) {
+        /* Move the UA_DataValue to the UA_ReadResponse */
+        setReadResult(server, ar, ao,
+                      &ar->response.readResponse.results[ao->index]);
+    } else {
+        /* Move the UA_CallMethodResult to UA_CallResponse */
+        ar->response.callResponse.results[ao->index] = ao->response;
+        UA_CallMethodResult_init(&ao->response);
+    }
 
     /* Done with all operations -> send the response */
     UA_Boolean done = (ar->opCountdown == 0);
@@ -117,7 +168,84 @@ processAsyncResults(UA_Server *server) {
     return count;
 }
 
-/* Check if any operations have timed out */
+/* The operation is still with a worker or in the result stack. Set the status
+ * in the AsyncResponse directly and detach the operation. It is deleted when it
+ * is taken from the result stack. Returns true if the response was sent. */
+static UA_Boolean
+orphanOperation(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperation *ao,
+                UA_StatusCode status) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+
+    UA_AsyncResponse *ar = ao->parent;
+    if(ao->state == UA_ASYNCOPERATIONSTATE_WORKER)
+        TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
+    TAILQ_REMOVE(&ar->ops, ao, parentPointers);
+    ao->state = UA_ASYNCOPERATIONSTATE_ORPHANED;
+    ar->opCountdown -= 1;
+
+    if(ar->operationType == UA_ASYNCOPERATIONTYPE_READ_DATASOURCE) {
+        UA_DataValue *dv = &ar->response.readResponse.results[ao->index];
+        UA_DataValue_clear(dv);
+        dv->hasStatus = true;
+        dv->status = status;
+        setReadTimestamps(server, ar->timestampsToReturn, dv);
+    } else {
+        ar->response.callResponse.results[ao->index].statusCode = status;
+    }
+
+    if(ar->opCountdown > 0)
+        return false;
+    UA_AsyncManager_sendAsyncResponse(am, server, ar);
+    return true;
+}
+
+/* Set the status of all outstanding operations of the AsyncResponse. Results
+ * that were already returned are kept. Returns true if the response was sent
+ * right away. Otherwise it is sent when the result queue is processed. */
+static UA_Boolean
+abortAsyncResponse(UA_AsyncManager *am, UA_Server *server, UA_AsyncResponse *ar,
+                   UA_StatusCode status) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+
+    /* The Read service is still running and has suspended the service lock
+     * for a DataSource. The timeout is handled after it has finished. */
+    if(ar->collecting)
+        return false;
+
+    UA_AsyncOperation *op, *op_tmp;
+    TAILQ_FOREACH_SAFE(op, &ar->ops, parentPointers, op_tmp) {
+        if(op->state == UA_ASYNCOPERATIONSTATE_RETURNED ||
+           op->state == UA_ASYNCOPERATIONSTATE_DONE)
+            continue;
+
+        if(status == UA_STATUSCODE_BADTIMEOUT) {
+            am->stats.timeoutCount++;
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Operation was removed due to a timeout");
+        }
+
+        /* The worker still has the operation */
+        if(op->state == UA_ASYNCOPERATIONSTATE_WORKER) {
+            if(orphanOperation(am, server, op, status))
+                return true;
+            continue;
+        }
+
+        /* Set the status and put it into the result queue */
+        setOperationStatus(op, status);
+        if(op->state == UA_ASYNCOPERATIONSTATE_QUEUED)
+            TAILQ_REMOVE(&am->newQueue, op, pointers);
+        else
+            TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
+        TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
+        op->state = UA_ASYNCOPERATIONSTATE_DONE;
+    }
+    return false;
+}
+
+/* Check if any AsyncResponses have timed out */
 static void
 checkTimeouts(UA_Server *server, void *_) {
     /* Timeouts are not configured */
@@ -128,43 +256,373 @@ checkTimeouts(UA_Server *server, void *_) {
     UA_AsyncManager *am = &server->asyncManager;
     const UA_DateTime tNow = el->dateTime_nowMonotonic(el);
 
+    UA_LOCK(&server->serviceMutex);
     UA_LOCK(&am->queueLock);
 
-    /* Loop over the queue of dispatched ops */
-    UA_AsyncOperation *op = NULL, *op_tmp = NULL;
-    TAILQ_FOREACH_SAFE(op, &am->dispatchedQueue, pointers, op_tmp) {
-        /* The timeout has not passed. Also for all elements following in the queue. */
-        if(tNow <= op->parent->timeout)
+    /* The AsyncResponses are sorted by their deadline. Only the expired ones
+     * at the head of the list are visited. */
+    UA_AsyncResponse *ar, *ar_tmp;
+    TAILQ_FOREACH_SAFE(ar, &am->asyncResponses, pointers, ar_tmp) {
+        if(tNow <= ar->timeout)
             break;
-
-        /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADTIMEOUT;
-        TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
-        TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "Operation was removed due to a timeout");
+        abortAsyncResponse(am, server, ar, UA_STATUSCODE_BADTIMEOUT);
     }
 
-    /* Loop over the queue of new ops */
-    TAILQ_FOREACH_SAFE(op, &am->newQueue, pointers, op_tmp) {
-        /* The timeout has not passed. Also for all elements following in the queue. */
-        if(tNow <= op->parent->timeout)
+    UA_UNLOCK(&am->queueLock);
+
+    /* Integrate async results and send out complete responses */
+    processAsyncResults(server);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/* Move the next operation to the dispatched queue */
+static UA_AsyncOperation *
+dispatchOperation(UA_AsyncManager *am, UA_Server *server,
+                  UA_AsyncOperationState state) {
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+    UA_AsyncOperation *ao = TAILQ_FIRST(&am->newQueue);
+    if(!ao)
+        return NULL;
+    UA_EventLoop *el = server->config.eventLoop;
+    TAILQ_REMOVE(&am->newQueue, ao, pointers);
+    TAILQ_INSERT_TAIL(&am->dispatchedQueue, ao, pointers);
+    ao->state = state;
+    ao->dispatched = el->dateTime_nowMonotonic(el);
+    return ao;
+}
+
+static void
+updateStatistics(UA_AsyncManager *am, const UA_AsyncOperation *ao) {
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+    UA_UInt64 queueTime = (UA_UInt64)(ao->dispatched - ao->enqueued);
+    UA_UInt64 processingTime = (UA_UInt64)(ao->completed - ao->dispatched);
+    UA_AsyncOperationStatistics *stats = &am->stats;
+    stats->operationCount++;
+    stats->queueTime += queueTime;
+    if(queueTime > stats->maxQueueTime)
+        stats->maxQueueTime = queueTime;
+    stats->processingTime += processingTime;
+    if(processingTime > stats->maxProcessingTime)
+        stats->maxProcessingTime = processingTime;
+}
+
+/* Update the statistics and move the operation with its result from the
+ * dispatched queue to the result queue */
+static void
+finishOperation(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperation *ao) {
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+    UA_EventLoop *el = server->config.eventLoop;
+    ao->completed = el->dateTime_nowMonotonic(el);
+    updateStatistics(am, ao);
+    TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
+    TAILQ_INSERT_TAIL(&am->resultQueue, ao, pointers);
+    ao->state = UA_ASYNCOPERATIONSTATE_DONE;
+}
+
+/* Move the result into the operation and the operation to the result stack.
+ * Returns false if the operation has timed out in the meantime. Then the
+ * result is not moved. */
+static UA_Boolean
+returnOperationResult(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperation *ao,
+                      UA_CallMethodResult *result) {
+    UA_LOCK(&am->queueLock);
+
+    /* See if the operation is still in the dispatched queue. Otherwise it has
+     * been removed due to a timeout.
+     *
+     * TODO: Add a tree-structure for the dispatch queue. The linear lookup does
+     * not scale. */
+    UA_AsyncOperation *op = NULL;
+    TAILQ_FOREACH(op, &am->dispatchedQueue, pointers) {
+        if(op == ao)
             break;
+    }
+    if(!op || op->state != UA_ASYNCOPERATIONSTATE_DISPATCHED) {
+        UA_UNLOCK(&am->queueLock);
+        return false;
+    }
 
-        /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADTIMEOUT;
-        TAILQ_REMOVE(&am->newQueue, op, pointers);
-        TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "Operation was removed due to a timeout");
+    /* Move the result into the internal AsyncOperation */
+    UA_EventLoop *el = server->config.eventLoop;
+    ao->response = *result;
+    UA_CallMethodResult_init(result);
+    ao->completed = el->dateTime_nowMonotonic(el);
+    TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
+    ao->state = UA_ASYNCOPERATIONSTATE_RETURNED;
+    UA_UNLOCK(&am->queueLock);
+
+    pushResult(am, server, ao);
+    return true;
+}
+
+/****************/
+/* Result Stack */
+/****************/
+
+/* Push without a lock. The first result for an empty stack adds the delayed
+ * callback. That wakes up the EventLoop to integrate the results. */
+static void
+pushResult(UA_AsyncManager *am, UA_Server *server, UA_AsyncOperation *ao) {
+    void *head;
+    do {
+        head = am->resultStack;
+        ao->next = (UA_AsyncOperation*)head;
+    } while(UA_atomic_cmpxchg(&am->resultStack, head, ao) != head);
+    if(!head) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->addDelayedCallback(el, &am->resultCallback);
     }
+}
+
+/* Take all results from the stack and integrate them in the order they were
+ * returned. Only called from the delayed callback, or after it was removed
+ * from the EventLoop. */
+static void
+takeResults(UA_Server *server) {
+    UA_AsyncManager *am = &server->asyncManager;
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
+    UA_AsyncOperation *ao = (UA_AsyncOperation*)UA_atomic_xchg(&am->resultStack, NULL);
+    if(!ao)
+        return;
+
+    UA_AsyncOperation *fifo = NULL, *next;
+    for(; ao; ao = next) {
+        next = ao->next;
+        ao->next = fifo;
+        fifo = ao;
+    }
+
+    UA_LOCK(&am->queueLock);
+    for(ao = fifo; ao; ao = next) {
+        next = ao->next;
+        if(ao->state != UA_ASYNCOPERATIONSTATE_ORPHANED) {
+            if(ao->state == UA_ASYNCOPERATIONSTATE_WORKER)
+                TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
+            updateStatistics(am, ao);
+            integrateOperationResult(am, server, ao);
+        }
+        UA_AsyncOperation_delete(ao);
+        am->opsCount--;
+    }
     UA_UNLOCK(&am->queueLock);
+}
 
-    /* Integrate async results and send out complete responses */
+static void
+resultCallback(void *application, void *context) {
+    UA_Server *server = (UA_Server*)application;
     UA_LOCK(&server->serviceMutex);
-    processAsyncResults(server);
+    takeResults(server);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/***********/
+/* Workers */
+/***********/
+
+#ifdef UA_ARCHITECTURE_WIN32
+typedef HANDLE UA_WorkerThread;
+#else
+typedef pthread_t UA_WorkerThread;
+#endif
+
+struct UA_AsyncWorkers {
+    UA_Server *server;
+#ifdef UA_ARCHITECTURE_WIN32
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+    UA_Boolean running;
+    size_t pending; /* Notified operations not yet picked up by a worker */
+    size_t threadsSize;
+    UA_WorkerThread *threads; /* Allocated after the struct */
+};
+
+static void
+lockWorkers(UA_AsyncWorkers *aw) {
+#ifdef UA_ARCHITECTURE_WIN32
+    EnterCriticalSection(&aw->mutex);
+#else
+    pthread_mutex_lock(&aw->mutex);
+#endif
+}
+
+static void
+unlockWorkers(UA_AsyncWorkers *aw) {
+#ifdef UA_ARCHITECTURE_WIN32
+    LeaveCriticalSection(&aw->mutex);
+#else
+    pthread_mutex_unlock(&aw->mutex);
+#endif
+}
+
+static void
+notifyWorkers(UA_AsyncWorkers *aw) {
+    lockWorkers(aw);
+    aw->pending++;
+#ifdef UA_ARCHITECTURE_WIN32
+    WakeConditionVariable(&aw->cond);
+#else
+    pthread_cond_signal(&aw->cond);
+#endif
+    unlockWorkers(aw);
+}
+
+/* Block until an operation was notified. Returns false when the workers are
+ * stopped. */
+static UA_Boolean
+waitForOperation(UA_AsyncWorkers *aw) {
+    lockWorkers(aw);
+    while(aw->running && aw->pending == 0) {
+#ifdef UA_ARCHITECTURE_WIN32
+        SleepConditionVariableCS(&aw->cond, &aw->mutex, INFINITE);
+#else
+        pthread_cond_wait(&aw->cond, &aw->mutex);
+#endif
+    }
+    UA_Boolean running = aw->running;
+    if(running)
+        aw->pending--;
+    unlockWorkers(aw);
+    return running;
+}
+
+/* The workers share the queue of new operations. So an idle worker always
+ * takes the next operation and no work has to be redistributed. */
+static void
+processOperations(UA_AsyncWorkers *aw) {
+    UA_Server *server = aw->server;
+    UA_AsyncManager *am = &server->asyncManager;
+    while(waitForOperation(aw)) {
+        /* The operation might have been taken already by the application or
+         * removed due to a timeout */
+        UA_LOCK(&am->queueLock);
+        UA_AsyncOperation *ao =
+            dispatchOperation(am, server, UA_ASYNCOPERATIONSTATE_WORKER);
+        if(!ao) {
+            UA_UNLOCK(&am->queueLock);
+            continue;
+        }
+
+        /* Move the request out. The operation is not deleted until the
+         * worker returns it. But it can be orphaned in the meantime. */
+        UA_CallMethodRequest request = ao->request;
+        UA_CallMethodRequest_init(&ao->request);
+        UA_UNLOCK(&am->queueLock);
+
+        /* Return the result through the lock-free stack. The server thread
+         * integrates it and sends out the response. */
+        UA_EventLoop *el = server->config.eventLoop;
+        ao->response = UA_Server_call(server, &request);
+        ao->completed = el->dateTime_nowMonotonic(el);
+        UA_CallMethodRequest_clear(&request);
+        pushResult(am, server, ao);
+    }
+}
+
+#ifdef UA_ARCHITECTURE_WIN32
+static DWORD WINAPI
+workerThread(LPVOID aw) {
+    processOperations((UA_AsyncWorkers*)aw);
+    return 0;
+}
+#else
+static void *
+workerThread(void *aw) {
+    processOperations((UA_AsyncWorkers*)aw);
+    return NULL;
+}
+#endif
+
+static void
+startWorkers(UA_AsyncManager *am, UA_Server *server) {
+    size_t workers = server->config.asyncOperationWorkers;
+    if(workers == 0)
+        return;
+
+    UA_AsyncWorkers *aw = (UA_AsyncWorkers*)
+        UA_calloc(1, sizeof(UA_AsyncWorkers) + (workers * sizeof(UA_WorkerThread)));
+    if(!aw) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Async Workers: Mem alloc failed");
+        return;
+    }
+    aw->server = server;
+    aw->running = true;
+    aw->threads = (UA_WorkerThread*)(uintptr_t)(aw + 1);
+#ifdef UA_ARCHITECTURE_WIN32
+    InitializeCriticalSection(&aw->mutex);
+    InitializeConditionVariable(&aw->cond);
+#else
+    pthread_mutex_init(&aw->mutex, NULL);
+    pthread_cond_init(&aw->cond, NULL);
+#endif
+
+    /* Operations enqueued before the start are picked up right away */
+    UA_LOCK(&am->queueLock);
+    UA_AsyncOperation *ao;
+    TAILQ_FOREACH(ao, &am->newQueue, pointers)
+        aw->pending++;
+    UA_UNLOCK(&am->queueLock);
+
+    for(; aw->threadsSize < workers; aw->threadsSize++) {
+#ifdef UA_ARCHITECTURE_WIN32
+        aw->threads[aw->threadsSize] = CreateThread(NULL, 0, workerThread, aw, 0, NULL);
+        UA_Boolean created = (aw->threads[aw->threadsSize] != NULL);
+#else
+        UA_Boolean created =
+            (pthread_create(&aw->threads[aw->threadsSize], NULL, workerThread, aw) == 0);
+#endif
+        if(!created) {
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "Async Workers: Could only start %u of %u threads",
+                           (unsigned)aw->threadsSize, (unsigned)workers);
+            break;
+        }
+    }
+
+    am->workers = aw;
+}
+
+static void
+stopWorkers(UA_AsyncManager *am, UA_Server *server) {
+    UA_AsyncWorkers *aw = am->workers;
+    if(!aw)
+        return;
+
+    lockWorkers(aw);
+    aw->running = false;
+#ifdef UA_ARCHITECTURE_WIN32
+    WakeAllConditionVariable(&aw->cond);
+#else
+    pthread_cond_broadcast(&aw->cond);
+#endif
+    unlockWorkers(aw);
+
+    /* The workers take the service lock to call the method and to send the
+     * response. Release it until they have finished. */
     UA_UNLOCK(&server->serviceMutex);
+    for(size_t i = 0; i < aw->threadsSize; i++) {
+#ifdef UA_ARCHITECTURE_WIN32
+        WaitForSingleObject(aw->threads[i], INFINITE);
+        CloseHandle(aw->threads[i]);
+#else
+        pthread_join(aw->threads[i], NULL);
+#endif
+    }
+    UA_LOCK(&server->serviceMutex);
+
+#ifdef UA_ARCHITECTURE_WIN32
+    DeleteCriticalSection(&aw->mutex);
+#else
+    pthread_cond_destroy(&aw->cond);
+    pthread_mutex_destroy(&aw->mutex);
+#endif
+    am->workers = NULL;
+    UA_free(aw);
 }
 
 void
@@ -175,6 +633,8 @@ UA_AsyncManager_init(UA_AsyncManager *am, UA_Server *server) {
     TAILQ_INIT(&am->dispatchedQueue);
     TAILQ_INIT(&am->resultQueue);
     UA_LOCK_INIT(&am->queueLock);
+    am->resultCallback.callback = resultCallback;
+    am->resultCallback.application = server;
 }
 
 void
@@ -183,21 +643,44 @@ UA_AsyncManager_start(UA_AsyncManager *am, UA_Server *server) {
      * responses at a 100ms interval. */
     addRepeatedCallback(server, (UA_ServerCallback)checkTimeouts, NULL, 100.0,
                         &am->checkTimeoutCallbackId);
+
+    startWorkers(am, server);
 }
 
 void
 UA_AsyncManager_stop(UA_AsyncManager *am, UA_Server *server) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
     /* Add a regular callback for checking timeouts and sending finished
      * responses at a 100ms interval. */
     removeCallback(server, am->checkTimeoutCallbackId);
+
+    /* Integrate the last results from the workers */
+    stopWorkers(am, server);
+    UA_EventLoop *el = server->config.eventLoop;
+    el->removeDelayedCallback(el, &am->resultCallback);
+    takeResults(server);
 }
 
 void
 UA_AsyncManager_clear(UA_AsyncManager *am, UA_Server *server) {
     UA_AsyncOperation *ar, *ar_tmp;
 
-    /* Clean up queues */
+    /* Results that were returned after the stop. Worker operations are also
+     * in the dispatched queue. */
+    UA_EventLoop *el = server->config.eventLoop;
+    if(el)
+        el->removeDelayedCallback(el, &am->resultCallback);
     UA_LOCK(&am->queueLock);
+    ar = (UA_AsyncOperation*)UA_atomic_xchg(&am->resultStack, NULL);
+    for(; ar; ar = ar_tmp) {
+        ar_tmp = ar->next;
+        if(ar->state == UA_ASYNCOPERATIONSTATE_WORKER)
+            TAILQ_REMOVE(&am->dispatchedQueue, ar, pointers);
+        UA_AsyncOperation_delete(ar);
+    }
+
+    /* Clean up queues */
     TAILQ_FOREACH_SAFE(ar, &am->newQueue, pointers, ar_tmp) {
         TAILQ_REMOVE(&am->newQueue, ar, pointers);
         UA_AsyncOperation_delete(ar);
@@ -244,6 +727,8 @@ UA_AsyncManager_createAsyncResponse(UA_AsyncManager *am, UA_Server *server,
     am->asyncResponsesCount += 1;
     newentry->requestId = requestId;
     newentry->requestHandle = requestHandle;
+    newentry->operationType = operationType;
+    TAILQ_INIT(&newentry->ops);
     newentry->timeout = el->dateTime_nowMonotonic(el);
     if(server->config.asyncOperationTimeout > 0.0)
         newentry->timeout += (UA_DateTime)(server->config.asyncOperationTimeout *
@@ -259,11 +744,51 @@ void
 UA_AsyncManager_removeAsyncResponse(UA_AsyncManager *am, UA_AsyncResponse *ar) {
     TAILQ_REMOVE(&am->asyncResponses, ar, pointers);
     am->asyncResponsesCount -= 1;
-    UA_CallResponse_clear(&ar->response.callResponse);
+    UA_clear(&ar->response, asyncResponseType(ar));
     UA_NodeId_clear(&ar->sessionId);
     UA_free(ar);
 }
 
+UA_StatusCode
+UA_AsyncManager_admitRequest(UA_AsyncManager *am, UA_Server *server,
+                             const UA_Session *session) {
+    UA_ServerConfig *config = &server->config;
+    if(config->maxPendingRequestsPerSession == 0 &&
+       config->maxPendingRequests == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&am->queueLock);
+
+    /* The server is overloaded. Either too many requests are in flight or the
+     * queue of async operations is full. */
+    if(config->maxPendingRequests != 0 &&
+       (am->asyncResponsesCount >= config->maxPendingRequests ||
+        (config->maxAsyncOperationQueueSize != 0 &&
+         am->opsCount >= config->maxAsyncOperationQueueSize))) {
+        res = UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+        goto out;
+    }
+
+    /* The session has too many requests in flight */
+    if(config->maxPendingRequestsPerSession != 0) {
+        size_t count = 0;
+        UA_AsyncResponse *ar;
+        TAILQ_FOREACH(ar, &am->asyncResponses, pointers) {
+            if(!UA_NodeId_equal(&ar->sessionId, &session->sessionId))
+                continue;
+            if(++count >= config->maxPendingRequestsPerSession) {
+                res = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+                break;
+            }
+        }
+    }
+
+ out:
+    UA_UNLOCK(&am->queueLock);
+    return res;
+}
+
 /* Enqueue next MethodRequest */
 UA_StatusCode
 UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
@@ -292,22 +817,159 @@ UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
         return result;
     }
 
+    UA_EventLoop *el = server->config.eventLoop;
     UA_CallMethodResult_init(&ao->response);
     ao->index = opIndex;
     ao->parent = ar;
+    ao->enqueued = el->dateTime_nowMonotonic(el);
 
     UA_LOCK(&am->queueLock);
+    ao->state = UA_ASYNCOPERATIONSTATE_QUEUED;
     TAILQ_INSERT_TAIL(&am->newQueue, ao, pointers);
+    TAILQ_INSERT_TAIL(&ar->ops, ao, parentPointers);
     am->opsCount++;
     ar->opCountdown++;
     UA_UNLOCK(&am->queueLock);
 
+    if(am->workers)
+        notifyWorkers(am->workers);
+
     if(server->config.asyncOperationNotifyCallback)
         server->config.asyncOperationNotifyCallback(server);
 
     return UA_STATUSCODE_GOOD;
 }
 
+/* Remove an async read that has not been handed to the AsyncResponse */
+static void
+removeAsyncRead(UA_AsyncManager *am, UA_AsyncOperation *ao) {
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+    if(ao->state == UA_ASYNCOPERATIONSTATE_DISPATCHED)
+        TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
+    TAILQ_REMOVE(&ao->parent->ops, ao, parentPointers);
+    ao->parent->opCountdown--;
+    am->opsCount--;
+    UA_AsyncOperation_delete(ao);
+}
+
+UA_StatusCode
+UA_AsyncManager_beginAsyncRead(UA_AsyncManager *am, UA_Server *server,
+                               UA_Session *session, UA_DataValue *value,
+                               UA_AsyncOperation **outOp) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_AsyncReadContext *ctx = session->asyncRead;
+    *outOp = NULL;
+
+    UA_AsyncOperation *ao = (UA_AsyncOperation*)
+        UA_calloc(1, sizeof(UA_AsyncOperation));
+    if(!ao)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* The Read service can run concurrently on the shared side of the service
+     * lock. The queueLock protects the AsyncResponses then. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&am->queueLock);
+    if(server->config.maxAsyncOperationQueueSize != 0 &&
+       am->opsCount >= server->config.maxAsyncOperationQueueSize) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Async Read: Queue exceeds limit (%d).",
+                       (int unsigned)server->config.maxAsyncOperationQueueSize);
+        res = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+        goto out;
+    }
+
+    /* Create the AsyncResponse for the first DataSource read */
+    if(!ctx->ar) {
+        res = UA_AsyncManager_createAsyncResponse(am, server, &session->sessionId,
+                                                  ctx->requestId, ctx->requestHandle,
+                                                  UA_ASYNCOPERATIONTYPE_READ_DATASOURCE,
+                                                  &ctx->ar);
+        if(res != UA_STATUSCODE_GOOD)
+            goto out;
+        ctx->ar->timestampsToReturn = ctx->timestampsToReturn;
+        ctx->ar->collecting = true;
+    }
+
+    /* The operation is dispatched to the DataSource right away */
+    UA_EventLoop *el = server->config.eventLoop;
+    if(++am->lastOperationId == 0)
+        am->lastOperationId = 1;
+    ao->id = am->lastOperationId;
+    ao->parent = ctx->ar;
+    ao->readValue = value;
+    ao->inReadCallback = true;
+    ao->enqueued = el->dateTime_nowMonotonic(el);
+    ao->dispatched = ao->enqueued;
+    ao->state = UA_ASYNCOPERATIONSTATE_DISPATCHED;
+    TAILQ_INSERT_TAIL(&am->dispatchedQueue, ao, pointers);
+    TAILQ_INSERT_TAIL(&ctx->ar->ops, ao, parentPointers);
+    am->opsCount++;
+    ctx->ar->opCountdown++;
+    *outOp = ao;
+    ao = NULL;
+
+ out:
+    UA_UNLOCK(&am->queueLock);
+    UA_free(ao);
+    return res;
+}
+
+void
+UA_AsyncManager_endAsyncRead(UA_AsyncManager *am, UA_Server *server,
+                             UA_AsyncOperation *ao, UA_Boolean pending) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_LOCK(&am->queueLock);
+    ao->inReadCallback = false;
+    if(!pending)
+        removeAsyncRead(am, ao);
+    UA_UNLOCK(&am->queueLock);
+}
+
+UA_Boolean
+UA_AsyncManager_finishAsyncReads(UA_AsyncManager *am, UA_Server *server,
+                                 UA_Session *session, UA_AsyncReadContext *ctx,
+                                 UA_ReadResponse *response) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_AsyncResponse *ar = ctx->ar;
+    if(!ar)
+        return false;
+
+    UA_LOCK(&am->queueLock);
+    UA_AsyncOperation *ao, *ao_tmp;
+    TAILQ_FOREACH_SAFE(ao, &ar->ops, parentPointers, ao_tmp) {
+        /* Not a result slot of the response (e.g. the sampling of a
+         * MonitoredItem while the service lock was suspended) */
+        if(ao->readValue < response->results ||
+           ao->readValue >= &response->results[response->resultsSize]) {
+            removeAsyncRead(am, ao);
+            continue;
+        }
+        ao->index = (size_t)(ao->readValue - response->results);
+        ao->readValue = NULL;
+
+        /* Integrate the results that were returned early */
+        if(ao->state == UA_ASYNCOPERATIONSTATE_EARLY) {
+            setReadResult(server, ar, ao, &response->results[ao->index]);
+            removeAsyncRead(am, ao);
+        }
+    }
+
+    /* All operations are done. Send the response right away. */
+    if(ar->opCountdown == 0) {
+        UA_AsyncManager_removeAsyncResponse(am, ar);
+        UA_UNLOCK(&am->queueLock);
+        return false;
+    }
+
+    /* Move the response. The results of the pending operations are set with
+     * UA_Server_setAsyncReadResult. */
+    ar->response.readResponse = *response;
+    UA_ReadResponse_init(response);
+    ar->collecting = false;
+    UA_UNLOCK(&am->queueLock);
+    return true;
+}
+
 /* Get and remove next Method Call Request */
 UA_Boolean
 UA_Server_getAsyncOperationNonBlocking(UA_Server *server, UA_AsyncOperationType *type,
@@ -318,10 +980,9 @@ UA_Server_getAsyncOperationNonBlocking(UA_Server *server, UA_AsyncOperationType
     UA_Boolean bRV = false;
     *type = UA_ASYNCOPERATIONTYPE_INVALID;
     UA_LOCK(&am->queueLock);
-    UA_AsyncOperation *ao = TAILQ_FIRST(&am->newQueue);
+    UA_AsyncOperation *ao =
+        dispatchOperation(am, server, UA_ASYNCOPERATIONSTATE_DISPATCHED);
     if(ao) {
-        TAILQ_REMOVE(&am->newQueue, ao, pointers);
-        TAILQ_INSERT_TAIL(&am->dispatchedQueue, ao, pointers);
         *type = UA_ASYNCOPERATIONTYPE_CALL;
         *request = (UA_AsyncOperationRequest *)&ao->request;
         *context = (void *)ao;
@@ -349,43 +1010,113 @@ UA_Server_setAsyncOperationResult(UA_Server *server,
         return;
     }
 
-    UA_LOCK(&am->queueLock);
+    /* Copy the result. The copy is moved into the internal AsyncOperation. */
+    UA_CallMethodResult result;
+    UA_StatusCode res =
+        UA_CallMethodResult_copy(&response->callMethodResult, &result);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(
+            server->config.logging, UA_LOGCATEGORY_SERVER,
+            "UA_Server_SetAsyncMethodResult: UA_CallMethodResult_copy failed.");
+        UA_CallMethodResult_init(&result);
+        result.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+    }
 
-    /* See if the operation is still in the dispatched queue. Otherwise it has
-     * been removed due to a timeout.
-     *
-     * TODO: Add a tree-structure for the dispatch queue. The linear lookup does
-     * not scale. */
-    UA_AsyncOperation *op = NULL;
+    if(!returnOperationResult(am, server, ao, &result)) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "UA_Server_SetAsyncMethodResult: The operation has timed out");
+        UA_CallMethodResult_clear(&result);
+        return;
+    }
+
+    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                 "Set the result from the worker thread");
+}
+
+/* Find an async read that is still pending.
+ *
+ * TODO: Add a tree-structure for the dispatch queue. The linear lookup does
+ * not scale. */
+static UA_AsyncOperation *
+findAsyncRead(UA_AsyncManager *am, UA_UInt32 operationId) {
+    UA_LOCK_ASSERT(&am->queueLock, 1);
+    UA_AsyncOperation *op;
     TAILQ_FOREACH(op, &am->dispatchedQueue, pointers) {
-        if(op == ao)
+        if(op->id == operationId &&
+           op->state == UA_ASYNCOPERATIONSTATE_DISPATCHED &&
+           op->parent->operationType == UA_ASYNCOPERATIONTYPE_READ_DATASOURCE)
+            return op;
+    }
+    return NULL;
+}
+
+UA_UInt32
+UA_Server_getAsyncReadId(UA_Server *server, const UA_DataValue *value) {
+    if(!server || !value)
+        return 0;
+
+    /* Only the operations whose DataSource is called right now are
+     * considered. So the pointer is unambiguous. */
+    UA_UInt32 id = 0;
+    UA_AsyncManager *am = &server->asyncManager;
+    UA_LOCK(&am->queueLock);
+    UA_AsyncOperation *op;
+    TAILQ_FOREACH(op, &am->dispatchedQueue, pointers) {
+        if(op->inReadCallback && op->readValue == value) {
+            id = op->id;
             break;
+        }
     }
+    UA_UNLOCK(&am->queueLock);
+    return id;
+}
+
+UA_StatusCode
+UA_Server_setAsyncReadResult(UA_Server *server, UA_UInt32 operationId,
+                             const UA_DataValue *result) {
+    if(!server || operationId == 0 || !result)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    UA_AsyncManager *am = &server->asyncManager;
+    UA_LOCK(&server->serviceMutex);
+    UA_LOCK(&am->queueLock);
+
+    UA_AsyncOperation *op = findAsyncRead(am, operationId);
     if(!op) {
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "UA_Server_SetAsyncMethodResult: The operation has timed out");
         UA_UNLOCK(&am->queueLock);
-        return;
+        UA_UNLOCK(&server->serviceMutex);
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "UA_Server_setAsyncReadResult: The operation has "
+                       "timed out or is unknown");
+        return UA_STATUSCODE_BADNOTFOUND;
     }
 
-    /* Copy the result into the internal AsyncOperation */
-    UA_StatusCode result =
-        UA_CallMethodResult_copy(&response->callMethodResult, &ao->response);
-    if(result != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING(
-            server->config.logging, UA_LOGCATEGORY_SERVER,
-            "UA_Server_SetAsyncMethodResult: UA_CallMethodResult_copy failed.");
-        ao->response.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_DataValue_copy(result, &op->readResult);
+    if(res != UA_STATUSCODE_GOOD) {
+        op->readResult.hasStatus = true;
+        op->readResult.status = res;
     }
 
-    /* Move to the result queue */
-    TAILQ_REMOVE(&am->dispatchedQueue, ao, pointers);
-    TAILQ_INSERT_TAIL(&am->resultQueue, ao, pointers);
+    /* The Read service is still running. The result is integrated when it
+     * has finished. */
+    if(op->parent->collecting) {
+        UA_EventLoop *el = server->config.eventLoop;
+        op->completed = el->dateTime_nowMonotonic(el);
+        updateStatistics(am, op);
+        TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
+        op->state = UA_ASYNCOPERATIONSTATE_EARLY;
+        UA_UNLOCK(&am->queueLock);
+        UA_UNLOCK(&server->serviceMutex);
+        return res;
+    }
 
+    finishOperation(am, server, op);
     UA_UNLOCK(&am->queueLock);
 
-    UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
-                 "Set the result from the worker thread");
+    /* Send out the response if this was the last pending operation */
+    processAsyncResults(server);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
 }
 
 /******************/
@@ -411,37 +1142,6 @@ UA_Server_setMethodNodeAsync(UA_Server *server, const UA_NodeId id, UA_Boolean i
     return res;
 }
 
-UA_StatusCode
-UA_Server_processServiceOperationsAsync(
-    UA_Server *server, UA_Session *session, UA_UInt32 requestId, UA_UInt32 requestHandle,
-    UA_AsyncServiceOperation operationCallback, const size_t *requestOperations,
-    const UA_DataType *requestOperationsType, size_t *responseOperations,
-    const UA_DataType *responseOperationsType, UA_AsyncResponse **ar) {
-    size_t ops = *requestOperations;
-    if(ops == 0)
-        return UA_STATUSCODE_BADNOTHINGTODO;
-
-    /* Allocate the response array. No padding after size_t */
-    void **respPos = (void **)((uintptr_t)responseOperations + sizeof(size_t));
-    *respPos = UA_Array_new(ops, responseOperationsType);
-    if(!*respPos)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    *responseOperations = ops;
-
-    /* Finish / dispatch the operations. This may allocate a new AsyncResponse internally
-     */
-    uintptr_t respOp = (uintptr_t)*respPos;
-    uintptr_t reqOp = *(uintptr_t *)((uintptr_t)requestOperations + sizeof(size_t));
-    for(size_t i = 0; i < ops; i++) {
-        operationCallback(server, session, requestId, requestHandle, i, (void *)reqOp,
-                          (void *)respOp, ar);
-        reqOp += requestOperationsType->memSize;
-        respOp += responseOperationsType->memSize;
-    }
-
-    return UA_STATUSCODE_GOOD;
-}
-
 UA_UInt32
 UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 requestHandle) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
@@ -449,42 +1149,25 @@ UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 request
 
     UA_LOCK(&am->queueLock);
 
-    /* Loop over the queue of dispatched ops */
-    UA_AsyncOperation *op = NULL, *op_tmp = NULL;
-    TAILQ_FOREACH_SAFE(op, &am->dispatchedQueue, pointers, op_tmp) {
-        if(op->parent->requestHandle != requestHandle ||
-           !UA_NodeId_equal(&session->sessionId, &op->parent->sessionId))
-            continue;
-
-        /* Set status and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
-        TAILQ_REMOVE(&am->dispatchedQueue, op, pointers);
-        TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
-
-        /* Also set the status of the overall response */
-        op->parent->response.callResponse.responseHeader.serviceResult =
-            UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
-    }
-
-    /* Idem for waiting ops */
-    TAILQ_FOREACH_SAFE(op, &am->newQueue, pointers, op_tmp) {
-        if(op->parent->requestHandle != requestHandle ||
-           !UA_NodeId_equal(&session->sessionId, &op->parent->sessionId))
+    /* Set the status of the outstanding operations. A response whose
+     * operations were all with a worker is sent right away. */
+    UA_UInt32 count = 0;
+    UA_AsyncResponse *ar, *ar_tmp;
+    TAILQ_FOREACH_SAFE(ar, &am->asyncResponses, pointers, ar_tmp) {
+        if(ar->requestHandle != requestHandle ||
+           !UA_NodeId_equal(&session->sessionId, &ar->sessionId))
             continue;
-
-        /* Mark as timed out and put it into the result queue */
-        op->response.statusCode = UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
-        TAILQ_REMOVE(&am->newQueue, op, pointers);
-        TAILQ_INSERT_TAIL(&am->resultQueue, op, pointers);
-
-        op->parent->response.callResponse.responseHeader.serviceResult =
+        ar->response.callResponse.responseHeader.serviceResult =
             UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT;
+        if(abortAsyncResponse(am, server, ar,
+                              UA_STATUSCODE_BADREQUESTCANCELLEDBYCLIENT))
+            count++;
     }
 
     UA_UNLOCK(&am->queueLock);
 
     /* Process messages that have all ops completed */
-    return processAsyncResults(server);
+    return count + processAsyncResults(server);
 }
 
 #endif
@@ -26,17 +26,50 @@ _UA_BEGIN_DECLS
 struct UA_AsyncResponse;
 typedef struct UA_AsyncResponse UA_AsyncResponse;
 
+/* Where is the operation? It is always in the list of its parent
+ * AsyncResponse, except when ORPHANED. */
+typedef enum {
+    UA_ASYNCOPERATIONSTATE_QUEUED,     /* In the newQueue */
+    UA_ASYNCOPERATIONSTATE_DISPATCHED, /* Taken by the application. In the
+                                        * dispatchedQueue. */
+    UA_ASYNCOPERATIONSTATE_WORKER,     /* Taken by a server-owned worker. In the
+                                        * dispatchedQueue, possibly already in
+                                        * the result stack. */
+    UA_ASYNCOPERATIONSTATE_RETURNED,   /* In the result stack */
+    UA_ASYNCOPERATIONSTATE_DONE,       /* In the resultQueue */
+    UA_ASYNCOPERATIONSTATE_EARLY,      /* Async read returned while the Read
+                                        * service is still running. Only in
+                                        * the list of the AsyncResponse. */
+    UA_ASYNCOPERATIONSTATE_ORPHANED    /* Timed out or cancelled while in a
+                                        * worker or the result stack. Deleted
+                                        * when taken from the result stack. */
+} UA_AsyncOperationState;
+
 /* A single operation (of a larger request) */
 typedef struct UA_AsyncOperation {
     TAILQ_ENTRY(UA_AsyncOperation) pointers;
+    TAILQ_ENTRY(UA_AsyncOperation) parentPointers; /* In the AsyncResponse */
+    struct UA_AsyncOperation *next; /* In the lock-free result stack */
+    UA_AsyncOperationState state;   /* Protected by the queueLock */
     UA_CallMethodRequest request;
     UA_CallMethodResult	response;
+    UA_DataValue readResult;  /* For async DataSource reads */
+    UA_DataValue *readValue;  /* The result slot handed to the DataSource. Only
+                               * used while the Read service runs. */
+    UA_Boolean inReadCallback;
+    UA_UInt32 id;             /* Identifies async reads, never zero */
     size_t index;             /* Index of the operation in the array of ops in
                                * request/response */
+    UA_DateTime enqueued;     /* Statistics */
+    UA_DateTime dispatched;
+    UA_DateTime completed;
     UA_AsyncResponse *parent; /* Always non-NULL. The parent is only removed
-                               * when its operations are removed */
+                               * when its operations are removed. Dangling
+                               * when ORPHANED. */
 } UA_AsyncOperation;
 
+typedef TAILQ_HEAD(UA_AsyncOperationQueue, UA_AsyncOperation) UA_AsyncOperationQueue;
+
 struct UA_AsyncResponse {
     TAILQ_ENTRY(UA_AsyncResponse) pointers; /* Insert new at the end */
     UA_UInt32 requestId;
@@ -44,6 +77,9 @@ struct UA_AsyncResponse {
     UA_UInt32 requestHandle;
     UA_DateTime	timeout;
     UA_AsyncOperationType operationType;
+    UA_TimestampsToReturn timestampsToReturn; /* For async DataSource reads */
+    UA_Boolean collecting; /* The Read service is still running. The response
+                            * is not yet moved into the AsyncResponse. */
     union {
         UA_CallResponse callResponse;
         UA_ReadResponse readResponse;
@@ -51,12 +87,16 @@ struct UA_AsyncResponse {
     } response;
     UA_UInt32 opCountdown; /* Counter for outstanding operations. The AR can
                             * only be deleted when all have returned. */
+    UA_AsyncOperationQueue ops; /* The outstanding operations */
 };
 
-typedef TAILQ_HEAD(UA_AsyncOperationQueue, UA_AsyncOperation) UA_AsyncOperationQueue;
+/* Server-owned worker threads (config.asyncOperationWorkers) */
+struct UA_AsyncWorkers;
+typedef struct UA_AsyncWorkers UA_AsyncWorkers;
 
 typedef struct {
-    /* Requests / Responses */
+    /* Requests / Responses. All have the same timeout duration. So the list is
+     * sorted by the deadline. */
     TAILQ_HEAD(, UA_AsyncResponse) asyncResponses;
     size_t asyncResponsesCount;
 
@@ -71,7 +111,20 @@ typedef struct {
                                              * returned, we search for the op here to see if it
                                              * is still "alive" (not timed out). */
     UA_AsyncOperationQueue resultQueue;     /* Results to be integrated */
-    size_t opsCount; /* How many operations are transient (in one of the three queues)? */
+    size_t opsCount; /* How many operations are transient (in one of the
+                      * queues, the result stack or a worker)? */
+
+    /* Results returned from other threads. A lock-free intrusive stack of
+     * UA_AsyncOperation. Pushed by the workers and the application. Only the
+     * delayed callback takes the results out. The first push onto the empty
+     * stack adds the delayed callback to the EventLoop. */
+    void * volatile resultStack;
+    UA_DelayedCallback resultCallback;
+
+    UA_AsyncOperationStatistics stats; /* Protected by the queueLock */
+    UA_UInt32 lastOperationId;         /* Protected by the queueLock */
+
+    UA_AsyncWorkers *workers;
 
     UA_UInt64 checkTimeoutCallbackId; /* Registered repeated callbacks */
 } UA_AsyncManager;
@@ -93,35 +146,55 @@ UA_AsyncManager_createAsyncResponse(UA_AsyncManager *am, UA_Server *server,
 void
 UA_AsyncManager_removeAsyncResponse(UA_AsyncManager *am, UA_AsyncResponse *ar);
 
+/* Admission control for a new request that can be answered asynchronously.
+ * Takes the queueLock. Returns Bad_TooManyOperations if the session has too
+ * many requests in flight and Bad_ResourceUnavailable if the server is
+ * overloaded. */
+UA_StatusCode
+UA_AsyncManager_admitRequest(UA_AsyncManager *am, UA_Server *server,
+                             const UA_Session *session);
+
 UA_StatusCode
 UA_AsyncManager_createAsyncOp(UA_AsyncManager *am, UA_Server *server,
                               UA_AsyncResponse *ar, size_t opIndex,
                               const UA_CallMethodRequest *opRequest);
 
+/* Async DataSource reads. The Read service sets the context in the Session.
+ * Every DataSource read into the ReadResponse registers an operation before
+ * the DataSource is called. So the DataSource can complete the operation
+ * right away from a different thread. The operations are removed again if the
+ * DataSource returns synchronously. */
+typedef struct UA_AsyncReadContext {
+    UA_UInt32 requestId;
+    UA_UInt32 requestHandle;
+    UA_TimestampsToReturn timestampsToReturn;
+    UA_AsyncResponse *ar; /* Created for the first DataSource read */
+} UA_AsyncReadContext;
+
+UA_StatusCode
+UA_AsyncManager_beginAsyncRead(UA_AsyncManager *am, UA_Server *server,
+                               UA_Session *session, UA_DataValue *value,
+                               UA_AsyncOperation **outOp);
+
+/* Remove the operation if the DataSource has returned synchronously */
+void
+UA_AsyncManager_endAsyncRead(UA_AsyncManager *am, UA_Server *server,
+                             UA_AsyncOperation *ao, UA_Boolean pending);
+
+/* Move the response to the AsyncResponse if async DataSource reads are still
+ * pending. Returns true if the response is sent later. The results that were
+ * returned during the Read service are integrated right away. */
+UA_Boolean
+UA_AsyncManager_finishAsyncReads(UA_AsyncManager *am, UA_Server *server,
+                                 UA_Session *session, UA_AsyncReadContext *ctx,
+                                 UA_ReadResponse *response);
+
 /* Send out the response with status set. Also removes all outstanding
  * operations from the dispatch queue. The queuelock needs to be taken before
  * calling _cancel. */
 UA_UInt32
 UA_AsyncManager_cancel(UA_Server *server, UA_Session *session, UA_UInt32 requestHandle);
 
-typedef void (*UA_AsyncServiceOperation)(UA_Server *server, UA_Session *session,
-                                         UA_UInt32 requestId, UA_UInt32 requestHandle,
-                                         size_t opIndex, const void *requestOperation,
-                                         void *responseOperation, UA_AsyncResponse **ar);
-
-/* Creates an AsyncResponse in-situ when an async operation is encountered. If
- * that is the case, the sync responses are moved to the AsyncResponse. */
-UA_StatusCode
-UA_Server_processServiceOperationsAsync(UA_Server *server, UA_Session *session,
-                                        UA_UInt32 requestId, UA_UInt32 requestHandle,
-                                        UA_AsyncServiceOperation operationCallback,
-                                        const size_t *requestOperations,
-                                        const UA_DataType *requestOperationsType,
-                                        size_t *responseOperations,
-                                        const UA_DataType *responseOperationsType,
-                                        UA_AsyncResponse **ar)
-UA_FUNC_ATTR_WARN_UNUSED_RESULT;
-
 #endif /* UA_MULTITHREADING >= 100 */
 
 _UA_END_DECLS
@@ -29,6 +29,7 @@
 # include <winsock2.h>
 #else
 # include <unistd.h>
+# include <time.h>
 #endif
 
 #define STARTCHANNELID 1
@@ -97,10 +98,18 @@ typedef struct {
     UA_UInt32 lastChannelId;
     UA_UInt32 lastTokenId;
 
+    /* Token bucket for config.maxNewSecureChannelsPerSecond */
+    UA_Double channelTokens;
+    UA_DateTime channelTokensUpdate;
+
     /* Reverse Connections */
     LIST_HEAD(, reverse_connect_context) reverseConnects;
     UA_UInt64 reverseConnectsCheckHandle;
     UA_UInt64 lastReverseConnectHandle;
+
+#ifdef UA_ENABLE_STATIC_POOLS
+    UA_ObjectPool channelPool; /* Capacity of maxSecureChannels */
+#endif
 } UA_BinaryProtocolManager;
 
 void setReverseConnectState(UA_Server *server, reverse_connect_context *context,
@@ -139,6 +148,54 @@ setBinaryProtocolManagerState(UA_Server *server,
         bpm->sc.notifyState(server, &bpm->sc, state);
 }
 
+/* Connections of the network EventLoops are served from the threads of the
+ * application. Their callbacks take the server lock before touching the state
+ * shared with the main EventLoop. */
+static UA_Boolean
+isNetworkEventLoop(UA_Server *server, const UA_ConnectionManager *cm) {
+#if UA_MULTITHREADING >= 100
+    return (cm && cm->eventSource.eventLoop != server->config.eventLoop);
+#else
+    (void)server;
+    (void)cm;
+    return false;
+#endif
+}
+
+static UA_Boolean
+lockNetworkEventLoop(UA_Server *server, const UA_ConnectionManager *cm) {
+    if(!isNetworkEventLoop(server, cm))
+        return false;
+    UA_LOCK(&server->serviceMutex);
+    return true;
+}
+
+static void
+unlockNetworkEventLoop(UA_Server *server, UA_Boolean locked) {
+    (void)server;
+    if(locked) {
+        UA_UNLOCK(&server->serviceMutex);
+    }
+}
+
+UA_Boolean
+lockSharedForCrypto(UA_Server *server, const UA_SecureChannel *channel) {
+    if(!isNetworkEventLoop(server, channel->connectionManager))
+        return false;
+    UA_UNLOCK(&server->serviceMutex);
+    UA_LOCK_SHARED(&server->serviceMutex);
+    return true;
+}
+
+void
+unlockSharedForCrypto(UA_Server *server, UA_Boolean shared) {
+    (void)server;
+    if(shared) {
+        UA_UNLOCK_SHARED(&server->serviceMutex);
+        UA_LOCK(&server->serviceMutex);
+    }
+}
+
 static void
 deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
                           UA_SecureChannel *channel) {
@@ -150,6 +207,17 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
      * SecureChannel. */
     while(channel->sessions)
         UA_Session_detachFromSecureChannel(channel->sessions);
+
+    UA_LOG_DEBUG_CHANNEL(bpm->logging, channel,
+                         "Received %lu chunks in %lu buffers "
+                         "(at most %lu chunks per buffer)",
+                         (unsigned long)channel->receivedChunkCount,
+                         (unsigned long)channel->receivedBufferCount,
+                         (unsigned long)channel->maxChunksPerBuffer);
+
+    /* Clearing resets the channel for reuse. Keep the reason for the
+     * statistics. */
+    UA_ShutdownReason reason = channel->shutdownReason;
     UA_SecureChannel_clear(channel);
 
     /* Detach the channel from the server list */
@@ -158,7 +226,7 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
     /* Update the statistics */
     UA_SecureChannelStatistics *scs = &bpm->server->secureChannelStatistics;
     scs->currentChannelCount--;
-    switch(channel->shutdownReason) {
+    switch(reason) {
     case UA_SHUTDOWNREASON_CLOSE:
         UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel closed");
         break;
@@ -184,20 +252,18 @@ deleteServerSecureChannel(UA_BinaryProtocolManager *bpm,
         break;
     }
 
-    UA_free(channel);
+    UA_POOL_FREE(channel);
 }
 
 UA_StatusCode
 sendServiceFault(UA_Server *server, UA_SecureChannel *channel,
                  UA_UInt32 requestId, UA_UInt32 requestHandle,
                  UA_StatusCode statusCode) {
-    UA_EventLoop *el = server->config.eventLoop;
-
     UA_ServiceFault response;
     UA_ServiceFault_init(&response);
     UA_ResponseHeader *responseHeader = &response.responseHeader;
     responseHeader->requestHandle = requestHandle;
-    responseHeader->timestamp = el->dateTime_now(el);
+    responseHeader->timestamp = getCachedTime(server);
     responseHeader->serviceResult = statusCode;
 
     UA_LOG_DEBUG(channel->securityPolicy->logger, UA_LOGCATEGORY_SERVER,
@@ -214,13 +280,13 @@ sendServiceFault(UA_Server *server, UA_SecureChannel *channel,
 /* This is not an ERR message, the connection is not closed afterwards */
 static UA_StatusCode
 decodeHeaderSendServiceFault(UA_Server *server, UA_SecureChannel *channel,
-                             const UA_ByteString *msg, size_t offset,
-                             const UA_DataType *responseType, UA_UInt32 requestId,
-                             UA_StatusCode error) {
+                             const UA_ByteString *msg, size_t msgSegments,
+                             size_t offset, const UA_DataType *responseType,
+                             UA_UInt32 requestId, UA_StatusCode error) {
     UA_RequestHeader requestHeader;
     UA_StatusCode retval =
-        UA_decodeBinaryInternal(msg, &offset, &requestHeader,
-                                &UA_TYPES[UA_TYPES_REQUESTHEADER], NULL);
+        UA_decodeBinaryInternalSegments(msg, msgSegments, &offset, &requestHeader,
+                                        &UA_TYPES[UA_TYPES_REQUESTHEADER], NULL);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     retval = sendServiceFault(server, channel, requestId, requestHeader.requestHandle, error);
@@ -342,6 +408,7 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
     UA_NodeId_clear(&requestType);
 
     /* Call the service */
+    UA_Boolean renew = (channel->state == UA_SECURECHANNELSTATE_OPEN);
     UA_OpenSecureChannelResponse openScResponse;
     UA_OpenSecureChannelResponse_init(&openScResponse);
     Service_OpenSecureChannel(server, channel, &openSecureChannelRequest, &openScResponse);
@@ -354,24 +421,39 @@ processOPN(UA_Server *server, UA_SecureChannel *channel,
         return openScResponse.responseHeader.serviceResult;
     }
 
+    /* The asymmetric signing and encryption of the response is expensive. For
+     * new channels on a network EventLoop it is done under the shared side of
+     * the service lock. So the network EventLoops handle a surge of new
+     * connections in parallel. The exclusive holders (timeouts, purging,
+     * certificate updates) are kept out. The channel can be shut down before
+     * the shared side is taken. Then sending fails. It is not deleted, as this
+     * happens only in the connection callback on the current thread. Renewals
+     * keep the exclusive side, as notifications might be sent on the channel
+     * at the same time. */
+    UA_Boolean shared = false;
+    if(!renew)
+        shared = lockSharedForCrypto(server, channel);
+
     /* Send the response */
     retval = UA_SecureChannel_sendAsymmetricOPNMessage(channel, requestId, &openScResponse,
                                                        &UA_TYPES[UA_TYPES_OPENSECURECHANNELRESPONSE]);
     UA_OpenSecureChannelResponse_clear(&openScResponse);
+    unlockSharedForCrypto(server, shared);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "Could not send the OPN answer with error code %s",
                                UA_StatusCode_name(retval));
         UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_REJECT);
     }
-
     return retval;
 }
 
-/* The responseHeader must have the requestHandle already set */
-UA_StatusCode
-sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
-             UA_Response *response, const UA_DataType *responseType) {
+/* The responseHeader must have the requestHandle already set. The size of the
+ * encoded message body is returned in encodedSize (if not NULL). */
+static UA_StatusCode
+encodeSendResponse(UA_Server *server, UA_SecureChannel *channel,
+                   UA_UInt32 requestId, UA_Response *response,
+                   const UA_DataType *responseType, size_t *encodedSize) {
     if(!channel)
         return UA_STATUSCODE_BADINTERNALERROR;
 
@@ -382,8 +464,7 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
                                 response->responseHeader.serviceResult);
 
     /* Prepare the ResponseHeader */
-    UA_EventLoop *el = server->config.eventLoop;
-    response->responseHeader.timestamp = el->dateTime_now(el);
+    response->responseHeader.timestamp = getCachedTime(server);
 
     /* Start the message context */
     UA_MessageContext mc;
@@ -407,7 +488,148 @@ sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
         return retval;
 
     /* Finish / send out */
-    return UA_MessageContext_finish(&mc);
+    retval = UA_MessageContext_finish(&mc);
+    if(encodedSize && retval == UA_STATUSCODE_GOOD)
+        *encodedSize = mc.messageSizeSoFar;
+    return retval;
+}
+
+UA_StatusCode
+sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
+             UA_Response *response, const UA_DataType *responseType) {
+    return encodeSendResponse(server, channel, requestId, response,
+                              responseType, NULL);
+}
+
+UA_StatusCode
+sendSessionResponse(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                    UA_Response *response, const UA_DataType *responseType) {
+    size_t encodedSize = 0;
+    UA_StatusCode res = encodeSendResponse(server, session->channel, requestId,
+                                           response, responseType, &encodedSize);
+    UA_atomic_addUInt64(&session->usage.bytesEncoded, encodedSize);
+    return res;
+}
+
+void
+UA_ResponseStream_init(UA_ResponseStream *rs, UA_SecureChannel *channel,
+                       UA_UInt32 requestId, const UA_DataType *responseType) {
+    memset(rs, 0, sizeof(UA_ResponseStream));
+    rs->channel = channel;
+    rs->requestId = requestId;
+    rs->responseType = responseType;
+}
+
+/* Before the first chunk was sent, the stream is reset so that a ServiceFault
+ * can be sent instead. Otherwise the message is aborted. */
+static UA_StatusCode
+streamError(UA_ResponseStream *rs, UA_StatusCode res) {
+    rs->status = res;
+    if(rs->mc.chunksSent == 0) {
+        UA_MessageContext_abort(&rs->mc);
+        rs->started = false;
+        return res;
+    }
+    UA_LOG_DEBUG_CHANNEL(rs->channel->securityPolicy->logger, rs->channel,
+                         "Abort the streamed response with StatusCode %s",
+                         UA_StatusCode_name(res));
+    UA_MessageContext_sendAbort(&rs->mc, res);
+    return res;
+}
+
+UA_StatusCode
+UA_ResponseStream_begin(UA_Server *server, UA_ResponseStream *rs,
+                        UA_ResponseHeader *rh, size_t resultsSize) {
+    UA_assert(!rs->started);
+    UA_assert(rs->responseType->membersSize == 3 &&
+              rs->responseType->members[1].isArray);
+    if(!rs->channel || resultsSize > UA_INT32_MAX)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    rh->timestamp = getCachedTime(server);
+
+    UA_StatusCode res = UA_MessageContext_begin(&rs->mc, rs->channel, rs->requestId,
+                                                UA_MESSAGETYPE_MSG);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    rs->started = true;
+    rs->resultsSize = resultsSize;
+    rs->resultsDone = 0;
+    rs->status = UA_STATUSCODE_GOOD;
+
+    /* Encode the response type, the header and the length of the results */
+    UA_Int32 size = (UA_Int32)resultsSize;
+    res = UA_MessageContext_encode(&rs->mc, &rs->responseType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_encode(&rs->mc, rh, &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_encode(&rs->mc, &size, &UA_TYPES[UA_TYPES_INT32]);
+    if(res != UA_STATUSCODE_GOOD)
+        return streamError(rs, res);
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ResponseStream_emit(UA_ResponseStream *rs, const void *result) {
+    if(rs->status != UA_STATUSCODE_GOOD)
+        return rs->status;
+    UA_assert(rs->started && rs->resultsDone < rs->resultsSize);
+    UA_StatusCode res =
+        UA_MessageContext_encode(&rs->mc, result,
+                                 rs->responseType->members[1].memberType);
+    if(res != UA_STATUSCODE_GOOD)
+        return streamError(rs, res);
+    rs->resultsDone++;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ResponseStream_finish(UA_ResponseStream *rs) {
+    if(rs->status != UA_STATUSCODE_GOOD)
+        return rs->status;
+    UA_assert(rs->started && rs->resultsDone == rs->resultsSize);
+
+    /* No DiagnosticInfos */
+    UA_Int32 diagnosticInfosSize = -1;
+    UA_StatusCode res =
+        UA_MessageContext_encode(&rs->mc, &diagnosticInfosSize, &UA_TYPES[UA_TYPES_INT32]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_finish(&rs->mc);
+    if(res != UA_STATUSCODE_GOOD)
+        return streamError(rs, res);
+    rs->encodedSize = rs->mc.messageSizeSoFar;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_ResponseStream_sendEncoded(UA_Server *server, UA_ResponseStream *rs,
+                              UA_ResponseHeader *rh, const UA_ByteString *body) {
+    UA_assert(!rs->started);
+    if(!rs->channel)
+        return UA_STATUSCODE_BADINTERNALERROR;
+
+    rh->timestamp = getCachedTime(server);
+
+    UA_StatusCode res = UA_MessageContext_begin(&rs->mc, rs->channel, rs->requestId,
+                                                UA_MESSAGETYPE_MSG);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    rs->started = true;
+    rs->status = UA_STATUSCODE_GOOD;
+
+    res = UA_MessageContext_encode(&rs->mc, &rs->responseType->binaryEncodingId,
+                                   &UA_TYPES[UA_TYPES_NODEID]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_encode(&rs->mc, rh, &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_encodeRaw(&rs->mc, body);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_MessageContext_finish(&rs->mc);
+    if(res != UA_STATUSCODE_GOOD)
+        return streamError(rs, res);
+    rs->encodedSize = rs->mc.messageSizeSoFar;
+    return UA_STATUSCODE_GOOD;
 }
 
 /* A Session is "bound" to a SecureChannel if it was created by the
@@ -425,9 +647,11 @@ getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
         if(!UA_NodeId_equal(token, &s->authenticationToken))
             continue;
 
-        /* Has the session timed out? */
+        /* Has the session timed out? Can be reached under the shared side
+         * of the service lock (the timeout was not yet reached in
+         * lockService). */
         if(s->validTill < nowMonotonic) {
-            server->serverDiagnosticsSummary.rejectedSessionCount++;
+            UA_atomic_addUInt32(&server->serverDiagnosticsSummary.rejectedSessionCount, 1);
             return UA_STATUSCODE_BADSESSIONCLOSED;
         }
 
@@ -448,15 +672,151 @@ getBoundSession(UA_Server *server, const UA_SecureChannel *channel,
     return UA_STATUSCODE_BADSESSIONIDINVALID;
 }
 
+#if UA_MULTITHREADING >= 100
+
+/* Without side effects, so that it can be checked under the shared lock */
+static UA_Boolean
+hasActivatedSession(UA_Server *server, const UA_SecureChannel *channel,
+                    const UA_NodeId *token) {
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    for(UA_Session *s = channel->sessions; s; s = s->next) {
+        if(UA_NodeId_equal(token, &s->authenticationToken))
+            return (s->activated && s->validTill >= nowMonotonic);
+    }
+    return false;
+}
+
+#endif
+
+static void
+updateMaximum(volatile UA_UInt64 *max, UA_UInt64 value) {
+    UA_UInt64 old = *max;
+    while(old < value) {
+        UA_UInt64 found = UA_atomic_cmpxchgUInt64(max, old, value);
+        if(found == old)
+            break;
+        old = found;
+    }
+}
+
+/* Requests are decoded and processed concurrently from several threads. So
+ * the histograms are updated with atomic operations. */
+static void
+recordLatency(UA_LatencyHistogram *h, UA_DateTime duration) {
+    UA_UInt64 d = (duration > 0) ? (UA_UInt64)duration : 0;
+    size_t bucket = 0;
+    while(bucket < UA_LATENCYHISTOGRAM_BUCKETS - 1 && (d >> (bucket + 1)) > 0)
+        bucket++;
+    UA_atomic_addUInt64(&h->buckets[bucket], 1);
+    UA_atomic_addUInt64(&h->count, 1);
+    UA_atomic_addUInt64(&h->sum, d);
+    updateMaximum(&h->max, d);
+}
+
+/* Read-only services for an activated Session take the shared side of the
+ * service lock if the Nodestore supports concurrent reads. Everything else
+ * (including the error handling for missing and inactive Sessions) takes the
+ * exclusive side. Returns whether the lock is held shared. */
+static UA_Boolean
+lockService(UA_Server *server, const UA_SecureChannel *channel,
+            const UA_ServiceDescription *sd, const UA_RequestHeader *rh,
+            UA_DateTime *lockedSince) {
+#if UA_MULTITHREADING >= 100
+    UA_EventLoop *el = server->config.eventLoop;
+    if(sd->shared && server->config.nodestore.concurrentReads) {
+        UA_LOCK_SHARED(&server->serviceMutex);
+        UA_Boolean canShare =
+            hasActivatedSession(server, channel, &rh->authenticationToken);
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+        /* Browsing adds the pending PubSub nodes to the Nodestore */
+        if(server->pubSubManager.pendingRepresentations > 0)
+            canShare = false;
+#endif
+        if(canShare) {
+            *lockedSince = el->dateTime_nowMonotonic(el);
+            return true;
+        }
+        UA_UNLOCK_SHARED(&server->serviceMutex);
+    }
+    UA_LOCK(&server->serviceMutex);
+    *lockedSince = el->dateTime_nowMonotonic(el);
+#else
+    (void)server;
+    (void)channel;
+    (void)sd;
+    (void)rh;
+    (void)lockedSince;
+#endif
+    return false;
+}
+
+static void
+unlockService(UA_Server *server, UA_Boolean shared, UA_DateTime lockedSince) {
+#if UA_MULTITHREADING >= 100
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_UInt64 holdTime = (UA_UInt64)(el->dateTime_nowMonotonic(el) - lockedSince);
+    UA_ServiceLockStatistics *sls = &server->serviceLockStatistics;
+    if(shared) {
+        /* Concurrent with the other shared holders */
+        UA_atomic_addUInt64(&sls->sharedCount, 1);
+        UA_atomic_addUInt64(&sls->sharedHoldTime, holdTime);
+        updateMaximum(&sls->sharedMaxHoldTime, holdTime);
+        UA_UNLOCK_SHARED(&server->serviceMutex);
+        return;
+    }
+    sls->exclusiveCount++;
+    sls->exclusiveHoldTime += holdTime;
+    if(holdTime > sls->exclusiveMaxHoldTime)
+        sls->exclusiveMaxHoldTime = holdTime;
+    UA_UNLOCK(&server->serviceMutex);
+#else
+    (void)server;
+    (void)shared;
+    (void)lockedSince;
+#endif
+}
+
+/* CPU time of the current thread. Falls back to the monotonic clock if there is
+ * no per-thread CPU clock. */
+static UA_DateTime
+threadCpuTime(UA_Server *server) {
+#if defined(UA_ARCHITECTURE_POSIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+        return (ts.tv_sec * UA_DATETIME_SEC) + (ts.tv_nsec / 100);
+#endif
+    UA_EventLoop *el = server->config.eventLoop;
+    return el->dateTime_nowMonotonic(el);
+}
+
+/* Add the resource usage of the request to the Session */
+static void
+accountSessionUsage(UA_Server *server, UA_Session *session, UA_DateTime cpuStart,
+                    size_t decodedSize, size_t encodedSize) {
+    if(!session)
+        return;
+    if(server->config.sessionCpuTime) {
+        UA_DateTime cpu = threadCpuTime(server) - cpuStart;
+        if(cpu > 0)
+            UA_atomic_addUInt64(&session->usage.serviceCpuTime, (UA_UInt64)cpu);
+    }
+    UA_atomic_addUInt64(&session->usage.bytesDecoded, decodedSize);
+    UA_atomic_addUInt64(&session->usage.bytesEncoded, encodedSize);
+}
+
+/* Multi-chunk messages are decoded from the segments of the chunk payloads */
 static UA_StatusCode
 processMSG(UA_Server *server, UA_SecureChannel *channel,
-           UA_UInt32 requestId, const UA_ByteString *msg) {
+           UA_UInt32 requestId, const UA_ByteString *msg, size_t msgSegments) {
     if(channel->state != UA_SECURECHANNELSTATE_OPEN)
         return UA_STATUSCODE_BADINTERNALERROR;
     /* Decode the nodeid */
     size_t offset = 0;
     UA_NodeId requestTypeId;
-    UA_StatusCode retval = UA_NodeId_decodeBinary(msg, &offset, &requestTypeId);
+    UA_StatusCode retval =
+        UA_decodeBinaryInternalSegments(msg, msgSegments, &offset, &requestTypeId,
+                                        &UA_TYPES[UA_TYPES_NODEID], NULL);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     if(requestTypeId.namespaceIndex != 0 ||
@@ -476,52 +836,158 @@ processMSG(UA_Server *server, UA_SecureChannel *channel,
                                 "Unknown request with type identifier %" PRIi32,
                                 requestTypeId.identifier.numeric);
         }
-        return decodeHeaderSendServiceFault(server, channel, msg, offset,
-                                            &UA_TYPES[UA_TYPES_SERVICEFAULT],
-                                            requestId, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
+        UA_Boolean locked = lockNetworkEventLoop(server, channel->connectionManager);
+        retval = decodeHeaderSendServiceFault(server, channel, msg, msgSegments, offset,
+                                              &UA_TYPES[UA_TYPES_SERVICEFAULT], requestId,
+                                              UA_STATUSCODE_BADSERVICEUNSUPPORTED);
+        unlockNetworkEventLoop(server, locked);
+        return retval;
+    }
+
+    /* Start the CPU time measurement for the Session */
+    UA_DateTime cpuStart = 0;
+    if(server->config.sessionCpuTime)
+        cpuStart = threadCpuTime(server);
+
+    /* Start the timing for the service statistics */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_ServiceStatistics *stats = NULL;
+    UA_DateTime start = 0, now = 0;
+    if(server->serviceStatistics) {
+        stats = &server->serviceStatistics[sd - serviceDescriptions];
+        start = el->dateTime_nowMonotonic(el);
     }
 
     /* Decode the request */
+    UA_ALLOCPHASE_BEGIN(UA_ALLOCPHASE_DECODE);
     UA_Request request;
     size_t requestPos = offset; /* Store the offset (for sendServiceFault) */
-    retval = UA_decodeBinaryInternal(msg, &offset, &request,
-                                     sd->requestType, server->config.customDataTypes);
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.customTypes = server->config.customDataTypes;
+    /* The Write service copies the values into the nodes. The message buffer
+     * outlives the request. So large arrays need not be copied twice. */
+    opts.zeroCopy = (sd->requestType == &UA_TYPES[UA_TYPES_WRITEREQUEST]);
+    /* Read and Write neither keep nor modify parts of the request. Decode them
+     * into an arena that is released at once after processing. */
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    if(sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST] ||
+       sd->requestType == &UA_TYPES[UA_TYPES_WRITEREQUEST])
+        opts.arena = &arena;
+    retval = UA_decodeBinaryInternalSegments(msg, msgSegments, &offset, &request,
+                                             sd->requestType, &opts);
     if(retval != UA_STATUSCODE_GOOD) {
+        UA_Arena_clear(&arena);
         UA_LOG_DEBUG_CHANNEL(server->config.logging, channel,
                              "Could not decode the request with StatusCode %s",
                              UA_StatusCode_name(retval));
-        return decodeHeaderSendServiceFault(server, channel, msg, requestPos,
-                                            sd->responseType, requestId, retval);
+        UA_Boolean locked = lockNetworkEventLoop(server, channel->connectionManager);
+        retval = decodeHeaderSendServiceFault(server, channel, msg, msgSegments,
+                                              requestPos, sd->responseType,
+                                              requestId, retval);
+        unlockNetworkEventLoop(server, locked);
+        UA_ALLOCPHASE_END();
+        return retval;
+    }
+
+    if(stats) {
+        now = el->dateTime_nowMonotonic(el);
+        recordLatency(&stats->decodeTime, now - start);
+        start = now;
     }
 
     /* Initialize the response */
+    UA_ALLOCPHASE_SWITCH(UA_ALLOCPHASE_SERVICE);
     UA_Response response;
     UA_init(&response, sd->responseType);
     response.responseHeader.requestHandle = request.requestHeader.requestHandle;
 
-    /* Process the request */
-    UA_LOCK(&server->serviceMutex);
-    UA_Boolean async =
-        UA_Server_processRequest(server, channel, requestId, sd, &request, &response);
-    UA_UNLOCK(&server->serviceMutex);
-
-    /* Send response if not async */
-    if(UA_LIKELY(!async)) {
-        retval = sendResponse(server, channel, requestId, &response, sd->responseType);
+    /* Process the request. On a network EventLoop the lock is kept for sending
+     * the response. Notifications for the same SecureChannel are sent from the
+     * main EventLoop. */
+    UA_Boolean network = isNetworkEventLoop(server, channel->connectionManager);
+    UA_DateTime lockedSince = 0;
+    UA_Boolean shared =
+        lockService(server, channel, sd, &request.requestHeader, &lockedSince);
+    if(stats) {
+        now = el->dateTime_nowMonotonic(el);
+        recordLatency(&stats->lockWaitTime, now - start);
+        start = now;
+    }
+    UA_Session *session = NULL;
+    UA_ResponseStream stream;
+    UA_ResponseStream_init(&stream, channel, requestId, sd->responseType);
+    UA_Boolean async = UA_Server_processBulkRequest(server, channel, requestId, sd,
+                                                    &request, &response, &stream,
+                                                    &session);
+    if(stats) {
+        now = el->dateTime_nowMonotonic(el);
+        recordLatency(&stats->executionTime, now - start);
+        UA_atomic_addUInt64(&stats->requestCount, 1);
+        if(!async && response.responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+            UA_atomic_addUInt64(&stats->faultCount, 1);
+    }
+    if(!network)
+        unlockService(server, shared, lockedSince);
+
+    /* Send response if not async or already streamed */
+    size_t encodedSize = 0;
+    if(stream.started) {
+        retval = stream.status;
+        encodedSize = stream.encodedSize;
+    } else if(UA_LIKELY(!async)) {
+        if(stats)
+            start = el->dateTime_nowMonotonic(el);
+        UA_ALLOCPHASE_SWITCH(UA_ALLOCPHASE_ENCODE);
+        retval = encodeSendResponse(server, channel, requestId, &response,
+                                    sd->responseType, &encodedSize);
+        if(stats)
+            recordLatency(&stats->sendTime, el->dateTime_nowMonotonic(el) - start);
     }
 
+    /* Sessions are removed in a delayed callback of the main EventLoop. So the
+     * Session is still valid if the lock was released before sending (only on
+     * the main EventLoop). */
+    size_t msgLength = 0;
+    for(size_t i = 0; i < msgSegments; i++)
+        msgLength += msg[i].length;
+    accountSessionUsage(server, session, cpuStart, msgLength, encodedSize);
+    if(network)
+        unlockService(server, shared, lockedSince);
+
     /* Clean up */
-    UA_clear(&request, sd->requestType);
+    if(opts.arena)
+        UA_Arena_clear(&arena);
+    else
+        UA_clear(&request, sd->requestType);
     UA_clear(&response, sd->responseType);
+    UA_ALLOCPHASE_END();
     return retval;
 }
 
+/* Add the chunks received by processBuffer to the server statistics. The
+ * channel counter is reset when the channel is closed. */
+static void
+addChunkCount(UA_Server *server, const UA_SecureChannel *channel, size_t before) {
+    if(channel->receivedChunkCount > before)
+        UA_atomic_addUInt64(&server->counterStatistics.chunkCount,
+                            (UA_UInt64)(channel->receivedChunkCount - before));
+}
+
 /* Takes decoded messages starting at the nodeid of the content type. */
 static UA_StatusCode
 processSecureChannelMessage(void *application, UA_SecureChannel *channel,
                             UA_MessageType messagetype, UA_UInt32 requestId,
-                            UA_ByteString *message) {
+                            UA_ByteString *message, size_t messageSegments) {
     UA_Server *server = (UA_Server*)application;
+    UA_atomic_addUInt64(&server->counterStatistics.messageCount, 1);
+
+    /* MSG takes the lock only for the processing after decoding. OPN switches
+     * to the shared side for the asymmetric crypto of new channels. */
+    UA_Boolean locked = false;
+    if(messagetype != UA_MESSAGETYPE_MSG)
+        locked = lockNetworkEventLoop(server, channel->connectionManager);
 
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     switch(messagetype) {
@@ -535,7 +1001,7 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         break;
     case UA_MESSAGETYPE_MSG:
         UA_LOG_TRACE_CHANNEL(server->config.logging, channel, "Process a MSG");
-        retval = processMSG(server, channel, requestId, message);
+        retval = processMSG(server, channel, requestId, message, messageSegments);
         break;
     case UA_MESSAGETYPE_CLO:
         UA_LOG_TRACE_CHANNEL(server->config.logging, channel, "Process a CLO");
@@ -547,10 +1013,13 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         break;
     }
     if(retval != UA_STATUSCODE_GOOD) {
+        if(!locked)
+            locked = lockNetworkEventLoop(server, channel->connectionManager);
         if(!UA_SecureChannel_isConnected(channel)) {
             UA_LOG_INFO_CHANNEL(server->config.logging, channel,
                                 "Processing the message failed. Channel already closed "
                                 "with StatusCode %s. ", UA_StatusCode_name(retval));
+            unlockNetworkEventLoop(server, locked);
             return retval;
         }
 
@@ -578,6 +1047,7 @@ processSecureChannelMessage(void *application, UA_SecureChannel *channel,
         UA_SecureChannel_shutdown(channel, reason);
     }
 
+    unlockNetworkEventLoop(server, locked);
     return retval;
 }
 
@@ -634,6 +1104,30 @@ configServerSecureChannel(void *application, UA_SecureChannel *channel,
     return UA_SecureChannel_setSecurityPolicy(channel, securityPolicy, &appInstCert);
 }
 
+/* Take a token from the bucket for a new connection. The bucket is refilled
+ * with maxNewSecureChannelsPerSecond tokens per second and holds at most that
+ * many tokens. */
+static UA_Boolean
+admitNewConnection(UA_BinaryProtocolManager *bpm) {
+    UA_ServerConfig *config = &bpm->server->config;
+    UA_Double rate = (UA_Double)config->maxNewSecureChannelsPerSecond;
+    if(rate == 0.0)
+        return true;
+
+    UA_EventLoop *el = config->eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    bpm->channelTokens += rate * (UA_Double)(now - bpm->channelTokensUpdate) /
+        (UA_Double)UA_DATETIME_SEC;
+    if(bpm->channelTokens > rate)
+        bpm->channelTokens = rate;
+    bpm->channelTokensUpdate = now;
+
+    if(bpm->channelTokens < 1.0)
+        return false;
+    bpm->channelTokens -= 1.0;
+    return true;
+}
+
 static UA_StatusCode
 createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *cm,
                           uintptr_t connectionId, UA_SecureChannel **outChannel) {
@@ -648,7 +1142,8 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Allocate memory for the SecureChannel */
-    channel_entry *entry = (channel_entry *)UA_calloc(1, sizeof(channel_entry));
+    channel_entry *entry = (channel_entry *)
+        UA_POOL_ALLOC(&bpm->channelPool, sizeof(channel_entry));
     if(!entry)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -673,6 +1168,12 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     entry->channel.certificateVerification = &config->secureChannelPKI;
     entry->channel.processOPNHeader = configServerSecureChannel;
     entry->channel.connectionManager = cm;
+#if UA_MULTITHREADING >= 100
+    /* Unpack the OPN chunks (certificate verification and asymmetric
+     * decryption) in parallel on the network EventLoops */
+    if(isNetworkEventLoop(server, cm))
+        entry->channel.opnLock = &server->serviceMutex;
+#endif
     entry->channel.connectionId = connectionId;
 
     /* Set the SecureChannel identifier already here. So we get the right
@@ -701,14 +1202,12 @@ createServerSecureChannel(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *c
     return UA_STATUSCODE_GOOD;
 }
 
-/* Callback of a TCP socket (server socket or an active connection) */
-void
-serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
-                      void *application, void **connectionContext,
-                      UA_ConnectionState state,
-                      const UA_KeyValueMap *params,
-                      UA_ByteString msg) {
-    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+/* Handle the connection state changes of a TCP socket. Returns the
+ * SecureChannel if a received message remains to be processed. */
+static UA_SecureChannel *
+serverConnectionState(UA_BinaryProtocolManager *bpm, UA_ConnectionManager *cm,
+                      uintptr_t connectionId, void **connectionContext,
+                      UA_ConnectionState state) {
 
     /* A server socket that is not yet registered in the server. Register it and
      * set the connection context to the pointer in the
@@ -719,14 +1218,14 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         /* The socket is closing without being previously registered -> ignore */
         if(state == UA_CONNECTIONSTATE_CLOSED ||
            state == UA_CONNECTIONSTATE_CLOSING)
-            return;
+            return NULL;
 
         /* Cannot register */
         if(bpm->serverConnectionsSize >= UA_MAXSERVERCONNECTIONS) {
             UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
                            "Cannot register server socket - too many already open");
             cm->closeConnection(cm, connectionId);
-            return;
+            return NULL;
         }
 
         /* Find and use a free connection slot */
@@ -738,7 +1237,7 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         sc->connectionId = connectionId;
         sc->connectionManager = cm;
         *connectionContext = (void*)sc; /* Set the context pointer in the connection */
-        return;
+        return NULL;
     }
 
     UA_ServerConnection *sc = (UA_ServerConnection*)*connectionContext;
@@ -768,33 +1267,62 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
            setBinaryProtocolManagerState(bpm->server, bpm,
                                          UA_LIFECYCLESTATE_STOPPED);
         }
-        return;
+        return NULL;
     }
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
     if(serverSocket) {
+        /* Throttle new connections during a connect storm */
+        if(!admitNewConnection(bpm)) {
+            UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
+                           "TCP %lu\t| Connection rejected, too many new "
+                           "connections per second", (unsigned long)connectionId);
+            bpm->server->secureChannelStatistics.rejectedChannelCount++;
+            *connectionContext = NULL;
+            cm->closeConnection(cm, connectionId);
+            return NULL;
+        }
+
         /* A new connection is opening. This is the only place where
          * createSecureChannel is used. */
-        retval = createServerSecureChannel(bpm, cm, connectionId, &channel);
+        UA_StatusCode retval =
+            createServerSecureChannel(bpm, cm, connectionId, &channel);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING(bpm->logging, UA_LOGCATEGORY_SERVER,
                            "TCP %lu\t| Could not accept the connection with status %s",
                            (unsigned long)sc->connectionId, UA_StatusCode_name(retval));
             *connectionContext = NULL;
             cm->closeConnection(cm, connectionId);
-            return;
+            return NULL;
         }
 
         UA_LOG_INFO_CHANNEL(bpm->logging, channel, "SecureChannel created");
 
         /* Set the new channel as the new context for the connection */
         *connectionContext = (void*)channel;
-        return;
+        return NULL;
     }
 
     /* The connection has fully opened */
     if(channel->state < UA_SECURECHANNELSTATE_CONNECTED)
         channel->state = UA_SECURECHANNELSTATE_CONNECTED;
+    return channel;
+}
+
+/* Callback of a TCP socket (server socket or an active connection) */
+void
+serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                      void *application, void **connectionContext,
+                      UA_ConnectionState state,
+                      const UA_KeyValueMap *params,
+                      UA_ByteString msg) {
+    UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)application;
+
+    UA_Boolean locked = lockNetworkEventLoop(bpm->server, cm);
+    UA_SecureChannel *channel =
+        serverConnectionState(bpm, cm, connectionId, connectionContext, state);
+    unlockNetworkEventLoop(bpm->server, locked);
+    if(!channel)
+        return;
 
     /* Received a message on a normal connection */
 #ifdef UA_DEBUG_DUMP_PKGS
@@ -806,10 +1334,14 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
 
     UA_EventLoop *el = bpm->server->config.eventLoop;
     UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-    retval = UA_SecureChannel_processBuffer(channel, bpm->server,
-                                            processSecureChannelMessage,
-                                            &msg, nowMonotonic);
+    size_t chunks = channel->receivedChunkCount;
+    UA_StatusCode retval =
+        UA_SecureChannel_processBuffer(channel, bpm->server,
+                                       processSecureChannelMessage,
+                                       &msg, nowMonotonic);
+    addChunkCount(bpm->server, channel, chunks);
     if(retval != UA_STATUSCODE_GOOD) {
+        locked = lockNetworkEventLoop(bpm->server, cm);
         UA_LOG_WARNING_CHANNEL(bpm->logging, channel,
                                "Processing the message failed with error %s",
                                UA_StatusCode_name(retval));
@@ -820,11 +1352,13 @@ serverNetworkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         error.reason = UA_STRING_NULL;
         UA_SecureChannel_sendError(channel, &error);
         UA_SecureChannel_shutdown(channel, UA_SHUTDOWNREASON_ABORT);
+        unlockNetworkEventLoop(bpm->server, locked);
     }
 }
 
 static UA_StatusCode
-createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl) {
+createServerSocket(UA_BinaryProtocolManager *bpm, UA_EventLoop *el,
+                   const UA_String *serverUrl) {
     UA_Server *server = bpm->server;
     UA_ServerConfig *config = &server->config;
 
@@ -838,9 +1372,11 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
     if(res != UA_STATUSCODE_GOOD)
         return res;
 
+    /* The listen sockets of the network EventLoops share the port */
+    UA_Boolean networkLoop = (el != config->eventLoop);
+
     UA_String tcpString = UA_STRING("tcp");
-    for(UA_EventSource *es = config->eventLoop->eventSources;
-        es != NULL; es = es->next) {
+    for(UA_EventSource *es = el->eventSources; es != NULL; es = es->next) {
         /* Is this a usable connection manager? */
         if(es->eventSourceType != UA_EVENTSOURCETYPE_CONNECTIONMANAGER)
             continue;
@@ -859,7 +1395,7 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
         params[1].key = UA_QUALIFIEDNAME(0, "listen");
         UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
 
-        UA_Boolean reuseaddr = config->tcpReuseAddr;
+        UA_Boolean reuseaddr = config->tcpReuseAddr || networkLoop;
         params[2].key = UA_QUALIFIEDNAME(0, "reuse");
         UA_Variant_setScalar(&params[2].value, &reuseaddr, &UA_TYPES[UA_TYPES_BOOLEAN]);
 
@@ -912,8 +1448,15 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
         paramsMap.map = params;
         paramsMap.mapSize = paramsSize;
 
-        /* Open the server connection */
+        /* Open the server connection. The network EventLoop announces the
+         * listen socket in a callback that takes the server lock. */
+        if(networkLoop) {
+            UA_UNLOCK(&server->serviceMutex);
+        }
         res = cm->openConnection(cm, &paramsMap, bpm, NULL, serverNetworkCallback);
+        if(networkLoop) {
+            UA_LOCK(&server->serviceMutex);
+        }
         if(res == UA_STATUSCODE_GOOD)
             return res;
     }
@@ -921,6 +1464,24 @@ createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl
     return UA_STATUSCODE_BADINTERNALERROR;
 }
 
+static UA_StatusCode
+createServerConnection(UA_BinaryProtocolManager *bpm, const UA_String *serverUrl) {
+#if UA_MULTITHREADING >= 100
+    /* Listen on every network EventLoop instead of the main EventLoop */
+    UA_ServerConfig *config = &bpm->server->config;
+    if(config->networkEventLoopsSize > 0) {
+        UA_StatusCode res = UA_STATUSCODE_GOOD;
+        for(size_t i = 0; i < config->networkEventLoopsSize; i++) {
+            res = createServerSocket(bpm, config->networkEventLoops[i], serverUrl);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+        }
+        return res;
+    }
+#endif
+    return createServerSocket(bpm, bpm->server->config.eventLoop, serverUrl);
+}
+
 /* Remove timed out SecureChannels */
 static void
 secureChannelHouseKeeping(UA_Server *server, void *context) {
@@ -1113,6 +1674,16 @@ UA_Server_addReverseConnect(UA_Server *server, UA_String url,
         return UA_STATUSCODE_BADINTERNALERROR;
     }
 
+#if UA_MULTITHREADING >= 100
+    /* Reverse connections run on the main EventLoop without the server lock */
+    if(config->networkEventLoopsSize > 0) {
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "Reverse connections are not supported "
+                     "with network EventLoops");
+        return UA_STATUSCODE_BADNOTSUPPORTED;
+    }
+#endif
+
     /* Parse the reverse connect URL */
     UA_String hostname = UA_STRING_NULL;
     UA_UInt16 port = 0;
@@ -1291,9 +1862,11 @@ serverReverseConnectCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
      * Process the received buffer */
     UA_EventLoop *el = bpm->server->config.eventLoop;
     UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    size_t chunks = context->channel->receivedChunkCount;
     retval = UA_SecureChannel_processBuffer(context->channel, bpm->server,
                                             processSecureChannelMessage,
                                             &msg, nowMonotonic);
+    addChunkCount(bpm->server, context->channel, chunks);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_CHANNEL(bpm->logging, context->channel,
                                "Processing the message failed with error %s",
@@ -1324,8 +1897,21 @@ UA_BinaryProtocolManager_start(UA_Server *server,
                                UA_ServerComponent *sc) {
     UA_BinaryProtocolManager *bpm = (UA_BinaryProtocolManager*)sc;
     UA_ServerConfig *config = &server->config;
-    
-    UA_StatusCode retVal =
+
+    /* Start with a full bucket for the new connections */
+    UA_EventLoop *el = config->eventLoop;
+    bpm->channelTokens = (UA_Double)config->maxNewSecureChannelsPerSecond;
+    bpm->channelTokensUpdate = el->dateTime_nowMonotonic(el);
+
+    UA_StatusCode retVal;
+#ifdef UA_ENABLE_STATIC_POOLS
+    retVal = UA_ObjectPool_init(&bpm->channelPool, sizeof(channel_entry),
+                                config->maxSecureChannels);
+    if(retVal != UA_STATUSCODE_GOOD)
+        return retVal;
+#endif
+
+    retVal =
         addRepeatedCallback(server, secureChannelHouseKeeping,
                             bpm, 1000.0, &bpm->houseKeepingCallbackId);
     if(retVal != UA_STATUSCODE_GOOD)
@@ -1451,6 +2037,9 @@ UA_BinaryProtocolManager_free(UA_Server *server,
     if(sc->state != UA_LIFECYCLESTATE_STOPPED)
         return UA_STATUSCODE_BADINTERNALERROR;
 
+#ifdef UA_ENABLE_STATIC_POOLS
+    UA_ObjectPool_clear(&((UA_BinaryProtocolManager*)sc)->channelPool);
+#endif
     UA_free(sc);
     return UA_STATUSCODE_GOOD;
 }
@@ -105,6 +105,8 @@ UA_ServerConfig_clean(UA_ServerConfig *config) {
     config->logging = NULL;
 
     /* Custom Data Types */
-    UA_cleanupDataTypeWithCustom(config->customDataTypes);
+    if(!config->externalCustomDataTypes)
+        UA_cleanupDataTypeWithCustom(config->customDataTypes);
     config->customDataTypes = NULL;
+    config->externalCustomDataTypes = false;
 }
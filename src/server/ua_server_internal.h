@@ -51,6 +51,11 @@ typedef struct {
         UA_Server_EventNotificationCallback eventCallback;
     } callback;
 
+    /* For DataChange-MonitoredItems only. The callback is called directly
+     * from the sampling (or the Write service) with the borrowed value. No
+     * Notifications are queued. */
+    UA_Boolean direct;
+
     /* For Event-MonitoredItems only. The value fields are overwritten before
      * each callback. They can contain stray pointers between callbacks. So
      * don't clean up the value fields. */
@@ -117,12 +122,191 @@ getServerComponentByName(UA_Server *server, UA_String name);
 /* Server Structure */
 /********************/
 
+#define UA_RANDOMPOOL_SIZE 1024
+
 typedef struct session_list_entry {
     UA_DelayedCallback cleanupCallback;
     LIST_ENTRY(session_list_entry) pointers;
+
+    /* Indexed by AuthenticationToken and SessionId. The timeout tree is ordered
+     * by the validTill of the Session when it was (re)inserted. The lifetime
+     * of a Session only ever increases. So the housekeeping reinserts the
+     * refreshed Sessions lazily instead of updating the tree for every
+     * request. */
+    ZIP_ENTRY(session_list_entry) tokenTreeEntry;
+    ZIP_ENTRY(session_list_entry) idTreeEntry;
+    ZIP_ENTRY(session_list_entry) timeoutTreeEntry;
+    UA_DateTime timeoutTreeKey;
+
     UA_Session session;
 } session_list_entry;
 
+typedef ZIP_HEAD(UA_SessionTokenTree, session_list_entry) UA_SessionTokenTree;
+typedef ZIP_HEAD(UA_SessionIdTree, session_list_entry) UA_SessionIdTree;
+typedef ZIP_HEAD(UA_SessionTimeoutTree, session_list_entry) UA_SessionTimeoutTree;
+
+/* Slot of the Browse cache. The BrowseDescription (and the locales of the
+ * Session for the DisplayName) are the key. */
+typedef struct {
+    UA_UInt32 generation;
+    UA_UInt32 hash;
+    UA_UInt32 localeHash;
+    UA_BrowseDescription bd;
+    size_t referencesSize;
+    UA_ReferenceDescription *references; /* NULL -> empty slot */
+} UA_BrowseCacheEntry;
+
+/* Slot of the TranslateBrowsePath cache. The result does not depend on the
+ * Session. */
+typedef struct {
+    UA_UInt32 generation;
+    UA_UInt32 hash;
+    UA_UInt32 nodeClassMask;
+    UA_BrowsePath path;
+    UA_BrowsePathResult result;
+    UA_Boolean used;
+} UA_TranslateCacheEntry;
+
+/* Slot of the GetEndpoints cache. The EndpointUrl and ProfileUris of the
+ * request are the key. The binary encoding of the endpoints array (with the
+ * array length) is the value. */
+typedef struct {
+    UA_UInt32 generation;
+    UA_UInt32 hash;
+    UA_String endpointUrl;
+    size_t profileUrisSize;
+    UA_String *profileUris;
+    UA_ByteString encoded; /* Empty -> empty slot */
+} UA_EndpointsCacheEntry;
+
+/* The supertypes of a type node (following HasSubtype references upwards).
+ * Computed the first time a subtype check starts at the type node. */
+typedef struct UA_TypeHierarchyEntry {
+    ZIP_ENTRY(UA_TypeHierarchyEntry) treeEntry;
+    UA_UInt32 hash;
+    UA_NodeId typeId;
+    size_t supertypesSize;
+    UA_ExpandedNodeId *supertypes;
+} UA_TypeHierarchyEntry;
+
+typedef ZIP_HEAD(UA_TypeHierarchyTree, UA_TypeHierarchyEntry) UA_TypeHierarchyTree;
+
+/* Cached value of a DataSource variable. The generation is increased when the
+ * cached value is invalidated. So a read that was started before is not put
+ * into the cache afterwards. */
+typedef struct UA_DataSourceCacheEntry {
+    ZIP_ENTRY(UA_DataSourceCacheEntry) treeEntry;
+    UA_UInt32 hash;
+    UA_NodeId nodeId;
+    UA_UInt32 generation;
+    UA_DateTime cacheTime; /* Monotonic time of the read. 0 -> empty */
+    UA_DataValue value;
+} UA_DataSourceCacheEntry;
+
+typedef ZIP_HEAD(UA_DataSourceCacheTree, UA_DataSourceCacheEntry)
+    UA_DataSourceCacheTree;
+
+struct UA_BulkRequest;
+typedef struct UA_BulkRequest UA_BulkRequest;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* The verbs of the ModelChangeStructureDataType */
+#define UA_MODELCHANGEVERB_NODEADDED        0x01
+#define UA_MODELCHANGEVERB_NODEDELETED      0x02
+#define UA_MODELCHANGEVERB_REFERENCEADDED   0x04
+#define UA_MODELCHANGEVERB_REFERENCEDELETED 0x08
+
+typedef struct {
+    UA_NodeId affected;
+    UA_NodeId affectedType;
+    UA_Byte verb;
+} UA_ModelChange;
+#endif
+
+/****************/
+/* Object Pools */
+/****************/
+
+/* With UA_ENABLE_STATIC_POOLS, SecureChannels, Sessions, Subscriptions,
+ * MonitoredItems and Notifications are taken from fixed-size pools. The pools
+ * are allocated during the server startup with the capacity from the server
+ * limits. Afterwards these objects use no heap memory. Every object has a
+ * header that points to its pool. So objects allocated before the startup, or
+ * for a limit of zero (unlimited), are taken from the heap and still freed
+ * with the same method. */
+
+#ifdef UA_ENABLE_STATIC_POOLS
+
+typedef union UA_PoolBlock {
+    struct UA_ObjectPool *pool; /* While the object is used. NULL for the heap. */
+    union UA_PoolBlock *next;   /* While the block is in the free list */
+    UA_UInt64 align64;
+    UA_Double alignDouble;
+} UA_PoolBlock;
+
+typedef struct UA_ObjectPool {
+    size_t objectSize;
+    size_t capacity; /* 0 -> allocate from the heap */
+    size_t used;
+    UA_Byte *memory;
+    UA_PoolBlock *freeList;
+#if UA_MULTITHREADING >= 100
+    UA_Lock lock; /* Objects are also freed in delayed callbacks */
+#endif
+} UA_ObjectPool;
+
+typedef struct {
+    UA_ObjectPool sessions;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    UA_ObjectPool subscriptions;
+    UA_ObjectPool monitoredItems; /* Sized for UA_LocalMonitoredItem */
+    UA_ObjectPool notifications;
+#endif
+} UA_ServerPools;
+
+/* Allocate the memory of the pool. Does nothing if the pool is already
+ * allocated. With a capacity of zero, the objects are allocated from the
+ * heap. */
+UA_StatusCode
+UA_ObjectPool_init(UA_ObjectPool *pool, size_t objectSize, size_t capacity);
+
+/* The memory is kept if objects are still in use */
+void
+UA_ObjectPool_clear(UA_ObjectPool *pool);
+
+/* Zeroed memory for an object of at most objectSize. Returns NULL if the pool
+ * is exhausted. */
+void *
+UA_ObjectPool_alloc(UA_ObjectPool *pool, size_t size);
+
+/* Return the object to its pool (or the heap) */
+void
+UA_ObjectPool_free(void *p);
+
+/* Dimension the pools from the server limits */
+UA_StatusCode
+UA_ServerPools_init(UA_Server *server);
+
+void
+UA_ServerPools_clear(UA_Server *server);
+
+# define UA_POOL_ALLOC(pool, size) UA_ObjectPool_alloc(pool, size)
+# define UA_POOL_FREE(p) UA_ObjectPool_free(p)
+# define UA_POOL_EXHAUSTED(limitStatus) (limitStatus)
+#else
+# define UA_POOL_ALLOC(pool, size) UA_calloc(1, size)
+# define UA_POOL_FREE(p) UA_free(p)
+# define UA_POOL_EXHAUSTED(limitStatus) UA_STATUSCODE_BADOUTOFMEMORY
+#endif
+
+/* UA_Server_browseRecursive expands large levels of the walk in parallel
+ * threads. The Nodestore has to allow concurrent readers for that. */
+#if UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES)
+#define UA_BROWSERECURSIVE_PARALLEL 1
+struct UA_BrowseWorkers;
+typedef struct UA_BrowseWorkers UA_BrowseWorkers;
+#endif
+
 struct UA_Server {
     /* Config */
     UA_ServerConfig config;
@@ -142,8 +326,27 @@ struct UA_Server {
     UA_AsyncManager asyncManager;
 #endif
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+    /* Threads for UA_Server_browseRecursive (config.browseRecursiveWorkers).
+     * Started on first use. */
+    UA_BrowseWorkers *browseWorkers;
+#endif
+
+    /* Bulk requests that are processed in slices in the background (see
+     * config.bulkRequestSliceSize). The queue has a lock of its own as the
+     * requests are added under the shared side of the service lock. */
+    TAILQ_HEAD(, UA_BulkRequest) bulkRequests;
+    UA_DelayedCallback bulkRequestsCallback;
+    UA_Boolean bulkRequestsCallbackRegistered;
+#if UA_MULTITHREADING >= 100
+    UA_Lock bulkRequestsLock;
+#endif
+
     /* Session Management */
     LIST_HEAD(session_list, session_list_entry) sessions;
+    UA_SessionTokenTree sessionsByToken;
+    UA_SessionIdTree sessionsById;
+    UA_SessionTimeoutTree sessionTimeouts;
     UA_UInt32 sessionCount;
     UA_UInt32 activeSessionCount;
 
@@ -155,10 +358,64 @@ struct UA_Server {
     size_t namespacesSize;
     UA_String *namespaces;
 
+    /* Direct-mapped cache for the lookup of namespace indices by their URI.
+     * The slot is selected by the hash of the URI. Entries are validated with
+     * a string comparison, so they cannot become stale. */
+#define UA_NAMESPACECACHE_SIZE 16
+    UA_UInt16 namespaceCache[UA_NAMESPACECACHE_SIZE];
+
     /* For bootstrapping, omit some consistency checks, creating a reference to
      * the parent and member instantiation */
     UA_Boolean bootstrapNS0;
 
+    /* Cached supertypes for the subtype checks in isNodeInTree */
+    UA_TypeHierarchyTree typeHierarchy;
+
+    /* Cached Browse and TranslateBrowsePath results. The entries from older
+     * generations are stale. */
+    UA_BrowseCacheEntry *browseCache;
+    size_t browseCacheSize;
+    UA_TranslateCacheEntry *translateCache;
+    size_t translateCacheSize;
+    UA_UInt32 browseCacheGeneration;
+#if UA_MULTITHREADING >= 100
+    /* Browse, BrowseNext and TranslateBrowsePathsToNodeIds can run on the
+     * shared side of the service lock. Then several threads look up and
+     * store entries in the type hierarchy and the Browse/Translate caches at
+     * the same time. The invalidation happens with the exclusive lock. */
+    UA_Lock viewCacheLock;
+#endif
+
+    /* Browse ContinuationPoints of all Sessions in the order of their last
+     * use. The least recently used are evicted if the memory limit is
+     * reached. */
+    TAILQ_HEAD(, ContinuationPoint) continuationPoints;
+    size_t continuationPointsMemory;
+#if UA_MULTITHREADING >= 100
+    /* Browse on the shared side of the service lock evicts the
+     * ContinuationPoints of other Sessions. The lock protects the server-wide
+     * list and the ContinuationPoint lists of all Sessions. */
+    UA_Lock continuationPointsLock;
+#endif
+
+    /* Cached GetEndpoints responses. Entries from older generations are
+     * stale. */
+    UA_EndpointsCacheEntry *endpointsCache;
+    size_t endpointsCacheSize;
+    UA_UInt32 endpointsCacheGeneration;
+
+    /* Cached values of DataSource variables. Entries are added and removed
+     * only with the exclusive service lock. The Read service runs on the
+     * shared side. So the cached values have a lock of their own. */
+    UA_DataSourceCacheTree dataSourceCache;
+    size_t dataSourceCacheSize;
+#if UA_MULTITHREADING >= 100
+    UA_Lock dataSourceCacheLock;
+#endif
+
+    /* Increased when a node is removed or replaced in the Nodestore */
+    UA_UInt32 nodestoreGeneration;
+
     /* Subscriptions */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The admin session is initialized with a special subscription. This
@@ -173,10 +430,30 @@ struct UA_Server {
                                                  * from a session. */
     UA_UInt32 lastSubscriptionId; /* To generate unique SubscriptionIds */
 
+    /* Cyclic MonitoredItems that sample the same value */
+    UA_SamplingGroupTree samplingGroups;
+
+    /* Subscriptions that publish with the same interval */
+    UA_PublishGroupTree publishGroups;
+
+    /* Incremented for every write of an EURange property. The percent
+     * deadbands of MonitoredItems are then recomputed. */
+    UA_UInt32 euRangeGeneration;
+
 # ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     LIST_HEAD(, UA_ConditionSource) conditionSources;
+    UA_ConditionSourceTree conditionSourceTree;
+    UA_ConditionTree conditionTree;
     UA_NodeId refreshEvents[2];
 # endif
+
+# ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Node and reference changes for the next GeneralModelChangeEvent */
+    UA_ModelChange *modelChanges;
+    size_t modelChangesSize;
+    size_t modelChangesCapacity;
+    UA_UInt64 modelChangeCallbackId; /* 0 -> no event scheduled */
+# endif
 #endif
 
     /* Publish/Subscribe */
@@ -191,8 +468,42 @@ struct UA_Server {
     /* Statistics */
     UA_SecureChannelStatistics secureChannelStatistics;
     UA_ServerDiagnosticsSummaryDataType serverDiagnosticsSummary;
+#if UA_MULTITHREADING >= 100
+    UA_ServiceLockStatistics serviceLockStatistics;
+#endif
+    UA_ServerCounterStatistics counterStatistics;
+    UA_ServiceStatistics *serviceStatistics; /* Indexed like the
+                                              * serviceDescriptions. NULL if
+                                              * disabled. */
+
+    /* Buffered random bytes for nonces, EventIds and authentication tokens.
+     * Refilled in blocks from the strongest SecurityPolicy. Protected by the
+     * service lock. */
+    UA_Byte randomPool[UA_RANDOMPOOL_SIZE];
+    size_t randomPoolPos; /* Consumed bytes. The pool is empty at
+                           * UA_RANDOMPOOL_SIZE. */
+
+#ifdef UA_ENABLE_STATIC_POOLS
+    UA_ServerPools pools;
+#endif
 };
 
+/* Set the phase for the allocation profiling of the current thread. BEGIN
+ * stores the previous phase that is restored with END. SWITCH changes the
+ * phase in between. Without UA_DEBUG_ALLOC_PROFILE the macros do nothing. */
+#ifdef UA_DEBUG_ALLOC_PROFILE
+UA_AllocPhase
+UA_AllocPhase_set(UA_AllocPhase phase);
+# define UA_ALLOCPHASE_BEGIN(phase) \
+    UA_AllocPhase allocPhasePrevious = UA_AllocPhase_set(phase)
+# define UA_ALLOCPHASE_SWITCH(phase) (void)UA_AllocPhase_set(phase)
+# define UA_ALLOCPHASE_END() (void)UA_AllocPhase_set(allocPhasePrevious)
+#else
+# define UA_ALLOCPHASE_BEGIN(phase)
+# define UA_ALLOCPHASE_SWITCH(phase)
+# define UA_ALLOCPHASE_END()
+#endif
+
 /***********************/
 /* References Handling */
 /***********************/
@@ -203,6 +514,13 @@ cmpRefTargetId(const void *a, const void *b);
 enum ZIP_CMP
 cmpRefTargetName(const void *a, const void *b);
 
+/* The array of reference targets is sorted by UA_NodePointer_order. Returns the
+ * position of the first target that is not smaller than the targetId. The found
+ * flag is set if the target at that position is equal to the targetId. */
+size_t
+refTargetArrayPos(const UA_NodeReferenceKind *rk, UA_NodePointer targetId,
+                  UA_Boolean *found);
+
 /* Static inline methods for tree handling */
 typedef ZIP_HEAD(UA_ReferenceIdTree, UA_ReferenceTargetTreeElem) UA_ReferenceIdTree;
 ZIP_FUNCTIONS(UA_ReferenceIdTree, UA_ReferenceTargetTreeElem, idTreeEntry,
@@ -227,6 +545,19 @@ UA_StatusCode
 sendServiceFault(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
                  UA_UInt32 requestHandle, UA_StatusCode statusCode);
 
+/* The asymmetric crypto for a SecureChannel on a network EventLoop (signing
+ * and verifying the CreateSession/ActivateSession signatures, decrypting the
+ * user tokens) runs under the shared side of the service lock. So the network
+ * EventLoops handle the crypto in parallel. Switches from the exclusive to the
+ * shared side and returns whether the lock was switched. The state protected
+ * by the exclusive side can change during the switch. */
+UA_Boolean
+lockSharedForCrypto(UA_Server *server, const UA_SecureChannel *channel);
+
+/* Take the exclusive side again if the lock was switched */
+void
+unlockSharedForCrypto(UA_Server *server, UA_Boolean shared);
+
 /* Gets the a pointer to the context of a security policy supported by the
  * server matched by the security policy uri. */
 UA_SecurityPolicy *
@@ -273,6 +604,68 @@ getSessionByToken(UA_Server *server, const UA_NodeId *token);
 UA_Session *
 getSessionById(UA_Server *server, const UA_NodeId *sessionId);
 
+/* Look up a cached AccessControl decision. Returns NULL if caching is disabled
+ * or nothing is cached. Then the current cache generation is written out. */
+UA_AccessCacheEntry *
+getCachedAccess(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+                UA_Byte decision, UA_UInt32 *generation);
+
+/* Returns the cache entry where the decision is stored. Returns NULL if
+ * caching is disabled or the cache was invalidated since the generation was
+ * taken (while the service lock was released). */
+UA_AccessCacheEntry *
+cacheAccess(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+            UA_Byte decision, UA_UInt32 generation);
+
+/* The Browse and TranslateBrowsePath results depend on the references,
+ * BrowseName and DisplayName of the nodes. Call this after they were
+ * changed. */
+static UA_INLINE void
+invalidateBrowseCache(UA_Server *server) {
+    server->browseCacheGeneration++;
+}
+
+void
+UA_BrowseCache_clear(UA_Server *server);
+
+/* Drop the cached value of a DataSource variable. Call this after the value
+ * was written or the DataSource was changed. */
+void
+invalidateDataSourceCache(UA_Server *server, const UA_NodeId *nodeId);
+
+/* Disable the value cache for the node (e.g. when the node is deleted) */
+void
+removeDataSourceCache(UA_Server *server, const UA_NodeId *nodeId);
+
+void
+UA_DataSourceCache_clear(UA_Server *server);
+
+/* Call after the endpoints, certificates or the ApplicationDescription were
+ * changed */
+static UA_INLINE void
+invalidateEndpointsCache(UA_Server *server) {
+    server->endpointsCacheGeneration++;
+}
+
+void
+UA_EndpointsCache_clear(UA_Server *server);
+
+/* Wallclock time cached by the EventLoop for the current iteration. Use for
+ * timestamps where a lag of up to one iteration is acceptable. Falls back to
+ * reading the clock if the EventLoop has no cache. */
+static UA_INLINE UA_DateTime
+getCachedTime(UA_Server *server) {
+    UA_EventLoop *el = server->config.eventLoop;
+    if(el->dateTime_nowCached)
+        return el->dateTime_nowCached(el);
+    return el->dateTime_now(el);
+}
+
+/* Drop cached AccessControl decisions. NULL matches all sessions / nodes. */
+void
+invalidateAccessCache(UA_Server *server, const UA_NodeId *sessionId,
+                      const UA_NodeId *nodeId);
+
 /*****************/
 /* Node Handling */
 /*****************/
@@ -287,12 +680,24 @@ UA_StatusCode UA_Server_editNode(UA_Server *server, UA_Session *session,
                                  UA_EditNodeCallback callback,
                                  void *data);
 
+/* Add the ReferenceTypeIndex of a new ReferenceType to the subtype sets of its
+ * supertypes */
+UA_StatusCode
+setReferenceTypeSubtypes(UA_Server *server, const UA_ReferenceTypeNode *node);
+
 /*********************/
 /* Utility Functions */
 /*********************/
 
 void setServerLifecycleState(UA_Server *server, UA_LifecycleState state);
 
+/* Take random bytes from the buffered pool of the server. The pool is refilled
+ * with the nonce generator of the SecurityPolicy with the highest
+ * securityLevel. So the output is cryptographically secure if an encrypting
+ * SecurityPolicy is configured. */
+UA_StatusCode
+getRandomBytes(UA_Server *server, UA_Byte *out, size_t len);
+
 void setupNs1Uri(UA_Server *server);
 UA_UInt16 addNamespace(UA_Server *server, const UA_String name);
 
@@ -309,6 +714,14 @@ UA_Boolean
 isNodeInTree_singleRef(UA_Server *server, const UA_NodeId *leafNode,
                        const UA_NodeId *nodeToFind, const UA_Byte relevantRefTypeIndex);
 
+/* Drop the cached supertypes of the type node and of all its subtypes. Called
+ * when the HasSubtype references of the node change. */
+void
+invalidateTypeHierarchy(UA_Server *server, const UA_NodeId *typeId);
+
+void
+UA_TypeHierarchy_clear(UA_Server *server);
+
 /* Returns an array with the hierarchy of nodes. The start nodes can be returned
  * as well. The returned array starts at the leaf and continues "upwards" or
  * "downwards". Duplicate entries are removed. */
@@ -318,6 +731,11 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
                 UA_UInt32 nodeClassMask, UA_Boolean includeStartNodes,
                 size_t *resultsSize, UA_ExpandedNodeId **results);
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+void
+UA_BrowseWorkers_delete(UA_BrowseWorkers *bw);
+#endif
+
 /* Get the bitfield indices of a ReferenceType and possibly its subtypes.
  * refType must point to a ReferenceTypeNode. */
 UA_StatusCode
@@ -343,6 +761,10 @@ UA_getConditionId(UA_Server *server, const UA_NodeId *conditionNodeId,
 void
 UA_ConditionList_delete(UA_Server *server);
 
+/* Add the next chunk of the pending ConditionRefreshes of the Subscription */
+void
+UA_Subscription_continueConditionRefresh(UA_Server *server, UA_Subscription *sub);
+
 UA_Boolean
 isConditionOrBranch(UA_Server *server,
                     const UA_NodeId *condition,
@@ -356,16 +778,40 @@ isConditionOrBranch(UA_Server *server,
 const UA_Node *
 getNodeType(UA_Server *server, const UA_NodeHead *nodeHead);
 
-/* Returns whether we send a response right away (async call or not) */
+/* Returns whether we send a response right away (async call or not). Also
+ * returns true if the response was sent by the stream. The Session (can be
+ * NULL) used for the request is returned in outSession. */
 UA_Boolean
 UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
                          UA_UInt32 requestId, UA_ServiceDescription *sd,
-                         const UA_Request *request, UA_Response *response);
+                         const UA_Request *request, UA_Response *response,
+                         UA_ResponseStream *stream, UA_Session **outSession);
+
+/* Same as UA_Server_processRequest. But bulk requests with more operations
+ * than config.bulkRequestSliceSize are processed in slices. Only the first
+ * slice is processed right away. Then the request and the response are moved
+ * into the queue (and reset) and true is returned. The response is sent once
+ * the last slice was processed. */
+UA_Boolean
+UA_Server_processBulkRequest(UA_Server *server, UA_SecureChannel *channel,
+                             UA_UInt32 requestId, UA_ServiceDescription *sd,
+                             UA_Request *request, UA_Response *response,
+                             UA_ResponseStream *stream, UA_Session **outSession);
+
+/* Drop the pending bulk requests without sending a response */
+void
+UA_Server_clearBulkRequests(UA_Server *server);
 
 UA_StatusCode
 sendResponse(UA_Server *server, UA_SecureChannel *channel, UA_UInt32 requestId,
              UA_Response *response, const UA_DataType *responseType);
 
+/* Same as sendResponse. The number of encoded bytes is added to the resource
+ * usage of the Session. */
+UA_StatusCode
+sendSessionResponse(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                    UA_Response *response, const UA_DataType *responseType);
+
 /* Many services come as an array of operations. This function generalizes the
  * processing of the operations. */
 typedef void (*UA_ServiceOperation)(UA_Server *server, UA_Session *session,
@@ -383,6 +829,20 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
                                    const UA_DataType *responseOperationsType)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Same as UA_Server_processServiceOperations. But every result is emitted into
+ * the response stream and cleaned up right away. If the returned StatusCode is
+ * not good and the stream has not started, it becomes the serviceResult. */
+UA_StatusCode
+UA_Server_streamServiceOperations(UA_Server *server, UA_Session *session,
+                                  UA_ResponseStream *stream,
+                                  UA_ResponseHeader *responseHeader,
+                                  UA_ServiceOperation operationCallback,
+                                  const void *context,
+                                  const size_t *requestOperations,
+                                  const UA_DataType *requestOperationsType,
+                                  const UA_DataType *responseOperationsType)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 /******************************************/
 /* Internal function calls, without locks */
 /******************************************/
@@ -467,6 +927,22 @@ readWithSession(UA_Server *server, UA_Session *session,
                 const UA_ReadValueId *item,
                 UA_TimestampsToReturn timestampsToReturn);
 
+UA_DataValue
+readWithSessionMaxAge(UA_Server *server, UA_Session *session,
+                      const UA_ReadValueId *item,
+                      UA_TimestampsToReturn timestampsToReturn,
+                      UA_Double maxAge);
+
+/* Set the server timestamp and remove the source timestamp as requested */
+void
+setReadTimestamps(UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+                  UA_DataValue *v);
+
+/* Returns the StatusCode for reading the Value attribute of the node with the
+ * AccessLevel and UserAccessLevel of the session */
+UA_StatusCode
+checkReadValueAccess(UA_Server *server, UA_Session *session, const UA_Node *node);
+
 UA_StatusCode
 readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
                   const UA_AttributeId attributeId, void *v);
@@ -497,12 +973,29 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
              const UA_NodeId origin, UA_ByteString *outEventId,
              const UA_Boolean deleteEventNode);
 
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *eventFields,
+                   UA_ByteString *outEventId);
+
+/* Record a change of the address space for the next GeneralModelChangeEvent.
+ * Does nothing if the server is not started or the modelChangeEventInterval
+ * is not set. The affectedType can be NULL. */
+void
+addModelChange(UA_Server *server, const UA_NodeId *affected,
+               const UA_NodeId *affectedType, UA_Byte verb);
+
+/* Drop the pending changes without emitting an event */
+void
+clearModelChanges(UA_Server *server);
+
 /* Filters the given event with the given filter and writes the results into a
- * notification */
+ * notification. The cache and the result can be NULL. */
 UA_StatusCode
 filterEvent(UA_Server *server, UA_Session *session,
             const UA_NodeId *eventNode, UA_EventFilter *filter,
-            UA_EventFieldList *efl, UA_EventFilterResult *result);
+            UA_EventCache *cache, UA_EventFieldList *efl,
+            UA_EventFilterResult *result);
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
 
@@ -560,32 +1053,26 @@ UA_BinaryProtocolManager_new(UA_Server *server);
 /* RefTree */
 /***********/
 
-/* A RefTree is a sorted set of NodeIds that ensures we consider each node just
- * once. It holds a single array for both the ExpandedNodeIds and the entries of
- * a tree-structure for fast lookup. A single realloc operation (with some
- * pointer repairing) can be used to increase the capacity of the RefTree.
+/* A RefTree is a set of NodeIds that ensures we consider each node just once.
+ * It holds a single array for both the ExpandedNodeIds and a hash index for
+ * fast lookup. A single realloc operation (and rebuilding the index from the
+ * stored hashes) can be used to increase the capacity of the RefTree.
  *
- * When the RefTree is complete, the tree-part at the end of the targets array
+ * When the RefTree is complete, the index-part at the end of the targets array
  * can be ignored / cut away to use it as a simple ExpandedNodeId array.
  *
- * The layout of the targets array is as follows:
+ * The layout of the targets array is as follows (n is the capacity):
+ *
+ * | Targets [ExpandedNodeId, n times] | Hashes [UInt32, n times] |
+ * | Slots [UInt32, 2n times] |
  *
- * | Targets [ExpandedNodeId, n times] | Tree [RefEntry, n times] | */
+ * The slots are an open-addressing table with linear probing. They contain the
+ * index of the target plus one. Zero marks an empty slot. */
 
 #define UA_REFTREE_INITIAL_SIZE 16
 
-typedef struct RefEntry {
-    ZIP_ENTRY(RefEntry) zipfields;
-    const UA_ExpandedNodeId *target;
-    UA_UInt32 targetHash; /* Hash of the target nodeid */
-} RefEntry;
-
-ZIP_HEAD(RefHead, RefEntry);
-typedef struct RefHead RefHead;
-
 typedef struct {
     UA_ExpandedNodeId *targets;
-    RefHead head;
     size_t capacity; /* available space */
     size_t size;     /* used space */
 } RefTree;
@@ -595,6 +1082,9 @@ RefTree_init(RefTree *rt);
 
 void RefTree_clear(RefTree *rt);
 
+/* Remove all entries but keep the capacity */
+void RefTree_reset(RefTree *rt);
+
 UA_StatusCode UA_FUNC_ATTR_WARN_UNUSED_RESULT
 RefTree_addNodeId(RefTree *rt, const UA_NodeId *target, UA_Boolean *duplicate);
 
@@ -616,6 +1106,13 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
              UA_TimestampsToReturn timestampsToReturn,
              const UA_ReadValueId *id, UA_DataValue *v);
 
+/* Same as ReadWithNode. The value of a DataSource variable with a cache is
+ * taken from the cache if it is not older than maxAge (in ms). */
+void
+ReadWithNodeMaxAge(const UA_Node *node, UA_Server *server, UA_Session *session,
+                   UA_TimestampsToReturn timestampsToReturn, UA_Double maxAge,
+                   const UA_ReadValueId *id, UA_DataValue *v);
+
 UA_StatusCode
 readValueAttribute(UA_Server *server, UA_Session *session,
                    const UA_VariableNode *vn, UA_DataValue *v);
@@ -799,6 +1296,17 @@ UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
     server->config.nodestore.getNodeFromPtr(server->config.nodestore.context,      \
                                             target, attrMask, refs, refDirs)
 
+/* Uses the cached pointer to the target node if the Nodestore supports that */
+static UA_INLINE const UA_Node *
+UA_NODESTORE_GETFROMTARGET_SELECTIVE(UA_Server *server, UA_ReferenceTarget *target,
+                                     UA_UInt32 attrMask, UA_ReferenceTypeSet refs,
+                                     UA_BrowseDirection refDirs) {
+    UA_Nodestore *ns = &server->config.nodestore;
+    if(ns->getNodeFromTarget)
+        return ns->getNodeFromTarget(ns->context, target, attrMask, refs, refDirs);
+    return ns->getNodeFromPtr(ns->context, target->targetId, attrMask, refs, refDirs);
+}
+
 #define UA_NODESTORE_RELEASE(server, node)                              \
     server->config.nodestore.releaseNode(server->config.nodestore.context, node)
 
@@ -810,11 +1318,16 @@ UA_NODESTORE_GETFROMREF(UA_Server *server, UA_NodePointer target) {
     server->config.nodestore.insertNode(server->config.nodestore.context, \
                                         node, addedNodeId)
 
+/* Removing and replacing nodes increases the nodestore generation. Node
+ * pointers held across requests (registered nodes) are used only while the
+ * generation is unchanged. */
 #define UA_NODESTORE_REPLACE(server, node)                              \
-    server->config.nodestore.replaceNode(server->config.nodestore.context, node)
+    ((server)->nodestoreGeneration++,                                   \
+     server->config.nodestore.replaceNode(server->config.nodestore.context, node))
 
 #define UA_NODESTORE_REMOVE(server, nodeId)                             \
-    server->config.nodestore.removeNode(server->config.nodestore.context, nodeId)
+    ((server)->nodestoreGeneration++,                                   \
+     server->config.nodestore.removeNode(server->config.nodestore.context, nodeId))
 
 #define UA_NODESTORE_GETREFERENCETYPEID(server, index)                  \
     server->config.nodestore.getReferenceTypeId(server->config.nodestore.context, \
@@ -839,6 +1352,11 @@ UA_StatusCode
 UA_Node_insertOrUpdateDescription(UA_NodeHead *head,
                                   const UA_LocalizedText *value);
 
+/* Replaces the BrowseName. Shares the string with other nodes if
+ * UA_ENABLE_NODE_STRING_INTERNING is set. */
+UA_StatusCode
+UA_Node_setBrowseName(UA_NodeHead *head, const UA_QualifiedName *browseName);
+
 _UA_END_DECLS
 
 #endif /* UA_SERVER_INTERNAL_H_ */
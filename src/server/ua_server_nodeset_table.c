@@ -0,0 +1,404 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *    Copyright 2024 (c) Fraunhofer IOSB (Author: Julius Pfrommer)
+ */
+
+#include "ua_server_internal.h"
+#include "ua_types_encoding_binary.h"
+
+/* Loads the constant nodeset tables generated by the open62541_tables backend
+ * of the nodeset compiler. See the documentation in server.h. */
+
+typedef struct {
+    UA_Server *server;
+    const UA_NodesetTable *table;
+    const UA_UInt16 *namespaces;
+    size_t namespacesSize;
+} TableLoader;
+
+static UA_StatusCode
+mapNamespace(const TableLoader *l, UA_UInt16 *nsIndex) {
+    if(*nsIndex >= l->namespacesSize)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    *nsIndex = l->namespaces[*nsIndex];
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The NodeId points to the string in the table. It is not cleared. */
+static UA_StatusCode
+getNodeId(const TableLoader *l, UA_UInt32 index, UA_NodeId *id) {
+    if(index >= l->table->nodeIdsSize)
+        return UA_STATUSCODE_BADDECODINGERROR;
+    const UA_NodesetTableNodeId *tid = &l->table->nodeIds[index];
+    UA_UInt16 nsIndex = tid->namespaceIndex;
+    UA_StatusCode res = mapNamespace(l, &nsIndex);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(tid->string)
+        *id = UA_NODEID_STRING(nsIndex, (char*)(uintptr_t)tid->string);
+    else
+        *id = UA_NODEID_NUMERIC(nsIndex, tid->numeric);
+    return UA_STATUSCODE_GOOD;
+}
+
+/**********/
+/* Values */
+/**********/
+
+static UA_StatusCode
+remapNamespaces(const TableLoader *l, void *p, const UA_DataType *type);
+
+static UA_StatusCode
+remapArray(const TableLoader *l, void *p, size_t size, const UA_DataType *type) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    uintptr_t ptr = (uintptr_t)p;
+    for(size_t i = 0; i < size && res == UA_STATUSCODE_GOOD; i++) {
+        res = remapNamespaces(l, (void*)ptr, type);
+        ptr += type->memSize;
+    }
+    return res;
+}
+
+static UA_StatusCode
+remapStructure(const TableLoader *l, void *p, const UA_DataType *type) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    uintptr_t ptr = (uintptr_t)p;
+    for(size_t i = 0; i < type->membersSize && res == UA_STATUSCODE_GOOD; i++) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        ptr += m->padding;
+        if(m->isArray) {
+            size_t size = *(size_t*)ptr;
+            ptr += sizeof(size_t);
+            res = remapArray(l, *(void**)ptr, size, mt);
+            ptr += sizeof(void*);
+        } else if(m->isOptional) {
+            if(*(void**)ptr)
+                res = remapNamespaces(l, *(void**)ptr, mt);
+            ptr += sizeof(void*);
+        } else {
+            res = remapNamespaces(l, (void*)ptr, mt);
+            ptr += mt->memSize;
+        }
+    }
+    return res;
+}
+
+static UA_StatusCode
+remapUnion(const TableLoader *l, void *p, const UA_DataType *type) {
+    UA_UInt32 selection = *(UA_UInt32*)p;
+    if(selection == 0 || selection > type->membersSize)
+        return UA_STATUSCODE_GOOD;
+    const UA_DataTypeMember *m = &type->members[selection-1];
+    uintptr_t ptr = (uintptr_t)p + m->padding;
+    if(m->isArray) {
+        size_t size = *(size_t*)ptr;
+        return remapArray(l, *(void**)(ptr + sizeof(size_t)), size, m->memberType);
+    }
+    return remapNamespaces(l, (void*)ptr, m->memberType);
+}
+
+/* Map the namespace indices of the table inside a decoded value */
+static UA_StatusCode
+remapNamespaces(const TableLoader *l, void *p, const UA_DataType *type) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_NODEID:
+        return mapNamespace(l, &((UA_NodeId*)p)->namespaceIndex);
+    case UA_DATATYPEKIND_EXPANDEDNODEID: {
+        UA_ExpandedNodeId *en = (UA_ExpandedNodeId*)p;
+        if(en->serverIndex != 0 || en->namespaceUri.length > 0)
+            return UA_STATUSCODE_GOOD;
+        return mapNamespace(l, &en->nodeId.namespaceIndex);
+    }
+    case UA_DATATYPEKIND_QUALIFIEDNAME:
+        return mapNamespace(l, &((UA_QualifiedName*)p)->namespaceIndex);
+    case UA_DATATYPEKIND_VARIANT: {
+        UA_Variant *v = (UA_Variant*)p;
+        if(!v->type)
+            return UA_STATUSCODE_GOOD;
+        if(UA_Variant_isScalar(v))
+            return remapNamespaces(l, v->data, v->type);
+        return remapArray(l, v->data, v->arrayLength, v->type);
+    }
+    case UA_DATATYPEKIND_EXTENSIONOBJECT: {
+        UA_ExtensionObject *eo = (UA_ExtensionObject*)p;
+        if(eo->encoding < UA_EXTENSIONOBJECT_DECODED)
+            return UA_STATUSCODE_GOOD;
+        return remapNamespaces(l, eo->content.decoded.data, eo->content.decoded.type);
+    }
+    case UA_DATATYPEKIND_DATAVALUE:
+        return remapNamespaces(l, &((UA_DataValue*)p)->value,
+                               &UA_TYPES[UA_TYPES_VARIANT]);
+    case UA_DATATYPEKIND_STRUCTURE:
+    case UA_DATATYPEKIND_OPTSTRUCT:
+        return remapStructure(l, p, type);
+    case UA_DATATYPEKIND_UNION:
+        return remapUnion(l, p, type);
+    default:
+        return UA_STATUSCODE_GOOD;
+    }
+}
+
+/* Decode the value of the table node into the (empty) variant */
+static UA_StatusCode
+decodeValue(const TableLoader *l, const UA_NodesetTableNode *tn, UA_Variant *v) {
+    const UA_DataType *type = tn->valueType;
+    size_t length = (tn->valueArrayLength < 0) ? 1 : (size_t)tn->valueArrayLength;
+    void *data = (tn->valueArrayLength < 0) ?
+        UA_new(type) : UA_Array_new(length, type);
+    if(!data)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_ByteString buf = {tn->valueSize, (UA_Byte*)(uintptr_t)tn->value};
+    size_t offset = 0;
+    const UA_DataTypeArray *customTypes = l->server->config.customDataTypes;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    uintptr_t ptr = (uintptr_t)data;
+    for(size_t i = 0; i < length && res == UA_STATUSCODE_GOOD; i++) {
+        res = UA_decodeBinaryInternal(&buf, &offset, (void*)ptr, type, customTypes);
+        ptr += type->memSize;
+    }
+    if(res == UA_STATUSCODE_GOOD && offset != buf.length)
+        res = UA_STATUSCODE_BADDECODINGERROR;
+    if(res == UA_STATUSCODE_GOOD)
+        res = remapArray(l, data, length, type);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_Array_delete(data, length, type);
+        return res;
+    }
+
+    if(tn->valueArrayLength < 0) {
+        UA_Variant_setScalar(v, data, type);
+    } else {
+        UA_Variant_setArray(v, data, length, type);
+        if(tn->flags & UA_NODESETTABLE_VALUEDIMENSIONS) {
+            v->arrayDimensionsSize = tn->arrayDimensionsSize;
+            v->arrayDimensions = (UA_UInt32*)(uintptr_t)tn->arrayDimensions;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/*********/
+/* Nodes */
+/*********/
+
+typedef union {
+    UA_NodeAttributes common;
+    UA_ObjectAttributes object;
+    UA_VariableAttributes variable;
+    UA_MethodAttributes method;
+    UA_ObjectTypeAttributes objectType;
+    UA_VariableTypeAttributes variableType;
+    UA_ReferenceTypeAttributes referenceType;
+    UA_DataTypeAttributes dataType;
+    UA_ViewAttributes view;
+} TableAttributes;
+
+/* The attributes point into the table. Only the decoded value is allocated. */
+static UA_StatusCode
+setAttributes(const TableLoader *l, const UA_NodesetTableNode *tn,
+              TableAttributes *attr, const UA_DataType **attrType) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_Variant *value = NULL;
+    switch(tn->nodeClass) {
+    case UA_NODECLASS_OBJECT:
+        attr->object = UA_ObjectAttributes_default;
+        attr->object.eventNotifier = tn->eventNotifier;
+        *attrType = &UA_TYPES[UA_TYPES_OBJECTATTRIBUTES];
+        break;
+    case UA_NODECLASS_VARIABLE:
+        attr->variable = UA_VariableAttributes_default;
+        attr->variable.historizing = (tn->flags & UA_NODESETTABLE_HISTORIZING) != 0;
+        attr->variable.minimumSamplingInterval = tn->minimumSamplingInterval;
+        attr->variable.userAccessLevel = tn->userAccessLevel;
+        attr->variable.accessLevel = tn->accessLevel;
+        attr->variable.valueRank = tn->valueRank;
+        attr->variable.arrayDimensionsSize = tn->arrayDimensionsSize;
+        attr->variable.arrayDimensions = (UA_UInt32*)(uintptr_t)tn->arrayDimensions;
+        res = getNodeId(l, tn->dataType, &attr->variable.dataType);
+        value = &attr->variable.value;
+        *attrType = &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES];
+        break;
+    case UA_NODECLASS_METHOD:
+        attr->method = UA_MethodAttributes_default;
+        attr->method.executable = (tn->flags & UA_NODESETTABLE_EXECUTABLE) != 0;
+        attr->method.userExecutable = (tn->flags & UA_NODESETTABLE_USEREXECUTABLE) != 0;
+        *attrType = &UA_TYPES[UA_TYPES_METHODATTRIBUTES];
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        attr->objectType = UA_ObjectTypeAttributes_default;
+        attr->objectType.isAbstract = (tn->flags & UA_NODESETTABLE_ISABSTRACT) != 0;
+        *attrType = &UA_TYPES[UA_TYPES_OBJECTTYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_VARIABLETYPE:
+        attr->variableType = UA_VariableTypeAttributes_default;
+        attr->variableType.isAbstract = (tn->flags & UA_NODESETTABLE_ISABSTRACT) != 0;
+        attr->variableType.valueRank = tn->valueRank;
+        attr->variableType.arrayDimensionsSize = tn->arrayDimensionsSize;
+        attr->variableType.arrayDimensions = (UA_UInt32*)(uintptr_t)tn->arrayDimensions;
+        res = getNodeId(l, tn->dataType, &attr->variableType.dataType);
+        value = &attr->variableType.value;
+        *attrType = &UA_TYPES[UA_TYPES_VARIABLETYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_REFERENCETYPE:
+        attr->referenceType = UA_ReferenceTypeAttributes_default;
+        attr->referenceType.isAbstract = (tn->flags & UA_NODESETTABLE_ISABSTRACT) != 0;
+        attr->referenceType.symmetric = (tn->flags & UA_NODESETTABLE_SYMMETRIC) != 0;
+        if(tn->inverseName)
+            attr->referenceType.inverseName = UA_LOCALIZEDTEXT("", tn->inverseName);
+        *attrType = &UA_TYPES[UA_TYPES_REFERENCETYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_DATATYPE:
+        attr->dataType = UA_DataTypeAttributes_default;
+        attr->dataType.isAbstract = (tn->flags & UA_NODESETTABLE_ISABSTRACT) != 0;
+        *attrType = &UA_TYPES[UA_TYPES_DATATYPEATTRIBUTES];
+        break;
+    case UA_NODECLASS_VIEW:
+        attr->view = UA_ViewAttributes_default;
+        attr->view.containsNoLoops = (tn->flags & UA_NODESETTABLE_CONTAINSNOLOOPS) != 0;
+        attr->view.eventNotifier = tn->eventNotifier;
+        *attrType = &UA_TYPES[UA_TYPES_VIEWATTRIBUTES];
+        break;
+    default:
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    }
+
+    /* The attribute structures share the common header */
+    if(tn->displayName)
+        attr->common.displayName =
+            UA_LOCALIZEDTEXT(tn->displayNameLocale, tn->displayName);
+    if(tn->description)
+        attr->common.description =
+            UA_LOCALIZEDTEXT(tn->descriptionLocale, tn->description);
+    attr->common.writeMask = tn->writeMask;
+    attr->common.userWriteMask = tn->userWriteMask;
+
+    if(res == UA_STATUSCODE_GOOD && value && tn->valueType)
+        res = decodeValue(l, tn, value);
+    return res;
+}
+
+static void
+clearAttributes(const UA_NodesetTableNode *tn, TableAttributes *attr) {
+    UA_Variant *value = NULL;
+    if(tn->nodeClass == UA_NODECLASS_VARIABLE)
+        value = &attr->variable.value;
+    else if(tn->nodeClass == UA_NODECLASS_VARIABLETYPE)
+        value = &attr->variableType.value;
+    if(!value)
+        return;
+    /* The ArrayDimensions point into the table */
+    value->arrayDimensions = NULL;
+    value->arrayDimensionsSize = 0;
+    UA_Variant_clear(value);
+}
+
+static UA_StatusCode
+beginNode(const TableLoader *l, const UA_NodesetTableNode *tn) {
+    UA_NodeId nodeId, parentNodeId, referenceTypeId, typeDefinition;
+    UA_StatusCode res = getNodeId(l, tn->nodeId, &nodeId);
+    res |= getNodeId(l, tn->parentNodeId, &parentNodeId);
+    res |= getNodeId(l, tn->referenceTypeId, &referenceTypeId);
+    res |= getNodeId(l, tn->typeDefinition, &typeDefinition);
+    UA_QualifiedName browseName =
+        UA_QUALIFIEDNAME(tn->browseNameNamespace, (char*)(uintptr_t)tn->browseName);
+    res |= mapNamespace(l, &browseName.namespaceIndex);
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    TableAttributes attr;
+    const UA_DataType *attrType = NULL;
+    res = setAttributes(l, tn, &attr, &attrType);
+    if(res == UA_STATUSCODE_GOOD)
+        res = addNode_begin(l->server, tn->nodeClass, nodeId, parentNodeId,
+                            referenceTypeId, browseName, typeDefinition,
+                            &attr, attrType, NULL, NULL);
+    clearAttributes(tn, &attr);
+    return res;
+}
+
+static UA_StatusCode
+addReferences(const TableLoader *l, const UA_NodesetTableNode *tn,
+              const UA_NodesetTableReference *refs) {
+    UA_NodeId sourceId;
+    UA_StatusCode res = getNodeId(l, tn->nodeId, &sourceId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    for(size_t i = 0; i < tn->referencesSize; i++) {
+        UA_NodeId refTypeId, targetId;
+        UA_StatusCode res2 = getNodeId(l, refs[i].referenceTypeId, &refTypeId);
+        res2 |= getNodeId(l, refs[i].targetId, &targetId);
+        if(res2 != UA_STATUSCODE_GOOD)
+            return UA_STATUSCODE_BADDECODINGERROR;
+        res |= addRef(l->server, sourceId, refTypeId, targetId, refs[i].isForward);
+    }
+    return res;
+}
+
+static UA_Boolean
+skipNode(const UA_NodesetTableNode *tn) {
+#ifndef UA_ENABLE_METHODCALLS
+    if(tn->flags & UA_NODESETTABLE_METHODCALLS)
+        return true;
+#endif
+    return false;
+}
+
+/* Method nodes are finished like the other nodes. The table does not define
+ * arguments that have to be added during _finish. */
+static UA_StatusCode
+finishNode(const TableLoader *l, const UA_NodesetTableNode *tn) {
+    UA_NodeId nodeId;
+    UA_StatusCode res = getNodeId(l, tn->nodeId, &nodeId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return addNode_finish(l->server, &l->server->adminSession, &nodeId);
+}
+
+UA_StatusCode
+UA_Server_loadNodesetTable(UA_Server *server, const UA_NodesetTable *table,
+                           const UA_UInt16 *namespaces, size_t namespacesSize) {
+    TableLoader l;
+    l.server = server;
+    l.table = table;
+    l.namespaces = namespaces;
+    l.namespacesSize = namespacesSize;
+
+    /* The reference blocks must cover the reference table */
+    size_t refsTotal = 0;
+    for(size_t i = 0; i < table->nodesSize; i++)
+        refsTotal += table->nodes[i].referencesSize;
+    if(refsTotal != table->referencesSize)
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+
+    UA_LOCK(&server->serviceMutex);
+
+    /* Add the nodes and their references. ReferenceTypes are finished right
+     * away. The subtype information is required for the following nodes. */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    const UA_NodesetTableReference *refs = table->references;
+    for(size_t i = 0; i < table->nodesSize; i++) {
+        const UA_NodesetTableNode *tn = &table->nodes[i];
+        if(!skipNode(tn)) {
+            res |= beginNode(&l, tn);
+            res |= addReferences(&l, tn, refs);
+            if(tn->nodeClass == UA_NODECLASS_REFERENCETYPE)
+                res |= finishNode(&l, tn);
+        }
+        refs += tn->referencesSize;
+    }
+
+    /* Finish the remaining nodes in reverse order */
+    for(size_t i = table->nodesSize; i > 0; i--) {
+        const UA_NodesetTableNode *tn = &table->nodes[i-1];
+        if(skipNode(tn) || tn->nodeClass == UA_NODECLASS_REFERENCETYPE)
+            continue;
+        res |= finishNode(&l, tn);
+    }
+
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
@@ -926,22 +926,32 @@ UA_StatusCode
 initNS0(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    /* Initialize base nodes which are always required an cannot be created
-     * through the NS compiler */
-    server->bootstrapNS0 = true;
-    UA_StatusCode retVal = createNS0_base(server);
+    /* The nodes of namespace zero are already present if the Nodestore is
+     * layered on top of a shared image. Then only the server-specific values
+     * and callbacks below are set. */
+    UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+    UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    const UA_Node *serverNode = UA_NODESTORE_GET(server, &serverId);
+    if(serverNode) {
+        UA_NODESTORE_RELEASE(server, serverNode);
+    } else {
+        /* Initialize base nodes which are always required an cannot be
+         * created through the NS compiler */
+        server->bootstrapNS0 = true;
+        retVal = createNS0_base(server);
 
 #ifdef UA_GENERATED_NAMESPACE_ZERO
-    UA_UNLOCK(&server->serviceMutex);
-    /* Load nodes and references generated from the XML ns0 definition */
-    retVal |= namespace0_generated(server);
-    UA_LOCK(&server->serviceMutex);
+        UA_UNLOCK(&server->serviceMutex);
+        /* Load nodes and references generated from the XML ns0 definition */
+        retVal |= namespace0_generated(server);
+        UA_LOCK(&server->serviceMutex);
 #else
-    /* Create a minimal server object */
-    retVal |= minimalServerObject(server);
+        /* Create a minimal server object */
+        retVal |= minimalServerObject(server);
 #endif
 
-    server->bootstrapNS0 = false;
+        server->bootstrapNS0 = false;
+    }
 
     if(retVal != UA_STATUSCODE_GOOD) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
@@ -1101,7 +1111,11 @@ initNS0(UA_Server *server) {
                                     profileArray, profileArraySize, &UA_TYPES[UA_TYPES_STRING]);
 
     /* ServerCapabilities - MaxQueryContinuationPoints */
+#ifdef UA_ENABLE_QUERY
+    UA_UInt16 maxQueryContinuationPoints = UA_MAXCONTINUATIONPOINTS;
+#else
     UA_UInt16 maxQueryContinuationPoints = 0;
+#endif
     retVal |= writeNs0Variable(server, UA_NS0ID_SERVER_SERVERCAPABILITIES_MAXQUERYCONTINUATIONPOINTS,
                                &maxQueryContinuationPoints, &UA_TYPES[UA_TYPES_UINT16]);
 
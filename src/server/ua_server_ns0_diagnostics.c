@@ -18,6 +18,29 @@ equalBrowseName(UA_String *bn, const char *n) {
     return UA_String_equal(bn, &name);
 }
 
+/* The diagnostics arrays are built on every read. With an IndexRange, only the
+ * selected elements are built. Monitoring tools can read a part of the array
+ * without the cost of the entire array. The range is returned as the start
+ * index and the number of elements. */
+static UA_StatusCode
+diagnosticsArrayRange(const UA_NumericRange *range, size_t size,
+                      size_t *start, size_t *count) {
+    *start = 0;
+    *count = size;
+    if(!range)
+        return UA_STATUSCODE_GOOD;
+    if(range->dimensionsSize != 1)
+        return UA_STATUSCODE_BADINDEXRANGENODATA;
+    if(range->dimensions[0].min >= size)
+        return UA_STATUSCODE_BADINDEXRANGENODATA;
+    size_t max = range->dimensions[0].max;
+    if(max >= size)
+        max = size - 1;
+    *start = range->dimensions[0].min;
+    *count = max - *start + 1;
+    return UA_STATUSCODE_GOOD;
+}
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 
 /****************************/
@@ -58,13 +81,7 @@ fillSubscriptionDiagnostics(UA_Subscription *sub,
     diag->monitoringQueueOverflowCount = sub->monitoringQueueOverflowCount;
     diag->nextSequenceNumber = sub->nextSequenceNumber;
     diag->eventQueueOverFlowCount = sub->eventQueueOverFlowCount;
-
-    /* Count the disabled MonitoredItems */
-    UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
-        if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED)
-            diag->disabledMonitoredItemCount++;
-    }
+    diag->disabledMonitoredItemCount = sub->disabledMonitoredItemsSize;
 }
 
 /* The node context points to the subscription */
@@ -128,10 +145,18 @@ readSubscriptionDiagnosticsArray(UA_Server *server,
     UA_LOCK(&server->serviceMutex);
 
     /* Get the current session */
-    size_t sdSize = 0;
+    size_t total = 0;
     session_list_entry *sentry;
     LIST_FOREACH(sentry, &server->sessions, pointers) {
-        sdSize += sentry->session.subscriptionsSize;
+        total += sentry->session.subscriptionsSize;
+    }
+
+    /* Select the range */
+    size_t start, sdSize;
+    UA_StatusCode res = diagnosticsArrayRange(range, total, &start, &sdSize);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        return res;
     }
 
     /* Allocate the output array */
@@ -142,11 +167,21 @@ readSubscriptionDiagnosticsArray(UA_Server *server,
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
 
-    /* Collect the statistics */
-    size_t i = 0;
+    /* Collect the statistics. Skip entire sessions before the range. */
+    size_t pos = 0, i = 0;
     UA_Subscription *sub;
     LIST_FOREACH(sentry, &server->sessions, pointers) {
+        if(i == sdSize)
+            break;
+        if(pos + sentry->session.subscriptionsSize <= start) {
+            pos += sentry->session.subscriptionsSize;
+            continue;
+        }
         TAILQ_FOREACH(sub, &sentry->session.subscriptions, sessionListEntry) {
+            if(pos++ < start)
+                continue;
+            if(i == sdSize)
+                break;
             fillSubscriptionDiagnostics(sub, &sd[i]);
             i++;
         }
@@ -311,27 +346,40 @@ readSessionDiagnosticsArray(UA_Server *server,
                             UA_Boolean sourceTimestamp,
                             const UA_NumericRange *range, UA_DataValue *value) {
     UA_LOCK_ASSERT(&server->serviceMutex, 0);
+    UA_LOCK(&server->serviceMutex);
+
+    /* Select the range */
+    size_t start, sdSize;
+    UA_StatusCode res =
+        diagnosticsArrayRange(range, server->sessionCount, &start, &sdSize);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        return res;
+    }
 
     /* Allocate the output array */
     UA_SessionDiagnosticsDataType *sd = (UA_SessionDiagnosticsDataType*)
-        UA_Array_new(server->sessionCount,
-                     &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]);
-    if(!sd)
+        UA_Array_new(sdSize, &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]);
+    if(!sd) {
+        UA_UNLOCK(&server->serviceMutex);
         return UA_STATUSCODE_BADOUTOFMEMORY;
-
-    UA_LOCK(&server->serviceMutex);
+    }
 
     /* Collect the statistics */
-    size_t i = 0;
+    size_t pos = 0, i = 0;
     session_list_entry *session;
     LIST_FOREACH(session, &server->sessions, pointers) {
+        if(i == sdSize)
+            break;
+        if(pos++ < start)
+            continue;
         setSessionDiagnostics(&session->session, &sd[i]);
         i++;
     }
 
     /* Set the output */
     value->hasValue = true;
-    UA_Variant_setArray(&value->value, sd, server->sessionCount,
+    UA_Variant_setArray(&value->value, sd, sdSize,
                         &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]);
 
     UA_UNLOCK(&server->serviceMutex);
@@ -354,6 +402,39 @@ setSessionSecurityDiagnostics(UA_Session *session,
     }
 }
 
+/* The resource usage of the Session is not part of the
+ * SessionDiagnosticsObjectType. It is added as additional variables in the
+ * session object. */
+#define SESSIONUSAGE_VARIABLES 4
+static const char *sessionUsageNames[SESSIONUSAGE_VARIABLES] = {
+    "ServiceCpuTime", "BytesDecoded", "BytesEncoded", "NotificationsGenerated"};
+
+static UA_Boolean
+readSessionUsage(UA_Session *session, UA_String *bn, UA_DataValue *value) {
+    UA_UInt64 count;
+    if(equalBrowseName(bn, sessionUsageNames[0])) {
+        /* Duration in ms */
+        UA_Duration cpuTime = (UA_Duration)
+            UA_atomic_addUInt64(&session->usage.serviceCpuTime, 0) / UA_DATETIME_MSEC;
+        value->hasValue =
+            (UA_Variant_setScalarCopy(&value->value, &cpuTime,
+                                      &UA_TYPES[UA_TYPES_DURATION]) == UA_STATUSCODE_GOOD);
+        return true;
+    } else if(equalBrowseName(bn, sessionUsageNames[1])) {
+        count = UA_atomic_addUInt64(&session->usage.bytesDecoded, 0);
+    } else if(equalBrowseName(bn, sessionUsageNames[2])) {
+        count = UA_atomic_addUInt64(&session->usage.bytesEncoded, 0);
+    } else if(equalBrowseName(bn, sessionUsageNames[3])) {
+        count = UA_atomic_addUInt64(&session->usage.notifications, 0);
+    } else {
+        return false;
+    }
+    value->hasValue =
+        (UA_Variant_setScalarCopy(&value->value, &count,
+                                  &UA_TYPES[UA_TYPES_UINT64]) == UA_STATUSCODE_GOOD);
+    return true;
+}
+
 static UA_StatusCode
 readSessionDiagnostics(UA_Server *server,
                        const UA_NodeId *sessionId, void *sessionContext,
@@ -397,6 +478,9 @@ readSessionDiagnostics(UA_Server *server,
     }
 #endif
 
+    if(readSessionUsage(session, &bn.name, value))
+        goto cleanup;
+
     if(equalBrowseName(&bn.name, "SessionDiagnostics")) {
         setSessionDiagnostics(session, &data.sddt);
         content = &data.sddt;
@@ -457,26 +541,40 @@ readSessionSecurityDiagnostics(UA_Server *server,
                                const UA_NodeId *nodeId, void *nodeContext,
                                UA_Boolean sourceTimestamp,
                                const UA_NumericRange *range, UA_DataValue *value) {
+    UA_LOCK(&server->serviceMutex);
+
+    /* Select the range */
+    size_t start, sdSize;
+    UA_StatusCode res =
+        diagnosticsArrayRange(range, server->sessionCount, &start, &sdSize);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_UNLOCK(&server->serviceMutex);
+        return res;
+    }
+
     /* Allocate the output array */
     UA_SessionSecurityDiagnosticsDataType *sd = (UA_SessionSecurityDiagnosticsDataType*)
-        UA_Array_new(server->sessionCount,
-                     &UA_TYPES[UA_TYPES_SESSIONSECURITYDIAGNOSTICSDATATYPE]);
-    if(!sd)
+        UA_Array_new(sdSize, &UA_TYPES[UA_TYPES_SESSIONSECURITYDIAGNOSTICSDATATYPE]);
+    if(!sd) {
+        UA_UNLOCK(&server->serviceMutex);
         return UA_STATUSCODE_BADOUTOFMEMORY;
-
-    UA_LOCK(&server->serviceMutex);
+    }
 
     /* Collect the statistics */
-    size_t i = 0;
+    size_t pos = 0, i = 0;
     session_list_entry *session;
     LIST_FOREACH(session, &server->sessions, pointers) {
+        if(i == sdSize)
+            break;
+        if(pos++ < start)
+            continue;
         setSessionSecurityDiagnostics(&session->session, &sd[i]);
         i++;
     }
 
     /* Set the output */
     value->hasValue = true;
-    UA_Variant_setArray(&value->value, sd, server->sessionCount,
+    UA_Variant_setArray(&value->value, sd, sdSize,
                         &UA_TYPES[UA_TYPES_SESSIONSECURITYDIAGNOSTICSDATATYPE]);
 
     UA_UNLOCK(&server->serviceMutex);
@@ -505,6 +603,22 @@ createSessionObject(UA_Server *server, UA_Session *session) {
     if(res != UA_STATUSCODE_GOOD)
         goto cleanup;
 
+    /* Add the variables for the resource usage */
+    for(size_t i = 0; i < SESSIONUSAGE_VARIABLES; i++) {
+        UA_VariableAttributes var_attr = UA_VariableAttributes_default;
+        var_attr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)sessionUsageNames[i]);
+        var_attr.dataType = (i == 0) ? UA_TYPES[UA_TYPES_DURATION].typeId :
+            UA_TYPES[UA_TYPES_UINT64].typeId;
+        var_attr.valueRank = UA_VALUERANK_SCALAR;
+        res = addNode(server, UA_NODECLASS_VARIABLE, UA_NODEID_NUMERIC(1, 0),
+                      session->sessionId, hasComponent,
+                      UA_QUALIFIEDNAME(1, (char*)(uintptr_t)sessionUsageNames[i]),
+                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), &var_attr,
+                      &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES], NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            goto cleanup;
+    }
+
     /* Recursively browse all children */
     res = referenceTypeIndices(server, &hasComponent, &refTypes, false);
     if(res != UA_STATUSCODE_GOOD)
@@ -0,0 +1,147 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+
+#ifdef UA_ENABLE_STATIC_POOLS
+
+/* The header is followed by the object. The block size is a multiple of the
+ * header size to keep the alignment. */
+static size_t
+blockSize(const UA_ObjectPool *pool) {
+    size_t blocks = (pool->objectSize + sizeof(UA_PoolBlock) - 1) / sizeof(UA_PoolBlock);
+    return (blocks + 1) * sizeof(UA_PoolBlock);
+}
+
+UA_StatusCode
+UA_ObjectPool_init(UA_ObjectPool *pool, size_t objectSize, size_t capacity) {
+    if(pool->memory)
+        return UA_STATUSCODE_GOOD;
+
+    pool->objectSize = objectSize;
+    pool->capacity = capacity;
+    pool->used = 0;
+    pool->freeList = NULL;
+    if(capacity == 0)
+        return UA_STATUSCODE_GOOD;
+
+    size_t bs = blockSize(pool);
+    if(capacity > SIZE_MAX / bs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    pool->memory = (UA_Byte*)UA_malloc(bs * capacity);
+    if(!pool->memory) {
+        pool->capacity = 0;
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    /* Chain the free list in the order of the memory */
+    for(size_t i = capacity; i > 0; i--) {
+        UA_PoolBlock *b = (UA_PoolBlock*)&pool->memory[(i - 1) * bs];
+        b->next = pool->freeList;
+        pool->freeList = b;
+    }
+
+    UA_LOCK_INIT(&pool->lock);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_ObjectPool_clear(UA_ObjectPool *pool) {
+    if(!pool->memory)
+        return;
+    /* Objects that are still in use would be returned to freed memory */
+    if(pool->used > 0)
+        return;
+    UA_LOCK_DESTROY(&pool->lock);
+    UA_free(pool->memory);
+    memset(pool, 0, sizeof(UA_ObjectPool));
+}
+
+void *
+UA_ObjectPool_alloc(UA_ObjectPool *pool, size_t size) {
+    /* Allocate from the heap */
+    if(!pool->memory || size > pool->objectSize) {
+        UA_PoolBlock *b = (UA_PoolBlock*)UA_calloc(1, sizeof(UA_PoolBlock) + size);
+        if(!b)
+            return NULL;
+        b->pool = NULL;
+        return b + 1;
+    }
+
+    /* Take from the free list */
+    UA_LOCK(&pool->lock);
+    UA_PoolBlock *b = pool->freeList;
+    if(!b) {
+        UA_UNLOCK(&pool->lock);
+        return NULL;
+    }
+    pool->freeList = b->next;
+    pool->used++;
+    UA_UNLOCK(&pool->lock);
+
+    b->pool = pool;
+    memset(b + 1, 0, pool->objectSize);
+    return b + 1;
+}
+
+void
+UA_ObjectPool_free(void *p) {
+    if(!p)
+        return;
+    UA_PoolBlock *b = (UA_PoolBlock*)p - 1;
+    UA_ObjectPool *pool = b->pool;
+    if(!pool) {
+        UA_free(b);
+        return;
+    }
+
+    UA_LOCK(&pool->lock);
+    b->next = pool->freeList;
+    pool->freeList = b;
+    pool->used--;
+    UA_UNLOCK(&pool->lock);
+}
+
+UA_StatusCode
+UA_ServerPools_init(UA_Server *server) {
+    UA_ServerConfig *config = &server->config;
+    UA_ServerPools *pools = &server->pools;
+    UA_StatusCode res =
+        UA_ObjectPool_init(&pools->sessions, sizeof(session_list_entry),
+                           config->maxSessions);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    res |= UA_ObjectPool_init(&pools->subscriptions, sizeof(UA_Subscription),
+                              config->maxSubscriptions);
+    res |= UA_ObjectPool_init(&pools->monitoredItems, sizeof(UA_LocalMonitoredItem),
+                              config->maxMonitoredItems);
+
+    /* One Notification more than the queue size is needed temporarily when the
+     * queue overflows */
+    size_t notifications = (size_t)config->maxMonitoredItems *
+        ((size_t)config->queueSizeLimits.max + 1);
+    res |= UA_ObjectPool_init(&pools->notifications, sizeof(UA_Notification),
+                              notifications);
+#endif
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ServerPools_clear(server);
+        UA_LOG_ERROR(config->logging, UA_LOGCATEGORY_SERVER,
+                     "Could not allocate the object pools");
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_ServerPools_clear(UA_Server *server) {
+    UA_ServerPools *pools = &server->pools;
+    UA_ObjectPool_clear(&pools->sessions);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    UA_ObjectPool_clear(&pools->subscriptions);
+    UA_ObjectPool_clear(&pools->monitoredItems);
+    UA_ObjectPool_clear(&pools->notifications);
+#endif
+}
+
+#endif /* UA_ENABLE_STATIC_POOLS */
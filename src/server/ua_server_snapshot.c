@@ -0,0 +1,710 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *    Copyright 2024 (c) Fraunhofer IOSB (Author: Julius Pfrommer)
+ */
+
+#include "ua_server_internal.h"
+#include "ua_types_encoding_binary.h"
+
+/* Snapshot Format
+ * ---------------
+ * All values use the OPC UA binary encoding.
+ *
+ * Header: UInt32 magic, UInt32 version, String[] namespaces
+ *
+ * Followed by one record per node until the end of the buffer. A record has
+ * two sections, each prefixed with its length as a UInt32. This allows the
+ * loader to insert all nodes before the references are resolved.
+ *
+ * Attributes: NodeId, NodeClass, BrowseName, LocalizedText[] DisplayName,
+ *             LocalizedText[] Description, UInt32 WriteMask, followed by the
+ *             attributes of the NodeClass
+ *
+ * References: UInt32 kindsSize, followed for each ReferenceKind by
+ *             NodeId referenceType, Boolean isInverse, ExpandedNodeId[] targets
+ */
+
+#define UA_SNAPSHOT_MAGIC 0x53414E55 /* "UNAS" */
+#define UA_SNAPSHOT_VERSION 1
+#define UA_SNAPSHOT_INITIALSIZE 65536
+
+/***********/
+/* Writing */
+/***********/
+
+typedef struct {
+    UA_Server *server;
+    UA_ByteString buf;
+    size_t pos;
+    UA_StatusCode res;
+} SnapshotWriter;
+
+static void
+writeValue(SnapshotWriter *w, const void *src, const UA_DataType *type) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Grow the buffer. Without an exchange callback the encoding cannot
+     * resume after the end of the buffer is reached. */
+    size_t len = UA_calcSizeBinary(src, type);
+    if(w->pos + len > w->buf.length) {
+        size_t newLength = w->buf.length * 2;
+        while(w->pos + len > newLength)
+            newLength *= 2;
+        UA_Byte *newData = (UA_Byte*)UA_realloc(w->buf.data, newLength);
+        if(!newData) {
+            w->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        w->buf.data = newData;
+        w->buf.length = newLength;
+    }
+
+    UA_Byte *pos = &w->buf.data[w->pos];
+    const UA_Byte *end = &w->buf.data[w->buf.length];
+    w->res = UA_encodeBinaryInternal(src, type, &pos, &end, NULL, NULL);
+    w->pos = (uintptr_t)(pos - w->buf.data);
+}
+
+/* Reserve the length field of a section. Returns the offset of the field. */
+static size_t
+beginSection(SnapshotWriter *w) {
+    size_t start = w->pos;
+    UA_UInt32 placeholder = 0;
+    writeValue(w, &placeholder, &UA_TYPES[UA_TYPES_UINT32]);
+    return start;
+}
+
+static void
+endSection(SnapshotWriter *w, size_t start) {
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    UA_UInt32 len = (UA_UInt32)(w->pos - start - 4);
+    UA_Byte *pos = &w->buf.data[start];
+    const UA_Byte *end = &w->buf.data[start + 4];
+    w->res = UA_encodeBinaryInternal(&len, &UA_TYPES[UA_TYPES_UINT32],
+                                     &pos, &end, NULL, NULL);
+}
+
+static void
+writeLocalizedTexts(SnapshotWriter *w, const UA_LocalizedTextListEntry *lt) {
+    UA_UInt32 count = 0;
+    for(const UA_LocalizedTextListEntry *e = lt; e; e = e->next)
+        count++;
+    writeValue(w, &count, &UA_TYPES[UA_TYPES_UINT32]);
+    for(; lt; lt = lt->next)
+        writeValue(w, &lt->localizedText, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+}
+
+static void
+writeVariableAttributes(SnapshotWriter *w, const UA_VariableNode *vn) {
+    writeValue(w, &vn->dataType, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+    UA_UInt32 dimsSize = (UA_UInt32)vn->arrayDimensionsSize;
+    writeValue(w, &dimsSize, &UA_TYPES[UA_TYPES_UINT32]);
+    for(size_t i = 0; i < vn->arrayDimensionsSize; i++)
+        writeValue(w, &vn->arrayDimensions[i], &UA_TYPES[UA_TYPES_UINT32]);
+
+    /* Only values stored in the node are part of the snapshot. Values from a
+     * DataSource or an external backend are written as empty. */
+    UA_DataValue empty;
+    UA_DataValue_init(&empty);
+    const UA_DataValue *value = &empty;
+    if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_INTERNAL)
+        value = &vn->valueBackend.backend.internal.value;
+    else if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+            vn->valueSource == UA_VALUESOURCE_DATA)
+        value = &vn->value.data.value;
+    writeValue(w, value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+}
+
+static void
+writeAttributes(SnapshotWriter *w, const UA_Node *node) {
+    const UA_NodeHead *head = &node->head;
+    writeValue(w, &head->nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    writeValue(w, &head->nodeClass, &UA_TYPES[UA_TYPES_NODECLASS]);
+    writeValue(w, &head->browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    writeLocalizedTexts(w, head->displayName);
+    writeLocalizedTexts(w, head->description);
+    writeValue(w, &head->writeMask, &UA_TYPES[UA_TYPES_UINT32]);
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        const UA_VariableNode *vn = &node->variableNode;
+        writeVariableAttributes(w, vn);
+        writeValue(w, &vn->accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        writeValue(w, &vn->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeValue(w, &vn->historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &vn->isDynamic, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        writeVariableAttributes(w, &node->variableNode);
+        writeValue(w, &node->variableTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD:
+        writeValue(w, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_OBJECT:
+        writeValue(w, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        writeValue(w, &node->objectTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE: {
+        const UA_ReferenceTypeNode *rn = &node->referenceTypeNode;
+        writeValue(w, &rn->isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &rn->symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        writeValue(w, &rn->inverseName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        break;
+    }
+    case UA_NODECLASS_DATATYPE:
+        writeValue(w, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        writeValue(w, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        writeValue(w, &node->viewNode.containsNoLoops, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        w->res = UA_STATUSCODE_BADINTERNALERROR;
+        break;
+    }
+}
+
+static void *
+writeTarget(void *context, UA_ReferenceTarget *t) {
+    SnapshotWriter *w = (SnapshotWriter*)context;
+    UA_ExpandedNodeId target = UA_NodePointer_toExpandedNodeId(t->targetId);
+    writeValue(w, &target, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return NULL;
+}
+
+static void
+writeReferences(SnapshotWriter *w, const UA_Node *node) {
+    const UA_NodeHead *head = &node->head;
+    UA_UInt32 kindsSize = (UA_UInt32)head->referencesSize;
+    writeValue(w, &kindsSize, &UA_TYPES[UA_TYPES_UINT32]);
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        const UA_NodeId *refTypeId =
+            UA_NODESTORE_GETREFERENCETYPEID(w->server, rk->referenceTypeIndex);
+        if(!refTypeId) {
+            w->res = UA_STATUSCODE_BADINTERNALERROR;
+            return;
+        }
+        writeValue(w, refTypeId, &UA_TYPES[UA_TYPES_NODEID]);
+        writeValue(w, &rk->isInverse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        UA_UInt32 targetsSize = (UA_UInt32)rk->targetsSize;
+        writeValue(w, &targetsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        UA_NodeReferenceKind_iterate(rk, writeTarget, w);
+    }
+}
+
+static void
+snapshotVisitor(void *visitorCtx, const UA_Node *node) {
+    SnapshotWriter *w = (SnapshotWriter*)visitorCtx;
+    if(w->res != UA_STATUSCODE_GOOD)
+        return;
+    size_t start = beginSection(w);
+    writeAttributes(w, node);
+    endSection(w, start);
+    start = beginSection(w);
+    writeReferences(w, node);
+    endSection(w, start);
+}
+
+UA_StatusCode
+UA_Server_saveSnapshot(UA_Server *server, UA_ByteString *snapshot) {
+    UA_ByteString_init(snapshot);
+
+    SnapshotWriter w;
+    memset(&w, 0, sizeof(SnapshotWriter));
+    w.server = server;
+    w.res = UA_ByteString_allocBuffer(&w.buf, UA_SNAPSHOT_INITIALSIZE);
+    if(w.res != UA_STATUSCODE_GOOD)
+        return w.res;
+
+    UA_LOCK(&server->serviceMutex);
+
+    /* Header */
+    UA_UInt32 magic = UA_SNAPSHOT_MAGIC;
+    UA_UInt32 version = UA_SNAPSHOT_VERSION;
+    writeValue(&w, &magic, &UA_TYPES[UA_TYPES_UINT32]);
+    writeValue(&w, &version, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Int32 nsSize = (UA_Int32)server->namespacesSize;
+    writeValue(&w, &nsSize, &UA_TYPES[UA_TYPES_INT32]);
+    for(size_t i = 0; i < server->namespacesSize; i++)
+        writeValue(&w, &server->namespaces[i], &UA_TYPES[UA_TYPES_STRING]);
+
+    /* Nodes */
+    server->config.nodestore.iterate(server->config.nodestore.context,
+                                     snapshotVisitor, &w);
+
+    UA_UNLOCK(&server->serviceMutex);
+
+    if(w.res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&w.buf);
+        return w.res;
+    }
+
+    /* Shrink to the used size */
+    UA_Byte *data = (UA_Byte*)UA_realloc(w.buf.data, w.pos);
+    if(data)
+        w.buf.data = data;
+    w.buf.length = w.pos;
+    *snapshot = w.buf;
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********/
+/* Loading */
+/***********/
+
+typedef struct {
+    UA_Server *server;
+    const UA_ByteString *buf;
+    size_t offset;
+    UA_StatusCode res;
+
+    /* Maps the namespace indices of the snapshot to the server */
+    size_t nsMapSize;
+    UA_UInt16 *nsMap;
+} SnapshotReader;
+
+static void
+readValue(SnapshotReader *r, void *dst, const UA_DataType *type) {
+    if(r->res != UA_STATUSCODE_GOOD) {
+        UA_init(dst, type);
+        return;
+    }
+    r->res = UA_decodeBinaryInternal(r->buf, &r->offset, dst, type,
+                                     r->server->config.customDataTypes);
+}
+
+static void
+remapNamespace(SnapshotReader *r, UA_UInt16 *nsIndex) {
+    if(*nsIndex >= r->nsMapSize) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    *nsIndex = r->nsMap[*nsIndex];
+}
+
+static void
+readNodeId(SnapshotReader *r, UA_NodeId *id) {
+    readValue(r, id, &UA_TYPES[UA_TYPES_NODEID]);
+    if(r->res == UA_STATUSCODE_GOOD)
+        remapNamespace(r, &id->namespaceIndex);
+}
+
+static UA_StatusCode
+readNamespaces(SnapshotReader *r) {
+    UA_UInt32 magic = 0, version = 0;
+    UA_Int32 nsSize = 0;
+    readValue(r, &magic, &UA_TYPES[UA_TYPES_UINT32]);
+    readValue(r, &version, &UA_TYPES[UA_TYPES_UINT32]);
+    readValue(r, &nsSize, &UA_TYPES[UA_TYPES_INT32]);
+    if(r->res != UA_STATUSCODE_GOOD || magic != UA_SNAPSHOT_MAGIC ||
+       version != UA_SNAPSHOT_VERSION || nsSize < 2 || nsSize > UA_UINT16_MAX)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    r->nsMap = (UA_UInt16*)UA_malloc(sizeof(UA_UInt16) * (size_t)nsSize);
+    if(!r->nsMap)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    r->nsMapSize = (size_t)nsSize;
+
+    /* Namespace zero and the local server namespace keep their index */
+    for(UA_Int32 i = 0; i < nsSize; i++) {
+        UA_String uri;
+        readValue(r, &uri, &UA_TYPES[UA_TYPES_STRING]);
+        if(r->res != UA_STATUSCODE_GOOD)
+            return r->res;
+        r->nsMap[i] = (i < 2) ? (UA_UInt16)i : addNamespace(r->server, uri);
+        UA_String_clear(&uri);
+        if(r->nsMap[i] == 0 && i > 0)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+skipSection(SnapshotReader *r) {
+    UA_UInt32 len = 0;
+    readValue(r, &len, &UA_TYPES[UA_TYPES_UINT32]);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(len > r->buf->length - r->offset) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    r->offset += len;
+}
+
+/* Replaces all locales of the list */
+static void
+readLocalizedTexts(SnapshotReader *r, UA_NodeHead *head, UA_Boolean description) {
+    UA_LocalizedTextListEntry **root = (description) ?
+        &head->description : &head->displayName;
+
+    /* Remove the existing locales. Setting an empty text removes the locale. */
+    while(*root && r->res == UA_STATUSCODE_GOOD) {
+        UA_LocalizedText remove = (*root)->localizedText;
+        remove.text = UA_STRING_NULL;
+        r->res = (description) ?
+            UA_Node_insertOrUpdateDescription(head, &remove) :
+            UA_Node_insertOrUpdateDisplayName(head, &remove);
+    }
+
+    UA_UInt32 count = 0;
+    readValue(r, &count, &UA_TYPES[UA_TYPES_UINT32]);
+    if(r->res != UA_STATUSCODE_GOOD || count == 0)
+        return;
+    if(count > r->buf->length - r->offset) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    UA_LocalizedText *lts = (UA_LocalizedText*)
+        UA_Array_new(count, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    if(!lts) {
+        r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    for(size_t i = 0; i < count; i++)
+        readValue(r, &lts[i], &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+
+    /* New locales are prepended. Insert in reverse order to restore the
+     * original order of the list (the first locale is the default). */
+    for(size_t i = count; i > 0 && r->res == UA_STATUSCODE_GOOD; i--) {
+        r->res = (description) ?
+            UA_Node_insertOrUpdateDescription(head, &lts[i-1]) :
+            UA_Node_insertOrUpdateDisplayName(head, &lts[i-1]);
+    }
+    UA_Array_delete(lts, count, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+}
+
+static void
+readVariableAttributes(SnapshotReader *r, UA_VariableNode *vn) {
+    UA_NodeId_clear(&vn->dataType);
+    readNodeId(r, &vn->dataType);
+    readValue(r, &vn->valueRank, &UA_TYPES[UA_TYPES_INT32]);
+
+    UA_Array_delete(vn->arrayDimensions, vn->arrayDimensionsSize,
+                    &UA_TYPES[UA_TYPES_UINT32]);
+    vn->arrayDimensions = NULL;
+    vn->arrayDimensionsSize = 0;
+    UA_UInt32 dimsSize = 0;
+    readValue(r, &dimsSize, &UA_TYPES[UA_TYPES_UINT32]);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(dimsSize > 0) {
+        if(dimsSize > r->buf->length - r->offset) {
+            r->res = UA_STATUSCODE_BADDECODINGERROR;
+            return;
+        }
+        vn->arrayDimensions = (UA_UInt32*)
+            UA_Array_new(dimsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(!vn->arrayDimensions) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+            return;
+        }
+        vn->arrayDimensionsSize = dimsSize;
+        for(size_t i = 0; i < dimsSize; i++)
+            readValue(r, &vn->arrayDimensions[i], &UA_TYPES[UA_TYPES_UINT32]);
+    }
+
+    /* Values from a DataSource or an external backend remain in place */
+    UA_DataValue value;
+    readValue(r, &value, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_INTERNAL) {
+        UA_DataValue_clear(&vn->valueBackend.backend.internal.value);
+        vn->valueBackend.backend.internal.value = value;
+    } else if(vn->valueBackend.backendType == UA_VALUEBACKENDTYPE_NONE &&
+              vn->valueSource == UA_VALUESOURCE_DATA) {
+        UA_DataValue_clear(&vn->value.data.value);
+        vn->value.data.value = value;
+    } else {
+        UA_DataValue_clear(&value);
+    }
+}
+
+/* Overwrites the attributes of the node that are part of the snapshot. The
+ * NodeId and NodeClass were already decoded. */
+static void
+readAttributes(SnapshotReader *r, UA_Node *node) {
+    UA_NodeHead *head = &node->head;
+    UA_QualifiedName browseName;
+    readValue(r, &browseName, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    if(r->res == UA_STATUSCODE_GOOD)
+        remapNamespace(r, &browseName.namespaceIndex);
+    if(r->res == UA_STATUSCODE_GOOD)
+        r->res = UA_Node_setBrowseName(head, &browseName);
+    UA_QualifiedName_clear(&browseName);
+    readLocalizedTexts(r, head, false);
+    readLocalizedTexts(r, head, true);
+    readValue(r, &head->writeMask, &UA_TYPES[UA_TYPES_UINT32]);
+
+    switch(head->nodeClass) {
+    case UA_NODECLASS_VARIABLE: {
+        UA_VariableNode *vn = &node->variableNode;
+        readVariableAttributes(r, vn);
+        readValue(r, &vn->accessLevel, &UA_TYPES[UA_TYPES_BYTE]);
+        readValue(r, &vn->minimumSamplingInterval, &UA_TYPES[UA_TYPES_DOUBLE]);
+        readValue(r, &vn->historizing, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &vn->isDynamic, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    }
+    case UA_NODECLASS_VARIABLETYPE:
+        readVariableAttributes(r, &node->variableNode);
+        readValue(r, &node->variableTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_METHOD:
+        readValue(r, &node->methodNode.executable, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_OBJECT:
+        readValue(r, &node->objectNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        break;
+    case UA_NODECLASS_OBJECTTYPE:
+        readValue(r, &node->objectTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_REFERENCETYPE: {
+        UA_ReferenceTypeNode *rn = &node->referenceTypeNode;
+        readValue(r, &rn->isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &rn->symmetric, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        UA_LocalizedText_clear(&rn->inverseName);
+        readValue(r, &rn->inverseName, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+        break;
+    }
+    case UA_NODECLASS_DATATYPE:
+        readValue(r, &node->dataTypeNode.isAbstract, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    case UA_NODECLASS_VIEW:
+        readValue(r, &node->viewNode.eventNotifier, &UA_TYPES[UA_TYPES_BYTE]);
+        readValue(r, &node->viewNode.containsNoLoops, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        break;
+    default:
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        break;
+    }
+}
+
+/* Insert the node or replace the existing node with the same NodeId. Existing
+ * nodes keep their context, callbacks and value sources. The references are
+ * removed and restored in the second pass. New ReferenceTypes are added to
+ * the newRefTypes list to compute their subtype sets at the end. */
+static void
+loadNode(SnapshotReader *r, UA_NodeId **newRefTypes, size_t *newRefTypesSize) {
+    UA_Server *server = r->server;
+    UA_NodeId nodeId;
+    UA_NodeClass nodeClass = UA_NODECLASS_UNSPECIFIED;
+    readNodeId(r, &nodeId);
+    readValue(r, &nodeClass, &UA_TYPES[UA_TYPES_NODECLASS]);
+    if(r->res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&nodeId);
+        return;
+    }
+
+    /* Get a copy of the existing node. Replace nodes of a different class. */
+    UA_Node *node = NULL;
+    UA_StatusCode res = UA_NODESTORE_GETCOPY(server, &nodeId, &node);
+    if(res == UA_STATUSCODE_GOOD && node->head.nodeClass != nodeClass) {
+        UA_NODESTORE_DELETE(server, node);
+        node = NULL;
+        r->res = UA_NODESTORE_REMOVE(server, &nodeId);
+    }
+
+    UA_Boolean existing = (node != NULL);
+    if(!existing && r->res == UA_STATUSCODE_GOOD) {
+        node = UA_NODESTORE_NEW(server, nodeClass);
+        if(!node) {
+            r->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        } else {
+            node->head.nodeId = nodeId;
+            UA_NodeId_init(&nodeId);
+            node->head.constructed = true; /* Skip the constructors */
+        }
+    }
+    UA_NodeId_clear(&nodeId);
+    if(r->res != UA_STATUSCODE_GOOD) {
+        if(node)
+            UA_NODESTORE_DELETE(server, node);
+        return;
+    }
+
+    UA_Node_deleteReferences(node);
+    readAttributes(r, node);
+    if(r->res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return;
+    }
+
+    /* Remember new ReferenceTypes before the node is handed over */
+    if(!existing && nodeClass == UA_NODECLASS_REFERENCETYPE) {
+        r->res = UA_Array_appendCopy((void**)newRefTypes, newRefTypesSize,
+                                     &node->head.nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+        if(r->res != UA_STATUSCODE_GOOD) {
+            UA_NODESTORE_DELETE(server, node);
+            return;
+        }
+    }
+
+    r->res = (existing) ?
+        UA_NODESTORE_REPLACE(server, node) : UA_NODESTORE_INSERT(server, node, NULL);
+}
+
+static UA_UInt32
+targetNameHash(UA_Server *server, const UA_ExpandedNodeId *target) {
+    if(target->serverIndex != 0 || target->namespaceUri.length > 0)
+        return 0; /* Remote target */
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, &target->nodeId,
+                                   UA_NODEATTRIBUTESMASK_BROWSENAME,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(!node)
+        return 0;
+    UA_UInt32 hash = UA_QualifiedName_hash(&node->head.browseName);
+    UA_NODESTORE_RELEASE(server, node);
+    return hash;
+}
+
+/* Restore the references of the node. All nodes exist at this point. */
+static void
+loadReferences(SnapshotReader *r) {
+    UA_Server *server = r->server;
+
+    /* Decode the NodeId from the attributes section and skip the remainder */
+    UA_UInt32 attrLen = 0;
+    readValue(r, &attrLen, &UA_TYPES[UA_TYPES_UINT32]);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+    if(attrLen > r->buf->length - r->offset) {
+        r->res = UA_STATUSCODE_BADDECODINGERROR;
+        return;
+    }
+    size_t attrEnd = r->offset + attrLen;
+    UA_NodeId nodeId;
+    readNodeId(r, &nodeId);
+    r->offset = attrEnd;
+
+    UA_UInt32 refLen = 0, kindsSize = 0;
+    readValue(r, &refLen, &UA_TYPES[UA_TYPES_UINT32]);
+    readValue(r, &kindsSize, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Node *node = NULL;
+    if(r->res == UA_STATUSCODE_GOOD)
+        r->res = UA_NODESTORE_GETCOPY(server, &nodeId, &node);
+    UA_NodeId_clear(&nodeId);
+    if(r->res != UA_STATUSCODE_GOOD)
+        return;
+
+    for(size_t i = 0; i < kindsSize && r->res == UA_STATUSCODE_GOOD; i++) {
+        UA_NodeId refTypeId;
+        UA_Boolean isInverse = false;
+        UA_UInt32 targetsSize = 0;
+        readNodeId(r, &refTypeId);
+        readValue(r, &isInverse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        readValue(r, &targetsSize, &UA_TYPES[UA_TYPES_UINT32]);
+        if(r->res != UA_STATUSCODE_GOOD) {
+            UA_NodeId_clear(&refTypeId);
+            break;
+        }
+
+        /* Resolve the ReferenceTypeIndex */
+        const UA_Node *refType = UA_NODESTORE_GET(server, &refTypeId);
+        UA_NodeId_clear(&refTypeId);
+        if(!refType || refType->head.nodeClass != UA_NODECLASS_REFERENCETYPE) {
+            if(refType)
+                UA_NODESTORE_RELEASE(server, refType);
+            r->res = UA_STATUSCODE_BADREFERENCETYPEIDINVALID;
+            break;
+        }
+        UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
+        UA_NODESTORE_RELEASE(server, refType);
+
+        for(size_t j = 0; j < targetsSize && r->res == UA_STATUSCODE_GOOD; j++) {
+            UA_ExpandedNodeId target;
+            readValue(r, &target, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+            if(r->res == UA_STATUSCODE_GOOD && target.serverIndex == 0 &&
+               target.namespaceUri.length == 0)
+                remapNamespace(r, &target.nodeId.namespaceIndex);
+            if(r->res == UA_STATUSCODE_GOOD) {
+                r->res = UA_Node_addReference(node, refTypeIndex, !isInverse, &target,
+                                              targetNameHash(server, &target));
+                if(r->res == UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED)
+                    r->res = UA_STATUSCODE_GOOD;
+            }
+            UA_ExpandedNodeId_clear(&target);
+        }
+    }
+
+    if(r->res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_DELETE(server, node);
+        return;
+    }
+    r->res = UA_NODESTORE_REPLACE(server, node);
+}
+
+UA_StatusCode
+UA_Server_loadSnapshot(UA_Server *server, const UA_ByteString *snapshot) {
+    SnapshotReader r;
+    memset(&r, 0, sizeof(SnapshotReader));
+    r.server = server;
+    r.buf = snapshot;
+    UA_NodeId *newRefTypes = NULL;
+    size_t newRefTypesSize = 0;
+
+    UA_LOCK(&server->serviceMutex);
+
+    r.res = readNamespaces(&r);
+    size_t nodesStart = r.offset;
+
+    /* Insert the nodes without references */
+    while(r.res == UA_STATUSCODE_GOOD && r.offset < snapshot->length) {
+        UA_UInt32 attrLen = 0;
+        readValue(&r, &attrLen, &UA_TYPES[UA_TYPES_UINT32]);
+        if(r.res != UA_STATUSCODE_GOOD)
+            break;
+        size_t attrEnd = r.offset + attrLen;
+        loadNode(&r, &newRefTypes, &newRefTypesSize);
+        if(r.res == UA_STATUSCODE_GOOD && r.offset != attrEnd)
+            r.res = UA_STATUSCODE_BADDECODINGERROR;
+        skipSection(&r);
+    }
+
+    /* Add the references. The ReferenceTypes and targets are all known now. */
+    if(r.res == UA_STATUSCODE_GOOD)
+        r.offset = nodesStart;
+    while(r.res == UA_STATUSCODE_GOOD && r.offset < snapshot->length)
+        loadReferences(&r);
+
+    /* Add the new ReferenceTypes to the subtype sets of their supertypes */
+    for(size_t i = 0; i < newRefTypesSize && r.res == UA_STATUSCODE_GOOD; i++) {
+        const UA_Node *refType = UA_NODESTORE_GET(server, &newRefTypes[i]);
+        if(!refType) {
+            r.res = UA_STATUSCODE_BADINTERNALERROR;
+            break;
+        }
+        r.res = setReferenceTypeSubtypes(server, &refType->referenceTypeNode);
+        UA_NODESTORE_RELEASE(server, refType);
+    }
+
+    /* The cached lookups may refer to replaced nodes */
+    UA_BrowseCache_clear(server);
+    UA_TypeHierarchy_clear(server);
+    invalidateAccessCache(server, NULL, NULL);
+
+    if(r.res != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Loading the snapshot failed with StatusCode %s "
+                     "at offset %lu", UA_StatusCode_name(r.res),
+                     (long unsigned)r.offset);
+
+    UA_UNLOCK(&server->serviceMutex);
+
+    UA_Array_delete(newRefTypes, newRefTypesSize, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_free(r.nsMap);
+    return r.res;
+}
@@ -332,6 +332,88 @@ UA_Server_processServiceOperations(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Server_streamServiceOperations(UA_Server *server, UA_Session *session,
+                                  UA_ResponseStream *stream,
+                                  UA_ResponseHeader *responseHeader,
+                                  UA_ServiceOperation operationCallback,
+                                  const void *context,
+                                  const size_t *requestOperations,
+                                  const UA_DataType *requestOperationsType,
+                                  const UA_DataType *responseOperationsType) {
+    size_t ops = *requestOperations;
+    if(ops == 0)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+
+    /* A single result is reused for all operations */
+    void *respOp = UA_new(responseOperationsType);
+    if(!respOp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_StatusCode res = UA_ResponseStream_begin(server, stream, responseHeader, ops);
+    /* No padding after size_t */
+    uintptr_t reqOp = *(uintptr_t*)((uintptr_t)requestOperations + sizeof(size_t));
+    for(size_t i = 0; i < ops && res == UA_STATUSCODE_GOOD; i++) {
+        operationCallback(server, session, context, (void*)reqOp, respOp);
+        res = UA_ResponseStream_emit(stream, respOp);
+        UA_clear(respOp, responseOperationsType);
+        reqOp += requestOperationsType->memSize;
+    }
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_ResponseStream_finish(stream);
+    UA_delete(respOp, responseOperationsType);
+    return res;
+}
+
+static UA_StatusCode
+refillRandomPool(UA_Server *server) {
+    /* Use the SecurityPolicy with the highest securityLevel. Picked for every
+     * refill as the policies can change at runtime. */
+    UA_SecurityPolicy *sp = NULL;
+    for(size_t i = 0; i < server->config.securityPoliciesSize; i++) {
+        UA_SecurityPolicy *cand = &server->config.securityPolicies[i];
+        if(!sp || cand->securityLevel > sp->securityLevel)
+            sp = cand;
+    }
+
+    if(sp) {
+        UA_ByteString buf = {UA_RANDOMPOOL_SIZE, server->randomPool};
+        UA_StatusCode res =
+            sp->symmetricModule.generateNonce(sp->policyContext, &buf);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    } else {
+        for(size_t i = 0; i + 3 < UA_RANDOMPOOL_SIZE; i += 4) {
+            UA_UInt32 r = UA_UInt32_random();
+            memcpy(&server->randomPool[i], &r, 4);
+        }
+    }
+    server->randomPoolPos = 0;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+getRandomBytes(UA_Server *server, UA_Byte *out, size_t len) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    while(len > 0) {
+        if(server->randomPoolPos >= UA_RANDOMPOOL_SIZE) {
+            UA_StatusCode res = refillRandomPool(server);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+        }
+        size_t n = UA_RANDOMPOOL_SIZE - server->randomPoolPos;
+        if(n > len)
+            n = len;
+        /* Consumed bytes are wiped from the pool */
+        memcpy(out, &server->randomPool[server->randomPoolPos], n);
+        memset(&server->randomPool[server->randomPoolPos], 0, n);
+        server->randomPoolPos += n;
+        out += n;
+        len -= n;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 /* A few global NodeId definitions */
 const UA_NodeId subtypeId = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASSUBTYPE}};
 const UA_NodeId hierarchicalReferences = {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HIERARCHICALREFERENCES}};
@@ -29,14 +29,18 @@ UA_NodeId unsafe_fuzz_authenticationToken = {0, UA_NODEIDTYPE_NUMERIC, {0}};
 #endif
 
 /* The counterOffset is the offset of the UA_ServiceCounterDataType for the
- * service in the UA_ SessionDiagnosticsDataType. */
+ * service in the UA_ SessionDiagnosticsDataType. The read-only services
+ * (_SHARED) require a session and can take the shared side of the lock. */
 #ifdef UA_ENABLE_DIAGNOSTICS
-# define UA_SERVICECOUNTER_OFFSET_NONE(requiresSession) 0, requiresSession
+# define UA_SERVICECOUNTER_OFFSET_NONE(requiresSession) 0, requiresSession, false
 # define UA_SERVICECOUNTER_OFFSET(X, requiresSession) \
-    offsetof(UA_SessionDiagnosticsDataType, X), requiresSession
+    offsetof(UA_SessionDiagnosticsDataType, X), requiresSession, false
+# define UA_SERVICECOUNTER_OFFSET_SHARED(X) \
+    offsetof(UA_SessionDiagnosticsDataType, X), true, true
 #else
-# define UA_SERVICECOUNTER_OFFSET_NONE(requiresSession) requiresSession
-# define UA_SERVICECOUNTER_OFFSET(X, requiresSession) requiresSession
+# define UA_SERVICECOUNTER_OFFSET_NONE(requiresSession) requiresSession, false
+# define UA_SERVICECOUNTER_OFFSET(X, requiresSession) requiresSession, false
+# define UA_SERVICECOUNTER_OFFSET_SHARED(X) true, true
 #endif
 
 UA_ServiceDescription serviceDescriptions[] = {
@@ -72,17 +76,25 @@ UA_ServiceDescription serviceDescriptions[] = {
      UA_SERVICECOUNTER_OFFSET_NONE(true), (UA_Service)Service_Cancel,
      &UA_TYPES[UA_TYPES_CANCELREQUEST], &UA_TYPES[UA_TYPES_CANCELRESPONSE]},
     {UA_NS0ID_READREQUEST_ENCODING_DEFAULTBINARY,
-     UA_SERVICECOUNTER_OFFSET(readCount, true), (UA_Service)Service_Read,
+     UA_SERVICECOUNTER_OFFSET_SHARED(readCount), (UA_Service)Service_Read,
      &UA_TYPES[UA_TYPES_READREQUEST], &UA_TYPES[UA_TYPES_READRESPONSE]},
     {UA_NS0ID_WRITEREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(writeCount, true), (UA_Service)Service_Write,
      &UA_TYPES[UA_TYPES_WRITEREQUEST], &UA_TYPES[UA_TYPES_WRITERESPONSE]},
     {UA_NS0ID_BROWSEREQUEST_ENCODING_DEFAULTBINARY,
-     UA_SERVICECOUNTER_OFFSET(browseCount, true), (UA_Service)Service_Browse,
+     UA_SERVICECOUNTER_OFFSET_SHARED(browseCount), (UA_Service)Service_Browse,
      &UA_TYPES[UA_TYPES_BROWSEREQUEST], &UA_TYPES[UA_TYPES_BROWSERESPONSE]},
     {UA_NS0ID_BROWSENEXTREQUEST_ENCODING_DEFAULTBINARY,
-     UA_SERVICECOUNTER_OFFSET(browseNextCount, true), (UA_Service)Service_BrowseNext,
+     UA_SERVICECOUNTER_OFFSET_SHARED(browseNextCount), (UA_Service)Service_BrowseNext,
      &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST], &UA_TYPES[UA_TYPES_BROWSENEXTRESPONSE]},
+#ifdef UA_ENABLE_QUERY
+    {UA_NS0ID_QUERYFIRSTREQUEST_ENCODING_DEFAULTBINARY,
+     UA_SERVICECOUNTER_OFFSET(queryFirstCount, true), (UA_Service)Service_QueryFirst,
+     &UA_TYPES[UA_TYPES_QUERYFIRSTREQUEST], &UA_TYPES[UA_TYPES_QUERYFIRSTRESPONSE]},
+    {UA_NS0ID_QUERYNEXTREQUEST_ENCODING_DEFAULTBINARY,
+     UA_SERVICECOUNTER_OFFSET(queryNextCount, true), (UA_Service)Service_QueryNext,
+     &UA_TYPES[UA_TYPES_QUERYNEXTREQUEST], &UA_TYPES[UA_TYPES_QUERYNEXTRESPONSE]},
+#endif
     {UA_NS0ID_REGISTERNODESREQUEST_ENCODING_DEFAULTBINARY,
      UA_SERVICECOUNTER_OFFSET(registerNodesCount, true), (UA_Service)Service_RegisterNodes,
      &UA_TYPES[UA_TYPES_REGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_REGISTERNODESRESPONSE]},
@@ -90,7 +102,7 @@ UA_ServiceDescription serviceDescriptions[] = {
      UA_SERVICECOUNTER_OFFSET(unregisterNodesCount, true), (UA_Service)Service_UnregisterNodes,
      &UA_TYPES[UA_TYPES_UNREGISTERNODESREQUEST], &UA_TYPES[UA_TYPES_UNREGISTERNODESRESPONSE]},
     {UA_NS0ID_TRANSLATEBROWSEPATHSTONODEIDSREQUEST_ENCODING_DEFAULTBINARY,
-     UA_SERVICECOUNTER_OFFSET(translateBrowsePathsToNodeIdsCount, true), (UA_Service)Service_TranslateBrowsePathsToNodeIds,
+     UA_SERVICECOUNTER_OFFSET_SHARED(translateBrowsePathsToNodeIdsCount), (UA_Service)Service_TranslateBrowsePathsToNodeIds,
      &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST], &UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSRESPONSE]},
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     {UA_NS0ID_CREATESUBSCRIPTIONREQUEST_ENCODING_DEFAULTBINARY,
@@ -160,6 +172,9 @@ UA_ServiceDescription serviceDescriptions[] = {
     {0, UA_SERVICECOUNTER_OFFSET_NONE(false), NULL, NULL, NULL}
 };
 
+const size_t serviceDescriptionsSize =
+    (sizeof(serviceDescriptions) / sizeof(UA_ServiceDescription)) - 1;
+
 UA_ServiceDescription *
 getServiceDescription(UA_UInt32 requestTypeId) {
     for(size_t i = 0; serviceDescriptions[i].requestTypeId > 0; i++) {
@@ -175,7 +190,8 @@ static const UA_String securityPolicyNone =
 static UA_Boolean
 processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session *session,
                        UA_UInt32 requestId, UA_ServiceDescription *sd,
-                       const UA_Request *request, UA_Response *response) {
+                       const UA_Request *request, UA_Response *response,
+                       UA_ResponseStream *stream) {
     UA_ResponseHeader *rh = &response->responseHeader;
 
     /* Check timestamp in the request header */
@@ -251,7 +267,7 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
     /* Update the session lifetime */
     UA_EventLoop *el = server->config.eventLoop;
     UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-    UA_DateTime now = el->dateTime_now(el);
+    UA_DateTime now = getCachedTime(server);
     UA_Session_updateLifetime(session, now, nowMonotonic);
 
     /* The publish request is not answered immediately */
@@ -260,6 +276,40 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
         rh->serviceResult = Service_Publish(server, session, &request->publishRequest, requestId);
         return (rh->serviceResult == UA_STATUSCODE_GOOD);
     }
+
+    /* The republished message is sent from the retransmission queue */
+    if(sd->requestType == &UA_TYPES[UA_TYPES_REPUBLISHREQUEST])
+        return Service_RepublishSend(server, session, &request->republishRequest,
+                                     &response->republishResponse, requestId);
+#endif
+
+    /* Admission control for the requests that can be answered asynchronously.
+     * Reject new requests early when the session or the server is
+     * overloaded. */
+#if UA_MULTITHREADING >= 100
+    if(sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST] ||
+       sd->requestType == &UA_TYPES[UA_TYPES_CALLREQUEST]) {
+        rh->serviceResult =
+            UA_AsyncManager_admitRequest(&server->asyncManager, server, session);
+        if(rh->serviceResult != UA_STATUSCODE_GOOD) {
+            UA_atomic_addUInt32(&server->serverDiagnosticsSummary.rejectedRequestsCount, 1);
+            UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                                 "Request rejected by the admission control "
+                                 "with StatusCode %s",
+                                 UA_StatusCode_name(rh->serviceResult));
+            return false;
+        }
+    }
+#endif
+
+    /* A read request with async DataSource reads is answered later */
+#if UA_MULTITHREADING >= 100
+    if(sd->requestType == &UA_TYPES[UA_TYPES_READREQUEST]) {
+        UA_Boolean finished = true;
+        Service_ReadAsync(server, session, requestId, &request->readRequest,
+                          &response->readResponse, &finished);
+        return !finished;
+    }
 #endif
 
     /* An async call request might not be answered immediately */
@@ -272,6 +322,26 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
     }
 #endif
 
+    /* Cached endpoints are sent in their binary encoding */
+    if(stream && sd->requestType == &UA_TYPES[UA_TYPES_GETENDPOINTSREQUEST]) {
+        Service_GetEndpointsStream(server, session, stream,
+                                   &request->getEndpointsRequest,
+                                   &response->getEndpointsResponse);
+        return stream->started;
+    }
+
+    /* Browse results are encoded into the response message one at a time */
+    if(stream && sd->requestType == &UA_TYPES[UA_TYPES_BROWSEREQUEST]) {
+        Service_BrowseStream(server, session, stream, &request->browseRequest,
+                             &response->browseResponse);
+        return stream->started;
+    }
+    if(stream && sd->requestType == &UA_TYPES[UA_TYPES_BROWSENEXTREQUEST]) {
+        Service_BrowseNextStream(server, session, stream, &request->browseNextRequest,
+                                 &response->browseNextResponse);
+        return stream->started;
+    }
+
     /* Execute the synchronous service call */
     sd->serviceCallback(server, session, request, response);
     return false;
@@ -280,7 +350,8 @@ processServiceInternal(UA_Server *server, UA_SecureChannel *channel, UA_Session
 UA_Boolean
 UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
                          UA_UInt32 requestId, UA_ServiceDescription *sd,
-                         const UA_Request *request, UA_Response *response) {
+                         const UA_Request *request, UA_Response *response,
+                         UA_ResponseStream *stream, UA_Session **outSession) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Set the authenticationToken from the create session request to help
@@ -298,6 +369,7 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
     UA_Session *session = NULL;
     response->responseHeader.serviceResult =
         getBoundSession(server, channel, &request->requestHeader.authenticationToken, &session);
+    *outSession = session;
     if(!session && sd->sessionRequired)
         return false;
 
@@ -306,7 +378,8 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
 
     /* Process the service */
     UA_Boolean async =
-        processServiceInternal(server, channel, session, requestId, sd, request, response);
+        processServiceInternal(server, channel, session, requestId, sd,
+                               request, response, stream);
 
     /* Update the service statistics */
 #ifdef UA_ENABLE_DIAGNOSTICS
@@ -326,3 +399,294 @@ UA_Server_processRequest(UA_Server *server, UA_SecureChannel *channel,
 
     return async;
 }
+
+/*****************/
+/* Bulk Requests */
+/*****************/
+
+/* Services with a large number of (independent) operations that can be
+ * processed in slices. The array of operations in the request and the results
+ * in the response both follow after their size field. */
+typedef struct {
+    const UA_DataType *requestType;
+    size_t opsSizeOffset;     /* Offset of the operations count in the request */
+    size_t resultsSizeOffset; /* Offset of the results count in the response */
+    const UA_DataType *opType;
+    const UA_DataType *resultType;
+    size_t limitOffset;       /* Offset of the operations limit in the config */
+} UA_BulkService;
+
+static const UA_BulkService bulkServices[] = {
+    {&UA_TYPES[UA_TYPES_BROWSEREQUEST],
+     offsetof(UA_BrowseRequest, nodesToBrowseSize),
+     offsetof(UA_BrowseResponse, resultsSize),
+     &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION], &UA_TYPES[UA_TYPES_BROWSERESULT],
+     offsetof(UA_ServerConfig, maxNodesPerBrowse)},
+    {&UA_TYPES[UA_TYPES_TRANSLATEBROWSEPATHSTONODEIDSREQUEST],
+     offsetof(UA_TranslateBrowsePathsToNodeIdsRequest, browsePathsSize),
+     offsetof(UA_TranslateBrowsePathsToNodeIdsResponse, resultsSize),
+     &UA_TYPES[UA_TYPES_BROWSEPATH], &UA_TYPES[UA_TYPES_BROWSEPATHRESULT],
+     offsetof(UA_ServerConfig, maxNodesPerTranslateBrowsePathsToNodeIds)},
+#ifdef UA_ENABLE_HISTORIZING
+    {&UA_TYPES[UA_TYPES_HISTORYREADREQUEST],
+     offsetof(UA_HistoryReadRequest, nodesToReadSize),
+     offsetof(UA_HistoryReadResponse, resultsSize),
+     &UA_TYPES[UA_TYPES_HISTORYREADVALUEID], &UA_TYPES[UA_TYPES_HISTORYREADRESULT],
+     offsetof(UA_ServerConfig, maxNodesPerRead)},
+#endif
+    {NULL, 0, 0, NULL, NULL, 0}
+};
+
+struct UA_BulkRequest {
+    TAILQ_ENTRY(UA_BulkRequest) pointers;
+    UA_NodeId sessionId;
+    UA_UInt32 requestId;
+    const UA_ServiceDescription *sd;
+    const UA_BulkService *bs;
+    size_t done; /* Number of processed operations */
+    UA_Request request;
+    UA_Response response;
+};
+
+static const UA_BulkService *
+getBulkService(UA_Server *server, const UA_ServiceDescription *sd,
+               const UA_Request *request) {
+    size_t sliceSize = server->config.bulkRequestSliceSize;
+    if(sliceSize == 0)
+        return NULL;
+    for(const UA_BulkService *bs = bulkServices; bs->requestType; bs++) {
+        if(bs->requestType != sd->requestType)
+            continue;
+        const size_t *opsSize = (const size_t*)
+            ((uintptr_t)request + bs->opsSizeOffset);
+        if(*opsSize <= sliceSize)
+            return NULL;
+        /* The operations limit applies to the entire request. Requests above
+         * the limit are not sliced. The service rejects them with
+         * BadTooManyOperations. */
+        const UA_UInt32 *limit = (const UA_UInt32*)
+            ((uintptr_t)&server->config + bs->limitOffset);
+        if(*limit != 0 && *opsSize > *limit)
+            return NULL;
+        return bs;
+    }
+    return NULL;
+}
+
+/* Process the operations [done, done + sliceSize) of the request into the
+ * preallocated results. Returns true if the request is finished (also if
+ * processing failed). */
+static UA_Boolean
+processBulkSlice(UA_Server *server, UA_Session *session, UA_BulkRequest *br) {
+    const UA_BulkService *bs = br->bs;
+    size_t *opsSize = (size_t*)((uintptr_t)&br->request + bs->opsSizeOffset);
+    void **ops = (void**)((uintptr_t)opsSize + sizeof(size_t));
+    size_t *resultsSize = (size_t*)((uintptr_t)&br->response + bs->resultsSizeOffset);
+    void **results = (void**)((uintptr_t)resultsSize + sizeof(size_t));
+
+    /* Shallow copy of the request with a window into the operations */
+    size_t count = *opsSize - br->done;
+    if(count > server->config.bulkRequestSliceSize)
+        count = server->config.bulkRequestSliceSize;
+    UA_Request slice = br->request;
+    size_t *sliceOpsSize = (size_t*)((uintptr_t)&slice + bs->opsSizeOffset);
+    void **sliceOps = (void**)((uintptr_t)sliceOpsSize + sizeof(size_t));
+    *sliceOpsSize = count;
+    *sliceOps = (void*)((uintptr_t)*ops + (br->done * bs->opType->memSize));
+
+    UA_Response sliceResponse;
+    UA_init(&sliceResponse, br->sd->responseType);
+    br->sd->serviceCallback(server, session, &slice, &sliceResponse);
+
+    /* Move the results into the response */
+    size_t *sliceResultsSize = (size_t*)
+        ((uintptr_t)&sliceResponse + bs->resultsSizeOffset);
+    void **sliceResults = (void**)((uintptr_t)sliceResultsSize + sizeof(size_t));
+    UA_StatusCode res = sliceResponse.responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && *sliceResultsSize != count)
+        res = UA_STATUSCODE_BADINTERNALERROR;
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_clear(&sliceResponse, br->sd->responseType);
+        UA_Array_delete(*results, *resultsSize, bs->resultType);
+        *results = NULL;
+        *resultsSize = 0;
+        br->response.responseHeader.serviceResult = res;
+        return true;
+    }
+    memcpy((void*)((uintptr_t)*results + (br->done * bs->resultType->memSize)),
+           *sliceResults, count * bs->resultType->memSize);
+    UA_free(*sliceResults);
+    *sliceResults = NULL;
+    *sliceResultsSize = 0;
+    UA_clear(&sliceResponse, br->sd->responseType);
+
+    br->done += count;
+    return (br->done == *opsSize);
+}
+
+static void
+deleteBulkRequest(UA_BulkRequest *br) {
+    UA_clear(&br->request, br->sd->requestType);
+    UA_clear(&br->response, br->sd->responseType);
+    UA_NodeId_clear(&br->sessionId);
+    UA_free(br);
+}
+
+/* Move the requests of the Session behind the requests of the other Sessions.
+ * The order within the Session is kept. */
+static void
+rotateBulkRequests(UA_Server *server, const UA_NodeId *sessionId) {
+    TAILQ_HEAD(, UA_BulkRequest) moved = TAILQ_HEAD_INITIALIZER(moved);
+    UA_BulkRequest *br, *br_tmp;
+    TAILQ_FOREACH_SAFE(br, &server->bulkRequests, pointers, br_tmp) {
+        if(!UA_NodeId_equal(&br->sessionId, sessionId))
+            continue;
+        TAILQ_REMOVE(&server->bulkRequests, br, pointers);
+        TAILQ_INSERT_TAIL(&moved, br, pointers);
+    }
+    while((br = TAILQ_FIRST(&moved))) {
+        TAILQ_REMOVE(&moved, br, pointers);
+        TAILQ_INSERT_TAIL(&server->bulkRequests, br, pointers);
+    }
+}
+
+/* Process the next slice of the first request. Returns whether more requests
+ * are pending. */
+static UA_Boolean
+processNextBulkSlice(UA_Server *server) {
+    UA_LOCK(&server->bulkRequestsLock);
+    UA_BulkRequest *br = TAILQ_FIRST(&server->bulkRequests);
+    UA_UNLOCK(&server->bulkRequestsLock);
+    if(!br)
+        return false;
+
+    /* The request is dropped if the Session was closed in the meantime. Only
+     * this callback removes requests from the queue. So br remains valid
+     * while the lock is released. */
+    UA_Session *session = getSessionById(server, &br->sessionId);
+    UA_Boolean done = true;
+    if(session && session->channel && session->activated) {
+        done = processBulkSlice(server, session, br);
+        if(done)
+            sendSessionResponse(server, session, br->requestId,
+                                &br->response, br->sd->responseType);
+    }
+
+    UA_LOCK(&server->bulkRequestsLock);
+    if(done) {
+        TAILQ_REMOVE(&server->bulkRequests, br, pointers);
+        deleteBulkRequest(br);
+    } else {
+        rotateBulkRequests(server, &br->sessionId);
+    }
+    UA_Boolean pending = !TAILQ_EMPTY(&server->bulkRequests);
+    UA_UNLOCK(&server->bulkRequestsLock);
+    return pending;
+}
+
+/* Delayed callback. Processes slices until the time budget is used up. Then
+ * the EventLoop handles the network in between. */
+static void
+processBulkRequests(void *application, void *context) {
+    UA_Server *server = (UA_Server*)application;
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_LOCK(&server->serviceMutex);
+    UA_DateTime deadline = el->dateTime_nowMonotonic(el) + (UA_DateTime)
+        (server->config.bulkRequestTimeSlice * UA_DATETIME_MSEC);
+    UA_Boolean pending;
+    do {
+        pending = processNextBulkSlice(server);
+    } while(pending && el->dateTime_nowMonotonic(el) < deadline);
+
+    /* Continue in the next iteration of the EventLoop */
+    UA_LOCK(&server->bulkRequestsLock);
+    if(!TAILQ_EMPTY(&server->bulkRequests))
+        el->addDelayedCallback(el, &server->bulkRequestsCallback);
+    else
+        server->bulkRequestsCallbackRegistered = false;
+    UA_UNLOCK(&server->bulkRequestsLock);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+UA_Boolean
+UA_Server_processBulkRequest(UA_Server *server, UA_SecureChannel *channel,
+                             UA_UInt32 requestId, UA_ServiceDescription *sd,
+                             UA_Request *request, UA_Response *response,
+                             UA_ResponseStream *stream, UA_Session **outSession) {
+    const UA_BulkService *bs = getBulkService(server, sd, request);
+    if(!bs)
+        return UA_Server_processRequest(server, channel, requestId, sd, request,
+                                        response, stream, outSession);
+
+    /* Process the first slice right away. This also checks the Session. The
+     * results are not streamed. */
+    size_t *opsSize = (size_t*)((uintptr_t)request + bs->opsSizeOffset);
+    size_t total = *opsSize;
+    *opsSize = server->config.bulkRequestSliceSize;
+    UA_Boolean async =
+        UA_Server_processRequest(server, channel, requestId, sd, request,
+                                 response, NULL, outSession);
+    *opsSize = total;
+    size_t *resultsSize = (size_t*)((uintptr_t)response + bs->resultsSizeOffset);
+    void **results = (void**)((uintptr_t)resultsSize + sizeof(size_t));
+    if(async || !*outSession ||
+       response->responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+       *resultsSize != server->config.bulkRequestSliceSize)
+        return async;
+
+    /* Move the request and the response into the queue. The results array is
+     * allocated for all operations. */
+    UA_BulkRequest *br = (UA_BulkRequest*)UA_calloc(1, sizeof(UA_BulkRequest));
+    void *allResults = UA_Array_new(total, bs->resultType);
+    if(!br || !allResults ||
+       UA_NodeId_copy(&(*outSession)->sessionId, &br->sessionId) != UA_STATUSCODE_GOOD) {
+        UA_free(br);
+        UA_free(allResults);
+        UA_clear(response, sd->responseType);
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return false;
+    }
+    memcpy(allResults, *results, *resultsSize * bs->resultType->memSize);
+    UA_free(*results);
+    *results = allResults;
+    *resultsSize = total;
+
+    br->requestId = requestId;
+    br->sd = sd;
+    br->bs = bs;
+    br->done = server->config.bulkRequestSliceSize;
+    br->request = *request;
+    br->response = *response;
+    UA_init(request, sd->requestType);
+    UA_init(response, sd->responseType);
+
+    /* The queue is processed in a delayed callback of the main EventLoop */
+    UA_LOCK(&server->bulkRequestsLock);
+    TAILQ_INSERT_TAIL(&server->bulkRequests, br, pointers);
+    if(!server->bulkRequestsCallbackRegistered) {
+        server->bulkRequestsCallbackRegistered = true;
+        server->bulkRequestsCallback.callback = processBulkRequests;
+        server->bulkRequestsCallback.application = server;
+        server->bulkRequestsCallback.context = NULL;
+        UA_EventLoop *el = server->config.eventLoop;
+        el->addDelayedCallback(el, &server->bulkRequestsCallback);
+    }
+    UA_UNLOCK(&server->bulkRequestsLock);
+    return true;
+}
+
+void
+UA_Server_clearBulkRequests(UA_Server *server) {
+    UA_LOCK(&server->bulkRequestsLock);
+    if(server->bulkRequestsCallbackRegistered) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->removeDelayedCallback(el, &server->bulkRequestsCallback);
+        server->bulkRequestsCallbackRegistered = false;
+    }
+    UA_BulkRequest *br, *br_tmp;
+    TAILQ_FOREACH_SAFE(br, &server->bulkRequests, pointers, br_tmp) {
+        TAILQ_REMOVE(&server->bulkRequests, br, pointers);
+        deleteBulkRequest(br);
+    }
+    UA_UNLOCK(&server->bulkRequestsLock);
+}
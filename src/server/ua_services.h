@@ -32,6 +32,7 @@ typedef struct {
     UA_UInt16 counterOffset;
 #endif
     UA_Boolean sessionRequired;
+    UA_Boolean shared; /* Read-only, can take the shared side of the lock */
     UA_Service serviceCallback;
     const UA_DataType *requestType;
     const UA_DataType *responseType;
@@ -40,6 +41,53 @@ typedef struct {
 /* Returns NULL if none found */
 UA_ServiceDescription * getServiceDescription(UA_UInt32 requestTypeId);
 
+/* Terminated by an entry with requestTypeId zero */
+extern UA_ServiceDescription serviceDescriptions[];
+extern const size_t serviceDescriptionsSize;
+
+/* Streaming responses. The results are encoded one by one into the response
+ * message and the chunks are sent out as soon as they are full. So the memory
+ * use is bounded by one result instead of the entire results array. This
+ * applies to responses with the layout (ResponseHeader, results array,
+ * DiagnosticInfo array). DiagnosticInfos are not streamed.
+ *
+ * If the encoding fails before the first chunk was sent, the stream is reset
+ * and a ServiceFault can be sent instead. Afterwards the message is aborted
+ * with an abort chunk. */
+typedef struct {
+    UA_SecureChannel *channel;
+    UA_UInt32 requestId;
+    const UA_DataType *responseType;
+    UA_MessageContext mc;
+    size_t resultsSize;
+    size_t resultsDone;
+    UA_Boolean started;  /* The stream is responsible for the response */
+    UA_StatusCode status;
+    size_t encodedSize;
+} UA_ResponseStream;
+
+void
+UA_ResponseStream_init(UA_ResponseStream *rs, UA_SecureChannel *channel,
+                       UA_UInt32 requestId, const UA_DataType *responseType);
+
+/* Encodes the ResponseHeader and the length of the results array */
+UA_StatusCode
+UA_ResponseStream_begin(UA_Server *server, UA_ResponseStream *rs,
+                        UA_ResponseHeader *rh, size_t resultsSize);
+
+UA_StatusCode
+UA_ResponseStream_emit(UA_ResponseStream *rs, const void *result);
+
+/* Sends the final chunk. All announced results must have been emitted. */
+UA_StatusCode
+UA_ResponseStream_finish(UA_ResponseStream *rs);
+
+/* Sends the complete response. The body after the ResponseHeader is already
+ * in the binary encoding (e.g. from a cache). */
+UA_StatusCode
+UA_ResponseStream_sendEncoded(UA_Server *server, UA_ResponseStream *rs,
+                              UA_ResponseHeader *rh, const UA_ByteString *body);
+
 /** Discovery Service Set **/
 void Service_FindServers(UA_Server *server, UA_Session *session,
                          const UA_FindServersRequest *request,
@@ -49,6 +97,12 @@ void Service_GetEndpoints(UA_Server *server, UA_Session *session,
                           const UA_GetEndpointsRequest *request,
                           UA_GetEndpointsResponse *response);
 
+/* Sends the endpoints from the cache (if enabled) in their binary encoding */
+void Service_GetEndpointsStream(UA_Server *server, UA_Session *session,
+                                UA_ResponseStream *stream,
+                                const UA_GetEndpointsRequest *request,
+                                UA_GetEndpointsResponse *response);
+
 #ifdef UA_ENABLE_DISCOVERY
 
 void Service_RegisterServer(UA_Server *server, UA_Session *session,
@@ -119,6 +173,17 @@ void Service_BrowseNext(UA_Server *server, UA_Session *session,
                         const UA_BrowseNextRequest *request,
                         UA_BrowseNextResponse *response);
 
+/* Streaming variants. The BrowseResults are sent as they are produced. */
+void Service_BrowseStream(UA_Server *server, UA_Session *session,
+                          UA_ResponseStream *stream,
+                          const UA_BrowseRequest *request,
+                          UA_BrowseResponse *response);
+
+void Service_BrowseNextStream(UA_Server *server, UA_Session *session,
+                              UA_ResponseStream *stream,
+                              const UA_BrowseNextRequest *request,
+                              UA_BrowseNextResponse *response);
+
 void Service_TranslateBrowsePathsToNodeIds(UA_Server *server, UA_Session *session,
              const UA_TranslateBrowsePathsToNodeIdsRequest *request,
              UA_TranslateBrowsePathsToNodeIdsResponse *response);
@@ -131,13 +196,29 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
                              const UA_UnregisterNodesRequest *request,
                              UA_UnregisterNodesResponse *response);
 
-/** Query Service Set (not implemented) **/
+/** Query Service Set **/
+#ifdef UA_ENABLE_QUERY
+void Service_QueryFirst(UA_Server *server, UA_Session *session,
+                        const UA_QueryFirstRequest *request,
+                        UA_QueryFirstResponse *response);
+
+void Service_QueryNext(UA_Server *server, UA_Session *session,
+                       const UA_QueryNextRequest *request,
+                       UA_QueryNextResponse *response);
+#endif
 
 /** Attribute Service Set **/
 void Service_Read(UA_Server *server, UA_Session *session,
                   const UA_ReadRequest *request,
                   UA_ReadResponse *response);
 
+#if UA_MULTITHREADING >= 100
+/* Async DataSource reads can defer the response */
+void Service_ReadAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                       const UA_ReadRequest *request, UA_ReadResponse *response,
+                       UA_Boolean *finished);
+#endif
+
 void Service_Write(UA_Server *server, UA_Session *session,
                    const UA_WriteRequest *request,
                    UA_WriteResponse *response);
@@ -210,6 +291,14 @@ void Service_Republish(UA_Server *server, UA_Session *session,
                        const UA_RepublishRequest *request,
                        UA_RepublishResponse *response);
 
+/* Sends the RepublishResponse with the message from the retransmission queue
+ * without copying it. Returns true if the response was sent. Otherwise the
+ * error is set in the response. */
+UA_Boolean
+Service_RepublishSend(UA_Server *server, UA_Session *session,
+                      const UA_RepublishRequest *request,
+                      UA_RepublishResponse *response, UA_UInt32 requestId);
+
 void Service_DeleteSubscriptions(UA_Server *server, UA_Session *session,
                                  const UA_DeleteSubscriptionsRequest *request,
                                  UA_DeleteSubscriptionsResponse *response);
@@ -72,24 +72,33 @@ attributeId2AttributeMask(UA_AttributeId id) {
  * where the underlying Subscription was detached during CloseSession. */
 
 static UA_UInt32
-getUserWriteMask(UA_Server *server, const UA_Session *session,
+getUserWriteMask(UA_Server *server, UA_Session *session,
                  const UA_NodeHead *head) {
     if(session == &server->adminSession)
         return 0xFFFFFFFF; /* the local admin user has all rights */
-    UA_UInt32 mask = head->writeMask;
+    UA_UInt32 generation = 0;
+    UA_AccessCacheEntry *ce =
+        getCachedAccess(server, session, &head->nodeId,
+                        UA_ACCESSCACHE_RIGHTSMASK, &generation);
+    if(ce)
+        return head->writeMask & ce->rightsMask;
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_UNLOCK(&server->serviceMutex);
-    mask &= server->config.accessControl.
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
+    UA_UInt32 rights = server->config.accessControl.
         getUserRightsMask(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->context : NULL,
                           &head->nodeId, head->context);
-    UA_LOCK(&server->serviceMutex);
-    return mask;
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
+    ce = cacheAccess(server, session, &head->nodeId,
+                     UA_ACCESSCACHE_RIGHTSMASK, generation);
+    if(ce)
+        ce->rightsMask = rights;
+    return head->writeMask & rights;
 }
 
 static UA_Byte
-getAccessLevel(UA_Server *server, const UA_Session *session,
+getAccessLevel(UA_Server *server, UA_Session *session,
                const UA_VariableNode *node) {
     if(session == &server->adminSession)
         return 0xFF; /* the local admin user has all rights */
@@ -97,38 +106,55 @@ getAccessLevel(UA_Server *server, const UA_Session *session,
 }
 
 static UA_Byte
-getUserAccessLevel(UA_Server *server, const UA_Session *session,
+getUserAccessLevel(UA_Server *server, UA_Session *session,
                    const UA_VariableNode *node) {
     if(session == &server->adminSession)
         return 0xFF; /* the local admin user has all rights */
-    UA_Byte retval = node->accessLevel;
+    UA_UInt32 generation = 0;
+    UA_AccessCacheEntry *ce =
+        getCachedAccess(server, session, &node->head.nodeId,
+                        UA_ACCESSCACHE_ACCESSLEVEL, &generation);
+    if(ce)
+        return node->accessLevel & ce->accessLevel;
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_UNLOCK(&server->serviceMutex);
-    retval &= server->config.accessControl.
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
+    UA_Byte userAccessLevel = server->config.accessControl.
         getUserAccessLevel(server, &server->config.accessControl,
                            session ? &session->sessionId : NULL,
                            session ? session->context : NULL,
                            &node->head.nodeId, node->head.context);
-    UA_LOCK(&server->serviceMutex);
-    return retval;
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
+    ce = cacheAccess(server, session, &node->head.nodeId,
+                     UA_ACCESSCACHE_ACCESSLEVEL, generation);
+    if(ce)
+        ce->accessLevel = userAccessLevel;
+    return node->accessLevel & userAccessLevel;
 }
 
 static UA_Boolean
-getUserExecutable(UA_Server *server, const UA_Session *session,
+getUserExecutable(UA_Server *server, UA_Session *session,
                   const UA_MethodNode *node) {
     if(session == &server->adminSession)
         return true; /* the local admin user has all rights */
+    UA_UInt32 generation = 0;
+    UA_AccessCacheEntry *ce =
+        getCachedAccess(server, session, &node->head.nodeId,
+                        UA_ACCESSCACHE_EXECUTABLE, &generation);
+    if(ce)
+        return node->executable && ce->executable;
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_UNLOCK(&server->serviceMutex);
-    UA_Boolean userExecutable = node->executable;
-    userExecutable &=
-        server->config.accessControl.
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
+    UA_Boolean userExecutable = server->config.accessControl.
         getUserExecutable(server, &server->config.accessControl,
                           session ? &session->sessionId : NULL,
                           session ? session->context : NULL,
                           &node->head.nodeId, node->head.context);
-    UA_LOCK(&server->serviceMutex);
-    return userExecutable;
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
+    ce = cacheAccess(server, session, &node->head.nodeId,
+                     UA_ACCESSCACHE_EXECUTABLE, generation);
+    if(ce)
+        ce->executable = userExecutable;
+    return node->executable && userExecutable;
 }
 
 /****************/
@@ -165,13 +191,13 @@ readValueAttributeFromNode(UA_Server *server, UA_Session *session,
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
     /* Update the value by the user callback */
     if(vn->value.data.callback.onRead) {
-        UA_UNLOCK(&server->serviceMutex);
+        UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
         vn->value.data.callback.onRead(server,
                                        session ? &session->sessionId : NULL,
                                        session ? session->context : NULL,
                                        &vn->head.nodeId, vn->head.context, rangeptr,
                                        &vn->value.data.value);
-        UA_LOCK(&server->serviceMutex);
+        UA_LOCK_RESUME(&server->serviceMutex, shared);
         vn = (const UA_VariableNode*)
             UA_NODESTORE_GET_SELECTIVE(server, &vn->head.nodeId,
                                        UA_NODEATTRIBUTESMASK_VALUE,
@@ -197,40 +223,257 @@ readValueAttributeFromNode(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+/**************************/
+/* DataSource Value Cache */
+/**************************/
+
+/* A DataSource read can be expensive (e.g. a fieldbus access). Variables with
+ * a cache keep the last value from the DataSource. Reads with a maxAge and the
+ * sampling of MonitoredItems take the cached value if it is recent enough. */
+
+static enum ZIP_CMP
+cmpDataSourceCacheEntry(const void *a, const void *b) {
+    const UA_DataSourceCacheEntry *aa = (const UA_DataSourceCacheEntry*)a;
+    const UA_DataSourceCacheEntry *bb = (const UA_DataSourceCacheEntry*)b;
+    if(aa->hash != bb->hash)
+        return (aa->hash < bb->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->nodeId, &bb->nodeId);
+}
+
+ZIP_FUNCTIONS(UA_DataSourceCacheTree, UA_DataSourceCacheEntry, treeEntry,
+              UA_DataSourceCacheEntry, treeEntry, cmpDataSourceCacheEntry)
+
+static UA_DataSourceCacheEntry *
+findDataSourceCache(UA_Server *server, const UA_NodeId *nodeId) {
+    if(server->dataSourceCacheSize == 0)
+        return NULL;
+    UA_DataSourceCacheEntry key;
+    key.hash = UA_NodeId_hash(nodeId);
+    key.nodeId = *nodeId;
+    return ZIP_FIND(UA_DataSourceCacheTree, &server->dataSourceCache, &key);
+}
+
+static void
+UA_DataSourceCacheEntry_delete(UA_DataSourceCacheEntry *e) {
+    UA_DataValue_clear(&e->value);
+    UA_NodeId_clear(&e->nodeId);
+    UA_free(e);
+}
+
+static void *
+deleteDataSourceCacheEntry(void *context, UA_DataSourceCacheEntry *e) {
+    UA_DataSourceCacheEntry_delete(e);
+    return NULL;
+}
+
+void
+UA_DataSourceCache_clear(UA_Server *server) {
+    ZIP_ITER(UA_DataSourceCacheTree, &server->dataSourceCache,
+             deleteDataSourceCacheEntry, NULL);
+    ZIP_INIT(&server->dataSourceCache);
+    server->dataSourceCacheSize = 0;
+}
+
+void
+invalidateDataSourceCache(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_DataSourceCacheEntry *e = findDataSourceCache(server, nodeId);
+    if(!e)
+        return;
+    UA_LOCK(&server->dataSourceCacheLock);
+    e->generation++;
+    e->cacheTime = 0;
+    UA_DataValue_clear(&e->value);
+    UA_UNLOCK(&server->dataSourceCacheLock);
+}
+
+void
+removeDataSourceCache(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_DataSourceCacheEntry *e = findDataSourceCache(server, nodeId);
+    if(!e)
+        return;
+    ZIP_REMOVE(UA_DataSourceCacheTree, &server->dataSourceCache, e);
+    server->dataSourceCacheSize--;
+    UA_DataSourceCacheEntry_delete(e);
+}
+
+static UA_StatusCode
+addDataSourceCache(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(findDataSourceCache(server, nodeId))
+        return UA_STATUSCODE_GOOD;
+    UA_DataSourceCacheEntry *e = (UA_DataSourceCacheEntry*)
+        UA_calloc(1, sizeof(UA_DataSourceCacheEntry));
+    if(!e)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &e->nodeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_free(e);
+        return res;
+    }
+    e->hash = UA_NodeId_hash(nodeId);
+    ZIP_INSERT(UA_DataSourceCacheTree, &server->dataSourceCache, e);
+    server->dataSourceCacheSize++;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_setVariableNode_dataSourceCache(UA_Server *server, const UA_NodeId nodeId,
+                                          UA_Boolean enabled) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(enabled) {
+        const UA_Node *node = UA_NODESTORE_GET(server, &nodeId);
+        if(!node) {
+            res = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        } else {
+            if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+                res = UA_STATUSCODE_BADNODECLASSINVALID;
+            UA_NODESTORE_RELEASE(server, node);
+        }
+        if(res == UA_STATUSCODE_GOOD)
+            res = addDataSourceCache(server, &nodeId);
+    } else {
+        removeDataSourceCache(server, &nodeId);
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+/* Copy the cached value if it is not older than maxAge (in ms). A maxAge of
+ * Int32 max or more accepts any cached value (Part 4, 5.10.2). */
+static UA_Boolean
+readDataSourceCache(UA_Server *server, UA_DataSourceCacheEntry *e,
+                    UA_DateTime now, UA_Double maxAge,
+                    const UA_NumericRange *rangeptr, UA_DataValue *v) {
+    UA_Boolean hit = false;
+    UA_LOCK(&server->dataSourceCacheLock);
+    if(e->cacheTime != 0 &&
+       (maxAge >= (UA_Double)UA_INT32_MAX ||
+        (UA_Double)(now - e->cacheTime) <= maxAge * (UA_Double)UA_DATETIME_MSEC)) {
+        UA_StatusCode res;
+        if(!rangeptr) {
+            res = UA_DataValue_copy(&e->value, v);
+        } else {
+            *v = e->value; /* Copy timestamps */
+            UA_Variant_init(&v->value);
+            res = UA_Variant_copyRange(&e->value.value, &v->value, *rangeptr);
+        }
+        if(res == UA_STATUSCODE_GOOD) {
+            server->counterStatistics.dataSourceCacheHitCount++;
+            hit = true;
+        } else {
+            UA_DataValue_clear(v);
+        }
+    }
+    if(!hit)
+        server->counterStatistics.dataSourceCacheMissCount++;
+    UA_UNLOCK(&server->dataSourceCacheLock);
+    return hit;
+}
+
+/* Keep the value unless the cache was invalidated during the read */
+static void
+updateDataSourceCache(UA_Server *server, const UA_NodeId *nodeId,
+                      UA_UInt32 generation, UA_DateTime readTime,
+                      const UA_DataValue *v) {
+    if(!v->hasValue || (v->hasStatus && UA_StatusCode_isBad(v->status)))
+        return;
+    /* The entry might have been removed while the service lock was
+     * suspended for the DataSource. Look it up again. */
+    UA_DataSourceCacheEntry *e = findDataSourceCache(server, nodeId);
+    if(!e)
+        return;
+    UA_LOCK(&server->dataSourceCacheLock);
+    if(e->generation == generation && readTime > e->cacheTime) {
+        UA_DataValue tmp;
+        if(UA_DataValue_copy(v, &tmp) == UA_STATUSCODE_GOOD) {
+            UA_DataValue_clear(&e->value);
+            e->value = tmp;
+            e->cacheTime = readTime;
+        }
+    }
+    UA_UNLOCK(&server->dataSourceCacheLock);
+}
+
 static UA_StatusCode
 readValueAttributeFromDataSource(UA_Server *server, UA_Session *session,
                                  const UA_VariableNode *vn, UA_DataValue *v,
                                  UA_TimestampsToReturn timestamps,
-                                 UA_NumericRange *rangeptr) {
+                                 UA_NumericRange *rangeptr, UA_Double maxAge) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
     if(!vn->value.dataSource.read)
         return UA_STATUSCODE_BADINTERNALERROR;
     UA_Boolean sourceTimeStamp = (timestamps == UA_TIMESTAMPSTORETURN_SOURCE ||
                                   timestamps == UA_TIMESTAMPSTORETURN_BOTH);
-    UA_DataValue v2;
-    UA_DataValue_init(&v2);
-    UA_UNLOCK(&server->serviceMutex);
+    /* Read directly into the result. The async reads find their slot in the
+     * ReadResponse from the address. */
+    UA_DataValue_init(v);
+
+    /* Take the value from the cache. Only full values are put into the
+     * cache. */
+    UA_UInt32 generation = 0;
+    UA_DateTime readTime = 0;
+    UA_DataSourceCacheEntry *e = findDataSourceCache(server, &vn->head.nodeId);
+    if(e) {
+        UA_EventLoop *el = server->config.eventLoop;
+        readTime = el->dateTime_nowMonotonic(el);
+        if(maxAge > 0.0 &&
+           readDataSourceCache(server, e, readTime, maxAge, rangeptr, v))
+            return UA_STATUSCODE_GOOD;
+        UA_LOCK(&server->dataSourceCacheLock);
+        generation = e->generation;
+        UA_UNLOCK(&server->dataSourceCacheLock);
+        if(!rangeptr)
+            sourceTimeStamp = true;
+    }
+
+#if UA_MULTITHREADING >= 100
+    /* Register the async operation before the DataSource is called. Then the
+     * DataSource can complete it right away from a different thread. */
+    UA_AsyncOperation *ao = NULL;
+    UA_StatusCode asyncRes = UA_STATUSCODE_GOOD;
+    if(session && session->asyncRead)
+        asyncRes = UA_AsyncManager_beginAsyncRead(&server->asyncManager, server,
+                                                  session, v, &ao);
+#endif
+
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
     UA_StatusCode retval = vn->value.dataSource.
         read(server,
              session ? &session->sessionId : NULL,
              session ? session->context : NULL,
              &vn->head.nodeId, vn->head.context,
-             sourceTimeStamp, rangeptr, &v2);
-    UA_LOCK(&server->serviceMutex);
-    if(v2.hasValue && v2.value.storageType == UA_VARIANT_DATA_NODELETE) {
+             sourceTimeStamp, rangeptr, v);
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
+
+#if UA_MULTITHREADING >= 100
+    UA_Boolean pending = (retval == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY ||
+                          (!v->hasValue && v->hasStatus &&
+                           v->status == UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY));
+    if(ao) {
+        UA_AsyncManager_endAsyncRead(&server->asyncManager, server, ao, pending);
+    } else if(pending && asyncRes != UA_STATUSCODE_GOOD) {
+        /* The operation could not be registered */
+        UA_DataValue_clear(v);
+        retval = asyncRes;
+    }
+#endif
+    if(v->hasValue && v->value.storageType == UA_VARIANT_DATA_NODELETE) {
+        UA_DataValue v2 = *v;
         retval = UA_DataValue_copy(&v2, v);
-        UA_DataValue_clear(&v2);
-    } else {
-        *v = v2;
     }
+    if(e && !rangeptr && retval == UA_STATUSCODE_GOOD)
+        updateDataSourceCache(server, &vn->head.nodeId, generation, readTime, v);
     return retval;
 }
 
 static UA_StatusCode
 readValueAttributeComplete(UA_Server *server, UA_Session *session,
                            const UA_VariableNode *vn, UA_TimestampsToReturn timestamps,
-                           const UA_String *indexRange, UA_DataValue *v) {
-    UA_EventLoop *el = server->config.eventLoop;
+                           UA_Double maxAge, const UA_String *indexRange,
+                           UA_DataValue *v) {
 
     /* Compute the index range */
     UA_NumericRange range;
@@ -250,7 +493,7 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
             break;
         case UA_VALUEBACKENDTYPE_DATA_SOURCE_CALLBACK:
             retval = readValueAttributeFromDataSource(server, session, vn, v,
-                                                      timestamps, rangeptr);
+                                                      timestamps, rangeptr, maxAge);
             //TODO change old structure to value backend
             break;
         case UA_VALUEBACKENDTYPE_EXTERNAL:
@@ -279,7 +522,7 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
                 retval = readValueAttributeFromNode(server, session, vn, v, rangeptr);
             else
                 retval = readValueAttributeFromDataSource(server, session, vn, v,
-                                                          timestamps, rangeptr);
+                                                          timestamps, rangeptr, maxAge);
             /* end lagacy */
             break;
     }
@@ -287,7 +530,7 @@ readValueAttributeComplete(UA_Server *server, UA_Session *session,
     /* If not defined return a source timestamp of "now".
      * Static nodes always have the current time as source-time. */
     if(!v->hasSourceTimestamp) {
-        v->sourceTimestamp = el->dateTime_now(el);
+        v->sourceTimestamp = getCachedTime(server);
         v->hasSourceTimestamp = true;
     }
 
@@ -301,7 +544,7 @@ UA_StatusCode
 readValueAttribute(UA_Server *server, UA_Session *session,
                    const UA_VariableNode *vn, UA_DataValue *v) {
     return readValueAttributeComplete(server, session, vn,
-                                      UA_TIMESTAMPSTORETURN_NEITHER, NULL, v);
+                                      UA_TIMESTAMPSTORETURN_NEITHER, 0.0, NULL, v);
 }
 
 static const UA_String binEncoding = {sizeof("Default Binary")-1, (UA_Byte*)"Default Binary"};
@@ -380,13 +623,31 @@ getStructureDefinition(const UA_DataType *type, UA_StructureDefinition *def) {
 }
 #endif
 
+UA_StatusCode
+checkReadValueAccess(UA_Server *server, UA_Session *session, const UA_Node *node) {
+    /* VariableTypes don't have the AccessLevel concept. Always allow reading
+     * the value. */
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return UA_STATUSCODE_GOOD;
+
+    /* The access to a value variable is granted via the AccessLevel and
+     * UserAccessLevel attributes */
+    UA_Byte accessLevel = getAccessLevel(server, session, &node->variableNode);
+    if(!(accessLevel & (UA_ACCESSLEVELMASK_READ)))
+        return UA_STATUSCODE_BADNOTREADABLE;
+    accessLevel = getUserAccessLevel(server, session, &node->variableNode);
+    if(!(accessLevel & (UA_ACCESSLEVELMASK_READ)))
+        return UA_STATUSCODE_BADUSERACCESSDENIED;
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Returns a datavalue that may point into the node via the
  * UA_VARIANT_DATA_NODELETE tag. Don't access the returned DataValue once the
  * node has been released! */
 void
-ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
-             UA_TimestampsToReturn timestampsToReturn,
-             const UA_ReadValueId *id, UA_DataValue *v) {
+ReadWithNodeMaxAge(const UA_Node *node, UA_Server *server, UA_Session *session,
+                   UA_TimestampsToReturn timestampsToReturn, UA_Double maxAge,
+                   const UA_ReadValueId *id, UA_DataValue *v) {
     UA_Byte userAccessLevel;
     UA_UInt32 accessLevelEx; 
     UA_Byte accessLevel;
@@ -486,24 +747,12 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
         break;
     case UA_ATTRIBUTEID_VALUE: {
         CHECK_NODECLASS(UA_NODECLASS_VARIABLE | UA_NODECLASS_VARIABLETYPE);
-        /* VariableTypes don't have the AccessLevel concept. Always allow
-         * reading the value. */
-        if(node->head.nodeClass == UA_NODECLASS_VARIABLE) {
-            /* The access to a value variable is granted via the AccessLevel
-             * and UserAccessLevel attributes */
-            accessLevel = getAccessLevel(server, session, &node->variableNode);
-            if(!(accessLevel & (UA_ACCESSLEVELMASK_READ))) {
-                retval = UA_STATUSCODE_BADNOTREADABLE;
-                break;
-            }
-            accessLevel = getUserAccessLevel(server, session, &node->variableNode);
-            if(!(accessLevel & (UA_ACCESSLEVELMASK_READ))) {
-                retval = UA_STATUSCODE_BADUSERACCESSDENIED;
-                break;
-            }
-        }
+        retval = checkReadValueAccess(server, session, node);
+        if(retval != UA_STATUSCODE_GOOD)
+            break;
         retval = readValueAttributeComplete(server, session, &node->variableNode,
-                                            timestampsToReturn, &id->indexRange, v);
+                                            timestampsToReturn, maxAge,
+                                            &id->indexRange, v);
         break;
     }
     case UA_ATTRIBUTEID_DATATYPE:
@@ -612,11 +861,23 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
         v->status = retval;
     }
 
+    setReadTimestamps(server, timestampsToReturn, v);
+}
+
+void
+ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
+             UA_TimestampsToReturn timestampsToReturn,
+             const UA_ReadValueId *id, UA_DataValue *v) {
+    ReadWithNodeMaxAge(node, server, session, timestampsToReturn, 0.0, id, v);
+}
+
+void
+setReadTimestamps(UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+                  UA_DataValue *v) {
     /* Always use the current time as the server-timestamp */
     if(timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER ||
        timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH) {
-        UA_EventLoop *el = server->config.eventLoop;
-        v->serverTimestamp = el->dateTime_now(el);
+        v->serverTimestamp = getCachedTime(server);
         v->hasServerTimestamp = true;
         v->hasServerPicoseconds = false;
     } else {
@@ -632,15 +893,30 @@ ReadWithNode(const UA_Node *node, UA_Server *server, UA_Session *session,
     }
 }
 
-void
-Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *ttr,
-               const UA_ReadValueId *rvi, UA_DataValue *dv) {
-    /* Get the node (with only the selected attribute if the NodeStore supports that) */
+/* Get the node (with only the selected attributes if the NodeStore supports
+ * that). For the alias NodeIds of registered nodes, the node is held by the
+ * Session and must not be released. */
+static const UA_Node *
+getNodeForRead(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+               UA_UInt32 attributeMask, UA_Boolean *registered) {
+    UA_RegisteredNode *rn = (session) ?
+        UA_Session_getRegisteredNode(session, nodeId) : NULL;
+    *registered = (rn != NULL);
+    if(rn)
+        return UA_Session_resolveRegisteredNode(server, rn);
+    return UA_NODESTORE_GET_SELECTIVE(server, nodeId, attributeMask,
+                                      UA_REFERENCETYPESET_NONE,
+                                      UA_BROWSEDIRECTION_INVALID);
+}
+
+static void
+readOperation(UA_Server *server, UA_Session *session, UA_TimestampsToReturn ttr,
+              UA_Double maxAge, const UA_ReadValueId *rvi, UA_DataValue *dv) {
+    UA_Boolean registered;
     const UA_Node *node =
-        UA_NODESTORE_GET_SELECTIVE(server, &rvi->nodeId,
-                                   attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
-                                   UA_REFERENCETYPESET_NONE,
-                                   UA_BROWSEDIRECTION_INVALID);
+        getNodeForRead(server, session, &rvi->nodeId,
+                       attributeId2AttributeMask((UA_AttributeId)rvi->attributeId),
+                       &registered);
     if(!node) {
         dv->hasStatus = true;
         dv->status = UA_STATUSCODE_BADNODEIDUNKNOWN;
@@ -648,8 +924,231 @@ Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *tt
     }
 
     /* Perform the read operation */
-    ReadWithNode(node, server, session, *ttr, rvi, dv);
-    UA_NODESTORE_RELEASE(server, node);
+    ReadWithNodeMaxAge(node, server, session, ttr, maxAge, rvi, dv);
+    if(!registered)
+        UA_NODESTORE_RELEASE(server, node);
+}
+
+void
+Operation_Read(UA_Server *server, UA_Session *session, UA_TimestampsToReturn *ttr,
+               const UA_ReadValueId *rvi, UA_DataValue *dv) {
+    readOperation(server, session, *ttr, 0.0, rvi, dv);
+}
+
+/* The ReadRequest is the context. So the maxAge is taken into account. */
+static void
+Operation_ReadMaxAge(UA_Server *server, UA_Session *session,
+                     const UA_ReadRequest *request,
+                     const UA_ReadValueId *rvi, UA_DataValue *dv) {
+    readOperation(server, session, request->timestampsToReturn,
+                  request->maxAge, rvi, dv);
+}
+
+/* Batch path for ReadRequests that target only the Value attribute (the
+ * typical polling of many tags). All nodes are resolved first. The user access
+ * levels are then checked in a single unlocked section. Pointer-free scalar
+ * values are copied into memory appended to the results array. The value
+ * variants point there with UA_VARIANT_DATA_NODELETE. So the results need a
+ * single allocation, which is freed together with the response. Nodes whose
+ * value comes from a callback or a data source take the normal path. */
+
+static UA_Boolean
+isValueOnlyRead(const UA_ReadRequest *request) {
+    for(size_t i = 0; i < request->nodesToReadSize; i++) {
+        const UA_ReadValueId *rvi = &request->nodesToRead[i];
+        if(rvi->attributeId != UA_ATTRIBUTEID_VALUE ||
+           rvi->indexRange.length > 0 ||
+           (rvi->dataEncoding.name.length > 0 &&
+            !UA_String_equal(&binEncoding, &rvi->dataEncoding.name)))
+            return false;
+    }
+    return true;
+}
+
+/* The value is stored in the node and not updated by a callback */
+static UA_Boolean
+isPlainValueNode(const UA_Node *node) {
+    if(node->head.nodeClass != UA_NODECLASS_VARIABLE)
+        return false;
+    const UA_VariableNode *vn = &node->variableNode;
+    if(vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_INTERNAL &&
+       (vn->valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE ||
+        vn->valueSource != UA_VALUESOURCE_DATA))
+        return false;
+    return (vn->value.data.callback.onRead == NULL);
+}
+
+/* Size in the appended memory (with alignment) or zero if the value is copied
+ * individually */
+static size_t
+inlineValueSize(const UA_Variant *value) {
+    if(!value->type || !value->type->pointerFree || !UA_Variant_isScalar(value))
+        return 0;
+    return (value->type->memSize + 7) & ~(size_t)7;
+}
+
+static void
+readPlainValue(UA_Server *server, UA_Session *session, const UA_VariableNode *vn,
+               UA_Byte userAccessLevel, UA_TimestampsToReturn timestampsToReturn,
+               UA_DataValue *v, UA_Byte **inlinePos) {
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    const UA_DataValue *src = &vn->value.data.value;
+    size_t inlineSize = inlineValueSize(&src->value);
+    if(!(getAccessLevel(server, session, vn) & UA_ACCESSLEVELMASK_READ)) {
+        retval = UA_STATUSCODE_BADNOTREADABLE;
+    } else if(!(userAccessLevel & UA_ACCESSLEVELMASK_READ)) {
+        retval = UA_STATUSCODE_BADUSERACCESSDENIED;
+    } else {
+        *v = *src; /* Copy status and timestamps */
+        UA_Variant_init(&v->value);
+        if(inlineSize > 0) {
+            memcpy(*inlinePos, src->value.data, src->value.type->memSize);
+            v->value.type = src->value.type;
+            v->value.data = *inlinePos;
+            v->value.storageType = UA_VARIANT_DATA_NODELETE;
+            *inlinePos += inlineSize;
+        } else {
+            retval = UA_Variant_copy(&src->value, &v->value);
+        }
+
+        /* Static nodes always have the current time as source-time */
+        if(!v->hasSourceTimestamp) {
+            UA_EventLoop *el = server->config.eventLoop;
+            v->sourceTimestamp = el->dateTime_now(el);
+            v->hasSourceTimestamp = true;
+        }
+    }
+
+    if(retval == UA_STATUSCODE_GOOD) {
+        v->hasValue = true;
+    } else {
+        v->hasStatus = true;
+        v->status = retval;
+    }
+    setReadTimestamps(server, timestampsToReturn, v);
+}
+
+static void
+readValuesBatch(UA_Server *server, UA_Session *session,
+                const UA_ReadRequest *request, UA_ReadResponse *response) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    size_t ops = request->nodesToReadSize;
+
+    /* The node pointers followed by the user access levels, the flags for the
+     * nodes that need a decision from the AccessControl plugin and the flags
+     * for the registered nodes (that are not released) */
+    const UA_Node **nodes = (const UA_Node**)
+        UA_malloc(ops * (sizeof(UA_Node*) + 3 * sizeof(UA_Byte)));
+    if(!nodes) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    UA_Byte *userAccessLevels = (UA_Byte*)&nodes[ops];
+    UA_Boolean *askPlugin = (UA_Boolean*)&userAccessLevels[ops];
+    UA_Boolean *registered = &askPlugin[ops];
+
+    /* Resolve the nodes */
+    const UA_UInt32 mask = attributeId2AttributeMask(UA_ATTRIBUTEID_VALUE) |
+        UA_NODEATTRIBUTESMASK_ACCESSLEVEL;
+    for(size_t i = 0; i < ops; i++) {
+        nodes[i] = getNodeForRead(server, session, &request->nodesToRead[i].nodeId,
+                                  mask, &registered[i]);
+        userAccessLevels[i] = 0xFF;
+    }
+
+    /* Check the user access levels of the plain value nodes without taking the
+     * lock for every node. The other nodes do this in ReadWithNode. */
+    if(session != &server->adminSession) {
+        /* Use the cached decisions first */
+        size_t pending = 0;
+        UA_UInt32 generation = 0;
+        for(size_t i = 0; i < ops; i++) {
+            askPlugin[i] = false;
+            const UA_Node *node = nodes[i];
+            if(!node || !isPlainValueNode(node) ||
+               !(node->variableNode.accessLevel & UA_ACCESSLEVELMASK_READ))
+                continue;
+            UA_AccessCacheEntry *ce =
+                getCachedAccess(server, session, &node->head.nodeId,
+                                UA_ACCESSCACHE_ACCESSLEVEL, &generation);
+            if(ce) {
+                userAccessLevels[i] = node->variableNode.accessLevel & ce->accessLevel;
+                continue;
+            }
+            askPlugin[i] = true;
+            pending++;
+        }
+
+        if(pending > 0) {
+            UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
+            for(size_t i = 0; i < ops; i++) {
+                if(!askPlugin[i])
+                    continue;
+                const UA_Node *node = nodes[i];
+                userAccessLevels[i] = server->config.accessControl.
+                    getUserAccessLevel(server, &server->config.accessControl,
+                                       session ? &session->sessionId : NULL,
+                                       session ? session->context : NULL,
+                                       &node->head.nodeId, node->head.context);
+            }
+            UA_LOCK_RESUME(&server->serviceMutex, shared);
+
+            for(size_t i = 0; i < ops; i++) {
+                if(!askPlugin[i])
+                    continue;
+                UA_AccessCacheEntry *ce =
+                    cacheAccess(server, session, &nodes[i]->head.nodeId,
+                                UA_ACCESSCACHE_ACCESSLEVEL, generation);
+                if(ce)
+                    ce->accessLevel = userAccessLevels[i];
+                userAccessLevels[i] &= nodes[i]->variableNode.accessLevel;
+            }
+        }
+    }
+
+    /* Allocate the results together with the memory for the inline values */
+    size_t resultsSize = ops * sizeof(UA_DataValue);
+    resultsSize = (resultsSize + 7) & ~(size_t)7;
+    size_t inlineSize = 0;
+    for(size_t i = 0; i < ops; i++) {
+        if(nodes[i] && isPlainValueNode(nodes[i]))
+            inlineSize += inlineValueSize(&nodes[i]->variableNode.value.data.value.value);
+    }
+    UA_DataValue *results = (UA_DataValue*)UA_malloc(resultsSize + inlineSize);
+    if(!results) {
+        for(size_t i = 0; i < ops; i++) {
+            if(nodes[i] && !registered[i])
+                UA_NODESTORE_RELEASE(server, nodes[i]);
+        }
+        UA_free(nodes);
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    memset(results, 0, resultsSize);
+    UA_Byte *inlinePos = (UA_Byte*)results + resultsSize;
+
+    /* Read */
+    for(size_t i = 0; i < ops; i++) {
+        const UA_Node *node = nodes[i];
+        if(!node) {
+            results[i].hasStatus = true;
+            results[i].status = UA_STATUSCODE_BADNODEIDUNKNOWN;
+            continue;
+        }
+        if(isPlainValueNode(node))
+            readPlainValue(server, session, &node->variableNode, userAccessLevels[i],
+                           request->timestampsToReturn, &results[i], &inlinePos);
+        else
+            ReadWithNodeMaxAge(node, server, session, request->timestampsToReturn,
+                               request->maxAge, &request->nodesToRead[i],
+                               &results[i]);
+        if(!registered[i])
+            UA_NODESTORE_RELEASE(server, node);
+    }
+    UA_free(nodes);
+
+    response->results = results;
+    response->resultsSize = ops;
 }
 
 void
@@ -679,28 +1178,58 @@ Service_Read(UA_Server *server, UA_Session *session,
 
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
+    if(request->nodesToReadSize > 0 && isValueOnlyRead(request)) {
+        readValuesBatch(server, session, request, response);
+        return;
+    }
+
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session,
-                                           (UA_ServiceOperation)Operation_Read,
-                                           &request->timestampsToReturn,
-                                           &request->nodesToReadSize,
+                                           (UA_ServiceOperation)Operation_ReadMaxAge,
+                                           request, &request->nodesToReadSize,
                                            &UA_TYPES[UA_TYPES_READVALUEID],
                                            &response->resultsSize,
                                            &UA_TYPES[UA_TYPES_DATAVALUE]);
 }
 
+#if UA_MULTITHREADING >= 100
+void
+Service_ReadAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
+                  const UA_ReadRequest *request, UA_ReadResponse *response,
+                  UA_Boolean *finished) {
+    UA_AsyncReadContext ctx;
+    ctx.requestId = requestId;
+    ctx.requestHandle = request->requestHeader.requestHandle;
+    ctx.timestampsToReturn = request->timestampsToReturn;
+    ctx.ar = NULL;
+    session->asyncRead = &ctx;
+    Service_Read(server, session, request, response);
+    session->asyncRead = NULL;
+    *finished = !UA_AsyncManager_finishAsyncReads(&server->asyncManager, server,
+                                                  session, &ctx, response);
+}
+#endif
+
 UA_DataValue
-readWithSession(UA_Server *server, UA_Session *session,
-                const UA_ReadValueId *item,
-                UA_TimestampsToReturn timestampsToReturn) {
+readWithSessionMaxAge(UA_Server *server, UA_Session *session,
+                      const UA_ReadValueId *item,
+                      UA_TimestampsToReturn timestampsToReturn,
+                      UA_Double maxAge) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     UA_DataValue dv;
     UA_DataValue_init(&dv);
-    Operation_Read(server, session, &timestampsToReturn, item, &dv);
+    readOperation(server, session, timestampsToReturn, maxAge, item, &dv);
     return dv;
 }
 
+UA_DataValue
+readWithSession(UA_Server *server, UA_Session *session,
+                const UA_ReadValueId *item,
+                UA_TimestampsToReturn timestampsToReturn) {
+    return readWithSessionMaxAge(server, session, item, timestampsToReturn, 0.0);
+}
+
 UA_StatusCode
 readWithReadValue(UA_Server *server, const UA_NodeId *nodeId,
                   const UA_AttributeId attributeId, void *v) {
@@ -1139,9 +1668,11 @@ unwrapEOArray(UA_Server *server, UA_Variant *value) {
         pos += innerType->memSize;
     }
 
-    /* Adjust the value */
+    /* Adjust the value. A shared payload remains with the original. */
     value->type = innerType;
     value->data = unwrappedArray;
+    if(value->storageType == UA_VARIANT_DATA_SHARED)
+        value->storageType = UA_VARIANT_DATA_NODELETE;
 
     /* Add the delayed callback to free the memory of the unwrapped array */
     dc->callback = freeWrapperArray;
@@ -1181,6 +1712,8 @@ adjustValueType(UA_Server *server, UA_Variant *value,
         value->type = &UA_TYPES[UA_TYPES_BYTE];
         value->arrayLength = str->length;
         value->data = str->data;
+        if(value->storageType == UA_VARIANT_DATA_SHARED)
+            value->storageType = UA_VARIANT_DATA_NODELETE;
         return;
     }
 
@@ -1408,6 +1941,42 @@ writeValueAttributeWithRange(UA_VariableNode *node, const UA_DataValue *value,
     return UA_STATUSCODE_GOOD;
 }
 
+/* ExtensionObjects are excluded as they might get unwrapped in
+ * adjustValueType. The current value can be a scalar or an array without
+ * ArrayDimensions. Changing the DataType, ValueRank or ArrayDimensions of the
+ * node re-checks the current value. */
+static UA_Boolean
+sameTypeAsStoredValue(const UA_VariableNode *node, const UA_Variant *v,
+                      const UA_NumericRange *range) {
+    if(range || node->valueSource != UA_VALUESOURCE_DATA ||
+       node->valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE)
+        return false;
+    const UA_DataValue *cur = &node->value.data.value;
+    if(!cur->hasValue || cur->value.type != v->type ||
+       v->type == &UA_TYPES[UA_TYPES_EXTENSIONOBJECT])
+        return false;
+    if(UA_Variant_isScalar(v))
+        return UA_Variant_isScalar(&cur->value);
+    return (!UA_Variant_isScalar(&cur->value) &&
+            cur->value.arrayLength == v->arrayLength &&
+            cur->value.arrayDimensionsSize == 0 && v->arrayDimensionsSize == 0);
+}
+
+/* Large values stored in the node are converted into a shared payload. The
+ * node, the read results, the MonitoredItem samples and the history then
+ * reference the same data. */
+static UA_Boolean
+shareWrittenValue(const UA_Server *server, const UA_VariableNode *node,
+                  const UA_DataValue *value, const UA_NumericRange *range) {
+    UA_UInt32 minSize = server->config.sharedValueMinSize;
+    if(minSize == 0 || range || !value->hasValue || !value->value.type ||
+       value->value.storageType == UA_VARIANT_DATA_SHARED ||
+       node->valueSource != UA_VALUESOURCE_DATA ||
+       node->valueBackend.backendType != UA_VALUEBACKENDTYPE_NONE)
+        return false;
+    return (UA_calcSizeBinary(&value->value, &UA_TYPES[UA_TYPES_VARIANT]) >= minSize);
+}
+
 static UA_StatusCode
 writeNodeValueAttribute(UA_Server *server, UA_Session *session,
                         UA_VariableNode *node, const UA_DataValue *value,
@@ -1432,9 +2001,12 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
      * "container". */
     UA_DataValue adjustedValue = *value;
 
-    /* Type checking. May change the type of adjustedValue */
+    /* Type checking. May change the type of adjustedValue. Skipped if the new
+     * value has the same type and shape as the current value, which was
+     * already checked against the (unchanged) node attributes. */
     const char *reason;
-    if(value->hasValue && value->value.type) {
+    if(value->hasValue && value->value.type &&
+       !sameTypeAsStoredValue(node, &value->value, rangeptr)) {
         /* Try to correct the type */
         adjustValueType(server, &adjustedValue.value, &node->dataType);
 
@@ -1469,6 +2041,16 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
         adjustedValue.hasSourcePicoseconds = false;
     }
 
+    /* Copy the data once into the shared payload. The request keeps its own
+     * data, so the variant is marked as borrowed before. */
+    UA_Boolean shared = shareWrittenValue(server, node, &adjustedValue, rangeptr);
+    if(shared) {
+        adjustedValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+        retval = UA_Variant_share(&adjustedValue.value);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval; /* No range to clean up */
+    }
+
     /* Call into the different value storage backends.
      *
      * TODO: Clean up this mess with duplicated possibilities for external
@@ -1501,6 +2083,7 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
                       &node->head.nodeId, node->head.context,
                       rangeptr, &adjustedValue);
             UA_LOCK(&server->serviceMutex);
+            invalidateDataSourceCache(server, &node->head.nodeId);
         }
         break;
 
@@ -1535,6 +2118,8 @@ writeNodeValueAttribute(UA_Server *server, UA_Session *session,
 #endif
 
     /* Clean up */
+    if(shared)
+        UA_Variant_clear(&adjustedValue.value);
     if(rangeptr && rangeptr->dimensions != NULL)
         UA_free(rangeptr->dimensions);
     return retval;
@@ -1666,6 +2251,8 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
         CHECK_DATATYPE_SCALAR(LOCALIZEDTEXT);
         retval = UA_Node_insertOrUpdateDisplayName(&node->head,
                                                    (const UA_LocalizedText *)value);
+        if(retval == UA_STATUSCODE_GOOD)
+            invalidateBrowseCache(server);
         break;
     case UA_ATTRIBUTEID_DESCRIPTION:
         CHECK_USERWRITEMASK(UA_WRITEMASK_DESCRIPTION);
@@ -1804,9 +2391,19 @@ copyAttributeIntoNode(UA_Server *server, UA_Session *session,
         return retval;
     }
 
-    /* Trigger MonitoredItems with no SamplingInterval */
+    /* Trigger MonitoredItems with no SamplingInterval and mark the
+     * event-driven SamplingGroups */
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     triggerImmediateDataChange(server, session, node, wvalue);
+    if(wvalue->attributeId == UA_ATTRIBUTEID_VALUE) {
+        UA_Node_markSamplingGroupsDirty(node);
+#ifdef UA_ENABLE_DA
+        static const UA_String euRangeName = UA_STRING_STATIC("EURange");
+        if(node->head.browseName.namespaceIndex == 0 &&
+           UA_String_equal(&node->head.browseName.name, &euRangeName))
+            server->euRangeGeneration++;
+#endif
+    }
 #endif
 
     return UA_STATUSCODE_GOOD;
@@ -1816,7 +2413,24 @@ void
 Operation_Write(UA_Server *server, UA_Session *session, void *context,
                 const UA_WriteValue *wv, UA_StatusCode *result) {
     UA_assert(session != NULL);
-    *result = UA_Server_editNode(server, session, &wv->nodeId,
+
+    /* Registered nodes are held by the Session. Edit them in-situ if the nodes
+     * are mutable. Otherwise only the lookup of the NodeId is resolved. */
+    const UA_NodeId *nodeId = &wv->nodeId;
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, nodeId);
+    if(rn) {
+#ifndef UA_ENABLE_IMMUTABLE_NODES
+        const UA_Node *node = UA_Session_resolveRegisteredNode(server, rn);
+        *result = (node) ?
+            copyAttributeIntoNode(server, session, (UA_Node*)(uintptr_t)node, wv) :
+            UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
+#else
+        nodeId = &rn->nodeId;
+#endif
+    }
+
+    *result = UA_Server_editNode(server, session, nodeId,
                                  (UA_EditNodeCallback)copyAttributeIntoNode,
                                  (void*)(uintptr_t)wv);
 }
@@ -1866,6 +2480,28 @@ __UA_Server_write(UA_Server *server, const UA_NodeId *nodeId,
     return res;
 }
 
+UA_StatusCode
+UA_Server_writeValues(UA_Server *server, size_t size, const UA_NodeId *nodeIds,
+                      const UA_DataValue *values, UA_StatusCode *results) {
+    UA_WriteValue wvalue;
+    UA_WriteValue_init(&wvalue);
+    wvalue.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_LOCK(&server->serviceMutex);
+    for(size_t i = 0; i < size; i++) {
+        wvalue.nodeId = nodeIds[i];
+        wvalue.value = values[i];
+        UA_StatusCode opRes = UA_STATUSCODE_GOOD;
+        Operation_Write(server, &server->adminSession, NULL, &wvalue, &opRes);
+        if(results)
+            results[i] = opRes;
+        if(res == UA_STATUSCODE_GOOD)
+            res = opRes;
+    }
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
 /* Internal convenience function */
 UA_StatusCode
 writeAttribute(UA_Server *server, UA_Session *session,
@@ -1955,6 +2591,12 @@ Service_HistoryRead(UA_Server *server, UA_Session *session,
         return;
     }
 
+    /* The history database does not implement the operation */
+    if(!readHistory) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+        return;
+    }
+
     /* Something to do? */
     if(request->nodesToReadSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
@@ -146,22 +146,29 @@ void Service_FindServers(UA_Server *server, UA_Session *session,
                                        &response->servers[pos++]);
 
     registeredServer *current;
-    LIST_FOREACH(current, &dm->registeredServers, pointers) {
-        UA_Boolean usable = (request->serverUrisSize == 0);
-        if(!usable) {
-            /* If client only requested a specific set of servers */
-            for(size_t i = 0; i < request->serverUrisSize; i++) {
-                if(UA_String_equal(&current->registeredServer.serverUri,
-                                   &request->serverUris[i])) {
-                    usable = true;
+    if(request->serverUrisSize == 0) {
+        LIST_FOREACH(current, &dm->registeredServers, pointers) {
+            setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
+                                                          &current->registeredServer);
+        }
+    } else {
+        /* If client only requested a specific set of servers, look them up
+         * in the index. Skip duplicate ServerUris in the request. */
+        for(size_t i = 0; i < request->serverUrisSize && pos < maxResults; i++) {
+            current = UA_DiscoveryManager_findRegisteredServer(dm, &request->serverUris[i]);
+            if(!current)
+                continue;
+            UA_Boolean duplicate = false;
+            for(size_t j = 0; j < i; j++) {
+                if(UA_String_equal(&request->serverUris[j], &request->serverUris[i])) {
+                    duplicate = true;
                     break;
                 }
             }
+            if(!duplicate)
+                setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
+                                                              &current->registeredServer);
         }
-
-        if(usable)
-            setApplicationDescriptionFromRegisteredServer(request, &response->servers[pos++],
-                                                          &current->registeredServer);
     }
 
     /* Set the final size */
@@ -246,15 +253,23 @@ Service_FindServersOnNetwork(UA_Server *server, UA_Session *session,
         return;
     }
 
-    /* Iterate over all records and add to filtered list */
+    /* The queue is sorted by ascending recordId. Clients poll incrementally
+     * with the last seen recordId. So walk backwards from the newest entry to
+     * find the first record to return. This touches only the new records
+     * instead of scanning the entire queue. */
+    serverOnNetwork *first = NULL, *current;
+    TAILQ_FOREACH_REVERSE(current, &dm->serverOnNetwork,
+                          serverOnNetworkQueue, pointers) {
+        if(current->serverOnNetwork.recordId < request->startingRecordId)
+            break;
+        first = current;
+    }
+
+    /* Iterate forward from there and add to filtered list */
     UA_UInt32 filteredCount = 0;
     UA_STACKARRAY(UA_ServerOnNetwork*, filtered, recordCount);
-    serverOnNetwork *current;
-    LIST_FOREACH(current, &dm->serverOnNetwork, pointers) {
-        if(filteredCount >= recordCount)
-            break;
-        if(current->serverOnNetwork.recordId < request->startingRecordId)
-            continue;
+    for(current = first; current && filteredCount < recordCount;
+        current = TAILQ_NEXT(current, pointers)) {
         if(!entryMatchesCapabilityFilter(request->serverCapabilityFilterSize,
                                request->serverCapabilityFilter, current))
             continue;
@@ -273,9 +288,9 @@ Service_FindServersOnNetwork(UA_Server *server, UA_Session *session,
     }
     response->serversSize = filteredCount;
 
-    /* Copy the server names */
+    /* Copy the records in ascending recordId order */
     for(size_t i = 0; i < filteredCount; i++)
-        UA_ServerOnNetwork_copy(filtered[i], &response->servers[filteredCount-i-1]);
+        UA_ServerOnNetwork_copy(filtered[i], &response->servers[i]);
 }
 #endif
 
@@ -459,12 +474,44 @@ setCurrentEndPointsArray(UA_Server *server, const UA_String endpointUrl,
     return retval;
 }
 
-void
-Service_GetEndpoints(UA_Server *server, UA_Session *session,
-                     const UA_GetEndpointsRequest *request,
-                     UA_GetEndpointsResponse *response) {
-    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+/* Check if the ServerUrl is already present in the DiscoveryUrl array.
+ * Add if not already there. */
+static void
+addDiscoveryUrl(UA_Server *server, UA_Session *session,
+                const UA_GetEndpointsRequest *request) {
+    /* Don't grow the array (and invalidate the endpoints cache) for every
+     * request without an EndpointUrl or with an already known EndpointUrl */
+    if(request->endpointUrl.length == 0)
+        return;
+    UA_SecureChannel *channel = session->channel;
+    for(size_t i = 0; i < server->config.applicationDescription.discoveryUrlsSize; i++) {
+        if(UA_String_equal(&channel->endpointUrl,
+                           &server->config.applicationDescription.discoveryUrls[i]) ||
+           UA_String_equal(&request->endpointUrl,
+                           &server->config.applicationDescription.discoveryUrls[i])) {
+            return;
+        }
+    }
+    if(server->config.applicationDescription.discoveryUrls == NULL){
+        server->config.applicationDescription.discoveryUrls = (UA_String*)UA_Array_new(1, &UA_TYPES[UA_TYPES_STRING]);
+        server->config.applicationDescription.discoveryUrlsSize = 0;
+    }
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    retval = UA_Array_appendCopy((void**)&server->config.applicationDescription.discoveryUrls,
+                        &server->config.applicationDescription.discoveryUrlsSize,
+                        &request->endpointUrl, &UA_TYPES[UA_TYPES_STRING]);
+    if(retval != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "Error adding the ServerUrl to theDiscoverUrl list.");
 
+    /* The DiscoveryUrls are part of the ApplicationDescription in the
+     * endpoints */
+    invalidateEndpointsCache(server);
+}
+
+static void
+logGetEndpoints(UA_Server *server, UA_Session *session,
+                const UA_GetEndpointsRequest *request) {
     /* If the client expects to see a specific endpointurl, mirror it back. If
      * not, clone the endpoints with the discovery url of all networklayers. */
     if(request->endpointUrl.length > 0) {
@@ -475,32 +522,160 @@ Service_GetEndpoints(UA_Server *server, UA_Session *session,
         UA_LOG_DEBUG_SESSION(server->config.logging, session,
                              "Processing GetEndpointsRequest with an empty endpointUrl");
     }
+}
 
+void
+Service_GetEndpoints(UA_Server *server, UA_Session *session,
+                     const UA_GetEndpointsRequest *request,
+                     UA_GetEndpointsResponse *response) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    logGetEndpoints(server, session, request);
     response->responseHeader.serviceResult =
         setCurrentEndPointsArray(server, request->endpointUrl,
                                  request->profileUris, request->profileUrisSize,
                                  &response->endpoints, &response->endpointsSize);
+    addDiscoveryUrl(server, session, request);
+}
 
-    /* Check if the ServerUrl is already present in the DiscoveryUrl array.
-     * Add if not already there. */
-    UA_SecureChannel *channel = session->channel;
-    for(size_t i = 0; i < server->config.applicationDescription.discoveryUrlsSize; i++) {
-        if(UA_String_equal(&channel->endpointUrl,
-                           &server->config.applicationDescription.discoveryUrls[i])) {
-            return;
-        }
+/********************/
+/* Endpoints Cache  */
+/********************/
+
+static UA_UInt32
+endpointsCacheHash(const UA_GetEndpointsRequest *request) {
+    UA_UInt32 h = UA_ByteString_hash(0, request->endpointUrl.data,
+                                     request->endpointUrl.length);
+    for(size_t i = 0; i < request->profileUrisSize; i++) {
+        const UA_String *p = &request->profileUris[i];
+        h = UA_ByteString_hash(h, (const UA_Byte*)"", 1); /* Separator */
+        h = UA_ByteString_hash(h, p->data, p->length);
     }
-    if(server->config.applicationDescription.discoveryUrls == NULL){
-        server->config.applicationDescription.discoveryUrls = (UA_String*)UA_Array_new(1, &UA_TYPES[UA_TYPES_STRING]);
-        server->config.applicationDescription.discoveryUrlsSize = 0;
+    return h;
+}
+
+static void
+UA_EndpointsCacheEntry_clear(UA_EndpointsCacheEntry *e) {
+    UA_String_clear(&e->endpointUrl);
+    UA_Array_delete(e->profileUris, e->profileUrisSize, &UA_TYPES[UA_TYPES_STRING]);
+    UA_ByteString_clear(&e->encoded);
+    memset(e, 0, sizeof(UA_EndpointsCacheEntry));
+}
+
+void
+UA_EndpointsCache_clear(UA_Server *server) {
+    for(size_t i = 0; i < server->endpointsCacheSize; i++)
+        UA_EndpointsCacheEntry_clear(&server->endpointsCache[i]);
+    UA_free(server->endpointsCache);
+    server->endpointsCache = NULL;
+    server->endpointsCacheSize = 0;
+}
+
+void
+UA_Server_invalidateEndpointsCache(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    invalidateEndpointsCache(server);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static const UA_ByteString *
+endpointsCacheLookup(UA_Server *server, const UA_GetEndpointsRequest *request) {
+    if(server->endpointsCacheSize == 0)
+        return NULL;
+    UA_UInt32 hash = endpointsCacheHash(request);
+    const UA_EndpointsCacheEntry *e =
+        &server->endpointsCache[hash % server->endpointsCacheSize];
+    if(e->encoded.length == 0 || e->generation != server->endpointsCacheGeneration ||
+       e->hash != hash || !UA_String_equal(&e->endpointUrl, &request->endpointUrl) ||
+       e->profileUrisSize != request->profileUrisSize)
+        return NULL;
+    for(size_t i = 0; i < e->profileUrisSize; i++) {
+        if(!UA_String_equal(&e->profileUris[i], &request->profileUris[i]))
+            return NULL;
+    }
+    return &e->encoded;
+}
+
+/* Encode the endpoints array of the response (without the ResponseHeader)
+ * into the cache slot */
+static const UA_ByteString *
+endpointsCacheStore(UA_Server *server, const UA_GetEndpointsRequest *request,
+                    const UA_GetEndpointsResponse *response) {
+    /* (Re)allocate the cache if the configuration changed */
+    UA_UInt32 size = server->config.endpointsCacheSize;
+    if(server->endpointsCacheSize != size) {
+        UA_EndpointsCache_clear(server);
+        server->endpointsCache = (UA_EndpointsCacheEntry*)
+            UA_calloc(size, sizeof(UA_EndpointsCacheEntry));
+        if(!server->endpointsCache)
+            return NULL;
+        server->endpointsCacheSize = size;
+    }
+
+    /* Encode the entire response and cut away the ResponseHeader */
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    UA_StatusCode res =
+        UA_encodeBinary(response, &UA_TYPES[UA_TYPES_GETENDPOINTSRESPONSE], &encoded);
+    if(res != UA_STATUSCODE_GOOD)
+        return NULL;
+    size_t headerSize = UA_calcSizeBinary(&response->responseHeader,
+                                          &UA_TYPES[UA_TYPES_RESPONSEHEADER]);
+    UA_assert(headerSize < encoded.length);
+    encoded.length -= headerSize;
+    memmove(encoded.data, encoded.data + headerSize, encoded.length);
+
+    /* Replace the entry in the slot */
+    UA_UInt32 hash = endpointsCacheHash(request);
+    UA_EndpointsCacheEntry *e = &server->endpointsCache[hash % size];
+    UA_EndpointsCacheEntry_clear(e);
+    res = UA_String_copy(&request->endpointUrl, &e->endpointUrl);
+    res |= UA_Array_copy(request->profileUris, request->profileUrisSize,
+                         (void**)&e->profileUris, &UA_TYPES[UA_TYPES_STRING]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(&encoded);
+        UA_EndpointsCacheEntry_clear(e);
+        return NULL;
+    }
+    e->profileUrisSize = request->profileUrisSize;
+    e->encoded = encoded;
+    e->generation = server->endpointsCacheGeneration;
+    e->hash = hash;
+    return &e->encoded;
+}
+
+void
+Service_GetEndpointsStream(UA_Server *server, UA_Session *session,
+                           UA_ResponseStream *stream,
+                           const UA_GetEndpointsRequest *request,
+                           UA_GetEndpointsResponse *response) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    if(server->config.endpointsCacheSize == 0) {
+        Service_GetEndpoints(server, session, request, response);
+        return;
     }
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
-    retval = UA_Array_appendCopy((void**)&server->config.applicationDescription.discoveryUrls,
-                        &server->config.applicationDescription.discoveryUrlsSize,
-                        &request->endpointUrl, &UA_TYPES[UA_TYPES_STRING]);
-    if(retval != UA_STATUSCODE_GOOD)
-        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
-                     "Error adding the ServerUrl to theDiscoverUrl list.");
+
+    /* Build and cache the endpoints if required. The endpoints do not depend
+     * on the SecureChannel or the Session. */
+    logGetEndpoints(server, session, request);
+    const UA_ByteString *encoded = endpointsCacheLookup(server, request);
+    if(!encoded) {
+        response->responseHeader.serviceResult =
+            setCurrentEndPointsArray(server, request->endpointUrl,
+                                     request->profileUris, request->profileUrisSize,
+                                     &response->endpoints, &response->endpointsSize);
+        if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
+            encoded = endpointsCacheStore(server, request, response);
+    }
+    addDiscoveryUrl(server, session, request);
+
+    /* Send the cached encoding. Otherwise the response is encoded normally. */
+    if(!encoded)
+        return;
+    UA_StatusCode res =
+        UA_ResponseStream_sendEncoded(server, stream, &response->responseHeader,
+                                      encoded);
+    if(res != UA_STATUSCODE_GOOD && !stream->started)
+        response->responseHeader.serviceResult = res;
 }
 
 #ifdef UA_ENABLE_DISCOVERY
@@ -529,11 +704,8 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
     }
 
     /* Find the server from the request in the registered list */
-    registeredServer *rs = NULL;
-    LIST_FOREACH(rs, &dm->registeredServers, pointers) {
-        if(UA_String_equal(&rs->registeredServer.serverUri, &requestServer->serverUri))
-            break;
-    }
+    registeredServer *rs =
+        UA_DiscoveryManager_findRegisteredServer(dm, &requestServer->serverUri);
 
     UA_MdnsDiscoveryConfiguration *mdnsConfig = NULL;
 
@@ -634,34 +806,35 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
             UA_LOCK(&server->serviceMutex);
         }
 
-        // server found, remove from list
-        LIST_REMOVE(rs, pointers);
-        UA_RegisteredServer_clear(&rs->registeredServer);
-        UA_free(rs);
-        dm->registeredServersSize--;
+        // server found, remove from list. Look up again, the entry might
+        // have been removed while the lock was released.
+        rs = UA_DiscoveryManager_findRegisteredServer(dm, &requestServer->serverUri);
+        if(rs)
+            UA_DiscoveryManager_removeRegisteredServer(dm, rs);
         responseHeader->serviceResult = UA_STATUSCODE_GOOD;
         return;
     }
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    // copy the data from the request into the list. The entry is complete
+    // before it is added to the indexes.
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    UA_StatusCode retval;
     if(!rs) {
         // server not yet registered, register it by adding it to the list
         UA_LOG_DEBUG_SESSION(server->config.logging, session,
                              "Registering new server: %.*s",
                              (int)requestServer->serverUri.length,
                              requestServer->serverUri.data);
-
-        rs = (registeredServer*)UA_malloc(sizeof(registeredServer));
-        if(!rs) {
-            responseHeader->serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
-            return;
-        }
-
-        LIST_INSERT_HEAD(&dm->registeredServers, rs, pointers);
-        dm->registeredServersSize++;
+        retval = UA_DiscoveryManager_addRegisteredServer(dm, requestServer,
+                                                         nowMonotonic);
     } else {
-        UA_RegisteredServer_clear(&rs->registeredServer);
+        retval = UA_DiscoveryManager_updateRegisteredServer(dm, rs, requestServer,
+                                                            nowMonotonic);
     }
+    responseHeader->serviceResult = retval;
+    if(retval != UA_STATUSCODE_GOOD)
+        return;
 
     // Always call the callback, if it is set. Previously we only called it if
     // it was a new register call. It may be the case that this endpoint
@@ -673,13 +846,6 @@ process_RegisterServer(UA_Server *server, UA_Session *session,
                                    dm->registerServerCallbackData);
         UA_LOCK(&server->serviceMutex);
     }
-
-    // copy the data from the request into the list
-    UA_EventLoop *el = server->config.eventLoop;
-    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
-    UA_RegisteredServer_copy(requestServer, &rs->registeredServer);
-    rs->lastSeen = nowMonotonic;
-    responseHeader->serviceResult = retval;
 }
 
 void Service_RegisterServer(UA_Server *server, UA_Session *session,
@@ -197,70 +197,161 @@ checkFunctionalGroupMethodReference(UA_Server *server, const UA_NodeHead *h,
     return UA_STATUSCODE_GOOD;
 }
 
+/* Resolved nodes that are reused for consecutive calls in the same
+ * CallRequest. Clients often call the same method many times in one request.
+ * The nodes stay valid until they are released, also while the service lock
+ * is released for the callbacks. */
+typedef struct {
+    const UA_Node *method;
+    const UA_VariableNode *inputArguments;
+    const UA_VariableNode *outputArguments;
+    const UA_Node *object;
+    UA_Boolean referenceChecked; /* The method is verified for the object */
+} MethodCallCache;
+
 static void
-callWithMethodAndObject(UA_Server *server, UA_Session *session,
-                        const UA_CallMethodRequest *request, UA_CallMethodResult *result,
-                        const UA_MethodNode *method, const UA_ObjectNode *object) {
+MethodCallCache_clear(UA_Server *server, MethodCallCache *cache) {
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)cache->inputArguments);
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)cache->outputArguments);
+    UA_NODESTORE_RELEASE(server, cache->method);
+    UA_NODESTORE_RELEASE(server, cache->object);
+    memset(cache, 0, sizeof(MethodCallCache));
+}
+
+static const UA_Node *
+getMethodNode(UA_Server *server, MethodCallCache *cache, const UA_NodeId *methodId) {
+    if(cache->method && UA_NodeId_equal(&cache->method->head.nodeId, methodId))
+        return cache->method;
+
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)cache->inputArguments);
+    UA_NODESTORE_RELEASE(server, (const UA_Node*)cache->outputArguments);
+    UA_NODESTORE_RELEASE(server, cache->method);
+    cache->inputArguments = NULL;
+    cache->outputArguments = NULL;
+    cache->referenceChecked = false;
+
+    /* Get the method node. We only need the nodeClass and executable
+     * attribute. Take all forward hasProperty references to get the
+     * input/output argument definition variables. */
+    cache->method =
+        UA_NODESTORE_GET_SELECTIVE(server, methodId,
+                                   UA_NODEATTRIBUTESMASK_NODECLASS |
+                                   UA_NODEATTRIBUTESMASK_EXECUTABLE,
+                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASPROPERTY),
+                                   UA_BROWSEDIRECTION_FORWARD);
+    if(!cache->method)
+        return NULL;
+
+    /* Resolve the argument definitions once for all calls of the method */
+    cache->inputArguments =
+        getArgumentsVariableNode(server, &cache->method->head, UA_STRING("InputArguments"));
+    cache->outputArguments =
+        getArgumentsVariableNode(server, &cache->method->head, UA_STRING("OutputArguments"));
+    return cache->method;
+}
+
+static const UA_Node *
+getObjectNode(UA_Server *server, MethodCallCache *cache, const UA_NodeId *objectId) {
+    if(cache->object && UA_NodeId_equal(&cache->object->head.nodeId, objectId))
+        return cache->object;
+
+    UA_NODESTORE_RELEASE(server, cache->object);
+    cache->referenceChecked = false;
+
+    /* Get the object node. We only need the NodeClass attribute. But take all
+     * references for now.
+     *
+     * TODO: Which references do we need actually? */
+    cache->object =
+        UA_NODESTORE_GET_SELECTIVE(server, objectId,
+                                   UA_NODEATTRIBUTESMASK_NODECLASS,
+                                   UA_REFERENCETYPESET_ALL,
+                                   UA_BROWSEDIRECTION_BOTH);
+    return cache->object;
+}
+
+/* Validate the call and prepare the result. The (possibly type-adjusted) input
+ * arguments are copied to mutableInputArgs. Returns true if the method can be
+ * executed. */
+static UA_Boolean
+prepareMethodCall(UA_Server *server, UA_Session *session, MethodCallCache *cache,
+                  const UA_CallMethodRequest *request, UA_CallMethodResult *result,
+                  UA_Variant *mutableInputArgs) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
+    /* The method node is already in the cache */
+    const UA_MethodNode *method = &cache->method->methodNode;
+    const UA_Node *objectNode = getObjectNode(server, cache, &request->objectId);
+    if(!objectNode) {
+        result->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return false;
+    }
+    const UA_ObjectNode *object = &objectNode->objectNode;
+
     /* Verify the object's NodeClass */
     if(object->head.nodeClass != UA_NODECLASS_OBJECT &&
        object->head.nodeClass != UA_NODECLASS_OBJECTTYPE) {
         result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
-        return;
+        return false;
     }
 
     /* Verify the method's NodeClass */
     if(method->head.nodeClass != UA_NODECLASS_METHOD) {
         result->statusCode = UA_STATUSCODE_BADNODECLASSINVALID;
-        return;
+        return false;
     }
 
     /* Is there a method to execute? */
-    if(!method->method) {
+    if(!method->method && !method->methodBatch) {
         result->statusCode = UA_STATUSCODE_BADINTERNALERROR;
-        return;
+        return false;
     }
 
     /* Verify method/object relations. Object must have a hasComponent or a
      * subtype of hasComponent reference to the method node. Therefore, check
      * every reference between the parent object and the method node if there is
-     * a hasComponent (or subtype) reference */
-    UA_ExpandedNodeId methodId = UA_EXPANDEDNODEID_NODEID(request->methodId);
-    UA_ReferenceTypeSet hasComponentRefs;
-    result->statusCode = referenceTypeIndices(server, &hasComponentNodeId,
-                                              &hasComponentRefs, true);
-    UA_CHECK_STATUS(result->statusCode, return);
-    UA_Boolean found = checkMethodReference(&object->head, hasComponentRefs, &methodId);
-
-    if(!found) {
-        /* If the object doesn't have a hasComponent reference to the method node,
-         * check its objectType (and its supertypes). Invoked method can be a component
-         * of objectType and be invoked on this objectType's instance (or on a instance
-         * of one of its subtypes). */
-        const UA_Node *objectType = getNodeType(server, &object->head);
-        if(objectType) {
-            found = checkMethodReference(&objectType->head, hasComponentRefs, &methodId);
-            UA_NODESTORE_RELEASE(server, objectType);
+     * a hasComponent (or subtype) reference. The result is cached for the
+     * following calls with the same object. */
+    if(!cache->referenceChecked) {
+        UA_ExpandedNodeId methodId = UA_EXPANDEDNODEID_NODEID(request->methodId);
+        UA_ReferenceTypeSet hasComponentRefs;
+        result->statusCode = referenceTypeIndices(server, &hasComponentNodeId,
+                                                  &hasComponentRefs, true);
+        UA_CHECK_STATUS(result->statusCode, return false);
+        UA_Boolean found = checkMethodReference(&object->head, hasComponentRefs, &methodId);
+
+        if(!found) {
+            /* If the object doesn't have a hasComponent reference to the method
+             * node, check its objectType (and its supertypes). Invoked method
+             * can be a component of objectType and be invoked on this
+             * objectType's instance (or on a instance of one of its
+             * subtypes). */
+            const UA_Node *objectType = getNodeType(server, &object->head);
+            if(objectType) {
+                found = checkMethodReference(&objectType->head, hasComponentRefs, &methodId);
+                UA_NODESTORE_RELEASE(server, objectType);
+            }
         }
-    }
 
-    if(!found) {
-        /* The following ParentObject evaluation is a workaround only to fulfill
-         * the OPC UA Spec. Part 100 - Devices requirements regarding functional
-         * groups. Compare OPC UA Spec. Part 100 - Devices, Release 1.02
-         *    - 5.4 FunctionalGroupType
-         *    - B.1 Functional Group Usages
-         * A functional group is a sub-type of the FolderType and is used to
-         * organize the Parameters and Methods from the complete set (named
-         * ParameterSet and MethodSet) in (Functional) groups for instance
-         * Configuration or Identification. The same Property, Parameter or
-         * Method can be referenced from more than one FunctionalGroup. */
-        result->statusCode =
-            checkFunctionalGroupMethodReference(server, &object->head, &methodId, &found);
-        if(!found && result->statusCode == UA_STATUSCODE_GOOD)
-            result->statusCode = UA_STATUSCODE_BADMETHODINVALID;
-        UA_CHECK_STATUS(result->statusCode, return);
+        if(!found) {
+            /* The following ParentObject evaluation is a workaround only to
+             * fulfill the OPC UA Spec. Part 100 - Devices requirements
+             * regarding functional groups. Compare OPC UA Spec. Part 100 -
+             * Devices, Release 1.02
+             *    - 5.4 FunctionalGroupType
+             *    - B.1 Functional Group Usages
+             * A functional group is a sub-type of the FolderType and is used to
+             * organize the Parameters and Methods from the complete set (named
+             * ParameterSet and MethodSet) in (Functional) groups for instance
+             * Configuration or Identification. The same Property, Parameter or
+             * Method can be referenced from more than one FunctionalGroup. */
+            result->statusCode =
+                checkFunctionalGroupMethodReference(server, &object->head, &methodId, &found);
+            if(!found && result->statusCode == UA_STATUSCODE_GOOD)
+                result->statusCode = UA_STATUSCODE_BADMETHODINVALID;
+            UA_CHECK_STATUS(result->statusCode, return false);
+        }
+        cache->referenceChecked = true;
     }
 
     /* Verify access rights */
@@ -277,7 +368,7 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
 
     if(!executable) {
         result->statusCode = UA_STATUSCODE_BADNOTEXECUTABLE;
-        return;
+        return false;
     }
 
     /* The input arguments are const and not changed. We move the input
@@ -287,34 +378,30 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
      * call. */
     if(request->inputArgumentsSize > UA_MAX_METHOD_ARGUMENTS) {
         result->statusCode = UA_STATUSCODE_BADTOOMANYARGUMENTS;
-        return;
+        return false;
     }
-    UA_Variant mutableInputArgs[UA_MAX_METHOD_ARGUMENTS];
-    memcpy(mutableInputArgs, request->inputArguments,
-           sizeof(UA_Variant) * request->inputArgumentsSize);
+    if(request->inputArgumentsSize > 0)
+        memcpy(mutableInputArgs, request->inputArguments,
+               sizeof(UA_Variant) * request->inputArgumentsSize);
 
     /* Allocate the inputArgumentResults array */
     result->inputArgumentResults = (UA_StatusCode*)
         UA_Array_new(request->inputArgumentsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
     if(!result->inputArgumentResults) {
         result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
-        return;
+        return false;
     }
     result->inputArgumentResultsSize = request->inputArgumentsSize;
 
     /* Type-check the input arguments */
-    const UA_VariableNode *inputArguments =
-        getArgumentsVariableNode(server, &method->head, UA_STRING("InputArguments"));
-    if(inputArguments) {
+    if(cache->inputArguments) {
         result->statusCode =
-            checkAdjustArguments(server, session, inputArguments, request->inputArgumentsSize,
+            checkAdjustArguments(server, session, cache->inputArguments,
+                                 request->inputArgumentsSize,
                                  mutableInputArgs, result->inputArgumentResults);
-        UA_NODESTORE_RELEASE(server, (const UA_Node*)inputArguments);
     } else {
-        if(request->inputArgumentsSize > 0) {
+        if(request->inputArgumentsSize > 0)
             result->statusCode = UA_STATUSCODE_BADTOOMANYARGUMENTS;
-            return;
-        }
     }
 
     /* Return inputArgumentResults only for BADINVALIDARGUMENT */
@@ -327,28 +414,32 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
 
     /* Error during type-checking? */
     if(result->statusCode != UA_STATUSCODE_GOOD)
-        return;
-
-    /* Get the output arguments node */
-    const UA_VariableNode *outputArguments =
-        getArgumentsVariableNode(server, &method->head, UA_STRING("OutputArguments"));
+        return false;
 
     /* Allocate the output arguments array */
     size_t outputArgsSize = 0;
-    if(outputArguments)
-        outputArgsSize = outputArguments->value.data.value.value.arrayLength;
+    if(cache->outputArguments)
+        outputArgsSize = cache->outputArguments->value.data.value.value.arrayLength;
     result->outputArguments = (UA_Variant*)
         UA_Array_new(outputArgsSize, &UA_TYPES[UA_TYPES_VARIANT]);
     if(!result->outputArguments) {
         result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
-        return;
+        return false;
     }
     result->outputArgumentsSize = outputArgsSize;
+    return true;
+}
 
-    /* Release the output arguments node */
-    UA_NODESTORE_RELEASE(server, (const UA_Node*)outputArguments);
+static void
+callMethod(UA_Server *server, UA_Session *session, MethodCallCache *cache,
+           const UA_CallMethodRequest *request, UA_CallMethodResult *result) {
+    UA_Variant mutableInputArgs[UA_MAX_METHOD_ARGUMENTS];
+    if(!prepareMethodCall(server, session, cache, request, result, mutableInputArgs))
+        return;
 
     /* Call the method */
+    const UA_MethodNode *method = &cache->method->methodNode;
+    const UA_ObjectNode *object = &cache->object->objectNode;
     UA_UNLOCK(&server->serviceMutex);
     result->statusCode = method->method(server, &session->sessionId, session->context,
                                         &method->head.nodeId, method->head.context,
@@ -359,50 +450,108 @@ callWithMethodAndObject(UA_Server *server, UA_Session *session,
     /* TODO: Verify Output matches the argument definition */
 }
 
-#if UA_MULTITHREADING >= 100
-
+/* Validate all calls individually and execute them with a single invocation
+ * of the batch callback. The requests passed to the callback are shallow
+ * copies with the mutable input arguments. */
 static void
-Operation_CallMethodAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
-                          UA_UInt32 requestHandle, size_t opIndex,
-                          UA_CallMethodRequest *opRequest, UA_CallMethodResult *opResult,
-                          UA_AsyncResponse **ar) {
-    /* Get the method node. We only need the nodeClass and executable attribute.
-     * Take all forward hasProperty references to get the input/output argument
-     * definition variables. */
-    const UA_Node *method =
-        UA_NODESTORE_GET_SELECTIVE(server, &opRequest->methodId,
-                                   UA_NODEATTRIBUTESMASK_NODECLASS |
-                                   UA_NODEATTRIBUTESMASK_EXECUTABLE,
-                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASPROPERTY),
-                                   UA_BROWSEDIRECTION_FORWARD);
-    if(!method) {
-        opResult->statusCode = UA_STATUSCODE_BADMETHODINVALID;
+callMethodBatch(UA_Server *server, UA_Session *session, MethodCallCache *cache,
+                size_t callsSize, const UA_CallMethodRequest *calls,
+                UA_CallMethodResult *results) {
+    size_t argsSize = 0;
+    for(size_t i = 0; i < callsSize; i++) {
+        if(calls[i].inputArgumentsSize <= UA_MAX_METHOD_ARGUMENTS)
+            argsSize += calls[i].inputArgumentsSize;
+    }
+    UA_CallMethodRequest *mutableCalls = (UA_CallMethodRequest*)
+        UA_malloc(sizeof(UA_CallMethodRequest) * callsSize);
+    UA_Variant *mutableArgs = (UA_Variant*)UA_malloc(sizeof(UA_Variant) * (argsSize + 1));
+    if(!mutableCalls || !mutableArgs) {
+        for(size_t i = 0; i < callsSize; i++)
+            results[i].statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_free(mutableCalls);
+        UA_free(mutableArgs);
         return;
     }
 
-    /* Get the object node. We only need the NodeClass attribute. But take all
-     * references for now.
-     *
-     * TODO: Which references do we need actually? */
-    const UA_Node *object =
-        UA_NODESTORE_GET_SELECTIVE(server, &opRequest->objectId,
-                                   UA_NODEATTRIBUTESMASK_NODECLASS,
-                                   UA_REFERENCETYPESET_ALL,
-                                   UA_BROWSEDIRECTION_BOTH);
-    if(!object) {
-        opResult->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
-        UA_NODESTORE_RELEASE(server, method);
-        return;
+    /* Validate */
+    UA_Boolean execute = false;
+    UA_Variant *args = mutableArgs;
+    for(size_t i = 0; i < callsSize; i++) {
+        mutableCalls[i] = calls[i];
+        mutableCalls[i].inputArguments = args;
+        if(prepareMethodCall(server, session, cache, &calls[i], &results[i], args)) {
+            args += calls[i].inputArgumentsSize;
+            execute = true;
+        }
+    }
+
+    /* Call the method once for all calls */
+    if(execute) {
+        const UA_MethodNode *method = &cache->method->methodNode;
+        UA_UNLOCK(&server->serviceMutex);
+        method->methodBatch(server, &session->sessionId, session->context,
+                            &method->head.nodeId, method->head.context,
+                            callsSize, mutableCalls, results);
+        UA_LOCK(&server->serviceMutex);
+    }
+
+    UA_free(mutableCalls);
+    UA_free(mutableArgs);
+}
+
+/* Execute the next call. Consecutive calls of a method with a batch callback
+ * are executed together. Returns the number of processed calls. */
+static size_t
+callMethods(UA_Server *server, UA_Session *session, MethodCallCache *cache,
+            size_t callsSize, const UA_CallMethodRequest *calls,
+            UA_CallMethodResult *results) {
+    const UA_Node *method = getMethodNode(server, cache, &calls[0].methodId);
+    if(!method) {
+        results[0].statusCode = UA_STATUSCODE_BADMETHODINVALID;
+        return 1;
     }
 
-    /* Synchronous execution */
-    if(!method->methodNode.async) {
-        callWithMethodAndObject(server, session, opRequest, opResult,
-                                &method->methodNode, &object->objectNode);
-        goto cleanup;
+    if(method->head.nodeClass != UA_NODECLASS_METHOD ||
+       !method->methodNode.methodBatch) {
+        callMethod(server, session, cache, &calls[0], &results[0]);
+        return 1;
     }
 
-    /* <-- Async method call --> */
+    size_t batchSize = 1;
+    while(batchSize < callsSize &&
+          UA_NodeId_equal(&calls[batchSize].methodId, &method->head.nodeId))
+        batchSize++;
+    callMethodBatch(server, session, cache, batchSize, calls, results);
+    return batchSize;
+}
+
+static UA_StatusCode
+allocateCallResults(UA_Server *server, const UA_CallRequest *request,
+                    UA_CallResponse *response) {
+    if(server->config.maxNodesPerMethodCall != 0 &&
+       request->methodsToCallSize > server->config.maxNodesPerMethodCall)
+        return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+    if(request->methodsToCallSize == 0)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+    response->results = (UA_CallMethodResult*)
+        UA_Array_new(request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT]);
+    if(!response->results)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    response->resultsSize = request->methodsToCallSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+#if UA_MULTITHREADING >= 100
+
+static void
+callMethodAsync(UA_Server *server, UA_Session *session, MethodCallCache *cache,
+                UA_UInt32 requestId, UA_UInt32 requestHandle, size_t opIndex,
+                const UA_CallMethodRequest *opRequest, UA_CallMethodResult *opResult,
+                UA_AsyncResponse **ar) {
+    if(!getObjectNode(server, cache, &opRequest->objectId)) {
+        opResult->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
+        return;
+    }
 
     /* No AsyncResponse allocated so far */
     if(!*ar) {
@@ -411,18 +560,13 @@ Operation_CallMethodAsync(UA_Server *server, UA_Session *session, UA_UInt32 requ
                             &session->sessionId, requestId, requestHandle,
                             UA_ASYNCOPERATIONTYPE_CALL, ar);
         if(opResult->statusCode != UA_STATUSCODE_GOOD)
-            goto cleanup;
+            return;
     }
 
     /* Create the Async Request to be taken by workers */
     opResult->statusCode =
         UA_AsyncManager_createAsyncOp(&server->asyncManager,
                                       server, *ar, opIndex, opRequest);
-
- cleanup:
-    /* Release the method and object node */
-    UA_NODESTORE_RELEASE(server, method);
-    UA_NODESTORE_RELEASE(server, object);
 }
 
 void
@@ -430,19 +574,32 @@ Service_CallAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
                   const UA_CallRequest *request, UA_CallResponse *response,
                   UA_Boolean *finished) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing CallRequestAsync");
-    if(server->config.maxNodesPerMethodCall != 0 &&
-        request->methodsToCallSize > server->config.maxNodesPerMethodCall) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+    response->responseHeader.serviceResult =
+        allocateCallResults(server, request, response);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
         return;
-    }
 
+    size_t ops = response->resultsSize;
+
+    /* Finish / dispatch the operations. This may allocate a new AsyncResponse
+     * internally. */
+    MethodCallCache cache;
+    memset(&cache, 0, sizeof(MethodCallCache));
     UA_AsyncResponse *ar = NULL;
-    response->responseHeader.serviceResult =
-        UA_Server_processServiceOperationsAsync(server, session, requestId,
-                  request->requestHeader.requestHandle,
-                  (UA_AsyncServiceOperation)Operation_CallMethodAsync,
-                  &request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT], &ar);
+    for(size_t i = 0; i < ops;) {
+        const UA_CallMethodRequest *call = &request->methodsToCall[i];
+        const UA_Node *method = getMethodNode(server, &cache, &call->methodId);
+        if(method && method->head.nodeClass == UA_NODECLASS_METHOD &&
+           method->methodNode.async) {
+            callMethodAsync(server, session, &cache, requestId,
+                            request->requestHeader.requestHandle, i,
+                            call, &response->results[i], &ar);
+            i++;
+            continue;
+        }
+        i += callMethods(server, session, &cache, ops - i, call, &response->results[i]);
+    }
+    MethodCallCache_clear(server, &cache);
 
     if(ar) {
         if(ar->opCountdown > 0) {
@@ -460,63 +617,23 @@ Service_CallAsync(UA_Server *server, UA_Session *session, UA_UInt32 requestId,
 }
 #endif
 
-static void
-Operation_CallMethod(UA_Server *server, UA_Session *session, void *context,
-                     const UA_CallMethodRequest *request, UA_CallMethodResult *result) {
-    /* Get the method node. We only need the nodeClass and executable attribute.
-     * Take all forward hasProperty references to get the input/output argument
-     * definition variables. */
-    const UA_Node *method =
-        UA_NODESTORE_GET_SELECTIVE(server, &request->methodId,
-                                   UA_NODEATTRIBUTESMASK_NODECLASS |
-                                   UA_NODEATTRIBUTESMASK_EXECUTABLE,
-                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASPROPERTY),
-                                   UA_BROWSEDIRECTION_FORWARD);
-    if(!method) {
-        result->statusCode = UA_STATUSCODE_BADMETHODINVALID;
-        return;
-    }
-
-    /* Get the object node. We only need the NodeClass attribute. But take all
-     * references for now.
-     *
-     * TODO: Which references do we need actually? */
-    const UA_Node *object =
-        UA_NODESTORE_GET_SELECTIVE(server, &request->objectId,
-                                   UA_NODEATTRIBUTESMASK_NODECLASS,
-                                   UA_REFERENCETYPESET_ALL,
-                                   UA_BROWSEDIRECTION_BOTH);
-    if(!object) {
-        result->statusCode = UA_STATUSCODE_BADNODEIDUNKNOWN;
-        UA_NODESTORE_RELEASE(server, method);
-        return;
-    }
-
-    /* Continue with method and object as context */
-    callWithMethodAndObject(server, session, request, result,
-                            &method->methodNode, &object->objectNode);
-
-    /* Release the method and object node */
-    UA_NODESTORE_RELEASE(server, method);
-    UA_NODESTORE_RELEASE(server, object);
-}
-
 void Service_Call(UA_Server *server, UA_Session *session,
                   const UA_CallRequest *request, UA_CallResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing CallRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    if(server->config.maxNodesPerMethodCall != 0 &&
-       request->methodsToCallSize > server->config.maxNodesPerMethodCall) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
+    response->responseHeader.serviceResult =
+        allocateCallResults(server, request, response);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
         return;
-    }
 
-    response->responseHeader.serviceResult =
-        UA_Server_processServiceOperations(server, session,
-                  (UA_ServiceOperation)Operation_CallMethod, NULL,
-                  &request->methodsToCallSize, &UA_TYPES[UA_TYPES_CALLMETHODREQUEST],
-                  &response->resultsSize, &UA_TYPES[UA_TYPES_CALLMETHODRESULT]);
+    size_t ops = response->resultsSize;
+    MethodCallCache cache;
+    memset(&cache, 0, sizeof(MethodCallCache));
+    for(size_t i = 0; i < ops;)
+        i += callMethods(server, session, &cache, ops - i,
+                         &request->methodsToCall[i], &response->results[i]);
+    MethodCallCache_clear(server, &cache);
 }
 
 UA_CallMethodResult
@@ -524,7 +641,10 @@ UA_Server_call(UA_Server *server, const UA_CallMethodRequest *request) {
     UA_CallMethodResult result;
     UA_CallMethodResult_init(&result);
     UA_LOCK(&server->serviceMutex);
-    Operation_CallMethod(server, &server->adminSession, NULL, request, &result);
+    MethodCallCache cache;
+    memset(&cache, 0, sizeof(MethodCallCache));
+    callMethods(server, &server->adminSession, &cache, 1, request, &result);
+    MethodCallCache_clear(server, &cache);
     UA_UNLOCK(&server->serviceMutex);
     return result;
 }
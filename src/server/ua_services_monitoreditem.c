@@ -28,11 +28,13 @@
 #ifdef UA_ENABLE_DA
 
 /* Translate a percentage deadband into an absolute deadband based on the
- * UARange property of the variable */
+ * EURange property of the variable. The EURange property is resolved only once
+ * and stored in the PercentDeadband. */
 static UA_StatusCode
 setAbsoluteFromPercentageDeadband(UA_Server *server, UA_Session *session,
                                   const UA_MonitoredItem *mon,
-                                  UA_DataChangeFilter *filter) {
+                                  UA_DataChangeFilter *filter,
+                                  UA_PercentDeadband *pd) {
     /* A valid deadband? */
     if(filter->deadbandValue < 0.0 || filter->deadbandValue > 100.0)
         return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
@@ -46,31 +48,19 @@ setAbsoluteFromPercentageDeadband(UA_Server *server, UA_Session *session,
         return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
     }
 
-    /* Read the range */
-    UA_ReadValueId rvi;
-    UA_ReadValueId_init(&rvi);
-    rvi.nodeId = bpr.targets->targetId.nodeId;
-    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
-    UA_DataValue rangeVal =
-        readWithSession(server, session, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    /* Move the NodeId of the EURange property into the PercentDeadband */
+    pd->percent = filter->deadbandValue;
+    pd->euRangeId = bpr.targets->targetId.nodeId;
+    pd->euRangeGeneration = server->euRangeGeneration;
+    UA_NodeId_init(&bpr.targets->targetId.nodeId);
     UA_BrowsePathResult_clear(&bpr);
-    if(!UA_Variant_isScalar(&rangeVal.value) ||
-       rangeVal.value.type != &UA_TYPES[UA_TYPES_RANGE]) {
-        UA_DataValue_clear(&rangeVal);
-        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
-    }
 
     /* Compute the abs deadband */
-    UA_Range *euRange = (UA_Range *)rangeVal.value.data;
-    UA_Double absDeadband =
-        (filter->deadbandValue / 100.0) * (euRange->high - euRange->low);
-
-    UA_DataValue_clear(&rangeVal);
-
-    /* EURange invalid or NaN? */
-    if(absDeadband < 0.0 || absDeadband != absDeadband) {
-        UA_DataValue_clear(&rangeVal);
-        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
+    UA_Double absDeadband;
+    UA_StatusCode res = UA_PercentDeadband_compute(server, session, pd, &absDeadband);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&pd->euRangeId);
+        return res;
     }
 
     /* Adjust the original filter */
@@ -218,7 +208,8 @@ static UA_StatusCode
 checkAdjustMonitoredItemParams(UA_Server *server, UA_Session *session,
                                const UA_MonitoredItem *mon, const UA_DataType *valueType,
                                UA_MonitoringParameters *params,
-                               UA_ExtensionObject *filterResult) {
+                               UA_ExtensionObject *filterResult,
+                               UA_PercentDeadband *pd) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Check the filter */
@@ -266,7 +257,8 @@ checkAdjustMonitoredItemParams(UA_Server *server, UA_Session *session,
                     /* If percentage deadband is supported, look up the range values
                      * and precompute as if it was an absolute deadband. */
                     UA_StatusCode res =
-                        setAbsoluteFromPercentageDeadband(server, session, mon, filter);
+                        setAbsoluteFromPercentageDeadband(server, session, mon,
+                                                          filter, pd);
                     if(res != UA_STATUSCODE_GOOD)
                         return res;
                     break;
@@ -387,7 +379,10 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
      * - The Node does not exist
      * - The AttributeId does not match the NodeClass
      * - The Session does not have sufficient access rights
-     * - The indicated encoding is not supported or not valid */
+     * - The indicated encoding is not supported or not valid
+     *
+     * The value is then reused as the first sample. So every item is read only
+     * once during the creation. */
     UA_DataValue v = readWithSession(server, session, &request->itemToMonitor,
                                      cmc->timestampsToReturn);
     if(v.hasStatus && (v.status == UA_STATUSCODE_BADNODEIDUNKNOWN ||
@@ -434,7 +429,6 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
 #endif
 
     const UA_DataType *valueType = v.value.type;
-    UA_DataValue_clear(&v);
 
     /* Allocate the MonitoredItem */
     UA_MonitoredItem *newMon = NULL;
@@ -442,9 +436,11 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
         newMon = &cmc->localMon->monitoredItem;
         cmc->localMon = NULL; /* clean up internally from now on */
     } else {
-        newMon = (UA_MonitoredItem *)UA_malloc(sizeof(UA_MonitoredItem));
+        newMon = (UA_MonitoredItem *)
+            UA_POOL_ALLOC(&server->pools.monitoredItems, sizeof(UA_MonitoredItem));
         if(!newMon) {
-            result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+            result->statusCode = UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYMONITOREDITEMS);
+            UA_DataValue_clear(&v);
             return;
         }
     }
@@ -458,13 +454,15 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
     result->statusCode |=
         UA_MonitoringParameters_copy(&request->requestedParameters, &newMon->parameters);
     result->statusCode |= checkAdjustMonitoredItemParams(
-        server, session, newMon, valueType, &newMon->parameters, &result->filterResult);
+        server, session, newMon, valueType, &newMon->parameters,
+        &result->filterResult, &newMon->percentDeadband);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO_SUBSCRIPTION(server->config.logging, cmc->sub,
                                  "Could not create a MonitoredItem "
                                  "with StatusCode %s",
                                  UA_StatusCode_name(result->statusCode));
         UA_MonitoredItem_delete(server, newMon);
+        UA_DataValue_clear(&v);
         return;
     }
 
@@ -475,9 +473,9 @@ Operation_CreateMonitoredItem(UA_Server *server, UA_Session *session,
     /* Register the Monitoreditem in the server and subscription */
     UA_Server_registerMonitoredItem(server, newMon);
 
-    /* Activate the MonitoredItem */
+    /* Activate the MonitoredItem. This consumes the sample. */
     result->statusCode =
-        UA_MonitoredItem_setMonitoringMode(server, newMon, request->monitoringMode);
+        UA_MonitoredItem_setMonitoringMode(server, newMon, request->monitoringMode, &v);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_MonitoredItem_delete(server, newMon);
         return;
@@ -542,16 +540,17 @@ Service_CreateMonitoredItems(UA_Server *server, UA_Session *session,
         &response->resultsSize, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATERESULT]);
 }
 
-UA_MonitoredItemCreateResult
-UA_Server_createDataChangeMonitoredItem(
-    UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
-    const UA_MonitoredItemCreateRequest item, void *monitoredItemContext,
-    UA_Server_DataChangeNotificationCallback callback) {
+static UA_MonitoredItemCreateResult
+createDataChangeMonitoredItem(UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+                              const UA_MonitoredItemCreateRequest *item,
+                              void *monitoredItemContext,
+                              UA_Server_DataChangeNotificationCallback callback,
+                              UA_Boolean direct) {
     UA_MonitoredItemCreateResult result;
     UA_MonitoredItemCreateResult_init(&result);
 
     /* Check that we don't use the DataChange callback for events */
-    if(item.itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
+    if(item->itemToMonitor.attributeId == UA_ATTRIBUTEID_EVENTNOTIFIER) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_SERVER,
                      "DataChange-MonitoredItem cannot be created for the "
                      "EventNotifier attribute");
@@ -560,14 +559,15 @@ UA_Server_createDataChangeMonitoredItem(
     }
 
     /* Pre-allocate the local MonitoredItem structure */
-    UA_LocalMonitoredItem *localMon =
-        (UA_LocalMonitoredItem *)UA_calloc(1, sizeof(UA_LocalMonitoredItem));
+    UA_LocalMonitoredItem *localMon = (UA_LocalMonitoredItem *)
+        UA_POOL_ALLOC(&server->pools.monitoredItems, sizeof(UA_LocalMonitoredItem));
     if(!localMon) {
-        result.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+        result.statusCode = UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYMONITOREDITEMS);
         return result;
     }
     localMon->context = monitoredItemContext;
     localMon->callback.dataChangeCallback = callback;
+    localMon->direct = direct;
 
     /* Call the service */
     struct createMonContext cmc;
@@ -576,16 +576,34 @@ UA_Server_createDataChangeMonitoredItem(
     cmc.timestampsToReturn = timestampsToReturn;
 
     UA_LOCK(&server->serviceMutex);
-    Operation_CreateMonitoredItem(server, &server->adminSession, &cmc, &item, &result);
+    Operation_CreateMonitoredItem(server, &server->adminSession, &cmc, item, &result);
     UA_UNLOCK(&server->serviceMutex);
 
     /* If this failed, clean up the local MonitoredItem structure */
     if(result.statusCode != UA_STATUSCODE_GOOD && cmc.localMon)
-        UA_free(localMon);
+        UA_POOL_FREE(localMon);
 
     return result;
 }
 
+UA_MonitoredItemCreateResult
+UA_Server_createDataChangeMonitoredItem(
+    UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+    const UA_MonitoredItemCreateRequest item, void *monitoredItemContext,
+    UA_Server_DataChangeNotificationCallback callback) {
+    return createDataChangeMonitoredItem(server, timestampsToReturn, &item,
+                                         monitoredItemContext, callback, false);
+}
+
+UA_MonitoredItemCreateResult
+UA_Server_createDataChangeMonitoredItemDirect(
+    UA_Server *server, UA_TimestampsToReturn timestampsToReturn,
+    const UA_MonitoredItemCreateRequest item, void *monitoredItemContext,
+    UA_Server_DataChangeNotificationCallback callback) {
+    return createDataChangeMonitoredItem(server, timestampsToReturn, &item,
+                                         monitoredItemContext, callback, true);
+}
+
 UA_MonitoredItemCreateResult
 UA_Server_createEventMonitoredItemEx(UA_Server *server,
                                      const UA_MonitoredItemCreateRequest item,
@@ -621,10 +639,10 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     }
 
     /* Pre-allocate the local MonitoredItem structure */
-    UA_LocalMonitoredItem *localMon =
-        (UA_LocalMonitoredItem *)UA_calloc(1, sizeof(UA_LocalMonitoredItem));
+    UA_LocalMonitoredItem *localMon = (UA_LocalMonitoredItem *)
+        UA_POOL_ALLOC(&server->pools.monitoredItems, sizeof(UA_LocalMonitoredItem));
     if(!localMon) {
-        result.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+        result.statusCode = UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYMONITOREDITEMS);
         return result;
     }
     localMon->context = monitoredItemContext;
@@ -634,7 +652,7 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     localMon->eventFields.map =
         (UA_KeyValuePair *)UA_calloc(ef->selectClausesSize, sizeof(UA_KeyValuePair));
     if(!localMon->eventFields.map) {
-        UA_free(localMon);
+        UA_POOL_FREE(localMon);
         result.statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
         return result;
     }
@@ -647,7 +665,7 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     }
     if(result.statusCode != UA_STATUSCODE_GOOD) {
         UA_KeyValueMap_clear(&localMon->eventFields);
-        UA_free(localMon);
+        UA_POOL_FREE(localMon);
         return result;
     }
 #endif
@@ -665,7 +683,7 @@ UA_Server_createEventMonitoredItemEx(UA_Server *server,
     /* If the service failed, clean up the local MonitoredItem structure */
     if(result.statusCode != UA_STATUSCODE_GOOD && cmc.localMon) {
         UA_KeyValueMap_clear(&localMon->eventFields);
-        UA_free(localMon);
+        UA_POOL_FREE(localMon);
     }
     return result;
 }
@@ -714,11 +732,14 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session,
 
     /* Verify and adjust the new parameters. This still leaves the original
      * MonitoredItem untouched. */
+    UA_PercentDeadband pd;
+    memset(&pd, 0, sizeof(UA_PercentDeadband));
     result->statusCode = checkAdjustMonitoredItemParams(
-        server, session, mon, v.value.type, &params, &result->filterResult);
+        server, session, mon, v.value.type, &params, &result->filterResult, &pd);
     UA_DataValue_clear(&v);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_MonitoringParameters_clear(&params);
+        UA_NodeId_clear(&pd.euRangeId);
         return;
     }
 
@@ -728,12 +749,14 @@ Operation_ModifyMonitoredItem(UA_Server *server, UA_Session *session,
     /* Move over the new settings */
     UA_MonitoringParameters_clear(&mon->parameters);
     mon->parameters = params;
+    UA_NodeId_clear(&mon->percentDeadband.euRangeId);
+    mon->percentDeadband = pd;
 
     /* Re-register the callback if necessary */
     if(oldSamplingInterval != mon->parameters.samplingInterval) {
         UA_MonitoredItem_unregisterSampling(server, mon);
         result->statusCode =
-            UA_MonitoredItem_setMonitoringMode(server, mon, mon->monitoringMode);
+            UA_MonitoredItem_setMonitoringMode(server, mon, mon->monitoringMode, NULL);
     }
 
     result->revisedSamplingInterval = mon->parameters.samplingInterval;
@@ -821,7 +844,7 @@ Operation_SetMonitoringMode(UA_Server *server, UA_Session *session,
         *result = UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
         return;
     }
-    *result = UA_MonitoredItem_setMonitoringMode(server, mon, smc->monitoringMode);
+    *result = UA_MonitoredItem_setMonitoringMode(server, mon, smc->monitoringMode, NULL);
 }
 
 void
@@ -925,4 +948,34 @@ UA_Server_deleteMonitoredItem(UA_Server *server, UA_UInt32 monitoredItemId) {
     return res;
 }
 
+UA_StatusCode
+UA_Server_notifyValueChanged(UA_Server *server, const UA_NodeId nodeId) {
+    UA_LOCK(&server->serviceMutex);
+    invalidateDataSourceCache(server, &nodeId);
+    const UA_Node *node = UA_NODESTORE_GET(server, &nodeId);
+    if(!node) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    }
+
+    /* Sample the MonitoredItems with no SamplingInterval */
+    UA_MonitoredItem *mon = node->head.monitoredItems;
+    for(; mon != NULL; mon = mon->sampling.nodeListNext) {
+        if(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_VALUE)
+            continue;
+        UA_Subscription *sub = mon->subscription;
+        UA_Session *session = (sub) ? sub->session : &server->adminSession;
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        ReadWithNode(node, server, session, mon->timestampsToReturn,
+                     &mon->itemToMonitor, &value);
+        UA_MonitoredItem_processSampledValue(server, mon, &value);
+    }
+
+    UA_Node_markSamplingGroupsDirty(node);
+    UA_NODESTORE_RELEASE(server, node);
+    UA_UNLOCK(&server->serviceMutex);
+    return UA_STATUSCODE_GOOD;
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
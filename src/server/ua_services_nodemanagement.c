@@ -536,7 +536,12 @@ isMandatoryChild(UA_Server *server, UA_Session *session,
 
 static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
-                const UA_NodeId *source, const UA_NodeId *destination);
+                const UA_NodeId *source, const UA_NodeId *destination,
+                UA_Boolean deferConstructors);
+
+static UA_StatusCode
+finishNode(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+           UA_Boolean deferConstructors);
 
 static void
 Operation_addReference(UA_Server *server, UA_Session *session, void *context,
@@ -568,7 +573,8 @@ addRef(UA_Server *server, const UA_NodeId sourceId,
 
 static UA_StatusCode
 addInterfaceChildren(UA_Server *server, UA_Session *session,
-                     const UA_NodeId *nodeId, const UA_NodeId *typeId) {
+                     const UA_NodeId *nodeId, const UA_NodeId *typeId,
+                     UA_Boolean deferConstructors) {
     /* Get the hierarchy of the type and all its supertypes */
     UA_NodeId *hierarchy = NULL;
     size_t hierarchySize = 0;
@@ -579,7 +585,8 @@ addInterfaceChildren(UA_Server *server, UA_Session *session,
 
     /* Copy members of the type and supertypes (and instantiate them) */
     for(size_t i = 0; i < hierarchySize; ++i) {
-        retval = copyAllChildren(server, session, &hierarchy[i], nodeId);
+        retval = copyAllChildren(server, session, &hierarchy[i], nodeId,
+                                 deferConstructors);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_Array_delete(hierarchy, hierarchySize, &UA_TYPES[UA_TYPES_NODEID]);
             return retval;
@@ -602,27 +609,33 @@ addInterfaceChildren(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+/* If deferConstructors is set, the destination is constructed later together
+ * with all new children. Otherwise the new children are constructed right
+ * away. */
 static UA_StatusCode
 copyChild(UA_Server *server, UA_Session *session,
           const UA_NodeId *destinationNodeId,
-          const UA_ReferenceDescription *rd) {
+          const UA_ReferenceDescription *rd, const UA_NodeId *existingChild,
+          UA_Boolean keepModellingRules, UA_Boolean deferConstructors) {
     UA_assert(session);
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    /* Is there an existing child with the browsename? */
-    UA_NodeId existingChild = UA_NODEID_NULL;
-    UA_StatusCode retval = findChildByBrowsename(server, session, destinationNodeId,
-                                                 &rd->browseName, &existingChild);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
-
-    /* Have a child with that browseName. Deep-copy missing members. */
-    if(!UA_NodeId_isNull(&existingChild)) {
-        if(rd->nodeClass == UA_NODECLASS_VARIABLE ||
-           rd->nodeClass == UA_NODECLASS_OBJECT)
-            retval = copyAllChildren(server, session, &rd->nodeId.nodeId, &existingChild);
-        UA_NodeId_clear(&existingChild);
-        return retval;
+    /* Have a child with that browseName. Deep-copy missing members. The new
+     * members can be constructed later only if the existing child is not
+     * constructed yet. */
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(existingChild) {
+        if(rd->nodeClass != UA_NODECLASS_VARIABLE &&
+           rd->nodeClass != UA_NODECLASS_OBJECT)
+            return UA_STATUSCODE_GOOD;
+        UA_Boolean deferChildren = false;
+        if(deferConstructors) {
+            const UA_Node *child = UA_NODESTORE_GET(server, existingChild);
+            deferChildren = (child && !child->head.constructed);
+            UA_NODESTORE_RELEASE(server, child);
+        }
+        return copyAllChildren(server, session, &rd->nodeId.nodeId,
+                               existingChild, deferChildren);
     }
 
     /* Is the child mandatory? If not, ask callback whether child should be instantiated.
@@ -699,20 +712,14 @@ copyChild(UA_Server *server, UA_Session *session,
         /* TODO: Be more clever in removing references that are re-added during
          * addnode_finish. That way, we can call addnode_finish also on children that were
          * manually added by the user during addnode_begin and addnode_finish. */
-        /* For now we keep all the modelling rule references and delete all others */
-        const UA_NodeId nodeId_typesFolder= UA_NODEID_NUMERIC(0, UA_NS0ID_TYPESFOLDER);
-        const UA_ReferenceTypeSet reftypes_aggregates =
-            UA_REFTYPESET(UA_REFERENCETYPEINDEX_AGGREGATES);
+        /* For now we keep all the modelling rule references and delete all
+         * others. The hasModellingRule-reference is required if configured or
+         * if the node is in an instance declaration. */
         UA_ReferenceTypeSet reftypes_skipped;
-        /* Check if the hasModellingRule-reference is required (configured or node in an
-            instance declaration) */
-        if(server->config.modellingRulesOnInstances ||
-           isNodeInTree(server, destinationNodeId,
-                        &nodeId_typesFolder, &reftypes_aggregates)) {
+        if(keepModellingRules)
             reftypes_skipped = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASMODELLINGRULE);
-        } else {
+        else
             UA_ReferenceTypeSet_init(&reftypes_skipped);
-        }
         reftypes_skipped = UA_ReferenceTypeSet_union(reftypes_skipped, UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASINTERFACE));
         UA_Node_deleteReferencesSubset(node, &reftypes_skipped);
 
@@ -722,37 +729,31 @@ copyChild(UA_Server *server, UA_Session *session,
         /* node = NULL; The pointer is no longer valid */
         if(retval != UA_STATUSCODE_GOOD)
             return retval;
+        invalidateBrowseCache(server);
 
         /* Add the node references */
         retval = addNode_addRefs(server, session, &newNodeId, destinationNodeId,
                                  &rd->referenceTypeId, &rd->typeDefinition.nodeId);
         if(retval != UA_STATUSCODE_GOOD) {
+            invalidateTypeHierarchy(server, &newNodeId);
             UA_NODESTORE_REMOVE(server, &newNodeId);
             UA_NodeId_clear(&newNodeId);
             return retval;
         }
 
-        if (rd->nodeClass == UA_NODECLASS_VARIABLE) {
-            retval = checkSetIsDynamicVariable(server, session, &newNodeId);
-
-            if(retval != UA_STATUSCODE_GOOD) {
-                UA_NODESTORE_REMOVE(server, &newNodeId);
-                return retval;
-            }
-        }
-
         /* For the new child, recursively copy the members of the original. No
          * typechecking is performed here. Assuming that the original is
-         * consistent. */
-        retval = copyAllChildren(server, session, &rd->nodeId.nodeId, &newNodeId);
+         * consistent. The new child is not constructed yet. So the
+         * constructors of its members are always deferred. */
+        retval = copyAllChildren(server, session, &rd->nodeId.nodeId, &newNodeId, true);
         if(retval != UA_STATUSCODE_GOOD) {
             deleteNode(server, newNodeId, true);
             return retval;
         }
 
         /* Check if its a dynamic variable, add all type and/or interface
-         * children and call the constructor */
-        retval = addNode_finish(server, session, &newNodeId);
+         * children and call the constructor (unless deferred) */
+        retval = finishNode(server, session, &newNodeId, deferConstructors);
         if(retval != UA_STATUSCODE_GOOD) {
             deleteNode(server, newNodeId, true);
             return retval;
@@ -766,10 +767,22 @@ copyChild(UA_Server *server, UA_Session *session,
     return retval;
 }
 
+static const UA_NodeId *
+findBrowseName(const UA_ReferenceDescription *refs, size_t refsSize,
+               const UA_QualifiedName *browseName) {
+    for(size_t i = 0; i < refsSize; ++i) {
+        if(refs[i].browseName.namespaceIndex == browseName->namespaceIndex &&
+           UA_String_equal(&refs[i].browseName.name, &browseName->name))
+            return &refs[i].nodeId.nodeId;
+    }
+    return NULL;
+}
+
 /* Copy any children of Node sourceNodeId to another node destinationNodeId. */
 static UA_StatusCode
 copyAllChildren(UA_Server *server, UA_Session *session,
-                const UA_NodeId *source, const UA_NodeId *destination) {
+                const UA_NodeId *source, const UA_NodeId *destination,
+                UA_Boolean deferConstructors) {
     /* Browse to get all children of the source */
     UA_BrowseDescription bd;
     UA_BrowseDescription_init(&bd);
@@ -788,21 +801,64 @@ copyAllChildren(UA_Server *server, UA_Session *session,
     if(br.statusCode != UA_STATUSCODE_GOOD)
         return br.statusCode;
 
-    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(br.referencesSize == 0) {
+        UA_BrowseResult_clear(&br);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Get the existing children of the destination once. Instead of browsing
+     * the destination again for every child. */
+    UA_BrowseResult existing;
+    UA_BrowseResult_init(&existing);
+    bd.nodeId = *destination;
+    bd.resultMask = UA_BROWSERESULTMASK_BROWSENAME;
+    Operation_Browse(server, session, &maxrefs, &bd, &existing);
+    UA_StatusCode retval = existing.statusCode;
+    if(retval != UA_STATUSCODE_GOOD)
+        goto cleanup;
+
+    /* The same for all children of the destination */
+    const UA_NodeId nodeId_typesFolder = UA_NODEID_NUMERIC(0, UA_NS0ID_TYPESFOLDER);
+    const UA_ReferenceTypeSet reftypes_aggregates =
+        UA_REFTYPESET(UA_REFERENCETYPEINDEX_AGGREGATES);
+    UA_Boolean keepModellingRules = server->config.modellingRulesOnInstances ||
+        isNodeInTree(server, destination, &nodeId_typesFolder, &reftypes_aggregates);
+
     for(size_t i = 0; i < br.referencesSize; ++i) {
         UA_ReferenceDescription *rd = &br.references[i];
-        retval = copyChild(server, session, destination, rd);
+
+        /* Is there an existing child with the browsename? If a previous child
+         * has the same browsename, the destination has to be browsed again to
+         * see the new node. */
+        UA_NodeId found = UA_NODEID_NULL;
+        const UA_NodeId *existingChild =
+            findBrowseName(existing.references, existing.referencesSize, &rd->browseName);
+        if(!existingChild && findBrowseName(br.references, i, &rd->browseName)) {
+            retval = findChildByBrowsename(server, session, destination,
+                                           &rd->browseName, &found);
+            if(retval != UA_STATUSCODE_GOOD)
+                break;
+            if(!UA_NodeId_isNull(&found))
+                existingChild = &found;
+        }
+
+        retval = copyChild(server, session, destination, rd, existingChild,
+                           keepModellingRules, deferConstructors);
+        UA_NodeId_clear(&found);
         if(retval != UA_STATUSCODE_GOOD)
             break;
     }
 
+ cleanup:
+    UA_BrowseResult_clear(&existing);
     UA_BrowseResult_clear(&br);
     return retval;
 }
 
 static UA_StatusCode
 addTypeChildren(UA_Server *server, UA_Session *session,
-                const UA_NodeId *nodeId, const UA_NodeId *typeId) {
+                const UA_NodeId *nodeId, const UA_NodeId *typeId,
+                UA_Boolean deferConstructors) {
     /* Get the hierarchy of the type and all its supertypes */
     UA_NodeId *hierarchy = NULL;
     size_t hierarchySize = 0;
@@ -814,7 +870,8 @@ addTypeChildren(UA_Server *server, UA_Session *session,
 
     /* Copy members of the type and supertypes (and instantiate them) */
     for(size_t i = 0; i < hierarchySize; ++i) {
-        retval = copyAllChildren(server, session, &hierarchy[i], nodeId);
+        retval = copyAllChildren(server, session, &hierarchy[i], nodeId,
+                                 deferConstructors);
         if(retval != UA_STATUSCODE_GOOD)
             break;
     }
@@ -1076,7 +1133,7 @@ addNode_raw(UA_Server *server, UA_Session *session, void *nodeContext,
     if(retval != UA_STATUSCODE_GOOD)
         goto create_error;
 
-    retval = UA_QualifiedName_copy(&item->browseName, &node->head.browseName);
+    retval = UA_Node_setBrowseName(&node->head, &item->browseName);
     if(retval != UA_STATUSCODE_GOOD)
         goto create_error;
 
@@ -1104,6 +1161,7 @@ addNode_raw(UA_Server *server, UA_Session *session, void *nodeContext,
                             UA_StatusCode_name(retval));
         return retval;
     }
+    invalidateBrowseCache(server);
 
     if(outNewNodeId == &tmpOutId)
         UA_NodeId_clear(&tmpOutId);
@@ -1352,7 +1410,7 @@ addReferenceTypeSubtype(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
-static UA_StatusCode
+UA_StatusCode
 setReferenceTypeSubtypes(UA_Server *server, const UA_ReferenceTypeNode *node) {
     /* Get the ReferenceTypes upwards in the hierarchy */
     size_t parentsSize = 0;
@@ -1444,9 +1502,13 @@ UA_Server_setVariableNodeDynamic(UA_Server *server, const UA_NodeId nodeId,
     return res;
 }
 
-/* Children, references, type-checking, constructors. */
-UA_StatusCode
-addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
+/* Children, references, type-checking, constructors. The constructors of the
+ * new children are deferred and called in one pass over the subtree when the
+ * node itself is constructed. With deferConstructors, the node is left
+ * unconstructed for the constructor pass of its parent. */
+static UA_StatusCode
+finishNode(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+           UA_Boolean deferConstructors) {
     /* Get the node */
     const UA_Node *type = NULL;
     const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
@@ -1549,7 +1611,8 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
     /* Add (mandatory) child nodes from the type definition */
     if(node->head.nodeClass == UA_NODECLASS_VARIABLE ||
        node->head.nodeClass == UA_NODECLASS_OBJECT) {
-        retval = addTypeChildren(server, session, nodeId, &type->head.nodeId);
+        retval = addTypeChildren(server, session, nodeId, &type->head.nodeId,
+                                 !node->head.constructed);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_NODEID_INFO(&node->head.nodeId,
             UA_LOG_INFO_SESSION(server->config.logging, session,
@@ -1562,7 +1625,8 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
 
     /* Add (mandatory) child nodes from the HasInterface references */
     if(node->head.nodeClass == UA_NODECLASS_OBJECT) {
-        retval = addInterfaceChildren(server, session, nodeId, &type->head.nodeId);
+        retval = addInterfaceChildren(server, session, nodeId, &type->head.nodeId,
+                                      !node->head.constructed);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_NODEID_INFO(&node->head.nodeId,
             UA_LOG_INFO_SESSION(server->config.logging, session,
@@ -1576,7 +1640,7 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
 
     /* Call the constructor(s) */
  constructor:
-    if(!node->head.constructed)
+    if(!deferConstructors && !node->head.constructed)
         retval = recursiveCallConstructors(server, session, nodeId, type);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_NODEID_INFO(&node->head.nodeId,
@@ -1586,6 +1650,12 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
                             nodeIdStr.data, UA_StatusCode_name(retval)));
     }
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(retval == UA_STATUSCODE_GOOD)
+        addModelChange(server, nodeId, (type) ? &type->head.nodeId : NULL,
+                       UA_MODELCHANGEVERB_NODEADDED);
+#endif
+
  cleanup:
     if(type)
         UA_NODESTORE_RELEASE(server, type);
@@ -1596,6 +1666,11 @@ addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId)
     return retval;
 }
 
+UA_StatusCode
+addNode_finish(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId) {
+    return finishNode(server, session, nodeId, false);
+}
+
 static void
 Operation_addNode(UA_Server *server, UA_Session *session, void *nodeContext,
                   const UA_AddNodesItem *item, UA_AddNodesResult *result) {
@@ -1741,6 +1816,7 @@ struct RemoveIncomingContext {
     UA_Server *server;
     UA_Session *session;
     UA_DeleteReferencesItem *item;
+    RefTree *deleted;
 };
 
 static void *
@@ -1748,16 +1824,20 @@ removeIncomingReferencesCallback(void *context, UA_ReferenceTarget *t) {
     struct RemoveIncomingContext *ctx = (struct RemoveIncomingContext *)context;
     if(!UA_NodePointer_isLocal(t->targetId))
         return NULL;
-    UA_StatusCode dummy;
     ctx->item->sourceNodeId = UA_NodePointer_toNodeId(t->targetId);
+    /* The target is removed as well. Don't edit it. */
+    if(ctx->deleted && RefTree_containsNodeId(ctx->deleted, &ctx->item->sourceNodeId))
+        return NULL;
+    UA_StatusCode dummy;
     Operation_deleteReference(ctx->server, ctx->session, NULL, ctx->item, &dummy);
     return NULL;
 }
 
-/* Remove references to this node (in the other nodes) */
+/* Remove references to this node (in the other nodes). Nodes in the deleted
+ * set are skipped. */
 static void
 removeIncomingReferences(UA_Server *server, UA_Session *session,
-                         const UA_NodeHead *head) {
+                         const UA_NodeHead *head, RefTree *deleted) {
     UA_DeleteReferencesItem item;
     UA_DeleteReferencesItem_init(&item);
     item.targetNodeId.nodeId = head->nodeId;
@@ -1767,6 +1847,7 @@ removeIncomingReferences(UA_Server *server, UA_Session *session,
     ctx.server = server;
     ctx.session = session;
     ctx.item = &item;
+    ctx.deleted = deleted;
 
     for(size_t i = 0; i < head->referencesSize; ++i) {
         UA_NodeReferenceKind *rk = &head->references[i];
@@ -1946,16 +2027,29 @@ static void
 deleteNodeSet(UA_Server *server, UA_Session *session,
               const UA_ReferenceTypeSet *hierarchRefsSet,
               UA_Boolean removeTargetRefs, RefTree *refTree) {
-    /* Delete the nodes based on the RefTree entries */
+    /* Delete the nodes based on the RefTree entries. The references between
+     * members of the set are removed together with the nodes. Only the nodes
+     * outside of the set are edited to remove their references into the
+     * set. The service lock is held for the entire set. So other operations
+     * never see a partially deleted subtree. */
     for(size_t i = refTree->size; i > 0; --i) {
-        const UA_Node *member = UA_NODESTORE_GET(server, &refTree->targets[i-1].nodeId);
+        const UA_NodeId *memberId = &refTree->targets[i-1].nodeId;
+        const UA_Node *member = UA_NODESTORE_GET(server, memberId);
         if(!member)
             continue;
-        UA_NODESTORE_RELEASE(server, member);
         if(removeTargetRefs)
-            removeIncomingReferences(server, session, &member->head);
-        UA_NODESTORE_REMOVE(server, &member->head.nodeId);
+            removeIncomingReferences(server, session, &member->head, refTree);
+        UA_NODESTORE_RELEASE(server, member);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+        addModelChange(server, memberId, NULL, UA_MODELCHANGEVERB_NODEDELETED);
+#endif
+        if(server->config.accessControl.cacheDecisions)
+            invalidateAccessCache(server, NULL, memberId);
+        invalidateTypeHierarchy(server, memberId);
+        removeDataSourceCache(server, memberId);
+        UA_NODESTORE_REMOVE(server, memberId);
     }
+    invalidateBrowseCache(server);
 }
 
 static void
@@ -2088,11 +2182,27 @@ struct AddNodeInfo {
     UA_UInt32 targetBrowseNameHash;
 };
 
+/* The node with the inverse HasSubtype reference is the subtype */
+static void
+invalidateSubtype(UA_Server *server, UA_Node *node, UA_Byte refTypeIndex,
+                  UA_Boolean isForward, const UA_ExpandedNodeId *target) {
+    if(refTypeIndex != UA_REFERENCETYPEINDEX_HASSUBTYPE)
+        return;
+    invalidateTypeHierarchy(server, (isForward) ? &target->nodeId : &node->head.nodeId);
+}
+
 static UA_StatusCode
 addOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
                    const struct AddNodeInfo *info) {
-    return UA_Node_addReference(node, info->refTypeIndex, info->isForward,
-                                info->targetNodeId, info->targetBrowseNameHash);
+    UA_StatusCode res =
+        UA_Node_addReference(node, info->refTypeIndex, info->isForward,
+                             info->targetNodeId, info->targetBrowseNameHash);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    invalidateBrowseCache(server);
+    invalidateSubtype(server, node, info->refTypeIndex, info->isForward,
+                      info->targetNodeId);
+    return UA_STATUSCODE_GOOD;
 }
 
 static UA_StatusCode
@@ -2107,7 +2217,13 @@ deleteOneWayReference(UA_Server *server, UA_Session *session, UA_Node *node,
     }
     UA_Byte refTypeIndex = refType->referenceTypeNode.referenceTypeIndex;
     UA_NODESTORE_RELEASE(server, refType);
-    return UA_Node_deleteReference(node, refTypeIndex, item->isForward, &item->targetNodeId);
+    UA_StatusCode res =
+        UA_Node_deleteReference(node, refTypeIndex, item->isForward, &item->targetNodeId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    invalidateBrowseCache(server);
+    invalidateSubtype(server, node, refTypeIndex, item->isForward, &item->targetNodeId);
+    return UA_STATUSCODE_GOOD;
 }
 
 static void
@@ -2233,7 +2349,18 @@ Operation_addReference(UA_Server *server, UA_Session *session, void *context,
         /* Ignore status code */
         UA_Server_editNode(server, session, &item->sourceNodeId,
                            (UA_EditNodeCallback)deleteOneWayReference, &deleteItem);
+        return;
     }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    /* Both nodes have a new reference */
+    if(*retval == UA_STATUSCODE_GOOD) {
+        addModelChange(server, &item->sourceNodeId, NULL,
+                       UA_MODELCHANGEVERB_REFERENCEADDED);
+        addModelChange(server, &item->targetNodeId.nodeId, NULL,
+                       UA_MODELCHANGEVERB_REFERENCEADDED);
+    }
+#endif
 }
 
 void
@@ -2310,6 +2437,11 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     if(*retval != UA_STATUSCODE_GOOD)
         return;
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    addModelChange(server, &item->sourceNodeId, NULL,
+                   UA_MODELCHANGEVERB_REFERENCEDELETED);
+#endif
+
     if(!item->deleteBidirectional || item->targetNodeId.serverIndex != 0)
         return;
 
@@ -2322,6 +2454,11 @@ Operation_deleteReference(UA_Server *server, UA_Session *session, void *context,
     *retval = UA_Server_editNode(server, session, &secondItem.sourceNodeId,
                                  (UA_EditNodeCallback)deleteOneWayReference,
                                  &secondItem);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(*retval == UA_STATUSCODE_GOOD)
+        addModelChange(server, &secondItem.sourceNodeId, NULL,
+                       UA_MODELCHANGEVERB_REFERENCEDELETED);
+#endif
 }
 
 void
@@ -2488,6 +2625,7 @@ UA_StatusCode
 setVariableNode_dataSource(UA_Server *server, const UA_NodeId nodeId,
                            const UA_DataSource dataSource) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    invalidateDataSourceCache(server, &nodeId);
     return UA_Server_editNode(server, &server->adminSession, &nodeId,
                               (UA_EditNodeCallback)setDataSource,
                               /* casting away const because callback casts it back anyway */
@@ -2816,6 +2954,28 @@ UA_Server_setMethodNodeCallback(UA_Server *server,
     return retVal;
 }
 
+static UA_StatusCode
+editMethodBatchCallback(UA_Server *server, UA_Session* session,
+                        UA_Node *node, UA_MethodBatchCallback batchCallback) {
+    if(node->head.nodeClass != UA_NODECLASS_METHOD)
+        return UA_STATUSCODE_BADNODECLASSINVALID;
+    node->methodNode.methodBatch = batchCallback;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+UA_Server_setMethodNodeBatchCallback(UA_Server *server,
+                                     const UA_NodeId methodNodeId,
+                                     UA_MethodBatchCallback batchCallback) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode retVal =
+        UA_Server_editNode(server, &server->adminSession, &methodNodeId,
+                           (UA_EditNodeCallback)editMethodBatchCallback,
+                           (void*)(uintptr_t)batchCallback);
+    UA_UNLOCK(&server->serviceMutex);
+    return retVal;
+}
+
 UA_StatusCode
 UA_Server_getMethodNodeCallback(UA_Server *server,
                                 const UA_NodeId methodNodeId,
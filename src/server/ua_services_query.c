@@ -0,0 +1,470 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ua_server_internal.h"
+#include "ua_services.h"
+
+#ifdef UA_ENABLE_QUERY
+
+/* The Query looks up the instances of the requested types without browsing the
+ * address space. The HasTypeDefinition references are stored in both
+ * directions. So every type node holds an inverse reference to each of its
+ * instances and the Nodestore maintains the type -> instances index when nodes
+ * are added and deleted. The instances are then checked against the
+ * ContentFilter with the evaluation engine of the EventFilter. The
+ * SimpleAttributeOperands are resolved relative to the instance.
+ *
+ * The candidates are collected in QueryFirst. They are evaluated until
+ * maxDataSetsToReturn results are found. The remaining candidates are kept in
+ * a ContinuationPoint for QueryNext. */
+
+typedef struct {
+    UA_NodeId nodeId;
+    UA_NodeId typeDefinition;
+    size_t nodeType; /* Index in the NodeTypeDescriptions */
+} QueryCandidate;
+
+struct QueryContinuationPoint {
+    QueryContinuationPoint *next;
+    UA_Guid identifier;
+
+    /* Only the NodeTypeDescriptions, the filter and the limits are used */
+    UA_QueryFirstRequest request;
+
+    size_t candidatesPos;
+    size_t candidatesSize;
+    QueryCandidate *candidates;
+};
+
+QueryContinuationPoint *
+QueryContinuationPoint_clear(QueryContinuationPoint *cp) {
+    QueryContinuationPoint *next = cp->next;
+    UA_QueryFirstRequest_clear(&cp->request);
+    for(size_t i = 0; i < cp->candidatesSize; i++) {
+        UA_NodeId_clear(&cp->candidates[i].nodeId);
+        UA_NodeId_clear(&cp->candidates[i].typeDefinition);
+    }
+    UA_free(cp->candidates);
+    return next;
+}
+
+/*************************/
+/* Collect the Instances */
+/*************************/
+
+typedef struct {
+    QueryContinuationPoint *cp;
+    const UA_NodeId *typeDefinition;
+    size_t nodeType;
+    UA_StatusCode res;
+} CollectContext;
+
+static void *
+collectInstance(void *context, UA_ReferenceTarget *t) {
+    CollectContext *cc = (CollectContext*)context;
+    if(!UA_NodePointer_isLocal(t->targetId))
+        return NULL;
+    QueryContinuationPoint *cp = cc->cp;
+    QueryCandidate *c = (QueryCandidate*)
+        UA_realloc(cp->candidates, sizeof(QueryCandidate) * (cp->candidatesSize + 1));
+    if(!c) {
+        cc->res = UA_STATUSCODE_BADOUTOFMEMORY;
+        return cc; /* Abort the iteration */
+    }
+    cp->candidates = c;
+    c = &c[cp->candidatesSize];
+    UA_NodeId id = UA_NodePointer_toNodeId(t->targetId);
+    cc->res = UA_NodeId_copy(&id, &c->nodeId);
+    cc->res |= UA_NodeId_copy(cc->typeDefinition, &c->typeDefinition);
+    if(cc->res != UA_STATUSCODE_GOOD) {
+        UA_NodeId_clear(&c->nodeId);
+        UA_NodeId_clear(&c->typeDefinition);
+        return cc;
+    }
+    c->nodeType = cc->nodeType;
+    cp->candidatesSize++;
+    return NULL;
+}
+
+/* Add the instances of the type node (without subtypes) */
+static UA_StatusCode
+collectTypeInstances(UA_Server *server, QueryContinuationPoint *cp,
+                     const UA_NodeId *typeId, size_t nodeType) {
+    const UA_Node *type =
+        UA_NODESTORE_GET_SELECTIVE(server, typeId, UA_NODEATTRIBUTESMASK_NONE,
+                                   UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASTYPEDEFINITION),
+                                   UA_BROWSEDIRECTION_INVERSE);
+    if(!type)
+        return UA_STATUSCODE_GOOD;
+
+    CollectContext cc = {cp, typeId, nodeType, UA_STATUSCODE_GOOD};
+    for(size_t i = 0; i < type->head.referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &type->head.references[i];
+        if(!rk->isInverse ||
+           rk->referenceTypeIndex != UA_REFERENCETYPEINDEX_HASTYPEDEFINITION)
+            continue;
+        UA_NodeReferenceKind_iterate(rk, collectInstance, &cc);
+        if(cc.res != UA_STATUSCODE_GOOD)
+            break;
+    }
+    UA_NODESTORE_RELEASE(server, type);
+    return cc.res;
+}
+
+/* Returns the status for the ParsingResult of the NodeTypeDescription */
+static UA_StatusCode
+collectCandidates(UA_Server *server, QueryContinuationPoint *cp, size_t nodeType,
+                  UA_StatusCode *internalError) {
+    const UA_NodeTypeDescription *ntd = &cp->request.nodeTypes[nodeType];
+    if(!UA_ExpandedNodeId_isLocal(&ntd->typeDefinitionNode))
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    const UA_NodeId *typeId = &ntd->typeDefinitionNode.nodeId;
+
+    /* Only ObjectTypes and VariableTypes have instances */
+    const UA_Node *type =
+        UA_NODESTORE_GET_SELECTIVE(server, typeId, UA_NODEATTRIBUTESMASK_NODECLASS,
+                                   UA_REFERENCETYPESET_NONE, UA_BROWSEDIRECTION_INVALID);
+    if(!type)
+        return UA_STATUSCODE_BADNODEIDUNKNOWN;
+    UA_NodeClass nc = type->head.nodeClass;
+    UA_NODESTORE_RELEASE(server, type);
+    if(nc != UA_NODECLASS_OBJECTTYPE && nc != UA_NODECLASS_VARIABLETYPE)
+        return UA_STATUSCODE_BADTYPEDEFINITIONINVALID;
+
+    if(!ntd->includeSubTypes) {
+        *internalError = collectTypeInstances(server, cp, typeId, nodeType);
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Collect the instances of the type and its subtypes */
+    size_t typesSize = 0;
+    UA_ExpandedNodeId *types = NULL;
+    UA_ReferenceTypeSet subtypes = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    *internalError = browseRecursive(server, 1, typeId, UA_BROWSEDIRECTION_FORWARD,
+                                     &subtypes, UA_NODECLASS_UNSPECIFIED, true,
+                                     &typesSize, &types);
+    for(size_t i = 0; *internalError == UA_STATUSCODE_GOOD && i < typesSize; i++)
+        *internalError = collectTypeInstances(server, cp, &types[i].nodeId, nodeType);
+    UA_Array_delete(types, typesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+checkDataToReturn(const UA_NodeTypeDescription *ntd, UA_ParsingResult *pr) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < ntd->dataToReturnSize; i++) {
+        const UA_QueryDataDescription *qdd = &ntd->dataToReturn[i];
+        if(qdd->attributeId == 0 || qdd->attributeId > UA_ATTRIBUTEID_ACCESSLEVELEX)
+            res = UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+    }
+    if(res == UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Return the details */
+    pr->dataStatusCodes = (UA_StatusCode*)
+        UA_Array_new(ntd->dataToReturnSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    if(!pr->dataStatusCodes)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    pr->dataStatusCodesSize = ntd->dataToReturnSize;
+    for(size_t i = 0; i < ntd->dataToReturnSize; i++) {
+        const UA_QueryDataDescription *qdd = &ntd->dataToReturn[i];
+        if(qdd->attributeId == 0 || qdd->attributeId > UA_ATTRIBUTEID_ACCESSLEVELEX)
+            pr->dataStatusCodes[i] = UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+    }
+    return res;
+}
+
+/****************************/
+/* Evaluate the Candidates */
+/****************************/
+
+/* Read the value for the QueryDataDescription. A StatusCode is returned as the
+ * value if it cannot be read. */
+static void
+readDataToReturn(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+                 const UA_QueryDataDescription *qdd, UA_Variant *out) {
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = *nodeId;
+    rvi.attributeId = qdd->attributeId;
+    rvi.indexRange = qdd->indexRange;
+
+    /* Resolve the RelativePath */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_BrowsePathResult bpr;
+    UA_BrowsePathResult_init(&bpr);
+    if(qdd->relativePath.elementsSize > 0) {
+        UA_BrowsePath bp;
+        bp.startingNode = *nodeId;
+        bp.relativePath = qdd->relativePath;
+        bpr = translateBrowsePathToNodeIds(server, &bp);
+        res = bpr.statusCode;
+        if(res == UA_STATUSCODE_GOOD && bpr.targetsSize == 0)
+            res = UA_STATUSCODE_BADNOMATCH;
+        if(res == UA_STATUSCODE_GOOD)
+            rvi.nodeId = bpr.targets[0].targetId.nodeId;
+    }
+
+    /* Read */
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_DataValue dv = readWithSession(server, session, &rvi,
+                                          UA_TIMESTAMPSTORETURN_NEITHER);
+        if(dv.hasStatus && dv.status != UA_STATUSCODE_GOOD) {
+            res = dv.status;
+            UA_DataValue_clear(&dv);
+        } else {
+            *out = dv.value;
+            UA_Variant_init(&dv.value);
+            UA_DataValue_clear(&dv);
+        }
+    }
+    UA_BrowsePathResult_clear(&bpr);
+
+    if(res != UA_STATUSCODE_GOOD)
+        UA_Variant_setScalarCopy(out, &res, &UA_TYPES[UA_TYPES_STATUSCODE]);
+}
+
+static UA_Boolean
+matchCandidate(UA_Server *server, UA_Session *session,
+               const UA_ContentFilter *filter, const UA_NodeId *nodeId) {
+    if(filter->elementsSize == 0)
+        return true;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    return (evaluateWhereClause(server, session, nodeId,
+                                filter, NULL) == UA_STATUSCODE_GOOD);
+#else
+    return false; /* Filters are rejected in checkQueryFirstRequest */
+#endif
+}
+
+/* Evaluate the remaining candidates until the maximum number of results is
+ * reached */
+static UA_StatusCode
+processQuery(UA_Server *server, UA_Session *session, QueryContinuationPoint *cp,
+             size_t *dataSetsSize, UA_QueryDataSet **dataSets) {
+    size_t max = cp->request.maxDataSetsToReturn;
+    size_t remaining = cp->candidatesSize - cp->candidatesPos;
+    if(max == 0 || max > remaining)
+        max = remaining;
+    if(max == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_QueryDataSet *ds = (UA_QueryDataSet*)
+        UA_Array_new(max, &UA_TYPES[UA_TYPES_QUERYDATASET]);
+    if(!ds)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    size_t found = 0;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(; cp->candidatesPos < cp->candidatesSize && found < max; cp->candidatesPos++) {
+        QueryCandidate *c = &cp->candidates[cp->candidatesPos];
+        if(!matchCandidate(server, session, &cp->request.filter, &c->nodeId))
+            continue;
+
+        /* Move the identifiers into the result */
+        UA_QueryDataSet *qds = &ds[found];
+        qds->nodeId.nodeId = c->nodeId;
+        qds->typeDefinitionNode.nodeId = c->typeDefinition;
+        UA_NodeId_init(&c->nodeId);
+        UA_NodeId_init(&c->typeDefinition);
+        found++;
+
+        /* Read the values */
+        const UA_NodeTypeDescription *ntd = &cp->request.nodeTypes[c->nodeType];
+        if(ntd->dataToReturnSize == 0)
+            continue;
+        qds->values = (UA_Variant*)
+            UA_Array_new(ntd->dataToReturnSize, &UA_TYPES[UA_TYPES_VARIANT]);
+        if(!qds->values) {
+            res = UA_STATUSCODE_BADOUTOFMEMORY;
+            break;
+        }
+        qds->valuesSize = ntd->dataToReturnSize;
+        for(size_t i = 0; i < ntd->dataToReturnSize; i++)
+            readDataToReturn(server, session, &qds->nodeId.nodeId,
+                             &ntd->dataToReturn[i], &qds->values[i]);
+    }
+
+    if(res != UA_STATUSCODE_GOOD || found == 0) {
+        UA_Array_delete(ds, max, &UA_TYPES[UA_TYPES_QUERYDATASET]);
+        return res;
+    }
+    *dataSets = ds;
+    *dataSetsSize = found; /* The unused entries at the end are all zero */
+    return UA_STATUSCODE_GOOD;
+}
+
+/*************************/
+/* Query Service Handler */
+/*************************/
+
+static UA_StatusCode
+checkQueryFirstRequest(UA_Server *server, const UA_QueryFirstRequest *request,
+                       UA_QueryFirstResponse *response) {
+    if(request->nodeTypesSize == 0)
+        return UA_STATUSCODE_BADNOTHINGTODO;
+
+    /* No views supported at the moment */
+    if(!UA_NodeId_isNull(&request->view.viewId))
+        return UA_STATUSCODE_BADVIEWIDUNKNOWN;
+
+    const UA_ContentFilter *cf = &request->filter;
+    if(cf->elementsSize == 0)
+        return UA_STATUSCODE_GOOD;
+#ifndef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    return UA_STATUSCODE_BADFILTERNOTALLOWED;
+#else
+    if(cf->elementsSize > UA_EVENTFILTER_MAXELEMENTS)
+        return UA_STATUSCODE_BADCONTENTFILTERINVALID;
+
+    /* Validate the filter elements */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    UA_ContentFilterElementResult er[UA_EVENTFILTER_MAXELEMENTS];
+    for(size_t i = 0; i < cf->elementsSize; i++) {
+        er[i] = UA_ContentFilterElementValidation(server, i, cf->elementsSize,
+                                                  &cf->elements[i]);
+        if(er[i].statusCode != UA_STATUSCODE_GOOD && res == UA_STATUSCODE_GOOD)
+            res = er[i].statusCode;
+    }
+
+    /* Return the details. The response body is kept for this service error. */
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ContentFilterResult tmp;
+        UA_ContentFilterResult_init(&tmp);
+        tmp.elementResultsSize = cf->elementsSize;
+        tmp.elementResults = er;
+        if(UA_ContentFilterResult_copy(&tmp, &response->filterResult) ==
+           UA_STATUSCODE_GOOD)
+            res = UA_STATUSCODE_BADCONTENTFILTERINVALID;
+    }
+
+    for(size_t i = 0; i < cf->elementsSize; i++)
+        UA_ContentFilterElementResult_clear(&er[i]);
+    return res;
+#endif
+}
+
+void
+Service_QueryFirst(UA_Server *server, UA_Session *session,
+                   const UA_QueryFirstRequest *request,
+                   UA_QueryFirstResponse *response) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing QueryFirstRequest");
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    response->responseHeader.serviceResult =
+        checkQueryFirstRequest(server, request, response);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        return;
+
+    /* Prepare the ContinuationPoint */
+    QueryContinuationPoint *cp = (QueryContinuationPoint*)
+        UA_calloc(1, sizeof(QueryContinuationPoint));
+    if(!cp) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    UA_StatusCode res = UA_QueryFirstRequest_copy(request, &cp->request);
+    UA_RequestHeader_clear(&cp->request.requestHeader);
+
+    /* Collect the instances of the NodeTypes. The ParsingResults are only
+     * returned if there was an error. */
+    UA_ParsingResult *pr = (UA_ParsingResult*)
+        UA_Array_new(request->nodeTypesSize, &UA_TYPES[UA_TYPES_PARSINGRESULT]);
+    if(!pr)
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_Boolean parsingError = false;
+    for(size_t i = 0; res == UA_STATUSCODE_GOOD && i < request->nodeTypesSize; i++) {
+        pr[i].statusCode = checkDataToReturn(&request->nodeTypes[i], &pr[i]);
+        if(pr[i].statusCode == UA_STATUSCODE_GOOD)
+            pr[i].statusCode = collectCandidates(server, cp, i, &res);
+        if(pr[i].statusCode != UA_STATUSCODE_GOOD)
+            parsingError = true;
+    }
+    if(res == UA_STATUSCODE_GOOD && parsingError) {
+        response->parsingResults = pr;
+        response->parsingResultsSize = request->nodeTypesSize;
+    } else if(pr) {
+        UA_Array_delete(pr, request->nodeTypesSize, &UA_TYPES[UA_TYPES_PARSINGRESULT]);
+    }
+
+    /* Evaluate the candidates */
+    if(res == UA_STATUSCODE_GOOD)
+        res = processQuery(server, session, cp, &response->queryDataSetsSize,
+                           &response->queryDataSets);
+
+    /* Keep the remaining candidates for QueryNext */
+    if(res == UA_STATUSCODE_GOOD && cp->candidatesPos < cp->candidatesSize) {
+        if(session->availableQueryContinuationPoints == 0) {
+            res = UA_STATUSCODE_BADNOCONTINUATIONPOINTS;
+        } else {
+            cp->identifier = UA_Guid_random();
+            res = UA_ByteString_allocBuffer(&response->continuationPoint,
+                                            sizeof(UA_Guid));
+            if(res == UA_STATUSCODE_GOOD) {
+                memcpy(response->continuationPoint.data, &cp->identifier,
+                       sizeof(UA_Guid));
+                cp->next = session->queryContinuationPoints;
+                session->queryContinuationPoints = cp;
+                session->availableQueryContinuationPoints--;
+                return;
+            }
+        }
+    }
+
+    QueryContinuationPoint_clear(cp);
+    UA_free(cp);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_QueryFirstResponse_clear(response);
+        response->responseHeader.serviceResult = res;
+    }
+}
+
+void
+Service_QueryNext(UA_Server *server, UA_Session *session,
+                  const UA_QueryNextRequest *request,
+                  UA_QueryNextResponse *response) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing QueryNextRequest");
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    /* Find the ContinuationPoint */
+    QueryContinuationPoint **prev = &session->queryContinuationPoints;
+    QueryContinuationPoint *cp;
+    while((cp = *prev)) {
+        if(request->continuationPoint.length == sizeof(UA_Guid) &&
+           memcmp(request->continuationPoint.data, &cp->identifier,
+                  sizeof(UA_Guid)) == 0)
+            break;
+        prev = &cp->next;
+    }
+    if(!cp) {
+        response->responseHeader.serviceResult =
+            UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        return;
+    }
+
+    /* Continue the Query */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(!request->releaseContinuationPoint) {
+        res = processQuery(server, session, cp, &response->queryDataSetsSize,
+                           &response->queryDataSets);
+        if(res == UA_STATUSCODE_GOOD && cp->candidatesPos < cp->candidatesSize) {
+            /* Keep the ContinuationPoint */
+            res = UA_ByteString_copy(&request->continuationPoint,
+                                     &response->revisedContinuationPoint);
+            if(res == UA_STATUSCODE_GOOD)
+                return;
+            UA_QueryNextResponse_clear(response);
+            response->responseHeader.serviceResult = res;
+        }
+    }
+
+    /* Remove the ContinuationPoint */
+    *prev = QueryContinuationPoint_clear(cp);
+    UA_free(cp);
+    session->availableQueryContinuationPoints++;
+    response->responseHeader.serviceResult = res;
+}
+
+#endif /* UA_ENABLE_QUERY */
@@ -16,13 +16,32 @@
 #include "ua_server_internal.h"
 #include "ua_services.h"
 
+static enum ZIP_CMP
+cmpSessionNodeId(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+static enum ZIP_CMP
+cmpSessionTimeout(const UA_DateTime *a, const UA_DateTime *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_SessionTokenTree, session_list_entry, tokenTreeEntry,
+              UA_NodeId, session.authenticationToken, cmpSessionNodeId)
+ZIP_FUNCTIONS(UA_SessionIdTree, session_list_entry, idTreeEntry,
+              UA_NodeId, session.sessionId, cmpSessionNodeId)
+ZIP_FUNCTIONS(UA_SessionTimeoutTree, session_list_entry, timeoutTreeEntry,
+              UA_DateTime, timeoutTreeKey, cmpSessionTimeout)
+
 /* Delayed callback to free the session memory */
 static void
 removeSessionCallback(UA_Server *server, session_list_entry *entry) {
     UA_LOCK(&server->serviceMutex);
     UA_Session_clear(&entry->session, server);
     UA_UNLOCK(&server->serviceMutex);
-    UA_free(entry);
+    UA_POOL_FREE(entry);
 }
 
 void
@@ -67,6 +86,9 @@ UA_Server_removeSession(UA_Server *server, session_list_entry *sentry,
     /* Detach the session from the session manager and make the capacity
      * available */
     LIST_REMOVE(sentry, pointers);
+    ZIP_REMOVE(UA_SessionTokenTree, &server->sessionsByToken, sentry);
+    ZIP_REMOVE(UA_SessionIdTree, &server->sessionsById, sentry);
+    ZIP_REMOVE(UA_SessionTimeoutTree, &server->sessionTimeouts, sentry);
     server->sessionCount--;
 
     switch(shutdownReason) {
@@ -103,24 +125,31 @@ UA_StatusCode
 UA_Server_removeSessionByToken(UA_Server *server, const UA_NodeId *token,
                                UA_ShutdownReason shutdownReason) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    session_list_entry *entry;
-    LIST_FOREACH(entry, &server->sessions, pointers) {
-        if(UA_NodeId_equal(&entry->session.authenticationToken, token)) {
-            UA_Server_removeSession(server, entry, shutdownReason);
-            return UA_STATUSCODE_GOOD;
-        }
-    }
-    return UA_STATUSCODE_BADSESSIONIDINVALID;
+    session_list_entry *entry =
+        ZIP_FIND(UA_SessionTokenTree, &server->sessionsByToken, token);
+    if(!entry)
+        return UA_STATUSCODE_BADSESSIONIDINVALID;
+    UA_Server_removeSession(server, entry, shutdownReason);
+    return UA_STATUSCODE_GOOD;
 }
 
 void
 UA_Server_cleanupSessions(UA_Server *server, UA_DateTime nowMonotonic) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    session_list_entry *sentry, *temp;
-    LIST_FOREACH_SAFE(sentry, &server->sessions, pointers, temp) {
-        /* Session has timed out? */
-        if(sentry->session.validTill >= nowMonotonic)
+    /* Only visit the Sessions whose lifetime has ended at the time they were
+     * (re)inserted into the timeout tree */
+    session_list_entry *sentry;
+    while((sentry = ZIP_MIN(UA_SessionTimeoutTree, &server->sessionTimeouts)) &&
+          sentry->timeoutTreeKey < nowMonotonic) {
+        /* The lifetime was extended in the meantime. Reinsert. */
+        if(sentry->session.validTill >= nowMonotonic) {
+            ZIP_REMOVE(UA_SessionTimeoutTree, &server->sessionTimeouts, sentry);
+            sentry->timeoutTreeKey = sentry->session.validTill;
+            ZIP_INSERT(UA_SessionTimeoutTree, &server->sessionTimeouts, sentry);
             continue;
+        }
+
+        /* Session has timed out */
         UA_LOG_INFO_SESSION(server->config.logging, &sentry->session,
                             "Session has timed out");
         UA_Server_removeSession(server, sentry, UA_SHUTDOWNREASON_TIMEOUT);
@@ -135,37 +164,30 @@ UA_Session *
 getSessionByToken(UA_Server *server, const UA_NodeId *token) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.authenticationToken, token))
-            continue;
+    session_list_entry *current =
+        ZIP_FIND(UA_SessionTokenTree, &server->sessionsByToken, token);
+    if(!current)
+        return NULL;
 
-        /* Session has timed out */
-        UA_EventLoop *el = server->config.eventLoop;
-        UA_DateTime now = el->dateTime_nowMonotonic(el);
-        if(now > current->session.validTill) {
-            UA_LOG_INFO_SESSION(server->config.logging, &current->session,
-                                "Client tries to use a session that has timed out");
-            return NULL;
-        }
-
-        return &current->session;
+    /* Session has timed out */
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    if(now > current->session.validTill) {
+        UA_LOG_INFO_SESSION(server->config.logging, &current->session,
+                            "Client tries to use a session that has timed out");
+        return NULL;
     }
 
-    return NULL;
+    return &current->session;
 }
 
 UA_Session *
 getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    session_list_entry *current = NULL;
-    LIST_FOREACH(current, &server->sessions, pointers) {
-        /* Token does not match */
-        if(!UA_NodeId_equal(&current->session.sessionId, sessionId))
-            continue;
-
+    session_list_entry *current =
+        ZIP_FIND(UA_SessionIdTree, &server->sessionsById, sessionId);
+    if(current) {
         /* Session has timed out */
         UA_EventLoop *el = server->config.eventLoop;
         UA_DateTime now = el->dateTime_nowMonotonic(el);
@@ -174,7 +196,6 @@ getSessionById(UA_Server *server, const UA_NodeId *sessionId) {
                                 "Client tries to use a session that has timed out");
             return NULL;
         }
-
         return &current->session;
     }
 
@@ -237,15 +258,23 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
         return UA_STATUSCODE_BADTOOMANYSESSIONS;
     }
 
+    /* The authentication token is secret. Use cryptographic randomness. */
+    UA_Guid token;
+    UA_StatusCode res = getRandomBytes(server, (UA_Byte*)&token, sizeof(UA_Guid));
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    /* Removed Sessions are returned to the pool after the current EventLoop
+     * iteration */
     session_list_entry *newentry = (session_list_entry*)
-        UA_malloc(sizeof(session_list_entry));
+        UA_POOL_ALLOC(&server->pools.sessions, sizeof(session_list_entry));
     if(!newentry)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
+        return UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYSESSIONS);
 
     /* Initialize the Session */
     UA_Session_init(&newentry->session);
     newentry->session.sessionId = UA_NODEID_GUID(1, UA_Guid_random());
-    newentry->session.authenticationToken = UA_NODEID_GUID(1, UA_Guid_random());
+    newentry->session.authenticationToken = UA_NODEID_GUID(1, token);
 
     newentry->session.timeout = server->config.maxSessionTimeout;
     if(request->requestedSessionTimeout <= server->config.maxSessionTimeout &&
@@ -263,6 +292,10 @@ UA_Server_createSession(UA_Server *server, UA_SecureChannel *channel,
 
     /* Add to the server */
     LIST_INSERT_HEAD(&server->sessions, newentry, pointers);
+    ZIP_INSERT(UA_SessionTokenTree, &server->sessionsByToken, newentry);
+    ZIP_INSERT(UA_SessionIdTree, &server->sessionsById, newentry);
+    newentry->timeoutTreeKey = newentry->session.validTill;
+    ZIP_INSERT(UA_SessionTimeoutTree, &server->sessionTimeouts, newentry);
     server->sessionCount++;
 
     *session = &newentry->session;
@@ -336,7 +369,8 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
         response->responseHeader.serviceResult |=
             UA_NodeId_print(&newSession->sessionId, &newSession->sessionName);
 
-    response->responseHeader.serviceResult |= UA_Session_generateNonce(newSession);
+    response->responseHeader.serviceResult |=
+        UA_Session_generateNonce(server, newSession);
     newSession->maxResponseMessageSize = request->maxResponseMessageSize;
     newSession->maxRequestMessageSize = channel->config.localMaxMessageSize;
     response->responseHeader.serviceResult |=
@@ -379,9 +413,23 @@ Service_CreateSession(UA_Server *server, UA_SecureChannel *channel,
         response->responseHeader.serviceResult |=
             UA_ByteString_copy(&sp->localCertificate, &response->serverCertificate);
 
-    /* Sign the signature */
+    /* Sign the signature. The signed data comes only from the request and the
+     * channel. On a network EventLoop this runs under the shared side of the
+     * lock. The channel context is not removed meanwhile (see processOPN). But
+     * the Session could be and is looked up again. */
+    UA_Boolean shared = lockSharedForCrypto(server, channel);
     response->responseHeader.serviceResult |=
        signCreateSessionResponse(server, channel, request, response);
+    unlockSharedForCrypto(server, shared);
+    if(shared &&
+       getSessionByToken(server, &response->authenticationToken) != newSession) {
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "CreateSession: The Session was removed "
+                               "while signing the response");
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADSESSIONCLOSED;
+        server->serverDiagnosticsSummary.rejectedSessionCount++;
+        return;
+    }
 
     /* Failure -> remove the session */
     if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
@@ -546,15 +594,15 @@ selectEndpointAndTokenPolicy(UA_Server *server, UA_SecureChannel *channel,
 }
 
 static UA_StatusCode
-decryptUserNamePW(UA_Server *server, UA_Session *session,
-                  const UA_SecurityPolicy *sp,
+decryptUserNamePW(UA_Server *server, UA_SecureChannel *channel,
+                  const UA_ByteString *sn, const UA_SecurityPolicy *sp,
                   UA_UserNameIdentityToken *userToken) {
     /* If SecurityPolicy is None there shall be no EncryptionAlgorithm  */
     if(UA_String_equal(&sp->policyUri, &UA_SECURITY_POLICY_NONE_URI)) {
         if(userToken->encryptionAlgorithm.length > 0)
             return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
 
-        UA_LOG_WARNING_SESSION(server->config.logging, session, "ActivateSession: "
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel, "ActivateSession: "
                                "Received an unencrypted username/passwort. "
                                "Is the server misconfigured to allow that?");
         return UA_STATUSCODE_GOOD;
@@ -569,12 +617,12 @@ decryptUserNamePW(UA_Server *server, UA_Session *session,
      * TODO: We should not need a ChannelContext at all for asymmetric
      * decryption where the remote certificate is not used. */
     void *tempChannelContext = NULL;
-    UA_UNLOCK(&server->serviceMutex);
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
     UA_StatusCode res =
         sp->channelModule.newContext(sp, &sp->localCertificate, &tempChannelContext);
-    UA_LOCK(&server->serviceMutex);
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
     if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "ActivateSession: Failed to create a "
                                "context for the SecurityPolicy %.*s",
                                (int)sp->policyUri.length,
@@ -586,7 +634,6 @@ decryptUserNamePW(UA_Server *server, UA_Session *session,
     UA_ByteString secret, tokenNonce;
     size_t tokenpos = 0;
     size_t offset = 0;
-    UA_ByteString *sn = &session->serverNonce;
     const UA_SecurityPolicyEncryptionAlgorithm *asymEnc =
         &sp->asymmetricModule.cryptoModule.encryptionAlgorithm;
 
@@ -638,12 +685,12 @@ decryptUserNamePW(UA_Server *server, UA_Session *session,
     UA_ByteString_clear(&secret);
 
     /* Remove the temporary channel context */
-    UA_UNLOCK(&server->serviceMutex);
+    shared = UA_LOCK_SUSPEND(&server->serviceMutex);
     sp->channelModule.deleteContext(tempChannelContext);
-    UA_LOCK(&server->serviceMutex);
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
 
     if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "ActivateSession: Failed to decrypt the "
                                "password with the StatusCode %s",
                                UA_StatusCode_name(res));
@@ -652,7 +699,8 @@ decryptUserNamePW(UA_Server *server, UA_Session *session,
 }
 
 static UA_StatusCode
-checkActivateSessionX509(UA_Server *server, UA_Session *session,
+checkActivateSessionX509(UA_Server *server, UA_SecureChannel *channel,
+                         const UA_ByteString *serverNonce,
                          const UA_SecurityPolicy *sp, UA_X509IdentityToken* token,
                          const UA_SignatureData *tokenSignature) {
     /* The SecurityPolicy must be None */
@@ -662,12 +710,12 @@ checkActivateSessionX509(UA_Server *server, UA_Session *session,
     /* We need a channel context with the user certificate in order to reuse
      * the signature checking code. */
     void *tempChannelContext;
-    UA_UNLOCK(&server->serviceMutex);
+    UA_Boolean shared = UA_LOCK_SUSPEND(&server->serviceMutex);
     UA_StatusCode res = sp->channelModule.
         newContext(sp, &token->certificateData, &tempChannelContext);
-    UA_LOCK(&server->serviceMutex);
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
     if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "ActivateSession: Failed to create a context "
                                "for the SecurityPolicy %.*s",
                                (int)sp->policyUri.length,
@@ -677,17 +725,73 @@ checkActivateSessionX509(UA_Server *server, UA_Session *session,
 
     /* Check the user token signature */
     res = checkCertificateSignature(server, sp, tempChannelContext,
-                                    &session->serverNonce, tokenSignature, true);
+                                    serverNonce, tokenSignature, true);
     if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SESSION(server->config.logging, session,
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
                                "ActivateSession: User token signature check "
                                "failed with StatusCode %s", UA_StatusCode_name(res));
     }
 
     /* Delete the temporary channel context */
-    UA_UNLOCK(&server->serviceMutex);
+    shared = UA_LOCK_SUSPEND(&server->serviceMutex);
     sp->channelModule.deleteContext(tempChannelContext);
-    UA_LOCK(&server->serviceMutex);
+    UA_LOCK_RESUME(&server->serviceMutex, shared);
+    return res;
+}
+
+/* Check the client signature, select the Endpoint and UserTokenPolicy and
+ * check (or decrypt) the user token. Without access to the Session, so that
+ * this can run under the shared side of the lock. Sets securityRejected if a
+ * security check has failed. */
+static UA_StatusCode
+checkActivateSessionSecurity(UA_Server *server, UA_SecureChannel *channel,
+                             const UA_ActivateSessionRequest *req,
+                             const UA_ByteString *serverNonce,
+                             const UA_EndpointDescription **ed,
+                             const UA_UserTokenPolicy **utp,
+                             UA_Boolean *securityRejected) {
+    /* Check the client signature */
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    *securityRejected = true;
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
+       channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT) {
+        res = checkCertificateSignature(server, channel->securityPolicy,
+                                        channel->channelContext, serverNonce,
+                                        &req->clientSignature, false);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                                   "ActivateSession: Client signature check failed "
+                                   "with StatusCode %s", UA_StatusCode_name(res));
+            return res;
+        }
+    }
+
+    /* Find the matching Endpoint with UserTokenPolicy.
+     * Also sets the SecurityPolicy used to encrypt the token. */
+    const UA_SecurityPolicy *tokenSp = NULL;
+    selectEndpointAndTokenPolicy(server, channel, &req->userIdentityToken,
+                                 ed, utp, &tokenSp);
+    if(!*ed || !tokenSp) {
+        *securityRejected = false;
+        return UA_STATUSCODE_BADIDENTITYTOKENINVALID;
+    }
+
+    if((*utp)->tokenType == UA_USERTOKENTYPE_USERNAME) {
+        /* If it is a UserNameIdentityToken, the password may be encrypted */
+        UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken *)
+            req->userIdentityToken.content.decoded.data;
+        res = decryptUserNamePW(server, channel, serverNonce, tokenSp, userToken);
+    } else if((*utp)->tokenType == UA_USERTOKENTYPE_CERTIFICATE) {
+        /* If it is a X509IdentityToken, check the userTokenSignature. Note this
+         * only validates that the user has the corresponding private key for
+         * the given user cetificate. Checking whether the user certificate is
+         * trusted has to be implemented in the access control plugin. The
+         * entire token is forwarded in the call to ActivateSession. */
+        UA_X509IdentityToken* token = (UA_X509IdentityToken*)
+            req->userIdentityToken.content.decoded.data;
+        res = checkActivateSessionX509(server, channel, serverNonce, tokenSp,
+                                       token, &req->userTokenSignature);
+    }
     return res;
 }
 
@@ -706,9 +810,11 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
     const UA_EndpointDescription *ed = NULL;
     const UA_UserTokenPolicy *utp = NULL;
-    const UA_SecurityPolicy *tokenSp = NULL;
     UA_String *tmpLocaleIds;
     UA_StatusCode res;
+    UA_ByteString serverNonce;
+    UA_Boolean shared;
+    UA_Boolean securityRejected;
     UA_SessionSecurityDiagnosticsDataType *ssd;
     const UA_DataType *tokenType;
     UA_DateTime now;
@@ -746,53 +852,31 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
         goto rejected;
     }
 
-    /* Check the client signature */
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGN ||
-       channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT) {
-        resp->responseHeader.serviceResult =
-            checkCertificateSignature(server, channel->securityPolicy,
-                                      channel->channelContext,
-                                      &session->serverNonce,
-                                      &req->clientSignature, false);
-        if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
-            UA_LOG_WARNING_SESSION(server->config.logging, session,
-                                   "ActivateSession: Client signature check failed "
-                                   "with StatusCode %s",
-                                   UA_StatusCode_name(resp->responseHeader.serviceResult));
-            goto securityRejected;
-        }
-    }
-
-    /* Find the matching Endpoint with UserTokenPolicy.
-     * Also sets the SecurityPolicy used to encrypt the token. */
-    selectEndpointAndTokenPolicy(server, channel, &req->userIdentityToken,
-                                 &ed, &utp, &tokenSp);
-    if(!ed || !tokenSp) {
-        resp->responseHeader.serviceResult = UA_STATUSCODE_BADIDENTITYTOKENINVALID;
+    /* The asymmetric crypto runs under the shared side of the lock on a
+     * network EventLoop. The ServerNonce is copied and the Session looked up
+     * again afterwards, as it can be removed while the lock is switched. */
+    resp->responseHeader.serviceResult =
+        UA_ByteString_copy(&session->serverNonce, &serverNonce);
+    if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        goto rejected;
+    shared = lockSharedForCrypto(server, channel);
+    resp->responseHeader.serviceResult =
+        checkActivateSessionSecurity(server, channel, req, &serverNonce,
+                                     &ed, &utp, &securityRejected);
+    unlockSharedForCrypto(server, shared);
+    UA_ByteString_clear(&serverNonce);
+    if(shared &&
+       getSessionByToken(server, &req->requestHeader.authenticationToken) != session) {
+        UA_LOG_WARNING_CHANNEL(server->config.logging, channel,
+                               "ActivateSession: The Session was removed "
+                               "during the security checks");
+        resp->responseHeader.serviceResult = UA_STATUSCODE_BADSESSIONIDINVALID;
         goto rejected;
     }
-
-    if(utp->tokenType == UA_USERTOKENTYPE_USERNAME) {
-        /* If it is a UserNameIdentityToken, the password may be encrypted */
-       UA_UserNameIdentityToken *userToken = (UA_UserNameIdentityToken *)
-           req->userIdentityToken.content.decoded.data;
-       resp->responseHeader.serviceResult =
-           decryptUserNamePW(server, session, tokenSp, userToken);
-       if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
-           goto securityRejected;
-    } else if(utp->tokenType == UA_USERTOKENTYPE_CERTIFICATE) {
-        /* If it is a X509IdentityToken, check the userTokenSignature. Note this
-         * only validates that the user has the corresponding private key for
-         * the given user cetificate. Checking whether the user certificate is
-         * trusted has to be implemented in the access control plugin. The
-         * entire token is forwarded in the call to ActivateSession. */
-        UA_X509IdentityToken* token = (UA_X509IdentityToken*)
-            req->userIdentityToken.content.decoded.data;
-       resp->responseHeader.serviceResult =
-           checkActivateSessionX509(server, session, tokenSp,
-                                    token, &req->userTokenSignature);
-       if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
-           goto securityRejected;
+    if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        if(securityRejected)
+            goto securityRejected;
+        goto rejected;
     }
 
     /* Callback into userland access control */
@@ -802,6 +886,10 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
                         &channel->remoteCertificate, &session->sessionId,
                         &req->userIdentityToken, &session->context);
     UA_LOCK(&server->serviceMutex);
+
+    /* The user identity may have changed */
+    UA_Session_invalidateAccessCache(session, NULL);
+
     if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING_SESSION(server->config.logging, session,
                                "ActivateSession: The AccessControl "
@@ -821,7 +909,7 @@ Service_ActivateSession(UA_Server *server, UA_SecureChannel *channel,
     }
 
     /* Generate a new session nonce for the next time ActivateSession is called */
-    resp->responseHeader.serviceResult = UA_Session_generateNonce(session);
+    resp->responseHeader.serviceResult = UA_Session_generateNonce(server, session);
     resp->responseHeader.serviceResult |=
         UA_ByteString_copy(&session->serverNonce, &resp->serverNonce);
     if(resp->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
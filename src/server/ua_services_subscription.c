@@ -67,11 +67,12 @@ Service_CreateSubscription(UA_Server *server, UA_Session *session,
     }
 
     /* Create the subscription */
-    UA_Subscription *sub = UA_Subscription_new();
+    UA_Subscription *sub = UA_Subscription_new(server);
     if(!sub) {
         UA_LOG_DEBUG_SESSION(server->config.logging, session,
                              "Processing CreateSubscriptionRequest failed");
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        response->responseHeader.serviceResult =
+            UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYSUBSCRIPTIONS);
         return;
     }
 
@@ -155,11 +156,10 @@ Service_ModifySubscription(UA_Server *server, UA_Session *session,
 
     /* The publish interval has changed */
     if(sub->publishingInterval != oldPublishingInterval) {
-        /* Change the repeated callback to the new interval. This cannot fail as
-         * memory is reused. */
-        if(sub->publishCallbackId > 0)
-            changeRepeatedCallbackInterval(server, sub->publishCallbackId,
-                                           sub->publishingInterval);
+        /* Move to the PublishGroup of the new interval. The Subscription is
+         * stopped if this fails. */
+        response->responseHeader.serviceResult =
+            Subscription_updatePublishGroup(server, sub);
 
         /* For each MonitoredItem check if it was/shall be attached to the
          * publish interval. This ensures that we have less cyclic callbacks
@@ -378,8 +378,10 @@ Service_DeleteSubscriptions(UA_Server *server, UA_Session *session,
                   &response->resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
 }
 
-void
-Service_Republish(UA_Server *server, UA_Session *session,
+/* Returns the entry of the retransmission queue or NULL with the error set in
+ * the response */
+static UA_NotificationMessageEntry *
+getRepublishEntry(UA_Server *server, UA_Session *session,
                   const UA_RepublishRequest *request,
                   UA_RepublishResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session,
@@ -390,7 +392,7 @@ Service_Republish(UA_Server *server, UA_Session *session,
     UA_Subscription *sub = UA_Session_getSubscriptionById(session, request->subscriptionId);
     if(!sub) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID;
-        return;
+        return NULL;
     }
 
     /* Reset the lifetime counter */
@@ -409,16 +411,44 @@ Service_Republish(UA_Server *server, UA_Session *session,
     }
     if(!entry) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADMESSAGENOTAVAILABLE;
-        return;
+        return NULL;
     }
 
-    response->responseHeader.serviceResult =
-        UA_NotificationMessage_copy(&entry->message, &response->notificationMessage);
-
     /* Update the subscription statistics for the case where we return a message */
 #ifdef UA_ENABLE_DIAGNOSTICS
     sub->republishMessageCount++;
 #endif
+    return entry;
+}
+
+void
+Service_Republish(UA_Server *server, UA_Session *session,
+                  const UA_RepublishRequest *request,
+                  UA_RepublishResponse *response) {
+    UA_NotificationMessageEntry *entry =
+        getRepublishEntry(server, session, request, response);
+    if(!entry)
+        return;
+    response->responseHeader.serviceResult =
+        UA_NotificationMessage_copy(&entry->message, &response->notificationMessage);
+}
+
+UA_Boolean
+Service_RepublishSend(UA_Server *server, UA_Session *session,
+                      const UA_RepublishRequest *request,
+                      UA_RepublishResponse *response, UA_UInt32 requestId) {
+    UA_NotificationMessageEntry *entry =
+        getRepublishEntry(server, session, request, response);
+    if(!entry || !session->channel)
+        return false;
+
+    /* Encode the message directly from the retransmission queue. Reset the
+     * shallow copy before the response is cleared. */
+    response->notificationMessage = entry->message;
+    sendSessionResponse(server, session, requestId, (UA_Response*)response,
+                        &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE]);
+    UA_NotificationMessage_init(&response->notificationMessage);
+    return true;
 }
 
 static UA_StatusCode
@@ -498,16 +528,17 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     }
 
     /* Allocate memory for the new subscription */
-    UA_Subscription *newSub = (UA_Subscription*)UA_malloc(sizeof(UA_Subscription));
+    UA_Subscription *newSub = (UA_Subscription*)
+        UA_POOL_ALLOC(&server->pools.subscriptions, sizeof(UA_Subscription));
     if(!newSub) {
-        result->statusCode = UA_STATUSCODE_BADOUTOFMEMORY;
+        result->statusCode = UA_POOL_EXHAUSTED(UA_STATUSCODE_BADTOOMANYSUBSCRIPTIONS);
         return;
     }
 
     /* Set the available sequence numbers */
     result->statusCode = setTransferredSequenceNumbers(sub, result);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
-        UA_free(newSub);
+        UA_POOL_FREE(newSub);
         return;
     }
 
@@ -518,14 +549,14 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
     memcpy(newSub, sub, sizeof(UA_Subscription));
 
     /* Set to the same state as the original subscription */
-    newSub->publishCallbackId = 0;
+    newSub->publishGroup = NULL;
     result->statusCode = Subscription_setState(server, newSub, sub->state);
     if(result->statusCode != UA_STATUSCODE_GOOD) {
         UA_Array_delete(result->availableSequenceNumbers,
                         sub->retransmissionQueueSize, &UA_TYPES[UA_TYPES_UINT32]);
         result->availableSequenceNumbers = NULL;
         result->availableSequenceNumbersSize = 0;
-        UA_free(newSub);
+        UA_POOL_FREE(newSub);
         return;
     }
 
@@ -539,7 +570,9 @@ Operation_TransferSubscription(UA_Server *server, UA_Session *session,
         mon->subscription = newSub;
         LIST_INSERT_HEAD(&newSub->monitoredItems, mon, listEntry);
     }
+    ZIP_INIT(&sub->monitoredItemsById); /* The tree was copied with memcpy */
     sub->monitoredItemsSize = 0;
+    sub->disabledMonitoredItemsSize = 0;
 
     /* Move over the notification queue */
     TAILQ_INIT(&newSub->notificationQueue);
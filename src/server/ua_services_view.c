@@ -20,6 +20,14 @@
 #include "ua_services.h"
 #include "ziptree.h"
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+# ifdef UA_ARCHITECTURE_WIN32
+#  include <windows.h>
+# else
+#  include <pthread.h>
+# endif
+#endif
+
 #define UA_MAX_TREE_RECURSE 50 /* How deep up/down the tree do we recurse at most? */
 
 static UA_UInt32
@@ -127,10 +135,10 @@ isNodeInTreeIterateCallback(void *context, UA_ReferenceTarget *t) {
     /* Get the node without attributes (if the NodeStore supports it) and only
      * the relevant references in inverse direction */
     const UA_Node *node =
-        UA_NODESTORE_GETFROMREF_SELECTIVE(tc->server, t->targetId,
-                                          UA_NODEATTRIBUTESMASK_NONE,
-                                          tc->relevantRefs,
-                                          UA_BROWSEDIRECTION_INVERSE);
+        UA_NODESTORE_GETFROMTARGET_SELECTIVE(tc->server, t,
+                                             UA_NODEATTRIBUTESMASK_NONE,
+                                             tc->relevantRefs,
+                                             UA_BROWSEDIRECTION_INVERSE);
     if(!node)
         return NULL;
 
@@ -162,10 +170,158 @@ isNodeInTreeIterateCallback(void *context, UA_ReferenceTarget *t) {
     return res;
 }
 
+/******************/
+/* Type Hierarchy */
+/******************/
+
+/* Subtype checks are frequent (DataType compatibility, OfType in EventFilters,
+ * ...). The supertypes of a type node are looked up once and cached in the
+ * server. */
+
+static enum ZIP_CMP
+cmpTypeHierarchyEntry(const void *a, const void *b) {
+    const UA_TypeHierarchyEntry *aa = (const UA_TypeHierarchyEntry*)a;
+    const UA_TypeHierarchyEntry *bb = (const UA_TypeHierarchyEntry*)b;
+    if(aa->hash != bb->hash)
+        return (aa->hash < bb->hash) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_NodeId_order(&aa->typeId, &bb->typeId);
+}
+
+ZIP_FUNCTIONS(UA_TypeHierarchyTree, UA_TypeHierarchyEntry, treeEntry,
+              UA_TypeHierarchyEntry, treeEntry, cmpTypeHierarchyEntry)
+
+static void
+UA_TypeHierarchyEntry_delete(UA_TypeHierarchyEntry *e) {
+    UA_Array_delete(e->supertypes, e->supertypesSize,
+                    &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    UA_NodeId_clear(&e->typeId);
+    UA_free(e);
+}
+
+static void *
+deleteTypeHierarchyEntry(void *context, UA_TypeHierarchyEntry *e) {
+    UA_TypeHierarchyEntry_delete(e);
+    return NULL;
+}
+
+void
+UA_TypeHierarchy_clear(UA_Server *server) {
+    ZIP_ITER(UA_TypeHierarchyTree, &server->typeHierarchy,
+             deleteTypeHierarchyEntry, NULL);
+    ZIP_INIT(&server->typeHierarchy);
+}
+
+static UA_Boolean
+hasSupertype(const UA_TypeHierarchyEntry *e, const UA_NodeId *typeId) {
+    for(size_t i = 0; i < e->supertypesSize; i++) {
+        if(UA_NodeId_equal(&e->supertypes[i].nodeId, typeId) &&
+           e->supertypes[i].serverIndex == 0)
+            return true;
+    }
+    return false;
+}
+
+struct InvalidateTypeContext {
+    UA_TypeHierarchyTree remaining;
+    const UA_NodeId *typeId;
+};
+
+/* The iteration is over the old tree. The (unaffected) entries are moved into
+ * a new tree. */
+static void *
+invalidateTypeHierarchyEntry(void *context, UA_TypeHierarchyEntry *e) {
+    struct InvalidateTypeContext *ctx = (struct InvalidateTypeContext*)context;
+    if(UA_NodeId_equal(&e->typeId, ctx->typeId) || hasSupertype(e, ctx->typeId))
+        UA_TypeHierarchyEntry_delete(e);
+    else
+        ZIP_INSERT(UA_TypeHierarchyTree, &ctx->remaining, e);
+    return NULL;
+}
+
+void
+invalidateTypeHierarchy(UA_Server *server, const UA_NodeId *typeId) {
+    if(!ZIP_ROOT(&server->typeHierarchy))
+        return;
+    struct InvalidateTypeContext ctx;
+    ZIP_INIT(&ctx.remaining);
+    ctx.typeId = typeId;
+    ZIP_ITER(UA_TypeHierarchyTree, &server->typeHierarchy,
+             invalidateTypeHierarchyEntry, &ctx);
+    server->typeHierarchy = ctx.remaining;
+}
+
+/* Returns whether the supertypes of the type are known. Then the result of the
+ * subtype check is written out. The supertypes are looked up outside of the
+ * cache lock. If another thread added the same type in the meantime, its entry
+ * is used. */
+static UA_Boolean
+isCachedSubtype(UA_Server *server, const UA_NodeId *typeId,
+                const UA_NodeId *supertypeId, UA_Boolean *result) {
+    UA_TypeHierarchyEntry dummy;
+    dummy.hash = UA_NodeId_hash(typeId);
+    dummy.typeId = *typeId;
+    UA_LOCK(&server->viewCacheLock);
+    UA_TypeHierarchyEntry *e =
+        ZIP_FIND(UA_TypeHierarchyTree, &server->typeHierarchy, &dummy);
+    if(e)
+        *result = hasSupertype(e, supertypeId);
+    UA_UNLOCK(&server->viewCacheLock);
+    if(e)
+        return true;
+
+    /* Unknown nodes are not cached. They might be added later on. */
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, typeId, UA_NODEATTRIBUTESMASK_NONE,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+    if(!node)
+        return false;
+    UA_NODESTORE_RELEASE(server, node);
+
+    UA_TypeHierarchyEntry *newEntry = (UA_TypeHierarchyEntry*)
+        UA_calloc(1, sizeof(UA_TypeHierarchyEntry));
+    if(!newEntry)
+        return false;
+    UA_ReferenceTypeSet reftypes = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    UA_StatusCode res =
+        browseRecursive(server, 1, typeId, UA_BROWSEDIRECTION_INVERSE, &reftypes,
+                        UA_NODECLASS_UNSPECIFIED, false,
+                        &newEntry->supertypesSize, &newEntry->supertypes);
+    res |= UA_NodeId_copy(typeId, &newEntry->typeId);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_TypeHierarchyEntry_delete(newEntry);
+        return false;
+    }
+    newEntry->hash = dummy.hash;
+
+    UA_LOCK(&server->viewCacheLock);
+    e = ZIP_FIND(UA_TypeHierarchyTree, &server->typeHierarchy, &dummy);
+    if(!e) {
+        ZIP_INSERT(UA_TypeHierarchyTree, &server->typeHierarchy, newEntry);
+        e = newEntry;
+        newEntry = NULL;
+    }
+    *result = hasSupertype(e, supertypeId);
+    UA_UNLOCK(&server->viewCacheLock);
+    if(newEntry)
+        UA_TypeHierarchyEntry_delete(newEntry);
+    return true;
+}
+
 UA_Boolean
 isNodeInTree(UA_Server *server, const UA_NodeId *leafNode,
              const UA_NodeId *nodeToFind,
              const UA_ReferenceTypeSet *relevantRefs) {
+    /* Subtype check with the cached type hierarchy */
+    UA_ReferenceTypeSet hasSubtype = UA_REFTYPESET(UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    if(memcmp(relevantRefs, &hasSubtype, sizeof(UA_ReferenceTypeSet)) == 0) {
+        if(UA_NodeId_equal(leafNode, nodeToFind))
+            return true;
+        UA_Boolean result;
+        if(isCachedSubtype(server, leafNode, nodeToFind, &result))
+            return result;
+    }
+
     struct IsNodeInTreeContext ctx;
     memset(&ctx, 0, sizeof(struct IsNodeInTreeContext));
     ctx.server = server;
@@ -184,29 +340,64 @@ isNodeInTree_singleRef(UA_Server *server, const UA_NodeId *leafNode,
     return isNodeInTree(server, leafNode, nodeToFind, &reftypes);
 }
 
-static enum ZIP_CMP
-cmpTarget(const void *a, const void *b) {
-    const RefEntry *aa = (const RefEntry*)a;
-    const RefEntry *bb = (const RefEntry*)b;
-    if(aa->targetHash < bb->targetHash)
-        return ZIP_CMP_LESS;
-    if(aa->targetHash > bb->targetHash)
-        return ZIP_CMP_MORE;
-    return (enum ZIP_CMP)UA_ExpandedNodeId_order(aa->target, bb->target);
+/***********/
+/* RefTree */
+/***********/
+
+#define REFTREE_SPACE(capacity)                                         \
+    ((sizeof(UA_ExpandedNodeId) + 3 * sizeof(UA_UInt32)) * (capacity))
+
+static UA_UInt32 *
+RefTree_hashes(const RefTree *rt) {
+    return (UA_UInt32*)((uintptr_t)rt->targets +
+                        (sizeof(UA_ExpandedNodeId) * rt->capacity));
+}
+
+static UA_UInt32 *
+RefTree_slots(const RefTree *rt) {
+    return &RefTree_hashes(rt)[rt->capacity];
 }
 
-ZIP_FUNCTIONS(RefHead, RefEntry, zipfields, RefEntry, zipfields, cmpTarget)
+/* Returns the slot with the target or the empty slot where it can be added */
+static UA_UInt32 *
+RefTree_findSlot(const RefTree *rt, const UA_ExpandedNodeId *target,
+                 UA_UInt32 hash) {
+    const UA_UInt32 *hashes = RefTree_hashes(rt);
+    UA_UInt32 *slots = RefTree_slots(rt);
+    size_t mask = (rt->capacity * 2) - 1; /* The capacity is a power of two */
+    for(size_t i = hash & mask;; i = (i + 1) & mask) {
+        UA_UInt32 index = slots[i];
+        if(index == 0)
+            return &slots[i];
+        if(hashes[index - 1] == hash &&
+           UA_ExpandedNodeId_equal(&rt->targets[index - 1], target))
+            return &slots[i];
+    }
+}
+
+static void
+RefTree_reindex(RefTree *rt) {
+    const UA_UInt32 *hashes = RefTree_hashes(rt);
+    UA_UInt32 *slots = RefTree_slots(rt);
+    size_t mask = (rt->capacity * 2) - 1;
+    memset(slots, 0, sizeof(UA_UInt32) * rt->capacity * 2);
+    for(size_t j = 0; j < rt->size; j++) {
+        size_t i = hashes[j] & mask;
+        while(slots[i] != 0)
+            i = (i + 1) & mask;
+        slots[i] = (UA_UInt32)(j + 1);
+    }
+}
 
 UA_StatusCode
 RefTree_init(RefTree *rt) {
     rt->size = 0;
     rt->capacity = 0;
-    ZIP_INIT(&rt->head);
-    size_t space = (sizeof(UA_ExpandedNodeId) + sizeof(RefEntry)) * UA_REFTREE_INITIAL_SIZE;
-    rt->targets = (UA_ExpandedNodeId*)UA_malloc(space);
+    rt->targets = (UA_ExpandedNodeId*)UA_malloc(REFTREE_SPACE(UA_REFTREE_INITIAL_SIZE));
     if(!rt->targets)
         return UA_STATUSCODE_BADOUTOFMEMORY;
     rt->capacity = UA_REFTREE_INITIAL_SIZE;
+    memset(RefTree_slots(rt), 0, sizeof(UA_UInt32) * rt->capacity * 2);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -218,46 +409,46 @@ RefTree_clear(RefTree *rt) {
         UA_free(rt->targets);
 }
 
+void
+RefTree_reset(RefTree *rt) {
+    for(size_t i = 0; i < rt->size; i++)
+        UA_ExpandedNodeId_clear(&rt->targets[i]);
+    rt->size = 0;
+    memset(RefTree_slots(rt), 0, sizeof(UA_UInt32) * rt->capacity * 2);
+}
+
 /* Double the capacity of the reftree */
 static UA_StatusCode UA_FUNC_ATTR_WARN_UNUSED_RESULT
 RefTree_double(RefTree *rt) {
     size_t capacity = rt->capacity * 2;
     UA_assert(capacity > 0);
-    size_t space = (sizeof(UA_ExpandedNodeId) + sizeof(RefEntry)) * capacity;
-    UA_ExpandedNodeId *newTargets = (UA_ExpandedNodeId*)UA_realloc(rt->targets, space);
+    if(capacity >= UA_UINT32_MAX)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_ExpandedNodeId *newTargets = (UA_ExpandedNodeId*)
+        UA_realloc(rt->targets, REFTREE_SPACE(capacity));
     if(!newTargets)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
-    /* Move the entries to the new location  */
-    RefEntry *reArray = (RefEntry*)
-        ((uintptr_t)newTargets + (capacity * sizeof(UA_ExpandedNodeId)));
-    RefEntry *oldReArray = (RefEntry*)
+    /* Move the hashes to the new location and rebuild the index. The hashes
+     * are not recomputed and no NodeIds need to be compared. */
+    UA_UInt32 *oldHashes = (UA_UInt32*)
         ((uintptr_t)newTargets + (rt->capacity * sizeof(UA_ExpandedNodeId)));
-    memmove(reArray, oldReArray, rt->size * sizeof(RefEntry));
-
-    /* Reinsert all entries into the tree. The new pointer location has changed
-     * their ziptree rank. */
-    rt->head.root = NULL;
-    for(size_t i = 0; i < rt->size; i++) {
-        reArray[i].target = &newTargets[i];
-        ZIP_INSERT(RefHead, &rt->head, &reArray[i]);
-    }
-
-    rt->capacity = capacity;
     rt->targets = newTargets;
+    rt->capacity = capacity;
+    memmove(RefTree_hashes(rt), oldHashes, rt->size * sizeof(UA_UInt32));
+    RefTree_reindex(rt);
     return UA_STATUSCODE_GOOD;
 }
 
+/* The hash is passed in if it is already cached in the ReferenceTarget */
 static UA_StatusCode
-RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
+RefTree_addHashed(RefTree *rt, UA_NodePointer target, UA_UInt32 hash,
+                  UA_Boolean *duplicate) {
     UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(target);
 
     /* Is the target already in the tree? */
-    RefEntry dummy;
-    memset(&dummy, 0, sizeof(RefEntry));
-    dummy.target = &en;
-    dummy.targetHash = UA_ExpandedNodeId_hash(&en);
-    if(ZIP_FIND(RefHead, &rt->head, &dummy)) {
+    UA_UInt32 *slot = RefTree_findSlot(rt, &en, hash);
+    if(*slot != 0) {
         if(duplicate)
             *duplicate = true;
         return UA_STATUSCODE_GOOD;
@@ -268,20 +459,23 @@ RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
         s = RefTree_double(rt);
         if(s != UA_STATUSCODE_GOOD)
             return s;
+        slot = RefTree_findSlot(rt, &en, hash);
     }
     s = UA_ExpandedNodeId_copy(&en, &rt->targets[rt->size]);
     if(s != UA_STATUSCODE_GOOD)
         return s;
-    RefEntry *re = (RefEntry*)((uintptr_t)rt->targets +
-                               (sizeof(UA_ExpandedNodeId) * rt->capacity) +
-                               (sizeof(RefEntry) * rt->size));
-    re->target = &rt->targets[rt->size];
-    re->targetHash = dummy.targetHash;
-    ZIP_INSERT(RefHead, &rt->head, re);
+    RefTree_hashes(rt)[rt->size] = hash;
     rt->size++;
+    *slot = (UA_UInt32)rt->size;
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+RefTree_add(RefTree *rt, UA_NodePointer target, UA_Boolean *duplicate) {
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(target);
+    return RefTree_addHashed(rt, target, UA_ExpandedNodeId_hash(&en), duplicate);
+}
+
 UA_StatusCode
 RefTree_addNodeId(RefTree *rt, const UA_NodeId *target,
                   UA_Boolean *duplicate) {
@@ -290,10 +484,7 @@ RefTree_addNodeId(RefTree *rt, const UA_NodeId *target,
 
 UA_Boolean
 RefTree_contains(RefTree *rt, const UA_ExpandedNodeId *target) {
-    RefEntry dummy;
-    dummy.target = target;
-    dummy.targetHash = UA_ExpandedNodeId_hash(target);
-    return !!ZIP_FIND(RefHead, &rt->head, &dummy);
+    return (*RefTree_findSlot(rt, target, UA_ExpandedNodeId_hash(target)) != 0);
 }
 
 UA_Boolean
@@ -312,6 +503,7 @@ RefTree_containsNodeId(RefTree *rt, const UA_NodeId *target) {
 struct BrowseRecursiveContext {
     UA_Server *server;
     RefTree *rt;
+    RefTree *skipped; /* Visited nodes that don't match the nodeClassMask */
     UA_UInt16 depth;
     UA_BrowseDirection browseDirection;
     UA_ReferenceTypeSet refTypes;
@@ -339,20 +531,23 @@ browseRecursiveCallback(void *context, UA_ReferenceTarget *t) {
     /* We only look at the NodeClass attribute and a subset of the references.
      * Get a node with only these elements if the NodeStore supports that. */
     const UA_Node *node =
-        UA_NODESTORE_GETFROMREF_SELECTIVE(brc->server, t->targetId,
-                                          UA_NODEATTRIBUTESMASK_NODECLASS,
-                                          brc->refTypes, brc->browseDirection);
+        UA_NODESTORE_GETFROMTARGET_SELECTIVE(brc->server, t,
+                                             UA_NODEATTRIBUTESMASK_NODECLASS,
+                                             brc->refTypes, brc->browseDirection);
     if(!node)
         return NULL;
 
     /* Add the current node if we don't want to skip it as a start node and it
-     * matches the nodeClassMask filter Recurse into the children in any
-     * case. */
+     * matches the nodeClassMask filter. Recurse into the children in any case.
+     * The nodes not matching the filter are remembered as well. Otherwise
+     * their subtree is visited again for every path that leads there. */
     const UA_NodeHead *head = &node->head;
-    if((brc->includeStartNodes || brc->depth > 0)  &&
-       matchClassMask(node, brc->nodeClassMask)) {
+    if(brc->includeStartNodes || brc->depth > 0) {
         UA_Boolean duplicate = false;
-        brc->status = RefTree_addNodeId(brc->rt, &head->nodeId, &duplicate);
+        if(matchClassMask(node, brc->nodeClassMask))
+            brc->status = RefTree_addNodeId(brc->rt, &head->nodeId, &duplicate);
+        else
+            brc->status = RefTree_addNodeId(brc->skipped, &head->nodeId, &duplicate);
         if(duplicate || brc->status != UA_STATUSCODE_GOOD)
             goto cleanup;
     }
@@ -386,14 +581,20 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
                 UA_BrowseDirection browseDirection, const UA_ReferenceTypeSet *refTypes,
                 UA_UInt32 nodeClassMask, UA_Boolean includeStartNodes,
                 size_t *resultsSize, UA_ExpandedNodeId **results) {
-    RefTree rt;
+    RefTree rt, skipped;
     UA_StatusCode retval = RefTree_init(&rt);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
+    retval = RefTree_init(&skipped);
+    if(retval != UA_STATUSCODE_GOOD) {
+        RefTree_clear(&rt);
+        return retval;
+    }
 
     struct BrowseRecursiveContext brc;
     brc.server = server;
     brc.rt = &rt;
+    brc.skipped = &skipped;
     brc.depth = 0;
     brc.refTypes = *refTypes;
     brc.nodeClassMask = nodeClassMask;
@@ -402,6 +603,7 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
 
     for(size_t i = 0; i < startNodesSize && brc.status == UA_STATUSCODE_GOOD; i++) {
         UA_ReferenceTarget target;
+        memset(&target, 0, sizeof(UA_ReferenceTarget));
         target.targetId = UA_NodePointer_fromNodeId(&startNodes[i]);
 
         /* Call the inner recursive browse separately for the search direction.
@@ -420,6 +622,7 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
         }
     }
 
+    RefTree_clear(&skipped);
     if(rt.size > 0 && brc.status == UA_STATUSCODE_GOOD) {
         *results = rt.targets;
         *resultsSize = rt.size;
@@ -429,6 +632,445 @@ browseRecursive(UA_Server *server, size_t startNodesSize, const UA_NodeId *start
     return brc.status;
 }
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+
+/* The parallel walk goes level by level. The nodes of a level (the frontier)
+ * are expanded by the calling thread and the workers. Each expanded node is
+ * kept until the level is merged into the results. The merge is done by the
+ * calling thread alone in the order of the frontier. So the results do not
+ * depend on the scheduling of the threads.
+ *
+ * The calling thread holds the serviceMutex throughout. So no node is
+ * replaced or removed during the walk. The workers only read from the
+ * Nodestore and never take the serviceMutex. */
+
+/* Levels with fewer nodes are expanded by the calling thread alone */
+#define UA_BROWSERECURSIVE_PARALLEL_MIN 64
+
+/* Number of frontier nodes a thread takes at once */
+#define UA_BROWSERECURSIVE_CHUNK 16
+
+typedef struct {
+    UA_NodePointer target; /* Points into the expanded node */
+    UA_UInt32 hash;
+} BrowseChild;
+
+/* One for each thread that takes part in the walk. Index zero is used by the
+ * calling thread. */
+typedef struct {
+    BrowseChild *children;
+    size_t size;
+    size_t capacity;
+    UA_StatusCode status;
+} BrowseChildren;
+
+typedef struct {
+    const UA_Node *node; /* NULL if not found */
+    UA_Boolean matches;  /* Matches the nodeClassMask */
+    size_t thread;       /* Index of the BrowseChildren */
+    size_t childrenStart;
+    size_t childrenSize;
+} BrowseExpanded;
+
+typedef struct {
+    UA_Server *server;
+    UA_ReferenceTypeSet refTypes;
+    UA_BrowseDirection browseDirection;
+    UA_UInt32 nodeClassMask;
+
+    const UA_ExpandedNodeId *frontier;
+    size_t frontierSize;
+    size_t next; /* Next frontier entry to be taken */
+    BrowseExpanded *expanded; /* One for each frontier entry */
+    BrowseChildren *children;
+} BrowseLevel;
+
+static void *
+collectChild(void *context, UA_ReferenceTarget *t) {
+    BrowseChildren *bc = (BrowseChildren*)context;
+    if(bc->size >= bc->capacity) {
+        size_t capacity = (bc->capacity == 0) ? 64 : bc->capacity * 2;
+        BrowseChild *children = (BrowseChild*)
+            UA_realloc(bc->children, capacity * sizeof(BrowseChild));
+        if(!children) {
+            bc->status = UA_STATUSCODE_BADOUTOFMEMORY;
+            return (void*)0x01;
+        }
+        bc->children = children;
+        bc->capacity = capacity;
+    }
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(t->targetId);
+    bc->children[bc->size].target = t->targetId;
+    bc->children[bc->size].hash = UA_ExpandedNodeId_hash(&en);
+    bc->size++;
+    return NULL;
+}
+
+static void
+expandFrontierEntry(BrowseLevel *bl, size_t index, size_t thread) {
+    BrowseExpanded *be = &bl->expanded[index];
+    BrowseChildren *bc = &bl->children[thread];
+    be->thread = thread;
+    be->childrenStart = bc->size;
+    be->childrenSize = 0;
+    be->node = UA_NODESTORE_GET_SELECTIVE(bl->server, &bl->frontier[index].nodeId,
+                                          UA_NODEATTRIBUTESMASK_NODECLASS,
+                                          bl->refTypes, bl->browseDirection);
+    if(!be->node)
+        return;
+    be->matches = matchClassMask(be->node, bl->nodeClassMask);
+
+    const UA_NodeHead *head = &be->node->head;
+    for(size_t i = 0; i < head->referencesSize; i++) {
+        UA_NodeReferenceKind *rk = &head->references[i];
+        if(rk->isInverse != (bl->browseDirection == UA_BROWSEDIRECTION_INVERSE))
+            continue;
+        if(!UA_ReferenceTypeSet_contains(&bl->refTypes, rk->referenceTypeIndex))
+            continue;
+        if(UA_NodeReferenceKind_iterate(rk, collectChild, bc))
+            break;
+    }
+    be->childrenSize = bc->size - be->childrenStart;
+}
+
+#ifdef UA_ARCHITECTURE_WIN32
+typedef HANDLE UA_BrowseThread;
+#else
+typedef pthread_t UA_BrowseThread;
+#endif
+
+typedef struct {
+    UA_BrowseWorkers *bw;
+    size_t index; /* Index of the BrowseChildren used by the worker */
+    UA_BrowseThread thread;
+} BrowseWorker;
+
+struct UA_BrowseWorkers {
+#ifdef UA_ARCHITECTURE_WIN32
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE cond;     /* A level was started or the workers stop */
+    CONDITION_VARIABLE doneCond; /* A thread has left the level */
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t doneCond;
+#endif
+    UA_Boolean running;
+    BrowseLevel *level; /* The level that is expanded right now (or NULL) */
+    UA_UInt32 levelCounter; /* Every level is joined at most once per thread */
+    size_t busy;        /* Threads working on the level */
+    size_t workersSize;
+    BrowseWorker *workers; /* Allocated after the struct */
+};
+
+static void
+lockBrowseWorkers(UA_BrowseWorkers *bw) {
+#ifdef UA_ARCHITECTURE_WIN32
+    EnterCriticalSection(&bw->mutex);
+#else
+    pthread_mutex_lock(&bw->mutex);
+#endif
+}
+
+static void
+unlockBrowseWorkers(UA_BrowseWorkers *bw) {
+#ifdef UA_ARCHITECTURE_WIN32
+    LeaveCriticalSection(&bw->mutex);
+#else
+    pthread_mutex_unlock(&bw->mutex);
+#endif
+}
+
+/* Take chunks of the frontier until it is exhausted. Called and returns with
+ * the lock held. */
+static void
+expandChunks(UA_BrowseWorkers *bw, BrowseLevel *bl, size_t thread) {
+    while(bl->next < bl->frontierSize) {
+        size_t start = bl->next;
+        size_t end = start + UA_BROWSERECURSIVE_CHUNK;
+        if(end > bl->frontierSize)
+            end = bl->frontierSize;
+        bl->next = end;
+        unlockBrowseWorkers(bw);
+        for(size_t i = start; i < end; i++)
+            expandFrontierEntry(bl, i, thread);
+        lockBrowseWorkers(bw);
+    }
+}
+
+static void
+browseWorkerLoop(BrowseWorker *w) {
+    UA_BrowseWorkers *bw = w->bw;
+    UA_UInt32 joined = 0;
+    lockBrowseWorkers(bw);
+    while(bw->running) {
+        if(!bw->level || bw->levelCounter == joined) {
+#ifdef UA_ARCHITECTURE_WIN32
+            SleepConditionVariableCS(&bw->cond, &bw->mutex, INFINITE);
+#else
+            pthread_cond_wait(&bw->cond, &bw->mutex);
+#endif
+            continue;
+        }
+        joined = bw->levelCounter;
+        bw->busy++;
+        expandChunks(bw, bw->level, w->index);
+        bw->busy--;
+        if(bw->busy == 0) {
+#ifdef UA_ARCHITECTURE_WIN32
+            WakeConditionVariable(&bw->doneCond);
+#else
+            pthread_cond_signal(&bw->doneCond);
+#endif
+        }
+    }
+    unlockBrowseWorkers(bw);
+}
+
+#ifdef UA_ARCHITECTURE_WIN32
+static DWORD WINAPI
+browseWorkerThread(LPVOID w) {
+    browseWorkerLoop((BrowseWorker*)w);
+    return 0;
+}
+#else
+static void *
+browseWorkerThread(void *w) {
+    browseWorkerLoop((BrowseWorker*)w);
+    return NULL;
+}
+#endif
+
+/* Start the workers on first use */
+static UA_BrowseWorkers *
+getBrowseWorkers(UA_Server *server) {
+    if(server->browseWorkers)
+        return server->browseWorkers;
+
+    size_t workers = server->config.browseRecursiveWorkers;
+    UA_BrowseWorkers *bw = (UA_BrowseWorkers*)
+        UA_calloc(1, sizeof(UA_BrowseWorkers) + (workers * sizeof(BrowseWorker)));
+    if(!bw)
+        return NULL;
+    bw->running = true;
+    bw->workers = (BrowseWorker*)(uintptr_t)(bw + 1);
+#ifdef UA_ARCHITECTURE_WIN32
+    InitializeCriticalSection(&bw->mutex);
+    InitializeConditionVariable(&bw->cond);
+    InitializeConditionVariable(&bw->doneCond);
+#else
+    pthread_mutex_init(&bw->mutex, NULL);
+    pthread_cond_init(&bw->cond, NULL);
+    pthread_cond_init(&bw->doneCond, NULL);
+#endif
+
+    for(; bw->workersSize < workers; bw->workersSize++) {
+        BrowseWorker *w = &bw->workers[bw->workersSize];
+        w->bw = bw;
+        w->index = bw->workersSize + 1;
+#ifdef UA_ARCHITECTURE_WIN32
+        w->thread = CreateThread(NULL, 0, browseWorkerThread, w, 0, NULL);
+        UA_Boolean created = (w->thread != NULL);
+#else
+        UA_Boolean created =
+            (pthread_create(&w->thread, NULL, browseWorkerThread, w) == 0);
+#endif
+        if(!created) {
+            UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                           "BrowseRecursive: Could only start %u of %u threads",
+                           (unsigned)bw->workersSize, (unsigned)workers);
+            break;
+        }
+    }
+
+    server->browseWorkers = bw;
+    return bw;
+}
+
+void
+UA_BrowseWorkers_delete(UA_BrowseWorkers *bw) {
+    if(!bw)
+        return;
+
+    lockBrowseWorkers(bw);
+    bw->running = false;
+#ifdef UA_ARCHITECTURE_WIN32
+    WakeAllConditionVariable(&bw->cond);
+#else
+    pthread_cond_broadcast(&bw->cond);
+#endif
+    unlockBrowseWorkers(bw);
+
+    for(size_t i = 0; i < bw->workersSize; i++) {
+#ifdef UA_ARCHITECTURE_WIN32
+        WaitForSingleObject(bw->workers[i].thread, INFINITE);
+        CloseHandle(bw->workers[i].thread);
+#else
+        pthread_join(bw->workers[i].thread, NULL);
+#endif
+    }
+
+#ifdef UA_ARCHITECTURE_WIN32
+    DeleteCriticalSection(&bw->mutex);
+#else
+    pthread_cond_destroy(&bw->doneCond);
+    pthread_cond_destroy(&bw->cond);
+    pthread_mutex_destroy(&bw->mutex);
+#endif
+    UA_free(bw);
+}
+
+static void
+expandLevel(UA_BrowseWorkers *bw, BrowseLevel *bl) {
+    bl->next = 0;
+
+    /* Small levels are not worth waking up the workers */
+    if(!bw || bw->workersSize == 0 ||
+       bl->frontierSize < UA_BROWSERECURSIVE_PARALLEL_MIN) {
+        for(size_t i = 0; i < bl->frontierSize; i++)
+            expandFrontierEntry(bl, i, 0);
+        return;
+    }
+
+    lockBrowseWorkers(bw);
+    bw->level = bl;
+    bw->levelCounter++;
+#ifdef UA_ARCHITECTURE_WIN32
+    WakeAllConditionVariable(&bw->cond);
+#else
+    pthread_cond_broadcast(&bw->cond);
+#endif
+    expandChunks(bw, bl, 0);
+    while(bw->busy > 0) {
+#ifdef UA_ARCHITECTURE_WIN32
+        SleepConditionVariableCS(&bw->doneCond, &bw->mutex, INFINITE);
+#else
+        pthread_cond_wait(&bw->doneCond, &bw->mutex);
+#endif
+    }
+    bw->level = NULL;
+    unlockBrowseWorkers(bw);
+}
+
+/* Add the expanded nodes of the level to the results. New local children are
+ * added to the visited nodes. They form the next frontier. */
+static UA_StatusCode
+mergeLevel(BrowseLevel *bl, RefTree *rt, RefTree *visited,
+           UA_Boolean addNodes, UA_Boolean addChildren) {
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < bl->frontierSize; i++) {
+        BrowseExpanded *be = &bl->expanded[i];
+        if(!be->node)
+            continue;
+        if(res == UA_STATUSCODE_GOOD && addNodes && be->matches)
+            res = RefTree_addNodeId(rt, &be->node->head.nodeId, NULL);
+        const BrowseChild *bc = &bl->children[be->thread].children[be->childrenStart];
+        for(size_t j = 0; j < be->childrenSize && addChildren &&
+                res == UA_STATUSCODE_GOOD; j++) {
+            if(UA_NodePointer_isLocal(bc[j].target))
+                res = RefTree_addHashed(visited, bc[j].target, bc[j].hash, NULL);
+            else
+                res = RefTree_addHashed(rt, bc[j].target, bc[j].hash, NULL);
+        }
+        UA_NODESTORE_RELEASE(bl->server, be->node);
+    }
+    return res;
+}
+
+static UA_StatusCode
+browseRecursiveParallel(UA_Server *server, const UA_NodeId *startNode,
+                        UA_BrowseDirection browseDirection,
+                        const UA_ReferenceTypeSet *refTypes, UA_UInt32 nodeClassMask,
+                        size_t *resultsSize, UA_ExpandedNodeId **results) {
+    UA_BrowseWorkers *bw = getBrowseWorkers(server);
+    size_t threads = (bw) ? bw->workersSize + 1 : 1;
+
+    RefTree rt, visited;
+    UA_StatusCode res = RefTree_init(&rt);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    res = RefTree_init(&visited);
+    if(res != UA_STATUSCODE_GOOD) {
+        RefTree_clear(&rt);
+        return res;
+    }
+
+    BrowseLevel bl;
+    memset(&bl, 0, sizeof(BrowseLevel));
+    bl.server = server;
+    bl.refTypes = *refTypes;
+    bl.nodeClassMask = nodeClassMask;
+    bl.children = (BrowseChildren*)UA_calloc(threads, sizeof(BrowseChildren));
+    size_t expandedCapacity = 0;
+    if(!bl.children)
+        res = UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* The start node is not added to the results (but can be reached again
+     * through a loop). Walk separately for the search direction. Otherwise we
+     * might take one step up and another step down in the search tree. */
+    UA_ExpandedNodeId start;
+    start.nodeId = *startNode;
+    start.namespaceUri = UA_STRING_NULL;
+    start.serverIndex = 0;
+    for(size_t d = 0; d < 2 && res == UA_STATUSCODE_GOOD; d++) {
+        bl.browseDirection = (d == 0) ?
+            UA_BROWSEDIRECTION_FORWARD : UA_BROWSEDIRECTION_INVERSE;
+        if(browseDirection != UA_BROWSEDIRECTION_BOTH &&
+           browseDirection != bl.browseDirection)
+            continue;
+
+        bl.frontier = &start;
+        bl.frontierSize = 1;
+        for(size_t depth = 0; depth < UA_MAX_TREE_RECURSE && bl.frontierSize > 0;
+            depth++) {
+            if(expandedCapacity < bl.frontierSize) {
+                BrowseExpanded *expanded = (BrowseExpanded*)
+                    UA_realloc(bl.expanded, bl.frontierSize * sizeof(BrowseExpanded));
+                if(!expanded) {
+                    res = UA_STATUSCODE_BADOUTOFMEMORY;
+                    break;
+                }
+                bl.expanded = expanded;
+                expandedCapacity = bl.frontierSize;
+            }
+            for(size_t i = 0; i < threads; i++)
+                bl.children[i].size = 0;
+
+            expandLevel(bw, &bl);
+
+            size_t visitedSize = visited.size;
+            res = mergeLevel(&bl, &rt, &visited, depth > 0,
+                             depth + 1 < UA_MAX_TREE_RECURSE);
+            for(size_t i = 0; i < threads; i++) {
+                if(bl.children[i].status != UA_STATUSCODE_GOOD)
+                    res = bl.children[i].status;
+            }
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+
+            bl.frontier = &visited.targets[visitedSize];
+            bl.frontierSize = visited.size - visitedSize;
+        }
+    }
+
+    if(bl.children) {
+        for(size_t i = 0; i < threads; i++)
+            UA_free(bl.children[i].children);
+        UA_free(bl.children);
+    }
+    UA_free(bl.expanded);
+    RefTree_clear(&visited);
+    if(rt.size > 0 && res == UA_STATUSCODE_GOOD) {
+        *results = rt.targets;
+        *resultsSize = rt.size;
+    } else {
+        RefTree_clear(&rt);
+    }
+    return res;
+}
+
+#endif /* UA_BROWSERECURSIVE_PARALLEL */
+
 UA_StatusCode
 UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
                           size_t *resultsSize, UA_ExpandedNodeId **results) {
@@ -444,6 +1086,13 @@ UA_Server_browseRecursive(UA_Server *server, const UA_BrowseDescription *bd,
     }
 
     /* Browse */
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+    if(server->config.browseRecursiveWorkers > 0)
+        retval = browseRecursiveParallel(server, &bd->nodeId, bd->browseDirection,
+                                         &refTypes, bd->nodeClassMask,
+                                         resultsSize, results);
+    else
+#endif
     retval = browseRecursive(server, 1, &bd->nodeId, bd->browseDirection,
                              &refTypes, bd->nodeClassMask, false, resultsSize, results);
 
@@ -494,11 +1143,144 @@ RefResult_clear(RefResult *rr) {
     UA_free(rr->descr);
 }
 
-struct ContinuationPoint {
-    ContinuationPoint *next;
-    UA_ByteString identifier;
+/*****************/
+/* Browse Cache  */
+/*****************/
+
+static UA_UInt32
+browseCacheHash(const UA_BrowseDescription *bd) {
+    UA_UInt32 params[5] = {UA_NodeId_hash(&bd->referenceTypeId),
+                           (UA_UInt32)bd->browseDirection,
+                           (UA_UInt32)bd->includeSubtypes,
+                           bd->nodeClassMask, bd->resultMask};
+    return UA_ByteString_hash(UA_NodeId_hash(&bd->nodeId),
+                              (const UA_Byte*)params, sizeof(params));
+}
+
+/* The DisplayName in the results is selected by the locales of the session */
+static UA_UInt32
+browseCacheLocaleHash(const UA_Session *session) {
+    UA_UInt32 h = 0;
+    for(size_t i = 0; i < session->localeIdsSize; i++) {
+        const UA_String *l = &session->localeIds[i];
+        h = UA_ByteString_hash(h, l->data, l->length);
+        h = UA_ByteString_hash(h, (const UA_Byte*)"", 1); /* Separator */
+    }
+    return h;
+}
+
+static void
+UA_BrowseCacheEntry_clear(UA_BrowseCacheEntry *e) {
+    if(e->references)
+        UA_Array_delete(e->references, e->referencesSize,
+                        &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    UA_BrowseDescription_clear(&e->bd);
+    memset(e, 0, sizeof(UA_BrowseCacheEntry));
+}
+
+static void
+UA_TranslateCache_clear(UA_Server *server);
+
+void
+UA_BrowseCache_clear(UA_Server *server) {
+    for(size_t i = 0; i < server->browseCacheSize; i++)
+        UA_BrowseCacheEntry_clear(&server->browseCache[i]);
+    UA_free(server->browseCache);
+    server->browseCache = NULL;
+    server->browseCacheSize = 0;
+    UA_TranslateCache_clear(server);
+}
+
+void
+UA_Server_invalidateBrowseCache(UA_Server *server) {
+    UA_LOCK(&server->serviceMutex);
+    invalidateBrowseCache(server);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+/* Copy the cached references if they fit into maxReferences. Returns false if
+ * nothing usable is cached. */
+static UA_Boolean
+browseCacheLookup(UA_Server *server, UA_Session *session,
+                  const UA_BrowseDescription *bd, UA_UInt32 maxReferences,
+                  UA_ReferenceDescription **refs, size_t *refsSize) {
+    UA_Boolean found = false;
+    UA_UInt32 hash = browseCacheHash(bd);
+    const UA_BrowseCacheEntry *e;
+    UA_LOCK(&server->viewCacheLock);
+    if(server->browseCacheSize == 0)
+        goto out;
+    e = &server->browseCache[hash % server->browseCacheSize];
+    if(!e->references || e->generation != server->browseCacheGeneration ||
+       e->hash != hash || e->localeHash != browseCacheLocaleHash(session) ||
+       e->referencesSize > maxReferences ||
+       UA_order(&e->bd, bd, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]) != UA_ORDER_EQ)
+        goto out;
+    *refs = NULL;
+    *refsSize = e->referencesSize;
+    found = (e->referencesSize == 0 ||
+             UA_Array_copy(e->references, e->referencesSize, (void**)refs,
+                           &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]) ==
+             UA_STATUSCODE_GOOD);
+ out:
+    UA_UNLOCK(&server->viewCacheLock);
+    return found;
+}
+
+/* Store the complete result of browsing the BrowseDescription. The generation
+ * was sampled before browsing. The entry is stale right away if the results
+ * were changed in the meantime. */
+static void
+browseCacheStore(UA_Server *server, UA_Session *session,
+                 const UA_BrowseDescription *bd, UA_UInt32 generation,
+                 const RefResult *rr) {
+    UA_UInt32 hash = browseCacheHash(bd);
+    UA_BrowseCacheEntry *e;
+    UA_StatusCode res;
+    UA_UInt32 size = server->config.browseCacheSize;
+    UA_LOCK(&server->viewCacheLock);
+
+    /* (Re)allocate the cache if the configuration changed */
+    if(server->browseCacheSize != size) {
+        UA_BrowseCache_clear(server);
+        if(size == 0)
+            goto out;
+        server->browseCache = (UA_BrowseCacheEntry*)
+            UA_calloc(size, sizeof(UA_BrowseCacheEntry));
+        if(!server->browseCache)
+            goto out;
+        server->browseCacheSize = size;
+    }
+
+    /* Replace the entry in the slot */
+    e = &server->browseCache[hash % size];
+    UA_BrowseCacheEntry_clear(e);
+    res = UA_BrowseDescription_copy(bd, &e->bd);
+    res |= UA_Array_copy(rr->descr, rr->size, (void**)&e->references,
+                         &UA_TYPES[UA_TYPES_REFERENCEDESCRIPTION]);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_BrowseCacheEntry_clear(e);
+        goto out;
+    }
+    e->referencesSize = rr->size;
+    e->generation = generation;
+    e->hash = hash;
+    e->localeHash = browseCacheLocaleHash(session);
+
+ out:
+    UA_UNLOCK(&server->viewCacheLock);
+}
 
-    /* Parameters of the Browse Request */
+struct ContinuationPoint {
+    ContinuationPoint *next; /* In the list of the Session */
+    TAILQ_ENTRY(ContinuationPoint) serverEntry;
+    UA_Session *session; /* Set while in the server-wide list */
+    size_t memorySize;
+    UA_Guid identifier;
+
+    /* Parameters of the Browse Request. Only the NodeId is deep-copied when the
+     * ContinuationPoint is persisted. The ReferenceTypeId is resolved into
+     * relevantReferences before. */
     UA_BrowseDescription browseDescription;
     UA_UInt32 maxReferences;
     UA_ReferenceTypeSet relevantReferences;
@@ -511,14 +1293,80 @@ struct ContinuationPoint {
     UA_Boolean lastRefInverse;
 };
 
+/* The ContinuationPoint lists of the Sessions, the server-wide list and the
+ * memory accounting are protected by the continuationPointsLock. A
+ * ContinuationPoint that is used by BrowseNext is taken out of the lists
+ * during the browse. So it cannot be evicted by a concurrent Browse of another
+ * Session on the shared side of the service lock. */
+
 ContinuationPoint *
-ContinuationPoint_clear(ContinuationPoint *cp) {
-    UA_ByteString_clear(&cp->identifier);
-    UA_BrowseDescription_clear(&cp->browseDescription);
+ContinuationPoint_clear(UA_Server *server, ContinuationPoint *cp) {
+    if(cp->session) {
+        TAILQ_REMOVE(&server->continuationPoints, cp, serverEntry);
+        server->continuationPointsMemory -= cp->memorySize;
+        cp->session = NULL;
+    }
+    UA_NodeId_clear(&cp->browseDescription.nodeId);
     UA_NodePointer_clear(&cp->lastTarget);
     return cp->next;
 }
 
+/* Estimate the memory used by the ContinuationPoint */
+static size_t
+ContinuationPoint_memory(const ContinuationPoint *cp) {
+    UA_ExpandedNodeId en = UA_NodePointer_toExpandedNodeId(cp->lastTarget);
+    return sizeof(ContinuationPoint) +
+        UA_calcSizeBinary(&cp->browseDescription.nodeId, &UA_TYPES[UA_TYPES_NODEID]) +
+        UA_calcSizeBinary(&en, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+}
+
+/* Add the ContinuationPoint to the Session and as the most recently used to
+ * the server-wide list */
+static void
+ContinuationPoint_attach(UA_Server *server, UA_Session *session,
+                         ContinuationPoint *cp) {
+    cp->next = session->continuationPoints;
+    session->continuationPoints = cp;
+    cp->session = session;
+    TAILQ_INSERT_TAIL(&server->continuationPoints, cp, serverEntry);
+    server->continuationPointsMemory += cp->memorySize;
+}
+
+/* Take the ContinuationPoint out of the lists. It still counts against the
+ * availableContinuationPoints of the Session. */
+static void
+ContinuationPoint_detach(UA_Server *server, ContinuationPoint **prev,
+                         ContinuationPoint *cp) {
+    *prev = cp->next;
+    cp->next = NULL;
+    TAILQ_REMOVE(&server->continuationPoints, cp, serverEntry);
+    server->continuationPointsMemory -= cp->memorySize;
+    cp->session = NULL;
+}
+
+/* Remove the least recently used ContinuationPoints until the additional
+ * memory fits within the limit */
+static void
+evictContinuationPoints(UA_Server *server, size_t additional) {
+    size_t limit = server->config.maxBrowseContinuationPointsMemory;
+    if(limit == 0)
+        return;
+    ContinuationPoint *cp;
+    while(server->continuationPointsMemory + additional > limit &&
+          (cp = TAILQ_FIRST(&server->continuationPoints))) {
+        UA_Session *session = cp->session;
+        ContinuationPoint **prev = &session->continuationPoints;
+        while(*prev != cp)
+            prev = &(*prev)->next;
+        UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                             "Evict a Browse ContinuationPoint "
+                             "(memory limit reached)");
+        *prev = ContinuationPoint_clear(server, cp);
+        UA_free(cp);
+        ++session->availableContinuationPoints;
+    }
+}
+
 struct BrowseContext {
     /* Context */
     ContinuationPoint *cp;
@@ -534,6 +1382,8 @@ struct BrowseContext {
     RefResult rr;
     UA_StatusCode status;
     UA_Boolean done;
+    UA_Boolean useCache; /* Set to false once the results are taken from the
+                          * cache */
 };
 
 /* Target node on top of the stack */
@@ -613,9 +1463,9 @@ browseReferencTargetCallback(void *context, UA_ReferenceTarget *t) {
      * including those for figuring out the TypeDefinition (if that was
      * requested). */
     const UA_Node *target =
-        UA_NODESTORE_GETFROMREF_SELECTIVE(bc->server, t->targetId,
-                                          resultMask2AttributesMask(bd->resultMask),
-                                          bc->resultRefs, bd->browseDirection);
+        UA_NODESTORE_GETFROMTARGET_SELECTIVE(bc->server, t,
+                                             resultMask2AttributesMask(bd->resultMask),
+                                             bc->resultRefs, bd->browseDirection);
     if(!target)
         return NULL;
 
@@ -699,18 +1549,17 @@ browseWithNode(struct BrowseContext *bc, const UA_NodeHead *head ) {
                           &key, &left, &right);
                 rk->targets.tree.idRoot = right.root;
             } else {
-                /* Iterate over the array to find the match */
-                for(; nextTargetIndex < rk->targetsSize; nextTargetIndex++) {
-                    UA_ReferenceTarget *t = &rk->targets.array[nextTargetIndex];
-                    if(UA_NodePointer_equal(cp->lastTarget, t->targetId))
-                        break;
-                }
-                if(nextTargetIndex == rk->targetsSize) {
-                    /* Not found - assume that this reference kind is done */
+                /* Binary search in the sorted array. Continue after the last
+                 * target (or where it was if it was removed since). */
+                UA_Boolean found;
+                nextTargetIndex = refTargetArrayPos(rk, cp->lastTarget, &found);
+                if(!found && nextTargetIndex == rk->targetsSize) {
+                    /* Nothing left - assume that this reference kind is done */
                     bc->activeCP = false;
                     continue;
                 }
-                nextTargetIndex++; /* From the last index to the next index */
+                if(found)
+                    nextTargetIndex++; /* From the last index to the next index */
                 rk->targets.array = &rk->targets.array[nextTargetIndex];
                 rk->targetsSize -= nextTargetIndex;
             }
@@ -785,17 +1634,49 @@ browse(struct BrowseContext *bc) {
     /* Check AccessControl rights */
     if(bc->session != &bc->server->adminSession) {
         UA_LOCK_ASSERT(&bc->server->serviceMutex, 1);
-        UA_UNLOCK(&bc->server->serviceMutex);
-        if(!bc->server->config.accessControl.
-           allowBrowseNode(bc->server, &bc->server->config.accessControl,
-                           &bc->session->sessionId, bc->session->context,
-                           &descr->nodeId, node->head.context)) {
-            UA_LOCK(&bc->server->serviceMutex);
+        UA_UInt32 generation = 0;
+        UA_AccessCacheEntry *ce =
+            getCachedAccess(bc->server, bc->session, &descr->nodeId,
+                            UA_ACCESSCACHE_BROWSE, &generation);
+        UA_Boolean allowed;
+        if(ce) {
+            allowed = ce->browse;
+        } else {
+            UA_Boolean shared = UA_LOCK_SUSPEND(&bc->server->serviceMutex);
+            allowed = bc->server->config.accessControl.
+                allowBrowseNode(bc->server, &bc->server->config.accessControl,
+                                &bc->session->sessionId, bc->session->context,
+                                &descr->nodeId, node->head.context);
+            UA_LOCK_RESUME(&bc->server->serviceMutex, shared);
+            ce = cacheAccess(bc->server, bc->session, &descr->nodeId,
+                             UA_ACCESSCACHE_BROWSE, generation);
+            if(ce)
+                ce->browse = allowed;
+        }
+        if(!allowed) {
             UA_NODESTORE_RELEASE(bc->server, node);
             bc->status = UA_STATUSCODE_BADUSERACCESSDENIED;
             return;
         }
-        UA_LOCK(&bc->server->serviceMutex);
+    }
+
+    /* Take the results from the cache if they fit into a single response */
+    if(bc->useCache) {
+        UA_ReferenceDescription *refs = NULL;
+        size_t refsSize = 0;
+        if(browseCacheLookup(bc->server, bc->session, descr,
+                             cp->maxReferences, &refs, &refsSize)) {
+            UA_NODESTORE_RELEASE(bc->server, node);
+            if(refsSize > 0) {
+                RefResult_clear(&bc->rr);
+                bc->rr.descr = refs;
+                bc->rr.size = refsSize;
+                bc->rr.capacity = refsSize;
+            }
+            bc->useCache = false;
+            bc->done = true;
+            return;
+        }
     }
 
     /* Browse the node */
@@ -836,6 +1717,11 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     cp.maxReferences = *maxrefs;
     cp.browseDescription = *descr; /* Shallow copy. Deep-copy later if we persist the cp. */
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    /* Add the nodes of the lazy PubSub information model */
+    UA_PubSubManager_materializeNode(server, &descr->nodeId);
+#endif
+
     /* How many references can we return at most? */
     if(cp.maxReferences == 0) {
         if(server->config.maxReferencesPerNode != 0) {
@@ -865,6 +1751,7 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     bc.status = UA_STATUSCODE_GOOD;
     bc.done = false;
     bc.activeCP = false;
+    bc.useCache = (server->config.browseCacheSize > 0);
     bc.resultRefs = cp.relevantReferences;
     if(cp.browseDescription.resultMask & UA_BROWSERESULTMASK_TYPEDEFINITION) {
         /* Get the node with additional reference types if we need to lookup the
@@ -878,8 +1765,13 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
         return;
 
     /* Perform the browse */
+    UA_UInt32 generation = server->browseCacheGeneration;
     browse(&bc);
 
+    /* Cache the complete results */
+    if(bc.useCache && bc.done && bc.status == UA_STATUSCODE_GOOD)
+        browseCacheStore(server, session, descr, generation, &bc.rr);
+
     if(bc.status != UA_STATUSCODE_GOOD || bc.rr.size == 0) {
         /* No relevant references, return array of length zero */
         RefResult_clear(&bc.rr);
@@ -899,15 +1791,8 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     /* Persist the continuation point */
 
     ContinuationPoint *cp2 = NULL;
-    UA_Guid *ident = NULL;
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
 
-    /* Enough space for the continuation point? */
-    if(session->availableContinuationPoints == 0) {
-        retval = UA_STATUSCODE_BADNOCONTINUATIONPOINTS;
-        goto cleanup;
-    }
-
     /* Allocate and fill the data structure */
     cp2 = (ContinuationPoint*)UA_calloc(1, sizeof(ContinuationPoint));
     if(!cp2) {
@@ -916,9 +1801,13 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     }
 
     /* The BrowseDescription is only a shallow copy so far */
-    retval = UA_BrowseDescription_copy(descr, &cp2->browseDescription);
+    retval = UA_NodeId_copy(&descr->nodeId, &cp2->browseDescription.nodeId);
     if(retval != UA_STATUSCODE_GOOD)
         goto cleanup;
+    cp2->browseDescription.browseDirection = descr->browseDirection;
+    cp2->browseDescription.includeSubtypes = descr->includeSubtypes;
+    cp2->browseDescription.nodeClassMask = descr->nodeClassMask;
+    cp2->browseDescription.resultMask = descr->resultMask;
     cp2->maxReferences = cp.maxReferences;
     cp2->relevantReferences = cp.relevantReferences;
     cp2->lastTarget = cp.lastTarget; /* Move the (deep) copy */
@@ -926,30 +1815,38 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     cp2->lastRefKindIndex = cp.lastRefKindIndex;
     cp2->lastRefInverse = cp.lastRefInverse;
 
-    /* Create a random bytestring via a Guid */
-    ident = UA_Guid_new();
-    if(!ident) {
-        retval = UA_STATUSCODE_BADOUTOFMEMORY;
-        goto cleanup;
-    }
-    *ident = UA_Guid_random();
-    cp2->identifier.data = (UA_Byte*)ident;
-    cp2->identifier.length = sizeof(UA_Guid);
+    /* Create a random identifier via a Guid */
+    cp2->identifier = UA_Guid_random();
 
     /* Return the cp identifier */
-    retval = UA_ByteString_copy(&cp2->identifier, &result->continuationPoint);
+    retval = UA_ByteString_allocBuffer(&result->continuationPoint, sizeof(UA_Guid));
     if(retval != UA_STATUSCODE_GOOD)
         goto cleanup;
+    memcpy(result->continuationPoint.data, &cp2->identifier, sizeof(UA_Guid));
 
-    /* Attach the cp to the session */
-    cp2->next = session->continuationPoints;
-    session->continuationPoints = cp2;
+    cp2->memorySize = ContinuationPoint_memory(cp2);
+
+    UA_LOCK(&server->continuationPointsLock);
+
+    /* Enough space for the continuation point? */
+    if(session->availableContinuationPoints == 0) {
+        UA_UNLOCK(&server->continuationPointsLock);
+        retval = UA_STATUSCODE_BADNOCONTINUATIONPOINTS;
+        goto cleanup;
+    }
+
+    /* Make room within the memory limit and attach the cp to the session and
+     * the server */
+    evictContinuationPoints(server, cp2->memorySize);
+    ContinuationPoint_attach(server, session, cp2);
     --session->availableContinuationPoints;
+
+    UA_UNLOCK(&server->continuationPointsLock);
     return;
 
  cleanup:
     if(cp2) {
-        ContinuationPoint_clear(cp2);
+        ContinuationPoint_clear(server, cp2);
         UA_free(cp2);
     }
     UA_NodePointer_clear(&cp.lastTarget);
@@ -957,23 +1854,28 @@ Operation_Browse(UA_Server *server, UA_Session *session, const UA_UInt32 *maxref
     result->statusCode = retval;
 }
 
+static UA_StatusCode
+checkBrowseRequest(UA_Server *server, const UA_BrowseRequest *request) {
+    /* Test the number of operations in the request */
+    if(server->config.maxNodesPerBrowse != 0 &&
+       request->nodesToBrowseSize > server->config.maxNodesPerBrowse)
+        return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+
+    /* No views supported at the moment */
+    if(!UA_NodeId_isNull(&request->view.viewId))
+        return UA_STATUSCODE_BADVIEWIDUNKNOWN;
+
+    return UA_STATUSCODE_GOOD;
+}
+
 void Service_Browse(UA_Server *server, UA_Session *session,
                     const UA_BrowseRequest *request, UA_BrowseResponse *response) {
     UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing BrowseRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    /* Test the number of operations in the request */
-    if(server->config.maxNodesPerBrowse != 0 &&
-       request->nodesToBrowseSize > server->config.maxNodesPerBrowse) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
-        return;
-    }
-
-    /* No views supported at the moment */
-    if(!UA_NodeId_isNull(&request->view.viewId)) {
-        response->responseHeader.serviceResult = UA_STATUSCODE_BADVIEWIDUNKNOWN;
+    response->responseHeader.serviceResult = checkBrowseRequest(server, request);
+    if(response->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
         return;
-    }
 
     response->responseHeader.serviceResult =
         UA_Server_processServiceOperations(server, session,
@@ -985,6 +1887,26 @@ void Service_Browse(UA_Server *server, UA_Session *session,
                                            &UA_TYPES[UA_TYPES_BROWSERESULT]);
 }
 
+void
+Service_BrowseStream(UA_Server *server, UA_Session *session,
+                     UA_ResponseStream *stream, const UA_BrowseRequest *request,
+                     UA_BrowseResponse *response) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session, "Processing BrowseRequest");
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    UA_StatusCode res = checkBrowseRequest(server, request);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_streamServiceOperations(server, session, stream,
+                                                &response->responseHeader,
+                                                (UA_ServiceOperation)Operation_Browse,
+                                                &request->requestedMaxReferencesPerNode,
+                                                &request->nodesToBrowseSize,
+                                                &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION],
+                                                &UA_TYPES[UA_TYPES_BROWSERESULT]);
+    if(!stream->started)
+        response->responseHeader.serviceResult = res;
+}
+
 UA_BrowseResult
 UA_Server_browse(UA_Server *server, UA_UInt32 maxReferences,
                  const UA_BrowseDescription *bd) {
@@ -1000,26 +1922,28 @@ static void
 Operation_BrowseNext(UA_Server *server, UA_Session *session,
                      const UA_Boolean *releaseContinuationPoints,
                      const UA_ByteString *continuationPoint, UA_BrowseResult *result) {
-    /* Find the continuation point */
+    /* Find the continuation point and take it out of the lists. Then it
+     * cannot be evicted while we browse. */
+    UA_LOCK(&server->continuationPointsLock);
     ContinuationPoint **prev = &session->continuationPoints;
     ContinuationPoint *cp;
     while((cp = *prev)) {
-        if(UA_ByteString_equal(&cp->identifier, continuationPoint))
+        if(continuationPoint->length == sizeof(UA_Guid) &&
+           memcmp(continuationPoint->data, &cp->identifier, sizeof(UA_Guid)) == 0)
             break;
         prev = &cp->next;
     }
     if(!cp) {
+        UA_UNLOCK(&server->continuationPointsLock);
         result->statusCode = UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
         return;
     }
+    ContinuationPoint_detach(server, prev, cp);
+    UA_UNLOCK(&server->continuationPointsLock);
 
     /* Remove the cp */
-    if(*releaseContinuationPoints) {
-        *prev = ContinuationPoint_clear(cp);
-        UA_free(cp);
-        ++session->availableContinuationPoints;
-        return;
-    }
+    if(*releaseContinuationPoints)
+        goto remove_cp;
 
     /* Prepare the context */
     struct BrowseContext bc;
@@ -1028,6 +1952,7 @@ Operation_BrowseNext(UA_Server *server, UA_Session *session,
     bc.session = session;
     bc.status = UA_STATUSCODE_GOOD;
     bc.done = false;
+    bc.useCache = false;
     bc.activeCP = true;
     bc.resultRefs = cp->relevantReferences;
     if(cp->browseDescription.resultMask & UA_BROWSERESULTMASK_TYPEDEFINITION) {
@@ -1039,7 +1964,7 @@ Operation_BrowseNext(UA_Server *server, UA_Session *session,
     }
     result->statusCode = RefResult_init(&bc.rr);
     if(result->statusCode != UA_STATUSCODE_GOOD)
-        return;
+        goto reattach_cp;
 
     /* Continue browsing */
     browse(&bc);
@@ -1060,18 +1985,30 @@ Operation_BrowseNext(UA_Server *server, UA_Session *session,
         goto remove_cp;
 
     /* Return the cp identifier to signal that there are references left */
-    bc.status = UA_ByteString_copy(&cp->identifier, &result->continuationPoint);
+    bc.status = UA_ByteString_allocBuffer(&result->continuationPoint, sizeof(UA_Guid));
     if(bc.status != UA_STATUSCODE_GOOD) {
         UA_BrowseResult_clear(result);
         result->statusCode = bc.status;
+        goto reattach_cp;
     }
+    memcpy(result->continuationPoint.data, &cp->identifier, sizeof(UA_Guid));
+
+ reattach_cp:
+    /* Attach the cp again as the most recently used */
+    cp->memorySize = ContinuationPoint_memory(cp);
+    UA_LOCK(&server->continuationPointsLock);
+    evictContinuationPoints(server, cp->memorySize);
+    ContinuationPoint_attach(server, session, cp);
+    UA_UNLOCK(&server->continuationPointsLock);
     return;
 
  remove_cp:
     /* Remove the cp */
-    *prev = ContinuationPoint_clear(cp);
+    ContinuationPoint_clear(server, cp);
     UA_free(cp);
+    UA_LOCK(&server->continuationPointsLock);
     ++session->availableContinuationPoints;
+    UA_UNLOCK(&server->continuationPointsLock);
 }
 
 void
@@ -1094,6 +2031,29 @@ Service_BrowseNext(UA_Server *server, UA_Session *session,
                                            &UA_TYPES[UA_TYPES_BROWSERESULT]);
 }
 
+void
+Service_BrowseNextStream(UA_Server *server, UA_Session *session,
+                         UA_ResponseStream *stream,
+                         const UA_BrowseNextRequest *request,
+                         UA_BrowseNextResponse *response) {
+    UA_LOG_DEBUG_SESSION(server->config.logging, session,
+                         "Processing BrowseNextRequest");
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    UA_Boolean releaseContinuationPoints =
+        request->releaseContinuationPoints; /* request is const */
+    UA_StatusCode res =
+        UA_Server_streamServiceOperations(server, session, stream,
+                                          &response->responseHeader,
+                                          (UA_ServiceOperation)Operation_BrowseNext,
+                                          &releaseContinuationPoints,
+                                          &request->continuationPointsSize,
+                                          &UA_TYPES[UA_TYPES_BYTESTRING],
+                                          &UA_TYPES[UA_TYPES_BROWSERESULT]);
+    if(!stream->started)
+        response->responseHeader.serviceResult = res;
+}
+
 UA_BrowseResult
 UA_Server_browseNext(UA_Server *server, UA_Boolean releaseContinuationPoint,
                      const UA_ByteString *continuationPoint) {
@@ -1110,12 +2070,107 @@ UA_Server_browseNext(UA_Server *server, UA_Boolean releaseContinuationPoint,
 /* TranslateBrowsePath */
 /***********************/
 
+/* Cache for the results of complete paths. Invalidated with the Browse cache
+ * (same generation counter). */
+
+static UA_UInt32
+translateCacheHash(const UA_BrowsePath *path, UA_UInt32 nodeClassMask) {
+    UA_UInt32 h = UA_NodeId_hash(&path->startingNode);
+    h = UA_ByteString_hash(h, (const UA_Byte*)&nodeClassMask, sizeof(UA_UInt32));
+    for(size_t i = 0; i < path->relativePath.elementsSize; i++) {
+        const UA_RelativePathElement *elem = &path->relativePath.elements[i];
+        UA_UInt32 params[4] = {UA_NodeId_hash(&elem->referenceTypeId),
+                               (UA_UInt32)elem->isInverse,
+                               (UA_UInt32)elem->includeSubtypes,
+                               UA_QualifiedName_hash(&elem->targetName)};
+        h = UA_ByteString_hash(h, (const UA_Byte*)params, sizeof(params));
+    }
+    return h;
+}
+
+static void
+UA_TranslateCacheEntry_clear(UA_TranslateCacheEntry *e) {
+    UA_BrowsePath_clear(&e->path);
+    UA_BrowsePathResult_clear(&e->result);
+    memset(e, 0, sizeof(UA_TranslateCacheEntry));
+}
+
+static void
+UA_TranslateCache_clear(UA_Server *server) {
+    for(size_t i = 0; i < server->translateCacheSize; i++)
+        UA_TranslateCacheEntry_clear(&server->translateCache[i]);
+    UA_free(server->translateCache);
+    server->translateCache = NULL;
+    server->translateCacheSize = 0;
+}
+
+static UA_Boolean
+translateCacheLookup(UA_Server *server, const UA_BrowsePath *path,
+                     UA_UInt32 nodeClassMask, UA_BrowsePathResult *result) {
+    UA_Boolean found = false;
+    UA_UInt32 hash = translateCacheHash(path, nodeClassMask);
+    const UA_TranslateCacheEntry *e;
+    UA_LOCK(&server->viewCacheLock);
+    if(server->translateCacheSize == 0)
+        goto out;
+    e = &server->translateCache[hash % server->translateCacheSize];
+    if(!e->used || e->generation != server->browseCacheGeneration ||
+       e->hash != hash || e->nodeClassMask != nodeClassMask ||
+       UA_order(&e->path, path, &UA_TYPES[UA_TYPES_BROWSEPATH]) != UA_ORDER_EQ)
+        goto out;
+    found = (UA_BrowsePathResult_copy(&e->result, result) == UA_STATUSCODE_GOOD);
+ out:
+    UA_UNLOCK(&server->viewCacheLock);
+    return found;
+}
+
+static void
+translateCacheStore(UA_Server *server, const UA_BrowsePath *path,
+                    UA_UInt32 nodeClassMask, UA_UInt32 generation,
+                    const UA_BrowsePathResult *result) {
+    UA_UInt32 hash = translateCacheHash(path, nodeClassMask);
+    UA_TranslateCacheEntry *e;
+    UA_StatusCode res;
+    UA_UInt32 size = server->config.translateBrowsePathCacheSize;
+    UA_LOCK(&server->viewCacheLock);
+
+    /* (Re)allocate the cache if the configuration changed */
+    if(server->translateCacheSize != size) {
+        UA_TranslateCache_clear(server);
+        if(size == 0)
+            goto out;
+        server->translateCache = (UA_TranslateCacheEntry*)
+            UA_calloc(size, sizeof(UA_TranslateCacheEntry));
+        if(!server->translateCache)
+            goto out;
+        server->translateCacheSize = size;
+    }
+
+    /* Replace the entry in the slot */
+    e = &server->translateCache[hash % size];
+    UA_TranslateCacheEntry_clear(e);
+    res = UA_BrowsePath_copy(path, &e->path);
+    res |= UA_BrowsePathResult_copy(result, &e->result);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_TranslateCacheEntry_clear(e);
+        goto out;
+    }
+    e->generation = generation;
+    e->hash = hash;
+    e->nodeClassMask = nodeClassMask;
+    e->used = true;
+
+ out:
+    UA_UNLOCK(&server->viewCacheLock);
+}
+
 /* Add all entries for the hash. There are possible duplicates due to hash
  * collisions. The full browsename is checked afterwards. */
 static void *
 addBrowseHashTarget(void *context, UA_ReferenceTargetTreeElem *elem) {
     RefTree *next = (RefTree*)context;
-    return (void*)(uintptr_t)RefTree_add(next, elem->target.targetId, NULL);
+    return (void*)(uintptr_t)
+        RefTree_addHashed(next, elem->target.targetId, elem->targetIdHash, NULL);
 }
 
 static UA_StatusCode
@@ -1158,6 +2213,10 @@ walkBrowsePathElement(UA_Server *server, UA_Session *session,
             continue;
         }
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+        UA_PubSubManager_materializeNode(server, &current->targets[i].nodeId);
+#endif
+
         /* Local Node. Add to the tree of results at the next depth. Get only
          * the NodeClass + BrowseName attribute and the selected ReferenceTypes
          * if the nodestore supports that. */
@@ -1251,6 +2310,17 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
         }
     }
 
+#ifdef UA_ENABLE_PUBSUB_INFORMATIONMODEL
+    /* Add the nodes of the lazy PubSub information model */
+    UA_PubSubManager_materializeNode(server, &path->startingNode);
+#endif
+
+    /* Take the result from the cache */
+    if(server->config.translateBrowsePathCacheSize > 0 &&
+       translateCacheLookup(server, path, *nodeClassMask, result))
+        return;
+    UA_UInt32 generation = server->browseCacheGeneration;
+
     /* Check if the starting node exists */
     const UA_Node *startingNode =
         UA_NODESTORE_GET_SELECTIVE(server, &path->startingNode,
@@ -1290,10 +2360,7 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
         next = tmp;
 
         /* Clear up current, keep the capacity */
-        for(size_t j = 0; j < next->size; j++)
-            UA_ExpandedNodeId_clear(&next->targets[j]);
-        next->size = 0;
-        ZIP_INIT(&next->head);
+        RefTree_reset(next);
 
         /* Do this check after next->size has been set to zero */
         if(current->size == 0)
@@ -1358,6 +2425,12 @@ Operation_TranslateBrowsePathToNodeIds(UA_Server *server, UA_Session *session,
         result->targets = NULL;
         result->targetsSize = 0;
     }
+
+    /* Cache the result if the path was walked to the end */
+    if(server->config.translateBrowsePathCacheSize > 0 &&
+       (result->statusCode == UA_STATUSCODE_GOOD ||
+        result->statusCode == UA_STATUSCODE_BADNOMATCH))
+        translateCacheStore(server, path, *nodeClassMask, generation, result);
 }
 
 UA_BrowsePathResult
@@ -1461,7 +2534,6 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
                          "Processing RegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    //TODO: hang the nodeids to the session if really needed
     if(request->nodesToRegisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
         return;
@@ -1474,11 +2546,25 @@ void Service_RegisterNodes(UA_Server *server, UA_Session *session,
         return;
     }
 
-    response->responseHeader.serviceResult =
-        UA_Array_copy(request->nodesToRegister, request->nodesToRegisterSize,
-                      (void**)&response->registeredNodeIds, &UA_TYPES[UA_TYPES_NODEID]);
-    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD)
-        response->registeredNodeIdsSize = request->nodesToRegisterSize;
+    response->registeredNodeIds = (UA_NodeId*)
+        UA_Array_new(request->nodesToRegisterSize, &UA_TYPES[UA_TYPES_NODEID]);
+    if(!response->registeredNodeIds) {
+        response->responseHeader.serviceResult = UA_STATUSCODE_BADOUTOFMEMORY;
+        return;
+    }
+    response->registeredNodeIdsSize = request->nodesToRegisterSize;
+
+    /* Registered nodes get an alias NodeId with a fast path in Read and Write.
+     * Beyond the limit, the NodeIds are returned unchanged. */
+    for(size_t i = 0; i < request->nodesToRegisterSize; i++) {
+        UA_StatusCode res =
+            UA_Session_registerNode(server, session, &request->nodesToRegister[i],
+                                    &response->registeredNodeIds[i]);
+        if(res != UA_STATUSCODE_GOOD) {
+            response->responseHeader.serviceResult = res;
+            return;
+        }
+    }
 }
 
 void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
@@ -1488,9 +2574,10 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
                          "Processing UnRegisterNodesRequest");
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    //TODO: remove the nodeids from the session if really needed
-    if(request->nodesToUnregisterSize == 0)
+    if(request->nodesToUnregisterSize == 0) {
         response->responseHeader.serviceResult = UA_STATUSCODE_BADNOTHINGTODO;
+        return;
+    }
 
     /* Test the number of operations in the request */
     if(server->config.maxNodesPerRegisterNodes != 0 &&
@@ -1498,4 +2585,8 @@ void Service_UnregisterNodes(UA_Server *server, UA_Session *session,
         response->responseHeader.serviceResult = UA_STATUSCODE_BADTOOMANYOPERATIONS;
         return;
     }
+
+    /* NodeIds that are not an alias are ignored */
+    for(size_t i = 0; i < request->nodesToUnregisterSize; i++)
+        UA_Session_unregisterNode(server, session, &request->nodesToUnregister[i]);
 }
@@ -16,9 +16,20 @@
 
 #define UA_SESSION_NONCELENTH 32
 
+static enum ZIP_CMP
+cmpAccessCacheEntry(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_AccessCache, UA_AccessCacheEntry, zipEntry,
+              UA_NodeId, nodeId, cmpAccessCacheEntry)
+
 void UA_Session_init(UA_Session *session) {
     memset(session, 0, sizeof(UA_Session));
     session->availableContinuationPoints = UA_MAXCONTINUATIONPOINTS;
+#ifdef UA_ENABLE_QUERY
+    session->availableQueryContinuationPoints = UA_MAXCONTINUATIONPOINTS;
+#endif
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     SIMPLEQ_INIT(&session->responseQueue);
     TAILQ_INIT(&session->subscriptions);
@@ -48,17 +59,31 @@ void UA_Session_clear(UA_Session *session, UA_Server* server) {
     UA_NodeId_clear(&session->sessionId);
     UA_String_clear(&session->sessionName);
     UA_ByteString_clear(&session->serverNonce);
+    UA_LOCK(&server->continuationPointsLock);
     struct ContinuationPoint *cp, *next = session->continuationPoints;
     while((cp = next)) {
-        next = ContinuationPoint_clear(cp);
+        next = ContinuationPoint_clear(server, cp);
         UA_free(cp);
     }
     session->continuationPoints = NULL;
     session->availableContinuationPoints = UA_MAXCONTINUATIONPOINTS;
+    UA_UNLOCK(&server->continuationPointsLock);
+#ifdef UA_ENABLE_QUERY
+    QueryContinuationPoint *qcp, *qnext = session->queryContinuationPoints;
+    while((qcp = qnext)) {
+        qnext = QueryContinuationPoint_clear(qcp);
+        UA_free(qcp);
+    }
+    session->queryContinuationPoints = NULL;
+    session->availableQueryContinuationPoints = UA_MAXCONTINUATIONPOINTS;
+#endif
 
     UA_KeyValueMap_delete(session->attributes);
     session->attributes = NULL;
 
+    UA_Session_invalidateAccessCache(session, NULL);
+    UA_Session_clearRegisteredNodes(server, session);
+
     UA_Array_delete(session->localeIds, session->localeIdsSize,
                     &UA_TYPES[UA_TYPES_STRING]);
     session->localeIds = NULL;
@@ -114,7 +139,7 @@ UA_Session_detachFromSecureChannel(UA_Session *session) {
 }
 
 UA_StatusCode
-UA_Session_generateNonce(UA_Session *session) {
+UA_Session_generateNonce(UA_Server *server, UA_Session *session) {
     UA_SecureChannel *channel = session->channel;
     if(!channel || !channel->securityPolicy)
         return UA_STATUSCODE_BADINTERNALERROR;
@@ -128,8 +153,8 @@ UA_Session_generateNonce(UA_Session *session) {
             return retval;
     }
 
-    return channel->securityPolicy->symmetricModule.
-        generateNonce(channel->securityPolicy->policyContext, &session->serverNonce);
+    return getRandomBytes(server, session->serverNonce.data,
+                          session->serverNonce.length);
 }
 
 void
@@ -142,8 +167,155 @@ UA_Session_updateLifetime(UA_Session *session, UA_DateTime now,
 #endif
 }
 
+UA_AccessCacheEntry *
+UA_Session_getAccessCacheEntry(UA_Session *session, const UA_NodeId *nodeId) {
+    return ZIP_FIND(UA_AccessCache, &session->accessCache, nodeId);
+}
+
+UA_AccessCacheEntry *
+UA_Session_addAccessCacheEntry(UA_Session *session, const UA_NodeId *nodeId) {
+    UA_AccessCacheEntry *entry =
+        ZIP_FIND(UA_AccessCache, &session->accessCache, nodeId);
+    if(entry)
+        return entry;
+
+    /* Start over instead of tracking the least recently used entries */
+    if(session->accessCacheSize >= UA_ACCESSCACHE_MAXENTRIES)
+        UA_Session_invalidateAccessCache(session, NULL);
+
+    entry = (UA_AccessCacheEntry*)UA_calloc(1, sizeof(UA_AccessCacheEntry));
+    if(!entry)
+        return NULL;
+    if(UA_NodeId_copy(nodeId, &entry->nodeId) != UA_STATUSCODE_GOOD) {
+        UA_free(entry);
+        return NULL;
+    }
+    ZIP_INSERT(UA_AccessCache, &session->accessCache, entry);
+    session->accessCacheSize++;
+    return entry;
+}
+
+static void *
+deleteAccessCacheEntry(void *context, UA_AccessCacheEntry *entry) {
+    UA_NodeId_clear(&entry->nodeId);
+    UA_free(entry);
+    return NULL;
+}
+
+void
+UA_Session_invalidateAccessCache(UA_Session *session, const UA_NodeId *nodeId) {
+    session->accessCacheGeneration++;
+    if(!nodeId) {
+        ZIP_ITER(UA_AccessCache, &session->accessCache,
+                 deleteAccessCacheEntry, NULL);
+        ZIP_INIT(&session->accessCache);
+        session->accessCacheSize = 0;
+        return;
+    }
+
+    UA_AccessCacheEntry *entry =
+        ZIP_FIND(UA_AccessCache, &session->accessCache, nodeId);
+    if(!entry)
+        return;
+    ZIP_REMOVE(UA_AccessCache, &session->accessCache, entry);
+    session->accessCacheSize--;
+    deleteAccessCacheEntry(NULL, entry);
+}
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *outAlias) {
+    /* Return the NodeId unchanged if no more nodes can be registered or if the
+     * node does not exist */
+    if(session->registeredNodesCount >= server->config.maxRegisteredNodesPerSession ||
+       UA_NodeId_isNull(nodeId))
+        return UA_NodeId_copy(nodeId, outAlias);
+    const UA_Node *node = UA_NODESTORE_GET(server, nodeId);
+    if(!node)
+        return UA_NodeId_copy(nodeId, outAlias);
+
+    UA_NodeId id;
+    UA_StatusCode res = UA_NodeId_copy(nodeId, &id);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_NODESTORE_RELEASE(server, node);
+        return res;
+    }
+
+    /* Take a free slot or extend the array */
+    UA_UInt32 index;
+    UA_RegisteredNode *rn;
+    if(session->registeredNodesFree > 0) {
+        index = session->registeredNodesFree;
+        rn = &session->registeredNodes[index - 1];
+        session->registeredNodesFree = rn->nextFree;
+    } else {
+        rn = (UA_RegisteredNode*)
+            UA_realloc(session->registeredNodes, sizeof(UA_RegisteredNode) *
+                       (session->registeredNodesSize + 1));
+        if(!rn) {
+            UA_NodeId_clear(&id);
+            UA_NODESTORE_RELEASE(server, node);
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        }
+        session->registeredNodes = rn;
+        rn = &rn[session->registeredNodesSize];
+        session->registeredNodesSize++;
+        index = (UA_UInt32)session->registeredNodesSize;
+    }
+
+    rn->nodeId = id;
+    rn->node = node;
+    rn->generation = server->nodestoreGeneration;
+    rn->nextFree = 0;
+    session->registeredNodesCount++;
+    *outAlias = UA_NODEID_NUMERIC(UA_REGISTEREDNODES_NSINDEX, index);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *alias) {
+    UA_RegisteredNode *rn = UA_Session_getRegisteredNode(session, alias);
+    if(!rn)
+        return;
+    if(rn->node)
+        UA_NODESTORE_RELEASE(server, rn->node);
+    UA_NodeId_clear(&rn->nodeId);
+    rn->node = NULL;
+    rn->nextFree = session->registeredNodesFree;
+    session->registeredNodesFree = alias->identifier.numeric;
+    session->registeredNodesCount--;
+}
+
+const UA_Node *
+UA_Session_resolveRegisteredNode(UA_Server *server, UA_RegisteredNode *rn) {
+    if(rn->node && rn->generation == server->nodestoreGeneration)
+        return rn->node;
+    const UA_Node *node = UA_NODESTORE_GET(server, &rn->nodeId);
+    if(rn->node)
+        UA_NODESTORE_RELEASE(server, rn->node);
+    rn->node = node;
+    rn->generation = server->nodestoreGeneration;
+    return node;
+}
+
+void
+UA_Session_clearRegisteredNodes(UA_Server *server, UA_Session *session) {
+    for(size_t i = 0; i < session->registeredNodesSize; i++) {
+        UA_RegisteredNode *rn = &session->registeredNodes[i];
+        if(rn->node)
+            UA_NODESTORE_RELEASE(server, rn->node);
+        UA_NodeId_clear(&rn->nodeId);
+    }
+    UA_free(session->registeredNodes);
+    session->registeredNodes = NULL;
+    session->registeredNodesSize = 0;
+    session->registeredNodesCount = 0;
+    session->registeredNodesFree = 0;
+}
+
 void
 UA_Session_attachSubscription(UA_Session *session, UA_Subscription *sub) {
     /* Attach to the session */
@@ -261,14 +433,68 @@ UA_Server_closeSession(UA_Server *server, const UA_NodeId *sessionId) {
     return res;
 }
 
+UA_AccessCacheEntry *
+getCachedAccess(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+                UA_Byte decision, UA_UInt32 *generation) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(!session || !server->config.accessControl.cacheDecisions)
+        return NULL;
+    *generation = session->accessCacheGeneration;
+    UA_AccessCacheEntry *entry = UA_Session_getAccessCacheEntry(session, nodeId);
+    return (entry && (entry->cached & decision)) ? entry : NULL;
+}
+
+UA_AccessCacheEntry *
+cacheAccess(UA_Server *server, UA_Session *session, const UA_NodeId *nodeId,
+            UA_Byte decision, UA_UInt32 generation) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(!session || !server->config.accessControl.cacheDecisions)
+        return NULL;
+    /* The cache was invalidated while the decision was made */
+    if(generation != session->accessCacheGeneration)
+        return NULL;
+    UA_AccessCacheEntry *entry = UA_Session_addAccessCacheEntry(session, nodeId);
+    if(entry)
+        entry->cached |= decision;
+    return entry;
+}
+
+void
+invalidateAccessCache(UA_Server *server, const UA_NodeId *sessionId,
+                      const UA_NodeId *nodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(sessionId) {
+        UA_Session *session = getSessionById(server, sessionId);
+        if(session)
+            UA_Session_invalidateAccessCache(session, nodeId);
+        return;
+    }
+    session_list_entry *entry;
+    LIST_FOREACH(entry, &server->sessions, pointers) {
+        UA_Session_invalidateAccessCache(&entry->session, nodeId);
+    }
+}
+
+void
+UA_Server_invalidateAccessCache(UA_Server *server, const UA_NodeId *sessionId,
+                                const UA_NodeId *nodeId) {
+    UA_LOCK(&server->serviceMutex);
+    invalidateAccessCache(server, sessionId, nodeId);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
 /* Session Attributes */
 
-#define UA_PROTECTEDATTRIBUTESSIZE 4
+#define UA_PROTECTEDATTRIBUTESSIZE 8
 static const UA_QualifiedName protectedAttributes[UA_PROTECTEDATTRIBUTESSIZE] = {
     {0, UA_STRING_STATIC("localeIds")},
     {0, UA_STRING_STATIC("clientDescription")},
     {0, UA_STRING_STATIC("sessionName")},
-    {0, UA_STRING_STATIC("clientUserId")}
+    {0, UA_STRING_STATIC("clientUserId")},
+    {0, UA_STRING_STATIC("serviceCpuTime")},
+    {0, UA_STRING_STATIC("bytesDecoded")},
+    {0, UA_STRING_STATIC("bytesEncoded")},
+    {0, UA_STRING_STATIC("notifications")}
 };
 
 static UA_Boolean
@@ -346,6 +572,23 @@ getSessionAttribute(UA_Server *server, const UA_NodeId *sessionId,
         UA_Variant_setScalar(&localAttr, &session->clientUserIdOfSession,
                              &UA_TYPES[UA_TYPES_STRING]);
         attr = &localAttr;
+    } else if(UA_QualifiedName_equal(&key, &protectedAttributes[4])) {
+        /* Return the resource usage */
+        UA_Variant_setScalar(&localAttr, &session->usage.serviceCpuTime,
+                             &UA_TYPES[UA_TYPES_UINT64]);
+        attr = &localAttr;
+    } else if(UA_QualifiedName_equal(&key, &protectedAttributes[5])) {
+        UA_Variant_setScalar(&localAttr, &session->usage.bytesDecoded,
+                             &UA_TYPES[UA_TYPES_UINT64]);
+        attr = &localAttr;
+    } else if(UA_QualifiedName_equal(&key, &protectedAttributes[6])) {
+        UA_Variant_setScalar(&localAttr, &session->usage.bytesEncoded,
+                             &UA_TYPES[UA_TYPES_UINT64]);
+        attr = &localAttr;
+    } else if(UA_QualifiedName_equal(&key, &protectedAttributes[7])) {
+        UA_Variant_setScalar(&localAttr, &session->usage.notifications,
+                             &UA_TYPES[UA_TYPES_UINT64]);
+        attr = &localAttr;
     } else {
         /* Get from the actual key-value list */
         attr = UA_KeyValueMap_get(session->attributes, key);
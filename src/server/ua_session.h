@@ -10,8 +10,10 @@
 #define UA_SESSION_H_
 
 #include <open62541/util.h>
+#include <open62541/plugin/nodestore.h>
 
 #include "ua_securechannel.h"
+#include "ziptree.h"
 
 _UA_BEGIN_DECLS
 
@@ -20,13 +22,59 @@ _UA_BEGIN_DECLS
 struct ContinuationPoint;
 typedef struct ContinuationPoint ContinuationPoint;
 
-/* Returns the next entry in the linked list */
+/* Returns the next entry in the linked list. Also removes the
+ * ContinuationPoint from the server-wide list. */
 ContinuationPoint *
-ContinuationPoint_clear(ContinuationPoint *cp);
+ContinuationPoint_clear(UA_Server *server, ContinuationPoint *cp);
+
+#ifdef UA_ENABLE_QUERY
+struct QueryContinuationPoint;
+typedef struct QueryContinuationPoint QueryContinuationPoint;
+
+/* Returns the next entry in the linked list */
+QueryContinuationPoint *
+QueryContinuationPoint_clear(QueryContinuationPoint *cp);
+#endif
 
 struct UA_Subscription;
 typedef struct UA_Subscription UA_Subscription;
 
+/* Cached AccessControl decisions for a node. Only used if enabled in the
+ * AccessControl plugin. The bits in the "cached" field mark the decisions that
+ * are valid. */
+#define UA_ACCESSCACHE_MAXENTRIES 1024
+
+#define UA_ACCESSCACHE_RIGHTSMASK  0x01
+#define UA_ACCESSCACHE_ACCESSLEVEL 0x02
+#define UA_ACCESSCACHE_EXECUTABLE  0x04
+#define UA_ACCESSCACHE_BROWSE      0x08
+
+typedef struct UA_AccessCacheEntry {
+    ZIP_ENTRY(UA_AccessCacheEntry) zipEntry;
+    UA_NodeId nodeId;
+    UA_UInt32 rightsMask;
+    UA_Byte accessLevel;
+    UA_Boolean executable;
+    UA_Boolean browse;
+    UA_Byte cached;
+} UA_AccessCacheEntry;
+
+typedef ZIP_HEAD(UA_AccessCache, UA_AccessCacheEntry) UA_AccessCache;
+
+/* Nodes registered with RegisterNodes get a numeric alias NodeId in this
+ * namespace. The identifier is the index in the array of registered nodes plus
+ * one. The Session holds a reference to the node from the Nodestore. It is
+ * used as long as the Nodestore generation is unchanged (no node was removed
+ * or replaced in the meantime). */
+#define UA_REGISTEREDNODES_NSINDEX UA_UINT16_MAX
+
+typedef struct {
+    UA_NodeId nodeId;     /* Null for a free slot */
+    const UA_Node *node;  /* Held reference or NULL */
+    UA_UInt32 generation; /* Nodestore generation of the reference */
+    UA_UInt32 nextFree;   /* Index plus one of the next free slot */
+} UA_RegisteredNode;
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
 typedef struct UA_PublishResponseEntry {
     SIMPLEQ_ENTRY(UA_PublishResponseEntry) listEntry;
@@ -36,6 +84,16 @@ typedef struct UA_PublishResponseEntry {
 } UA_PublishResponseEntry;
 #endif
 
+/* Resource usage of a Session. Read-only services are processed concurrently
+ * under the shared side of the service lock. So the counters are updated with
+ * atomic operations. */
+typedef struct {
+    UA_UInt64 serviceCpuTime; /* In 100ns ticks. Only with config->sessionCpuTime */
+    UA_UInt64 bytesDecoded;   /* Service requests */
+    UA_UInt64 bytesEncoded;   /* Service and Publish responses */
+    UA_UInt64 notifications;  /* Notifications generated by MonitoredItems */
+} UA_SessionUsage;
+
 struct UA_Session {
     UA_Session *next; /* singly-linked list */
     UA_SecureChannel *channel; /* The pointer back to the SecureChannel in the session. */
@@ -64,10 +122,36 @@ struct UA_Session {
     UA_UInt16         availableContinuationPoints;
     ContinuationPoint *continuationPoints;
 
+#ifdef UA_ENABLE_QUERY
+    UA_UInt16 availableQueryContinuationPoints;
+    QueryContinuationPoint *queryContinuationPoints;
+#endif
+
     /* Localization information */
     size_t localeIdsSize;
     UA_String *localeIds;
 
+    /* AccessControl decisions per node. The generation is increased with
+     * every invalidation. */
+    UA_AccessCache accessCache;
+    size_t accessCacheSize;
+    UA_UInt32 accessCacheGeneration;
+
+    /* Registered nodes. Only accessed while processing the requests of the
+     * Session. These are processed one after the other. */
+    UA_RegisteredNode *registeredNodes;
+    size_t registeredNodesSize; /* Including the free slots */
+    size_t registeredNodesCount;
+    UA_UInt32 registeredNodesFree; /* Index plus one of the first free slot */
+
+    UA_SessionUsage usage;
+
+#if UA_MULTITHREADING >= 100
+    /* Set while a Read request of the Session is processed. DataSource reads
+     * into the response can complete asynchronously. */
+    struct UA_AsyncReadContext *asyncRead;
+#endif
+
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     /* The queue is ordered according to the priority byte (higher bytes come
      * first). When a late subscription finally publishes, then it is pushed to
@@ -96,12 +180,69 @@ void UA_Session_init(UA_Session *session);
 void UA_Session_clear(UA_Session *session, UA_Server *server);
 void UA_Session_attachToSecureChannel(UA_Session *session, UA_SecureChannel *channel);
 void UA_Session_detachFromSecureChannel(UA_Session *session);
-UA_StatusCode UA_Session_generateNonce(UA_Session *session);
+UA_StatusCode
+UA_Session_generateNonce(UA_Server *server, UA_Session *session);
 
 /* If any activity on a session happens, the timeout is extended */
 void UA_Session_updateLifetime(UA_Session *session, UA_DateTime now,
                                UA_DateTime nowMonotonic);
 
+/**
+ * AccessControl Cache
+ * ------------------- */
+
+/* Returns NULL if no decision is cached for the node */
+UA_AccessCacheEntry *
+UA_Session_getAccessCacheEntry(UA_Session *session, const UA_NodeId *nodeId);
+
+/* Returns the existing or a new entry. The cache is flushed when the maximum
+ * number of entries is reached. Returns NULL if out of memory. */
+UA_AccessCacheEntry *
+UA_Session_addAccessCacheEntry(UA_Session *session, const UA_NodeId *nodeId);
+
+/* Removes the cached decisions for the node. All entries are removed if nodeId
+ * is NULL. */
+void
+UA_Session_invalidateAccessCache(UA_Session *session, const UA_NodeId *nodeId);
+
+/**
+ * Registered Nodes
+ * ---------------- */
+
+/* Returns the alias NodeId in the output. Or a copy of the NodeId if the
+ * maximum number of registered nodes is reached or the node does not exist. */
+UA_StatusCode
+UA_Session_registerNode(UA_Server *server, UA_Session *session,
+                        const UA_NodeId *nodeId, UA_NodeId *outAlias);
+
+void
+UA_Session_unregisterNode(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *alias);
+
+/* Returns the registered entry for an alias NodeId. Or NULL for all other
+ * NodeIds. */
+static UA_INLINE UA_RegisteredNode *
+UA_Session_getRegisteredNode(UA_Session *session, const UA_NodeId *alias) {
+    if(alias->namespaceIndex != UA_REGISTEREDNODES_NSINDEX ||
+       alias->identifierType != UA_NODEIDTYPE_NUMERIC ||
+       alias->identifier.numeric == 0 ||
+       alias->identifier.numeric > session->registeredNodesSize)
+        return NULL;
+    UA_RegisteredNode *rn = &session->registeredNodes[alias->identifier.numeric - 1];
+    return (UA_NodeId_isNull(&rn->nodeId)) ? NULL : rn;
+}
+
+/* Returns the node of the registered entry. The reference is renewed if the
+ * Nodestore generation has changed. Returns NULL if the node was removed in the
+ * meantime. The reference remains with the Session and must not be
+ * released. */
+const UA_Node *
+UA_Session_resolveRegisteredNode(UA_Server *server, UA_RegisteredNode *rn);
+
+/* Releases the references to the registered nodes */
+void
+UA_Session_clearRegisteredNodes(UA_Server *server, UA_Session *session);
+
 /**
  * Subscription handling
  * --------------------- */
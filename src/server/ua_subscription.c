@@ -25,10 +25,18 @@
 
 #define UA_MAX_RETRANSMISSIONQUEUESIZE 256
 
+static void
+deleteRetransmissionMessage(UA_NotificationMessageEntry *nme) {
+    UA_NotificationMessage_clear(&nme->message);
+    UA_SharedSampleRefs_clear(&nme->sharedRefs);
+    UA_free(nme);
+}
+
 UA_Subscription *
-UA_Subscription_new(void) {
+UA_Subscription_new(UA_Server *server) {
     /* Allocate the memory */
-    UA_Subscription *newSub = (UA_Subscription*)UA_calloc(1, sizeof(UA_Subscription));
+    UA_Subscription *newSub = (UA_Subscription*)
+        UA_POOL_ALLOC(&server->pools.subscriptions, sizeof(UA_Subscription));
     if(!newSub)
         return NULL;
 
@@ -41,12 +49,21 @@ UA_Subscription_new(void) {
 
     TAILQ_INIT(&newSub->retransmissionQueue);
     TAILQ_INIT(&newSub->notificationQueue);
+    ZIP_INIT(&newSub->monitoredItemsById);
     return newSub;
 }
 
+/* The application pointer is the list of the MonitoredItems deleted together
+ * with the Subscription. Chained via their (unused) DelayedCallback, which is
+ * the first member of the MonitoredItem. */
 static void
 delayedFreeSubscription(void *app, void *context) {
-    UA_free(context);
+    UA_DelayedCallback *dc = (UA_DelayedCallback*)app, *next;
+    for(; dc; dc = next) {
+        next = dc->next;
+        UA_POOL_FREE(dc);
+    }
+    UA_POOL_FREE(context);
 }
 
 void
@@ -85,11 +102,15 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
         server->serverDiagnosticsSummary.currentSubscriptionCount--;
     }
 
-    /* Delete monitored Items */
+    /* Delete monitored Items. Instead of one delayed callback per
+     * MonitoredItem, their memory is freed together with the Subscription. */
     UA_assert(server->monitoredItemsSize >= sub->monitoredItemsSize);
     UA_MonitoredItem *mon, *tmp_mon;
+    UA_DelayedCallback *deletedMons = NULL;
     LIST_FOREACH_SAFE(mon, &sub->monitoredItems, listEntry, tmp_mon) {
-        UA_MonitoredItem_delete(server, mon);
+        UA_MonitoredItem_clear(server, mon);
+        mon->delayedFreePointers.next = deletedMons;
+        deletedMons = &mon->delayedFreePointers;
     }
     UA_assert(sub->monitoredItemsSize == 0);
 
@@ -97,8 +118,7 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
     UA_NotificationMessageEntry *nme, *nme_tmp;
     TAILQ_FOREACH_SAFE(nme, &sub->retransmissionQueue, listEntry, nme_tmp) {
         TAILQ_REMOVE(&sub->retransmissionQueue, nme, listEntry);
-        UA_NotificationMessage_clear(&nme->message);
-        UA_free(nme);
+        deleteRetransmissionMessage(nme);
         if(sub->session)
             --sub->session->totalRetransmissionQueueSize;
         --sub->retransmissionQueueSize;
@@ -109,7 +129,7 @@ UA_Subscription_delete(UA_Server *server, UA_Subscription *sub) {
      * Add a delayed callback to remove the Subscription when the current jobs
      * have completed. */
     sub->delayedFreePointers.callback = delayedFreeSubscription;
-    sub->delayedFreePointers.application = NULL;
+    sub->delayedFreePointers.application = deletedMons;
     sub->delayedFreePointers.context = sub;
     el->addDelayedCallback(el, &sub->delayedFreePointers);
 }
@@ -119,14 +139,17 @@ Subscription_resetLifetime(UA_Subscription *sub) {
     sub->currentLifetimeCount = 0;
 }
 
+enum ZIP_CMP
+cmpMonitoredItemId(const UA_UInt32 *a, const UA_UInt32 *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
 UA_MonitoredItem *
 UA_Subscription_getMonitoredItem(UA_Subscription *sub, UA_UInt32 monitoredItemId) {
-    UA_MonitoredItem *mon;
-    LIST_FOREACH(mon, &sub->monitoredItems, listEntry) {
-        if(mon->monitoredItemId == monitoredItemId)
-            break;
-    }
-    return mon;
+    return ZIP_FIND(UA_MonitoredItemIdTree, &sub->monitoredItemsById,
+                    &monitoredItemId);
 }
 
 static void
@@ -134,8 +157,7 @@ removeOldestRetransmissionMessageFromSub(UA_Subscription *sub) {
     UA_NotificationMessageEntry *oldestEntry =
         TAILQ_LAST(&sub->retransmissionQueue, NotificationMessageQueue);
     TAILQ_REMOVE(&sub->retransmissionQueue, oldestEntry, listEntry);
-    UA_NotificationMessage_clear(&oldestEntry->message);
-    UA_free(oldestEntry);
+    deleteRetransmissionMessage(oldestEntry);
     --sub->retransmissionQueueSize;
     if(sub->session)
         --sub->session->totalRetransmissionQueueSize;
@@ -204,8 +226,7 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
     /* Remove the retransmission message */
     TAILQ_REMOVE(&sub->retransmissionQueue, entry, listEntry);
     --sub->retransmissionQueueSize;
-    UA_NotificationMessage_clear(&entry->message);
-    UA_free(entry);
+    deleteRetransmissionMessage(entry);
 
     if(sub->session)
         --sub->session->totalRetransmissionQueueSize;
@@ -214,9 +235,42 @@ UA_Subscription_removeRetransmissionMessage(UA_Subscription *sub, UA_UInt32 sequ
 }
 
 /* The output counters are only set when the preparation is successful */
+/* Move the reference to a SharedSample into the message. Returns false if
+ * that is not possible. Then the caller takes a copy of the borrowed values.
+ * n->shared is released with the notification. */
+static UA_Boolean
+moveSharedSampleRef(UA_SharedSampleRefs *refs, size_t maxRefs, UA_Notification *n) {
+    if(!refs->samples) {
+        refs->samples = (UA_SharedSample**)
+            UA_malloc(sizeof(UA_SharedSample*) * maxRefs);
+        if(!refs->samples)
+            return false;
+    }
+    UA_assert(refs->samplesSize < maxRefs);
+    refs->samples[refs->samplesSize++] = n->shared;
+    n->shared = NULL;
+    return true;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+/* Replace the borrowed event fields with copies */
+static void
+copyBorrowedEventFields(UA_EventFieldList *efl) {
+    for(size_t i = 0; i < efl->eventFieldsSize; i++) {
+        UA_Variant *field = &efl->eventFields[i];
+        if(field->storageType != UA_VARIANT_DATA_NODELETE)
+            continue;
+        UA_Variant borrowed = *field;
+        if(UA_Variant_copy(&borrowed, field) != UA_STATUSCODE_GOOD)
+            UA_Variant_init(field);
+    }
+}
+#endif
+
 static UA_StatusCode
 prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
                            UA_NotificationMessage *message,
+                           UA_SharedSampleRefs *refs,
                            size_t maxNotifications) {
     UA_assert(maxNotifications > 0);
 
@@ -285,6 +339,13 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
     UA_assert(notificationDataIdx > 0);
     message->notificationDataSize = notificationDataIdx;
 
+    /* Every notification can hold one reference to a SharedSample */
+    size_t maxRefs = (dcn) ? dcn->monitoredItemsSize : 0;
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(enl)
+        maxRefs += enl->eventsSize;
+#endif
+
     /* <-- The point of no return --> */
 
     /* How many notifications were moved to the response overall? */
@@ -302,6 +363,8 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
             UA_assert(enl != NULL); /* Have at least one event notification */
             enl->events[enlPos] = notification->data.event;
             UA_EventFieldList_init(&notification->data.event);
+            if(notification->shared && !moveSharedSampleRef(refs, maxRefs, notification))
+                copyBorrowedEventFields(&enl->events[enlPos]);
             enlPos++;
             break;
 #endif
@@ -309,6 +372,12 @@ prepareNotificationMessage(UA_Server *server, UA_Subscription *sub,
             UA_assert(dcn != NULL); /* Have at least one change notification */
             dcn->monitoredItems[dcnPos] = notification->data.dataChange;
             UA_DataValue_init(&notification->data.dataChange.value);
+            if(notification->shared && !moveSharedSampleRef(refs, maxRefs, notification)) {
+                UA_DataValue *value = &dcn->monitoredItems[dcnPos].value;
+                UA_DataValue borrowed = *value;
+                if(UA_DataValue_copy(&borrowed, value) != UA_STATUSCODE_GOOD)
+                    UA_DataValue_init(value);
+            }
             dcnPos++;
             break;
         }
@@ -379,8 +448,6 @@ sendStatusChangeDelete(UA_Server *server, UA_Subscription *sub,
                               "Sending out a StatusChange "
                               "notification and removing the subscription");
 
-    UA_EventLoop *el = server->config.eventLoop;
-
     /* Populate the response */
     UA_PublishResponse *response = &pre->response;
 
@@ -395,15 +462,15 @@ sendStatusChangeDelete(UA_Server *server, UA_Subscription *sub,
     response->notificationMessage.notificationData = &notificationData;
     response->notificationMessage.notificationDataSize = 1;
     response->subscriptionId = sub->subscriptionId;
-    response->notificationMessage.publishTime = el->dateTime_now(el);
+    response->notificationMessage.publishTime = getCachedTime(server);
     response->notificationMessage.sequenceNumber = sub->nextSequenceNumber;
 
     /* Send the response */
     UA_assert(sub->session); /* Otherwise pre is NULL */
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sending out a publish response");
-    sendResponse(server, sub->session->channel, pre->requestId,
-                 (UA_Response *)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    sendSessionResponse(server, sub->session, pre->requestId,
+                        (UA_Response *)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
 
     /* Clean up */
     response->notificationMessage.notificationData = NULL;
@@ -485,8 +552,8 @@ delayedPublishNotifications(UA_Server *server, UA_Subscription *sub) {
 
 /* Try to publish now. Enqueue a "next publish" as a delayed callback if not
  * done. */
-void
-UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
+static void
+publishSubscription(UA_Server *server, UA_Subscription *sub) {
     UA_EventLoop *el = server->config.eventLoop;
 
     /* Get a response */
@@ -536,6 +603,13 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
         return;
     }
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    /* Add the next chunk of a pending ConditionRefresh. Only if the
+     * notifications can be sent right away. */
+    if(pre && sub->conditionRefreshes > 0)
+        UA_Subscription_continueConditionRefresh(server, sub);
+#endif
+
     /* Dsiabled subscriptions do not send notifications */
     UA_UInt32 notifications = (sub->state == UA_SUBSCRIPTIONSTATE_ENABLED) ?
         sub->notificationQueueSize : 0;
@@ -568,6 +642,21 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
         return;
     }
 
+    /* The previous responses are still in the send queue of the connection.
+     * Keep the notifications in the Subscription until the client has caught
+     * up. There they are aggregated according to the MonitoredItem queue
+     * settings instead of piling up in the network buffers. */
+    UA_SecureChannel *channel = sub->session->channel;
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(notifications > 0 && cm && cm->getSendQueueSize &&
+       cm->getSendQueueSize(cm, channel->connectionId) > 0) {
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
+                                  "The send queue of the connection is not "
+                                  "empty. Delay the publish response.");
+        UA_Session_queuePublishReq(sub->session, pre, true); /* Re-enqueue */
+        return;
+    }
+
     UA_assert(pre);
     UA_assert(sub->session); /* Otherwise pre is NULL */
 
@@ -575,6 +664,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     UA_PublishResponse *response = &pre->response;
     UA_NotificationMessage *message = &response->notificationMessage;
     UA_NotificationMessageEntry *retransmission = NULL;
+    UA_SharedSampleRefs sharedRefs = {0, NULL};
 #ifdef UA_ENABLE_DIAGNOSTICS
     size_t priorDataChangeNotifications = sub->dataChangeNotifications;
     size_t priorEventNotifications = sub->eventNotifications;
@@ -596,7 +686,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
 
         /* Prepare the response */
         UA_StatusCode retval =
-            prepareNotificationMessage(server, sub, message, notifications);
+            prepareNotificationMessage(server, sub, message, &sharedRefs, notifications);
         if(retval != UA_STATUSCODE_GOOD) {
             UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
                                         "Could not prepare the notification message. "
@@ -615,7 +705,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     /* Set up the response */
     response->subscriptionId = sub->subscriptionId;
     response->moreNotifications = (sub->notificationQueueSize > 0);
-    message->publishTime = el->dateTime_now(el);
+    message->publishTime = getCachedTime(server);
 
     /* Set sequence number to message. Started at 1 which is given during
      * creating a new subscription. The 1 is required for initial publish
@@ -630,6 +720,7 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
              * needs to be done here, so that the message itself is included in
              * the available sequence numbers for acknowledgement. */
             retransmission->message = response->notificationMessage;
+            retransmission->sharedRefs = sharedRefs;
             UA_Subscription_addRetransmissionMessage(server, sub, retransmission);
         }
         /* Only if a notification was created, the sequence number must be
@@ -655,8 +746,8 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sending out a publish response with %" PRIu32
                               " notifications", notifications);
-    sendResponse(server, sub->session->channel, pre->requestId,
-                 (UA_Response*)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
+    sendSessionResponse(server, sub->session, pre->requestId,
+                        (UA_Response*)response, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE]);
 
     /* Reset the Subscription state to NORMAL. But only if all notifications
      * have been sent out. Otherwise keep the Subscription in the LATE state. So
@@ -675,6 +766,8 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     if(retransmission) {
         /* NotificationMessage was moved into retransmission queue */
         UA_NotificationMessage_init(&response->notificationMessage);
+    } else {
+        UA_SharedSampleRefs_clear(&sharedRefs);
     }
     response->availableSequenceNumbers = NULL;
     response->availableSequenceNumbersSize = 0;
@@ -709,6 +802,13 @@ UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
     }
 }
 
+void
+UA_Subscription_publish(UA_Server *server, UA_Subscription *sub) {
+    UA_ALLOCPHASE_BEGIN(UA_ALLOCPHASE_PUBLISH);
+    publishSubscription(server, sub);
+    UA_ALLOCPHASE_END();
+}
+
 void
 UA_Subscription_resendData(UA_Server *server, UA_Subscription *sub) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
@@ -736,8 +836,18 @@ UA_Subscription_resendData(UA_Server *server, UA_Subscription *sub) {
         if(mon->queueSize > 0)
             continue;
 
-        /* Create a notification with the last sampled value */
-        UA_MonitoredItem_createDataChangeNotification(server, mon, &mon->lastValue);
+        /* Create a notification with the last sampled value. Sample again if
+         * only the hash of the last value was kept. */
+        if(mon->lastValueHashed) {
+            UA_Session *session = (sub->session) ? sub->session : &server->adminSession;
+            UA_DataValue dv = readWithSession(server, session, &mon->itemToMonitor,
+                                              mon->timestampsToReturn);
+            UA_MonitoredItem_createDataChangeNotification(server, mon, &dv, NULL);
+            UA_DataValue_clear(&dv);
+            continue;
+        }
+        UA_MonitoredItem_createDataChangeNotification(server, mon, &mon->lastValue,
+                                                      mon->lastValueShared);
     }
 }
 
@@ -767,10 +877,7 @@ UA_Session_ensurePublishQueueSpace(UA_Server* server, UA_Session* session) {
 }
 
 static void
-sampleAndPublishCallback(UA_Server *server, UA_Subscription *sub) {
-    UA_LOCK(&server->serviceMutex);
-    UA_assert(sub);
-
+sampleAndPublish(UA_Server *server, UA_Subscription *sub) {
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub,
                               "Sample and Publish Callback");
 
@@ -783,25 +890,112 @@ sampleAndPublishCallback(UA_Server *server, UA_Subscription *sub) {
 
     /* Publish the queued notifications */
     UA_Subscription_publish(server, sub);
+}
+
+/*****************/
+/* Publish Group */
+/*****************/
+
+static enum ZIP_CMP
+cmpPublishingInterval(const UA_Double *a, const UA_Double *b) {
+    if(*a == *b)
+        return ZIP_CMP_EQ;
+    return (*a < *b) ? ZIP_CMP_LESS : ZIP_CMP_MORE;
+}
+
+ZIP_FUNCTIONS(UA_PublishGroupTree, UA_PublishGroup, zipEntry,
+              UA_Double, publishingInterval, cmpPublishingInterval)
+
+static void
+publishGroupCallback(UA_Server *server, UA_PublishGroup *pg) {
+    UA_LOCK(&server->serviceMutex);
+    UA_assert(pg);
+
+    /* The current Subscription can be deleted during the publish */
+    UA_Subscription *sub, *sub_tmp;
+    TAILQ_FOREACH_SAFE(sub, &pg->subscriptions, publishGroupEntry, sub_tmp) {
+        sampleAndPublish(server, sub);
+    }
 
     UA_UNLOCK(&server->serviceMutex);
 }
 
+static UA_StatusCode
+addToPublishGroup(UA_Server *server, UA_Subscription *sub) {
+    UA_PublishGroup *pg =
+        ZIP_FIND(UA_PublishGroupTree, &server->publishGroups, &sub->publishingInterval);
+
+    /* Create a new group with its own repeated callback */
+    if(!pg) {
+        pg = (UA_PublishGroup*)UA_calloc(1, sizeof(UA_PublishGroup));
+        if(!pg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        pg->publishingInterval = sub->publishingInterval;
+        UA_StatusCode res =
+            addRepeatedCallback(server, (UA_ServerCallback)publishGroupCallback,
+                                pg, pg->publishingInterval, &pg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(pg);
+            return res;
+        }
+        TAILQ_INIT(&pg->subscriptions);
+        ZIP_INSERT(UA_PublishGroupTree, &server->publishGroups, pg);
+    }
+
+    TAILQ_INSERT_TAIL(&pg->subscriptions, sub, publishGroupEntry);
+    sub->publishGroup = pg;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+delayedFreePublishGroup(void *app, void *context) {
+    UA_free(context);
+}
+
+static void
+removeFromPublishGroup(UA_Server *server, UA_Subscription *sub) {
+    UA_PublishGroup *pg = sub->publishGroup;
+    TAILQ_REMOVE(&pg->subscriptions, sub, publishGroupEntry);
+    sub->publishGroup = NULL;
+    if(!TAILQ_EMPTY(&pg->subscriptions))
+        return;
+
+    /* Remove the empty group. Freeing is delayed as the group might currently
+     * be publishing. */
+    removeCallback(server, pg->callbackId);
+    ZIP_REMOVE(UA_PublishGroupTree, &server->publishGroups, pg);
+    pg->delayedFree.callback = delayedFreePublishGroup;
+    pg->delayedFree.application = NULL;
+    pg->delayedFree.context = pg;
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &pg->delayedFree);
+}
+
+UA_StatusCode
+Subscription_updatePublishGroup(UA_Server *server, UA_Subscription *sub) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_PublishGroup *pg = sub->publishGroup;
+    if(!pg || pg->publishingInterval == sub->publishingInterval)
+        return UA_STATUSCODE_GOOD;
+    removeFromPublishGroup(server, sub);
+    UA_StatusCode res = addToPublishGroup(server, sub);
+    if(res != UA_STATUSCODE_GOOD)
+        sub->state = UA_SUBSCRIPTIONSTATE_STOPPED;
+    return res;
+}
+
 UA_StatusCode
 Subscription_setState(UA_Server *server, UA_Subscription *sub,
                       UA_SubscriptionState state) {
     if(state <= UA_SUBSCRIPTIONSTATE_REMOVING) {
-        if(sub->publishCallbackId != 0) {
-            removeCallback(server, sub->publishCallbackId);
-            sub->publishCallbackId = 0;
+        if(sub->publishGroup) {
+            removeFromPublishGroup(server, sub);
 #ifdef UA_ENABLE_DIAGNOSTICS
             sub->disableCount++;
 #endif
         }
-    } else if(sub->publishCallbackId == 0) {
-        UA_StatusCode res =
-            addRepeatedCallback(server, (UA_ServerCallback)sampleAndPublishCallback,
-                                sub, sub->publishingInterval, &sub->publishCallbackId);
+    } else if(!sub->publishGroup) {
+        UA_StatusCode res = addToPublishGroup(server, sub);
         if(res != UA_STATUSCODE_GOOD) {
             sub->state = UA_SUBSCRIPTIONSTATE_STOPPED;
             return res;
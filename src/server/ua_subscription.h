@@ -47,10 +47,43 @@ _UA_BEGIN_DECLS
  * notification was not added to the global queue */
 #define UA_SUBSCRIPTION_QUEUE_SENTINEL ((UA_Notification*)0x01)
 
+/* A sampled value that is shared between the MonitoredItems of a
+ * SamplingGroup. The notifications (and the last value) of the MonitoredItems
+ * only borrow the Variant data with UA_VARIANT_DATA_NODELETE and hold a
+ * reference. The value is cleaned up when the last reference is released.
+ * The reference count is only modified with the service mutex held. */
+typedef struct {
+    size_t refCount;
+    UA_DataValue value;
+} UA_SharedSample;
+
+/* Moves the value into a new SharedSample with a reference count of one */
+UA_SharedSample *
+UA_SharedSample_new(UA_DataValue *value);
+
+/* Shallow copy of the value that borrows the Variant data. Adds a reference. */
+void
+UA_SharedSample_borrow(UA_SharedSample *ss, UA_DataValue *dst);
+
+void
+UA_SharedSample_release(UA_SharedSample *ss);
+
+/* References of a NotificationMessage to the SharedSamples of its
+ * DataChange- and EventNotifications */
+typedef struct {
+    size_t samplesSize;
+    UA_SharedSample **samples;
+} UA_SharedSampleRefs;
+
+void
+UA_SharedSampleRefs_clear(UA_SharedSampleRefs *refs);
+
 typedef struct UA_Notification {
     TAILQ_ENTRY(UA_Notification) localEntry;  /* Notification list for the MonitoredItem */
     TAILQ_ENTRY(UA_Notification) globalEntry; /* Notification list for the Subscription */
     UA_MonitoredItem *mon; /* Always set */
+    UA_SharedSample *shared; /* The DataChange value or the event fields borrow
+                              * from the sample */
 
     /* The event field is used if mon->attributeId is the EventNotifier */
     union {
@@ -66,7 +99,12 @@ typedef struct UA_Notification {
 } UA_Notification;
 
 /* Initializes and sets the sentinel pointers */
-UA_Notification * UA_Notification_new(void);
+UA_Notification * UA_Notification_new(UA_Server *server);
+
+/* Takes a Notification from the pool of the MonitoredItem or allocates a new
+ * one. The MonitoredItem of the Notification is set. */
+UA_Notification *
+UA_MonitoredItem_newNotification(UA_Server *server, UA_MonitoredItem *mon);
 
 /* Notifications are always added to the queue of the MonitoredItem. That queue
  * can overflow. If Notifications are reported, they are also added to the
@@ -80,7 +118,9 @@ UA_Notification * UA_Notification_new(void);
 void UA_Notification_enqueueAndTrigger(UA_Server *server,
                                        UA_Notification *n);
 
-/* Dequeue and delete the notification */
+/* Dequeue and delete the notification. The memory is kept in the pool of the
+ * MonitoredItem as long as the queued and pooled Notifications of the
+ * MonitoredItem do not exceed the queue size. */
 void UA_Notification_delete(UA_Notification *n);
 
 /* A NotificationMessage contains an array of notifications.
@@ -88,6 +128,7 @@ void UA_Notification_delete(UA_Notification *n);
 typedef struct UA_NotificationMessageEntry {
     TAILQ_ENTRY(UA_NotificationMessageEntry) listEntry;
     UA_NotificationMessage message;
+    UA_SharedSampleRefs sharedRefs;
 } UA_NotificationMessageEntry;
 
 /* Queue Definitions */
@@ -110,12 +151,70 @@ typedef enum {
     UA_MONITOREDITEMSAMPLINGTYPE_EVENT,  /* Attached to the node. Can be a "write
                                           * event" for DataChange MonitoredItems
                                           * with a zero sampling interval .*/
-    UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH /* Attached to the subscription */
+    UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH, /* Attached to the subscription */
+    UA_MONITOREDITEMSAMPLINGTYPE_GROUP   /* Cyclic callback of a SamplingGroup */
 } UA_MonitoredItemSamplingType;
 
+/* Cyclic MonitoredItems on the Value attribute that sample the same node (with
+ * the same IndexRange and DataEncoding) at the same interval and with the same
+ * TimestampsToReturn share a SamplingGroup. The value is read once per
+ * interval (with the admin session) and then processed by every MonitoredItem
+ * of the group. The read access is still checked for the session of each
+ * MonitoredItem. */
+typedef struct {
+    UA_ReadValueId itemToMonitor;
+    UA_Double samplingInterval;
+    UA_TimestampsToReturn timestampsToReturn;
+} UA_SamplingGroupKey;
+
+typedef struct UA_SamplingGroup {
+    ZIP_ENTRY(UA_SamplingGroup) zipEntry;
+    UA_DelayedCallback delayedFree;
+    UA_SamplingGroupKey key;
+    UA_UInt64 callbackId;
+    LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+
+    /* Event-driven sampling: The group is attached to the node and sampled
+     * only when marked dirty by a change of the value. */
+    UA_Boolean attached;
+    UA_Boolean dirty;
+    struct UA_SamplingGroup *nodeListNext;
+} UA_SamplingGroup;
+
+typedef ZIP_HEAD(UA_SamplingGroupTree, UA_SamplingGroup) UA_SamplingGroupTree;
+
+/* The EURange property of a percent deadband is resolved once. The absolute
+ * deadband is recomputed if an EURange was written since the last
+ * computation. */
+typedef struct {
+    UA_Double percent;
+    UA_NodeId euRangeId; /* Null if no percent deadband is used */
+    UA_UInt32 euRangeGeneration;
+} UA_PercentDeadband;
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+typedef enum {
+    UA_CONDITIONREFRESH_NONE = 0,
+    UA_CONDITIONREFRESH_CONDITIONS, /* Adding the retained Conditions */
+    UA_CONDITIONREFRESH_END         /* Waiting to add the RefreshEndEvent */
+} UA_ConditionRefreshState;
+#endif
+
+/* A triggering link between two MonitoredItems of the same Subscription. The
+ * link is in the lists of both MonitoredItems. So it can be removed from
+ * either side without a search when one of them is deleted. */
+typedef struct UA_TriggeringLink {
+    LIST_ENTRY(UA_TriggeringLink) triggeringEntry; /* In the triggering item */
+    LIST_ENTRY(UA_TriggeringLink) triggeredEntry;  /* In the triggered item */
+    UA_MonitoredItem *triggering;
+    UA_MonitoredItem *triggered;
+} UA_TriggeringLink;
+
 struct UA_MonitoredItem {
     UA_DelayedCallback delayedFreePointers;
     LIST_ENTRY(UA_MonitoredItem) listEntry; /* Linked list in the Subscription */
+    ZIP_ENTRY(UA_MonitoredItem) idTreeEntry; /* Lookup by monitoredItemId in
+                                              * the Subscription */
     UA_Subscription *subscription;          /* Always non-NULL */
     UA_UInt32 monitoredItemId;
 
@@ -140,11 +239,11 @@ struct UA_MonitoredItem {
      *                > (deadbandValue/100.0) * ((high–low) of EURange)))
      *
      * So we can convert from a percentage to an absolute deadband and keep
-     * the hot code path simple.
-     *
-     * TODO: Store the percentage deadband to recompute when the UARange is
-     * changed at runtime of the MonitoredItem */
+     * the hot code path simple. The percentage is kept in percentDeadband to
+     * recompute the absolute deadband when the EURange is changed at runtime
+     * of the MonitoredItem. */
     UA_MonitoringParameters parameters;
+    UA_PercentDeadband percentDeadband;
 
     /* Sampling */
     UA_MonitoredItemSamplingType samplingType;
@@ -153,25 +252,67 @@ struct UA_MonitoredItem {
         UA_MonitoredItem *nodeListNext; /* Event-Based: Attached to Node */
         LIST_ENTRY(UA_MonitoredItem) subscriptionSampling; /* Linked to publish
                                                             * interval */
+        struct {
+            UA_SamplingGroup *group;
+            LIST_ENTRY(UA_MonitoredItem) groupEntry;
+        } grouped;
     } sampling;
     UA_DataValue lastValue;
+    UA_SharedSample *lastValueShared; /* lastValue borrows from the sample */
+    UA_Boolean lastValueHashed; /* Only the hash of lastValue.value is kept */
+    UA_UInt64 lastValueHash;
+    UA_UInt64 lastValueInline[2]; /* Storage for small pointer-free scalars.
+                                   * lastValue.value points here. */
 
     /* Triggering Links */
-    size_t triggeringLinksSize;
-    UA_UInt32 *triggeringLinks;
+    LIST_HEAD(, UA_TriggeringLink) triggeringLinks; /* Items triggered by this */
+    LIST_HEAD(, UA_TriggeringLink) triggeredLinks;  /* Items triggering this */
 
     /* Notification Queue */
     NotificationQueue queue;
+    NotificationQueue notificationPool; /* Deleted Notifications for reuse.
+                                         * Linked with the localEntry. */
+    size_t notificationPoolSize;
     size_t queueSize; /* This is the current size. See also the configured
                        * (maximum) queueSize in the parameters. */
     size_t eventOverflows; /* Separate counter for the queue. Can at most double
                             * the queue size */
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    /* ConditionRefresh that resumes with every publish cycle. The retained
+     * Conditions are added in the order of their NodeId. The cursor is the
+     * last Condition that was added. */
+    UA_ConditionRefreshState refreshState;
+    UA_NodeId refreshCursor;
+#endif
 };
 
+enum ZIP_CMP
+cmpMonitoredItemId(const UA_UInt32 *a, const UA_UInt32 *b);
+
+typedef ZIP_HEAD(UA_MonitoredItemIdTree, UA_MonitoredItem) UA_MonitoredItemIdTree;
+ZIP_FUNCTIONS(UA_MonitoredItemIdTree, UA_MonitoredItem, idTreeEntry,
+              UA_UInt32, monitoredItemId, cmpMonitoredItemId)
+
+#ifdef UA_ENABLE_DA
+/* Compute the absolute deadband from the EURange property */
+UA_StatusCode
+UA_PercentDeadband_compute(UA_Server *server, UA_Session *session,
+                           const UA_PercentDeadband *pd, UA_Double *absDeadband);
+#endif
+
 void UA_MonitoredItem_init(UA_MonitoredItem *mon);
 void UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon);
+
+/* Deregister and clean up the MonitoredItem without freeing its memory. Used
+ * to free the MonitoredItems of a deleted Subscription in one batch. */
+void UA_MonitoredItem_clear(UA_Server *server, UA_MonitoredItem *mon);
 void UA_MonitoredItem_removeOverflowInfoBits(UA_MonitoredItem *mon);
 void UA_MonitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *mon);
+void UA_SamplingGroup_sampleCallback(UA_Server *server, UA_SamplingGroup *sg);
+
+/* The value of the node has changed. Mark the attached SamplingGroups dirty. */
+void UA_Node_markSamplingGroupsDirty(const UA_Node *node);
 void UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon);
 
 /* Register sampling. Either by adding a repeated callback or by adding the
@@ -182,9 +323,13 @@ UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon);
 void
 UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon);
 
+/* If the MonitoredItem is activated, the firstSample (if non-NULL) is
+ * processed instead of reading a new value. The firstSample is always
+ * cleared. */
 UA_StatusCode
 UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
-                                   UA_MonitoringMode monitoringMode);
+                                   UA_MonitoringMode monitoringMode,
+                                   UA_DataValue *firstSample);
 
 
 /* Do not use the value after calling this. It will be moved to mon or freed. */
@@ -192,6 +337,23 @@ void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
                                      UA_DataValue *value);
 
+/* Content hash of a sampled value. Computed at most once per sample. */
+typedef struct {
+    UA_Boolean computed;
+    UA_StatusCode res;
+    UA_UInt64 hash;
+} UA_SampleHash;
+
+/* The value is shared between the MonitoredItems of a SamplingGroup. If the
+ * MonitoredItem detects a change, the notification borrows from the sample. */
+void
+UA_MonitoredItem_processSharedSample(UA_Server *server, UA_MonitoredItem *mon,
+                                     UA_SharedSample *ss, UA_SampleHash *sh);
+
+/* Remove the last sampled value (or its hash) */
+void
+UA_MonitoredItem_clearLastValue(UA_MonitoredItem *mon);
+
 UA_StatusCode
 UA_MonitoredItem_removeLink(UA_Subscription *sub, UA_MonitoredItem *mon,
                             UA_UInt32 linkId);
@@ -200,9 +362,12 @@ UA_StatusCode
 UA_MonitoredItem_addLink(UA_Subscription *sub, UA_MonitoredItem *mon,
                          UA_UInt32 linkId);
 
+/* The value is copied into the notification. Unless it is the value of the
+ * SharedSample ss (can be NULL), which is borrowed. */
 UA_StatusCode
 UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
-                                              const UA_DataValue *value);
+                                              const UA_DataValue *value,
+                                              UA_SharedSample *ss);
 
 /* Remove entries until mon->maxQueueSize is reached. Sets infobits for lost
  * data if required. */
@@ -212,6 +377,20 @@ void UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon)
 /* Subscription */
 /****************/
 
+/* Subscriptions with the same publishing interval share a PublishGroup. The
+ * repeated callback of the group samples and publishes all its Subscriptions
+ * in one sweep. This avoids a large number of timers that fire at unrelated
+ * points in time. */
+typedef struct UA_PublishGroup {
+    ZIP_ENTRY(UA_PublishGroup) zipEntry;
+    UA_DelayedCallback delayedFree;
+    UA_Double publishingInterval;
+    UA_UInt64 callbackId;
+    TAILQ_HEAD(, UA_Subscription) subscriptions;
+} UA_PublishGroup;
+
+typedef ZIP_HEAD(UA_PublishGroupTree, UA_PublishGroup) UA_PublishGroupTree;
+
 /* We use only a subset of the states defined in the standard */
 typedef enum {
     UA_SUBSCRIPTIONSTATE_STOPPED = 0,
@@ -251,8 +430,9 @@ struct UA_Subscription {
     UA_UInt32 currentKeepAliveCount;
     UA_UInt32 currentLifetimeCount;
 
-    /* Publish Callback. Registered if id > 0. */
-    UA_UInt64 publishCallbackId;
+    /* Publish Callback of the PublishGroup. Registered if the group is set. */
+    UA_PublishGroup *publishGroup;
+    TAILQ_ENTRY(UA_Subscription) publishGroupEntry;
 
     /* Delayed callback to schedule publication of more notifications */
     UA_Boolean delayedCallbackRegistered;
@@ -261,7 +441,12 @@ struct UA_Subscription {
     /* MonitoredItems */
     UA_UInt32 lastMonitoredItemId; /* increase the identifiers */
     LIST_HEAD(, UA_MonitoredItem) monitoredItems;
+    UA_MonitoredItemIdTree monitoredItemsById;
     UA_UInt32 monitoredItemsSize;
+    UA_UInt32 disabledMonitoredItemsSize; /* Maintained for the diagnostics */
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    UA_UInt32 conditionRefreshes; /* MonitoredItems with a pending refresh */
+#endif
 
     /* MonitoredItems that are sampled in every publish callback (with the
      * publish interval of the subscription) */
@@ -301,7 +486,7 @@ struct UA_Subscription {
 #endif
 };
 
-UA_Subscription * UA_Subscription_new(void);
+UA_Subscription * UA_Subscription_new(UA_Server *server);
 
 void
 UA_Subscription_delete(UA_Server *server, UA_Subscription *sub);
@@ -310,6 +495,11 @@ UA_StatusCode
 Subscription_setState(UA_Server *server, UA_Subscription *sub,
                       UA_SubscriptionState state);
 
+/* Move the Subscription to the PublishGroup of its (changed) publishing
+ * interval. The Subscription is stopped if the new group cannot be created. */
+UA_StatusCode
+Subscription_updatePublishGroup(UA_Server *server, UA_Subscription *sub);
+
 void
 Subscription_resetLifetime(UA_Subscription *sub);
 
@@ -336,6 +526,11 @@ UA_Session_ensurePublishQueueSpace(UA_Server *server, UA_Session *session);
 /* Forward declaration for A&C used in ua_server_internal.h" */
 struct UA_ConditionSource;
 typedef struct UA_ConditionSource UA_ConditionSource;
+struct UA_Condition;
+
+/* Index of the ConditionSources and Conditions by their NodeId */
+typedef ZIP_HEAD(UA_ConditionSourceTree, UA_ConditionSource) UA_ConditionSourceTree;
+typedef ZIP_HEAD(UA_ConditionTree, UA_Condition) UA_ConditionTree;
 
 /* Event Handling */
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
@@ -344,12 +539,62 @@ typedef struct UA_ConditionSource UA_ConditionSource;
 #define UA_EVENTFILTER_MAXOPERANDS 64 /* Max operands per operator */
 #define UA_EVENTFILTER_MAXSELECT   64 /* Max select clauses */
 
+#define UA_EVENTCACHE_MAXPATHS     16 /* Max cached browse paths per event */
+#define UA_EVENTCACHE_MAXTYPES     8  /* Max cached OfType results per event */
+#define UA_EVENTCACHE_MAXFIELDS    32 /* Max cached operand values per event */
+
+/* The browse paths of SimpleAttributeOperands and the EventType are resolved
+ * once per event and then reused by the where- and select-clauses of all
+ * MonitoredItems receiving the event. The cached browse paths point into the
+ * filters. So the MonitoredItems must not be modified while the cache is in
+ * use.
+ *
+ * Transient events have no node representation. Their fields are taken from
+ * the map instead. Only the Value attribute of single-element browse paths can
+ * be resolved from the map.
+ *
+ * If shareFields is set, the resolved operand values are kept in a
+ * SharedSample (as an array of Variants). The EventFieldLists borrow from it and
+ * the notification holds a reference. The values are cached per Session, as
+ * reading them depends on the access rights of the Session. */
+typedef struct {
+    const UA_KeyValueMap *fields; /* Transient event if set */
+    UA_Boolean eventTypeResolved;
+    UA_StatusCode eventTypeStatus;
+    UA_NodeId eventType;
+    size_t pathsSize;
+    struct {
+        size_t browsePathSize;
+        const UA_QualifiedName *browsePath;
+        UA_StatusCode status;
+        UA_NodeId target;
+    } paths[UA_EVENTCACHE_MAXPATHS];
+    size_t typesSize;
+    struct {
+        const UA_NodeId *type; /* Points into the filter */
+        UA_Boolean ofType;
+    } types[UA_EVENTCACHE_MAXTYPES];
+    UA_Boolean shareFields;
+    UA_SharedSample *selected; /* Variant array with the resolved values */
+    size_t selectedSize;
+    struct {
+        const UA_Session *session;
+        const UA_SimpleAttributeOperand *sao; /* Points into the filter */
+        UA_StatusCode status;
+    } selectedOperands[UA_EVENTCACHE_MAXFIELDS];
+} UA_EventCache;
+
+void UA_EventCache_init(UA_EventCache *cache);
+void UA_EventCache_clear(UA_EventCache *cache);
+
+/* The cache can be NULL. With a cache, MonitoredItems whose where-clause
+ * cannot match the EventType are skipped before the filter is evaluated. */
 UA_StatusCode
 UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
-                          const UA_NodeId *event);
+                          const UA_NodeId *event, UA_EventCache *cache);
 
 UA_StatusCode
-generateEventId(UA_ByteString *generatedId);
+generateEventId(UA_Server *server, UA_ByteString *generatedId);
 
 /* Static validation when the filter is registered */
 UA_StatusCode
@@ -368,6 +613,14 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
                     const UA_ContentFilter *contentFilter,
                     UA_ContentFilterResult *contentFilterResult);
 
+/* Quick check of the OfType operators in the where-clause against the EventType.
+ * Returns false only if the where-clause cannot match the event. The other
+ * operators are not evaluated. */
+UA_Boolean
+whereClauseMayMatch(UA_Server *server, UA_EventCache *cache,
+                    const UA_NodeId *eventNode,
+                    const UA_ContentFilter *contentFilter);
+
 #endif
 
 /***********/
@@ -39,12 +39,26 @@ typedef struct UA_ConditionBranch {
     UA_Boolean isCallerAC;
 } UA_ConditionBranch;
 
+/* The state variables of a Condition. Their NodeIds are resolved with a
+ * browse path once and then read directly. */
+enum {
+    CONDITION_STATE_RETAIN = 0,
+    CONDITION_STATE_ENABLED,
+    CONDITION_STATE_ACKED,
+    CONDITION_STATE_CONFIRMED,
+    CONDITION_STATE_ACTIVE,
+    CONDITION_STATE_COUNT
+};
+
 /* In Alarms and Conditions first implementation, A Condition
  * have only one ConditionBranch entry. */
 typedef struct UA_Condition {
     LIST_ENTRY(UA_Condition) listEntry;
+    ZIP_ENTRY(UA_Condition) idTreeEntry; /* Server-wide index by conditionId */
     LIST_HEAD(, UA_ConditionBranch) conditionBranches;
+    struct UA_ConditionSource *source;
     UA_NodeId conditionId;
+    UA_NodeId stateIds[CONDITION_STATE_COUNT]; /* Resolved on first use */
     UA_UInt16 lastSeverity;
     UA_DateTime lastSeveritySourceTimeStamp;
     UA_ConditionCallbacks callbacks;
@@ -56,6 +70,7 @@ typedef struct UA_Condition {
 /* A ConditionSource can have multiple Conditions. */
 struct UA_ConditionSource {
     LIST_ENTRY(UA_ConditionSource) listEntry;
+    ZIP_ENTRY(UA_ConditionSource) idTreeEntry;
     LIST_HEAD(, UA_Condition) conditions;
     UA_NodeId conditionSourceId;
 };
@@ -166,6 +181,11 @@ static const UA_QualifiedName fieldExpirationDateQN = STATIC_QN(CONDITION_FIELD_
 
 static const UA_QualifiedName fieldExpirationLimitQN = STATIC_QN(CONDITION_FIELD_EXPIRATION_LIMIT);
 
+/* The TwoStateVariables in the order of the CONDITION_STATE enum */
+static const UA_QualifiedName *twoStateVariableQNs[CONDITION_STATE_COUNT] =
+    {NULL, &fieldEnabledStateQN, &fieldAckedStateQN,
+     &fieldConfirmedStateQN, &fieldActiveStateQN};
+
 #define CONDITION_ASSERT_RETURN_RETVAL(retval, logMessage, deleteFunction)                \
     {                                                                                     \
         if(retval != UA_STATUSCODE_GOOD) {                                                \
@@ -205,31 +225,30 @@ addConditionOptionalField(UA_Server *server, const UA_NodeId condition,
                           const UA_NodeId conditionType, const UA_QualifiedName fieldName,
                           UA_NodeId *outOptionalNode);
 
+static enum ZIP_CMP
+cmpConditionNodeId(const UA_NodeId *a, const UA_NodeId *b) {
+    return (enum ZIP_CMP)UA_NodeId_order(a, b);
+}
+
+ZIP_FUNCTIONS(UA_ConditionSourceTree, UA_ConditionSource, idTreeEntry,
+              UA_NodeId, conditionSourceId, cmpConditionNodeId)
+ZIP_FUNCTIONS(UA_ConditionTree, UA_Condition, idTreeEntry,
+              UA_NodeId, conditionId, cmpConditionNodeId)
+
 static UA_ConditionSource *
 getConditionSource(UA_Server *server, const UA_NodeId *sourceId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_ConditionSource *cs;
-    LIST_FOREACH(cs, &server->conditionSources, listEntry) {
-        if(UA_NodeId_equal(&cs->conditionSourceId, sourceId))
-            return cs;
-    }
-    return NULL;
+    return ZIP_FIND(UA_ConditionSourceTree, &server->conditionSourceTree, sourceId);
 }
 
 static UA_Condition *
 getCondition(UA_Server *server, const UA_NodeId *sourceId,
              const UA_NodeId *conditionId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_ConditionSource *cs = getConditionSource(server, sourceId);
-    if(!cs)
+    UA_Condition *c = ZIP_FIND(UA_ConditionTree, &server->conditionTree, conditionId);
+    if(!c || !UA_NodeId_equal(&c->source->conditionSourceId, sourceId))
         return NULL;
-
-    UA_Condition *c;
-    LIST_FOREACH(c, &cs->conditions, listEntry) {
-        if(UA_NodeId_equal(&c->conditionId, conditionId))
-            return c;
-    }
-    return NULL;
+    return c;
 }
 
 /* Function used to set a user specific callback to TwoStateVariable Fields of a
@@ -672,37 +691,72 @@ isConditionOrBranch(UA_Server *server, const UA_NodeId *condition,
     return false;
 }
 
+/* Resolve the NodeId of a state variable (Retain or TwoStateVariable/Id). The
+ * NodeId is cached in the Condition entry if there is one. Otherwise the caller
+ * takes ownership of the returned NodeId. */
+static UA_StatusCode
+getConditionStateNodeId(UA_Server *server, UA_Condition *cond,
+                        const UA_NodeId *condition, size_t state,
+                        UA_NodeId *outStateNodeId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    if(cond && !UA_NodeId_isNull(&cond->stateIds[state])) {
+        *outStateNodeId = cond->stateIds[state];
+        return UA_STATUSCODE_GOOD;
+    }
+
+    UA_NodeId stateNodeId;
+    UA_StatusCode retval;
+    if(state == CONDITION_STATE_RETAIN)
+        retval = getConditionFieldNodeId(server, condition, &fieldRetainQN,
+                                         &stateNodeId);
+    else
+        retval = getConditionFieldPropertyNodeId(server, condition,
+                                                 twoStateVariableQNs[state],
+                                                 &twoStateVariableIdQN, &stateNodeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+    if(cond)
+        cond->stateIds[state] = stateNodeId;
+    *outStateNodeId = stateNodeId;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The Condition entry is NULL for ConditionBranches */
 static UA_Boolean
-isRetained(UA_Server *server, const UA_NodeId *condition) {
+readConditionState(UA_Server *server, UA_Condition *cond,
+                   const UA_NodeId *condition, size_t state) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    /* Get EnabledStateId NodeId */
-    UA_NodeId retainNodeId;
-    UA_StatusCode retval = getConditionFieldNodeId(server, condition, &fieldRetainQN, &retainNodeId);
+    UA_NodeId stateNodeId;
+    UA_StatusCode retval =
+        getConditionStateNodeId(server, cond, condition, state, &stateNodeId);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_USERLAND,
-                       "Retain not found. StatusCode %s", UA_StatusCode_name(retval));
+                       "%s not found. StatusCode %s",
+                       (state == CONDITION_STATE_RETAIN) ?
+                       CONDITION_FIELD_RETAIN : "TwoStateVariable/Id",
+                       UA_StatusCode_name(retval));
         return false; //TODO maybe a better error handling?
     }
 
-    /* Read Retain value */
+    /* Read the Boolean value */
     UA_Variant tOutVariant;
-    retval = readWithReadValue(server, &retainNodeId, UA_ATTRIBUTEID_VALUE, &tOutVariant);
-    if(retval != UA_STATUSCODE_GOOD ||
-       !UA_Variant_hasScalarType(&tOutVariant, &UA_TYPES[UA_TYPES_BOOLEAN])) {
-          UA_NodeId_clear(&retainNodeId);
-          return false;
-    }
-
-    if(*(UA_Boolean *)tOutVariant.data == true) {
-        UA_NodeId_clear(&retainNodeId);
-        UA_Variant_clear(&tOutVariant);
-        return true;
-    }
-
-    UA_NodeId_clear(&retainNodeId);
+    retval = readWithReadValue(server, &stateNodeId, UA_ATTRIBUTEID_VALUE, &tOutVariant);
+    if(!cond)
+        UA_NodeId_clear(&stateNodeId);
+    if(retval != UA_STATUSCODE_GOOD)
+        return false;
+    UA_Boolean res = (UA_Variant_hasScalarType(&tOutVariant, &UA_TYPES[UA_TYPES_BOOLEAN]) &&
+                      *(UA_Boolean *)tOutVariant.data == true);
     UA_Variant_clear(&tOutVariant);
-    return false;
+    return res;
+}
+
+static UA_Boolean
+isRetained(UA_Server *server, const UA_NodeId *condition) {
+    UA_Condition *cond = ZIP_FIND(UA_ConditionTree, &server->conditionTree, condition);
+    return readConditionState(server, cond, condition, CONDITION_STATE_RETAIN);
 }
 
 static UA_Boolean
@@ -718,6 +772,14 @@ isTwoStateVariableInTrueState(UA_Server *server, const UA_NodeId *condition,
                               const UA_QualifiedName *twoStateVariable) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
+    /* The standard state variables are read from the cached NodeId */
+    for(size_t i = CONDITION_STATE_ENABLED; i < CONDITION_STATE_COUNT; i++) {
+        if(!UA_QualifiedName_equal(twoStateVariable, twoStateVariableQNs[i]))
+            continue;
+        UA_Condition *cond = ZIP_FIND(UA_ConditionTree, &server->conditionTree, condition);
+        return readConditionState(server, cond, condition, i);
+    }
+
     /* Get TwoStateVariableId NodeId */
     UA_NodeId twoStateVariableIdNodeId;
     UA_StatusCode retval = getConditionFieldPropertyNodeId(server, condition, twoStateVariable,
@@ -1712,7 +1774,7 @@ setRefreshMethodEventFields(UA_Server *server, const UA_NodeId *refreshEventNodI
     CONDITION_ASSERT_RETURN_RETVAL(retval, "Set RefreshEvent ReceiveTime failed",);
 
     /* Set EventId */
-    retval = generateEventId(&eventId);
+    retval = generateEventId(server, &eventId);
     CONDITION_ASSERT_RETURN_RETVAL(retval, "Generating EventId failed",);
 
     UA_Variant_setScalar(&value, &eventId, &UA_TYPES[UA_TYPES_BYTESTRING]);
@@ -1772,71 +1834,215 @@ isConditionSourceInMonitoredItem(UA_Server *server, const UA_MonitoredItem *moni
     return isNodeInTree(server, conditionSource, &monitoredItem->itemToMonitor.nodeId, &refs);
 }
 
+/* Is the ConditionSource monitored? If the Server Object is being monitored,
+ * then all Events of all ConditionSources should be refreshed. */
+static UA_Boolean
+isRefreshedConditionSource(UA_Server *server, const UA_MonitoredItem *monitoredItem,
+                           const UA_NodeId *conditionSource) {
+    UA_NodeId serverObjectNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    return (UA_NodeId_equal(&monitoredItem->itemToMonitor.nodeId, conditionSource) ||
+            UA_NodeId_equal(&monitoredItem->itemToMonitor.nodeId, &serverObjectNodeId) ||
+            isConditionSourceInMonitoredItem(server, monitoredItem, conditionSource));
+}
+
+/* The first Condition with a NodeId greater than the cursor. Returns the
+ * smallest Condition if the cursor is NULL. */
+static UA_Condition *
+nextRefreshCondition(UA_Server *server, const UA_NodeId *cursor) {
+    if(UA_NodeId_isNull(cursor))
+        return ZIP_MIN(UA_ConditionTree, &server->conditionTree);
+    UA_Condition *next = NULL;
+    UA_Condition *c = ZIP_ROOT(&server->conditionTree);
+    while(c) {
+        if(UA_NodeId_order(&c->conditionId, cursor) == UA_ORDER_MORE) {
+            next = c;
+            c = ZIP_LEFT(c, idTreeEntry);
+        } else {
+            c = ZIP_RIGHT(c, idTreeEntry);
+        }
+    }
+    return next;
+}
+
+/* Add the retained Conditions after the cursor of the MonitoredItem. At most
+ * maxEvents are added (0 -> unlimited). The cursor is moved forward. Sets done
+ * if no retained Condition remains. */
 static UA_StatusCode
-refreshLogic(UA_Server *server, const UA_NodeId *refreshStartNodId,
-             const UA_NodeId *refreshEndNodId, UA_MonitoredItem *monitoredItem) {
+refreshConditions(UA_Server *server, UA_MonitoredItem *monitoredItem,
+                  size_t maxEvents, size_t *outAdded, UA_Boolean *done) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
-    UA_assert(monitoredItem != NULL);
 
-    /* 1. Trigger RefreshStartEvent */
+    /* Refresh (see 5.5.7) */
+    size_t added = 0;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    UA_Condition *cond = nextRefreshCondition(server, &monitoredItem->refreshCursor);
+    for(; cond; cond = nextRefreshCondition(server, &cond->conditionId)) {
+        if(maxEvents > 0 && added >= maxEvents)
+            break;
+
+        UA_Boolean sourceChecked = false;
+        UA_ConditionBranch *branch;
+        LIST_FOREACH(branch, &cond->conditionBranches, listEntry) {
+            /* If no event was triggered for that branch, then check next
+             * without refreshing */
+            if(UA_ByteString_equal(&branch->lastEventId, &UA_BYTESTRING_NULL))
+                continue;
+
+            UA_NodeId triggeredNode;
+            UA_Condition *entry = NULL;
+            if(UA_NodeId_isNull(&branch->conditionBranchId)) {
+                triggeredNode = cond->conditionId;
+                entry = cond;
+            } else {
+                triggeredNode = branch->conditionBranchId;
+            }
+
+            /* Check if Retain is set to true */
+            if(!readConditionState(server, entry, &triggeredNode,
+                                   CONDITION_STATE_RETAIN))
+                continue;
+
+            /* Check if the ConditionSource is being monitored */
+            if(!sourceChecked) {
+                if(!isRefreshedConditionSource(server, monitoredItem,
+                                               &cond->source->conditionSourceId))
+                    break;
+                sourceChecked = true;
+            }
+
+            /* Add the event */
+            retval = UA_MonitoredItem_addEvent(server, monitoredItem, &triggeredNode, NULL);
+            CONDITION_ASSERT_RETURN_RETVAL(retval, "Events: Could not add the event to a listening node",);
+            added++;
+        }
+
+        /* Move the cursor forward */
+        if(maxEvents > 0) {
+            UA_NodeId_clear(&monitoredItem->refreshCursor);
+            retval = UA_NodeId_copy(&cond->conditionId, &monitoredItem->refreshCursor);
+            if(retval != UA_STATUSCODE_GOOD)
+                return retval;
+        }
+    }
+
+    *outAdded = added;
+    *done = (cond == NULL);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+addRefreshEvent(UA_Server *server, const UA_NodeId *refreshEventNodId,
+                UA_MonitoredItem *monitoredItem) {
     UA_EventLoop *el = server->config.eventLoop;
     UA_DateTime fieldTimeValue = el->dateTime_now(el);
     UA_StatusCode retval =
-        writeObjectProperty_scalar(server, *refreshStartNodId, fieldTimeQN,
+        writeObjectProperty_scalar(server, *refreshEventNodId, fieldTimeQN,
                                    &fieldTimeValue, &UA_TYPES[UA_TYPES_DATETIME]);
     CONDITION_ASSERT_RETURN_RETVAL(retval, "Write Object Property scalar failed",);
+    return UA_MonitoredItem_addEvent(server, monitoredItem, refreshEventNodId, NULL);
+}
 
-    retval = UA_MonitoredItem_addEvent(server, monitoredItem, refreshStartNodId);
-    CONDITION_ASSERT_RETURN_RETVAL(retval, "Events: Could not add the event to a listening node",);
+static void
+stopConditionRefresh(UA_MonitoredItem *monitoredItem) {
+    if(monitoredItem->refreshState == UA_CONDITIONREFRESH_NONE)
+        return;
+    monitoredItem->subscription->conditionRefreshes--;
+    monitoredItem->refreshState = UA_CONDITIONREFRESH_NONE;
+    UA_NodeId_clear(&monitoredItem->refreshCursor);
+}
 
-    /* 2. Refresh (see 5.5.7) */
-    /* Get ConditionSource Entry */
-    UA_ConditionSource *source;
-    LIST_FOREACH(source, &server->conditionSources, listEntry) {
-        UA_NodeId conditionSource = source->conditionSourceId;
-        UA_NodeId serverObjectNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
-        /* Check if the conditionSource is being monitored. If the Server Object
-         * is being monitored, then all Events of all monitoredItems should be
-         * refreshed */
-        if(!UA_NodeId_equal(&monitoredItem->itemToMonitor.nodeId, &conditionSource) &&
-           !UA_NodeId_equal(&monitoredItem->itemToMonitor.nodeId, &serverObjectNodeId) &&
-           !isConditionSourceInMonitoredItem(server, monitoredItem, &conditionSource))
+/* Add the next chunk of a streaming refresh. The chunk is limited by the
+ * configuration and by the free space in the queues. */
+static UA_StatusCode
+continueConditionRefresh(UA_Server *server, UA_MonitoredItem *monitoredItem) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_Subscription *sub = monitoredItem->subscription;
+
+    size_t space = 0;
+    if(monitoredItem->parameters.queueSize > monitoredItem->queueSize)
+        space = monitoredItem->parameters.queueSize - monitoredItem->queueSize;
+    if(sub->notificationsPerPublish > sub->notificationQueueSize) {
+        size_t subSpace = sub->notificationsPerPublish - sub->notificationQueueSize;
+        if(space > subSpace)
+            space = subSpace;
+    } else {
+        space = 0;
+    }
+    if(space == 0)
+        return UA_STATUSCODE_GOOD; /* Wait for the next publish cycle */
+
+    if(monitoredItem->refreshState == UA_CONDITIONREFRESH_CONDITIONS) {
+        size_t maxEvents = server->config.maxConditionRefreshPerPublish;
+        if(maxEvents > space)
+            maxEvents = space;
+        size_t added = 0;
+        UA_Boolean done = false;
+        UA_StatusCode retval =
+            refreshConditions(server, monitoredItem, maxEvents, &added, &done);
+        if(retval != UA_STATUSCODE_GOOD) {
+            stopConditionRefresh(monitoredItem);
+            return retval;
+        }
+        if(!done)
+            return UA_STATUSCODE_GOOD;
+        monitoredItem->refreshState = UA_CONDITIONREFRESH_END;
+        space -= added;
+        if(space == 0)
+            return UA_STATUSCODE_GOOD; /* Add the RefreshEndEvent later */
+    }
+
+    /* Trigger RefreshEndEvent */
+    stopConditionRefresh(monitoredItem);
+    return addRefreshEvent(server, &server->refreshEvents[REFRESHEVENT_END_IDX],
+                           monitoredItem);
+}
+
+void
+UA_Subscription_continueConditionRefresh(UA_Server *server, UA_Subscription *sub) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_MonitoredItem *monitoredItem;
+    LIST_FOREACH(monitoredItem, &sub->monitoredItems, listEntry) {
+        if(monitoredItem->refreshState == UA_CONDITIONREFRESH_NONE)
             continue;
+        UA_StatusCode retval = continueConditionRefresh(server, monitoredItem);
+        if(retval != UA_STATUSCODE_GOOD)
+            UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, sub,
+                                        "Could not continue the ConditionRefresh "
+                                        "with StatusCode %s", UA_StatusCode_name(retval));
+        if(sub->conditionRefreshes == 0)
+            break;
+    }
+}
 
-        /* Get Condition Entry */
-        UA_Condition *cond;
-        LIST_FOREACH(cond, &source->conditions, listEntry) {
-            /* Get Branch Entry */
-            UA_ConditionBranch *branch;
-            LIST_FOREACH(branch, &cond->conditionBranches, listEntry) {
-                /* If no event was triggered for that branch, then check next
-                 * without refreshing */
-                if(UA_ByteString_equal(&branch->lastEventId, &UA_BYTESTRING_NULL))
-                    continue;
+static UA_StatusCode
+refreshLogic(UA_Server *server, const UA_NodeId *refreshStartNodId,
+             const UA_NodeId *refreshEndNodId, UA_MonitoredItem *monitoredItem) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    UA_assert(monitoredItem != NULL);
 
-                UA_NodeId triggeredNode;
-                if(UA_NodeId_isNull(&branch->conditionBranchId))
-                    triggeredNode = cond->conditionId;
-                else
-                    triggeredNode = branch->conditionBranchId;
+    /* A new refresh restarts a pending refresh */
+    stopConditionRefresh(monitoredItem);
 
-                /* Check if Retain is set to true */
-                if(!isRetained(server, &triggeredNode))
-                    continue;
+    /* 1. Trigger RefreshStartEvent */
+    UA_StatusCode retval = addRefreshEvent(server, refreshStartNodId, monitoredItem);
+    CONDITION_ASSERT_RETURN_RETVAL(retval, "Events: Could not add the event to a listening node",);
 
-                /* Add the event */
-                retval = UA_MonitoredItem_addEvent(server, monitoredItem, &triggeredNode);
-                CONDITION_ASSERT_RETURN_RETVAL(retval, "Events: Could not add the event to a listening node",);
-            }
-        }
+    /* 2. Streaming refresh. The first chunk is added right away. */
+    if(server->config.maxConditionRefreshPerPublish > 0) {
+        monitoredItem->refreshState = UA_CONDITIONREFRESH_CONDITIONS;
+        monitoredItem->subscription->conditionRefreshes++;
+        return continueConditionRefresh(server, monitoredItem);
     }
 
+    /* 2. Add all retained Conditions at once */
+    size_t added = 0;
+    UA_Boolean done = false;
+    retval = refreshConditions(server, monitoredItem, 0, &added, &done);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* 3. Trigger RefreshEndEvent */
-    fieldTimeValue = el->dateTime_now(el);
-    retval = writeObjectProperty_scalar(server, *refreshEndNodId, fieldTimeQN,
-                                        &fieldTimeValue, &UA_TYPES[UA_TYPES_DATETIME]);
-    CONDITION_ASSERT_RETURN_RETVAL(retval, "Write Object Property scalar failed",);
-    return UA_MonitoredItem_addEvent(server, monitoredItem, refreshEndNodId);
+    return addRefreshEvent(server, refreshEndNodId, monitoredItem);
 }
 
 static UA_StatusCode
@@ -1951,7 +2157,9 @@ setConditionInConditionList(UA_Server *server, const UA_NodeId *conditionNodeId,
     }
 
     memset(conditionBranchListEntry, 0, sizeof(UA_ConditionBranch));
+    conditionListEntry->source = conditionSourceEntry;
     LIST_INSERT_HEAD(&conditionSourceEntry->conditions, conditionListEntry, listEntry);
+    ZIP_INSERT(UA_ConditionTree, &server->conditionTree, conditionListEntry);
     LIST_INSERT_HEAD(&conditionListEntry->conditionBranches, conditionBranchListEntry, listEntry);
     return UA_STATUSCODE_GOOD;
 }
@@ -1982,6 +2190,8 @@ appendConditionEntry(UA_Server *server, const UA_NodeId *conditionNodeId,
     }
 
     LIST_INSERT_HEAD(&server->conditionSources, conditionSourceListEntry, listEntry);
+    ZIP_INSERT(UA_ConditionSourceTree, &server->conditionSourceTree,
+               conditionSourceListEntry);
     return setConditionInConditionList(server, conditionNodeId, conditionSourceListEntry);
 }
 
@@ -1997,13 +2207,24 @@ deleteAllBranchesFromCondition(UA_Condition *cond) {
 }
 
 static void
-deleteCondition(UA_Condition *cond) {
+deleteCondition(UA_Server *server, UA_Condition *cond) {
     deleteAllBranchesFromCondition(cond);
+    ZIP_REMOVE(UA_ConditionTree, &server->conditionTree, cond);
     UA_NodeId_clear(&cond->conditionId);
+    for(size_t i = 0; i < CONDITION_STATE_COUNT; i++)
+        UA_NodeId_clear(&cond->stateIds[i]);
     LIST_REMOVE(cond, listEntry);
     UA_free(cond);
 }
 
+static void
+deleteConditionSource(UA_Server *server, UA_ConditionSource *source) {
+    ZIP_REMOVE(UA_ConditionSourceTree, &server->conditionSourceTree, source);
+    UA_NodeId_clear(&source->conditionSourceId);
+    LIST_REMOVE(source, listEntry);
+    UA_free(source);
+}
+
 void
 UA_ConditionList_delete(UA_Server *server) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
@@ -2012,11 +2233,9 @@ UA_ConditionList_delete(UA_Server *server) {
     LIST_FOREACH_SAFE(source, &server->conditionSources, listEntry, tmp_source) {
         UA_Condition *cond, *tmp_cond;
         LIST_FOREACH_SAFE(cond, &source->conditions, listEntry, tmp_cond) {
-            deleteCondition(cond);
+            deleteCondition(server, cond);
         }
-        UA_NodeId_clear(&source->conditionSourceId);
-        LIST_REMOVE(source, listEntry);
-        UA_free(source);
+        deleteConditionSource(server, source);
     }
     /* Free memory allocated for RefreshEvents NodeIds */
     UA_NodeId_clear(&server->refreshEvents[REFRESHEVENT_START_IDX]);
@@ -2030,16 +2249,18 @@ UA_getConditionId(UA_Server *server, const UA_NodeId *conditionNodeId,
                   UA_NodeId *outConditionId) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
-    /* Get ConditionSource Entry */
+    /* Look up the Condition in the index */
+    UA_Condition *cond = ZIP_FIND(UA_ConditionTree, &server->conditionTree,
+                                  conditionNodeId);
+    if(cond) {
+        *outConditionId = cond->conditionId;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Search the ConditionBranches */
     UA_ConditionSource *source;
     LIST_FOREACH(source, &server->conditionSources, listEntry) {
-        /* Get Condition Entry */
-        UA_Condition *cond;
         LIST_FOREACH(cond, &source->conditions, listEntry) {
-            if(UA_NodeId_equal(&cond->conditionId, conditionNodeId)) {
-                *outConditionId = cond->conditionId;
-                return UA_STATUSCODE_GOOD;
-            }
             /* Get Branch Entry*/
             UA_ConditionBranch *branch;
             LIST_FOREACH(branch, &cond->conditionBranches, listEntry) {
@@ -2932,37 +3153,19 @@ UA_Server_deleteCondition(UA_Server *server, const UA_NodeId condition,
                           const UA_NodeId conditionSource) {
     UA_LOCK_ASSERT(&server->serviceMutex, 0);
 
-    /* Get ConditionSource Entry */
-    UA_Boolean found = false; /* Delete from internal list */
-    UA_ConditionSource *source, *tmp_source;
-
+    /* Delete from internal list */
     UA_LOCK(&server->serviceMutex);
-    LIST_FOREACH_SAFE(source, &server->conditionSources, listEntry, tmp_source) {
-        if(!UA_NodeId_equal(&source->conditionSourceId, &conditionSource))
-            continue;
-
-        /* Get Condition Entry */
-        UA_Condition *cond, *tmp_cond;
-        LIST_FOREACH_SAFE(cond, &source->conditions, listEntry, tmp_cond) {
-            if(!UA_NodeId_equal(&cond->conditionId, &condition))
-                continue;
-            deleteCondition(cond);
-            found = true;
-            break;
-        }
-
-        if(LIST_EMPTY(&source->conditions)){
-            UA_NodeId_clear(&source->conditionSourceId);
-            LIST_REMOVE(source, listEntry);
-            UA_free(source);
-        }
-        break;
+    UA_Condition *cond = getCondition(server, &conditionSource, &condition);
+    if(!cond) {
+        UA_UNLOCK(&server->serviceMutex);
+        return UA_STATUSCODE_BADNOTFOUND;
     }
+    UA_ConditionSource *source = cond->source;
+    deleteCondition(server, cond);
+    if(LIST_EMPTY(&source->conditions))
+        deleteConditionSource(server, source);
     UA_UNLOCK(&server->serviceMutex);
 
-    if(!found)
-        return UA_STATUSCODE_BADNOTFOUND;
-
     /* Delete from address space */
     return UA_Server_deleteNode(server, condition, true);
 }
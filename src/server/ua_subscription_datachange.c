@@ -15,42 +15,50 @@
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS /* conditional compilation */
 
-/* Detect value changes outside the deadband */
-#define UA_DETECT_DEADBAND(TYPE) do {                           \
-    TYPE v1 = *(const TYPE*)data1;                              \
-    TYPE v2 = *(const TYPE*)data2;                              \
-    TYPE diff = (v1 > v2) ? (TYPE)(v1 - v2) : (TYPE)(v2 - v1);  \
-    return ((UA_Double)diff > deadband);                        \
-} while(false);
+/* Detect value changes outside the deadband. The kernels are specialized for
+ * each numeric type. The elements are tested in blocks without branches inside
+ * the block, so that the compiler can vectorize the inner loop. The test exits
+ * after the first block with an element outside the deadband. */
+#define UA_DEADBAND_BLOCK 16
 
-static UA_Boolean
-detectScalarDeadBand(const void *data1, const void *data2,
-                     const UA_DataType *type, const UA_Double deadband) {
-    if(type->typeKind == UA_DATATYPEKIND_SBYTE) {
-        UA_DETECT_DEADBAND(UA_SByte);
-    } else if(type->typeKind == UA_DATATYPEKIND_BYTE) {
-        UA_DETECT_DEADBAND(UA_Byte);
-    } else if(type->typeKind == UA_DATATYPEKIND_INT16) {
-        UA_DETECT_DEADBAND(UA_Int16);
-    } else if(type->typeKind == UA_DATATYPEKIND_UINT16) {
-        UA_DETECT_DEADBAND(UA_UInt16);
-    } else if(type->typeKind == UA_DATATYPEKIND_INT32) {
-        UA_DETECT_DEADBAND(UA_Int32);
-    } else if(type->typeKind == UA_DATATYPEKIND_UINT32) {
-        UA_DETECT_DEADBAND(UA_UInt32);
-    } else if(type->typeKind == UA_DATATYPEKIND_INT64) {
-        UA_DETECT_DEADBAND(UA_Int64);
-    } else if(type->typeKind == UA_DATATYPEKIND_UINT64) {
-        UA_DETECT_DEADBAND(UA_UInt64);
-    } else if(type->typeKind == UA_DATATYPEKIND_FLOAT) {
-        UA_DETECT_DEADBAND(UA_Float);
-    } else if(type->typeKind == UA_DATATYPEKIND_DOUBLE) {
-        UA_DETECT_DEADBAND(UA_Double);
-    } else {
-        return false; /* Not a known numerical type */
-    }
+#define UA_DEADBAND_DIFF(TYPE, A, B)                                    \
+    ((UA_Double)(((A) > (B)) ? (TYPE)((A) - (B)) : (TYPE)((B) - (A))))
+
+#define UA_DEADBAND_KERNEL(NAME, TYPE)                                  \
+static UA_Boolean                                                       \
+NAME(const TYPE *v1, const TYPE *v2, size_t length,                     \
+     const UA_Double deadband) {                                        \
+    size_t i = 0;                                                       \
+    for(; i + UA_DEADBAND_BLOCK <= length; i += UA_DEADBAND_BLOCK) {    \
+        unsigned outside = 0;                                           \
+        for(size_t j = i; j < i + UA_DEADBAND_BLOCK; j++)               \
+            outside |= (UA_DEADBAND_DIFF(TYPE, v1[j], v2[j]) > deadband); \
+        if(outside)                                                     \
+            return true;                                                \
+    }                                                                   \
+    for(; i < length; i++) {                                            \
+        if(UA_DEADBAND_DIFF(TYPE, v1[i], v2[i]) > deadband)             \
+            return true;                                                \
+    }                                                                   \
+    return false;                                                       \
 }
 
+UA_DEADBAND_KERNEL(detectDeadbandSByte, UA_SByte)
+UA_DEADBAND_KERNEL(detectDeadbandByte, UA_Byte)
+UA_DEADBAND_KERNEL(detectDeadbandInt16, UA_Int16)
+UA_DEADBAND_KERNEL(detectDeadbandUInt16, UA_UInt16)
+UA_DEADBAND_KERNEL(detectDeadbandInt32, UA_Int32)
+UA_DEADBAND_KERNEL(detectDeadbandUInt32, UA_UInt32)
+UA_DEADBAND_KERNEL(detectDeadbandInt64, UA_Int64)
+UA_DEADBAND_KERNEL(detectDeadbandUInt64, UA_UInt64)
+UA_DEADBAND_KERNEL(detectDeadbandFloat, UA_Float)
+UA_DEADBAND_KERNEL(detectDeadbandDouble, UA_Double)
+
+#define UA_DEADBAND_CASE(KIND, NAME, TYPE)                              \
+    case UA_DATATYPEKIND_##KIND:                                        \
+        return NAME((const TYPE*)value->data,                           \
+                    (const TYPE*)oldValue->data, length, deadbandValue);
+
 static UA_Boolean
 detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
                       const UA_Double deadbandValue) {
@@ -61,21 +69,145 @@ detectVariantDeadband(const UA_Variant *value, const UA_Variant *oldValue,
     size_t length = 1;
     if(!UA_Variant_isScalar(value))
         length = value->arrayLength;
-    uintptr_t data = (uintptr_t)value->data;
-    uintptr_t oldData = (uintptr_t)oldValue->data;
-    UA_UInt32 memSize = value->type->memSize;
-    for(size_t i = 0; i < length; ++i) {
-        if(detectScalarDeadBand((const void*)data, (const void*)oldData,
-                                value->type, deadbandValue))
-            return true;
-        data += memSize;
-        oldData += memSize;
+
+    /* Select the kernel once for all array elements */
+    switch(value->type->typeKind) {
+    UA_DEADBAND_CASE(SBYTE, detectDeadbandSByte, UA_SByte)
+    UA_DEADBAND_CASE(BYTE, detectDeadbandByte, UA_Byte)
+    UA_DEADBAND_CASE(INT16, detectDeadbandInt16, UA_Int16)
+    UA_DEADBAND_CASE(UINT16, detectDeadbandUInt16, UA_UInt16)
+    UA_DEADBAND_CASE(INT32, detectDeadbandInt32, UA_Int32)
+    UA_DEADBAND_CASE(UINT32, detectDeadbandUInt32, UA_UInt32)
+    UA_DEADBAND_CASE(INT64, detectDeadbandInt64, UA_Int64)
+    UA_DEADBAND_CASE(UINT64, detectDeadbandUInt64, UA_UInt64)
+    UA_DEADBAND_CASE(FLOAT, detectDeadbandFloat, UA_Float)
+    UA_DEADBAND_CASE(DOUBLE, detectDeadbandDouble, UA_Double)
+    default:
+        return false; /* Not a known numerical type */
     }
-    return false;
 }
 
+/* 64-bit FNV-1a over the binary encoding. The value is encoded in chunks into
+ * a buffer on the stack. */
+#define UA_SAMPLEHASH_CHUNK 512
+#define UA_FNV64_OFFSET 0xcbf29ce484222325ULL
+#define UA_FNV64_PRIME 0x100000001b3ULL
+
+typedef struct {
+    UA_UInt64 hash;
+    UA_Byte buf[UA_SAMPLEHASH_CHUNK];
+} HashContext;
+
+static void
+hashChunk(HashContext *hc, const UA_Byte *end) {
+    for(const UA_Byte *pos = hc->buf; pos < end; pos++) {
+        hc->hash ^= *pos;
+        hc->hash *= UA_FNV64_PRIME;
+    }
+}
+
+static UA_StatusCode
+hashExchangeBuffer(void *handle, UA_Byte **bufPos, const UA_Byte **bufEnd) {
+    HashContext *hc = (HashContext*)handle;
+    hashChunk(hc, *bufPos);
+    *bufPos = hc->buf;
+    *bufEnd = &hc->buf[UA_SAMPLEHASH_CHUNK];
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Only the hash of arrays and non-trivial scalars is kept. Absolute deadbands
+ * need the full last value. */
 static UA_Boolean
-detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *dv) {
+useValueHash(UA_Server *server, const UA_MonitoredItem *mon, const UA_DataValue *dv) {
+    if(!server->config.hashedChangeDetection || !dv->hasValue || !dv->value.type)
+        return false;
+    if(UA_Variant_isScalar(&dv->value) && dv->value.type->pointerFree)
+        return false;
+    const UA_ExtensionObject *filter = &mon->parameters.filter;
+    if(filter->content.decoded.type == &UA_TYPES[UA_TYPES_DATACHANGEFILTER]) {
+        const UA_DataChangeFilter *dcf = (const UA_DataChangeFilter*)
+            filter->content.decoded.data;
+        if(dcf->deadbandType == UA_DEADBANDTYPE_ABSOLUTE)
+            return false;
+    }
+    return true;
+}
+
+/* Computes the hash at most once for each sample */
+static UA_StatusCode
+getSampleHash(const UA_DataValue *dv, UA_SampleHash *sh) {
+    if(sh->computed)
+        return sh->res;
+    HashContext hc;
+    hc.hash = UA_FNV64_OFFSET;
+    UA_Byte *pos = hc.buf;
+    const UA_Byte *end = &hc.buf[UA_SAMPLEHASH_CHUNK];
+    sh->res = UA_encodeBinaryInternal(&dv->value, &UA_TYPES[UA_TYPES_VARIANT],
+                                      &pos, &end, hashExchangeBuffer, &hc);
+    hashChunk(&hc, pos);
+    sh->hash = hc.hash;
+    sh->computed = true;
+    return sh->res;
+}
+
+#ifdef UA_ENABLE_DA
+
+UA_StatusCode
+UA_PercentDeadband_compute(UA_Server *server, UA_Session *session,
+                           const UA_PercentDeadband *pd, UA_Double *absDeadband) {
+    /* Read the range */
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = pd->euRangeId;
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue rangeVal =
+        readWithSession(server, session, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    if(!UA_Variant_isScalar(&rangeVal.value) ||
+       rangeVal.value.type != &UA_TYPES[UA_TYPES_RANGE]) {
+        UA_DataValue_clear(&rangeVal);
+        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
+    }
+
+    /* Compute the abs deadband */
+    UA_Range *euRange = (UA_Range *)rangeVal.value.data;
+    UA_Double abs = (pd->percent / 100.0) * (euRange->high - euRange->low);
+    UA_DataValue_clear(&rangeVal);
+
+    /* EURange invalid or NaN? */
+    if(abs < 0.0 || abs != abs)
+        return UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED;
+
+    *absDeadband = abs;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* An EURange was written since the last computation of the percent deadband.
+ * If the new range is invalid, the previous deadband remains. */
+static void
+updatePercentDeadband(UA_Server *server, UA_MonitoredItem *mon,
+                      UA_DataChangeFilter *dcf) {
+    mon->percentDeadband.euRangeGeneration = server->euRangeGeneration;
+    UA_Session *session = &server->adminSession;
+    if(mon->subscription && mon->subscription->session)
+        session = mon->subscription->session;
+    UA_Double absDeadband;
+    UA_StatusCode res =
+        UA_PercentDeadband_compute(server, session, &mon->percentDeadband, &absDeadband);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                    "MonitoredItem %" PRIi32 " | Cannot update "
+                                    "the percent deadband from the EURange",
+                                    mon->monitoredItemId);
+        return;
+    }
+    dcf->deadbandValue = absDeadband;
+}
+
+#endif /* UA_ENABLE_DA */
+
+static UA_Boolean
+detectValueChange(UA_Server *server, UA_MonitoredItem *mon,
+                  const UA_DataValue *dv, UA_SampleHash *sh) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Status changes are always reported */
@@ -102,6 +234,13 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
     UA_assert(trigger == UA_DATACHANGETRIGGER_STATUSVALUE ||
               trigger == UA_DATACHANGETRIGGER_STATUSVALUETIMESTAMP);
 
+#ifdef UA_ENABLE_DA
+    /* Recompute the percent deadband after the EURange has changed */
+    if(dcf && mon->percentDeadband.euRangeGeneration != server->euRangeGeneration &&
+       !UA_NodeId_isNull(&mon->percentDeadband.euRangeId))
+        updatePercentDeadband(server, mon, (UA_DataChangeFilter*)(uintptr_t)dcf);
+#endif
+
     /* Test absolute deadband */
     if(dcf && dcf->deadbandType == UA_DEADBANDTYPE_ABSOLUTE &&
        dv->value.type != NULL && UA_DataType_isNumeric(dv->value.type))
@@ -120,25 +259,98 @@ detectValueChange(UA_Server *server, UA_MonitoredItem *mon, const UA_DataValue *
     /* Has the value changed? */
     if(dv->hasValue != mon->lastValue.hasValue)
         return true;
+
+    /* Only the hash of the last value is stored */
+    if(mon->lastValueHashed) {
+        if(!useValueHash(server, mon, dv) ||
+           getSampleHash(dv, sh) != UA_STATUSCODE_GOOD)
+            return true;
+        return (sh->hash != mon->lastValueHash);
+    }
+
     return !UA_equal(&dv->value, &mon->lastValue.value,
                      &UA_TYPES[UA_TYPES_VARIANT]);
 }
 
+void
+UA_MonitoredItem_clearLastValue(UA_MonitoredItem *mon) {
+    UA_DataValue_clear(&mon->lastValue);
+    if(mon->lastValueShared) {
+        UA_SharedSample_release(mon->lastValueShared);
+        mon->lastValueShared = NULL;
+    }
+    mon->lastValueHashed = false;
+}
+
+UA_SharedSample *
+UA_SharedSample_new(UA_DataValue *value) {
+    UA_SharedSample *ss = (UA_SharedSample*)UA_malloc(sizeof(UA_SharedSample));
+    if(!ss)
+        return NULL;
+    ss->refCount = 1;
+
+    /* Take a copy if the sample itself borrows the data */
+    if(value->value.storageType == UA_VARIANT_DATA_NODELETE) {
+        UA_StatusCode res = UA_DataValue_copy(value, &ss->value);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(ss);
+            return NULL;
+        }
+        UA_DataValue_clear(value);
+        return ss;
+    }
+
+    ss->value = *value;
+    UA_DataValue_init(value);
+    return ss;
+}
+
+void
+UA_SharedSample_borrow(UA_SharedSample *ss, UA_DataValue *dst) {
+    *dst = ss->value;
+    dst->value.storageType = UA_VARIANT_DATA_NODELETE;
+    ss->refCount++;
+}
+
+void
+UA_SharedSample_release(UA_SharedSample *ss) {
+    UA_assert(ss->refCount > 0);
+    ss->refCount--;
+    if(ss->refCount > 0)
+        return;
+    UA_DataValue_clear(&ss->value);
+    UA_free(ss);
+}
+
+void
+UA_SharedSampleRefs_clear(UA_SharedSampleRefs *refs) {
+    for(size_t i = 0; i < refs->samplesSize; i++)
+        UA_SharedSample_release(refs->samples[i]);
+    UA_free(refs->samples);
+    refs->samples = NULL;
+    refs->samplesSize = 0;
+}
+
 UA_StatusCode
 UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredItem *mon,
-                                              const UA_DataValue *dv) {
+                                              const UA_DataValue *dv,
+                                              UA_SharedSample *ss) {
     /* Allocate a new notification */
-    UA_Notification *newNot = UA_Notification_new();
+    UA_Notification *newNot = UA_MonitoredItem_newNotification(server, mon);
     if(!newNot)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Prepare the notification */
-    newNot->mon = mon;
     newNot->data.dataChange.clientHandle = mon->parameters.clientHandle;
-    UA_StatusCode retval = UA_DataValue_copy(dv, &newNot->data.dataChange.value);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_free(newNot);
-        return retval;
+    if(ss) {
+        UA_SharedSample_borrow(ss, &newNot->data.dataChange.value);
+        newNot->shared = ss;
+    } else {
+        UA_StatusCode retval = UA_DataValue_copy(dv, &newNot->data.dataChange.value);
+        if(retval != UA_STATUSCODE_GOOD) {
+            UA_Notification_delete(newNot);
+            return retval;
+        }
     }
 
     /* Enqueue the notification */
@@ -146,6 +358,117 @@ UA_MonitoredItem_createDataChangeNotification(UA_Server *server, UA_MonitoredIte
     return UA_STATUSCODE_GOOD;
 }
 
+/* Small pointer-free scalars are copied into the MonitoredItem for the next
+ * comparison. The MonitoredItem does not move in memory, so lastValue can
+ * point there. The sampled value itself is then moved into the notification
+ * instead of copied. Returns false if the value is not eligible. */
+static UA_Boolean
+storeInlineValue(UA_Server *server, UA_MonitoredItem *mon, UA_DataValue *value) {
+    const UA_Variant *v = &value->value;
+    if(!v->type || !v->type->pointerFree || !UA_Variant_isScalar(v) ||
+       v->type->memSize > sizeof(mon->lastValueInline) ||
+       v->storageType == UA_VARIANT_DATA_NODELETE)
+        return false;
+
+    UA_Notification *newNot = UA_MonitoredItem_newNotification(server, mon);
+    if(!newNot)
+        return false;
+
+    UA_MonitoredItem_clearLastValue(mon);
+    memcpy(mon->lastValueInline, v->data, v->type->memSize);
+    mon->lastValue = *value;
+    mon->lastValue.value.data = mon->lastValueInline;
+    mon->lastValue.value.storageType = UA_VARIANT_DATA_NODELETE;
+
+    newNot->data.dataChange.clientHandle = mon->parameters.clientHandle;
+    newNot->data.dataChange.value = *value;
+    UA_DataValue_init(value);
+    UA_Notification_enqueueAndTrigger(server, newNot);
+    return true;
+}
+
+/* Keep the value (or only its hash) for the next comparison. If ss is NULL,
+ * the value is moved into the MonitoredItem or freed. Otherwise the value of
+ * the SharedSample is borrowed. */
+static void
+storeLastValue(UA_Server *server, UA_MonitoredItem *mon, UA_DataValue *value,
+               UA_SharedSample *ss, UA_SampleHash *sh) {
+    /* Store only the hash and the metadata of large values */
+    UA_MonitoredItem_clearLastValue(mon);
+    if(useValueHash(server, mon, value) &&
+       getSampleHash(value, sh) == UA_STATUSCODE_GOOD) {
+        mon->lastValue = *value;
+        UA_Variant_init(&mon->lastValue.value);
+        mon->lastValueHash = sh->hash;
+        mon->lastValueHashed = true;
+        if(!ss)
+            UA_Variant_clear(&value->value);
+        return;
+    }
+
+    /* Move/borrow the value for filter comparison and TransferSubscription */
+    if(ss) {
+        UA_SharedSample_borrow(ss, &mon->lastValue);
+        mon->lastValueShared = ss;
+        return;
+    }
+    mon->lastValue = *value;
+}
+
+/* Call the callback of a local MonitoredItem in direct mode. Returns false if
+ * the MonitoredItem is not a direct one. */
+static UA_Boolean
+callDirectCallback(UA_Server *server, UA_MonitoredItem *mon,
+                   const UA_DataValue *value) {
+    if(mon->subscription != server->adminSubscription)
+        return false;
+    UA_LocalMonitoredItem *localMon = (UA_LocalMonitoredItem*)mon;
+    if(!localMon->direct)
+        return false;
+    if(mon->monitoringMode != UA_MONITORINGMODE_REPORTING)
+        return true;
+
+    void *nodeContext = NULL;
+    getNodeContext(server, mon->itemToMonitor.nodeId, &nodeContext);
+    localMon->callback.
+        dataChangeCallback(server, mon->monitoredItemId, localMon->context,
+                           &mon->itemToMonitor.nodeId, nodeContext,
+                           mon->itemToMonitor.attributeId, value);
+    return true;
+}
+
+/* Enqueue a notification for a changed value and keep the value (or only its
+ * hash) for the next comparison. If ss is NULL, the value is moved into the
+ * MonitoredItem or freed. Otherwise the value of the SharedSample is
+ * borrowed. */
+static void
+storeChangedValue(UA_Server *server, UA_MonitoredItem *mon, UA_DataValue *value,
+                  UA_SharedSample *ss, UA_SampleHash *sh) {
+    /* Direct local MonitoredItems skip the Notification */
+    if(callDirectCallback(server, mon, value)) {
+        storeLastValue(server, mon, value, ss, sh);
+        return;
+    }
+
+    if(!ss && storeInlineValue(server, mon, value))
+        return;
+
+    /* Prepare a notification and enqueue it */
+    UA_StatusCode res =
+        UA_MonitoredItem_createDataChangeNotification(server, mon, value, ss);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                    "MonitoredItem %" PRIi32 " | "
+                                    "Processing the sample returned the statuscode %s",
+                                    mon->monitoredItemId, UA_StatusCode_name(res));
+        if(!ss)
+            UA_DataValue_clear(value);
+        return;
+    }
+
+    storeLastValue(server, mon, value, ss, sh);
+}
+
 void
 UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
                                      UA_DataValue *value) {
@@ -153,7 +476,8 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Has the value changed (with the filters applied)? */
-    UA_Boolean changed = detectValueChange(server, mon, value);
+    UA_SampleHash sh = {false, UA_STATUSCODE_GOOD, 0};
+    UA_Boolean changed = detectValueChange(server, mon, value, &sh);
     if(!changed) {
         UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
                                   "MonitoredItem %" PRIi32 " | "
@@ -162,21 +486,24 @@ UA_MonitoredItem_processSampledValue(UA_Server *server, UA_MonitoredItem *mon,
         return;
     }
 
-    /* Prepare a notification and enqueue it */
-    UA_StatusCode res =
-        UA_MonitoredItem_createDataChangeNotification(server, mon, value);
-    if(res != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING_SUBSCRIPTION(server->config.logging, mon->subscription,
-                                    "MonitoredItem %" PRIi32 " | "
-                                    "Processing the sample returned the statuscode %s",
-                                    mon->monitoredItemId, UA_StatusCode_name(res));
-        UA_DataValue_clear(value);
+    storeChangedValue(server, mon, value, NULL, &sh);
+}
+
+void
+UA_MonitoredItem_processSharedSample(UA_Server *server, UA_MonitoredItem *mon,
+                                     UA_SharedSample *ss, UA_SampleHash *sh) {
+    UA_assert(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER);
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    /* Has the value changed (with the filters applied)? */
+    if(!detectValueChange(server, mon, &ss->value, sh)) {
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, mon->subscription,
+                                  "MonitoredItem %" PRIi32 " | "
+                                  "The value has not changed", mon->monitoredItemId);
         return;
     }
 
-    /* Move/store the value for filter comparison and TransferSubscription */
-    UA_DataValue_clear(&mon->lastValue);
-    mon->lastValue = *value;
+    storeChangedValue(server, mon, &ss->value, ss, sh);
 }
 
 void
@@ -194,14 +521,82 @@ monitoredItem_sampleCallback(UA_Server *server, UA_MonitoredItem *mon) {
     UA_Subscription *sub = mon->subscription;
     UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub, "MonitoredItem %" PRIi32
                               " | Sample callback called", mon->monitoredItemId);
+    server->counterStatistics.samplingCount++;
+    UA_ALLOCPHASE_BEGIN(UA_ALLOCPHASE_SAMPLING);
 
     /* Sample the current value */
     UA_Session *session = (sub) ? sub->session : &server->adminSession;
-    UA_DataValue dv = readWithSession(server, session, &mon->itemToMonitor,
-                                      mon->timestampsToReturn);
+    UA_DataValue dv =
+        readWithSessionMaxAge(server, session, &mon->itemToMonitor,
+                              mon->timestampsToReturn,
+                              server->config.samplingCacheMaxAge);
 
     /* Process the sample. This always clears the value. */
     UA_MonitoredItem_processSampledValue(server, mon, &dv);
+    UA_ALLOCPHASE_END();
+}
+
+void
+UA_SamplingGroup_sampleCallback(UA_Server *server, UA_SamplingGroup *sg) {
+    UA_LOCK(&server->serviceMutex);
+
+    /* The group was removed while the callback was pending. Or the value has
+     * not changed with event-driven sampling. */
+    if(LIST_EMPTY(&sg->monitoredItems) || (sg->attached && !sg->dirty)) {
+        UA_UNLOCK(&server->serviceMutex);
+        return;
+    }
+    sg->dirty = false;
+    server->counterStatistics.samplingCount++;
+    UA_ALLOCPHASE_BEGIN(UA_ALLOCPHASE_SAMPLING);
+
+    /* Sample the current value once for all MonitoredItems */
+    UA_DataValue dv =
+        readWithSessionMaxAge(server, &server->adminSession,
+                              &sg->key.itemToMonitor, sg->key.timestampsToReturn,
+                              server->config.samplingCacheMaxAge);
+
+    /* The node for the access checks of the individual sessions */
+    const UA_Node *node =
+        UA_NODESTORE_GET_SELECTIVE(server, &sg->key.itemToMonitor.nodeId,
+                                   UA_NODEATTRIBUTESMASK_ACCESSLEVEL,
+                                   UA_REFERENCETYPESET_NONE,
+                                   UA_BROWSEDIRECTION_INVALID);
+
+    /* The value is shared by the notifications of all MonitoredItems. Sample
+     * individually if that is not possible. */
+    UA_SharedSample *ss = UA_SharedSample_new(&dv);
+    if(!ss)
+        UA_DataValue_clear(&dv);
+
+    /* The content hash is computed once for all MonitoredItems */
+    UA_SampleHash sh = {false, UA_STATUSCODE_GOOD, 0};
+
+    UA_MonitoredItem *mon, *mon_tmp;
+    LIST_FOREACH_SAFE(mon, &sg->monitoredItems, sampling.grouped.groupEntry, mon_tmp) {
+        UA_Subscription *sub = mon->subscription;
+        UA_LOG_DEBUG_SUBSCRIPTION(server->config.logging, sub, "MonitoredItem %"
+                                  PRIi32 " | Sample callback called",
+                                  mon->monitoredItemId);
+
+        /* Read individually to get the exact result if the session has no
+         * access */
+        UA_Session *session = (sub) ? sub->session : &server->adminSession;
+        if(!ss || (node && session != &server->adminSession &&
+                   checkReadValueAccess(server, session, node) != UA_STATUSCODE_GOOD)) {
+            monitoredItem_sampleCallback(server, mon);
+            continue;
+        }
+
+        UA_MonitoredItem_processSharedSample(server, mon, ss, &sh);
+    }
+
+    if(node)
+        UA_NODESTORE_RELEASE(server, node);
+    if(ss)
+        UA_SharedSample_release(ss);
+    UA_ALLOCPHASE_END();
+    UA_UNLOCK(&server->serviceMutex);
 }
 
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
@@ -9,23 +9,25 @@
 
 #include "ua_server_internal.h"
 #include "ua_subscription.h"
+#include "ua_types_encoding_binary.h"
+#include "mp_printf.h"
+
+#include <stdlib.h> /* qsort */
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
 
 /* We use a 16-Byte ByteString as an identifier */
 UA_StatusCode
-generateEventId(UA_ByteString *generatedId) {
+generateEventId(UA_Server *server, UA_ByteString *generatedId) {
     /* EventId is a ByteString, which is basically just a string
      * We will use a 16-Byte ByteString as an identifier */
     UA_StatusCode res = UA_ByteString_allocBuffer(generatedId, 16 * sizeof(UA_Byte));
     if(res != UA_STATUSCODE_GOOD)
         return res;
-    UA_UInt32 *ids = (UA_UInt32*)generatedId->data;
-    ids[0] = UA_UInt32_random();
-    ids[1] = UA_UInt32_random();
-    ids[2] = UA_UInt32_random();
-    ids[3] = UA_UInt32_random();
-    return UA_STATUSCODE_GOOD;
+    res = getRandomBytes(server, generatedId->data, generatedId->length);
+    if(res != UA_STATUSCODE_GOOD)
+        UA_ByteString_clear(generatedId);
+    return res;
 }
 
 UA_StatusCode
@@ -144,7 +146,7 @@ eventSetStandardFields(UA_Server *server, const UA_NodeId *event,
 
     /* Set the EventId */
     UA_ByteString eventId = UA_BYTESTRING_NULL;
-    retval = generateEventId(&eventId);
+    retval = generateEventId(server, &eventId);
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
     name = UA_QUALIFIEDNAME(0, "EventId");
@@ -177,15 +179,19 @@ eventSetStandardFields(UA_Server *server, const UA_NodeId *event,
  * mons notification queue */
 UA_StatusCode
 UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
-                          const UA_NodeId *event) {
+                          const UA_NodeId *event, UA_EventCache *cache) {
     /* Get the filter */
     if(mon->parameters.filter.content.decoded.type != &UA_TYPES[UA_TYPES_EVENTFILTER])
         return UA_STATUSCODE_BADFILTERNOTALLOWED;
     UA_EventFilter *eventFilter = (UA_EventFilter*)
         mon->parameters.filter.content.decoded.data;
 
+    /* Skip before allocating the notification if the EventType cannot match */
+    if(cache && !whereClauseMayMatch(server, cache, event, &eventFilter->whereClause))
+        return UA_STATUSCODE_GOOD;
+
     /* Allocate memory for the notification */
-    UA_Notification *notification = UA_Notification_new();
+    UA_Notification *notification = UA_MonitoredItem_newNotification(server, mon);
     if(!notification)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
@@ -195,12 +201,10 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     UA_Subscription *sub = mon->subscription;
     UA_Session *session = sub->session;
 
-    UA_EventFilterResult res; /* FilterResult contains only statuscodes. Ignored
-                               * outside the initial setup/validation. */
-    UA_EventFilterResult_init(&res);
-    UA_StatusCode retval = filterEvent(server, session, event, eventFilter,
-                                       &notification->data.event, &res);
-    UA_EventFilterResult_clear(&res);
+    /* The FilterResult contains only statuscodes. It is ignored outside the
+     * initial setup/validation. */
+    UA_StatusCode retval = filterEvent(server, session, event, eventFilter, cache,
+                                       &notification->data.event, NULL);
     if(retval != UA_STATUSCODE_GOOD) {
         UA_Notification_delete(notification);
         if(retval == UA_STATUSCODE_BADNOMATCH)
@@ -209,7 +213,12 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
     }
 
     notification->data.event.clientHandle = mon->parameters.clientHandle;
-    notification->mon = mon;
+
+    /* Keep the shared event fields alive while the notification borrows them */
+    if(cache && cache->selected) {
+        notification->shared = cache->selected;
+        notification->shared->refCount++;
+    }
 
     UA_Notification_enqueueAndTrigger(server, notification);
     return UA_STATUSCODE_GOOD;
@@ -218,7 +227,8 @@ UA_MonitoredItem_addEvent(UA_Server *server, UA_MonitoredItem *mon,
 #ifdef UA_ENABLE_HISTORIZING
 static void
 setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
-                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId) {
+                   const UA_NodeId *emitNodeId, const UA_NodeId *eventNodeId,
+                   UA_EventCache *cache) {
     UA_Variant historicalEventFilterValue;
     UA_Variant_init(&historicalEventFilterValue);
 
@@ -252,7 +262,8 @@ setHistoricalEvent(UA_Server *server, const UA_NodeId *origin,
     UA_EventFilter *filter = (UA_EventFilter*) historicalEventFilterValue.data;
     UA_EventFieldList efl;
     UA_EventFilterResult result;
-    retval = filterEvent(server, &server->adminSession, eventNodeId, filter, &efl, &result);
+    retval = filterEvent(server, &server->adminSession, eventNodeId, filter,
+                         cache, &efl, &result);
     if(retval == UA_STATUSCODE_GOOD)
         server->config.historyDatabase.setEvent(server, server->config.historyDatabase.context,
                                                 origin, emitNodeId, filter, &efl);
@@ -274,31 +285,11 @@ static const UA_NodeId isInFolderReferences[2] =
     {{0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_ORGANIZES}},
      {0, UA_NODEIDTYPE_NUMERIC, {UA_NS0ID_HASCOMPONENT}}};
 
-UA_StatusCode
-triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
-             const UA_NodeId origin, UA_ByteString *outEventId,
-             const UA_Boolean deleteEventNode) {
-    UA_LOCK_ASSERT(&server->serviceMutex, 1);
-
-    UA_LOG_NODEID_DEBUG(&origin,
-        UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
-            "Events: An event is triggered on node %.*s",
-            (int)nodeIdStr.length, nodeIdStr.data));
-
-#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
-    UA_Boolean isCallerAC = false;
-    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
-        if(!isCallerAC) {
-          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
-                                  UA_STATUSCODE_BADINVALIDARGUMENT);
-          return UA_STATUSCODE_BADINVALIDARGUMENT;
-        }
-    }
-#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
-
+/* The origin must exist and be in the ObjectsFolder */
+static UA_StatusCode
+checkEventOrigin(UA_Server *server, const UA_NodeId *origin) {
     /* Check that the origin node exists */
-    const UA_Node *originNode = UA_NODESTORE_GET(server, &origin);
+    const UA_Node *originNode = UA_NODESTORE_GET(server, origin);
     if(!originNode) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Origin node for event does not exist.");
@@ -322,20 +313,20 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         refTypes = UA_ReferenceTypeSet_union(refTypes, tmpRefTypes);
     }
 
-    if(!isNodeInTree(server, &origin, &objectsFolderId, &refTypes)) {
+    if(!isNodeInTree(server, origin, &objectsFolderId, &refTypes)) {
         UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
                      "Node for event must be in ObjectsFolder!");
         return UA_STATUSCODE_BADINVALIDARGUMENT;
     }
+    return UA_STATUSCODE_GOOD;
+}
 
-    /* Update the standard fields of the event */
-    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
-    if(retval != UA_STATUSCODE_GOOD) {
-        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "Events: Could not set the standard event fields with StatusCode %s",
-                       UA_StatusCode_name(retval));
-        return retval;
-    }
+/* Add the event to the MonitoredItems of the origin and of all nodes the
+ * event propagates to. The cache is shared for all MonitoredItems. */
+static UA_StatusCode
+emitEvent(UA_Server *server, const UA_NodeId *eventNodeId,
+          const UA_NodeId *origin, UA_EventCache *cache) {
+    UA_StatusCode retval;
 
     /* List of nodes that emit the node. Events propagate upwards (bubble up) in
      * the node hierarchy. */
@@ -350,7 +341,7 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
      * a Server and as such has implied HasEventSource References to every event
      * source in a Server. */
     UA_NodeId emitStartNodes[2];
-    emitStartNodes[0] = origin;
+    emitStartNodes[0] = *origin;
     emitStartNodes[1] = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
 
     /* Get all ReferenceTypes over which the events propagate */
@@ -398,7 +389,7 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
             /* Is this an Event-MonitoredItem? */
             if(mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER)
                 continue;
-            retval = UA_MonitoredItem_addEvent(server, mon, &eventNodeId);
+            retval = UA_MonitoredItem_addEvent(server, mon, eventNodeId, cache);
             if(retval != UA_STATUSCODE_GOOD) {
                 UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
                                "Events: Could not add the event to a listening "
@@ -412,10 +403,63 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         /* Add event entry in the historical database */
 #ifdef UA_ENABLE_HISTORIZING
         if(server->config.historyDatabase.setEvent)
-            setHistoricalEvent(server, &origin, &emitNodes[i].nodeId, &eventNodeId);
+            setHistoricalEvent(server, origin, &emitNodes[i].nodeId,
+                               eventNodeId, cache);
 #endif
     }
 
+ cleanup:
+    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    return retval;
+}
+
+UA_StatusCode
+triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
+             const UA_NodeId origin, UA_ByteString *outEventId,
+             const UA_Boolean deleteEventNode) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    UA_LOG_NODEID_DEBUG(&origin,
+        UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+            "Events: An event is triggered on node %.*s",
+            (int)nodeIdStr.length, nodeIdStr.data));
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    UA_Boolean isCallerAC = false;
+    if(isConditionOrBranch(server, &eventNodeId, &origin, &isCallerAC)) {
+        if(!isCallerAC) {
+          UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                                 "Condition Events: Please use A&C API to trigger Condition Events 0x%08X",
+                                  UA_STATUSCODE_BADINVALIDARGUMENT);
+          return UA_STATUSCODE_BADINVALIDARGUMENT;
+        }
+    }
+#endif /* UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS */
+
+
+    UA_StatusCode retval = checkEventOrigin(server, &origin);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Update the standard fields of the event */
+    retval = eventSetStandardFields(server, &eventNodeId, &origin, outEventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Events: Could not set the standard event fields with StatusCode %s",
+                       UA_StatusCode_name(retval));
+        return retval;
+    }
+
+    /* Add the event to the listening MonitoredItems. The resolved event fields
+     * are cached for all MonitoredItems. */
+    UA_EventCache cache;
+    UA_EventCache_init(&cache);
+    cache.shareFields = true;
+    retval = emitEvent(server, &eventNodeId, &origin, &cache);
+    UA_EventCache_clear(&cache);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
     /* Delete the node representation of the event */
     if(deleteEventNode) {
         retval = deleteNode(server, eventNodeId, true);
@@ -426,8 +470,6 @@ triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
         }
     }
 
- cleanup:
-    UA_Array_delete(emitNodes, emitNodesSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
     return retval;
 }
 
@@ -441,4 +483,362 @@ UA_Server_triggerEvent(UA_Server *server, const UA_NodeId eventNodeId,
     UA_UNLOCK(&server->serviceMutex);
     return res;
 }
+
+#define EVENTFIELDS_STANDARD 5
+
+UA_StatusCode
+triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                   const UA_NodeId origin, const UA_KeyValueMap *eventFields,
+                   UA_ByteString *outEventId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    /* Make sure the eventType is a subtype of BaseEventType. Conditions have
+     * a state and always need a node representation. */
+    UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
+    if(!isNodeInTree_singleRef(server, &eventType, &baseEventTypeId,
+                               UA_REFERENCETYPEINDEX_HASSUBTYPE) ||
+       isNodeInTree_singleRef(server, &eventType, &conditionTypeId,
+                              UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
+        UA_LOG_ERROR(server->config.logging, UA_LOGCATEGORY_USERLAND,
+                     "Event type must be a subtype of BaseEventType "
+                     "and not a ConditionType!");
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    }
+
+    UA_StatusCode retval = checkEventOrigin(server, &origin);
+    if(retval != UA_STATUSCODE_GOOD)
+        return retval;
+
+    /* Prepend the standard fields. They take precedence over the user-defined
+     * fields as the first match is used. The Time is appended and used only if
+     * not defined by the user. The map is a shallow copy. */
+    size_t userFieldsSize = (eventFields) ? eventFields->mapSize : 0;
+    UA_KeyValuePair *fields = (UA_KeyValuePair*)
+        UA_malloc(sizeof(UA_KeyValuePair) * (EVENTFIELDS_STANDARD + userFieldsSize));
+    if(!fields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    retval = generateEventId(server, &eventId);
+    if(retval != UA_STATUSCODE_GOOD) {
+        UA_free(fields);
+        return retval;
+    }
+
+    UA_EventLoop *el = server->config.eventLoop;
+    UA_DateTime now = el->dateTime_now(el);
+    fields[0].key = UA_QUALIFIEDNAME(0, "EventId");
+    UA_Variant_setScalar(&fields[0].value, &eventId, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "EventType");
+    UA_Variant_setScalar(&fields[1].value, (void*)(uintptr_t)&eventType,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    fields[2].key = UA_QUALIFIEDNAME(0, "SourceNode");
+    UA_Variant_setScalar(&fields[2].value, (void*)(uintptr_t)&origin,
+                         &UA_TYPES[UA_TYPES_NODEID]);
+    fields[3].key = UA_QUALIFIEDNAME(0, "ReceiveTime");
+    UA_Variant_setScalar(&fields[3].value, &now, &UA_TYPES[UA_TYPES_DATETIME]);
+    for(size_t i = 0; i < userFieldsSize; i++)
+        fields[EVENTFIELDS_STANDARD - 1 + i] = eventFields->map[i];
+    fields[EVENTFIELDS_STANDARD - 1 + userFieldsSize].key = UA_QUALIFIEDNAME(0, "Time");
+    UA_Variant_setScalar(&fields[EVENTFIELDS_STANDARD - 1 + userFieldsSize].value,
+                         &now, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_KeyValueMap fieldMap = {EVENTFIELDS_STANDARD + userFieldsSize, fields};
+
+    /* The cache resolves the select-clauses from the map. Without an event
+     * node, the EventType is known upfront. */
+    UA_EventCache cache;
+    UA_EventCache_init(&cache);
+    cache.fields = &fieldMap;
+    cache.shareFields = true;
+    cache.eventTypeResolved = true;
+    cache.eventTypeStatus = UA_STATUSCODE_GOOD;
+    cache.eventType = eventType; /* Shallow copy, not cleaned up */
+    retval = emitEvent(server, &UA_NODEID_NULL, &origin, &cache);
+    UA_NodeId_init(&cache.eventType);
+    UA_EventCache_clear(&cache);
+    UA_free(fields);
+
+    /* Return the EventId */
+    if(outEventId && retval == UA_STATUSCODE_GOOD)
+        *outEventId = eventId;
+    else
+        UA_ByteString_clear(&eventId);
+    return retval;
+}
+
+UA_StatusCode
+UA_Server_triggerEventFields(UA_Server *server, const UA_NodeId eventType,
+                             const UA_NodeId originId,
+                             const UA_KeyValueMap *eventFields,
+                             UA_ByteString *outEventId) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res =
+        triggerEventFields(server, eventType, originId, eventFields, outEventId);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+UA_StatusCode
+UA_Server_filterEventFields(UA_Server *server, const UA_NodeId eventType,
+                            const UA_KeyValueMap *eventFields,
+                            const UA_EventFilter *filter,
+                            UA_EventFieldList *efl) {
+    UA_KeyValueMap emptyFields = UA_KEYVALUEMAP_NULL;
+    UA_EventCache cache;
+    UA_EventCache_init(&cache);
+    cache.fields = (eventFields) ? eventFields : &emptyFields;
+    cache.eventTypeResolved = true;
+    cache.eventTypeStatus = UA_STATUSCODE_GOOD;
+    cache.eventType = eventType; /* Shallow copy, not cleaned up */
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res =
+        filterEvent(server, &server->adminSession, &UA_NODEID_NULL,
+                    (UA_EventFilter*)(uintptr_t)filter, &cache, efl, NULL);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_NodeId_init(&cache.eventType);
+    UA_EventCache_clear(&cache);
+    return res;
+}
+
+/*****************/
+/* Model Changes */
+/*****************/
+
+/* ModelChangeStructureDataType is not part of every generated type set. Encode
+ * the structure manually: Affected, AffectedType, Verb. */
+static UA_StatusCode
+encodeModelChange(const UA_ModelChange *mc, UA_ExtensionObject *eo) {
+    UA_ByteString *body = &eo->content.encoded.body;
+    size_t size = UA_calcSizeBinary(&mc->affected, &UA_TYPES[UA_TYPES_NODEID]) +
+        UA_calcSizeBinary(&mc->affectedType, &UA_TYPES[UA_TYPES_NODEID]) + 1;
+    UA_StatusCode res = UA_ByteString_allocBuffer(body, size);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    UA_Byte *pos = body->data;
+    const UA_Byte *end = &body->data[size];
+    res |= UA_encodeBinaryInternal(&mc->affected, &UA_TYPES[UA_TYPES_NODEID],
+                                   &pos, &end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&mc->affectedType, &UA_TYPES[UA_TYPES_NODEID],
+                                   &pos, &end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&mc->verb, &UA_TYPES[UA_TYPES_BYTE],
+                                   &pos, &end, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_ByteString_clear(body);
+        return res;
+    }
+    eo->encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
+    eo->content.encoded.typeId = UA_NODEID_NUMERIC(0,
+        UA_NS0ID_MODELCHANGESTRUCTUREDATATYPE_ENCODING_DEFAULTBINARY);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The NodeVersion property is optional. If present, the String contains a
+ * decimal counter. */
+static void
+incrementNodeVersion(UA_Server *server, const UA_NodeId *nodeId) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY);
+    rpe.targetName = UA_QUALIFIEDNAME(0, "NodeVersion");
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = *nodeId;
+    bp.relativePath.elementsSize = 1;
+    bp.relativePath.elements = &rpe;
+    UA_BrowsePathResult bpr = translateBrowsePathToNodeIds(server, &bp);
+    if(bpr.statusCode != UA_STATUSCODE_GOOD || bpr.targetsSize < 1) {
+        UA_BrowsePathResult_clear(&bpr);
+        return;
+    }
+    const UA_NodeId *versionId = &bpr.targets[0].targetId.nodeId;
+
+    UA_UInt32 version = 0;
+    UA_Variant v;
+    UA_Variant_init(&v);
+    readWithReadValue(server, versionId, UA_ATTRIBUTEID_VALUE, &v);
+    if(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_STRING])) {
+        const UA_String *s = (const UA_String*)v.data;
+        for(size_t i = 0; i < s->length && s->data[i] >= '0' && s->data[i] <= '9'; i++)
+            version = (version * 10) + (UA_UInt32)(s->data[i] - '0');
+    }
+    UA_Variant_clear(&v);
+
+    char buf[16];
+    UA_String newVersion;
+    newVersion.data = (UA_Byte*)buf;
+    newVersion.length = (size_t)mp_snprintf(buf, sizeof(buf), "%u", version + 1);
+    UA_Variant_setScalar(&v, &newVersion, &UA_TYPES[UA_TYPES_STRING]);
+    writeValueAttribute(server, *versionId, &v);
+    UA_BrowsePathResult_clear(&bpr);
+}
+
+static int
+cmpModelChange(const void *a, const void *b) {
+    const UA_ModelChange *ma = (const UA_ModelChange*)a;
+    const UA_ModelChange *mb = (const UA_ModelChange*)b;
+    return (int)UA_NodeId_order(&ma->affected, &mb->affected);
+}
+
+static void
+emitModelChangeEvent(UA_Server *server, void *_) {
+    UA_LOCK(&server->serviceMutex);
+    server->modelChangeCallbackId = 0;
+
+    /* Take the pending changes. Writing the NodeVersion does not add new
+     * changes. */
+    UA_ModelChange *changes = server->modelChanges;
+    size_t changesSize = server->modelChangesSize;
+    server->modelChanges = NULL;
+    server->modelChangesSize = 0;
+    server->modelChangesCapacity = 0;
+    if(changesSize == 0)
+        goto cleanup;
+
+    /* Merge all changes of the same node */
+    qsort(changes, changesSize, sizeof(UA_ModelChange), cmpModelChange);
+    size_t merged = 0;
+    for(size_t i = 1; i < changesSize; i++) {
+        UA_ModelChange *last = &changes[merged];
+        if(UA_NodeId_equal(&last->affected, &changes[i].affected)) {
+            last->verb |= changes[i].verb;
+            if(UA_NodeId_isNull(&last->affectedType)) {
+                last->affectedType = changes[i].affectedType;
+                UA_NodeId_init(&changes[i].affectedType);
+            }
+            UA_NodeId_clear(&changes[i].affected);
+            UA_NodeId_clear(&changes[i].affectedType);
+            continue;
+        }
+        changes[++merged] = changes[i];
+    }
+    changesSize = merged + 1;
+
+    /* Increment the NodeVersion once per node. Deleted nodes have none. */
+    for(size_t i = 0; i < changesSize; i++) {
+        if(!(changes[i].verb & UA_MODELCHANGEVERB_NODEDELETED))
+            incrementNodeVersion(server, &changes[i].affected);
+    }
+
+    /* The ModelChangeEvent types are not part of the reduced namespace zero */
+    UA_NodeId eventType = UA_NODEID_NUMERIC(0, UA_NS0ID_GENERALMODELCHANGEEVENTTYPE);
+    const UA_Node *eventTypeNode = UA_NODESTORE_GET(server, &eventType);
+    if(!eventTypeNode) {
+        UA_LOG_DEBUG(server->config.logging, UA_LOGCATEGORY_SERVER,
+                     "No GeneralModelChangeEventType in the information model");
+        goto cleanup;
+    }
+    UA_NODESTORE_RELEASE(server, eventTypeNode);
+
+    /* Too many changes for the list. Clients have to assume that anything
+     * could have changed. */
+    UA_NodeId origin = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    if(server->config.maxModelChangesPerEvent > 0 &&
+       changesSize > server->config.maxModelChangesPerEvent) {
+        triggerEventFields(server, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE),
+                           origin, NULL, NULL);
+        goto cleanup;
+    }
+
+    UA_ExtensionObject *eos = (UA_ExtensionObject*)
+        UA_Array_new(changesSize, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    if(!eos) {
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Cannot allocate the GeneralModelChangeEvent");
+        goto cleanup;
+    }
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    for(size_t i = 0; i < changesSize && res == UA_STATUSCODE_GOOD; i++)
+        res = encodeModelChange(&changes[i], &eos[i]);
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_KeyValuePair field;
+        field.key = UA_QUALIFIEDNAME(0, "Changes");
+        UA_Variant_setArray(&field.value, eos, changesSize,
+                            &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+        UA_KeyValueMap fields = {1, &field};
+        res = triggerEventFields(server, eventType, origin, &fields, NULL);
+    }
+    if(res != UA_STATUSCODE_GOOD)
+        UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                       "Could not emit the GeneralModelChangeEvent with "
+                       "StatusCode %s", UA_StatusCode_name(res));
+    UA_Array_delete(eos, changesSize, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+
+ cleanup:
+    for(size_t i = 0; i < changesSize; i++) {
+        UA_NodeId_clear(&changes[i].affected);
+        UA_NodeId_clear(&changes[i].affectedType);
+    }
+    UA_free(changes);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+void
+addModelChange(UA_Server *server, const UA_NodeId *affected,
+               const UA_NodeId *affectedType, UA_Byte verb) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(server->state != UA_LIFECYCLESTATE_STARTED ||
+       server->config.modelChangeEventInterval <= 0.0)
+        return;
+
+    /* Consecutive changes of the same node are merged right away. This is the
+     * common case when a node is added together with its references. */
+    if(server->modelChangesSize > 0) {
+        UA_ModelChange *last = &server->modelChanges[server->modelChangesSize - 1];
+        if(UA_NodeId_equal(&last->affected, affected)) {
+            last->verb |= verb;
+            if(affectedType && UA_NodeId_isNull(&last->affectedType))
+                UA_NodeId_copy(affectedType, &last->affectedType);
+            return;
+        }
+    }
+
+    /* Grow the array */
+    if(server->modelChangesSize == server->modelChangesCapacity) {
+        size_t newCapacity = (server->modelChangesCapacity > 0) ?
+            server->modelChangesCapacity * 2 : 16;
+        UA_ModelChange *newChanges = (UA_ModelChange*)
+            UA_realloc(server->modelChanges, newCapacity * sizeof(UA_ModelChange));
+        if(!newChanges)
+            return;
+        server->modelChanges = newChanges;
+        server->modelChangesCapacity = newCapacity;
+    }
+
+    UA_ModelChange *mc = &server->modelChanges[server->modelChangesSize];
+    UA_NodeId_init(&mc->affectedType);
+    if(UA_NodeId_copy(affected, &mc->affected) != UA_STATUSCODE_GOOD)
+        return;
+    if(affectedType)
+        UA_NodeId_copy(affectedType, &mc->affectedType);
+    mc->verb = verb;
+    server->modelChangesSize++;
+
+    /* Schedule the event for the end of the interval */
+    if(server->modelChangeCallbackId == 0) {
+        UA_EventLoop *el = server->config.eventLoop;
+        UA_DateTime date = el->dateTime_nowMonotonic(el) +
+            (UA_DateTime)(server->config.modelChangeEventInterval * UA_DATETIME_MSEC);
+        el->addTimedCallback(el, (UA_Callback)emitModelChangeEvent, server, NULL,
+                             date, &server->modelChangeCallbackId);
+    }
+}
+
+void
+clearModelChanges(UA_Server *server) {
+    if(server->modelChangeCallbackId != 0) {
+        UA_EventLoop *el = server->config.eventLoop;
+        el->removeCyclicCallback(el, server->modelChangeCallbackId);
+        server->modelChangeCallbackId = 0;
+    }
+    for(size_t i = 0; i < server->modelChangesSize; i++) {
+        UA_NodeId_clear(&server->modelChanges[i].affected);
+        UA_NodeId_clear(&server->modelChanges[i].affectedType);
+    }
+    UA_free(server->modelChanges);
+    server->modelChanges = NULL;
+    server->modelChangesSize = 0;
+    server->modelChangesCapacity = 0;
+}
+
 #endif /* UA_ENABLE_SUBSCRIPTIONS_EVENTS */
@@ -454,7 +454,8 @@ typedef struct {
     UA_Session *session;
     const UA_NodeId *eventNode;
     const UA_ContentFilter *filter;
-    UA_ContentFilterResult *filterResult;
+    UA_ContentFilterResult *filterResult; /* Can be NULL */
+    UA_EventCache *cache;
     UA_Variant results[UA_EVENTFILTER_MAXELEMENTS];
 
     /* The stack contains temporary variants. Cleaned up after the evaluation of
@@ -463,17 +464,174 @@ typedef struct {
     UA_Variant stack[UA_EVENTFILTER_MAXOPERANDS];
 } UA_FilterEvalContext;
 
+/* Event Cache
+ * ~~~~~~~~~~~
+ * The same fields of an event are often used by several MonitoredItems and
+ * clauses. Every browse path is resolved only once per event. */
+
+void
+UA_EventCache_init(UA_EventCache *cache) {
+    memset(cache, 0, sizeof(UA_EventCache));
+}
+
+void
+UA_EventCache_clear(UA_EventCache *cache) {
+    UA_NodeId_clear(&cache->eventType);
+    for(size_t i = 0; i < cache->pathsSize; i++)
+        UA_NodeId_clear(&cache->paths[i].target);
+    /* The notifications hold their own reference */
+    if(cache->selected)
+        UA_SharedSample_release(cache->selected);
+    UA_EventCache_init(cache);
+}
+
+static UA_Boolean
+browsePathEqual(size_t aSize, const UA_QualifiedName *a,
+                size_t bSize, const UA_QualifiedName *b) {
+    if(aSize != bSize)
+        return false;
+    if(a == b)
+        return true;
+    for(size_t i = 0; i < aSize; i++) {
+        if(!UA_QualifiedName_equal(&a[i], &b[i]))
+            return false;
+    }
+    return true;
+}
+
+/* Resolve the browse path, starting from the event-source. The target points
+ * either into the cache or to the scratch NodeId. The scratch NodeId has to be
+ * cleared by the caller. */
+static UA_StatusCode
+resolveBrowsePath(UA_Server *server, UA_EventCache *cache, const UA_NodeId *origin,
+                  size_t browsePathSize, const UA_QualifiedName *browsePath,
+                  UA_NodeId *scratch, const UA_NodeId **target) {
+    /* Already resolved for this event? */
+    for(size_t i = 0; i < cache->pathsSize; i++) {
+        if(!browsePathEqual(cache->paths[i].browsePathSize, cache->paths[i].browsePath,
+                            browsePathSize, browsePath))
+            continue;
+        *target = &cache->paths[i].target;
+        return cache->paths[i].status;
+    }
+
+    UA_BrowsePathResult bpr =
+        browseSimplifiedBrowsePath(server, *origin, browsePathSize, browsePath);
+    if(bpr.targetsSize == 0 && bpr.statusCode == UA_STATUSCODE_GOOD)
+        bpr.statusCode = UA_STATUSCODE_BADNOTFOUND;
+
+    /* Use the first match. Move the NodeId out of the result. */
+    UA_StatusCode res = bpr.statusCode;
+    UA_NodeId found = UA_NODEID_NULL;
+    if(res == UA_STATUSCODE_GOOD) {
+        found = bpr.targets[0].targetId.nodeId;
+        UA_NodeId_init(&bpr.targets[0].targetId.nodeId);
+    }
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* The cache is full */
+    if(cache->pathsSize == UA_EVENTCACHE_MAXPATHS) {
+        *scratch = found;
+        *target = scratch;
+        return res;
+    }
+
+    /* Store in the cache. Also failed lookups. */
+    cache->paths[cache->pathsSize].browsePathSize = browsePathSize;
+    cache->paths[cache->pathsSize].browsePath = browsePath;
+    cache->paths[cache->pathsSize].status = res;
+    cache->paths[cache->pathsSize].target = found;
+    *target = &cache->paths[cache->pathsSize].target;
+    cache->pathsSize++;
+    return res;
+}
+
+/* Get the EventType of the event node */
+static UA_StatusCode
+getEventType(UA_Server *server, UA_EventCache *cache, const UA_NodeId *eventNode,
+             const UA_NodeId **eventType) {
+    if(!cache->eventTypeResolved) {
+        cache->eventTypeResolved = true;
+        UA_Variant v;
+        UA_Variant_init(&v);
+        cache->eventTypeStatus =
+            readObjectProperty(server, *eventNode,
+                               UA_QUALIFIEDNAME(0, "EventType"), &v);
+        if(cache->eventTypeStatus == UA_STATUSCODE_GOOD) {
+            if(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_NODEID])) {
+                cache->eventType = *(UA_NodeId*)v.data;
+                UA_NodeId_init((UA_NodeId*)v.data);
+            } else {
+                UA_LOG_WARNING(server->config.logging, UA_LOGCATEGORY_SERVER,
+                               "EventType has an invalid type.");
+                cache->eventTypeStatus = UA_STATUSCODE_BADINTERNALERROR;
+            }
+        }
+        UA_Variant_clear(&v);
+    }
+    *eventType = &cache->eventType;
+    return cache->eventTypeStatus;
+}
+
+/* Is the EventType equal to the type or a subtype of it? */
+static UA_Boolean
+isOfEventType(UA_Server *server, UA_EventCache *cache,
+              const UA_NodeId *eventType, const UA_NodeId *type) {
+    for(size_t i = 0; i < cache->typesSize; i++) {
+        if(UA_NodeId_equal(cache->types[i].type, type))
+            return cache->types[i].ofType;
+    }
+    UA_Boolean ofType = isNodeInTree_singleRef(server, eventType, type,
+                                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    if(cache->typesSize < UA_EVENTCACHE_MAXTYPES) {
+        cache->types[cache->typesSize].type = type;
+        cache->types[cache->typesSize].ofType = ofType;
+        cache->typesSize++;
+    }
+    return ofType;
+}
+
 /* Operand Resolving
  * ~~~~~~~~~~~~~~~~~
  * Methods that all resolve an operator operand to a Variant. */
 
+/* Resolve the field of a transient event from the map */
+static UA_StatusCode
+resolveEventField(const UA_KeyValueMap *fields, const UA_SimpleAttributeOperand *sao,
+                  UA_Variant *value) {
+    if(sao->attributeId != UA_ATTRIBUTEID_VALUE)
+        return UA_STATUSCODE_BADATTRIBUTEIDINVALID;
+    if(sao->browsePathSize != 1)
+        return UA_STATUSCODE_BADNOTFOUND;
+    const UA_Variant *field = UA_KeyValueMap_get(fields, sao->browsePath[0]);
+    if(!field)
+        return UA_STATUSCODE_BADNOTFOUND;
+    if(UA_Variant_isEmpty(field))
+        return UA_STATUSCODE_BADNODATAAVAILABLE;
+
+    /* Copy the field. The map is not owned by the notification. */
+    if(sao->indexRange.length == 0)
+        return UA_Variant_copy(field, value);
+    UA_NumericRange range;
+    UA_StatusCode res = UA_NumericRange_parse(&range, sao->indexRange);
+    if(res != UA_STATUSCODE_GOOD)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    res = UA_Variant_copyRange(field, value, range);
+    UA_free(range.dimensions);
+    return res;
+}
+
 /* Part 4, 7.4.4.5 SimpleAttributeOperand: The clause can point to any attribute
  * of nodes. Either a child of the event node and also the event type. */
 static UA_StatusCode
 resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
-                              const UA_NodeId *origin,
+                              UA_EventCache *cache, const UA_NodeId *origin,
                               const UA_SimpleAttributeOperand *sao,
                               UA_Variant *value) {
+    /* Transient event */
+    if(cache->fields)
+        return resolveEventField(cache->fields, sao, value);
+
     /* Prepare the ReadValueId */
     UA_ReadValueId rvi;
     UA_ReadValueId_init(&rvi);
@@ -503,21 +661,19 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
     } else {
         /* Resolve the browse path, starting from the event-source (and not the
          * typeDefinitionId). */
-        UA_BrowsePathResult bpr =
-            browseSimplifiedBrowsePath(server, *origin,
-                                       sao->browsePathSize, sao->browsePath);
-        if(bpr.targetsSize == 0 && bpr.statusCode == UA_STATUSCODE_GOOD)
-            bpr.statusCode = UA_STATUSCODE_BADNOTFOUND;
-        if(bpr.statusCode != UA_STATUSCODE_GOOD) {
-            UA_StatusCode res = bpr.statusCode;
-            UA_BrowsePathResult_clear(&bpr);
+        UA_NodeId scratch = UA_NODEID_NULL;
+        const UA_NodeId *target = NULL;
+        UA_StatusCode res =
+            resolveBrowsePath(server, cache, origin, sao->browsePathSize,
+                              sao->browsePath, &scratch, &target);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_NodeId_clear(&scratch);
             return res;
         }
 
-        /* Use the first match */
-        rvi.nodeId = bpr.targets[0].targetId.nodeId;
+        rvi.nodeId = *target;
         v = readWithSession(server, session, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
-        UA_BrowsePathResult_clear(&bpr);
+        UA_NodeId_clear(&scratch);
     }
 
     /* Validate the result */
@@ -533,6 +689,82 @@ resolveSimpleAttributeOperand(UA_Server *server, UA_Session *session,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_Boolean
+operandEqual(const UA_SimpleAttributeOperand *a, const UA_SimpleAttributeOperand *b) {
+    return (a == b ||
+            (a->attributeId == b->attributeId &&
+             UA_NodeId_equal(&a->typeDefinitionId, &b->typeDefinitionId) &&
+             UA_String_equal(&a->indexRange, &b->indexRange) &&
+             browsePathEqual(a->browsePathSize, a->browsePath,
+                             b->browsePathSize, b->browsePath)));
+}
+
+/* Resolve the operand once per event and Session. The value borrows from the
+ * SharedSample of the cache. Falls back to an owned value if the cache is
+ * full. */
+static UA_StatusCode
+resolveSharedOperand(UA_Server *server, UA_Session *session, UA_EventCache *cache,
+                     const UA_NodeId *origin, const UA_SimpleAttributeOperand *sao,
+                     UA_Variant *value) {
+    if(!cache->shareFields)
+        return resolveSimpleAttributeOperand(server, session, cache, origin, sao, value);
+
+    /* Already resolved? */
+    UA_Variant *fields = (cache->selected) ?
+        (UA_Variant*)cache->selected->value.value.data : NULL;
+    for(size_t i = 0; i < cache->selectedSize; i++) {
+        if(cache->selectedOperands[i].session != session ||
+           !operandEqual(cache->selectedOperands[i].sao, sao))
+            continue;
+        if(cache->selectedOperands[i].status == UA_STATUSCODE_GOOD) {
+            *value = fields[i];
+            value->storageType = UA_VARIANT_DATA_NODELETE;
+        }
+        return cache->selectedOperands[i].status;
+    }
+
+    /* Resolve */
+    UA_Variant v;
+    UA_Variant_init(&v);
+    UA_StatusCode res =
+        resolveSimpleAttributeOperand(server, session, cache, origin, sao, &v);
+
+    /* Create the SharedSample with space for all values */
+    if(!cache->selected && cache->selectedSize < UA_EVENTCACHE_MAXFIELDS) {
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        dv.value.type = &UA_TYPES[UA_TYPES_VARIANT];
+        dv.value.data = UA_Array_new(UA_EVENTCACHE_MAXFIELDS, &UA_TYPES[UA_TYPES_VARIANT]);
+        if(dv.value.data) {
+            dv.hasValue = true;
+            cache->selected = UA_SharedSample_new(&dv);
+            if(!cache->selected)
+                UA_DataValue_clear(&dv);
+        }
+        fields = (cache->selected) ?
+            (UA_Variant*)cache->selected->value.value.data : NULL;
+    }
+
+    /* Cache is full (or out of memory). Keep the owned value. */
+    if(!cache->selected || cache->selectedSize == UA_EVENTCACHE_MAXFIELDS) {
+        *value = v;
+        return res;
+    }
+
+    /* Move the value into the cache and borrow from there */
+    size_t pos = cache->selectedSize++;
+    cache->selectedOperands[pos].session = session;
+    cache->selectedOperands[pos].sao = sao;
+    cache->selectedOperands[pos].status = res;
+    fields[pos] = v;
+    cache->selected->value.value.arrayLength = cache->selectedSize;
+    if(res == UA_STATUSCODE_GOOD) {
+        *value = v;
+        value->storageType = UA_VARIANT_DATA_NODELETE;
+    }
+    return res;
+}
+
 static UA_StatusCode
 resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *out) {
     if(op->encoding != UA_EXTENSIONOBJECT_DECODED &&
@@ -559,8 +791,8 @@ resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *ou
     if(op->content.decoded.type == &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]) {
         UA_SimpleAttributeOperand *sao =
             (UA_SimpleAttributeOperand*)op->content.decoded.data;
-        return resolveSimpleAttributeOperand(ctx->server, ctx->session,
-                                             ctx->eventNode, sao, out);
+        return resolveSharedOperand(ctx->server, ctx->session, ctx->cache,
+                                    ctx->eventNode, sao, out);
     }
 
     return UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED;
@@ -571,6 +803,8 @@ resolveOperand(UA_FilterEvalContext *ctx, UA_ExtensionObject *op, UA_Variant *ou
 static UA_StatusCode
 setOperandError(UA_FilterEvalContext *ctx, size_t elementIndex,
                 size_t operandIndex, UA_StatusCode statusCode) {
+    if(!ctx->filterResult)
+        return statusCode;
     UA_ContentFilterElementResult *res = &ctx->filterResult->elementResults[elementIndex];
     res->operandStatusCodes[operandIndex] = statusCode;
     /* The operator status is set globally in a single location upwards the call chain
@@ -593,26 +827,14 @@ ofTypeOperator(UA_FilterEvalContext *ctx, size_t index) {
         return setOperandError(ctx, index, 0, UA_STATUSCODE_BADFILTEROPERATORUNSUPPORTED);
 
     /* Read the event type */
-    UA_Variant eventTypeVar;
-    UA_Variant_init(&eventTypeVar);
     const UA_NodeId *operandTypeId = (const UA_NodeId *)op0->data;
-    res = readObjectProperty(ctx->server, *ctx->eventNode,
-                             UA_QUALIFIEDNAME(0, "EventType"), &eventTypeVar);
+    const UA_NodeId *eventTypeId = NULL;
+    res = getEventType(ctx->server, ctx->cache, ctx->eventNode, &eventTypeId);
     UA_CHECK_STATUS(res, return res);
 
-    if(!UA_Variant_hasScalarType(&eventTypeVar, &UA_TYPES[UA_TYPES_NODEID])) {
-        UA_LOG_WARNING(ctx->server->config.logging, UA_LOGCATEGORY_SERVER,
-                       "EventType has an invalid type.");
-        UA_Variant_clear(&eventTypeVar);
-        return UA_STATUSCODE_BADINTERNALERROR;
-    }
-
     /* Check if the eventtype is equal to the operand or a subtype of it */
-    const UA_NodeId *eventTypeId = (UA_NodeId*)eventTypeVar.data;
-    UA_Boolean ofType = isNodeInTree_singleRef(ctx->server, eventTypeId, operandTypeId,
-                                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
+    UA_Boolean ofType = isOfEventType(ctx->server, ctx->cache, eventTypeId, operandTypeId);
     ctx->results[index] = t2v(ofType ? UA_TERNARY_TRUE : UA_TERNARY_FALSE);
-    UA_Variant_clear(&eventTypeVar);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -920,10 +1142,11 @@ static const UA_FilterOperatorJumptableElement operatorJumptable[18] = {
     {bitwiseOrOperator, 2, 2}
 };
 
-UA_StatusCode
-evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
-                    const UA_ContentFilter *contentFilter,
-                    UA_ContentFilterResult *contentFilterResult) {
+static UA_StatusCode
+evaluateWhereClauseCached(UA_Server *server, UA_Session *session,
+                          const UA_NodeId *eventNode, UA_EventCache *cache,
+                          const UA_ContentFilter *contentFilter,
+                          UA_ContentFilterResult *contentFilterResult) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* An empty filter always succeeds */
@@ -937,6 +1160,7 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
     ctx.server = server;
     ctx.session = session;
     ctx.eventNode = eventNode;
+    ctx.cache = cache;
     ctx.top = 0;
 
     /* Pacify some compilers by initializing the first result */
@@ -967,80 +1191,130 @@ evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eve
     return res;
 }
 
-static UA_Boolean
-isValidEvent(UA_Server *server, const UA_NodeId *validEventParent,
-             const UA_NodeId *eventId) {
-    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+UA_StatusCode
+evaluateWhereClause(UA_Server *server, UA_Session *session, const UA_NodeId *eventNode,
+                    const UA_ContentFilter *contentFilter,
+                    UA_ContentFilterResult *contentFilterResult) {
+    UA_EventCache cache;
+    UA_EventCache_init(&cache);
+    UA_StatusCode res =
+        evaluateWhereClauseCached(server, session, eventNode, &cache,
+                                  contentFilter, contentFilterResult);
+    UA_EventCache_clear(&cache);
+    return res;
+}
 
-    /* Find the eventType variableNode */
-    UA_QualifiedName findName = UA_QUALIFIEDNAME(0, "EventType");
-    UA_BrowsePathResult bpr = browseSimplifiedBrowsePath(server, *eventId, 1, &findName);
-    if(bpr.statusCode != UA_STATUSCODE_GOOD || bpr.targetsSize < 1) {
-        UA_BrowsePathResult_clear(&bpr);
-        return false;
+/* Partial evaluation of the where-clause with only the OfType operators. NULL
+ * denotes an unknown result. TRUE/FALSE are only returned if the operator
+ * evaluates to that result regardless of the other operators. */
+static UA_Ternary
+partialOfType(UA_Server *server, UA_EventCache *cache, const UA_NodeId *eventType,
+              const UA_ContentFilter *cf, size_t index) {
+    const UA_ContentFilterElement *elm = &cf->elements[index];
+
+    /* OfType with a literal NodeId is the only operator that is resolved */
+    if(elm->filterOperator == UA_FILTEROPERATOR_OFTYPE) {
+        if(elm->filterOperandsSize != 1 ||
+           elm->filterOperands[0].content.decoded.type != &UA_TYPES[UA_TYPES_LITERALOPERAND])
+            return UA_TERNARY_NULL;
+        const UA_LiteralOperand *lo = (const UA_LiteralOperand*)
+            elm->filterOperands[0].content.decoded.data;
+        if(!UA_Variant_hasScalarType(&lo->value, &UA_TYPES[UA_TYPES_NODEID]))
+            return UA_TERNARY_NULL;
+        return isOfEventType(server, cache, eventType, (const UA_NodeId*)lo->value.data) ?
+            UA_TERNARY_TRUE : UA_TERNARY_FALSE;
     }
 
-    /* Get the EventType Property Node */
-    UA_Variant tOutVariant;
-    UA_Variant_init(&tOutVariant);
-    /* Read the Value of EventType Property Node (the Value should be a NodeId) */
-    UA_StatusCode retval = readWithReadValue(server, &bpr.targets[0].targetId.nodeId,
-                                             UA_ATTRIBUTEID_VALUE, &tOutVariant);
-    if(retval != UA_STATUSCODE_GOOD ||
-       !UA_Variant_hasScalarType(&tOutVariant, &UA_TYPES[UA_TYPES_NODEID])) {
-        UA_BrowsePathResult_clear(&bpr);
-        return false;
+    if(elm->filterOperator != UA_FILTEROPERATOR_AND &&
+       elm->filterOperator != UA_FILTEROPERATOR_OR &&
+       elm->filterOperator != UA_FILTEROPERATOR_NOT)
+        return UA_TERNARY_NULL;
+
+    /* Resolve the element operands. The validation ensures they point to
+     * elements with a higher index. So the recursion terminates. */
+    UA_Ternary op[2] = {UA_TERNARY_NULL, UA_TERNARY_NULL};
+    if(elm->filterOperandsSize == 0 || elm->filterOperandsSize > 2)
+        return UA_TERNARY_NULL;
+    for(size_t i = 0; i < elm->filterOperandsSize; i++) {
+        const UA_ExtensionObject *o = &elm->filterOperands[i];
+        if(o->content.decoded.type != &UA_TYPES[UA_TYPES_ELEMENTOPERAND])
+            continue;
+        const UA_ElementOperand *eo = (const UA_ElementOperand*)o->content.decoded.data;
+        if(eo->index <= index || eo->index >= cf->elementsSize)
+            continue;
+        op[i] = partialOfType(server, cache, eventType, cf, eo->index);
+    }
+
+    switch(elm->filterOperator) {
+    case UA_FILTEROPERATOR_NOT:
+        return UA_Ternary_not(op[0]);
+    case UA_FILTEROPERATOR_AND:
+        if(elm->filterOperandsSize != 2)
+            return UA_TERNARY_NULL;
+        if(op[0] == UA_TERNARY_FALSE || op[1] == UA_TERNARY_FALSE)
+            return UA_TERNARY_FALSE;
+        return (op[0] == UA_TERNARY_TRUE && op[1] == UA_TERNARY_TRUE) ?
+            UA_TERNARY_TRUE : UA_TERNARY_NULL;
+    default: /* UA_FILTEROPERATOR_OR */
+        if(elm->filterOperandsSize != 2)
+            return UA_TERNARY_NULL;
+        if(op[0] == UA_TERNARY_TRUE || op[1] == UA_TERNARY_TRUE)
+            return UA_TERNARY_TRUE;
+        return (op[0] == UA_TERNARY_FALSE && op[1] == UA_TERNARY_FALSE) ?
+            UA_TERNARY_FALSE : UA_TERNARY_NULL;
     }
+}
+
+UA_Boolean
+whereClauseMayMatch(UA_Server *server, UA_EventCache *cache,
+                    const UA_NodeId *eventNode,
+                    const UA_ContentFilter *contentFilter) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+    if(contentFilter->elementsSize == 0)
+        return true;
+    const UA_NodeId *eventType = NULL;
+    UA_StatusCode res = getEventType(server, cache, eventNode, &eventType);
+    if(res != UA_STATUSCODE_GOOD)
+        return true; /* Let the full evaluation handle the error */
+    return (partialOfType(server, cache, eventType, contentFilter, 0) !=
+            UA_TERNARY_FALSE);
+}
 
-    const UA_NodeId *tEventType = (UA_NodeId*)tOutVariant.data;
+static UA_Boolean
+isValidEvent(UA_Server *server, UA_EventCache *cache,
+             const UA_NodeId *validEventParent, const UA_NodeId *eventId) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    /* Get the EventType */
+    const UA_NodeId *tEventType = NULL;
+    UA_StatusCode retval = getEventType(server, cache, eventId, &tEventType);
+    if(retval != UA_STATUSCODE_GOOD)
+        return false;
 
     /* Check whether the EventType is a Subtype of CondtionType (Part 9 first
      * implementation) */
     UA_NodeId conditionTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE);
     if(UA_NodeId_equal(validEventParent, &conditionTypeId) &&
        isNodeInTree_singleRef(server, tEventType, &conditionTypeId,
-                              UA_REFERENCETYPEINDEX_HASSUBTYPE)) {
-        UA_BrowsePathResult_clear(&bpr);
-        UA_Variant_clear(&tOutVariant);
+                              UA_REFERENCETYPEINDEX_HASSUBTYPE))
         return true;
-    }
 
     /* EventType is not a Subtype of CondtionType (ConditionId Clause won't be
      * present in Events, which are not Conditions) */
     /* Check whether Valid Event other than Conditions */
     UA_NodeId baseEventTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
-    UA_Boolean isSubtypeOfBaseEvent =
-        isNodeInTree_singleRef(server, tEventType, &baseEventTypeId,
-                               UA_REFERENCETYPEINDEX_HASSUBTYPE);
-
-    UA_BrowsePathResult_clear(&bpr);
-    UA_Variant_clear(&tOutVariant);
-    return isSubtypeOfBaseEvent;
+    return isNodeInTree_singleRef(server, tEventType, &baseEventTypeId,
+                                  UA_REFERENCETYPEINDEX_HASSUBTYPE);
 }
 
-UA_StatusCode
-filterEvent(UA_Server *server, UA_Session *session,
-            const UA_NodeId *eventNode, UA_EventFilter *filter,
-            UA_EventFieldList *efl, UA_EventFilterResult *result) {
-    UA_LOCK_ASSERT(&server->serviceMutex, 1);
-
-    if(filter->selectClausesSize == 0)
-        return UA_STATUSCODE_BADEVENTFILTERINVALID;
-
-    UA_EventFieldList_init(efl);
-    efl->eventFields = (UA_Variant *)
-        UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_VARIANT]);
-    if(!efl->eventFields)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    efl->eventFieldsSize = filter->selectClausesSize;
-
+static UA_StatusCode
+prepareEventFilterResult(const UA_EventFilter *filter, UA_EventFilterResult *result) {
     /* Empty event filter result */
     UA_EventFilterResult_init(result);
     result->selectClauseResultsSize = filter->selectClausesSize;
     result->selectClauseResults = (UA_StatusCode *)
         UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
     if(!result->selectClauseResults) {
-        UA_EventFieldList_clear(efl);
         UA_EventFilterResult_clear(result);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
@@ -1052,7 +1326,6 @@ filterEvent(UA_Server *server, UA_Session *session,
             UA_Array_new(filter->whereClause.elementsSize,
                          &UA_TYPES[UA_TYPES_CONTENTFILTERELEMENTRESULT]);
         if(!result->whereClauseResult.elementResults) {
-            UA_EventFieldList_clear(efl);
             UA_EventFilterResult_clear(result);
             return UA_STATUSCODE_BADOUTOFMEMORY;
         }
@@ -1065,20 +1338,59 @@ filterEvent(UA_Server *server, UA_Session *session,
             er->operandStatusCodes = (UA_StatusCode *)
                 UA_Array_new(er->operandStatusCodesSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
             if(!er->operandStatusCodes) {
-                UA_EventFieldList_clear(efl);
                 UA_EventFilterResult_clear(result);
                 return UA_STATUSCODE_BADOUTOFMEMORY;
             }
         }
     }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode
+filterEvent(UA_Server *server, UA_Session *session,
+            const UA_NodeId *eventNode, UA_EventFilter *filter,
+            UA_EventCache *cache, UA_EventFieldList *efl,
+            UA_EventFilterResult *result) {
+    UA_LOCK_ASSERT(&server->serviceMutex, 1);
+
+    if(filter->selectClausesSize == 0)
+        return UA_STATUSCODE_BADEVENTFILTERINVALID;
+
+    /* Use a local cache if none is provided */
+    UA_EventCache localCache;
+    if(!cache) {
+        UA_EventCache_init(&localCache);
+        UA_StatusCode res = filterEvent(server, session, eventNode, filter,
+                                        &localCache, efl, result);
+        UA_EventCache_clear(&localCache);
+        return res;
+    }
+
+    UA_EventFieldList_init(efl);
+    efl->eventFields = (UA_Variant *)
+        UA_Array_new(filter->selectClausesSize, &UA_TYPES[UA_TYPES_VARIANT]);
+    if(!efl->eventFields)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    efl->eventFieldsSize = filter->selectClausesSize;
+
+    /* Without a result, only the event fields are computed */
+    UA_StatusCode res;
+    if(result) {
+        res = prepareEventFilterResult(filter, result);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_EventFieldList_clear(efl);
+            return res;
+        }
+    }
 
     /* Evaluate the where filter. Do we event need to consider the event? */
-    UA_StatusCode res = evaluateWhereClause(server, session, eventNode,
-                                            &filter->whereClause,
-                                            &result->whereClauseResult);
+    res = evaluateWhereClauseCached(server, session, eventNode, cache,
+                                    &filter->whereClause,
+                                    (result) ? &result->whereClauseResult : NULL);
     if(res != UA_STATUSCODE_GOOD){
         UA_EventFieldList_clear(efl);
-        UA_EventFilterResult_clear(result);
+        if(result)
+            UA_EventFilterResult_clear(result);
         return res;
     }
 
@@ -1089,7 +1401,7 @@ filterEvent(UA_Server *server, UA_Session *session,
         /* Check if the browsePath is BaseEventType, in which case nothing more
          * needs to be checked */
         if(!UA_NodeId_equal(&sc->typeDefinitionId, &baseEventTypeId) &&
-           !isValidEvent(server, &sc->typeDefinitionId, eventNode)) {
+           !isValidEvent(server, cache, &sc->typeDefinitionId, eventNode)) {
             UA_Variant_init(&efl->eventFields[i]);
             /* EventFilterResult currently isn't being used
                notification->result.selectClauseResults[i] =
@@ -1099,9 +1411,10 @@ filterEvent(UA_Server *server, UA_Session *session,
 
         /* Lookup the field. The overall filter can succeed even if a single
          * select-field cannot be resolved. */
-        result->selectClauseResults[i] =
-            resolveSimpleAttributeOperand(server, session, eventNode,
-                                          sc, &efl->eventFields[i]);
+        res = resolveSharedOperand(server, session, cache, eventNode,
+                                   sc, &efl->eventFields[i]);
+        if(result)
+            result->selectClauseResults[i] = res;
     }
 
     return UA_STATUSCODE_GOOD;
@@ -51,17 +51,16 @@ createEventOverflowNotification(UA_Server *server, UA_Subscription *sub,
      * NodeId of the OverflowEventType. */
 
     /* Allocate the notification */
-    UA_Notification *overflowNotification = UA_Notification_new();
+    UA_Notification *overflowNotification = UA_MonitoredItem_newNotification(server, mon);
     if(!overflowNotification)
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Set the notification fields */
     overflowNotification->isOverflowEvent = true;
-    overflowNotification->mon = mon;
     overflowNotification->data.event.clientHandle = mon->parameters.clientHandle;
     overflowNotification->data.event.eventFields = UA_Variant_new();
     if(!overflowNotification->data.event.eventFields) {
-        UA_free(overflowNotification);
+        UA_Notification_delete(overflowNotification);
         return UA_STATUSCODE_BADOUTOFMEMORY;
     }
     overflowNotification->data.event.eventFieldsSize = 1;
@@ -168,8 +167,9 @@ UA_MonitoredItem_removeOverflowInfoBits(UA_MonitoredItem *mon) {
 }
 
 UA_Notification *
-UA_Notification_new(void) {
-    UA_Notification *n = (UA_Notification*)UA_calloc(1, sizeof(UA_Notification));
+UA_Notification_new(UA_Server *server) {
+    UA_Notification *n = (UA_Notification*)
+        UA_POOL_ALLOC(&server->pools.notifications, sizeof(UA_Notification));
     if(n) {
         /* Set the sentinel for a notification that is not enqueued */
         TAILQ_NEXT(n, globalEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
@@ -178,6 +178,24 @@ UA_Notification_new(void) {
     return n;
 }
 
+UA_Notification *
+UA_MonitoredItem_newNotification(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_Notification *n = TAILQ_FIRST(&mon->notificationPool);
+    if(n) {
+        TAILQ_REMOVE(&mon->notificationPool, n, localEntry);
+        mon->notificationPoolSize--;
+        memset(n, 0, sizeof(UA_Notification));
+        TAILQ_NEXT(n, globalEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+        TAILQ_NEXT(n, localEntry) = UA_SUBSCRIPTION_QUEUE_SENTINEL;
+    } else {
+        n = UA_Notification_new(server);
+        if(!n)
+            return NULL;
+    }
+    n->mon = mon;
+    return n;
+}
+
 static void UA_Notification_dequeueMon(UA_Notification *n);
 static void UA_Notification_enqueueSub(UA_Notification *n);
 static void UA_Notification_dequeueSub(UA_Notification *n);
@@ -185,10 +203,11 @@ static void UA_Notification_dequeueSub(UA_Notification *n);
 void
 UA_Notification_delete(UA_Notification *n) {
     UA_assert(n != UA_SUBSCRIPTION_QUEUE_SENTINEL);
-    if(n->mon) {
+    UA_MonitoredItem *mon = n->mon;
+    if(mon) {
         UA_Notification_dequeueMon(n);
         UA_Notification_dequeueSub(n);
-        switch(n->mon->itemToMonitor.attributeId) {
+        switch(mon->itemToMonitor.attributeId) {
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
         case UA_ATTRIBUTEID_EVENTNOTIFIER:
             UA_EventFieldList_clear(&n->data.event);
@@ -199,7 +218,17 @@ UA_Notification_delete(UA_Notification *n) {
             break;
         }
     }
-    UA_free(n);
+    if(n->shared)
+        UA_SharedSample_release(n->shared);
+
+    /* Keep for reuse in the MonitoredItem. One more than the queue size is
+     * needed temporarily when the queue overflows. */
+    if(mon && mon->queueSize + mon->notificationPoolSize <= mon->parameters.queueSize) {
+        TAILQ_INSERT_HEAD(&mon->notificationPool, n, localEntry);
+        mon->notificationPoolSize++;
+        return;
+    }
+    UA_POOL_FREE(n);
 }
 
 /* Add to the MonitoredItem queue, update all counters and then handle overflow */
@@ -212,6 +241,7 @@ UA_Notification_enqueueMon(UA_Server *server, UA_Notification *n) {
     /* Add to the MonitoredItem */
     TAILQ_INSERT_TAIL(&mon->queue, n, localEntry);
     ++mon->queueSize;
+    server->counterStatistics.notificationCount++;
 
 #ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
     if(n->isOverflowEvent)
@@ -266,6 +296,8 @@ UA_Notification_enqueueAndTrigger(UA_Server *server, UA_Notification *n) {
     UA_MonitoredItem *mon = n->mon;
     UA_Subscription *sub = mon->subscription;
     UA_assert(sub); /* This function is never called for local MonitoredItems */
+    if(sub->session)
+        UA_atomic_addUInt64(&sub->session->usage.notifications, 1);
 
     /* If reporting or (sampled+triggered), enqueue into the Subscription first
      * and then into the MonitoredItem. UA_MonitoredItem_ensureQueueSpace
@@ -287,14 +319,10 @@ UA_Notification_enqueueAndTrigger(UA_Server *server, UA_Notification *n) {
      * handles overflow. */
     UA_Notification_enqueueMon(server, n);
 
-    for(size_t i = mon->triggeringLinksSize - 1; i < mon->triggeringLinksSize; i--) {
-        /* Get the triggered MonitoredItem. Remove the link if the MI doesn't exist. */
-        UA_MonitoredItem *triggeredMon =
-            UA_Subscription_getMonitoredItem(sub, mon->triggeringLinks[i]);
-        if(!triggeredMon) {
-            UA_MonitoredItem_removeLink(sub, mon, mon->triggeringLinks[i]);
-            continue;
-        }
+    UA_TriggeringLink *link;
+    LIST_FOREACH(link, &mon->triggeringLinks, triggeringEntry) {
+        /* Links are removed together with the triggered MonitoredItem */
+        UA_MonitoredItem *triggeredMon = link->triggered;
 
         /* Only sampling MonitoredItems receive a trigger. Reporting
          * MonitoredItems send out Notifications anyway and disabled
@@ -396,6 +424,9 @@ void
 UA_MonitoredItem_init(UA_MonitoredItem *mon) {
     memset(mon, 0, sizeof(UA_MonitoredItem));
     TAILQ_INIT(&mon->queue);
+    TAILQ_INIT(&mon->notificationPool);
+    LIST_INIT(&mon->triggeringLinks);
+    LIST_INIT(&mon->triggeredLinks);
     mon->triggeredUntil = UA_INT64_MIN;
 }
 
@@ -447,7 +478,10 @@ UA_Server_registerMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
     mon->monitoredItemId = ++sub->lastMonitoredItemId;
     mon->subscription = sub;
     LIST_INSERT_HEAD(&sub->monitoredItems, mon, listEntry);
+    ZIP_INSERT(UA_MonitoredItemIdTree, &sub->monitoredItemsById, mon);
     sub->monitoredItemsSize++;
+    if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED)
+        sub->disabledMonitoredItemsSize++;
     server->monitoredItemsSize++;
 
     /* Register the MonitoredItem in userland */
@@ -496,20 +530,39 @@ UA_Server_unregisterMonitoredItem(UA_Server *server, UA_MonitoredItem *mon) {
 
     /* Deregister in Subscription and server */
     sub->monitoredItemsSize--;
+    if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED)
+        sub->disabledMonitoredItemsSize--;
     LIST_REMOVE(mon, listEntry);
+    ZIP_REMOVE(UA_MonitoredItemIdTree, &sub->monitoredItemsById, mon);
     server->monitoredItemsSize--;
 }
 
+/* Keeps the count of disabled MonitoredItems in the Subscription up to date */
+static void
+changeMonitoringMode(UA_MonitoredItem *mon, UA_MonitoringMode monitoringMode) {
+    if(mon->registered && mon->subscription) {
+        if(mon->monitoringMode == UA_MONITORINGMODE_DISABLED)
+            mon->subscription->disabledMonitoredItemsSize--;
+        if(monitoringMode == UA_MONITORINGMODE_DISABLED)
+            mon->subscription->disabledMonitoredItemsSize++;
+    }
+    mon->monitoringMode = monitoringMode;
+}
+
 UA_StatusCode
 UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
-                                   UA_MonitoringMode monitoringMode) {
+                                   UA_MonitoringMode monitoringMode,
+                                   UA_DataValue *firstSample) {
     /* Check if the MonitoringMode is valid or not */
-    if(monitoringMode > UA_MONITORINGMODE_REPORTING)
+    if(monitoringMode > UA_MONITORINGMODE_REPORTING) {
+        if(firstSample)
+            UA_DataValue_clear(firstSample);
         return UA_STATUSCODE_BADMONITORINGMODEINVALID;
+    }
 
     /* Set the MonitoringMode, store the old mode */
     UA_MonitoringMode oldMode = mon->monitoringMode;
-    mon->monitoringMode = monitoringMode;
+    changeMonitoringMode(mon, monitoringMode);
 
     UA_Notification *notification;
     /* Reporting is disabled. This causes all Notifications to be dequeued and
@@ -521,7 +574,9 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
         TAILQ_FOREACH_SAFE(notification, &mon->queue, localEntry, notification_tmp) {
             UA_Notification_delete(notification);
         }
-        UA_DataValue_clear(&mon->lastValue);
+        UA_MonitoredItem_clearLastValue(mon);
+        if(firstSample)
+            UA_DataValue_clear(firstSample);
         return UA_STATUSCODE_GOOD;
     }
 
@@ -548,42 +603,68 @@ UA_MonitoredItem_setMonitoringMode(UA_Server *server, UA_MonitoredItem *mon,
      * notifications. */
     UA_StatusCode res = UA_MonitoredItem_registerSampling(server, mon);
     if(res != UA_STATUSCODE_GOOD) {
-        mon->monitoringMode = UA_MONITORINGMODE_DISABLED;
+        changeMonitoringMode(mon, UA_MONITORINGMODE_DISABLED);
+        if(firstSample)
+            UA_DataValue_clear(firstSample);
         return res;
     }
 
     /* Manually create the first sample if the MonitoredItem was disabled, the
      * MonitoredItem is now sampling (or reporting) and it is not an
-     * Event-MonitoredItem */
+     * Event-MonitoredItem. Use the provided sample if possible. */
     if(oldMode == UA_MONITORINGMODE_DISABLED &&
        mon->monitoringMode > UA_MONITORINGMODE_DISABLED &&
-       mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER)
-        monitoredItem_sampleCallback(server, mon);
+       mon->itemToMonitor.attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER) {
+        if(firstSample)
+            UA_MonitoredItem_processSampledValue(server, mon, firstSample);
+        else
+            monitoredItem_sampleCallback(server, mon);
+    } else if(firstSample) {
+        UA_DataValue_clear(firstSample);
+    }
 
     return UA_STATUSCODE_GOOD;
 }
 
+static void
+removeTriggeringLink(UA_TriggeringLink *link) {
+    LIST_REMOVE(link, triggeringEntry);
+    LIST_REMOVE(link, triggeredEntry);
+    UA_free(link);
+}
+
 static void
 delayedFreeMonitoredItem(void *app, void *context) {
-    UA_free(context);
+    UA_POOL_FREE(context);
 }
 
 void
-UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
+UA_MonitoredItem_clear(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
 
     /* Remove the sampling callback */
     UA_MonitoredItem_unregisterSampling(server, mon);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    /* Abort a pending ConditionRefresh */
+    if(mon->refreshState != UA_CONDITIONREFRESH_NONE) {
+        mon->subscription->conditionRefreshes--;
+        mon->refreshState = UA_CONDITIONREFRESH_NONE;
+    }
+    UA_NodeId_clear(&mon->refreshCursor);
+#endif
+
     /* Deregister in Server and Subscription */
     if(mon->registered)
         UA_Server_unregisterMonitoredItem(server, mon);
 
-    /* Remove the TriggeringLinks */
-    if(mon->triggeringLinksSize > 0) {
-        UA_free(mon->triggeringLinks);
-        mon->triggeringLinks = NULL;
-        mon->triggeringLinksSize = 0;
+    /* Remove the TriggeringLinks in both directions */
+    UA_TriggeringLink *link, *link_tmp;
+    LIST_FOREACH_SAFE(link, &mon->triggeringLinks, triggeringEntry, link_tmp) {
+        removeTriggeringLink(link);
+    }
+    LIST_FOREACH_SAFE(link, &mon->triggeredLinks, triggeredEntry, link_tmp) {
+        removeTriggeringLink(link);
     }
 
     /* Remove the queued notifications attached to the subscription */
@@ -592,12 +673,20 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
         UA_Notification_delete(notification);
     }
 
+    /* Free the pooled notifications */
+    TAILQ_FOREACH_SAFE(notification, &mon->notificationPool, localEntry, notification_tmp) {
+        TAILQ_REMOVE(&mon->notificationPool, notification, localEntry);
+        UA_POOL_FREE(notification);
+    }
+    mon->notificationPoolSize = 0;
+
     /* Remove the settings */
     UA_ReadValueId_clear(&mon->itemToMonitor);
     UA_MonitoringParameters_clear(&mon->parameters);
+    UA_NodeId_clear(&mon->percentDeadband.euRangeId);
 
     /* Remove the last samples */
-    UA_DataValue_clear(&mon->lastValue);
+    UA_MonitoredItem_clearLastValue(mon);
 
     /* If this is a local MonitoredItem, clean up additional values */
     if(mon->subscription == server->adminSubscription) {
@@ -606,6 +695,11 @@ UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
             UA_Variant_init(&lm->eventFields.map[i].value);
         UA_KeyValueMap_clear(&lm->eventFields);
     }
+}
+
+void
+UA_MonitoredItem_delete(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_MonitoredItem_clear(server, mon);
 
     /* Add a delayed callback to remove the MonitoredItem when the current jobs
      * have completed. This is needed to allow that a local MonitoredItem can
@@ -695,6 +789,7 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
 #ifdef UA_ENABLE_DIAGNOSTICS
         sub->monitoringQueueOverflowCount++;
 #endif
+        server->counterStatistics.notificationDropCount++;
 
         /* Assertions to help Clang's scan-analyzer */
         UA_assert(del != TAILQ_FIRST(&mon->queue));
@@ -714,6 +809,139 @@ UA_MonitoredItem_ensureQueueSpace(UA_Server *server, UA_MonitoredItem *mon) {
     }
 }
 
+/******************/
+/* Sampling Group */
+/******************/
+
+static enum ZIP_CMP
+cmpSamplingGroupKey(const UA_SamplingGroupKey *a, const UA_SamplingGroupKey *b) {
+    if(a->samplingInterval != b->samplingInterval)
+        return (a->samplingInterval < b->samplingInterval) ?
+            ZIP_CMP_LESS : ZIP_CMP_MORE;
+    if(a->timestampsToReturn != b->timestampsToReturn)
+        return (a->timestampsToReturn < b->timestampsToReturn) ?
+            ZIP_CMP_LESS : ZIP_CMP_MORE;
+    return (enum ZIP_CMP)UA_order(&a->itemToMonitor, &b->itemToMonitor,
+                                  &UA_TYPES[UA_TYPES_READVALUEID]);
+}
+
+ZIP_FUNCTIONS(UA_SamplingGroupTree, UA_SamplingGroup, zipEntry,
+              UA_SamplingGroupKey, key, cmpSamplingGroupKey)
+
+static UA_Boolean
+useSamplingGroup(const UA_MonitoredItem *mon) {
+    return mon->itemToMonitor.attributeId == UA_ATTRIBUTEID_VALUE;
+}
+
+static UA_StatusCode
+addSamplingGroupBackpointer(UA_Server *server, UA_Session *session,
+                            UA_Node *node, void *data) {
+    UA_SamplingGroup *sg = (UA_SamplingGroup*)data;
+    sg->nodeListNext = node->head.samplingGroups;
+    node->head.samplingGroups = sg;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+removeSamplingGroupBackpointer(UA_Server *server, UA_Session *session,
+                               UA_Node *node, void *data) {
+    UA_SamplingGroup *remove = (UA_SamplingGroup*)data;
+    UA_SamplingGroup **prev = &node->head.samplingGroups;
+    for(; *prev; prev = &(*prev)->nodeListNext) {
+        if(*prev == remove) {
+            *prev = remove->nodeListNext;
+            break;
+        }
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_Node_markSamplingGroupsDirty(const UA_Node *node) {
+    UA_SamplingGroup *sg = node->head.samplingGroups;
+    for(; sg; sg = sg->nodeListNext)
+        sg->dirty = true;
+}
+
+static UA_StatusCode
+addToSamplingGroup(UA_Server *server, UA_MonitoredItem *mon) {
+    /* The key points into the MonitoredItem for the lookup */
+    UA_SamplingGroupKey key;
+    key.itemToMonitor = mon->itemToMonitor;
+    key.samplingInterval = mon->parameters.samplingInterval;
+    key.timestampsToReturn = mon->timestampsToReturn;
+    UA_SamplingGroup *sg = ZIP_FIND(UA_SamplingGroupTree, &server->samplingGroups, &key);
+
+    /* Create a new group with its own repeated callback */
+    if(!sg) {
+        sg = (UA_SamplingGroup*)UA_calloc(1, sizeof(UA_SamplingGroup));
+        if(!sg)
+            return UA_STATUSCODE_BADOUTOFMEMORY;
+        UA_StatusCode res = UA_ReadValueId_copy(&mon->itemToMonitor,
+                                                &sg->key.itemToMonitor);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sg);
+            return res;
+        }
+        sg->key.samplingInterval = key.samplingInterval;
+        sg->key.timestampsToReturn = key.timestampsToReturn;
+        res = addRepeatedCallback(server,
+                                  (UA_ServerCallback)UA_SamplingGroup_sampleCallback,
+                                  sg, sg->key.samplingInterval, &sg->callbackId);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_ReadValueId_clear(&sg->key.itemToMonitor);
+            UA_free(sg);
+            return res;
+        }
+        LIST_INIT(&sg->monitoredItems);
+        ZIP_INSERT(UA_SamplingGroupTree, &server->samplingGroups, sg);
+
+        /* Attach to the node for event-driven sampling. If the node does not
+         * exist (yet), the group is sampled in every interval. */
+        sg->dirty = true;
+        if(server->config.eventDrivenSampling) {
+            res = UA_Server_editNode(server, &server->adminSession,
+                                     &sg->key.itemToMonitor.nodeId,
+                                     addSamplingGroupBackpointer, sg);
+            sg->attached = (res == UA_STATUSCODE_GOOD);
+        }
+    }
+
+    LIST_INSERT_HEAD(&sg->monitoredItems, mon, sampling.grouped.groupEntry);
+    mon->sampling.grouped.group = sg;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+delayedFreeSamplingGroup(void *app, void *context) {
+    UA_SamplingGroup *sg = (UA_SamplingGroup*)context;
+    UA_ReadValueId_clear(&sg->key.itemToMonitor);
+    UA_free(sg);
+}
+
+static void
+removeFromSamplingGroup(UA_Server *server, UA_MonitoredItem *mon) {
+    UA_SamplingGroup *sg = mon->sampling.grouped.group;
+    LIST_REMOVE(mon, sampling.grouped.groupEntry);
+    mon->sampling.grouped.group = NULL;
+    if(!LIST_EMPTY(&sg->monitoredItems))
+        return;
+
+    /* Remove the empty group. Freeing is delayed as the group might currently
+     * be sampled. */
+    if(sg->attached)
+        UA_Server_editNode(server, &server->adminSession,
+                           &sg->key.itemToMonitor.nodeId,
+                           removeSamplingGroupBackpointer, sg);
+    removeCallback(server, sg->callbackId);
+    ZIP_REMOVE(UA_SamplingGroupTree, &server->samplingGroups, sg);
+    sg->delayedFree.callback = delayedFreeSamplingGroup;
+    sg->delayedFree.application = NULL;
+    sg->delayedFree.context = sg;
+    UA_EventLoop *el = server->config.eventLoop;
+    el->addDelayedCallback(el, &sg->delayedFree);
+}
+
 UA_StatusCode
 UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
     UA_LOCK_ASSERT(&server->serviceMutex, 1);
@@ -740,6 +968,12 @@ UA_MonitoredItem_registerSampling(UA_Server *server, UA_MonitoredItem *mon) {
         LIST_INSERT_HEAD(&sub->samplingMonitoredItems, mon,
                          sampling.subscriptionSampling);
         mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_PUBLISH;
+    } else if(useSamplingGroup(mon)) {
+        /* Share the repeated callback with the MonitoredItems that sample the
+         * same value */
+        res = addToSamplingGroup(server, mon);
+        if(res == UA_STATUSCODE_GOOD)
+            mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_GROUP;
     } else {
         /* DataChange MonitoredItems with a positive sampling interval have a
          * repeated callback. Other MonitoredItems are attached to the Node in a
@@ -778,6 +1012,10 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
         LIST_REMOVE(mon, sampling.subscriptionSampling);
         break;
 
+    case UA_MONITOREDITEMSAMPLINGTYPE_GROUP:
+        removeFromSamplingGroup(server, mon);
+        break;
+
     case UA_MONITOREDITEMSAMPLINGTYPE_NONE:
     default:
         /* Sampling is not registered */
@@ -787,40 +1025,32 @@ UA_MonitoredItem_unregisterSampling(UA_Server *server, UA_MonitoredItem *mon) {
     mon->samplingType = UA_MONITOREDITEMSAMPLINGTYPE_NONE;
 }
 
-UA_StatusCode
-UA_MonitoredItem_removeLink(UA_Subscription *sub, UA_MonitoredItem *mon, UA_UInt32 linkId) {
-    /* Find the index */
-    size_t i = 0;
-    for(; i < mon->triggeringLinksSize; i++) {
-        if(mon->triggeringLinks[i] == linkId)
+/* Returns the link from mon to the triggered MonitoredItem or NULL. The list
+ * of links to the triggered item is searched as it is usually short. */
+static UA_TriggeringLink *
+findTriggeringLink(UA_MonitoredItem *mon, UA_MonitoredItem *triggered) {
+    UA_TriggeringLink *link;
+    LIST_FOREACH(link, &triggered->triggeredLinks, triggeredEntry) {
+        if(link->triggering == mon)
             break;
     }
+    return link;
+}
 
-    /* Not existing / already removed */
-    if(i == mon->triggeringLinksSize)
-        return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
-
-    /* Remove the link */
-    mon->triggeringLinksSize--;
-    if(mon->triggeringLinksSize == 0) {
-        UA_free(mon->triggeringLinks);
-        mon->triggeringLinks = NULL;
-    } else {
-        mon->triggeringLinks[i] = mon->triggeringLinks[mon->triggeringLinksSize];
-        UA_UInt32 *tmpLinks = (UA_UInt32*)
-            UA_realloc(mon->triggeringLinks, mon->triggeringLinksSize * sizeof(UA_UInt32));
-        if(tmpLinks)
-            mon->triggeringLinks = tmpLinks;
-    }
-
-    /* Does the target MonitoredItem exist? This is stupid, but the CTT wants us
-     * to to this. We don't auto-remove links together with the target
-     * MonitoredItem. Links to removed MonitoredItems are removed when the link
-     * triggers and the target no longer exists. */
+UA_StatusCode
+UA_MonitoredItem_removeLink(UA_Subscription *sub, UA_MonitoredItem *mon, UA_UInt32 linkId) {
+    /* Links to a removed MonitoredItem have been removed together with it.
+     * The CTT expects UA_STATUSCODE_BADMONITOREDITEMIDINVALID then. */
     UA_MonitoredItem *mon2 = UA_Subscription_getMonitoredItem(sub, linkId);
     if(!mon2)
         return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 
+    /* Not existing / already removed */
+    UA_TriggeringLink *link = findTriggeringLink(mon, mon2);
+    if(!link)
+        return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
+
+    removeTriggeringLink(link);
     return UA_STATUSCODE_GOOD;
 }
 
@@ -832,21 +1062,17 @@ UA_MonitoredItem_addLink(UA_Subscription *sub, UA_MonitoredItem *mon, UA_UInt32
         return UA_STATUSCODE_BADMONITOREDITEMIDINVALID;
 
     /* Does the link already exist? */
-    for(size_t i = 0 ; i < mon->triggeringLinksSize; i++) {
-        if(mon->triggeringLinks[i] == linkId)
-            return UA_STATUSCODE_GOOD;
-    }
-
-    /* Allocate the memory */
-    UA_UInt32 *tmpLinkIds = (UA_UInt32*)
-        UA_realloc(mon->triggeringLinks, (mon->triggeringLinksSize + 1) * sizeof(UA_UInt32));
-    if(!tmpLinkIds)
-        return UA_STATUSCODE_BADOUTOFMEMORY;
-    mon->triggeringLinks = tmpLinkIds;
+    if(findTriggeringLink(mon, mon2))
+        return UA_STATUSCODE_GOOD;
 
     /* Add the link */
-    mon->triggeringLinks[mon->triggeringLinksSize] = linkId;
-    mon->triggeringLinksSize++;
+    UA_TriggeringLink *link = (UA_TriggeringLink*)UA_malloc(sizeof(UA_TriggeringLink));
+    if(!link)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    link->triggering = mon;
+    link->triggered = mon2;
+    LIST_INSERT_HEAD(&mon->triggeringLinks, link, triggeringEntry);
+    LIST_INSERT_HEAD(&mon2->triggeredLinks, link, triggeredEntry);
     return UA_STATUSCODE_GOOD;
 }
 
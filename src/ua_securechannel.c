@@ -21,6 +21,9 @@
 #define UA_BITMASK_MESSAGETYPE 0x00ffffffu
 #define UA_BITMASK_CHUNKTYPE 0xff000000u
 
+/* Number of unused chunk structures kept per SecureChannel */
+#define UA_SECURECHANNEL_FREECHUNKS_MAX 8
+
 const UA_String UA_SECURITY_POLICY_NONE_URI =
     {47, (UA_Byte *)"http://opcfoundation.org/UA/SecurityPolicy#None"};
 
@@ -30,6 +33,7 @@ UA_SecureChannel_init(UA_SecureChannel *channel) {
     memset(channel, 0, sizeof(UA_SecureChannel));
     SIMPLEQ_INIT(&channel->completeChunks);
     SIMPLEQ_INIT(&channel->decryptedChunks);
+    SIMPLEQ_INIT(&channel->freeChunks);
 }
 
 UA_StatusCode
@@ -120,27 +124,57 @@ UA_SecureChannel_sendError(UA_SecureChannel *channel, UA_TcpErrorMessage *error)
     cm->sendWithConnection(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL, &msg);
 }
 
+/* Chunk structures are taken from the free-list of the channel if possible.
+ * This avoids a malloc/free pair for every received chunk. */
+static UA_Chunk *
+UA_Chunk_new(UA_SecureChannel *channel) {
+    UA_Chunk *chunk = SIMPLEQ_FIRST(&channel->freeChunks);
+    if(chunk) {
+        SIMPLEQ_REMOVE_HEAD(&channel->freeChunks, pointers);
+        channel->freeChunksCount--;
+    } else {
+        chunk = (UA_Chunk*)UA_malloc(sizeof(UA_Chunk));
+        if(!chunk)
+            return NULL;
+    }
+    memset(chunk, 0, sizeof(UA_Chunk));
+    return chunk;
+}
+
 static void
-UA_Chunk_delete(UA_Chunk *chunk) {
+UA_Chunk_delete(UA_SecureChannel *channel, UA_Chunk *chunk) {
     if(chunk->copied)
         UA_ByteString_clear(&chunk->bytes);
-    UA_free(chunk);
+    if(channel->freeChunksCount >= UA_SECURECHANNEL_FREECHUNKS_MAX) {
+        UA_free(chunk);
+        return;
+    }
+    SIMPLEQ_INSERT_HEAD(&channel->freeChunks, chunk, pointers);
+    channel->freeChunksCount++;
 }
 
 static void
-deleteChunks(UA_ChunkQueue *queue) {
+deleteChunks(UA_SecureChannel *channel, UA_ChunkQueue *queue) {
     UA_Chunk *chunk;
     while((chunk = SIMPLEQ_FIRST(queue))) {
         SIMPLEQ_REMOVE_HEAD(queue, pointers);
-        UA_Chunk_delete(chunk);
+        UA_Chunk_delete(channel, chunk);
     }
 }
 
 void
 UA_SecureChannel_deleteBuffered(UA_SecureChannel *channel) {
-    deleteChunks(&channel->completeChunks);
-    deleteChunks(&channel->decryptedChunks);
+    deleteChunks(channel, &channel->completeChunks);
+    deleteChunks(channel, &channel->decryptedChunks);
     UA_ByteString_clear(&channel->incompleteChunk);
+
+    /* Release the cached chunk structures */
+    UA_Chunk *chunk;
+    while((chunk = SIMPLEQ_FIRST(&channel->freeChunks))) {
+        SIMPLEQ_REMOVE_HEAD(&channel->freeChunks, pointers);
+        UA_free(chunk);
+    }
+    channel->freeChunksCount = 0;
 }
 
 void
@@ -196,6 +230,9 @@ UA_SecureChannel_clear(UA_SecureChannel *channel) {
     memset(&channel->config, 0, sizeof(UA_ConnectionConfig));
     channel->receiveSequenceNumber = 0;
     channel->sendSequenceNumber = 0;
+    channel->receivedBufferCount = 0;
+    channel->receivedChunkCount = 0;
+    channel->maxChunksPerBuffer = 0;
 
     /* Set the state to closed */
     channel->state = UA_SECURECHANNELSTATE_CLOSED;
@@ -310,6 +347,10 @@ adjustCheckMessageLimitsSym(UA_MessageContext *mc, size_t bodyLength) {
     mc->messageSizeSoFar += bodyLength;
     mc->chunksSoFar++;
 
+    /* The abort chunk is sent in any case */
+    if(mc->abort)
+        return UA_STATUSCODE_GOOD;
+
     UA_SecureChannel *channel = mc->channel;
     if(mc->messageSizeSoFar > channel->config.localMaxMessageSize &&
        channel->config.localMaxMessageSize != 0)
@@ -330,7 +371,9 @@ encodeHeadersSym(UA_MessageContext *mc, size_t totalLength) {
     UA_TcpMessageHeader header;
     header.messageTypeAndChunkType = mc->messageType;
     header.messageSize = (UA_UInt32)totalLength;
-    if(mc->final)
+    if(mc->abort)
+        header.messageTypeAndChunkType += UA_CHUNKTYPE_ABORT;
+    else if(mc->final)
         header.messageTypeAndChunkType += UA_CHUNKTYPE_FINAL;
     else
         header.messageTypeAndChunkType += UA_CHUNKTYPE_INTERMEDIATE;
@@ -354,6 +397,21 @@ encodeHeadersSym(UA_MessageContext *mc, size_t totalLength) {
     return res;
 }
 
+/* Send the queued chunks with a single call into the ConnectionManager */
+static UA_StatusCode
+flushSymmetricChunks(UA_MessageContext *mc) {
+    UA_SecureChannel *channel = mc->channel;
+    UA_ConnectionManager *cm = channel->connectionManager;
+    UA_StatusCode res =
+        cm->sendWithConnectionVector(cm, channel->connectionId, &UA_KEYVALUEMAP_NULL,
+                                     mc->queue, mc->queueSize);
+    mc->chunksSent += (UA_UInt16)mc->queueSize;
+    mc->queueSize = 0;
+    if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel))
+        channel->state = UA_SECURECHANNELSTATE_CLOSING;
+    return res;
+}
+
 static UA_StatusCode
 sendSymmetricChunk(UA_MessageContext *mc) {
     UA_SecureChannel *channel = mc->channel;
@@ -415,11 +473,22 @@ sendSymmetricChunk(UA_MessageContext *mc) {
     res = signAndEncryptSym(mc, pre_sig_length, total_length);
     UA_CHECK_STATUS(res, goto error);
 
+    /* Queue the chunk if the ConnectionManager can send several buffers at
+     * once. The queue is flushed when it is full and with the final chunk. */
+    if(cm->sendWithConnectionVector) {
+        mc->queue[mc->queueSize++] = mc->messageBuffer;
+        UA_ByteString_init(&mc->messageBuffer);
+        if(!mc->final && mc->queueSize < UA_MESSAGECONTEXT_QUEUESIZE)
+            return UA_STATUSCODE_GOOD;
+        return flushSymmetricChunks(mc);
+    }
+
     /* Send the chunk. The buffer is freed in the network layer. If sending goes
      * wrong, the connection is removed in the next iteration of the
      * SecureChannel. Set the SecureChannel to closing already. */
     res = cm->sendWithConnection(cm, channel->connectionId,
                                  &UA_KEYVALUEMAP_NULL, &mc->messageBuffer);
+    mc->chunksSent++;
     if(res != UA_STATUSCODE_GOOD && UA_SecureChannel_isConnected(channel))
         channel->state = UA_SECURECHANNELSTATE_CLOSING;
 
@@ -473,9 +542,12 @@ UA_MessageContext_begin(UA_MessageContext *mc, UA_SecureChannel *channel,
     mc->channel = channel;
     mc->requestId = requestId;
     mc->chunksSoFar = 0;
+    mc->chunksSent = 0;
     mc->messageSizeSoFar = 0;
     mc->final = false;
+    mc->abort = false;
     mc->messageBuffer = UA_BYTESTRING_NULL;
+    mc->queueSize = 0;
     mc->messageType = messageType;
 
     /* Allocate the message buffer */
@@ -496,7 +568,34 @@ UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
     UA_StatusCode res =
         UA_encodeBinaryInternal(content, contentType, &mc->buf_pos, &mc->buf_end,
                                 sendSymmetricEncodingCallback, mc);
-    if(res != UA_STATUSCODE_GOOD && mc->messageBuffer.length > 0)
+    if(res != UA_STATUSCODE_GOOD &&
+       (mc->messageBuffer.length > 0 || mc->queueSize > 0))
+        UA_MessageContext_abort(mc);
+    return res;
+}
+
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *raw) {
+    const UA_Byte *src = raw->data;
+    size_t left = raw->length;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    while(left > 0) {
+        /* Send the full chunk and continue in a new buffer */
+        if(mc->buf_pos == mc->buf_end) {
+            res = sendSymmetricEncodingCallback(mc, &mc->buf_pos, &mc->buf_end);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+        }
+        size_t len = (size_t)(mc->buf_end - mc->buf_pos);
+        if(len > left)
+            len = left;
+        memcpy(mc->buf_pos, src, len);
+        mc->buf_pos += len;
+        src += len;
+        left -= len;
+    }
+    if(res != UA_STATUSCODE_GOOD &&
+       (mc->messageBuffer.length > 0 || mc->queueSize > 0))
         UA_MessageContext_abort(mc);
     return res;
 }
@@ -513,6 +612,43 @@ UA_MessageContext_abort(UA_MessageContext *mc) {
     if(!UA_SecureChannel_isConnected(mc->channel))
         return;
     cm->freeNetworkBuffer(cm, mc->channel->connectionId, &mc->messageBuffer);
+
+    /* Drop the queued chunks that were not sent yet. They have the most
+     * recent sequence numbers which can be reused. */
+    for(size_t i = 0; i < mc->queueSize; i++)
+        cm->freeNetworkBuffer(cm, mc->channel->connectionId, &mc->queue[i]);
+    mc->channel->sendSequenceNumber -= (UA_UInt32)mc->queueSize;
+    mc->queueSize = 0;
+}
+
+UA_StatusCode
+UA_MessageContext_sendAbort(UA_MessageContext *mc, UA_StatusCode error) {
+    UA_MessageContext_abort(mc);
+    UA_SecureChannel *channel = mc->channel;
+    UA_ConnectionManager *cm = channel->connectionManager;
+    if(!UA_SecureChannel_isConnected(channel))
+        return UA_STATUSCODE_BADCONNECTIONCLOSED;
+
+    UA_StatusCode res =
+        cm->allocNetworkBuffer(cm, channel->connectionId, &mc->messageBuffer,
+                               channel->config.sendBufferSize);
+    UA_CHECK_STATUS(res, return res);
+    setBufPos(mc);
+
+    /* The body of the abort chunk is the error code and a reason */
+    UA_String reason = UA_STRING((char*)(uintptr_t)UA_StatusCode_name(error));
+    res |= UA_encodeBinaryInternal(&error, &UA_TYPES[UA_TYPES_STATUSCODE],
+                                   &mc->buf_pos, &mc->buf_end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&reason, &UA_TYPES[UA_TYPES_STRING],
+                                   &mc->buf_pos, &mc->buf_end, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD) {
+        cm->freeNetworkBuffer(cm, channel->connectionId, &mc->messageBuffer);
+        return res;
+    }
+
+    mc->final = true;
+    mc->abort = true;
+    return sendSymmetricChunk(mc);
 }
 
 UA_StatusCode
@@ -696,6 +832,37 @@ unpackPayloadMSG(UA_SecureChannel *channel, UA_Chunk *chunk,
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode
+processSegmentedMessage(UA_SecureChannel *channel, void *application,
+                        UA_ProcessMessageCallback callback,
+                        UA_UInt32 requestId, size_t chunksCount) {
+    UA_ByteString segmentsBuf[8];
+    UA_ByteString *segments = segmentsBuf;
+    if(chunksCount > 8) {
+        segments = (UA_ByteString*)UA_malloc(chunksCount * sizeof(UA_ByteString));
+        UA_CHECK_MEM(segments, return UA_STATUSCODE_BADOUTOFMEMORY);
+    }
+
+    /* Move the chunks of the message out of the queue. They are kept until
+     * the message is processed. */
+    UA_ChunkQueue message;
+    SIMPLEQ_INIT(&message);
+    for(size_t i = 0; i < chunksCount; i++) {
+        UA_Chunk *chunk = SIMPLEQ_FIRST(&channel->decryptedChunks);
+        SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
+        SIMPLEQ_INSERT_TAIL(&message, chunk, pointers);
+        segments[i] = chunk->bytes;
+    }
+
+    UA_StatusCode res = callback(application, channel, UA_MESSAGETYPE_MSG,
+                                 requestId, segments, chunksCount);
+
+    deleteChunks(channel, &message);
+    if(segments != segmentsBuf)
+        UA_free(segments);
+    return res;
+}
+
 static UA_StatusCode
 assembleProcessMessage(UA_SecureChannel *channel, void *application,
                        UA_ProcessMessageCallback callback) {
@@ -707,8 +874,8 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
         SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
         UA_assert(chunk->chunkType == UA_CHUNKTYPE_FINAL);
         res = callback(application, channel, chunk->messageType,
-                       chunk->requestId, &chunk->bytes);
-        UA_Chunk_delete(chunk);
+                       chunk->requestId, &chunk->bytes, 1);
+        UA_Chunk_delete(channel, chunk);
         return res;
     }
 
@@ -718,6 +885,7 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
     UA_assert(chunkType == UA_CHUNKTYPE_INTERMEDIATE);
 
     size_t messageSize = 0;
+    size_t chunksCount = 0;
     SIMPLEQ_FOREACH(chunk, &channel->decryptedChunks, pointers) {
         /* Consistency check */
         if(requestId != chunk->requestId)
@@ -729,30 +897,51 @@ assembleProcessMessage(UA_SecureChannel *channel, void *application,
 
         /* Sum up the lengths */
         messageSize += chunk->bytes.length;
+        chunksCount++;
         if(chunk->chunkType == UA_CHUNKTYPE_FINAL)
             break;
     }
 
-    /* Allocate memory for the full message */
+    /* MSG messages are not reassembled. The payloads of the chunks are decoded
+     * as segments. Large messages are then neither copied once more nor held
+     * twice in memory. */
+    if(messageType == UA_MESSAGETYPE_MSG)
+        return processSegmentedMessage(channel, application, callback,
+                                       requestId, chunksCount);
+
+    /* Use the buffer of the first chunk if it was persisted with enough
+     * capacity (see persistDecryptedChunks). Then the first part of the
+     * message is not copied once more. Otherwise allocate memory for the full
+     * message. */
     UA_ByteString payload;
-    res = UA_ByteString_allocBuffer(&payload, messageSize);
-    UA_CHECK_STATUS(res, return res);
+    size_t offset = 0;
+    chunk = SIMPLEQ_FIRST(&channel->decryptedChunks);
+    if(chunk->capacity > 0 && chunk->capacity >= messageSize) {
+        SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
+        payload = chunk->bytes;
+        offset = payload.length;
+        payload.length = messageSize;
+        chunk->copied = false; /* Take ownership of the buffer */
+        UA_Chunk_delete(channel, chunk);
+    } else {
+        res = UA_ByteString_allocBuffer(&payload, messageSize);
+        UA_CHECK_STATUS(res, return res);
+    }
 
     /* Assemble the full message */
-    size_t offset = 0;
     while(true) {
         chunk = SIMPLEQ_FIRST(&channel->decryptedChunks);
         memcpy(&payload.data[offset], chunk->bytes.data, chunk->bytes.length);
         offset += chunk->bytes.length;
         SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
         UA_ChunkType ct = chunk->chunkType;
-        UA_Chunk_delete(chunk);
+        UA_Chunk_delete(channel, chunk);
         if(ct == UA_CHUNKTYPE_FINAL)
             break;
     }
 
     /* Process the assembled message */
-    res = callback(application, channel, messageType, requestId, &payload);
+    res = callback(application, channel, messageType, requestId, &payload, 1);
     UA_ByteString_clear(&payload);
     return res;
 }
@@ -772,6 +961,65 @@ persistCompleteChunks(UA_ChunkQueue *queue) {
     return UA_STATUSCODE_GOOD;
 }
 
+/* The decrypted chunks that remain after processing are the intermediate
+ * chunks of an unfinished message. MSG chunks are decoded as segments and
+ * persisted individually. The chunks of other messages are coalesced into the
+ * buffer of the first chunk. The buffer grows geometrically and is reused for
+ * the assembled message. So every payload byte is copied only once and not
+ * every chunk needs its own allocation. */
+static UA_StatusCode
+persistDecryptedChunks(UA_SecureChannel *channel) {
+    UA_Chunk *first = SIMPLEQ_FIRST(&channel->decryptedChunks);
+    if(!first)
+        return UA_STATUSCODE_GOOD;
+    if(first->messageType == UA_MESSAGETYPE_MSG)
+        return persistCompleteChunks(&channel->decryptedChunks);
+
+    /* Consistency check and sum up the lengths */
+    size_t total = 0;
+    UA_Chunk *chunk;
+    SIMPLEQ_FOREACH(chunk, &channel->decryptedChunks, pointers) {
+        UA_assert(chunk->chunkType == UA_CHUNKTYPE_INTERMEDIATE);
+        if(first->requestId != chunk->requestId)
+            return UA_STATUSCODE_BADINTERNALERROR;
+        if(first->messageType != chunk->messageType)
+            return UA_STATUSCODE_BADTCPMESSAGETYPEINVALID;
+        total += chunk->bytes.length;
+    }
+
+    /* Make room in the buffer of the first chunk. A capacity is only set for
+     * buffers that were allocated here. */
+    if(first->capacity < total) {
+        size_t capacity = first->capacity * 2;
+        if(capacity < total)
+            capacity = total;
+        UA_Byte *data;
+        if(first->capacity > 0) {
+            data = (UA_Byte*)UA_realloc(first->bytes.data, capacity);
+            UA_CHECK_MEM(data, return UA_STATUSCODE_BADOUTOFMEMORY);
+        } else {
+            data = (UA_Byte*)UA_malloc(capacity);
+            UA_CHECK_MEM(data, return UA_STATUSCODE_BADOUTOFMEMORY);
+            memcpy(data, first->bytes.data, first->bytes.length);
+            if(first->copied)
+                UA_free(first->bytes.data);
+        }
+        first->bytes.data = data;
+        first->copied = true;
+        first->capacity = capacity;
+    }
+
+    /* Move the following chunks into the first */
+    while((chunk = SIMPLEQ_NEXT(first, pointers))) {
+        memcpy(&first->bytes.data[first->bytes.length],
+               chunk->bytes.data, chunk->bytes.length);
+        first->bytes.length += chunk->bytes.length;
+        SIMPLEQ_REMOVE_AFTER(&channel->decryptedChunks, first, pointers);
+        UA_Chunk_delete(channel, chunk);
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 static UA_StatusCode
 persistIncompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
                        size_t offset) {
@@ -784,12 +1032,13 @@ persistIncompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
     return UA_STATUSCODE_GOOD;
 }
 
-/* Processes chunks and puts them into the payloads queue. Once a final chunk is
- * put into the queue, the message is assembled and the callback is called. The
- * queue will be cleared for the next message. */
+/* Check, decrypt and unpack the chunks in the complete-chunk queue and append
+ * them to the decrypted-chunk queue. All MSG chunks received in one buffer are
+ * decrypted in one go before any message is dispatched. The batch ends after
+ * any other chunk type, as processing OPN, CLO, HEL, etc. changes the state
+ * (and the keys) needed to unpack the following chunks. */
 static UA_StatusCode
-processChunks(UA_SecureChannel *channel, void *application,
-              UA_ProcessMessageCallback callback,
+decryptChunks(UA_SecureChannel *channel, void *application,
               UA_DateTime nowMonotonic) {
     UA_Chunk *chunk;
     UA_StatusCode res = UA_STATUSCODE_GOOD;
@@ -803,8 +1052,18 @@ processChunks(UA_SecureChannel *channel, void *application,
                channel->state != UA_SECURECHANNELSTATE_OPN_SENT &&
                channel->state != UA_SECURECHANNELSTATE_ACK_SENT)
                 res = UA_STATUSCODE_BADINVALIDSTATE;
-            else
+            else {
+#if UA_MULTITHREADING >= 100
+                UA_Lock *opnLock = channel->opnLock;
+                if(opnLock)
+                    UA_LOCK_SHARED(opnLock);
+#endif
                 res = unpackPayloadOPN(channel, chunk, application);
+#if UA_MULTITHREADING >= 100
+                if(opnLock)
+                    UA_UNLOCK_SHARED(opnLock);
+#endif
+            }
         } else if(chunk->messageType == UA_MESSAGETYPE_MSG ||
                   chunk->messageType == UA_MESSAGETYPE_CLO) {
             if(channel->state == UA_SECURECHANNELSTATE_CLOSED)
@@ -817,7 +1076,7 @@ processChunks(UA_SecureChannel *channel, void *application,
         }
 
         if(res != UA_STATUSCODE_GOOD) {
-            UA_Chunk_delete(chunk);
+            UA_Chunk_delete(channel, chunk);
             return res;
         }
 
@@ -834,30 +1093,68 @@ processChunks(UA_SecureChannel *channel, void *application,
             return UA_STATUSCODE_BADTCPMESSAGETOOLARGE;
         }
 
-        /* Waiting for additional chunks */
-        if(chunk->chunkType == UA_CHUNKTYPE_INTERMEDIATE)
-            continue;
-
         /* Final chunk or abort. Reset the counters. */
-        channel->decryptedChunksCount = 0;
-        channel->decryptedChunksLength = 0;
+        if(chunk->chunkType != UA_CHUNKTYPE_INTERMEDIATE) {
+            channel->decryptedChunksCount = 0;
+            channel->decryptedChunksLength = 0;
+        }
+
+        /* End of the batch */
+        if(chunk->messageType != UA_MESSAGETYPE_MSG)
+            break;
+    }
+    return UA_STATUSCODE_GOOD;
+}
 
-        /* Abort the message, remove all decrypted chunks
+/* Dispatch the complete messages in the decrypted-chunk queue in order. Chunks
+ * of an unfinished message remain in the queue. */
+static UA_StatusCode
+dispatchChunks(UA_SecureChannel *channel, void *application,
+               UA_ProcessMessageCallback callback) {
+    UA_Chunk *chunk;
+    while((chunk = SIMPLEQ_FIRST(&channel->decryptedChunks))) {
+        /* Find the end of the first message */
+        while(chunk && chunk->chunkType == UA_CHUNKTYPE_INTERMEDIATE)
+            chunk = SIMPLEQ_NEXT(chunk, pointers);
+        if(!chunk)
+            break; /* Waiting for additional chunks */
+
+        /* Abort the message, remove its decrypted chunks
          * TODO: Log a warning with the error code */
         if(chunk->chunkType == UA_CHUNKTYPE_ABORT) {
-            while((chunk = SIMPLEQ_FIRST(&channel->decryptedChunks))) {
+            UA_ChunkType ct;
+            do {
+                chunk = SIMPLEQ_FIRST(&channel->decryptedChunks);
                 SIMPLEQ_REMOVE_HEAD(&channel->decryptedChunks, pointers);
-                UA_Chunk_delete(chunk);
-            }
+                ct = chunk->chunkType;
+                UA_Chunk_delete(channel, chunk);
+            } while(ct != UA_CHUNKTYPE_ABORT);
             continue;
         }
 
         /* The decrypted queue contains a full message. Process it. */
         UA_assert(chunk->chunkType == UA_CHUNKTYPE_FINAL);
-        res = assembleProcessMessage(channel, application, callback);
+        UA_StatusCode res = assembleProcessMessage(channel, application, callback);
         UA_CHECK_STATUS(res, return res);
     }
+    return UA_STATUSCODE_GOOD;
+}
 
+/* Processes chunks in batches. First the chunks are decrypted and put into the
+ * payloads queue. Then the complete messages are assembled and the callback is
+ * called. Chunks of completed messages are removed from the queue. */
+static UA_StatusCode
+processChunks(UA_SecureChannel *channel, void *application,
+              UA_ProcessMessageCallback callback,
+              UA_DateTime nowMonotonic) {
+    while(!SIMPLEQ_EMPTY(&channel->completeChunks)) {
+        /* The messages decrypted before an error are still dispatched. Like
+         * they would have been without batching. */
+        UA_StatusCode decryptRes = decryptChunks(channel, application, nowMonotonic);
+        UA_StatusCode res = dispatchChunks(channel, application, callback);
+        UA_CHECK_STATUS(decryptRes, return decryptRes);
+        UA_CHECK_STATUS(res, return res);
+    }
     return UA_STATUSCODE_GOOD;
 }
 
@@ -920,14 +1217,12 @@ extractCompleteChunk(UA_SecureChannel *channel, const UA_ByteString *buffer,
 
     /* Add the chunk; forward the offset */
     *offset += hdr.messageSize;
-    UA_Chunk *chunk = (UA_Chunk*)UA_malloc(sizeof(UA_Chunk));
+    UA_Chunk *chunk = UA_Chunk_new(channel);
     UA_CHECK_MEM(chunk, return UA_STATUSCODE_BADOUTOFMEMORY);
 
     chunk->bytes = chunkPayload;
     chunk->messageType = msgType;
     chunk->chunkType = chunkType;
-    chunk->requestId = 0;
-    chunk->copied = false;
 
     SIMPLEQ_INSERT_TAIL(&channel->completeChunks, chunk, pointers);
     return UA_STATUSCODE_GOOD;
@@ -955,13 +1250,22 @@ UA_SecureChannel_processBuffer(UA_SecureChannel *channel, void *application,
 
     /* Loop over the received chunks */
     size_t offset = 0;
+    size_t chunks = 0;
     UA_Boolean done = false;
     UA_StatusCode res;
     while(!done) {
         res = extractCompleteChunk(channel, buffer, &offset, &done);
         UA_CHECK_STATUS(res, goto cleanup);
+        if(!done)
+            chunks++;
     }
 
+    /* Update the statistics */
+    channel->receivedBufferCount++;
+    channel->receivedChunkCount += chunks;
+    if(chunks > channel->maxChunksPerBuffer)
+        channel->maxChunksPerBuffer = chunks;
+
     /* Buffer half-received chunk. Before processing the messages so that
      * processing is reentrant. */
     if(offset < buffer->length) {
@@ -974,10 +1278,10 @@ UA_SecureChannel_processBuffer(UA_SecureChannel *channel, void *application,
     res = processChunks(channel, application, callback, nowMonotonic);
     UA_CHECK_STATUS(res, goto cleanup);
 
-    /* Persist full chunks that still point to the buffer. Can only return
-     * UA_STATUSCODE_BADOUTOFMEMORY as an error code. So merging res works. */
-    res |= persistCompleteChunks(&channel->completeChunks);
-    res |= persistCompleteChunks(&channel->decryptedChunks);
+    /* Persist full chunks that still point to the buffer */
+    res = persistCompleteChunks(&channel->completeChunks);
+    UA_CHECK_STATUS(res, goto cleanup);
+    res = persistDecryptedChunks(channel);
 
  cleanup:
     UA_ByteString_clear(&appended);
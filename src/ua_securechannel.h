@@ -69,6 +69,7 @@ typedef struct UA_Chunk {
     UA_UInt32 requestId;
     UA_Boolean copied; /* Do the bytes point to a buffer from the network or was
                         * memory allocated for the chunk separately */
+    size_t capacity;   /* Allocated length if copied (can exceed bytes.length) */
 } UA_Chunk;
 
 typedef SIMPLEQ_HEAD(UA_ChunkQueue, UA_Chunk) UA_ChunkQueue;
@@ -151,10 +152,25 @@ struct UA_SecureChannel {
     size_t decryptedChunksLength;
     UA_ByteString incompleteChunk; /* A half-received chunk (TCP is a
                                     * streaming protocol) is stored here */
+    UA_ChunkQueue freeChunks; /* Chunk structures kept for reuse */
+    size_t freeChunksCount;
+
+    /* Receive statistics */
+    size_t receivedBufferCount; /* Buffers given to processBuffer */
+    size_t receivedChunkCount;  /* Complete chunks found in the buffers */
+    size_t maxChunksPerBuffer;  /* Largest batch of chunks from one buffer */
 
     UA_CertificateGroup *certificateVerification;
     UA_StatusCode (*processOPNHeader)(void *application, UA_SecureChannel *channel,
                                       const UA_AsymmetricAlgorithmSecurityHeader *asymHeader);
+
+#if UA_MULTITHREADING >= 100
+    /* If set, the OPN chunks are unpacked (certificate verification, selection
+     * of the SecurityPolicy, asymmetric decryption) under the shared side of
+     * this lock. The server sets it for the channels of the network
+     * EventLoops, where the buffers are processed without the service lock. */
+    UA_Lock *opnLock;
+#endif
 };
 
 void UA_SecureChannel_init(UA_SecureChannel *channel);
@@ -224,6 +240,12 @@ UA_SecureChannel_sendSymmetricMessage(UA_SecureChannel *channel, UA_UInt32 reque
                                       UA_MessageType messageType, void *payload,
                                       const UA_DataType *payloadType);
 
+/* Number of finished chunks that are queued up before they are sent at once.
+ * Only used if the ConnectionManager supports vectored sending. */
+#ifndef UA_MESSAGECONTEXT_QUEUESIZE
+# define UA_MESSAGECONTEXT_QUEUESIZE 8
+#endif
+
 /* The MessageContext is forwarded into the encoding layer so that we can send
  * chunks before continuing to encode. This lets us reuse a fixed chunk-sized
  * messages buffer. */
@@ -233,13 +255,18 @@ typedef struct {
     UA_UInt32 messageType;
 
     UA_UInt16 chunksSoFar;
+    UA_UInt16 chunksSent; /* Handed to the ConnectionManager */
     size_t messageSizeSoFar;
 
     UA_ByteString messageBuffer;
     UA_Byte *buf_pos;
     const UA_Byte *buf_end;
 
+    UA_ByteString queue[UA_MESSAGECONTEXT_QUEUESIZE];
+    size_t queueSize;
+
     UA_Boolean final;
+    UA_Boolean abort;
 } UA_MessageContext;
 
 /* Start the context of a new symmetric message. */
@@ -254,6 +281,11 @@ UA_StatusCode
 UA_MessageContext_encode(UA_MessageContext *mc, const void *content,
                          const UA_DataType *contentType);
 
+/* Append content that is already in the binary encoding. Full chunks are sent
+ * out like in _encode. */
+UA_StatusCode
+UA_MessageContext_encodeRaw(UA_MessageContext *mc, const UA_ByteString *raw);
+
 /* Sends a symmetric message already encoded in the context. The context is
  * cleaned up, also in case of errors. */
 UA_StatusCode
@@ -265,14 +297,23 @@ UA_MessageContext_finish(UA_MessageContext *mc);
 void
 UA_MessageContext_abort(UA_MessageContext *mc);
 
+/* Aborts a message of which intermediate chunks have already been sent. The
+ * unsent content is dropped and an abort chunk with the error code is sent
+ * instead of the final chunk. */
+UA_StatusCode
+UA_MessageContext_sendAbort(UA_MessageContext *mc, UA_StatusCode error);
+
 /**
  * Receive Message
  * --------------- */
 
+/* MSG messages that were sent in several chunks are not reassembled. Then the
+ * message points to an array of the chunk payloads. They are decoded with
+ * UA_decodeBinaryInternalSegments. All other messages have a single segment. */
 typedef UA_StatusCode
 (UA_ProcessMessageCallback)(void *application, UA_SecureChannel *channel,
                             UA_MessageType messageType, UA_UInt32 requestId,
-                            UA_ByteString *message);
+                            UA_ByteString *message, size_t messageSegments);
 
 /* Process a received buffer. The callback function is called with the message
  * body if the message is complete. The message is removed afterwards. Returns
@@ -430,10 +430,24 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
                       const UA_SecurityPolicyCryptoModule *cryptoModule,
                       UA_MessageType messageType, UA_ByteString *chunk,
                       size_t offset) {
-    /* Decrypt the chunk */
+    /* Decrypt and verify in one pass over the chunk if the symmetric policy
+     * supports it */
     UA_StatusCode res = UA_STATUSCODE_GOOD;
-    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
-       messageType == UA_MESSAGETYPE_OPN) {
+    UA_Boolean verified = false;
+    if(channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT &&
+       messageType != UA_MESSAGETYPE_OPN && cryptoModule->decryptAndVerify) {
+        res = cryptoModule->decryptAndVerify(channel->channelContext, chunk, offset);
+        UA_CHECK_STATUS(res,
+           UA_LOG_WARNING_CHANNEL(channel->securityPolicy->logger, channel,
+                                  "Could not decrypt and verify the chunk");
+           return res);
+        verified = true;
+    }
+
+    /* Decrypt the chunk */
+    if(!verified &&
+       (channel->securityMode == UA_MESSAGESECURITYMODE_SIGNANDENCRYPT ||
+        messageType == UA_MESSAGETYPE_OPN)) {
         UA_ByteString cipher = {chunk->length - offset, chunk->data + offset};
         res = cryptoModule->encryptionAlgorithm.decrypt(channel->channelContext, &cipher);
         UA_CHECK_STATUS(res, return res);
@@ -449,10 +463,12 @@ decryptAndVerifyChunk(const UA_SecureChannel *channel,
     /* Verify the chunk signature */
     size_t sigsize = cryptoModule->signatureAlgorithm.
         getRemoteSignatureSize(channel->channelContext);
-    res = verifySignature(channel, cryptoModule, chunk, sigsize);
-    UA_CHECK_STATUS(res,
-       UA_LOG_WARNING_CHANNEL(channel->securityPolicy->logger, channel,
-                              "Could not verify the signature"); return res);
+    if(!verified) {
+        res = verifySignature(channel, cryptoModule, chunk, sigsize);
+        UA_CHECK_STATUS(res,
+           UA_LOG_WARNING_CHANNEL(channel->securityPolicy->logger, channel,
+                                  "Could not verify the signature"); return res);
+    }
 
     /* Compute the padding if the payload as encrypted */
     size_t padSize = 0;
@@ -20,6 +20,7 @@
 #include <open62541/types_generated_handling.h>
 
 #include "util/ua_util_internal.h"
+#include "ua_types_encoding_binary.h"
 #include "../deps/itoa.h"
 #include "../deps/base64.h"
 #include "libc_time.h"
@@ -60,18 +61,18 @@ expandedNodeIdOrder(const UA_ExpandedNodeId *p1, const UA_ExpandedNodeId *p2,
 static UA_Order
 guidOrder(const UA_Guid *p1, const UA_Guid *p2, const UA_DataType *_);
 
+/* Defined below. The hash index over the builtin types. */
+static const UA_DataType *
+findBuiltinType(const UA_NodeId *typeId);
+
 const UA_DataType *
 UA_findDataTypeWithCustom(const UA_NodeId *typeId,
                           const UA_DataTypeArray *customTypes) {
     /* Always look in built-in types first (may contain data types from all
-     * namespaces).
-     *
-     * TODO: The standard-defined types are ordered. See if binary search is
-     * more efficient. */
-    for(size_t i = 0; i < UA_TYPES_COUNT; ++i) {
-        if(nodeIdOrder(&UA_TYPES[i].typeId, typeId, NULL) == UA_ORDER_EQ)
-            return &UA_TYPES[i];
-    }
+     * namespaces) */
+    const UA_DataType *type = findBuiltinType(typeId);
+    if(type)
+        return type;
 
     /* Search in the customTypes */
     while(customTypes) {
@@ -90,6 +91,174 @@ UA_findDataType(const UA_NodeId *typeId) {
     return UA_findDataTypeWithCustom(typeId, NULL);
 }
 
+/* Open addressing with linear probing. The table has at least twice as many
+ * slots as types. */
+struct UA_DataTypeIndex {
+    size_t mask; /* Number of slots minus one */
+    const UA_DataType **byTypeId;
+    const UA_DataType **byBinaryEncodingId;
+};
+
+static void
+indexInsert(const UA_DataType **table, size_t mask, const UA_NodeId *id,
+            const UA_DataType *type, size_t idOffset) {
+    size_t slot = UA_NodeId_hash(id) & mask;
+    while(table[slot]) {
+        /* The first type with the identifier wins */
+        const UA_NodeId *other = (const UA_NodeId*)
+            ((uintptr_t)table[slot] + idOffset);
+        if(nodeIdOrder(other, id, NULL) == UA_ORDER_EQ)
+            return;
+        slot = (slot + 1) & mask;
+    }
+    table[slot] = type;
+}
+
+static const UA_DataType *
+indexFind(const UA_DataType *const *table, size_t mask, const UA_NodeId *id,
+          size_t idOffset) {
+    size_t slot = UA_NodeId_hash(id) & mask;
+    while(table[slot]) {
+        const UA_NodeId *other = (const UA_NodeId*)
+            ((uintptr_t)table[slot] + idOffset);
+        if(nodeIdOrder(other, id, NULL) == UA_ORDER_EQ)
+            return table[slot];
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+static void
+indexInsertTypes(UA_DataTypeIndex *index, const UA_DataType *types, size_t typesSize) {
+    for(size_t i = 0; i < typesSize; i++) {
+        const UA_DataType *type = &types[i];
+        indexInsert(index->byTypeId, index->mask, &type->typeId, type,
+                    offsetof(UA_DataType, typeId));
+        /* Enumerations and other types without a binary encoding */
+        if(!UA_NodeId_isNull(&type->binaryEncodingId))
+            indexInsert(index->byBinaryEncodingId, index->mask,
+                        &type->binaryEncodingId, type,
+                        offsetof(UA_DataType, binaryEncodingId));
+    }
+}
+
+UA_DataTypeIndex *
+UA_DataTypeIndex_new(const UA_DataTypeArray *customTypes) {
+    size_t typesSize = UA_TYPES_COUNT;
+    for(const UA_DataTypeArray *ct = customTypes; ct; ct = ct->next)
+        typesSize += ct->typesSize;
+    size_t slots = 16;
+    while(slots < typesSize * 2)
+        slots <<= 1;
+
+    UA_DataTypeIndex *index = (UA_DataTypeIndex*)
+        UA_calloc(1, sizeof(UA_DataTypeIndex) + (2 * slots * sizeof(UA_DataType*)));
+    if(!index)
+        return NULL;
+    index->mask = slots - 1;
+    index->byTypeId = (const UA_DataType**)(uintptr_t)&index[1];
+    index->byBinaryEncodingId = &index->byTypeId[slots];
+
+    /* Same order as the linear search */
+    indexInsertTypes(index, UA_TYPES, UA_TYPES_COUNT);
+    for(const UA_DataTypeArray *ct = customTypes; ct; ct = ct->next)
+        indexInsertTypes(index, ct->types, ct->typesSize);
+    return index;
+}
+
+void
+UA_DataTypeIndex_delete(UA_DataTypeIndex *index) {
+    UA_free(index);
+}
+
+const UA_DataType *
+UA_DataTypeIndex_find(const UA_DataTypeIndex *index, const UA_NodeId *typeId) {
+    return indexFind(index->byTypeId, index->mask, typeId,
+                     offsetof(UA_DataType, typeId));
+}
+
+const UA_DataType *
+UA_DataTypeIndex_findBinary(const UA_DataTypeIndex *index,
+                            const UA_NodeId *binaryEncodingId) {
+    return indexFind(index->byBinaryEncodingId, index->mask, binaryEncodingId,
+                     offsetof(UA_DataType, binaryEncodingId));
+}
+
+/* The builtin types never change. Their index is built once on first use into
+ * static tables. The thread that claims the build fills the tables and then
+ * publishes them. Until then, the lookups fall back to the linear search. */
+#if UA_TYPES_COUNT <= 256
+# define UA_TYPES_INDEXSLOTS 512
+#elif UA_TYPES_COUNT <= 512
+# define UA_TYPES_INDEXSLOTS 1024
+#elif UA_TYPES_COUNT <= 1024
+# define UA_TYPES_INDEXSLOTS 2048
+#else
+# define UA_TYPES_INDEXSLOTS 4096
+#endif
+UA_STATIC_ASSERT(UA_TYPES_COUNT <= UA_TYPES_INDEXSLOTS / 2, builtin_index_too_small);
+
+typedef struct {
+    const UA_DataType *byTypeId[UA_TYPES_INDEXSLOTS];
+    const UA_DataType *byBinaryEncodingId[UA_TYPES_INDEXSLOTS];
+} UA_BuiltinTypeIndex;
+
+static UA_BuiltinTypeIndex builtinIndexTables;
+static void * volatile builtinIndexClaimed = NULL;
+static void * volatile builtinIndex = NULL; /* Points to the tables when ready */
+
+static const UA_BuiltinTypeIndex *
+getBuiltinIndex(void) {
+    const UA_BuiltinTypeIndex *bi = (const UA_BuiltinTypeIndex*)builtinIndex;
+    if(UA_LIKELY(bi != NULL))
+        return bi;
+    if(UA_atomic_cmpxchg(&builtinIndexClaimed, NULL, (void*)0x01) != NULL)
+        return NULL; /* Built by another thread */
+    const size_t mask = UA_TYPES_INDEXSLOTS - 1;
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        const UA_DataType *type = &UA_TYPES[i];
+        indexInsert(builtinIndexTables.byTypeId, mask, &type->typeId, type,
+                    offsetof(UA_DataType, typeId));
+        if(!UA_NodeId_isNull(&type->binaryEncodingId))
+            indexInsert(builtinIndexTables.byBinaryEncodingId, mask,
+                        &type->binaryEncodingId, type,
+                        offsetof(UA_DataType, binaryEncodingId));
+    }
+    UA_atomic_cmpxchg(&builtinIndex, NULL, &builtinIndexTables);
+    return &builtinIndexTables;
+}
+
+static const UA_DataType *
+findBuiltinType(const UA_NodeId *typeId) {
+    const UA_BuiltinTypeIndex *bi = getBuiltinIndex();
+    if(bi)
+        return indexFind(bi->byTypeId, UA_TYPES_INDEXSLOTS - 1, typeId,
+                         offsetof(UA_DataType, typeId));
+    for(size_t i = 0; i < UA_TYPES_COUNT; ++i) {
+        if(nodeIdOrder(&UA_TYPES[i].typeId, typeId, NULL) == UA_ORDER_EQ)
+            return &UA_TYPES[i];
+    }
+    return NULL;
+}
+
+const UA_DataType *
+UA_findDataTypeByBinary(const UA_NodeId *binaryEncodingId) {
+    const UA_BuiltinTypeIndex *bi = getBuiltinIndex();
+    if(bi)
+        return indexFind(bi->byBinaryEncodingId, UA_TYPES_INDEXSLOTS - 1,
+                         binaryEncodingId, offsetof(UA_DataType, binaryEncodingId));
+    if(binaryEncodingId->identifierType != UA_NODEIDTYPE_NUMERIC)
+        return NULL;
+    for(size_t i = 0; i < UA_TYPES_COUNT; ++i) {
+        if(UA_TYPES[i].binaryEncodingId.identifier.numeric ==
+           binaryEncodingId->identifier.numeric &&
+           UA_TYPES[i].binaryEncodingId.namespaceIndex ==
+           binaryEncodingId->namespaceIndex)
+            return &UA_TYPES[i];
+    }
+    return NULL;
+}
+
 void
 UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes) {
     while (customTypes) {
@@ -105,6 +274,10 @@ UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes) {
                 }
 #endif
                 UA_free((void*)type->members);
+                /* The identifiers are allocated for types that are generated
+                 * at runtime */
+                UA_NodeId_clear((UA_NodeId*)(uintptr_t)&type->typeId);
+                UA_NodeId_clear((UA_NodeId*)(uintptr_t)&type->binaryEncodingId);
             }
             UA_free((void*)(uintptr_t)customTypes->types);
             UA_free((void*)(uintptr_t)customTypes);
@@ -371,14 +544,46 @@ UA_NodeId_order(const UA_NodeId *n1, const UA_NodeId *n2) {
     return nodeIdOrder(n1, n2, NULL);
 }
 
-/* sdbm-hash (http://www.cse.yorku.ca/~oz/hash.html) */
+/* Non-cryptographic hash in the style of wyhash/xxh3. The input is consumed
+ * eight bytes at a time and the state is finalized with the Murmur3/xxh64
+ * avalanche. Only 64bit multiplications are used, no 128bit integer type is
+ * required. The result depends on the endianness and must not be persisted. */
+#define UA_HASH_P0 0xa0761d6478bd642fULL
+#define UA_HASH_P1 0xe7037ed1a0b428dbULL
+#define UA_HASH_P2 0x8ebc6af09c88c6e3ULL
+
+static UA_INLINE u64
+hashMix(u64 h, u64 w) {
+    h ^= w * UA_HASH_P0;
+    h = (h << 31) | (h >> 33);
+    return h * UA_HASH_P1;
+}
+
+static UA_INLINE u32
+hashFinal(u64 h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (u32)h;
+}
+
 u32
 UA_ByteString_hash(u32 initialHashValue,
                    const u8 *data, size_t size) {
-    u32 h = initialHashValue;
-    for(size_t i = 0; i < size; i++)
-        h = data[i] + (h << 6) + (h << 16) - h;
-    return h;
+    u64 h = ((u64)initialHashValue ^ UA_HASH_P2) + ((u64)size * UA_HASH_P0);
+    u64 w;
+    for(; size >= 8; data += 8, size -= 8) {
+        memcpy(&w, data, 8);
+        h = hashMix(h, w);
+    }
+    if(size > 0) {
+        w = 0;
+        memcpy(&w, data, size);
+        h = hashMix(h, w);
+    }
+    return hashFinal(h);
 }
 
 u32
@@ -386,8 +591,10 @@ UA_NodeId_hash(const UA_NodeId *n) {
     switch(n->identifierType) {
     case UA_NODEIDTYPE_NUMERIC:
     default:
-        return UA_ByteString_hash(n->namespaceIndex, (const u8*)&n->identifier.numeric,
-                                  sizeof(UA_UInt32));
+        /* Fast path without the byte loop. The finalizer is a bijection on
+         * 64bit. So distinct numeric NodeIds only collide after truncation. */
+        return hashFinal((((u64)n->namespaceIndex << 32) |
+                          n->identifier.numeric) ^ UA_HASH_P2);
     case UA_NODEIDTYPE_STRING:
     case UA_NODEIDTYPE_BYTESTRING:
         return UA_ByteString_hash(n->namespaceIndex, n->identifier.string.data,
@@ -700,6 +907,39 @@ UA_ExtensionObject_setValueCopy(UA_ExtensionObject *eo,
 }
 
 /* Variant */
+
+/* The header of a shared variant payload. The data follows after the header.
+ * The type and length are kept in the header since the variants referencing
+ * the payload can change their type (e.g. from an Int32 to an enum). */
+typedef struct {
+    volatile UA_UInt32 refCount;
+    const UA_DataType *type;
+    size_t length;
+} SharedPayload;
+
+/* Padded for the alignment of the data */
+#define SHAREDPAYLOAD_HEADERSIZE ((sizeof(SharedPayload) + 15) & ~(size_t)15)
+
+static SharedPayload *
+getSharedPayload(const void *data) {
+    return (SharedPayload*)((uintptr_t)data - SHAREDPAYLOAD_HEADERSIZE);
+}
+
+static void
+releaseSharedPayload(void *data) {
+    SharedPayload *sp = getSharedPayload(data);
+    if(UA_atomic_subUInt32(&sp->refCount, 1) > 0)
+        return;
+    if(!sp->type->pointerFree) {
+        uintptr_t ptr = (uintptr_t)data;
+        for(size_t i = 0; i < sp->length; i++) {
+            clearJumpTable[sp->type->typeKind]((void*)ptr, sp->type);
+            ptr += sp->type->memSize;
+        }
+    }
+    UA_free(sp);
+}
+
 static void
 Variant_clear(UA_Variant *p, const UA_DataType *_) {
     /* The content is "borrowed" */
@@ -708,9 +948,13 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
     /* Delete the value */
     if(p->type && p->data > UA_EMPTY_ARRAY_SENTINEL) {
-        if(p->arrayLength == 0)
-            p->arrayLength = 1;
-        UA_Array_delete(p->data, p->arrayLength, p->type);
+        if(p->storageType == UA_VARIANT_DATA_SHARED) {
+            releaseSharedPayload(p->data);
+        } else {
+            if(p->arrayLength == 0)
+                p->arrayLength = 1;
+            UA_Array_delete(p->data, p->arrayLength, p->type);
+        }
         p->data = NULL;
     }
 
@@ -721,13 +965,21 @@ Variant_clear(UA_Variant *p, const UA_DataType *_) {
 
 static UA_StatusCode
 Variant_copy(UA_Variant const *src, UA_Variant *dst, const UA_DataType *_) {
-    size_t length = src->arrayLength;
-    if(UA_Variant_isScalar(src))
-        length = 1;
-    UA_StatusCode retval = UA_Array_copy(src->data, length,
-                                         &dst->data, src->type);
-    if(retval != UA_STATUSCODE_GOOD)
-        return retval;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if(src->storageType == UA_VARIANT_DATA_SHARED &&
+       src->data > UA_EMPTY_ARRAY_SENTINEL) {
+        /* Take another reference to the shared payload */
+        UA_atomic_addUInt32(&getSharedPayload(src->data)->refCount, 1);
+        dst->data = src->data;
+        dst->storageType = UA_VARIANT_DATA_SHARED;
+    } else {
+        size_t length = src->arrayLength;
+        if(UA_Variant_isScalar(src))
+            length = 1;
+        retval = UA_Array_copy(src->data, length, &dst->data, src->type);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
     dst->arrayLength = src->arrayLength;
     dst->type = src->type;
     if(src->arrayDimensions) {
@@ -786,6 +1038,77 @@ UA_Variant_setArrayCopy(UA_Variant *v, const void * UA_RESTRICT array,
     return UA_STATUSCODE_GOOD;
 }
 
+UA_StatusCode
+UA_Variant_share(UA_Variant *v) {
+    if(v->storageType == UA_VARIANT_DATA_SHARED || !v->type ||
+       v->data <= UA_EMPTY_ARRAY_SENTINEL)
+        return UA_STATUSCODE_GOOD;
+
+    const UA_DataType *type = v->type;
+    size_t length = (UA_Variant_isScalar(v)) ? 1 : v->arrayLength;
+    SharedPayload *sp = (SharedPayload*)
+        UA_malloc(SHAREDPAYLOAD_HEADERSIZE + (length * type->memSize));
+    if(!sp)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    sp->refCount = 1;
+    sp->type = type;
+    sp->length = length;
+    void *data = (void*)((uintptr_t)sp + SHAREDPAYLOAD_HEADERSIZE);
+
+    /* Owned data is moved into the payload */
+    if(v->storageType == UA_VARIANT_DATA) {
+        memcpy(data, v->data, length * type->memSize);
+        UA_free(v->data);
+        v->data = data;
+        v->storageType = UA_VARIANT_DATA_SHARED;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Borrowed data and array dimensions are copied */
+    UA_UInt32 *dims = NULL;
+    UA_StatusCode res = UA_STATUSCODE_GOOD;
+    if(v->arrayDimensionsSize > 0) {
+        res = UA_Array_copy(v->arrayDimensions, v->arrayDimensionsSize,
+                            (void**)&dims, &UA_TYPES[UA_TYPES_UINT32]);
+        if(res != UA_STATUSCODE_GOOD) {
+            UA_free(sp);
+            return res;
+        }
+    }
+    uintptr_t src = (uintptr_t)v->data;
+    uintptr_t dst = (uintptr_t)data;
+    for(size_t i = 0; i < length; i++) {
+        res = UA_copy((void*)src, (void*)dst, type);
+        if(res != UA_STATUSCODE_GOOD) {
+            sp->length = i;
+            sp->refCount = 1;
+            releaseSharedPayload(data);
+            UA_free(dims);
+            return res;
+        }
+        src += type->memSize;
+        dst += type->memSize;
+    }
+    v->data = data;
+    v->arrayDimensions = dims;
+    v->storageType = UA_VARIANT_DATA_SHARED;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Shared data is immutable. Replace with a private copy before modifying. */
+static UA_StatusCode
+Variant_unshare(UA_Variant *v) {
+    size_t length = (UA_Variant_isScalar(v)) ? 1 : v->arrayLength;
+    void *data = NULL;
+    UA_StatusCode res = UA_Array_copy(v->data, length, &data, v->type);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    releaseSharedPayload(v->data);
+    v->data = data;
+    v->storageType = UA_VARIANT_DATA;
+    return UA_STATUSCODE_GOOD;
+}
+
 /* Test if a range is compatible with a variant. This may adjust the upper bound
  * (max) in order to fit the variant. */
 static UA_StatusCode
@@ -837,21 +1160,24 @@ checkAdjustRange(const UA_Variant *v, UA_NumericRange *range) {
     return UA_STATUSCODE_GOOD;
 }
 
-/* Computes the stride for copying the range elements.
- * - total: how many elements are in the range
- * - block: how big is each contiguous block of elements in the variant that
- *   maps into the range
- * - stride: how many elements are between the blocks (beginning to beginning)
- * - first: where does the first block begin */
-static void
-computeStrides(const UA_Variant *v, const UA_NumericRange range,
-               size_t *total, size_t *block, size_t *stride, size_t *first) {
-    /* Number of total elements to be copied */
-    size_t count = 1;
-    for(size_t i = 0; i < range.dimensionsSize; ++i)
-        count *= (range.dimensions[i].max - range.dimensions[i].min) + 1;
-    *total = count;
+/* Iterates over the contiguous blocks of elements of a range within a
+ * (multi-dimensional) array. The innermost dimensions that are entirely
+ * covered by the range are merged with the first partially covered dimension
+ * into one block. The remaining outer dimensions are iterated like an
+ * odometer. Call checkAdjustRange before. */
+typedef struct {
+    size_t total;  /* Number of elements in the range */
+    size_t block;  /* Number of contiguous elements in each block */
+    size_t offset; /* Index of the first element of the current block */
+    size_t outer;  /* Number of outer dimensions iterated between blocks */
+    const UA_NumericRangeDimension *range;
+    size_t strides[UA_MAX_ARRAY_DIMS]; /* Elements between two indices */
+    u32 pos[UA_MAX_ARRAY_DIMS];        /* Current index of outer dimensions */
+} RangeBlocks;
 
+static void
+RangeBlocks_init(RangeBlocks *rb, const UA_Variant *v,
+                 const UA_NumericRange range) {
     /* Assume one array dimension if none defined */
     u32 arrayLength = (u32)v->arrayLength;
     const u32 *dims = v->arrayDimensions;
@@ -860,25 +1186,46 @@ computeStrides(const UA_Variant *v, const UA_NumericRange range,
         dims_count = 1;
         dims = &arrayLength;
     }
+    UA_assert(dims_count == range.dimensionsSize);
 
-    /* Compute the stride length and the position of the first element */
-    *block = count;           /* Assume the range describes the entire array. */
-    *stride = v->arrayLength; /* So it can be copied as a contiguous block.   */
-    *first = 0;
+    rb->range = range.dimensions;
+    rb->total = 1;
+    rb->block = 0;
+    rb->offset = 0;
+    rb->outer = 0;
     size_t running_dimssize = 1;
-    UA_Boolean found_contiguous = false;
     for(size_t k = dims_count; k > 0;) {
         --k;
         size_t dimrange = 1 + range.dimensions[k].max - range.dimensions[k].min;
-        if(!found_contiguous && dimrange != dims[k]) {
+        rb->total *= dimrange;
+        if(rb->block == 0 && dimrange != dims[k]) {
             /* Found the maximum block that can be copied contiguously */
-            found_contiguous = true;
-            *block = running_dimssize * dimrange;
-            *stride = running_dimssize * dims[k];
+            rb->block = running_dimssize * dimrange;
+            rb->outer = k;
         }
-        *first += running_dimssize * range.dimensions[k].min;
+        rb->strides[k] = running_dimssize;
+        rb->pos[k] = range.dimensions[k].min;
+        rb->offset += running_dimssize * range.dimensions[k].min;
         running_dimssize *= dims[k];
     }
+
+    /* The range describes the entire array */
+    if(rb->block == 0)
+        rb->block = rb->total;
+}
+
+static void
+RangeBlocks_next(RangeBlocks *rb) {
+    for(size_t k = rb->outer; k > 0;) {
+        --k;
+        if(rb->pos[k] < rb->range[k].max) {
+            rb->pos[k]++;
+            rb->offset += rb->strides[k];
+            return;
+        }
+        rb->offset -= (size_t)(rb->pos[k] - rb->range[k].min) * rb->strides[k];
+        rb->pos[k] = rb->range[k].min;
+    }
 }
 
 /* Is the type string-like? */
@@ -964,10 +1311,11 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Compute the strides */
-    size_t count, block, stride, first;
-    computeStrides(src, thisrange, &count, &block, &stride, &first);
-    UA_assert(block > 0);
+    /* Compute the blocks */
+    RangeBlocks rb;
+    RangeBlocks_init(&rb, src, thisrange);
+    size_t count = rb.total;
+    UA_assert(rb.block > 0);
 
     /* Allocate the array */
     UA_Variant_init(dst);
@@ -976,27 +1324,33 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
         return UA_STATUSCODE_BADOUTOFMEMORY;
 
     /* Copy the range */
-    size_t block_count = count / block;
+    size_t block_count = count / rb.block;
     size_t elem_size = src->type->memSize;
     uintptr_t nextdst = (uintptr_t)dst->data;
-    uintptr_t nextsrc = (uintptr_t)src->data + (elem_size * first);
     if(nextrange.dimensionsSize == 0) {
         /* no nextrange */
         if(src->type->pointerFree) {
+            /* One memcpy per contiguous block */
             for(size_t i = 0; i < block_count; ++i) {
-                memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-                nextdst += block * elem_size;
-                nextsrc += stride * elem_size;
+                memcpy((void*)nextdst,
+                       (void*)((uintptr_t)src->data + (rb.offset * elem_size)),
+                       elem_size * rb.block);
+                nextdst += rb.block * elem_size;
+                RangeBlocks_next(&rb);
             }
         } else {
+            /* The target array is zeroed. So the elements can be copied with
+             * the jump table directly. */
+            const UA_copySignature copyElem = copyJumpTable[src->type->typeKind];
             for(size_t i = 0; i < block_count; ++i) {
-                for(size_t j = 0; j < block; ++j) {
-                    retval = UA_copy((const void*)nextsrc,
-                                     (void*)nextdst, src->type);
+                uintptr_t nextsrc = (uintptr_t)src->data + (rb.offset * elem_size);
+                for(size_t j = 0; j < rb.block; ++j) {
+                    retval |= copyElem((const void*)nextsrc, (void*)nextdst,
+                                       src->type);
                     nextdst += elem_size;
                     nextsrc += elem_size;
                 }
-                nextsrc += (stride - block) * elem_size;
+                RangeBlocks_next(&rb);
             }
         }
     } else {
@@ -1010,8 +1364,9 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
         }
 
         /* Copy the content */
-        for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block && retval == UA_STATUSCODE_GOOD; ++j) {
+        for(size_t i = 0; i < block_count && retval == UA_STATUSCODE_GOOD; ++i) {
+            uintptr_t nextsrc = (uintptr_t)src->data + (rb.offset * elem_size);
+            for(size_t j = 0; j < rb.block && retval == UA_STATUSCODE_GOOD; ++j) {
                 if(stringLike)
                     retval = copySubString((const UA_String*)nextsrc,
                                            (UA_String*)nextdst,
@@ -1023,7 +1378,7 @@ UA_Variant_copyRange(const UA_Variant *src, UA_Variant * UA_RESTRICT dst,
                 nextdst += elem_size;
                 nextsrc += elem_size;
             }
-            nextsrc += (stride - block) * elem_size;
+            RangeBlocks_next(&rb);
         }
     }
 
@@ -1077,38 +1432,46 @@ Variant_setRange(UA_Variant *v, void *array, size_t arraySize,
     if(retval != UA_STATUSCODE_GOOD)
         return retval;
 
-    /* Compute the strides */
-    size_t count, block, stride, first;
-    computeStrides(v, range, &count, &block, &stride, &first);
+    /* Compute the blocks */
+    RangeBlocks rb;
+    RangeBlocks_init(&rb, v, thisrange);
+    size_t count = rb.total;
     if(count != arraySize)
         return UA_STATUSCODE_BADINDEXRANGEINVALID;
 
+    if(v->storageType == UA_VARIANT_DATA_SHARED) {
+        retval = Variant_unshare(v);
+        if(retval != UA_STATUSCODE_GOOD)
+            return retval;
+    }
+
     /* Move/copy the elements */
-    size_t block_count = count / block;
+    size_t block_count = count / rb.block;
     size_t elem_size = v->type->memSize;
-    uintptr_t nextdst = (uintptr_t)v->data + (first * elem_size);
     uintptr_t nextsrc = (uintptr_t)array;
     if(v->type->pointerFree || !copy) {
         for(size_t i = 0; i < block_count; ++i) {
-            memcpy((void*)nextdst, (void*)nextsrc, elem_size * block);
-            nextsrc += block * elem_size;
-            nextdst += stride * elem_size;
+            memcpy((void*)((uintptr_t)v->data + (rb.offset * elem_size)),
+                   (void*)nextsrc, elem_size * rb.block);
+            nextsrc += rb.block * elem_size;
+            RangeBlocks_next(&rb);
         }
     } else {
         for(size_t i = 0; i < block_count; ++i) {
-            for(size_t j = 0; j < block; ++j) {
+            uintptr_t nextdst = (uintptr_t)v->data + (rb.offset * elem_size);
+            for(size_t j = 0; j < rb.block; ++j) {
                 clearJumpTable[v->type->typeKind]((void*)nextdst, v->type);
                 retval |= UA_copy((void*)nextsrc, (void*)nextdst, v->type);
                 nextdst += elem_size;
                 nextsrc += elem_size;
             }
-            nextdst += (stride - block) * elem_size;
+            RangeBlocks_next(&rb);
         }
     }
 
     /* If members were moved, initialize original array to prevent reuse */
     if(!copy && !v->type->pointerFree)
-        memset(array, 0, sizeof(elem_size)*arraySize);
+        memset(array, 0, elem_size * arraySize);
 
     return retval;
 }
@@ -1243,8 +1606,146 @@ copyGuid(const UA_Guid *src, UA_Guid *dst, const UA_DataType *_) {
     return UA_STATUSCODE_GOOD;
 }
 
+/****************************/
+/* Compiled Copy and Clear  */
+/****************************/
+
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+
+/* Structures from UA_TYPES get a list of the members that (may) own heap
+ * memory. The list is built on first use. Copying is then a memcpy of the
+ * entire structure followed by a deep copy of only these members. Clearing
+ * visits only these members. Pointer-free structures have an empty list. Like
+ * the compiled encoding programs, the lists are stored in a static pool. If the
+ * pool is exhausted, the remaining types use the generic member loop. */
+
+#define UA_MEMBERFIXUPS_POOLSIZE 2048
+
+typedef struct {
+    u16 offset;  /* Offset from the start of the structure */
+    u16 isArray; /* Length-prefixed array member */
+    const UA_DataType *type; /* NULL marks the end of the list */
+} MemberFixup;
+
+static MemberFixup fixupPool[UA_MEMBERFIXUPS_POOLSIZE];
+static void * volatile fixupPoolPos = fixupPool;
+static const MemberFixup emptyFixups = {0, 0, NULL};
+static const MemberFixup noFixups = {0, 0, NULL};
+static void * volatile typeFixups[UA_TYPES_COUNT];
+
+static const MemberFixup *
+compileFixups(const UA_DataType *type) {
+    if(type->pointerFree)
+        return &emptyFixups;
+
+    /* At most one entry per member plus the end marker */
+    MemberFixup fixups[256];
+    size_t fixupsSize = 0;
+    uintptr_t offset = 0;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        offset += m->padding;
+        if(m->isArray) {
+            fixups[fixupsSize].offset = (u16)offset;
+            fixups[fixupsSize].isArray = true;
+            fixups[fixupsSize].type = mt;
+            fixupsSize++;
+            offset += sizeof(size_t) + sizeof(void *);
+            continue;
+        }
+        if(!mt->pointerFree) {
+            fixups[fixupsSize].offset = (u16)offset;
+            fixups[fixupsSize].isArray = false;
+            fixups[fixupsSize].type = mt;
+            fixupsSize++;
+        }
+        offset += mt->memSize;
+    }
+    fixups[fixupsSize] = emptyFixups;
+    fixupsSize++;
+
+    /* Reserve space in the pool with compare-and-swap */
+    void *oldPos, *newPos;
+    do {
+        oldPos = fixupPoolPos;
+        if((MemberFixup*)oldPos + fixupsSize > &fixupPool[UA_MEMBERFIXUPS_POOLSIZE])
+            return &noFixups;
+        newPos = (MemberFixup*)oldPos + fixupsSize;
+    } while(UA_atomic_cmpxchg(&fixupPoolPos, oldPos, newPos) != oldPos);
+    memcpy(oldPos, fixups, fixupsSize * sizeof(MemberFixup));
+    return (const MemberFixup*)oldPos;
+}
+
+/* Returns NULL if no fixup list is available for the type */
+static const MemberFixup *
+getFixups(const UA_DataType *type) {
+    if(type->typeKind != UA_DATATYPEKIND_STRUCTURE ||
+       (uintptr_t)type < (uintptr_t)UA_TYPES ||
+       (uintptr_t)type >= (uintptr_t)&UA_TYPES[UA_TYPES_COUNT])
+        return NULL;
+    size_t index = (size_t)(type - UA_TYPES);
+    const MemberFixup *f = (const MemberFixup *)typeFixups[index];
+    if(UA_UNLIKELY(!f)) {
+        f = compileFixups(type);
+        void *old = UA_atomic_cmpxchg(&typeFixups[index], NULL,
+                                      (void *)(uintptr_t)f);
+        if(old)
+            f = (const MemberFixup *)old;
+    }
+    return (f != &noFixups) ? f : NULL;
+}
+
+static UA_StatusCode
+copyStructureFixups(const void *src, void *dst, const UA_DataType *type,
+                    const MemberFixup *f) {
+    /* The memcpy also takes over the pointers of the members that are deep
+     * copied below. They are reset before each member is copied. */
+    memcpy(dst, src, type->memSize);
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for(; f->type; f++) {
+        const uintptr_t ms = (uintptr_t)src + f->offset;
+        const uintptr_t md = (uintptr_t)dst + f->offset;
+        if(!f->isArray) {
+            memset((void*)md, 0, f->type->memSize);
+            retval |= copyJumpTable[f->type->typeKind]((const void*)ms,
+                                                       (void*)md, f->type);
+            continue;
+        }
+        size_t *dstSize = (size_t*)md;
+        void **dstData = (void**)(md + sizeof(size_t));
+        *dstData = NULL;
+        UA_StatusCode res =
+            UA_Array_copy(*(void* const*)(ms + sizeof(size_t)),
+                          *(const size_t*)ms, dstData, f->type);
+        if(res != UA_STATUSCODE_GOOD)
+            *dstSize = 0;
+        retval |= res;
+    }
+    return retval;
+}
+
+static void
+clearStructureFixups(void *p, const MemberFixup *f) {
+    for(; f->type; f++) {
+        const uintptr_t m = (uintptr_t)p + f->offset;
+        if(!f->isArray)
+            clearJumpTable[f->type->typeKind]((void*)m, f->type);
+        else
+            UA_Array_delete(*(void**)(m + sizeof(size_t)),
+                            *(size_t*)m, f->type);
+    }
+}
+
+#endif /* UA_ENABLE_ENCODING_PROGRAMS */
+
 static UA_StatusCode
 copyStructure(const void *src, void *dst, const UA_DataType *type) {
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+    const MemberFixup *fixups = getFixups(type);
+    if(fixups)
+        return copyStructureFixups(src, dst, type, fixups);
+#endif
     UA_StatusCode retval = UA_STATUSCODE_GOOD;
     uintptr_t ptrs = (uintptr_t)src;
     uintptr_t ptrd = (uintptr_t)dst;
@@ -1380,6 +1881,13 @@ UA_copy(const void *src, void *dst, const UA_DataType *type) {
 
 static void
 clearStructure(void *p, const UA_DataType *type) {
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+    const MemberFixup *fixups = getFixups(type);
+    if(fixups) {
+        clearStructureFixups(p, fixups);
+        return;
+    }
+#endif
     uintptr_t ptr = (uintptr_t)p;
     for(size_t i = 0; i < type->membersSize; ++i) {
         const UA_DataTypeMember *m = &type->members[i];
@@ -1931,6 +2439,87 @@ UA_Order UA_order(const void *p1, const void *p2, const UA_DataType *type) {
     return orderJumpTable[type->typeKind](p1, p2, type);
 }
 
+/*******************/
+/* Arena Allocator */
+/*******************/
+
+#define UA_ARENA_DEFAULT_BLOCKSIZE 4096
+#define UA_ARENA_ALIGN 8
+
+struct UA_ArenaBlock {
+    struct UA_ArenaBlock *next;
+    size_t size; /* The usable size after the (padded) header */
+    size_t pos;
+};
+
+#define UA_ARENA_ALIGNUP(x) (((x) + (UA_ARENA_ALIGN - 1)) & ~(size_t)(UA_ARENA_ALIGN - 1))
+#define UA_ARENA_HEADERSIZE UA_ARENA_ALIGNUP(sizeof(struct UA_ArenaBlock))
+
+void *
+UA_Arena_calloc(UA_Arena *arena, size_t nelem, size_t elsize) {
+    if(elsize > 0 && nelem > (SIZE_MAX - UA_ARENA_HEADERSIZE - UA_ARENA_ALIGN) / elsize)
+        return NULL;
+    size_t size = UA_ARENA_ALIGNUP(nelem * elsize);
+
+    struct UA_ArenaBlock *b = arena->blocks;
+    if(!b || b->size - b->pos < size) {
+        size_t blockSize = (arena->blockSize > 0) ?
+            UA_ARENA_ALIGNUP(arena->blockSize) : UA_ARENA_DEFAULT_BLOCKSIZE;
+        /* Large allocations get a dedicated block. It is inserted behind the
+         * current block so that the remaining space is still used. */
+        UA_Boolean dedicated = (b && size > blockSize / 4);
+        if(size > blockSize)
+            blockSize = size;
+        struct UA_ArenaBlock *nb = (struct UA_ArenaBlock*)
+            UA_malloc(UA_ARENA_HEADERSIZE + blockSize);
+        if(!nb)
+            return NULL;
+        nb->size = blockSize;
+        nb->pos = 0;
+        if(dedicated) {
+            nb->next = b->next;
+            b->next = nb;
+        } else {
+            nb->next = b;
+            arena->blocks = nb;
+        }
+        b = nb;
+    }
+
+    void *p = (u8*)b + UA_ARENA_HEADERSIZE + b->pos;
+    b->pos += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void
+UA_Arena_reset(UA_Arena *arena) {
+    struct UA_ArenaBlock *b = arena->blocks;
+    if(!b)
+        return;
+    if(!b->next) {
+        b->pos = 0;
+        return;
+    }
+    size_t total = 0;
+    for(; b; b = b->next)
+        total += b->size;
+    UA_Arena_clear(arena);
+    if(total > arena->blockSize)
+        arena->blockSize = total;
+}
+
+void
+UA_Arena_clear(UA_Arena *arena) {
+    struct UA_ArenaBlock *b = arena->blocks;
+    while(b) {
+        struct UA_ArenaBlock *next = b->next;
+        UA_free(b);
+        b = next;
+    }
+    arena->blocks = NULL;
+}
+
 /******************/
 /* Array Handling */
 /******************/
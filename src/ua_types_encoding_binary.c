@@ -48,14 +48,159 @@ typedef struct {
     u16 depth;
 
     const UA_DataTypeArray *customTypes;
+    UA_Boolean zeroCopy; /* Decode only. See UA_DecodeBinaryOptions */
+    UA_Arena *arena;     /* Decode only. Allocate from the arena if set. */
+    const UA_DataTypeIndex *typeIndex; /* Decode only. Replaces the search. */
+    UA_Boolean lazyExtensionObjects;   /* Decode only. Keep the EO body. */
     UA_exchangeEncodeBuffer exchangeBufferCallback;
     void *exchangeBufferCallbackHandle;
+
+    /* Decode only. The input can consist of several segments (e.g. the
+     * payloads of the chunks of a message). Decoding continues in the next
+     * segment when the end of the current segment is reached. */
+    const UA_ByteString *segments;
+    size_t segmentsSize;
+    size_t segment;       /* Index of the current segment */
+    size_t segmentOffset; /* Position of the current segment in the input */
+    size_t segmentsRest;  /* Length of the segments after the current */
 } Ctx;
 
+/* Saved decoding position to go back to */
+typedef struct {
+    u8 *pos;
+    const u8 *end;
+    size_t segment;
+    size_t segmentOffset;
+    size_t segmentsRest;
+} CtxPos;
+
 typedef status (*encodeBinarySignature)(const void *UA_RESTRICT src,
                                         const UA_DataType *type, Ctx *UA_RESTRICT ctx);
 typedef status (*decodeBinarySignature)(void *UA_RESTRICT dst, const UA_DataType *type,
                                         Ctx *UA_RESTRICT ctx);
+/* Memory handling during decoding. With an arena, the memory is released all at
+ * once later on. Then the cleanup of (partially) decoded values is skipped. */
+static UA_INLINE void *
+ctxCalloc(Ctx *ctx, size_t nelem, size_t elsize) {
+    if(ctx->arena)
+        return UA_Arena_calloc(ctx->arena, nelem, elsize);
+    return UA_calloc(nelem, elsize);
+}
+
+static UA_INLINE void
+ctxFree(Ctx *ctx, void *p) {
+    if(!ctx->arena)
+        UA_free(p);
+}
+
+static UA_INLINE void
+ctxClearNodeId(Ctx *ctx, UA_NodeId *id) {
+    if(!ctx->arena)
+        UA_NodeId_clear(id);
+}
+
+/* Segmented input for decoding. The fast paths check only the current segment.
+ * The slow paths are taken when the end of the segment is reached. */
+
+static UA_INLINE void
+ctxSavePos(const Ctx *ctx, CtxPos *cp) {
+    cp->pos = ctx->pos;
+    cp->end = ctx->end;
+    cp->segment = ctx->segment;
+    cp->segmentOffset = ctx->segmentOffset;
+    cp->segmentsRest = ctx->segmentsRest;
+}
+
+static UA_INLINE void
+ctxRestorePos(Ctx *ctx, const CtxPos *cp) {
+    ctx->pos = cp->pos;
+    ctx->end = cp->end;
+    ctx->segment = cp->segment;
+    ctx->segmentOffset = cp->segmentOffset;
+    ctx->segmentsRest = cp->segmentsRest;
+}
+
+/* Number of bytes left for decoding */
+static UA_INLINE size_t
+ctxRemaining(const Ctx *ctx) {
+    return (size_t)(ctx->end - ctx->pos) + ctx->segmentsRest;
+}
+
+/* Position in the overall input */
+static UA_INLINE size_t
+ctxOffset(const Ctx *ctx) {
+    return ctx->segmentOffset +
+        (size_t)(ctx->pos - ctx->segments[ctx->segment].data);
+}
+
+/* Move to the start of the next segment. Returns false if there is none. */
+static UA_Boolean
+ctxNextSegment(Ctx *ctx) {
+    if(ctx->segment + 1 >= ctx->segmentsSize)
+        return false;
+    ctx->segmentOffset += ctx->segments[ctx->segment].length;
+    ctx->segment++;
+    const UA_ByteString *seg = &ctx->segments[ctx->segment];
+    ctx->pos = seg->data;
+    ctx->end = seg->data + seg->length;
+    ctx->segmentsRest -= seg->length;
+    return true;
+}
+
+/* Skip over exhausted segments, so that the position points to the next byte
+ * (if there is one) */
+static UA_INLINE void
+ctxSkipEmpty(Ctx *ctx) {
+    while(ctx->pos == ctx->end && ctxNextSegment(ctx)) {}
+}
+
+/* Copy the next n bytes and advance the position. The bytes can span several
+ * segments. If dst is NULL, the bytes are skipped. */
+static status
+ctxRead(Ctx *ctx, u8 *dst, size_t n) {
+    UA_CHECK(n <= ctxRemaining(ctx), return UA_STATUSCODE_BADDECODINGERROR);
+    while(n > 0) {
+        size_t avail = (size_t)(ctx->end - ctx->pos);
+        if(avail == 0) {
+            ctxNextSegment(ctx);
+            continue;
+        }
+        if(avail > n)
+            avail = n;
+        if(dst) {
+            memcpy(dst, ctx->pos, avail);
+            dst += avail;
+        }
+        ctx->pos += avail;
+        n -= avail;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static const u8 *
+ctxGatherSlow(Ctx *ctx, u8 *tmp, size_t n) {
+    ctxSkipEmpty(ctx);
+    if(ctx->pos + n <= ctx->end) {
+        const u8 *p = ctx->pos;
+        ctx->pos += n;
+        return p;
+    }
+    return (ctxRead(ctx, tmp, n) == UA_STATUSCODE_GOOD) ? tmp : NULL;
+}
+
+/* Returns a pointer to the next n bytes and advances the position. If the
+ * bytes span segments, they are gathered in tmp. Returns NULL if the input is
+ * too short. */
+static UA_INLINE const u8 *
+ctxGather(Ctx *ctx, u8 *tmp, size_t n) {
+    if(UA_LIKELY(ctx->pos + n <= ctx->end)) {
+        const u8 *p = ctx->pos;
+        ctx->pos += n;
+        return p;
+    }
+    return ctxGatherSlow(ctx, tmp, n);
+}
+
 #define ENCODE_BINARY(TYPE)                                                              \
     static status TYPE##_encodeBinary(const UA_##TYPE *UA_RESTRICT src,                  \
                                       const UA_DataType *type, Ctx *UA_RESTRICT ctx)
@@ -115,6 +260,92 @@ encodeWithExchangeBuffer(const void *ptr, const UA_DataType *type, Ctx *ctx) {
     return ret;
 }
 
+/*******************/
+/* Fixed-Size Types */
+/*******************/
+
+/* Types whose encoding has the same length for every value. The length is
+ * cached for the types in UA_TYPES. Then computing the size of such values
+ * requires no traversal. */
+
+#define BIN_VARIABLESIZE ((size_t)-1)
+
+/* 0 means "not yet computed". Otherwise the fixed size + 1 or UA_UINT32_MAX
+ * for types with variable size. Concurrent threads store the same value. */
+static volatile u32 binFixedSizes[UA_TYPES_COUNT];
+
+static size_t binFixedSize(const UA_DataType *type, u16 depth);
+
+static size_t
+binFixedSizeCompute(const UA_DataType *type, u16 depth) {
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_BOOLEAN:
+    case UA_DATATYPEKIND_SBYTE:
+    case UA_DATATYPEKIND_BYTE:
+        return 1;
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+        return 2;
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_FLOAT:
+    case UA_DATATYPEKIND_STATUSCODE:
+    case UA_DATATYPEKIND_ENUM:
+        return 4;
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_DOUBLE:
+    case UA_DATATYPEKIND_DATETIME:
+        return 8;
+    case UA_DATATYPEKIND_GUID:
+        return 16;
+    case UA_DATATYPEKIND_STRUCTURE:
+        break;
+    default:
+        return BIN_VARIABLESIZE;
+    }
+
+    if(depth > UA_ENCODING_MAX_RECURSION)
+        return BIN_VARIABLESIZE;
+    size_t size = 0;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        if(m->isArray)
+            return BIN_VARIABLESIZE;
+        size_t ms = binFixedSize(m->memberType, (u16)(depth + 1));
+        if(ms == BIN_VARIABLESIZE)
+            return BIN_VARIABLESIZE;
+        size += ms;
+    }
+    return size;
+}
+
+/* Returns BIN_VARIABLESIZE if the encoded length depends on the value */
+static size_t
+binFixedSize(const UA_DataType *type, u16 depth) {
+    if((uintptr_t)type < (uintptr_t)UA_TYPES ||
+       (uintptr_t)type >= (uintptr_t)&UA_TYPES[UA_TYPES_COUNT])
+        return binFixedSizeCompute(type, depth);
+    size_t index = (size_t)(type - UA_TYPES);
+    u32 cached = binFixedSizes[index];
+    if(UA_UNLIKELY(cached == 0)) {
+        size_t size = binFixedSizeCompute(type, depth);
+        cached = (size < UA_UINT32_MAX - 1) ? (u32)(size + 1) : UA_UINT32_MAX;
+        binFixedSizes[index] = cached;
+    }
+    return (cached != UA_UINT32_MAX) ? (size_t)(cached - 1) : BIN_VARIABLESIZE;
+}
+
+/* Only use what is cached. Computing the fixed size of a custom type inside a
+ * traversal could cost as much as the traversal itself. */
+static size_t
+binFixedSizeCached(const UA_DataType *type) {
+    if((uintptr_t)type < (uintptr_t)UA_TYPES ||
+       (uintptr_t)type >= (uintptr_t)&UA_TYPES[UA_TYPES_COUNT])
+        return BIN_VARIABLESIZE;
+    return binFixedSize(type, 0);
+}
+
 /*****************/
 /* Integer Types */
 /*****************/
@@ -181,9 +412,10 @@ ENCODE_BINARY(Boolean) {
 }
 
 DECODE_BINARY(Boolean) {
-    UA_CHECK(ctx->pos + 1 <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
-    *dst = (*ctx->pos > 0) ? true : false;
-    ++ctx->pos;
+    u8 tmp;
+    const u8 *src = ctxGather(ctx, &tmp, 1);
+    UA_CHECK(src != NULL, return UA_STATUSCODE_BADDECODINGERROR);
+    *dst = (*src > 0) ? true : false;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -195,9 +427,10 @@ ENCODE_BINARY(Byte) {
 }
 
 DECODE_BINARY(Byte) {
-    UA_CHECK(ctx->pos + sizeof(u8) <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
-    *dst = *ctx->pos;
-    ++ctx->pos;
+    u8 tmp;
+    const u8 *src = ctxGather(ctx, &tmp, sizeof(u8));
+    UA_CHECK(src != NULL, return UA_STATUSCODE_BADDECODINGERROR);
+    *dst = *src;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -215,13 +448,14 @@ ENCODE_BINARY(UInt16) {
 }
 
 DECODE_BINARY(UInt16) {
-    UA_CHECK(ctx->pos + sizeof(u16) <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
+    u8 tmp[sizeof(u16)];
+    const u8 *src = ctxGather(ctx, tmp, sizeof(u16));
+    UA_CHECK(src != NULL, return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
-    memcpy(dst, ctx->pos, sizeof(u16));
+    memcpy(dst, src, sizeof(u16));
 #else
-    UA_decode16(ctx->pos, dst);
+    UA_decode16(src, dst);
 #endif
-    ctx->pos += 2;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -239,13 +473,14 @@ ENCODE_BINARY(UInt32) {
 }
 
 DECODE_BINARY(UInt32) {
-    UA_CHECK(ctx->pos + sizeof(u32) <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
+    u8 tmp[sizeof(u32)];
+    const u8 *src = ctxGather(ctx, tmp, sizeof(u32));
+    UA_CHECK(src != NULL, return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
-    memcpy(dst, ctx->pos, sizeof(u32));
+    memcpy(dst, src, sizeof(u32));
 #else
-    UA_decode32(ctx->pos, dst);
+    UA_decode32(src, dst);
 #endif
-    ctx->pos += 4;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -263,13 +498,14 @@ ENCODE_BINARY(UInt64) {
 }
 
 DECODE_BINARY(UInt64) {
-    UA_CHECK(ctx->pos + sizeof(u64) <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
+    u8 tmp[sizeof(u64)];
+    const u8 *src = ctxGather(ctx, tmp, sizeof(u64));
+    UA_CHECK(src != NULL, return UA_STATUSCODE_BADDECODINGERROR);
 #if UA_BINARY_OVERLAYABLE_INTEGER
-    memcpy(dst, ctx->pos, sizeof(u64));
+    memcpy(dst, src, sizeof(u64));
 #else
-    UA_decode64(ctx->pos, dst);
+    UA_decode64(src, dst);
 #endif
-    ctx->pos += 8;
     return UA_STATUSCODE_GOOD;
 }
 
@@ -456,6 +692,129 @@ Array_encodeBinaryOverlayable(uintptr_t ptr, size_t memSize, Ctx *ctx) {
     return UA_STATUSCODE_GOOD;
 }
 
+#if !UA_BINARY_OVERLAYABLE_INTEGER
+
+/* Numeric arrays that cannot be memcpy'd are converted in bulk. The loops
+ * without a function call per element are simple enough to be turned into
+ * byte-swap (vector) instructions by the compiler. Returns the element size if
+ * the type can be converted in bulk and zero otherwise. */
+static size_t
+Array_bulkElementSize(const UA_DataType *type) {
+    size_t size;
+    switch(type->typeKind) {
+    case UA_DATATYPEKIND_INT16:
+    case UA_DATATYPEKIND_UINT16:
+        size = 2;
+        break;
+    case UA_DATATYPEKIND_INT32:
+    case UA_DATATYPEKIND_UINT32:
+    case UA_DATATYPEKIND_STATUSCODE:
+    case UA_DATATYPEKIND_ENUM:
+        size = 4;
+        break;
+    case UA_DATATYPEKIND_INT64:
+    case UA_DATATYPEKIND_UINT64:
+    case UA_DATATYPEKIND_DATETIME:
+        size = 8;
+        break;
+#if (UA_FLOAT_IEEE754 == 1) && (UA_LITTLE_ENDIAN == UA_FLOAT_LITTLE_ENDIAN)
+    /* Same byte order as the integers. Mixed-endian or non-IEEE754 floats use
+     * the per-element conversion. */
+    case UA_DATATYPEKIND_FLOAT:
+        size = 4;
+        break;
+    case UA_DATATYPEKIND_DOUBLE:
+        size = 8;
+        break;
+#endif
+    default:
+        return 0;
+    }
+    return (type->memSize == size) ? size : 0;
+}
+
+static void
+Array_bulkEncode(u8 *dst, uintptr_t src, size_t length, size_t elemSize) {
+    switch(elemSize) {
+    case 2: {
+        const u16 *v = (const u16 *)src;
+        for(size_t i = 0; i < length; i++)
+            UA_encode16(v[i], &dst[i * 2]);
+        break;
+    }
+    case 4: {
+        const u32 *v = (const u32 *)src;
+        for(size_t i = 0; i < length; i++)
+            UA_encode32(v[i], &dst[i * 4]);
+        break;
+    }
+    default: {
+        const u64 *v = (const u64 *)src;
+        for(size_t i = 0; i < length; i++)
+            UA_encode64(v[i], &dst[i * 8]);
+        break;
+    }
+    }
+}
+
+static void
+Array_bulkDecode(const u8 *src, void *dst, size_t length, size_t elemSize) {
+    switch(elemSize) {
+    case 2: {
+        u16 *v = (u16 *)dst;
+        for(size_t i = 0; i < length; i++)
+            UA_decode16(&src[i * 2], &v[i]);
+        break;
+    }
+    case 4: {
+        u32 *v = (u32 *)dst;
+        for(size_t i = 0; i < length; i++)
+            UA_decode32(&src[i * 4], &v[i]);
+        break;
+    }
+    default: {
+        u64 *v = (u64 *)dst;
+        for(size_t i = 0; i < length; i++)
+            UA_decode64(&src[i * 8], &v[i]);
+        break;
+    }
+    }
+}
+
+static status
+Array_encodeBinaryBulk(uintptr_t ptr, size_t length, size_t elemSize, Ctx *ctx) {
+    /* CalcSize only */
+    if(ctx->end == NULL) {
+        ctx->pos += length * elemSize;
+        return UA_STATUSCODE_GOOD;
+    }
+
+    /* Elements are not split between chunks */
+    UA_Boolean exchanged = false;
+    while(length > 0) {
+        size_t possible = ((uintptr_t)ctx->end - (uintptr_t)ctx->pos) / elemSize;
+        if(possible == 0) {
+            /* Not even one element fits into a fresh buffer */
+            UA_CHECK(!exchanged, return UA_STATUSCODE_BADENCODINGERROR);
+            status ret = exchangeBuffer(ctx);
+            UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+            UA_CHECK_STATUS(ret, return ret);
+            exchanged = true;
+            continue;
+        }
+        if(possible > length)
+            possible = length;
+        Array_bulkEncode(ctx->pos, ptr, possible, elemSize);
+        ctx->pos += possible * elemSize;
+        ptr += possible * elemSize;
+        length -= possible;
+        exchanged = false;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif /* !UA_BINARY_OVERLAYABLE_INTEGER */
+
 static status
 Array_encodeBinaryComplex(uintptr_t ptr, size_t length, const UA_DataType *type,
                           Ctx *ctx) {
@@ -487,11 +846,24 @@ Array_encodeBinary(const void *src, size_t length, const UA_DataType *type, Ctx
 
     /* Encode the content */
     if(length > 0) {
-        if(type->overlayable)
+        size_t fixedSize;
+        if(type->overlayable) {
             ret = Array_encodeBinaryOverlayable((uintptr_t)src, length * type->memSize,
                                                 ctx);
-        else
+        } else if(!ctx->end && (fixedSize = binFixedSizeCached(type)) !=
+                  BIN_VARIABLESIZE) {
+            /* Compute the size only (calcSizeBinary mode) with the cached
+             * fixed size. Custom types are traversed. */
+            ctx->pos += length * fixedSize;
+        } else {
+#if !UA_BINARY_OVERLAYABLE_INTEGER
+            size_t elemSize = Array_bulkElementSize(type);
+            if(elemSize > 0)
+                ret = Array_encodeBinaryBulk((uintptr_t)src, length, elemSize, ctx);
+            else
+#endif
             ret = Array_encodeBinaryComplex((uintptr_t)src, length, type, ctx);
+        }
     }
     UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
     return ret;
@@ -523,26 +895,32 @@ Array_decodeBinary(void *UA_RESTRICT *UA_RESTRICT dst, size_t *out_length,
      * sizeof(UA_DataValue) == 80 and an empty DataValue is encoded with just
      * one byte. We use 128 as the smallest power of 2 larger than 80. */
     size_t length = (size_t)signed_length;
-    UA_CHECK(ctx->pos + ((type->memSize * length) / 128) <= ctx->end,
+    UA_CHECK(((type->memSize * length) / 128) <= ctxRemaining(ctx),
              return UA_STATUSCODE_BADDECODINGERROR);
 
     /* Allocate memory */
-    *dst = UA_calloc(length, type->memSize);
+    *dst = ctxCalloc(ctx, length, type->memSize);
     UA_CHECK_MEM(*dst, return UA_STATUSCODE_BADOUTOFMEMORY);
 
     if(type->overlayable) {
-        /* memcpy overlayable array */
-        UA_CHECK(ctx->pos + (type->memSize * length) <= ctx->end, UA_free(*dst);
-                 *dst = NULL; return UA_STATUSCODE_BADDECODINGERROR);
-        memcpy(*dst, ctx->pos, type->memSize * length);
+        /* memcpy overlayable array (across segments) */
+        ret = ctxRead(ctx, (u8*)*dst, type->memSize * length);
+        UA_CHECK_STATUS(ret, ctxFree(ctx, *dst); *dst = NULL; return ret);
+#if !UA_BINARY_OVERLAYABLE_INTEGER
+    } else if(Array_bulkElementSize(type) > 0 &&
+              ctx->pos + (type->memSize * length) <= ctx->end) {
+        /* Convert numeric array in bulk. If the array spans segments, the
+         * members are decoded one by one below. */
+        Array_bulkDecode(ctx->pos, *dst, length, type->memSize);
         ctx->pos += type->memSize * length;
+#endif
     } else {
         /* Decode array members */
         uintptr_t ptr = (uintptr_t)*dst;
         for(size_t i = 0; i < length; ++i) {
             ret = decodeBinaryJumpTable[type->typeKind]((void *)ptr, type, ctx);
             UA_CHECK_STATUS(ret, /* +1 because last element is also already initialized */
-                            UA_Array_delete(*dst, i + 1, type);
+                            if(!ctx->arena) UA_Array_delete(*dst, i + 1, type);
                             *dst = NULL; return ret);
             ptr += type->memSize;
         }
@@ -582,10 +960,7 @@ DECODE_BINARY(Guid) {
     ret |= DECODE_DIRECT(&dst->data1, UInt32);
     ret |= DECODE_DIRECT(&dst->data2, UInt16);
     ret |= DECODE_DIRECT(&dst->data3, UInt16);
-    UA_CHECK(ctx->pos + (8 * sizeof(u8)) <= ctx->end,
-             return UA_STATUSCODE_BADDECODINGERROR);
-    memcpy(dst->data4, ctx->pos, 8 * sizeof(u8));
-    ctx->pos += 8;
+    ret |= ctxRead(ctx, dst->data4, 8 * sizeof(u8));
     return ret;
 }
 
@@ -740,7 +1115,8 @@ ENCODE_BINARY(ExpandedNodeId) {
 }
 
 DECODE_BINARY(ExpandedNodeId) {
-    /* Decode the encoding mask */
+    /* Peek the encoding mask */
+    ctxSkipEmpty(ctx);
     UA_CHECK(ctx->pos + 1 <= ctx->end, return UA_STATUSCODE_BADDECODINGERROR);
     u8 encoding = *ctx->pos;
 
@@ -817,17 +1193,15 @@ DECODE_BINARY(LocalizedText) {
  * possible to reuse UA_findDataType */
 static const UA_DataType *
 UA_findDataTypeByBinaryInternal(const UA_NodeId *typeId, Ctx *ctx) {
-    /* Always look in the built-in types first. Assume that only numeric
-     * identifiers are used for the builtin types. (They may contain data types
-     * from all namespaces though.) */
-    if(typeId->identifierType == UA_NODEIDTYPE_NUMERIC) {
-        for(size_t i = 0; i < UA_TYPES_COUNT; ++i) {
-            if(UA_TYPES[i].binaryEncodingId.identifier.numeric ==
-                   typeId->identifier.numeric &&
-               UA_TYPES[i].binaryEncodingId.namespaceIndex == typeId->namespaceIndex)
-                return &UA_TYPES[i];
-        }
-    }
+    /* The index contains the builtin and the custom types */
+    if(ctx->typeIndex)
+        return UA_DataTypeIndex_findBinary(ctx->typeIndex, typeId);
+
+    /* Always look in the built-in types first. (They may contain data types
+     * from all namespaces.) */
+    const UA_DataType *type = UA_findDataTypeByBinary(typeId);
+    if(type)
+        return type;
 
     const UA_DataTypeArray *customTypes = ctx->customTypes;
     while(customTypes) {
@@ -841,13 +1215,6 @@ UA_findDataTypeByBinaryInternal(const UA_NodeId *typeId, Ctx *ctx) {
     return NULL;
 }
 
-const UA_DataType *
-UA_findDataTypeByBinary(const UA_NodeId *typeId) {
-    Ctx ctx;
-    ctx.customTypes = NULL;
-    return UA_findDataTypeByBinaryInternal(typeId, &ctx);
-}
-
 /* ExtensionObject */
 ENCODE_BINARY(ExtensionObject) {
     u8 encoding = (u8)src->encoding;
@@ -893,13 +1260,25 @@ ENCODE_BINARY(ExtensionObject) {
     const UA_DataType *contentType = src->content.decoded.type;
 
     /* Compute the content length. But only if we are not already in the
-     * calcSizeBinary mode. This is avoids recursive cycles.*/
+     * calcSizeBinary mode. This is avoids recursive cycles. If the buffer
+     * cannot be exchanged, the length field is filled in after encoding the
+     * content. This saves the additional traversal. */
     i32 signed_len = 0;
+    UA_Boolean backpatch = false;
     if(ctx->end != NULL) {
-        size_t len = UA_calcSizeBinary(src->content.decoded.data, contentType);
-        UA_CHECK(len <= UA_INT32_MAX, return UA_STATUSCODE_BADENCODINGERROR);
-        signed_len = (i32)len;
+        size_t len = binFixedSize(contentType, ctx->depth);
+        if(len == BIN_VARIABLESIZE) {
+            if(!ctx->exchangeBufferCallback)
+                backpatch = true;
+            else
+                len = UA_calcSizeBinary(src->content.decoded.data, contentType);
+        }
+        if(!backpatch) {
+            UA_CHECK(len <= UA_INT32_MAX, return UA_STATUSCODE_BADENCODINGERROR);
+            signed_len = (i32)len;
+        }
     }
+    u8 *lenPos = ctx->pos;
     ret = encodeWithExchangeBuffer(&signed_len, &UA_TYPES[UA_TYPES_INT32], ctx);
     UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
     UA_CHECK_STATUS(ret, return ret);
@@ -907,28 +1286,42 @@ ENCODE_BINARY(ExtensionObject) {
     /* Encode the content */
     ret = encodeWithExchangeBuffer(src->content.decoded.data, contentType, ctx);
     UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+    if(backpatch && ret == UA_STATUSCODE_GOOD) {
+        size_t len = (size_t)(ctx->pos - lenPos) - 4;
+        UA_CHECK(len <= UA_INT32_MAX, return UA_STATUSCODE_BADENCODINGERROR);
+        signed_len = (i32)len;
+        u8 *pos = ctx->pos;
+        ctx->pos = lenPos;
+        ret = ENCODE_DIRECT(&signed_len, UInt32); /* Int32 */
+        ctx->pos = pos;
+    }
     return ret;
 }
 
 static status
 ExtensionObject_decodeBinaryContent(UA_ExtensionObject *dst, const UA_NodeId *typeId,
                                     Ctx *ctx) {
-    /* Lookup the datatype */
-    const UA_DataType *type = UA_findDataTypeByBinaryInternal(typeId, ctx);
+    /* Lookup the datatype. Lazy decoding keeps the body. */
+    const UA_DataType *type = (ctx->lazyExtensionObjects) ? NULL :
+        UA_findDataTypeByBinaryInternal(typeId, ctx);
 
     /* Unknown type, just take the binary content */
     if(!type) {
         dst->encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
-        UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
+        if(ctx->arena)
+            dst->content.encoded.typeId = *typeId; /* Arena memory is not freed */
+        else
+            UA_NodeId_copy(typeId, &dst->content.encoded.typeId);
         return DECODE_DIRECT(&dst->content.encoded.body, String); /* ByteString */
     }
 
     /* Allocate memory */
-    dst->content.decoded.data = UA_new(type);
+    dst->content.decoded.data = ctxCalloc(ctx, 1, type->memSize);
     UA_CHECK_MEM(dst->content.decoded.data, return UA_STATUSCODE_BADOUTOFMEMORY);
 
     /* Jump over the length field (TODO: check if the decoded length matches) */
-    ctx->pos += 4;
+    status ret = ctxRead(ctx, NULL, 4);
+    UA_CHECK_STATUS(ret, return ret);
 
     /* Decode */
     dst->encoding = UA_EXTENSIONOBJECT_DECODED;
@@ -944,12 +1337,12 @@ DECODE_BINARY(ExtensionObject) {
     status ret = UA_STATUSCODE_GOOD;
     ret |= DECODE_DIRECT(&binTypeId, NodeId);
     ret |= DECODE_DIRECT(&encoding, Byte);
-    UA_CHECK_STATUS(ret, UA_NodeId_clear(&binTypeId); return ret);
+    UA_CHECK_STATUS(ret, ctxClearNodeId(ctx, &binTypeId); return ret);
 
     switch(encoding) {
         case UA_EXTENSIONOBJECT_ENCODED_BYTESTRING:
             ret = ExtensionObject_decodeBinaryContent(dst, &binTypeId, ctx);
-            UA_NodeId_clear(&binTypeId);
+            ctxClearNodeId(ctx, &binTypeId);
             break;
         case UA_EXTENSIONOBJECT_ENCODED_NOBODY:
             dst->encoding = (UA_ExtensionObjectEncoding)encoding;
@@ -960,10 +1353,10 @@ DECODE_BINARY(ExtensionObject) {
             dst->encoding = (UA_ExtensionObjectEncoding)encoding;
             dst->content.encoded.typeId = binTypeId;                 /* move to dst */
             ret = DECODE_DIRECT(&dst->content.encoded.body, String); /* ByteString */
-            UA_CHECK_STATUS(ret, UA_NodeId_clear(&dst->content.encoded.typeId));
+            UA_CHECK_STATUS(ret, ctxClearNodeId(ctx, &dst->content.encoded.typeId));
             break;
         default:
-            UA_NodeId_clear(&binTypeId);
+            ctxClearNodeId(ctx, &binTypeId);
             ret = UA_STATUSCODE_BADDECODINGERROR;
             break;
     }
@@ -1079,7 +1472,8 @@ static status
 Variant_decodeBinaryUnwrapExtensionObject(UA_Variant *dst, Ctx *ctx) {
     /* Save the position in the ByteString. If unwrapping is not possible, start
      * from here to decode a normal ExtensionObject. */
-    u8 *old_pos = ctx->pos;
+    CtxPos old_pos;
+    ctxSavePos(ctx, &old_pos);
 
     /* Decode the DataType */
     UA_NodeId typeId;
@@ -1090,22 +1484,23 @@ Variant_decodeBinaryUnwrapExtensionObject(UA_Variant *dst, Ctx *ctx) {
     /* Decode the EncodingByte */
     u8 encoding;
     ret = DECODE_DIRECT(&encoding, Byte);
-    UA_CHECK_STATUS(ret, UA_NodeId_clear(&typeId); return ret);
+    UA_CHECK_STATUS(ret, ctxClearNodeId(ctx, &typeId); return ret);
 
     /* Search for the datatype. Default to ExtensionObject. */
     if(encoding == UA_EXTENSIONOBJECT_ENCODED_BYTESTRING &&
        (dst->type = UA_findDataTypeByBinaryInternal(&typeId, ctx)) != NULL) {
         /* Jump over the length field (TODO: check if length matches) */
-        ctx->pos += 4;
+        ret = ctxRead(ctx, NULL, 4);
     } else {
         /* Reset and decode as ExtensionObject */
         dst->type = &UA_TYPES[UA_TYPES_EXTENSIONOBJECT];
-        ctx->pos = old_pos;
+        ctxRestorePos(ctx, &old_pos);
     }
-    UA_NodeId_clear(&typeId);
+    ctxClearNodeId(ctx, &typeId);
+    UA_CHECK_STATUS(ret, return ret);
 
     /* Allocate memory */
-    dst->data = UA_new(dst->type);
+    dst->data = ctxCalloc(ctx, 1, dst->type->memSize);
     UA_CHECK_MEM(dst->data, return UA_STATUSCODE_BADOUTOFMEMORY);
 
     /* Decode the content */
@@ -1118,7 +1513,8 @@ static status
 Variant_decodeBinaryUnwrapExtensionObjectArray(void *UA_RESTRICT *UA_RESTRICT dst,
                                                size_t *out_length,
                                                const UA_DataType **type, Ctx *ctx) {
-    u8 *orig_pos = ctx->pos;
+    CtxPos orig_pos;
+    ctxSavePos(ctx, &orig_pos);
 
     /* Decode the length */
     i32 signed_length;
@@ -1141,10 +1537,13 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(void *UA_RESTRICT *UA_RESTRICT ds
      * ExtensionObject is at least 4 byte long (3 byte NodeId + 1 Byte encoding
      * field). */
     size_t length = (size_t)signed_length;
-    UA_CHECK(ctx->pos + ((4 * length) / 32) <= ctx->end,
+    UA_CHECK(((4 * length) / 32) <= ctxRemaining(ctx),
              return UA_STATUSCODE_BADDECODINGERROR);
 
     /* Decode the type NodeId of the first member */
+    CtxPos header_pos;
+    ctxSavePos(ctx, &header_pos);
+    size_t headerOffset = ctxOffset(ctx);
     UA_NodeId binTypeId;
     UA_NodeId_init(&binTypeId);
     ret |= DECODE_DIRECT(&binTypeId, NodeId);
@@ -1152,10 +1551,10 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(void *UA_RESTRICT *UA_RESTRICT ds
 
     /* Lookup the data type */
     const UA_DataType *contentType = UA_findDataTypeByBinaryInternal(&binTypeId, ctx);
-    UA_NodeId_clear(&binTypeId);
+    ctxClearNodeId(ctx, &binTypeId);
     if(!contentType) {
         /* DataType unknown, decode as ExtensionObject array */
-        ctx->pos = orig_pos;
+        ctxRestorePos(ctx, &orig_pos);
         return Array_decodeBinary(dst, out_length, *type, ctx);
     }
 
@@ -1166,52 +1565,135 @@ Variant_decodeBinaryUnwrapExtensionObjectArray(void *UA_RESTRICT *UA_RESTRICT ds
     if(encoding != UA_EXTENSIONOBJECT_ENCODED_BYTESTRING) {
         /* Encoding format is not automatically decoded, decode as
          * ExtensionObject array */
-        ctx->pos = orig_pos;
+        ctxRestorePos(ctx, &orig_pos);
         return Array_decodeBinary(dst, out_length, *type, ctx);
     }
 
-    /* Compare the header of all array members if the array can be unwrapped */
-    UA_ByteString header = {(uintptr_t)ctx->pos - (uintptr_t)orig_pos - 4, &orig_pos[4]};
-    UA_ByteString compare_header = header;
-    ctx->pos = &orig_pos[4];
+    /* The header of the first member. Copied if it spans segments. */
+    u8 headerBuf[32];
+    UA_ByteString header = {ctxOffset(ctx) - headerOffset, header_pos.pos};
+    if(header_pos.segment != ctx->segment) {
+        header.data = (header.length <= sizeof(headerBuf)) ?
+            headerBuf : (u8*)UA_malloc(header.length);
+        UA_CHECK_MEM(header.data, return UA_STATUSCODE_BADOUTOFMEMORY);
+        ctxRestorePos(ctx, &header_pos);
+        ret = ctxRead(ctx, header.data, header.length);
+        UA_assert(ret == UA_STATUSCODE_GOOD);
+    }
 
+    /* Compare the header of all array members if the array can be unwrapped */
+    ctxRestorePos(ctx, &header_pos);
     for(size_t i = 0; i < length; i++) {
-        compare_header.data = ctx->pos;
-        UA_CHECK(compare_header.data + compare_header.length <= ctx->end,
-                 return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
-        if(!UA_ByteString_equal(&header, &compare_header)) {
+        if(header.length > ctxRemaining(ctx)) {
+            ret = UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            goto cleanup;
+        }
+
+        /* Compare piecewise if the header spans segments */
+        UA_Boolean equal = true;
+        size_t cmp = 0;
+        while(cmp < header.length) {
+            ctxSkipEmpty(ctx);
+            size_t avail = (size_t)(ctx->end - ctx->pos);
+            if(avail > header.length - cmp)
+                avail = header.length - cmp;
+            if(memcmp(ctx->pos, &header.data[cmp], avail) != 0) {
+                equal = false;
+                break;
+            }
+            ctx->pos += avail;
+            cmp += avail;
+        }
+        if(!equal) {
             /* Different member types, decode as ExtensionObject array */
-            ctx->pos = orig_pos;
-            return Array_decodeBinary(dst, out_length, *type, ctx);
+            ctxRestorePos(ctx, &orig_pos);
+            ret = Array_decodeBinary(dst, out_length, *type, ctx);
+            goto cleanup;
         }
 
         /* Decode the length field and jump to the next element */
-        ctx->pos += header.length;
         u32 member_length = 0;
         ret = DECODE_DIRECT(&member_length, UInt32);
-        UA_CHECK_STATUS(ret, return ret);
-        ctx->pos += member_length;
+        if(ret == UA_STATUSCODE_GOOD)
+            ret = ctxRead(ctx, NULL, member_length);
+        if(ret != UA_STATUSCODE_GOOD)
+            goto cleanup;
     }
 
     /* Allocate memory for the unwrapped members */
-    *dst = UA_calloc(length, contentType->memSize);
-    UA_CHECK_MEM(*dst, return UA_STATUSCODE_BADOUTOFMEMORY);
+    *dst = ctxCalloc(ctx, length, contentType->memSize);
+    if(!*dst) {
+        ret = UA_STATUSCODE_BADOUTOFMEMORY;
+        goto cleanup;
+    }
     *out_length = length;
     *type = contentType;
 
     /* Decode unwrapped members */
     uintptr_t array_pos = (uintptr_t)*dst;
-    ctx->pos = &orig_pos[4];
+    ctxRestorePos(ctx, &header_pos);
     for(size_t i = 0; i < length && ret == UA_STATUSCODE_GOOD; i++) {
-        ctx->pos += header.length + 4; /* Jump over the header and length field */
+        /* Jump over the header and length field */
+        ret = ctxRead(ctx, NULL, header.length + 4);
+        if(ret != UA_STATUSCODE_GOOD)
+            break;
         ret = decodeBinaryJumpTable[contentType->typeKind]((void *)array_pos, contentType,
                                                            ctx);
         array_pos += contentType->memSize;
     }
+
+ cleanup:
+    if(header.data != header_pos.pos && header.data != headerBuf)
+        UA_free(header.data);
     return ret;
 }
 
-/* The resulting variant always has the storagetype UA_VARIANT_DATA. */
+/* Let the variant array point into the decoding buffer instead of allocating
+ * and copying. Only for overlayable types (and bytes) and if the buffer position has the
+ * alignment required by the type. Returns false if decoding shall continue
+ * the usual way. The position is not moved in that case. */
+static UA_Boolean
+Variant_decodeBinaryZeroCopy(UA_Variant *dst, Ctx *ctx) {
+    /* (S)Bytes have no byte order. They are not marked overlayable if the
+     * integer encoding in general is not. */
+    if(!dst->type->overlayable &&
+       dst->type->typeKind != UA_DATATYPEKIND_BYTE &&
+       dst->type->typeKind != UA_DATATYPEKIND_SBYTE)
+        return false;
+
+    /* Decode the length */
+    CtxPos oldPos;
+    ctxSavePos(ctx, &oldPos);
+    i32 signed_length;
+    status ret = DECODE_DIRECT(&signed_length, UInt32); /* Int32 */
+    if(ret != UA_STATUSCODE_GOOD || signed_length <= 0)
+        goto fallback;
+
+    /* Check the length and the alignment. The array has to be contained in the
+     * current segment. */
+    ctxSkipEmpty(ctx);
+    size_t length = (size_t)signed_length;
+    size_t memSize = dst->type->memSize;
+    size_t align = (memSize < 8) ? memSize : 8;
+    if(length > (size_t)(ctx->end - ctx->pos) / memSize ||
+       ((uintptr_t)ctx->pos % align) != 0)
+        goto fallback;
+
+    /* Point into the buffer */
+    dst->data = ctx->pos;
+    dst->arrayLength = length;
+    dst->storageType = UA_VARIANT_DATA_NODELETE;
+    ctx->pos += memSize * length;
+    return true;
+
+ fallback:
+    ctxRestorePos(ctx, &oldPos);
+    return false;
+}
+
+/* The resulting variant has the storagetype UA_VARIANT_DATA. Except for
+ * zero-copy decoding of arrays without dimensions, where the storagetype is
+ * UA_VARIANT_DATA_NODELETE. */
 DECODE_BINARY(Variant) {
     /* Decode the encoding byte */
     u8 encodingByte;
@@ -1248,16 +1730,23 @@ DECODE_BINARY(Variant) {
     dst->type = &UA_TYPES[typeKind];
     if(!isArray) {
         /* Decode scalar */
-        if(typeKind != UA_DATATYPEKIND_EXTENSIONOBJECT) {
-            dst->data = UA_new(dst->type);
+        if(typeKind != UA_DATATYPEKIND_EXTENSIONOBJECT ||
+           ctx->lazyExtensionObjects) {
+            dst->data = ctxCalloc(ctx, 1, dst->type->memSize);
             UA_CHECK_MEM(dst->data, ctx->depth--; return UA_STATUSCODE_BADOUTOFMEMORY);
             ret = decodeBinaryJumpTable[typeKind](dst->data, dst->type, ctx);
         } else {
             ret = Variant_decodeBinaryUnwrapExtensionObject(dst, ctx);
         }
     } else {
-        /* Decode array */
-        if(typeKind != UA_DATATYPEKIND_EXTENSIONOBJECT) {
+        /* Decode array. A NODELETE variant does not free the array
+         * dimensions. So zero-copy only applies without dimensions. */
+        if(ctx->zeroCopy &&
+           (encodingByte & (u8)UA_VARIANT_ENCODINGMASKTYPE_DIMENSIONS) == 0 &&
+           Variant_decodeBinaryZeroCopy(dst, ctx)) {
+            ret = UA_STATUSCODE_GOOD;
+        } else if(typeKind != UA_DATATYPEKIND_EXTENSIONOBJECT ||
+                  ctx->lazyExtensionObjects) {
             ret = Array_decodeBinary(&dst->data, &dst->arrayLength, dst->type, ctx);
         } else {
             ret = Variant_decodeBinaryUnwrapExtensionObjectArray(
@@ -1445,7 +1934,7 @@ DECODE_BINARY(DiagnosticInfo) {
     if(encodingMask & 0x40u) {
         /* innerDiagnosticInfo is allocated on the heap */
         dst->innerDiagnosticInfo =
-            (UA_DiagnosticInfo *)UA_calloc(1, sizeof(UA_DiagnosticInfo));
+            (UA_DiagnosticInfo *)ctxCalloc(ctx, 1, sizeof(UA_DiagnosticInfo));
         UA_CHECK_MEM(dst->innerDiagnosticInfo, return UA_STATUSCODE_BADOUTOFMEMORY);
         dst->hasInnerDiagnosticInfo = true;
 
@@ -1460,6 +1949,196 @@ DECODE_BINARY(DiagnosticInfo) {
     return ret;
 }
 
+/*******************************/
+/* Compiled Encoding Programs  */
+/*******************************/
+
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+
+/* Structures from UA_TYPES are compiled into a flat program of operations on
+ * first use. This avoids looking up the padding, array flag and member type of
+ * every member during each en-/decoding. Consecutive overlayable members
+ * without padding in between have the same layout in memory and on the wire.
+ * They are merged into a single memcpy run.
+ *
+ * The programs are stored in a static pool. So they do not need to be freed
+ * and don't depend on the (exchangeable) memory allocator. If the pool is
+ * exhausted, the remaining types fall back to the generic member loop. */
+
+#define UA_ENCODING_PROGRAMS_POOLSIZE 4096
+
+enum {
+    BINOP_END = 0, /* End of the program */
+    BINOP_COPY,    /* memcpy run of overlayable members */
+    BINOP_ARRAY,   /* Length-prefixed array member */
+    BINOP_CALL     /* Scalar member with an own encoding routine */
+};
+
+typedef struct {
+    u16 kind;
+    u16 offset; /* Offset from the start of the structure */
+    u16 length; /* Number of bytes for BINOP_COPY */
+    const UA_DataType *type; /* Member type for BINOP_ARRAY and BINOP_CALL */
+} BinOp;
+
+static BinOp binOpPool[UA_ENCODING_PROGRAMS_POOLSIZE];
+static void * volatile binOpPoolPos = binOpPool;
+static const BinOp binNoProgram = {BINOP_END, 0, 0, NULL};
+static void * volatile binPrograms[UA_TYPES_COUNT];
+
+/* Reserve space in the pool. Uses compare-and-swap in case of concurrent
+ * compilation in different threads. */
+static BinOp *
+binOpPoolReserve(size_t opsSize) {
+    void *oldPos, *newPos;
+    do {
+        oldPos = binOpPoolPos;
+        if((BinOp*)oldPos + opsSize > &binOpPool[UA_ENCODING_PROGRAMS_POOLSIZE])
+            return NULL;
+        newPos = (BinOp*)oldPos + opsSize;
+    } while(UA_atomic_cmpxchg(&binOpPoolPos, oldPos, newPos) != oldPos);
+    return (BinOp*)oldPos;
+}
+
+static const BinOp *
+compileBinProgram(const UA_DataType *type) {
+    /* Compile into a temporary buffer first. There is at most one operation
+     * per member plus the end marker. */
+    BinOp ops[256];
+    size_t opsSize = 0;
+    uintptr_t offset = 0;
+    for(size_t i = 0; i < type->membersSize; ++i) {
+        const UA_DataTypeMember *m = &type->members[i];
+        const UA_DataType *mt = m->memberType;
+        offset += m->padding;
+
+        if(m->isArray) {
+            ops[opsSize].kind = BINOP_ARRAY;
+            ops[opsSize].offset = (u16)offset;
+            ops[opsSize].length = 0;
+            ops[opsSize].type = mt;
+            opsSize++;
+            offset += sizeof(size_t) + sizeof(void *);
+            continue;
+        }
+
+        if(mt->overlayable) {
+            /* Extend the previous run if there is no padding in between */
+            BinOp *last = (opsSize > 0) ? &ops[opsSize - 1] : NULL;
+            if(last && last->kind == BINOP_COPY &&
+               (uintptr_t)last->offset + last->length == offset) {
+                last->length = (u16)(last->length + mt->memSize);
+            } else {
+                ops[opsSize].kind = BINOP_COPY;
+                ops[opsSize].offset = (u16)offset;
+                ops[opsSize].length = mt->memSize;
+                ops[opsSize].type = NULL;
+                opsSize++;
+            }
+        } else {
+            ops[opsSize].kind = BINOP_CALL;
+            ops[opsSize].offset = (u16)offset;
+            ops[opsSize].length = 0;
+            ops[opsSize].type = mt;
+            opsSize++;
+        }
+        offset += mt->memSize;
+    }
+    ops[opsSize].kind = BINOP_END;
+    ops[opsSize].offset = 0;
+    ops[opsSize].length = 0;
+    ops[opsSize].type = NULL;
+    opsSize++;
+
+    BinOp *prog = binOpPoolReserve(opsSize);
+    if(!prog)
+        return &binNoProgram;
+    memcpy(prog, ops, opsSize * sizeof(BinOp));
+    return prog;
+}
+
+/* Returns NULL if no program is available for the type */
+static const BinOp *
+getBinProgram(const UA_DataType *type) {
+    if(type->typeKind != UA_DATATYPEKIND_STRUCTURE ||
+       (uintptr_t)type < (uintptr_t)UA_TYPES ||
+       (uintptr_t)type >= (uintptr_t)&UA_TYPES[UA_TYPES_COUNT])
+        return NULL;
+    size_t index = (size_t)(type - UA_TYPES);
+    const BinOp *prog = (const BinOp *)binPrograms[index];
+    if(UA_UNLIKELY(!prog)) {
+        /* Concurrent compilations produce identical programs. The first one
+         * to be stored wins. The others remain unused in the pool. */
+        prog = compileBinProgram(type);
+        void *old = UA_atomic_cmpxchg(&binPrograms[index], NULL,
+                                      (void *)(uintptr_t)prog);
+        if(old)
+            prog = (const BinOp *)old;
+    }
+    return (prog != &binNoProgram) ? prog : NULL;
+}
+
+static status
+encodeBinaryProgram(const void *src, const BinOp *op, Ctx *ctx) {
+    status ret = UA_STATUSCODE_GOOD;
+    const uintptr_t base = (uintptr_t)src;
+    for(; op->kind != BINOP_END && ret == UA_STATUSCODE_GOOD; op++) {
+        const uintptr_t ptr = base + op->offset;
+        switch(op->kind) {
+        case BINOP_COPY:
+            /* Fast path if the run fits into the current buffer */
+            if(ctx->end && ctx->pos + op->length <= ctx->end) {
+                memcpy(ctx->pos, (const void*)ptr, op->length);
+                ctx->pos += op->length;
+            } else {
+                ret = Array_encodeBinaryOverlayable(ptr, op->length, ctx);
+            }
+            break;
+        case BINOP_ARRAY:
+            ret = Array_encodeBinary(*(void *UA_RESTRICT const *)(ptr + sizeof(size_t)),
+                                     *(const size_t *)ptr, op->type, ctx);
+            break;
+        default: /* BINOP_CALL */
+            ret = encodeWithExchangeBuffer((const void *)ptr, op->type, ctx);
+            break;
+        }
+        UA_assert(ret != UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+    }
+    return ret;
+}
+
+static status
+decodeBinaryProgram(void *dst, const BinOp *op, Ctx *ctx) {
+    status ret = UA_STATUSCODE_GOOD;
+    const uintptr_t base = (uintptr_t)dst;
+    for(; op->kind != BINOP_END && ret == UA_STATUSCODE_GOOD; op++) {
+        const uintptr_t ptr = base + op->offset;
+        switch(op->kind) {
+        case BINOP_COPY:
+            /* Fast path if the run is contained in the current segment */
+            if(ctx->pos + op->length <= ctx->end) {
+                memcpy((void*)ptr, ctx->pos, op->length);
+                ctx->pos += op->length;
+            } else {
+                ret = ctxRead(ctx, (u8*)ptr, op->length);
+            }
+            break;
+        case BINOP_ARRAY:
+            ret = Array_decodeBinary((void *UA_RESTRICT *UA_RESTRICT)
+                                     (ptr + sizeof(size_t)), (size_t *)ptr,
+                                     op->type, ctx);
+            break;
+        default: /* BINOP_CALL */
+            ret = decodeBinaryJumpTable[op->type->typeKind]((void *UA_RESTRICT)ptr,
+                                                            op->type, ctx);
+            break;
+        }
+    }
+    return ret;
+}
+
+#endif /* UA_ENABLE_ENCODING_PROGRAMS */
+
 /********************/
 /* Structured Types */
 /********************/
@@ -1471,9 +2150,29 @@ encodeBinaryStruct(const void *src, const UA_DataType *type, Ctx *ctx) {
              return UA_STATUSCODE_BADENCODINGERROR);
     ctx->depth++;
 
+    /* Compute the size only (calcSizeBinary mode) */
+    status ret = UA_STATUSCODE_GOOD;
+    if(!ctx->end) {
+        size_t fixedSize = binFixedSizeCached(type);
+        if(fixedSize != BIN_VARIABLESIZE) {
+            ctx->pos += fixedSize;
+            ctx->depth--;
+            return ret;
+        }
+    }
+
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+    /* Use the compiled program if available */
+    const BinOp *prog = getBinProgram(type);
+    if(prog) {
+        ret = encodeBinaryProgram(src, prog, ctx);
+        ctx->depth--;
+        return ret;
+    }
+#endif
+
     /* Loop over members */
     uintptr_t ptr = (uintptr_t)src;
-    status ret = UA_STATUSCODE_GOOD;
     for(size_t i = 0; i < type->membersSize && ret == UA_STATUSCODE_GOOD; ++i) {
         const UA_DataTypeMember *m = &type->members[i];
         const UA_DataType *mt = m->memberType;
@@ -1721,8 +2420,18 @@ decodeBinaryStructure(void *dst, const UA_DataType *type, Ctx *ctx) {
              return UA_STATUSCODE_BADENCODINGERROR);
     ctx->depth++;
 
-    uintptr_t ptr = (uintptr_t)dst;
     status ret = UA_STATUSCODE_GOOD;
+#ifdef UA_ENABLE_ENCODING_PROGRAMS
+    /* Use the compiled program if available */
+    const BinOp *prog = getBinProgram(type);
+    if(prog) {
+        ret = decodeBinaryProgram(dst, prog, ctx);
+        ctx->depth--;
+        return ret;
+    }
+#endif
+
+    uintptr_t ptr = (uintptr_t)dst;
     u8 membersSize = type->membersSize;
 
     /* Loop over members */
@@ -1780,7 +2489,7 @@ decodeBinaryStructureWithOptFields(void *dst, const UA_DataType *type, Ctx *ctx)
                                          ctx);
             } else {
                 /* Optional Scalar */
-                *(void *UA_RESTRICT *UA_RESTRICT)ptr = UA_calloc(1, mt->memSize);
+                *(void *UA_RESTRICT *UA_RESTRICT)ptr = ctxCalloc(ctx, 1, mt->memSize);
                 UA_CHECK_MEM(*(void *UA_RESTRICT *UA_RESTRICT)ptr,
                              return UA_STATUSCODE_BADOUTOFMEMORY);
                 ret = decodeBinaryJumpTable[mt->typeKind](
@@ -1882,12 +2591,49 @@ const decodeBinarySignature decodeBinaryJumpTable[UA_DATATYPEKINDS] = {
 status
 UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset, void *dst,
                         const UA_DataType *type, const UA_DataTypeArray *customTypes) {
-    /* Set up the context */
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.customTypes = customTypes;
+    return UA_decodeBinaryInternalOptions(src, offset, dst, type, &opts);
+}
+
+status
+UA_decodeBinaryInternalOptions(const UA_ByteString *src, size_t *offset, void *dst,
+                               const UA_DataType *type,
+                               const UA_DecodeBinaryOptions *options) {
+    return UA_decodeBinaryInternalSegments(src, 1, offset, dst, type, options);
+}
+
+status
+UA_decodeBinaryInternalSegments(const UA_ByteString *segments, size_t segmentsSize,
+                                size_t *offset, void *dst, const UA_DataType *type,
+                                const UA_DecodeBinaryOptions *options) {
+    UA_assert(segmentsSize > 0);
+
+    /* Set up the context. Find the segment with the offset. */
     Ctx ctx;
-    ctx.pos = &src->data[*offset];
-    ctx.end = &src->data[src->length];
+    ctx.segments = segments;
+    ctx.segmentsSize = segmentsSize;
+    ctx.segment = 0;
+    ctx.segmentOffset = 0;
+    ctx.segmentsRest = 0;
+    for(size_t i = 1; i < segmentsSize; i++)
+        ctx.segmentsRest += segments[i].length;
+    while(*offset > ctx.segmentOffset + segments[ctx.segment].length &&
+          ctxNextSegment(&ctx)) {}
+    size_t segPos = *offset - ctx.segmentOffset;
+    if(segPos > segments[ctx.segment].length) {
+        memset(dst, 0, type->memSize);
+        return UA_STATUSCODE_BADDECODINGERROR;
+    }
+    ctx.pos = &segments[ctx.segment].data[segPos];
+    ctx.end = &segments[ctx.segment].data[segments[ctx.segment].length];
     ctx.depth = 0;
-    ctx.customTypes = customTypes;
+    ctx.customTypes = options ? options->customTypes : NULL;
+    ctx.zeroCopy = options ? options->zeroCopy : false;
+    ctx.arena = options ? options->arena : NULL;
+    ctx.typeIndex = options ? options->typeIndex : NULL;
+    ctx.lazyExtensionObjects = options ? options->lazyExtensionObjects : false;
 
     /* Decode */
     memset(dst, 0, type->memSize); /* Initialize the value */
@@ -1895,10 +2641,11 @@ UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset, void *dst,
 
     if(UA_LIKELY(ret == UA_STATUSCODE_GOOD)) {
         /* Set the new offset */
-        *offset = (size_t)(ctx.pos - src->data) / sizeof(u8);
+        *offset = ctxOffset(&ctx);
     } else {
-        /* Clean up */
-        UA_clear(dst, type);
+        /* Clean up. Memory from the arena is released with the arena. */
+        if(!ctx.arena)
+            UA_clear(dst, type);
         memset(dst, 0, type->memSize);
     }
     return ret;
@@ -1908,8 +2655,47 @@ UA_StatusCode
 UA_decodeBinary(const UA_ByteString *inBuf, void *p, const UA_DataType *type,
                 const UA_DecodeBinaryOptions *options) {
     size_t offset = 0;
-    const UA_DataTypeArray *customTypes = options ? options->customTypes : NULL;
-    return UA_decodeBinaryInternal(inBuf, &offset, p, type, customTypes);
+    return UA_decodeBinaryInternalOptions(inBuf, &offset, p, type, options);
+}
+
+UA_StatusCode
+UA_ExtensionObject_ensureDecoded(UA_ExtensionObject *eo,
+                                 const UA_DecodeBinaryOptions *options) {
+    if(eo->encoding >= UA_EXTENSIONOBJECT_DECODED)
+        return UA_STATUSCODE_GOOD;
+    if(eo->encoding != UA_EXTENSIONOBJECT_ENCODED_BYTESTRING)
+        return UA_STATUSCODE_BADDECODINGERROR;
+
+    /* Lookup the datatype */
+    Ctx ctx;
+    memset(&ctx, 0, sizeof(Ctx));
+    ctx.customTypes = options ? options->customTypes : NULL;
+    ctx.typeIndex = options ? options->typeIndex : NULL;
+    ctx.arena = options ? options->arena : NULL;
+    const UA_DataType *type =
+        UA_findDataTypeByBinaryInternal(&eo->content.encoded.typeId, &ctx);
+    if(!type)
+        return UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+
+    /* Decode the body */
+    void *data = ctxCalloc(&ctx, 1, type->memSize);
+    UA_CHECK_MEM(data, return UA_STATUSCODE_BADOUTOFMEMORY);
+    size_t offset = 0;
+    status ret = UA_decodeBinaryInternalOptions(&eo->content.encoded.body,
+                                                &offset, data, type, options);
+    if(ret != UA_STATUSCODE_GOOD) {
+        ctxFree(&ctx, data);
+        return ret;
+    }
+
+    /* Replace the encoded content */
+    ctxClearNodeId(&ctx, &eo->content.encoded.typeId);
+    if(!ctx.arena)
+        UA_ByteString_clear(&eo->content.encoded.body);
+    eo->encoding = UA_EXTENSIONOBJECT_DECODED;
+    eo->content.decoded.type = type;
+    eo->content.decoded.data = data;
+    return UA_STATUSCODE_GOOD;
 }
 
 /**
@@ -1921,6 +2707,11 @@ UA_decodeBinary(const UA_ByteString *inBuf, void *p, const UA_DataType *type,
 
 size_t
 UA_calcSizeBinary(const void *p, const UA_DataType *type) {
+    if(!p || !type)
+        return 0;
+    size_t fixedSize = binFixedSize(type, 0);
+    if(fixedSize != BIN_VARIABLESIZE)
+        return fixedSize;
     u8 *pos = NULL;
     const u8 *posEnd = NULL;
     UA_StatusCode res = UA_encodeBinaryInternal(p, type, &pos, &posEnd, NULL, NULL);
@@ -67,6 +67,25 @@ UA_decodeBinaryInternal(const UA_ByteString *src, size_t *offset,
                         const UA_DataTypeArray *customTypes)
     UA_FUNC_ATTR_WARN_UNUSED_RESULT;
 
+/* Same as above. But with the full decoding options (zero-copy, etc.). The
+ * options can be NULL. */
+UA_StatusCode
+UA_decodeBinaryInternalOptions(const UA_ByteString *src, size_t *offset,
+                               void *dst, const UA_DataType *type,
+                               const UA_DecodeBinaryOptions *options)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
+/* Same as above. But the input is split into several segments, for example the
+ * payloads of the chunks of a message. Decoding reads across the segment
+ * boundaries without reassembling the input. The offset refers to the position
+ * in the concatenated segments. Zero-copy decoding applies only to arrays that
+ * are contained within one segment. */
+UA_StatusCode
+UA_decodeBinaryInternalSegments(const UA_ByteString *segments, size_t segmentsSize,
+                                size_t *offset, void *dst, const UA_DataType *type,
+                                const UA_DecodeBinaryOptions *options)
+    UA_FUNC_ATTR_WARN_UNUSED_RESULT;
+
 const UA_DataType *
 UA_findDataTypeByBinary(const UA_NodeId *typeId);
 
@@ -57,10 +57,40 @@
 #define ENCODE_DIRECT_JSON(SRC, TYPE) \
     TYPE##_encodeJson(ctx, (const UA_##TYPE*)SRC, NULL)
 
+/* Grow the output buffer to fit at least len more bytes. The size is doubled
+ * so that the encoding needs a logarithmic number of reallocations. */
 static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
-writeChar(CtxJson *ctx, char c) {
-    if(ctx->pos >= ctx->end)
+growJsonBuffer(CtxJson *ctx, size_t len) {
+    UA_ByteString *buf = ctx->growBuf;
+    size_t offset = (size_t)(ctx->pos - buf->data);
+    size_t newLength = buf->length * 2;
+    if(newLength < offset + len)
+        newLength = offset + len;
+    UA_Byte *newData = (UA_Byte*)UA_realloc(buf->data, newLength);
+    if(!newData)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    buf->data = newData;
+    buf->length = newLength;
+    ctx->pos = &newData[offset];
+    ctx->end = &newData[newLength];
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Ensure that len bytes can be written at the current position */
+static UA_INLINE status UA_FUNC_ATTR_WARN_UNUSED_RESULT
+reserveJson(CtxJson *ctx, size_t len) {
+    if(UA_LIKELY(ctx->pos + len <= ctx->end))
+        return UA_STATUSCODE_GOOD;
+    if(!ctx->growBuf)
         return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    return growJsonBuffer(ctx, len);
+}
+
+static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
+writeChar(CtxJson *ctx, char c) {
+    status res = reserveJson(ctx, 1);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
     if(!ctx->calcOnly)
         *ctx->pos = (UA_Byte)c;
     ctx->pos++;
@@ -69,8 +99,9 @@ writeChar(CtxJson *ctx, char c) {
 
 static status UA_FUNC_ATTR_WARN_UNUSED_RESULT
 writeChars(CtxJson *ctx, const char *c, size_t len) {
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, len);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
     if(!ctx->calcOnly)
         memcpy(ctx->pos, c, len);
     ctx->pos += len;
@@ -261,8 +292,9 @@ ENCODE_JSON(Byte) {
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
     /* Ensure destination can hold the data- */
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     /* Copy digits to the output string/buffer. */
     if(!ctx->calcOnly)
@@ -275,8 +307,9 @@ ENCODE_JSON(Byte) {
 ENCODE_JSON(SByte) {
     char buf[5];
     UA_UInt16 digits = itoaSigned(*src, buf);
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
     ctx->pos += digits;
@@ -288,8 +321,9 @@ ENCODE_JSON(UInt16) {
     char buf[6];
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -302,8 +336,9 @@ ENCODE_JSON(Int16) {
     char buf[7];
     UA_UInt16 digits = itoaSigned(*src, buf);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -316,8 +351,9 @@ ENCODE_JSON(UInt32) {
     char buf[11];
     UA_UInt16 digits = itoaUnsigned(*src, buf, 10);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -330,8 +366,9 @@ ENCODE_JSON(Int32) {
     char buf[12];
     UA_UInt16 digits = itoaSigned(*src, buf);
 
-    if(ctx->pos + digits > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, digits);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, digits);
@@ -347,8 +384,9 @@ ENCODE_JSON(UInt64) {
     buf[digits + 1] = '\"';
     UA_UInt16 length = (UA_UInt16)(digits + 2);
 
-    if(ctx->pos + length > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, length);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, length);
@@ -364,8 +402,9 @@ ENCODE_JSON(Int64) {
     buf[digits + 1] = '\"';
     UA_UInt16 length = (UA_UInt16)(digits + 2);
 
-    if(ctx->pos + length > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, length);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buf, length);
@@ -389,8 +428,9 @@ ENCODE_JSON(Float) {
         len = dtoa((UA_Double)*src, buffer);
     }
 
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, len);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buffer, len);
@@ -414,8 +454,9 @@ ENCODE_JSON(Double) {
         len = dtoa(*src, buffer);
     }
 
-    if(ctx->pos + len > ctx->end)
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, len);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
 
     if(!ctx->calcOnly)
         memcpy(ctx->pos, buffer, len);
@@ -434,6 +475,20 @@ encodeJsonArray(CtxJson *ctx, const void *ptr, size_t length,
 
     uintptr_t uptr = (uintptr_t)ptr;
     encodeJsonSignature encodeType = encodeJsonJumpTable[type->typeKind];
+
+    /* Numeric arrays without pretty-printing. The elements cannot be null and
+     * only need a comma separator. */
+    if(!ctx->prettyPrint && type->typeKind <= UA_DATATYPEKIND_DOUBLE) {
+        for(size_t i = 0; i < length && ret == UA_STATUSCODE_GOOD; ++i) {
+            if(i > 0)
+                ret |= writeChar(ctx, ',');
+            ret |= encodeType(ctx, (const void*)uptr, type);
+            uptr += type->memSize;
+        }
+        ctx->commaNeeded[ctx->depth] = (length > 0);
+        return ret | writeJsonArrEnd(ctx);
+    }
+
     UA_Boolean distinct = (type->typeKind > UA_DATATYPEKIND_DOUBLE);
     for(size_t i = 0; i < length && ret == UA_STATUSCODE_GOOD; ++i) {
         ret |= writeJsonBeforeElement(ctx, distinct);
@@ -496,6 +551,24 @@ extract_codepoint(const unsigned char *pos, size_t len, uint32_t *codepoint) {
     return pos + count; /* Return the new position in the pos */
 }
 
+/* Test eight bytes at once if they contain a character that needs escaping
+ * or a non-ASCII byte (SIMD within a register). False positives are possible
+ * and are handled by the per-codepoint path. */
+#define JSON_ONES  0x0101010101010101ull
+#define JSON_HIGHS 0x8080808080808080ull
+#define JSON_HASZERO(w) (((w) - JSON_ONES) & ~(w) & JSON_HIGHS)
+
+static UA_INLINE UA_Boolean
+needsEscape8(const unsigned char *pos) {
+    UA_UInt64 w;
+    memcpy(&w, pos, 8);
+    return ((w & JSON_HIGHS) |
+            (((w) - (JSON_ONES * ' ')) & ~(w) & JSON_HIGHS) | /* < ' ' */
+            JSON_HASZERO(w ^ (JSON_ONES * '\"')) |
+            JSON_HASZERO(w ^ (JSON_ONES * '\\')) |
+            JSON_HASZERO(w ^ (JSON_ONES * 127))) != 0;
+}
+
 ENCODE_JSON(String) {
     if(!src->data)
         return writeChars(ctx, "null", 4);
@@ -514,6 +587,13 @@ ENCODE_JSON(String) {
         /* Iterate over codepoints in the utf8 encoding. Until the first
          * character that needs to be escaped. */
         while(end < lim) {
+            /* Fast path for plain ASCII */
+            if(lim - pos >= 8 && !needsEscape8(pos)) {
+                pos += 8;
+                end = pos;
+                continue;
+            }
+
             end = extract_codepoint(pos, (size_t)(lim - pos), &codepoint);
             if(!end)  {
                 /* A malformed utf8 character. Print anyway and let the
@@ -533,8 +613,9 @@ ENCODE_JSON(String) {
 
         /* Write out the characters that don't need escaping */
         if(pos != str) {
-            if(ctx->pos + (pos - str) > ctx->end)
-                return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+            status res = reserveJson(ctx, (size_t)(pos - str));
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
             if(!ctx->calcOnly)
                 memcpy(ctx->pos, str, (size_t)(pos - str));
             ctx->pos += pos - str;
@@ -595,8 +676,9 @@ ENCODE_JSON(String) {
             }
             break;
         }
-        if(ctx->pos + length > ctx->end)
-            return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+        status res = reserveJson(ctx, length);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
         if(!ctx->calcOnly)
             memcpy(ctx->pos, text, length);
         ctx->pos += length;
@@ -617,35 +699,26 @@ ENCODE_JSON(ByteString) {
         return retval;
     }
 
+    /* Encode directly into the output buffer. Only compute the length if no
+     * output is written. */
+    size_t flen = 4 * ((src->length + 2) / 3);
+    if(flen < src->length)
+        return UA_STATUSCODE_BADENCODINGERROR; /* integer overflow */
     status ret = writeJsonQuote(ctx);
-    size_t flen = 0;
-    unsigned char *ba64 = UA_base64(src->data, src->length, &flen);
-
-    /* Not converted, no mem */
-    if(!ba64)
-        return UA_STATUSCODE_BADENCODINGERROR;
-
-    if(ctx->pos + flen > ctx->end) {
-        UA_free(ba64);
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
-    }
-
-    /* Copy flen bytes to output stream. */
+    ret |= reserveJson(ctx, flen);
+    if(ret != UA_STATUSCODE_GOOD)
+        return ret;
     if(!ctx->calcOnly)
-        memcpy(ctx->pos, ba64, flen);
+        flen = UA_base64_buf(src->data, src->length, ctx->pos);
     ctx->pos += flen;
-
-    /* Base64 result no longer needed */
-    UA_free(ba64);
-
-    ret |= writeJsonQuote(ctx);
-    return ret;
+    return writeJsonQuote(ctx);
 }
 
 /* Guid */
 ENCODE_JSON(Guid) {
-    if(ctx->pos + 38 > ctx->end) /* 36 + 2 (") */
-        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    status res = reserveJson(ctx, 38); /* 36 + 2 (") */
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
     status ret = writeJsonQuote(ctx);
     if(!ctx->calcOnly)
         UA_Guid_to_hex(src, ctx->pos, false);
@@ -747,17 +820,35 @@ NodeId_encodeJsonInternal(CtxJson *ctx, UA_NodeId const *src) {
     return ret;
 }
 
+/* Print into a stack buffer. Allocate only for long identifiers. */
+#define UA_JSON_NODEID_BUFSIZE 64
+
+static status
+encodeJsonNodeIdString(CtxJson *ctx, const void *src, UA_Boolean expanded) {
+    UA_Byte buf[UA_JSON_NODEID_BUFSIZE];
+    UA_String out = {UA_JSON_NODEID_BUFSIZE, buf};
+    status ret = (expanded) ?
+        UA_ExpandedNodeId_print((const UA_ExpandedNodeId*)src, &out) :
+        UA_NodeId_print((const UA_NodeId*)src, &out);
+    if(ret == UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED) {
+        out = UA_STRING_NULL;
+        ret = (expanded) ?
+            UA_ExpandedNodeId_print((const UA_ExpandedNodeId*)src, &out) :
+            UA_NodeId_print((const UA_NodeId*)src, &out);
+    }
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = encodeJsonJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
+    if(out.data != buf)
+        UA_String_clear(&out);
+    return ret;
+}
+
 ENCODE_JSON(NodeId) {
     /* Encode as string (non-standard). Encode with the standard utf8 escaping.
      * As the NodeId can contain quote characters, etc. */
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
-    if(ctx->stringNodeIds) {
-        UA_String out = UA_STRING_NULL;
-        ret |= UA_NodeId_print(src, &out);
-        ret |= encodeJsonJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
-        UA_String_clear(&out);
-        return ret;
-    }
+    if(ctx->stringNodeIds)
+        return encodeJsonNodeIdString(ctx, src, false);
 
     /* Encode as object */
     ret |= writeJsonObjStart(ctx);
@@ -796,13 +887,8 @@ ENCODE_JSON(ExpandedNodeId) {
     /* Encode as string (non-standard). Encode with utf8 escaping as the NodeId
      * can contain quote characters, etc. */
     UA_StatusCode ret = UA_STATUSCODE_GOOD;
-    if(ctx->stringNodeIds) {
-        UA_String out = UA_STRING_NULL;
-        ret |= UA_ExpandedNodeId_print(src, &out);
-        ret |= encodeJsonJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
-        UA_String_clear(&out);
-        return ret;
-    }
+    if(ctx->stringNodeIds)
+        return encodeJsonNodeIdString(ctx, src, true);
 
     /* Encode as object */
     ret |= writeJsonObjStart(ctx);
@@ -1293,20 +1379,21 @@ UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
     if(!src || !type)
         return UA_STATUSCODE_BADINTERNALERROR;
 
-    /* Allocate buffer */
+    /* Allocate a buffer that grows during the encoding. So the value is
+     * encoded only once and not also for UA_calcSizeJson. */
+    CtxJson ctx;
+    memset(&ctx, 0, sizeof(ctx));
     UA_Boolean allocated = false;
     status res = UA_STATUSCODE_GOOD;
     if(outBuf->length == 0) {
-        size_t len = UA_calcSizeJson(src, type, options);
-        res = UA_ByteString_allocBuffer(outBuf, len);
+        res = UA_ByteString_allocBuffer(outBuf, UA_JSON_ENCODING_INITIALSIZE);
         if(res != UA_STATUSCODE_GOOD)
             return res;
         allocated = true;
+        ctx.growBuf = outBuf;
     }
 
     /* Set up the context */
-    CtxJson ctx;
-    memset(&ctx, 0, sizeof(ctx));
     ctx.pos = outBuf->data;
     ctx.end = &outBuf->data[outBuf->length];
     ctx.depth = 0;
@@ -1327,12 +1414,20 @@ UA_encodeJson(const void *src, const UA_DataType *type, UA_ByteString *outBuf,
     res = encodeJsonJumpTable[type->typeKind](&ctx, src, type);
 
     /* Clean up */
-    if(res == UA_STATUSCODE_GOOD) {
-        outBuf->length = (size_t)((uintptr_t)ctx.pos - (uintptr_t)outBuf->data);
-    } else if(allocated) {
-        UA_ByteString_clear(outBuf);
+    if(res != UA_STATUSCODE_GOOD) {
+        if(allocated)
+            UA_ByteString_clear(outBuf);
+        return res;
     }
-    return res;
+    outBuf->length = (size_t)((uintptr_t)ctx.pos - (uintptr_t)outBuf->data);
+
+    /* Release the unused tail of the allocated buffer */
+    if(allocated && outBuf->length > 0) {
+        UA_Byte *data = (UA_Byte*)UA_realloc(outBuf->data, outBuf->length);
+        if(data)
+            outBuf->data = data;
+    }
+    return UA_STATUSCODE_GOOD;
 }
 
 UA_StatusCode
@@ -1434,14 +1529,43 @@ UA_calcSizeJson(const void *src, const UA_DataType *type,
 
 /* If ctx->index points to the beginning of an object, move the index to the
  * next token after this object. Attention! The index can be moved after the
- * last parsed token. So the array length has to be checked afterwards. */
+ * last parsed token. So the array length has to be checked afterwards.
+ *
+ * The tokens are stored in the order of their start position. So the first
+ * token after the object is found with a galloping search in O(log n) of the
+ * object size. Skipping large values does not scan their nested tokens. This
+ * matters for lookAheadForKey which is called repeatedly on the same object. */
 static void
 skipObject(ParseCtx *ctx) {
-    unsigned int end = ctx->tokens[ctx->index].end;
-    do {
+    const cj5_token *t = &ctx->tokens[ctx->index];
+    if((t->type != CJ5_TOKEN_OBJECT && t->type != CJ5_TOKEN_ARRAY) ||
+       t->size == 0) {
         ctx->index++;
-    } while(ctx->index < ctx->tokensSize &&
-            ctx->tokens[ctx->index].start < end);
+        return;
+    }
+
+    /* The direct children are part of the object. So lo is inside. */
+    unsigned int end = t->end;
+    size_t lo = ctx->index + t->size;
+    size_t step = 1;
+    size_t hi = lo + step;
+    while(hi < ctx->tokensSize && ctx->tokens[hi].start < end) {
+        lo = hi;
+        step <<= 1;
+        hi = lo + step;
+    }
+    if(hi > ctx->tokensSize)
+        hi = ctx->tokensSize;
+
+    /* Binary search for the first token after the object in (lo, hi] */
+    while(hi - lo > 1) {
+        size_t mid = lo + ((hi - lo) / 2);
+        if(ctx->tokens[mid].start < end)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    ctx->index = hi;
 }
 
 static status
@@ -19,11 +19,16 @@ _UA_BEGIN_DECLS
 
 #define UA_JSON_MAXTOKENCOUNT 256
 #define UA_JSON_ENCODING_MAX_RECURSION 100
+#define UA_JSON_ENCODING_INITIALSIZE 256 /* Initial size of growing buffers */
 
 typedef struct {
     uint8_t *pos;
     const uint8_t *end;
 
+    /* If set, the buffer is reallocated when the end is reached instead of
+     * returning BADENCODINGLIMITSEXCEEDED. The pos and end point into it. */
+    UA_ByteString *growBuf;
+
     uint16_t depth; /* How often did we en-/decoding recurse? */
     UA_Boolean commaNeeded[UA_JSON_ENCODING_MAX_RECURSION];
     UA_Boolean useReversible;
@@ -76,6 +81,10 @@ typedef struct {
     size_t numCustom;
     void * custom;
     size_t currentCustomIndex;
+
+    /* Optional DataSetMetaData lookup for the schema-driven decoding of
+     * DataSetMessages (see ua_pubsub_networkmessage_json.c) */
+    const void *customSchema;
 } ParseCtx;
 
 typedef UA_StatusCode
@@ -231,28 +231,37 @@ ENCODE_XML(DateTime) {
     return xmlEncodeWriteChars(ctx, (const char*)str.data, str.length);
 }
 
-/* NodeId */
-ENCODE_XML(NodeId) {
-    UA_StatusCode ret = UA_STATUSCODE_GOOD;
-    UA_String out = UA_STRING_NULL;
-
-    ret |= UA_NodeId_print(src, &out);
-    ret |= encodeXmlJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
+/* Print into a stack buffer. Allocate only for long identifiers. */
+#define UA_XML_NODEID_BUFSIZE 64
 
-    UA_String_clear(&out);
+static status
+encodeXmlNodeIdString(CtxXml *ctx, const void *src, UA_Boolean expanded) {
+    UA_Byte buf[UA_XML_NODEID_BUFSIZE];
+    UA_String out = {UA_XML_NODEID_BUFSIZE, buf};
+    status ret = (expanded) ?
+        UA_ExpandedNodeId_print((const UA_ExpandedNodeId*)src, &out) :
+        UA_NodeId_print((const UA_NodeId*)src, &out);
+    if(ret == UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED) {
+        out = UA_STRING_NULL;
+        ret = (expanded) ?
+            UA_ExpandedNodeId_print((const UA_ExpandedNodeId*)src, &out) :
+            UA_NodeId_print((const UA_NodeId*)src, &out);
+    }
+    if(ret == UA_STATUSCODE_GOOD)
+        ret = encodeXmlJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
+    if(out.data != buf)
+        UA_String_clear(&out);
     return ret;
 }
 
+/* NodeId */
+ENCODE_XML(NodeId) {
+    return encodeXmlNodeIdString(ctx, src, false);
+}
+
 /* ExpandedNodeId */
 ENCODE_XML(ExpandedNodeId) {
-    UA_StatusCode ret = UA_STATUSCODE_GOOD;
-    UA_String out = UA_STRING_NULL;
-
-    ret |= UA_ExpandedNodeId_print(src, &out);
-    ret |= encodeXmlJumpTable[UA_DATATYPEKIND_STRING](ctx, &out, NULL);
-
-    UA_String_clear(&out);
-    return ret;
+    return encodeXmlNodeIdString(ctx, src, true);
 }
 
 static status
@@ -0,0 +1,180 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/server.h>
+
+#include "../server/ua_server_internal.h"
+
+#ifdef UA_DEBUG_ALLOC_PROFILE
+
+#include <stdlib.h>
+
+/* The allocators below the profiling layer */
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+# define PROFILE_MALLOC(size) UA_mallocSingleton(size)
+# define PROFILE_CALLOC(num, size) UA_callocSingleton(num, size)
+# define PROFILE_REALLOC(ptr, size) UA_reallocSingleton(ptr, size)
+#else
+# define PROFILE_MALLOC(size) malloc(size)
+# define PROFILE_CALLOC(num, size) calloc(num, size)
+# define PROFILE_REALLOC(ptr, size) realloc(ptr, size)
+#endif
+
+/* Open addressing hash table of the call sites. A slot is claimed with a
+ * compare-and-swap on the file pointer. The line is set right after. Sites
+ * that do not fit into the table are counted as untracked. */
+#define ALLOC_SITES 4096 /* Power of two */
+#define ALLOC_PROBES 64
+
+typedef struct {
+    const char * volatile file;
+    volatile uint32_t line;
+    volatile uint64_t count;
+    volatile uint64_t bytes;
+} AllocSite;
+
+static AllocSite allocSites[ALLOC_SITES];
+static volatile uint64_t phaseCount[UA_ALLOCPHASES];
+static volatile uint64_t phaseBytes[UA_ALLOCPHASES];
+static volatile uint64_t untrackedCount;
+static volatile uint64_t untrackedBytes;
+
+static UA_THREAD_LOCAL UA_AllocPhase currentPhase = UA_ALLOCPHASE_OTHER;
+
+UA_AllocPhase
+UA_AllocPhase_set(UA_AllocPhase phase) {
+    UA_AllocPhase old = currentPhase;
+    currentPhase = phase;
+    return old;
+}
+
+static AllocSite *
+findSite(const char *file, unsigned int line) {
+    size_t hash = (((uintptr_t)file >> 3) ^ (line * 2654435761u)) & (ALLOC_SITES - 1);
+    for(size_t i = 0; i < ALLOC_PROBES; i++) {
+        AllocSite *site = &allocSites[(hash + i) & (ALLOC_SITES - 1)];
+        const char *f = site->file;
+        if(!f) {
+            f = (const char*)UA_atomic_cmpxchg((void * volatile *)(uintptr_t)&site->file,
+                                               NULL, (void*)(uintptr_t)file);
+            if(!f) {
+                UA_atomic_addUInt32(&site->line, line);
+                return site;
+            }
+        }
+        if(f != file)
+            continue;
+        /* Wait until the line of a concurrently claimed slot is set */
+        while(site->line == 0) {}
+        if(site->line == line)
+            return site;
+    }
+    return NULL;
+}
+
+static void
+countAllocation(size_t size, const char *file, unsigned int line) {
+    UA_atomic_addUInt64(&phaseCount[currentPhase], 1);
+    UA_atomic_addUInt64(&phaseBytes[currentPhase], size);
+    AllocSite *site = findSite(file, line);
+    if(!site) {
+        UA_atomic_addUInt64(&untrackedCount, 1);
+        UA_atomic_addUInt64(&untrackedBytes, size);
+        return;
+    }
+    UA_atomic_addUInt64(&site->count, 1);
+    UA_atomic_addUInt64(&site->bytes, size);
+}
+
+void *
+UA_mallocProfiled(size_t size, const char *file, unsigned int line) {
+    countAllocation(size, file, line);
+    return PROFILE_MALLOC(size);
+}
+
+void *
+UA_callocProfiled(size_t num, size_t size, const char *file, unsigned int line) {
+    countAllocation(num * size, file, line);
+    return PROFILE_CALLOC(num, size);
+}
+
+void *
+UA_reallocProfiled(void *ptr, size_t size, const char *file, unsigned int line) {
+    countAllocation(size, file, line);
+    return PROFILE_REALLOC(ptr, size);
+}
+
+/* Statistics */
+
+static int
+compareSites(const void *a, const void *b) {
+    const UA_AllocSiteStatistics *sa = (const UA_AllocSiteStatistics*)a;
+    const UA_AllocSiteStatistics *sb = (const UA_AllocSiteStatistics*)b;
+    if(sa->counter.count != sb->counter.count)
+        return (sa->counter.count < sb->counter.count) ? 1 : -1;
+    return (sa->counter.bytes < sb->counter.bytes) - (sa->counter.bytes > sb->counter.bytes);
+}
+
+UA_StatusCode
+UA_Server_getAllocStatistics(UA_Server *server, UA_AllocStatistics *stats) {
+    (void)server;
+    memset(stats, 0, sizeof(UA_AllocStatistics));
+    for(size_t i = 0; i < UA_ALLOCPHASES; i++) {
+        stats->phases[i].count = UA_atomic_addUInt64(&phaseCount[i], 0);
+        stats->phases[i].bytes = UA_atomic_addUInt64(&phaseBytes[i], 0);
+    }
+    stats->untracked.count = UA_atomic_addUInt64(&untrackedCount, 0);
+    stats->untracked.bytes = UA_atomic_addUInt64(&untrackedBytes, 0);
+
+    /* The result is not allocated with UA_malloc. So the retrieval of the
+     * statistics does not show up in the statistics. */
+    size_t count = 0;
+    for(size_t i = 0; i < ALLOC_SITES; i++) {
+        if(allocSites[i].line != 0 && allocSites[i].count > 0)
+            count++;
+    }
+    if(count == 0)
+        return UA_STATUSCODE_GOOD;
+    stats->sites = (UA_AllocSiteStatistics*)
+        PROFILE_CALLOC(count, sizeof(UA_AllocSiteStatistics));
+    if(!stats->sites)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    for(size_t i = 0; i < ALLOC_SITES && stats->sitesSize < count; i++) {
+        AllocSite *site = &allocSites[i];
+        if(site->line == 0 || site->count == 0)
+            continue;
+        UA_AllocSiteStatistics *s = &stats->sites[stats->sitesSize++];
+        s->file = site->file;
+        s->line = site->line;
+        s->counter.count = UA_atomic_addUInt64(&site->count, 0);
+        s->counter.bytes = UA_atomic_addUInt64(&site->bytes, 0);
+    }
+    qsort(stats->sites, stats->sitesSize, sizeof(UA_AllocSiteStatistics), compareSites);
+    return UA_STATUSCODE_GOOD;
+}
+
+void
+UA_AllocStatistics_clear(UA_AllocStatistics *stats) {
+    UA_free(stats->sites);
+    memset(stats, 0, sizeof(UA_AllocStatistics));
+}
+
+/* Concurrent allocations during the reset can be partially counted */
+void
+UA_Server_resetAllocStatistics(UA_Server *server) {
+    (void)server;
+    for(size_t i = 0; i < UA_ALLOCPHASES; i++) {
+        phaseCount[i] = 0;
+        phaseBytes[i] = 0;
+    }
+    untrackedCount = 0;
+    untrackedBytes = 0;
+    for(size_t i = 0; i < ALLOC_SITES; i++) {
+        allocSites[i].count = 0;
+        allocSites[i].bytes = 0;
+    }
+}
+
+#endif /* UA_DEBUG_ALLOC_PROFILE */
@@ -88,8 +88,37 @@ UA_Guid_parse(UA_Guid *guid, const UA_String str) {
     return res;
 }
 
+/* Take len bytes from the front of the caller-provided buffer */
 static UA_StatusCode
-parse_nodeid_body(UA_NodeId *id, const char *body, const char *end) {
+take_buf(UA_ByteString *buf, size_t len, UA_Byte **out) {
+    if(len > buf->length)
+        return UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED;
+    *out = (len > 0) ? buf->data : (UA_Byte*)UA_EMPTY_ARRAY_SENTINEL;
+    buf->data += len;
+    buf->length -= len;
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Copy the string into the buffer if defined. Otherwise allocate. */
+static UA_StatusCode
+parse_string(UA_String *str, const char *s, size_t len, UA_ByteString *buf) {
+    UA_String tmpstr;
+    tmpstr.data = (UA_Byte*)(uintptr_t)s;
+    tmpstr.length = len;
+    if(!buf)
+        return UA_String_copy(&tmpstr, str);
+    UA_StatusCode res = take_buf(buf, len, &str->data);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    if(len > 0)
+        memcpy(str->data, s, len);
+    str->length = len;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+parse_nodeid_body(UA_NodeId *id, const char *body, const char *end,
+                  UA_ByteString *buf) {
     size_t len = (size_t)(end - (body+2));
     UA_StatusCode res = UA_STATUSCODE_GOOD;
     switch(*body) {
@@ -100,10 +129,7 @@ parse_nodeid_body(UA_NodeId *id, const char *body, const char *end) {
         break;
     }
     case 's': {
-        UA_String tmpstr;
-        tmpstr.data = (UA_Byte*)(uintptr_t)body+2;
-        tmpstr.length = len;
-        res = UA_String_copy(&tmpstr, &id->identifier.string);
+        res = parse_string(&id->identifier.string, body+2, len, buf);
         if(res != UA_STATUSCODE_GOOD)
             break;
         id->identifierType = UA_NODEIDTYPE_STRING;
@@ -115,11 +141,27 @@ parse_nodeid_body(UA_NodeId *id, const char *body, const char *end) {
             id->identifierType = UA_NODEIDTYPE_GUID;
         break;
     case 'b':
-        id->identifier.byteString.data =
-            UA_unbase64((const unsigned char*)body+2, len,
-                        &id->identifier.byteString.length);
-        if(!id->identifier.byteString.data && len > 0)
-            return UA_STATUSCODE_BADDECODINGERROR;
+        if(buf) {
+            /* Reserve the maximum decoded length, return the remainder */
+            UA_Byte *data;
+            size_t max = (len / 4) * 3 + 2;
+            res = take_buf(buf, max, &data);
+            if(res != UA_STATUSCODE_GOOD)
+                break;
+            size_t outLen = (len > 2) ?
+                UA_unbase64_buf((const unsigned char*)body+2, len, data) : 0;
+            buf->data -= max - outLen;
+            buf->length += max - outLen;
+            id->identifier.byteString.data =
+                (outLen > 0) ? data : (UA_Byte*)UA_EMPTY_ARRAY_SENTINEL;
+            id->identifier.byteString.length = outLen;
+        } else {
+            id->identifier.byteString.data =
+                UA_unbase64((const unsigned char*)body+2, len,
+                            &id->identifier.byteString.length);
+            if(!id->identifier.byteString.data && len > 0)
+                return UA_STATUSCODE_BADDECODINGERROR;
+        }
         id->identifierType = UA_NODEIDTYPE_BYTESTRING;
         break;
     default:
@@ -128,9 +170,37 @@ parse_nodeid_body(UA_NodeId *id, const char *body, const char *end) {
     return res;
 }
 
+/* Fast path for the common numeric NodeIds "i=123" and "ns=1;i=123" that
+ * does not run the lexer. Returns false if the string has a different form. */
+static UA_Boolean
+parse_nodeid_numeric(UA_NodeId *id, const char *pos, const char *end,
+                     UA_StatusCode *res) {
+    if(end - pos > 3 && pos[0] == 'n' && pos[1] == 's' && pos[2] == '=') {
+        const char *ns = pos + 3;
+        for(pos = ns; pos < end && *pos >= '0' && *pos <= '9'; pos++) {}
+        if(pos == ns || end - pos < 3 || *pos != ';')
+            return false;
+        UA_UInt32 tmp;
+        UA_readNumber((const UA_Byte*)ns, (size_t)(pos - ns), &tmp);
+        id->namespaceIndex = (UA_UInt16)tmp;
+        pos++;
+    }
+    if(end - pos < 2 || pos[0] != 'i' || pos[1] != '=') {
+        id->namespaceIndex = 0;
+        return false;
+    }
+    size_t len = (size_t)(end - (pos+2));
+    *res = (UA_readNumber((const UA_Byte*)pos+2, len, &id->identifier.numeric) == len) ?
+        UA_STATUSCODE_GOOD : UA_STATUSCODE_BADDECODINGERROR;
+    return true;
+}
+
 static UA_StatusCode
-parse_nodeid(UA_NodeId *id, const char *pos, const char *end) {
+parse_nodeid(UA_NodeId *id, const char *pos, const char *end, UA_ByteString *buf) {
     *id = UA_NODEID_NULL; /* Reset the NodeId */
+    UA_StatusCode res;
+    if(parse_nodeid_numeric(id, pos, end, &res))
+        return res;
     LexContext context;
     memset(&context, 0, sizeof(LexContext));
     const char *ns = NULL, *nse= NULL;
@@ -184,7 +254,7 @@ yy5:
         }
 
         // From the current position until the end
-        return parse_nodeid_body(id, &pos[-2], end);
+        return parse_nodeid_body(id, &pos[-2], end, buf);
     }
 yy6:
 	YYSKIP();
@@ -257,15 +327,31 @@ yy11:
 UA_StatusCode
 UA_NodeId_parse(UA_NodeId *id, const UA_String str) {
     UA_StatusCode res =
-        parse_nodeid(id, (const char*)str.data, (const char*)str.data+str.length);
+        parse_nodeid(id, (const char*)str.data, (const char*)str.data+str.length, NULL);
     if(res != UA_STATUSCODE_GOOD)
         UA_NodeId_clear(id);
     return res;
 }
 
+UA_StatusCode
+UA_NodeId_parseBuf(UA_NodeId *id, const UA_String str, UA_ByteString *buf) {
+    UA_ByteString origBuf = *buf;
+    UA_StatusCode res =
+        parse_nodeid(id, (const char*)str.data, (const char*)str.data+str.length, buf);
+    if(res != UA_STATUSCODE_GOOD) {
+        *id = UA_NODEID_NULL;
+        *buf = origBuf;
+    }
+    return res;
+}
+
 static UA_StatusCode
-parse_expandednodeid(UA_ExpandedNodeId *id, const char *pos, const char *end) {
+parse_expandednodeid(UA_ExpandedNodeId *id, const char *pos, const char *end,
+                     UA_ByteString *buf) {
     *id = UA_EXPANDEDNODEID_NULL; /* Reset the NodeId */
+    UA_StatusCode res;
+    if(parse_nodeid_numeric(&id->nodeId, pos, end, &res))
+        return res;
     LexContext context;
     memset(&context, 0, sizeof(LexContext));
     const char *svr = NULL, *svre = NULL, *nsu = NULL, *ns = NULL, *body = NULL;
@@ -341,10 +427,7 @@ yy18:
 
         if(nsu) {
             size_t len = (size_t)((body-1) - nsu);
-            UA_String nsuri;
-            nsuri.data = (UA_Byte*)(uintptr_t)nsu;
-            nsuri.length = len;
-            UA_StatusCode res = UA_String_copy(&nsuri, &id->namespaceUri);
+            res = parse_string(&id->namespaceUri, nsu, len, buf);
             if(res != UA_STATUSCODE_GOOD)
                 return res;
         } else if(ns) {
@@ -356,7 +439,7 @@ yy18:
         }
 
         // From the current position until the end
-        return parse_nodeid_body(&id->nodeId, &pos[-2], end);
+        return parse_nodeid_body(&id->nodeId, &pos[-2], end, buf);
     }
 yy19:
 	YYSKIP();
@@ -543,12 +626,27 @@ yy34:
 UA_StatusCode
 UA_ExpandedNodeId_parse(UA_ExpandedNodeId *id, const UA_String str) {
     UA_StatusCode res =
-        parse_expandednodeid(id, (const char*)str.data, (const char*)str.data+str.length);
+        parse_expandednodeid(id, (const char*)str.data,
+                             (const char*)str.data+str.length, NULL);
     if(res != UA_STATUSCODE_GOOD)
         UA_ExpandedNodeId_clear(id);
     return res;
 }
 
+UA_StatusCode
+UA_ExpandedNodeId_parseBuf(UA_ExpandedNodeId *id, const UA_String str,
+                           UA_ByteString *buf) {
+    UA_ByteString origBuf = *buf;
+    UA_StatusCode res =
+        parse_expandednodeid(id, (const char*)str.data,
+                             (const char*)str.data+str.length, buf);
+    if(res != UA_STATUSCODE_GOOD) {
+        *id = UA_EXPANDEDNODEID_NULL;
+        *buf = origBuf;
+    }
+    return res;
+}
+
 static UA_StatusCode
 relativepath_addelem(UA_RelativePath *rp, UA_RelativePathElement *el) {
     /* Allocate memory */
@@ -809,7 +907,7 @@ yy54:
         }
 
         // Try to parse a NodeId for the ReferenceType (non-standard!)
-        res = parse_nodeid(&current.referenceTypeId, begin, finish);
+        res = parse_nodeid(&current.referenceTypeId, begin, finish, NULL);
         if(res == UA_STATUSCODE_GOOD)
             goto reftype_target;
 
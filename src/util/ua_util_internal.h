@@ -81,6 +81,17 @@ UA_String_escapeAppend(UA_String *s, const UA_String s2, UA_Boolean extended);
 UA_StatusCode
 UA_String_append(UA_String *s, const UA_String s2);
 
+/* Zeroed memory from the arena. The memory is aligned for all builtin types.
+ * Returns NULL if the allocation of a new block failed. */
+void *
+UA_Arena_calloc(UA_Arena *arena, size_t nelem, size_t elsize);
+
+/* Release all allocations but keep the memory. If several blocks were used,
+ * they are replaced by a single block of their total size with the next
+ * allocation. */
+void
+UA_Arena_reset(UA_Arena *arena);
+
 /* Case insensitive lookup. Returns UA_ATTRIBUTEID_INVALID if not found. */
 UA_AttributeId
 UA_AttributeId_fromName(const UA_String name);
@@ -211,9 +222,6 @@ isTrue(uint8_t expr) {
 # endif
 #endif
 
-void
-UA_cleanupDataTypeWithCustom(const UA_DataTypeArray *customTypes);
-
 /* Get the number of optional fields contained in an structure type */
 size_t UA_EXPORT
 getCountOfOptionalFields(const UA_DataType *type);
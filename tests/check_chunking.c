@@ -151,12 +151,188 @@ START_TEST(encodeTwoStringsIntoTenChunksShallWork) {
     UA_String_clear(&string);
 } END_TEST
 
+static UA_StatusCode
+collectChunkMockUp(void *_, UA_Byte **bufPos, const UA_Byte **bufEnd) {
+    size_t offset = (uintptr_t)(*bufPos - buffers[bufIndex].data);
+    buffers[bufIndex].length = offset;
+    bufIndex++;
+    *bufPos = buffers[bufIndex].data;
+    *bufEnd = &(*bufPos)[buffers[bufIndex].length];
+    counter++;
+    return UA_STATUSCODE_GOOD;
+}
+
+START_TEST(encodeStructureIntoSmallChunksShallWork) {
+    /* The ResponseHeader starts with overlayable members that are split over
+     * the chunk boundaries */
+    UA_Double values[4] = {1.0, 2.0, 3.0, 4.0};
+    UA_DataValue results[4];
+    for(size_t i = 0; i < 4; i++) {
+        UA_DataValue_init(&results[i]);
+        UA_Variant_setScalar(&results[i].value, &values[i], &UA_TYPES[UA_TYPES_DOUBLE]);
+        results[i].hasValue = true;
+        results[i].sourceTimestamp = (UA_DateTime)(i + 1) * UA_DATETIME_SEC;
+        results[i].hasSourceTimestamp = true;
+    }
+    UA_ReadResponse resp;
+    UA_ReadResponse_init(&resp);
+    resp.responseHeader.timestamp = 0x0102030405060708;
+    resp.responseHeader.requestHandle = 42;
+    resp.responseHeader.serviceResult = UA_STATUSCODE_BADINTERNALERROR;
+    resp.results = results;
+    resp.resultsSize = 4;
+
+    UA_ByteString expected = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&resp, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                           &expected);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    size_t chunkCount = 64;
+    for(size_t chunkSize = 16; chunkSize < 40; chunkSize++) {
+        bufIndex = 0;
+        counter = 0;
+        buffers = (UA_ByteString*)UA_Array_new(chunkCount, &UA_TYPES[UA_TYPES_BYTESTRING]);
+        for(size_t i = 0; i < chunkCount; i++)
+            UA_ByteString_allocBuffer(&buffers[i], chunkSize);
+
+        UA_Byte *pos = buffers[0].data;
+        const UA_Byte *end = &buffers[0].data[buffers[0].length];
+        retval = UA_encodeBinaryInternal(&resp, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                         &pos, &end, collectChunkMockUp, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_gt(counter, 0);
+        buffers[bufIndex].length = (uintptr_t)(pos - buffers[bufIndex].data);
+
+        /* The concatenated chunks are identical to the unchunked encoding */
+        size_t offset = 0;
+        for(size_t i = 0; i <= bufIndex; i++) {
+            ck_assert(offset + buffers[i].length <= expected.length);
+            ck_assert(memcmp(&expected.data[offset], buffers[i].data,
+                             buffers[i].length) == 0);
+            offset += buffers[i].length;
+        }
+        ck_assert_uint_eq(offset, expected.length);
+        UA_Array_delete(buffers, chunkCount, &UA_TYPES[UA_TYPES_BYTESTRING]);
+    }
+
+    /* Decode again */
+    UA_ReadResponse decoded;
+    retval = UA_decodeBinary(&expected, &decoded, &UA_TYPES[UA_TYPES_READRESPONSE], NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_equal(&resp, &decoded, &UA_TYPES[UA_TYPES_READRESPONSE]));
+    UA_ReadResponse_clear(&decoded);
+    UA_ByteString_clear(&expected);
+} END_TEST
+
+static void
+checkSegmentedDecode(const UA_ByteString *segments, size_t segmentsSize,
+                     const void *expected, size_t expectedLength,
+                     const UA_DataType *type) {
+    void *decoded = UA_new(type);
+    size_t offset = 0;
+    UA_StatusCode retval =
+        UA_decodeBinaryInternalSegments(segments, segmentsSize, &offset,
+                                        decoded, type, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(offset, expectedLength);
+    ck_assert(UA_equal(expected, decoded, type));
+    UA_delete(decoded, type);
+}
+
+START_TEST(decodeFromSegmentsShallWork) {
+    /* The ReadValueId array is encoded as an ExtensionObject array inside the
+     * Variant and unwrapped during decoding */
+    UA_ReadValueId rvi[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].nodeId = UA_NODEID_NUMERIC(1, (UA_UInt32)(1000 + i));
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    rvi[1].nodeId = UA_NODEID_STRING(2, "segmented");
+    UA_Int32 ints[5] = {1, -2, 3, -4, 5};
+    UA_Guid guid = {0x01020304, 0x0506, 0x0708,
+                    {0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10}};
+
+    UA_WriteValue wv[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_WriteValue_init(&wv[i]);
+        wv[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        wv[i].value.hasValue = true;
+    }
+    wv[0].nodeId = UA_NODEID_STRING(1, "int32array");
+    UA_Variant_setArray(&wv[0].value.value, ints, 5, &UA_TYPES[UA_TYPES_INT32]);
+    wv[1].nodeId = UA_NODEID_GUID(1, guid);
+    UA_Variant_setArray(&wv[1].value.value, rvi, 3, &UA_TYPES[UA_TYPES_READVALUEID]);
+    wv[2].nodeId = UA_NODEID_NUMERIC(0, 85);
+    UA_Variant_setScalar(&wv[2].value.value, &guid, &UA_TYPES[UA_TYPES_GUID]);
+
+    UA_WriteRequest req;
+    UA_WriteRequest_init(&req);
+    req.requestHeader.requestHandle = 17;
+    req.requestHeader.timeoutHint = 5000;
+    req.nodesToWrite = wv;
+    req.nodesToWriteSize = 3;
+
+    const UA_DataType *type = &UA_TYPES[UA_TYPES_WRITEREQUEST];
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&req, type, &encoded);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The reference is the decoding from the contiguous buffer */
+    UA_WriteRequest expected;
+    retval = UA_decodeBinary(&encoded, &expected, type, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Split into two segments at every position. Also with an empty segment
+     * at the split. */
+    UA_ByteString segments[64];
+    for(size_t split = 0; split <= encoded.length; split++) {
+        segments[0].data = encoded.data;
+        segments[0].length = split;
+        segments[1].data = &encoded.data[split];
+        segments[1].length = encoded.length - split;
+        checkSegmentedDecode(segments, 2, &expected, encoded.length, type);
+
+        segments[2] = segments[1];
+        segments[1].length = 0;
+        checkSegmentedDecode(segments, 3, &expected, encoded.length, type);
+    }
+
+    /* Split into many small segments */
+    for(size_t segSize = encoded.length / 63 + 1; segSize < 40; segSize++) {
+        size_t count = 0;
+        for(size_t pos = 0; pos < encoded.length; pos += segSize) {
+            segments[count].data = &encoded.data[pos];
+            segments[count].length = (encoded.length - pos < segSize) ?
+                encoded.length - pos : segSize;
+            count++;
+        }
+        checkSegmentedDecode(segments, count, &expected, encoded.length, type);
+    }
+
+    /* Truncated input fails cleanly */
+    segments[0].data = encoded.data;
+    segments[0].length = encoded.length / 2;
+    segments[1].data = &encoded.data[encoded.length / 2];
+    segments[1].length = encoded.length / 4;
+    UA_WriteRequest decoded;
+    size_t offset = 0;
+    retval = UA_decodeBinaryInternalSegments(segments, 2, &offset,
+                                             &decoded, type, NULL);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+
+    UA_WriteRequest_clear(&expected);
+    UA_ByteString_clear(&encoded);
+} END_TEST
+
 int main(void) {
     Suite *s = suite_create("Chunked encoding");
     TCase *tc_message = tcase_create("encode chunking");
     tcase_add_test(tc_message,encodeArrayIntoFiveChunksShallWork);
     tcase_add_test(tc_message,encodeStringIntoFiveChunksShallWork);
     tcase_add_test(tc_message,encodeTwoStringsIntoTenChunksShallWork);
+    tcase_add_test(tc_message,encodeStructureIntoSmallChunksShallWork);
+    tcase_add_test(tc_message,decodeFromSegmentsShallWork);
     suite_add_tcase(s, tc_message);
 
     SRunner *sr = srunner_create(s);
@@ -3,9 +3,12 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include <open62541/plugin/eventloop.h>
+#include <open62541/plugin/log_stdout.h>
 #include "testing_clock.h"
+#include "thread_wrapper.h"
 #include <time.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <stdlib.h>
 #include <check.h>
@@ -52,10 +55,224 @@ START_TEST(benchmarkTimer) {
     el = NULL;
 } END_TEST
 
+#if UA_MULTITHREADING >= 100 && !defined(_WIN32)
+static UA_Boolean delayedCalled;
+static UA_DelayedCallback dc;
+
+static void
+delayedCallback(void *application, void *data) {
+    delayedCalled = true;
+}
+
+THREAD_CALLBACK(addDelayed) {
+    struct timespec ts = {0, 100 * 1000 * 1000}; /* Wait until the poll */
+    nanosleep(&ts, NULL);
+    dc.callback = delayedCallback;
+    el->addDelayedCallback(el, &dc);
+    return 0;
+}
+
+/* A delayed callback from another thread interrupts the poll */
+START_TEST(wakeupFromThread) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_StatusCode res = el->start(el);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    delayedCalled = false;
+    THREAD_HANDLE thread;
+    THREAD_CREATE(thread, addDelayed);
+    UA_DateTime before = el->dateTime_nowMonotonic(el);
+    el->run(el, 10000);
+    UA_DateTime after = el->dateTime_nowMonotonic(el);
+    THREAD_JOIN(thread);
+    ck_assert(after - before < 5 * UA_DATETIME_SEC);
+
+    /* Processed in the next iteration */
+    el->run(el, 0);
+    ck_assert(delayedCalled);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 100);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+#define N_PRODUCERS 4
+#define N_DELAYED 1000
+static UA_DelayedCallback producerDCs[N_PRODUCERS][N_DELAYED];
+static size_t delayedCount;
+
+static void
+countDelayed(void *application, void *data) {
+    delayedCount++;
+}
+
+THREAD_CALLBACK_PARAM(produceDelayed, param) {
+    UA_DelayedCallback *dcs = (UA_DelayedCallback*)param;
+    for(size_t i = 0; i < N_DELAYED; i++) {
+        dcs[i].callback = countDelayed;
+        el->addDelayedCallback(el, &dcs[i]);
+    }
+    return 0;
+}
+
+/* Delayed callbacks submitted concurrently from many threads are all
+ * processed exactly once */
+START_TEST(delayedFromManyThreads) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_StatusCode res = el->start(el);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    delayedCount = 0;
+    memset(producerDCs, 0, sizeof(producerDCs));
+    THREAD_HANDLE threads[N_PRODUCERS];
+    for(size_t i = 0; i < N_PRODUCERS; i++) {
+        THREAD_CREATE_PARAM(threads[i], produceDelayed, producerDCs[i][0]);
+    }
+
+    UA_DateTime start = el->dateTime_nowMonotonic(el);
+    while(delayedCount < N_PRODUCERS * N_DELAYED &&
+          el->dateTime_nowMonotonic(el) - start < 10 * UA_DATETIME_SEC)
+        el->run(el, 100);
+    for(size_t i = 0; i < N_PRODUCERS; i++)
+        THREAD_JOIN(threads[i]);
+    el->run(el, 0);
+    ck_assert_uint_eq(delayedCount, N_PRODUCERS * N_DELAYED);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 100);
+    el->free(el);
+    el = NULL;
+} END_TEST
+#endif
+
+static size_t slowReported;
+static size_t iterationsTraced;
+static UA_DateTime tracedBusyTime;
+
+static void
+slowCallback(void *application, void *data) {
+    UA_realSleep(5);
+}
+
+static void
+traceSlowCallback(UA_EventLoop *tel, void *traceContext,
+                  UA_EventLoopCallbackType type, UA_Callback callback,
+                  void *application, UA_DateTime runtime, UA_DateTime lag) {
+    ck_assert_ptr_eq(traceContext, &slowReported);
+    ck_assert(callback == slowCallback);
+    ck_assert_int_ge(runtime, 2 * UA_DATETIME_MSEC);
+    if(type == UA_EVENTLOOPCALLBACK_DELAYED)
+        ck_assert_int_eq(lag, 0);
+    slowReported++;
+}
+
+static void
+traceIteration(UA_EventLoop *tel, void *traceContext,
+               const UA_EventLoopIterationTrace *trace) {
+    ck_assert_int_ge(trace->timerTime, 0);
+    ck_assert_int_ge(trace->delayedTime, 0);
+    ck_assert_int_ge(trace->eventTime, 0);
+    ck_assert_int_ge(trace->waitTime, 0);
+    tracedBusyTime += trace->timerTime + trace->delayedTime + trace->eventTime;
+    iterationsTraced++;
+}
+
+START_TEST(tracingHooks) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->traceContext = &slowReported;
+    el->traceIteration = traceIteration;
+    el->traceSlowCallback = traceSlowCallback;
+    el->slowCallbackThreshold = 2 * UA_DATETIME_MSEC;
+    UA_StatusCode res = el->start(el);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    slowReported = 0;
+    iterationsTraced = 0;
+    tracedBusyTime = 0;
+    res = el->addCyclicCallback(el, slowCallback, NULL, NULL, 1.0, NULL,
+                                UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = el->addCyclicCallback(el, timerCallback, NULL, NULL, 1.0, NULL,
+                                UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_DelayedCallback sdc = {NULL, slowCallback, NULL, NULL};
+    el->addDelayedCallback(el, &sdc);
+
+    for(size_t i = 0; i < 10; i++)
+        el->run(el, 2);
+
+    UA_EventLoopStatistics stats;
+    el->getStatistics(el, &stats);
+    ck_assert_uint_eq(stats.iterationCount, iterationsTraced);
+    ck_assert_uint_eq(stats.busyTime, (UA_UInt64)tracedBusyTime);
+    ck_assert_uint_eq(stats.busyTime,
+                      stats.timerTime + stats.delayedTime + stats.eventTime);
+    ck_assert_uint_ge(slowReported, 2); /* At least one of each type */
+    ck_assert_uint_eq(stats.slowCallbackCount, slowReported);
+
+    /* Every executed timer callback is in the lag distribution */
+    UA_UInt64 lagCount = 0;
+    for(size_t i = 0; i < UA_EVENTLOOP_LAGBUCKETS; i++)
+        lagCount += stats.timerLagBuckets[i];
+    ck_assert_uint_eq(lagCount, stats.timerCallbackCount);
+    ck_assert_uint_ge(stats.timerCallbackCount, slowReported);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 100);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+static UA_DateTime cachedFirst;
+static UA_DateTime cachedSecond;
+
+static void
+cachedTimeCallback(void *application, void *data) {
+    cachedFirst = el->dateTime_nowCached(el);
+    /* Spin until the clock has moved */
+    UA_DateTime start = el->dateTime_now(el);
+    while(el->dateTime_now(el) - start < UA_DATETIME_MSEC) {}
+    cachedSecond = el->dateTime_nowCached(el);
+}
+
+START_TEST(cachedTime) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_StatusCode res = el->start(el);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Outside of an iteration the current time is returned */
+    UA_DateTime before = el->dateTime_now(el);
+    ck_assert_int_ge(el->dateTime_nowCached(el), before);
+
+    /* Within an iteration the time does not advance */
+    UA_DelayedCallback dc = {NULL, cachedTimeCallback, NULL, NULL};
+    el->addDelayedCallback(el, &dc);
+    el->run(el, 1);
+    ck_assert_int_ge(cachedFirst, before);
+    ck_assert_int_eq(cachedFirst, cachedSecond);
+    ck_assert_int_gt(el->dateTime_nowCached(el), cachedSecond);
+
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        el->run(el, 100);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, tracingHooks);
+    tcase_add_test(tc, cachedTime);
+#if UA_MULTITHREADING >= 100 && !defined(_WIN32)
+    tcase_add_test(tc, wakeupFromThread);
+    tcase_add_test(tc, delayedFromManyThreads);
+#endif
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
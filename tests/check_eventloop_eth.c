@@ -16,6 +16,7 @@ static UA_EventLoop *el;
 static char *testMsg = "open62541";
 static uintptr_t clientId;
 static UA_Boolean received;
+static size_t receivedCount;
 
 #define ETHERNET_INTERFACE "lo" /* use the loopback interface for testing */
 #define MULTICAST_MAC_ADDRESS "00-00-00-00-00-00"
@@ -63,6 +64,7 @@ connectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         UA_ByteString rcv = UA_BYTESTRING(testMsg);
         ck_assert(UA_String_equal(&msg, &rcv));
         received = true;
+        receivedCount++;
     }
 }
 
@@ -197,11 +199,108 @@ START_TEST(connectETH) {
     el = NULL;
 } END_TEST
 
+static void
+sendTestMessage(UA_ConnectionManager *cm, UA_ByteString *snd) {
+    memcpy(snd->data, testMsg, strlen(testMsg));
+    UA_StatusCode retval = cm->sendWithConnection(cm, clientId, NULL, snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static void
+runUntilReceived(size_t count) {
+    for(size_t i = 0; i < 100 && receivedCount < count; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(receivedCount, count);
+}
+
+START_TEST(connectETHPacketRing) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_Ethernet(UA_STRING("ethCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_String interface = UA_STRING(ETHERNET_INTERFACE);
+    UA_String address = UA_STRING(MULTICAST_MAC_ADDRESS);
+    UA_Boolean listen = true;
+    UA_UInt16 etherType = 0xb62c; /* OPC UA PubSub EtherType */
+    UA_UInt32 ringFrames = 16;
+
+    UA_KeyValuePair params[5];
+    params[0].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[0].value, &address, &UA_TYPES[UA_TYPES_STRING]);
+    params[1].key = UA_QUALIFIEDNAME(0, "interface");
+    UA_Variant_setScalar(&params[1].value, &interface, &UA_TYPES[UA_TYPES_STRING]);
+    params[2].key = UA_QUALIFIEDNAME(0, "ethertype");
+    UA_Variant_setScalar(&params[2].value, &etherType, &UA_TYPES[UA_TYPES_UINT16]);
+    params[3].key = UA_QUALIFIEDNAME(0, "packet-ring");
+    UA_Variant_setScalar(&params[3].value, &ringFrames, &UA_TYPES[UA_TYPES_UINT32]);
+    params[4].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[4].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    TestContext testContext;
+    testContext.connCount = 0;
+
+    /* Listen connection with an rx ring */
+    UA_KeyValueMap kvm = {4, &params[1]};
+    UA_StatusCode retval =
+        cm->openConnection(cm, &kvm, NULL, &testContext, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Send connection with a tx ring */
+    kvm.map = params;
+    clientId = 0;
+    retval = cm->openConnection(cm, &kvm, NULL, &testContext, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(clientId != 0);
+
+    /* The second buffer is not taken from the ring. It is copied into the ring
+     * after the first buffer and sent together with it. */
+    receivedCount = 0;
+    UA_ByteString snd1, snd2;
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd1, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd2, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sendTestMessage(cm, &snd2);
+    sendTestMessage(cm, &snd1);
+    runUntilReceived(2);
+
+    /* A released frame is skipped */
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd1, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    cm->freeNetworkBuffer(cm, clientId, &snd1);
+    retval = cm->allocNetworkBuffer(cm, clientId, &snd1, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    sendTestMessage(cm, &snd1);
+    runUntilReceived(3);
+
+    /* Wrap around the rings */
+    for(size_t i = 0; i < 2 * ringFrames; i++) {
+        retval = cm->allocNetworkBuffer(cm, clientId, &snd1, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        sendTestMessage(cm, &snd1);
+        runUntilReceived(4 + i);
+    }
+
+    /* Stop the EventLoop */
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    el->free(el);
+    el = NULL;
+    ck_assert_uint_eq(testContext.connCount, 0);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test ETH EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, listenETH);
     tcase_add_test(tc, connectETH);
+    tcase_add_test(tc, connectETHPacketRing);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -11,6 +11,7 @@
 
 #include "testing_clock.h"
 #include <time.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <check.h>
 
@@ -107,10 +108,98 @@ START_TEST(connectSubscribePublish) {
     el = NULL;
 } END_TEST
 
+#define BENCHMARK_MESSAGES 20000
+
+/* Messages per second with QoS 1. The messages are pipelined within the
+ * in-flight window and flushed together in every EventLoop iteration. */
+START_TEST(benchmarkPublishQoS1) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_ConnectionManager *mcm = UA_ConnectionManager_new_MQTT(UA_STRING("mqttCM"));
+    UA_EventLoop *el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->registerEventSource(el, &mcm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 1883;
+    UA_String hostname = UA_STRING("localhost");
+    UA_String topic = UA_STRING("benchmarktopic");
+    UA_Boolean subscribe = false;
+    UA_Byte qos = 1;
+    UA_UInt16 maxInflight = 512;
+
+    UA_KeyValuePair params[6];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[1].value, &hostname, &UA_TYPES[UA_TYPES_STRING]);
+    params[2].key = UA_QUALIFIEDNAME(0, "topic");
+    UA_Variant_setScalar(&params[2].value, &topic, &UA_TYPES[UA_TYPES_STRING]);
+    params[3].key = UA_QUALIFIEDNAME(0, "subscribe");
+    UA_Variant_setScalar(&params[3].value, &subscribe, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[4].key = UA_QUALIFIEDNAME(0, "qos");
+    UA_Variant_setScalar(&params[4].value, &qos, &UA_TYPES[UA_TYPES_BYTE]);
+    params[5].key = UA_QUALIFIEDNAME(0, "max-inflight");
+    UA_Variant_setScalar(&params[5].value, &maxInflight, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_KeyValueMap kvm = {6, params};
+
+    uintptr_t publishConnectionId = 0;
+    UA_StatusCode res = mcm->openConnection(mcm, &kvm, NULL,
+                                            &publishConnectionId, connectionCallback);
+    ck_assert(res == UA_STATUSCODE_GOOD);
+
+    /* Iterate to open the connection */
+    el->run(el, 100);
+
+    /* Publish as fast as the in-flight window allows */
+    UA_MQTTConnectionStatistics stats;
+    size_t sent = 0;
+    clock_t begin = clock();
+    while(sent < BENCHMARK_MESSAGES) {
+        UA_ByteString msg = UA_BYTESTRING_ALLOC("open62541-benchmark-message");
+        res = mcm->sendWithConnection(mcm, publishConnectionId,
+                                      &UA_KEYVALUEMAP_NULL, &msg);
+        if(res == UA_STATUSCODE_GOOD) {
+            sent++;
+            continue;
+        }
+        ck_assert_uint_eq(res, UA_STATUSCODE_BADRESOURCEUNAVAILABLE);
+        el->run(el, 1);
+    }
+
+    /* Wait for all PUBACKs */
+    do {
+        el->run(el, 1);
+        res = UA_ConnectionManager_MQTT_getStatistics(mcm, publishConnectionId, &stats);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    } while(stats.inflight + stats.queued > 0);
+    clock_t finish = clock();
+
+    double time_spent = (double)(finish - begin) / CLOCKS_PER_SEC;
+    printf("%u messages in %f s (%.0f messages/s, %lu flushes)\n",
+           (unsigned)sent, time_spent, (double)sent / time_spent,
+           (unsigned long)stats.flushes);
+    ck_assert_uint_eq(stats.publishedMessages, BENCHMARK_MESSAGES);
+    ck_assert(stats.flushes < BENCHMARK_MESSAGES);
+
+    /* Stop the EventLoop */
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED && iteration < max_stop_iteration_count) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test MQTT TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, connectSubscribePublish);
+    tcase_add_test(tc, benchmarkPublishQoS1);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
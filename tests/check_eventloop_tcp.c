@@ -8,6 +8,7 @@
 #include "open62541/types_generated.h"
 
 #include "testing_clock.h"
+#include "../arch/eventloop_posix/eventloop_posix.h"
 #include <time.h>
 #include <stdlib.h>
 #include <check.h>
@@ -180,11 +181,604 @@ START_TEST(connectTCP) {
     el = NULL;
 } END_TEST
 
+static size_t receivedBytes;
+
+static void
+bulkCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+             void *application, void **connectionContext,
+             UA_ConnectionState status,
+             const UA_KeyValueMap *params,
+             UA_ByteString msg) {
+    if(*connectionContext != NULL)
+        clientId = connectionId;
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED)
+        connCount++;
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+    receivedBytes += msg.length;
+}
+
+/* Open a listen socket and a client connection with the bulkCallback */
+static void
+openBulkConnection(UA_ConnectionManager *cm) {
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    receivedBytes = 0;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, bulkCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    clientId = 0;
+    listen = false;
+    retval = cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, bulkCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(clientId != 0);
+}
+
+static void
+stopEventLoop(void) {
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
+          iteration < max_stop_iteration_count) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+}
+
+#define BULKSIZE (16 * 1024 * 1024)
+
+/* The receiver runs in the same EventLoop and does not read while we send.
+ * The send cannot complete and the remainder is queued. */
+static unsigned failOpening, failEstablished, failClosing;
+
+static void
+connectFailCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+                    void *application, void **connectionContext,
+                    UA_ConnectionState status,
+                    const UA_KeyValueMap *params,
+                    UA_ByteString msg) {
+    if(status == UA_CONNECTIONSTATE_OPENING)
+        failOpening++;
+    else if(status == UA_CONNECTIONSTATE_ESTABLISHED)
+        failEstablished++;
+    else if(status == UA_CONNECTIONSTATE_CLOSING)
+        failClosing++;
+}
+
+/* The connection to a port without a listening socket fails. The select
+ * backend reports the failed connect as writable (POSIX) or only in the
+ * exception set (Windows), poll and epoll as an error. In every case, the
+ * connection closes without being established. */
+START_TEST(connectFailTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4843; /* Nobody listens */
+    UA_String host = UA_STRING("127.0.0.1");
+
+    UA_KeyValuePair params[2];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[1].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 2;
+
+    failOpening = 0;
+    failEstablished = 0;
+    failClosing = 0;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, connectFailCallback);
+
+    /* The connect can also fail right away */
+    if(retval == UA_STATUSCODE_GOOD) {
+        ck_assert_uint_eq(failOpening, 1);
+        for(size_t i = 0; i < 100 && failClosing == 0; i++) {
+            UA_DateTime next = el->run(el, 10);
+            UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        }
+    }
+    ck_assert_uint_eq(failEstablished, 0);
+    ck_assert_uint_eq(failClosing, failOpening);
+
+    /* Stop the EventLoop */
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
+          iteration < max_stop_iteration_count) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+} END_TEST
+
+START_TEST(sendQueueTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+    ck_assert(cm->getSendQueueSize != NULL);
+    openBulkConnection(cm);
+
+    UA_ByteString snd;
+    UA_StatusCode retval = cm->allocNetworkBuffer(cm, clientId, &snd, BULKSIZE);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memset(snd.data, 'a', snd.length);
+    retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t queued = cm->getSendQueueSize(cm, clientId);
+    ck_assert_uint_gt(queued, 0);
+    ck_assert_uint_le(queued, BULKSIZE);
+
+    /* The queue drains as the receiver reads */
+    for(size_t i = 0; i < 10000 && receivedBytes < BULKSIZE; i++)
+        el->run(el, 10);
+    ck_assert_uint_eq(receivedBytes, BULKSIZE);
+    ck_assert_uint_eq(cm->getSendQueueSize(cm, clientId), 0);
+
+    retval = cm->closeConnection(cm, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    stopEventLoop();
+} END_TEST
+
+/* Exceeding the send-queue-limit closes the connection */
+START_TEST(sendQueueLimitTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    UA_UInt32 limit = 1024 * 1024;
+    UA_KeyValueMap_setScalar(&cm->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "send-queue-limit"),
+                             &limit, &UA_TYPES[UA_TYPES_UINT32]);
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+    openBulkConnection(cm);
+    size_t openConnections = connCount;
+
+    UA_ByteString snd;
+    UA_StatusCode retval = cm->allocNetworkBuffer(cm, clientId, &snd, BULKSIZE);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memset(snd.data, 'a', snd.length);
+    retval = cm->sendWithConnection(cm, clientId, NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADCONNECTIONCLOSED);
+
+    /* The client side of the connection is closed. The server side follows
+     * once it has received the end of the stream. */
+    for(size_t i = 0; i < 10; i++)
+        el->run(el, 1);
+    ck_assert_uint_lt(connCount, openConnections);
+    stopEventLoop();
+} END_TEST
+
+#define MANY_CONNECTIONS 200
+
+static size_t receivedMsgs;
+static uintptr_t clientIds[MANY_CONNECTIONS];
+static size_t clientIdsSize;
+
+static void
+manyCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+             void *application, void **connectionContext,
+             UA_ConnectionState status,
+             const UA_KeyValueMap *params,
+             UA_ByteString msg) {
+    if(msg.length == 0 && status == UA_CONNECTIONSTATE_ESTABLISHED) {
+        connCount++;
+        if(*connectionContext != NULL)
+            clientIds[clientIdsSize++] = connectionId;
+    }
+    if(status == UA_CONNECTIONSTATE_CLOSING)
+        connCount--;
+    if(msg.length > 0) {
+        UA_ByteString rcv = UA_BYTESTRING(testMsg);
+        ck_assert(UA_String_equal(&msg, &rcv));
+        receivedMsgs++;
+    }
+}
+
+/* Iterate until the number of connections and received messages is reached.
+ * The EventLoop uses the fake clock. So limit the wait by the real time. */
+static void
+runUntil(size_t conns, size_t msgs) {
+    time_t deadline = time(NULL) + 10;
+    while((connCount != conns || receivedMsgs < msgs) && time(NULL) < deadline)
+        el->run(el, 1);
+    ck_assert_uint_eq(connCount, conns);
+    ck_assert_uint_eq(receivedMsgs, msgs);
+}
+
+/* Connect in batches that fit into the listen backlog */
+static void
+openManyConnections(UA_ConnectionManager *cm, UA_KeyValueMap *paramsMap) {
+    clientIdsSize = 0;
+    size_t openConnections = connCount;
+    for(size_t i = 0; i < MANY_CONNECTIONS; i++) {
+        UA_StatusCode retval =
+            cm->openConnection(cm, paramsMap, NULL, (void*)0x01, manyCallback);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        if((i + 1) % 50 == 0)
+            runUntil(openConnections + 2 * (i + 1), receivedMsgs);
+    }
+    ck_assert_uint_eq(clientIdsSize, MANY_CONNECTIONS);
+}
+
+static void
+sendFromClient(UA_ConnectionManager *cm, uintptr_t id) {
+    UA_ByteString snd;
+    UA_StatusCode retval = cm->allocNetworkBuffer(cm, id, &snd, strlen(testMsg));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    memcpy(snd.data, testMsg, strlen(testMsg));
+    retval = cm->sendWithConnection(cm, id, NULL, &snd);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+/* Every connection gets served when many sockets are ready at once. Closed
+ * sockets are deregistered while events may still be pending for them. */
+START_TEST(manyConnectionsTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    /* The many closed connections linger in TIME_WAIT. Use a separate port
+     * and allow the reuse of the address. */
+    UA_UInt16 port = 4841;
+    UA_Boolean listen = true;
+    UA_Boolean reuse = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[4];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    params[3].key = UA_QUALIFIEDNAME(0, "reuse");
+    UA_Variant_setScalar(&params[3].value, &reuse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 4;
+
+    connCount = 0;
+    receivedMsgs = 0;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, manyCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t listenSockets = connCount;
+
+    /* Open the client connections. Each has a server-side counterpart. */
+    listen = false;
+    openManyConnections(cm, &paramsMap);
+    ck_assert_uint_eq(connCount, listenSockets + 2 * MANY_CONNECTIONS);
+
+    /* Send from all clients before the EventLoop runs */
+    for(size_t i = 0; i < MANY_CONNECTIONS; i++)
+        sendFromClient(cm, clientIds[i]);
+    runUntil(listenSockets + 2 * MANY_CONNECTIONS, MANY_CONNECTIONS);
+
+    /* Send again and close every second client right away. The server side
+     * receives the message before the connection closes. */
+    receivedMsgs = 0;
+    for(size_t i = 0; i < MANY_CONNECTIONS; i++) {
+        sendFromClient(cm, clientIds[i]);
+        if(i % 2 == 0) {
+            retval = cm->closeConnection(cm, clientIds[i]);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+    }
+    runUntil(listenSockets + MANY_CONNECTIONS, MANY_CONNECTIONS);
+
+    /* Close the remaining clients and reuse the freed sockets */
+    for(size_t i = 1; i < MANY_CONNECTIONS; i += 2) {
+        retval = cm->closeConnection(cm, clientIds[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    runUntil(listenSockets, MANY_CONNECTIONS);
+    openManyConnections(cm, &paramsMap);
+    ck_assert_uint_eq(connCount, listenSockets + 2 * MANY_CONNECTIONS);
+
+    stopEventLoop();
+    ck_assert_uint_eq(connCount, 0);
+} END_TEST
+
+/* Only a few of many sockets are ready in each iteration. The signaled
+ * sockets are found among the idle ones. */
+/* The select backend on Windows sorts the signaled sockets of the fd_set once
+ * and searches them for each registered socket */
+START_TEST(sortedFDsTCP) {
+    UA_FD fds[1000];
+    for(size_t i = 0; i < 1000; i++)
+        fds[i] = (UA_FD)(((i * 7919) % 1000) * 4 + 8);
+    UA_EventLoopPOSIX_sortFDs(fds, 1000);
+    for(size_t i = 1; i < 1000; i++)
+        ck_assert(fds[i-1] < fds[i]);
+    for(size_t i = 0; i < 1000; i++) {
+        ck_assert(UA_EventLoopPOSIX_containsFD(fds, 1000, (UA_FD)(i * 4 + 8)));
+        ck_assert(!UA_EventLoopPOSIX_containsFD(fds, 1000, (UA_FD)(i * 4 + 9)));
+    }
+    ck_assert(!UA_EventLoopPOSIX_containsFD(fds, 1000, (UA_FD)4));
+    ck_assert(!UA_EventLoopPOSIX_containsFD(fds, 0, fds[0]));
+    ck_assert(UA_EventLoopPOSIX_containsFD(fds, 1, fds[0]));
+} END_TEST
+
+#ifndef _WIN32
+static unsigned fdEvents[8];
+
+static void
+pipeCallback(UA_EventSource *es, UA_RegisteredFD *rfd, short event) {
+    fdEvents[event & 7]++;
+    if(event & UA_FDEVENT_IN) {
+        char buf[8];
+        ssize_t n = read(rfd->fd, buf, sizeof(buf));
+        ck_assert(n > 0);
+    }
+    /* Stop listening once writable, like the TCP ConnectionManager when the
+     * send queue is drained */
+    if(event & UA_FDEVENT_OUT) {
+        rfd->listenEvents = 0;
+        UA_EventLoopPOSIX_modifyFD((UA_EventLoopPOSIX*)el, rfd);
+    }
+}
+
+static void
+runPipeLoop(void) {
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+}
+
+/* Smoke test of the fd registration in whichever backend of the POSIX EventLoop
+ * is compiled in (epoll, io_uring, kqueue or poll) */
+START_TEST(registerFDPipe) {
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->start(el);
+    UA_EventLoopPOSIX *elp = (UA_EventLoopPOSIX*)el;
+
+    int fds[2];
+    ck_assert_int_eq(pipe(fds), 0);
+
+    UA_RegisteredFD rfdIn, rfdOut;
+    memset(&rfdIn, 0, sizeof(UA_RegisteredFD));
+    memset(&rfdOut, 0, sizeof(UA_RegisteredFD));
+    rfdIn.fd = fds[0];
+    rfdIn.listenEvents = UA_FDEVENT_IN;
+    rfdIn.eventSourceCB = pipeCallback;
+    rfdOut.fd = fds[1];
+    rfdOut.listenEvents = 0;
+    rfdOut.eventSourceCB = pipeCallback;
+
+    UA_LOCK(&elp->elMutex);
+    UA_StatusCode res = UA_EventLoopPOSIX_registerFD(elp, &rfdIn);
+    res |= UA_EventLoopPOSIX_registerFD(elp, &rfdOut);
+    UA_UNLOCK(&elp->elMutex);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Nothing to read and the write end is not listened to */
+    memset(fdEvents, 0, sizeof(fdEvents));
+    runPipeLoop();
+    ck_assert_uint_eq(fdEvents[UA_FDEVENT_IN], 0);
+    ck_assert_uint_eq(fdEvents[UA_FDEVENT_OUT], 0);
+
+    /* The written byte signals the read end */
+    ck_assert_int_eq(write(fds[1], "x", 1), 1);
+    runPipeLoop();
+    ck_assert_uint_ge(fdEvents[UA_FDEVENT_IN], 1);
+    ck_assert_uint_eq(fdEvents[UA_FDEVENT_OUT], 0);
+
+    /* Listen for the write end to become writable */
+    UA_LOCK(&elp->elMutex);
+    rfdOut.listenEvents = UA_FDEVENT_OUT;
+    res = UA_EventLoopPOSIX_modifyFD(elp, &rfdOut);
+    UA_UNLOCK(&elp->elMutex);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    runPipeLoop();
+    ck_assert_uint_ge(fdEvents[UA_FDEVENT_OUT], 1);
+
+    /* No events after the fds are deregistered */
+    UA_LOCK(&elp->elMutex);
+    UA_EventLoopPOSIX_deregisterFD(elp, &rfdIn);
+    UA_EventLoopPOSIX_deregisterFD(elp, &rfdOut);
+    UA_UNLOCK(&elp->elMutex);
+    ck_assert_int_eq(write(fds[1], "x", 1), 1);
+    memset(fdEvents, 0, sizeof(fdEvents));
+    runPipeLoop();
+    ck_assert_uint_eq(fdEvents[UA_FDEVENT_IN], 0);
+    ck_assert_uint_eq(fdEvents[UA_FDEVENT_OUT], 0);
+
+    close(fds[0]);
+    close(fds[1]);
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+        runPipeLoop();
+    el->free(el);
+    el = NULL;
+} END_TEST
+#endif
+
+START_TEST(sparseEventsTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+
+    UA_UInt16 port = 4841;
+    UA_Boolean listen = true;
+    UA_Boolean reuse = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[4];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    params[3].key = UA_QUALIFIEDNAME(0, "reuse");
+    UA_Variant_setScalar(&params[3].value, &reuse, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 4;
+
+    connCount = 0;
+    receivedMsgs = 0;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, manyCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    size_t listenSockets = connCount;
+
+    listen = false;
+    openManyConnections(cm, &paramsMap);
+
+    /* Every round, five different clients send */
+    size_t expected = 0;
+    for(size_t round = 0; round < 8; round++) {
+        for(size_t i = 0; i < MANY_CONNECTIONS; i++) {
+            if((i + round * 7) % 40 != 0)
+                continue;
+            sendFromClient(cm, clientIds[i]);
+            expected++;
+        }
+        runUntil(listenSockets + 2 * MANY_CONNECTIONS, expected);
+    }
+
+    stopEventLoop();
+    ck_assert_uint_eq(connCount, 0);
+} END_TEST
+
+#ifndef _WIN32
+START_TEST(sendVectorTCP) {
+    UA_ConnectionManager *cm = UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcpCM"));
+    el = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    el->registerEventSource(el, &cm->eventSource);
+    el->start(el);
+    ck_assert(cm->sendWithConnectionVector != NULL);
+
+    UA_UInt16 port = 4840;
+    UA_Boolean listen = true;
+    UA_String host = UA_STRING("localhost");
+
+    UA_KeyValuePair params[3];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+
+    UA_KeyValueMap paramsMap;
+    paramsMap.map = params;
+    paramsMap.mapSize = 3;
+
+    connCount = 0;
+    cm->openConnection(cm, &paramsMap, NULL, NULL, connectionCallback);
+    size_t listenSockets = connCount;
+
+    /* Open a client connection */
+    clientId = 0;
+    listen = false;
+    UA_StatusCode retval =
+        cm->openConnection(cm, &paramsMap, NULL, (void*)0x01, connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(clientId != 0);
+
+    /* Send the message split over three buffers */
+    received = false;
+    size_t splits[4] = {0, 4, 7, strlen(testMsg)};
+    UA_ByteString snd[3];
+    for(size_t i = 0; i < 3; i++) {
+        retval = cm->allocNetworkBuffer(cm, clientId, &snd[i],
+                                        splits[i+1] - splits[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd[i].data, &testMsg[splits[i]], snd[i].length);
+    }
+    retval = cm->sendWithConnectionVector(cm, clientId, NULL, snd, 3);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert(received);
+
+    /* Close the connection */
+    retval = cm->closeConnection(cm, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(connCount, listenSockets);
+
+    /* Stop the EventLoop */
+    int max_stop_iteration_count = 10;
+    int iteration = 0;
+    el->stop(el);
+    while(el->state != UA_EVENTLOOPSTATE_STOPPED &&
+          iteration < max_stop_iteration_count) {
+        UA_DateTime next = el->run(el, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+        iteration++;
+    }
+    ck_assert(el->state == UA_EVENTLOOPSTATE_STOPPED);
+    el->free(el);
+    el = NULL;
+} END_TEST
+#endif
+
 int main(void) {
     Suite *s  = suite_create("Test TCP EventLoop");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, listenTCP);
     tcase_add_test(tc, connectTCP);
+    tcase_add_test(tc, connectFailTCP);
+    tcase_add_test(tc, sendQueueTCP);
+    tcase_add_test(tc, sendQueueLimitTCP);
+    tcase_add_test(tc, manyConnectionsTCP);
+    tcase_add_test(tc, sparseEventsTCP);
+    tcase_add_test(tc, sortedFDsTCP);
+#ifndef _WIN32
+    tcase_add_test(tc, registerFDPipe);
+    tcase_add_test(tc, sendVectorTCP);
+#endif
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
@@ -16,6 +16,7 @@ static UA_EventLoop *el;
 static char *testMsg = "open62541";
 static uintptr_t clientId;
 static UA_Boolean received;
+static size_t receivedCount;
 
 typedef struct TestContext {
     unsigned connCount;
@@ -62,6 +63,7 @@ connectionCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
         UA_ByteString rcv = UA_BYTESTRING(testMsg);
         ck_assert(UA_String_equal(&msg, &rcv));
         received = true;
+        receivedCount++;
     }
 }
 
@@ -394,6 +396,176 @@ START_TEST(udpTalkerAndListener) {
     ck_assert_uint_eq(testContext.connCount, 0);
 } END_TEST
 
+/* Several datagrams are received with a single syscall and delivered with
+ * individual callbacks */
+START_TEST(udpBatchedReceive) {
+    UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmListener = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    UA_UInt32 batchSize = 8;
+    UA_KeyValueMap_setScalar(&cmListener->eventSource.params,
+                             UA_QUALIFIEDNAME(0, "recv-batchsize"),
+                             &batchSize, &UA_TYPES[UA_TYPES_UINT32]);
+    elListener->registerEventSource(elListener, &cmListener->eventSource);
+    elListener->start(elListener);
+
+    UA_EventLoop *elTalker = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmTalker = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elTalker->registerEventSource(elTalker, &cmTalker->eventSource);
+    elTalker->start(elTalker);
+
+    /* Open a listener connection */
+    UA_UInt16 port = 30000;
+    UA_Boolean listen = true;
+
+    UA_KeyValuePair params[3];
+    UA_KeyValueMap paramsMap = {2, params};
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    TestContext testContext;
+    testContext.connCount = 0;
+
+    UA_StatusCode retval =
+        cmListener->openConnection(cmListener, &paramsMap, NULL, &testContext,
+                                   connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Open a talker connection */
+    clientId = 0;
+    listen = false;
+    UA_String targetHost = UA_STRING("127.0.0.1");
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[2].value, &targetHost, &UA_TYPES[UA_TYPES_STRING]);
+    paramsMap.mapSize = 3;
+
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+
+    /* Send more messages than fit into one batch */
+    receivedCount = 0;
+    for(size_t i = 0; i < 12; i++) {
+        UA_ByteString snd;
+        retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd.data, testMsg, strlen(testMsg));
+        retval = cmTalker->sendWithConnection(cmTalker, clientId,
+                                              &UA_KEYVALUEMAP_NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 4; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(receivedCount, 12);
+
+    /* Close the connection and stop the EventLoops */
+    retval = cmTalker->closeConnection(cmTalker, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    elTalker->stop(elTalker);
+    while(elTalker->state != UA_EVENTLOOPSTATE_STOPPED)
+        elTalker->run(elTalker, 1);
+    elTalker->free(elTalker);
+
+    elListener->stop(elListener);
+    while(elListener->state != UA_EVENTLOOPSTATE_STOPPED)
+        elListener->run(elListener, 1);
+    elListener->free(elListener);
+
+    ck_assert_uint_eq(testContext.connCount, 0);
+} END_TEST
+
+START_TEST(udpFanoutSend) {
+    UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmListener = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elListener->registerEventSource(elListener, &cmListener->eventSource);
+    elListener->start(elListener);
+
+    UA_EventLoop *elTalker = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+    UA_ConnectionManager *cmTalker = UA_ConnectionManager_new_POSIX_UDP(UA_STRING("udpCM"));
+    elTalker->registerEventSource(elTalker, &cmTalker->eventSource);
+    elTalker->start(elTalker);
+
+    /* Open two listener connections on different ports */
+    UA_UInt16 ports[2] = {30001, 30002};
+    UA_Boolean listen = true;
+
+    UA_KeyValuePair params[3];
+    UA_KeyValueMap paramsMap = {2, params};
+    params[1].key = UA_QUALIFIEDNAME(0, "listen");
+    UA_Variant_setScalar(&params[1].value, &listen, &UA_TYPES[UA_TYPES_BOOLEAN]);
+
+    TestContext testContext;
+    testContext.connCount = 0;
+
+    UA_StatusCode retval;
+    for(size_t i = 0; i < 2; i++) {
+        params[0].key = UA_QUALIFIEDNAME(0, "port");
+        UA_Variant_setScalar(&params[0].value, &ports[i], &UA_TYPES[UA_TYPES_UINT16]);
+        retval = cmListener->openConnection(cmListener, &paramsMap, NULL, &testContext,
+                                            connectionCallback);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* Open a talker connection with both destinations */
+    clientId = 0;
+    listen = false;
+    UA_String targetHosts[2] = {UA_STRING_STATIC("127.0.0.1"),
+                                UA_STRING_STATIC("127.0.0.1")};
+    UA_Variant_setArray(&params[0].value, ports, 2, &UA_TYPES[UA_TYPES_UINT16]);
+    params[2].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setArray(&params[2].value, targetHosts, 2, &UA_TYPES[UA_TYPES_STRING]);
+    paramsMap.mapSize = 3;
+
+    retval = cmTalker->openConnection(cmTalker, &paramsMap, NULL, &testContext,
+                                      connectionCallback);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        UA_DateTime next = elTalker->run(elTalker, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_ne(clientId, 0);
+
+    /* Every buffer arrives at both listeners */
+    receivedCount = 0;
+    for(size_t i = 0; i < 3; i++) {
+        UA_ByteString snd;
+        retval = cmTalker->allocNetworkBuffer(cmTalker, clientId, &snd, strlen(testMsg));
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        memcpy(snd.data, testMsg, strlen(testMsg));
+        retval = cmTalker->sendWithConnection(cmTalker, clientId,
+                                              &UA_KEYVALUEMAP_NULL, &snd);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < 4; i++) {
+        UA_DateTime next = elListener->run(elListener, 1);
+        UA_fakeSleep((UA_UInt32)((next - UA_DateTime_now()) / UA_DATETIME_MSEC));
+    }
+    ck_assert_uint_eq(receivedCount, 6);
+
+    /* Close the connection and stop the EventLoops */
+    retval = cmTalker->closeConnection(cmTalker, clientId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    elTalker->stop(elTalker);
+    while(elTalker->state != UA_EVENTLOOPSTATE_STOPPED)
+        elTalker->run(elTalker, 1);
+    elTalker->free(elTalker);
+
+    elListener->stop(elListener);
+    while(elListener->state != UA_EVENTLOOPSTATE_STOPPED)
+        elListener->run(elListener, 1);
+    elListener->free(elListener);
+
+    ck_assert_uint_eq(testContext.connCount, 0);
+} END_TEST
+
 START_TEST(udpTalkerAndListenerDifferentDestination) {
     /* create listener eventloop */
     UA_EventLoop *elListener = UA_EventLoop_new_POSIX(UA_Log_Stdout);
@@ -525,6 +697,8 @@ int main(void) {
     tcase_add_test(tc, connectUDPValidationFails);
     tcase_add_test(tc, connectUDPValidationSucceeds);
     tcase_add_test(tc, udpTalkerAndListener);
+    tcase_add_test(tc, udpBatchedReceive);
+    tcase_add_test(tc, udpFanoutSend);
     tcase_add_test(tc, udpTalkerAndListenerDifferentDestination);
     suite_add_tcase(s, tc);
 
@@ -456,7 +456,7 @@ START_TEST(SecureChannel_sendSymmetricMessage_invalidParameters) {
 static UA_StatusCode
 process_callback(void *application, UA_SecureChannel *channel,
                  UA_MessageType messageType, UA_UInt32 requestId,
-                 UA_ByteString *message) {
+                 UA_ByteString *message, size_t messageSegments) {
     ck_assert_ptr_ne(message, NULL);
     ck_assert_ptr_ne(application, NULL);
     if(message == NULL || application == NULL)
@@ -524,6 +524,149 @@ START_TEST(SecureChannel_assemblePartialChunks) {
     ck_assert_int_eq(chunks_processed, 5);
 } END_TEST
 
+#define ASSEMBLE_CHUNK_PAYLOAD 100
+#define ASSEMBLE_CHUNKS 6
+
+typedef struct {
+    size_t messages;
+    UA_ByteString message;
+} AssembleContext;
+
+static UA_StatusCode
+assemble_callback(void *application, UA_SecureChannel *channel,
+                  UA_MessageType messageType, UA_UInt32 requestId,
+                  UA_ByteString *message, size_t messageSegments) {
+    AssembleContext *ctx = (AssembleContext *)application;
+    ck_assert_uint_eq(messageType, UA_MESSAGETYPE_MSG);
+    ck_assert_uint_eq(requestId, 42);
+    ctx->messages++;
+
+    /* The MSG is not reassembled. Every chunk payload is one segment. */
+    ck_assert_uint_eq(messageSegments, ASSEMBLE_CHUNKS);
+    size_t length = 0;
+    for(size_t i = 0; i < messageSegments; i++)
+        length += message[i].length;
+    UA_StatusCode res = UA_ByteString_allocBuffer(&ctx->message, length);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    length = 0;
+    for(size_t i = 0; i < messageSegments; i++) {
+        memcpy(&ctx->message.data[length], message[i].data, message[i].length);
+        length += message[i].length;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Encode a symmetric MSG chunk without security. The payload bytes count up
+ * from the chunk index. */
+static void
+encodeMsgChunk(UA_Byte *buf, UA_UInt32 sequenceNumber, UA_Boolean final) {
+    size_t chunkSize = UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH +
+        ASSEMBLE_CHUNK_PAYLOAD;
+    UA_Byte *pos = buf;
+    const UA_Byte *end = &buf[chunkSize];
+    UA_TcpMessageHeader header;
+    header.messageTypeAndChunkType = (UA_UInt32)UA_MESSAGETYPE_MSG +
+        (UA_UInt32)((final) ? UA_CHUNKTYPE_FINAL : UA_CHUNKTYPE_INTERMEDIATE);
+    header.messageSize = (UA_UInt32)chunkSize;
+    UA_UInt32 channelId = 0;
+    UA_UInt32 tokenId = 0;
+    UA_SequenceHeader seqHeader = {sequenceNumber, 42};
+    UA_StatusCode res =
+        UA_encodeBinaryInternal(&header, &UA_TRANSPORT[UA_TRANSPORT_TCPMESSAGEHEADER],
+                                &pos, &end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&channelId, &UA_TYPES[UA_TYPES_UINT32],
+                                   &pos, &end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&tokenId, &UA_TYPES[UA_TYPES_UINT32],
+                                   &pos, &end, NULL, NULL);
+    res |= UA_encodeBinaryInternal(&seqHeader, &UA_TRANSPORT[UA_TRANSPORT_SEQUENCEHEADER],
+                                   &pos, &end, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < ASSEMBLE_CHUNK_PAYLOAD; i++)
+        pos[i] = (UA_Byte)(sequenceNumber + i);
+}
+
+/* Intermediate chunks arrive in separate buffers and are persisted between
+ * the calls to processBuffer. The assembled message must be identical. */
+START_TEST(SecureChannel_assembleIntermediateChunks) {
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+
+    size_t chunkSize = UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH +
+        ASSEMBLE_CHUNK_PAYLOAD;
+    UA_Byte buf[ASSEMBLE_CHUNKS * (UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH +
+                                   ASSEMBLE_CHUNK_PAYLOAD)];
+    for(size_t i = 0; i < ASSEMBLE_CHUNKS; i++)
+        encodeMsgChunk(&buf[i * chunkSize], (UA_UInt32)(i + 1),
+                       i == ASSEMBLE_CHUNKS - 1);
+
+    /* Deliver the chunks in irregular pieces. Two chunks in the first buffer,
+     * then one and a half, and so on. */
+    AssembleContext ctx;
+    memset(&ctx, 0, sizeof(AssembleContext));
+    size_t pieces[] = {2 * chunkSize, chunkSize + chunkSize / 2,
+                       chunkSize / 2, chunkSize, chunkSize};
+    size_t offset = 0;
+    for(size_t i = 0; i < sizeof(pieces) / sizeof(size_t); i++) {
+        ck_assert_uint_eq(ctx.messages, 0);
+        UA_ByteString piece = {pieces[i], &buf[offset]};
+        UA_StatusCode res =
+            UA_SecureChannel_processBuffer(&testChannel, &ctx, assemble_callback,
+                                           &piece, UA_DateTime_nowMonotonic());
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        offset += pieces[i];
+    }
+    ck_assert_uint_eq(offset, sizeof(buf));
+    ck_assert_uint_eq(ctx.messages, 1);
+
+    /* Compare with the concatenated payloads */
+    ck_assert_uint_eq(ctx.message.length, ASSEMBLE_CHUNKS * ASSEMBLE_CHUNK_PAYLOAD);
+    for(size_t i = 0; i < ASSEMBLE_CHUNKS; i++) {
+        for(size_t j = 0; j < ASSEMBLE_CHUNK_PAYLOAD; j++)
+            ck_assert_uint_eq(ctx.message.data[i * ASSEMBLE_CHUNK_PAYLOAD + j],
+                              (UA_Byte)(i + 1 + j));
+    }
+    UA_ByteString_clear(&ctx.message);
+} END_TEST
+
+static UA_StatusCode
+pipeline_callback(void *application, UA_SecureChannel *channel,
+                  UA_MessageType messageType, UA_UInt32 requestId,
+                  UA_ByteString *message, size_t messageSegments) {
+    /* The messages are dispatched in order. The payload starts with the
+     * sequence number. */
+    size_t *messages = (size_t *)application;
+    ++*messages;
+    ck_assert_uint_eq(message->length, ASSEMBLE_CHUNK_PAYLOAD);
+    ck_assert_uint_eq(message->data[0], *messages);
+    return UA_STATUSCODE_GOOD;
+}
+
+/* Many small pipelined requests arrive in one buffer. They are decrypted as a
+ * batch and dispatched in order. */
+START_TEST(SecureChannel_processPipelinedChunks) {
+    testChannel.securityToken.createdAt = UA_DateTime_nowMonotonic();
+    testChannel.securityToken.revisedLifetime = 600000;
+
+    size_t chunkSize = UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH +
+        ASSEMBLE_CHUNK_PAYLOAD;
+    UA_Byte buf[ASSEMBLE_CHUNKS * (UA_SECURECHANNEL_SYMMETRIC_HEADER_TOTALLENGTH +
+                                   ASSEMBLE_CHUNK_PAYLOAD)];
+    for(size_t i = 0; i < ASSEMBLE_CHUNKS; i++)
+        encodeMsgChunk(&buf[i * chunkSize], (UA_UInt32)(i + 1), true);
+
+    size_t messages = 0;
+    UA_ByteString buffer = {sizeof(buf), buf};
+    UA_StatusCode res =
+        UA_SecureChannel_processBuffer(&testChannel, &messages, pipeline_callback,
+                                       &buffer, UA_DateTime_nowMonotonic());
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(messages, ASSEMBLE_CHUNKS);
+
+    ck_assert_uint_eq(testChannel.receivedBufferCount, 1);
+    ck_assert_uint_eq(testChannel.receivedChunkCount, ASSEMBLE_CHUNKS);
+    ck_assert_uint_eq(testChannel.maxChunksPerBuffer, ASSEMBLE_CHUNKS);
+} END_TEST
+
 
 static Suite *
 testSuite_SecureChannel(void) {
@@ -565,6 +708,8 @@ testSuite_SecureChannel(void) {
     tcase_add_checked_fixture(tc_processBuffer, setup_key_sizes, teardown_key_sizes);
     tcase_add_checked_fixture(tc_processBuffer, setup_secureChannel, teardown_secureChannel);
     tcase_add_test(tc_processBuffer, SecureChannel_assemblePartialChunks);
+    tcase_add_test(tc_processBuffer, SecureChannel_assembleIntermediateChunks);
+    tcase_add_test(tc_processBuffer, SecureChannel_processPipelinedChunks);
     suite_add_tcase(s, tc_processBuffer);
 
     return s;
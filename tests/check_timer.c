@@ -52,10 +52,84 @@ START_TEST(benchmarkTimer) {
     UA_Timer_clear(&timer);
 } END_TEST
 
+static UA_DateTime currentNow;
+static UA_DateTime execTimes[16];
+static size_t execCount;
+
+static void
+recordCallback(void *application, void *data) {
+    if(execCount < 16)
+        execTimes[execCount] = currentNow;
+    execCount++;
+}
+
+START_TEST(repeatedCallbackShallRunOnTime) {
+    UA_Timer timer;
+    UA_Timer_init(&timer);
+    execCount = 0;
+
+    /* Not aligned with the millisecond */
+    UA_DateTime start = 1000 * UA_DATETIME_SEC + 1234;
+    UA_UInt64 id;
+    UA_Timer_addRepeatedCallback(&timer, recordCallback, NULL, NULL, 300.0, start,
+                                 NULL, UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME, &id);
+
+    /* Jump to the next time returned by the timer */
+    currentNow = start;
+    for(size_t i = 0; i < 100 && execCount < 10; i++)
+        currentNow = UA_Timer_process(&timer, currentNow);
+    ck_assert_uint_eq(execCount, 10);
+    for(size_t i = 0; i < 10; i++)
+        ck_assert_int_eq(execTimes[i],
+                         start + (UA_DateTime)(i + 1) * 300 * UA_DATETIME_MSEC);
+
+    /* Never early */
+    UA_Timer_removeCallback(&timer, id);
+    UA_DateTime date = currentNow + 20 * UA_DATETIME_MSEC + 5;
+    UA_Timer_addTimedCallback(&timer, recordCallback, NULL, NULL, date, NULL);
+    currentNow = date - 1;
+    ck_assert_int_eq(UA_Timer_process(&timer, currentNow), date);
+    ck_assert_uint_eq(execCount, 10);
+    currentNow = date;
+    ck_assert_int_eq(UA_Timer_process(&timer, currentNow), UA_INT64_MAX);
+    ck_assert_uint_eq(execCount, 11);
+
+    UA_Timer_clear(&timer);
+} END_TEST
+
+static UA_Timer removeTimer;
+static UA_UInt64 removeIds[2];
+
+static void
+removeOtherCallback(void *application, void *data) {
+    execCount++;
+    UA_Timer_removeCallback(&removeTimer, removeIds[0]);
+    UA_Timer_removeCallback(&removeTimer, removeIds[1]);
+}
+
+START_TEST(removeCallbackFromCallback) {
+    UA_Timer_init(&removeTimer);
+    execCount = 0;
+
+    /* Both are due in the same tick. Only the first one is executed. */
+    for(size_t i = 0; i < 2; i++)
+        UA_Timer_addRepeatedCallback(&removeTimer, removeOtherCallback, NULL, NULL,
+                                     10.0, 0, NULL,
+                                     UA_TIMER_HANDLE_CYCLEMISS_WITH_CURRENTTIME,
+                                     &removeIds[i]);
+    ck_assert_int_eq(UA_Timer_process(&removeTimer, 100 * UA_DATETIME_MSEC),
+                     UA_INT64_MAX);
+    ck_assert_uint_eq(execCount, 1);
+
+    UA_Timer_clear(&removeTimer);
+} END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Event Timer");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, benchmarkTimer);
+    tcase_add_test(tc, repeatedCallbackShallRunOnTime);
+    tcase_add_test(tc, removeCallbackFromCallback);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
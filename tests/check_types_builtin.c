@@ -511,6 +511,157 @@ START_TEST(UA_Variant_decodeWithArrayFlagSetShallSetVTAndAllocateMemoryForArray)
 }
 END_TEST
 
+START_TEST(UA_Variant_decodeZeroCopyShallPointIntoBuffer) {
+    // given
+    UA_Byte data[] = { (UA_Byte)(UA_TYPES[UA_TYPES_BYTE].typeId.identifier.numeric |
+                                 UA_VARIANT_ENCODINGMASKTYPE_ARRAY),
+                       0x03, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03 };
+    UA_ByteString src = { 8, data };
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.zeroCopy = true;
+    UA_Variant dst;
+    // when
+    UA_StatusCode retval = UA_decodeBinary(&src, &dst, &UA_TYPES[UA_TYPES_VARIANT], &opts);
+    // then
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq((uintptr_t)dst.type, (uintptr_t)&UA_TYPES[UA_TYPES_BYTE]);
+    ck_assert_uint_eq(dst.arrayLength, 3);
+    ck_assert_uint_eq((uintptr_t)dst.data, (uintptr_t)&data[5]);
+    ck_assert_int_eq(dst.storageType, UA_VARIANT_DATA_NODELETE);
+    ck_assert_uint_eq(UA_calcSizeBinary(&dst, &UA_TYPES[UA_TYPES_VARIANT]), 8);
+    // finally
+    UA_Variant_clear(&dst); /* Does not free the data */
+
+    // given: array dimensions are always decoded into new memory
+    UA_Byte dimData[] = { (UA_Byte)(UA_TYPES[UA_TYPES_BYTE].typeId.identifier.numeric |
+                                    UA_VARIANT_ENCODINGMASKTYPE_ARRAY |
+                                    UA_VARIANT_ENCODINGMASKTYPE_DIMENSIONS),
+                          0x02, 0x00, 0x00, 0x00, 0x01, 0x02,
+                          0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00 };
+    UA_ByteString dimSrc = { 15, dimData };
+    // when
+    retval = UA_decodeBinary(&dimSrc, &dst, &UA_TYPES[UA_TYPES_VARIANT], &opts);
+    // then
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(dst.storageType, UA_VARIANT_DATA);
+    ck_assert_uint_eq(dst.arrayLength, 2);
+    ck_assert_uint_ne((uintptr_t)dst.data, (uintptr_t)&dimData[5]);
+    ck_assert_uint_eq(dst.arrayDimensionsSize, 1);
+    ck_assert_uint_eq(dst.arrayDimensions[0], 2);
+    // finally
+    UA_Variant_clear(&dst);
+}
+END_TEST
+
+START_TEST(UA_ExtensionObject_decodeLazyShallKeepBody) {
+    // given: a Variant with a ReadValueId and a ReadRequest with a filter
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "lazy");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &rvi, &UA_TYPES[UA_TYPES_READVALUEID]);
+    UA_ByteString encoded = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT], &encoded);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.lazyExtensionObjects = true;
+
+    // when
+    UA_Variant dst;
+    retval = UA_decodeBinary(&encoded, &dst, &UA_TYPES[UA_TYPES_VARIANT], &opts);
+
+    // then: the content stays encoded and is re-encoded identically
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(dst.type, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    UA_ExtensionObject *eo = (UA_ExtensionObject*)dst.data;
+    ck_assert_int_eq(eo->encoding, UA_EXTENSIONOBJECT_ENCODED_BYTESTRING);
+    UA_ByteString reencoded = UA_BYTESTRING_NULL;
+    retval = UA_encodeBinary(&dst, &UA_TYPES[UA_TYPES_VARIANT], &reencoded);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&encoded, &reencoded));
+    UA_ByteString_clear(&reencoded);
+
+    // when: decoding on first access
+    retval = UA_ExtensionObject_ensureDecoded(eo, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(eo->encoding, UA_EXTENSIONOBJECT_DECODED);
+    ck_assert_ptr_eq(eo->content.decoded.type, &UA_TYPES[UA_TYPES_READVALUEID]);
+    ck_assert(UA_equal(eo->content.decoded.data, &rvi, &UA_TYPES[UA_TYPES_READVALUEID]));
+    retval = UA_ExtensionObject_ensureDecoded(eo, NULL); /* No-op */
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&dst);
+
+    // then: unknown types are left untouched
+    UA_ExtensionObject unknown;
+    UA_ExtensionObject_init(&unknown);
+    unknown.encoding = UA_EXTENSIONOBJECT_ENCODED_BYTESTRING;
+    unknown.content.encoded.typeId = UA_NODEID_NUMERIC(2, 4711);
+    unknown.content.encoded.body = encoded;
+    retval = UA_ExtensionObject_ensureDecoded(&unknown, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_BADDATATYPEIDUNKNOWN);
+    ck_assert_int_eq(unknown.encoding, UA_EXTENSIONOBJECT_ENCODED_BYTESTRING);
+
+    // finally
+    UA_ByteString_clear(&encoded);
+}
+END_TEST
+
+START_TEST(UA_decodeBinaryIntoArenaShallWork) {
+    // given
+    UA_ReadValueId rvi[3];
+    for(size_t i = 0; i < 3; i++)
+        UA_ReadValueId_init(&rvi[i]);
+    rvi[0].nodeId = UA_NODEID_STRING(1, "the.answer");
+    rvi[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    rvi[1].nodeId = UA_NODEID_NUMERIC(0, 2255);
+    rvi[1].indexRange = UA_STRING("1:2");
+    rvi[2].nodeId = UA_NODEID_STRING(1, "a somewhat longer identifier that needs its own block");
+    rvi[2].dataEncoding = UA_QUALIFIEDNAME(0, "Default Binary");
+    UA_ReadRequest req;
+    UA_ReadRequest_init(&req);
+    req.nodesToRead = rvi;
+    req.nodesToReadSize = 3;
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode retval = UA_encodeBinary(&req, &UA_TYPES[UA_TYPES_READREQUEST], &buf);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Arena arena;
+    memset(&arena, 0, sizeof(UA_Arena));
+    arena.blockSize = 64; /* Force several blocks */
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.arena = &arena;
+
+    // when
+    UA_ReadRequest dst;
+    retval = UA_decodeBinary(&buf, &dst, &UA_TYPES[UA_TYPES_READREQUEST], &opts);
+
+    // then
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_order(&req, &dst, &UA_TYPES[UA_TYPES_READREQUEST]), UA_ORDER_EQ);
+    ck_assert_uint_eq((uintptr_t)dst.nodesToRead % 8, 0);
+    ck_assert_ptr_ne(arena.blocks, NULL);
+    UA_Arena_clear(&arena); /* Releases dst */
+    ck_assert_ptr_eq(arena.blocks, NULL);
+
+    // when: decoding fails halfway
+    buf.length -= 5;
+    retval = UA_decodeBinary(&buf, &dst, &UA_TYPES[UA_TYPES_READREQUEST], &opts);
+
+    // then
+    ck_assert_int_ne(retval, UA_STATUSCODE_GOOD);
+    UA_Arena_clear(&arena);
+    buf.length += 5;
+
+    // finally
+    UA_ByteString_clear(&buf);
+}
+END_TEST
+
 START_TEST(UA_Variant_decodeSingleExtensionObjectShallSetVTAndAllocateMemory){
     /* // given */
     /* size_t pos = 0; */
@@ -916,6 +1067,46 @@ START_TEST(UA_Double_encodeShallWorkOnExample) {
 }
 END_TEST
 
+START_TEST(UA_Variant_encodeNumericArraysShallEncodeLittleEndian) {
+    // given
+    UA_Int16 i16[2] = {1, -2};
+    UA_Int64 i64[2] = {0x0102030405060708, -1};
+    UA_Double d[2] = {1.0, -2.0};
+    UA_Byte expected16[] = {0x01, 0x00, 0xFE, 0xFF};
+    UA_Byte expected64[] = {0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,
+                            0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    UA_Byte expectedD[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x3F,
+                           0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xC0};
+    const void *arrays[3] = {i16, i64, d};
+    const UA_DataType *types[3] = {&UA_TYPES[UA_TYPES_INT16], &UA_TYPES[UA_TYPES_INT64],
+                                   &UA_TYPES[UA_TYPES_DOUBLE]};
+    const UA_Byte *expected[3] = {expected16, expected64, expectedD};
+    size_t expectedSize[3] = {sizeof(expected16), sizeof(expected64), sizeof(expectedD)};
+
+    for(size_t i = 0; i < 3; i++) {
+        UA_Variant v;
+        UA_Variant_setArray(&v, (void*)(uintptr_t)arrays[i], 2, types[i]);
+        // when
+        UA_ByteString buf = UA_BYTESTRING_NULL;
+        UA_StatusCode retval = UA_encodeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT], &buf);
+        // then
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(buf.length, 1 + 4 + expectedSize[i]);
+        ck_assert_int_eq(memcmp(&buf.data[5], expected[i], expectedSize[i]), 0);
+
+        UA_Variant dec;
+        retval = UA_decodeBinary(&buf, &dec, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(UA_Variant_hasArrayType(&dec, types[i]));
+        ck_assert_uint_eq(dec.arrayLength, 2);
+        ck_assert_int_eq(memcmp(dec.data, arrays[i], 2 * types[i]->memSize), 0);
+        // finally
+        UA_Variant_clear(&dec);
+        UA_ByteString_clear(&buf);
+    }
+}
+END_TEST
+
 START_TEST(UA_String_encodeShallWorkOnExample) {
     // given
     UA_String src;
@@ -1117,6 +1308,45 @@ START_TEST(UA_ExpandedNodeId_hashIdentical) {
 }
 END_TEST
 
+START_TEST(UA_NodeId_hashLowBitsDistributed) {
+    /* Sequential numeric identifiers fill most slots of a masked table */
+    UA_Byte slots[1024];
+    memset(slots, 0, sizeof(slots));
+    size_t used = 0;
+    for(UA_UInt32 i = 0; i < 1024; i++) {
+        UA_NodeId n = UA_NODEID_NUMERIC(1, 5000 + i);
+        UA_UInt32 slot = UA_NodeId_hash(&n) & 1023;
+        if(!slots[slot])
+            used++;
+        slots[slot] = 1;
+    }
+    ck_assert_uint_gt(used, 600);
+
+    /* The namespace index is part of the hash */
+    UA_NodeId n1 = UA_NODEID_NUMERIC(0, 85);
+    UA_NodeId n2 = UA_NODEID_NUMERIC(1, 85);
+    ck_assert_uint_ne(UA_NodeId_hash(&n1), UA_NodeId_hash(&n2));
+}
+END_TEST
+
+START_TEST(UA_ByteString_hashIndependentOfAlignment) {
+    const char *text = "xthe.quick.brown.fox.jumps.over.the.lazy.dog";
+    UA_Byte buf[64];
+    for(size_t len = 0; len < 40; len++) {
+        UA_UInt32 h = UA_ByteString_hash(7, (const UA_Byte*)&text[1], len);
+        for(size_t off = 1; off < 8; off++) {
+            memcpy(&buf[off], &text[1], len);
+            ck_assert_uint_eq(UA_ByteString_hash(7, &buf[off], len), h);
+        }
+        /* The length and the initial value change the hash */
+        if(len > 0) {
+            ck_assert_uint_ne(UA_ByteString_hash(7, (const UA_Byte*)&text[1], len - 1), h);
+            ck_assert_uint_ne(UA_ByteString_hash(8, (const UA_Byte*)&text[1], len), h);
+        }
+    }
+}
+END_TEST
+
 START_TEST(UA_ExtensionObject_copyShallWorkOnExample) {
     // given
     /* UA_Byte data[3] = { 1, 2, 3 }; */
@@ -1461,6 +1691,124 @@ START_TEST(UA_Variant_copyShallWorkOn1DArrayExample) {
 }
 END_TEST
 
+START_TEST(UA_MonitoredItemCreateRequest_copyShallBeDeep) {
+    UA_MonitoredItemCreateRequest src;
+    UA_MonitoredItemCreateRequest_init(&src);
+    src.itemToMonitor.nodeId = UA_NODEID_STRING_ALLOC(1, "the.answer");
+    src.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    src.itemToMonitor.indexRange = UA_STRING_ALLOC("1:2");
+    src.itemToMonitor.dataEncoding = UA_QUALIFIEDNAME_ALLOC(0, "Default Binary");
+    src.monitoringMode = UA_MONITORINGMODE_SAMPLING;
+    src.requestedParameters.clientHandle = 42;
+    src.requestedParameters.samplingInterval = 250.0;
+    src.requestedParameters.queueSize = 10;
+    src.requestedParameters.discardOldest = true;
+
+    UA_MonitoredItemCreateRequest dst[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_StatusCode res =
+            UA_MonitoredItemCreateRequest_copy(i == 0 ? &src : &dst[0], &dst[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(UA_equal(&src, &dst[i], &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]));
+        ck_assert_ptr_ne(dst[i].itemToMonitor.nodeId.identifier.string.data,
+                         src.itemToMonitor.nodeId.identifier.string.data);
+        ck_assert_ptr_ne(dst[i].itemToMonitor.indexRange.data,
+                         src.itemToMonitor.indexRange.data);
+        ck_assert_ptr_ne(dst[i].itemToMonitor.dataEncoding.name.data,
+                         src.itemToMonitor.dataEncoding.name.data);
+    }
+
+    /* Array members and pointer-free structures */
+    UA_ReadRequest rr;
+    UA_ReadRequest_init(&rr);
+    rr.maxAge = 100.0;
+    rr.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    rr.nodesToRead = &src.itemToMonitor;
+    rr.nodesToReadSize = 1;
+    UA_ReadRequest rr2;
+    UA_StatusCode res = UA_ReadRequest_copy(&rr, &rr2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_equal(&rr, &rr2, &UA_TYPES[UA_TYPES_READREQUEST]));
+    ck_assert_ptr_ne(rr2.nodesToRead, rr.nodesToRead);
+
+    UA_Range range = {1.0, 2.0};
+    UA_Range range2;
+    res = UA_Range_copy(&range, &range2);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(range2.low == 1.0 && range2.high == 2.0);
+
+    UA_ReadRequest_clear(&rr2);
+    UA_MonitoredItemCreateRequest_clear(&dst[0]);
+    UA_MonitoredItemCreateRequest_clear(&dst[1]);
+    UA_MonitoredItemCreateRequest_clear(&src);
+    ck_assert_ptr_eq(src.itemToMonitor.indexRange.data, NULL);
+}
+END_TEST
+
+START_TEST(UA_Variant_shareShallCopyByReference) {
+    UA_String *srcArray = (UA_String*)UA_Array_new(3, &UA_TYPES[UA_TYPES_STRING]);
+    srcArray[0] = UA_STRING_ALLOC("__open");
+    srcArray[1] = UA_STRING_ALLOC("_62541");
+    srcArray[2] = UA_STRING_ALLOC("opc ua");
+
+    UA_Variant value;
+    UA_Variant_setArray(&value, srcArray, 3, &UA_TYPES[UA_TYPES_STRING]);
+    value.arrayDimensions = (UA_UInt32*)UA_malloc(sizeof(UA_UInt32));
+    value.arrayDimensions[0] = 3;
+    value.arrayDimensionsSize = 1;
+
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(value.storageType, UA_VARIANT_DATA_SHARED);
+    retval = UA_Variant_share(&value); /* Sharing twice has no effect */
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Copies point to the same data */
+    UA_DataValue dv1, dv2;
+    UA_DataValue_init(&dv1);
+    dv1.value = value;
+    dv1.hasValue = true;
+    retval = UA_DataValue_copy(&dv1, &dv2);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(dv2.value.data, value.data);
+    ck_assert_int_eq(dv2.value.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_ne(dv2.value.arrayDimensions, value.arrayDimensions);
+    ck_assert(UA_equal(&dv2.value, &value, &UA_TYPES[UA_TYPES_VARIANT]));
+
+    /* Writing a range takes a private copy */
+    UA_String s = UA_STRING("changed");
+    UA_NumericRangeDimension d1 = {1, 1};
+    UA_NumericRange nr = {1, &d1};
+    retval = UA_Variant_setRangeCopy(&dv2.value, &s, 1, nr);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(dv2.value.storageType, UA_VARIANT_DATA);
+    ck_assert_ptr_ne(dv2.value.data, value.data);
+    ck_assert(UA_String_equal(&((UA_String*)dv2.value.data)[1], &s));
+    UA_String orig = UA_STRING("_62541");
+    ck_assert(UA_String_equal(&((UA_String*)value.data)[1], &orig));
+    UA_DataValue_clear(&dv2);
+
+    /* The last reference frees the payload */
+    UA_Variant copy;
+    retval = UA_Variant_copy(&value, &copy);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&value);
+    ck_assert(UA_String_equal(&((UA_String*)copy.data)[1], &orig));
+    UA_Variant_clear(&copy);
+
+    /* Borrowed scalars are copied into the shared payload */
+    UA_Variant borrowed;
+    UA_Variant_setScalar(&borrowed, &orig, &UA_TYPES[UA_TYPES_STRING]);
+    borrowed.storageType = UA_VARIANT_DATA_NODELETE;
+    retval = UA_Variant_share(&borrowed);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_isScalar(&borrowed));
+    ck_assert_ptr_ne(borrowed.data, &orig);
+    ck_assert(UA_String_equal((UA_String*)borrowed.data, &orig));
+    UA_Variant_clear(&borrowed);
+}
+END_TEST
+
 START_TEST(UA_Variant_copyShallWorkOn2DArrayExample) {
     // given
     UA_Int32 *srcArray = (UA_Int32*)UA_Array_new(6, &UA_TYPES[UA_TYPES_INT32]);
@@ -1572,6 +1920,70 @@ START_TEST(UA_ExtensionObject_encodeDecodeShallWorkOnExtensionObject) {
 }
 END_TEST
 
+START_TEST(UA_calcSizeBinaryShallWorkOnFixedSizeTypes) {
+    UA_Range range;
+    UA_Range_init(&range);
+    ck_assert_uint_eq(UA_calcSizeBinary(&range, &UA_TYPES[UA_TYPES_RANGE]), 16);
+    /* Twice for the cached value */
+    ck_assert_uint_eq(UA_calcSizeBinary(&range, &UA_TYPES[UA_TYPES_RANGE]), 16);
+
+    UA_ServerDiagnosticsSummaryDataType sum;
+    UA_ServerDiagnosticsSummaryDataType_init(&sum);
+    ck_assert_uint_eq(UA_calcSizeBinary(&sum, &UA_TYPES[UA_TYPES_SERVERDIAGNOSTICSSUMMARYDATATYPE]),
+                      12 * 4);
+
+    /* Array of fixed-size structures in a variant */
+    UA_Range ranges[3];
+    for(size_t i = 0; i < 3; i++)
+        UA_Range_init(&ranges[i]);
+    UA_Variant v;
+    UA_Variant_setArray(&v, ranges, 3, &UA_TYPES[UA_TYPES_RANGE]);
+    ck_assert_uint_eq(UA_calcSizeBinary(&v, &UA_TYPES[UA_TYPES_VARIANT]),
+                      1 + 4 + 3 * (4 + 1 + 4 + 16));
+
+    /* Variable size */
+    UA_EUInformation eu;
+    UA_EUInformation_init(&eu);
+    eu.namespaceUri = UA_STRING("abc");
+    ck_assert_uint_eq(UA_calcSizeBinary(&eu, &UA_TYPES[UA_TYPES_EUINFORMATION]),
+                      (4 + 3) + 4 + 1 + 1);
+}
+END_TEST
+
+START_TEST(UA_ExtensionObject_encodeShallWriteContentLength) {
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "temperature");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    rvi.indexRange = UA_STRING("1:4");
+
+    UA_ExtensionObject eo;
+    UA_ExtensionObject_setValue(&eo, &rvi, &UA_TYPES[UA_TYPES_READVALUEID]);
+    size_t contentSize = UA_calcSizeBinary(&rvi, &UA_TYPES[UA_TYPES_READVALUEID]);
+    size_t eoSize = UA_calcSizeBinary(&eo, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    ck_assert_uint_eq(eoSize, 4 + 1 + 4 + contentSize);
+
+    /* Encode into a fixed buffer. The length field is filled in after the
+     * content is encoded. */
+    UA_Byte data[128];
+    memset(data, 0xff, sizeof(data));
+    UA_ByteString buf = {sizeof(data), data};
+    UA_StatusCode retval = UA_encodeBinary(&eo, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT], &buf);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(buf.length, eoSize);
+    UA_Int32 len = (UA_Int32)(data[5] | (data[6] << 8) | (data[7] << 16) | (data[8] << 24));
+    ck_assert_int_eq(len, (UA_Int32)contentSize);
+
+    UA_ExtensionObject eo2;
+    retval = UA_decodeBinary(&buf, &eo2, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT], NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(eo2.encoding, UA_EXTENSIONOBJECT_DECODED);
+    ck_assert_int_eq(UA_order(&rvi, eo2.content.decoded.data,
+                              &UA_TYPES[UA_TYPES_READVALUEID]), UA_ORDER_EQ);
+    UA_ExtensionObject_clear(&eo2);
+}
+END_TEST
+
 START_TEST(UA_Variant_encodeDecodeShallWorkOnVariantWithStruct) {
     UA_Range* sourceRange = UA_Range_new();
     sourceRange->low = 1.0;
@@ -1740,6 +2152,9 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_decode, UA_Variant_decodeSingleExtensionObjectShallSetVTAndAllocateMemory);
     tcase_add_test(tc_decode, UA_Variant_decodeWithOutArrayFlagSetShallSetVTAndAllocateMemoryForArray);
     tcase_add_test(tc_decode, UA_Variant_decodeWithArrayFlagSetShallSetVTAndAllocateMemoryForArray);
+    tcase_add_test(tc_decode, UA_Variant_decodeZeroCopyShallPointIntoBuffer);
+    tcase_add_test(tc_decode, UA_decodeBinaryIntoArenaShallWork);
+    tcase_add_test(tc_decode, UA_ExtensionObject_decodeLazyShallKeepBody);
     tcase_add_test(tc_decode, UA_Variant_decodeWithOutDeleteMembersShallFailInCheckMem);
     tcase_add_test(tc_decode, UA_Variant_decodeWithTooSmallSourceShallReturnWithError);
     suite_add_tcase(s, tc_decode);
@@ -1756,6 +2171,9 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_encode, UA_Int64_encodeShallEncodeLittleEndian);
     tcase_add_test(tc_encode, UA_Float_encodeShallWorkOnExample);
     tcase_add_test(tc_encode, UA_Double_encodeShallWorkOnExample);
+    tcase_add_test(tc_encode, UA_Variant_encodeNumericArraysShallEncodeLittleEndian);
+    tcase_add_test(tc_encode, UA_calcSizeBinaryShallWorkOnFixedSizeTypes);
+    tcase_add_test(tc_encode, UA_ExtensionObject_encodeShallWriteContentLength);
     tcase_add_test(tc_encode, UA_String_encodeShallWorkOnExample);
     tcase_add_test(tc_encode, UA_ExpandedNodeId_encodeShallWorkOnExample);
     tcase_add_test(tc_encode, UA_DataValue_encodeShallWorkOnExampleWithoutVariant);
@@ -1780,6 +2198,8 @@ static Suite *testSuite_builtin(void) {
 
     TCase *tc_hash = tcase_create("hash");
     tcase_add_test(tc_hash, UA_ExpandedNodeId_hashIdentical);
+    tcase_add_test(tc_hash, UA_NodeId_hashLowBitsDistributed);
+    tcase_add_test(tc_hash, UA_ByteString_hashIndependentOfAlignment);
     suite_add_tcase(s, tc_hash);
 
     TCase *tc_copy = tcase_create("copy");
@@ -1790,6 +2210,8 @@ static Suite *testSuite_builtin(void) {
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn1DArrayExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOn2DArrayExample);
     tcase_add_test(tc_copy, UA_Variant_copyShallWorkOnByteStringIndexRange);
+    tcase_add_test(tc_copy, UA_Variant_shareShallCopyByReference);
+    tcase_add_test(tc_copy, UA_MonitoredItemCreateRequest_copyShallBeDeep);
 
     tcase_add_test(tc_copy, UA_DiagnosticInfo_copyShallWorkOnExample);
     tcase_add_test(tc_copy, UA_ApplicationDescription_copyShallWorkOnExample);
@@ -107,6 +107,28 @@ START_TEST(UA_String_json_encode) {
 }
 END_TEST
 
+/* Plain ASCII runs are copied eight bytes at a time */
+START_TEST(UA_String_LongEscape_json_encode) {
+    // given
+    UA_String src = UA_STRING("abcdefghijklmnop\"qrstuvw\\xyz\n\xc3\xa4" "abcdefgh\x7f");
+    const UA_DataType *type = &UA_TYPES[UA_TYPES_STRING];
+
+    UA_ByteString buf;
+    size_t size = UA_calcSizeJson((void *) &src, type, NULL);
+    UA_ByteString_allocBuffer(&buf, size+1);
+
+    // when
+    status s = UA_encodeJson(&src, type, &buf, NULL);
+    ck_assert_int_eq(s, UA_STATUSCODE_GOOD);
+
+    // then
+    char* result = "\"abcdefghijklmnop\\\"qrstuvw\\\\xyz\\n\xc3\xa4" "abcdefgh\\u007f\"";
+    buf.data[size] = 0; /* zero terminate */
+    ck_assert_str_eq(result, (char*)buf.data);
+    UA_ByteString_clear(&buf);
+}
+END_TEST
+
 START_TEST(UA_String_Empty_json_encode) {
     // given
     UA_String src = UA_STRING("");
@@ -5000,6 +5022,29 @@ START_TEST(UA_VariantStringArray_json_decode) {
 }
 END_TEST
 
+/* The Body is skipped when looking ahead for the Type and the Dimension */
+START_TEST(UA_VariantNestedBodyFirst_json_decode) {
+    UA_Variant out;
+    UA_Variant_init(&out);
+    UA_ByteString buf = UA_STRING("{\"Body\":[{\"Body\":{\"Name\":\"a\"},\"Type\":20},"
+                                  "{\"Body\":[1,2],\"Type\":6},{\"Type\":0}],"
+                                  "\"Dimension\":[3],\"Type\":24}");
+
+    UA_StatusCode retval = UA_decodeJson(&buf, &out, &UA_TYPES[UA_TYPES_VARIANT], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(out.arrayLength, 3);
+    ck_assert_uint_eq(out.arrayDimensionsSize, 1);
+    ck_assert_uint_eq(out.arrayDimensions[0], 3);
+    UA_Variant *inner = (UA_Variant*)out.data;
+    ck_assert_ptr_eq(inner[0].type, &UA_TYPES[UA_TYPES_QUALIFIEDNAME]);
+    ck_assert_ptr_eq(inner[1].type, &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_uint_eq(inner[1].arrayLength, 2);
+    ck_assert(UA_Variant_isEmpty(&inner[2]));
+    UA_Variant_clear(&out);
+}
+END_TEST
+
 START_TEST(UA_VariantStringArrayNull_json_decode) {
     // given
 
@@ -5474,6 +5519,7 @@ static Suite *testSuite_builtin_json(void) {
     tcase_add_test(tc_json_encode, UA_Boolean_true_bufferTooSmall_json_encode);
 
     tcase_add_test(tc_json_encode, UA_String_json_encode);
+    tcase_add_test(tc_json_encode, UA_String_LongEscape_json_encode);
     tcase_add_test(tc_json_encode, UA_String_Empty_json_encode);
     tcase_add_test(tc_json_encode, UA_String_Null_json_encode);
     tcase_add_test(tc_json_encode, UA_String_escapesimple_json_encode);
@@ -5797,6 +5843,7 @@ static Suite *testSuite_builtin_json(void) {
     tcase_add_test(tc_json_decode, UA_VariantBoolNull_json_decode);
     tcase_add_test(tc_json_decode, UA_VariantNull_json_decode);
     tcase_add_test(tc_json_decode, UA_VariantStringArray_json_decode);
+    tcase_add_test(tc_json_decode, UA_VariantNestedBodyFirst_json_decode);
     tcase_add_test(tc_json_decode, UA_VariantStringArrayNull_json_decode);
     tcase_add_test(tc_json_decode, UA_VariantLocalizedTextArrayNull_json_decode);
     tcase_add_test(tc_json_decode, UA_VariantVariantArrayNull_json_decode);
@@ -1749,6 +1749,22 @@ START_TEST(UA_Double_corrupt_xml_decode) {
 }
 END_TEST
 
+/* The value ends with the given length, even if more digits follow in memory */
+START_TEST(UA_Double_bounded_xml_decode) {
+    UA_Double out;
+    UA_Double_init(&out);
+    UA_ByteString buf = UA_STRING("1.55");
+    buf.length = 3;
+
+    UA_StatusCode retval = UA_decodeXml(&buf, &out, &UA_TYPES[UA_TYPES_DOUBLE], NULL);
+
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(out == 1.5);
+
+    UA_Double_clear(&out);
+}
+END_TEST
+
 START_TEST(UA_Double_one_xml_decode) {
     UA_Double out;
     UA_Double_init(&out);
@@ -2644,6 +2660,7 @@ static Suite *testSuite_builtin_xml(void) {
     tcase_add_test(tc_xml_decode, UA_Double_xml_decode);
     tcase_add_test(tc_xml_decode, UA_Double_one_xml_decode);
     tcase_add_test(tc_xml_decode, UA_Double_corrupt_xml_decode);
+    tcase_add_test(tc_xml_decode, UA_Double_bounded_xml_decode);
     tcase_add_test(tc_xml_decode, UA_Double_onepointsmallest_xml_decode);
     tcase_add_test(tc_xml_decode, UA_Double_nan_xml_decode);
     tcase_add_test(tc_xml_decode, UA_Double_negnan_xml_decode);
@@ -226,6 +226,23 @@ START_TEST(calcSizeBinaryShallBeCorrect) {
 }
 END_TEST
 
+START_TEST(findDataTypeShallReturnTheType) {
+    const UA_DataType *type = &UA_TYPES[_i];
+    ck_assert(UA_findDataType(&type->typeId) == type);
+    if(!UA_NodeId_isNull(&type->binaryEncodingId))
+        ck_assert(UA_findDataTypeByBinary(&type->binaryEncodingId) == type);
+
+    /* Custom types with the same identifier do not shadow the builtin types */
+    UA_DataType custom = *type;
+    UA_DataTypeArray customTypes = {NULL, 1, &custom, false};
+    ck_assert(UA_findDataTypeWithCustom(&type->typeId, &customTypes) == type);
+    UA_NodeId unknown = UA_NODEID_STRING(1, "unknown");
+    ck_assert(UA_findDataTypeWithCustom(&unknown, &customTypes) == NULL);
+    custom.typeId = unknown;
+    ck_assert(UA_findDataTypeWithCustom(&unknown, &customTypes) == &custom);
+}
+END_TEST
+
 int main(void) {
     int number_failed = 0;
     SRunner *sr;
@@ -252,6 +269,10 @@ int main(void) {
     tcase_add_loop_test(tc, calcSizeBinaryShallBeCorrect, UA_TYPES_BOOLEAN, UA_TYPES_COUNT - 1);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("Test findDataType");
+    tcase_add_loop_test(tc, findDataTypeShallReturnTheType, UA_TYPES_BOOLEAN, UA_TYPES_COUNT);
+    suite_add_tcase(s, tc);
+
     sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
     srunner_run_all (sr, CK_NORMAL);
@@ -6,6 +6,7 @@
 #include <open62541/types_generated_handling.h>
 #include "test_helpers.h"
 #include "open62541/util.h"
+#include "../deps/base64.h"
 
 #include <stdlib.h>
 #include <check.h>
@@ -44,6 +45,35 @@ START_TEST(base64) {
     UA_ByteString_clear(&test2out);
 } END_TEST
 
+/* Decoding in-place and direct JSON encoding give the same results */
+START_TEST(base64InPlace) {
+    UA_Byte data[40];
+    for(size_t i = 0; i < 40; i++)
+        data[i] = (UA_Byte)(i * 37 + 11);
+
+    for(size_t len = 1; len <= 40; len++) {
+        UA_ByteString bs = {len, data};
+        UA_String b64;
+        UA_StatusCode res = UA_ByteString_toBase64(&bs, &b64);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(b64.length, 4 * ((len + 2) / 3));
+
+#ifdef UA_ENABLE_JSON_ENCODING
+        UA_ByteString json = UA_BYTESTRING_NULL;
+        res = UA_encodeJson(&bs, &UA_TYPES[UA_TYPES_BYTESTRING], &json, NULL);
+        ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(json.length, b64.length + 2);
+        ck_assert(memcmp(&json.data[1], b64.data, b64.length) == 0);
+        UA_ByteString_clear(&json);
+#endif
+
+        size_t outLen = UA_unbase64_buf(b64.data, b64.length, b64.data);
+        ck_assert_uint_eq(outLen, len);
+        ck_assert(memcmp(b64.data, data, len) == 0);
+        UA_String_clear(&b64);
+    }
+} END_TEST
+
 /* Example taken from Part 6, 5.2.2.6 */
 START_TEST(parseGuid) {
     UA_Guid guid = UA_GUID("72962B91-FA75-4AE6-8D28-B404DC7DAF63");
@@ -116,6 +146,65 @@ START_TEST(parseNodeIdByteString) {
     UA_NodeId_clear(&id);
 } END_TEST
 
+START_TEST(parseNodeIdNumericFail) {
+    UA_NodeId id;
+    UA_StatusCode res = UA_NodeId_parse(&id, UA_STRING("ns=1;i=12a"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+    res = UA_NodeId_parse(&id, UA_STRING("ns=;i=12"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+    res = UA_NodeId_parse(&id, UA_STRING("ns=1i=12"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+    ck_assert_int_eq(id.namespaceIndex, 0);
+} END_TEST
+
+START_TEST(parseNodeIdBuf) {
+    UA_Byte mem[32];
+    UA_ByteString buf = {sizeof(mem), mem};
+
+    UA_NodeId id;
+    UA_StatusCode res = UA_NodeId_parseBuf(&id, UA_STRING("ns=2;i=42"), &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(id.namespaceIndex, 2);
+    ck_assert_int_eq(id.identifier.numeric, 42);
+    ck_assert_uint_eq(buf.length, sizeof(mem));
+
+    res = UA_NodeId_parseBuf(&id, UA_STRING("ns=10;s=Hello:World"), &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String strid = UA_STRING("Hello:World");
+    ck_assert(UA_String_equal(&id.identifier.string, &strid));
+    ck_assert(id.identifier.string.data == mem);
+    ck_assert_uint_eq(buf.length, sizeof(mem) - strid.length);
+
+    UA_NodeId id2;
+    res = UA_NodeId_parseBuf(&id2, UA_STRING("ns=1;b=b3BlbjYyNTQxIQ=="), &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_ByteString bstrid = UA_BYTESTRING("open62541!");
+    ck_assert(UA_ByteString_equal(&id2.identifier.byteString, &bstrid));
+    ck_assert(UA_String_equal(&id.identifier.string, &strid));
+
+    /* The buffer is too small. The remaining buffer is unchanged. */
+    UA_ByteString before = buf;
+    res = UA_NodeId_parseBuf(&id, UA_STRING("s=0123456789012345678901234567890"), &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED);
+    ck_assert(buf.data == before.data && buf.length == before.length);
+    ck_assert(UA_NodeId_isNull(&id));
+} END_TEST
+
+START_TEST(parseExpandedNodeIdBuf) {
+    UA_Byte mem[32];
+    UA_ByteString buf = {sizeof(mem), mem};
+    UA_ExpandedNodeId id;
+    UA_StatusCode res =
+        UA_ExpandedNodeId_parseBuf(&id, UA_STRING("svr=5;nsu=urn:test;s=abc"), &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_String nsu = UA_STRING("urn:test");
+    UA_String strid = UA_STRING("abc");
+    ck_assert(UA_String_equal(&id.namespaceUri, &nsu));
+    ck_assert(UA_String_equal(&id.nodeId.identifier.string, &strid));
+    ck_assert_int_eq(id.serverIndex, 5);
+    ck_assert_uint_eq(buf.length, sizeof(mem) - nsu.length - strid.length);
+} END_TEST
+
 START_TEST(parseExpandedNodeIdInteger) {
     UA_ExpandedNodeId id = UA_EXPANDEDNODEID("ns=1;i=1337");
     ck_assert_int_eq(id.nodeId.identifierType, UA_NODEIDTYPE_NUMERIC);
@@ -360,6 +449,7 @@ int main(void) {
     Suite *s  = suite_create("Test Builtin Type Parsing");
     TCase *tc = tcase_create("test cases");
     tcase_add_test(tc, base64);
+    tcase_add_test(tc, base64InPlace);
     tcase_add_test(tc, parseGuid);
     tcase_add_test(tc, parseNodeIdNumeric);
     tcase_add_test(tc, parseNodeIdNumeric2);
@@ -367,6 +457,9 @@ int main(void) {
     tcase_add_test(tc, parseNodeIdGuid);
     tcase_add_test(tc, parseNodeIdGuidFail);
     tcase_add_test(tc, parseNodeIdByteString);
+    tcase_add_test(tc, parseNodeIdNumericFail);
+    tcase_add_test(tc, parseNodeIdBuf);
+    tcase_add_test(tc, parseExpandedNodeIdBuf);
     tcase_add_test(tc, parseExpandedNodeIdInteger);
     tcase_add_test(tc, parseExpandedNodeIdInteger2);
     tcase_add_test(tc, parseExpandedNodeIdIntegerNSU);
@@ -7,6 +7,7 @@
 
 #include "ua_server_internal.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <check.h>
 
@@ -117,6 +118,86 @@ START_TEST(copyArrayRangeUpperBoundOutOfRange) {
 }
 END_TEST
 
+/* Ranges with several partially covered dimensions. The result is compared
+ * against the element-wise selection. */
+START_TEST(copyMultiDimArrayRange) {
+    UA_UInt32 dims[3] = {4, 5, 6};
+    UA_UInt32 arr[120];
+    UA_String strArr[120];
+    char buf[8];
+    for(size_t i = 0; i < 120; i++) {
+        arr[i] = (UA_UInt32)i;
+        snprintf(buf, sizeof(buf), "%u", (unsigned)i);
+        strArr[i] = UA_STRING_ALLOC(buf);
+    }
+
+    const char *ranges[4] = {"0:1,1:2,0:1", "1:3,0:4,2:5", "0:3,2,0:5", "3,4,5"};
+    for(size_t r = 0; r < 4; r++) {
+        UA_NumericRange nr;
+        UA_StatusCode retval = UA_NumericRange_parse(&nr, UA_STRING((char*)(uintptr_t)ranges[r]));
+        ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+        for(size_t t = 0; t < 2; t++) {
+            UA_Variant v, v2;
+            if(t == 0)
+                UA_Variant_setArray(&v, arr, 120, &UA_TYPES[UA_TYPES_UINT32]);
+            else
+                UA_Variant_setArray(&v, strArr, 120, &UA_TYPES[UA_TYPES_STRING]);
+            v.arrayDimensions = dims;
+            v.arrayDimensionsSize = 3;
+
+            retval = UA_Variant_copyRange(&v, &v2, nr);
+            ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(v2.arrayDimensionsSize, 3);
+
+            size_t n = 0;
+            for(UA_UInt32 i = nr.dimensions[0].min; i <= nr.dimensions[0].max; i++) {
+                for(UA_UInt32 j = nr.dimensions[1].min; j <= nr.dimensions[1].max; j++) {
+                    for(UA_UInt32 k = nr.dimensions[2].min; k <= nr.dimensions[2].max; k++) {
+                        size_t idx = (i * 30) + (j * 6) + k;
+                        if(t == 0)
+                            ck_assert_uint_eq(((UA_UInt32*)v2.data)[n], arr[idx]);
+                        else
+                            ck_assert(UA_String_equal(&((UA_String*)v2.data)[n],
+                                                      &strArr[idx]));
+                        n++;
+                    }
+                }
+            }
+            ck_assert_uint_eq(v2.arrayLength, n);
+
+            /* Write the range back into a zeroed array at the same place */
+            UA_UInt32 target[120];
+            memset(target, 0, sizeof(target));
+            if(t == 0) {
+                UA_Variant tv;
+                UA_Variant_setArray(&tv, target, 120, &UA_TYPES[UA_TYPES_UINT32]);
+                tv.arrayDimensions = dims;
+                tv.arrayDimensionsSize = 3;
+                retval = UA_Variant_setRangeCopy(&tv, v2.data, v2.arrayLength, nr);
+                ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+                n = 0;
+                for(size_t idx = 0; idx < 120; idx++) {
+                    if(target[idx] == 0)
+                        continue;
+                    ck_assert_uint_eq(target[idx], idx);
+                    n++;
+                }
+                ck_assert_uint_eq(n + (nr.dimensions[0].min == 0 &&
+                                       nr.dimensions[1].min == 0 &&
+                                       nr.dimensions[2].min == 0),
+                                  v2.arrayLength);
+            }
+            UA_Variant_clear(&v2);
+        }
+        UA_free(nr.dimensions);
+    }
+
+    for(size_t i = 0; i < 120; i++)
+        UA_String_clear(&strArr[i]);
+}
+END_TEST
+
 int main(void) {
     Suite *s  = suite_create("Test Variant Range Access");
     TCase *tc = tcase_create("test cases");
@@ -125,6 +206,7 @@ int main(void) {
     tcase_add_test(tc, copySimpleArrayRange);
     tcase_add_test(tc, copyIntoStringArrayRange);
     tcase_add_test(tc, copyArrayRangeUpperBoundOutOfRange);
+    tcase_add_test(tc, copyMultiDimArrayRange);
     suite_add_tcase(s, tc);
 
     SRunner *sr = srunner_create(s);
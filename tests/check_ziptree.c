@@ -189,6 +189,89 @@ START_TEST(splitTreeRand) {
     }
 } END_TEST
 
+static int
+compareEntryPtrs(const void *a, const void *b) {
+    const struct treeEntry *aa = *(struct treeEntry * const *)a;
+    const struct treeEntry *bb = *(struct treeEntry * const *)b;
+    if(aa->key != bb->key)
+        return (aa->key < bb->key) ? -1 : 1;
+    if(aa == bb)
+        return 0;
+    return (aa < bb) ? -1 : 1;
+}
+
+static void *
+countRange(void *context, struct treeEntry *e) {
+    (*(size_t*)context)++;
+    return NULL;
+}
+
+START_TEST(buildTree) {
+    struct treeEntry *elms[TEST_ITERATIONS * 5];
+    struct treeEntry *left[TEST_ITERATIONS * 5];
+    struct treeEntry *right[TEST_ITERATIONS * 5];
+    size_t n = TEST_ITERATIONS * 5;
+    for(size_t i = 0; i < n; i++) {
+        elms[i] = (struct treeEntry*)malloc(sizeof(struct treeEntry));
+        elms[i]->key = (unsigned int)rand() % TEST_ITERATIONS; /* Duplicates */
+    }
+    qsort(elms, n, sizeof(struct treeEntry*), compareEntryPtrs);
+
+    /* The tree from one-by-one insertion */
+    struct tree t1 = {NULL};
+    for(size_t i = 0; i < n; i++)
+        ZIP_INSERT(tree, &t1, elms[n - 1 - i]);
+    struct treeEntry *root = t1.root;
+    for(size_t i = 0; i < n; i++) {
+        left[i] = elms[i]->pointers.left;
+        right[i] = elms[i]->pointers.right;
+    }
+
+    /* The bulk-built tree is identical */
+    struct tree t2 = {NULL};
+    ZIP_BUILD(tree, &t2, elms, n);
+    checkTree(&t2);
+    ck_assert_ptr_eq(t2.root, root);
+    for(size_t i = 0; i < n; i++) {
+        ck_assert_ptr_eq(elms[i]->pointers.left, left[i]);
+        ck_assert_ptr_eq(elms[i]->pointers.right, right[i]);
+    }
+
+    /* Iterate without recursion in both directions */
+    size_t pos = 0;
+    for(struct treeEntry *e = ZIP_MIN(tree, &t2); e; e = ZIP_NEXT(tree, &t2, e))
+        ck_assert_ptr_eq(e, elms[pos++]);
+    ck_assert_uint_eq(pos, n);
+    for(struct treeEntry *e = ZIP_MAX(tree, &t2); e; e = ZIP_PREV(tree, &t2, e))
+        ck_assert_ptr_eq(e, elms[--pos]);
+    ck_assert_uint_eq(pos, 0);
+
+    /* Range queries */
+    for(unsigned int min = 0; min < TEST_ITERATIONS + 1; min++) {
+        unsigned int max = min + 5;
+        size_t expected = 0;
+        struct treeEntry *first = NULL;
+        for(size_t i = 0; i < n; i++) {
+            if(elms[i]->key < min || elms[i]->key > max)
+                continue;
+            if(!first)
+                first = elms[i];
+            expected++;
+        }
+        size_t count = 0;
+        ZIP_ITER_RANGE(tree, &t2, &min, &max, countRange, &count);
+        ck_assert_uint_eq(count, expected);
+        struct treeEntry *lower = ZIP_LOWER_BOUND(tree, &t2, &min);
+        if(first)
+            ck_assert_ptr_eq(lower, first);
+        else if(lower)
+            ck_assert_uint_gt(lower->key, max);
+    }
+
+    for(size_t i = 0; i < n; i++)
+        free(elms[i]);
+} END_TEST
+
 int main(void) {
     int number_failed = 0;
     TCase *tc_parse = tcase_create("ziptree");
@@ -196,6 +279,7 @@ int main(void) {
     tcase_add_test(tc_parse, mergeTrees);
     tcase_add_test(tc_parse, splitTree);
     tcase_add_test(tc_parse, splitTreeRand);
+    tcase_add_test(tc_parse, buildTree);
     Suite *s = suite_create("Test ziptree library");
     suite_add_tcase(s, tc_parse);
     SRunner *sr = srunner_create(s);
@@ -127,6 +127,74 @@ START_TEST(Client_connect_username) {
 }
 END_TEST
 
+static void
+connectAndWait(UA_Client *client) {
+    UA_SessionState ss = UA_SESSIONSTATE_CLOSED;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    while(ss != UA_SESSIONSTATE_ACTIVATED) {
+        UA_Client_run_iterate(client, 10);
+        UA_Client_getState(client, NULL, &ss, &retval);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+}
+
+START_TEST(Client_endpointCache) {
+    UA_ClientEndpointCache *cache = UA_ClientEndpointCache_new(1000);
+    ck_assert(cache != NULL);
+
+    /* The first connection runs the discovery */
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_Client_getConfig(client)->endpointCache = cache;
+    UA_StatusCode retval = UA_Client_connectAsync(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(!client->endpointFromCache);
+    connectAndWait(client);
+    ck_assert_uint_eq(UA_ClientEndpointCache_getSize(cache), 1);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* Another client uses the cached Endpoint */
+    client = UA_Client_newForUnitTest();
+    UA_Client_getConfig(client)->endpointCache = cache;
+    retval = UA_Client_connectAsync(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(client->endpointFromCache);
+    connectAndWait(client);
+    ck_assert(!client->endpointFromCache);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* Not used for a different user identity token */
+    client = UA_Client_newForUnitTest();
+    UA_Client_getConfig(client)->endpointCache = cache;
+    UA_ClientConfig_setAuthenticationUsername(UA_Client_getConfig(client),
+                                              "user1", "password");
+    retval = UA_Client_connectAsync(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(!client->endpointFromCache);
+    connectAndWait(client);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    /* The entry expires */
+    UA_fakeSleep(2000);
+    client = UA_Client_newForUnitTest();
+    UA_Client_getConfig(client)->endpointCache = cache;
+    retval = UA_Client_connectAsync(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(!client->endpointFromCache);
+    ck_assert_uint_eq(UA_ClientEndpointCache_getSize(cache), 0);
+    connectAndWait(client);
+    ck_assert_uint_eq(UA_ClientEndpointCache_getSize(cache), 1);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+
+    UA_ClientEndpointCache_remove(cache, UA_STRING("opc.tcp://localhost:4840"));
+    ck_assert_uint_eq(UA_ClientEndpointCache_getSize(cache), 0);
+    UA_ClientEndpointCache_delete(cache);
+}
+END_TEST
+
 START_TEST(Client_endpoints) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_EndpointDescription* endpointArray = NULL;
@@ -142,6 +210,40 @@ START_TEST(Client_endpoints) {
 }
 END_TEST
 
+START_TEST(Client_endpoints_serverCache) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_EndpointDescription *uncached = NULL;
+    size_t uncachedSize = 0;
+    UA_StatusCode retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                                  &uncachedSize, &uncached);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_Server_getConfig(server)->endpointsCacheSize = 4;
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* The first request fills the cache, the second is answered from it, the
+     * third after invalidation. All have the same content. */
+    for(size_t i = 0; i < 3; i++) {
+        if(i == 2)
+            UA_Server_invalidateEndpointsCache(server);
+        UA_EndpointDescription *cached = NULL;
+        size_t cachedSize = 0;
+        retval = UA_Client_getEndpoints(client, "opc.tcp://localhost:4840",
+                                        &cachedSize, &cached);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(cachedSize, uncachedSize);
+        for(size_t j = 0; j < cachedSize; j++)
+            ck_assert(UA_equal(&cached[j], &uncached[j],
+                               &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]));
+        UA_Array_delete(cached, cachedSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    }
+
+    UA_Array_delete(uncached, uncachedSize, &UA_TYPES[UA_TYPES_ENDPOINTDESCRIPTION]);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_endpoints_empty) {
     /* Issue a getEndpoints call with empty endpointUrl.
      * Using UA_Client_getEndpoints automatically passes the client->endpointUrl as requested endpointUrl.
@@ -438,7 +540,9 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_connect_username);
     tcase_add_test(tc_client, Client_delete_without_connect);
     tcase_add_test(tc_client, Client_endpoints);
+    tcase_add_test(tc_client, Client_endpoints_serverCache);
     tcase_add_test(tc_client, Client_endpoints_empty);
+    tcase_add_test(tc_client, Client_endpointCache);
     tcase_add_test(tc_client, Client_read);
     suite_add_tcase(s,tc_client);
     TCase *tc_client_reconnect = tcase_create("Client Reconnect");
@@ -192,6 +192,163 @@ START_TEST(Client_read_async_timed) {
         UA_Client_delete(client);
 } END_TEST
 
+static size_t asyncTimedOut;
+static size_t asyncCancelled;
+
+static void
+asyncCountCallback(UA_Client *client, void *userdata,
+                   UA_UInt32 requestId, const UA_ReadResponse *response) {
+    if(response->responseHeader.serviceResult == UA_STATUSCODE_BADTIMEOUT)
+        asyncTimedOut++;
+    else
+        asyncCancelled++;
+}
+
+/* Only the requests with the short timeout expire while the server is stalled.
+ * The others are cancelled when the client disconnects. */
+START_TEST(Client_read_async_timeout_mixed) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        running = false;
+        THREAD_JOIN(server_thread);
+
+        UA_ReadRequest rr;
+        UA_ReadRequest_init(&rr);
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        rr.nodesToRead = &rvid;
+        rr.nodesToReadSize = 1;
+
+        asyncTimedOut = 0;
+        asyncCancelled = 0;
+        for(size_t i = 0; i < 100; i++) {
+            rr.requestHeader.timeoutHint = (i % 2 == 0) ? 100 : 100000;
+            retval = __UA_Client_AsyncService(client, &rr,
+                    &UA_TYPES[UA_TYPES_READREQUEST],
+                    (UA_ClientAsyncServiceCallback) asyncCountCallback,
+                    &UA_TYPES[UA_TYPES_READRESPONSE], NULL, NULL);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+
+        UA_fakeSleep(1000 + 200);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(asyncTimedOut, 50);
+        ck_assert_uint_eq(asyncCancelled, 0);
+
+        /* Get the server back up */
+        running = true;
+        THREAD_CREATE(server_thread, serverloop);
+
+        UA_Client_disconnect(client);
+        ck_assert_uint_eq(asyncTimedOut, 50);
+        ck_assert_uint_eq(asyncCancelled, 50);
+        UA_Client_delete(client);
+} END_TEST
+
+#define BATCH_READS 100
+#define BATCH_WRITES 10
+static size_t batchReads;
+static size_t batchWrites;
+static UA_UInt32 batchRequestIds[BATCH_READS + BATCH_WRITES];
+static size_t batchRequestIdsSize;
+
+static void
+addBatchRequestId(UA_UInt32 requestId) {
+    for(size_t i = 0; i < batchRequestIdsSize; i++) {
+        if(batchRequestIds[i] == requestId)
+            return;
+    }
+    batchRequestIds[batchRequestIdsSize++] = requestId;
+}
+
+static void
+batchReadCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+                  UA_StatusCode status, UA_DataValue *value) {
+    ck_assert_uint_eq(status, UA_STATUSCODE_GOOD);
+    ck_assert(value && value->hasValue);
+    ck_assert(UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DATETIME]));
+    addBatchRequestId(requestId);
+    batchReads++;
+}
+
+static void
+batchWriteCallback(UA_Client *client, void *userdata, UA_UInt32 requestId,
+                   UA_WriteResponse *wr) {
+    ck_assert_uint_eq(wr->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(wr->resultsSize, 1);
+    ck_assert_uint_eq(wr->results[0], UA_STATUSCODE_BADNODEIDUNKNOWN);
+    addBatchRequestId(requestId);
+    batchWrites++;
+}
+
+/* Single-item reads and writes are coalesced into combined requests */
+START_TEST(Client_async_batching) {
+        UA_Client *client = UA_Client_newForUnitTest();
+        UA_ClientConfig *clientConfig = UA_Client_getConfig(client);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        clientConfig->outStandingPublishRequests = 0;
+#endif
+        clientConfig->asyncBatching = true;
+        clientConfig->asyncBatchingMaxNodesPerRead = 30;
+
+        UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        batchReads = 0;
+        batchWrites = 0;
+        batchRequestIdsSize = 0;
+        UA_UInt32 reqId = 1;
+        for(size_t i = 0; i < BATCH_READS; i++) {
+            retval = UA_Client_readValueAttribute_async(client,
+                UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME),
+                batchReadCallback, NULL, &reqId);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(reqId, 0);
+        }
+
+        UA_Int32 value = 42;
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+        for(size_t i = 0; i < BATCH_WRITES; i++) {
+            retval = UA_Client_writeValueAttribute_async(client,
+                UA_NODEID_NUMERIC(1, (UA_UInt32)(90000 + i)), &v,
+                batchWriteCallback, NULL, NULL);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        }
+
+        for(size_t i = 0; i < 100 && batchReads + batchWrites < BATCH_READS + BATCH_WRITES; i++)
+            retval |= UA_Client_run_iterate(client, 10);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(batchReads, BATCH_READS);
+        ck_assert_uint_eq(batchWrites, BATCH_WRITES);
+
+        /* Three full reads, the remaining reads and one write */
+        ck_assert_uint_eq(batchRequestIdsSize, 5);
+
+        /* Collected operations are cancelled on disconnect */
+        UA_UInt16 asyncCounter = 0;
+        retval = UA_Client_readValueAttribute_async(client,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME),
+            (UA_ClientAsyncReadValueAttributeCallback)asyncReadValueAtttributeCallback,
+            &asyncCounter, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(asyncCounter, 0);
+
+        UA_Client_disconnect(client);
+        ck_assert_uint_eq(asyncCounter, 1);
+        UA_Client_delete(client);
+} END_TEST
+
 static UA_Boolean inactivityCallbackTriggered = false;
 
 static void inactivityCallback(UA_Client *client) {
@@ -237,14 +394,99 @@ START_TEST(Client_connectivity_check) {
         UA_Client_delete(client);
 }END_TEST
 
+typedef struct {
+    size_t references;
+    size_t maxReferences; /* Abort after that many references */
+    UA_Boolean done;
+    UA_StatusCode status;
+} BrowseRecursiveContext;
+
+static UA_Boolean
+browseRecursiveCallback(UA_Client *client, void *userdata,
+                        const UA_NodeId *sourceNodeId,
+                        const UA_ReferenceDescription *rd) {
+    BrowseRecursiveContext *ctx = (BrowseRecursiveContext*)userdata;
+    ctx->references++;
+    return (ctx->maxReferences == 0 || ctx->references < ctx->maxReferences);
+}
+
+static void
+browseRecursiveDoneCallback(UA_Client *client, void *userdata,
+                            UA_StatusCode status) {
+    BrowseRecursiveContext *ctx = (BrowseRecursiveContext*)userdata;
+    ctx->done = true;
+    ctx->status = status;
+}
+
+static void
+browseRecursive(UA_Client *client, size_t nodesPerRequest, size_t inFlight,
+                BrowseRecursiveContext *ctx) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_NONE;
+
+    UA_StatusCode retval =
+        UA_Client_browseRecursive_async(client, &bd, nodesPerRequest, inFlight,
+                                        browseRecursiveCallback,
+                                        browseRecursiveDoneCallback, ctx);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    while(!ctx->done) {
+        retval = UA_Client_run_iterate(client, 10);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+}
+
+START_TEST(Client_browseRecursive_async) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* One node per request */
+    BrowseRecursiveContext single;
+    memset(&single, 0, sizeof(BrowseRecursiveContext));
+    browseRecursive(client, 1, 1, &single);
+    ck_assert_uint_eq(single.status, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(single.references, 10);
+
+    /* Batched and pipelined with continuation points. Every reference is
+     * reported once. */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxReferencesPerNode = 2;
+    BrowseRecursiveContext batched;
+    memset(&batched, 0, sizeof(BrowseRecursiveContext));
+    browseRecursive(client, 8, 4, &batched);
+    config->maxReferencesPerNode = 0;
+    ck_assert_uint_eq(batched.status, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(batched.references, single.references);
+
+    /* Abort from the callback */
+    BrowseRecursiveContext aborted;
+    memset(&aborted, 0, sizeof(BrowseRecursiveContext));
+    aborted.maxReferences = 5;
+    browseRecursive(client, 8, 4, &aborted);
+    ck_assert_uint_eq(aborted.status, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(aborted.references, 5);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 static Suite* testSuite_Client(void) {
     Suite *s = suite_create("Client");
     TCase *tc_client = tcase_create("Client Basic");
     tcase_add_checked_fixture(tc_client, setup, teardown);
     tcase_add_test(tc_client, Client_read_async);
     tcase_add_test(tc_client, Client_read_async_timed);
+    tcase_add_test(tc_client, Client_read_async_timeout_mixed);
     tcase_add_test(tc_client, Client_connectivity_check);
     tcase_add_test(tc_client, Client_highlevel_async_readValue);
+    tcase_add_test(tc_client, Client_async_batching);
+    tcase_add_test(tc_client, Client_browseRecursive_async);
 
     suite_add_tcase(s, tc_client);
     return s;
@@ -0,0 +1,311 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+UA_Client *client;
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+/* The data types are only known to the server */
+
+typedef struct {
+    UA_Float x;
+    UA_Float y;
+    UA_Float z;
+} Point;
+
+typedef struct {
+    UA_Byte color;
+    Point start;
+    Point end;
+} Line;
+
+typedef struct {
+    UA_String description;
+    size_t measurementSize;
+    UA_Float *measurement;
+} Measurements;
+
+typedef struct {
+    UA_Int16 a;
+    UA_Float *b;
+    UA_Float *c;
+} Opt;
+
+typedef struct {
+    UA_UInt32 switchField;
+    union {
+        UA_Double optionA;
+        UA_String optionB;
+    } fields;
+} Uni;
+
+static UA_DataTypeMember Point_members[3] = {
+    {UA_TYPENAME("x") &UA_TYPES[UA_TYPES_FLOAT], 0, false, false},
+    {UA_TYPENAME("y") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Point,y) - offsetof(Point,x) - sizeof(UA_Float), false, false},
+    {UA_TYPENAME("z") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Point,z) - offsetof(Point,y) - sizeof(UA_Float), false, false}
+};
+
+/* The member type of start and end is set in the setup */
+static UA_DataTypeMember Line_members[3] = {
+    {UA_TYPENAME("color") &UA_TYPES[UA_TYPES_BYTE], 0, false, false},
+    {UA_TYPENAME("start") NULL,
+     offsetof(Line,start) - offsetof(Line,color) - sizeof(UA_Byte), false, false},
+    {UA_TYPENAME("end") NULL,
+     offsetof(Line,end) - offsetof(Line,start) - sizeof(Point), false, false}
+};
+
+static UA_DataTypeMember Measurements_members[2] = {
+    {UA_TYPENAME("description") &UA_TYPES[UA_TYPES_STRING], 0, false, false},
+    {UA_TYPENAME("measurement") &UA_TYPES[UA_TYPES_FLOAT], 0, true, false}
+};
+
+static UA_DataTypeMember Opt_members[3] = {
+    {UA_TYPENAME("a") &UA_TYPES[UA_TYPES_INT16], 0, false, false},
+    {UA_TYPENAME("b") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Opt,b) - offsetof(Opt,a) - sizeof(UA_Int16), false, true},
+    {UA_TYPENAME("c") &UA_TYPES[UA_TYPES_FLOAT],
+     offsetof(Opt,c) - offsetof(Opt,b) - sizeof(void *), false, true}
+};
+
+static UA_DataTypeMember Uni_members[2] = {
+    {UA_TYPENAME("optionA") &UA_TYPES[UA_TYPES_DOUBLE],
+     offsetof(Uni, fields.optionA), false, false},
+    {UA_TYPENAME("optionB") &UA_TYPES[UA_TYPES_STRING],
+     offsetof(Uni, fields.optionB), false, false}
+};
+
+#define POINT 0
+#define LINE 1
+#define MEASUREMENTS 2
+#define OPT 3
+#define UNI 4
+#define SERVERTYPES 5
+
+static UA_DataType serverTypes[SERVERTYPES] = {
+    {UA_TYPENAME("Point") {1, UA_NODEIDTYPE_NUMERIC, {4242}},
+     {1, UA_NODEIDTYPE_NUMERIC, {1}}, sizeof(Point),
+     UA_DATATYPEKIND_STRUCTURE, true, false, 3, Point_members},
+    {UA_TYPENAME("Line") {1, UA_NODEIDTYPE_NUMERIC, {4343}},
+     {1, UA_NODEIDTYPE_NUMERIC, {2}}, sizeof(Line),
+     UA_DATATYPEKIND_STRUCTURE, true, false, 3, Line_members},
+    {UA_TYPENAME("Measurements") {1, UA_NODEIDTYPE_NUMERIC, {4443}},
+     {1, UA_NODEIDTYPE_NUMERIC, {3}}, sizeof(Measurements),
+     UA_DATATYPEKIND_STRUCTURE, false, false, 2, Measurements_members},
+    {UA_TYPENAME("Opt") {1, UA_NODEIDTYPE_NUMERIC, {4644}},
+     {1, UA_NODEIDTYPE_NUMERIC, {4}}, sizeof(Opt),
+     UA_DATATYPEKIND_OPTSTRUCT, false, false, 3, Opt_members},
+    {UA_TYPENAME("Uni") {1, UA_NODEIDTYPE_NUMERIC, {4845}},
+     {1, UA_NODEIDTYPE_NUMERIC, {5}}, sizeof(Uni),
+     UA_DATATYPEKIND_UNION, false, false, 2, Uni_members}
+};
+
+static UA_DataTypeArray serverCustomTypes = {NULL, SERVERTYPES, serverTypes, false};
+
+static const UA_NodeId lineVariableId = {1, UA_NODEIDTYPE_NUMERIC, {5000}};
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    Line_members[1].memberType = &serverTypes[POINT];
+    Line_members[2].memberType = &serverTypes[POINT];
+
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->customDataTypes = &serverCustomTypes;
+
+    for(size_t i = 0; i < SERVERTYPES; i++) {
+        UA_DataTypeAttributes attr = UA_DataTypeAttributes_default;
+        attr.displayName = UA_LOCALIZEDTEXT("", (char*)(uintptr_t)serverTypes[i].typeName);
+        UA_StatusCode res =
+            UA_Server_addDataTypeNode(server, serverTypes[i].typeId,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_STRUCTURE),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                      UA_QUALIFIEDNAME(1, (char*)(uintptr_t)
+                                                       serverTypes[i].typeName),
+                                      attr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    Line line = {7, {1.0f, 2.0f, 3.0f}, {4.0f, 5.0f, 6.0f}};
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    vattr.dataType = serverTypes[LINE].typeId;
+    vattr.valueRank = UA_VALUERANK_SCALAR;
+    UA_Variant_setScalar(&vattr.value, &line, &serverTypes[LINE]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, lineVariableId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "Line"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+
+    client = UA_Client_newForUnitTest();
+    res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_getConfig(server)->customDataTypes = NULL;
+    UA_Server_delete(server);
+}
+
+/* The generated description has the same layout as the compiled struct */
+static void
+checkType(const UA_DataType *type, const UA_DataType *expected) {
+    ck_assert(type != NULL);
+    ck_assert(UA_NodeId_equal(&type->binaryEncodingId, &expected->binaryEncodingId));
+    ck_assert_uint_eq(type->typeKind, expected->typeKind);
+    ck_assert_uint_eq(type->memSize, expected->memSize);
+    ck_assert_uint_eq(type->pointerFree, expected->pointerFree);
+    ck_assert_uint_eq(type->membersSize, expected->membersSize);
+    for(size_t i = 0; i < type->membersSize; i++) {
+        ck_assert_uint_eq(type->members[i].padding, expected->members[i].padding);
+        ck_assert_uint_eq(type->members[i].isArray, expected->members[i].isArray);
+        ck_assert_uint_eq(type->members[i].isOptional, expected->members[i].isOptional);
+        ck_assert(UA_NodeId_equal(&type->members[i].memberType->typeId,
+                                  &expected->members[i].memberType->typeId));
+    }
+}
+
+START_TEST(Client_loadDataTypes) {
+    ck_assert(UA_Client_findDataType(client, &serverTypes[LINE].typeId) == NULL);
+
+    /* Reading the value without the type leaves the ExtensionObject encoded */
+    UA_Variant val;
+    UA_StatusCode res = UA_Client_readValueAttribute(client, lineVariableId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(val.type == &UA_TYPES[UA_TYPES_EXTENSIONOBJECT]);
+    UA_Variant_clear(&val);
+
+    /* Loading the Line also loads the Point */
+    res = UA_Client_loadDataTypes(client, 1, &serverTypes[LINE].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    const UA_DataType *lineType =
+        UA_Client_findDataType(client, &serverTypes[LINE].typeId);
+    checkType(lineType, &serverTypes[LINE]);
+    checkType(UA_Client_findDataType(client, &serverTypes[POINT].typeId),
+              &serverTypes[POINT]);
+    ck_assert(UA_Client_findDataType(client, &serverTypes[UNI].typeId) == NULL);
+
+    /* The value is decoded with the loaded type */
+    res = UA_Client_readValueAttribute(client, lineVariableId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(val.type == lineType);
+    Line *line = (Line*)val.data;
+    ck_assert_uint_eq(line->color, 7);
+    ck_assert(line->start.y == 2.0f);
+    ck_assert(line->end.z == 6.0f);
+    UA_Variant_clear(&val);
+
+    /* Loading again is a no-op */
+    res = UA_Client_loadDataTypes(client, 1, &serverTypes[LINE].typeId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Client_findDataType(client, &serverTypes[LINE].typeId) == lineType);
+} END_TEST
+
+START_TEST(Client_loadAllDataTypes) {
+    UA_StatusCode res = UA_Client_loadDataTypes(client, 0, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < SERVERTYPES; i++)
+        checkType(UA_Client_findDataType(client, &serverTypes[i].typeId),
+                  &serverTypes[i]);
+
+    /* Encode with the loaded type and decode with the server type */
+    const UA_DataType *uniType = UA_Client_findDataType(client, &serverTypes[UNI].typeId);
+    Uni uni;
+    memset(&uni, 0, sizeof(Uni));
+    uni.switchField = 2;
+    uni.fields.optionB = UA_STRING("union");
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    res = UA_encodeBinary(&uni, uniType, &buf);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    Uni uni2;
+    res = UA_decodeBinary(&buf, &uni2, &serverTypes[UNI], NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(uni2.switchField, 2);
+    ck_assert(UA_String_equal(&uni2.fields.optionB, &uni.fields.optionB));
+    UA_clear(&uni2, &serverTypes[UNI]);
+    UA_ByteString_clear(&buf);
+} END_TEST
+
+START_TEST(Client_loadUnknownDataType) {
+    UA_NodeId unknown = UA_NODEID_NUMERIC(1, 99999);
+    UA_StatusCode res = UA_Client_loadDataTypes(client, 1, &unknown);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Client_findDataType(client, &unknown) == NULL);
+} END_TEST
+
+START_TEST(DataTypeIndex_find) {
+    UA_DataTypeIndex *index = UA_DataTypeIndex_new(&serverCustomTypes);
+    ck_assert(index != NULL);
+    for(size_t i = 0; i < SERVERTYPES; i++) {
+        ck_assert(UA_DataTypeIndex_find(index, &serverTypes[i].typeId) ==
+                  &serverTypes[i]);
+        ck_assert(UA_DataTypeIndex_findBinary(index, &serverTypes[i].binaryEncodingId) ==
+                  &serverTypes[i]);
+    }
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        ck_assert(UA_DataTypeIndex_find(index, &UA_TYPES[i].typeId) == &UA_TYPES[i]);
+        if(!UA_NodeId_isNull(&UA_TYPES[i].binaryEncodingId))
+            ck_assert(UA_DataTypeIndex_findBinary(index, &UA_TYPES[i].binaryEncodingId) ==
+                      &UA_TYPES[i]);
+    }
+    UA_NodeId unknown = UA_NODEID_NUMERIC(1, 99999);
+    ck_assert(UA_DataTypeIndex_find(index, &unknown) == NULL);
+    ck_assert(UA_DataTypeIndex_findBinary(index, &unknown) == NULL);
+    UA_DataTypeIndex_delete(index);
+} END_TEST
+
+static Suite* testSuite_Client_DataTypes(void) {
+    Suite *s = suite_create("Client DataTypes");
+    TCase *tc_load = tcase_create("Client Load DataTypes");
+    tcase_add_checked_fixture(tc_load, setup, teardown);
+    tcase_add_test(tc_load, Client_loadDataTypes);
+    tcase_add_test(tc_load, Client_loadAllDataTypes);
+    tcase_add_test(tc_load, Client_loadUnknownDataType);
+    suite_add_tcase(s, tc_load);
+    TCase *tc_index = tcase_create("DataType Index");
+    tcase_add_test(tc_index, DataTypeIndex_find);
+    suite_add_tcase(s, tc_index);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_Client_DataTypes();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
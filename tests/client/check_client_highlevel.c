@@ -316,6 +316,99 @@ START_TEST(Node_Browse) {
 }
 END_TEST
 
+START_TEST(Node_BrowseManyChunks) {
+    /* The BrowseResults are streamed into a response of many chunks */
+    size_t nodes = 500;
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    bReq.nodesToBrowse = (UA_BrowseDescription*)
+        UA_Array_new(nodes, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+    bReq.nodesToBrowseSize = nodes;
+    for(size_t i = 0; i < nodes; i++) {
+        bReq.nodesToBrowse[i].nodeId = UA_NODEID_NUMERIC(0, (i % 2 == 0) ?
+                                                         UA_NS0ID_SERVER :
+                                                         UA_NS0ID_OBJECTSFOLDER);
+        bReq.nodesToBrowse[i].resultMask = UA_BROWSERESULTMASK_ALL;
+    }
+    bReq.nodesToBrowse[nodes - 1].nodeId = UA_NODEID_NUMERIC(1, 123456);
+
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.resultsSize, nodes);
+    for(size_t i = 0; i < nodes - 1; i++) {
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bReq.nodesToBrowse[i]);
+        ck_assert(UA_equal(&br, &bResp.results[i], &UA_TYPES[UA_TYPES_BROWSERESULT]));
+        UA_BrowseResult_clear(&br);
+    }
+    ck_assert_uint_eq(bResp.results[nodes - 1].statusCode,
+                      UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_BrowseResponse_clear(&bResp);
+
+    /* Errors before the results are streamed lead to a ServiceFault */
+    UA_NodeId_clear(&bReq.view.viewId);
+    bReq.view.viewId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADVIEWIDUNKNOWN);
+    ck_assert_uint_eq(bResp.resultsSize, 0);
+    UA_BrowseResponse_clear(&bResp);
+
+    UA_BrowseRequest_clear(&bReq);
+} END_TEST
+
+START_TEST(Node_BrowseSliced) {
+    /* The bulk request is processed in slices of 7 operations */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->bulkRequestSliceSize = 7;
+    config->bulkRequestTimeSlice = 0.0;
+
+    size_t nodes = 100;
+    UA_BrowseRequest bReq;
+    UA_BrowseRequest_init(&bReq);
+    bReq.nodesToBrowse = (UA_BrowseDescription*)
+        UA_Array_new(nodes, &UA_TYPES[UA_TYPES_BROWSEDESCRIPTION]);
+    bReq.nodesToBrowseSize = nodes;
+    for(size_t i = 0; i < nodes; i++) {
+        bReq.nodesToBrowse[i].nodeId = UA_NODEID_NUMERIC(0, (i % 2 == 0) ?
+                                                         UA_NS0ID_SERVER :
+                                                         UA_NS0ID_OBJECTSFOLDER);
+        bReq.nodesToBrowse[i].resultMask = UA_BROWSERESULTMASK_ALL;
+    }
+    bReq.nodesToBrowse[nodes - 1].nodeId = UA_NODEID_NUMERIC(1, 123456);
+
+    UA_BrowseResponse bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bResp.resultsSize, nodes);
+    for(size_t i = 0; i < nodes - 1; i++) {
+        UA_BrowseResult br = UA_Server_browse(server, 0, &bReq.nodesToBrowse[i]);
+        ck_assert(UA_equal(&br, &bResp.results[i], &UA_TYPES[UA_TYPES_BROWSERESULT]));
+        UA_BrowseResult_clear(&br);
+    }
+    ck_assert_uint_eq(bResp.results[nodes - 1].statusCode,
+                      UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_BrowseResponse_clear(&bResp);
+
+    /* Errors in the first slice lead to a ServiceFault */
+    bReq.view.viewId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADVIEWIDUNKNOWN);
+    UA_BrowseResponse_clear(&bResp);
+
+    /* The operations limit applies to the entire request, not to the slices */
+    UA_NodeId_init(&bReq.view.viewId);
+    UA_UInt32 maxNodesPerBrowse = config->maxNodesPerBrowse;
+    config->maxNodesPerBrowse = 50;
+    bResp = UA_Client_Service_browse(client, bReq);
+    ck_assert_uint_eq(bResp.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADTOOMANYOPERATIONS);
+    ck_assert_uint_eq(bResp.resultsSize, 0);
+    UA_BrowseResponse_clear(&bResp);
+    config->maxNodesPerBrowse = maxNodesPerBrowse;
+
+    UA_BrowseRequest_clear(&bReq);
+} END_TEST
+
 START_TEST(Node_Register) {
     UA_RegisterNodesRequest req;
     UA_RegisterNodesRequest_init(&req);
@@ -822,6 +915,63 @@ START_TEST(Node_ReadWrite_Value) {
 }
 END_TEST
 
+START_TEST(Node_ReadWrite_Prepared) {
+    /* Add a variable to poll */
+    UA_Int32 value = 42;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "prepared");
+    UA_StatusCode retval =
+        UA_Client_addVariableNode(client, nodeId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "prepared"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ReadValueId rvi[2];
+    UA_ReadValueId_init(&rvi[0]);
+    rvi[0].nodeId = nodeId;
+    rvi[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadValueId_init(&rvi[1]);
+    rvi[1].nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_NAMESPACEARRAY);
+    rvi[1].attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 2;
+
+    UA_PreparedRead *pr = NULL;
+    retval = UA_Client_prepareRead(client, &request, &pr);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    for(UA_Int32 i = 0; i < 10; i++) {
+        const UA_ReadResponse *resp = UA_Client_readPrepared(client, pr);
+        ck_assert_uint_eq(resp->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(resp->resultsSize, 2);
+        ck_assert(resp->results[0].hasValue);
+        ck_assert(UA_Variant_hasScalarType(&resp->results[0].value,
+                                           &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(*(UA_Int32*)resp->results[0].value.data, 42 + i);
+        ck_assert(UA_Variant_hasArrayType(&resp->results[1].value,
+                                          &UA_TYPES[UA_TYPES_STRING]));
+        ck_assert_uint_eq(resp->results[1].value.arrayLength, 3);
+
+        /* Change the value between the polls */
+        value = 43 + i;
+        UA_Variant v;
+        UA_Variant_setScalar(&v, &value, &UA_TYPES[UA_TYPES_INT32]);
+        retval = UA_Client_writeValueAttribute(client, nodeId, &v);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    UA_PreparedRead_delete(pr);
+}
+END_TEST
+
 START_TEST(Node_ReadWrite_DataType) {
     UA_NodeId dataType;
 
@@ -1034,6 +1184,135 @@ END_TEST
 
 #endif
 
+static UA_String
+readCachedDisplayName(const UA_NodeId nodeId) {
+    UA_LocalizedText lt;
+    UA_StatusCode retval = UA_Client_readDisplayNameAttribute(client, nodeId, &lt);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_String text = lt.text;
+    UA_String_init(&lt.text);
+    UA_LocalizedText_clear(&lt);
+    return text;
+}
+
+START_TEST(NodeCache_ReadBrowse) {
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "A");
+    attr.writeMask = UA_WRITEMASK_DISPLAYNAME;
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(1, 62541);
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, nodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Cached"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_getConfig(client)->nodeCacheSize = 10;
+
+    /* Cached and not updated by changes on the server */
+    UA_String text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &attr.displayName.text));
+    UA_String_clear(&text);
+    UA_LocalizedText dn = UA_LOCALIZEDTEXT("en-US", "B");
+    retval = UA_Server_writeDisplayName(server, nodeId, dn);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &attr.displayName.text));
+    UA_String_clear(&text);
+
+    /* Invalidate explicitly */
+    UA_Client_NodeCache_invalidate(client, nodeId);
+    text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &dn.text));
+    UA_String_clear(&text);
+
+    /* Writing from the client invalidates the node */
+    UA_LocalizedText dn2 = UA_LOCALIZEDTEXT("en-US", "C");
+    retval = UA_Client_writeDisplayNameAttribute(client, nodeId, &dn2);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &dn2.text));
+    UA_String_clear(&text);
+
+    /* Browse results are cached */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseRequest breq;
+    UA_BrowseRequest_init(&breq);
+    breq.nodesToBrowse = &bd;
+    breq.nodesToBrowseSize = 1;
+    UA_BrowseResponse bresp = UA_Client_Service_browse(client, breq);
+    ck_assert_uint_eq(bresp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bresp.resultsSize, 1);
+    size_t refs = bresp.results[0].referencesSize;
+    UA_BrowseResponse_clear(&bresp);
+    retval = UA_Server_addReference(server, nodeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_SERVER), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    bresp = UA_Client_Service_browse(client, breq);
+    ck_assert_uint_eq(bresp.resultsSize, 1);
+    ck_assert_uint_eq(bresp.results[0].referencesSize, refs);
+    UA_BrowseResponse_clear(&bresp);
+
+    /* An unknown model change clears the cache */
+    UA_Variant changes;
+    UA_Variant_init(&changes);
+    UA_Client_NodeCache_processModelChange(client, &changes);
+    bresp = UA_Client_Service_browse(client, breq);
+    ck_assert_uint_eq(bresp.resultsSize, 1);
+    ck_assert_uint_eq(bresp.results[0].referencesSize, refs + 1);
+    UA_BrowseResponse_clear(&bresp);
+} END_TEST
+
+START_TEST(NodeCache_SaveLoad) {
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_Client_getConfig(client)->nodeCacheSize = 10;
+    UA_String objects = UA_STRING("Objects");
+    UA_String text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &objects));
+    UA_String_clear(&text);
+
+    UA_ByteString saved;
+    UA_StatusCode retval = UA_Client_NodeCache_save(client, &saved);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Client_NodeCache_clear(client);
+
+    UA_LocalizedText dn = UA_LOCALIZEDTEXT("", "Changed");
+    retval = UA_Server_writeDisplayName(server, nodeId, dn);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The loaded entries are used for the same NamespaceArray. Also in a new
+     * Session. */
+    retval = UA_Client_NodeCache_load(client, &saved);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Client_disconnect(client);
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &objects));
+    UA_String_clear(&text);
+
+    /* A changed NamespaceArray clears the cache */
+    ck_assert_uint_eq(3, UA_Server_addNamespace(server, "http://open62541.org/ns/cache"));
+    UA_Client_disconnect(client);
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    text = readCachedDisplayName(nodeId);
+    ck_assert(UA_String_equal(&text, &dn.text));
+    UA_String_clear(&text);
+
+    /* Invalid data is rejected */
+    saved.length /= 2;
+    retval = UA_Client_NodeCache_load(client, &saved);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+    UA_ByteString_clear(&saved);
+} END_TEST
+
 static Suite *testSuite_Client(void) {
     Suite *s = suite_create("Client Highlevel");
     TCase *tc_misc = tcase_create("Client Highlevel Misc");
@@ -1042,12 +1321,20 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_misc, Misc_NamespaceGetIndex);
     suite_add_tcase(s, tc_misc);
 
+    TCase *tc_cache = tcase_create("Client Highlevel Node Cache");
+    tcase_add_checked_fixture(tc_cache, setup, teardown);
+    tcase_add_test(tc_cache, NodeCache_ReadBrowse);
+    tcase_add_test(tc_cache, NodeCache_SaveLoad);
+    suite_add_tcase(s, tc_cache);
+
     TCase *tc_nodes = tcase_create("Client Highlevel Node Management");
     tcase_add_checked_fixture(tc_nodes, setup, teardown);
 #ifdef UA_ENABLE_NODEMANAGEMENT
     tcase_add_test(tc_nodes, Node_Add);
 #endif
     tcase_add_test(tc_nodes, Node_Browse);
+    tcase_add_test(tc_nodes, Node_BrowseManyChunks);
+    tcase_add_test(tc_nodes, Node_BrowseSliced);
     tcase_add_test(tc_nodes, Node_Register);
     suite_add_tcase(s, tc_nodes);
 
@@ -1070,6 +1357,7 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_readwrite, Node_ReadWrite_ContainsNoLoops);
     tcase_add_test(tc_readwrite, Node_ReadWrite_EventNotifier);
     tcase_add_test(tc_readwrite, Node_ReadWrite_Value);
+    tcase_add_test(tc_readwrite, Node_ReadWrite_Prepared);
     tcase_add_test(tc_readwrite, Node_ReadWrite_DataType);
     tcase_add_test(tc_readwrite, Node_ReadWrite_ValueRank);
     tcase_add_test(tc_readwrite, Node_ReadWrite_ArrayDimensions);
@@ -239,6 +239,69 @@ START_TEST(Client_HistorizingReadRawAll) {
 }
 END_TEST
 
+/* Reads the same node several times in a batch. The second read stops after
+ * the first page. */
+#define BATCH_NODES 5
+static const UA_NodeId *batchNodeIds;
+static size_t batchReceived[BATCH_NODES];
+static UA_Boolean batchOrdered;
+
+static UA_Boolean
+receiveBatchCallback(UA_Client *clt, const UA_NodeId *nodeId,
+                     UA_Boolean moreDataAvailable, const UA_ExtensionObject *_data,
+                     void *callbackContext) {
+    size_t node = (size_t)(nodeId - batchNodeIds);
+    ck_assert_uint_lt(node, BATCH_NODES);
+    UA_HistoryData *data = (UA_HistoryData*)_data->content.decoded.data;
+    for(size_t i = 0; i < data->dataValuesSize; ++i) {
+        if(data->dataValues[i].sourceTimestamp != testData[batchReceived[node] + i])
+            batchOrdered = false;
+    }
+    batchReceived[node] += data->dataValuesSize;
+    return node != 1;
+}
+
+START_TEST(Client_HistorizingReadRawBatch) {
+    UA_NodeId nodeIds[BATCH_NODES];
+    for(size_t i = 0; i < BATCH_NODES; i++)
+        nodeIds[i] = outNodeId;
+    nodeIds[3] = UA_NODEID_STRING(1, "unknown");
+    batchNodeIds = nodeIds;
+    memset(batchReceived, 0, sizeof(batchReceived));
+    batchOrdered = true;
+
+    UA_StatusCode results[BATCH_NODES];
+    UA_StatusCode ret =
+        UA_Client_HistoryRead_rawBatch(client, BATCH_NODES, nodeIds,
+                                       receiveBatchCallback, TESTDATA_START_TIME,
+                                       TESTDATA_STOP_TIME, UA_STRING_NULL, false, 3,
+                                       UA_TIMESTAMPSTORETURN_BOTH, 2, 2, results, NULL);
+    ck_assert_uint_eq(ret, results[3]);
+    ck_assert(batchOrdered);
+    for(size_t i = 0; i < BATCH_NODES; i++) {
+        if(i == 3) {
+            ck_assert(!UA_StatusCode_isEqualTop(results[i], UA_STATUSCODE_GOOD));
+            ck_assert_uint_eq(batchReceived[i], 0);
+        } else if(i == 1) {
+            ck_assert_uint_eq(results[i], UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(batchReceived[i], 3);
+        } else {
+            ck_assert_uint_eq(results[i], UA_STATUSCODE_GOOD);
+            ck_assert_uint_eq(batchReceived[i], testDataSize);
+        }
+    }
+
+    /* The released continuation points do not prevent further reads */
+    ret = UA_Client_HistoryRead_rawBatch(client, 1, &outNodeId, receiveCallback,
+                                         TESTDATA_START_TIME, TESTDATA_STOP_TIME,
+                                         UA_STRING_NULL, false, 100,
+                                         UA_TIMESTAMPSTORETURN_BOTH, 0, 0, NULL, NULL);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert_uint_eq(testDataSize, receivedTestDataPos);
+    ck_assert(checkTestData(false, testData, receivedTestData, testDataSize));
+}
+END_TEST
+
 START_TEST(Client_HistorizingReadRawOne) {
     UA_StatusCode ret = UA_Client_HistoryRead_raw(client,
                                                   &outNodeId,
@@ -621,6 +684,7 @@ testSuite_Client(void) {
     tcase_add_checked_fixture(tc_client, setup, teardown);
     tcase_add_test(tc_client, Client_HistorizingReadRawAll);
     tcase_add_test(tc_client, Client_HistorizingReadRawOne);
+    tcase_add_test(tc_client, Client_HistorizingReadRawBatch);
     tcase_add_test(tc_client, Client_HistorizingReadRawTwo);
     tcase_add_test(tc_client, Client_HistorizingReadRawAllInv);
     tcase_add_test(tc_client, Client_HistorizingReadRawOneInv);
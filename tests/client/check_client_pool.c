@@ -0,0 +1,177 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/client_pool.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "client/ua_client_internal.h"
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
+
+#define POOL_SIZE 3
+#define READS 30
+
+UA_Server *server;
+UA_Boolean running;
+THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_ClientPool *
+newPool(void) {
+    UA_ClientConfig config;
+    memset(&config, 0, sizeof(UA_ClientConfig));
+    UA_ClientConfig_setDefault(&config);
+    config.eventLoop->dateTime_now = UA_DateTime_now_fake;
+    config.eventLoop->dateTime_nowMonotonic = UA_DateTime_now_fake;
+    config.tcpReuseAddr = true;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    config.outStandingPublishRequests = 0;
+#endif
+    UA_ClientPool *pool = UA_ClientPool_new(&config, POOL_SIZE);
+    ck_assert(pool != NULL);
+    return pool;
+}
+
+static void
+readCallback(UA_Client *client, void *userdata,
+             UA_UInt32 requestId, UA_ReadResponse *response) {
+    size_t *counter = (size_t*)userdata;
+    if(response->responseHeader.serviceResult == UA_STATUSCODE_GOOD &&
+       response->resultsSize == 1 && response->results[0].hasValue)
+        (*counter)++;
+}
+
+START_TEST(ClientPool_connect) {
+    UA_ClientPool *pool = newPool();
+    ck_assert_uint_eq(UA_ClientPool_getSize(pool), POOL_SIZE);
+
+    /* Not connected */
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == NULL);
+
+    UA_StatusCode res = UA_ClientPool_connect(pool, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Every client has its own SecureChannel and Session */
+    UA_Client *c0 = UA_ClientPool_getClient(pool, 0);
+    UA_Client *c1 = UA_ClientPool_getClient(pool, 1);
+    UA_Client *c2 = UA_ClientPool_getClient(pool, 2);
+    ck_assert(c0 != c1 && c1 != c2 && c0 != c2);
+    ck_assert(UA_ClientPool_getClient(pool, POOL_SIZE) == NULL);
+
+    /* The clients share the plugins */
+    ck_assert(UA_Client_getConfig(c0)->eventLoop == UA_Client_getConfig(c1)->eventLoop);
+    ck_assert(UA_Client_getConfig(c0)->securityPolicies ==
+              UA_Client_getConfig(c2)->securityPolicies);
+
+    /* Round-robin */
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c0);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c1);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c2);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c0);
+
+    /* A disconnected client is skipped */
+    UA_Client_disconnect(c1);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c2);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_ROUNDROBIN) == c0);
+
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+START_TEST(ClientPool_leastLoaded) {
+    UA_ClientPool *pool = newPool();
+    UA_StatusCode res = UA_ClientPool_connect(pool, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The pending calls are distributed evenly */
+    size_t counter = 0;
+    for(size_t i = 0; i < READS; i++) {
+        UA_Client *client = UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_LEASTLOADED);
+        ck_assert(client != NULL);
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        UA_ReadRequest rr;
+        UA_ReadRequest_init(&rr);
+        rr.nodesToRead = &rvid;
+        rr.nodesToReadSize = 1;
+        res = UA_Client_sendAsyncReadRequest(client, &rr, readCallback, &counter, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < POOL_SIZE; i++) {
+        UA_Client *client = UA_ClientPool_getClient(pool, i);
+        ck_assert_uint_eq(client->asyncServiceCallsSize, READS / POOL_SIZE);
+    }
+
+    while(counter < READS) {
+        res = UA_ClientPool_run_iterate(pool, 10);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    for(size_t i = 0; i < POOL_SIZE; i++) {
+        UA_Client *client = UA_ClientPool_getClient(pool, i);
+        ck_assert_uint_eq(client->asyncServiceCallsSize, 0);
+    }
+
+    UA_ClientPool_disconnect(pool);
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+START_TEST(ClientPool_connectFail) {
+    UA_ClientPool *pool = newPool();
+    UA_StatusCode res = UA_ClientPool_connect(pool, "opc.tcp://localhost:4841");
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ClientPool_next(pool, UA_CLIENTPOOLSTRATEGY_LEASTLOADED) == NULL);
+    UA_ClientPool_delete(pool);
+} END_TEST
+
+static Suite* testSuite_ClientPool(void) {
+    Suite *s = suite_create("Client Pool");
+    TCase *tc_pool = tcase_create("Client Pool");
+    tcase_add_checked_fixture(tc_pool, setup, teardown);
+    tcase_add_test(tc_pool, ClientPool_connect);
+    tcase_add_test(tc_pool, ClientPool_leastLoaded);
+    tcase_add_test(tc_pool, ClientPool_connectFail);
+    suite_add_tcase(s, tc_pool);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_ClientPool();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
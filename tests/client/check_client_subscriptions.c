@@ -1317,6 +1317,172 @@ subscriptionInactivityCallback (UA_Client *client, UA_UInt32 subId, void *subCon
     inactivityCallbackCalled = true;
 }
 
+static size_t batchCalls;
+static size_t batchDataChanges;
+
+static void
+dataChangeBatchHandler(UA_Client *client, UA_UInt32 subId, void *subContext,
+                       size_t dataChangesSize, const UA_Client_DataChange *dataChanges) {
+    batchCalls++;
+    for(size_t i = 0; i < dataChangesSize; i++) {
+        ck_assert(dataChanges[i].value->hasValue);
+        batchDataChanges++;
+    }
+}
+
+START_TEST(Client_subscription_batchCallback) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_Client_getConfig(client)->publishResponseArena = true;
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    retval = UA_Client_Subscriptions_setDataChangeBatchCallback(client, 99999,
+                                                                dataChangeBatchHandler);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADSUBSCRIPTIONIDINVALID);
+    retval = UA_Client_Subscriptions_setDataChangeBatchCallback(client, subId,
+                                                                dataChangeBatchHandler);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest monRequest = UA_MonitoredItemCreateRequest_default(
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE));
+    UA_UInt32 monIds[5];
+    for(size_t i = 0; i < 5; i++) {
+        UA_MonitoredItemCreateResult monResponse =
+            UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monRequest, NULL,
+                                                      dataChangeHandler, NULL);
+        ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+        monIds[i] = monResponse.monitoredItemId;
+    }
+
+    /* The clientHandle of a deleted MonitoredItem is reused */
+    ck_assert_uint_eq(client->monitoredItemHandles, 5);
+    retval = UA_Client_MonitoredItems_deleteSingle(client, subId, monIds[2]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(client->freeHandlesSize, 1);
+    UA_MonitoredItemCreateResult monResponse =
+        UA_Client_MonitoredItems_createDataChange(client, subId, UA_TIMESTAMPSTORETURN_BOTH,
+                                                  monRequest, NULL, dataChangeHandler, NULL);
+    ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(client->freeHandlesSize, 0);
+    ck_assert_uint_eq(client->monitoredItemHandles, 5);
+    ck_assert_uint_ge(client->monitoredItemsByHandleSize, 6);
+    for(UA_UInt32 h = 1; h <= 5; h++)
+        ck_assert(client->monitoredItemsByHandle[h] != NULL);
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* All notifications in one call. The individual callbacks are not used. */
+    batchCalls = 0;
+    batchDataChanges = 0;
+    notificationReceived = false;
+    UA_Server_run_iterate(server, true);
+    UA_Client_run_iterate(client, 1);
+    UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+    UA_Server_run_iterate(server, true);
+    retval = UA_Client_run_iterate(client, 1);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(batchCalls, 1);
+    ck_assert_uint_eq(batchDataChanges, 5);
+    ck_assert_uint_eq(notificationReceived, false);
+
+    /* The decoded response was released, the memory is kept */
+    ck_assert(client->publishArena.blocks != NULL);
+    ck_assert(!client->publishArenaInUse);
+    ck_assert(client->dataChanges != NULL);
+    ck_assert_uint_ge(client->dataChangesSize, 5);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+START_TEST(Client_subscription_adaptivePublishWindow) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    cc->outStandingPublishRequests = 1;
+    cc->maxOutStandingPublishRequests = 4;
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* One notification per PublishResponse */
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    request.requestedMaxKeepAliveCount = 1;
+    request.maxNotificationsPerPublish = 1;
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest monRequest = UA_MonitoredItemCreateRequest_default(
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE));
+    monRequest.requestedParameters.samplingInterval = 99999999.0;
+    for(size_t i = 0; i < 8; i++) {
+        UA_MonitoredItemCreateResult monResponse =
+            UA_Client_MonitoredItems_createDataChange(client, response.subscriptionId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monRequest, NULL,
+                                                      dataChangeHandler, NULL);
+        ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+    }
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* The server has a backlog. More PublishRequests are sent. */
+    countNotificationReceived = 0;
+    UA_UInt16 maxOutstanding = 0;
+    UA_UInt16 maxWindow = 0;
+    for(size_t i = 0; i < 20 && countNotificationReceived < 8; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_Client_run_iterate(client, 1);
+        if(client->currentlyOutStandingPublishRequests > maxOutstanding)
+            maxOutstanding = client->currentlyOutStandingPublishRequests;
+        if(client->publishWindow > maxWindow)
+            maxWindow = client->publishWindow;
+    }
+    ck_assert_uint_eq(countNotificationReceived, 8);
+    ck_assert_uint_gt(maxOutstanding, 1);
+    ck_assert_uint_le(maxOutstanding, 4);
+
+    /* Keep-alive messages shrink the window. The fake clock advances by one
+     * publishing interval during every round-trip. Which requires three
+     * PublishRequests in flight. */
+    for(size_t i = 0; i < 10; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 1);
+        UA_Client_run_iterate(client, 1);
+    }
+    ck_assert_uint_eq(maxWindow, 4);
+    ck_assert_uint_eq(client->publishWindow, 3);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_subscription_async_sub) {
     UA_Client *client = UA_Client_newForUnitTest();
 
@@ -1528,6 +1694,226 @@ START_TEST(Client_subscription_server_disappears) {
 }
 END_TEST
 
+/* Subscriptions that monitor the same value share the sample. The shared value
+ * is released when the client acknowledges the notifications. */
+START_TEST(Client_subscription_sharedSample) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_UInt32 subIds[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_CreateSubscriptionResponse response =
+            UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+        ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        subIds[i] = response.subscriptionId;
+
+        UA_MonitoredItemCreateRequest monRequest =
+            UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_BUILDINFO));
+        UA_MonitoredItemCreateResult monResponse =
+            UA_Client_MonitoredItems_createDataChange(client, subIds[i],
+                                                      UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monRequest, NULL, dataChangeHandler, NULL);
+        ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+    }
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    countNotificationReceived = 0;
+    for(size_t i = 0; i < 5 && countNotificationReceived < 2; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(countNotificationReceived, 2);
+
+    /* Acknowledge the notifications */
+    for(size_t i = 0; i < 3; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(countNotificationReceived, 2);
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subIds[0]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Client_Subscriptions_deleteSingle(client, subIds[1]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+static UA_RepublishResponse
+republish(UA_Client *client, const UA_RepublishRequest *request) {
+    UA_RepublishResponse response;
+    __UA_Client_Service(client, request, &UA_TYPES[UA_TYPES_REPUBLISHREQUEST],
+                        &response, &UA_TYPES[UA_TYPES_REPUBLISHRESPONSE]);
+    return response;
+}
+
+START_TEST(Client_subscription_republish) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    UA_MonitoredItemCreateRequest monRequest =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_BUILDINFO));
+    UA_MonitoredItemCreateResult monResponse =
+        UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH,
+                                                  monRequest, NULL, dataChangeHandler, NULL);
+    ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+
+    /* Don't send new PublishRequests. So the notification is not acked. */
+    UA_Client_getConfig(client)->outStandingPublishRequests = 0;
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    countNotificationReceived = 0;
+    for(size_t i = 0; i < 5 && countNotificationReceived < 1; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(countNotificationReceived, 1);
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    /* The message is resent from the retransmission queue */
+    UA_RepublishRequest rpRequest;
+    UA_RepublishRequest_init(&rpRequest);
+    rpRequest.subscriptionId = subId;
+    rpRequest.retransmitSequenceNumber = 1;
+    UA_RepublishResponse rpResponse = republish(client, &rpRequest);
+    ck_assert_uint_eq(rpResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(rpResponse.notificationMessage.sequenceNumber, 1);
+    ck_assert_uint_eq(rpResponse.notificationMessage.notificationDataSize, 1);
+    UA_RepublishResponse_clear(&rpResponse);
+
+    /* The message is still available */
+    rpResponse = republish(client, &rpRequest);
+    ck_assert_uint_eq(rpResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(rpResponse.notificationMessage.sequenceNumber, 1);
+    UA_RepublishResponse_clear(&rpResponse);
+
+    /* Unknown sequence number */
+    rpRequest.retransmitSequenceNumber = 100;
+    rpResponse = republish(client, &rpRequest);
+    ck_assert_uint_eq(rpResponse.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADMESSAGENOTAVAILABLE);
+    UA_RepublishResponse_clear(&rpResponse);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+static UA_DateTime recordedTimes[16];
+static size_t recordedTimesSize;
+
+static void
+recordTimeHandler(UA_Client *client, UA_UInt32 subId, void *subContext,
+                  UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    ck_assert(UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DATETIME]));
+    if(recordedTimesSize < 16)
+        recordedTimes[recordedTimesSize++] = *(UA_DateTime*)value->value.data;
+}
+
+START_TEST(Client_subscription_republishGap) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, request, NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UInt32 subId = response.subscriptionId;
+
+    UA_MonitoredItemCreateRequest monRequest =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+    UA_MonitoredItemCreateResult monResponse =
+        UA_Client_MonitoredItems_createDataChange(client, subId,
+                                                  UA_TIMESTAMPSTORETURN_BOTH,
+                                                  monRequest, NULL, recordTimeHandler, NULL);
+    ck_assert_uint_eq(monResponse.statusCode, UA_STATUSCODE_GOOD);
+
+    /* Don't send new PublishRequests. So the notifications are not acked. The
+     * server still holds the PublishRequests that were sent before. */
+    UA_Client_getConfig(client)->outStandingPublishRequests = 0;
+
+    /* manually control the server thread */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    recordedTimesSize = 0;
+    for(size_t i = 0; i < 10 && recordedTimesSize < 2; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(recordedTimesSize, 2);
+
+    /* Pretend the second NotificationMessage got lost */
+    UA_Client_Subscription *sub = LIST_FIRST(&client->subscriptions);
+    ck_assert(sub != NULL);
+    ck_assert_uint_eq(sub->sequenceNumber, 2);
+    sub->sequenceNumber = 1;
+    recordedTimesSize = 1;
+
+    /* The third message shows the gap. The second message is republished and
+     * processed before the third. */
+    for(size_t i = 0; i < 10 && recordedTimesSize < 3; i++) {
+        UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+        UA_Server_run_iterate(server, true);
+        retval = UA_Client_run_iterate(client, 1);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_ge(recordedTimesSize, 3);
+    for(size_t i = 1; i < recordedTimesSize; i++)
+        ck_assert(recordedTimes[i-1] < recordedTimes[i]);
+    ck_assert_uint_eq(sub->sequenceNumber, recordedTimesSize);
+    ck_assert_uint_eq(sub->republishNext, 0);
+    ck_assert(SIMPLEQ_EMPTY(&sub->heldMessages));
+
+    /* run the server in an independent thread again */
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    retval = UA_Client_Subscriptions_deleteSingle(client, subId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
 START_TEST(Client_subscription_transfer) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -1665,7 +2051,12 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client, Client_subscription_createDataChanges_async);
     tcase_add_test(tc_client, Client_subscription_keepAlive);
     tcase_add_test(tc_client, Client_subscription_priority);
+    tcase_add_test(tc_client, Client_subscription_sharedSample);
+    tcase_add_test(tc_client, Client_subscription_republish);
+    tcase_add_test(tc_client, Client_subscription_republishGap);
     tcase_add_test(tc_client, Client_subscription_without_notification);
+    tcase_add_test(tc_client, Client_subscription_adaptivePublishWindow);
+    tcase_add_test(tc_client, Client_subscription_batchCallback);
     tcase_add_test(tc_client, Client_subscription_async_sub);
     tcase_add_test(tc_client, Client_subscription_reconnect);
     tcase_add_test(tc_client, Client_subscription_server_disappears);
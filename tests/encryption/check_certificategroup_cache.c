@@ -0,0 +1,155 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/certificategroup_default.h>
+#include <open62541/plugin/create_certificate.h>
+#include <open62541/plugin/log_stdout.h>
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static UA_ByteString certA;
+static UA_ByteString certB;
+
+static void
+createCertificate(const char *cn, UA_ByteString *cert) {
+    UA_String subject[2] = {UA_STRING_STATIC("O=SampleOrganization"),
+                            UA_STRING((char*)(uintptr_t)cn)};
+    UA_String subjectAltName[2] = {
+        UA_STRING_STATIC("DNS:localhost"),
+        UA_STRING_STATIC("URI:urn:open62541.unconfigured.application")
+    };
+    UA_KeyValueMap *kvm = UA_KeyValueMap_new();
+    UA_UInt16 expiresIn = 14;
+    UA_KeyValueMap_setScalar(kvm, UA_QUALIFIEDNAME(0, "expires-in-days"),
+                             (void *)&expiresIn, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_UInt16 keyLength = 2048;
+    UA_KeyValueMap_setScalar(kvm, UA_QUALIFIEDNAME(0, "key-size-bits"),
+                             (void *)&keyLength, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_ByteString privateKey = UA_BYTESTRING_NULL;
+    UA_StatusCode res =
+        UA_CreateCertificate(UA_Log_Stdout, subject, 2, subjectAltName, 2,
+                             UA_CERTIFICATEFORMAT_DER, kvm, &privateKey, cert);
+    UA_KeyValueMap_delete(kvm);
+    UA_ByteString_clear(&privateKey);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setup(void) {
+    createCertificate("CN=CacheTestA@localhost", &certA);
+    createCertificate("CN=CacheTestB@localhost", &certB);
+}
+
+static void teardown(void) {
+    UA_ByteString_clear(&certA);
+    UA_ByteString_clear(&certB);
+}
+
+/* Cached results are returned for repeated verifications */
+START_TEST(verifyTrustlistRepeated) {
+    UA_CertificateGroup certGroup;
+    memset(&certGroup, 0, sizeof(UA_CertificateGroup));
+    certGroup.logging = UA_Log_Stdout;
+    UA_StatusCode res =
+        UA_CertificateVerification_Trustlist(&certGroup, &certA, 1,
+                                             NULL, 0, NULL, 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 3; i++) {
+        res = certGroup.verifyCertificate(&certGroup, &certA);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = certGroup.verifyCertificate(&certGroup, &certB);
+        ck_assert_uint_eq(res, UA_STATUSCODE_BADCERTIFICATEUNTRUSTED);
+    }
+
+    certGroup.clear(&certGroup);
+} END_TEST
+
+#if defined(__linux__) && !defined(UA_ENABLE_CERT_REJECTED_DIR)
+
+static void
+writeFile(const char *path, const UA_ByteString *data) {
+    FILE *fp = fopen(path, "wb");
+    ck_assert(fp != NULL);
+    ck_assert_uint_eq(fwrite(data->data, 1, data->length, fp), data->length);
+    fclose(fp);
+}
+
+/* Changing the trust list folder invalidates the cached results */
+START_TEST(verifyFolderChange) {
+    char base[] = "/tmp/open62541_certcacheXXXXXX";
+    ck_assert(mkdtemp(base) != NULL);
+    char trusted[64], issuer[64], revoked[64], fileA[96], fileB[96];
+    snprintf(trusted, sizeof(trusted), "%s/trusted", base);
+    snprintf(issuer, sizeof(issuer), "%s/issuer", base);
+    snprintf(revoked, sizeof(revoked), "%s/revoked", base);
+    snprintf(fileA, sizeof(fileA), "%s/a.der", trusted);
+    snprintf(fileB, sizeof(fileB), "%s/b.der", trusted);
+    ck_assert_int_eq(mkdir(trusted, 0700), 0);
+    ck_assert_int_eq(mkdir(issuer, 0700), 0);
+    ck_assert_int_eq(mkdir(revoked, 0700), 0);
+    writeFile(fileA, &certA);
+
+    UA_CertificateGroup certGroup;
+    memset(&certGroup, 0, sizeof(UA_CertificateGroup));
+    certGroup.logging = UA_Log_Stdout;
+    UA_StatusCode res =
+        UA_CertificateVerification_CertFolders(&certGroup, trusted, issuer, revoked);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    res = certGroup.verifyCertificate(&certGroup, &certB);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADCERTIFICATEUNTRUSTED);
+    res = certGroup.verifyCertificate(&certGroup, &certB);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADCERTIFICATEUNTRUSTED);
+
+    /* Trust B */
+    writeFile(fileB, &certB);
+    res = certGroup.verifyCertificate(&certGroup, &certB);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = certGroup.verifyCertificate(&certGroup, &certA);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Remove B from the trust list again */
+    ck_assert_int_eq(unlink(fileB), 0);
+    res = certGroup.verifyCertificate(&certGroup, &certB);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADCERTIFICATEUNTRUSTED);
+
+    certGroup.clear(&certGroup);
+
+    unlink(fileA);
+    rmdir(trusted);
+    rmdir(issuer);
+    rmdir(revoked);
+    rmdir(base);
+} END_TEST
+
+#endif
+
+static Suite* testSuite_certificateGroupCache(void) {
+    Suite *s = suite_create("CertificateGroup Cache");
+    TCase *tc_cache = tcase_create("Verification Cache");
+    tcase_add_checked_fixture(tc_cache, setup, teardown);
+    tcase_add_test(tc_cache, verifyTrustlistRepeated);
+#if defined(__linux__) && !defined(UA_ENABLE_CERT_REJECTED_DIR)
+    tcase_add_test(tc_cache, verifyFolderChange);
+#endif
+    suite_add_tcase(s, tc_cache);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_certificateGroupCache();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -262,6 +262,145 @@ START_TEST(encryption_connect_pem) {
 }
 END_TEST
 
+/* The symmetric keys change with every renewal of the SecureChannel */
+START_TEST(encryption_renew) {
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    ck_assert(client != NULL);
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateVerification_AcceptAll(&cc->certificateVerification);
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_UInt32 channelId = client->channel.securityToken.channelId;
+    UA_UInt32 tokenId = client->channel.securityToken.tokenId;
+
+    UA_Variant val;
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    for(size_t i = 0; i < 3; i++) {
+        /* Renew the channel. Then read with the new keys. */
+        UA_fakeSleep((UA_UInt32)(client->channel.securityToken.revisedLifetime * 0.8));
+        for(size_t j = 0; j < 3; j++) {
+            retval = UA_Client_readValueAttribute(client, nodeId, &val);
+            ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+            UA_Variant_clear(&val);
+        }
+    }
+
+    /* Still on the same channel with a new token */
+    ck_assert_uint_eq(channelId, client->channel.securityToken.channelId);
+    ck_assert_uint_ne(tokenId, client->channel.securityToken.tokenId);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+END_TEST
+
+/* Decrypt and verify a symmetric chunk in one pass. The chunk spans several
+ * slices of the plugin. */
+START_TEST(encryption_decryptAndVerify) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_String uri =
+        UA_STRING("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+    UA_SecurityPolicy *sp = NULL;
+    for(size_t i = 0; i < config->securityPoliciesSize; i++) {
+        if(UA_String_equal(&config->securityPolicies[i].policyUri, &uri))
+            sp = &config->securityPolicies[i];
+    }
+    ck_assert(sp != NULL);
+    const UA_SecurityPolicyCryptoModule *cm = &sp->symmetricModule.cryptoModule;
+    if(!cm->decryptAndVerify)
+        return; /* Not implemented by the crypto backend */
+
+    void *ctx = NULL;
+    UA_StatusCode retval =
+        sp->channelModule.newContext(sp, &sp->localCertificate, &ctx);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Use the same keys in both directions */
+    UA_Byte signingKey[32], encryptingKey[32], iv[16];
+    for(size_t i = 0; i < 32; i++) {
+        signingKey[i] = (UA_Byte)i;
+        encryptingKey[i] = (UA_Byte)(3 * i);
+    }
+    for(size_t i = 0; i < 16; i++)
+        iv[i] = (UA_Byte)(7 * i);
+    UA_ByteString sk = {32, signingKey};
+    UA_ByteString ek = {32, encryptingKey};
+    UA_ByteString ivs = {16, iv};
+    retval |= sp->channelModule.setLocalSymSigningKey(ctx, &sk);
+    retval |= sp->channelModule.setLocalSymEncryptingKey(ctx, &ek);
+    retval |= sp->channelModule.setLocalSymIv(ctx, &ivs);
+    retval |= sp->channelModule.setRemoteSymSigningKey(ctx, &sk);
+    retval |= sp->channelModule.setRemoteSymEncryptingKey(ctx, &ek);
+    retval |= sp->channelModule.setRemoteSymIv(ctx, &ivs);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Sign and encrypt a chunk with a 16 byte header */
+    const size_t offset = 16;
+    const size_t length = offset + 5008;
+    size_t sigSize = cm->signatureAlgorithm.getLocalSignatureSize(ctx);
+    UA_ByteString plain, chunk;
+    retval |= UA_ByteString_allocBuffer(&plain, length);
+    retval |= UA_ByteString_allocBuffer(&chunk, length);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < length; i++)
+        plain.data[i] = (UA_Byte)(i * 31);
+    UA_ByteString content = {length - sigSize, plain.data};
+    UA_ByteString sig = {sigSize, plain.data + length - sigSize};
+    retval = cm->signatureAlgorithm.sign(ctx, &content, &sig);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    memcpy(chunk.data, plain.data, length);
+    UA_ByteString cipher = {length - offset, chunk.data + offset};
+    retval = cm->encryptionAlgorithm.encrypt(ctx, &cipher);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_ByteString encrypted;
+    retval = UA_ByteString_copy(&chunk, &encrypted);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Decrypted in place with the same length */
+    retval = cm->decryptAndVerify(ctx, &chunk, offset);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(chunk.length, length);
+    ck_assert(memcmp(chunk.data, plain.data, length) == 0);
+
+    /* Modified ciphertext */
+    memcpy(chunk.data, encrypted.data, length);
+    chunk.data[offset + 2500] ^= 0x01;
+    retval = cm->decryptAndVerify(ctx, &chunk, offset);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+
+    /* Modified unencrypted header */
+    memcpy(chunk.data, encrypted.data, length);
+    chunk.data[3] ^= 0x01;
+    retval = cm->decryptAndVerify(ctx, &chunk, offset);
+    ck_assert_uint_ne(retval, UA_STATUSCODE_GOOD);
+
+    /* The context works for the next chunk */
+    memcpy(chunk.data, encrypted.data, length);
+    retval = cm->decryptAndVerify(ctx, &chunk, offset);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_ByteString_clear(&encrypted);
+    UA_ByteString_clear(&chunk);
+    UA_ByteString_clear(&plain);
+    sp->channelModule.deleteContext(ctx);
+}
+END_TEST
+
 static Suite* testSuite_encryption(void) {
     Suite *s = suite_create("Encryption");
     TCase *tc_encryption = tcase_create("Encryption basic256sha256");
@@ -269,6 +408,8 @@ static Suite* testSuite_encryption(void) {
 #ifdef UA_ENABLE_ENCRYPTION
     tcase_add_test(tc_encryption, encryption_connect);
     tcase_add_test(tc_encryption, encryption_connect_pem);
+    tcase_add_test(tc_encryption, encryption_renew);
+    tcase_add_test(tc_encryption, encryption_decryptAndVerify);
 #endif /* UA_ENABLE_ENCRYPTION */
     suite_add_tcase(s,tc_encryption);
     return s;
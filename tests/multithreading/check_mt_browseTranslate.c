@@ -0,0 +1,268 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_NETWORK_LOOPS 3
+#define NUMBER_OF_CLIENTS 12
+#define ITERATIONS_PER_CLIENT 20
+
+/* Browse, BrowseNext and TranslateBrowsePathsToNodeIds from clients on
+ * different network EventLoops. With a Nodestore that supports concurrent
+ * reads, they run in parallel on the shared side of the service lock and
+ * fill the Browse and Translate caches at the same time. */
+
+UA_EventLoop *networkLoops[NUMBER_OF_NETWORK_LOOPS];
+THREAD_HANDLE networkThreads[NUMBER_OF_NETWORK_LOOPS];
+UA_Boolean networkRunning;
+
+/* Computed before the clients start */
+size_t objectsFolderRefs;
+
+/* Memory limit for the ContinuationPoints of all Sessions */
+UA_UInt32 cpMemoryLimit;
+
+THREAD_CALLBACK_PARAM(networkLoop, val) {
+    UA_EventLoop *el = *(UA_EventLoop**)val;
+    while(networkRunning)
+        el->run(el, 100);
+    return 0;
+}
+
+static size_t
+countLocalReferences(const UA_NodeId nodeId) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = nodeId;
+    bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseResult br = UA_Server_browse(tc.server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    size_t count = br.referencesSize;
+    UA_BrowseResult_clear(&br);
+    return count;
+}
+
+static void setup(void) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    config->browseCacheSize = 64;
+    config->translateBrowsePathCacheSize = 64;
+    config->maxBrowseContinuationPointsMemory = cpMemoryLimit;
+    objectsFolderRefs =
+        countLocalReferences(UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER));
+
+    /* Each network EventLoop gets its own TCP ConnectionManager */
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        networkLoops[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        UA_ConnectionManager *tcpCM =
+            UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcp connection manager"));
+        networkLoops[i]->registerEventSource(networkLoops[i],
+                                             (UA_EventSource *)tcpCM);
+    }
+    config->networkEventLoops = networkLoops;
+    config->networkEventLoopsSize = NUMBER_OF_NETWORK_LOOPS;
+
+    UA_StatusCode res = UA_Server_run_startup(tc.server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    networkRunning = true;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++)
+        THREAD_CREATE_PARAM(networkThreads[i], networkLoop, networkLoops[i]);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+/* Room for only a few ContinuationPoints. The Browse requests of the clients
+ * evict the ContinuationPoints of each other while they are in use. */
+static void setupCPLimit(void) {
+    cpMemoryLimit = 1024;
+    setup();
+}
+
+static void teardownNetwork(void) {
+    teardown();
+    networkRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        THREAD_JOIN(networkThreads[i]);
+        UA_EventLoop *el = networkLoops[i];
+        el->stop(el);
+        while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+            el->run(el, 100);
+        el->free(el);
+    }
+}
+
+/* Complete Browse (cached) */
+static void
+browseObjectsFolder(UA_Client *client) {
+    UA_BrowseRequest req;
+    UA_BrowseRequest_init(&req);
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.browseDirection = UA_BROWSEDIRECTION_BOTH;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    req.nodesToBrowse = &bd;
+    req.nodesToBrowseSize = 1;
+    UA_BrowseResponse resp = UA_Client_Service_browse(client, req);
+    ck_assert_uint_eq(resp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.resultsSize, 1);
+    ck_assert_uint_eq(resp.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.results[0].referencesSize, objectsFolderRefs);
+    UA_BrowseResponse_clear(&resp);
+}
+
+/* Browse with a ContinuationPoint and walk it with BrowseNext. With a memory
+ * limit, the ContinuationPoint can be evicted by the other clients. */
+static void
+browseServerObjectPaged(UA_Client *client) {
+    UA_BrowseRequest req;
+    UA_BrowseRequest_init(&req);
+    req.requestedMaxReferencesPerNode = 2;
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    req.nodesToBrowse = &bd;
+    req.nodesToBrowseSize = 1;
+    UA_BrowseResponse resp = UA_Client_Service_browse(client, req);
+    ck_assert_uint_eq(resp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.resultsSize, 1);
+    ck_assert_uint_eq(resp.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.results[0].referencesSize, 2);
+
+    UA_ByteString cp = resp.results[0].continuationPoint;
+    UA_ByteString_init(&resp.results[0].continuationPoint);
+    UA_BrowseResponse_clear(&resp);
+    while(cp.length > 0) {
+        UA_BrowseNextRequest nextReq;
+        UA_BrowseNextRequest_init(&nextReq);
+        nextReq.continuationPoints = &cp;
+        nextReq.continuationPointsSize = 1;
+        UA_BrowseNextResponse nextResp = UA_Client_Service_browseNext(client, nextReq);
+        UA_ByteString_clear(&cp);
+        ck_assert_uint_eq(nextResp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(nextResp.resultsSize, 1);
+        if(cpMemoryLimit > 0 && nextResp.results[0].statusCode ==
+           UA_STATUSCODE_BADCONTINUATIONPOINTINVALID) {
+            UA_BrowseNextResponse_clear(&nextResp);
+            break;
+        }
+        ck_assert_uint_eq(nextResp.results[0].statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_le(nextResp.results[0].referencesSize, 2);
+        cp = nextResp.results[0].continuationPoint;
+        UA_ByteString_init(&nextResp.results[0].continuationPoint);
+        UA_BrowseNextResponse_clear(&nextResp);
+    }
+}
+
+/* Objects/Server/ServerStatus (cached) */
+static void
+translateServerStatus(UA_Client *client) {
+    UA_RelativePathElement elems[2];
+    for(size_t i = 0; i < 2; i++) {
+        UA_RelativePathElement_init(&elems[i]);
+        elems[i].referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+        elems[i].includeSubtypes = true;
+    }
+    elems[0].targetName = UA_QUALIFIEDNAME(0, "Server");
+    elems[1].targetName = UA_QUALIFIEDNAME(0, "ServerStatus");
+
+    UA_BrowsePath bp;
+    UA_BrowsePath_init(&bp);
+    bp.startingNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bp.relativePath.elements = elems;
+    bp.relativePath.elementsSize = 2;
+
+    UA_TranslateBrowsePathsToNodeIdsRequest req;
+    UA_TranslateBrowsePathsToNodeIdsRequest_init(&req);
+    req.browsePaths = &bp;
+    req.browsePathsSize = 1;
+    UA_TranslateBrowsePathsToNodeIdsResponse resp =
+        UA_Client_Service_translateBrowsePathsToNodeIds(client, req);
+    ck_assert_uint_eq(resp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.resultsSize, 1);
+    ck_assert_uint_eq(resp.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(resp.results[0].targetsSize, 1);
+    UA_NodeId expected = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS);
+    ck_assert(UA_NodeId_equal(&resp.results[0].targets[0].targetId.nodeId,
+                              &expected));
+    UA_TranslateBrowsePathsToNodeIdsResponse_clear(&resp);
+}
+
+static void
+client_browseTranslate(void *value) {
+    ThreadContext tmp = (*(ThreadContext *) value);
+    UA_Client *client = tc.clients[tmp.index];
+    browseObjectsFolder(client);
+    browseServerObjectPaged(client);
+    translateServerStatus(client);
+}
+
+static void
+initTest(void) {
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        setThreadContext(&tc.clientContext[i], i, ITERATIONS_PER_CLIENT,
+                         client_browseTranslate);
+}
+
+static void
+checkServiceLock(void) {
+    UA_ServerStatistics stat = UA_Server_getStatistics(tc.server);
+    if(UA_Server_getConfig(tc.server)->nodestore.concurrentReads) {
+        ck_assert_uint_ge(stat.sls.sharedCount,
+                          NUMBER_OF_CLIENTS * ITERATIONS_PER_CLIENT);
+    } else {
+        ck_assert_uint_eq(stat.sls.sharedCount, 0);
+    }
+}
+
+START_TEST(browseTranslateOnNetworkEventLoops) {
+    startMultithreading();
+} END_TEST
+
+START_TEST(evictContinuationPoints) {
+    startMultithreading();
+} END_TEST
+
+static Suite* testSuite_browseTranslate(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_browse = tcase_create("Browse and Translate");
+    tcase_add_checked_fixture(tc_browse, setup, teardownNetwork);
+    tcase_add_test(tc_browse, browseTranslateOnNetworkEventLoops);
+    suite_add_tcase(s, tc_browse);
+
+    TCase *tc_evict = tcase_create("Evict ContinuationPoints");
+    tcase_add_checked_fixture(tc_evict, setupCPLimit, teardownNetwork);
+    tcase_add_test(tc_evict, evictContinuationPoints);
+    suite_add_tcase(s, tc_evict);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_browseTranslate();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(0, NUMBER_OF_CLIENTS, checkServiceLock);
+    initTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,175 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/plugin/accesscontrol_default.h>
+#include <open62541/plugin/certificategroup_default.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include <stdlib.h>
+
+#include "../encryption/certificates.h"
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_NETWORK_LOOPS 3
+#define NUMBER_OF_CLIENTS 6
+#define SESSIONS_PER_CLIENT 10
+
+/* Encrypted Sessions are created and activated concurrently on the network
+ * EventLoops. The asymmetric crypto of OPN, CreateSession and ActivateSession
+ * (client signature and the encrypted password) runs under the shared side of
+ * the service lock. Run with the ThreadSanitizer to find races. */
+
+static UA_UsernamePasswordLogin usernamePasswords[1] = {
+    {UA_STRING_STATIC("user1"), UA_STRING_STATIC("password")}};
+
+UA_EventLoop *networkLoops[NUMBER_OF_NETWORK_LOOPS];
+THREAD_HANDLE networkThreads[NUMBER_OF_NETWORK_LOOPS];
+UA_Boolean networkRunning;
+volatile UA_UInt32 activatedSessions;
+
+THREAD_CALLBACK_PARAM(networkLoop, val) {
+    UA_EventLoop *el = *(UA_EventLoop**)val;
+    while(networkRunning)
+        el->run(el, 100);
+    return 0;
+}
+
+static void setup(void) {
+    tc.running = true;
+
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+    tc.server = UA_Server_newForUnitTestWithSecurityPolicies(4840, &certificate, &privateKey,
+                                                             NULL, 0, NULL, 0, NULL, 0);
+    ck_assert(tc.server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    UA_CertificateVerification_AcceptAll(&config->secureChannelPKI);
+    UA_CertificateVerification_AcceptAll(&config->sessionPKI);
+    UA_AccessControl_default(config, false, NULL, 1, usernamePasswords);
+    UA_String_clear(&config->applicationDescription.applicationUri);
+    config->applicationDescription.applicationUri =
+        UA_STRING_ALLOC("urn:unconfigured:application");
+
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        networkLoops[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        UA_ConnectionManager *tcpCM =
+            UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcp connection manager"));
+        networkLoops[i]->registerEventSource(networkLoops[i],
+                                             (UA_EventSource *)tcpCM);
+    }
+    config->networkEventLoops = networkLoops;
+    config->networkEventLoopsSize = NUMBER_OF_NETWORK_LOOPS;
+
+    UA_StatusCode res = UA_Server_run_startup(tc.server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    networkRunning = true;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++)
+        THREAD_CREATE_PARAM(networkThreads[i], networkLoop, networkLoops[i]);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardownNetwork(void) {
+    teardown();
+    networkRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        THREAD_JOIN(networkThreads[i]);
+        UA_EventLoop *el = networkLoops[i];
+        el->stop(el);
+        while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+            el->run(el, 100);
+        el->free(el);
+    }
+}
+
+/* Connect with SignAndEncrypt and an encrypted password */
+static void
+client_activateSession(void *value) {
+    (void)value;
+    UA_ByteString certificate;
+    certificate.length = CERT_DER_LENGTH;
+    certificate.data = CERT_DER_DATA;
+    UA_ByteString privateKey;
+    privateKey.length = KEY_DER_LENGTH;
+    privateKey.data = KEY_DER_DATA;
+
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefaultEncryption(cc, certificate, privateKey,
+                                         NULL, 0, NULL, 0);
+    cc->certificateVerification.clear(&cc->certificateVerification);
+    UA_CertificateVerification_AcceptAll(&cc->certificateVerification);
+    cc->securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    cc->securityPolicyUri =
+        UA_STRING_ALLOC("http://opcfoundation.org/UA/SecurityPolicy#Basic256Sha256");
+
+    UA_StatusCode res =
+        UA_Client_connectUsername(client, "opc.tcp://localhost:4840",
+                                  "user1", "password");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_atomic_addUInt32(&activatedSessions, 1);
+
+    UA_Variant val;
+    UA_Variant_init(&val);
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_STATE);
+    res = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+static void
+initTest(void) {
+    for(size_t i = 0; i < tc.numberOfWorkers; i++)
+        setThreadContext(&tc.workerContext[i], i, SESSIONS_PER_CLIENT,
+                         client_activateSession);
+}
+
+static void
+checkSessions(void) {
+    ck_assert_uint_eq(activatedSessions, NUMBER_OF_CLIENTS * SESSIONS_PER_CLIENT);
+    UA_ServerStatistics stat = UA_Server_getStatistics(tc.server);
+    ck_assert_uint_ge(stat.ss.cumulatedSessionCount, activatedSessions);
+    ck_assert_uint_eq(stat.ss.securityRejectedSessionCount, 0);
+}
+
+START_TEST(activateEncryptedSessions) {
+    startMultithreading();
+} END_TEST
+
+static Suite* testSuite_encryptedSessions(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_network = tcase_create("Encrypted Sessions on network EventLoops");
+    tcase_set_timeout(tc_network, 60);
+    tcase_add_checked_fixture(tc_network, setup, teardownNetwork);
+    tcase_add_test(tc_network, activateEncryptedSessions);
+    suite_add_tcase(s, tc_network);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_encryptedSessions();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(NUMBER_OF_CLIENTS, 0, checkSessions);
+    initTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_async.h>
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_wrapper.h"
+
+#define NUMBER_OF_THREADS 4
+#define MESSAGES_PER_THREAD 5000
+
+static char path[] = "/tmp/check_mt_logAsyncXXXXXX";
+static int fd;
+static UA_Logger *logger;
+
+static void
+openLog(size_t capacity) {
+    fd = mkstemp(path);
+    ck_assert_int_ge(fd, 0);
+    logger = UA_Log_Async_new(UA_LOGLEVEL_INFO, fd, capacity);
+    ck_assert_ptr_ne(logger, NULL);
+}
+
+/* Counts the lines that contain the needle */
+static size_t
+countLines(const char *needle) {
+    FILE *f = fopen(path, "r");
+    ck_assert_ptr_ne(f, NULL);
+    char line[512];
+    size_t count = 0;
+    while(fgets(line, sizeof(line), f)) {
+        if(strstr(line, needle))
+            count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static void
+closeLog(void) {
+    if(logger)
+        logger->clear(logger);
+    logger = NULL;
+    close(fd);
+    unlink(path);
+    strcpy(path, "/tmp/check_mt_logAsyncXXXXXX");
+}
+
+START_TEST(logAndFlush) {
+    openLog(0);
+    for(int i = 0; i < 100; i++)
+        UA_LOG_INFO(logger, UA_LOGCATEGORY_SERVER, "message %i", i);
+    UA_LOG_DEBUG(logger, UA_LOGCATEGORY_SERVER, "filtered");
+    UA_Log_Async_flush(logger);
+    ck_assert_uint_eq(countLines("info/server\tmessage "), 100);
+    ck_assert_uint_eq(countLines("\tmessage 42\n"), 1);
+    ck_assert_uint_eq(countLines("filtered"), 0);
+    ck_assert_uint_eq(UA_Log_Async_getDropped(logger), 0);
+    closeLog();
+} END_TEST
+
+START_TEST(clearWritesRemaining) {
+    openLog(0);
+    for(int i = 0; i < 100; i++)
+        UA_LOG_WARNING(logger, UA_LOGCATEGORY_NETWORK, "message %i", i);
+    logger->clear(logger);
+    logger = NULL;
+    ck_assert_uint_eq(countLines("warn/network\tmessage "), 100);
+    closeLog();
+} END_TEST
+
+THREAD_CALLBACK(logThread) {
+    for(int i = 0; i < MESSAGES_PER_THREAD; i++)
+        UA_LOG_INFO(logger, UA_LOGCATEGORY_USERLAND, "message %i", i);
+    return 0;
+}
+
+static void
+logConcurrently(size_t capacity) {
+    openLog(capacity);
+    THREAD_HANDLE threads[NUMBER_OF_THREADS];
+    for(size_t i = 0; i < NUMBER_OF_THREADS; i++)
+        THREAD_CREATE(threads[i], logThread);
+    for(size_t i = 0; i < NUMBER_OF_THREADS; i++)
+        THREAD_JOIN(threads[i]);
+    UA_Log_Async_flush(logger);
+
+    /* Every message is either written or counted as dropped */
+    UA_UInt64 dropped = UA_Log_Async_getDropped(logger);
+    size_t written = countLines("info/userland\tmessage ");
+    ck_assert_uint_eq(written + dropped, NUMBER_OF_THREADS * MESSAGES_PER_THREAD);
+    if(dropped > 0)
+        ck_assert_uint_ge(countLines("log messages dropped"), 1);
+    closeLog();
+}
+
+START_TEST(concurrentLogging) {
+    logConcurrently(NUMBER_OF_THREADS * MESSAGES_PER_THREAD);
+} END_TEST
+
+START_TEST(concurrentLoggingDropped) {
+    logConcurrently(4);
+} END_TEST
+
+int main(void) {
+    Suite *s = suite_create("Asynchronous Logger");
+    TCase *tc = tcase_create("Log");
+    tcase_add_test(tc, logAndFlush);
+    tcase_add_test(tc, clearWritesRemaining);
+    tcase_add_test(tc, concurrentLogging);
+    tcase_add_test(tc, concurrentLoggingDropped);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,157 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_NETWORK_LOOPS 3
+#define NUMBER_OF_CLIENTS 12
+#define ITERATIONS_PER_CLIENT 20
+
+UA_NodeId pumpTypeId = {1, UA_NODEIDTYPE_NUMERIC, {1001}};
+
+UA_EventLoop *networkLoops[NUMBER_OF_NETWORK_LOOPS];
+THREAD_HANDLE networkThreads[NUMBER_OF_NETWORK_LOOPS];
+UA_Boolean networkRunning;
+
+THREAD_CALLBACK_PARAM(networkLoop, val) {
+    UA_EventLoop *el = *(UA_EventLoop**)val;
+    while(networkRunning)
+        el->run(el, 100);
+    return 0;
+}
+
+static void
+addVariableNode(void) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 myInteger = 42;
+    UA_Variant_setScalar(&attr.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US","Temperature");
+    UA_QualifiedName myIntegerName = UA_QUALIFIEDNAME(1, "Temperature");
+    UA_NodeId parentNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId parentReferenceNodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(tc.server, pumpTypeId, parentNodeId,
+                                  parentReferenceNodeId, myIntegerName,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(UA_STATUSCODE_GOOD, res);
+}
+
+static void setup(void) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+    addVariableNode();
+
+    /* Each network EventLoop gets its own TCP ConnectionManager */
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        networkLoops[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        UA_ConnectionManager *tcpCM =
+            UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcp connection manager"));
+        networkLoops[i]->registerEventSource(networkLoops[i],
+                                             (UA_EventSource *)tcpCM);
+    }
+    config->networkEventLoops = networkLoops;
+    config->networkEventLoopsSize = NUMBER_OF_NETWORK_LOOPS;
+
+    UA_StatusCode res = UA_Server_run_startup(tc.server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    networkRunning = true;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++)
+        THREAD_CREATE_PARAM(networkThreads[i], networkLoop, networkLoops[i]);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+/* The network EventLoops run until the server has shut down */
+static void teardownNetwork(void) {
+    teardown();
+    networkRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        THREAD_JOIN(networkThreads[i]);
+        UA_EventLoop *el = networkLoops[i];
+        el->stop(el);
+        while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+            el->run(el, 100);
+        el->free(el);
+    }
+}
+
+static void
+client_readValueAttribute(void *value) {
+    ThreadContext tmp = (*(ThreadContext *) value);
+    UA_Variant val;
+    UA_StatusCode retval =
+        UA_Client_readValueAttribute(tc.clients[tmp.index], pumpTypeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(42, *(UA_Int32 *)val.data);
+    UA_Variant_clear(&val);
+}
+
+static void
+initTest(void) {
+    for(size_t i = 0; i < tc.numberofClients; i++)
+        setThreadContext(&tc.clientContext[i], i, ITERATIONS_PER_CLIENT,
+                         client_readValueAttribute);
+}
+
+/* The reads take the shared side of the service lock if the Nodestore
+ * supports concurrent reads. The Session handling is exclusive. */
+static void
+checkServiceLock(void) {
+    UA_ServerStatistics stat = UA_Server_getStatistics(tc.server);
+    if(UA_Server_getConfig(tc.server)->nodestore.concurrentReads) {
+        ck_assert_uint_ge(stat.sls.sharedCount,
+                          NUMBER_OF_CLIENTS * ITERATIONS_PER_CLIENT);
+    } else {
+        ck_assert_uint_eq(stat.sls.sharedCount, 0);
+    }
+    ck_assert_uint_ge(stat.sls.sharedHoldTime, stat.sls.sharedMaxHoldTime);
+    ck_assert_uint_ge(stat.sls.exclusiveCount, 2 * NUMBER_OF_CLIENTS);
+    ck_assert_uint_ge(stat.sls.exclusiveHoldTime, stat.sls.exclusiveMaxHoldTime);
+}
+
+START_TEST(clientsOnNetworkEventLoops) {
+    /* Reverse connections are not served by the network EventLoops */
+    UA_UInt64 handle = 0;
+    UA_StatusCode res =
+        UA_Server_addReverseConnect(tc.server, UA_STRING("opc.tcp://localhost:4841"),
+                                    NULL, NULL, &handle);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNOTSUPPORTED);
+
+    startMultithreading();
+} END_TEST
+
+static Suite* testSuite_networkEventLoops(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_network = tcase_create("Network EventLoops");
+    tcase_add_checked_fixture(tc_network, setup, teardownNetwork);
+    tcase_add_test(tc_network, clientsOnNetworkEventLoops);
+    suite_add_tcase(s, tc_network);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_networkEventLoops();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(0, NUMBER_OF_CLIENTS, checkServiceLock);
+    initTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
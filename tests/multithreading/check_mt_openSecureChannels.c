@@ -0,0 +1,134 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/plugin/log_stdout.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+#include "mt_testing.h"
+
+#define NUMBER_OF_NETWORK_LOOPS 3
+#define NUMBER_OF_CLIENTS 8
+#define CHANNELS_PER_CLIENT 40
+#define MAX_SECURECHANNELS 4
+
+/* OPN messages are processed concurrently on the network EventLoops while the
+ * SecureChannels are purged from the other threads (maxSecureChannels is
+ * exceeded). Run with the AddressSanitizer to find use-after-free. */
+
+UA_EventLoop *networkLoops[NUMBER_OF_NETWORK_LOOPS];
+THREAD_HANDLE networkThreads[NUMBER_OF_NETWORK_LOOPS];
+UA_Boolean networkRunning;
+volatile UA_UInt32 openedChannels;
+
+THREAD_CALLBACK_PARAM(networkLoop, val) {
+    UA_EventLoop *el = *(UA_EventLoop**)val;
+    while(networkRunning)
+        el->run(el, 100);
+    return 0;
+}
+
+static void setup(void) {
+    tc.running = true;
+    tc.server = UA_Server_newForUnitTest();
+    ck_assert(tc.server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(tc.server);
+    config->maxSecureChannels = MAX_SECURECHANNELS;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        networkLoops[i] = UA_EventLoop_new_POSIX(UA_Log_Stdout);
+        UA_ConnectionManager *tcpCM =
+            UA_ConnectionManager_new_POSIX_TCP(UA_STRING("tcp connection manager"));
+        networkLoops[i]->registerEventSource(networkLoops[i],
+                                             (UA_EventSource *)tcpCM);
+    }
+    config->networkEventLoops = networkLoops;
+    config->networkEventLoopsSize = NUMBER_OF_NETWORK_LOOPS;
+
+    UA_StatusCode res = UA_Server_run_startup(tc.server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    networkRunning = true;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++)
+        THREAD_CREATE_PARAM(networkThreads[i], networkLoop, networkLoops[i]);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardownNetwork(void) {
+    teardown();
+    networkRunning = false;
+    for(size_t i = 0; i < NUMBER_OF_NETWORK_LOOPS; i++) {
+        THREAD_JOIN(networkThreads[i]);
+        UA_EventLoop *el = networkLoops[i];
+        el->stop(el);
+        while(el->state != UA_EVENTLOOPSTATE_STOPPED)
+            el->run(el, 100);
+        el->free(el);
+    }
+}
+
+/* Open a SecureChannel and keep it for a moment. So that the other clients
+ * exceed maxSecureChannels. The channel may be purged in the meantime. */
+static void
+client_openSecureChannel(void *value) {
+    (void)value;
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res =
+        UA_Client_connectSecureChannel(client, "opc.tcp://localhost:4840");
+    if(res == UA_STATUSCODE_GOOD) {
+        UA_atomic_addUInt32(&openedChannels, 1);
+        UA_Client_run_iterate(client, 20);
+    }
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+}
+
+/* The clients of mt_testing.h connect a Session first. Here only the
+ * SecureChannels are opened in worker threads. */
+static void
+initTest(void) {
+    for(size_t i = 0; i < tc.numberOfWorkers; i++)
+        setThreadContext(&tc.workerContext[i], i, CHANNELS_PER_CLIENT,
+                         client_openSecureChannel);
+}
+
+static void
+checkChannels(void) {
+    UA_ServerStatistics stat = UA_Server_getStatistics(tc.server);
+    ck_assert_uint_gt(openedChannels, 0);
+    ck_assert_uint_ge(stat.scs.cumulatedChannelCount, openedChannels);
+    ck_assert_uint_gt(stat.scs.channelPurgeCount, 0);
+}
+
+START_TEST(openSecureChannelsWithPurge) {
+    startMultithreading();
+} END_TEST
+
+static Suite* testSuite_openSecureChannels(void) {
+    Suite *s = suite_create("Multithreading");
+    TCase *tc_network = tcase_create("OpenSecureChannel on network EventLoops");
+    tcase_add_checked_fixture(tc_network, setup, teardownNetwork);
+    tcase_add_test(tc_network, openSecureChannelsWithPurge);
+    suite_add_tcase(s, tc_network);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_openSecureChannels();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+
+    createThreadContext(NUMBER_OF_CLIENTS, 0, checkChannels);
+    initTest();
+    srunner_run_all(sr, CK_NORMAL);
+    deleteThreadContext();
+
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
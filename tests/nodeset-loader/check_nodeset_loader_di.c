@@ -7,28 +7,93 @@
 #include <open62541/plugin/nodesetloader.h>
 
 #include <check.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "testing_clock.h"
 #include "test_helpers.h"
 
 UA_Server *server = NULL;
 
+/* Keeps the last info and error message of the server category */
+static UA_Logger *serverLogger;
+static char lastInfo[512];
+static char lastError[512];
+
+#ifdef __clang__
+__attribute__((__format__(__printf__, 7 , 0)))
+#endif
+static void
+captureLog(void *context, UA_LogLevel level, UA_LogCategory category,
+           const char *file, const char *function, uint_least32_t line,
+           const char *msg, va_list args) {
+    (void)context;
+    if(category == UA_LOGCATEGORY_SERVER && level == UA_LOGLEVEL_INFO) {
+        va_list args2;
+        va_copy(args2, args);
+        vsnprintf(lastInfo, sizeof(lastInfo), msg, args2);
+        va_end(args2);
+    } else if(category == UA_LOGCATEGORY_SERVER && level == UA_LOGLEVEL_ERROR) {
+        va_list args2;
+        va_copy(args2, args);
+        vsnprintf(lastError, sizeof(lastError), msg, args2);
+        va_end(args2);
+    }
+    serverLogger->log(serverLogger->context, level, category,
+                      file, function, line, msg, args);
+}
+
+static UA_Logger captureLogger = {captureLog, NULL, NULL};
+
+static size_t
+countNodes(void) {
+    UA_NodestoreStatistics stats;
+    UA_StatusCode res = UA_Server_getNodestoreStatistics(server, &stats);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    size_t count = stats.total.nodeCount;
+    UA_NodestoreStatistics_clear(&stats);
+    return count;
+}
+
 static void setup(void) {
     server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    serverLogger = config->logging;
+    config->logging = &captureLogger;
     UA_Server_run_startup(server);
 }
 
 static void teardown(void) {
     UA_Server_run_shutdown(server);
+    UA_Server_getConfig(server)->logging = serverLogger;
     UA_Server_delete(server);
 }
 
+START_TEST(Server_loadMissingNodeset) {
+    lastError[0] = 0;
+    UA_StatusCode retVal = UA_Server_loadNodeset(server,
+        OPEN62541_NODESET_DIR "DI/Missing.NodeSet2.xml", NULL);
+    ck_assert(!UA_StatusCode_isGood(retVal));
+    ck_assert_ptr_ne(strstr(lastError, "DI/Missing.NodeSet2.xml failed"), NULL);
+}
+END_TEST
+
 START_TEST(Server_loadDiNodeset) {
+    size_t nodesBefore = countNodes();
     UA_StatusCode retVal = UA_Server_loadNodeset(server,
         OPEN62541_NODESET_DIR "DI/Opc.Ua.Di.NodeSet2.xml", NULL);
     ck_assert(UA_StatusCode_isGood(retVal));
+
+    /* The report contains the number of added nodes */
+    const char *report = strstr(lastInfo, "Opc.Ua.Di.NodeSet2.xml with ");
+    ck_assert_ptr_ne(report, NULL);
+    unsigned long reportedNodes = 0;
+    ck_assert_int_eq(sscanf(report, "Opc.Ua.Di.NodeSet2.xml with %lu nodes",
+                            &reportedNodes), 1);
+    ck_assert_uint_gt(reportedNodes, 0);
+    ck_assert_uint_eq(reportedNodes, countNodes() - nodesBefore);
 }
 END_TEST
 
@@ -36,6 +101,7 @@ static Suite* testSuite_Client(void) {
     Suite *s = suite_create("Server Nodeset Loader");
     TCase *tc_server = tcase_create("Server DI nodeset");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
+    tcase_add_test(tc_server, Server_loadMissingNodeset);
     tcase_add_test(tc_server, Server_loadDiNodeset);
     suite_add_tcase(s, tc_server);
     return s;
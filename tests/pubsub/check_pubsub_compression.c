@@ -0,0 +1,174 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+#include <open62541/types.h>
+
+#include "ua_pubsub.h"
+#include "ua_pubsub_compression.h"
+#include "test_helpers.h"
+
+#include <check.h>
+
+UA_Server *server = NULL;
+UA_NodeId connection1, writerGroup1, publishedDataSet1, dataSetWriter1,
+    readerGroup1, dataSetReader1;
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("UADP Connection");
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4840/")};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    UA_StatusCode retVal =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connection1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* WriterGroup with compression */
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup 1");
+    writerGroupConfig.publishingInterval = 10;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_JSON;
+    UA_String deflate = UA_STRING("deflate");
+    UA_KeyValuePair compression;
+    compression.key = UA_QUALIFIEDNAME(0, "compression");
+    UA_Variant_setScalar(&compression.value, &deflate, &UA_TYPES[UA_TYPES_STRING]);
+    writerGroupConfig.groupProperties.map = &compression;
+    writerGroupConfig.groupProperties.mapSize = 1;
+    retVal = UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet 1");
+    UA_AddPublishedDataSetResult result =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet1);
+    ck_assert_int_eq(result.addResult, UA_STATUSCODE_GOOD);
+
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Server localtime");
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataSetFieldResult dsFieldResult =
+        UA_Server_addDataSetField(server, publishedDataSet1, &dataSetFieldConfig, NULL);
+    ck_assert_int_eq(dsFieldResult.result, UA_STATUSCODE_GOOD);
+
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter 1");
+    dataSetWriterConfig.dataSetWriterId = 62541;
+    retVal = UA_Server_addDataSetWriter(server, writerGroup1, publishedDataSet1,
+                                        &dataSetWriterConfig, &dataSetWriter1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* ReaderGroup with the same field names in the DataSetMetaData */
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset(&readerGroupConfig, 0, sizeof(readerGroupConfig));
+    readerGroupConfig.name = UA_STRING("ReaderGroup 1");
+    retVal = UA_Server_addReaderGroup(server, connection1, &readerGroupConfig, &readerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_FieldMetaData field;
+    UA_FieldMetaData_init(&field);
+    field.name = UA_STRING("Server localtime");
+    field.builtInType = UA_NS0ID_DATETIME;
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(readerConfig));
+    readerConfig.name = UA_STRING("DataSetReader 1");
+    readerConfig.dataSetWriterId = 62541;
+    readerConfig.dataSetMetaData.fields = &field;
+    readerConfig.dataSetMetaData.fieldsSize = 1;
+    retVal = UA_Server_addDataSetReader(server, readerGroup1, &readerConfig, &dataSetReader1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(CompressAndDecode) {
+    UA_ByteString msg = UA_STRING("{\"MessageId\":\"5ED82C10-50BB-CD07-0120-22521081E8EE\","
+        "\"MessageType\":\"ua-data\",\"Messages\":[{\"DataSetWriterId\":62541,"
+        "\"MetaDataVersion\":{\"MajorVersion\":1478393530,\"MinorVersion\":12345},"
+        "\"SequenceNumber\":4711,\"Payload\":{\"Server localtime\":"
+        "{\"Type\":13,\"Body\":\"2018-06-05T05:58:36.000Z\"}}}]}");
+
+    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroup1);
+    ck_assert(wg != NULL);
+    ck_assert(UA_WriterGroup_compressionEnabled(wg));
+    ck_assert(!UA_PubSub_isCompressed(&msg));
+
+    UA_ByteString compressed;
+    UA_StatusCode retVal = UA_WriterGroup_compress(server, wg, 62541, &msg, &compressed);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(UA_PubSub_isCompressed(&compressed));
+    ck_assert_uint_lt(compressed.length, msg.length);
+
+    /* The subscriber finds the dictionary from the DataSetReader */
+    UA_PubSubConnection *c = UA_PubSubConnection_findConnectionbyId(server, connection1);
+    UA_NetworkMessage nm;
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    retVal = UA_PubSubConnection_decodeJson(c, &nm, &compressed);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(nm.payloadHeader.dataSetPayloadHeader.count, 1);
+    ck_assert_uint_eq(nm.payloadHeader.dataSetPayloadHeader.dataSetWriterIds[0], 62541);
+    UA_NetworkMessage_clear(&nm);
+
+    /* Uncompressed messages are decoded directly */
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    retVal = UA_PubSubConnection_decodeJson(c, &nm, &msg);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_NetworkMessage_clear(&nm);
+
+    /* Without the matching dictionary the message cannot be decoded */
+    retVal = UA_Server_removeDataSetReader(server, dataSetReader1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    retVal = UA_PubSubConnection_decodeJson(c, &nm, &compressed);
+    ck_assert_int_ne(retVal, UA_STATUSCODE_GOOD);
+
+    UA_ByteString_clear(&compressed);
+} END_TEST
+
+START_TEST(PublishCompressed) {
+    UA_StatusCode retVal = UA_Server_enableWriterGroup(server, writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroup1);
+    ck_assert(wg != NULL);
+    UA_WriterGroup_publishCallback(server, wg);
+    ck_assert_int_eq(wg->state, UA_PUBSUBSTATE_OPERATIONAL);
+} END_TEST
+
+int main(void) {
+    TCase *tc_compression = tcase_create("PubSub JSON compression");
+    tcase_add_checked_fixture(tc_compression, setup, teardown);
+    tcase_add_test(tc_compression, CompressAndDecode);
+    tcase_add_test(tc_compression, PublishCompressed);
+
+    Suite *s = suite_create("PubSub compression");
+    suite_add_tcase(s, tc_compression);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -98,11 +98,157 @@ START_TEST(AddSubscriberUsingBinaryFile) {
     UA_ByteString_clear(&subscriberConfiguration);
 } END_TEST
 
+/* Encode the configuration like a configuration file and load it */
+static UA_StatusCode
+loadConfiguration(UA_PubSubConfigurationDataType *config) {
+    UA_UABinaryFileDataType binFile;
+    UA_UABinaryFileDataType_init(&binFile);
+    UA_Variant_setScalar(&binFile.body, config,
+                         &UA_TYPES[UA_TYPES_PUBSUBCONFIGURATIONDATATYPE]);
+    UA_ExtensionObject eo;
+    UA_ExtensionObject_setValue(&eo, &binFile, &UA_TYPES[UA_TYPES_UABINARYFILEDATATYPE]);
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_encodeBinary(&eo, &UA_TYPES[UA_TYPES_EXTENSIONOBJECT], &buf);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_LOCK(&server->serviceMutex);
+    res = UA_PubSubManager_loadPubSubConfigFromByteString(server, buf);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_ByteString_clear(&buf);
+    return res;
+}
+
+#define BULK_PDS 8
+#define BULK_WRITERS 64
+#define BULK_READERS 256
+
+START_TEST(BulkLoadConfiguration) {
+    char names[BULK_PDS][16];
+    UA_PublishedDataItemsDataType items;
+    UA_PublishedDataItemsDataType_init(&items);
+    UA_PublishedDataSetDataType pds[BULK_PDS];
+    for(size_t i = 0; i < BULK_PDS; i++) {
+        /* Not sorted by name */
+        snprintf(names[i], 16, "PDS %u", (unsigned)((i * 5) % BULK_PDS));
+        UA_PublishedDataSetDataType_init(&pds[i]);
+        pds[i].name = UA_STRING(names[i]);
+        UA_ExtensionObject_setValue(&pds[i].dataSetSource, &items,
+                                    &UA_TYPES[UA_TYPES_PUBLISHEDDATAITEMSDATATYPE]);
+    }
+
+    UA_DataSetWriterDataType writers[BULK_WRITERS];
+    for(size_t i = 0; i < BULK_WRITERS; i++) {
+        UA_DataSetWriterDataType_init(&writers[i]);
+        writers[i].name = UA_STRING("Writer");
+        writers[i].dataSetWriterId = (UA_UInt16)(i + 1);
+        writers[i].dataSetName = pds[i % BULK_PDS].name;
+    }
+    UA_UadpWriterGroupMessageDataType wgMessage;
+    UA_UadpWriterGroupMessageDataType_init(&wgMessage);
+    UA_WriterGroupDataType wg;
+    UA_WriterGroupDataType_init(&wg);
+    wg.name = UA_STRING("WriterGroup");
+    wg.writerGroupId = 1;
+    wg.publishingInterval = 100;
+    UA_ExtensionObject_setValue(&wg.messageSettings, &wgMessage,
+                                &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE]);
+    wg.dataSetWriters = writers;
+    wg.dataSetWritersSize = BULK_WRITERS;
+
+    UA_UInt16 publisherId = 1;
+    UA_TargetVariablesDataType targets;
+    UA_TargetVariablesDataType_init(&targets);
+    UA_DataSetReaderDataType readers[BULK_READERS];
+    for(size_t i = 0; i < BULK_READERS; i++) {
+        UA_DataSetReaderDataType_init(&readers[i]);
+        readers[i].name = UA_STRING("Reader");
+        UA_Variant_setScalar(&readers[i].publisherId, &publisherId,
+                             &UA_TYPES[UA_TYPES_UINT16]);
+        readers[i].writerGroupId = 1;
+        readers[i].dataSetWriterId = (UA_UInt16)(i + 1);
+        UA_ExtensionObject_setValue(&readers[i].subscribedDataSet, &targets,
+                                    &UA_TYPES[UA_TYPES_TARGETVARIABLESDATATYPE]);
+    }
+    UA_ReaderGroupDataType rg;
+    UA_ReaderGroupDataType_init(&rg);
+    rg.name = UA_STRING("ReaderGroup");
+    rg.dataSetReaders = readers;
+    rg.dataSetReadersSize = BULK_READERS;
+
+    UA_NetworkAddressUrlDataType address =
+        {UA_STRING_NULL, UA_STRING("opc.udp://224.0.0.22:4840/")};
+    UA_PubSubConnectionDataType connection;
+    UA_PubSubConnectionDataType_init(&connection);
+    connection.name = UA_STRING("Connection");
+    connection.enabled = true;
+    connection.transportProfileUri =
+        UA_STRING("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+    UA_Variant_setScalar(&connection.publisherId, &publisherId, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_ExtensionObject_setValue(&connection.address, &address,
+                                &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connection.writerGroups = &wg;
+    connection.writerGroupsSize = 1;
+    connection.readerGroups = &rg;
+    connection.readerGroupsSize = 1;
+
+    UA_PubSubConfigurationDataType config;
+    UA_PubSubConfigurationDataType_init(&config);
+    config.publishedDataSets = pds;
+    config.publishedDataSetsSize = BULK_PDS;
+    config.connections = &connection;
+    config.connectionsSize = 1;
+    config.enabled = true;
+
+    ck_assert_int_eq(loadConfiguration(&config), UA_STATUSCODE_GOOD);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_PubSubConnection *c = TAILQ_FIRST(&server->pubSubManager.connections);
+    ck_assert(c != NULL);
+    UA_WriterGroup *writerGroup = LIST_FIRST(&c->writerGroups);
+    ck_assert(writerGroup != NULL);
+    ck_assert_uint_eq(writerGroup->writersCount, BULK_WRITERS);
+    ck_assert(writerGroup->state != UA_PUBSUBSTATE_DISABLED);
+    UA_ReaderGroup *readerGroup = LIST_FIRST(&c->readerGroups);
+    ck_assert(readerGroup != NULL);
+    ck_assert_uint_eq(readerGroup->readersCount, BULK_READERS);
+    ck_assert(readerGroup->state != UA_PUBSUBSTATE_DISABLED);
+
+    /* The writers are connected to the PublishedDataSet with the name */
+    UA_DataSetWriter *dsw;
+    LIST_FOREACH(dsw, &writerGroup->writers, listEntry) {
+        UA_PublishedDataSet *p =
+            UA_PublishedDataSet_findPDSbyId(server, dsw->connectedDataSet);
+        ck_assert(p != NULL);
+        ck_assert(UA_String_equal(&p->config.name, &dsw->config.dataSetName));
+        ck_assert(UA_DataSetWriter_findDSWbyId(server, dsw->identifier) == dsw);
+    }
+
+    /* Components are found by their id only with the matching type */
+    UA_DataSetReader *dsr = LIST_FIRST(&readerGroup->readers);
+    ck_assert(UA_ReaderGroup_findDSRbyId(server, dsr->identifier) == dsr);
+    ck_assert(UA_ReaderGroup_findRGbyId(server, dsr->identifier) == NULL);
+    ck_assert(UA_ReaderGroup_findRGbyId(server, readerGroup->identifier) == readerGroup);
+    ck_assert(UA_WriterGroup_findWGbyId(server, writerGroup->identifier) == writerGroup);
+    ck_assert(UA_PubSubConnection_findConnectionbyId(server, c->identifier) == c);
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* An invalid configuration is rejected before the current configuration
+     * is removed */
+    UA_ExtensionObject_setValue(&readers[BULK_READERS - 1].subscribedDataSet, &items,
+                                &UA_TYPES[UA_TYPES_PUBLISHEDDATAITEMSDATATYPE]);
+    ck_assert_int_ne(loadConfiguration(&config), UA_STATUSCODE_GOOD);
+    UA_LOCK(&server->serviceMutex);
+    ck_assert_uint_eq(server->pubSubManager.connectionsSize, 1);
+    ck_assert_uint_eq(server->pubSubManager.publishedDataSetsSize, BULK_PDS);
+    ck_assert(UA_ReaderGroup_findDSRbyId(server, dsr->identifier) == dsr);
+    UA_UNLOCK(&server->serviceMutex);
+} END_TEST
+
 int main(void) {
     TCase *tc_pubsub_file_configuration = tcase_create("File Configuration");
     tcase_add_checked_fixture(tc_pubsub_file_configuration, setup, teardown);
     tcase_add_test(tc_pubsub_file_configuration, AddPublisherUsingBinaryFile);
     tcase_add_test(tc_pubsub_file_configuration, AddSubscriberUsingBinaryFile);
+    tcase_add_test(tc_pubsub_file_configuration, BulkLoadConfiguration);
 
     Suite *s = suite_create("PubSub file configuration");
     suite_add_tcase(s, tc_pubsub_file_configuration);
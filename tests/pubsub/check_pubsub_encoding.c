@@ -9,8 +9,12 @@
 #include <open62541/types.h>
 
 #include "ua_pubsub_networkmessage.h"
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+#include "ua_pubsub_bufmalloc.h"
+#endif
 
 #include "check.h"
+#include <stdlib.h>
 
 START_TEST(UA_PubSub_EnDecode_ShallWorkOn1DS1ValueVariantKeyFrame) {
     UA_NetworkMessage m;
@@ -1340,6 +1344,168 @@ START_TEST(UA_PubSub_EnDecode_ShallWorkOn2DSVariant) {
 }
 END_TEST
 
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+
+/* Custom allocator hooks that count the calls */
+static size_t mallocCount;
+static size_t freeCount;
+static size_t reallocCount;
+
+static void *
+countingMalloc(size_t size) {
+    mallocCount++;
+    return malloc(size);
+}
+
+static void
+countingFree(void *ptr) {
+    if(ptr)
+        freeCount++;
+    free(ptr);
+}
+
+static void *
+countingCalloc(size_t nelem, size_t elsize) {
+    mallocCount++;
+    return calloc(nelem, elsize);
+}
+
+static void *
+countingRealloc(void *ptr, size_t size) {
+    reallocCount++;
+    return realloc(ptr, size);
+}
+
+static void
+useCountingAlloc(void) {
+    mallocCount = 0;
+    freeCount = 0;
+    reallocCount = 0;
+    UA_mallocSingleton = countingMalloc;
+    UA_freeSingleton = countingFree;
+    UA_callocSingleton = countingCalloc;
+    UA_reallocSingleton = countingRealloc;
+}
+
+static void
+useLibcAlloc(void) {
+    UA_mallocSingleton = malloc;
+    UA_freeSingleton = free;
+    UA_callocSingleton = calloc;
+    UA_reallocSingleton = realloc;
+}
+
+static UA_ByteString
+encodeKeyFrame(UA_Int32 iv) {
+    UA_NetworkMessage m;
+    memset(&m, 0, sizeof(UA_NetworkMessage));
+    m.version = 1;
+    m.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    UA_DataSetMessage dmkf;
+    memset(&dmkf, 0, sizeof(UA_DataSetMessage));
+    dmkf.header.dataSetMessageValid = true;
+    dmkf.header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+    dmkf.header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+    dmkf.data.keyFrameData.fieldCount = 1;
+    UA_DataValue field;
+    UA_DataValue_init(&field);
+    UA_Variant_setScalar(&field.value, &iv, &UA_TYPES[UA_TYPES_INT32]);
+    field.hasValue = true;
+    dmkf.data.keyFrameData.dataSetFields = &field;
+    m.payload.dataSetPayload.dataSetMessages = &dmkf;
+
+    UA_ByteString buffer;
+    UA_StatusCode rv =
+        UA_ByteString_allocBuffer(&buffer, UA_NetworkMessage_calcSizeBinary(&m, NULL));
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    UA_Byte *bufPos = buffer.data;
+    rv = UA_NetworkMessage_encodeBinary(&m, &bufPos, &buffer.data[buffer.length], NULL);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    return buffer;
+}
+
+START_TEST(UA_PubSub_Arena_DecodeShallNotUseTheAllocator) {
+    UA_ByteString buffer = encodeKeyFrame(27);
+    useCountingAlloc();
+    UA_PubSubArena arena;
+    UA_StatusCode rv = UA_PubSubArena_init(&arena, UA_PUBSUB_ARENASIZE);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(mallocCount, 1);
+
+    /* Decode into the arena. Twice, the arena is reset when it is entered. */
+    for(size_t i = 0; i < 2; i++) {
+        UA_PubSubArena_enter(&arena);
+        UA_NetworkMessage m;
+        memset(&m, 0, sizeof(UA_NetworkMessage));
+        size_t offset = 0;
+        rv = UA_NetworkMessage_decodeBinary(&buffer, &offset, &m, NULL);
+        ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+        UA_DataValue *field =
+            &m.payload.dataSetPayload.dataSetMessages[0].data.keyFrameData.dataSetFields[0];
+        ck_assert_int_eq(*(UA_Int32*)field->value.data, 27);
+        UA_NetworkMessage_clear(&m);
+        UA_PubSubArena_leave(&arena);
+    }
+    ck_assert_uint_eq(mallocCount, 1);
+    ck_assert_uint_eq(freeCount, 0);
+
+    /* The custom allocator hooks are restored */
+    ck_assert(UA_mallocSingleton == countingMalloc);
+    ck_assert(UA_freeSingleton == countingFree);
+    ck_assert(UA_callocSingleton == countingCalloc);
+    ck_assert(UA_reallocSingleton == countingRealloc);
+
+    UA_PubSubArena_clear(&arena);
+    ck_assert_uint_eq(freeCount, 1);
+    useLibcAlloc();
+    UA_ByteString_clear(&buffer);
+} END_TEST
+
+START_TEST(UA_PubSub_Arena_ForeignMemoryShallUsePreviousAllocator) {
+    useCountingAlloc();
+    UA_PubSubArena arena;
+    UA_StatusCode rv = UA_PubSubArena_init(&arena, 256);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    void *foreign = UA_malloc(16);
+    void *foreign2 = UA_malloc(16);
+    ck_assert_ptr_ne(foreign2, NULL);
+    ck_assert_uint_eq(mallocCount, 3);
+
+    UA_PubSubArena_enter(&arena);
+
+    /* Memory from outside the arena is reallocated and freed with the
+     * previous allocator */
+    foreign = UA_realloc(foreign, 32);
+    ck_assert_ptr_ne(foreign, NULL);
+    ck_assert_uint_eq(reallocCount, 1);
+    UA_free(foreign);
+    ck_assert_uint_eq(freeCount, 1);
+
+    /* Arena memory is not freed individually. Growing it copies the content. */
+    char *mem = (char*)UA_malloc(8);
+    ck_assert_ptr_ne(mem, NULL);
+    memcpy(mem, "arena", 6);
+    mem = (char*)UA_realloc(mem, 64);
+    ck_assert_ptr_ne(mem, NULL);
+    ck_assert_str_eq(mem, "arena");
+    UA_free(mem);
+    ck_assert_uint_eq(freeCount, 1);
+    ck_assert_uint_eq(reallocCount, 1);
+
+    /* The arena is exhausted */
+    ck_assert_ptr_eq(UA_malloc(256), NULL);
+    ck_assert_ptr_eq(UA_calloc(SIZE_MAX / 2, 4), NULL);
+    ck_assert_uint_eq(mallocCount, 3);
+
+    UA_PubSubArena_leave(&arena);
+    UA_free(foreign2);
+    ck_assert_uint_eq(freeCount, 2);
+    UA_PubSubArena_clear(&arena);
+    useLibcAlloc();
+} END_TEST
+
+#endif
+
 int main(void) {
     TCase *tc_encode = tcase_create("encode");
     tcase_add_test(tc_encode, UA_PubSub_Encode_WithBufferTooSmallShallReturnError);
@@ -1371,6 +1537,13 @@ int main(void) {
     suite_add_tcase(s, tc_ende1);
     suite_add_tcase(s, tc_ende2);
 
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+    TCase *tc_arena = tcase_create("arena");
+    tcase_add_test(tc_arena, UA_PubSub_Arena_DecodeShallNotUseTheAllocator);
+    tcase_add_test(tc_arena, UA_PubSub_Arena_ForeignMemoryShallUsePreviousAllocator);
+    suite_add_tcase(s, tc_arena);
+#endif
+
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
     srunner_run_all(sr,CK_NORMAL);
@@ -100,6 +100,14 @@ START_TEST(UA_PubSub_EncodeAllOptionalFields) {
     char* result = "{\"MessageId\":\"ABCDEFGH\",\"MessageType\":\"ua-data\",\"PublisherId\":65535,\"DataSetClassId\":\"00000001-0002-0003-0000-000000000000\",\"Messages\":[{\"DataSetWriterId\":12345,\"SequenceNumber\":4711,\"MetaDataVersion\":{\"MajorVersion\":42,\"MinorVersion\":7},\"Timestamp\":\"1601-01-13T20:38:31.1111111Z\",\"Status\":12345,\"Payload\":{\"Field1\":{\"Type\":7,\"Body\":27}}}]}";
     ck_assert_str_eq(result, (char*)buffer.data);
 
+    /* Single-pass encoding into a growing buffer gives the same result */
+    UA_ByteString grown;
+    rv = UA_NetworkMessage_encodeJsonAlloc(&m, &grown, NULL, 0, NULL, 0, true);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(grown.length, size);
+    ck_assert(memcmp(grown.data, buffer.data, size) == 0);
+    UA_ByteString_clear(&grown);
+
     UA_ByteString_clear(&buffer);
     UA_NetworkMessage_clear(&m);
 }
@@ -324,6 +332,70 @@ START_TEST(UA_NetworkMessage_json_decode) {
 }
 END_TEST
 
+static UA_DataSetMetaDataType testMetaData;
+
+static const UA_DataSetMetaDataType *
+lookupTestMetaData(void *context, UA_UInt16 dataSetWriterId) {
+    return (dataSetWriterId == 62541) ? &testMetaData : NULL;
+}
+
+START_TEST(UA_NetworkMessage_json_decodeWithMetaData) {
+    UA_FieldMetaData fields[2];
+    UA_FieldMetaData_init(&fields[0]);
+    fields[0].name = UA_STRING("Test");
+    fields[0].builtInType = UA_NS0ID_UINT16;
+    fields[0].valueRank = UA_VALUERANK_SCALAR;
+    UA_FieldMetaData_init(&fields[1]);
+    fields[1].name = UA_STRING("Server localtime");
+    fields[1].builtInType = UA_NS0ID_BOOLEAN;
+    fields[1].valueRank = UA_VALUERANK_SCALAR;
+    UA_DataSetMetaDataType_init(&testMetaData);
+    testMetaData.fields = fields;
+    testMetaData.fieldsSize = 2;
+
+    UA_NetworkMessage out;
+    memset(&out,0,sizeof(UA_NetworkMessage));
+    UA_ByteString buf = UA_STRING("{\"MessageId\":\"5ED82C10-50BB-CD07-0120-22521081E8EE\",\"MessageType\":\"ua-data\",\"Messages\":[{\"DataSetWriterId\":62541,\"SequenceNumber\":4711,\"Payload\":{\"Test\":{\"Type\":5,\"Body\":42},\"Server localtime\":{\"Type\":1,\"Body\":true}}}]}");
+
+    /* The fields match the metadata. The fieldNames are not decoded. */
+    UA_StatusCode retval =
+        UA_NetworkMessage_decodeJsonWithMetaData(&out, &buf, lookupTestMetaData, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_DataSetMessage *dsm = &out.payload.dataSetPayload.dataSetMessages[0];
+    ck_assert_int_eq(out.payloadHeader.dataSetPayloadHeader.dataSetWriterIds[0], 62541);
+    ck_assert_int_eq(dsm->data.keyFrameData.fieldCount, 2);
+    ck_assert_ptr_eq(dsm->data.keyFrameData.fieldNames, NULL);
+    ck_assert(dsm->data.keyFrameData.dataSetFields[0].value.type == &UA_TYPES[UA_TYPES_UINT16]);
+    ck_assert_int_eq(*(UA_UInt16*)dsm->data.keyFrameData.dataSetFields[0].value.data, 42);
+    ck_assert(dsm->data.keyFrameData.dataSetFields[1].value.type == &UA_TYPES[UA_TYPES_BOOLEAN]);
+    ck_assert_int_eq(*(UA_Boolean*)dsm->data.keyFrameData.dataSetFields[1].value.data, true);
+    UA_NetworkMessage_clear(&out);
+
+    /* The builtin type deviates. The field is decoded as a generic Variant. */
+    fields[0].builtInType = UA_NS0ID_INT32;
+    memset(&out,0,sizeof(UA_NetworkMessage));
+    retval = UA_NetworkMessage_decodeJsonWithMetaData(&out, &buf, lookupTestMetaData, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    dsm = &out.payload.dataSetPayload.dataSetMessages[0];
+    ck_assert(dsm->data.keyFrameData.dataSetFields[0].value.type == &UA_TYPES[UA_TYPES_UINT16]);
+    ck_assert_int_eq(*(UA_UInt16*)dsm->data.keyFrameData.dataSetFields[0].value.data, 42);
+    UA_NetworkMessage_clear(&out);
+
+    /* The field names deviate. Fall back to the generic decoding. */
+    fields[1].name = UA_STRING("Other");
+    memset(&out,0,sizeof(UA_NetworkMessage));
+    retval = UA_NetworkMessage_decodeJsonWithMetaData(&out, &buf, lookupTestMetaData, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    dsm = &out.payload.dataSetPayload.dataSetMessages[0];
+    ck_assert_int_eq(dsm->data.keyFrameData.fieldCount, 2);
+    ck_assert_ptr_ne(dsm->data.keyFrameData.fieldNames, NULL);
+    UA_String expected = UA_STRING("Server localtime");
+    ck_assert(UA_String_equal(&dsm->data.keyFrameData.fieldNames[1], &expected));
+    ck_assert_int_eq(*(UA_Boolean*)dsm->data.keyFrameData.dataSetFields[1].value.data, true);
+    UA_NetworkMessage_clear(&out);
+}
+END_TEST
+
 START_TEST(UA_Networkmessage_DataSetFieldsNull_json_decode) {
     // given
     UA_NetworkMessage out;
@@ -375,6 +447,109 @@ START_TEST(UA_NetworkMessage_fieldNames_json_decode) {
 }
 END_TEST
 
+static void
+checkJsonTemplate(UA_NetworkMessageJsonTemplate *tmpl, const UA_NetworkMessage *m) {
+    ck_assert(UA_NetworkMessageJsonTemplate_matches(tmpl, m));
+    UA_ByteString out;
+    UA_StatusCode rv = UA_NetworkMessage_encodeJsonTemplate(tmpl, m, &out);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+
+    size_t size = UA_NetworkMessage_calcSizeJson(m, NULL, 0, NULL, 0, true);
+    ck_assert_uint_eq(out.length, size);
+    UA_ByteString expected;
+    rv = UA_ByteString_allocBuffer(&expected, size);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    UA_Byte *bufPos = expected.data;
+    const UA_Byte *bufEnd = &expected.data[expected.length];
+    rv = UA_NetworkMessage_encodeJson(m, &bufPos, &bufEnd, NULL, 0, NULL, 0, true);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    ck_assert(UA_ByteString_equal(&out, &expected));
+    UA_ByteString_clear(&expected);
+}
+
+START_TEST(UA_NetworkMessage_json_template) {
+    UA_NetworkMessage m;
+    memset(&m, 0, sizeof(UA_NetworkMessage));
+    m.version = 1;
+    m.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    m.payloadHeaderEnabled = true;
+    m.publisherIdEnabled = true;
+    m.publisherIdType = UA_PUBLISHERIDTYPE_UINT16;
+    m.publisherId.uint16 = 65535;
+    m.payloadHeader.dataSetPayloadHeader.count = 2;
+    UA_UInt16 dsWriterIds[2] = {12345, 678};
+    m.payloadHeader.dataSetPayloadHeader.dataSetWriterIds = dsWriterIds;
+    UA_DataSetMessage dsm[2];
+    memset(dsm, 0, sizeof(dsm));
+    m.payload.dataSetPayload.dataSetMessages = dsm;
+
+    UA_DataValue fields[3];
+    UA_String fieldNames[3] = {UA_STRING_STATIC("Field1"), UA_STRING_STATIC("Field2"),
+                               UA_STRING_STATIC("Field3")};
+    for(size_t i = 0; i < 3; i++)
+        UA_DataValue_init(&fields[i]);
+    for(size_t i = 0; i < 2; i++) {
+        dsm[i].header.dataSetMessageValid = true;
+        dsm[i].header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+        dsm[i].header.dataSetMessageSequenceNrEnabled = true;
+        dsm[i].header.dataSetMessageSequenceNr = 4711;
+    }
+
+    /* The first DataSetMessage with variants and header fields */
+    dsm[0].header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+    dsm[0].header.timestampEnabled = true;
+    dsm[0].header.timestamp = 11111111111111;
+    dsm[0].header.statusEnabled = true;
+    dsm[0].header.status = 12345;
+    dsm[0].data.keyFrameData.fieldCount = 2;
+    dsm[0].data.keyFrameData.dataSetFields = fields;
+    dsm[0].data.keyFrameData.fieldNames = fieldNames;
+    UA_UInt32 iv = 27;
+    UA_Variant_setScalar(&fields[0].value, &iv, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_String sv = UA_STRING("abc");
+    UA_Variant_setScalar(&fields[1].value, &sv, &UA_TYPES[UA_TYPES_STRING]);
+
+    /* The second DataSetMessage with a DataValue */
+    dsm[1].header.fieldEncoding = UA_FIELDENCODING_DATAVALUE;
+    dsm[1].data.keyFrameData.fieldCount = 1;
+    dsm[1].data.keyFrameData.dataSetFields = &fields[2];
+    dsm[1].data.keyFrameData.fieldNames = &fieldNames[2];
+    UA_Double dv = 3.5;
+    UA_Variant_setScalar(&fields[2].value, &dv, &UA_TYPES[UA_TYPES_DOUBLE]);
+    fields[2].hasValue = true;
+    fields[2].hasStatus = true;
+    fields[2].status = UA_STATUSCODE_UNCERTAIN;
+
+    UA_NetworkMessageJsonTemplate tmpl;
+    UA_StatusCode rv = UA_NetworkMessage_generateJsonTemplate(&m, &tmpl);
+    ck_assert_int_eq(rv, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(tmpl.gapsSize, 7);
+    checkJsonTemplate(&tmpl, &m);
+
+    /* New values. The string outgrows the reused buffer. */
+    dsm[0].header.dataSetMessageSequenceNr = 5;
+    dsm[0].header.timestamp = 22222222222222;
+    dsm[1].header.dataSetMessageSequenceNr = 65535;
+    iv = 4000000000;
+    sv = UA_STRING("A much longer string value that does not fit in the "
+                   "buffer of the first message");
+    fields[2].hasStatus = false;
+    checkJsonTemplate(&tmpl, &m);
+
+    /* Layout changes are detected */
+    dsm[1].header.timestampEnabled = true;
+    ck_assert(!UA_NetworkMessageJsonTemplate_matches(&tmpl, &m));
+    dsm[1].header.timestampEnabled = false;
+    dsWriterIds[1] = 679;
+    ck_assert(!UA_NetworkMessageJsonTemplate_matches(&tmpl, &m));
+    dsWriterIds[1] = 678;
+    m.payloadHeader.dataSetPayloadHeader.count = 1;
+    ck_assert(!UA_NetworkMessageJsonTemplate_matches(&tmpl, &m));
+
+    UA_NetworkMessageJsonTemplate_clear(&tmpl);
+}
+END_TEST
+
 static Suite *testSuite_networkmessage(void) {
     Suite *s = suite_create("Built-in Data Types 62541-6 Json");
     TCase *tc_json_networkmessage = tcase_create("networkmessage_json");
@@ -384,8 +559,10 @@ static Suite *testSuite_networkmessage(void) {
     tcase_add_test(tc_json_networkmessage, UA_PubSub_EnDecode);
     tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_oneMessage_twoFields_json_decode);
     tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_json_decode);
+    tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_json_decodeWithMetaData);
     tcase_add_test(tc_json_networkmessage, UA_Networkmessage_DataSetFieldsNull_json_decode);
     tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_fieldNames_json_decode);
+    tcase_add_test(tc_json_networkmessage, UA_NetworkMessage_json_template);
 
     suite_add_tcase(s, tc_json_networkmessage);
     return s;
@@ -7,6 +7,7 @@
 
 #include <open62541/server_config_default.h>
 #include <open62541/server_pubsub.h>
+#include <open62541/plugin/log_stdout.h>
 #include <open62541/plugin/securitypolicy_default.h>
 
 #include "test_helpers.h"
@@ -14,6 +15,7 @@
 #include "ua_server_internal.h"
 
 #include <check.h>
+#include <stdlib.h>
 
 #define UA_AES128CTR_SIGNING_KEY_LENGTH 32
 #define UA_AES128CTR_KEY_LENGTH 16
@@ -122,14 +124,200 @@ START_TEST(SinglePublishDataSetField) {
     ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
 } END_TEST
 
+/* A key rollover swaps in a second context. The active context is never
+ * modified while it is in use. */
+START_TEST(KeyRolloverSwapsContexts) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup 1");
+    writerGroupConfig.publishingInterval = 10;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.securityMode = UA_MESSAGESECURITYMODE_SIGNANDENCRYPT;
+    writerGroupConfig.securityPolicy = &config->pubSubConfig.securityPolicies[0];
+    UA_StatusCode retVal =
+        UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_ByteString sk = {UA_AES128CTR_SIGNING_KEY_LENGTH, signingKey};
+    UA_ByteString ek = {UA_AES128CTR_KEY_LENGTH, encryptingKey};
+    UA_ByteString kn = {UA_AES128CTR_KEYNONCE_LENGTH, keyNonce};
+    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroup1);
+
+    retVal = UA_Server_setWriterGroupEncryptionKeys(server, writerGroup1, 1, sk, ek, kn);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    void *first = wg->securityPolicyContext;
+    ck_assert_ptr_ne(first, NULL);
+    ck_assert_ptr_eq(wg->retiredSecurityPolicyContext, NULL);
+
+    /* Rollover into a new context */
+    retVal = UA_Server_setWriterGroupEncryptionKeys(server, writerGroup1, 2, sk, ek, kn);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    void *second = wg->securityPolicyContext;
+    ck_assert_ptr_ne(second, NULL);
+    ck_assert_ptr_ne(second, first);
+    ck_assert_ptr_eq(wg->retiredSecurityPolicyContext, first);
+    ck_assert_uint_eq(wg->securityTokenId, 2);
+
+    /* The retired context is reused */
+    retVal = UA_Server_setWriterGroupEncryptionKeys(server, writerGroup1, 3, sk, ek, kn);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(wg->securityPolicyContext, first);
+    ck_assert_ptr_eq(wg->retiredSecurityPolicyContext, second);
+
+    /* Invalid keys do not touch the active context */
+    UA_ByteString invalid = {UA_AES128CTR_KEY_LENGTH - 1, encryptingKey};
+    retVal = UA_Server_setWriterGroupEncryptionKeys(server, writerGroup1, 4, sk, invalid, kn);
+    ck_assert_int_ne(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(wg->securityPolicyContext, first);
+    ck_assert_uint_eq(wg->securityTokenId, 3);
+} END_TEST
+
+/* Encryption with a precomputed keystream gives the same result. Also for
+ * messages longer than the precomputed keystream. */
+START_TEST(PrecomputedKeystream) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_PubSubSecurityPolicy *sp = &config->pubSubConfig.securityPolicies[0];
+    ck_assert(sp->precomputeKeystream != NULL);
+
+    UA_ByteString sk = {UA_AES128CTR_SIGNING_KEY_LENGTH, signingKey};
+    UA_ByteString ek = {UA_AES128CTR_KEY_LENGTH, encryptingKey};
+    UA_ByteString kn = {UA_AES128CTR_KEYNONCE_LENGTH, keyNonce};
+    void *ctx = NULL;
+    UA_StatusCode retVal = sp->newContext(sp->policyContext, &sk, &ek, &kn, &ctx);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_Byte nonceData[8] = {1, 2, 3, 4, 0, 0, 0, 1};
+    UA_ByteString nonce = {8, nonceData};
+    UA_Byte plain[50];
+    for(size_t i = 0; i < sizeof(plain); i++)
+        plain[i] = (UA_Byte)i;
+
+    /* Reference without precomputation */
+    UA_Byte expected[50];
+    memcpy(expected, plain, sizeof(plain));
+    UA_ByteString buf = {sizeof(expected), expected};
+    retVal = sp->setMessageNonce(ctx, &nonce);
+    retVal |= sp->symmetricModule.cryptoModule.encryptionAlgorithm.encrypt(ctx, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* Precompute for a shorter message */
+    UA_Byte out[50];
+    memcpy(out, plain, sizeof(plain));
+    buf.data = out;
+    retVal = sp->precomputeKeystream(ctx, &nonce, 20);
+    retVal |= sp->setMessageNonce(ctx, &nonce);
+    retVal |= sp->symmetricModule.cryptoModule.encryptionAlgorithm.encrypt(ctx, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(memcmp(out, expected, sizeof(out)) == 0);
+
+    /* Precompute for a longer message */
+    memcpy(out, plain, sizeof(plain));
+    retVal = sp->precomputeKeystream(ctx, &nonce, 100);
+    retVal |= sp->symmetricModule.cryptoModule.encryptionAlgorithm.encrypt(ctx, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(memcmp(out, expected, sizeof(out)) == 0);
+
+    /* New keys discard the precomputed keystream */
+    UA_Byte otherKey[UA_AES128CTR_KEY_LENGTH];
+    memset(otherKey, 0xab, sizeof(otherKey));
+    UA_ByteString ek2 = {UA_AES128CTR_KEY_LENGTH, otherKey};
+    retVal = sp->setSecurityKeys(ctx, &sk, &ek2, &kn);
+    memcpy(out, plain, sizeof(plain));
+    retVal |= sp->symmetricModule.cryptoModule.encryptionAlgorithm.encrypt(ctx, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(memcmp(out, expected, sizeof(out)) != 0);
+
+    sp->deleteContext(ctx);
+} END_TEST
+
+#ifdef UA_ENABLE_TPM2_SECURITY
+
+/* Runs only with a PKCS#11 token set up as in
+ * examples/pubsub/README_pubsub_tpm2_pkcs11.txt. The slot is taken from
+ * UA_TPM2_SLOTID. The pin and the key labels default to the README. */
+static const char *
+tpmSetting(const char *name, const char *defaultValue) {
+    const char *value = getenv(name);
+    return (value) ? value : defaultValue;
+}
+
+/* The contexts share the session and the key handles of the policy. Deleting a
+ * context keeps them open for the others. Messages longer than 255 bytes are
+ * en- and decrypted completely. */
+START_TEST(TPMContextsShareSession) {
+    const char *slot = getenv("UA_TPM2_SLOTID");
+    if(!slot)
+        return;
+    char *pin = (char*)(uintptr_t)tpmSetting("UA_TPM2_USERPIN", "123456");
+    char *encLabel = (char*)(uintptr_t)tpmSetting("UA_TPM2_ENCRYPTION_KEY", "enc_key");
+    char *signLabel = (char*)(uintptr_t)tpmSetting("UA_TPM2_SIGNING_KEY", "sign_key");
+
+    UA_PubSubSecurityPolicy sp;
+    UA_StatusCode retVal =
+        UA_PubSubSecurityPolicy_Aes128CtrTPM(&sp, pin, strtoul(slot, NULL, 10),
+                                             encLabel, signLabel, UA_Log_Stdout);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    /* Empty keys. The key objects are looked up by their label. */
+    UA_ByteString kn = {UA_AES128CTR_KEYNONCE_LENGTH, keyNonce};
+    void *ctx1 = NULL;
+    void *ctx2 = NULL;
+    retVal = sp.newContext(sp.policyContext, &UA_BYTESTRING_NULL,
+                           &UA_BYTESTRING_NULL, &kn, &ctx1);
+    retVal |= sp.newContext(sp.policyContext, &UA_BYTESTRING_NULL,
+                            &UA_BYTESTRING_NULL, &kn, &ctx2);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_Byte nonceData[8] = {1, 2, 3, 4, 0, 0, 0, 1};
+    UA_ByteString nonce = {8, nonceData};
+    UA_Byte plain[300];
+    for(size_t i = 0; i < sizeof(plain); i++)
+        plain[i] = (UA_Byte)i;
+    UA_Byte msg[300];
+    memcpy(msg, plain, sizeof(plain));
+    UA_ByteString buf = {sizeof(msg), msg};
+
+    retVal = sp.setMessageNonce(ctx1, &nonce);
+    retVal |= sp.symmetricModule.cryptoModule.encryptionAlgorithm.encrypt(ctx1, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(memcmp(&msg[256], &plain[256], sizeof(plain) - 256) != 0);
+    sp.deleteContext(ctx1);
+
+    /* The other context still works after ctx1 was deleted */
+    retVal = sp.setMessageNonce(ctx2, &nonce);
+    retVal |= sp.symmetricModule.cryptoModule.encryptionAlgorithm.decrypt(ctx2, &buf);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert(memcmp(msg, plain, sizeof(plain)) == 0);
+
+    UA_Byte sigData[UA_AES128CTR_SIGNING_KEY_LENGTH];
+    UA_ByteString sig = {sizeof(sigData), sigData};
+    retVal = sp.symmetricModule.cryptoModule.signatureAlgorithm.sign(ctx2, &buf, &sig);
+    retVal |= sp.symmetricModule.cryptoModule.signatureAlgorithm.verify(ctx2, &buf, &sig);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    sp.deleteContext(ctx2);
+    sp.clear(&sp);
+} END_TEST
+
+#endif
+
 int main(void) {
     TCase *tc_pubsub_publish = tcase_create("PubSub publish DataSetFields");
     tcase_add_checked_fixture(tc_pubsub_publish, setup, teardown);
     tcase_add_test(tc_pubsub_publish, SinglePublishDataSetField);
+    tcase_add_test(tc_pubsub_publish, KeyRolloverSwapsContexts);
+    tcase_add_test(tc_pubsub_publish, PrecomputedKeystream);
 
     Suite *s = suite_create("PubSub WriterGroups/Writer/Fields handling and publishing");
     suite_add_tcase(s, tc_pubsub_publish);
 
+#ifdef UA_ENABLE_TPM2_SECURITY
+    TCase *tc_tpm = tcase_create("PubSub TPM security policy");
+    tcase_add_test(tc_tpm, TPMContextsShareSession);
+    suite_add_tcase(s, tc_tpm);
+#endif
+
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
     srunner_run_all(sr,CK_NORMAL);
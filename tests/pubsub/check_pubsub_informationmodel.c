@@ -23,7 +23,7 @@ UA_Server *server = NULL;
 
 UA_NodeId connection1, connection2, writerGroup1, writerGroup2, writerGroup3,
         publishedDataSet1, publishedDataSet2, dataSetWriter1, dataSetWriter2, dataSetWriter3,
-        dataSetWriter4, readerGroup1, dataSetReader1;
+        dataSetWriter4, readerGroup1, dataSetReader1, dataSetReader2;
 
 static void setup(void) {
     server = UA_Server_newForUnitTest();
@@ -512,6 +512,60 @@ START_TEST(ReadDataSetWriterIdWGAndCompareWithInternalValue){
     UA_Variant_clear(&value);
     } END_TEST
 
+START_TEST(LazyInformationModelMaterializesOnBrowse){
+    UA_Server_getConfig(server)->pubSubConfig.lazyInformationModel = true;
+    addPubSubConnection(UA_STRING("Connection 1"), UA_STRING("opc.udp://224.0.0.22:4840/"), &connection1);
+    addPublishedDataSet(UA_STRING("PublishedDataSet 1"), &publishedDataSet1);
+    addWriterGroup(connection1, UA_STRING("WriterGroup 1"), 100, &writerGroup1);
+    addDataSetWriter(writerGroup1, publishedDataSet1, UA_STRING("DataSetWriter 1"), &dataSetWriter1);
+    addReaderGroup(connection1, UA_STRING("ReaderGroup 1"), &readerGroup1);
+    addDataSetReader(readerGroup1, UA_STRING("DataSetReader 1"), &dataSetReader1);
+    addDataSetReader(readerGroup1, UA_STRING("DataSetReader 2"), &dataSetReader2);
+
+    /* The groups are eager. The writer and reader nodes are not yet added. */
+    UA_NodeClass nc;
+    ck_assert_int_eq(UA_Server_readNodeClass(server, readerGroup1, &nc), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetReader1, &nc),
+                     UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetWriter1, &nc),
+                     UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Removing a reader that was never materialized */
+    ck_assert_int_eq(UA_Server_removeDataSetReader(server, dataSetReader2), UA_STATUSCODE_GOOD);
+
+    /* Browsing the ReaderGroup materializes the reader */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = readerGroup1;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_int_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(UA_NodeId_equal(&br.references[i].nodeId.nodeId, &dataSetReader1))
+            found = true;
+    }
+    ck_assert(found);
+    UA_BrowseResult_clear(&br);
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetReader1, &nc), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetWriter1, &nc),
+                     UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Translating a browse path below the writer materializes the writer */
+    UA_NodeId writerIdNode =
+        findSingleChildNode(server, UA_QUALIFIEDNAME(0, "DataSetWriterId"),
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY), dataSetWriter1);
+    ck_assert(!UA_NodeId_isNull(&writerIdNode));
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetWriter1, &nc), UA_STATUSCODE_GOOD);
+    UA_NodeId_clear(&writerIdNode);
+
+    /* Materialized nodes are deleted with the component */
+    ck_assert_int_eq(UA_Server_removeDataSetReader(server, dataSetReader1), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(UA_Server_readNodeClass(server, dataSetReader1, &nc),
+                     UA_STATUSCODE_BADNODEIDUNKNOWN);
+    } END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_informationmodel = tcase_create("PubSub add single elements and check information model representation");
     tcase_add_checked_fixture(tc_add_pubsub_informationmodel, setup, teardown);
@@ -527,6 +581,7 @@ int main(void) {
     tcase_add_test(tc_add_pubsub_informationmodel, AddSingleDataSetReaderAndCheckInformationModelRepresentation);
     tcase_add_test(tc_add_pubsub_informationmodel, AddRemoveAddSingleDataSetReaderAndCheckInformationModelRepresentation);
     tcase_add_test(tc_add_pubsub_informationmodel, AddRemoveAddSingleReaderGroupAndCheckInformationModelRepresentation);
+    tcase_add_test(tc_add_pubsub_informationmodel, LazyInformationModelMaterializesOnBrowse);
 
     TCase *tc_add_pubsub_writergroupelements = tcase_create("PubSub WriterGroup check properties");
     tcase_add_checked_fixture(tc_add_pubsub_writergroupelements, setup, teardown);
@@ -520,6 +520,175 @@ START_TEST(PublishDataSetFieldAsDeltaFrame){
         ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
     } END_TEST
 
+static void
+addDeltaTestVariable(UA_UInt32 id) {
+    UA_Int32 zero = 0;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retVal =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, id),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "DeltaVariable"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("DeltaVariable");
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable = UA_NODEID_NUMERIC(1, id);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    retVal = UA_Server_addDataSetField(server, publishedDataSet1, &dataSetFieldConfig, NULL).result;
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+static UA_StatusCode
+generateDeltaTestMessage(UA_DataSetMessage *dsm, UA_DataSetWriter *dsw) {
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode res = UA_DataSetWriter_generateDataSetMessage(server, dsm, dsw);
+    UA_UNLOCK(&server->serviceMutex);
+    return res;
+}
+
+START_TEST(DeltaFrameContainsOnlyChangedFields){
+        setupPublishedDataSetTestEnvironment();
+        addDeltaTestVariable(50001);
+        addDeltaTestVariable(50002);
+        addDeltaTestVariable(50003);
+        setupDataSetFieldTestEnvironment();
+        UA_DataSetWriter *dsw = UA_DataSetWriter_findDSWbyId(server, dataSetWriter1);
+        dsw->config.keyFrameCount = 3;
+
+        /* The first message is a key frame with all fields */
+        UA_DataSetMessage dsm;
+        UA_StatusCode retVal = generateDeltaTestMessage(&dsm, dsw);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+        ck_assert_uint_eq(dsm.data.keyFrameData.fieldCount, 3);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* Only the changed field is sent */
+        UA_Int32 val = 42;
+        UA_Variant var;
+        UA_Variant_setScalar(&var, &val, &UA_TYPES[UA_TYPES_INT32]);
+        retVal = UA_Server_writeValue(server, UA_NODEID_NUMERIC(1, 50002), var);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        retVal = generateDeltaTestMessage(&dsm, dsw);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, 1);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.deltaFrameFields[0].fieldIndex, 1);
+        ck_assert_int_eq(*(UA_Int32*)dsm.data.deltaFrameData.deltaFrameFields[0].
+                         fieldValue.value.data, 42);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* No changes, no fields */
+        retVal = generateDeltaTestMessage(&dsm, dsw);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATADELTAFRAME);
+        ck_assert_uint_eq(dsm.data.deltaFrameData.fieldCount, 0);
+        UA_DataSetMessage_clear(&dsm);
+
+        /* Every keyFrameCount'th message is a key frame */
+        retVal = generateDeltaTestMessage(&dsm, dsw);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(dsm.header.dataSetMessageType, UA_DATASETMESSAGE_DATAKEYFRAME);
+        ck_assert_uint_eq(dsm.data.keyFrameData.fieldCount, 3);
+        UA_DataSetMessage_clear(&dsm);
+    } END_TEST
+
+static size_t
+countPublishSchedules(UA_NodeId connectionId) {
+    size_t count = 0;
+    UA_PubSubPublishSchedule *ps;
+    LIST_FOREACH(ps, &UA_PubSubConnection_findConnectionbyId(server, connectionId)->publishSchedules, listEntry){
+        count++;
+    }
+    return count;
+}
+
+START_TEST(PublishWriterGroupsInSharedSchedule){
+        UA_PublishedDataSetConfig pdsConfig;
+        UA_StatusCode retVal = UA_STATUSCODE_GOOD;
+        memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+        pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+        pdsConfig.name = UA_STRING(publishedDataSet1Name);
+        retVal |= UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet1).addResult;
+
+        UA_DataSetFieldConfig dataSetFieldConfig;
+        memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+        dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+        dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Server localtime");
+        dataSetFieldConfig.field.variable.publishParameters.publishedVariable = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+        dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+        retVal |= UA_Server_addDataSetField(server, publishedDataSet1, &dataSetFieldConfig, NULL).result;
+
+        /* Two WriterGroups with the same interval and one with a different
+         * interval on the same connection */
+        UA_WriterGroupConfig writerGroupConfig;
+        memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+        writerGroupConfig.name = UA_STRING("WriterGroup 1");
+        writerGroupConfig.publishingInterval = 10;
+        writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+        writerGroupConfig.writerGroupId = 1;
+        retVal |= UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup1);
+        writerGroupConfig.name = UA_STRING("WriterGroup 2");
+        writerGroupConfig.writerGroupId = 2;
+        retVal |= UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup2);
+        writerGroupConfig.name = UA_STRING("WriterGroup 3");
+        writerGroupConfig.writerGroupId = 3;
+        writerGroupConfig.publishingInterval = 20;
+        retVal |= UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup3);
+
+        UA_DataSetWriterConfig dataSetWriterConfig;
+        memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+        dataSetWriterConfig.name = UA_STRING("DataSetWriter 1");
+        dataSetWriterConfig.dataSetWriterId = 1;
+        retVal |= UA_Server_addDataSetWriter(server, writerGroup1, publishedDataSet1, &dataSetWriterConfig, &dataSetWriter1);
+        dataSetWriterConfig.dataSetWriterId = 2;
+        retVal |= UA_Server_addDataSetWriter(server, writerGroup2, publishedDataSet1, &dataSetWriterConfig, &dataSetWriter2);
+        dataSetWriterConfig.dataSetWriterId = 3;
+        retVal |= UA_Server_addDataSetWriter(server, writerGroup3, publishedDataSet1, &dataSetWriterConfig, &dataSetWriter3);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        retVal |= UA_Server_enableWriterGroup(server, writerGroup1);
+        retVal |= UA_Server_enableWriterGroup(server, writerGroup2);
+        retVal |= UA_Server_enableWriterGroup(server, writerGroup3);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        UA_WriterGroup *wg1 = UA_WriterGroup_findWGbyId(server, writerGroup1);
+        UA_WriterGroup *wg2 = UA_WriterGroup_findWGbyId(server, writerGroup2);
+        UA_WriterGroup *wg3 = UA_WriterGroup_findWGbyId(server, writerGroup3);
+        ck_assert_uint_eq(wg1->state, UA_PUBSUBSTATE_OPERATIONAL);
+        ck_assert(wg1->publishSchedule != NULL);
+        ck_assert(wg1->publishSchedule == wg2->publishSchedule);
+        ck_assert(wg1->publishSchedule != wg3->publishSchedule);
+        ck_assert_uint_eq(wg1->publishSchedule->writerGroupsSize, 2);
+        ck_assert_uint_eq(countPublishSchedules(connection1), 2);
+
+        /* Both WriterGroups are published from the shared cyclic callback */
+        for(size_t i = 0; i < 100; i++) {
+            if(wg1->lastPublishTimeStamp != 0 && wg2->lastPublishTimeStamp != 0)
+                break;
+            UA_fakeSleep(5);
+            UA_Server_run_iterate(server, false);
+        }
+        ck_assert(wg1->lastPublishTimeStamp != 0);
+        ck_assert(wg2->lastPublishTimeStamp != 0);
+        ck_assert(server->pubSubManager.samples == NULL);
+
+        /* The schedule is removed with the last WriterGroup */
+        retVal |= UA_Server_setWriterGroupDisabled(server, writerGroup2);
+        ck_assert_uint_eq(wg1->publishSchedule->writerGroupsSize, 1);
+        retVal |= UA_Server_setWriterGroupDisabled(server, writerGroup3);
+        ck_assert_uint_eq(countPublishSchedules(connection1), 1);
+        retVal |= UA_Server_setWriterGroupDisabled(server, writerGroup1);
+        ck_assert_uint_eq(countPublishSchedules(connection1), 0);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    } END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_writergroup = tcase_create("PubSub WriterGroup items handling");
     tcase_add_checked_fixture(tc_add_pubsub_writergroup, setup, teardown);
@@ -552,6 +721,8 @@ int main(void) {
     tcase_add_checked_fixture(tc_pubsub_publish, setup, teardown);
     tcase_add_test(tc_pubsub_publish, SinglePublishDataSetFieldAndPublishTimestampTest);
     tcase_add_test(tc_pubsub_publish, PublishDataSetFieldAsDeltaFrame);
+    tcase_add_test(tc_pubsub_publish, DeltaFrameContainsOnlyChangedFields);
+    tcase_add_test(tc_pubsub_publish, PublishWriterGroupsInSharedSchedule);
 
     Suite *s = suite_create("PubSub WriterGroups/Writer/Fields handling and publishing");
     suite_add_tcase(s, tc_add_pubsub_writergroup);
@@ -93,10 +93,69 @@ START_TEST(SinglePublishDataSetField){
     UA_WriterGroup_publishCallback(server, wg);
 } END_TEST
 
+/* The frozen configuration publishes from a preformatted template */
+START_TEST(FrozenPublishDataSetField){
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(writerGroupConfig));
+    writerGroupConfig.name = UA_STRING("WriterGroup 1");
+    writerGroupConfig.publishingInterval = 10;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_JSON;
+    UA_StatusCode retVal =
+        UA_Server_addWriterGroup(server, connection1, &writerGroupConfig, &writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("PublishedDataSet 1");
+    UA_AddPublishedDataSetResult result =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &publishedDataSet1);
+    ck_assert_int_eq(result.addResult, UA_STATUSCODE_GOOD);
+
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING("Server localtime");
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable =
+        UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataSetFieldResult dsFieldResult =
+        UA_Server_addDataSetField(server, publishedDataSet1, &dataSetFieldConfig, NULL);
+    ck_assert_int_eq(dsFieldResult.result, UA_STATUSCODE_GOOD);
+
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(dataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("DataSetWriter 1");
+    retVal = UA_Server_addDataSetWriter(server, writerGroup1, publishedDataSet1,
+                                        &dataSetWriterConfig, &dataSetWriter1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    retVal = UA_Server_freezeWriterGroupConfiguration(server, writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    retVal = UA_Server_enableWriterGroup(server, writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+    UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroup1);
+    ck_assert(wg != 0);
+    ck_assert_uint_eq(wg->jsonTemplatesSize, 0);
+    for(size_t i = 0; i < 3; i++) {
+        UA_Server_run_iterate(server, false);
+        UA_WriterGroup_publishCallback(server, wg);
+    }
+    ck_assert_uint_eq(wg->state, UA_PUBSUBSTATE_OPERATIONAL);
+    ck_assert_uint_eq(wg->jsonTemplatesSize, 1);
+    ck_assert_uint_eq(wg->sequenceNumber, 3);
+
+    retVal = UA_Server_unfreezeWriterGroupConfiguration(server, writerGroup1);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(wg->jsonTemplatesSize, 0);
+} END_TEST
+
 int main(void) {
     TCase *tc_pubsub_publish = tcase_create("PubSub publish");
     tcase_add_checked_fixture(tc_pubsub_publish, setup, teardown);
     tcase_add_test(tc_pubsub_publish, SinglePublishDataSetField);
+    tcase_add_test(tc_pubsub_publish, FrozenPublishDataSetField);
 
     Suite *s = suite_create("PubSub publishing json via udp");
     suite_add_tcase(s, tc_pubsub_publish);
@@ -376,6 +376,103 @@ START_TEST(PublishSingleFieldInCustomCallback) {
         UA_Server_run_iterate(server, false);
 } END_TEST
 
+static UA_ServerCallback deterministicCallback;
+static void *deterministicData;
+
+static UA_StatusCode
+addDeterministicCallback(UA_Server *srv, UA_NodeId identifier,
+                         UA_ServerCallback callback, void *data,
+                         UA_Double interval_ms, UA_DateTime *baseTime,
+                         UA_TimerPolicy timerPolicy, UA_UInt64 *callbackId) {
+    deterministicCallback = callback;
+    deterministicData = data;
+    *callbackId = 1;
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removeDeterministicCallback(UA_Server *srv, UA_NodeId identifier,
+                            UA_UInt64 callbackId) {
+    deterministicCallback = NULL;
+    deterministicData = NULL;
+}
+
+static void
+addDeterministicWriterGroup(UA_Boolean customCallback) {
+    ck_assert(addMinimalPubSubConfiguration() == UA_STATUSCODE_GOOD);
+    UA_WriterGroupConfig writerGroupConfig;
+    memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+    writerGroupConfig.name = UA_STRING("Demo WriterGroup");
+    writerGroupConfig.publishingInterval = PUBLISH_INTERVAL;
+    writerGroupConfig.enabled = UA_FALSE;
+    writerGroupConfig.writerGroupId = 100;
+    writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    writerGroupConfig.rtLevel = UA_PUBSUB_RT_DETERMINISTIC;
+    if(customCallback) {
+        writerGroupConfig.pubsubManagerCallback.addCustomCallback =
+            addDeterministicCallback;
+        writerGroupConfig.pubsubManagerCallback.removeCustomCallback =
+            removeDeterministicCallback;
+    }
+    UA_UadpWriterGroupMessageDataType *wgm = UA_UadpWriterGroupMessageDataType_new();
+    wgm->networkMessageContentMask = UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER;
+    writerGroupConfig.messageSettings.content.decoded.data = wgm;
+    writerGroupConfig.messageSettings.content.decoded.type =
+        &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE];
+    writerGroupConfig.messageSettings.encoding = UA_EXTENSIONOBJECT_DECODED;
+    ck_assert(UA_Server_addWriterGroup(server, connectionIdentifier, &writerGroupConfig, &writerGroupIdent) == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_enableWriterGroup(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+    UA_UadpWriterGroupMessageDataType_delete(wgm);
+    UA_DataSetWriterConfig dataSetWriterConfig;
+    memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dataSetWriterConfig.name = UA_STRING("Test DataSetWriter");
+    dataSetWriterConfig.dataSetWriterId = 62541;
+    UA_DataSetFieldConfig dsfConfig;
+    memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+    UA_UInt32 *intValue = UA_UInt32_new();
+    *intValue = (UA_UInt32) 1000;
+    staticSource1 = UA_DataValue_new();
+    UA_Variant_setScalar(&staticSource1->value, intValue, &UA_TYPES[UA_TYPES_UINT32]);
+    dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = UA_TRUE;
+    dsfConfig.field.variable.rtValueSource.staticValueSource = &staticSource1;
+    dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    ck_assert(UA_Server_addDataSetField(server, publishedDataSetIdent, &dsfConfig, &dataSetFieldIdent).result == UA_STATUSCODE_GOOD);
+    ck_assert(UA_Server_addDataSetWriter(server, writerGroupIdent, publishedDataSetIdent, &dataSetWriterConfig, &dataSetWriterIdent) == UA_STATUSCODE_GOOD);
+    UA_fakeSleep(50 + 1);
+    UA_Server_run_iterate(server, true);
+}
+
+/* The deterministic RT level runs the publish cycle in the custom callback
+ * without taking the server lock */
+START_TEST(PublishDeterministicInCustomCallback) {
+        addDeterministicWriterGroup(true);
+        ck_assert(UA_Server_freezeWriterGroupConfiguration(server, writerGroupIdent) == UA_STATUSCODE_GOOD);
+        ck_assert(deterministicCallback != NULL);
+
+        UA_LOCK(&server->serviceMutex);
+        UA_WriterGroup *wg = UA_WriterGroup_findWGbyId(server, writerGroupIdent);
+        UA_UNLOCK(&server->serviceMutex);
+        ck_assert(wg != NULL);
+        UA_UInt16 sequenceNumber = wg->sequenceNumber;
+
+        /* Change the value in place between the cycles */
+        for(UA_UInt32 i = 0; i < 3; i++) {
+            *(UA_UInt32*)staticSource1->value.data = 1000 + i;
+            deterministicCallback(server, deterministicData);
+        }
+        ck_assert_uint_eq(wg->sequenceNumber, (UA_UInt16)(sequenceNumber + 3));
+        ck_assert_uint_eq(wg->state, UA_PUBSUBSTATE_OPERATIONAL);
+
+        UA_Server_run_iterate(server, false);
+} END_TEST
+
+/* The deterministic RT level cannot be frozen without a custom callback */
+START_TEST(FreezeDeterministicWithoutCustomCallback) {
+        addDeterministicWriterGroup(false);
+        ck_assert(UA_Server_freezeWriterGroupConfiguration(server, writerGroupIdent) == UA_STATUSCODE_BADNOTSUPPORTED);
+        UA_Server_run_iterate(server, false);
+} END_TEST
+
 static UA_StatusCode
 simpleNotificationRead(UA_Server *srv, const UA_NodeId *sessionId,
                        void *sessionContext, const UA_NodeId *nodeid,
@@ -559,9 +656,15 @@ int main(void) {
     tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishPDSWithMultipleFieldsAndFixedOffset);
     tcase_add_test(tc_pubsub_rt_fixed_offsets, PublishSingleFieldInCustomCallback);
 
+    TCase *tc_pubsub_rt_deterministic = tcase_create("PubSub RT publish deterministic");
+    tcase_add_checked_fixture(tc_pubsub_rt_deterministic, setup, teardown);
+    tcase_add_test(tc_pubsub_rt_deterministic, PublishDeterministicInCustomCallback);
+    tcase_add_test(tc_pubsub_rt_deterministic, FreezeDeterministicWithoutCustomCallback);
+
     Suite *s = suite_create("PubSub RT configuration levels");
     suite_add_tcase(s, tc_pubsub_rt_static_value_source);
     suite_add_tcase(s, tc_pubsub_rt_fixed_offsets);
+    suite_add_tcase(s, tc_pubsub_rt_deterministic);
 
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
@@ -2589,6 +2589,280 @@ START_TEST(InvalidConfiguredSizPublishSubscribe) {
         UA_Server_run_iterate(server, false);
 } END_TEST
 
+static void
+encodeInt32Message(UA_Int32 value, UA_UInt16 sequenceNumber, UA_Boolean timestamp,
+                   UA_UInt16 dataSetWriterId, UA_ByteString *buffer) {
+    UA_NetworkMessage nm;
+    memset(&nm, 0, sizeof(UA_NetworkMessage));
+    nm.version = 1;
+    nm.networkMessageType = UA_NETWORKMESSAGE_DATASET;
+    nm.publisherIdEnabled = true;
+    nm.publisherIdType = UA_PUBLISHERIDTYPE_UINT16;
+    nm.publisherId.uint16 = PUBLISHER_ID;
+    nm.groupHeaderEnabled = true;
+    nm.groupHeader.writerGroupIdEnabled = true;
+    nm.groupHeader.writerGroupId = WRITER_GROUP_ID;
+    nm.groupHeader.sequenceNumberEnabled = true;
+    nm.groupHeader.sequenceNumber = sequenceNumber;
+    nm.timestampEnabled = timestamp;
+    nm.timestamp = UA_DateTime_now();
+    nm.payloadHeaderEnabled = true;
+    nm.payloadHeader.dataSetPayloadHeader.count = 1;
+    nm.payloadHeader.dataSetPayloadHeader.dataSetWriterIds = &dataSetWriterId;
+
+    UA_DataValue field;
+    UA_DataValue_init(&field);
+    UA_Variant_setScalar(&field.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    field.hasValue = true;
+    UA_DataSetMessage dsm;
+    memset(&dsm, 0, sizeof(UA_DataSetMessage));
+    dsm.header.dataSetMessageValid = true;
+    dsm.header.fieldEncoding = UA_FIELDENCODING_VARIANT;
+    dsm.header.dataSetMessageType = UA_DATASETMESSAGE_DATAKEYFRAME;
+    dsm.header.dataSetMessageSequenceNrEnabled = true;
+    dsm.header.dataSetMessageSequenceNr = sequenceNumber;
+    dsm.data.keyFrameData.fieldCount = 1;
+    dsm.data.keyFrameData.dataSetFields = &field;
+    nm.payload.dataSetPayload.dataSetMessages = &dsm;
+
+    UA_StatusCode res =
+        UA_ByteString_allocBuffer(buffer, UA_NetworkMessage_calcSizeBinary(&nm, NULL));
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_Byte *bufPos = buffer->data;
+    res = UA_NetworkMessage_encodeBinary(&nm, &bufPos, &buffer->data[buffer->length], NULL);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void
+processInt32Message(UA_PubSubConnection *c, UA_Int32 value, UA_UInt16 sequenceNumber,
+                    UA_Boolean timestamp, UA_UInt16 dataSetWriterId) {
+    UA_ByteString buffer;
+    encodeInt32Message(value, sequenceNumber, timestamp, dataSetWriterId, &buffer);
+    UA_LOCK(&server->serviceMutex);
+    UA_PubSubConnection_process(server, c, buffer);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_ByteString_clear(&buffer);
+}
+
+static UA_Int32
+readInt32(UA_UInt32 nodeId) {
+    UA_Variant out;
+    UA_StatusCode res = UA_Server_readValue(server, UA_NODEID_NUMERIC(1, nodeId), &out);
+    ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+    UA_Int32 value = -1;
+    if(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_INT32]))
+        value = *(UA_Int32*)out.data;
+    UA_Variant_clear(&out);
+    return value;
+}
+
+static void
+receiveInt32Message(UA_PubSubConnection *c, UA_Int32 value,
+                    UA_UInt16 sequenceNumber, UA_Boolean timestamp) {
+    processInt32Message(c, value, sequenceNumber, timestamp, DATASET_WRITER_ID);
+    ck_assert_int_eq(readInt32(SUBSCRIBEVARIABLE_NODEID), value);
+}
+
+/* Adds a DataSetReader with a single Int32 field and its target variable */
+static UA_NodeId
+addInt32Reader(UA_UInt16 dataSetWriterId, UA_UInt32 targetNodeId,
+               UA_DataValue **externalDataValue) {
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING("DataSetReader Test");
+    UA_UInt16 publisherIdentifier = PUBLISHER_ID;
+    readerConfig.publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
+    readerConfig.publisherId.data = &publisherIdentifier;
+    readerConfig.writerGroupId    = WRITER_GROUP_ID;
+    readerConfig.dataSetWriterId  = dataSetWriterId;
+    UA_DataSetMetaDataType *pMetaData = &readerConfig.dataSetMetaData;
+    UA_DataSetMetaDataType_init(pMetaData);
+    pMetaData->name = UA_STRING("DataSet Test");
+    pMetaData->fieldsSize = 1;
+    pMetaData->fields = (UA_FieldMetaData*)
+        UA_Array_new(pMetaData->fieldsSize, &UA_TYPES[UA_TYPES_FIELDMETADATA]);
+    UA_FieldMetaData_init(&pMetaData->fields[0]);
+    UA_NodeId_copy(&UA_TYPES[UA_TYPES_INT32].typeId, &pMetaData->fields[0].dataType);
+    pMetaData->fields[0].builtInType = UA_NS0ID_INT32;
+    pMetaData->fields[0].valueRank   = -1; /* scalar */
+    UA_NodeId readerIdentifier;
+    UA_StatusCode retVal =
+        UA_Server_addDataSetReader(server, readerGroupId, &readerConfig, &readerIdentifier);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_free(pMetaData->fields);
+
+    UA_NodeId newnodeId;
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    vAttr.displayName = UA_LOCALIZEDTEXT("en-US", "Subscribed Int32");
+    vAttr.dataType    = UA_TYPES[UA_TYPES_INT32].typeId;
+    retVal = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, targetNodeId), folderId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), UA_QUALIFIEDNAME(1, "Subscribed Int32"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE), vAttr, NULL, &newnodeId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    UA_FieldTargetVariable targetVar;
+    memset(&targetVar, 0, sizeof(UA_FieldTargetVariable));
+    UA_FieldTargetDataType_init(&targetVar.targetVariable);
+    targetVar.targetVariable.attributeId  = UA_ATTRIBUTEID_VALUE;
+    targetVar.targetVariable.targetNodeId = newnodeId;
+    targetVar.externalDataValue = externalDataValue;
+    retVal = UA_Server_DataSetReader_createTargetVariables(server, readerIdentifier,
+                                                           1, &targetVar);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+    return readerIdentifier;
+}
+
+static void
+addInt32ReaderGroup(void) {
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset(&readerGroupConfig, 0, sizeof(UA_ReaderGroupConfig));
+    readerGroupConfig.name = UA_STRING("ReaderGroup Test");
+    UA_StatusCode retVal =
+        UA_Server_addReaderGroup(server, connectionId, &readerGroupConfig, &readerGroupId);
+    ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+}
+
+/* Returns the stable template that was used for the last decoding */
+static UA_PubSubDecodeTemplate *
+findDecodeTemplate(UA_PubSubConnection *c, UA_UInt16 sequenceNumber) {
+    for(size_t i = 0; i < UA_PUBSUB_DECODETEMPLATES; i++) {
+        UA_PubSubDecodeTemplate *t = &c->decodeTemplates[i];
+        if(t->matches >= UA_PUBSUB_DECODETEMPLATE_STABLE && t->offsetBuffer.nm &&
+           t->offsetBuffer.nm->groupHeader.sequenceNumber == sequenceNumber)
+            return t;
+    }
+    return NULL;
+}
+
+START_TEST(SubscribeWithDecodeTemplate) {
+        addInt32ReaderGroup();
+        addInt32Reader(DATASET_WRITER_ID, SUBSCRIBEVARIABLE_NODEID, NULL);
+        UA_StatusCode retVal = UA_Server_enableReaderGroup(server, readerGroupId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        UA_PubSubConnection *c =
+            UA_PubSubConnection_findConnectionbyId(server, connectionId);
+        ck_assert(c != NULL);
+
+        /* The layout becomes a stable template */
+        UA_UInt16 seq = 0;
+        for(; seq <= UA_PUBSUB_DECODETEMPLATE_STABLE; seq++) {
+            receiveInt32Message(c, 100 + seq, seq, false);
+            ck_assert(findDecodeTemplate(c, seq) == NULL);
+        }
+
+        /* Decode with the template */
+        for(; seq < 2 * UA_PUBSUB_DECODETEMPLATE_STABLE; seq++) {
+            receiveInt32Message(c, 100 + seq, seq, false);
+            ck_assert(findDecodeTemplate(c, seq) != NULL);
+        }
+
+        /* A different layout is fully decoded */
+        receiveInt32Message(c, -1, seq, true);
+        ck_assert(findDecodeTemplate(c, seq) == NULL);
+        seq++;
+
+        /* The template is still used for the known layout */
+        receiveInt32Message(c, 5, seq, false);
+        ck_assert(findDecodeTemplate(c, seq) != NULL);
+} END_TEST
+
+#define INDEXED_READERS 50
+
+START_TEST(DispatchToIndexedReaders) {
+        addInt32ReaderGroup();
+        UA_NodeId readers[INDEXED_READERS];
+        for(UA_UInt16 i = 0; i < INDEXED_READERS; i++)
+            readers[i] = addInt32Reader(i + 1, 2000 + i, NULL);
+        UA_StatusCode retVal = UA_Server_enableReaderGroup(server, readerGroupId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+
+        UA_PubSubConnection *c =
+            UA_PubSubConnection_findConnectionbyId(server, connectionId);
+        ck_assert(c != NULL);
+
+        /* Only the reader with the matching DataSetWriterId receives */
+        processInt32Message(c, 7, 0, false, 10);
+        for(UA_UInt16 i = 0; i < INDEXED_READERS; i++)
+            ck_assert_int_eq(readInt32(2000 + i), (i + 1 == 10) ? 7 : 0);
+
+        /* Update the DataSetWriterId of the reader */
+        UA_DataSetReaderConfig readerConfig;
+        retVal = UA_Server_DataSetReader_getConfig(server, readers[9], &readerConfig);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        readerConfig.dataSetWriterId = 1000;
+        retVal = UA_Server_DataSetReader_updateConfig(server, readers[9], readerGroupId,
+                                                      &readerConfig);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_DataSetReaderConfig_clear(&readerConfig);
+
+        processInt32Message(c, 8, 1, false, 10);
+        ck_assert_int_eq(readInt32(2009), 7);
+        processInt32Message(c, 9, 2, false, 1000);
+        ck_assert_int_eq(readInt32(2009), 9);
+
+        /* A removed reader no longer receives */
+        retVal = UA_Server_removeDataSetReader(server, readers[9]);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        processInt32Message(c, 10, 3, false, 1000);
+        ck_assert_int_eq(readInt32(2009), 9);
+        processInt32Message(c, 11, 4, false, INDEXED_READERS);
+        ck_assert_int_eq(readInt32(2000 + INDEXED_READERS - 1), 11);
+} END_TEST
+
+static UA_UInt32 afterWriteCount;
+
+static void
+countAfterWrite(UA_Server *s, const UA_NodeId *readerId, const UA_NodeId *readerGroupId,
+                const UA_NodeId *targetVariableId, void *targetVariableContext,
+                UA_DataValue **externalDataValue) {
+    afterWriteCount++;
+}
+
+START_TEST(SubscribeIntoExternalDataValue) {
+        addInt32ReaderGroup();
+        UA_Int32 externalInt = 0;
+        UA_DataValue externalValue;
+        UA_DataValue_init(&externalValue);
+        UA_Variant_setScalar(&externalValue.value, &externalInt, &UA_TYPES[UA_TYPES_INT32]);
+        externalValue.hasValue = true;
+        UA_DataValue *externalValuePtr = &externalValue;
+        UA_NodeId reader =
+            addInt32Reader(DATASET_WRITER_ID, SUBSCRIBEVARIABLE_NODEID, &externalValuePtr);
+
+        /* Set the afterWrite callback of the target variable */
+        UA_DataSetReaderConfig readerConfig;
+        UA_StatusCode retVal = UA_Server_DataSetReader_getConfig(server, reader, &readerConfig);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_FieldTargetVariable *tv =
+            readerConfig.subscribedDataSet.subscribedDataSetTarget.targetVariables;
+        ck_assert(tv->externalDataValue == &externalValuePtr);
+        UA_DataSetReaderConfig_clear(&readerConfig);
+        UA_DataSetReader *dsr = UA_ReaderGroup_findDSRbyId(server, reader);
+        ck_assert(dsr != NULL);
+        dsr->config.subscribedDataSet.subscribedDataSetTarget.
+            targetVariables[0].afterWrite = countAfterWrite;
+
+        retVal = UA_Server_enableReaderGroup(server, readerGroupId);
+        ck_assert_int_eq(retVal, UA_STATUSCODE_GOOD);
+        UA_PubSubConnection *c =
+            UA_PubSubConnection_findConnectionbyId(server, connectionId);
+        ck_assert(c != NULL);
+
+        /* The value is copied into the external memory, not written into the node */
+        afterWriteCount = 0;
+        processInt32Message(c, 33, 0, false, DATASET_WRITER_ID);
+        ck_assert_int_eq(externalInt, 33);
+        ck_assert_uint_eq(afterWriteCount, 1);
+        ck_assert_int_eq(readInt32(SUBSCRIBEVARIABLE_NODEID), 0);
+
+        /* Mismatching types are written with the Write service */
+        externalValue.value.type = &UA_TYPES[UA_TYPES_UINT32];
+        processInt32Message(c, 34, 1, false, DATASET_WRITER_ID);
+        ck_assert_int_eq(externalInt, 33);
+        ck_assert_uint_eq(afterWriteCount, 1);
+        ck_assert_int_eq(readInt32(SUBSCRIBEVARIABLE_NODEID), 34);
+} END_TEST
+
 int main(void) {
     TCase *tc_add_pubsub_readergroup = tcase_create("PubSub readerGroup items handling");
     tcase_add_checked_fixture(tc_add_pubsub_readergroup, setup, teardown);
@@ -2631,6 +2905,9 @@ int main(void) {
     tcase_add_test(tc_pubsub_publish_subscribe, SinglePublishSubscribeWithoutPayloadHeader);
     tcase_add_test(tc_pubsub_publish_subscribe, MultiPublishSubscribeInt32);
     tcase_add_test(tc_pubsub_publish_subscribe, SinglePublishOnDemand);
+    tcase_add_test(tc_pubsub_publish_subscribe, SubscribeWithDecodeTemplate);
+    tcase_add_test(tc_pubsub_publish_subscribe, DispatchToIndexedReaders);
+    tcase_add_test(tc_pubsub_publish_subscribe, SubscribeIntoExternalDataValue);
 
 
     /*Test cases for the standalone datasets */
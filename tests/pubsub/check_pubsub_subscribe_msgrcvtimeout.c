@@ -1764,6 +1764,63 @@ START_TEST(Test_add_remove) {
 
 } END_TEST
 
+/* All readers of a ReaderGroup share one timer. Receiving a message moves
+ * only the deadline of the reader. */
+START_TEST(Test_shared_timer) {
+    UA_NodeId ConnId_1;
+    UA_NodeId_init(&ConnId_1);
+    AddConnection("Conn1", 1, &ConnId_1);
+
+    UA_NodeId RGId_Conn1_RG1;
+    UA_NodeId_init(&RGId_Conn1_RG1);
+    AddReaderGroup(&ConnId_1, "Conn1_RG1", &RGId_Conn1_RG1);
+
+    UA_NodeId DSRId_1, DSRId_2, VarId_1, VarId_2;
+    AddDataSetReader(&RGId_Conn1_RG1, "Conn1_RG1_DSR1", 1, 1, 1, 100.0, &VarId_1, &DSRId_1);
+    AddDataSetReader(&RGId_Conn1_RG1, "Conn1_RG1_DSR2", 1, 1, 2, 300.0, &VarId_2, &DSRId_2);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_ReaderGroup *rg = UA_ReaderGroup_findRGbyId(server, RGId_Conn1_RG1);
+    UA_DataSetReader *dsr1 = UA_ReaderGroup_findDSRbyId(server, DSRId_1);
+    UA_DataSetReader *dsr2 = UA_ReaderGroup_findDSRbyId(server, DSRId_2);
+    ck_assert(rg && dsr1 && dsr2);
+    UA_PubSubMonitoringInterface *mif = &server->config.pubSubConfig.monitoringInterface;
+
+    /* Start the supervision as for a received message */
+    ck_assert_uint_eq(mif->startMonitoring(server, DSRId_2, UA_PUBSUB_COMPONENT_DATASETREADER,
+                                           UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT,
+                                           dsr2), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(mif->startMonitoring(server, DSRId_1, UA_PUBSUB_COMPONENT_DATASETREADER,
+                                           UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT,
+                                           dsr1), UA_STATUSCODE_GOOD);
+    UA_UInt64 timerId = rg->msgRcvTimeoutTimerId;
+    ck_assert(timerId != 0);
+    ck_assert(rg->msgRcvTimeoutNextCheck == dsr1->msgRcvTimeoutDeadline);
+
+    /* The next message keeps the timer */
+    UA_fakeSleep(50);
+    mif->stopMonitoring(server, DSRId_1, UA_PUBSUB_COMPONENT_DATASETREADER,
+                        UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT, dsr1);
+    mif->startMonitoring(server, DSRId_1, UA_PUBSUB_COMPONENT_DATASETREADER,
+                         UA_PUBSUB_MONITORING_MESSAGE_RECEIVE_TIMEOUT, dsr1);
+    ck_assert(rg->msgRcvTimeoutTimerId == timerId);
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* The first check finds no expired deadline and re-arms */
+    ServerDoProcess("1", 60, 1);
+    ck_assert(dsr1->msgRcvTimeoutDeadline != 0);
+    ck_assert(rg->msgRcvTimeoutNextCheck == dsr1->msgRcvTimeoutDeadline);
+
+    /* The deadline of the first reader expires */
+    ServerDoProcess("2", 50, 1);
+    ck_assert(dsr1->msgRcvTimeoutDeadline == 0);
+    ck_assert(dsr2->msgRcvTimeoutDeadline != 0);
+    ck_assert(rg->msgRcvTimeoutNextCheck == dsr2->msgRcvTimeoutDeadline);
+
+    /* The timer is removed with the ReaderGroup */
+    ck_assert(UA_STATUSCODE_GOOD == UA_Server_removeReaderGroup(server, RGId_Conn1_RG1));
+} END_TEST
+
 static void
 PubSubStateChangeCallback_fast_path(UA_Server *hostServer, UA_NodeId *pubsubComponentId,
                                     UA_PubSubState state, UA_StatusCode reason) {
@@ -2049,6 +2106,7 @@ int main(void) {
         - add and remove a reader without any operation -> check for memory leaks
     */
     tcase_add_test(tc_basic, Test_add_remove);
+    tcase_add_test(tc_basic, Test_shared_timer);
 
     /* test case description:
         - test message receive timeout with fast-path
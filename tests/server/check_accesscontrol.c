@@ -4,6 +4,7 @@
 
 #include <open62541/client.h>
 #include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
 #include <open62541/plugin/accesscontrol_default.h>
@@ -89,6 +90,125 @@ START_TEST(Client_pass_fail) {
     UA_Client_delete(client);
 } END_TEST
 
+static size_t accessLevelCalls;
+static size_t browseCalls;
+static UA_Boolean denyAccess;
+
+static UA_Byte
+getUserAccessLevel_counting(UA_Server *s, UA_AccessControl *ac,
+                            const UA_NodeId *sessionId, void *sessionContext,
+                            const UA_NodeId *nodeId, void *nodeContext) {
+    accessLevelCalls++;
+    return denyAccess ? 0 : 0xFF;
+}
+
+static UA_Boolean
+allowBrowseNode_counting(UA_Server *s, UA_AccessControl *ac,
+                         const UA_NodeId *sessionId, void *sessionContext,
+                         const UA_NodeId *nodeId, void *nodeContext) {
+    browseCalls++;
+    return !denyAccess;
+}
+
+static void setupCache(void) {
+    accessLevelCalls = 0;
+    browseCalls = 0;
+    denyAccess = false;
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_SecurityPolicy *sp = &config->securityPolicies[config->securityPoliciesSize-1];
+    UA_AccessControl_default(config, true, &sp->policyUri,
+                             usernamePasswordsSize, usernamePasswords);
+    config->accessControl.getUserAccessLevel = getUserAccessLevel_counting;
+    config->accessControl.allowBrowseNode = allowBrowseNode_counting;
+    config->accessControl.cacheDecisions = true;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "cached"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "cached"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+START_TEST(Cache_readValue) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId nodeId = UA_NODEID_STRING(1, "cached");
+    UA_Variant val;
+    for(size_t i = 0; i < 3; i++) {
+        retval = UA_Client_readValueAttribute(client, nodeId, &val);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_int_eq(*(UA_Int32*)val.data, 42);
+        UA_Variant_clear(&val);
+    }
+    ck_assert_uint_eq(accessLevelCalls, 1);
+
+    /* The cached decision is used until it is invalidated */
+    denyAccess = true;
+    retval = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant_clear(&val);
+
+    UA_Server_invalidateAccessCache(server, NULL, &nodeId);
+    retval = UA_Client_readValueAttribute(client, nodeId, &val);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADUSERACCESSDENIED);
+    ck_assert_uint_eq(accessLevelCalls, 2);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(Cache_browse) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseRequest request;
+    UA_BrowseRequest_init(&request);
+    request.nodesToBrowse = &bd;
+    request.nodesToBrowseSize = 1;
+    for(size_t i = 0; i < 3; i++) {
+        UA_BrowseResponse resp = UA_Client_Service_browse(client, request);
+        ck_assert_uint_eq(resp.resultsSize, 1);
+        ck_assert_uint_eq(resp.results[0].statusCode, UA_STATUSCODE_GOOD);
+        UA_BrowseResponse_clear(&resp);
+    }
+    size_t calls = browseCalls;
+    ck_assert_uint_gt(calls, 0);
+
+    /* Reconnecting activates a new session without cached decisions */
+    UA_Client_disconnect(client);
+    retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    denyAccess = true;
+    UA_BrowseResponse resp = UA_Client_Service_browse(client, request);
+    ck_assert_uint_eq(resp.resultsSize, 1);
+    ck_assert_uint_eq(resp.results[0].statusCode, UA_STATUSCODE_BADUSERACCESSDENIED);
+    UA_BrowseResponse_clear(&resp);
+    ck_assert_uint_gt(browseCalls, calls);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
 
 static Suite* testSuite_Client(void) {
     Suite *s = suite_create("Client");
@@ -99,6 +219,11 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_client_user, Client_user_fail);
     tcase_add_test(tc_client_user, Client_pass_fail);
     suite_add_tcase(s,tc_client_user);
+    TCase *tc_cache = tcase_create("Decision Cache");
+    tcase_add_checked_fixture(tc_cache, setupCache, teardown);
+    tcase_add_test(tc_cache, Cache_readValue);
+    tcase_add_test(tc_cache, Cache_browse);
+    suite_add_tcase(s,tc_cache);
     return s;
 }
 
@@ -8,6 +8,7 @@
 #include <open62541/plugin/certificategroup_default.h>
 
 #include "server/ua_server_internal.h"
+#include "server/ua_discovery.h"
 #include "../encryption/certificates.h"
 
 #include <fcntl.h>
@@ -496,15 +497,6 @@ GetEndpointsAndCheck(const char* discoveryUrl, const char* filterTransportProfil
     UA_Client_delete(client);
 }
 
-// Test if discovery server lists himself as registered server if it is filtered by his uri
-static UA_Boolean
-Client_filter_discovery(void) {
-    UA_String expectedUris[1];
-    expectedUris[0] = UA_STRING("urn:open62541.test.local_discovery_server");
-    return FindAndCheck(expectedUris, 1, NULL, NULL,
-                        "urn:open62541.test.local_discovery_server", NULL);
-}
-
 // Test if server filters locale
 static UA_Boolean
 Client_filter_locale(void) {
@@ -559,15 +551,6 @@ Client_find_on_network_registered(void) {
     FindOnNetworkAndCheck(expectedUris, 1, NULL, NULL, capsMultipleCustomIgnoreCase, 2);
 }
 
-// Test if filtering with uris works
-static UA_Boolean
-Client_find_filter(void) {
-    UA_String expectedUris[1];
-    expectedUris[0] = UA_STRING("urn:open62541.test.server_register");
-    return FindAndCheck(expectedUris, 1, NULL, NULL,
-                        "urn:open62541.test.server_register", NULL);
-}
-
 static void
 Client_get_endpoints(void) {
     UA_String expectedEndpoints = UA_STRING("opc.tcp://localhost:4840");
@@ -605,6 +588,24 @@ Client_find_registered(void) {
     return FindAndCheck(expectedUris, 2, NULL, NULL, NULL, NULL);
 }
 
+// Test if filtering with uris works
+static UA_Boolean
+Client_find_filter(void) {
+    UA_String expectedUris[1];
+    expectedUris[0] = UA_STRING("urn:open62541.test.server_register");
+    return FindAndCheck(expectedUris, 1, NULL, NULL,
+                        "urn:open62541.test.server_register", NULL);
+}
+
+// Test if discovery server lists himself as registered server if it is filtered by his uri
+static UA_Boolean
+Client_filter_discovery(void) {
+    UA_String expectedUris[1];
+    expectedUris[0] = UA_STRING("urn:open62541.test.local_discovery_server");
+    return FindAndCheck(expectedUris, 1, NULL, NULL,
+                        "urn:open62541.test.local_discovery_server", NULL);
+}
+
 START_TEST(Server_new_delete) {
     UA_Server *pServer = UA_Server_newForUnitTest();
     configure_lds_server(pServer);
@@ -628,6 +629,17 @@ START_TEST(Server_registerUnregister) {
 }
 END_TEST
 
+START_TEST(Server_registerFindFilter) {
+    registerServer();
+    while(!Client_find_filter()) {}
+    while(!Client_filter_discovery()) {}
+    registerServer(); // register again, the filtered lookup is unchanged
+    while(!Client_find_filter()) {}
+    unregisterServer();
+    while(!Client_find_discovery()) {}
+}
+END_TEST
+
 START_TEST(Server_registerTimeout) {
     registerServer();
 
@@ -657,6 +669,70 @@ START_TEST(Server_registerTimeout) {
 END_TEST
 
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
+static void
+checkFindServersOnNetwork(UA_Server *pServer, UA_UInt32 startingRecordId,
+                          UA_UInt32 maxRecordsToReturn,
+                          const UA_UInt32 *expectedIds, size_t expectedSize) {
+    UA_FindServersOnNetworkRequest request;
+    UA_FindServersOnNetworkRequest_init(&request);
+    request.startingRecordId = startingRecordId;
+    request.maxRecordsToReturn = maxRecordsToReturn;
+    UA_FindServersOnNetworkResponse response;
+    UA_FindServersOnNetworkResponse_init(&response);
+
+    UA_LOCK(&pServer->serviceMutex);
+    Service_FindServersOnNetwork(pServer, &pServer->adminSession,
+                                 &request, &response);
+    UA_UNLOCK(&pServer->serviceMutex);
+
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.serversSize, expectedSize);
+    for(size_t i = 0; i < expectedSize; i++)
+        ck_assert_uint_eq(response.servers[i].recordId, expectedIds[i]);
+    UA_FindServersOnNetworkResponse_clear(&response);
+}
+
+/* The records are returned in ascending recordId order, starting from the
+ * startingRecordId. Removed records leave a gap. */
+START_TEST(Server_findServersOnNetworkRecordIds) {
+    /* Start without sending mDNS messages. The records are added directly. */
+    UA_Server *pServer = UA_Server_newForUnitTest();
+    UA_StatusCode retval = UA_Server_run_startup(pServer);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_getConfig(pServer)->mdnsEnabled = true;
+    UA_DiscoveryManager *dm = (UA_DiscoveryManager*)
+        getServerComponentByName(pServer, UA_STRING("discovery"));
+    ck_assert(dm != NULL);
+
+    /* Add the records 0 to 4 and remove record 2 */
+    char record[64];
+    for(int i = 0; i < 5; i++) {
+        snprintf(record, sizeof(record), "server%d-host._opcua-tcp._tcp.local.", i);
+        retval =
+            UA_DiscoveryManager_addEntryToServersOnNetwork(dm, record, record,
+                                                           strlen("serverX"), NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    snprintf(record, sizeof(record), "server%d-host._opcua-tcp._tcp.local.", 2);
+    retval =
+        UA_DiscoveryManager_removeEntryFromServersOnNetwork(dm, record, record,
+                                                            strlen("serverX"));
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    const UA_UInt32 all[4] = {0, 1, 3, 4};
+    checkFindServersOnNetwork(pServer, 0, 0, all, 4);
+    checkFindServersOnNetwork(pServer, 0, 2, all, 2);
+    checkFindServersOnNetwork(pServer, 1, 0, &all[1], 3);
+    checkFindServersOnNetwork(pServer, 2, 0, &all[2], 2);
+    checkFindServersOnNetwork(pServer, 4, 0, &all[3], 1);
+    checkFindServersOnNetwork(pServer, 5, 0, NULL, 0);
+
+    UA_Server_getConfig(pServer)->mdnsEnabled = false;
+    UA_Server_run_shutdown(pServer);
+    UA_Server_delete(pServer);
+}
+END_TEST
+
 START_TEST(Server_registerFindServers) {
     while(!Client_find_discovery()) {}
 
@@ -689,12 +765,16 @@ static Suite* testSuite_Client(void) {
     TCase *tc_new_del = tcase_create("New Delete");
     tcase_add_test(tc_new_del, Server_new_delete);
     tcase_add_test(tc_new_del, Server_new_shutdown_delete);
+#ifdef UA_ENABLE_DISCOVERY_MULTICAST
+    tcase_add_test(tc_new_del, Server_findServersOnNetworkRecordIds);
+#endif
     suite_add_tcase(s,tc_new_del);
 
     TCase *tc_register = tcase_create("RegisterServer");
     tcase_add_unchecked_fixture(tc_register, setup_lds, teardown_lds);
     tcase_add_unchecked_fixture(tc_register, setup_register, teardown_register);
     tcase_add_test(tc_register, Server_registerUnregister);
+    tcase_add_test(tc_register, Server_registerFindFilter);
     suite_add_tcase(s,tc_register);
 
 #ifdef UA_ENABLE_DISCOVERY_MULTICAST
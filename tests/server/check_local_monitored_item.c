@@ -199,6 +199,470 @@ START_TEST(Server_LocalMonitoredItem_CustomType) {
 }
 END_TEST
 
+static size_t sourceReads = 0;
+
+static UA_StatusCode
+readCounter(UA_Server *s, const UA_NodeId *sessionId, void *sessionContext,
+            const UA_NodeId *nodeId, void *nodeContext, UA_Boolean includeSourceTimeStamp,
+            const UA_NumericRange *range, UA_DataValue *value) {
+    sourceReads++;
+    UA_UInt32 v = (UA_UInt32)sourceReads;
+    value->hasValue = true;
+    return UA_Variant_setScalarCopy(&value->value, &v, &UA_TYPES[UA_TYPES_UINT32]);
+}
+
+static void
+dataChangeCountCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                        void *monitoredItemContext, const UA_NodeId *nodeId,
+                        void *nodeContext, UA_UInt32 attributeId,
+                        const UA_DataValue *value) {
+    ck_assert(value->hasValue);
+    callbackCount++;
+}
+
+/* MonitoredItems with the same node and sampling interval share one sample */
+START_TEST(Server_LocalMonitoredItem_SamplingGroup) {
+    callbackCount = 0;
+    sourceReads = 0;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_DataSource counter = {readCounter, NULL};
+    UA_NodeId counterId = UA_NODEID_STRING(1, "counter");
+    ASSERT_STATUSCODE(UA_Server_addDataSourceVariableNode(server, counterId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "counter"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, counter, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(counterId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_UInt32 ids[3];
+    for(size_t i = 0; i < 3; i++) {
+        UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+            server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+            &dataChangeCountCallback);
+        ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+        ids[i] = result.monitoredItemId;
+    }
+    UA_Server_run_iterate(server, false);
+
+    /* One read for all three MonitoredItems per sampling interval */
+    for(size_t i = 0; i < 5; i++) {
+        size_t reads = sourceReads;
+        size_t callbacks = callbackCount;
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+        ck_assert_uint_eq(sourceReads, reads + 1);
+        ck_assert_uint_eq(callbackCount, callbacks + 3);
+    }
+
+    /* The group continues with the remaining MonitoredItem */
+    ASSERT_STATUSCODE(UA_Server_deleteMonitoredItem(server, ids[0]), UA_STATUSCODE_GOOD);
+    ASSERT_STATUSCODE(UA_Server_deleteMonitoredItem(server, ids[1]), UA_STATUSCODE_GOOD);
+    size_t reads = sourceReads;
+    size_t callbacks = callbackCount;
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(sourceReads, reads + 1);
+    ck_assert_uint_eq(callbackCount, callbacks + 1);
+
+    /* No more sampling after the last MonitoredItem is removed */
+    ASSERT_STATUSCODE(UA_Server_deleteMonitoredItem(server, ids[2]), UA_STATUSCODE_GOOD);
+    reads = sourceReads;
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(sourceReads, reads);
+}
+END_TEST
+
+static UA_UInt32 firstCounterValue = 0;
+
+static void
+dataChangeFirstValueCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                             void *monitoredItemContext, const UA_NodeId *nodeId,
+                             void *nodeContext, UA_UInt32 attributeId,
+                             const UA_DataValue *value) {
+    ck_assert(value->hasValue);
+    if(callbackCount == 0)
+        firstCounterValue = *(UA_UInt32*)value->value.data;
+    callbackCount++;
+}
+
+/* The read that checks the item during the creation is the first sample */
+START_TEST(Server_LocalMonitoredItem_CreateSingleRead) {
+    callbackCount = 0;
+    sourceReads = 0;
+    firstCounterValue = 0;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_DataSource counter = {readCounter, NULL};
+    UA_NodeId counterId = UA_NODEID_STRING(1, "counter");
+    ASSERT_STATUSCODE(UA_Server_addDataSourceVariableNode(server, counterId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "counter"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, counter, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    /* Adding the node already reads from the DataSource */
+    size_t reads = sourceReads;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(counterId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeFirstValueCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(sourceReads, reads + 1);
+
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+    ck_assert_uint_eq(firstCounterValue, reads + 1);
+
+    ASSERT_STATUSCODE(UA_Server_deleteMonitoredItem(server, result.monitoredItemId),
+                      UA_STATUSCODE_GOOD);
+}
+END_TEST
+
+static const void *sharedData[3];
+
+static void
+dataChangeSharedCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                         void *monitoredItemContext, const UA_NodeId *nodeId,
+                         void *nodeContext, UA_UInt32 attributeId,
+                         const UA_DataValue *value) {
+    ck_assert(value->hasValue);
+    ck_assert_uint_lt(callbackCount, 3);
+    sharedData[callbackCount] = value->value.data;
+    callbackCount++;
+}
+
+/* The notifications of a SamplingGroup borrow the same sampled value */
+START_TEST(Server_LocalMonitoredItem_SharedSample) {
+    callbackCount = 0;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    for(size_t i = 0; i < 3; i++) {
+        UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+            server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+            &dataChangeSharedCallback);
+        ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    }
+    UA_Server_run_iterate(server, false);
+
+    /* The initial samples are taken individually */
+    callbackCount = 0;
+    UA_UInt32 v = 7;
+    UA_Variant val;
+    UA_Variant_setScalar(&val, &v, &UA_TYPES[UA_TYPES_UINT32]);
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 3);
+    ck_assert(sharedData[0] != NULL);
+    ck_assert(sharedData[0] == sharedData[1]);
+    ck_assert(sharedData[0] == sharedData[2]);
+}
+END_TEST
+
+/* With event-driven sampling, only changed values are sampled */
+START_TEST(Server_LocalMonitoredItem_EventDrivenSampling) {
+    callbackCount = 0;
+    sourceReads = 0;
+    UA_Server_getConfig(server)->eventDrivenSampling = true;
+
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_DataSource counter = {readCounter, NULL};
+    UA_NodeId counterId = UA_NODEID_STRING(1, "counter");
+    ASSERT_STATUSCODE(UA_Server_addDataSourceVariableNode(server, counterId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "counter"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, counter, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(counterId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    for(size_t i = 0; i < 2; i++) {
+        UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+            server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+            &dataChangeCountCallback);
+        ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    }
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+
+    /* No sampling without a change */
+    size_t reads = sourceReads;
+    size_t callbacks = callbackCount;
+    for(size_t i = 0; i < 5; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+    }
+    ck_assert_uint_eq(sourceReads, reads);
+    ck_assert_uint_eq(callbackCount, callbacks);
+
+    /* Sample once after the notification */
+    ASSERT_STATUSCODE(UA_Server_notifyValueChanged(server, counterId),
+                      UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 3; i++) {
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+    }
+    ck_assert_uint_eq(sourceReads, reads + 1);
+    ck_assert_uint_eq(callbackCount, callbacks + 2);
+
+    /* Writes mark the node as changed */
+    UA_MonitoredItemCreateRequest valueRequest =
+        UA_MonitoredItemCreateRequest_default(outNodeId);
+    valueRequest.requestedParameters.samplingInterval = (double)100;
+    valueRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, valueRequest, NULL,
+        &dataChangeCountCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    callbacks = callbackCount;
+
+    UA_UInt32 v = 7;
+    UA_Variant val;
+    UA_Variant_setScalar(&val, &v, &UA_TYPES[UA_TYPES_UINT32]);
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, callbacks + 1);
+    ck_assert_uint_eq(sourceReads, reads + 1);
+}
+END_TEST
+
+/* The direct callback is called synchronously from the sampling and from the
+ * Write service */
+START_TEST(Server_LocalMonitoredItem_Direct) {
+    callbackCount = 0;
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = 0.0;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result =
+        UA_Server_createDataChangeMonitoredItemDirect(server, UA_TIMESTAMPSTORETURN_BOTH,
+                                                      monitorRequest, NULL,
+                                                      &dataChangeCountCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    UA_UInt32 v = 7;
+    UA_Variant val;
+    UA_Variant_setScalar(&val, &v, &UA_TYPES[UA_TYPES_UINT32]);
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(callbackCount, 2);
+
+    /* Unchanged values are filtered */
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, outNodeId, val), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(callbackCount, 2);
+
+    /* Nothing is left for the delayed publishing */
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 2);
+}
+END_TEST
+
+/* Only the hash of large values is kept for the change detection */
+START_TEST(Server_LocalMonitoredItem_HashedChangeDetection) {
+    callbackCount = 0;
+    UA_Server_getConfig(server)->hashedChangeDetection = true;
+
+    UA_Double data[256];
+    for(size_t i = 0; i < 256; i++)
+        data[i] = (UA_Double)i;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Variant_setArray(&attr.value, data, 256, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_NodeId arrayId = UA_NODEID_STRING(1, "array");
+    ASSERT_STATUSCODE(UA_Server_addVariableNode(server, arrayId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "array"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(arrayId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeCountCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* Writing the same content is not a change */
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, arrayId, attr.value),
+                      UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* A single changed element is detected */
+    data[200] = -1.0;
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, arrayId, attr.value),
+                      UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 2);
+
+    /* Scalars of the uint32 node are still compared directly */
+    monitorRequest = UA_MonitoredItemCreateRequest_default(outNodeId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeCountCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 3);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 3);
+}
+END_TEST
+
+/* The absolute deadband applies to every element of numeric arrays */
+START_TEST(Server_LocalMonitoredItem_ArrayDeadband) {
+    callbackCount = 0;
+
+    UA_Double data[37];
+    for(size_t i = 0; i < 37; i++)
+        data[i] = (UA_Double)i;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    UA_Variant_setArray(&attr.value, data, 37, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_NodeId arrayId = UA_NODEID_STRING(1, "array");
+    ASSERT_STATUSCODE(UA_Server_addVariableNode(server, arrayId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "array"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    UA_DataChangeFilter filter;
+    UA_DataChangeFilter_init(&filter);
+    filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    filter.deadbandType = UA_DEADBANDTYPE_ABSOLUTE;
+    filter.deadbandValue = 1.0;
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(arrayId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_ExtensionObject_setValueNoDelete(&monitorRequest.requestedParameters.filter,
+                                        &filter, &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeCountCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* Changes inside the deadband are not reported */
+    for(size_t i = 0; i < 37; i++)
+        data[i] += 0.5;
+    ASSERT_STATUSCODE(UA_Server_writeValue(server, arrayId, attr.value),
+                      UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* Changes outside the deadband in the blocks and in the remainder */
+    size_t pos[3] = {3, 20, 36};
+    for(size_t i = 0; i < 3; i++) {
+        data[pos[i]] -= 2.0;
+        ASSERT_STATUSCODE(UA_Server_writeValue(server, arrayId, attr.value),
+                          UA_STATUSCODE_GOOD);
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+        ck_assert_uint_eq(callbackCount, i + 2);
+    }
+}
+END_TEST
+
+/* Small scalars are kept inline in the MonitoredItem for the comparison */
+static UA_Double lastDouble;
+
+static void
+dataChangeDoubleCallback(UA_Server *thisServer, UA_UInt32 monitoredItemId,
+                         void *monitoredItemContext, const UA_NodeId *nodeId,
+                         void *nodeContext, UA_UInt32 attributeId,
+                         const UA_DataValue *value) {
+    ck_assert(value->value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    lastDouble = *(UA_Double*)value->value.data;
+    callbackCount++;
+}
+
+START_TEST(Server_LocalMonitoredItem_ScalarDeadband) {
+    callbackCount = 0;
+
+    UA_Double d = 0.0;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    UA_Variant_setScalar(&attr.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_NodeId doubleId = UA_NODEID_STRING(1, "double");
+    ASSERT_STATUSCODE(UA_Server_addVariableNode(server, doubleId,
+                                        parentNodeId, parentReferenceNodeId,
+                                        UA_QUALIFIEDNAME(1, "double"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        attr, NULL, NULL), UA_STATUSCODE_GOOD);
+
+    UA_DataChangeFilter filter;
+    UA_DataChangeFilter_init(&filter);
+    filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    filter.deadbandType = UA_DEADBANDTYPE_ABSOLUTE;
+    filter.deadbandValue = 1.0;
+    UA_MonitoredItemCreateRequest monitorRequest =
+        UA_MonitoredItemCreateRequest_default(doubleId);
+    monitorRequest.requestedParameters.samplingInterval = (double)100;
+    monitorRequest.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_ExtensionObject_setValueNoDelete(&monitorRequest.requestedParameters.filter,
+                                        &filter, &UA_TYPES[UA_TYPES_DATACHANGEFILTER]);
+    UA_MonitoredItemCreateResult result = UA_Server_createDataChangeMonitoredItem(
+        server, UA_TIMESTAMPSTORETURN_BOTH, monitorRequest, NULL,
+        &dataChangeDoubleCallback);
+    ASSERT_STATUSCODE(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_fakeSleep(100);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(callbackCount, 1);
+
+    /* Only the values outside the deadband of the last reported value */
+    UA_Double values[5] = {0.5, 2.0, 2.5, 2.9, -1.0};
+    size_t expected[5] = {1, 2, 2, 2, 3};
+    for(size_t i = 0; i < 5; i++) {
+        d = values[i];
+        ASSERT_STATUSCODE(UA_Server_writeValue(server, doubleId, attr.value),
+                          UA_STATUSCODE_GOOD);
+        UA_fakeSleep(100);
+        UA_Server_run_iterate(server, false);
+        ck_assert_uint_eq(callbackCount, expected[i]);
+    }
+    ck_assert(lastDouble == -1.0);
+}
+END_TEST
+
 static void setupIndexRange(void) {
     server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -284,6 +748,14 @@ static Suite * testSuite_Client(void) {
     tcase_add_checked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, Server_LocalMonitoredItem);
     tcase_add_test(tc_server, Server_LocalMonitoredItem_CustomType);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_SamplingGroup);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_CreateSingleRead);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_EventDrivenSampling);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_Direct);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_SharedSample);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_HashedChangeDetection);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_ArrayDeadband);
+    tcase_add_test(tc_server, Server_LocalMonitoredItem_ScalarDeadband);
     suite_add_tcase(s, tc_server);
 
     TCase *tc_server_indexrange = tcase_create("Local Monitored Item Index Range");
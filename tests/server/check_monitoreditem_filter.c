@@ -1106,6 +1106,73 @@ START_TEST(Server_MonitoredItemsPercentFilterSetOnCreateDeadBandValueOutOfRange)
     UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
 }
 END_TEST
+
+START_TEST(Server_MonitoredItemsPercentFilterEURangeChanged) {
+    UA_DataValue_init(&lastValue);
+    /* define a monitored item with an percent filter with deadbandvalue = 10.0 */
+    UA_MonitoredItemCreateRequest item = UA_MonitoredItemCreateRequest_default(outNodeIdAnalogItem);
+    UA_DataChangeFilter filter;
+    UA_DataChangeFilter_init(&filter);
+    filter.trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+    filter.deadbandType = UA_DEADBANDTYPE_PERCENT;
+    filter.deadbandValue = 10.0;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_DATACHANGEFILTER];
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    UA_Client_DataChangeNotificationCallback callbacks[1];
+    callbacks[0] = dataChangeHandler;
+    UA_Client_DeleteMonitoredItemCallback deleteCallbacks[1] = {NULL};
+    void *contexts[1];
+    contexts[0] = NULL;
+
+    UA_CreateMonitoredItemsRequest createRequest;
+    UA_CreateMonitoredItemsRequest_init(&createRequest);
+    createRequest.subscriptionId = subId;
+    createRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    createRequest.itemsToCreate = &item;
+    createRequest.itemsToCreateSize = 1;
+    UA_CreateMonitoredItemsResponse createResponse =
+       UA_Client_MonitoredItems_createDataChanges(client, createRequest, contexts,
+                                                  callbacks, deleteCallbacks);
+    ck_assert_uint_eq(createResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(createResponse.resultsSize, 1);
+    ck_assert_uint_eq(createResponse.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_CreateMonitoredItemsResponse_clear(&createResponse);
+
+    // Do we get initial value ?
+    notificationReceived = false;
+    countNotificationReceived = 0;
+    ck_assert_uint_eq(waitForNotification(1, 10), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(countNotificationReceived, 1);
+
+    // Widen the EURange. The deadband is now 100.0.
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(0, "EURange");
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server, outNodeIdAnalogItem, 1, &qn);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    UA_Range range;
+    range.low = 10;
+    range.high = 1010;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &range, &UA_TYPES[UA_TYPES_RANGE]);
+    ck_assert_uint_eq(UA_Client_writeValueAttribute(client, bpr.targets[0].targetId.nodeId, &v),
+                      UA_STATUSCODE_GOOD);
+    UA_BrowsePathResult_clear(&bpr);
+
+    // This would trigger with the original EURange
+    notificationReceived = false;
+    countNotificationReceived = 0;
+    ck_assert_uint_eq(setDouble(client, outNodeIdAnalogItem, 90.0), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(waitForNotification(1, 10), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(countNotificationReceived, 0);
+
+    // This should trigger
+    ck_assert_uint_eq(setDouble(client, outNodeIdAnalogItem, 200.0), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(waitForNotification(1, 10), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(countNotificationReceived, 1);
+    ck_assert(fuzzyLastValueIsEqualTo(200.0));
+}
+END_TEST
 #endif /* UA_ENABLE_DA */
 
 #endif /*UA_ENABLE_SUBSCRIPTIONS*/
@@ -1126,6 +1193,7 @@ static Suite* testSuite_Client(void) {
 #ifdef UA_ENABLE_DA
     tcase_add_test(tc_server, Server_MonitoredItemsPercentFilterSetOnCreate);
     tcase_add_test(tc_server, Server_MonitoredItemsPercentFilterSetOnCreateDeadBandValueOutOfRange);
+    tcase_add_test(tc_server, Server_MonitoredItemsPercentFilterEURangeChanged);
 #endif /* UA_ENABLE_DA */
 #endif /* UA_ENABLE_SUBSCRIPTIONS */
     suite_add_tcase(s, tc_server);
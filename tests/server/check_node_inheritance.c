@@ -447,6 +447,65 @@ START_TEST(Nodes_createObjectWithInterfaceOnObject) {
 }
 END_TEST
 
+static void
+addObjectType(UA_UInt32 id, UA_NodeId parentId) {
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("", "HierarchyType");
+    UA_StatusCode res =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NUMERIC(1, id), parentId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "HierarchyType"),
+                                    attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static UA_Boolean
+isSubtype(UA_UInt32 id, UA_UInt32 parentId) {
+    UA_NodeId typeId = UA_NODEID_NUMERIC(id < 100 ? 0 : 1, id);
+    UA_NodeId parentTypeId = UA_NODEID_NUMERIC(parentId < 100 ? 0 : 1, parentId);
+    return isNodeInTree_singleRef(server, &typeId, &parentTypeId,
+                                  UA_REFERENCETYPEINDEX_HASSUBTYPE);
+}
+
+/* The cached supertypes follow changes of the HasSubtype references */
+START_TEST(Nodes_typeHierarchy) {
+    addObjectType(9000, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+    addObjectType(9001, UA_NODEID_NUMERIC(1, 9000));
+    addObjectType(9002, UA_NODEID_NUMERIC(1, 9001));
+    addObjectType(9003, UA_NODEID_NUMERIC(1, 9000));
+
+    ck_assert(isSubtype(9002, 9002));
+    ck_assert(isSubtype(9002, 9001));
+    ck_assert(isSubtype(9002, 9000));
+    ck_assert(isSubtype(9002, UA_NS0ID_BASEOBJECTTYPE));
+    ck_assert(!isSubtype(9002, 9003));
+    ck_assert(!isSubtype(9000, 9002));
+    UA_StatusCode res;
+
+    /* Move 9001 (with the subtype 9002) below 9003 */
+    res = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(1, 9000),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE), true,
+                                    UA_EXPANDEDNODEID_NUMERIC(1, 9001), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(!isSubtype(9002, 9000));
+    res = UA_Server_addReference(server, UA_NODEID_NUMERIC(1, 9003),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                 UA_EXPANDEDNODEID_NUMERIC(1, 9001), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(isSubtype(9002, 9003));
+    ck_assert(isSubtype(9002, 9000));
+
+    /* Delete the type and add it again at a different position */
+    res = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 9002), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(!isSubtype(9002, 9001));
+    addObjectType(9002, UA_NODEID_NUMERIC(1, 9000));
+    ck_assert(!isSubtype(9002, 9001));
+    ck_assert(!isSubtype(9002, 9003));
+    ck_assert(isSubtype(9002, 9000));
+}
+END_TEST
+
 static Suite *testSuite_Client(void) {
     Suite *s = suite_create("Node inheritance");
     TCase *tc_inherit_subtype = tcase_create("Inherit subtype value");
@@ -457,6 +516,7 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_inherit_subtype, Nodes_checkInheritedValue);
     tcase_add_test(tc_inherit_subtype, Nodes_createCustomBrowseNameObjectType);
     tcase_add_test(tc_inherit_subtype, Nodes_checkDefaultInstanceBrowseName);
+    tcase_add_test(tc_inherit_subtype, Nodes_typeHierarchy);
     suite_add_tcase(s, tc_inherit_subtype);
     TCase *tc_interface_addin = tcase_create("Interfaces and Addins");
     tcase_add_unchecked_fixture(tc_interface_addin, setup, teardown);
@@ -13,7 +13,8 @@
 #include <time.h>
 #include "check.h"
 
-#if UA_MULTITHREADING >= 200
+#if UA_MULTITHREADING >= 200 || \
+    (UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES))
 #include <pthread.h>
 #endif
 
@@ -31,6 +32,25 @@ static void teardown(void) {
     ns.clear(ns.context);
 }
 
+/* The base contains the nodes ns=3;i=1 to ns=3;i=100 */
+static UA_Nodestore baseNs;
+
+static void setupLayered(void) {
+    UA_Nodestore_HashMap(&baseNs);
+    for(UA_UInt32 i = 1; i <= 100; i++) {
+        UA_Node *p = baseNs.newNode(baseNs.context, UA_NODECLASS_VARIABLE);
+        p->head.nodeId = UA_NODEID_NUMERIC(3, i);
+        baseNs.insertNode(baseNs.context, p, NULL);
+    }
+    UA_Nodestore_HashMap_freeze(&baseNs);
+    UA_Nodestore_HashMapLayered(&ns, &baseNs);
+}
+
+static void teardownLayered(void) {
+    ns.clear(ns.context);
+    baseNs.clear(baseNs.context);
+}
+
 static int zeroCnt = 0;
 static int visitCnt = 0;
 static void checkZeroVisitor(void *context, const UA_Node* node) {
@@ -39,7 +59,7 @@ static void checkZeroVisitor(void *context, const UA_Node* node) {
 }
 
 static UA_Node* createNode(UA_UInt16 nsid, UA_UInt32 id) {
-    UA_Node *p = ns.newNode(&ns.context, UA_NODECLASS_VARIABLE);
+    UA_Node *p = ns.newNode(ns.context, UA_NODECLASS_VARIABLE);
     p->head.nodeId.identifierType = UA_NODEIDTYPE_NUMERIC;
     p->head.nodeId.namespaceIndex = nsid;
     p->head.nodeId.identifier.numeric = id;
@@ -191,6 +211,257 @@ START_TEST(failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries) {
 }
 END_TEST
 
+START_TEST(findNodesAfterRemovingOthers) {
+    /* Numeric and string NodeIds. The numeric identifiers are the same in both
+     * namespaces. */
+    char buf[32];
+    for(UA_UInt32 i = 0; i < 1000; i++) {
+        ns.insertNode(ns.context, createNode(1, i + 1), NULL);
+        UA_Node *n = ns.newNode(ns.context, UA_NODECLASS_VARIABLE);
+        snprintf(buf, sizeof(buf), "node-%u", (unsigned)i);
+        n->head.nodeId = UA_NODEID_STRING_ALLOC(2, buf);
+        ns.insertNode(ns.context, n, NULL);
+    }
+    for(UA_UInt32 i = 0; i < 1000; i += 2)
+        ns.insertNode(ns.context, createNode(2, i + 1), NULL);
+
+    /* Leave tombstones behind */
+    for(UA_UInt32 i = 0; i < 1000; i += 2) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i + 1);
+        ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+        snprintf(buf, sizeof(buf), "node-%u", (unsigned)i);
+        id = UA_NODEID_STRING(2, buf);
+        ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    }
+
+    for(UA_UInt32 i = 0; i < 1000; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i + 1);
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_int_eq(n != NULL, i % 2 == 1);
+        ns.releaseNode(ns.context, n);
+
+        id = UA_NODEID_NUMERIC(2, i + 1);
+        n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_int_eq(n != NULL, i % 2 == 0);
+        if(n)
+            ck_assert(UA_NodeId_equal(&n->head.nodeId, &id));
+        ns.releaseNode(ns.context, n);
+
+        snprintf(buf, sizeof(buf), "node-%u", (unsigned)i);
+        id = UA_NODEID_STRING(2, buf);
+        n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_int_eq(n != NULL, i % 2 == 1);
+        if(n)
+            ck_assert(UA_NodeId_equal(&n->head.nodeId, &id));
+        ns.releaseNode(ns.context, n);
+    }
+}
+END_TEST
+
+START_TEST(referenceArrayStaysSorted) {
+    UA_Node *n = createNode(1, 1);
+    const UA_UInt32 count = UA_NODEREFERENCEKIND_TREETHRESHOLD;
+    for(UA_UInt32 i = 0; i < count; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, ((i * 37) % count) + 2);
+        ck_assert_uint_eq(UA_Node_addReference(n, 0, true, &target, 0),
+                          UA_STATUSCODE_GOOD);
+    }
+    UA_ExpandedNodeId dup = UA_EXPANDEDNODEID_NUMERIC(1, 2);
+    ck_assert_uint_eq(UA_Node_addReference(n, 0, true, &dup, 0),
+                      UA_STATUSCODE_BADDUPLICATEREFERENCENOTALLOWED);
+
+    /* Remove every third target */
+    for(UA_UInt32 i = 0; i < count; i += 3) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i + 2);
+        ck_assert_uint_eq(UA_Node_deleteReference(n, 0, true, &target),
+                          UA_STATUSCODE_GOOD);
+    }
+
+    ck_assert_uint_eq(n->head.referencesSize, 1);
+    UA_NodeReferenceKind *rk = &n->head.references[0];
+    ck_assert(!rk->hasRefTree);
+    for(size_t i = 1; i < rk->targetsSize; i++)
+        ck_assert_int_eq(UA_NodePointer_order(rk->targets.array[i-1].targetId,
+                                              rk->targets.array[i].targetId),
+                         UA_ORDER_LESS);
+    for(UA_UInt32 i = 0; i < count; i++) {
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, i + 2);
+        const UA_ReferenceTarget *t = UA_NodeReferenceKind_findTarget(rk, &target);
+        ck_assert_int_eq(t != NULL, i % 3 != 0);
+    }
+
+    /* Switch to the tree and back */
+    ck_assert_uint_eq(UA_NodeReferenceKind_switch(rk), UA_STATUSCODE_GOOD);
+    ck_assert(rk->hasRefTree);
+    ck_assert_uint_eq(UA_NodeReferenceKind_switch(rk), UA_STATUSCODE_GOOD);
+    ck_assert(!rk->hasRefTree);
+    for(size_t i = 1; i < rk->targetsSize; i++)
+        ck_assert_int_eq(UA_NodePointer_order(rk->targets.array[i-1].targetId,
+                                              rk->targets.array[i].targetId),
+                         UA_ORDER_LESS);
+
+    ns.deleteNode(ns.context, n);
+}
+END_TEST
+
+START_TEST(referenceTargetCachesNode) {
+    UA_Node *n1 = createNode(1, 1);
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, 2);
+    ck_assert_uint_eq(UA_Node_addReference(n1, 0, true, &target, 0),
+                      UA_STATUSCODE_GOOD);
+    ns.insertNode(ns.context, n1, NULL);
+    ns.insertNode(ns.context, createNode(1, 2), NULL);
+
+    UA_NodeId id1 = UA_NODEID_NUMERIC(1, 1);
+    const UA_Node *source = ns.getNode(ns.context, &id1, UA_NODEATTRIBUTESMASK_ALL,
+                                       UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(source != NULL);
+    UA_ReferenceTarget *t = (UA_ReferenceTarget*)(uintptr_t)
+        &source->head.references[0].targets.array[0];
+    ck_assert(t->targetNode == NULL);
+
+    /* The first lookup caches the pointer. The second uses it. */
+    const UA_Node *n2 = ns.getNodeFromTarget(ns.context, t, UA_NODEATTRIBUTESMASK_ALL,
+                                             UA_REFERENCETYPESET_ALL,
+                                             UA_BROWSEDIRECTION_BOTH);
+    ck_assert(n2 != NULL);
+    ck_assert(t->targetNode == &n2->head);
+    const UA_Node *n2b = ns.getNodeFromTarget(ns.context, t, UA_NODEATTRIBUTESMASK_ALL,
+                                              UA_REFERENCETYPESET_ALL,
+                                              UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(n2, n2b);
+    ns.releaseNode(ns.context, n2);
+    ns.releaseNode(ns.context, n2b);
+
+    /* The cached pointer is not used after the target was removed */
+    UA_NodeId id2 = UA_NODEID_NUMERIC(1, 2);
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id2), UA_STATUSCODE_GOOD);
+    n2 = ns.getNodeFromTarget(ns.context, t, UA_NODEATTRIBUTESMASK_ALL,
+                              UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert(n2 == NULL);
+    ns.releaseNode(ns.context, source);
+}
+END_TEST
+
+#ifdef UA_ENABLE_NODE_STRING_INTERNING
+START_TEST(copiedNodesShareStrings) {
+    UA_Node *n = createNode(1, 1);
+    n->head.browseName = UA_QUALIFIEDNAME_ALLOC(1, "Temperature");
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en", "Temperature");
+    ck_assert_uint_eq(UA_Node_setAttributes(n, &attr,
+                                            &UA_TYPES[UA_TYPES_VARIABLEATTRIBUTES]),
+                      UA_STATUSCODE_GOOD);
+
+    /* The BrowseName was not set via the pool. The copies share the name with
+     * the DisplayName. */
+    UA_Node *c1 = UA_Node_copy_alloc(n);
+    UA_Node *c2 = UA_Node_copy_alloc(n);
+    ck_assert(c1 && c2);
+    ck_assert_ptr_ne(c1->head.browseName.name.data, n->head.browseName.name.data);
+    ck_assert_ptr_eq(c1->head.browseName.name.data, c2->head.browseName.name.data);
+    ck_assert_ptr_eq(c1->head.browseName.name.data,
+                     n->head.displayName->localizedText.text.data);
+    ck_assert_ptr_eq(c1->head.displayName->localizedText.text.data,
+                     c2->head.displayName->localizedText.text.data);
+
+    /* The shared strings stay valid until the last node is gone */
+    ns.deleteNode(ns.context, n);
+    UA_Node_clear(c1);
+    UA_free(c1);
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(1, "Temperature");
+    ck_assert(UA_QualifiedName_equal(&c2->head.browseName, &qn));
+    UA_Node_clear(c2);
+    UA_free(c2);
+}
+END_TEST
+#endif
+
+START_TEST(statisticsCountNodes) {
+    for(UA_UInt32 i = 1; i <= 10; i++)
+        ns.insertNode(ns.context, createNode(1, i), NULL);
+    for(UA_UInt32 i = 1; i <= 5; i++)
+        ns.insertNode(ns.context, createNode(2, i), NULL);
+    UA_NodeId in3 = UA_NODEID_NUMERIC(1, 3);
+    ns.removeNode(ns.context, &in3);
+
+    UA_NodestoreStatistics stats;
+    memset(&stats, 0, sizeof(UA_NodestoreStatistics));
+    UA_StatusCode retval = ns.getStatistics(ns.context, &stats);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.total.nodeCount, 14);
+    ck_assert_uint_eq(stats.nodeClasses[1].nodeCount, 14); /* Variable */
+    ck_assert_uint_ge(stats.total.nodeBytes, 14 * sizeof(UA_VariableNode));
+    ck_assert_uint_eq(stats.namespacesSize, 3);
+    ck_assert_uint_eq(stats.namespaces[0].nodeCount, 0);
+    ck_assert_uint_eq(stats.namespaces[1].nodeCount, 9);
+    ck_assert_uint_eq(stats.namespaces[2].nodeCount, 5);
+    UA_NodestoreStatistics_clear(&stats);
+}
+END_TEST
+
+static int
+countVisits(void) {
+    visitCnt = 0;
+    zeroCnt = 0;
+    ns.iterate(ns.context, checkZeroVisitor, NULL);
+    ck_assert_int_eq(zeroCnt, 0);
+    return visitCnt;
+}
+
+START_TEST(layeredNodestoreShallShadowTheBase) {
+    /* The frozen base is read-only */
+    UA_Node *n = baseNs.newNode(baseNs.context, UA_NODECLASS_VARIABLE);
+    n->head.nodeId = UA_NODEID_NUMERIC(3, 200);
+    ck_assert_uint_eq(baseNs.insertNode(baseNs.context, n, NULL),
+                      UA_STATUSCODE_BADNOTWRITABLE);
+
+    /* Nodes of the base are visible and cannot be added twice */
+    UA_NodeId id = UA_NODEID_NUMERIC(3, 10);
+    const UA_Node *baseNode = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                         UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_ne(baseNode, NULL);
+    ns.releaseNode(ns.context, baseNode);
+    ck_assert_uint_eq(ns.insertNode(ns.context, createNode(3, 10), NULL),
+                      UA_STATUSCODE_BADNODEIDEXISTS);
+    ck_assert_int_eq(countVisits(), 100);
+
+    /* Replace a node of the base */
+    UA_Node *copy = NULL;
+    ck_assert_uint_eq(ns.getNodeCopy(ns.context, &id, &copy), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(ns.replaceNode(ns.context, copy), UA_STATUSCODE_GOOD);
+    const UA_Node *replaced = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                         UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(replaced, copy);
+    ns.releaseNode(ns.context, replaced);
+    const UA_Node *unchanged = baseNs.getNode(baseNs.context, &id, ~(UA_UInt32)0,
+                                              UA_REFERENCETYPESET_ALL,
+                                              UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(unchanged, baseNode);
+    baseNs.releaseNode(baseNs.context, unchanged);
+    ck_assert_int_eq(countVisits(), 100);
+
+    /* Remove a replaced and a non-replaced node of the base */
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    UA_NodeId id2 = UA_NODEID_NUMERIC(3, 20);
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id2), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id2), UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ck_assert_ptr_eq(ns.getNode(ns.context, &id2, ~(UA_UInt32)0,
+                                UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH), NULL);
+    ck_assert_int_eq(countVisits(), 98);
+
+    /* Add the removed node again and a new node */
+    ck_assert_uint_eq(ns.insertNode(ns.context, createNode(3, 20), NULL),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(ns.insertNode(ns.context, createNode(3, 200), NULL),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(countVisits(), 100);
+}
+END_TEST
+
 /************************************/
 /* Performance Profiling Test Cases */
 /************************************/
@@ -257,6 +528,164 @@ START_TEST(profileGetDelete) {
 }
 END_TEST
 
+/* Compacted nodes are decoded when they are accessed. Only the last decoded
+ * nodes are kept up to the cache size. */
+#if !(UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES))
+#define COMPACT_NODES 100
+
+static size_t nodeBytes(void) {
+    UA_NodestoreStatistics stats;
+    memset(&stats, 0, sizeof(stats));
+    ns.getStatistics(ns.context, &stats);
+    size_t bytes = stats.total.nodeBytes;
+    UA_NodestoreStatistics_clear(&stats);
+    return bytes;
+}
+
+START_TEST(compactNodesAreMaterialized) {
+    for(UA_UInt32 i = 1; i <= COMPACT_NODES; i++) {
+        UA_Node *n = createNode(0, i);
+        n->head.browseName = UA_QUALIFIEDNAME_ALLOC(0, "Compact");
+        UA_LocalizedTextListEntry *dn = (UA_LocalizedTextListEntry*)
+            UA_calloc(1, sizeof(UA_LocalizedTextListEntry));
+        dn->localizedText = UA_LOCALIZEDTEXT_ALLOC("en", "Compact");
+        n->head.displayName = dn;
+        UA_Int32 value = (UA_Int32)i;
+        UA_Variant_setScalarCopy(&n->variableNode.value.data.value.value,
+                                 &value, &UA_TYPES[UA_TYPES_INT32]);
+        n->variableNode.value.data.value.hasValue = true;
+        n->variableNode.valueRank = UA_VALUERANK_SCALAR;
+        UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(0, i + 1);
+        UA_Node_addReference(n, 1, true, &target, 5);
+        ns.insertNode(ns.context, n, NULL);
+    }
+    /* Not compacted. Has a context. */
+    UA_NodeId ctxId = UA_NODEID_NUMERIC(0, 1);
+    UA_Node *copy = NULL;
+    ns.getNodeCopy(ns.context, &ctxId, &copy);
+    copy->head.context = &copy;
+    ns.replaceNode(ns.context, copy);
+
+    size_t before = nodeBytes();
+    ck_assert_uint_eq(UA_Nodestore_HashMap_compact(&ns, 0, 4), UA_STATUSCODE_GOOD);
+    ck_assert_uint_lt(nodeBytes(), before);
+    ck_assert_int_eq(countVisits(), COMPACT_NODES);
+
+    /* Hold more nodes than the cache size */
+    const UA_Node *held[COMPACT_NODES];
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 0);
+    for(UA_UInt32 i = 1; i <= COMPACT_NODES; i++) {
+        id.identifier.numeric = i;
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_ptr_ne(n, NULL);
+        ck_assert(UA_NodeId_equal(&n->head.nodeId, &id));
+        UA_QualifiedName bn = UA_QUALIFIEDNAME(0, "Compact");
+        ck_assert(UA_QualifiedName_equal(&n->head.browseName, &bn));
+        ck_assert_ptr_ne(n->head.displayName, NULL);
+        const UA_DataValue *dv = &n->variableNode.value.data.value;
+        ck_assert_ptr_eq(dv->value.type, &UA_TYPES[UA_TYPES_INT32]);
+        ck_assert_int_eq(*(UA_Int32*)dv->value.data, (UA_Int32)i);
+        ck_assert_uint_eq(n->head.referencesSize, 1);
+        ck_assert_uint_eq(n->head.references[0].referenceTypeIndex, 1);
+        ck_assert(!n->head.references[0].isInverse);
+        ck_assert_uint_eq(n->head.references[0].targetsSize, 1);
+        held[i-1] = n;
+    }
+    for(UA_UInt32 i = 0; i < COMPACT_NODES; i++)
+        ns.releaseNode(ns.context, held[i]);
+
+    /* Access again. This compacts the released nodes. */
+    for(UA_UInt32 i = 1; i <= COMPACT_NODES; i++) {
+        id.identifier.numeric = i;
+        const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                      UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+        ck_assert_ptr_ne(n, NULL);
+        ns.releaseNode(ns.context, n);
+    }
+    ck_assert_uint_lt(nodeBytes(), before);
+
+    /* Edited nodes stay decoded */
+    id.identifier.numeric = 50;
+    ck_assert_uint_eq(ns.getNodeCopy(ns.context, &id, &copy), UA_STATUSCODE_GOOD);
+    copy->head.writeMask = 1;
+    ck_assert_uint_eq(ns.replaceNode(ns.context, copy), UA_STATUSCODE_GOOD);
+    const UA_Node *n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                  UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+    ck_assert_ptr_eq(n, copy);
+    ck_assert_uint_eq(n->head.writeMask, 1);
+    ns.releaseNode(ns.context, n);
+    ck_assert_uint_eq(ns.removeNode(ns.context, &id), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(countVisits(), COMPACT_NODES - 1);
+}
+END_TEST
+#endif
+
+/* The HashMap allows concurrent readers with immutable nodes. Replace the
+ * nodes while they are read from other threads. */
+#if UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES)
+#define CONCURRENT_NODES 512
+#define CONCURRENT_ROUNDS 200
+static volatile UA_Boolean concurrentRunning;
+
+static void *concurrentGetThread(void *arg) {
+    size_t *found = (size_t*)arg;
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 0);
+    while(concurrentRunning) {
+        for(UA_UInt32 i = 0; i < CONCURRENT_NODES; i++) {
+            id.identifier.numeric = i + 1;
+            const UA_Node* n = ns.getNode(ns.context, &id, ~(UA_UInt32)0,
+                                          UA_REFERENCETYPESET_ALL, UA_BROWSEDIRECTION_BOTH);
+            if(!n)
+                continue;
+            if(n->head.nodeId.identifier.numeric == i + 1)
+                (*found)++;
+            ns.releaseNode(ns.context, n);
+        }
+    }
+    return NULL;
+}
+
+START_TEST(concurrentGetReplace) {
+    for(UA_UInt32 i = 0; i < CONCURRENT_NODES; i++) {
+        UA_Node *n = createNode(0, i + 1);
+        ns.insertNode(ns.context, n, NULL);
+    }
+
+    concurrentRunning = true;
+    pthread_t t[4];
+    size_t found[4] = {0};
+    for(size_t i = 0; i < 4; i++)
+        pthread_create(&t[i], NULL, concurrentGetThread, &found[i]);
+
+    /* Replace, remove and re-insert (this also resizes) */
+    UA_NodeId id = UA_NODEID_NUMERIC(0, 0);
+    for(UA_UInt32 r = 0; r < CONCURRENT_ROUNDS; r++) {
+        for(UA_UInt32 i = 0; i < CONCURRENT_NODES; i++) {
+            id.identifier.numeric = i + 1;
+            UA_Node *copy = NULL;
+            UA_StatusCode res = ns.getNodeCopy(ns.context, &id, &copy);
+            ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+            res = ns.replaceNode(ns.context, copy);
+            ck_assert_int_eq(res, UA_STATUSCODE_GOOD);
+        }
+        for(UA_UInt32 i = r % 2; i < CONCURRENT_NODES; i += 2) {
+            id.identifier.numeric = i + 1;
+            ns.removeNode(ns.context, &id);
+        }
+        for(UA_UInt32 i = r % 2; i < CONCURRENT_NODES; i += 2)
+            ns.insertNode(ns.context, createNode(0, i + 1), NULL);
+    }
+
+    concurrentRunning = false;
+    for(size_t i = 0; i < 4; i++) {
+        pthread_join(t[i], NULL);
+        ck_assert_uint_gt(found[i], 0);
+    }
+}
+END_TEST
+#endif
+
 static Suite * namespace_suite (void) {
     Suite *s = suite_create ("UA_NodeStore");
 
@@ -267,6 +696,12 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find, findNodeInExpandedNamespace);
     tcase_add_test (tc_find, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find, findNodesAfterRemovingOthers);
+    tcase_add_test (tc_find, statisticsCountNodes);
+    tcase_add_test (tc_find, referenceArrayStaysSorted);
+#ifdef UA_ENABLE_NODE_STRING_INTERNING
+    tcase_add_test (tc_find, copiedNodesShareStrings);
+#endif
     suite_add_tcase (s, tc_find);
 
     TCase *tc_replace = tcase_create("Replace-ZipTree");
@@ -293,6 +728,12 @@ static Suite * namespace_suite (void) {
     tcase_add_test (tc_find_hm, findNodeInExpandedNamespace);
     tcase_add_test (tc_find_hm, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
     tcase_add_test (tc_find_hm, failToFindNodeInOtherUA_NodeStore);
+    tcase_add_test (tc_find_hm, findNodesAfterRemovingOthers);
+    tcase_add_test (tc_find_hm, statisticsCountNodes);
+#if !(UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES))
+    tcase_add_test (tc_find_hm, compactNodesAreMaterialized);
+    tcase_add_test (tc_find_hm, referenceTargetCachesNode);
+#endif
     suite_add_tcase (s, tc_find_hm);
 
     TCase *tc_replace_hm = tcase_create("Replace-HashMap");
@@ -310,8 +751,22 @@ static Suite * namespace_suite (void) {
     TCase* tc_profile_hm = tcase_create ("Profile-HashMap");
     tcase_add_checked_fixture(tc_profile_hm, setupHashMap, teardown);
     tcase_add_test (tc_profile_hm, profileGetDelete);
+#if UA_MULTITHREADING >= 100 && defined(UA_ENABLE_IMMUTABLE_NODES)
+    tcase_add_test (tc_profile_hm, concurrentGetReplace);
+#endif
     suite_add_tcase (s, tc_profile_hm);
 
+    TCase* tc_layered = tcase_create ("Layered-HashMap");
+    tcase_add_checked_fixture(tc_layered, setupLayered, teardownLayered);
+    tcase_add_test (tc_layered, findNodeInUA_NodeStoreWithSingleEntry);
+    tcase_add_test (tc_layered, findNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_layered, failToFindNonExistentNodeInUA_NodeStoreWithSeveralEntries);
+    tcase_add_test (tc_layered, findNodesAfterRemovingOthers);
+    tcase_add_test (tc_layered, replaceExistingNode);
+    tcase_add_test (tc_layered, replaceOldNode);
+    tcase_add_test (tc_layered, layeredNodestoreShallShadowTheBase);
+    suite_add_tcase (s, tc_layered);
+
     return s;
 }
 
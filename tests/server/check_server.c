@@ -80,6 +80,263 @@ START_TEST(checkServer_run) {
     ck_assert_int_eq(ret, UA_STATUSCODE_GOOD);
 } END_TEST
 
+START_TEST(checkSnapshot_roundtrip) {
+    UA_UInt16 ns = UA_Server_addNamespace(server, "urn:test:snapshot");
+    UA_VariableAttributes vattr = UA_VariableAttributes_default;
+    UA_Int32 value = 42;
+    UA_Variant_setScalar(&vattr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    vattr.displayName = UA_LOCALIZEDTEXT("en-US", "Answer");
+    UA_StatusCode ret =
+        UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(ns, 1000),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(ns, "Answer"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  vattr, NULL, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    UA_ByteString snapshot;
+    ret = UA_Server_saveSnapshot(server, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    /* Load into a server where the namespace gets a different index */
+    UA_Server *server2 = UA_Server_newForUnitTest();
+    UA_Server_addNamespace(server2, "urn:test:other");
+    ret = UA_Server_loadSnapshot(server2, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    size_t ns2 = 0;
+    ret = UA_Server_getNamespaceByName(server2, UA_STRING("urn:test:snapshot"), &ns2);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(ns2, ns + 1);
+
+    UA_Variant out;
+    ret = UA_Server_readValue(server2, UA_NODEID_NUMERIC((UA_UInt16)ns2, 1000), &out);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&out, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)out.data, 42);
+    UA_Variant_clear(&out);
+
+    UA_QualifiedName bn;
+    ret = UA_Server_readBrowseName(server2, UA_NODEID_NUMERIC((UA_UInt16)ns2, 1000), &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bn.namespaceIndex, ns2);
+    UA_QualifiedName_clear(&bn);
+
+    /* The node is reachable from the ObjectsFolder */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server2, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    UA_NodeId loadedId = UA_NODEID_NUMERIC((UA_UInt16)ns2, 1000);
+    UA_Boolean found = false;
+    for(size_t i = 0; i < br.referencesSize; i++) {
+        if(UA_NodeId_equal(&br.references[i].nodeId.nodeId, &loadedId))
+            found = true;
+    }
+    ck_assert(found);
+    UA_BrowseResult_clear(&br);
+
+    UA_Server_delete(server2);
+    UA_ByteString_clear(&snapshot);
+} END_TEST
+
+START_TEST(checkSnapshot_truncated) {
+    UA_ByteString snapshot;
+    UA_StatusCode ret = UA_Server_saveSnapshot(server, &snapshot);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_ByteString part = snapshot;
+    part.length -= 3;
+    ret = UA_Server_loadSnapshot(server, &part);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADDECODINGERROR);
+    UA_ByteString_clear(&snapshot);
+} END_TEST
+
+static const UA_NodesetTableNodeId tableNodeIds[] = {
+    {0, 0, NULL},
+    {1, 5000, NULL},                       /* 1: Object */
+    {0, UA_NS0ID_OBJECTSFOLDER, NULL},     /* 2 */
+    {0, UA_NS0ID_ORGANIZES, NULL},         /* 3 */
+    {0, UA_NS0ID_BASEOBJECTTYPE, NULL},    /* 4 */
+    {1, 0, "TableVariable"},               /* 5: Variable */
+    {0, UA_NS0ID_HASCOMPONENT, NULL},      /* 6 */
+    {0, UA_NS0ID_BASEDATAVARIABLETYPE, NULL}, /* 7 */
+    {0, UA_NS0ID_INT32, NULL}              /* 8 */
+};
+
+static const UA_Byte tableValue[] = {42, 0, 0, 0};
+
+static const UA_NodesetTableNode tableNodes[] = {
+    {UA_NODECLASS_OBJECT, 0, 0, 0, 0, 1, 2, 3, 4, 0,
+     1, "TableObject", "", "TableObject", NULL, NULL, NULL,
+     0, 0, 0.0, 0, 0, NULL, NULL, -1, 0, NULL, 0},
+    {UA_NODECLASS_VARIABLE, 0, 0, UA_ACCESSLEVELMASK_READ, UA_ACCESSLEVELMASK_READ,
+     5, 1, 6, 7, 8, 1, "TableVariable", "", "TableVariable", NULL, NULL, NULL,
+     0, 0, 0.0, UA_VALUERANK_SCALAR, 0, NULL,
+     &UA_TYPES[UA_TYPES_INT32], -1, sizeof(tableValue), tableValue, 0}
+};
+
+START_TEST(checkNodesetTable_load) {
+    UA_UInt16 ns[2];
+    ns[0] = 0;
+    ns[1] = UA_Server_addNamespace(server, "http://open62541.org/nodesettable/");
+    UA_NodesetTable table = {9, tableNodeIds, 2, tableNodes, 0, NULL};
+    UA_StatusCode ret = UA_Server_loadNodesetTable(server, &table, ns, 2);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    UA_QualifiedName bn;
+    ret = UA_Server_readBrowseName(server, UA_NODEID_NUMERIC(ns[1], 5000), &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bn.namespaceIndex, ns[1]);
+    UA_QualifiedName_clear(&bn);
+
+    UA_Variant v;
+    ret = UA_Server_readValue(server, UA_NODEID_STRING(ns[1], "TableVariable"), &v);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)v.data, 42);
+    UA_Variant_clear(&v);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(ns[1], 5000);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 1);
+    UA_NodeId varId = UA_NODEID_STRING(ns[1], "TableVariable");
+    ck_assert(UA_NodeId_equal(&br.references[0].nodeId.nodeId, &varId));
+    UA_BrowseResult_clear(&br);
+} END_TEST
+
+START_TEST(checkNodesetTable_badReferences) {
+    UA_UInt16 ns[2] = {0, 1};
+    /* The nodes do not account for the reference in the table */
+    UA_NodesetTableReference ref = {3, 2, false};
+    UA_NodesetTable table = {9, tableNodeIds, 2, tableNodes, 1, &ref};
+    UA_StatusCode ret = UA_Server_loadNodesetTable(server, &table, ns, 2);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADINVALIDARGUMENT);
+} END_TEST
+
+START_TEST(checkServiceStatistics) {
+    UA_ServiceStatistics stats;
+    UA_StatusCode ret =
+        UA_Server_getServiceStatistics(server, &UA_TYPES[UA_TYPES_READREQUEST], &stats);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADNOTSUPPORTED);
+
+    UA_Server_getConfig(server)->serviceStatistics = true;
+    ret = UA_Server_run_startup(server);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+
+    ret = UA_Server_getServiceStatistics(server, &UA_TYPES[UA_TYPES_READREQUEST], &stats);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.requestCount, 0);
+    ret = UA_Server_getServiceStatistics(server, &UA_TYPES[UA_TYPES_READRESPONSE], &stats);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADSERVICEUNSUPPORTED);
+
+    UA_Server_run_shutdown(server);
+} END_TEST
+
+START_TEST(checkLatencyHistogram_quantile) {
+    UA_LatencyHistogram h;
+    memset(&h, 0, sizeof(UA_LatencyHistogram));
+    ck_assert_uint_eq(UA_LatencyHistogram_quantile(&h, 0.5), 0);
+
+    /* 90 samples in [4,7], 10 samples in [512,1023] with a maximum of 600 */
+    h.count = 100;
+    h.max = 600;
+    h.buckets[2] = 90;
+    h.buckets[9] = 10;
+    ck_assert_uint_eq(UA_LatencyHistogram_quantile(&h, 0.5), 7);
+    ck_assert_uint_eq(UA_LatencyHistogram_quantile(&h, 0.9), 7);
+    ck_assert_uint_eq(UA_LatencyHistogram_quantile(&h, 0.99), 600);
+    ck_assert_uint_eq(UA_LatencyHistogram_quantile(&h, 1.0), 600);
+} END_TEST
+
+static UA_Server *
+newServerFromImage(UA_NodestoreImage *image, UA_EventLoop *el) {
+    UA_ServerConfig config;
+    memset(&config, 0, sizeof(UA_ServerConfig));
+    config.eventLoop = el;
+    config.externalEventLoop = true;
+    UA_StatusCode ret = UA_ServerConfig_setMinimal(&config, 4841, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ret = UA_ServerConfig_setNodestoreImage(&config, image);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    return UA_Server_newWithConfig(&config);
+}
+
+START_TEST(checkNodestoreImage_shared) {
+    UA_NodestoreImage *image = UA_Server_createNodestoreImage(server);
+    ck_assert_ptr_ne(image, NULL);
+
+    /* Two more servers on the EventLoop of the first one */
+    UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+    UA_Server *s1 = newServerFromImage(image, el);
+    UA_Server *s2 = newServerFromImage(image, el);
+    ck_assert_ptr_ne(s1, NULL);
+    ck_assert_ptr_ne(s2, NULL);
+    UA_NodestoreImage_release(image);
+
+    /* Namespace zero is visible in all servers */
+    UA_QualifiedName bn;
+    UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_StatusCode ret = UA_Server_readBrowseName(s2, serverId, &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_QualifiedName_clear(&bn);
+
+    /* Nodes added to one server are not visible in the others */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_NodeId id = UA_NODEID_NUMERIC(1, 62541);
+    ret = UA_Server_addVariableNode(s1, id,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                    UA_QUALIFIEDNAME(1, "v"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    attr, NULL, NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ret = UA_Server_readBrowseName(s1, id, &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_QualifiedName_clear(&bn);
+    ret = UA_Server_readBrowseName(s2, id, &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    ret = UA_Server_readBrowseName(server, id, &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    /* Removing a shared node only hides it locally */
+    ret = UA_Server_deleteNode(s2, UA_NODEID_NUMERIC(0, UA_NS0ID_VIEWSFOLDER), true);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ret = UA_Server_readBrowseName(s1, UA_NODEID_NUMERIC(0, UA_NS0ID_VIEWSFOLDER), &bn);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_QualifiedName_clear(&bn);
+
+    /* The image is freed with the last server */
+    UA_Server_delete(s1);
+    UA_Server_delete(s2);
+} END_TEST
+
+START_TEST(checkRandomPool_refill) {
+    /* Draw across the refill boundary of the pool */
+    UA_Byte a[UA_RANDOMPOOL_SIZE + 100];
+    UA_Byte b[16];
+    memset(a, 0, sizeof(a));
+    memset(b, 0, sizeof(b));
+    UA_LOCK(&server->serviceMutex);
+    UA_StatusCode ret = getRandomBytes(server, a, sizeof(a));
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->randomPoolPos, 100);
+    ret = getRandomBytes(server, b, sizeof(b));
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->randomPoolPos, 116);
+    UA_UNLOCK(&server->serviceMutex);
+
+    /* The tail of the first draw and the second draw differ */
+    ck_assert(memcmp(&a[sizeof(a) - 16], b, 16) != 0);
+} END_TEST
+
 int main(void) {
     Suite *s = suite_create("server");
 
@@ -89,6 +346,14 @@ int main(void) {
     tcase_add_test(tc_call, checkGetNamespaceByName);
     tcase_add_test(tc_call, checkGetNamespaceById);
     tcase_add_test(tc_call, checkServer_run);
+    tcase_add_test(tc_call, checkSnapshot_roundtrip);
+    tcase_add_test(tc_call, checkSnapshot_truncated);
+    tcase_add_test(tc_call, checkNodesetTable_load);
+    tcase_add_test(tc_call, checkNodesetTable_badReferences);
+    tcase_add_test(tc_call, checkServiceStatistics);
+    tcase_add_test(tc_call, checkLatencyHistogram_quantile);
+    tcase_add_test(tc_call, checkNodestoreImage_shared);
+    tcase_add_test(tc_call, checkRandomPool_refill);
     suite_add_tcase(s, tc_call);
 
     SRunner *sr = srunner_create(s);
@@ -5,11 +5,21 @@
  *    Copyright 2020 (c) Christian von Arnim, ISW University of Stuttgart (for VDW and umati)
  */
 
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_subscription.h"
+
 #include "test_helpers.h"
+#include "testing_clock.h"
+#include "thread_wrapper.h"
 
 #include <check.h>
+#include <stdio.h>
 
 UA_Server *server_ac;
 
@@ -121,6 +131,399 @@ START_TEST(splitCreation) {
 }
 END_TEST
 
+static void
+setConditionEnabled(const UA_NodeId condition, UA_Boolean enabled) {
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &enabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_StatusCode res =
+        UA_Server_setConditionVariableFieldProperty(server_ac, condition, &value,
+                                                    UA_QUALIFIEDNAME(0, "EnabledState"),
+                                                    UA_QUALIFIEDNAME(0, "Id"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+/* Conditions are looked up by their NodeId and must match the ConditionSource */
+START_TEST(deleteWithSource) {
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.eventNotifier = UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT;
+    oattr.displayName = UA_LOCALIZEDTEXT("", "Condition Source");
+    UA_NodeId otherSource;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server_ac, UA_NODEID_NULL,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(0, "Condition Source"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oattr, NULL, &otherSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    const UA_NodeId serverSource = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_NodeId serverCondition;
+    retval = UA_Server_createCondition(server_ac, UA_NODEID_NULL,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+                                       UA_QUALIFIEDNAME(0, "Condition on the Server"),
+                                       serverSource, UA_NODEID_NULL, &serverCondition);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_NodeId otherCondition;
+    retval = UA_Server_createCondition(server_ac, UA_NODEID_NULL,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+                                       UA_QUALIFIEDNAME(0, "Condition on the Object"),
+                                       otherSource, UA_NODEID_NULL, &otherCondition);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Wrong ConditionSource */
+    retval = UA_Server_deleteCondition(server_ac, serverCondition, otherSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+    retval = UA_Server_deleteCondition(server_ac, otherCondition, serverSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    /* Deleted only once */
+    retval = UA_Server_deleteCondition(server_ac, serverCondition, serverSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_deleteCondition(server_ac, serverCondition, serverSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    /* The Condition of the other source is not affected */
+    retval = UA_Server_deleteCondition(server_ac, otherCondition, otherSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_deleteCondition(server_ac, otherCondition, otherSource);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    UA_Server_deleteNode(server_ac, otherSource, true);
+}
+END_TEST
+
+/* The NodeId of EnabledState/Id is cached. The state follows the current
+ * value of the variable. */
+START_TEST(triggerFollowsEnabledState) {
+    const UA_NodeId source = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_NodeId condition;
+    UA_StatusCode retval =
+        UA_Server_createCondition(server_ac, UA_NODEID_NULL,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+                                  UA_QUALIFIEDNAME(0, "Condition enabled state"),
+                                  source, UA_NODEID_NULL, &condition);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    retval = UA_Server_triggerConditionEvent(server_ac, condition, source, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADCONDITIONALREADYDISABLED);
+
+    for(size_t i = 0; i < 2; i++) {
+        setConditionEnabled(condition, true);
+        UA_ByteString eventId = UA_BYTESTRING_NULL;
+        retval = UA_Server_triggerConditionEvent(server_ac, condition, source, &eventId);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert_uint_gt(eventId.length, 0);
+        UA_ByteString_clear(&eventId);
+
+        setConditionEnabled(condition, false);
+        retval = UA_Server_triggerConditionEvent(server_ac, condition, source, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_BADCONDITIONALREADYDISABLED);
+    }
+
+    retval = UA_Server_deleteCondition(server_ac, condition, source);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+END_TEST
+
+/* A Condition re-created with the same NodeId does not use the state of the
+ * deleted Condition */
+START_TEST(recreateWithSameId) {
+    UA_UInt16 nsIdx = UA_Server_addNamespace(server_ac, "http://yourorganisation.org/test/");
+    const UA_NodeId requestedId = UA_NODEID_NUMERIC(nsIdx, 2000);
+    const UA_NodeId source = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+
+    for(size_t i = 0; i < 2; i++) {
+        UA_NodeId condition;
+        UA_StatusCode retval =
+            UA_Server_createCondition(server_ac, requestedId,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+                                      UA_QUALIFIEDNAME(0, "Condition re-created"),
+                                      source, UA_NODEID_NULL, &condition);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        ck_assert(UA_NodeId_equal(&condition, &requestedId));
+
+        /* Disabled after the creation */
+        retval = UA_Server_triggerConditionEvent(server_ac, condition, source, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_BADCONDITIONALREADYDISABLED);
+
+        setConditionEnabled(condition, true);
+        retval = UA_Server_triggerConditionEvent(server_ac, condition, source, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+        retval = UA_Server_deleteCondition(server_ac, condition, source);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        UA_NodeId_clear(&condition);
+    }
+}
+END_TEST
+
+/* ConditionRefresh streamed in chunks over the publish cycles. The server runs
+ * in its own thread. The fake clock only advances in runPublishCycle. So the
+ * chunks are added at defined points. */
+
+#define REFRESH_CONDITIONS 10
+#define REFRESH_CHUNK 3
+
+static UA_Boolean running;
+static size_t serverIterations;
+static THREAD_HANDLE server_thread;
+static MUTEX_HANDLE serverMutex;
+
+static UA_Client *client;
+static UA_UInt32 subscriptionId;
+static UA_Double publishingInterval;
+static size_t refreshStarts;
+static size_t refreshEnds;
+static size_t refreshedConditions;
+
+THREAD_CALLBACK(serverloop) {
+    while(running) {
+        ck_assert(MUTEX_LOCK(serverMutex));
+        UA_Server_run_iterate(server_ac, false);
+        serverIterations++;
+        ck_assert(MUTEX_UNLOCK(serverMutex));
+        UA_realSleep(1);
+    }
+    return 0;
+}
+
+/* Advance the clock by one publishing interval. Wait for the server to publish
+ * and process the response in the client. */
+static void
+runPublishCycle(void) {
+    ck_assert(MUTEX_LOCK(serverMutex));
+    UA_fakeSleep((UA_UInt32)publishingInterval + 1);
+    size_t iterations = serverIterations;
+    ck_assert(MUTEX_UNLOCK(serverMutex));
+    UA_Boolean published = false;
+    while(!published) {
+        UA_realSleep(1);
+        ck_assert(MUTEX_LOCK(serverMutex));
+        published = (serverIterations > iterations + 1);
+        ck_assert(MUTEX_UNLOCK(serverMutex));
+    }
+    UA_Client_run_iterate(client, 20);
+}
+
+/* Run the publish cycles until the RefreshEndEvent was received */
+static size_t
+runUntilRefreshEnd(size_t ends) {
+    size_t cycles = 0;
+    for(; cycles < 100 && refreshEnds < ends; cycles++)
+        runPublishCycle();
+    ck_assert_uint_eq(refreshEnds, ends);
+    return cycles;
+}
+
+static void
+refreshHandler(UA_Client *c, UA_UInt32 subId, void *subContext,
+               UA_UInt32 monId, void *monContext,
+               size_t nEventFields, UA_Variant *eventFields) {
+    ck_assert_uint_eq(nEventFields, 1);
+    ck_assert(UA_Variant_hasScalarType(&eventFields[0], &UA_TYPES[UA_TYPES_NODEID]));
+    UA_NodeId *eventType = (UA_NodeId*)eventFields[0].data;
+    UA_NodeId startType = UA_NODEID_NUMERIC(0, UA_NS0ID_REFRESHSTARTEVENTTYPE);
+    UA_NodeId endType = UA_NODEID_NUMERIC(0, UA_NS0ID_REFRESHENDEVENTTYPE);
+    if(UA_NodeId_equal(eventType, &startType)) {
+        refreshStarts++;
+    } else if(UA_NodeId_equal(eventType, &endType)) {
+        refreshEnds++;
+    } else {
+        /* The Conditions come between the start and the end event */
+        ck_assert_uint_gt(refreshStarts, refreshEnds);
+        refreshedConditions++;
+    }
+}
+
+/* Retained and enabled. Enabling triggers the first event of the Condition. */
+static void
+addRetainedCondition(size_t index) {
+    char name[32];
+    snprintf(name, sizeof(name), "Condition %u", (unsigned)index);
+    UA_NodeId condition;
+    UA_StatusCode res =
+        UA_Server_createCondition(server_ac, UA_NODEID_NULL,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE),
+                                  UA_QUALIFIEDNAME(0, name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                  UA_NODEID_NULL, &condition);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Boolean retain = true;
+    res = UA_Server_writeObjectProperty_scalar(server_ac, condition,
+                                               UA_QUALIFIEDNAME(0, "Retain"),
+                                               &retain, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Boolean enabled = true;
+    UA_Variant value;
+    UA_Variant_setScalar(&value, &enabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    res = UA_Server_setConditionVariableFieldProperty(server_ac, condition, &value,
+                                                      UA_QUALIFIEDNAME(0, "EnabledState"),
+                                                      UA_QUALIFIEDNAME(0, "Id"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+/* Subscription with an event MonitoredItem on the Server Object */
+static void
+createRefreshSubscription(void) {
+    UA_CreateSubscriptionResponse response =
+        UA_Client_Subscriptions_create(client, UA_CreateSubscriptionRequest_default(),
+                                       NULL, NULL, NULL);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    subscriptionId = response.subscriptionId;
+    publishingInterval = response.revisedPublishingInterval;
+
+    UA_SimpleAttributeOperand select;
+    UA_SimpleAttributeOperand_init(&select);
+    select.typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    select.browsePathSize = 1;
+    UA_QualifiedName eventTypeName = UA_QUALIFIEDNAME(0, "EventType");
+    select.browsePath = &eventTypeName;
+    select.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = &select;
+    filter.selectClausesSize = 1;
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 100;
+    UA_MonitoredItemCreateResult result =
+        UA_Client_MonitoredItems_createEvent(client, subscriptionId,
+                                             UA_TIMESTAMPSTORETURN_BOTH, item,
+                                             NULL, refreshHandler, NULL);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+    UA_MonitoredItemCreateResult_clear(&result);
+}
+
+static void
+callConditionRefresh(void) {
+    UA_Variant input;
+    UA_Variant_setScalar(&input, &subscriptionId, &UA_TYPES[UA_TYPES_UINT32]);
+    size_t outputSize = 0;
+    UA_Variant *output = NULL;
+    UA_StatusCode res =
+        UA_Client_call(client, UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE),
+                       UA_NODEID_NUMERIC(0, UA_NS0ID_CONDITIONTYPE_CONDITIONREFRESH),
+                       1, &input, &outputSize, &output);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Array_delete(output, outputSize, &UA_TYPES[UA_TYPES_VARIANT]);
+}
+
+/* Inspect the pending refresh of the MonitoredItem in the server */
+static void
+checkRefreshState(UA_ConditionRefreshState state, size_t queueSize) {
+    ck_assert(MUTEX_LOCK(serverMutex));
+    UA_LOCK(&server_ac->serviceMutex);
+    UA_Subscription *sub = getSubscriptionById(server_ac, subscriptionId);
+    ck_assert_ptr_ne(sub, NULL);
+    UA_MonitoredItem *mon = LIST_FIRST(&sub->monitoredItems);
+    ck_assert_ptr_ne(mon, NULL);
+    ck_assert_int_eq(mon->refreshState, state);
+    ck_assert_uint_eq(sub->conditionRefreshes,
+                      (state == UA_CONDITIONREFRESH_NONE) ? 0 : 1);
+    ck_assert_uint_eq(mon->queueSize, queueSize);
+    UA_UNLOCK(&server_ac->serviceMutex);
+    ck_assert(MUTEX_UNLOCK(serverMutex));
+}
+
+static void
+setupRefresh(void) {
+    running = true;
+    serverIterations = 0;
+    refreshStarts = 0;
+    refreshEnds = 0;
+    refreshedConditions = 0;
+    ck_assert(MUTEX_INIT(serverMutex));
+
+    server_ac = UA_Server_newForUnitTest();
+    ck_assert_ptr_ne(server_ac, NULL);
+    UA_Server_getConfig(server_ac)->maxConditionRefreshPerPublish = REFRESH_CHUNK;
+    UA_StatusCode res = UA_Server_run_startup(server_ac);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < REFRESH_CONDITIONS; i++)
+        addRetainedCondition(i);
+    THREAD_CREATE(server_thread, serverloop);
+
+    client = UA_Client_newForUnitTest();
+    res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    createRefreshSubscription();
+}
+
+static void
+teardownRefresh(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    UA_Server_run_shutdown(server_ac);
+    UA_Server_delete(server_ac);
+    ck_assert(MUTEX_DESTROY(serverMutex));
+}
+
+START_TEST(refreshInChunks) {
+    /* The RefreshStartEvent and the first chunk are added right away */
+    callConditionRefresh();
+    checkRefreshState(UA_CONDITIONREFRESH_CONDITIONS, 1 + REFRESH_CHUNK);
+
+    /* One chunk per publish cycle. The RefreshEndEvent follows the last
+     * Condition. */
+    size_t cycles = runUntilRefreshEnd(1);
+    ck_assert_uint_ge(cycles, (REFRESH_CONDITIONS - REFRESH_CHUNK) / REFRESH_CHUNK);
+    ck_assert_uint_eq(refreshStarts, 1);
+    ck_assert_uint_eq(refreshedConditions, REFRESH_CONDITIONS);
+    checkRefreshState(UA_CONDITIONREFRESH_NONE, 0);
+} END_TEST
+
+START_TEST(refreshRestart) {
+    /* The second refresh restarts the pending one before it has ended */
+    callConditionRefresh();
+    callConditionRefresh();
+    checkRefreshState(UA_CONDITIONREFRESH_CONDITIONS, 2 * (1 + REFRESH_CHUNK));
+
+    /* Only the second refresh runs to the end */
+    runUntilRefreshEnd(1);
+    ck_assert_uint_eq(refreshStarts, 2);
+    ck_assert_uint_eq(refreshedConditions, REFRESH_CHUNK + REFRESH_CONDITIONS);
+    checkRefreshState(UA_CONDITIONREFRESH_NONE, 0);
+
+    /* No further events */
+    runPublishCycle();
+    ck_assert_uint_eq(refreshEnds, 1);
+    ck_assert_uint_eq(refreshedConditions, REFRESH_CHUNK + REFRESH_CONDITIONS);
+} END_TEST
+
+START_TEST(refreshDeleteSubscription) {
+    callConditionRefresh();
+    checkRefreshState(UA_CONDITIONREFRESH_CONDITIONS, 1 + REFRESH_CHUNK);
+
+    /* Delete the Subscription with the refresh pending */
+    UA_StatusCode res = UA_Client_Subscriptions_deleteSingle(client, subscriptionId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 5; i++)
+        runPublishCycle();
+    ck_assert_uint_eq(refreshEnds, 0);
+
+    /* A refresh on a new Subscription is not affected */
+    refreshStarts = 0;
+    refreshedConditions = 0;
+    createRefreshSubscription();
+    callConditionRefresh();
+    runUntilRefreshEnd(1);
+    ck_assert_uint_eq(refreshStarts, 1);
+    ck_assert_uint_eq(refreshedConditions, REFRESH_CONDITIONS);
+} END_TEST
+
 #endif
 
 int main(void) {
@@ -130,11 +533,23 @@ int main(void) {
 #ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
     tcase_add_test(tc_call, createDelete);
     tcase_add_test(tc_call, splitCreation);
+    tcase_add_test(tc_call, deleteWithSource);
+    tcase_add_test(tc_call, triggerFollowsEnabledState);
+    tcase_add_test(tc_call, recreateWithSameId);
 #endif
     tcase_add_checked_fixture(tc_call, setup, teardown);
 
     suite_add_tcase(s, tc_call);
 
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    TCase *tc_refresh = tcase_create("ConditionRefresh");
+    tcase_add_checked_fixture(tc_refresh, setupRefresh, teardownRefresh);
+    tcase_add_test(tc_refresh, refreshInChunks);
+    tcase_add_test(tc_refresh, refreshRestart);
+    tcase_add_test(tc_refresh, refreshDeleteSubscription);
+    suite_add_tcase(s, tc_refresh);
+#endif
+
     SRunner *sr = srunner_create(s);
     srunner_set_fork_status(sr, CK_NOFORK);
     srunner_run_all(sr, CK_NORMAL);
@@ -0,0 +1,113 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+static UA_Server *server;
+static UA_Boolean running;
+static THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(Alloc_phases) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_Server_resetAllocStatistics(server);
+
+    /* Every read allocates for the decoded request and the response */
+    for(size_t i = 0; i < 10; i++) {
+        UA_Variant value;
+        res = UA_Client_readValueAttribute(client,
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS), &value);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&value);
+    }
+
+    UA_AllocStatistics stats;
+    res = UA_Server_getAllocStatistics(server, &stats);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(stats.phases[UA_ALLOCPHASE_DECODE].count, 0);
+    ck_assert_uint_gt(stats.phases[UA_ALLOCPHASE_SERVICE].count, 0);
+
+    /* The sites are sorted by the number of allocations */
+    ck_assert_uint_gt(stats.sitesSize, 0);
+    ck_assert(stats.sites[0].file != NULL);
+    ck_assert_uint_gt(stats.sites[0].line, 0);
+    for(size_t i = 1; i < stats.sitesSize; i++)
+        ck_assert_uint_ge(stats.sites[i-1].counter.count, stats.sites[i].counter.count);
+    UA_AllocStatistics_clear(&stats);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(Alloc_reset) {
+    UA_Server_resetAllocStatistics(server);
+    void *p = UA_malloc(64);
+    UA_free(p);
+
+    UA_AllocStatistics stats;
+    UA_StatusCode res = UA_Server_getAllocStatistics(server, &stats);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The allocation above is found with the file name of this test */
+    UA_Boolean found = false;
+    for(size_t i = 0; i < stats.sitesSize; i++) {
+        if(strstr(stats.sites[i].file, "check_server_alloc_profile.c") &&
+           stats.sites[i].counter.bytes >= 64)
+            found = true;
+    }
+    ck_assert(found);
+    UA_AllocStatistics_clear(&stats);
+} END_TEST
+
+static Suite *testSuite_allocProfile(void) {
+    TCase *tc = tcase_create("AllocProfile");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Alloc_phases);
+    tcase_add_test(tc, Alloc_reset);
+    Suite *s = suite_create("Server Allocation Profile");
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_allocProfile();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -11,6 +11,8 @@
 #include <open62541/client_highlevel_async.h>
 #include <open62541/plugin/log_stdout.h>
 
+#include "ua_server_internal.h"
+
 #include "testing_clock.h"
 #include "test_helpers.h"
 #include "thread_wrapper.h"
@@ -22,6 +24,7 @@ UA_Boolean running;
 THREAD_HANDLE server_thread;
 static UA_Server *server;
 static size_t clientCounter;
+static volatile UA_Boolean blockMethod; /* Keep the worker busy */
 
 static UA_StatusCode
 methodCallback(UA_Server *serverArg,
@@ -30,13 +33,48 @@ methodCallback(UA_Server *serverArg,
                const UA_NodeId *objectId, void *objectContext,
                size_t inputSize, const UA_Variant *input,
                size_t outputSize, UA_Variant *output) {
+    while(blockMethod)
+        UA_realSleep(1);
     return UA_STATUSCODE_GOOD;
 }
 
+/* The id of the pending async read. The DataSource completes synchronously
+ * until asyncRead is set (adding the node reads the value for type checking).
+ * With earlyRead, the result is submitted before the callback returns. */
+static UA_Boolean asyncRead;
+static UA_Boolean earlyRead;
+static UA_UInt32 readId;
+
+static UA_StatusCode
+asyncReadCallback(UA_Server *serverArg,
+                  const UA_NodeId *sessionId, void *sessionContext,
+                  const UA_NodeId *nodeId, void *nodeContext,
+                  UA_Boolean includeSourceTimeStamp,
+                  const UA_NumericRange *range, UA_DataValue *value) {
+    if(!asyncRead)
+        return UA_STATUSCODE_GOOD;
+    readId = UA_Server_getAsyncReadId(serverArg, value);
+    if(readId == 0)
+        return UA_STATUSCODE_BADINTERNALERROR;
+    if(earlyRead) {
+        UA_Int32 v = 43;
+        UA_DataValue dv;
+        UA_DataValue_init(&dv);
+        UA_Variant_setScalar(&dv.value, &v, &UA_TYPES[UA_TYPES_INT32]);
+        dv.hasValue = true;
+        UA_StatusCode res = UA_Server_setAsyncReadResult(serverArg, readId, &dv);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    return UA_STATUSCODE_GOODCOMPLETESASYNCHRONOUSLY;
+}
+
+static UA_StatusCode lastServiceResult;
+
 static void
 clientReceiveCallback(UA_Client *client, void *userdata,
                       UA_UInt32 requestId, UA_CallResponse *cr) {
     UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_CLIENT, "Received call response");
+    lastServiceResult = cr->responseHeader.serviceResult;
     clientCounter++;
 }
 
@@ -46,13 +84,14 @@ THREAD_CALLBACK(serverloop) {
     return 0;
 }
 
-static void setup(void) {
+static void setupServer(UA_UInt16 workers) {
     clientCounter = 0;
     running = true;
     server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
     UA_ServerConfig *config = UA_Server_getConfig(server);
     config->asyncOperationTimeout = 2000.0; /* 2 seconds */
+    config->asyncOperationWorkers = workers;
 
     UA_MethodAttributes methodAttr = UA_MethodAttributes_default;
     methodAttr.executable = true;
@@ -79,10 +118,44 @@ static void setup(void) {
     res = UA_Server_setMethodNodeAsync(server, UA_NODEID_STRING(1, "asyncMethod"), true);
     ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
 
+    /* Synchronous Variable */
+    UA_VariableAttributes varAttr = UA_VariableAttributes_default;
+    UA_Int32 value = 23;
+    UA_Variant_setScalar(&varAttr.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "variable"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                    UA_QUALIFIEDNAME(1, "variable"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                    varAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Variable with an asynchronous DataSource */
+    asyncRead = false;
+    earlyRead = false;
+    readId = 0;
+    UA_DataSource dataSource = {asyncReadCallback, NULL};
+    varAttr = UA_VariableAttributes_default;
+    res = UA_Server_addDataSourceVariableNode(server, UA_NODEID_STRING(1, "asyncVariable"),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                              UA_QUALIFIEDNAME(1, "asyncVariable"),
+                                              UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                              varAttr, dataSource, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
     UA_Server_run_startup(server);
     THREAD_CREATE(server_thread, serverloop);
 }
 
+static void setup(void) {
+    setupServer(0);
+}
+
+static void setupWorkers(void) {
+    setupServer(3);
+}
+
 static void teardown(void) {
     running = false;
     THREAD_JOIN(server_thread);
@@ -193,6 +266,90 @@ START_TEST(Async_timeout) {
     UA_Client_delete(client);
 } END_TEST
 
+START_TEST(Async_admission) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    /* Allow one request in flight for the session */
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxPendingRequestsPerSession = 1;
+
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "asyncMethod"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, true);
+
+    /* The second request is rejected right away */
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "asyncMethod"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    while(clientCounter == 0) {
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 0);
+    }
+    ck_assert_uint_eq(clientCounter, 1);
+    ck_assert_uint_eq(lastServiceResult, UA_STATUSCODE_BADTOOMANYOPERATIONS);
+
+    /* The server-wide limit */
+    config->maxPendingRequestsPerSession = 0;
+    config->maxPendingRequests = 1;
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "asyncMethod"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    while(clientCounter == 1) {
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 0);
+    }
+    ck_assert_uint_eq(lastServiceResult, UA_STATUSCODE_BADRESOURCEUNAVAILABLE);
+    ck_assert_uint_eq(server->serverDiagnosticsSummary.rejectedRequestsCount, 2);
+
+    /* Answer the first request */
+    UA_AsyncOperationType aot;
+    const UA_AsyncOperationRequest *request;
+    void *context = NULL;
+    UA_DateTime timeout = 0;
+    UA_Boolean haveAsync =
+        UA_Server_getAsyncOperationNonBlocking(server, &aot, &request, &context, &timeout);
+    ck_assert_uint_eq(haveAsync, true);
+    UA_AsyncOperationResponse response;
+    UA_CallMethodResult_init(&response.callMethodResult);
+    UA_Server_setAsyncOperationResult(server, &response, context);
+    while(clientCounter == 2) {
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 0);
+    }
+    ck_assert_uint_eq(lastServiceResult, UA_STATUSCODE_GOOD);
+
+    /* Accepted again */
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "method"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    while(clientCounter == 3) {
+        UA_Server_run_iterate(server, true);
+        UA_Client_run_iterate(client, 0);
+    }
+    ck_assert_uint_eq(lastServiceResult, UA_STATUSCODE_GOOD);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
 START_TEST(Async_cancel) {
     UA_Client *client = UA_Client_newForUnitTest();
     UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
@@ -301,6 +458,269 @@ START_TEST(Async_timeout_worker) {
     UA_Client_delete(client);
 } END_TEST
 
+static UA_ReadResponse readResponse;
+
+static void
+clientReadCallback(UA_Client *client, void *userdata,
+                   UA_UInt32 requestId, UA_ReadResponse *rr) {
+    UA_ReadResponse_copy(rr, &readResponse);
+    clientCounter++;
+}
+
+/* Read the async and the sync variable in one request */
+static void
+sendMixedRead(UA_Client *client) {
+    UA_ReadValueId rvi[2];
+    UA_ReadValueId_init(&rvi[0]);
+    rvi[0].nodeId = UA_NODEID_STRING(1, "asyncVariable");
+    rvi[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadValueId_init(&rvi[1]);
+    rvi[1].nodeId = UA_NODEID_STRING(1, "variable");
+    rvi[1].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadRequest rr;
+    UA_ReadRequest_init(&rr);
+    rr.nodesToRead = rvi;
+    rr.nodesToReadSize = 2;
+    rr.timestampsToReturn = UA_TIMESTAMPSTORETURN_SERVER;
+    UA_StatusCode retval =
+        UA_Client_sendAsyncReadRequest(client, &rr, clientReadCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+START_TEST(Async_read) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    asyncRead = true;
+    sendMixedRead(client);
+    UA_Server_run_iterate(server, true);
+    ck_assert_uint_ne(readId, 0);
+
+    /* The response waits for the async item */
+    UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(clientCounter, 0);
+
+    /* Complete the async item. The response is sent right away. */
+    UA_Int32 value = 42;
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &value, &UA_TYPES[UA_TYPES_INT32]);
+    dv.hasValue = true;
+    retval = UA_Server_setAsyncReadResult(server, readId, &dv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    while(clientCounter == 0)
+        UA_Client_run_iterate(client, 10);
+    ck_assert_uint_eq(readResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(readResponse.resultsSize, 2);
+    ck_assert(readResponse.results[0].hasValue);
+    ck_assert(readResponse.results[0].hasServerTimestamp);
+    ck_assert(!readResponse.results[0].hasSourceTimestamp);
+    ck_assert_int_eq(*(UA_Int32*)readResponse.results[0].value.data, 42);
+    ck_assert(readResponse.results[1].hasValue);
+    ck_assert_int_eq(*(UA_Int32*)readResponse.results[1].value.data, 23);
+    UA_ReadResponse_clear(&readResponse);
+
+    /* The operation is done */
+    retval = UA_Server_setAsyncReadResult(server, readId, &dv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+START_TEST(Async_read_timeout) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    asyncRead = true;
+    sendMixedRead(client);
+    UA_Server_run_iterate(server, true);
+    ck_assert_uint_ne(readId, 0);
+
+    /* Force a timeout */
+    UA_fakeSleep(2500);
+    UA_Server_run_iterate(server, true);
+    UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(clientCounter, 1);
+    ck_assert_uint_eq(readResponse.resultsSize, 2);
+    ck_assert_uint_eq(readResponse.results[0].status, UA_STATUSCODE_BADTIMEOUT);
+    ck_assert(readResponse.results[1].hasValue);
+    UA_ReadResponse_clear(&readResponse);
+
+    /* The late result is rejected */
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    retval = UA_Server_setAsyncReadResult(server, readId, &dv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    UA_ServerStatistics stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.aos.timeoutCount, 1);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* The DataSource submits the result before its callback has returned. The
+ * operation is registered before the callback. So the result is not lost and
+ * the response is sent without waiting. */
+START_TEST(Async_read_early) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    asyncRead = true;
+    earlyRead = true;
+    sendMixedRead(client);
+    UA_Server_run_iterate(server, true);
+    ck_assert_uint_ne(readId, 0);
+
+    while(clientCounter == 0)
+        UA_Client_run_iterate(client, 10);
+    ck_assert_uint_eq(readResponse.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(readResponse.resultsSize, 2);
+    ck_assert(readResponse.results[0].hasValue);
+    ck_assert(readResponse.results[0].hasServerTimestamp);
+    ck_assert_int_eq(*(UA_Int32*)readResponse.results[0].value.data, 43);
+    ck_assert(readResponse.results[1].hasValue);
+    ck_assert_int_eq(*(UA_Int32*)readResponse.results[1].value.data, 23);
+    UA_ReadResponse_clear(&readResponse);
+
+    /* The id is not reused for the next operation */
+    UA_UInt32 firstId = readId;
+    sendMixedRead(client);
+    UA_Server_run_iterate(server, true);
+    ck_assert_uint_ne(readId, firstId);
+    while(clientCounter < 2)
+        UA_Client_run_iterate(client, 10);
+    UA_ReadResponse_clear(&readResponse);
+
+    /* The operation is done */
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    retval = UA_Server_setAsyncReadResult(server, firstId, &dv);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADNOTFOUND);
+
+    UA_ServerStatistics stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.aos.timeoutCount, 0);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+static void
+clientGoodCallback(UA_Client *client, void *userdata,
+                   UA_UInt32 requestId, UA_CallResponse *cr) {
+    ck_assert_uint_eq(cr->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(cr->resultsSize, 1);
+    ck_assert_uint_eq(cr->results[0].statusCode, UA_STATUSCODE_GOOD);
+    clientCounter++;
+}
+
+#define WORKER_CALLS 20
+
+/* The server-owned workers process the operations and send out the responses
+ * without waiting for the cyclic processing of the async results */
+START_TEST(Async_workers) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < WORKER_CALLS; i++) {
+        retval = UA_Client_call_async(client,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_STRING(1, "asyncMethod"),
+                                      0, NULL, clientGoodCallback, NULL, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* The (fake) clock does not advance. So the responses cannot come from
+     * the cyclic callback. */
+    while(clientCounter < WORKER_CALLS)
+        UA_Client_run_iterate(client, 10);
+
+    UA_ServerStatistics stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.aos.operationCount, WORKER_CALLS);
+    ck_assert_uint_eq(stat.aos.timeoutCount, 0);
+    ck_assert_uint_ge(stat.aos.processingTime, stat.aos.maxProcessingTime);
+
+    /* The application can still take operations. There are none left. */
+    UA_AsyncOperationType aot;
+    const UA_AsyncOperationRequest *request;
+    void *context = NULL;
+    UA_Boolean haveAsync =
+        UA_Server_getAsyncOperationNonBlocking(server, &aot, &request, &context, NULL);
+    ck_assert_uint_eq(haveAsync, false);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+/* The operation times out while the worker executes the method. The response
+ * is sent right away. The late result is discarded. */
+START_TEST(Async_workers_timeout) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode retval = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Stop the server thread. Iterate manually from now on */
+    running = false;
+    THREAD_JOIN(server_thread);
+
+    blockMethod = true;
+    retval = UA_Client_call_async(client,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_STRING(1, "asyncMethod"),
+                                  0, NULL, clientReceiveCallback, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, true);
+    UA_realSleep(100); /* The worker takes the operation */
+
+    /* Force a timeout */
+    UA_fakeSleep(2500);
+    UA_Server_run_iterate(server, true);
+    while(clientCounter == 0)
+        UA_Client_run_iterate(client, 10);
+    UA_ServerStatistics stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.aos.timeoutCount, 1);
+
+    /* Release the worker. The result is not counted. */
+    blockMethod = false;
+    UA_realSleep(100);
+    UA_Server_run_iterate(server, false);
+    stat = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(stat.aos.operationCount, 0);
+
+    running = true;
+    THREAD_CREATE(server_thread, serverloop);
+
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
 static Suite* method_async_suite(void) {
     /* set up unit test for internal data structures */
     Suite *s = suite_create("Async Method");
@@ -309,11 +729,21 @@ static Suite* method_async_suite(void) {
     tcase_add_checked_fixture(tc_manager, setup, teardown);
     tcase_add_test(tc_manager, Async_call);
     tcase_add_test(tc_manager, Async_timeout);
+    tcase_add_test(tc_manager, Async_admission);
     tcase_add_test(tc_manager, Async_cancel);
     tcase_add_test(tc_manager, Async_cancel_multiple);
     tcase_add_test(tc_manager, Async_timeout_worker);
+    tcase_add_test(tc_manager, Async_read);
+    tcase_add_test(tc_manager, Async_read_timeout);
+    tcase_add_test(tc_manager, Async_read_early);
     suite_add_tcase(s, tc_manager);
 
+    TCase* tc_workers = tcase_create("AsyncWorkers");
+    tcase_add_checked_fixture(tc_workers, setupWorkers, teardown);
+    tcase_add_test(tc_workers, Async_workers);
+    tcase_add_test(tc_workers, Async_workers_timeout);
+    suite_add_tcase(s, tc_workers);
+
     return s;
 }
 
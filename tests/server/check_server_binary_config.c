@@ -0,0 +1,231 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/server_config_file_based.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+/* The record layout and the tags are part of the stored format. So they are
+ * spelled out here and must not change. */
+#define BINARYCONFIG_MAGIC 0x42435541
+#define BINARYCONFIG_VERSION 1
+#define TAG_SERVERURLS 6
+#define TAG_MAXSESSIONS 15
+#define TAG_UNKNOWN 0x7fff
+
+static UA_Byte buf[512];
+static size_t bufLength;
+
+static void
+appendUInt32(UA_UInt32 v) {
+    for(size_t i = 0; i < 4; i++)
+        buf[bufLength++] = (UA_Byte)(v >> (i * 8));
+}
+
+static void
+appendRecord(UA_UInt16 tag, UA_UInt32 length, const void *payload,
+             size_t payloadLength) {
+    buf[bufLength++] = (UA_Byte)tag;
+    buf[bufLength++] = (UA_Byte)(tag >> 8);
+    appendUInt32(length);
+    ck_assert(bufLength + payloadLength <= sizeof(buf));
+    memcpy(&buf[bufLength], payload, payloadLength);
+    bufLength += payloadLength;
+}
+
+static void
+startConfig(void) {
+    bufLength = 0;
+    appendUInt32(BINARYCONFIG_MAGIC);
+    appendUInt32(BINARYCONFIG_VERSION);
+}
+
+static UA_StatusCode
+loadConfig(UA_ServerConfig *config) {
+    UA_ByteString bc = {bufLength, buf};
+    memset(config, 0, sizeof(UA_ServerConfig));
+    UA_StatusCode res = UA_ServerConfig_setDefault(config);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return UA_ServerConfig_updateFromBinary(config, bc);
+}
+
+START_TEST(unknownTagIsSkipped) {
+    startConfig();
+    const UA_Byte unknown[3] = {1, 2, 3};
+    appendRecord(TAG_UNKNOWN, sizeof(unknown), unknown, sizeof(unknown));
+    const UA_Byte maxSessions[2] = {17, 0};
+    appendRecord(TAG_MAXSESSIONS, sizeof(maxSessions), maxSessions,
+                 sizeof(maxSessions));
+
+    UA_ServerConfig config;
+    UA_StatusCode res = loadConfig(&config);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(config.maxSessions, 17);
+    UA_ServerConfig_clean(&config);
+} END_TEST
+
+START_TEST(badHeader) {
+    UA_ServerConfig config;
+    startConfig();
+    buf[0] ^= 0xff;
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+
+    startConfig();
+    buf[4] = BINARYCONFIG_VERSION + 1;
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+
+    UA_ByteString empty = {0, buf};
+    ck_assert_ptr_eq(UA_Server_newFromBinaryConfig(empty), NULL);
+} END_TEST
+
+START_TEST(oversizedLength) {
+    const UA_Byte maxSessions[2] = {17, 0};
+    UA_ServerConfig config;
+
+    /* The length exceeds the remaining input */
+    startConfig();
+    appendRecord(TAG_MAXSESSIONS, UA_UINT32_MAX, maxSessions, sizeof(maxSessions));
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    ck_assert_uint_ne(config.maxSessions, 17);
+    UA_ServerConfig_clean(&config);
+
+    startConfig();
+    appendRecord(TAG_MAXSESSIONS, sizeof(maxSessions) + 1, maxSessions,
+                 sizeof(maxSessions));
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+
+    /* The payload is too short for the field */
+    startConfig();
+    appendRecord(TAG_MAXSESSIONS, 1, maxSessions, 1);
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+
+    /* The array length in the Variant of the payload exceeds the payload */
+    startConfig();
+    const UA_Byte urls[9] = {UA_NS0ID_STRING | 0x80, 0xff, 0xff, 0xff, 0x7f,
+                             0xff, 0xff, 0xff, 0xff};
+    appendRecord(TAG_SERVERURLS, sizeof(urls), urls, sizeof(urls));
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+
+    /* An array record with a scalar of the wrong type */
+    startConfig();
+    const UA_Byte scalar[5] = {UA_NS0ID_UINT32, 1, 0, 0, 0};
+    appendRecord(TAG_SERVERURLS, sizeof(scalar), scalar, sizeof(scalar));
+    ck_assert_uint_eq(loadConfig(&config), UA_STATUSCODE_BADDECODINGERROR);
+    UA_ServerConfig_clean(&config);
+} END_TEST
+
+#ifdef UA_ENABLE_JSON_ENCODING
+
+static const char *json5Config =
+    "{\n"
+    "  applicationDescription: {\n"
+    "    applicationUri: \"urn:open62541.binaryconfig.test\",\n"
+    "    applicationName: { locale: \"en-US\", text: \"Binary Config\" },\n"
+    "    applicationType: 0\n"
+    "  },\n"
+    "  serverUrls: [\"opc.tcp://localhost:4842\"],\n"
+    "  maxSecureChannels: 7,\n"
+    "  maxSessions: 9,\n"
+    "  shutdownDelay: 0.0\n"
+    "}\n";
+
+static UA_ByteString
+jsonToBinary(void) {
+    UA_ByteString json = {strlen(json5Config), (UA_Byte*)(uintptr_t)json5Config};
+    UA_ByteString bc = UA_BYTESTRING_NULL;
+    UA_StatusCode res = UA_ServerConfig_jsonToBinary(json, &bc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(bc.length, 8);
+    return bc;
+}
+
+START_TEST(jsonToBinaryRoundTrip) {
+    UA_ByteString bc = jsonToBinary();
+    UA_Server *server = UA_Server_newFromBinaryConfig(bc);
+    UA_ByteString_clear(&bc);
+    ck_assert_ptr_ne(server, NULL);
+
+    /* The same settings as loaded from Json5 */
+    UA_ByteString json = {strlen(json5Config), (UA_Byte*)(uintptr_t)json5Config};
+    UA_Server *jsonServer = UA_Server_newFromFile(json);
+    ck_assert_ptr_ne(jsonServer, NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    UA_ServerConfig *jsonServerConfig = UA_Server_getConfig(jsonServer);
+    ck_assert_uint_eq(config->maxSecureChannels, 7);
+    ck_assert_uint_eq(config->maxSessions, 9);
+    ck_assert_uint_eq(config->maxSecureChannels, jsonServerConfig->maxSecureChannels);
+    ck_assert_uint_eq(config->maxSessions, jsonServerConfig->maxSessions);
+    ck_assert(UA_ApplicationDescription_equal(&config->applicationDescription,
+                                              &jsonServerConfig->applicationDescription));
+    ck_assert_uint_eq(config->serverUrlsSize, 1);
+    UA_String url = UA_STRING("opc.tcp://localhost:4842");
+    ck_assert(UA_String_equal(&config->serverUrls[0], &url));
+    UA_Server_delete(jsonServer);
+
+    /* The server starts with the configuration */
+    UA_StatusCode res = UA_Server_run_startup(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+    res = UA_Server_run_shutdown(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_delete(server);
+} END_TEST
+
+/* Every truncation of a valid configuration is either rejected or, if it ends
+ * on a record boundary, loads a subset of the settings */
+START_TEST(truncatedInput) {
+    UA_ByteString bc = jsonToBinary();
+    for(size_t len = 0; len < bc.length; len++) {
+        UA_ByteString part = {len, bc.data};
+        UA_ServerConfig config;
+        memset(&config, 0, sizeof(UA_ServerConfig));
+        UA_StatusCode res = UA_ServerConfig_setDefault(&config);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        res = UA_ServerConfig_updateFromBinary(&config, part);
+        ck_assert(res == UA_STATUSCODE_GOOD || res == UA_STATUSCODE_BADDECODINGERROR);
+        if(len < 8 || len == bc.length - 1)
+            ck_assert_uint_eq(res, UA_STATUSCODE_BADDECODINGERROR);
+        UA_ServerConfig_clean(&config);
+    }
+
+    /* The server is not created from a truncated configuration */
+    UA_ByteString part = {bc.length - 1, bc.data};
+    ck_assert_ptr_eq(UA_Server_newFromBinaryConfig(part), NULL);
+    UA_ByteString_clear(&bc);
+} END_TEST
+
+#endif
+
+static Suite *testSuite_binaryConfig(void) {
+    Suite *s = suite_create("Binary Server Configuration");
+    TCase *tc = tcase_create("Core");
+    tcase_add_test(tc, unknownTagIsSkipped);
+    tcase_add_test(tc, badHeader);
+    tcase_add_test(tc, oversizedLength);
+#ifdef UA_ENABLE_JSON_ENCODING
+    tcase_add_test(tc, jsonToBinaryRoundTrip);
+    tcase_add_test(tc, truncatedInput);
+#endif
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_binaryConfig();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
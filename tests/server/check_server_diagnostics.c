@@ -0,0 +1,159 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/server_config_default.h>
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+#define CLIENTS 3
+
+static UA_Server *server;
+static UA_Boolean running;
+static THREAD_HANDLE server_thread;
+static UA_Client *clients[CLIENTS];
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+
+    for(size_t i = 0; i < CLIENTS; i++) {
+        clients[i] = UA_Client_newForUnitTest();
+        UA_StatusCode res = UA_Client_connect(clients[i], "opc.tcp://localhost:4840");
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+}
+
+static void teardown(void) {
+    for(size_t i = 0; i < CLIENTS; i++) {
+        UA_Client_disconnect(clients[i]);
+        UA_Client_delete(clients[i]);
+    }
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_StatusCode
+readRange(UA_UInt32 id, const char *range, UA_Variant *out) {
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_NUMERIC(0, id);
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    if(range)
+        rvi.indexRange = UA_STRING((char*)(uintptr_t)range);
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = &rvi;
+    request.nodesToReadSize = 1;
+    UA_ReadResponse response = UA_Client_Service_read(clients[0], request);
+    UA_StatusCode res = response.responseHeader.serviceResult;
+    if(res == UA_STATUSCODE_GOOD && response.resultsSize == 1) {
+        res = response.results[0].status;
+        UA_Variant_copy(&response.results[0].value, out);
+    }
+    UA_ReadResponse_clear(&response);
+    return res;
+}
+
+START_TEST(Diagnostics_sessionArrayRange) {
+    UA_Variant v;
+    UA_Variant_init(&v);
+    UA_StatusCode res =
+        readRange(UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY_SESSIONDIAGNOSTICSARRAY,
+                  NULL, &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v.arrayLength, CLIENTS);
+    UA_Variant_clear(&v);
+
+    /* Only the selected elements are returned */
+    res = readRange(UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY_SESSIONDIAGNOSTICSARRAY,
+                    "1:5", &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v.arrayLength, CLIENTS - 1);
+    ck_assert(v.type == &UA_TYPES[UA_TYPES_SESSIONDIAGNOSTICSDATATYPE]);
+    UA_Variant_clear(&v);
+
+    res = readRange(UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY_SESSIONSECURITYDIAGNOSTICSARRAY,
+                    "0", &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v.arrayLength, 1);
+    UA_Variant_clear(&v);
+
+    /* Out of range */
+    res = readRange(UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SESSIONSDIAGNOSTICSSUMMARY_SESSIONDIAGNOSTICSARRAY,
+                    "10", &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADINDEXRANGENODATA);
+    UA_Variant_clear(&v);
+} END_TEST
+
+START_TEST(Diagnostics_subscriptionArray) {
+    /* One subscription per client with a disabled MonitoredItem */
+    for(size_t i = 0; i < CLIENTS; i++) {
+        UA_CreateSubscriptionResponse sub =
+            UA_Client_Subscriptions_create(clients[i], UA_CreateSubscriptionRequest_default(),
+                                           NULL, NULL, NULL);
+        ck_assert_uint_eq(sub.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+        UA_MonitoredItemCreateRequest item =
+            UA_MonitoredItemCreateRequest_default(
+                UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+        item.monitoringMode = UA_MONITORINGMODE_DISABLED;
+        UA_MonitoredItemCreateResult mon =
+            UA_Client_MonitoredItems_createDataChange(clients[i], sub.subscriptionId,
+                                                      UA_TIMESTAMPSTORETURN_BOTH, item,
+                                                      NULL, NULL, NULL);
+        ck_assert_uint_eq(mon.statusCode, UA_STATUSCODE_GOOD);
+    }
+
+    UA_Variant v;
+    UA_Variant_init(&v);
+    UA_StatusCode res =
+        readRange(UA_NS0ID_SERVER_SERVERDIAGNOSTICS_SUBSCRIPTIONDIAGNOSTICSARRAY,
+                  "1:2", &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(v.arrayLength, 2);
+    UA_SubscriptionDiagnosticsDataType *sd = (UA_SubscriptionDiagnosticsDataType*)v.data;
+    for(size_t i = 0; i < v.arrayLength; i++) {
+        ck_assert_uint_eq(sd[i].monitoredItemCount, 1);
+        ck_assert_uint_eq(sd[i].disabledMonitoredItemCount, 1);
+    }
+    UA_Variant_clear(&v);
+} END_TEST
+
+static Suite *testSuite_diagnostics(void) {
+    TCase *tc = tcase_create("Diagnostics");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Diagnostics_sessionArrayRange);
+    tcase_add_test(tc, Diagnostics_subscriptionArray);
+    Suite *s = suite_create("Server Diagnostics");
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_diagnostics();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -9,9 +9,12 @@
 #include <open62541/client_config_default.h>
 #include <open62541/client_highlevel.h>
 #include <open62541/plugin/historydata/history_data_backend.h>
+#include <open62541/plugin/historydata/history_data_backend_file.h>
 #include <open62541/plugin/historydata/history_data_backend_memory.h>
+#include <open62541/plugin/historydata/history_data_backend_memory_compressed.h>
 #include <open62541/plugin/historydata/history_data_gathering_default.h>
 #include <open62541/plugin/historydata/history_database_default.h>
+#include <open62541/plugin/historydata/history_event_backend_memory.h>
 #include <open62541/plugin/historydatabase.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
@@ -22,6 +25,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined(__linux__) || defined(__unix__)
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
 #include "test_helpers.h"
 #include "testing_clock.h"
 #include "thread_wrapper.h"
@@ -30,6 +38,8 @@
 
 static UA_Server *server;
 static UA_HistoryDataGathering *gathering;
+static UA_Boolean asyncGathering;
+static UA_Boolean historicalEvents;
 static UA_Boolean running;
 static THREAD_HANDLE server_thread;
 
@@ -55,7 +65,15 @@ static void setup(void) {
     UA_ServerConfig *config = UA_Server_getConfig(server);
 
     gathering = (UA_HistoryDataGathering*)UA_calloc(1, sizeof(UA_HistoryDataGathering));
-    *gathering = UA_HistoryDataGathering_Default(1);
+    *gathering = (asyncGathering) ?
+        UA_HistoryDataGathering_Async(1, 0, 0) : UA_HistoryDataGathering_Default(1);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    if(historicalEvents)
+        config->historyDatabase =
+            UA_HistoryDatabase_default_events(*gathering,
+                                              UA_HistoryEventBackend_Memory(2000, 0), 0);
+    else
+#endif
     config->historyDatabase = UA_HistoryDatabase_default(*gathering);
 
     UA_StatusCode retval = UA_Server_run_startup(server);
@@ -104,6 +122,22 @@ static void setup(void) {
     }
 }
 
+#if defined(__linux__) || defined(__unix__)
+static void setup_async(void) {
+    asyncGathering = true;
+    setup();
+    asyncGathering = false;
+}
+#endif
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+static void setup_events(void) {
+    historicalEvents = true;
+    setup();
+    historicalEvents = false;
+}
+#endif
+
 static void
 teardown(void) {
     /* cleanup */
@@ -564,6 +598,7 @@ START_TEST(Server_HistorizingUpdateDelete)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -587,6 +622,7 @@ START_TEST(Server_HistorizingUpdateInsert)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -613,10 +649,65 @@ START_TEST(Server_HistorizingUpdateInsert)
 }
 END_TEST
 
+START_TEST(Server_HistorizingUpdateInsertBulk)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // fill backend with insert
+    ck_assert_str_eq(UA_StatusCode_name(updateHistory(UA_PERFORMUPDATETYPE_INSERT, testData, NULL, NULL))
+                                        , UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // merge values between, before and after the existing ones
+    UA_DateTime insertData[] = {
+        TIMESTAMP_5_03,
+        TIMESTAMP_5_03 + UA_DATETIME_SEC / 2,
+        TIMESTAMP_FIRST + 1,
+        TIMESTAMP_5_03 + UA_DATETIME_SEC / 2,
+        TIMESTAMP_LAST - 1,
+        0
+    };
+    UA_StatusCode *results = NULL;
+    size_t resultsSize = 0;
+    ck_assert_str_eq(UA_StatusCode_name(updateHistory(UA_PERFORMUPDATETYPE_INSERT, insertData, &results, &resultsSize))
+                                        , UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert_uint_eq(resultsSize, 5);
+    ck_assert_uint_eq(results[0], UA_STATUSCODE_BADENTRYEXISTS);
+    ck_assert_uint_eq(results[1], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(results[2], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(results[3], UA_STATUSCODE_BADENTRYEXISTS);
+    ck_assert_uint_eq(results[4], UA_STATUSCODE_GOOD);
+    UA_Array_delete(results, resultsSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+
+    // the values are sorted
+    size_t testDataSize = 0;
+    while(testData[testDataSize])
+        ++testDataSize;
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestHistory(TIMESTAMP_FIRST, TIMESTAMP_LAST, &response, 0, false, NULL);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    UA_HistoryData *data = (UA_HistoryData*)response.results[0].historyData.content.decoded.data;
+    ck_assert_uint_eq(data->dataValuesSize, testDataSize + 3);
+    for (size_t i = 1; i < data->dataValuesSize; ++i)
+        ck_assert_int_lt(data->dataValues[i-1].sourceTimestamp, data->dataValues[i].sourceTimestamp);
+    UA_HistoryReadResponse_clear(&response);
+
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
 START_TEST(Server_HistorizingUpdateReplace)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -651,6 +742,7 @@ START_TEST(Server_HistorizingUpdateUpdate)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -699,6 +791,7 @@ END_TEST
 START_TEST(Server_HistorizingStrategyUser) {
     // set a data backend
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = UA_HistoryDataBackend_Memory(3, 100);
     setting.maxHistoryDataResponseSize = 100;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -772,6 +865,7 @@ START_TEST(Server_HistorizingStrategyPoll) {
 
     // set a data backend
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = UA_HistoryDataBackend_Memory(3, 100);
     setting.maxHistoryDataResponseSize = 100;
     setting.pollingInterval = 100;
@@ -843,6 +937,7 @@ START_TEST(Server_HistorizingStrategyValueSet) {
 
     // set a data backend
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = UA_HistoryDataBackend_Memory(3, 100);
     setting.maxHistoryDataResponseSize = 100;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
@@ -890,10 +985,67 @@ START_TEST(Server_HistorizingStrategyValueSet) {
 }
 END_TEST
 
+static void
+setCompressedValue(UA_DateTime t, UA_Double v) {
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, &v, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv.hasValue = true;
+    dv.sourceTimestamp = t;
+    dv.hasSourceTimestamp = true;
+    gathering->setValue(server, gathering->context, NULL, NULL, &outNodeId, true, &dv);
+}
+
+START_TEST(Server_HistorizingCompression) {
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = UA_HistoryDataBackend_Memory(1, 100);
+    setting.maxHistoryDataResponseSize = 100;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
+    setting.compression.exceptionDeviation = 0.3;
+    setting.compression.compressionDeviation = 1.0;
+    UA_StatusCode retval = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(retval), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    /* A noisy ramp up to the knee at 99 and then a noisy constant */
+    UA_DateTime start = UA_DateTime_now();
+    for(size_t i = 0; i < 200; i++) {
+        UA_Double noise = (i % 2) ? 0.2 : -0.2;
+        UA_Double v = (i < 100) ? (UA_Double)i : 99.0;
+        setCompressedValue(start + (UA_DateTime)i * UA_DATETIME_SEC, v + noise);
+    }
+
+    /* The last value is written when the settings are updated */
+    UA_HistoryDataBackend *backend = &setting.historizingBackend;
+    size_t first = backend->firstIndex(server, backend->context, NULL, NULL, &outNodeId);
+    size_t last = backend->lastIndex(server, backend->context, NULL, NULL, &outNodeId);
+    ck_assert_uint_eq(backend->resultSize(server, backend->context, NULL, NULL,
+                                          &outNodeId, first, last), 2);
+    gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, setting);
+    last = backend->lastIndex(server, backend->context, NULL, NULL, &outNodeId);
+    size_t size = backend->resultSize(server, backend->context, NULL, NULL,
+                                      &outNodeId, first, last);
+    ck_assert_uint_eq(size, 3);
+
+    /* The trend is kept: start, knee and end */
+    const UA_DateTime expected[3] = {start, start + 99 * UA_DATETIME_SEC,
+                                     start + 199 * UA_DATETIME_SEC};
+    for(size_t i = 0; i < size; i++) {
+        const UA_DataValue *dv =
+            backend->getDataValue(server, backend->context, NULL, NULL,
+                                  &outNodeId, first + i);
+        ck_assert(dv->sourceTimestamp == expected[i]);
+    }
+
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
 START_TEST(Server_HistorizingBackendMemory)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -925,10 +1077,460 @@ START_TEST(Server_HistorizingBackendMemory)
 }
 END_TEST
 
+START_TEST(Server_HistorizingBackendMemoryManyNodes)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    value.hasValue = true;
+    value.hasSourceTimestamp = true;
+
+    // the node contexts are found after the store and the index grew
+    for(UA_UInt32 i = 0; i < 1000; ++i) {
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(1, i);
+        UA_Variant_setScalar(&value.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        value.sourceTimestamp = i;
+        ck_assert_uint_eq(backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                                       &nodeId, true, &value),
+                          UA_STATUSCODE_GOOD);
+    }
+    for(UA_UInt32 i = 0; i < 1000; ++i) {
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(1, i);
+        ck_assert_uint_eq(backend.getEnd(server, backend.context, NULL, NULL, &nodeId), 1);
+        const UA_DataValue *dv = backend.getDataValue(server, backend.context, NULL, NULL, &nodeId, 0);
+        ck_assert_uint_eq(*(UA_UInt32*)dv->value.data, i);
+    }
+
+    // the cached node context skips the lookup
+    UA_NodeId nodeId = UA_NODEID_NUMERIC(1, 500);
+    void *nodeContext = NULL;
+    for(UA_UInt32 i = 1; i < 3; ++i) {
+        UA_Variant_setScalar(&value.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        value.sourceTimestamp = 1000 + i;
+        ck_assert_uint_eq(backend.serverSetHistoryDataCached(server, backend.context, NULL, NULL,
+                                                             &nodeId, &nodeContext, true, &value),
+                          UA_STATUSCODE_GOOD);
+        ck_assert_ptr_ne(nodeContext, NULL);
+    }
+    ck_assert_uint_eq(backend.getEnd(server, backend.context, NULL, NULL, &nodeId), 3);
+
+    UA_HistoryDataBackend_Memory_clear(&backend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendMemoryCursor)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 1);
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    value.hasValue = true;
+    value.hasSourceTimestamp = true;
+    for(UA_UInt32 i = 1; i <= 10; ++i) {
+        UA_Variant_setScalar(&value.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        value.sourceTimestamp = i;
+        ck_assert_uint_eq(backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                                       &outNodeId, true, &value),
+                          UA_STATUSCODE_GOOD);
+    }
+
+    // read the first page
+    UA_NumericRange range = {0, NULL};
+    UA_ByteString continuationPoint = UA_BYTESTRING_NULL;
+    UA_ByteString outContinuationPoint = UA_BYTESTRING_NULL;
+    UA_DataValue values[4];
+    memset(values, 0, sizeof(values));
+    size_t provided = 0;
+    ck_assert_uint_eq(backend.copyDataValues(server, backend.context, NULL, NULL, &outNodeId,
+                                             0, 9, false, 3, range, false, &continuationPoint,
+                                             &outContinuationPoint, &provided, values),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(provided, 3);
+    ck_assert_int_eq(values[2].sourceTimestamp, 3);
+    ck_assert_uint_gt(outContinuationPoint.length, 0);
+    for(size_t i = 0; i < provided; ++i)
+        UA_DataValue_clear(&values[i]);
+
+    // the cursor finds the next value again after the indices changed
+    UA_UInt32 zero = 0;
+    UA_Variant_setScalar(&value.value, &zero, &UA_TYPES[UA_TYPES_UINT32]);
+    value.sourceTimestamp = 0;
+    ck_assert_uint_eq(backend.insertDataValue(server, backend.context, NULL, NULL,
+                                              &outNodeId, &value),
+                      UA_STATUSCODE_GOOD);
+    continuationPoint = outContinuationPoint;
+    UA_ByteString_init(&outContinuationPoint);
+    ck_assert_uint_eq(backend.copyDataValues(server, backend.context, NULL, NULL, &outNodeId,
+                                             0, 10, false, 3, range, false, &continuationPoint,
+                                             &outContinuationPoint, &provided, values),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(provided, 3);
+    ck_assert_int_eq(values[0].sourceTimestamp, 4);
+    ck_assert_int_eq(values[2].sourceTimestamp, 6);
+    for(size_t i = 0; i < provided; ++i)
+        UA_DataValue_clear(&values[i]);
+    UA_ByteString_clear(&continuationPoint);
+
+    // the last page has no continuation point
+    continuationPoint = outContinuationPoint;
+    UA_ByteString_init(&outContinuationPoint);
+    ck_assert_uint_eq(backend.copyDataValues(server, backend.context, NULL, NULL, &outNodeId,
+                                             0, 10, false, 4, range, false, &continuationPoint,
+                                             &outContinuationPoint, &provided, values),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(provided, 4);
+    ck_assert_int_eq(values[0].sourceTimestamp, 7);
+    ck_assert_int_eq(values[3].sourceTimestamp, 10);
+    ck_assert_uint_eq(outContinuationPoint.length, 0);
+    for(size_t i = 0; i < provided; ++i)
+        UA_DataValue_clear(&values[i]);
+    UA_ByteString_clear(&continuationPoint);
+
+    UA_HistoryDataBackend_Memory_clear(&backend);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendMemoryCompressed)
+{
+    /* Small blocks to read and delete across block boundaries */
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory_Compressed(1, 2);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // empty backend should not crash
+    UA_UInt32 retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests expected failed.\n", retval);
+
+    // fill backend
+    ck_assert_uint_eq(fillHistoricalDataBackend(backend), true);
+
+    // read all in one
+    retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous one at one request
+    retval = testHistoricalDataBackend(1);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous two at one request
+    retval = testHistoricalDataBackend(2);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // delete some values
+    ck_assert_str_eq(UA_StatusCode_name(deleteHistory(DELETE_START_TIME, DELETE_STOP_TIME)),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    testResult(testDataAfterDelete, NULL);
+
+    // update all and insert some
+    UA_StatusCode *result = NULL;
+    size_t resultSize = 0;
+    ck_assert_uint_eq(updateHistory(UA_PERFORMUPDATETYPE_UPDATE, testDataSorted, &result, &resultSize),
+                      UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < resultSize; ++i) {
+        ck_assert_str_eq(UA_StatusCode_name(result[i]), UA_StatusCode_name(testDataUpdateResult[i]));
+    }
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+
+    UA_HistoryData data;
+    UA_HistoryData_init(&data);
+    testResult(testDataSorted, &data);
+    for(size_t i = 0; i < data.dataValuesSize; ++i) {
+        ck_assert_uint_eq(data.dataValues[i].hasValue, true);
+        ck_assert(data.dataValues[i].value.type == &UA_TYPES[UA_TYPES_INT64]);
+        ck_assert_int_eq(*((UA_Int64*)data.dataValues[i].value.data), UA_PERFORMUPDATETYPE_UPDATE);
+    }
+    UA_HistoryData_clear(&data);
+
+    // non-numeric values are rejected
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    UA_String s = UA_STRING("text");
+    UA_Variant_setScalar(&value.value, &s, &UA_TYPES[UA_TYPES_STRING]);
+    value.hasValue = true;
+    ck_assert_uint_eq(backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                                   &outNodeId, false, &value),
+                      UA_STATUSCODE_BADTYPEMISMATCH);
+
+    UA_HistoryDataBackend_Memory_Compressed_clear(&setting.historizingBackend);
+}
+END_TEST
+
+#if defined(__linux__) || defined(__unix__)
+
+static void
+removeDirectory(const char *path) {
+    DIR *dir = opendir(path);
+    ck_assert_ptr_ne(dir, NULL);
+    struct dirent *entry;
+    char file[512];
+    while((entry = readdir(dir))) {
+        if(strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+        unlink(file);
+    }
+    closedir(dir);
+    ck_assert_int_eq(rmdir(path), 0);
+}
+
+START_TEST(Server_HistorizingBackendFile)
+{
+    char directory[] = "/tmp/ua_history_XXXXXX";
+    ck_assert_ptr_ne(mkdtemp(directory), NULL);
+
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_File(directory, 0);
+    ck_assert_ptr_ne(backend.context, NULL);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // empty backend should not crash
+    UA_UInt32 retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests expected failed.\n", retval);
+
+    // fill backend (the test data is not sorted)
+    ck_assert_uint_eq(fillHistoricalDataBackend(backend), true);
+
+    // read all in one
+    retval = testHistoricalDataBackend(100);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // read continuous one at one request
+    retval = testHistoricalDataBackend(1);
+    fprintf(stderr, "%x tests failed.\n", retval);
+    ck_assert_uint_eq(retval, 0);
+
+    // delete some values
+    ck_assert_str_eq(UA_StatusCode_name(deleteHistory(DELETE_START_TIME, DELETE_STOP_TIME)),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    testResult(testDataAfterDelete, NULL);
+
+    // update all and insert some
+    UA_StatusCode *result = NULL;
+    size_t resultSize = 0;
+    ck_assert_uint_eq(updateHistory(UA_PERFORMUPDATETYPE_UPDATE, testDataSorted, &result, &resultSize),
+                      UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < resultSize; ++i) {
+        ck_assert_str_eq(UA_StatusCode_name(result[i]), UA_StatusCode_name(testDataUpdateResult[i]));
+    }
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    ck_assert_uint_eq(UA_HistoryDataBackend_File_flush(&backend), UA_STATUSCODE_GOOD);
+
+    // the history is read back from the files
+    UA_HistoryDataBackend_File_clear(&backend);
+    backend = UA_HistoryDataBackend_File(directory, 0);
+    ck_assert_ptr_ne(backend.context, NULL);
+    setting.historizingBackend = backend;
+    gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, setting);
+
+    UA_HistoryData data;
+    UA_HistoryData_init(&data);
+    testResult(testDataSorted, &data);
+    for(size_t i = 0; i < data.dataValuesSize; ++i) {
+        ck_assert_uint_eq(data.dataValues[i].hasValue, true);
+        ck_assert(data.dataValues[i].value.type == &UA_TYPES[UA_TYPES_INT64]);
+        ck_assert_int_eq(*((UA_Int64*)data.dataValues[i].value.data), UA_PERFORMUPDATETYPE_UPDATE);
+    }
+    UA_HistoryData_clear(&data);
+
+    UA_HistoryDataBackend_File_clear(&backend);
+    removeDirectory(directory);
+}
+END_TEST
+
+START_TEST(Server_HistorizingGatheringAsync) {
+    char directory[] = "/tmp/ua_history_XXXXXX";
+    ck_assert_ptr_ne(mkdtemp(directory), NULL);
+
+    // the file backend supports batches
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = UA_HistoryDataBackend_File(directory, 0);
+    ck_assert_ptr_ne(setting.historizingBackend.context, NULL);
+    setting.maxHistoryDataResponseSize = 100;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
+    UA_StatusCode retval = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(retval), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // fill the data
+    UA_fakeSleep(100);
+    UA_EventLoop *el = UA_Client_getConfig(client)->eventLoop;
+    UA_DateTime start = el->dateTime_now(el);
+    UA_fakeSleep(100);
+    for(UA_UInt32 i = 0; i < 10; ++i) {
+        retval = setUInt32(client, outNodeId, i);
+        ck_assert_str_eq(UA_StatusCode_name(retval), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+        UA_fakeSleep(100);
+    }
+    UA_DateTime end = el->dateTime_now(el);
+    ck_assert_uint_eq(UA_HistoryDataGathering_Async_flush(gathering), UA_STATUSCODE_GOOD);
+
+    UA_HistoryDataGatheringStatistics stats;
+    ck_assert_uint_eq(UA_HistoryDataGathering_Async_getStatistics(gathering, &stats),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(stats.queued, 0);
+    ck_assert_uint_eq(stats.dropped, 0);
+    ck_assert_uint_eq(stats.written, 10);
+    ck_assert_uint_eq(stats.failed, 0);
+    ck_assert_uint_ge(stats.batches, 1);
+    ck_assert_uint_ge(stats.maxBacklog, 1);
+
+    // request
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestHistory(start, end, &response, 0, false, NULL);
+    ck_assert_str_eq(UA_StatusCode_name(response.responseHeader.serviceResult), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_str_eq(UA_StatusCode_name(response.results[0].statusCode), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    ck_assert(response.results[0].historyData.content.decoded.type == &UA_TYPES[UA_TYPES_HISTORYDATA]);
+    UA_HistoryData *data = (UA_HistoryData *)response.results[0].historyData.content.decoded.data;
+    ck_assert_uint_eq(data->dataValuesSize, 10);
+    for(size_t j = 0; j < data->dataValuesSize; ++j) {
+        ck_assert(data->dataValues[j].value.type == &UA_TYPES[UA_TYPES_UINT32]);
+        ck_assert_uint_eq(*(UA_UInt32 *)data->dataValues[j].value.data, j);
+    }
+    UA_HistoryReadResponse_clear(&response);
+
+    UA_HistoryDataBackend_File_clear(&setting.historizingBackend);
+    removeDirectory(directory);
+}
+END_TEST
+
+START_TEST(Server_HistorizingBackendMemoryTiered)
+{
+    char path[] = "/tmp/open62541_history_tiered_XXXXXX";
+    int fd = mkstemp(path);
+    ck_assert_int_ge(fd, 0);
+    close(fd);
+
+    /* Small blocks and almost no memory. Nearly every access reads from the
+     * file. */
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory_Tiered(path, 1, 2, 16);
+    ck_assert_ptr_ne(backend.context, NULL);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    ck_assert_uint_eq(fillHistoricalDataBackend(backend), true);
+    UA_UInt32 retval = testHistoricalDataBackend(100);
+    ck_assert_uint_eq(retval, 0);
+    retval = testHistoricalDataBackend(1);
+    ck_assert_uint_eq(retval, 0);
+
+    UA_HistoryDataBackend_TieredStatistics stats;
+    ret = UA_HistoryDataBackend_Memory_Tiered_getStatistics(&backend, &stats);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(stats.evictions, 0);
+    ck_assert_uint_gt(stats.misses, 0);
+    ck_assert_uint_gt(stats.fileBytes, 0);
+    size_t misses = stats.misses;
+
+    /* Evicted blocks are rewritten by the updates */
+    ck_assert_str_eq(UA_StatusCode_name(deleteHistory(DELETE_START_TIME, DELETE_STOP_TIME)),
+                     UA_StatusCode_name(UA_STATUSCODE_GOOD));
+    testResult(testDataAfterDelete, NULL);
+    UA_StatusCode *result = NULL;
+    size_t resultSize = 0;
+    ck_assert_uint_eq(updateHistory(UA_PERFORMUPDATETYPE_UPDATE, testDataSorted, &result, &resultSize),
+                      UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < resultSize; ++i)
+        ck_assert_str_eq(UA_StatusCode_name(result[i]), UA_StatusCode_name(testDataUpdateResult[i]));
+    UA_Array_delete(result, resultSize, &UA_TYPES[UA_TYPES_STATUSCODE]);
+    testResult(testDataSorted, NULL);
+
+    ret = UA_HistoryDataBackend_Memory_Tiered_getStatistics(&backend, &stats);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_gt(stats.misses, misses);
+
+    UA_HistoryDataBackend_Memory_Compressed_clear(&setting.historizingBackend);
+    ck_assert_int_ne(access(path, F_OK), 0);
+}
+END_TEST
+
+#endif
+
+START_TEST(Server_HistorizingBackendMemoryCompressedSize)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory_Compressed(1, 0);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 1000;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    /* A slowly changing double sampled once per second */
+    const size_t count = 10000;
+    const UA_DateTime begin = 1000 * UA_DATETIME_SEC;
+    for(size_t i = 0; i < count; i++) {
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        UA_Double d = 20.0 + (UA_Double)(i % 16) * 0.25;
+        UA_Variant_setScalar(&value.value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+        value.hasValue = true;
+        value.sourceTimestamp = begin + (UA_DateTime)i * UA_DATETIME_SEC;
+        value.hasSourceTimestamp = true;
+        value.serverTimestamp = value.sourceTimestamp;
+        value.hasServerTimestamp = true;
+        ret = backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                           &outNodeId, false, &value);
+        ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    }
+
+    size_t samples = 0, bytes = 0;
+    ret = UA_HistoryDataBackend_Memory_Compressed_getUsage(&backend, &outNodeId,
+                                                           &samples, &bytes);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(samples, count);
+    fprintf(stderr, "%lu samples in %lu bytes\n",
+            (unsigned long)samples, (unsigned long)bytes);
+    ck_assert_uint_lt(bytes * 10, count * sizeof(UA_DataValue));
+
+    /* Read a range from the middle */
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestHistory(begin + 5000 * UA_DATETIME_SEC, begin + 5100 * UA_DATETIME_SEC,
+                   &response, 0, false, NULL);
+    ck_assert_uint_eq(response.resultsSize, 1);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    UA_HistoryData *data = (UA_HistoryData*)
+        response.results[0].historyData.content.decoded.data;
+    ck_assert_uint_eq(data->dataValuesSize, 100);
+    for(size_t i = 0; i < data->dataValuesSize; i++) {
+        size_t j = 5000 + i;
+        UA_DataValue *dv = &data->dataValues[i];
+        ck_assert_int_eq(dv->sourceTimestamp, begin + (UA_DateTime)j * UA_DATETIME_SEC);
+        ck_assert(dv->value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+        ck_assert(*(UA_Double*)dv->value.data == 20.0 + (UA_Double)(j % 16) * 0.25);
+    }
+    UA_HistoryReadResponse_clear(&response);
+
+    UA_HistoryDataBackend_Memory_Compressed_clear(&setting.historizingBackend);
+}
+END_TEST
+
 START_TEST(Server_HistorizingRandomIndexBackend)
 {
     UA_HistoryDataBackend backend = UA_HistoryDataBackend_randomindextest(testData);
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = backend;
     setting.maxHistoryDataResponseSize = 1000;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
@@ -953,6 +1555,406 @@ START_TEST(Server_HistorizingRandomIndexBackend)
 }
 END_TEST
 
+static void
+requestProcessed(UA_DateTime start, UA_DateTime end, UA_Double processingInterval,
+                 UA_UInt32 aggregate, UA_HistoryReadResponse *response,
+                 UA_ByteString *continuationPoint) {
+    UA_ReadProcessedDetails *details = UA_ReadProcessedDetails_new();
+    details->startTime = start;
+    details->endTime = end;
+    details->processingInterval = processingInterval;
+    details->aggregateType = UA_NodeId_new();
+    *details->aggregateType = UA_NODEID_NUMERIC(0, aggregate);
+    details->aggregateTypeSize = 1;
+    details->aggregateConfiguration.useServerCapabilitiesDefaults = true;
+
+    UA_HistoryReadValueId *valueId = UA_HistoryReadValueId_new();
+    UA_NodeId_copy(&outNodeId, &valueId->nodeId);
+    if (continuationPoint)
+        UA_ByteString_copy(continuationPoint, &valueId->continuationPoint);
+
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    request.historyReadDetails.encoding = UA_EXTENSIONOBJECT_DECODED;
+    request.historyReadDetails.content.decoded.type = &UA_TYPES[UA_TYPES_READPROCESSEDDETAILS];
+    request.historyReadDetails.content.decoded.data = details;
+
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+
+    request.nodesToReadSize = 1;
+    request.nodesToRead = valueId;
+
+    UA_LOCK(&server->serviceMutex);
+    Service_HistoryRead(server, &server->adminSession, &request, response);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_HistoryReadRequest_clear(&request);
+}
+
+static UA_HistoryData *
+processedResult(UA_HistoryReadResponse *response) {
+    ck_assert_uint_eq(response->responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response->resultsSize, 1);
+    ck_assert_uint_eq(response->results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert(response->results[0].historyData.content.decoded.type ==
+              &UA_TYPES[UA_TYPES_HISTORYDATA]);
+    return (UA_HistoryData*)response->results[0].historyData.content.decoded.data;
+}
+
+static UA_Double
+processedValue(const UA_DataValue *value) {
+    ck_assert(value->hasValue);
+    ck_assert(value->value.type == &UA_TYPES[UA_TYPES_DOUBLE]);
+    return *(UA_Double*)value->value.data;
+}
+
+START_TEST(Server_HistorizingReadProcessed)
+{
+    UA_HistoryDataBackend backend = UA_HistoryDataBackend_Memory(1, 100);
+    UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
+    setting.historizingBackend = backend;
+    setting.maxHistoryDataResponseSize = 100;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_USER;
+    UA_StatusCode ret = gathering->registerNodeId(server, gathering->context, &outNodeId, setting);
+    ck_assert_str_eq(UA_StatusCode_name(ret), UA_StatusCode_name(UA_STATUSCODE_GOOD));
+
+    // one value per second rising by one
+    UA_DateTime start = 1000 * UA_DATETIME_SEC;
+    UA_DateTime end = start + 100 * UA_DATETIME_SEC;
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    value.hasValue = true;
+    value.hasSourceTimestamp = true;
+    for (UA_UInt32 i = 0; i < 100; ++i) {
+        UA_Variant_setScalar(&value.value, &i, &UA_TYPES[UA_TYPES_UINT32]);
+        value.sourceTimestamp = start + i * UA_DATETIME_SEC;
+        ret = backend.serverSetHistoryData(server, backend.context, NULL, NULL,
+                                           &outNodeId, true, &value);
+        ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    }
+
+    const UA_UInt32 aggregates[] = {
+        UA_NS0ID_AGGREGATEFUNCTION_AVERAGE, UA_NS0ID_AGGREGATEFUNCTION_MINIMUM,
+        UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM, UA_NS0ID_AGGREGATEFUNCTION_INTERPOLATIVE,
+        UA_NS0ID_AGGREGATEFUNCTION_TIMEAVERAGE};
+    const UA_Double offsets[] = {4.5, 0.0, 9.0, 0.0, 5.0};
+    for (size_t a = 0; a < 5; ++a) {
+        UA_HistoryReadResponse response;
+        UA_HistoryReadResponse_init(&response);
+        requestProcessed(start, end, 10000.0, aggregates[a], &response, NULL);
+        UA_HistoryData *data = processedResult(&response);
+        ck_assert_uint_eq(data->dataValuesSize, 10);
+        ck_assert_uint_eq(response.results[0].continuationPoint.length, 0);
+        for (size_t k = 0; k < 9; ++k) {
+            const UA_DataValue *dv = &data->dataValues[k];
+            ck_assert_uint_eq(dv->status, UA_STATUSCODE_GOOD);
+            ck_assert(processedValue(dv) == 10.0 * (UA_Double)k + offsets[a]);
+        }
+        if (aggregates[a] == UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM)
+            ck_assert_int_eq(data->dataValues[0].sourceTimestamp, start + 9 * UA_DATETIME_SEC);
+        else
+            ck_assert_int_eq(data->dataValues[1].sourceTimestamp, start + 10 * UA_DATETIME_SEC);
+        // no value after the last interval
+        if (aggregates[a] == UA_NS0ID_AGGREGATEFUNCTION_TIMEAVERAGE)
+            ck_assert_uint_eq(data->dataValues[9].status, UA_STATUSCODE_UNCERTAINDATASUBNORMAL);
+        UA_HistoryReadResponse_clear(&response);
+    }
+
+    // count the values and read them continuous four at one request
+    UA_HistorizingNodeIdSettings newSetting = setting;
+    newSetting.maxHistoryDataResponseSize = 4;
+    gathering->updateNodeIdSetting(server, gathering->context, &outNodeId, newSetting);
+    UA_ByteString continuous;
+    UA_ByteString_init(&continuous);
+    size_t intervals = 0;
+    do {
+        UA_HistoryReadResponse response;
+        UA_HistoryReadResponse_init(&response);
+        requestProcessed(start, end, 10000.0, UA_NS0ID_AGGREGATEFUNCTION_COUNT,
+                         &response, &continuous);
+        UA_HistoryData *data = processedResult(&response);
+        ck_assert_uint_le(data->dataValuesSize, 4);
+        for (size_t k = 0; k < data->dataValuesSize; ++k) {
+            ck_assert(data->dataValues[k].value.type == &UA_TYPES[UA_TYPES_INT32]);
+            ck_assert_int_eq(*(UA_Int32*)data->dataValues[k].value.data, 10);
+            ck_assert_int_eq(data->dataValues[k].sourceTimestamp,
+                             start + (UA_DateTime)(intervals + k) * 10 * UA_DATETIME_SEC);
+        }
+        intervals += data->dataValuesSize;
+        UA_ByteString_clear(&continuous);
+        UA_ByteString_copy(&response.results[0].continuationPoint, &continuous);
+        UA_HistoryReadResponse_clear(&response);
+    } while (continuous.length > 0);
+    ck_assert_uint_eq(intervals, 10);
+
+    // the interval before the first value has no data
+    UA_HistoryReadResponse response;
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(start - 10 * UA_DATETIME_SEC, start, 0.0,
+                     UA_NS0ID_AGGREGATEFUNCTION_AVERAGE, &response, NULL);
+    UA_HistoryData *data = processedResult(&response);
+    ck_assert_uint_eq(data->dataValuesSize, 1);
+    ck_assert_uint_eq(data->dataValues[0].status, UA_STATUSCODE_BADNODATA);
+    UA_HistoryReadResponse_clear(&response);
+
+    // unsupported aggregate
+    UA_HistoryReadResponse_init(&response);
+    requestProcessed(start, end, 0.0, UA_NS0ID_AGGREGATEFUNCTION_RANGE, &response, NULL);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_BADAGGREGATENOTSUPPORTED);
+    UA_HistoryReadResponse_clear(&response);
+
+    UA_HistoryDataBackend_Memory_clear(&setting.historizingBackend);
+}
+END_TEST
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+static UA_NodeId eventEmitterId;
+static UA_NodeId eventSourceIds[2];
+static UA_NodeId eventTypeIds[2]; /* The second is a subtype of the first */
+
+static void
+addEventNodes(void) {
+    UA_ObjectTypeAttributes ta = UA_ObjectTypeAttributes_default;
+    ta.displayName = UA_LOCALIZEDTEXT("en-US", "TestEventType");
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NULL,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "TestEventType"),
+                                    ta, NULL, &eventTypeIds[0]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ta.displayName = UA_LOCALIZEDTEXT("en-US", "TestSubEventType");
+    retval = UA_Server_addObjectTypeNode(server, UA_NODEID_NULL, eventTypeIds[0],
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(1, "TestSubEventType"),
+                                         ta, NULL, &eventTypeIds[1]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The emitter stores the events of its two sources */
+    UA_ObjectAttributes oa = UA_ObjectAttributes_default;
+    oa.eventNotifier = UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT | UA_EVENTNOTIFIER_HISTORY_READ;
+    oa.displayName = UA_LOCALIZEDTEXT("en-US", "Emitter");
+    retval = UA_Server_addObjectNode(server, UA_NODEID_NULL, parentNodeId,
+                                     parentReferenceNodeId, UA_QUALIFIEDNAME(1, "Emitter"),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                     oa, NULL, &eventEmitterId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    for(size_t i = 0; i < 2; i++) {
+        oa = UA_ObjectAttributes_default;
+        oa.displayName = UA_LOCALIZEDTEXT("en-US", "Source");
+        retval = UA_Server_addObjectNode(server, UA_NODEID_NULL, eventEmitterId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                         UA_QUALIFIEDNAME(1, "Source"),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                         oa, NULL, &eventSourceIds[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    /* Store the Time, EventType, SourceNode and Severity */
+    static const char *names[4] = {"Time", "EventType", "SourceNode", "Severity"};
+    UA_SimpleAttributeOperand sao[4];
+    UA_QualifiedName paths[4];
+    for(size_t i = 0; i < 4; i++) {
+        UA_SimpleAttributeOperand_init(&sao[i]);
+        sao[i].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+        sao[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        paths[i] = UA_QUALIFIEDNAME(0, (char*)(uintptr_t)names[i]);
+        sao[i].browsePathSize = 1;
+        sao[i].browsePath = &paths[i];
+    }
+    UA_EventFilter hef;
+    UA_EventFilter_init(&hef);
+    hef.selectClausesSize = 4;
+    hef.selectClauses = sao;
+    UA_VariableAttributes va = UA_VariableAttributes_default;
+    va.displayName = UA_LOCALIZEDTEXT("en-US", "HistoricalEventFilter");
+    va.dataType = UA_TYPES[UA_TYPES_EVENTFILTER].typeId;
+    UA_Variant_setScalar(&va.value, &hef, &UA_TYPES[UA_TYPES_EVENTFILTER]);
+    retval = UA_Server_addVariableNode(server, UA_NODEID_NULL, eventEmitterId,
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                       UA_QUALIFIEDNAME(0, "HistoricalEventFilter"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                       va, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+/* Event i has the Severity i. The events alternate between the sources. Every
+ * third event has the subtype. */
+static UA_DateTime
+triggerHistoricalEvents(size_t count) {
+    UA_DateTime start = UA_DateTime_fromUnixTime(1700000000);
+    for(size_t i = 0; i < count; i++) {
+        UA_DateTime time = start + (UA_DateTime)i * UA_DATETIME_SEC;
+        UA_UInt16 severity = (UA_UInt16)i;
+        UA_KeyValuePair fields[2];
+        fields[0].key = UA_QUALIFIEDNAME(0, "Time");
+        UA_Variant_setScalar(&fields[0].value, &time, &UA_TYPES[UA_TYPES_DATETIME]);
+        fields[1].key = UA_QUALIFIEDNAME(0, "Severity");
+        UA_Variant_setScalar(&fields[1].value, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+        UA_KeyValueMap map = {2, fields};
+        UA_StatusCode retval =
+            UA_Server_triggerEventFields(server, eventTypeIds[(i % 3 == 0) ? 1 : 0],
+                                         eventSourceIds[i % 2], &map, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    return start;
+}
+
+typedef struct {
+    size_t responses;
+    size_t eventsSize;
+    UA_UInt16 severities[64];
+} UA_ReadEventsResult;
+
+static UA_Boolean
+readEventsCallback(UA_Client *clt, const UA_NodeId *nodeId,
+                   UA_Boolean moreDataAvailable,
+                   const UA_ExtensionObject *data, void *callbackContext) {
+    UA_ReadEventsResult *res = (UA_ReadEventsResult*)callbackContext;
+    ck_assert(data->content.decoded.type == &UA_TYPES[UA_TYPES_HISTORYEVENT]);
+    UA_HistoryEvent *he = (UA_HistoryEvent*)data->content.decoded.data;
+    res->responses++;
+    for(size_t i = 0; i < he->eventsSize; i++) {
+        ck_assert_uint_eq(he->events[i].eventFieldsSize, 1);
+        ck_assert(UA_Variant_hasScalarType(&he->events[i].eventFields[0],
+                                           &UA_TYPES[UA_TYPES_UINT16]));
+        ck_assert_uint_lt(res->eventsSize, 64);
+        res->severities[res->eventsSize++] =
+            *(UA_UInt16*)he->events[i].eventFields[0].data;
+    }
+    return true;
+}
+
+static UA_StatusCode
+readEvents(UA_DateTime startTime, UA_DateTime endTime,
+           size_t whereSize, UA_ContentFilterElement *where,
+           UA_UInt32 numValuesPerNode, UA_ReadEventsResult *res) {
+    memset(res, 0, sizeof(UA_ReadEventsResult));
+    UA_QualifiedName severity = UA_QUALIFIEDNAME(0, "Severity");
+    UA_SimpleAttributeOperand sao;
+    UA_SimpleAttributeOperand_init(&sao);
+    sao.typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    sao.attributeId = UA_ATTRIBUTEID_VALUE;
+    sao.browsePathSize = 1;
+    sao.browsePath = &severity;
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClausesSize = 1;
+    filter.selectClauses = &sao;
+    filter.whereClause.elementsSize = whereSize;
+    filter.whereClause.elements = where;
+    return UA_Client_HistoryRead_events(client, &eventEmitterId, readEventsCallback,
+                                        startTime, endTime, UA_STRING_NULL, filter,
+                                        numValuesPerNode,
+                                        UA_TIMESTAMPSTORETURN_SOURCE, res);
+}
+
+START_TEST(Server_HistorizingReadEvents)
+{
+    addEventNodes();
+    UA_DateTime start = triggerHistoricalEvents(10);
+    UA_DateTime end = start + 10 * UA_DATETIME_SEC;
+
+    /* All events in order */
+    UA_ReadEventsResult res;
+    UA_StatusCode retval = readEvents(start, end, 0, NULL, 0, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 10);
+    for(size_t i = 0; i < 10; i++)
+        ck_assert_uint_eq(res.severities[i], i);
+
+    /* The endTime is excluded */
+    retval = readEvents(start + UA_DATETIME_SEC, start + 4 * UA_DATETIME_SEC,
+                        0, NULL, 0, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 3);
+    ck_assert_uint_eq(res.severities[0], 1);
+    ck_assert_uint_eq(res.severities[2], 3);
+
+    /* Pages of three events across the partitions */
+    retval = readEvents(start, end, 0, NULL, 3, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.responses, 4);
+    ck_assert_uint_eq(res.eventsSize, 10);
+    for(size_t i = 0; i < 10; i++)
+        ck_assert_uint_eq(res.severities[i], i);
+
+    /* Reverse order if the startTime is after the endTime. The endTime is
+     * still excluded. */
+    retval = readEvents(end, start - 1, 0, NULL, 4, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 10);
+    for(size_t i = 0; i < 10; i++)
+        ck_assert_uint_eq(res.severities[i], 9 - i);
+
+    /* OfType includes the subtypes */
+    UA_LiteralOperand lit;
+    UA_LiteralOperand_init(&lit);
+    UA_Variant_setScalar(&lit.value, &eventTypeIds[1], &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ContentFilterElement where[3];
+    UA_ContentFilterElement_init(&where[0]);
+    where[0].filterOperator = UA_FILTEROPERATOR_OFTYPE;
+    where[0].filterOperandsSize = 1;
+    where[0].filterOperands = UA_ExtensionObject_new();
+    UA_ExtensionObject_setValue(where[0].filterOperands, &lit,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    retval = readEvents(start, end, 1, where, 0, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 4);
+    for(size_t i = 0; i < 4; i++)
+        ck_assert_uint_eq(res.severities[i], i * 3);
+    UA_Variant_setScalar(&lit.value, &eventTypeIds[0], &UA_TYPES[UA_TYPES_NODEID]);
+    retval = readEvents(start, end, 1, where, 0, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 10);
+
+    /* The subtype from the second source */
+    UA_Variant_setScalar(&lit.value, &eventTypeIds[1], &UA_TYPES[UA_TYPES_NODEID]);
+    UA_QualifiedName sourceNode = UA_QUALIFIEDNAME(0, "SourceNode");
+    UA_SimpleAttributeOperand sao;
+    UA_SimpleAttributeOperand_init(&sao);
+    sao.typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+    sao.attributeId = UA_ATTRIBUTEID_VALUE;
+    sao.browsePathSize = 1;
+    sao.browsePath = &sourceNode;
+    UA_LiteralOperand source;
+    UA_LiteralOperand_init(&source);
+    UA_Variant_setScalar(&source.value, &eventSourceIds[1], &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject equalsOps[2];
+    UA_ExtensionObject_setValue(&equalsOps[0], &sao,
+                                &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_ExtensionObject_setValue(&equalsOps[1], &source,
+                                &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ElementOperand elm[2];
+    elm[0].index = 1;
+    elm[1].index = 2;
+    UA_ExtensionObject andOps[2];
+    UA_ExtensionObject_setValue(&andOps[0], &elm[0], &UA_TYPES[UA_TYPES_ELEMENTOPERAND]);
+    UA_ExtensionObject_setValue(&andOps[1], &elm[1], &UA_TYPES[UA_TYPES_ELEMENTOPERAND]);
+    UA_ContentFilterElement_init(&where[1]);
+    where[1] = where[0];
+    where[2].filterOperator = UA_FILTEROPERATOR_EQUALS;
+    where[2].filterOperandsSize = 2;
+    where[2].filterOperands = equalsOps;
+    where[0].filterOperator = UA_FILTEROPERATOR_AND;
+    where[0].filterOperandsSize = 2;
+    where[0].filterOperands = andOps;
+    retval = readEvents(start, end, 3, where, 0, &res);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(res.eventsSize, 2);
+    ck_assert_uint_eq(res.severities[0], 3);
+    ck_assert_uint_eq(res.severities[1], 9);
+    UA_free(where[1].filterOperands);
+
+    UA_NodeId_clear(&eventEmitterId);
+    UA_NodeId_clear(&eventSourceIds[0]);
+    UA_NodeId_clear(&eventSourceIds[1]);
+    UA_NodeId_clear(&eventTypeIds[0]);
+    UA_NodeId_clear(&eventTypeIds[1]);
+}
+END_TEST
+#endif
+
 static Suite *
 testSuite_Client(void) {
     Suite *s = suite_create("Server Historical Data");
@@ -961,14 +1963,39 @@ testSuite_Client(void) {
     tcase_add_test(tc_server, Server_HistorizingStrategyPoll);
     tcase_add_test(tc_server, Server_HistorizingStrategyUser);
     tcase_add_test(tc_server, Server_HistorizingStrategyValueSet);
+    tcase_add_test(tc_server, Server_HistorizingCompression);
     tcase_add_test(tc_server, Server_HistorizingBackendMemory);
+    tcase_add_test(tc_server, Server_HistorizingBackendMemoryManyNodes);
+    tcase_add_test(tc_server, Server_HistorizingBackendMemoryCursor);
+    tcase_add_test(tc_server, Server_HistorizingBackendMemoryCompressed);
+    tcase_add_test(tc_server, Server_HistorizingBackendMemoryCompressedSize);
+#if defined(__linux__) || defined(__unix__)
+    tcase_add_test(tc_server, Server_HistorizingBackendFile);
+    tcase_add_test(tc_server, Server_HistorizingBackendMemoryTiered);
+#endif
     tcase_add_test(tc_server, Server_HistorizingRandomIndexBackend);
+    tcase_add_test(tc_server, Server_HistorizingReadProcessed);
     tcase_add_test(tc_server, Server_HistorizingUpdateDelete);
     tcase_add_test(tc_server, Server_HistorizingUpdateInsert);
+    tcase_add_test(tc_server, Server_HistorizingUpdateInsertBulk);
     tcase_add_test(tc_server, Server_HistorizingUpdateReplace);
     tcase_add_test(tc_server, Server_HistorizingUpdateUpdate);
     suite_add_tcase(s, tc_server);
 
+#if defined(__linux__) || defined(__unix__)
+    TCase *tc_async = tcase_create("Server Historical Data Async Gathering");
+    tcase_add_checked_fixture(tc_async, setup_async, teardown);
+    tcase_add_test(tc_async, Server_HistorizingGatheringAsync);
+    suite_add_tcase(s, tc_async);
+#endif
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    TCase *tc_events = tcase_create("Server Historical Events");
+    tcase_add_checked_fixture(tc_events, setup_events, teardown);
+    tcase_add_test(tc_events, Server_HistorizingReadEvents);
+    suite_add_tcase(s, tc_events);
+#endif
+
     return s;
 }
 
@@ -167,6 +167,7 @@ START_TEST(Server_HistorizingStrategyValueSet) {
 
     // set a data backend
     UA_HistorizingNodeIdSettings setting;
+    memset(&setting, 0, sizeof(UA_HistorizingNodeIdSettings));
     setting.historizingBackend = UA_HistoryDataBackend_Memory_Circular(3, 10);
     setting.maxHistoryDataResponseSize = 10;
     setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
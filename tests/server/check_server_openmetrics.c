@@ -0,0 +1,146 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/metrics_openmetrics.h>
+
+#include "test_helpers.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <check.h>
+
+static UA_Server *server;
+static UA_OpenMetricsExporter *exporter;
+
+/* HTTP client on the TCP ConnectionManager of the server */
+static const char *request;
+static char response[1 << 17];
+static size_t responseLength;
+static UA_Boolean closed;
+
+static void
+clientCallback(UA_ConnectionManager *cm, uintptr_t connectionId,
+               void *application, void **connectionContext,
+               UA_ConnectionState state, const UA_KeyValueMap *params,
+               UA_ByteString msg) {
+    if(state == UA_CONNECTIONSTATE_CLOSING) {
+        closed = true;
+        return;
+    }
+    if(state != UA_CONNECTIONSTATE_ESTABLISHED)
+        return;
+
+    /* Connected. Send the request. */
+    if(msg.length == 0) {
+        UA_ByteString buf;
+        size_t len = strlen(request);
+        UA_StatusCode res = cm->allocNetworkBuffer(cm, connectionId, &buf, len);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        memcpy(buf.data, request, len);
+        res = cm->sendWithConnection(cm, connectionId, &UA_KEYVALUEMAP_NULL, &buf);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        return;
+    }
+
+    ck_assert(responseLength + msg.length < sizeof(response));
+    memcpy(&response[responseLength], msg.data, msg.length);
+    responseLength += msg.length;
+    response[responseLength] = 0;
+}
+
+static void
+scrape(const char *req) {
+    request = req;
+    responseLength = 0;
+    response[0] = 0;
+    closed = false;
+
+    UA_EventLoop *el = UA_Server_getConfig(server)->eventLoop;
+    UA_ConnectionManager *cm = NULL;
+    UA_String tcpString = UA_STRING("tcp");
+    for(UA_EventSource *es = el->eventSources; es != NULL; es = es->next) {
+        if(es->eventSourceType == UA_EVENTSOURCETYPE_CONNECTIONMANAGER &&
+           UA_String_equal(&tcpString, &((UA_ConnectionManager*)es)->protocol))
+            cm = (UA_ConnectionManager*)es;
+    }
+    ck_assert_ptr_ne(cm, NULL);
+
+    UA_UInt16 port = 9464;
+    UA_String host = UA_STRING("localhost");
+    UA_KeyValuePair params[2];
+    params[0].key = UA_QUALIFIEDNAME(0, "port");
+    UA_Variant_setScalar(&params[0].value, &port, &UA_TYPES[UA_TYPES_UINT16]);
+    params[1].key = UA_QUALIFIEDNAME(0, "address");
+    UA_Variant_setScalar(&params[1].value, &host, &UA_TYPES[UA_TYPES_STRING]);
+    UA_KeyValueMap paramsMap = {2, params};
+    UA_StatusCode res =
+        cm->openConnection(cm, &paramsMap, NULL, NULL, clientCallback);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 1000 && !closed; i++)
+        UA_Server_run_iterate(server, false);
+    ck_assert(closed);
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->serviceStatistics = true;
+    exporter = UA_OpenMetricsExporter_new(server, NULL);
+    ck_assert_ptr_ne(exporter, NULL);
+    /* Opened in the first iteration */
+    UA_StatusCode res = UA_OpenMetricsExporter_start(exporter);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_run_startup(server);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_OpenMetricsExporter_delete(exporter);
+    UA_Server_delete(server);
+}
+
+START_TEST(scrapeMetrics) {
+    scrape("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    ck_assert(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+    ck_assert(strstr(response, "\nopcua_sessions 0\n") != NULL);
+    ck_assert(strstr(response, "# TYPE opcua_eventloop_iterations counter\n") != NULL);
+    ck_assert(strstr(response, "opcua_nodestore_nodes{namespace=\"0\"}") != NULL);
+    ck_assert(responseLength > 6);
+    ck_assert(strcmp(&response[responseLength - 6], "# EOF\n") == 0);
+} END_TEST
+
+START_TEST(scrapeNotFound) {
+    scrape("GET /other HTTP/1.1\r\n\r\n");
+    ck_assert(strncmp(response, "HTTP/1.1 404 Not Found\r\n", 24) == 0);
+} END_TEST
+
+START_TEST(scrapeAfterStop) {
+    UA_OpenMetricsExporter_stop(exporter);
+    for(size_t i = 0; i < 10; i++)
+        UA_Server_run_iterate(server, false);
+    scrape("GET /metrics HTTP/1.1\r\n\r\n");
+    ck_assert_uint_eq(responseLength, 0);
+} END_TEST
+
+int main(void) {
+    Suite *s = suite_create("server - openmetrics");
+    TCase *tc = tcase_create("scrape");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, scrapeMetrics);
+    tcase_add_test(tc, scrapeNotFound);
+    tcase_add_test(tc, scrapeAfterStop);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
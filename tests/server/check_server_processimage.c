@@ -0,0 +1,183 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/plugin/processimage.h>
+
+#include "test_helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <check.h>
+
+typedef struct {
+    UA_Int32 counter;
+    UA_Double values[4];
+} TestImage;
+
+static UA_Server *server;
+static UA_ProcessImage *writer;
+static UA_ProcessImage *reader;
+static char shmName[64];
+
+static void
+addVariable(const char *name, const UA_DataType *type, size_t arrayLength) {
+    /* Initial value before the mapping */
+    UA_Double zero[4] = {0.0, 0.0, 0.0, 0.0};
+    UA_UInt32 arrayDims = (UA_UInt32)arrayLength;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = type->typeId;
+    if(arrayLength > 0) {
+        attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+        attr.arrayDimensions = &arrayDims;
+        attr.arrayDimensionsSize = 1;
+        UA_Variant_setArray(&attr.value, zero, arrayLength, type);
+    } else {
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        UA_Variant_setScalar(&attr.value, zero, type);
+    }
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char*)(uintptr_t)name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    /* The writer creates the region. The server opens it separately, like
+     * from another process. */
+    snprintf(shmName, sizeof(shmName), "/ua_check_pi_%d", (int)getpid());
+    UA_StatusCode res =
+        UA_ProcessImage_open(shmName, sizeof(TestImage), true, &writer);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_ProcessImage_open(shmName, sizeof(TestImage), false, &reader);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    addVariable("counter", &UA_TYPES[UA_TYPES_INT32], 0);
+    addVariable("values", &UA_TYPES[UA_TYPES_DOUBLE], 4);
+    res = UA_ProcessImage_addVariable(reader, server, UA_NODEID_STRING(1, "counter"),
+                                      offsetof(TestImage, counter),
+                                      &UA_TYPES[UA_TYPES_INT32], 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_ProcessImage_addVariable(reader, server, UA_NODEID_STRING(1, "values"),
+                                      offsetof(TestImage, values),
+                                      &UA_TYPES[UA_TYPES_DOUBLE], 4);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+    UA_ProcessImage_close(reader, false);
+    UA_ProcessImage_close(writer, true);
+}
+
+static void
+publish(UA_Int32 counter) {
+    TestImage *img = (TestImage*)UA_ProcessImage_data(writer);
+    UA_ProcessImage_beginWrite(writer);
+    img->counter = counter;
+    for(size_t i = 0; i < 4; i++)
+        img->values[i] = counter + (UA_Double)i / 10.0;
+    UA_ProcessImage_endWrite(writer);
+}
+
+START_TEST(readMappedVariables) {
+    publish(7);
+
+    UA_Variant v;
+    UA_StatusCode res = UA_Server_readValue(server, UA_NODEID_STRING(1, "counter"), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_INT32]));
+    ck_assert_int_eq(*(UA_Int32*)v.data, 7);
+    UA_Variant_clear(&v);
+
+    res = UA_Server_readValue(server, UA_NODEID_STRING(1, "values"), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasArrayType(&v, &UA_TYPES[UA_TYPES_DOUBLE]));
+    ck_assert_uint_eq(v.arrayLength, 4);
+    ck_assert(((UA_Double*)v.data)[3] == 7.3);
+    UA_Variant_clear(&v);
+
+    /* The next publication is visible */
+    publish(8);
+    res = UA_Server_readValue(server, UA_NODEID_STRING(1, "counter"), &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)v.data, 8);
+    UA_Variant_clear(&v);
+
+    /* Writing via OPC UA is not supported */
+    UA_Int32 val = 5;
+    UA_Variant_setScalar(&v, &val, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_writeValue(server, UA_NODEID_STRING(1, "counter"), v);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+} END_TEST
+
+START_TEST(readDuringWrite) {
+    publish(1);
+
+    /* The snapshot is not renewed while the writer is active */
+    TestImage *img = (TestImage*)UA_ProcessImage_data(writer);
+    UA_ProcessImage_beginWrite(writer);
+    img->counter = 2;
+
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "counter");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue dv = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_SOURCE);
+    ck_assert(dv.hasStatus);
+    ck_assert_uint_eq(dv.status, UA_STATUSCODE_BADRESOURCEUNAVAILABLE);
+    UA_DataValue_clear(&dv);
+
+    TestImage copy;
+    ck_assert_uint_eq(UA_ProcessImage_read(reader, &copy),
+                      UA_STATUSCODE_BADRESOURCEUNAVAILABLE);
+
+    UA_ProcessImage_endWrite(writer);
+    ck_assert_uint_eq(UA_ProcessImage_read(reader, &copy), UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(copy.counter, 2);
+
+    dv = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_SOURCE);
+    ck_assert(dv.hasValue);
+    ck_assert(dv.hasSourceTimestamp);
+    ck_assert_int_eq(*(UA_Int32*)dv.value.data, 2);
+    UA_DataValue_clear(&dv);
+} END_TEST
+
+START_TEST(mapOutOfRange) {
+    UA_StatusCode res =
+        UA_ProcessImage_addVariable(reader, server, UA_NODEID_STRING(1, "values"),
+                                    offsetof(TestImage, values),
+                                    &UA_TYPES[UA_TYPES_DOUBLE], 5);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADOUTOFRANGE);
+    res = UA_ProcessImage_addVariable(reader, server, UA_NODEID_STRING(1, "values"),
+                                      0, &UA_TYPES[UA_TYPES_STRING], 0);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADINVALIDARGUMENT);
+} END_TEST
+
+int main(void) {
+    Suite *s = suite_create("server - process image");
+    TCase *tc = tcase_create("processimage");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, readMappedVariables);
+    tcase_add_test(tc, readDuringWrite);
+    tcase_add_test(tc, mapOutOfRange);
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
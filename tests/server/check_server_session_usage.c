@@ -0,0 +1,124 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/client_config_default.h>
+#include <open62541/client_highlevel.h>
+#include <open62541/server_config_default.h>
+
+#include "ua_server_internal.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+#include "thread_wrapper.h"
+
+static UA_Server *server;
+static UA_Boolean running;
+static THREAD_HANDLE server_thread;
+
+THREAD_CALLBACK(serverloop) {
+    while(running)
+        UA_Server_run_iterate(server, true);
+    return 0;
+}
+
+static void setup(void) {
+    running = true;
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->sessionCpuTime = true;
+    UA_Server_run_startup(server);
+    THREAD_CREATE(server_thread, serverloop);
+}
+
+static void teardown(void) {
+    running = false;
+    THREAD_JOIN(server_thread);
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+static UA_UInt64
+getUsage(const UA_NodeId *sessionId, const char *name) {
+    UA_UInt64 value = 0;
+    UA_StatusCode res =
+        UA_Server_getSessionAttribute_scalar(server, sessionId,
+                                             UA_QUALIFIEDNAME(0, (char*)(uintptr_t)name),
+                                             &UA_TYPES[UA_TYPES_UINT64], &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    return value;
+}
+
+START_TEST(Session_usage) {
+    UA_Client *client = UA_Client_newForUnitTest();
+    UA_StatusCode res = UA_Client_connect(client, "opc.tcp://localhost:4840");
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Find the session of the client */
+    UA_LOCK(&server->serviceMutex);
+    session_list_entry *entry = LIST_FIRST(&server->sessions);
+    ck_assert(entry != NULL);
+    UA_NodeId sessionId;
+    UA_NodeId_copy(&entry->session.sessionId, &sessionId);
+    UA_UNLOCK(&server->serviceMutex);
+
+    UA_UInt64 decoded = getUsage(&sessionId, "bytesDecoded");
+    UA_UInt64 encoded = getUsage(&sessionId, "bytesEncoded");
+    for(size_t i = 0; i < 10; i++) {
+        UA_Variant value;
+        res = UA_Client_readValueAttribute(client,
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS), &value);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Variant_clear(&value);
+    }
+    ck_assert_uint_gt(getUsage(&sessionId, "bytesDecoded"), decoded);
+    ck_assert_uint_gt(getUsage(&sessionId, "bytesEncoded"), encoded);
+    ck_assert_uint_gt(getUsage(&sessionId, "serviceCpuTime"), 0);
+
+    /* The resource usage is also shown in the session diagnostics object */
+    UA_QualifiedName bn = UA_QUALIFIEDNAME(1, "BytesDecoded");
+    UA_BrowsePathResult bpr =
+        UA_Server_browseSimplifiedBrowsePath(server, sessionId, 1, &bn);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_Variant value;
+    res = UA_Client_readValueAttribute(client, bpr.targets[0].targetId.nodeId, &value);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&value, &UA_TYPES[UA_TYPES_UINT64]));
+    ck_assert_uint_gt(*(UA_UInt64*)value.data, decoded);
+    UA_Variant_clear(&value);
+    UA_BrowsePathResult_clear(&bpr);
+
+    /* The resource usage attributes cannot be overwritten */
+    UA_UInt64 zero = 0;
+    UA_Variant v;
+    UA_Variant_setScalar(&v, &zero, &UA_TYPES[UA_TYPES_UINT64]);
+    res = UA_Server_setSessionAttribute(server, &sessionId,
+                                        UA_QUALIFIEDNAME(0, "bytesDecoded"), &v);
+    ck_assert_uint_ne(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId_clear(&sessionId);
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+} END_TEST
+
+static Suite *testSuite_sessionUsage(void) {
+    TCase *tc = tcase_create("SessionUsage");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Session_usage);
+    Suite *s = suite_create("Server Session Resource Usage");
+    suite_add_tcase(s, tc);
+    return s;
+}
+
+int main(void) {
+    Suite *s = testSuite_sessionUsage();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr,CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+
+static UA_Server *server = NULL;
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->maxSessions = 2;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    config->maxSubscriptions = 2;
+    config->maxMonitoredItems = 2;
+    config->queueSizeLimits.min = 1;
+    config->queueSizeLimits.max = 4;
+#endif
+    UA_Server_run_startup(server);
+}
+
+static void teardown(void) {
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+}
+
+START_TEST(Pools_dimensioned) {
+    ck_assert_uint_eq(server->pools.sessions.capacity, 2);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    ck_assert_uint_eq(server->pools.subscriptions.capacity, 2);
+    ck_assert_uint_eq(server->pools.monitoredItems.capacity, 2);
+    ck_assert_uint_eq(server->pools.notifications.capacity, 2 * (4 + 1));
+#endif
+} END_TEST
+
+START_TEST(Pools_sessions) {
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    request.requestedSessionTimeout = 1000.0;
+
+    UA_Session *sessions[2];
+    UA_LOCK(&server->serviceMutex);
+    for(size_t i = 0; i < 2; i++) {
+        UA_StatusCode res = UA_Server_createSession(server, NULL, &request, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+    ck_assert_uint_eq(server->pools.sessions.used, 2);
+
+    /* The pool is exhausted even if the limit is raised after the startup */
+    server->config.maxSessions = 3;
+    UA_Session *session;
+    UA_StatusCode res = UA_Server_createSession(server, NULL, &request, &session);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADTOOMANYSESSIONS);
+
+    /* The memory is returned after the delayed callback */
+    UA_Server_removeSessionByToken(server, &sessions[0]->authenticationToken,
+                                   UA_SHUTDOWNREASON_CLOSE);
+    UA_UNLOCK(&server->serviceMutex);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(server->pools.sessions.used, 1);
+
+    /* Reuse the block */
+    UA_LOCK(&server->serviceMutex);
+    res = UA_Server_createSession(server, NULL, &request, &session);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->pools.sessions.used, 2);
+} END_TEST
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+static void
+dataChangeCallback(UA_Server *s, UA_UInt32 monId, void *monContext,
+                   const UA_NodeId *nodeId, void *nodeContext, UA_UInt32 attributeId,
+                   const UA_DataValue *value) {}
+
+START_TEST(Pools_monitoredItems) {
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_VALUE;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+    UA_MonitoredItemCreateResult res1 =
+        UA_Server_createDataChangeMonitoredItem(server, UA_TIMESTAMPSTORETURN_BOTH,
+                                                item, NULL, dataChangeCallback);
+    ck_assert_uint_eq(res1.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(server->pools.monitoredItems.used, 1);
+
+    /* The first sample creates a notification from the pool */
+    UA_Server_run_iterate(server, false);
+
+    UA_StatusCode res = UA_Server_deleteMonitoredItem(server, res1.monitoredItemId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(server->pools.monitoredItems.used, 0);
+    ck_assert_uint_eq(server->pools.notifications.used, 0);
+} END_TEST
+#endif
+
+int main(void) {
+    Suite *s = suite_create("Server Static Pools");
+    TCase *tc = tcase_create("Pools");
+    tcase_add_checked_fixture(tc, setup, teardown);
+    tcase_add_test(tc, Pools_dimensioned);
+    tcase_add_test(tc, Pools_sessions);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    tcase_add_test(tc, Pools_monitoredItems);
+#endif
+    suite_add_tcase(s, tc);
+
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    int number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
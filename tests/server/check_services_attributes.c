@@ -21,6 +21,7 @@
 #endif
 
 static UA_Server *server = NULL;
+static size_t temperatureReads = 0;
 
 static UA_StatusCode
 readCPUTemperature(UA_Server *server_,
@@ -28,6 +29,7 @@ readCPUTemperature(UA_Server *server_,
                    const UA_NodeId *nodeId, void *nodeContext,
                    UA_Boolean sourceTimeStamp, const UA_NumericRange *range,
                    UA_DataValue *dataValue) {
+    temperatureReads++;
     UA_Float temp = 20.5f;
     UA_Variant_setScalarCopy(&dataValue->value, &temp, &UA_TYPES[UA_TYPES_FLOAT]);
     dataValue->hasValue = true;
@@ -257,6 +259,271 @@ START_TEST(ReadSingleAttributeValueRangeWithoutTimestamp) {
     UA_DataValue_clear(&resp);
 } END_TEST
 
+/* Service_Read takes the batch path if only Value attributes are read */
+START_TEST(ReadMultipleValuesBatch) {
+    UA_ReadValueId rvi[5];
+    for(size_t i = 0; i < 5; i++) {
+        UA_ReadValueId_init(&rvi[i]);
+        rvi[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    rvi[0].nodeId = UA_NODEID_STRING(1, "the.answer");
+    rvi[1].nodeId = UA_NODEID_STRING(1, "myarray");
+    rvi[2].nodeId = UA_NODEID_STRING(1, "cpu.temperature");
+    rvi[3].nodeId = UA_NODEID_STRING(1, "unknown");
+    rvi[4].nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_BUILDINFO);
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = rvi;
+    request.nodesToReadSize = 5;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 5);
+    UA_DataValue *res = response.results;
+
+    ck_assert(res[0].hasValue);
+    ck_assert(res[0].hasServerTimestamp);
+    ck_assert(res[0].hasSourceTimestamp);
+    ck_assert(res[0].value.type == &UA_TYPES[UA_TYPES_INT32]);
+    ck_assert_int_eq(*(UA_Int32*)res[0].value.data, 42);
+
+    ck_assert(res[1].hasValue);
+    ck_assert_uint_eq(res[1].value.arrayLength, 9);
+    ck_assert_uint_eq(res[1].value.arrayDimensionsSize, 2);
+    ck_assert_int_eq(((UA_Int32*)res[1].value.data)[8], 9);
+
+    ck_assert(res[2].hasValue);
+    ck_assert(res[2].value.type == &UA_TYPES[UA_TYPES_FLOAT]);
+    ck_assert(*(UA_Float*)res[2].value.data == 20.5f);
+
+    ck_assert_uint_eq(res[3].status, UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    ck_assert(res[4].hasValue);
+    ck_assert(res[4].value.type == &UA_TYPES[UA_TYPES_BUILDINFO]);
+
+    /* The response is encoded and cleaned up as usual */
+    UA_ByteString buf = UA_BYTESTRING_NULL;
+    UA_StatusCode ret = UA_encodeBinary(&response, &UA_TYPES[UA_TYPES_READRESPONSE], &buf);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    UA_ReadResponse decoded;
+    ret = UA_decodeBinary(&buf, &decoded, &UA_TYPES[UA_TYPES_READRESPONSE], NULL);
+    ck_assert_uint_eq(ret, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)decoded.results[0].value.data, 42);
+    UA_ReadResponse_clear(&decoded);
+    UA_ByteString_clear(&buf);
+    UA_ReadResponse_clear(&response);
+} END_TEST
+
+static UA_DataValue
+readTemperatureMaxAge(UA_Double maxAge) {
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = UA_NODEID_STRING(1, "cpu.temperature");
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = &rvi;
+    request.nodesToReadSize = 1;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    request.maxAge = maxAge;
+
+    UA_ReadResponse response;
+    UA_ReadResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Read(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 1);
+
+    UA_DataValue dv = response.results[0];
+    UA_DataValue_init(&response.results[0]);
+    UA_ReadResponse_clear(&response);
+    return dv;
+}
+
+/* Reads with a maxAge take the value from the DataSource cache */
+START_TEST(ReadDataSourceCacheMaxAge) {
+    UA_NodeId tempId = UA_NODEID_STRING(1, "cpu.temperature");
+    UA_StatusCode res = UA_Server_setVariableNode_dataSourceCache(server, tempId, true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* The first read fills the cache */
+    size_t reads = temperatureReads;
+    UA_ServerStatistics before = UA_Server_getStatistics(server);
+    UA_DataValue dv = readTemperatureMaxAge(1000.0);
+    ck_assert(dv.hasValue);
+    ck_assert_uint_eq(temperatureReads, reads + 1);
+    UA_DataValue_clear(&dv);
+
+    /* Served from the cache */
+    dv = readTemperatureMaxAge(1000.0);
+    ck_assert(dv.hasValue);
+    ck_assert(dv.hasSourceTimestamp);
+    ck_assert(*(UA_Float*)dv.value.data == 20.5f);
+    ck_assert_uint_eq(temperatureReads, reads + 1);
+    UA_DataValue_clear(&dv);
+
+    UA_ServerStatistics after = UA_Server_getStatistics(server);
+    ck_assert_uint_eq(after.cs.dataSourceCacheHitCount,
+                      before.cs.dataSourceCacheHitCount + 1);
+    ck_assert_uint_eq(after.cs.dataSourceCacheMissCount,
+                      before.cs.dataSourceCacheMissCount + 1);
+
+    /* The cached value is too old */
+    UA_fakeSleep(2000);
+    dv = readTemperatureMaxAge(1000.0);
+    ck_assert_uint_eq(temperatureReads, reads + 2);
+    UA_DataValue_clear(&dv);
+
+    /* A maxAge of zero always reads from the DataSource */
+    dv = readTemperatureMaxAge(0.0);
+    ck_assert_uint_eq(temperatureReads, reads + 3);
+    UA_DataValue_clear(&dv);
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* The notification of a changed value drops the cached value */
+    res = UA_Server_notifyValueChanged(server, tempId);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    dv = readTemperatureMaxAge(1000.0);
+    ck_assert_uint_eq(temperatureReads, reads + 4);
+    UA_DataValue_clear(&dv);
+    reads++;
+#endif
+
+    /* Without the cache */
+    res = UA_Server_setVariableNode_dataSourceCache(server, tempId, false);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    dv = readTemperatureMaxAge(1000.0);
+    ck_assert_uint_eq(temperatureReads, reads + 4);
+    UA_DataValue_clear(&dv);
+
+    /* Only variables can have a cache */
+    res = UA_Server_setVariableNode_dataSourceCache(server,
+              UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODECLASSINVALID);
+} END_TEST
+
+static UA_StatusCode
+readAliasValue(const UA_NodeId alias, UA_Variant *v) {
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = alias;
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue dv = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_NEITHER);
+    UA_StatusCode res = (dv.hasStatus) ? dv.status : UA_STATUSCODE_GOOD;
+    *v = dv.value;
+    UA_Variant_init(&dv.value);
+    UA_DataValue_clear(&dv);
+    return res;
+}
+
+/* Registered nodes are accessed with their alias NodeId */
+START_TEST(RegisteredNodesReadWrite) {
+    server->config.maxRegisteredNodesPerSession = 2;
+    UA_StatusCode res =
+        UA_Server_writeAccessLevel(server, UA_NODEID_STRING(1, "the.answer"),
+                                   UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId ids[4];
+    ids[0] = UA_NODEID_STRING(1, "the.answer");
+    ids[1] = UA_NODEID_STRING(1, "unknown");
+    ids[2] = UA_NODEID_STRING(1, "myarray");
+    ids[3] = UA_NODEID_STRING(1, "the.enum.answer");
+
+    UA_RegisterNodesRequest request;
+    UA_RegisterNodesRequest_init(&request);
+    request.nodesToRegister = ids;
+    request.nodesToRegisterSize = 4;
+    UA_RegisterNodesResponse response;
+    UA_RegisterNodesResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_RegisterNodes(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.registeredNodeIdsSize, 4);
+
+    /* Unknown nodes and nodes beyond the limit keep their NodeId */
+    UA_NodeId *reg = response.registeredNodeIds;
+    ck_assert(!UA_NodeId_equal(&reg[0], &ids[0]));
+    ck_assert(UA_NodeId_equal(&reg[1], &ids[1]));
+    ck_assert(!UA_NodeId_equal(&reg[2], &ids[2]));
+    ck_assert(UA_NodeId_equal(&reg[3], &ids[3]));
+
+    /* Read with the alias */
+    UA_Variant v;
+    res = readAliasValue(reg[0], &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)v.data, 42);
+    UA_Variant_clear(&v);
+
+    /* Write with the alias */
+    UA_WriteValue wv;
+    UA_WriteValue_init(&wv);
+    UA_Int32 answer = 43;
+    wv.nodeId = reg[0];
+    wv.attributeId = UA_ATTRIBUTEID_VALUE;
+    wv.value.hasValue = true;
+    UA_Variant_setScalar(&wv.value.value, &answer, &UA_TYPES[UA_TYPES_INT32]);
+    UA_WriteRequest wreq;
+    UA_WriteRequest_init(&wreq);
+    wreq.nodesToWrite = &wv;
+    wreq.nodesToWriteSize = 1;
+    UA_WriteResponse wresp;
+    UA_WriteResponse_init(&wresp);
+    UA_LOCK(&server->serviceMutex);
+    Service_Write(server, &server->adminSession, &wreq, &wresp);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(wresp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(wresp.resultsSize, 1);
+    ck_assert_uint_eq(wresp.results[0], UA_STATUSCODE_GOOD);
+    UA_WriteResponse_clear(&wresp);
+
+    res = UA_Server_readValue(server, ids[0], &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)v.data, 43);
+    UA_Variant_clear(&v);
+
+    /* The alias of a deleted node is unknown */
+    res = UA_Server_deleteNode(server, ids[2], true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = readAliasValue(reg[2], &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_Variant_clear(&v);
+
+    /* The first node is still found after the nodestore has changed */
+    res = readAliasValue(reg[0], &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(*(UA_Int32*)v.data, 43);
+    UA_Variant_clear(&v);
+
+    /* Unregister */
+    UA_UnregisterNodesRequest ureq;
+    UA_UnregisterNodesRequest_init(&ureq);
+    ureq.nodesToUnregister = reg;
+    ureq.nodesToUnregisterSize = 4;
+    UA_UnregisterNodesResponse uresp;
+    UA_UnregisterNodesResponse_init(&uresp);
+    UA_LOCK(&server->serviceMutex);
+    Service_UnregisterNodes(server, &server->adminSession, &ureq, &uresp);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(uresp.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_UnregisterNodesResponse_clear(&uresp);
+
+    res = readAliasValue(reg[0], &v);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_Variant_clear(&v);
+    UA_RegisterNodesResponse_clear(&response);
+} END_TEST
+
 START_TEST(ReadSingleAttributeNodeIdWithoutTimestamp) {
     UA_ReadValueId rvi;
     UA_ReadValueId_init(&rvi);
@@ -837,6 +1104,55 @@ START_TEST(WriteSingleAttributeValue) {
 
 /* The ServerTimestamp during a Write Request shall be ignored. Instead the
  * server uses its own current time. */
+START_TEST(WriteMultipleValues) {
+    UA_Int32 myInteger = 21;
+    UA_Int32 myArray[3] = {1, 2, 3};
+    UA_NodeId ids[4] = {
+        UA_NODEID_STRING(1, "the.answer"), UA_NODEID_STRING(1, "myarray"),
+        UA_NODEID_STRING(1, "cpu.temperature"), UA_NODEID_STRING(1, "unknown")};
+    UA_DataValue values[4];
+    for(size_t i = 0; i < 4; i++) {
+        UA_DataValue_init(&values[i]);
+        values[i].hasValue = true;
+    }
+    UA_Variant_setScalar(&values[0].value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    values[0].hasSourceTimestamp = true;
+    values[0].sourceTimestamp = 1337;
+    UA_Variant_setArray(&values[1].value, myArray, 3, &UA_TYPES[UA_TYPES_INT32]);
+    UA_Variant_setScalar(&values[2].value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    UA_Variant_setScalar(&values[3].value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+
+    UA_StatusCode results[4];
+    UA_StatusCode retval = UA_Server_writeValues(server, 4, ids, values, results);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADWRITENOTSUPPORTED);
+    ck_assert_uint_eq(results[0], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(results[1], UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(results[2], UA_STATUSCODE_BADWRITENOTSUPPORTED);
+    ck_assert_uint_eq(results[3], UA_STATUSCODE_BADNODEIDUNKNOWN);
+
+    UA_ReadValueId rvi;
+    UA_ReadValueId_init(&rvi);
+    rvi.nodeId = ids[0];
+    rvi.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_DataValue resp = UA_Server_read(server, &rvi, UA_TIMESTAMPSTORETURN_SOURCE);
+    ck_assert(resp.hasValue);
+    ck_assert(resp.hasSourceTimestamp);
+    ck_assert_int_eq(resp.sourceTimestamp, 1337);
+    ck_assert_int_eq(21, *(UA_Int32*)resp.value.data);
+    UA_DataValue_clear(&resp);
+
+    /* Same type and shape as the current value */
+    myArray[2] = 42;
+    retval = UA_Server_writeValues(server, 2, ids, values, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant read;
+    retval = UA_Server_readValue(server, ids[1], &read);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(read.arrayLength, 3);
+    ck_assert_int_eq(((UA_Int32*)read.data)[2], 42);
+    UA_Variant_clear(&read);
+} END_TEST
+
 START_TEST(WriteSingleAttributeValueWithServerTimestamp) {
     UA_fakeSleep(5000);
 
@@ -915,6 +1231,85 @@ START_TEST(WriteSingleAttributeValueRangeFromArray) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+START_TEST(WriteSingleAttributeValueShared) {
+    UA_Int32 *array = (UA_Int32*)UA_Array_new(9, &UA_TYPES[UA_TYPES_INT32]);
+    for(UA_Int32 i = 0; i < 9; i++)
+        array[i] = 10 + i;
+    UA_Variant value;
+    UA_Variant_setArray(&value, array, 9, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retval = UA_Variant_share(&value);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The node and the read result reference the shared payload */
+    retval = UA_Server_writeValue(server, UA_NODEID_STRING(1, "myarray"), value);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_Variant read;
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "myarray"), &read);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_eq(read.data, value.data);
+    UA_Variant_clear(&read);
+
+    /* Writing a range does not modify the shared payload */
+    UA_WriteValue wValue;
+    UA_WriteValue_init(&wValue);
+    UA_Int32 myInteger = 20;
+    UA_Variant_setScalar(&wValue.value.value, &myInteger, &UA_TYPES[UA_TYPES_INT32]);
+    wValue.value.hasValue = true;
+    wValue.nodeId = UA_NODEID_STRING(1, "myarray");
+    wValue.indexRange = UA_STRING("0");
+    wValue.attributeId = UA_ATTRIBUTEID_VALUE;
+    retval = UA_Server_write(server, &wValue);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(((UA_Int32*)value.data)[0], 10);
+
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "myarray"), &read);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_ptr_ne(read.data, value.data);
+    ck_assert_int_eq(((UA_Int32*)read.data)[0], 20);
+    ck_assert_int_eq(((UA_Int32*)read.data)[1], 11);
+    UA_Variant_clear(&read);
+    UA_Variant_clear(&value);
+} END_TEST
+
+START_TEST(WriteSingleAttributeValueSharedMinSize) {
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->sharedValueMinSize = 64;
+
+    UA_Int32 array[100];
+    for(UA_Int32 i = 0; i < 100; i++)
+        array[i] = i;
+    UA_Variant value;
+    UA_Variant_setArray(&value, array, 100, &UA_TYPES[UA_TYPES_INT32]);
+    UA_StatusCode retval =
+        UA_Server_writeValue(server, UA_NODEID_STRING(1, "myarray"), value);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* The written value was copied once into a shared payload. The reads
+     * reference it. */
+    UA_Variant read1, read2;
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "myarray"), &read1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "myarray"), &read2);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(read1.storageType, UA_VARIANT_DATA_SHARED);
+    ck_assert_ptr_eq(read1.data, read2.data);
+    ck_assert_ptr_ne(read1.data, array);
+    ck_assert_uint_eq(read1.arrayLength, 100);
+    ck_assert_int_eq(((UA_Int32*)read1.data)[99], 99);
+    UA_Variant_clear(&read1);
+    UA_Variant_clear(&read2);
+
+    /* Small values are copied */
+    UA_Variant_setArray(&value, array, 4, &UA_TYPES[UA_TYPES_INT32]);
+    retval = UA_Server_writeValue(server, UA_NODEID_STRING(1, "myarray"), value);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_readValue(server, UA_NODEID_STRING(1, "myarray"), &read1);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_int_eq(read1.storageType, UA_VARIANT_DATA);
+    ck_assert_uint_eq(read1.arrayLength, 4);
+    UA_Variant_clear(&read1);
+} END_TEST
+
 START_TEST(WriteSingleAttributeDataType) {
     UA_WriteValue wValue;
     UA_WriteValue_init(&wValue);
@@ -1128,6 +1523,9 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeValueWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleServerAttribute);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeValueRangeWithoutTimestamp);
+    tcase_add_test(tc_readSingleAttributes, ReadMultipleValuesBatch);
+    tcase_add_test(tc_readSingleAttributes, ReadDataSourceCacheMaxAge);
+    tcase_add_test(tc_readSingleAttributes, RegisteredNodesReadWrite);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeNodeIdWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeNodeClassWithoutTimestamp);
     tcase_add_test(tc_readSingleAttributes, ReadSingleAttributeBrowseNameWithoutTimestamp);
@@ -1172,11 +1570,14 @@ static Suite * testSuite_services_attributes(void) {
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeContainsNoLoops);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeEventNotifier);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValue);
+    tcase_add_test(tc_writeSingleAttributes, WriteMultipleValues);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueWithServerTimestamp);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueEnum);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeDataType);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromScalar);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRangeFromArray);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueShared);
+    tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueSharedMinSize);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeValueRank);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeArrayDimensions);
     tcase_add_test(tc_writeSingleAttributes, WriteSingleAttributeAccessLevel);
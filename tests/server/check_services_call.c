@@ -32,9 +32,31 @@ methodCallback(UA_Server *serverArg,
     return UA_STATUSCODE_GOOD;
 }
 
+static size_t batchInvocations;
+static size_t batchCalls;
+
+static void
+batchCallback(UA_Server *serverArg, const UA_NodeId *sessionId,
+              void *sessionContext, const UA_NodeId *methodId,
+              void *methodContext, size_t callsSize,
+              const UA_CallMethodRequest *calls, UA_CallMethodResult *results) {
+    batchInvocations++;
+    for(size_t i = 0; i < callsSize; i++) {
+        if(results[i].statusCode != UA_STATUSCODE_GOOD)
+            continue;
+        batchCalls++;
+        /* Echo the input argument */
+        ck_assert_uint_eq(results[i].outputArgumentsSize, 1);
+        results[i].statusCode =
+            UA_Variant_copy(&calls[i].inputArguments[0], &results[i].outputArguments[0]);
+    }
+}
+
 static void setup(void) {
     server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
+    batchInvocations = 0;
+    batchCalls = 0;
 
     UA_MethodAttributes noFpAttr = UA_MethodAttributes_default;
     noFpAttr.description = UA_LOCALIZEDTEXT("en-US","No function pointer attached");
@@ -60,6 +82,22 @@ static void setup(void) {
                             nonExecAttr, &methodCallback,
                             0, NULL, 0, NULL, NULL, NULL);
 
+    UA_Argument arg;
+    UA_Argument_init(&arg);
+    arg.dataType = UA_TYPES[UA_TYPES_UINT32].typeId;
+    arg.valueRank = UA_VALUERANK_SCALAR;
+    UA_MethodAttributes batchAttr = UA_MethodAttributes_default;
+    batchAttr.displayName = UA_LOCALIZEDTEXT("en-US","Batch");
+    batchAttr.executable = true;
+    batchAttr.userExecutable = true;
+    UA_Server_addMethodNode(server, UA_NODEID_STRING(1, "batch"),
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                            UA_QUALIFIEDNAME(1, "Batch"),
+                            batchAttr, NULL, 1, &arg, 1, &arg, NULL, NULL);
+    UA_Server_setMethodNodeBatchCallback(server, UA_NODEID_STRING(1, "batch"),
+                                         batchCallback);
+
     /* Add callback to ServerType's getMonitoredItems method */
     UA_Server_setMethodNodeCallback(server,
                                     UA_NODEID_NUMERIC(0,UA_NS0ID_SERVERTYPE_GETMONITOREDITEMS),
@@ -322,6 +360,64 @@ START_TEST(callObjectTypeMethodOnInstance2) {
 #endif
 } END_TEST
 
+START_TEST(callBatchMethod) {
+    UA_UInt32 values[3] = {1, 2, 3};
+    UA_Double wrongType = 1.0;
+    UA_Variant inputArguments[4];
+    UA_Variant_setScalar(&inputArguments[0], &values[0], &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Variant_setScalar(&inputArguments[1], &wrongType, &UA_TYPES[UA_TYPES_DOUBLE]);
+    UA_Variant_setScalar(&inputArguments[2], &values[1], &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Variant_setScalar(&inputArguments[3], &values[2], &UA_TYPES[UA_TYPES_UINT32]);
+
+    /* The first three calls go to the batch callback together. The fourth
+     * call is separated by a call to another method. */
+    UA_CallMethodRequest calls[5];
+    for(size_t i = 0; i < 5; i++) {
+        UA_CallMethodRequest_init(&calls[i]);
+        calls[i].methodId = UA_NODEID_STRING(1, "batch");
+        calls[i].objectId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        calls[i].inputArgumentsSize = 1;
+    }
+    calls[0].inputArguments = &inputArguments[0];
+    calls[1].inputArguments = &inputArguments[1];
+    calls[2].inputArguments = &inputArguments[2];
+    calls[3].methodId = UA_NODEID_STRING(1, "nonexec");
+    calls[3].inputArgumentsSize = 0;
+    calls[4].inputArguments = &inputArguments[3];
+
+    UA_CallRequest request;
+    UA_CallRequest_init(&request);
+    request.methodsToCall = calls;
+    request.methodsToCallSize = 5;
+    UA_CallResponse response;
+    UA_CallResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_Call(server, &server->adminSession, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.resultsSize, 5);
+    ck_assert_uint_eq(batchInvocations, 2);
+    ck_assert_uint_eq(batchCalls, 3);
+    ck_assert_uint_eq(response.results[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(*(UA_UInt32*)response.results[0].outputArguments[0].data, 1);
+    ck_assert_uint_eq(response.results[1].statusCode, UA_STATUSCODE_BADINVALIDARGUMENT);
+    ck_assert_uint_eq(response.results[1].inputArgumentResults[0],
+                      UA_STATUSCODE_BADTYPEMISMATCH);
+    ck_assert_uint_eq(response.results[2].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(*(UA_UInt32*)response.results[2].outputArguments[0].data, 2);
+    ck_assert_uint_eq(response.results[3].statusCode, UA_STATUSCODE_BADNOTEXECUTABLE);
+    ck_assert_uint_eq(response.results[4].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(*(UA_UInt32*)response.results[4].outputArguments[0].data, 3);
+    UA_CallResponse_clear(&response);
+
+    /* A single call also uses the batch callback */
+    UA_CallMethodResult result = UA_Server_call(server, &calls[0]);
+    ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(batchInvocations, 3);
+    UA_CallMethodResult_clear(&result);
+} END_TEST
+
 int main(void) {
     Suite *s = suite_create("services_call");
 
@@ -339,6 +435,7 @@ int main(void) {
     tcase_add_test(tc_call, callMethodWithEmptyArgument);
     tcase_add_test(tc_call, callObjectTypeMethodOnInstance);
     tcase_add_test(tc_call, callObjectTypeMethodOnInstance2);
+    tcase_add_test(tc_call, callBatchMethod);
     suite_add_tcase(s, tc_call);
 
     SRunner *sr = srunner_create(s);
@@ -493,6 +493,95 @@ START_TEST(DeleteObjectAndReferences) {
 } END_TEST
 
 
+#define LARGE_SUBTREE_CHILDREN 1500
+
+/* The subtree is removed in one step together with the references from the
+ * outside. The Browse cache does not keep the deleted nodes. */
+START_TEST(DeleteLargeSubtree) {
+    UA_Server_getConfig(server)->browseCacheSize = 16;
+
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    UA_NodeId parentId = UA_NODEID_NUMERIC(1, 50000);
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, parentId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                UA_QUALIFIEDNAME(1, "Parent"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_NodeId outsideId = UA_NODEID_NUMERIC(1, 49999);
+    res = UA_Server_addObjectNode(server, outsideId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                  UA_QUALIFIEDNAME(1, "Outside"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                  attr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Children with references between them and from the outside. The
+     * references are non-hierarchical. Otherwise the children would have other
+     * parents and would not be deleted with the subtree. */
+    for(UA_UInt32 i = 0; i < LARGE_SUBTREE_CHILDREN; i++) {
+        UA_NodeId childId = UA_NODEID_NUMERIC(1, 50001 + i);
+        res = UA_Server_addObjectNode(server, childId, parentId,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                      UA_QUALIFIEDNAME(1, "Child"),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                      attr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        if(i > 0) {
+            res = UA_Server_addReference(server, childId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_GENERATESEVENT),
+                                         UA_EXPANDEDNODEID_NUMERIC(1, 50000 + i),
+                                         true);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+        if(i % 100 == 0) {
+            res = UA_Server_addReference(server, outsideId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_GENERATESEVENT),
+                                         UA_EXPANDEDNODEID_NUMERIC(1, 50001 + i),
+                                         true);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        }
+    }
+
+    /* Fill the Browse cache */
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = parentId;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_ge(br.referencesSize, LARGE_SUBTREE_CHILDREN);
+    UA_BrowseResult_clear(&br);
+
+    res = UA_Server_deleteNode(server, parentId, true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* All members are gone */
+    UA_NodeClass nc;
+    res = UA_Server_readNodeClass(server, parentId, &nc);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    for(UA_UInt32 i = 0; i < LARGE_SUBTREE_CHILDREN; i++) {
+        res = UA_Server_readNodeClass(server, UA_NODEID_NUMERIC(1, 50001 + i), &nc);
+        ck_assert_uint_eq(res, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    }
+    br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_BADNODEIDUNKNOWN);
+    UA_BrowseResult_clear(&br);
+
+    /* The references from the outside are removed */
+    bd.nodeId = outsideId;
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_GENERATESEVENT);
+    br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.referencesSize, 0);
+    UA_BrowseResult_clear(&br);
+} END_TEST
+
 /* Example taken from tutorial_server_object.c */
 START_TEST(InstantiateObjectType) {
     /* Define the object type */
@@ -591,6 +680,134 @@ START_TEST(InstantiateObjectType) {
     ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
 } END_TEST
 
+/* UA_NS0ID_MODELLINGRULE_MANDATORY is not available in Minimal Nodeset */
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+
+#define MAX_CONSTRUCTED 16
+static UA_NodeId constructed[MAX_CONSTRUCTED];
+static size_t constructedSize;
+
+static UA_StatusCode
+recordingConstructor(UA_Server *server_,
+                     const UA_NodeId *sessionId, void *sessionContext,
+                     const UA_NodeId *nodeId, void **nodeContext) {
+    ck_assert_uint_lt(constructedSize, MAX_CONSTRUCTED);
+    UA_NodeId_copy(nodeId, &constructed[constructedSize++]);
+    return UA_STATUSCODE_GOOD;
+}
+
+static size_t
+constructedIndex(const UA_NodeId *nodeId) {
+    size_t found = MAX_CONSTRUCTED;
+    for(size_t i = 0; i < constructedSize; i++) {
+        if(!UA_NodeId_equal(nodeId, &constructed[i]))
+            continue;
+        ck_assert_uint_eq(found, MAX_CONSTRUCTED); /* Constructed only once */
+        found = i;
+    }
+    ck_assert_uint_lt(found, MAX_CONSTRUCTED);
+    return found;
+}
+
+static void
+addMandatoryChild(const UA_NodeId parent, const char *name,
+                  UA_NodeClass nodeClass, const UA_NodeId typeId) {
+    UA_NodeId childId;
+    UA_StatusCode retval;
+    if(nodeClass == UA_NODECLASS_OBJECT) {
+        UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+        retval = UA_Server_addObjectNode(server, UA_NODEID_NULL, parent,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                         UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                         typeId, oAttr, NULL, &childId);
+    } else {
+        UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+        retval = UA_Server_addVariableNode(server, UA_NODEID_NULL, parent,
+                                           UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                           UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name),
+                                           typeId, vAttr, NULL, &childId);
+    }
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    retval = UA_Server_addReference(server, childId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASMODELLINGRULE),
+                                    UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_MODELLINGRULE_MANDATORY),
+                                    true);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+}
+
+static UA_NodeId
+childId(const UA_NodeId parent, const char *name) {
+    UA_QualifiedName qn = UA_QUALIFIEDNAME(1, (char*)(uintptr_t)name);
+    UA_BrowsePathResult bpr = UA_Server_browseSimplifiedBrowsePath(server, parent, 1, &qn);
+    ck_assert_uint_eq(bpr.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(bpr.targetsSize, 1);
+    UA_NodeId id = bpr.targets[0].targetId.nodeId;
+    UA_NodeId_init(&bpr.targets[0].targetId.nodeId);
+    UA_BrowsePathResult_clear(&bpr);
+    return id;
+}
+
+/* The constructors of the instantiated children are called once per node. The
+ * children are constructed before their parent. */
+START_TEST(InstantiateObjectTypeConstructorOrder) {
+    UA_NodeId innerTypeId = UA_NODEID_NUMERIC(1, 2002);
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, innerTypeId,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "InnerType"), otAttr,
+                                    NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    UA_NodeId bdvType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+    addMandatoryChild(innerTypeId, "Value", UA_NODECLASS_VARIABLE, bdvType);
+    addMandatoryChild(innerTypeId, "Value2", UA_NODECLASS_VARIABLE, bdvType);
+
+    UA_NodeId outerTypeId = UA_NODEID_NUMERIC(1, 2001);
+    retval = UA_Server_addObjectTypeNode(server, outerTypeId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                         UA_QUALIFIEDNAME(1, "OuterType"), otAttr,
+                                         NULL, NULL);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    addMandatoryChild(outerTypeId, "Count", UA_NODECLASS_VARIABLE, bdvType);
+    addMandatoryChild(outerTypeId, "Inner", UA_NODECLASS_OBJECT, innerTypeId);
+
+    /* Record the constructed nodes during the instantiation */
+    UA_Server_getConfig(server)->nodeLifecycle.constructor = recordingConstructor;
+    constructedSize = 0;
+    UA_NodeId outerId;
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    retval = UA_Server_addObjectNode(server, UA_NODEID_NULL,
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_QUALIFIEDNAME(1, "Outer"), outerTypeId,
+                                     oAttr, NULL, &outerId);
+    ck_assert_int_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(constructedSize, 5);
+
+    UA_NodeId countId = childId(outerId, "Count");
+    UA_NodeId innerId = childId(outerId, "Inner");
+    UA_NodeId valueId = childId(innerId, "Value");
+    UA_NodeId value2Id = childId(innerId, "Value2");
+    size_t outerIndex = constructedIndex(&outerId);
+    size_t innerIndex = constructedIndex(&innerId);
+    ck_assert_uint_eq(outerIndex, 4);
+    ck_assert_uint_lt(constructedIndex(&countId), outerIndex);
+    ck_assert_uint_lt(constructedIndex(&valueId), innerIndex);
+    ck_assert_uint_lt(constructedIndex(&value2Id), innerIndex);
+
+    for(size_t i = 0; i < constructedSize; i++)
+        UA_NodeId_clear(&constructed[i]);
+    UA_NodeId_clear(&outerId);
+    UA_NodeId_clear(&countId);
+    UA_NodeId_clear(&innerId);
+    UA_NodeId_clear(&valueId);
+    UA_NodeId_clear(&value2Id);
+} END_TEST
+
+#endif
+
 START_TEST(ObjectWithDynamicVariableChild) {
     /* Add a ServerRedundancyType object */
     UA_ObjectAttributes attr = UA_ObjectAttributes_default;
@@ -753,6 +970,9 @@ int main(void) {
     tcase_add_test(tc_addnodes, AddNodeTwiceGivesError);
     tcase_add_test(tc_addnodes, AddObjectWithConstructor);
     tcase_add_test(tc_addnodes, InstantiateObjectType);
+#ifdef UA_GENERATED_NAMESPACE_ZERO
+    tcase_add_test(tc_addnodes, InstantiateObjectTypeConstructorOrder);
+#endif
     tcase_add_test(tc_addnodes, ObjectWithDynamicVariableChild);
     suite_add_tcase(s, tc_addnodes);
 
@@ -760,6 +980,7 @@ int main(void) {
     tcase_add_checked_fixture(tc_deletenodes, setup, teardown);
     tcase_add_test(tc_deletenodes, DeleteObjectWithDestructor);
     tcase_add_test(tc_deletenodes, DeleteObjectAndReferences);
+    tcase_add_test(tc_deletenodes, DeleteLargeSubtree);
     suite_add_tcase(s, tc_deletenodes);
 
     TCase *tc_addreferences = tcase_create("addreferences");
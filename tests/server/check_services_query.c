@@ -0,0 +1,283 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#include "server/ua_server_internal.h"
+#include "server/ua_services.h"
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "test_helpers.h"
+
+static UA_Server *server = NULL;
+
+#define DEVICETYPE 5000
+#define DERIVEDDEVICETYPE 5001
+#define DEVICES 5
+
+static void
+addDevice(UA_UInt32 id, UA_UInt32 typeId, UA_Int32 status) {
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, id),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "Device"),
+                                UA_NODEID_NUMERIC(1, typeId), oAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&vAttr.value, &status, &UA_TYPES[UA_TYPES_INT32]);
+    res = UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, id + 1000),
+                                    UA_NODEID_NUMERIC(1, id),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                    UA_QUALIFIEDNAME(1, "Status"),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                    vAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+}
+
+static void setup(void) {
+    server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    /* DeviceType with a subtype */
+    UA_ObjectTypeAttributes otAttr = UA_ObjectTypeAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NUMERIC(1, DEVICETYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(1, "DeviceType"), otAttr,
+                                    NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_addObjectTypeNode(server, UA_NODEID_NUMERIC(1, DERIVEDDEVICETYPE),
+                                      UA_NODEID_NUMERIC(1, DEVICETYPE),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                      UA_QUALIFIEDNAME(1, "DerivedDeviceType"), otAttr,
+                                      NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Devices with Status 0 and 1 (fault) in turns. One more with the
+     * subtype and Status 1. */
+    for(UA_UInt32 i = 0; i < DEVICES; i++)
+        addDevice(6000 + i, DEVICETYPE, (UA_Int32)(i % 2));
+    addDevice(6000 + DEVICES, DERIVEDDEVICETYPE, 1);
+}
+
+static void teardown(void) {
+    UA_Server_delete(server);
+}
+
+/* Status == 1 */
+static void
+setFaultFilter(UA_ContentFilter *cf, UA_ContentFilterElement *cfe,
+               UA_SimpleAttributeOperand *sao, UA_QualifiedName *status,
+               UA_LiteralOperand *lo, UA_ExtensionObject *ops) {
+    static UA_Int32 fault = 1;
+    UA_SimpleAttributeOperand_init(sao);
+    sao->typeDefinitionId = UA_NODEID_NUMERIC(1, DEVICETYPE);
+    sao->browsePathSize = 1;
+    *status = UA_QUALIFIEDNAME(1, "Status");
+    sao->browsePath = status;
+    sao->attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_LiteralOperand_init(lo);
+    UA_Variant_setScalar(&lo->value, &fault, &UA_TYPES[UA_TYPES_INT32]);
+    UA_ExtensionObject_setValue(&ops[0], sao, &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_ExtensionObject_setValue(&ops[1], lo, &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ContentFilterElement_init(cfe);
+    cfe->filterOperator = UA_FILTEROPERATOR_EQUALS;
+    cfe->filterOperandsSize = 2;
+    cfe->filterOperands = ops;
+    cf->elementsSize = 1;
+    cf->elements = cfe;
+}
+
+static void
+queryFirst(const UA_QueryFirstRequest *request, UA_QueryFirstResponse *response) {
+    UA_QueryFirstResponse_init(response);
+    UA_LOCK(&server->serviceMutex);
+    Service_QueryFirst(server, &server->adminSession, request, response);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+static void
+queryNext(const UA_ByteString *cp, UA_Boolean release, UA_QueryNextResponse *response) {
+    UA_QueryNextRequest request;
+    UA_QueryNextRequest_init(&request);
+    request.continuationPoint = *cp;
+    request.releaseContinuationPoint = release;
+    UA_QueryNextResponse_init(response);
+    UA_LOCK(&server->serviceMutex);
+    Service_QueryNext(server, &server->adminSession, &request, response);
+    UA_UNLOCK(&server->serviceMutex);
+}
+
+START_TEST(Service_Query_TypeInstances) {
+    UA_NodeTypeDescription ntd;
+    UA_NodeTypeDescription_init(&ntd);
+    ntd.typeDefinitionNode.nodeId = UA_NODEID_NUMERIC(1, DEVICETYPE);
+
+    UA_QueryFirstRequest request;
+    UA_QueryFirstRequest_init(&request);
+    request.nodeTypesSize = 1;
+    request.nodeTypes = &ntd;
+
+    /* Only the direct instances */
+    UA_QueryFirstResponse response;
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.queryDataSetsSize, DEVICES);
+    ck_assert_uint_eq(response.parsingResultsSize, 0);
+    ck_assert_uint_eq(response.continuationPoint.length, 0);
+    UA_QueryFirstResponse_clear(&response);
+
+    /* With the subtypes */
+    ntd.includeSubTypes = true;
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.queryDataSetsSize, DEVICES + 1);
+    UA_QueryFirstResponse_clear(&response);
+
+    /* Not a type */
+    ntd.typeDefinitionNode.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.queryDataSetsSize, 0);
+    ck_assert_uint_eq(response.parsingResultsSize, 1);
+    ck_assert_uint_eq(response.parsingResults[0].statusCode,
+                      UA_STATUSCODE_BADTYPEDEFINITIONINVALID);
+    UA_QueryFirstResponse_clear(&response);
+} END_TEST
+
+START_TEST(Service_Query_Filter) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "Status");
+    UA_QueryDataDescription qdd;
+    UA_QueryDataDescription_init(&qdd);
+    qdd.relativePath.elementsSize = 1;
+    qdd.relativePath.elements = &rpe;
+    qdd.attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_NodeTypeDescription ntd;
+    UA_NodeTypeDescription_init(&ntd);
+    ntd.typeDefinitionNode.nodeId = UA_NODEID_NUMERIC(1, DEVICETYPE);
+    ntd.includeSubTypes = true;
+    ntd.dataToReturnSize = 1;
+    ntd.dataToReturn = &qdd;
+
+    UA_QueryFirstRequest request;
+    UA_QueryFirstRequest_init(&request);
+    request.nodeTypesSize = 1;
+    request.nodeTypes = &ntd;
+    UA_ContentFilterElement cfe;
+    UA_SimpleAttributeOperand sao;
+    UA_QualifiedName status;
+    UA_LiteralOperand lo;
+    UA_ExtensionObject ops[2];
+    setFaultFilter(&request.filter, &cfe, &sao, &status, &lo, ops);
+
+    /* Devices 1, 3 and the derived device are in fault */
+    UA_QueryFirstResponse response;
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.queryDataSetsSize, 3);
+    for(size_t i = 0; i < response.queryDataSetsSize; i++) {
+        UA_QueryDataSet *ds = &response.queryDataSets[i];
+        ck_assert_uint_eq(ds->valuesSize, 1);
+        ck_assert(UA_Variant_hasScalarType(&ds->values[0], &UA_TYPES[UA_TYPES_INT32]));
+        ck_assert_int_eq(*(UA_Int32*)ds->values[0].data, 1);
+        ck_assert_uint_eq(ds->nodeId.nodeId.identifier.numeric % 2, 1);
+    }
+    UA_QueryFirstResponse_clear(&response);
+} END_TEST
+
+START_TEST(Service_Query_ContinuationPoint) {
+    UA_NodeTypeDescription ntd;
+    UA_NodeTypeDescription_init(&ntd);
+    ntd.typeDefinitionNode.nodeId = UA_NODEID_NUMERIC(1, DEVICETYPE);
+    ntd.includeSubTypes = true;
+
+    UA_QueryFirstRequest request;
+    UA_QueryFirstRequest_init(&request);
+    request.nodeTypesSize = 1;
+    request.nodeTypes = &ntd;
+    request.maxDataSetsToReturn = 2;
+
+    UA_QueryFirstResponse response;
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(response.queryDataSetsSize, 2);
+    ck_assert_uint_eq(response.continuationPoint.length, sizeof(UA_Guid));
+    ck_assert_uint_eq(server->adminSession.availableQueryContinuationPoints,
+                      UA_MAXCONTINUATIONPOINTS - 1);
+
+    /* Two more and then the last two */
+    UA_QueryNextResponse next;
+    queryNext(&response.continuationPoint, false, &next);
+    ck_assert_uint_eq(next.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(next.queryDataSetsSize, 2);
+    ck_assert(UA_ByteString_equal(&next.revisedContinuationPoint,
+                                  &response.continuationPoint));
+    UA_QueryNextResponse_clear(&next);
+
+    queryNext(&response.continuationPoint, false, &next);
+    ck_assert_uint_eq(next.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(next.queryDataSetsSize, 2);
+    ck_assert_uint_eq(next.revisedContinuationPoint.length, 0);
+    UA_QueryNextResponse_clear(&next);
+    ck_assert_uint_eq(server->adminSession.availableQueryContinuationPoints,
+                      UA_MAXCONTINUATIONPOINTS);
+
+    /* The ContinuationPoint is gone */
+    queryNext(&response.continuationPoint, false, &next);
+    ck_assert_uint_eq(next.responseHeader.serviceResult,
+                      UA_STATUSCODE_BADCONTINUATIONPOINTINVALID);
+    UA_QueryNextResponse_clear(&next);
+    UA_QueryFirstResponse_clear(&response);
+
+    /* Release early */
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.continuationPoint.length, sizeof(UA_Guid));
+    queryNext(&response.continuationPoint, true, &next);
+    ck_assert_uint_eq(next.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(next.queryDataSetsSize, 0);
+    UA_QueryNextResponse_clear(&next);
+    UA_QueryFirstResponse_clear(&response);
+    ck_assert_uint_eq(server->adminSession.availableQueryContinuationPoints,
+                      UA_MAXCONTINUATIONPOINTS);
+
+    /* Left open and cleaned up with the session */
+    queryFirst(&request, &response);
+    ck_assert_uint_eq(response.continuationPoint.length, sizeof(UA_Guid));
+    UA_QueryFirstResponse_clear(&response);
+} END_TEST
+
+static Suite *testSuite_Service_Query(void) {
+    Suite *s = suite_create("Service Query");
+    TCase *tc_query = tcase_create("Query Basic");
+    tcase_add_checked_fixture(tc_query, setup, teardown);
+    tcase_add_test(tc_query, Service_Query_TypeInstances);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_EVENTS
+    tcase_add_test(tc_query, Service_Query_Filter);
+#endif
+    tcase_add_test(tc_query, Service_Query_ContinuationPoint);
+    suite_add_tcase(s, tc_query);
+    return s;
+}
+
+int main(void) {
+    int number_failed = 0;
+    Suite *s = testSuite_Service_Query();
+    SRunner *sr = srunner_create(s);
+    srunner_set_fork_status(sr, CK_NOFORK);
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed += srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
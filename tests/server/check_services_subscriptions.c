@@ -163,6 +163,61 @@ START_TEST(Server_modifySubscription) {
 }
 END_TEST
 
+static void
+modifyPublishingInterval(UA_UInt32 id, UA_Double interval) {
+    UA_ModifySubscriptionRequest request;
+    UA_ModifySubscriptionRequest_init(&request);
+    request.subscriptionId = id;
+    request.requestedPublishingInterval = interval;
+    request.requestedLifetimeCount = 1000;
+    request.requestedMaxKeepAliveCount = 1000;
+
+    UA_ModifySubscriptionResponse response;
+    UA_ModifySubscriptionResponse_init(&response);
+
+    UA_LOCK(&server->serviceMutex);
+    Service_ModifySubscription(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    ck_assert(response.revisedPublishingInterval == interval);
+
+    UA_ModifySubscriptionResponse_clear(&response);
+}
+
+START_TEST(Server_publishGroup) {
+    /* Subscriptions with the same publishing interval share a group */
+    createSubscription();
+    UA_UInt32 firstId = subscriptionId;
+    createSubscription();
+    UA_Subscription *first = UA_Session_getSubscriptionById(session, firstId);
+    UA_Subscription *second = UA_Session_getSubscriptionById(session, subscriptionId);
+    ck_assert_ptr_ne(first, NULL);
+    ck_assert_ptr_ne(second, NULL);
+    ck_assert_ptr_ne(first->publishGroup, NULL);
+    ck_assert_ptr_eq(first->publishGroup, second->publishGroup);
+
+    /* Changing the interval moves the subscription to another group */
+    modifyPublishingInterval(subscriptionId, 250.0);
+    ck_assert_ptr_ne(second->publishGroup, NULL);
+    ck_assert_ptr_ne(first->publishGroup, second->publishGroup);
+    ck_assert(second->publishGroup->publishingInterval == 250.0);
+
+    modifyPublishingInterval(firstId, 250.0);
+    ck_assert_ptr_eq(first->publishGroup, second->publishGroup);
+    ck_assert_ptr_eq(TAILQ_FIRST(&first->publishGroup->subscriptions), second);
+    ck_assert_ptr_eq(TAILQ_NEXT(second, publishGroupEntry), first);
+
+    /* Both subscriptions are published by the shared callback. Without
+     * PublishRequests the lifetime counters increase. */
+    ck_assert_uint_eq(first->currentLifetimeCount, 0);
+    ck_assert_uint_eq(second->currentLifetimeCount, 0);
+    UA_fakeSleep(251);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_gt(first->currentLifetimeCount, 0);
+    ck_assert_uint_eq(first->currentLifetimeCount, second->currentLifetimeCount);
+}
+END_TEST
+
 START_TEST(Server_setPublishingMode) {
     createSubscription();
 
@@ -248,6 +303,64 @@ START_TEST(Server_deleteSubscription) {
 }
 END_TEST
 
+static size_t delayedCallbacks;
+static void (*addDelayedCallbackOrig)(UA_EventLoop *el, UA_DelayedCallback *dc);
+
+static void
+addDelayedCallbackCounting(UA_EventLoop *el, UA_DelayedCallback *dc) {
+    delayedCallbacks++;
+    addDelayedCallbackOrig(el, dc);
+}
+
+/* Delete the Subscription and return the number of delayed callbacks */
+static size_t
+deleteSubscriptionCountDelayed(void) {
+    UA_EventLoop *el = server->config.eventLoop;
+    delayedCallbacks = 0;
+    addDelayedCallbackOrig = el->addDelayedCallback;
+    el->addDelayedCallback = addDelayedCallbackCounting;
+
+    UA_DeleteSubscriptionsRequest del_request;
+    UA_DeleteSubscriptionsRequest_init(&del_request);
+    del_request.subscriptionIdsSize = 1;
+    del_request.subscriptionIds = &subscriptionId;
+
+    UA_DeleteSubscriptionsResponse del_response;
+    UA_DeleteSubscriptionsResponse_init(&del_response);
+
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteSubscriptions(server, session, &del_request, &del_response);
+    ck_assert_ptr_eq(getSubscriptionById(server, subscriptionId), NULL);
+    UA_UNLOCK(&server->serviceMutex);
+    el->addDelayedCallback = addDelayedCallbackOrig;
+    ck_assert_uint_eq(del_response.resultsSize, 1);
+    ck_assert_uint_eq(del_response.results[0], UA_STATUSCODE_GOOD);
+    UA_DeleteSubscriptionsResponse_clear(&del_response);
+    return delayedCallbacks;
+}
+
+START_TEST(Server_deleteSubscriptionWithMonitoredItems) {
+    createSubscription();
+    createMonitoredItem();
+    size_t singleItemCallbacks = deleteSubscriptionCountDelayed();
+    ck_assert_uint_eq(monitored, 0);
+
+    createSubscription();
+    for(size_t i = 0; i < 5; i++)
+        createMonitoredItem();
+    ck_assert_uint_eq(monitored, 5);
+    ck_assert_uint_eq(server->monitoredItemsSize, 5);
+    size_t multiItemCallbacks = deleteSubscriptionCountDelayed();
+
+    /* The MonitoredItems are deregistered right away. Their memory is freed
+     * together with the Subscription. No delayed callback per MonitoredItem. */
+    ck_assert_uint_eq(monitored, 0);
+    ck_assert_uint_eq(server->monitoredItemsSize, 0);
+    ck_assert_uint_eq(multiItemCallbacks, singleItemCallbacks);
+    UA_Server_run_iterate(server, false);
+}
+END_TEST
+
 START_TEST(Server_publishCallback) {
     /* Create a subscription */
     UA_CreateSubscriptionRequest request;
@@ -451,6 +564,16 @@ START_TEST(Server_overflow) {
     ck_assert_uint_eq(notification->data.dataChange.value.status,
                       UA_STATUSCODE_INFOTYPE_DATAVALUE | UA_STATUSCODE_INFOBITS_OVERFLOW);
 
+    /* The discarded notification is kept for reuse */
+    ck_assert_uint_eq(mon->notificationPoolSize, 1);
+    UA_Notification *pooled = TAILQ_FIRST(&mon->notificationPool);
+    UA_fakeSleep(1); /* modify the server's currenttime */
+    UA_MonitoredItem_sampleCallback(server, mon);
+    ck_assert_uint_eq(mon->queueSize, 3);
+    ck_assert_ptr_eq(TAILQ_LAST(&mon->queue, NotificationQueue), pooled);
+    ck_assert_uint_eq(mon->notificationPoolSize, 1);
+    notification = TAILQ_FIRST(&mon->queue);
+
     /* Remove status for next test */
     notification->data.dataChange.value.hasStatus = false;
     notification->data.dataChange.value.status = 0;
@@ -625,6 +748,82 @@ START_TEST(Server_deleteMonitoredItems) {
 }
 END_TEST
 
+static UA_StatusCode
+setTriggering(UA_UInt32 triggeringId, UA_UInt32 *add, UA_UInt32 *remove) {
+    UA_SetTriggeringRequest request;
+    UA_SetTriggeringRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.triggeringItemId = triggeringId;
+    if(add) {
+        request.linksToAddSize = 1;
+        request.linksToAdd = add;
+    }
+    if(remove) {
+        request.linksToRemoveSize = 1;
+        request.linksToRemove = remove;
+    }
+
+    UA_SetTriggeringResponse response;
+    UA_SetTriggeringResponse_init(&response);
+
+    UA_LOCK(&server->serviceMutex);
+    Service_SetTriggering(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.responseHeader.serviceResult, UA_STATUSCODE_GOOD);
+    UA_StatusCode res = (add) ? response.addResults[0] : response.removeResults[0];
+    UA_SetTriggeringResponse_clear(&response);
+    return res;
+}
+
+START_TEST(Server_setTriggering) {
+    createSubscription();
+    createMonitoredItem();
+    UA_UInt32 triggeringId = monitoredItemId;
+    createMonitoredItem();
+    UA_UInt32 triggeredId = monitoredItemId;
+    UA_UInt32 invalidId = triggeredId + 100;
+
+    /* Adding a link twice succeeds */
+    ck_assert_uint_eq(setTriggering(triggeringId, &triggeredId, NULL),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(setTriggering(triggeringId, &triggeredId, NULL),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(setTriggering(triggeringId, &invalidId, NULL),
+                      UA_STATUSCODE_BADMONITOREDITEMIDINVALID);
+
+    /* Remove the link. It is gone afterwards. */
+    ck_assert_uint_eq(setTriggering(triggeringId, NULL, &triggeredId),
+                      UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(setTriggering(triggeringId, NULL, &triggeredId),
+                      UA_STATUSCODE_BADMONITOREDITEMIDINVALID);
+
+    /* The link is removed together with the triggered MonitoredItem */
+    ck_assert_uint_eq(setTriggering(triggeringId, &triggeredId, NULL),
+                      UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsRequest request;
+    UA_DeleteMonitoredItemsRequest_init(&request);
+    request.subscriptionId = subscriptionId;
+    request.monitoredItemIdsSize = 1;
+    request.monitoredItemIds = &triggeredId;
+    UA_DeleteMonitoredItemsResponse response;
+    UA_DeleteMonitoredItemsResponse_init(&response);
+    UA_LOCK(&server->serviceMutex);
+    Service_DeleteMonitoredItems(server, session, &request, &response);
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(response.results[0], UA_STATUSCODE_GOOD);
+    UA_DeleteMonitoredItemsResponse_clear(&response);
+
+    UA_LOCK(&server->serviceMutex);
+    UA_Subscription *sub = UA_Session_getSubscriptionById(session, subscriptionId);
+    UA_MonitoredItem *mon = UA_Subscription_getMonitoredItem(sub, triggeringId);
+    ck_assert_ptr_ne(mon, NULL);
+    ck_assert(LIST_EMPTY(&mon->triggeringLinks));
+    UA_UNLOCK(&server->serviceMutex);
+    ck_assert_uint_eq(setTriggering(triggeringId, NULL, &triggeredId),
+                      UA_STATUSCODE_BADMONITOREDITEMIDINVALID);
+}
+END_TEST
+
 START_TEST(Server_lifeTimeCount) {
     /* Create a subscription */
     UA_CreateSubscriptionRequest request;
@@ -864,6 +1063,7 @@ static Suite* testSuite_Client(void) {
 #ifdef UA_ENABLE_SUBSCRIPTIONS
     tcase_add_test(tc_server, Server_createSubscription);
     tcase_add_test(tc_server, Server_modifySubscription);
+    tcase_add_test(tc_server, Server_publishGroup);
     tcase_add_test(tc_server, Server_setPublishingMode);
     tcase_add_test(tc_server, Server_negativeSamplingInterval);
     tcase_add_test(tc_server, Server_createMonitoredItems);
@@ -871,9 +1071,11 @@ static Suite* testSuite_Client(void) {
     tcase_add_test(tc_server, Server_overflow);
     tcase_add_test(tc_server, Server_setMonitoringMode);
     tcase_add_test(tc_server, Server_deleteMonitoredItems);
+    tcase_add_test(tc_server, Server_setTriggering);
     tcase_add_test(tc_server, Server_republish);
     tcase_add_test(tc_server, Server_republish_invalid);
     tcase_add_test(tc_server, Server_deleteSubscription);
+    tcase_add_test(tc_server, Server_deleteSubscriptionWithMonitoredItems);
     tcase_add_test(tc_server, Server_publishCallback);
     tcase_add_test(tc_server, Server_lifeTimeCount);
     tcase_add_test(tc_server, Server_invalidPublishingInterval);
@@ -129,6 +129,139 @@ START_TEST(Service_Browse_WithMaxResults) {
 }
 END_TEST
 
+START_TEST(Service_Browse_ContinuationPointMemory) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+
+    /* Measure a single ContinuationPoint */
+    UA_BrowseResult br[3];
+    br[0] = UA_Server_browse(server, 1, &bd);
+    ck_assert_uint_eq(br[0].statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br[0].continuationPoint.length, sizeof(UA_Guid));
+    size_t memory = server->continuationPointsMemory;
+    ck_assert_uint_gt(memory, 0);
+
+    /* Room for two ContinuationPoints. The third evicts the oldest. */
+    server->config.maxBrowseContinuationPointsMemory = (UA_UInt32)(memory * 5 / 2);
+    for(size_t i = 1; i < 3; i++) {
+        br[i] = UA_Server_browse(server, 1, &bd);
+        ck_assert_uint_eq(br[i].statusCode, UA_STATUSCODE_GOOD);
+        ck_assert_uint_eq(br[i].continuationPoint.length, sizeof(UA_Guid));
+    }
+    ck_assert_uint_le(server->continuationPointsMemory,
+                      server->config.maxBrowseContinuationPointsMemory);
+
+    UA_BrowseResult next = UA_Server_browseNext(server, false, &br[0].continuationPoint);
+    ck_assert_uint_eq(next.statusCode, UA_STATUSCODE_BADCONTINUATIONPOINTINVALID);
+    UA_BrowseResult_clear(&next);
+
+    /* The remaining ContinuationPoints are valid */
+    for(size_t i = 1; i < 3; i++) {
+        next = UA_Server_browseNext(server, true, &br[i].continuationPoint);
+        ck_assert_uint_eq(next.statusCode, UA_STATUSCODE_GOOD);
+        UA_BrowseResult_clear(&next);
+    }
+    ck_assert_uint_eq(server->continuationPointsMemory, 0);
+
+    for(size_t i = 0; i < 3; i++)
+        UA_BrowseResult_clear(&br[i]);
+    UA_Server_delete(server);
+}
+END_TEST
+
+/* Returns the number of organized nodes and the DisplayName of the Server
+ * object in the ObjectsFolder */
+static size_t
+browseOrganizes(UA_Server *server, UA_LocalizedText *serverName) {
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    bd.resultMask = UA_BROWSERESULTMASK_ALL;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+    UA_BrowseResult br = UA_Server_browse(server, 0, &bd);
+    ck_assert_uint_eq(br.statusCode, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(br.continuationPoint.length, 0);
+    size_t size = br.referencesSize;
+    UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    for(size_t i = 0; i < size && serverName; i++) {
+        if(UA_NodeId_equal(&br.references[i].nodeId.nodeId, &serverId))
+            UA_LocalizedText_copy(&br.references[i].displayName, serverName);
+    }
+    UA_BrowseResult_clear(&br);
+    return size;
+}
+
+START_TEST(Service_Browse_Cache) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->browseCacheSize = 16;
+
+    /* Repeated browsing returns the same (cached) results */
+    size_t initial = browseOrganizes(server, NULL);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial);
+
+    /* Adding a node invalidates the cache */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    oAttr.displayName = UA_LOCALIZEDTEXT("", "Cached");
+    UA_NodeId objId = UA_NODEID_NUMERIC(1, 4242);
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, objId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                UA_QUALIFIEDNAME(1, "Cached"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial);
+
+    /* Adding and deleting references invalidates the cache */
+    UA_ExpandedNodeId target = UA_EXPANDEDNODEID_NUMERIC(1, 4242);
+    res = UA_Server_addReference(server, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                 UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                 target, true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial + 1);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial + 1);
+
+    res = UA_Server_deleteReference(server, UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), true,
+                                    target, true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(browseOrganizes(server, NULL), initial);
+
+    /* Writing the DisplayName of a target invalidates the cache */
+    UA_String serverName = UA_STRING("Server");
+    UA_String renamed = UA_STRING("Renamed");
+    UA_LocalizedText name;
+    UA_LocalizedText_init(&name);
+    browseOrganizes(server, &name);
+    ck_assert(UA_String_equal(&name.text, &serverName));
+    UA_LocalizedText_clear(&name);
+    res = UA_Server_writeDisplayName(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     UA_LOCALIZEDTEXT("", "Renamed"));
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    browseOrganizes(server, &name);
+    ck_assert(UA_String_equal(&name.text, &renamed));
+    UA_LocalizedText_clear(&name);
+
+    /* Results that need a ContinuationPoint are not served from the cache */
+    UA_NodeId objects = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    size_t all = browseWithMaxResults(server, objects, 1000);
+    ck_assert_uint_eq(browseWithMaxResults(server, objects, 1), all);
+    ck_assert_uint_eq(browseWithMaxResults(server, objects, 1000), all);
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(Service_Browse_WithBrowseName) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -271,6 +404,39 @@ START_TEST(Service_Browse_ReferenceTypes) {
 }
 END_TEST
 
+START_TEST(RefTree_AddContains) {
+    RefTree rt;
+    UA_StatusCode res = RefTree_init(&rt);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+    /* Grow the RefTree several times */
+    for(UA_UInt32 i = 0; i < 1000; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        UA_Boolean duplicate = false;
+        res = RefTree_addNodeId(&rt, &id, &duplicate);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(!duplicate);
+    }
+    ck_assert_uint_eq(rt.size, 1000);
+
+    /* Duplicates are detected and the insertion order is kept */
+    for(UA_UInt32 i = 0; i < 1000; i++) {
+        UA_NodeId id = UA_NODEID_NUMERIC(1, i);
+        UA_Boolean duplicate = false;
+        res = RefTree_addNodeId(&rt, &id, &duplicate);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        ck_assert(duplicate);
+        ck_assert(RefTree_containsNodeId(&rt, &id));
+        ck_assert(UA_NodeId_equal(&rt.targets[i].nodeId, &id));
+    }
+    ck_assert_uint_eq(rt.size, 1000);
+
+    UA_NodeId missing = UA_NODEID_NUMERIC(2, 1);
+    ck_assert(!RefTree_containsNodeId(&rt, &missing));
+    RefTree_clear(&rt);
+}
+END_TEST
+
 START_TEST(Service_Browse_Recursive) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -303,6 +469,112 @@ START_TEST(Service_Browse_Recursive) {
 }
 END_TEST
 
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+static UA_Boolean
+containsNodeId(const UA_ExpandedNodeId *ids, size_t idsSize, const UA_NodeId *id) {
+    for(size_t i = 0; i < idsSize; i++) {
+        if(UA_NodeId_equal(&ids[i].nodeId, id))
+            return true;
+    }
+    return false;
+}
+
+/* The parallel walk finds the same nodes as the serial walk */
+START_TEST(Service_Browse_RecursiveParallel) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+
+    /* 10 folders with 10 objects with 10 variables each. The levels are large
+     * enough to be expanded by the workers. */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_StatusCode res;
+    for(UA_UInt32 i = 1; i <= 10; i++) {
+        UA_NodeId folderId = UA_NODEID_NUMERIC(1, 100000 + i);
+        res = UA_Server_addObjectNode(server, folderId,
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                      UA_QUALIFIEDNAME(1, "Folder"),
+                                      UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+                                      oAttr, NULL, NULL);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        for(UA_UInt32 j = 1; j <= 10; j++) {
+            UA_NodeId objectId = UA_NODEID_NUMERIC(1, i * 1000 + j * 100);
+            res = UA_Server_addObjectNode(server, objectId, folderId,
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                          UA_QUALIFIEDNAME(1, "Object"),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                          oAttr, NULL, NULL);
+            ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            for(UA_UInt32 k = 1; k <= 10; k++) {
+                res = UA_Server_addVariableNode(server,
+                                                UA_NODEID_NUMERIC(1, i * 1000 + j * 100 + k),
+                                                objectId,
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                                UA_QUALIFIEDNAME(1, "Variable"),
+                                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                                vAttr, NULL, NULL);
+                ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+            }
+        }
+
+        /* A loop back to the ObjectsFolder */
+        res = UA_Server_addReference(server, UA_NODEID_NUMERIC(1, i * 1000 + 100),
+                                     UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                     UA_EXPANDEDNODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                     true);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    }
+
+    UA_BrowseDescription bd;
+    UA_BrowseDescription_init(&bd);
+    bd.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    bd.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_HIERARCHICALREFERENCES);
+    bd.includeSubtypes = true;
+    bd.browseDirection = UA_BROWSEDIRECTION_FORWARD;
+
+    for(size_t m = 0; m < 2; m++) {
+        bd.nodeClassMask = (m == 0) ? 0 : UA_NODECLASS_VARIABLE;
+
+        size_t serialSize = 0;
+        UA_ExpandedNodeId *serial = NULL;
+        res = UA_Server_browseRecursive(server, &bd, &serialSize, &serial);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        UA_Server_getConfig(server)->browseRecursiveWorkers = 4;
+        size_t parallelSize = 0;
+        UA_ExpandedNodeId *parallel = NULL;
+        res = UA_Server_browseRecursive(server, &bd, &parallelSize, &parallel);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+
+        /* The result order is the same in every run */
+        size_t againSize = 0;
+        UA_ExpandedNodeId *again = NULL;
+        res = UA_Server_browseRecursive(server, &bd, &againSize, &again);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_Server_getConfig(server)->browseRecursiveWorkers = 0;
+
+        ck_assert_uint_eq(parallelSize, serialSize);
+        ck_assert_uint_eq(againSize, parallelSize);
+        if(m == 1)
+            ck_assert_uint_ge(parallelSize, 1000);
+        else
+            ck_assert_uint_ge(parallelSize, 1110);
+        for(size_t i = 0; i < parallelSize; i++) {
+            ck_assert(containsNodeId(serial, serialSize, &parallel[i].nodeId));
+            ck_assert(UA_ExpandedNodeId_equal(&parallel[i], &again[i]));
+        }
+
+        UA_Array_delete(serial, serialSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+        UA_Array_delete(parallel, parallelSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+        UA_Array_delete(again, againSize, &UA_TYPES[UA_TYPES_EXPANDEDNODEID]);
+    }
+
+    UA_Server_delete(server);
+}
+END_TEST
+#endif
+
 START_TEST(Service_Browse_Localization) {
     UA_Server *server = UA_Server_newForUnitTest();
     ck_assert(server != NULL);
@@ -480,6 +752,59 @@ START_TEST(Service_TranslateBrowsePathsNoMatches) {
 }
 END_TEST
 
+static UA_StatusCode
+translateCachedPath(UA_Server *server) {
+    UA_RelativePathElement rpe;
+    UA_RelativePathElement_init(&rpe);
+    rpe.referenceTypeId = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    rpe.targetName = UA_QUALIFIEDNAME(1, "CachedPath");
+    UA_BrowsePath browsePath;
+    UA_BrowsePath_init(&browsePath);
+    browsePath.startingNode = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    browsePath.relativePath.elements = &rpe;
+    browsePath.relativePath.elementsSize = 1;
+
+    UA_BrowsePathResult bpr = UA_Server_translateBrowsePathToNodeIds(server, &browsePath);
+    UA_StatusCode res = bpr.statusCode;
+    if(res == UA_STATUSCODE_GOOD) {
+        ck_assert_uint_eq(bpr.targetsSize, 1);
+        ck_assert_uint_eq(bpr.targets[0].targetId.nodeId.identifier.numeric, 4343);
+    }
+    UA_BrowsePathResult_clear(&bpr);
+    return res;
+}
+
+START_TEST(Service_TranslateBrowsePathsCache) {
+    UA_Server *server = UA_Server_newForUnitTest();
+    ck_assert(server != NULL);
+    UA_Server_getConfig(server)->translateBrowsePathCacheSize = 16;
+
+    /* The (cached) result without a match */
+    ck_assert_uint_eq(translateCachedPath(server), UA_STATUSCODE_BADNOMATCH);
+    ck_assert_uint_eq(translateCachedPath(server), UA_STATUSCODE_BADNOMATCH);
+
+    /* Adding the node invalidates the cache */
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode res =
+        UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 4343),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "CachedPath"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oAttr, NULL, NULL);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(translateCachedPath(server), UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(translateCachedPath(server), UA_STATUSCODE_GOOD);
+
+    /* Deleting the node invalidates the cache */
+    res = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 4343), true);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(translateCachedPath(server), UA_STATUSCODE_BADNOMATCH);
+
+    UA_Server_delete(server);
+}
+END_TEST
+
 START_TEST(BrowseSimplifiedBrowsePath) {
     UA_QualifiedName objectsName = UA_QUALIFIEDNAME(0, "Objects");
     UA_BrowsePathResult bpr =
@@ -501,7 +826,13 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     tcase_add_test(tc_browse, Service_Browse_ClassMask);
     tcase_add_test(tc_browse, Service_Browse_ReferenceTypes);
     tcase_add_test(tc_browse, Service_Browse_WithMaxResults);
+    tcase_add_test(tc_browse, Service_Browse_Cache);
+    tcase_add_test(tc_browse, Service_Browse_ContinuationPointMemory);
+    tcase_add_test(tc_browse, RefTree_AddContains);
     tcase_add_test(tc_browse, Service_Browse_Recursive);
+#ifdef UA_BROWSERECURSIVE_PARALLEL
+    tcase_add_test(tc_browse, Service_Browse_RecursiveParallel);
+#endif
     tcase_add_test(tc_browse, Service_Browse_Localization);
     suite_add_tcase(s, tc_browse);
 
@@ -510,6 +841,7 @@ static Suite *testSuite_Service_TranslateBrowsePathsToNodeIds(void) {
     tcase_add_test(tc_translate, ServiceTest_TranslateBrowsePathsToNodeIds);
     tcase_add_test(tc_translate, Service_TranslateBrowsePathsWithHashCollision);
     tcase_add_test(tc_translate, Service_TranslateBrowsePathsNoMatches);
+    tcase_add_test(tc_translate, Service_TranslateBrowsePathsCache);
     tcase_add_test(tc_translate, BrowseSimplifiedBrowsePath);
 
     suite_add_tcase(s, tc_translate);
@@ -8,6 +8,7 @@
 #include <open62541/server_config_default.h>
 #include <open62541/types.h>
 
+#include "server/ua_server_internal.h"
 #include "server/ua_services.h"
 #include "client/ua_client_internal.h"
 #include "test_helpers.h"
@@ -114,6 +115,75 @@ START_TEST(Session_updateLifetime_ShallWork) {
 }
 END_TEST
 
+#define INDEX_SESSIONS 100
+
+/* Sessions are found through the token and id index. Only the Sessions whose
+ * lifetime was not extended are removed by the housekeeping. */
+START_TEST(Session_index_ShallWork) {
+    UA_Server *indexServer = UA_Server_newForUnitTest();
+    ck_assert(indexServer != NULL);
+    UA_Server_run_startup(indexServer);
+
+    UA_CreateSessionRequest request;
+    UA_CreateSessionRequest_init(&request);
+    request.requestedSessionTimeout = 1000.0;
+
+    UA_Session *sessions[INDEX_SESSIONS];
+    UA_NodeId tokens[INDEX_SESSIONS];
+    UA_NodeId ids[INDEX_SESSIONS];
+    UA_LOCK(&indexServer->serviceMutex);
+    for(size_t i = 0; i < INDEX_SESSIONS; i++) {
+        UA_StatusCode res =
+            UA_Server_createSession(indexServer, NULL, &request, &sessions[i]);
+        ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+        UA_NodeId_copy(&sessions[i]->authenticationToken, &tokens[i]);
+        UA_NodeId_copy(&sessions[i]->sessionId, &ids[i]);
+    }
+    ck_assert_uint_eq(indexServer->sessionCount, INDEX_SESSIONS);
+
+    for(size_t i = 0; i < INDEX_SESSIONS; i++) {
+        ck_assert_ptr_eq(getSessionByToken(indexServer, &tokens[i]), sessions[i]);
+        ck_assert_ptr_eq(getSessionById(indexServer, &ids[i]), sessions[i]);
+    }
+    ck_assert_ptr_eq(getSessionByToken(indexServer, &ids[0]), NULL);
+
+    /* Extend the lifetime of every second session */
+    UA_EventLoop *el = indexServer->config.eventLoop;
+    UA_DateTime nowMonotonic = el->dateTime_nowMonotonic(el);
+    for(size_t i = 0; i < INDEX_SESSIONS; i += 2)
+        sessions[i]->validTill = nowMonotonic + (10 * UA_DATETIME_SEC);
+
+    UA_Server_cleanupSessions(indexServer, nowMonotonic + (2 * UA_DATETIME_SEC));
+    ck_assert_uint_eq(indexServer->sessionCount, INDEX_SESSIONS / 2);
+    for(size_t i = 0; i < INDEX_SESSIONS; i++) {
+        UA_Session *expected = (i % 2 == 0) ? sessions[i] : NULL;
+        ck_assert_ptr_eq(getSessionByToken(indexServer, &tokens[i]), expected);
+        ck_assert_ptr_eq(getSessionById(indexServer, &ids[i]), expected);
+    }
+
+    /* Remove by token */
+    UA_StatusCode res =
+        UA_Server_removeSessionByToken(indexServer, &tokens[0],
+                                       UA_SHUTDOWNREASON_CLOSE);
+    ck_assert_uint_eq(res, UA_STATUSCODE_GOOD);
+    res = UA_Server_removeSessionByToken(indexServer, &tokens[0],
+                                         UA_SHUTDOWNREASON_CLOSE);
+    ck_assert_uint_eq(res, UA_STATUSCODE_BADSESSIONIDINVALID);
+    ck_assert_ptr_eq(getSessionById(indexServer, &ids[0]), NULL);
+
+    /* The refreshed sessions time out later on */
+    UA_Server_cleanupSessions(indexServer, nowMonotonic + (20 * UA_DATETIME_SEC));
+    ck_assert_uint_eq(indexServer->sessionCount, 0);
+    UA_UNLOCK(&indexServer->serviceMutex);
+
+    for(size_t i = 0; i < INDEX_SESSIONS; i++) {
+        UA_NodeId_clear(&tokens[i]);
+        UA_NodeId_clear(&ids[i]);
+    }
+    UA_Server_run_shutdown(indexServer);
+    UA_Server_delete(indexServer);
+} END_TEST
+
 static Suite* testSuite_Session(void) {
     Suite *s = suite_create("Session");
     TCase *tc_session = tcase_create("Core");
@@ -122,6 +192,9 @@ static Suite* testSuite_Session(void) {
     tcase_add_test(tc_session, Session_init_ShallWork);
     tcase_add_test(tc_session, Session_updateLifetime_ShallWork);
     suite_add_tcase(s,tc_session);
+    TCase *tc_index = tcase_create("Index");
+    tcase_add_test(tc_index, Session_index_ShallWork);
+    suite_add_tcase(s,tc_index);
     return s;
 }
 
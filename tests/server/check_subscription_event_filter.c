@@ -439,7 +439,7 @@ setupInListFilter(UA_ContentFilterElement *element, UA_UInt16 elements){
     setupOperandArrays(element);
 }
 
-/*static void
+static void
 setupElementOperand(UA_ContentFilterElement *element, size_t count, UA_UInt32 *indexes){
     for(size_t i = 0; i < count; ++i) {
         element->filterOperands[i].content.decoded.type = &UA_TYPES[UA_TYPES_ELEMENTOPERAND];
@@ -449,7 +449,7 @@ setupElementOperand(UA_ContentFilterElement *element, size_t count, UA_UInt32 *i
         firstElementOperand->index = indexes[i];
         element->filterOperands[i].content.decoded.data = firstElementOperand;
     }
-}*/
+}
 
 static void
 setupLiteralOperand(UA_ContentFilterElement *element, size_t count, UA_Variant *literals){
@@ -604,6 +604,55 @@ START_TEST(ofTypeOperatorValidation) {
     UA_EventFilter_clear(&filter);
 } END_TEST
 
+/* Test Case "not-ofType-Operator" Description:
+ Phase 1:
+  Action -> Fire default "EventType_C_Layer_2" Event
+  Filters: Where (not (ofType EventType_B_Layer_1))
+  Expect: No Notification (subtype of EventType_B_Layer_1)
+ Phase 2:
+  Action -> Fire default "EventType_A_Layer_1" Event
+  Filters: Where (not (ofType EventType_B_Layer_1))
+  Expect: Get Notification
+*/
+START_TEST(notOfTypeOperatorValidation) {
+    /* setup event filter */
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    setupSelectClauses();
+    filter.selectClauses = selectClauses;
+    filter.selectClausesSize = defaultSlectClauseSize;
+    setupContentFilter(&filter.whereClause, 2);
+    setupNotFilter(&filter.whereClause.elements[0]);
+    UA_UInt32 index = 1;
+    setupElementOperand(&filter.whereClause.elements[0], 1, &index);
+    setupOfTypeFilter(&filter.whereClause.elements[1]);
+    UA_Variant literalContent;
+    UA_NodeId *nodeId = UA_NodeId_new();
+    *nodeId = EventType_B_Layer_1;
+    UA_Variant_setScalar(&literalContent, nodeId, &UA_TYPES[UA_TYPES_NODEID]);
+    setupLiteralOperand(&filter.whereClause.elements[1], 1, &literalContent);
+    /*  add a monitored item (with filter) */
+    UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_simple, &filter, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+    /*  trigger the event */
+    eventType = EventType_C_Layer_2;
+    UA_NodeId eventNodeId;
+    UA_StatusCode retval = eventSetup(&eventNodeId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = triggerEventLocked(eventNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER), NULL, UA_TRUE);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    checkForEvent(&createResult, false);
+    /*  trigger the event */
+    eventType = EventType_A_Layer_1;
+    eventSetup(&eventNodeId);
+    retval = triggerEventLocked(eventNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER), NULL, UA_TRUE);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    checkForEvent(&createResult, true);
+    deleteMonitoredItems();
+    UA_EventFilter_clear(&filter);
+} END_TEST
+
 START_TEST(ofTypeOperatorValidation_failure) {
     /* setup event filter */
     UA_EventFilter filter;
@@ -845,6 +894,7 @@ static Suite *testSuite_Client(void) {
     tcase_add_test(tc_server, selectFilterValidation);
     tcase_add_test(tc_server, notOperatorValidation);
     tcase_add_test(tc_server, ofTypeOperatorValidation);
+    tcase_add_test(tc_server, notOfTypeOperatorValidation);
     tcase_add_test(tc_server, ofTypeOperatorValidation_failure);
     tcase_add_test(tc_server, orTypeOperatorValidation);
     tcase_add_test(tc_server, andTypeOperatorValidation);
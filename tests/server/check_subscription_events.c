@@ -390,6 +390,51 @@ START_TEST(generateEvents) {
     UA_DeleteMonitoredItemsResponse_clear(&deleteResponse);
 } END_TEST
 
+/* Transient events are resolved from the map of fields without a node */
+START_TEST(generateTransientEvents) {
+    UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_simple, true, true);
+    ck_assert_uint_eq(createResult.statusCode, UA_STATUSCODE_GOOD);
+    monitoredItemId = createResult.monitoredItemId;
+
+    UA_UInt16 eventSeverity = 1000;
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en-US", "Generated Event");
+    UA_KeyValuePair fields[2];
+    fields[0].key = UA_QUALIFIEDNAME(0, "Severity");
+    UA_Variant_setScalar(&fields[0].value, &eventSeverity, &UA_TYPES[UA_TYPES_UINT16]);
+    fields[1].key = UA_QUALIFIEDNAME(0, "Message");
+    UA_Variant_setScalar(&fields[1].value, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_KeyValueMap eventFields = {2, fields};
+
+    UA_ByteString eventId = UA_BYTESTRING_NULL;
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_triggerEventFields(server, eventType, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                     &eventFields, &eventId);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(eventId.length, 16);
+    UA_ByteString_clear(&eventId);
+
+    notificationReceived = false;
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert_uint_eq(notificationReceived, true);
+
+    /* Only subtypes of BaseEventType can be triggered */
+    serverMutexLock();
+    retval = UA_Server_triggerEventFields(server, UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                          UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                          &eventFields, NULL);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_BADINVALIDARGUMENT);
+
+    retval = UA_Client_MonitoredItems_deleteSingle(client, subscriptionId, monitoredItemId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+} END_TEST
+
 static bool hasBaseModelChangeEventType(void) {
 
     UA_QualifiedName readBrowsename;
@@ -632,6 +677,187 @@ START_TEST(multipleMonitoredItemsOneNode) {
     }
 } END_TEST
 
+static void
+handler_events_count(UA_Client *lclient, UA_UInt32 subId, void *subContext,
+                     UA_UInt32 monId, void *monContext,
+                     size_t nEventFields, UA_Variant *eventFields) {
+    ck_assert_uint_eq(nEventFields, nSelectClauses);
+    ck_assert(UA_Variant_hasScalarType(&eventFields[2], &UA_TYPES[UA_TYPES_NODEID]));
+    ck_assert(UA_NodeId_equal((UA_NodeId*)eventFields[2].data, &eventType));
+    (*(size_t*)monContext)++;
+}
+
+/* Several MonitoredItems with a where-clause receive the same event. The event
+ * fields are resolved once and shared between them. */
+START_TEST(multipleMonitoredItemsWhereClause) {
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+
+    /* OfType where-clause */
+    UA_NodeId ofTypeId;
+    UA_LiteralOperand literal;
+    UA_LiteralOperand_init(&literal);
+    UA_Variant_setScalar(&literal.value, &ofTypeId, &UA_TYPES[UA_TYPES_NODEID]);
+    UA_ExtensionObject operand;
+    UA_ExtensionObject_setValue(&operand, &literal, &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    UA_ContentFilterElement element;
+    UA_ContentFilterElement_init(&element);
+    element.filterOperator = UA_FILTEROPERATOR_OFTYPE;
+    element.filterOperandsSize = 1;
+    element.filterOperands = &operand;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClauses = selectClauses;
+    filter.selectClausesSize = nSelectClauses;
+    filter.whereClause.elementsSize = 1;
+    filter.whereClause.elements = &element;
+
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 1;
+    item.requestedParameters.discardOldest = true;
+
+    /* The last MonitoredItem filters for a different EventType */
+    UA_NodeId otherEventType;
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "OtherEventType");
+    serverMutexLock();
+    UA_StatusCode retval =
+        UA_Server_addObjectTypeNode(server, UA_NODEID_NULL,
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+                                    UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                    UA_QUALIFIEDNAME(0, "OtherEventType"),
+                                    attr, NULL, &otherEventType);
+    serverMutexUnlock();
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    size_t counter[4] = {0};
+    UA_UInt32 monIds[4];
+    for(size_t i = 0; i < 4; i++) {
+        ofTypeId = (i < 3) ? eventType : otherEventType;
+        UA_MonitoredItemCreateResult result =
+            UA_Client_MonitoredItems_createEvent(client, subscriptionId,
+                                                 UA_TIMESTAMPSTORETURN_BOTH, item,
+                                                 &counter[i], handler_events_count, NULL);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        monIds[i] = result.monitoredItemId;
+    }
+
+    UA_NodeId eventNodeId;
+    retval = eventSetup(&eventNodeId);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    retval = triggerEventLocked(eventNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                NULL, UA_TRUE);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 3; i++)
+        ck_assert_uint_eq(counter[i], 1);
+    ck_assert_uint_eq(counter[3], 0);
+
+    for(size_t i = 0; i < 4; i++) {
+        retval = UA_Client_MonitoredItems_deleteSingle(client, subscriptionId, monIds[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+} END_TEST
+
+static void
+handler_events_shared(UA_Client *lclient, UA_UInt32 subId, void *subContext,
+                      UA_UInt32 monId, void *monContext,
+                      size_t nEventFields, UA_Variant *eventFields) {
+    ck_assert_uint_eq(nEventFields, nSelectClauses);
+    size_t found = 0;
+    for(size_t i = 0; i < nEventFields; i++) {
+        if(UA_Variant_hasScalarType(&eventFields[i], &UA_TYPES[UA_TYPES_UINT16])) {
+            ck_assert_uint_eq(*(UA_UInt16*)eventFields[i].data, 1000);
+            found++;
+        } else if(UA_Variant_hasScalarType(&eventFields[i], &UA_TYPES[UA_TYPES_LOCALIZEDTEXT])) {
+            UA_String text = UA_STRING("Generated Event");
+            ck_assert(UA_String_equal(&((UA_LocalizedText*)eventFields[i].data)->text, &text));
+            found++;
+        } else if(UA_Variant_hasScalarType(&eventFields[i], &UA_TYPES[UA_TYPES_NODEID])) {
+            UA_NodeId serverId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+            UA_NodeId *id = (UA_NodeId*)eventFields[i].data;
+            ck_assert(UA_NodeId_equal(id, &eventType) || UA_NodeId_equal(id, &serverId));
+            found++;
+        }
+    }
+    ck_assert_uint_eq(found, nSelectClauses);
+    (*(size_t*)monContext)++;
+}
+
+/* MonitoredItems with overlapping select-clauses (in a different order) share
+ * the resolved event fields. Every notification gets the correct values. */
+START_TEST(multipleMonitoredItemsSharedFields) {
+    UA_SimpleAttributeOperand reversed[4];
+    ck_assert_uint_eq(nSelectClauses, 4);
+    for(size_t i = 0; i < nSelectClauses; i++)
+        reversed[i] = selectClauses[nSelectClauses - 1 - i];
+
+    UA_MonitoredItemCreateRequest item;
+    UA_MonitoredItemCreateRequest_init(&item);
+    item.itemToMonitor.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    item.itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+    item.monitoringMode = UA_MONITORINGMODE_REPORTING;
+
+    UA_EventFilter filter;
+    UA_EventFilter_init(&filter);
+    filter.selectClausesSize = nSelectClauses;
+
+    item.requestedParameters.filter.encoding = UA_EXTENSIONOBJECT_DECODED;
+    item.requestedParameters.filter.content.decoded.data = &filter;
+    item.requestedParameters.filter.content.decoded.type = &UA_TYPES[UA_TYPES_EVENTFILTER];
+    item.requestedParameters.queueSize = 2;
+    item.requestedParameters.discardOldest = true;
+
+    size_t counter[4] = {0};
+    UA_UInt32 monIds[4];
+    for(size_t i = 0; i < 4; i++) {
+        filter.selectClauses = (i % 2 == 0) ? selectClauses : reversed;
+        UA_MonitoredItemCreateResult result =
+            UA_Client_MonitoredItems_createEvent(client, subscriptionId,
+                                                 UA_TIMESTAMPSTORETURN_BOTH, item,
+                                                 &counter[i], handler_events_shared, NULL);
+        ck_assert_uint_eq(result.statusCode, UA_STATUSCODE_GOOD);
+        monIds[i] = result.monitoredItemId;
+    }
+
+    /* Two events end up in the same NotificationMessage */
+    UA_StatusCode retval;
+    for(size_t i = 0; i < 2; i++) {
+        UA_NodeId eventNodeId;
+        retval = eventSetup(&eventNodeId);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+        retval = triggerEventLocked(eventNodeId, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                    NULL, UA_TRUE);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+
+    sleepUntilAnswer(publishingInterval + 100);
+    retval = UA_Client_run_iterate(client, 0);
+    sleepUntilAnswer(publishingInterval + 100);
+    retval |= UA_Client_run_iterate(client, 0);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    for(size_t i = 0; i < 4; i++)
+        ck_assert_uint_eq(counter[i], 2);
+
+    for(size_t i = 0; i < 4; i++) {
+        retval = UA_Client_MonitoredItems_deleteSingle(client, subscriptionId, monIds[i]);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+} END_TEST
+
 START_TEST(discardNewestOverflow) {
     // add a monitored item
     UA_MonitoredItemCreateResult createResult = addMonitoredItem(handler_events_overflow, true, false);
@@ -919,12 +1145,15 @@ static Suite *testSuite_Client(void) {
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEventEmptyFilter);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, generateTransientEvents);
     tcase_add_test(tc_server, createAbstractEvent);
     tcase_add_test(tc_server, createAbstractEventWithParent);
     tcase_add_test(tc_server, createNonAbstractEventWithParent);
     tcase_add_test(tc_server, uppropagation);
     tcase_add_test(tc_server, eventOverflow);
     tcase_add_test(tc_server, multipleMonitoredItemsOneNode);
+    tcase_add_test(tc_server, multipleMonitoredItemsWhereClause);
+    tcase_add_test(tc_server, multipleMonitoredItemsSharedFields);
     tcase_add_test(tc_server, discardNewestOverflow);
     tcase_add_test(tc_server, eventStressing);
     tcase_add_test(tc_server, evaluateFilterWhereClause);
@@ -11,6 +11,7 @@
 #include <check.h>
 
 #include "test_helpers.h"
+#include "testing_clock.h"
 
 static UA_Server *server;
 static UA_NodeId eventType;
@@ -117,11 +118,156 @@ START_TEST(generateEvents) {
     ck_assert_uint_eq(callbackCount, 3);
 } END_TEST
 
+static unsigned modelChangeCount;
+static UA_NodeId lastEventType;
+static size_t lastChangesSize;
+
+static void
+modelChangeCallback(UA_Server *server, UA_UInt32 monitoredItemId,
+                    void *monitoredItemContext, const UA_KeyValueMap eventFields) {
+    modelChangeCount++;
+    ck_assert_uint_eq(eventFields.mapSize, 2);
+    ck_assert(UA_Variant_hasScalarType(&eventFields.map[0].value,
+                                       &UA_TYPES[UA_TYPES_NODEID]));
+    lastEventType = *(UA_NodeId*)eventFields.map[0].value.data;
+    lastChangesSize = eventFields.map[1].value.arrayLength;
+}
+
+/* The ModelChangeEvent types are not part of the reduced namespace zero */
+static void
+addModelChangeEventTypes(void) {
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.isAbstract = true;
+    UA_Server_addObjectTypeNode(server,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                UA_QUALIFIEDNAME(0, "BaseModelChangeEventType"),
+                                attr, NULL, NULL);
+    UA_Server_addObjectTypeNode(server,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_GENERALMODELCHANGEEVENTTYPE),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_HASSUBTYPE),
+                                UA_QUALIFIEDNAME(0, "GeneralModelChangeEventType"),
+                                attr, NULL, NULL);
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_Server_addVariableNode(server,
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_GENERALMODELCHANGEEVENTTYPE_CHANGES),
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_GENERALMODELCHANGEEVENTTYPE),
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                              UA_QUALIFIEDNAME(0, "Changes"),
+                              UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                              vAttr, NULL, NULL);
+}
+
+/* Node changes are collected and emitted in a single GeneralModelChangeEvent */
+START_TEST(modelChangeEvents) {
+    addModelChangeEventTypes();
+    UA_ServerConfig *config = UA_Server_getConfig(server);
+    config->modelChangeEventInterval = 100.0;
+
+    /* Parent object with a NodeVersion */
+    UA_NodeId parentId = UA_NODEID_STRING(1, "ModelChangeParent");
+    UA_ObjectAttributes oAttr = UA_ObjectAttributes_default;
+    UA_StatusCode retval =
+        UA_Server_addObjectNode(server, parentId,
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                UA_QUALIFIEDNAME(1, "ModelChangeParent"),
+                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                oAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+    UA_String version = UA_STRING("1");
+    UA_Variant_setScalar(&vAttr.value, &version, &UA_TYPES[UA_TYPES_STRING]);
+    retval = UA_Server_addVariableNode(server, UA_NODEID_STRING(1, "ModelChangeVersion"),
+                                       parentId, UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+                                       UA_QUALIFIEDNAME(0, "NodeVersion"),
+                                       UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+                                       vAttr, NULL, NULL);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Wait for the event of the setup. Then reset the NodeVersion. */
+    UA_fakeSleep(200);
+    UA_Server_run_iterate(server, false);
+    retval = UA_Server_writeObjectProperty_scalar(server, parentId,
+                                                  UA_QUALIFIEDNAME(0, "NodeVersion"),
+                                                  &version, &UA_TYPES[UA_TYPES_STRING]);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    UA_EventFilter ef;
+    UA_EventFilter_init(&ef);
+    ef.selectClauses = (UA_SimpleAttributeOperand *)
+            UA_Array_new(2, &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    ef.selectClausesSize = 2;
+    UA_SimpleAttributeOperand_parse(&ef.selectClauses[0], UA_STRING("/EventType"));
+    UA_SimpleAttributeOperand_parse(&ef.selectClauses[1], UA_STRING("/Changes"));
+    UA_MonitoredItemCreateResult res =
+        UA_Server_createEventMonitoredItem(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                                           ef, NULL, modelChangeCallback);
+    ck_assert_uint_eq(res.statusCode, UA_STATUSCODE_GOOD);
+    UA_EventFilter_clear(&ef);
+
+    /* Add many nodes */
+    for(UA_UInt32 i = 0; i < 20; i++) {
+        retval = UA_Server_addObjectNode(server, UA_NODEID_NUMERIC(1, 5000 + i), parentId,
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+                                         UA_QUALIFIEDNAME(1, "Child"),
+                                         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+                                         oAttr, NULL, NULL);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    retval = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 5000), true);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+
+    /* Nothing is emitted before the end of the interval */
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(modelChangeCount, 0);
+
+    /* One event with one entry per affected node. The children, the parent and
+     * the type with the inverse HasTypeDefinition references. */
+    UA_fakeSleep(150);
+    UA_Server_run_iterate(server, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(modelChangeCount, 1);
+    UA_NodeId generalType = UA_NODEID_NUMERIC(0, UA_NS0ID_GENERALMODELCHANGEEVENTTYPE);
+    ck_assert(UA_NodeId_equal(&lastEventType, &generalType));
+    ck_assert_uint_eq(lastChangesSize, 22);
+
+    /* The NodeVersion of the parent was incremented once */
+    UA_Variant v;
+    retval = UA_Server_readObjectProperty(server, parentId,
+                                          UA_QUALIFIEDNAME(0, "NodeVersion"), &v);
+    ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    ck_assert(UA_Variant_hasScalarType(&v, &UA_TYPES[UA_TYPES_STRING]));
+    UA_String expected = UA_STRING("2");
+    ck_assert(UA_String_equal((UA_String*)v.data, &expected));
+    UA_Variant_clear(&v);
+
+    /* Too many changes for the list */
+    config->maxModelChangesPerEvent = 5;
+    for(UA_UInt32 i = 1; i < 20; i++) {
+        retval = UA_Server_deleteNode(server, UA_NODEID_NUMERIC(1, 5000 + i), true);
+        ck_assert_uint_eq(retval, UA_STATUSCODE_GOOD);
+    }
+    UA_fakeSleep(150);
+    UA_Server_run_iterate(server, false);
+    UA_Server_run_iterate(server, false);
+    ck_assert_uint_eq(modelChangeCount, 2);
+    UA_NodeId baseType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEMODELCHANGEEVENTTYPE);
+    ck_assert(UA_NodeId_equal(&lastEventType, &baseType));
+    ck_assert_uint_eq(lastChangesSize, 0);
+
+    UA_Server_deleteMonitoredItem(server, res.monitoredItemId);
+    config->modelChangeEventInterval = 0.0;
+} END_TEST
+
 static Suite *testSuite_event(void) {
     Suite *s = suite_create("Server Local Subscription Events");
     TCase *tc_server = tcase_create("Server Local Subscription Events");
     tcase_add_unchecked_fixture(tc_server, setup, teardown);
     tcase_add_test(tc_server, generateEvents);
+    tcase_add_test(tc_server, modelChangeEvents);
     suite_add_tcase(s, tc_server);
     return s;
 }
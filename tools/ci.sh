@@ -17,7 +17,9 @@ else
 fi
 
 # Allow to reuse TIME-WAIT sockets for new connections
-sudo echo 1 > /proc/sys/net/ipv4/tcp_tw_reuse
+if [ -e /proc/sys/net/ipv4/tcp_tw_reuse ]; then
+    sudo echo 1 > /proc/sys/net/ipv4/tcp_tw_reuse
+fi
 
 ###########
 # cpplint #
@@ -125,6 +127,23 @@ function build_amalgamation_mt {
     make ${MAKEOPTS}
 }
 
+#####################################
+# Cross-Compile for Windows (MinGW) #
+#####################################
+
+# Compiles the winsock code paths (select backend of the EventLoop). The unit
+# tests run on Windows in the Azure pipelines.
+function build_win_mingw {
+    mkdir -p build; cd build; rm -rf *
+    cmake -DCMAKE_TOOLCHAIN_FILE=../tools/cmake/Toolchain-mingw64.cmake \
+          -DCMAKE_BUILD_TYPE=Debug \
+          -DUA_ENABLE_SUBSCRIPTIONS_EVENTS=ON \
+          -DUA_MULTITHREADING=100 \
+          -DUA_BUILD_EXAMPLES=ON \
+          ..
+    make ${MAKEOPTS}
+}
+
 ############################
 # Build and Run Unit Tests #
 ############################
@@ -223,6 +242,35 @@ function unit_tests_mt {
     make test ARGS="-V"
 }
 
+# The EventLoop uses kqueue on macOS and the BSDs. Build everything and run the
+# EventLoop tests there.
+function unit_tests_kqueue {
+    mkdir -p build; cd build; rm -rf *
+    cmake -DCMAKE_BUILD_TYPE=Debug \
+          -DUA_MULTITHREADING=100 \
+          -DUA_BUILD_EXAMPLES=ON \
+          -DUA_BUILD_UNIT_TESTS=ON \
+          -DUA_ENABLE_SUBSCRIPTIONS_EVENTS=ON \
+          -DUA_FORCE_WERROR=ON \
+          ..
+    make ${MAKEOPTS}
+    ctest -V -R check_eventloop
+}
+
+function unit_tests_multicast {
+    mkdir -p build; cd build; rm -rf *
+    cmake -DCMAKE_BUILD_TYPE=Debug \
+          -DUA_BUILD_EXAMPLES=ON \
+          -DUA_BUILD_UNIT_TESTS=ON \
+          -DUA_ENABLE_DISCOVERY_MULTICAST=ON \
+          -DUA_ENABLE_ENCRYPTION=OPENSSL \
+          -DUA_FORCE_WERROR=ON \
+          ..
+    make ${MAKEOPTS}
+    set_capabilities
+    make test ARGS="-V"
+}
+
 function unit_tests_alarms {
     mkdir -p build; cd build; rm -rf *
     cmake -DCMAKE_BUILD_TYPE=Debug \
@@ -272,6 +272,8 @@ endfunction()
 #
 #   [INTERNAL]      Optional argument. If given, then the generated node set code will use internal headers.
 #   [AUTOLOAD]      Optional argument. If given, the nodeset is automatically attached to the server.
+#   [TABLES]        Optional argument. If given, the nodes are generated as constant tables that are
+#                   loaded with UA_Server_loadNodesetTable instead of one function per node.
 #
 #   Arguments taking one value:
 #
@@ -295,7 +297,7 @@ endfunction()
 #
 function(ua_generate_nodeset)
 
-    set(options INTERNAL AUTOLOAD)
+    set(options INTERNAL AUTOLOAD TABLES)
     set(oneValueArgs NAME TYPES_ARRAY OUTPUT_DIR IGNORE TARGET_PREFIX BLACKLIST FILES_BSD)
     set(multiValueArgs FILE DEPENDS_TYPES DEPENDS_NS DEPENDS_TARGET)
     cmake_parse_arguments(UA_GEN_NS "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
@@ -349,6 +351,11 @@ function(ua_generate_nodeset)
         set(GEN_INTERNAL_HEADERS "--internal-headers")
     endif()
 
+    set(GEN_BACKEND "")
+    if (UA_GEN_NS_TABLES)
+        set(GEN_BACKEND "--backend=open62541_tables")
+    endif()
+
     set(GEN_NS0 "")
     set(TARGET_SUFFIX "ns-${UA_GEN_NS_NAME}")
     set(FILE_SUFFIX "_${UA_GEN_NS_NAME}_generated")
@@ -396,6 +403,7 @@ function(ua_generate_nodeset)
                        PRE_BUILD
                        COMMAND ${Python3_EXECUTABLE} ${open62541_TOOLS_DIR}/nodeset_compiler/nodeset_compiler.py
                        ${GEN_INTERNAL_HEADERS}
+                       ${GEN_BACKEND}
                        ${GEN_NS0}
                        ${GEN_BIN_SIZE}
                        ${GEN_IGNORE}
@@ -413,6 +421,7 @@ function(ua_generate_nodeset)
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541.py
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_nodes.py
                        ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_datatypes.py
+                       ${open62541_TOOLS_DIR}/nodeset_compiler/backend_open62541_tables.py
                        ${UA_GEN_NS_FILE}
                        ${UA_GEN_NS_DEPENDS_NS}
                        ${GEN_BLACKLIST_DEPENDS}
@@ -508,6 +517,7 @@ endfunction()
 #
 #   INTERNAL        Include internal headers. Required if custom datatypes are added.
 #   [AUTOLOAD]      Optional argument. If given, the nodeset is automatically attached to the server.
+#   [TABLES]        Optional argument. Generate the nodes as constant tables (see ua_generate_nodeset).
 #
 #   Arguments taking one value:
 #
@@ -536,7 +546,7 @@ endfunction()
 #
 function(ua_generate_nodeset_and_datatypes)
 
-    set(options INTERNAL AUTOLOAD)
+    set(options INTERNAL AUTOLOAD TABLES)
     set(oneValueArgs NAME FILE_NS FILE_CSV FILE_BSD OUTPUT_DIR TARGET_PREFIX BLACKLIST)
     set(multiValueArgs DEPENDS IMPORT_BSD)
     cmake_parse_arguments(UA_GEN "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
@@ -692,6 +702,11 @@ function(ua_generate_nodeset_and_datatypes)
         set(NODESET_INTERNAL "INTERNAL")
     endif()
 
+    set(NODESET_TABLES "")
+    if (${UA_GEN_TABLES})
+        set(NODESET_TABLES "TABLES")
+    endif()
+
     ua_generate_nodeset(
         NAME "${UA_GEN_NAME}"
         FILE "${UA_GEN_FILE_NS}"
@@ -700,6 +715,7 @@ function(ua_generate_nodeset_and_datatypes)
         FILES_BSD "${UA_GEN_FILE_BSD}"
         ${NODESET_INTERNAL}
         ${NODESET_AUTOLOAD}
+        ${NODESET_TABLES}
         DEPENDS_TYPES ${TYPES_DEPENDS}
         DEPENDS_NS ${NODESET_DEPENDS}
         DEPENDS_TARGET ${NODESET_DEPENDS_TARGET}
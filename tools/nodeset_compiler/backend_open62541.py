@@ -123,18 +123,16 @@ def sortNodes(nodeset):
 # Generate C Code #
 ###################
 
-def generateOpen62541Code(nodeset, outfilename, internal_headers=False, typesArray=[]):
+# The header and the setup of the namespaces and custom types are shared with
+# the tables backend
+
+def generateHeader(outfilename, internal_headers=False, typesArray=[]):
     outfilebase = basename(outfilename)
-    # Printing functions
     outfileh = codecs.open(outfilename + ".h", r"w+", encoding='utf-8')
-    outfilec = StringIO()
 
     def writeh(line):
         print(unicode(line), end='\n', file=outfileh)
 
-    def writec(line):
-        print(unicode(line), end='\n', file=outfilec)
-
     additionalHeaders = ""
     if len(typesArray) > 0:
         for arr in typesArray:
@@ -207,6 +205,60 @@ _UA_END_DECLS
 
 #endif /* %s_H_ */""" % \
            (outfilebase, outfilebase.upper()))
+    outfileh.flush()
+    os.fsync(outfileh)
+    outfileh.close()
+
+def generateCustomTypesCode(typesArray, writec):
+    for arr in typesArray:
+        if arr == "UA_TYPES":
+            continue
+        writec("\nstatic UA_DataTypeArray custom" + arr + " = {")
+        writec("    NULL,")
+        writec("    " + arr + "_COUNT,")
+        writec("    " + arr + ",")
+        writec("    UA_FALSE\n};")
+
+def generateNamespaceCode(nodeset, typesArray, writec):
+    # Generate namespaces (don't worry about duplicates)
+    writec("/* Use namespace ids generated by the server */")
+    writec("UA_UInt16 ns[" + str(len(nodeset.namespaces)) + "];")
+    for i, nsid in enumerate(nodeset.namespaces):
+        nsid = nsid.replace("\"", "\\\"")
+        writec("ns[" + str(i) + "] = UA_Server_addNamespace(server, \"" + nsid + "\");")
+
+    # Change namespaceIndex from the current namespace,
+    # but only if it defines its own data types, otherwise it is not necessary.
+    if len(typesArray) > 0:
+        typeArr = typesArray[-1]
+        if typeArr != "UA_TYPES" and typeArr != "ns0":
+            writec("/* Change namespaceIndex from current namespace */")
+            writec("#if " + typeArr + "_COUNT" + " > 0")
+            writec("for(int i = 0; i < " + typeArr + "_COUNT" + "; i++) {")
+            writec(typeArr + "[i]" + ".typeId.namespaceIndex = ns[" + str(nodeset.namespaceMapping[1]) + "];")
+            writec(typeArr + "[i]" + ".binaryEncodingId.namespaceIndex = ns[" + str(nodeset.namespaceMapping[1]) + "];")
+            writec("}")
+            writec("#endif")
+
+    # Add generated types to the server
+    writec("\n/* Load custom datatype definitions into the server */")
+    for arr in typesArray:
+        if arr == "UA_TYPES":
+            continue
+        writec("if(" + arr + "_COUNT > 0) {")
+        writec("custom" + arr + ".next = UA_Server_getConfig(server)->customDataTypes;")
+        writec("UA_Server_getConfig(server)->customDataTypes = &custom" + arr + ";\n")
+        writec("}")
+
+def generateOpen62541Code(nodeset, outfilename, internal_headers=False, typesArray=[]):
+    outfilebase = basename(outfilename)
+    generateHeader(outfilename, internal_headers, typesArray)
+
+    # Printing functions
+    outfilec = StringIO()
+
+    def writec(line):
+        print(unicode(line), end='\n', file=outfilec)
 
     writec("""/* WARNING: This is a generated file.
  * Any manual changes will be overwritten. */
@@ -286,48 +338,13 @@ _UA_END_DECLS
 
 
     # Load generated types
-    for arr in typesArray:
-        if arr == "UA_TYPES":
-            continue
-        writec("\nstatic UA_DataTypeArray custom" + arr + " = {")
-        writec("    NULL,")
-        writec("    " + arr + "_COUNT,")
-        writec("    " + arr + ",")
-        writec("    UA_FALSE\n};")
+    generateCustomTypesCode(typesArray, writec)
 
     writec("""
 UA_StatusCode %s(UA_Server *server) {
 UA_StatusCode retVal = UA_STATUSCODE_GOOD;""" % (outfilebase))
 
-    # Generate namespaces (don't worry about duplicates)
-    writec("/* Use namespace ids generated by the server */")
-    writec("UA_UInt16 ns[" + str(len(nodeset.namespaces)) + "];")
-    for i, nsid in enumerate(nodeset.namespaces):
-        nsid = nsid.replace("\"", "\\\"")
-        writec("ns[" + str(i) + "] = UA_Server_addNamespace(server, \"" + nsid + "\");")
-
-    # Change namespaceIndex from the current namespace,
-    # but only if it defines its own data types, otherwise it is not necessary.
-    if len(typesArray) > 0:
-        typeArr = typesArray[-1]
-        if typeArr != "UA_TYPES" and typeArr != "ns0":
-            writec("/* Change namespaceIndex from current namespace */")
-            writec("#if " + typeArr + "_COUNT" + " > 0")
-            writec("for(int i = 0; i < " + typeArr + "_COUNT" + "; i++) {")
-            writec(typeArr + "[i]" + ".typeId.namespaceIndex = ns[" + str(nodeset.namespaceMapping[1]) + "];")
-            writec(typeArr + "[i]" + ".binaryEncodingId.namespaceIndex = ns[" + str(nodeset.namespaceMapping[1]) + "];")
-            writec("}")
-            writec("#endif")
-
-    # Add generated types to the server
-    writec("\n/* Load custom datatype definitions into the server */")
-    for arr in typesArray:
-        if arr == "UA_TYPES":
-            continue
-        writec("if(" + arr + "_COUNT > 0) {")
-        writec("custom" + arr + ".next = UA_Server_getConfig(server)->customDataTypes;")
-        writec("UA_Server_getConfig(server)->customDataTypes = &custom" + arr + ";\n")
-        writec("}")
+    generateNamespaceCode(nodeset, typesArray, writec)
 
     if functionNumber > 0:
         for i in range(0, functionNumber):
@@ -344,9 +361,6 @@ UA_StatusCode retVal = UA_STATUSCODE_GOOD;""" % (outfilebase))
                    format(outfilebase=outfilebase, idx=str(i)))
 
     writec("return retVal;\n}")
-    outfileh.flush()
-    os.fsync(outfileh)
-    outfileh.close()
     fullCode = outfilec.getvalue()
     outfilec.close()
 
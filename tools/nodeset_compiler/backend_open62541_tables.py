@@ -0,0 +1,533 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+### This Source Code Form is subject to the terms of the Mozilla Public
+### License, v. 2.0. If a copy of the MPL was not distributed with this
+### file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+###    Copyright 2024 (c) Fraunhofer IOSB (Author: Julius Pfrommer)
+
+# Generates the nodeset as constant tables that are loaded with
+# UA_Server_loadNodesetTable. The node order, the attributes and the
+# references are the same as in the open62541 backend. But instead of one
+# function per node, the nodes are rows of a table. Values are stored in the
+# binary encoding of their DataType.
+
+from __future__ import print_function
+from os.path import basename
+import logging
+import codecs
+import datetime
+import os
+import struct
+try:
+    from StringIO import StringIO
+except ImportError:
+    from io import StringIO
+
+import sys
+if sys.version_info[0] >= 3:
+    # strings are already parsed to unicode
+    def unicode(s):
+        return s
+
+from datatypes import Value, ExtensionObject, Structure, StatusCode, DiagnosticInfo
+from nodes import ReferenceTypeNode, ObjectNode, VariableNode, VariableTypeNode, \
+    MethodNode, ObjectTypeNode, DataTypeNode, ViewNode
+from type_parser import EnumerationType, OpaqueType, StructType
+from backend_open62541 import sortNodes, generateHeader, generateCustomTypesCode, \
+    generateNamespaceCode
+from backend_open62541_nodes import setNodeDatatypeRecursive, setNodeValueRankRecursive, \
+    isArrayVariableNode, getTypeBrowseName, getTypesArrayForValue
+from backend_open62541_datatypes import makeCIdentifier, makeCLiteral, splitStringLiterals
+
+logger = logging.getLogger(__name__)
+
+##################
+# Binary Encoding #
+##################
+
+class EncodingError(Exception):
+    pass
+
+numericFormats = {"Boolean": "<?", "SByte": "<b", "Byte": "<B", "Int16": "<h",
+                  "UInt16": "<H", "Int32": "<i", "UInt32": "<I", "Int64": "<q",
+                  "UInt64": "<Q", "Float": "<f", "Double": "<d", "StatusCode": "<I"}
+
+def encodeString(s):
+    if s is None:
+        return struct.pack("<i", -1)
+    if not isinstance(s, bytes):
+        s = s.encode('utf-8')
+    return struct.pack("<i", len(s)) + s
+
+def encodeNumber(typeName, value):
+    fmt = numericFormats[typeName]
+    if value is None:
+        value = 0
+    if typeName == "Boolean":
+        return struct.pack(fmt, str(value).lower() == "true")
+    if typeName in ["Float", "Double"]:
+        return struct.pack(fmt, float(value))
+    try:
+        return struct.pack(fmt, int(str(value)))
+    except ValueError:
+        return struct.pack(fmt, int(str(value), 0))
+
+def encodeNodeId(ns, i, s):
+    if s is not None:
+        return struct.pack("<BH", 3, ns) + encodeString(s)
+    if i is None:
+        i = 0
+    if ns == 0 and i < 256:
+        return struct.pack("<BB", 0, i)
+    if ns < 256 and i < 65536:
+        return struct.pack("<BBH", 1, ns, i)
+    return struct.pack("<BHI", 2, ns, i)
+
+def encodeDateTime(value):
+    if value is None:
+        return struct.pack("<q", 0)
+    epoch = datetime.datetime.utcfromtimestamp(0)
+    msecs = int((value - epoch).total_seconds() * 1000.0)
+    # 100 nanosecond intervals since 1601-01-01 (UA_DATETIME_UNIX_EPOCH)
+    return struct.pack("<q", msecs * 10000 + 11644473600 * 10000000)
+
+def encodeGuid(value):
+    if not value or len(value) != 5:
+        return bytes(16)
+    v = [int(str(x), 16) for x in value]
+    return struct.pack("<IHH", v[0], v[1], v[2]) + struct.pack(">HQ", v[3], v[4])[:8]
+
+# The value v is a Value object of the datatypes module or None for the
+# default (zero) value
+def encodeBuiltin(typeName, v):
+    if typeName == "CharArray":
+        typeName = "String"
+    if typeName in numericFormats:
+        return encodeNumber(typeName, None if v is None else v.value)
+    if typeName in ["String", "XmlElement"]:
+        return encodeString(None if v is None else v.value)
+    if typeName == "ByteString":
+        if v is None or not v.value:
+            return encodeString(None)
+        return encodeString(bytes(bytearray(v.value)))
+    if typeName == "LocalizedText":
+        if v is None or v.isNone():
+            return struct.pack("<B", 0)
+        # Always with locale and text, same as UA_LOCALIZEDTEXT("", text)
+        return struct.pack("<B", 0x03) + encodeString(v.locale or "") + \
+            encodeString(v.text or "")
+    if typeName == "NodeId":
+        if v is None or v.isNone():
+            return encodeNodeId(0, 0, None)
+        if v.i is None and v.s is None:
+            raise EncodingError("No encoding for bytestring and guid NodeIds")
+        return encodeNodeId(v.ns, v.i, v.s)
+    if typeName == "QualifiedName":
+        if v is None or v.isNone():
+            return struct.pack("<H", 0) + encodeString(None)
+        return struct.pack("<H", v.ns) + encodeString(v.name)
+    if typeName == "DateTime":
+        return encodeDateTime(None if v is None else v.value)
+    if typeName == "Guid":
+        return encodeGuid(None if v is None else v.value)
+    # The remaining builtin types are only encoded with their default value
+    if v is not None and not v.isNone():
+        raise EncodingError("No encoding for values of type " + typeName)
+    if typeName == "ExpandedNodeId":
+        return encodeNodeId(0, 0, None)
+    if typeName == "ExtensionObject":
+        return encodeNodeId(0, 0, None) + struct.pack("<B", 0)
+    if typeName in ["Variant", "DataValue", "DiagnosticInfo"]:
+        return struct.pack("<B", 0)
+    raise EncodingError("No encoding for values of type " + typeName)
+
+def memberTypeName(memberType):
+    if isinstance(memberType, OpaqueType):
+        base = memberType.base_type
+        return base if isinstance(base, str) else base.name
+    return memberType.name
+
+def encodeMember(member, v):
+    mt = member.member_type
+    if member.is_array:
+        if v is None:
+            return struct.pack("<i", -1)
+        # Arrays of structures are lists of member values
+        elements = v.value if isinstance(v, Structure) else v
+        if not elements:
+            return struct.pack("<i", -1)
+        out = struct.pack("<i", len(elements))
+        for e in elements:
+            if isinstance(mt, StructType):
+                out += encodeStructure(mt, e if isinstance(e, list) else [])
+            elif isinstance(mt, EnumerationType):
+                out += encodeBuiltin("Int32", e)
+            else:
+                out += encodeBuiltin(memberTypeName(mt), e)
+        return out
+    if isinstance(mt, StructType):
+        if isinstance(v, Structure):
+            return encodeStructure(mt, matchMembers(v))
+        return encodeStructure(mt, {})
+    if isinstance(mt, EnumerationType):
+        return encodeBuiltin("Int32", v)
+    return encodeBuiltin(memberTypeName(mt), v)
+
+# The parsed values are aligned with the encoding rules (the StructMembers).
+# Missing members are encoded with their default value.
+def matchMembers(v):
+    values = v.value if isinstance(v.value, list) else []
+    return {id(rule): val for rule, val in zip(v.encodingRule, values)}
+
+# The values are either a dict from id(StructMember) to the value, or a list
+# of values in the order of the members
+def encodeStructure(structType, values):
+    members = structType.members
+    if isinstance(values, list):
+        values = {id(m): val for m, val in zip(members, values)}
+
+    if structType.is_union:
+        for idx, m in enumerate(members):
+            if id(m) in values and values[id(m)] is not None:
+                return struct.pack("<I", idx + 1) + encodeMember(m, values[id(m)])
+        return struct.pack("<I", 0)
+
+    out = b""
+    optional = [m for m in members if m.is_optional]
+    if len(optional) > 0:
+        mask = 0
+        for idx, m in enumerate(optional):
+            if values.get(id(m)) is not None:
+                mask |= 1 << idx
+        out += struct.pack("<I", mask)
+    for m in members:
+        v = values.get(id(m))
+        if m.is_optional and v is None:
+            continue
+        out += encodeMember(m, v)
+    return out
+
+def findStructType(nodeset, dataTypeNode):
+    names = [dataTypeNode.displayName.text]
+    if dataTypeNode.symbolicName is not None and dataTypeNode.symbolicName.value is not None:
+        names.append(dataTypeNode.symbolicName.value)
+    for types in nodeset.parser.types.values():
+        for name in names:
+            t = types.get(name)
+            if isinstance(t, StructType):
+                return t
+    raise EncodingError("No structure definition for " + str(dataTypeNode.browseName))
+
+def typesArrayEntry(typesArray, typeName):
+    return "&" + typesArray + "[" + typesArray + "_" + typeName + "]"
+
+# Returns the C expression of the DataType, the array length (-1 for scalars)
+# and the encoded value. Or None if the value is not set. This follows the
+# value generation of the open62541 backend.
+def encodeNodeValue(node, nodeset):
+    value = node.value
+    if len(value.value) == 0 or not isinstance(value.value[0], Value):
+        return None
+    first = value.value[0]
+    if isinstance(first, DiagnosticInfo) or isinstance(first, StatusCode):
+        logger.warn("Don't know how to encode " + first.__class__.__name__ +
+                    " in node " + str(node.id))
+        return None
+
+    dataTypeNode = nodeset.getDataTypeNode(node.dataType)
+    if isArrayVariableNode(value, node):
+        typeExpr = typesArrayEntry(dataTypeNode.typesArray,
+                                   getTypeBrowseName(dataTypeNode).upper())
+        encoded = b""
+        for v in value.value:
+            if isinstance(v, ExtensionObject):
+                encoded += encodeStructure(findStructType(nodeset, dataTypeNode), matchMembers(v))
+            else:
+                encoded += encodeBuiltin(v.__class__.__name__, v)
+        return (typeExpr, len(value.value), encoded)
+
+    if isinstance(first, ExtensionObject):
+        typeName = dataTypeNode.browseName.name
+        if dataTypeNode.symbolicName is not None and dataTypeNode.symbolicName.value is not None:
+            typeName = dataTypeNode.symbolicName.value
+        if makeCIdentifier(typeName) == "NumericRange":
+            typeName = "String"
+        typeExpr = typesArrayEntry(dataTypeNode.typesArray, typeName.upper())
+        return (typeExpr, -1, encodeStructure(findStructType(nodeset, dataTypeNode),
+                                              matchMembers(first)))
+
+    if first.isNone():
+        return None
+    return (getTypesArrayForValue(nodeset, first), -1,
+            encodeBuiltin(first.__class__.__name__, first))
+
+##########
+# Tables #
+##########
+
+def generateStringCode(s):
+    if s is None:
+        return "NULL"
+    return splitStringLiterals(makeCLiteral(s))
+
+class NodesetTables(object):
+    def __init__(self, outfilebase):
+        self.outfilebase = outfilebase
+        self.nodeIds = [(0, 0, None)] # Index zero is the null NodeId
+        self.nodeIdIndex = {(0, 0, None): 0}
+        self.references = []
+        self.nodes = []
+        self.values = bytearray()
+        self.dimensions = []
+        self.dimensionsIndex = {}
+
+    def getNodeId(self, nodeId):
+        if nodeId is None or nodeId.isNone():
+            return 0
+        if nodeId.i is None and nodeId.s is None:
+            raise Exception(str(nodeId) + " no NodeID generation for bytestring and guid..")
+        key = (nodeId.ns, nodeId.i if nodeId.s is None else 0, nodeId.s)
+        if key not in self.nodeIdIndex:
+            self.nodeIdIndex[key] = len(self.nodeIds)
+            self.nodeIds.append(key)
+        return self.nodeIdIndex[key]
+
+    def getDimensions(self, dims):
+        if len(dims) == 0:
+            return "NULL"
+        key = tuple(dims)
+        if key not in self.dimensionsIndex:
+            self.dimensionsIndex[key] = len(self.dimensions)
+            self.dimensions.extend(dims)
+        return "&%s_arrayDimensions[%d]" % (self.outfilebase, self.dimensionsIndex[key])
+
+    def addValue(self, encoded):
+        offset = len(self.values)
+        self.values.extend(encoded)
+        return "&%s_values[%d]" % (self.outfilebase, offset)
+
+    def addReference(self, ref):
+        self.references.append("{%d, %d, %s}" % (self.getNodeId(ref.referenceType),
+                                                 self.getNodeId(ref.target),
+                                                 "true" if ref.isForward else "false"))
+
+# Returns the row of the node without the closing referencesSize. The
+# HasTypeDefinition reference is removed from the node.
+def generateNodeRow(node, nodeset, tables):
+    flags = []
+    eventNotifier = 0
+    accessLevel = 0
+    userAccessLevel = 0
+    dataType = 0
+    inverseName = None
+    minimumSamplingInterval = 0.0
+    valueRank = 0
+    dims = []
+    valueType = "NULL"
+    valueArrayLength = -1
+    valueSize = 0
+    valuePtr = "NULL"
+
+    if isinstance(node, MethodNode) or isinstance(node.parent, MethodNode):
+        flags.append("UA_NODESETTABLE_METHODCALLS")
+
+    if isinstance(node, ReferenceTypeNode):
+        if node.isAbstract:
+            flags.append("UA_NODESETTABLE_ISABSTRACT")
+        if node.symmetric:
+            flags.append("UA_NODESETTABLE_SYMMETRIC")
+        if node.inverseName != "":
+            inverseName = node.inverseName
+    elif isinstance(node, ObjectNode):
+        eventNotifier = node.eventNotifier & 0x0d
+    elif isinstance(node, VariableNode):
+        if isinstance(node, VariableTypeNode):
+            if node.isAbstract:
+                flags.append("UA_NODESETTABLE_ISABSTRACT")
+        else:
+            if node.historizing:
+                flags.append("UA_NODESETTABLE_HISTORIZING")
+            minimumSamplingInterval = node.minimumSamplingInterval
+            accessLevel = node.accessLevel
+            userAccessLevel = node.userAccessLevel
+
+        # Inherit the ValueRank and DataType (see generateCommonVariableCode)
+        if node.valueRank is None:
+            setNodeValueRankRecursive(node, nodeset)
+        valueRank = node.valueRank
+        if valueRank > 0:
+            if len(node.arrayDimensions) == valueRank:
+                dims = [int(unicode(v)) for v in node.arrayDimensions]
+            else:
+                dims = [0] * valueRank
+        if node.dataType is None:
+            setNodeDatatypeRecursive(node, nodeset)
+        dataType = tables.getNodeId(node.dataType)
+
+        dataTypeNode = nodeset.getBaseDataType(nodeset.getDataTypeNode(node.dataType))
+        if dataTypeNode is None:
+            raise RuntimeError("Cannot get BaseDataType for dataType : " + str(node.dataType) +
+                               " of node " + node.browseName.name + " " + str(node.id))
+        if dataTypeNode.isEncodable():
+            if node.value is not None:
+                try:
+                    encoded = encodeNodeValue(node, nodeset)
+                except EncodingError as e:
+                    logger.warn("Cannot encode the value of node " + str(node.id) + ": " + str(e))
+                    encoded = None
+                if encoded is not None:
+                    (valueType, valueArrayLength, data) = encoded
+                    valueSize = len(data)
+                    valuePtr = tables.addValue(data)
+                    # Multi-dimensional arrays only (see generateCommonVariableCode)
+                    if valueArrayLength > 0 and valueRank > 1 and \
+                       len(node.arrayDimensions) == valueRank and \
+                       0 not in dims and valueArrayLength == eval("*".join(str(d) for d in dims)):
+                        flags.append("UA_NODESETTABLE_VALUEDIMENSIONS")
+        elif node.value is not None:
+            logger.warn("Cannot encode dataTypeNode: " + dataTypeNode.browseName.name +
+                        " for value of node " + node.browseName.name + " " + str(node.id))
+    elif isinstance(node, MethodNode):
+        if node.executable:
+            flags.append("UA_NODESETTABLE_EXECUTABLE")
+        if node.userExecutable:
+            flags.append("UA_NODESETTABLE_USEREXECUTABLE")
+    elif isinstance(node, ObjectTypeNode) or isinstance(node, DataTypeNode):
+        if node.isAbstract:
+            flags.append("UA_NODESETTABLE_ISABSTRACT")
+    elif isinstance(node, ViewNode):
+        if node.containsNoLoops:
+            flags.append("UA_NODESETTABLE_CONTAINSNOLOOPS")
+        eventNotifier = int(node.eventNotifier)
+
+    typeDefinition = 0
+    if isinstance(node, VariableNode) or isinstance(node, ObjectNode):
+        typeDefinition = tables.getNodeId(node.popTypeDef().target)
+
+    displayName = (None, None)
+    if node.displayName is not None:
+        displayName = (node.displayName.locale or "", node.displayName.text or "")
+    description = "NULL, NULL"
+    if node.description is not None:
+        description = "%s_DESCRIPTION(%s, %s)" % \
+            (tables.outfilebase.upper(), generateStringCode(node.description.locale or ""),
+             generateStringCode(node.description.text or ""))
+
+    nodeClass = "UA_NODECLASS_" + makeCIdentifier(node.__class__.__name__.upper().replace("NODE", ""))
+    return "{%s, %s, %d, %d, %d,\n %d, %d, %d, %d, %d,\n %d, %s, %s, %s, %s, %s,\n %d, %d, %r, %d, %d, %s,\n %s, %d, %d, %s" % \
+        (nodeClass, " | ".join(flags) if flags else "0", eventNotifier, accessLevel, userAccessLevel,
+         tables.getNodeId(node.id),
+         tables.getNodeId(node.parent.id if node.parent else None),
+         tables.getNodeId(node.parentReference.id if node.parent else None),
+         typeDefinition, dataType,
+         node.browseName.ns, generateStringCode(node.browseName.name),
+         generateStringCode(displayName[0]), generateStringCode(displayName[1]),
+         description, generateStringCode(inverseName),
+         node.writeMask or 0, node.userWriteMask or 0,
+         float(minimumSamplingInterval), valueRank, len(dims), tables.getDimensions(dims),
+         valueType, valueArrayLength, valueSize, valuePtr)
+
+def generateOpen62541TablesCode(nodeset, outfilename, internal_headers=False, typesArray=[]):
+    outfilebase = basename(outfilename)
+    generateHeader(outfilename, internal_headers, typesArray)
+
+    outfilec = StringIO()
+
+    def writec(line):
+        print(unicode(line), end='\n', file=outfilec)
+
+    writec("""/* WARNING: This is a generated file.
+ * Any manual changes will be overwritten. */
+
+#include "%s.h"
+
+#ifdef UA_ENABLE_NODESET_COMPILER_DESCRIPTIONS
+# define %s_DESCRIPTION(locale, text) locale, text
+#else
+# define %s_DESCRIPTION(locale, text) NULL, NULL
+#endif
+""" % (outfilebase, outfilebase.upper(), outfilebase.upper()))
+
+    logger.info("Reordering nodes for minimal dependencies during printing")
+    sorted_nodes = sortNodes(nodeset)
+    logger.info("Writing tables for nodes and references")
+
+    tables = NodesetTables(outfilebase)
+    printed_ids = set()
+    for node in sorted_nodes:
+        printed_ids.add(node.id)
+        if node.hidden:
+            continue
+
+        row = generateNodeRow(node, nodeset, tables)
+        referencesBefore = len(tables.references)
+        for ref in node.references:
+            if ref.target not in printed_ids:
+                continue
+            if node.parent is not None and ref.target == node.parent.id \
+                and ref.referenceType == node.parentReference.id:
+                # Skip parent reference
+                continue
+            tables.addReference(ref)
+        referencesSize = len(tables.references) - referencesBefore
+        row += ", %d}" % referencesSize
+        tables.nodes.append("/* " + str(node.displayName).replace("*/", "* /") +
+                            " - " + str(node.id) + " */\n" + row)
+
+    # The data tables. Empty arrays are not allowed in C.
+    values = list(tables.values) if len(tables.values) > 0 else [0]
+    writec("static const UA_Byte %s_values[%d] = {" % (outfilebase, len(values)))
+    for i in range(0, len(values), 24):
+        writec(",".join(str(b) for b in values[i:i+24]) + ",")
+    writec("};\n")
+
+    dims = tables.dimensions if len(tables.dimensions) > 0 else [0]
+    writec("static const UA_UInt32 %s_arrayDimensions[%d] = {%s};\n" %
+           (outfilebase, len(dims), ", ".join(str(d) for d in dims)))
+
+    writec("static const UA_NodesetTableNodeId %s_nodeIds[%d] = {" % (outfilebase, len(tables.nodeIds)))
+    for (ns, i, s) in tables.nodeIds:
+        if s is None:
+            writec("{%d, %dLU, NULL}," % (ns, i))
+        else:
+            writec(u"{%d, 0, \"%s\"}," % (ns, makeCLiteral(s)))
+    writec("};\n")
+
+    refs = tables.references if len(tables.references) > 0 else ["{0, 0, false}"]
+    writec("static const UA_NodesetTableReference %s_references[%d] = {" % (outfilebase, len(refs)))
+    for r in refs:
+        writec(r + ",")
+    writec("};\n")
+
+    nodes = tables.nodes if len(tables.nodes) > 0 else \
+        ["{UA_NODECLASS_UNSPECIFIED, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, NULL, NULL, NULL, NULL, NULL, NULL, "
+         "0, 0, 0.0, 0, 0, NULL, NULL, -1, 0, NULL, 0}"]
+    writec("static const UA_NodesetTableNode %s_nodes[%d] = {" % (outfilebase, len(nodes)))
+    for n in nodes:
+        writec(n + ",")
+    writec("};\n")
+
+    writec("static const UA_NodesetTable %s_table = {" % outfilebase)
+    writec("    %d, %s_nodeIds," % (len(tables.nodeIds), outfilebase))
+    writec("    %d, %s_nodes," % (len(tables.nodes), outfilebase))
+    writec("    %d, %s_references\n};" % (len(tables.references), outfilebase))
+
+    # Load generated types
+    generateCustomTypesCode(typesArray, writec)
+
+    writec("""
+UA_StatusCode %s(UA_Server *server) {""" % (outfilebase))
+    generateNamespaceCode(nodeset, typesArray, writec)
+    writec("return UA_Server_loadNodesetTable(server, &%s_table, ns, %d);\n}" %
+           (outfilebase, len(nodeset.namespaces)))
+
+    fullCode = outfilec.getvalue()
+    outfilec.close()
+
+    outfilec = codecs.open(outfilename + ".c", r"w+", encoding='utf-8')
+    outfilec.write(fullCode)
+    outfilec.flush()
+    os.fsync(outfilec)
+    outfilec.close()
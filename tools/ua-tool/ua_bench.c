@@ -0,0 +1,793 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+/* Runs a workload against a server and prints the throughput, the latency
+ * percentiles and the allocations per operation as JSON. With "inproc" as the
+ * url, a server is started in the same process. The server and the clients are
+ * then iterated in turns from the same thread. Its processing time is part of
+ * the latency, its allocations are not counted. */
+
+#define INPROC_URL "opc.tcp://localhost:4840"
+
+static UA_Server *server = NULL;
+static const char *url = NULL;
+static const char *workload = NULL;
+
+/* Options */
+static size_t count = 0;     /* Number of requests (default per workload) */
+static size_t batch = 1;     /* Operations per request */
+static size_t inflight = 1;  /* Concurrent requests */
+static size_t clients = 10;  /* Concurrent connects */
+static size_t items = 100;   /* MonitoredItems */
+static UA_Double interval = 10.0; /* Publishing and sampling interval in ms */
+static UA_Double duration = 5.0;  /* Subscription duration in seconds */
+static UA_NodeId nodeidval = {0};
+
+static const UA_NodeId benchNodeId = {1, UA_NODEIDTYPE_STRING,
+                                      {.string = {5, (UA_Byte*)"bench"}}};
+
+static void
+usage(void) {
+    printf("Usage: ua_bench <server-url | inproc> <workload> [options]\n"
+           " <server-url>: opc.tcp://domain[:port]\n"
+           " inproc: Start a server in the same process on port 4840\n"
+           " <workload> -> read: Read the value of the node\n"
+           " <workload> -> write: Write the value of the node back to it\n"
+           " <workload> -> browse: Browse the references of the node\n"
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+           " <workload> -> subscribe: Receive data change notifications\n"
+#endif
+           " <workload> -> connect: Open SecureChannels and Sessions\n"
+           " --count <n>: Number of requests or connects [default: 10000 / 100]\n"
+           " --batch <n>: Nodes per Read, Write or Browse request [default: 1]\n"
+           " --inflight <n>: Concurrent requests [default: 1]\n"
+           " --nodeid <nodeid>: Node used by read, write and browse\n"
+           "   [default: ns=1;s=bench for inproc, i=2258 otherwise (i=85 for browse)]\n"
+           " --clients <n>: Concurrent connects [default: 10]\n"
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+           " --items <n>: MonitoredItems on the CurrentTime node [default: 100]\n"
+           " --interval <ms>: Publishing and sampling interval [default: 10]\n"
+           " --duration <s>: Duration of the subscription [default: 5]\n"
+#endif
+           " --help: Print this message\n");
+}
+
+/**************/
+/* Accounting */
+/**************/
+
+static size_t allocations = 0;
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+static UA_Boolean countAllocations = true;
+
+static void *
+countingMalloc(size_t size) {
+    if(countAllocations)
+        allocations++;
+    return malloc(size);
+}
+
+static void *
+countingCalloc(size_t nelem, size_t elsize) {
+    if(countAllocations)
+        allocations++;
+    return calloc(nelem, elsize);
+}
+
+static void *
+countingRealloc(void *ptr, size_t size) {
+    if(countAllocations)
+        allocations++;
+    return realloc(ptr, size);
+}
+#endif
+
+/* Latencies in DateTime units (100ns) */
+static UA_DateTime *latencies = NULL;
+static size_t latenciesSize = 0;
+static size_t latenciesCapacity = 0;
+static size_t operations = 0;
+static size_t errors = 0;
+
+static void
+recordLatency(UA_DateTime latency) {
+    if(latenciesSize == latenciesCapacity) {
+        size_t newCapacity = (latenciesCapacity == 0) ? 1024 : latenciesCapacity * 2;
+        UA_DateTime *l = (UA_DateTime*)
+            realloc(latencies, newCapacity * sizeof(UA_DateTime));
+        if(!l)
+            return;
+        latencies = l;
+        latenciesCapacity = newCapacity;
+    }
+    latencies[latenciesSize++] = latency;
+}
+
+static int
+compareLatency(const void *a, const void *b) {
+    UA_DateTime la = *(const UA_DateTime*)a;
+    UA_DateTime lb = *(const UA_DateTime*)b;
+    return (la > lb) - (la < lb);
+}
+
+static UA_Double
+percentile(UA_Double p) {
+    if(latenciesSize == 0)
+        return 0.0;
+    size_t pos = (size_t)(p * (UA_Double)(latenciesSize - 1) + 0.5);
+    return (UA_Double)latencies[pos] / UA_DATETIME_USEC;
+}
+
+static void
+printResult(UA_DateTime elapsed, size_t requests) {
+    qsort(latencies, latenciesSize, sizeof(UA_DateTime), compareLatency);
+    UA_Double seconds = (UA_Double)elapsed / UA_DATETIME_SEC;
+    printf("{\"workload\":\"%s\",\"server\":\"%s\",\"requests\":%lu,"
+           "\"operations\":%lu,\"errors\":%lu,\"batch\":%lu,\"inflight\":%lu,"
+           "\"durationMs\":%.3f,\"throughput\":%.1f,"
+           "\"latencyUs\":{\"p50\":%.1f,\"p99\":%.1f,\"p999\":%.1f,\"max\":%.1f}",
+           workload, server ? "inproc" : url, (unsigned long)requests,
+           (unsigned long)operations, (unsigned long)errors, (unsigned long)batch,
+           (unsigned long)inflight, seconds * 1000.0,
+           (seconds > 0.0) ? (UA_Double)operations / seconds : 0.0,
+           percentile(0.5), percentile(0.99), percentile(0.999), percentile(1.0));
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    printf(",\"allocsPerOp\":%.2f",
+           (operations > 0) ? (UA_Double)allocations / (UA_Double)operations : 0.0);
+#endif
+    printf("}\n");
+}
+
+/*************/
+/* Iteration */
+/*************/
+
+static UA_Client **clientList = NULL;
+static size_t clientListSize = 0;
+
+/* Process the network events of the in-process server and the clients */
+static void
+iterate(void) {
+    if(server) {
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        countAllocations = false;
+        UA_Server_run_iterate(server, false);
+        countAllocations = true;
+#else
+        UA_Server_run_iterate(server, false);
+#endif
+    }
+    for(size_t i = 0; i < clientListSize; i++) {
+        if(clientList[i])
+            UA_Client_run_iterate(clientList[i], server ? 0 : 1);
+    }
+}
+
+static UA_Client *
+newClient(void) {
+    UA_Client *client = UA_Client_new();
+    if(!client)
+        return NULL;
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    UA_ClientConfig_setDefault(cc);
+    cc->logging->context = (void*)(uintptr_t)UA_LOGLEVEL_WARNING;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    cc->outStandingPublishRequests = 0;
+#endif
+    return client;
+}
+
+/* Connect without blocking the in-process server */
+static UA_StatusCode
+connectClients(size_t clientsSize) {
+    for(size_t i = 0; i < clientsSize; i++) {
+        UA_StatusCode res = UA_Client_connectAsync(clientList[i], url);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    while(true) {
+        UA_Boolean activated = true;
+        for(size_t i = 0; i < clientsSize; i++) {
+            UA_SessionState ss;
+            UA_StatusCode res;
+            UA_Client_getState(clientList[i], NULL, &ss, &res);
+            if(res != UA_STATUSCODE_GOOD)
+                return res;
+            if(ss != UA_SESSIONSTATE_ACTIVATED)
+                activated = false;
+        }
+        if(activated)
+            return UA_STATUSCODE_GOOD;
+        iterate();
+    }
+}
+
+/* The synchronous disconnect waits for the CloseSession response. That would
+ * block the in-process server. */
+static void
+disconnectClients(void) {
+    for(size_t i = 0; i < clientListSize; i++) {
+        if(clientList[i])
+            UA_Client_disconnectAsync(clientList[i]);
+    }
+    UA_Boolean closed = false;
+    while(!closed) {
+        closed = true;
+        for(size_t i = 0; i < clientListSize; i++) {
+            if(!clientList[i])
+                continue;
+            UA_SecureChannelState cs;
+            UA_Client_getState(clientList[i], &cs, NULL, NULL);
+            if(cs != UA_SECURECHANNELSTATE_CLOSED)
+                closed = false;
+        }
+        if(!closed)
+            iterate();
+    }
+    for(size_t i = 0; i < clientListSize; i++) {
+        if(clientList[i])
+            UA_Client_delete(clientList[i]);
+        clientList[i] = NULL;
+    }
+}
+
+/*******************/
+/* Service Workload */
+/*******************/
+
+typedef struct {
+    UA_Boolean busy;
+    UA_DateTime started;
+} RequestSlot;
+
+static void
+serviceCallback(UA_Client *client, void *userdata,
+                UA_UInt32 requestId, void *response) {
+    RequestSlot *slot = (RequestSlot*)userdata;
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    recordLatency(now - slot->started);
+    slot->busy = false;
+    /* The ResponseHeader is the first member of every response */
+    const UA_ResponseHeader *rh = (const UA_ResponseHeader*)response;
+    if(rh->serviceResult != UA_STATUSCODE_GOOD)
+        errors++;
+    else
+        operations += batch;
+}
+
+/* Send the request count times with up to inflight requests pending */
+static int
+runService(UA_Client *client, const void *request, const UA_DataType *requestType,
+           const UA_DataType *responseType) {
+    RequestSlot *slots = (RequestSlot*)calloc(inflight, sizeof(RequestSlot));
+    if(!slots)
+        return -1;
+    size_t sent = 0;
+    size_t received = 0;
+    allocations = 0;
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    while(received < count) {
+        for(size_t i = 0; i < inflight && sent < count; i++) {
+            if(slots[i].busy)
+                continue;
+            slots[i].busy = true;
+            slots[i].started = UA_DateTime_nowMonotonic();
+            UA_StatusCode res =
+                __UA_Client_AsyncService(client, request, requestType, serviceCallback,
+                                         responseType, &slots[i], NULL);
+            if(res != UA_STATUSCODE_GOOD) {
+                slots[i].busy = false;
+                errors++;
+                received++;
+            }
+            sent++;
+        }
+        iterate();
+        received = sent;
+        for(size_t i = 0; i < inflight; i++) {
+            if(slots[i].busy)
+                received--;
+        }
+        UA_StatusCode connectStatus;
+        UA_Client_getState(client, NULL, NULL, &connectStatus);
+        if(connectStatus != UA_STATUSCODE_GOOD) {
+            printf("Aborting with status code %s\n", UA_StatusCode_name(connectStatus));
+            free(slots);
+            return -1;
+        }
+    }
+    printResult(UA_DateTime_nowMonotonic() - start, sent);
+    free(slots);
+    return 0;
+}
+
+/* Read the current value once to write it back in the write workload */
+static UA_Boolean valueRead = false;
+
+static void
+readValueCallback(UA_Client *client, void *userdata,
+                  UA_UInt32 requestId, void *response) {
+    UA_ReadResponse *rr = (UA_ReadResponse*)response;
+    if(rr->resultsSize == 1 && rr->results[0].hasValue)
+        UA_Variant_copy(&rr->results[0].value, (UA_Variant*)userdata);
+    valueRead = true;
+}
+
+static int
+runWorkload(UA_Client *client) {
+    const UA_NodeId *node = &nodeidval;
+    if(UA_NodeId_isNull(node)) {
+        if(strcmp(workload, "browse") == 0)
+            nodeidval = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+        else if(server)
+            UA_NodeId_copy(&benchNodeId, &nodeidval);
+        else
+            nodeidval = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    }
+
+    if(strcmp(workload, "read") == 0) {
+        UA_ReadValueId *rvids = (UA_ReadValueId*)calloc(batch, sizeof(UA_ReadValueId));
+        if(!rvids)
+            return -1;
+        for(size_t i = 0; i < batch; i++) {
+            rvids[i].nodeId = *node;
+            rvids[i].attributeId = UA_ATTRIBUTEID_VALUE;
+        }
+        UA_ReadRequest req;
+        UA_ReadRequest_init(&req);
+        req.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+        req.nodesToRead = rvids;
+        req.nodesToReadSize = batch;
+        int ret = runService(client, &req, &UA_TYPES[UA_TYPES_READREQUEST],
+                             &UA_TYPES[UA_TYPES_READRESPONSE]);
+        free(rvids);
+        return ret;
+    }
+
+    if(strcmp(workload, "write") == 0) {
+        UA_ReadValueId rvid;
+        UA_ReadValueId_init(&rvid);
+        rvid.nodeId = *node;
+        rvid.attributeId = UA_ATTRIBUTEID_VALUE;
+        UA_ReadRequest rreq;
+        UA_ReadRequest_init(&rreq);
+        rreq.nodesToRead = &rvid;
+        rreq.nodesToReadSize = 1;
+        UA_Variant value;
+        UA_Variant_init(&value);
+        UA_StatusCode res =
+            __UA_Client_AsyncService(client, &rreq, &UA_TYPES[UA_TYPES_READREQUEST],
+                                     readValueCallback, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                     &value, NULL);
+        while(res == UA_STATUSCODE_GOOD && !valueRead) {
+            iterate();
+            UA_Client_getState(client, NULL, NULL, &res);
+        }
+        if(!value.type) {
+            printf("Could not read the value to be written\n");
+            return -1;
+        }
+        UA_WriteValue *wvs = (UA_WriteValue*)calloc(batch, sizeof(UA_WriteValue));
+        if(!wvs) {
+            UA_Variant_clear(&value);
+            return -1;
+        }
+        for(size_t i = 0; i < batch; i++) {
+            wvs[i].nodeId = *node;
+            wvs[i].attributeId = UA_ATTRIBUTEID_VALUE;
+            wvs[i].value.hasValue = true;
+            wvs[i].value.value = value;
+        }
+        UA_WriteRequest req;
+        UA_WriteRequest_init(&req);
+        req.nodesToWrite = wvs;
+        req.nodesToWriteSize = batch;
+        int ret = runService(client, &req, &UA_TYPES[UA_TYPES_WRITEREQUEST],
+                             &UA_TYPES[UA_TYPES_WRITERESPONSE]);
+        free(wvs);
+        UA_Variant_clear(&value);
+        return ret;
+    }
+
+    if(strcmp(workload, "browse") == 0) {
+        UA_BrowseDescription *bds = (UA_BrowseDescription*)
+            calloc(batch, sizeof(UA_BrowseDescription));
+        if(!bds)
+            return -1;
+        for(size_t i = 0; i < batch; i++) {
+            bds[i].nodeId = *node;
+            bds[i].browseDirection = UA_BROWSEDIRECTION_BOTH;
+            bds[i].includeSubtypes = true;
+            bds[i].resultMask = UA_BROWSERESULTMASK_ALL;
+        }
+        UA_BrowseRequest req;
+        UA_BrowseRequest_init(&req);
+        req.nodesToBrowse = bds;
+        req.nodesToBrowseSize = batch;
+        int ret = runService(client, &req, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                             &UA_TYPES[UA_TYPES_BROWSERESPONSE]);
+        free(bds);
+        return ret;
+    }
+
+    usage();
+    return -1;
+}
+
+/**********************/
+/* Subscribe Workload */
+/**********************/
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+static UA_UInt32 subscriptionId = 0;
+static size_t createdItems = 0;
+static UA_Boolean setupFailed = false;
+
+/* The latency is measured from the source timestamp. Only meaningful if the
+ * clocks of the client and the server are synchronized. */
+static void
+dataChangeCallback(UA_Client *client, UA_UInt32 subId, void *subContext,
+                   UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    operations++;
+    if(value->hasSourceTimestamp)
+        recordLatency(UA_DateTime_now() - value->sourceTimestamp);
+}
+
+static void
+createSubscriptionCallback(UA_Client *client, void *userdata,
+                           UA_UInt32 requestId, void *response) {
+    UA_CreateSubscriptionResponse *r = (UA_CreateSubscriptionResponse*)response;
+    if(r->responseHeader.serviceResult != UA_STATUSCODE_GOOD)
+        setupFailed = true;
+    else
+        subscriptionId = r->subscriptionId;
+}
+
+static void
+createItemsCallback(UA_Client *client, void *userdata,
+                    UA_UInt32 requestId, void *response) {
+    UA_CreateMonitoredItemsResponse *r = (UA_CreateMonitoredItemsResponse*)response;
+    for(size_t i = 0; i < r->resultsSize; i++) {
+        if(r->results[i].statusCode == UA_STATUSCODE_GOOD)
+            createdItems++;
+    }
+    if(createdItems < items)
+        setupFailed = true;
+}
+
+static int
+runSubscribe(UA_Client *client) {
+    /* Keep PublishRequests in flight from the start of the subscription */
+    UA_ClientConfig *cc = UA_Client_getConfig(client);
+    cc->outStandingPublishRequests = 10;
+
+    UA_CreateSubscriptionRequest sreq = UA_CreateSubscriptionRequest_default();
+    sreq.requestedPublishingInterval = interval;
+    sreq.maxNotificationsPerPublish = 0;
+    UA_StatusCode res =
+        UA_Client_Subscriptions_create_async(client, sreq, NULL, NULL, NULL,
+                                             createSubscriptionCallback, NULL, NULL);
+    while(res == UA_STATUSCODE_GOOD && subscriptionId == 0 && !setupFailed) {
+        iterate();
+        UA_Client_getState(client, NULL, NULL, &res);
+    }
+    if(res != UA_STATUSCODE_GOOD || setupFailed) {
+        printf("Could not create the subscription\n");
+        return -1;
+    }
+
+    UA_MonitoredItemCreateRequest *mireqs = (UA_MonitoredItemCreateRequest*)
+        calloc(items, sizeof(UA_MonitoredItemCreateRequest));
+    UA_Client_DataChangeNotificationCallback *callbacks =
+        (UA_Client_DataChangeNotificationCallback*)
+        calloc(items, sizeof(UA_Client_DataChangeNotificationCallback));
+    void **contexts = (void**)calloc(items, sizeof(void*));
+    UA_Client_DeleteMonitoredItemCallback *deleteCallbacks =
+        (UA_Client_DeleteMonitoredItemCallback*)
+        calloc(items, sizeof(UA_Client_DeleteMonitoredItemCallback));
+    if(!mireqs || !callbacks || !contexts || !deleteCallbacks) {
+        free(mireqs);
+        free(callbacks);
+        free(contexts);
+        free(deleteCallbacks);
+        return -1;
+    }
+    for(size_t i = 0; i < items; i++) {
+        mireqs[i] = UA_MonitoredItemCreateRequest_default(
+            UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+        mireqs[i].requestedParameters.samplingInterval = interval;
+        callbacks[i] = dataChangeCallback;
+    }
+    UA_CreateMonitoredItemsRequest mreq;
+    UA_CreateMonitoredItemsRequest_init(&mreq);
+    mreq.subscriptionId = subscriptionId;
+    mreq.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    mreq.itemsToCreate = mireqs;
+    mreq.itemsToCreateSize = items;
+    res = UA_Client_MonitoredItems_createDataChanges_async(client, mreq, contexts,
+                                                           callbacks, deleteCallbacks,
+                                                           createItemsCallback,
+                                                           NULL, NULL);
+    free(mireqs);
+    free(callbacks);
+    free(contexts);
+    free(deleteCallbacks);
+    while(res == UA_STATUSCODE_GOOD && createdItems == 0 && !setupFailed) {
+        iterate();
+        UA_Client_getState(client, NULL, NULL, &res);
+    }
+    if(res != UA_STATUSCODE_GOOD || setupFailed) {
+        printf("Could not create the MonitoredItems\n");
+        return -1;
+    }
+
+    /* Receive notifications for the duration */
+    operations = 0;
+    latenciesSize = 0;
+    allocations = 0;
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    UA_DateTime end = start + (UA_DateTime)(duration * UA_DATETIME_SEC);
+    UA_DateTime now = start;
+    while(now < end && res == UA_STATUSCODE_GOOD) {
+        iterate();
+        UA_Client_getState(client, NULL, NULL, &res);
+        now = UA_DateTime_nowMonotonic();
+    }
+    cc->outStandingPublishRequests = 0;
+    if(res != UA_STATUSCODE_GOOD) {
+        printf("Aborting with status code %s\n", UA_StatusCode_name(res));
+        return -1;
+    }
+    batch = items;
+    inflight = 10;
+    printResult(now - start, 0);
+    return 0;
+}
+
+#endif
+
+/********************/
+/* Connect Workload */
+/********************/
+
+/* Connect the clients in waves. The latency is from the connect until the
+ * Session is activated. */
+static int
+runConnect(void) {
+    size_t done = 0;
+    size_t waves = 0;
+    allocations = 0;
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    while(done < count) {
+        size_t wave = (count - done < clients) ? count - done : clients;
+        clientListSize = wave;
+        UA_DateTime *started = (UA_DateTime*)calloc(wave, sizeof(UA_DateTime));
+        if(!started)
+            return -1;
+        for(size_t i = 0; i < wave; i++) {
+            clientList[i] = newClient();
+            if(!clientList[i]) {
+                free(started);
+                return -1;
+            }
+            started[i] = UA_DateTime_nowMonotonic();
+            if(UA_Client_connectAsync(clientList[i], url) != UA_STATUSCODE_GOOD)
+                started[i] = 0;
+        }
+
+        size_t pending = wave;
+        while(pending > 0) {
+            iterate();
+            for(size_t i = 0; i < wave; i++) {
+                if(started[i] == 0)
+                    continue;
+                UA_SessionState ss;
+                UA_StatusCode res;
+                UA_Client_getState(clientList[i], NULL, &ss, &res);
+                if(res != UA_STATUSCODE_GOOD) {
+                    errors++;
+                } else if(ss == UA_SESSIONSTATE_ACTIVATED) {
+                    recordLatency(UA_DateTime_nowMonotonic() - started[i]);
+                    operations++;
+                } else {
+                    continue;
+                }
+                started[i] = 0;
+                pending--;
+            }
+        }
+
+        disconnectClients();
+        free(started);
+        done += wave;
+        waves++;
+    }
+    batch = 1;
+    inflight = clients;
+    printResult(UA_DateTime_nowMonotonic() - start, waves);
+    clientListSize = 0;
+    return 0;
+}
+
+/********/
+/* Main */
+/********/
+
+static UA_StatusCode
+startServer(void) {
+    server = UA_Server_new();
+    if(!server)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_ServerConfig *sc = UA_Server_getConfig(server);
+    sc->logging->context = (void*)(uintptr_t)UA_LOGLEVEL_WARNING;
+    sc->tcpReuseAddr = true; /* Runs one after the other */
+    /* Room for the concurrent connects with a margin for the closing ones */
+    size_t maxClients = clients * 2 + 10;
+    if(maxClients > 60000)
+        maxClients = 60000;
+    if(sc->maxSessions < maxClients)
+        sc->maxSessions = (UA_UInt16)maxClients;
+    if(sc->maxSecureChannels <= sc->maxSessions)
+        sc->maxSecureChannels = (UA_UInt16)(sc->maxSessions + 1);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    /* Honor short intervals for the subscribe workload */
+    sc->publishingIntervalLimits.min = 1.0;
+    sc->samplingIntervalLimits.min = 1.0;
+#endif
+
+    /* Writable variable for the read and write workloads */
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Int32 zero = 0;
+    UA_Variant_setScalar(&attr.value, &zero, &UA_TYPES[UA_TYPES_INT32]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_StatusCode res =
+        UA_Server_addVariableNode(server, benchNodeId,
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                  UA_QUALIFIEDNAME(1, "bench"),
+                                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                  attr, NULL, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    return UA_Server_run_startup(server);
+}
+
+static int
+parseSize(const char *arg, size_t *out) {
+    long v = atol(arg);
+    if(v <= 0)
+        return -1;
+    *out = (size_t)v;
+    return 0;
+}
+
+int
+main(int argc, char **argv) {
+    if(argc < 3) {
+        usage();
+        return 0;
+    }
+    url = argv[1];
+    workload = argv[2];
+
+    /* Process the options */
+    for(int argpos = 3; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(argpos + 1 == argc) {
+            usage();
+            return -1;
+        }
+        const char *opt = argv[argpos];
+        const char *arg = argv[++argpos];
+        int ret = 0;
+        if(strcmp(opt, "--count") == 0)
+            ret = parseSize(arg, &count);
+        else if(strcmp(opt, "--batch") == 0)
+            ret = parseSize(arg, &batch);
+        else if(strcmp(opt, "--inflight") == 0)
+            ret = parseSize(arg, &inflight);
+        else if(strcmp(opt, "--clients") == 0)
+            ret = parseSize(arg, &clients);
+        else if(strcmp(opt, "--items") == 0)
+            ret = parseSize(arg, &items);
+        else if(strcmp(opt, "--interval") == 0)
+            interval = atof(arg);
+        else if(strcmp(opt, "--duration") == 0)
+            duration = atof(arg);
+        else if(strcmp(opt, "--nodeid") == 0)
+            ret = (UA_NodeId_parse(&nodeidval, UA_STRING((char*)(uintptr_t)arg)) ==
+                   UA_STATUSCODE_GOOD) ? 0 : -1;
+        else
+            ret = -1;
+        if(ret != 0) {
+            usage();
+            return -1;
+        }
+    }
+    UA_Boolean connectWorkload = (strcmp(workload, "connect") == 0);
+    if(count == 0)
+        count = connectWorkload ? 100 : 10000;
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    UA_mallocSingleton = countingMalloc;
+    UA_callocSingleton = countingCalloc;
+    UA_reallocSingleton = countingRealloc;
+#endif
+
+    int ret = -1;
+    if(strcmp(url, "inproc") == 0) {
+        url = INPROC_URL;
+        UA_StatusCode res = startServer();
+        if(res != UA_STATUSCODE_GOOD) {
+            printf("Could not start the server: %s\n", UA_StatusCode_name(res));
+            goto cleanup;
+        }
+    }
+
+    clientList = (UA_Client**)calloc(connectWorkload ? clients : 1, sizeof(UA_Client*));
+    if(!clientList)
+        goto cleanup;
+
+    if(connectWorkload) {
+        ret = runConnect();
+        goto cleanup;
+    }
+
+    clientList[0] = newClient();
+    clientListSize = 1;
+    if(!clientList[0])
+        goto cleanup;
+    UA_StatusCode res = connectClients(1);
+    if(res != UA_STATUSCODE_GOOD) {
+        printf("Aborting with status code %s\n", UA_StatusCode_name(res));
+        goto cleanup;
+    }
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    if(strcmp(workload, "subscribe") == 0)
+        ret = runSubscribe(clientList[0]);
+    else
+#endif
+        ret = runWorkload(clientList[0]);
+
+ cleanup:
+    if(clientList)
+        disconnectClients();
+    free(clientList);
+    if(server) {
+        UA_Server_run_shutdown(server);
+        UA_Server_delete(server);
+    }
+    UA_NodeId_clear(&nodeidval);
+    free(latencies);
+    return ret;
+}
@@ -0,0 +1,660 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+#include <open62541/server_pubsub.h>
+
+/* Cycle-time and jitter benchmark for PubSub. A publisher and a subscriber run
+ * in the same process and communicate over UDP multicast (loopback) or raw
+ * Ethernet. For every combination of DataSet size and publishing interval, a
+ * fixed number of publish cycles is executed and measured:
+ *
+ * - publishUs: Duration of the publish callback
+ * - wakeupUs: Delay of the publish callback relative to the cycle start
+ * - latencyUs: End-to-end latency from the publish callback until the value
+ *   arrives in the subscriber (the first field carries the send timestamp)
+ * - jitterUs: Difference of the latency between consecutive messages
+ *
+ * The publish cycle is driven by the benchmark instead of the EventLoop timer
+ * (custom publish callback). Between the cycles, the EventLoop processes the
+ * received messages. With UA_ENABLE_MALLOC_SINGLETON, the heap allocations
+ * inside the publish callback are counted. The subscriber of builds with
+ * UA_ENABLE_PUBSUB_BUFMALLOC decodes into the static memory buffer.
+ *
+ * The result is printed as one JSON line per run. */
+
+#define DEFAULT_URL "opc.udp://224.0.0.22:4840/"
+#define UDP_PROFILE "http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp"
+#define ETH_PROFILE "http://opcfoundation.org/UA-Profile/Transport/pubsub-eth-uadp"
+#define PUBLISHER_ID 2234
+#define WRITERGROUP_ID 100
+#define DATASETWRITER_ID 62541
+#define WARMUP_CYCLES 10
+#define MAX_RUNS 16
+
+/* Options */
+static const char *url = DEFAULT_URL;
+static const char *interface = NULL;
+static size_t cycles = 1000;
+static UA_PubSubRTLevel rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+static size_t fieldCounts[MAX_RUNS] = {1, 16, 64};
+static size_t fieldCountsSize = 3;
+static UA_Double intervals[MAX_RUNS] = {1.0, 10.0};
+static size_t intervalsSize = 2;
+
+static void
+usage(void) {
+    printf("Usage: ua_bench_pubsub [options]\n"
+           " --url <url>: opc.udp://address:port or opc.eth://mac-address "
+           "[default: " DEFAULT_URL "]\n"
+           " --interface <name>: Network interface (required for opc.eth)\n"
+           " --fields <n,...>: Number of DataSet fields [default: 1,16,64]\n"
+           " --interval <ms,...>: Publishing intervals [default: 1,10]\n"
+           " --cycles <n>: Measured publish cycles per run [default: 1000]\n"
+           " --rt <none|fixed|deterministic>: RT level of the WriterGroup "
+           "[default: fixed]\n"
+           " --help: Print this message\n");
+}
+
+/***********/
+/* Samples */
+/***********/
+
+typedef struct {
+    UA_DateTime *values;
+    size_t size;
+} Samples;
+
+static Samples publishSamples;
+static Samples wakeupSamples;
+static Samples latencySamples;
+static Samples jitterSamples;
+
+static void
+addSample(Samples *s, UA_DateTime value) {
+    if(s->size < cycles + WARMUP_CYCLES)
+        s->values[s->size++] = value;
+}
+
+static int
+compareDateTime(const void *a, const void *b) {
+    UA_DateTime da = *(const UA_DateTime*)a;
+    UA_DateTime db = *(const UA_DateTime*)b;
+    return (da > db) - (da < db);
+}
+
+/* Sorts the samples */
+static void
+printSamples(const char *name, Samples *s) {
+    if(s->size == 0) {
+        printf(",\"%s\":null", name);
+        return;
+    }
+    qsort(s->values, s->size, sizeof(UA_DateTime), compareDateTime);
+    printf(",\"%s\":{\"min\":%.1f,\"p50\":%.1f,\"p99\":%.1f,\"max\":%.1f}", name,
+           (UA_Double)s->values[0] / UA_DATETIME_USEC,
+           (UA_Double)s->values[s->size / 2] / UA_DATETIME_USEC,
+           (UA_Double)s->values[(s->size * 99) / 100] / UA_DATETIME_USEC,
+           (UA_Double)s->values[s->size - 1] / UA_DATETIME_USEC);
+}
+
+/*************************/
+/* Allocation Accounting */
+/*************************/
+
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+
+/* The counting allocator is only installed during the publish callback */
+static size_t cycleAllocations;
+static void * (*origMalloc)(size_t size);
+static void * (*origCalloc)(size_t nelem, size_t elsize);
+static void * (*origRealloc)(void *ptr, size_t size);
+
+static void *
+countingMalloc(size_t size) {
+    cycleAllocations++;
+    return origMalloc(size);
+}
+
+static void *
+countingCalloc(size_t nelem, size_t elsize) {
+    cycleAllocations++;
+    return origCalloc(nelem, elsize);
+}
+
+static void *
+countingRealloc(void *ptr, size_t size) {
+    cycleAllocations++;
+    return origRealloc(ptr, size);
+}
+
+static void
+beginAllocationCount(void) {
+    origMalloc = UA_mallocSingleton;
+    origCalloc = UA_callocSingleton;
+    origRealloc = UA_reallocSingleton;
+    UA_mallocSingleton = countingMalloc;
+    UA_callocSingleton = countingCalloc;
+    UA_reallocSingleton = countingRealloc;
+}
+
+static void
+endAllocationCount(void) {
+    UA_mallocSingleton = origMalloc;
+    UA_callocSingleton = origCalloc;
+    UA_reallocSingleton = origRealloc;
+}
+
+#endif
+
+/*************/
+/* Publisher */
+/*************/
+
+static UA_ServerCallback publishCallback;
+static void *publishData;
+
+static UA_StatusCode
+addPublishCallback(UA_Server *server, UA_NodeId identifier,
+                   UA_ServerCallback callback, void *data, UA_Double interval_ms,
+                   UA_DateTime *baseTime, UA_TimerPolicy timerPolicy,
+                   UA_UInt64 *callbackId) {
+    publishCallback = callback;
+    publishData = data;
+    *callbackId = 1;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+changePublishCallback(UA_Server *server, UA_NodeId identifier,
+                      UA_UInt64 callbackId, UA_Double interval_ms,
+                      UA_DateTime *baseTime, UA_TimerPolicy timerPolicy) {
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+removePublishCallback(UA_Server *server, UA_NodeId identifier, UA_UInt64 callbackId) {
+    publishCallback = NULL;
+    publishData = NULL;
+}
+
+/* The first field is the send timestamp. It is transmitted as an Int64, as
+ * the RT levels support only numeric fields. The other fields are counters. */
+static UA_DateTime sendTime;
+static UA_UInt32 *pubValues;
+static UA_DataValue *pubDataValues;
+static UA_DataValue **pubDataValuePtrs;
+
+static UA_StatusCode
+addPublisher(UA_Server *server, UA_NodeId connectionId,
+             size_t fields, UA_Double interval, UA_NodeId *writerGroupId) {
+    UA_NodeId pdsId;
+    UA_PublishedDataSetConfig pdsConfig;
+    memset(&pdsConfig, 0, sizeof(UA_PublishedDataSetConfig));
+    pdsConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+    pdsConfig.name = UA_STRING("Benchmark PDS");
+    UA_StatusCode res =
+        UA_Server_addPublishedDataSet(server, &pdsConfig, &pdsId).addResult;
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    for(size_t i = 0; i < fields; i++) {
+        UA_DataValue_init(&pubDataValues[i]);
+        if(i == 0)
+            UA_Variant_setScalar(&pubDataValues[i].value, &sendTime,
+                                 &UA_TYPES[UA_TYPES_INT64]);
+        else
+            UA_Variant_setScalar(&pubDataValues[i].value, &pubValues[i],
+                                 &UA_TYPES[UA_TYPES_UINT32]);
+        pubDataValues[i].hasValue = true;
+        pubDataValuePtrs[i] = &pubDataValues[i];
+
+        UA_DataSetFieldConfig dsfConfig;
+        memset(&dsfConfig, 0, sizeof(UA_DataSetFieldConfig));
+        dsfConfig.field.variable.fieldNameAlias = UA_STRING("Field");
+        dsfConfig.field.variable.rtValueSource.rtFieldSourceEnabled = true;
+        dsfConfig.field.variable.rtValueSource.staticValueSource = &pubDataValuePtrs[i];
+        dsfConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+        res = UA_Server_addDataSetField(server, pdsId, &dsfConfig, NULL).result;
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+
+    UA_WriterGroupConfig wgConfig;
+    memset(&wgConfig, 0, sizeof(UA_WriterGroupConfig));
+    wgConfig.name = UA_STRING("Benchmark WriterGroup");
+    wgConfig.publishingInterval = interval;
+    wgConfig.writerGroupId = WRITERGROUP_ID;
+    wgConfig.rtLevel = rtLevel;
+    wgConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+    wgConfig.pubsubManagerCallback.addCustomCallback = addPublishCallback;
+    wgConfig.pubsubManagerCallback.changeCustomCallback = changePublishCallback;
+    wgConfig.pubsubManagerCallback.removeCustomCallback = removePublishCallback;
+    UA_UadpWriterGroupMessageDataType wgm;
+    UA_UadpWriterGroupMessageDataType_init(&wgm);
+    wgm.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    UA_ExtensionObject_setValue(&wgConfig.messageSettings, &wgm,
+                                &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE]);
+    res = UA_Server_addWriterGroup(server, connectionId, &wgConfig, writerGroupId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_DataSetWriterConfig dswConfig;
+    memset(&dswConfig, 0, sizeof(UA_DataSetWriterConfig));
+    dswConfig.name = UA_STRING("Benchmark DataSetWriter");
+    dswConfig.dataSetWriterId = DATASETWRITER_ID;
+    return UA_Server_addDataSetWriter(server, *writerGroupId, pdsId, &dswConfig, NULL);
+}
+
+/**************/
+/* Subscriber */
+/**************/
+
+static UA_DateTime subTime;
+static UA_UInt32 *subValues;
+static UA_DataValue *subDataValues;
+static UA_DataValue **subDataValuePtrs;
+static UA_DateTime lastLatency;
+static size_t received;
+
+static void
+receivedCallback(UA_Server *server, const UA_NodeId *readerIdentifier,
+                 const UA_NodeId *readerGroupIdentifier,
+                 const UA_NodeId *targetVariableIdentifier,
+                 void *targetVariableContext, UA_DataValue **externalDataValue) {
+    UA_DateTime latency = UA_DateTime_now() - subTime;
+    received++;
+    if(received <= WARMUP_CYCLES) {
+        lastLatency = latency;
+        return;
+    }
+    addSample(&latencySamples, latency);
+    addSample(&jitterSamples, (latency > lastLatency) ?
+              latency - lastLatency : lastLatency - latency);
+    lastLatency = latency;
+}
+
+static UA_StatusCode
+externalWrite(UA_Server *server, const UA_NodeId *sessionId,
+              void *sessionContext, const UA_NodeId *nodeId,
+              void *nodeContext, const UA_NumericRange *range,
+              const UA_DataValue *data) {
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+externalRead(UA_Server *server, const UA_NodeId *sessionId,
+             void *sessionContext, const UA_NodeId *nodeid,
+             void *nodeContext, const UA_NumericRange *range) {
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+addSubscriber(UA_Server *server, UA_NodeId connectionId,
+              size_t fields, UA_NodeId *readerGroupId) {
+    UA_ReaderGroupConfig rgConfig;
+    memset(&rgConfig, 0, sizeof(UA_ReaderGroupConfig));
+    rgConfig.name = UA_STRING("Benchmark ReaderGroup");
+    if(rtLevel != UA_PUBSUB_RT_NONE)
+        rgConfig.rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+    UA_StatusCode res =
+        UA_Server_addReaderGroup(server, connectionId, &rgConfig, readerGroupId);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+
+    UA_DataSetReaderConfig dsrConfig;
+    memset(&dsrConfig, 0, sizeof(UA_DataSetReaderConfig));
+    dsrConfig.name = UA_STRING("Benchmark DataSetReader");
+    UA_UInt16 publisherId = PUBLISHER_ID;
+    dsrConfig.publisherId.type = &UA_TYPES[UA_TYPES_UINT16];
+    dsrConfig.publisherId.data = &publisherId;
+    dsrConfig.writerGroupId = WRITERGROUP_ID;
+    dsrConfig.dataSetWriterId = DATASETWRITER_ID;
+    UA_UadpDataSetReaderMessageDataType dsrm;
+    UA_UadpDataSetReaderMessageDataType_init(&dsrm);
+    dsrm.networkMessageContentMask = (UA_UadpNetworkMessageContentMask)
+        (UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+         UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+         UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+    UA_ExtensionObject_setValue(&dsrConfig.messageSettings, &dsrm,
+                                &UA_TYPES[UA_TYPES_UADPDATASETREADERMESSAGEDATATYPE]);
+
+    UA_FieldMetaData *fmd = (UA_FieldMetaData*)
+        UA_Array_new(fields, &UA_TYPES[UA_TYPES_FIELDMETADATA]);
+    UA_FieldTargetVariable *tvs = (UA_FieldTargetVariable*)
+        UA_calloc(fields, sizeof(UA_FieldTargetVariable));
+    if(!fmd || !tvs) {
+        UA_Array_delete(fmd, fields, &UA_TYPES[UA_TYPES_FIELDMETADATA]);
+        UA_free(tvs);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    dsrConfig.dataSetMetaData.name = UA_STRING("Benchmark DataSet");
+    dsrConfig.dataSetMetaData.fields = fmd;
+    dsrConfig.dataSetMetaData.fieldsSize = fields;
+    dsrConfig.subscribedDataSetType = UA_PUBSUB_SDS_TARGET;
+    dsrConfig.subscribedDataSet.subscribedDataSetTarget.targetVariables = tvs;
+    dsrConfig.subscribedDataSet.subscribedDataSetTarget.targetVariablesSize = fields;
+
+    /* Target variables with an external value backend. The values are copied
+     * into the static memory. */
+    for(size_t i = 0; i < fields && res == UA_STATUSCODE_GOOD; i++) {
+        const UA_DataType *type = (i == 0) ?
+            &UA_TYPES[UA_TYPES_INT64] : &UA_TYPES[UA_TYPES_UINT32];
+        fmd[i].dataType = type->typeId;
+        fmd[i].builtInType = (i == 0) ? UA_NS0ID_INT64 : UA_NS0ID_UINT32;
+        fmd[i].valueRank = UA_VALUERANK_SCALAR;
+
+        UA_DataValue_init(&subDataValues[i]);
+        if(i == 0)
+            UA_Variant_setScalar(&subDataValues[i].value, &subTime, type);
+        else
+            UA_Variant_setScalar(&subDataValues[i].value, &subValues[i], type);
+        subDataValues[i].hasValue = true;
+        subDataValuePtrs[i] = &subDataValues[i];
+
+        UA_VariableAttributes vAttr = UA_VariableAttributes_default;
+        vAttr.dataType = type->typeId;
+        vAttr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+        UA_Variant_setScalar(&vAttr.value, subDataValues[i].value.data, type);
+        UA_NodeId nodeId = UA_NODEID_NUMERIC(1, 50000 + (UA_UInt32)i);
+        res = UA_Server_addVariableNode(server, nodeId,
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+                                        UA_QUALIFIEDNAME(1, "Subscribed"),
+                                        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+                                        vAttr, NULL, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            break;
+        UA_ValueBackend backend;
+        memset(&backend, 0, sizeof(UA_ValueBackend));
+        backend.backendType = UA_VALUEBACKENDTYPE_EXTERNAL;
+        backend.backend.external.value = &subDataValuePtrs[i];
+        backend.backend.external.callback.userWrite = externalWrite;
+        backend.backend.external.callback.notificationRead = externalRead;
+        res = UA_Server_setVariableNode_valueBackend(server, nodeId, backend);
+
+        tvs[i].targetVariable.attributeId = UA_ATTRIBUTEID_VALUE;
+        tvs[i].targetVariable.targetNodeId = nodeId;
+        tvs[i].externalDataValue = &subDataValuePtrs[i];
+        if(i == 0)
+            tvs[i].afterWrite = receivedCallback;
+    }
+
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_addDataSetReader(server, *readerGroupId, &dsrConfig, NULL);
+    UA_Array_delete(fmd, fields, &UA_TYPES[UA_TYPES_FIELDMETADATA]);
+    UA_free(tvs);
+    return res;
+}
+
+/*******/
+/* Run */
+/*******/
+
+static const char *
+rtLevelName(UA_PubSubRTLevel level) {
+    switch(level) {
+    case UA_PUBSUB_RT_FIXED_SIZE: return "fixed";
+    case UA_PUBSUB_RT_DETERMINISTIC: return "deterministic";
+    default: return "none";
+    }
+}
+
+/* Process network events until the deadline */
+static void
+waitUntil(UA_EventLoop *el, UA_DateTime deadline) {
+    while(true) {
+        UA_DateTime remaining = deadline - el->dateTime_nowMonotonic(el);
+        if(remaining <= 0)
+            return;
+        /* Wake up one ms early and poll for the remainder */
+        UA_UInt32 timeout = 0;
+        if(remaining > 2 * UA_DATETIME_MSEC)
+            timeout = (UA_UInt32)(remaining / UA_DATETIME_MSEC) - 1;
+        el->run(el, timeout);
+    }
+}
+
+static int
+runBenchmark(size_t fields, UA_Double interval) {
+    publishSamples.size = 0;
+    wakeupSamples.size = 0;
+    latencySamples.size = 0;
+    jitterSamples.size = 0;
+    received = 0;
+    memset(pubValues, 0, fields * sizeof(UA_UInt32));
+
+    UA_Server *server = UA_Server_new();
+    if(!server)
+        return -1;
+    UA_ServerConfig *sc = UA_Server_getConfig(server);
+    sc->logging->context = (void*)(uintptr_t)UA_LOGLEVEL_WARNING;
+    sc->tcpReuseAddr = true;
+
+    UA_NodeId connectionId, writerGroupId, readerGroupId;
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING("Benchmark Connection");
+    UA_Boolean eth = (strncmp(url, "opc.eth://", 10) == 0);
+    connectionConfig.transportProfileUri = UA_STRING(eth ? ETH_PROFILE : UDP_PROFILE);
+    UA_NetworkAddressUrlDataType networkAddressUrl =
+        {interface ? UA_STRING((char*)(uintptr_t)interface) : UA_STRING_NULL,
+         UA_STRING((char*)(uintptr_t)url)};
+    UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl,
+                         &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.publisherIdType = UA_PUBLISHERIDTYPE_UINT16;
+    connectionConfig.publisherId.uint16 = PUBLISHER_ID;
+    UA_StatusCode res =
+        UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+    if(res == UA_STATUSCODE_GOOD)
+        res = addPublisher(server, connectionId, fields, interval, &writerGroupId);
+    if(res == UA_STATUSCODE_GOOD)
+        res = addSubscriber(server, connectionId, fields, &readerGroupId);
+    if(res == UA_STATUSCODE_GOOD && rtLevel != UA_PUBSUB_RT_NONE) {
+        res = UA_Server_freezeWriterGroupConfiguration(server, writerGroupId);
+        res |= UA_Server_freezeReaderGroupConfiguration(server, readerGroupId);
+    }
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_run_startup(server);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_enableWriterGroup(server, writerGroupId);
+    if(res == UA_STATUSCODE_GOOD)
+        res = UA_Server_enableReaderGroup(server, readerGroupId);
+    if(res != UA_STATUSCODE_GOOD || !publishCallback) {
+        fprintf(stderr, "Could not set up the PubSub configuration: %s\n",
+                UA_StatusCode_name(res));
+        UA_Server_delete(server);
+        return -1;
+    }
+
+    /* Wait until the connection is established */
+    UA_EventLoop *el = sc->eventLoop;
+    UA_DateTime now = el->dateTime_nowMonotonic(el);
+    waitUntil(el, now + 100 * UA_DATETIME_MSEC);
+
+    /* Publish cycles */
+    UA_DateTime cycleTime = (UA_DateTime)(interval * UA_DATETIME_MSEC);
+    UA_DateTime deadline = el->dateTime_nowMonotonic(el) + cycleTime;
+    size_t allocations = 0;
+    for(size_t i = 0; i < cycles + WARMUP_CYCLES; i++, deadline += cycleTime) {
+        waitUntil(el, deadline);
+        UA_DateTime start = el->dateTime_nowMonotonic(el);
+        for(size_t j = 1; j < fields; j++)
+            pubValues[j]++;
+        sendTime = UA_DateTime_now();
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        cycleAllocations = 0;
+        beginAllocationCount();
+#endif
+        publishCallback(server, publishData);
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+        endAllocationCount();
+        if(i >= WARMUP_CYCLES)
+            allocations += cycleAllocations;
+#endif
+        UA_DateTime end = el->dateTime_nowMonotonic(el);
+        if(i >= WARMUP_CYCLES) {
+            addSample(&publishSamples, end - start);
+            addSample(&wakeupSamples, start - deadline);
+        }
+    }
+
+    /* Receive the remaining messages */
+    waitUntil(el, deadline + 50 * UA_DATETIME_MSEC);
+
+    size_t measured = (received > WARMUP_CYCLES) ? received - WARMUP_CYCLES : 0;
+    printf("{\"transport\":\"%s\",\"rtLevel\":\"%s\",\"fields\":%lu,"
+           "\"intervalMs\":%.3f,\"cycles\":%lu,\"received\":%lu",
+           eth ? "eth" : "udp", rtLevelName(rtLevel), (unsigned long)fields,
+           interval, (unsigned long)cycles, (unsigned long)measured);
+#ifdef UA_ENABLE_MALLOC_SINGLETON
+    printf(",\"publishAllocations\":%lu", (unsigned long)allocations);
+#else
+    printf(",\"publishAllocations\":null");
+#endif
+#ifdef UA_ENABLE_PUBSUB_BUFMALLOC
+    printf(",\"bufmalloc\":true");
+#else
+    printf(",\"bufmalloc\":false");
+#endif
+    printSamples("publishUs", &publishSamples);
+    printSamples("wakeupUs", &wakeupSamples);
+    printSamples("latencyUs", &latencySamples);
+    printSamples("jitterUs", &jitterSamples);
+    printf("}\n");
+    fflush(stdout);
+    if(allocations > 0)
+        fprintf(stderr, "Warning: %lu heap allocations in the publish cycle\n",
+                (unsigned long)allocations);
+
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    return 0;
+}
+
+/********/
+/* Main */
+/********/
+
+/* Parse a comma-separated list of numbers */
+static int
+parseList(char *arg, UA_Double *out, size_t *outSize) {
+    size_t n = 0;
+    for(char *tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        if(n == MAX_RUNS)
+            return -1;
+        out[n] = atof(tok);
+        if(out[n] <= 0.0)
+            return -1;
+        n++;
+    }
+    *outSize = n;
+    return (n > 0) ? 0 : -1;
+}
+
+int
+main(int argc, char **argv) {
+    for(int argpos = 1; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(argpos + 1 == argc) {
+            usage();
+            return -1;
+        }
+        const char *opt = argv[argpos];
+        char *arg = argv[++argpos];
+        int ret = 0;
+        if(strcmp(opt, "--url") == 0) {
+            url = arg;
+        } else if(strcmp(opt, "--interface") == 0) {
+            interface = arg;
+        } else if(strcmp(opt, "--cycles") == 0) {
+            long c = atol(arg);
+            ret = (c > 0) ? 0 : -1;
+            cycles = (size_t)c;
+        } else if(strcmp(opt, "--fields") == 0) {
+            UA_Double counts[MAX_RUNS];
+            ret = parseList(arg, counts, &fieldCountsSize);
+            for(size_t i = 0; i < fieldCountsSize; i++)
+                fieldCounts[i] = (size_t)counts[i];
+        } else if(strcmp(opt, "--interval") == 0) {
+            ret = parseList(arg, intervals, &intervalsSize);
+        } else if(strcmp(opt, "--rt") == 0) {
+            if(strcmp(arg, "none") == 0)
+                rtLevel = UA_PUBSUB_RT_NONE;
+            else if(strcmp(arg, "fixed") == 0)
+                rtLevel = UA_PUBSUB_RT_FIXED_SIZE;
+            else if(strcmp(arg, "deterministic") == 0)
+                rtLevel = UA_PUBSUB_RT_DETERMINISTIC;
+            else
+                ret = -1;
+        } else {
+            ret = -1;
+        }
+        if(ret != 0) {
+            usage();
+            return -1;
+        }
+    }
+    if(strncmp(url, "opc.eth://", 10) == 0 && !interface) {
+        fprintf(stderr, "An interface is required for opc.eth\n");
+        return -1;
+    }
+
+    /* Allocate all memory for the measurements up front */
+    size_t maxFields = 0;
+    for(size_t i = 0; i < fieldCountsSize; i++) {
+        if(fieldCounts[i] > maxFields)
+            maxFields = fieldCounts[i];
+    }
+    size_t sampleSize = (cycles + WARMUP_CYCLES) * sizeof(UA_DateTime);
+    publishSamples.values = (UA_DateTime*)UA_malloc(sampleSize);
+    wakeupSamples.values = (UA_DateTime*)UA_malloc(sampleSize);
+    latencySamples.values = (UA_DateTime*)UA_malloc(sampleSize);
+    jitterSamples.values = (UA_DateTime*)UA_malloc(sampleSize);
+    pubValues = (UA_UInt32*)UA_calloc(maxFields, sizeof(UA_UInt32));
+    pubDataValues = (UA_DataValue*)UA_calloc(maxFields, sizeof(UA_DataValue));
+    pubDataValuePtrs = (UA_DataValue**)UA_calloc(maxFields, sizeof(UA_DataValue*));
+    subValues = (UA_UInt32*)UA_calloc(maxFields, sizeof(UA_UInt32));
+    subDataValues = (UA_DataValue*)UA_calloc(maxFields, sizeof(UA_DataValue));
+    subDataValuePtrs = (UA_DataValue**)UA_calloc(maxFields, sizeof(UA_DataValue*));
+
+    int ret = 0;
+    if(!publishSamples.values || !wakeupSamples.values ||
+       !latencySamples.values || !jitterSamples.values ||
+       !pubValues || !pubDataValues || !pubDataValuePtrs ||
+       !subValues || !subDataValues || !subDataValuePtrs) {
+        fprintf(stderr, "Out of memory\n");
+        ret = -1;
+    }
+
+    for(size_t i = 0; i < fieldCountsSize && ret == 0; i++) {
+        for(size_t j = 0; j < intervalsSize && ret == 0; j++)
+            ret = runBenchmark(fieldCounts[i], intervals[j]);
+    }
+
+    UA_free(publishSamples.values);
+    UA_free(wakeupSamples.values);
+    UA_free(latencySamples.values);
+    UA_free(jitterSamples.values);
+    UA_free(pubValues);
+    UA_free(pubDataValues);
+    UA_free(pubDataValuePtrs);
+    UA_free(subValues);
+    UA_free(subDataValues);
+    UA_free(subDataValuePtrs);
+    return ret;
+}
@@ -0,0 +1,595 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <open62541/types.h>
+
+#ifndef _WIN32
+# include <dirent.h>
+#endif
+
+/* Measures the throughput of the binary encoding and of the generic type
+ * handling for representative messages. Every case is a list of values. A
+ * pass over the list is measured for every operation until the duration is
+ * reached. The results are printed as one JSON object per line.
+ *
+ * The synthetic cases contain the same value BATCH times. The corpus case
+ * contains the service requests from the chunks in a directory of the fuzzing
+ * corpus (e.g. tests/fuzz/fuzz_binary_message_corpus/generated). */
+
+#define BATCH 32
+
+/* Options */
+static size_t size = 100;          /* Elements in the synthetic values */
+static UA_Double duration = 0.2;   /* Seconds per case and operation */
+static const char *caseFilter = NULL;
+static const char *corpusDir = NULL;
+
+static void
+usage(void) {
+    printf("Usage: ua_bench_types [options]\n"
+           " --size <n>: Elements in the synthetic values [default: 100]\n"
+           " --duration <s>: Duration per case and operation [default: 0.2]\n"
+           " --case <name>: Run only the named case\n"
+#ifndef _WIN32
+           " --corpus <dir>: Add the requests from the binary message corpus\n"
+#endif
+           " --help: Print this message\n"
+           "Cases: readresponse, publishresponse, doublearray, stringarray,\n"
+           "       eventfilter, corpus\n"
+           "Operations: calcSize, encode, decode, decodeArena, copy, clear\n");
+}
+
+/*********/
+/* Cases */
+/*********/
+
+typedef struct {
+    const UA_DataType *type;
+    void *value;
+    UA_ByteString encoded;
+    UA_Boolean owner; /* The synthetic cases share the value */
+} BenchItem;
+
+typedef struct {
+    const char *name;
+    BenchItem *items;
+    size_t itemsSize;
+    size_t bytes;           /* Encoded size of one pass */
+    size_t maxEncoded;
+    size_t maxMemSize;
+    UA_ByteString scratch;  /* Output buffer for the encoding */
+    UA_Byte *storage;       /* One slot per item for decode and copy */
+} BenchCase;
+
+static void
+BenchCase_clear(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        if(!bc->items[i].owner)
+            continue;
+        UA_delete(bc->items[i].value, bc->items[i].type);
+        UA_ByteString_clear(&bc->items[i].encoded);
+    }
+    free(bc->items);
+    free(bc->storage);
+    UA_ByteString_clear(&bc->scratch);
+    memset(bc, 0, sizeof(BenchCase));
+}
+
+/* Takes ownership of the value. Encodes it for the decoding. */
+static UA_StatusCode
+BenchCase_addItem(BenchCase *bc, void *value, const UA_DataType *type,
+                  size_t copies) {
+    BenchItem *items = (BenchItem*)
+        realloc(bc->items, (bc->itemsSize + copies) * sizeof(BenchItem));
+    if(!items) {
+        UA_delete(value, type);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    bc->items = items;
+    BenchItem *item = &bc->items[bc->itemsSize];
+    item->type = type;
+    item->value = value;
+    item->owner = true;
+    UA_ByteString_init(&item->encoded);
+    UA_StatusCode res = UA_encodeBinary(value, type, &item->encoded);
+    if(res != UA_STATUSCODE_GOOD) {
+        UA_delete(value, type);
+        return res;
+    }
+    for(size_t i = 1; i < copies; i++) {
+        bc->items[bc->itemsSize + i] = *item;
+        bc->items[bc->itemsSize + i].owner = false;
+    }
+    bc->itemsSize += copies;
+    bc->bytes += item->encoded.length * copies;
+    if(item->encoded.length > bc->maxEncoded)
+        bc->maxEncoded = item->encoded.length;
+    if(type->memSize > bc->maxMemSize)
+        bc->maxMemSize = type->memSize;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+BenchCase_finish(BenchCase *bc) {
+    if(bc->itemsSize == 0)
+        return UA_STATUSCODE_BADNOTFOUND;
+    bc->storage = (UA_Byte*)calloc(bc->itemsSize, bc->maxMemSize);
+    if(!bc->storage)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    return UA_ByteString_allocBuffer(&bc->scratch, bc->maxEncoded);
+}
+
+static void
+setDataValue(UA_DataValue *dv, UA_Double d, UA_DateTime now) {
+    UA_Variant_setScalarCopy(&dv->value, &d, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv->hasValue = true;
+    dv->sourceTimestamp = now;
+    dv->hasSourceTimestamp = true;
+    dv->serverTimestamp = now;
+    dv->hasServerTimestamp = true;
+}
+
+/* ReadResponse with size DataValues */
+static UA_StatusCode
+buildReadResponse(BenchCase *bc) {
+    UA_ReadResponse *rr = UA_ReadResponse_new();
+    if(!rr)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_DateTime now = UA_DateTime_now();
+    rr->responseHeader.timestamp = now;
+    rr->responseHeader.requestHandle = 42;
+    rr->results = (UA_DataValue*)
+        UA_Array_new(size, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if(rr->results) {
+        rr->resultsSize = size;
+        for(size_t i = 0; i < size; i++)
+            setDataValue(&rr->results[i], (UA_Double)i * 0.5, now);
+    }
+    return BenchCase_addItem(bc, rr, &UA_TYPES[UA_TYPES_READRESPONSE], BATCH);
+}
+
+/* PublishResponse with a DataChangeNotification for size MonitoredItems */
+static UA_StatusCode
+buildPublishResponse(BenchCase *bc) {
+    UA_PublishResponse *pr = UA_PublishResponse_new();
+    UA_DataChangeNotification *dcn = UA_DataChangeNotification_new();
+    UA_ExtensionObject *eo = UA_ExtensionObject_new();
+    if(!pr || !dcn || !eo) {
+        UA_PublishResponse_delete(pr);
+        UA_DataChangeNotification_delete(dcn);
+        UA_ExtensionObject_delete(eo);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_NotificationMessage *nm = &pr->notificationMessage;
+    nm->notificationData = eo;
+    UA_DateTime now = UA_DateTime_now();
+    pr->responseHeader.timestamp = now;
+    pr->subscriptionId = 1;
+    pr->moreNotifications = false;
+    nm->sequenceNumber = 7;
+    nm->publishTime = now;
+    dcn->monitoredItems = (UA_MonitoredItemNotification*)
+        UA_Array_new(size, &UA_TYPES[UA_TYPES_MONITOREDITEMNOTIFICATION]);
+    if(dcn->monitoredItems) {
+        dcn->monitoredItemsSize = size;
+        for(size_t i = 0; i < size; i++) {
+            dcn->monitoredItems[i].clientHandle = (UA_UInt32)i;
+            setDataValue(&dcn->monitoredItems[i].value, (UA_Double)i, now);
+        }
+    }
+    nm->notificationDataSize = 1;
+    UA_ExtensionObject_setValue(nm->notificationData, dcn,
+                                &UA_TYPES[UA_TYPES_DATACHANGENOTIFICATION]);
+    return BenchCase_addItem(bc, pr, &UA_TYPES[UA_TYPES_PUBLISHRESPONSE], BATCH);
+}
+
+/* Variant with an array of size * 100 Doubles */
+static UA_StatusCode
+buildDoubleArray(BenchCase *bc) {
+    UA_Variant *v = UA_Variant_new();
+    size_t len = size * 100;
+    UA_Double *d = (UA_Double*)UA_Array_new(len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    if(!v || !d) {
+        UA_Variant_delete(v);
+        UA_free(d);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for(size_t i = 0; i < len; i++)
+        d[i] = (UA_Double)i;
+    UA_Variant_setArray(v, d, len, &UA_TYPES[UA_TYPES_DOUBLE]);
+    return BenchCase_addItem(bc, v, &UA_TYPES[UA_TYPES_VARIANT], BATCH);
+}
+
+/* Variant with an array of size * 10 short Strings */
+static UA_StatusCode
+buildStringArray(BenchCase *bc) {
+    UA_Variant *v = UA_Variant_new();
+    size_t len = size * 10;
+    UA_String *s = (UA_String*)UA_Array_new(len, &UA_TYPES[UA_TYPES_STRING]);
+    if(!v || !s) {
+        UA_Variant_delete(v);
+        UA_free(s);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    char buf[32];
+    for(size_t i = 0; i < len; i++) {
+        snprintf(buf, sizeof(buf), "element-%08lu", (unsigned long)i);
+        s[i] = UA_STRING_ALLOC(buf);
+    }
+    UA_Variant_setArray(v, s, len, &UA_TYPES[UA_TYPES_STRING]);
+    return BenchCase_addItem(bc, v, &UA_TYPES[UA_TYPES_VARIANT], BATCH);
+}
+
+/* CreateMonitoredItemsRequest with size items. Every item has an EventFilter
+ * in an ExtensionObject. Its where clause has operands in nested
+ * ExtensionObjects. */
+static UA_StatusCode
+buildEventFilter(BenchCase *bc) {
+    UA_EventFilter ef;
+    UA_EventFilter_init(&ef);
+    UA_SimpleAttributeOperand sao[3];
+    UA_QualifiedName names[3] = {UA_QUALIFIEDNAME(0, "Message"),
+                                 UA_QUALIFIEDNAME(0, "Severity"),
+                                 UA_QUALIFIEDNAME(0, "EventType")};
+    for(size_t i = 0; i < 3; i++) {
+        UA_SimpleAttributeOperand_init(&sao[i]);
+        sao[i].typeDefinitionId = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEEVENTTYPE);
+        sao[i].browsePathSize = 1;
+        sao[i].browsePath = &names[i];
+        sao[i].attributeId = UA_ATTRIBUTEID_VALUE;
+    }
+    ef.selectClausesSize = 3;
+    ef.selectClauses = sao;
+
+    /* Severity > 100 */
+    UA_ContentFilterElement cfe;
+    UA_ContentFilterElement_init(&cfe);
+    UA_ExtensionObject operands[2];
+    UA_LiteralOperand lo;
+    UA_LiteralOperand_init(&lo);
+    UA_UInt16 severity = 100;
+    UA_Variant_setScalar(&lo.value, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    cfe.filterOperator = UA_FILTEROPERATOR_GREATERTHAN;
+    UA_ExtensionObject_setValueNoDelete(&operands[0], &sao[1],
+                                        &UA_TYPES[UA_TYPES_SIMPLEATTRIBUTEOPERAND]);
+    UA_ExtensionObject_setValueNoDelete(&operands[1], &lo,
+                                        &UA_TYPES[UA_TYPES_LITERALOPERAND]);
+    cfe.filterOperandsSize = 2;
+    cfe.filterOperands = operands;
+    ef.whereClause.elementsSize = 1;
+    ef.whereClause.elements = &cfe;
+
+    UA_CreateMonitoredItemsRequest *req = UA_CreateMonitoredItemsRequest_new();
+    if(!req)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    req->subscriptionId = 1;
+    req->timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    req->itemsToCreate = (UA_MonitoredItemCreateRequest*)
+        UA_Array_new(size, &UA_TYPES[UA_TYPES_MONITOREDITEMCREATEREQUEST]);
+    if(req->itemsToCreate) {
+        req->itemsToCreateSize = size;
+        for(size_t i = 0; i < size; i++) {
+            UA_MonitoredItemCreateRequest *item = &req->itemsToCreate[i];
+            item->itemToMonitor.nodeId = UA_NODEID_NUMERIC(1, (UA_UInt32)(1000 + i));
+            item->itemToMonitor.attributeId = UA_ATTRIBUTEID_EVENTNOTIFIER;
+            item->monitoringMode = UA_MONITORINGMODE_REPORTING;
+            item->requestedParameters.clientHandle = (UA_UInt32)i;
+            item->requestedParameters.queueSize = 10;
+            UA_ExtensionObject_setValueCopy(&item->requestedParameters.filter, &ef,
+                                            &UA_TYPES[UA_TYPES_EVENTFILTER]);
+        }
+    }
+    return BenchCase_addItem(bc, req, &UA_TYPES[UA_TYPES_CREATEMONITOREDITEMSREQUEST],
+                             BATCH);
+}
+
+#ifndef _WIN32
+
+static const UA_DataType *
+findTypeByBinaryEncodingId(const UA_NodeId *id) {
+    for(size_t i = 0; i < UA_TYPES_COUNT; i++) {
+        if(UA_NodeId_equal(&UA_TYPES[i].binaryEncodingId, id))
+            return &UA_TYPES[i];
+    }
+    return NULL;
+}
+
+/* Decode the service requests from the MSG chunks of a file. The chunk header
+ * (message header, SecureChannel id, token id, sequence header) has 24 bytes.
+ * Then follows the NodeId of the request type. */
+static void
+addCorpusFile(BenchCase *bc, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(!f)
+        return;
+    UA_Byte buf[1 << 16];
+    size_t len = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+
+    size_t pos = 0;
+    while(pos + 24 <= len) {
+        UA_UInt32 chunkSize = (UA_UInt32)buf[pos + 4] |
+            ((UA_UInt32)buf[pos + 5] << 8) | ((UA_UInt32)buf[pos + 6] << 16) |
+            ((UA_UInt32)buf[pos + 7] << 24);
+        if(chunkSize < 24 || chunkSize > len - pos)
+            return;
+        if(memcmp(&buf[pos], "MSGF", 4) == 0) {
+            UA_ByteString body = {chunkSize - 24, &buf[pos + 24]};
+            UA_NodeId id;
+            size_t offset = 0;
+            UA_StatusCode res = UA_decodeBinary(&body, &id, &UA_TYPES[UA_TYPES_NODEID],
+                                                NULL);
+            if(res == UA_STATUSCODE_GOOD) {
+                const UA_DataType *type = findTypeByBinaryEncodingId(&id);
+                offset = UA_calcSizeBinary(&id, &UA_TYPES[UA_TYPES_NODEID]);
+                UA_NodeId_clear(&id);
+                void *value = (type) ? UA_new(type) : NULL;
+                UA_ByteString rest = {body.length - offset, body.data + offset};
+                if(value &&
+                   UA_decodeBinary(&rest, value, type, NULL) == UA_STATUSCODE_GOOD)
+                    BenchCase_addItem(bc, value, type, 1);
+                else if(value)
+                    UA_delete(value, type);
+            }
+        }
+        pos += chunkSize;
+    }
+}
+
+static UA_StatusCode
+buildCorpus(BenchCase *bc) {
+    DIR *dir = opendir(corpusDir);
+    if(!dir)
+        return UA_STATUSCODE_BADNOTFOUND;
+    char path[4096];
+    struct dirent *de;
+    while((de = readdir(dir))) {
+        if(de->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", corpusDir, de->d_name);
+        addCorpusFile(bc, path);
+    }
+    closedir(dir);
+    return UA_STATUSCODE_GOOD;
+}
+
+#endif
+
+/**************/
+/* Operations */
+/**************/
+
+static void *
+slot(BenchCase *bc, size_t i) {
+    return bc->storage + (i * bc->maxMemSize);
+}
+
+static UA_Arena arena;
+
+static UA_StatusCode
+runCalcSize(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        if(UA_calcSizeBinary(bc->items[i].value, bc->items[i].type) == 0)
+            return UA_STATUSCODE_BADENCODINGERROR;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runEncode(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        UA_ByteString out = bc->scratch;
+        UA_StatusCode res = UA_encodeBinary(bc->items[i].value, bc->items[i].type, &out);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runDecode(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        UA_StatusCode res = UA_decodeBinary(&bc->items[i].encoded, slot(bc, i),
+                                            bc->items[i].type, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runDecodeArena(BenchCase *bc) {
+    UA_DecodeBinaryOptions opts;
+    memset(&opts, 0, sizeof(UA_DecodeBinaryOptions));
+    opts.arena = &arena;
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        UA_StatusCode res = UA_decodeBinary(&bc->items[i].encoded, slot(bc, i),
+                                            bc->items[i].type, &opts);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runCopy(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++) {
+        UA_StatusCode res = UA_copy(bc->items[i].value, slot(bc, i),
+                                    bc->items[i].type);
+        if(res != UA_STATUSCODE_GOOD)
+            return res;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode
+runClear(BenchCase *bc) {
+    for(size_t i = 0; i < bc->itemsSize; i++)
+        UA_clear(slot(bc, i), bc->items[i].type);
+    return UA_STATUSCODE_GOOD;
+}
+
+static void
+clearArena(BenchCase *bc) {
+    UA_Arena_clear(&arena);
+}
+
+/* The prepare and cleanup steps are not measured */
+typedef struct {
+    const char *name;
+    UA_StatusCode (*prepare)(BenchCase *bc);
+    UA_StatusCode (*run)(BenchCase *bc);
+    void (*cleanup)(BenchCase *bc);
+} BenchOp;
+
+static void
+cleanupClear(BenchCase *bc) {
+    runClear(bc);
+}
+
+static const BenchOp benchOps[] = {
+    {"calcSize", NULL, runCalcSize, NULL},
+    {"encode", NULL, runEncode, NULL},
+    {"decode", NULL, runDecode, cleanupClear},
+    {"decodeArena", NULL, runDecodeArena, clearArena},
+    {"copy", NULL, runCopy, cleanupClear},
+    {"clear", runCopy, runClear, NULL}
+};
+
+static int
+measure(BenchCase *bc, const BenchOp *op) {
+    UA_DateTime elapsed = 0;
+    UA_DateTime target = (UA_DateTime)(duration * UA_DATETIME_SEC);
+    size_t passes = 0;
+    do {
+        if(op->prepare && op->prepare(bc) != UA_STATUSCODE_GOOD)
+            return -1;
+        UA_DateTime start = UA_DateTime_nowMonotonic();
+        UA_StatusCode res = op->run(bc);
+        elapsed += UA_DateTime_nowMonotonic() - start;
+        if(op->cleanup)
+            op->cleanup(bc);
+        if(res != UA_STATUSCODE_GOOD) {
+            printf("{\"case\":\"%s\",\"op\":\"%s\",\"error\":\"%s\"}\n",
+                   bc->name, op->name, UA_StatusCode_name(res));
+            return -1;
+        }
+        passes++;
+    } while(elapsed < target);
+
+    UA_Double seconds = (UA_Double)elapsed / UA_DATETIME_SEC;
+    size_t ops = passes * bc->itemsSize;
+    printf("{\"case\":\"%s\",\"op\":\"%s\",\"size\":%lu,\"items\":%lu,"
+           "\"bytesPerItem\":%lu,\"ops\":%lu,\"nsPerOp\":%.1f,\"mbPerSec\":%.1f}\n",
+           bc->name, op->name, (unsigned long)size, (unsigned long)bc->itemsSize,
+           (unsigned long)(bc->bytes / bc->itemsSize), (unsigned long)ops,
+           seconds * 1e9 / (UA_Double)ops,
+           (UA_Double)(passes * bc->bytes) / seconds / (1024.0 * 1024.0));
+    return 0;
+}
+
+typedef struct {
+    const char *name;
+    UA_StatusCode (*build)(BenchCase *bc);
+} BenchCaseDef;
+
+static const BenchCaseDef benchCases[] = {
+    {"readresponse", buildReadResponse},
+    {"publishresponse", buildPublishResponse},
+    {"doublearray", buildDoubleArray},
+    {"stringarray", buildStringArray},
+    {"eventfilter", buildEventFilter},
+#ifndef _WIN32
+    {"corpus", buildCorpus}
+#endif
+};
+
+static int
+parseSize(const char *arg, size_t *out) {
+    long v = atol(arg);
+    if(v <= 0)
+        return -1;
+    *out = (size_t)v;
+    return 0;
+}
+
+int
+main(int argc, char **argv) {
+    /* Process the options */
+    for(int argpos = 1; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(argpos + 1 == argc) {
+            usage();
+            return -1;
+        }
+        const char *opt = argv[argpos];
+        const char *arg = argv[++argpos];
+        int ret = 0;
+        if(strcmp(opt, "--size") == 0)
+            ret = parseSize(arg, &size);
+        else if(strcmp(opt, "--duration") == 0)
+            ret = ((duration = atof(arg)) > 0.0) ? 0 : -1;
+        else if(strcmp(opt, "--case") == 0)
+            caseFilter = arg;
+#ifndef _WIN32
+        else if(strcmp(opt, "--corpus") == 0)
+            corpusDir = arg;
+#endif
+        else
+            ret = -1;
+        if(ret != 0) {
+            usage();
+            return -1;
+        }
+    }
+
+    int ret = 0;
+    for(size_t i = 0; i < sizeof(benchCases) / sizeof(BenchCaseDef); i++) {
+        const BenchCaseDef *def = &benchCases[i];
+        if(caseFilter && strcmp(caseFilter, def->name) != 0)
+            continue;
+        if(strcmp(def->name, "corpus") == 0 && !corpusDir)
+            continue;
+        BenchCase bc;
+        memset(&bc, 0, sizeof(BenchCase));
+        bc.name = def->name;
+        UA_StatusCode res = def->build(&bc);
+        if(res == UA_STATUSCODE_GOOD)
+            res = BenchCase_finish(&bc);
+        if(res != UA_STATUSCODE_GOOD) {
+            printf("{\"case\":\"%s\",\"error\":\"%s\"}\n",
+                   def->name, UA_StatusCode_name(res));
+            BenchCase_clear(&bc);
+            ret = -1;
+            continue;
+        }
+        for(size_t j = 0; j < sizeof(benchOps) / sizeof(BenchOp); j++) {
+            if(measure(&bc, &benchOps[j]) != 0)
+                ret = -1;
+        }
+        BenchCase_clear(&bc);
+    }
+    UA_Arena_clear(&arena);
+    return ret;
+}
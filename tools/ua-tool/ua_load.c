@@ -0,0 +1,838 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Enable POSIX features */
+#if !defined(_XOPEN_SOURCE)
+# define _XOPEN_SOURCE 600
+#endif
+#ifndef _DEFAULT_SOURCE
+# define _DEFAULT_SOURCE
+#endif
+/* On older systems we need to define _BSD_SOURCE.
+ * _DEFAULT_SOURCE is an alias for that. */
+#ifndef _BSD_SOURCE
+# define _BSD_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <open62541/client.h>
+#include <open62541/client_config_default.h>
+#include <open62541/client_pool.h>
+#include <open62541/client_subscriptions.h>
+#include <open62541/server.h>
+#include <open62541/server_config_default.h>
+
+#ifndef _WIN32
+# include <errno.h>
+# include <fcntl.h>
+# include <signal.h>
+# include <time.h>
+# include <unistd.h>
+# include <sys/resource.h>
+# include <sys/wait.h>
+#endif
+
+/* Load generator with many virtual clients. The clients of a process share
+ * one EventLoop (see the client pool). Every client has a role: It polls a
+ * value with Read requests, browses back-to-back ("browse storm") or receives
+ * data change notifications from a subscription. Reconnect waves close and
+ * reopen the Session of a part of the clients.
+ *
+ * With "inproc" as the url, the server is started in the main process. With
+ * several processes, the clients run in forked processes and the main process
+ * only runs the server. For a remote server (e.g. examples/ci_server.c), the
+ * server CPU time is taken from /proc/<pid>/stat if --server-pid is set.
+ *
+ * The result is printed as JSON. The latency percentiles are upper bounds from
+ * logarithmic histograms. */
+
+#define INPROC_URL "opc.tcp://localhost:4840"
+
+static UA_Server *server = NULL;
+static const char *url = NULL;
+
+/* Options */
+static size_t clients = 100;       /* Virtual clients per process */
+static size_t processes = 1;
+static size_t readWeight = 70;
+static size_t browseWeight = 20;
+static size_t subscribeWeight = 10;
+static size_t items = 10;          /* MonitoredItems per subscription */
+static UA_Double interval = 100.0; /* Read polling and publishing interval (ms) */
+static UA_Double duration = 10.0;  /* Seconds */
+static UA_Double reconnect = 0.0;  /* Seconds between reconnect waves */
+static UA_Double wave = 0.1;       /* Share of the clients per wave */
+static long serverPid = 0;
+
+static void
+usage(void) {
+    printf("Usage: ua_load <server-url | inproc> [options]\n"
+           " <server-url>: opc.tcp://domain[:port]\n"
+           " inproc: Start a server in the main process on port 4840\n"
+           " --clients <n>: Virtual clients per process [default: 100]\n"
+#ifndef _WIN32
+           " --processes <n>: Client processes [default: 1]\n"
+#endif
+           " --read <w>: Weight of the clients polling with Read [default: 70]\n"
+           " --browse <w>: Weight of the clients browsing back-to-back [default: 20]\n"
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+           " --subscribe <w>: Weight of the clients with a subscription [default: 10]\n"
+           " --items <n>: MonitoredItems per subscription [default: 10]\n"
+#endif
+           " --interval <ms>: Read polling and publishing interval [default: 100]\n"
+           " --duration <s>: Duration of the load [default: 10]\n"
+           " --reconnect <s>: Time between reconnect waves [default: 0 (off)]\n"
+           " --wave <share>: Share of the clients per reconnect wave [default: 0.1]\n"
+#ifdef __linux__
+           " --server-pid <pid>: Measure the CPU time of a remote server\n"
+#endif
+           " --help: Print this message\n");
+}
+
+/**************/
+/* Accounting */
+/**************/
+
+enum {
+    OP_READ = 0,
+    OP_BROWSE,
+    OP_NOTIFICATION,
+    OP_CONNECT,
+    OP_COUNT
+};
+
+static const char *opNames[OP_COUNT] = {"read", "browse", "notification", "connect"};
+
+/* Bucket i counts the latencies d (in 100ns) with 2^i <= d < 2^(i+1) */
+#define LATENCY_BUCKETS 40
+
+typedef struct {
+    UA_UInt64 count;
+    UA_UInt64 errors;
+    UA_UInt64 buckets[LATENCY_BUCKETS];
+} OpStats;
+
+/* Sent from the client processes to the main process */
+typedef struct {
+    OpStats ops[OP_COUNT];
+    UA_UInt64 sessions;       /* Activated at the end */
+    UA_UInt64 monitoredItems; /* Created at the end */
+} LoadResults;
+
+static LoadResults results;
+
+static void
+recordOp(size_t op, UA_DateTime latency) {
+    OpStats *s = &results.ops[op];
+    s->count++;
+    size_t bucket = 0;
+    UA_UInt64 d = (latency > 0) ? (UA_UInt64)latency : 0;
+    while(bucket < LATENCY_BUCKETS - 1 && (d >> (bucket + 1)) > 0)
+        bucket++;
+    s->buckets[bucket]++;
+}
+
+/* Upper bound in microseconds */
+static UA_Double
+quantile(const OpStats *s, UA_Double q) {
+    UA_UInt64 total = 0;
+    for(size_t i = 0; i < LATENCY_BUCKETS; i++)
+        total += s->buckets[i];
+    if(total == 0)
+        return 0.0;
+    UA_UInt64 rank = (UA_UInt64)(q * (UA_Double)total + 0.5);
+    if(rank == 0)
+        rank = 1;
+    UA_UInt64 seen = 0;
+    size_t i = 0;
+    for(; i < LATENCY_BUCKETS - 1; i++) {
+        seen += s->buckets[i];
+        if(seen >= rank)
+            break;
+    }
+    return (UA_Double)((UA_UInt64)2 << i) / UA_DATETIME_USEC;
+}
+
+static void
+mergeResults(LoadResults *dst, const LoadResults *src) {
+    for(size_t op = 0; op < OP_COUNT; op++) {
+        dst->ops[op].count += src->ops[op].count;
+        dst->ops[op].errors += src->ops[op].errors;
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++)
+            dst->ops[op].buckets[i] += src->ops[op].buckets[i];
+    }
+    dst->sessions += src->sessions;
+    dst->monitoredItems += src->monitoredItems;
+}
+
+/* Negative if the CPU time is unknown */
+static UA_DateTime serverCpu = -1;
+
+static void
+printResults(UA_DateTime elapsed) {
+    UA_Double seconds = (UA_Double)elapsed / UA_DATETIME_SEC;
+    UA_UInt64 total = 0;
+    for(size_t op = 0; op < OP_COUNT; op++)
+        total += results.ops[op].count;
+    printf("{\"server\":\"%s\",\"clients\":%lu,\"processes\":%lu,"
+           "\"durationS\":%.3f,\"sessions\":%lu,\"monitoredItems\":%lu",
+           server ? "inproc" : url, (unsigned long)(clients * processes),
+           (unsigned long)processes, seconds, (unsigned long)results.sessions,
+           (unsigned long)results.monitoredItems);
+    if(serverCpu >= 0) {
+        printf(",\"serverCpuS\":%.3f,\"serverCpuUsPerOp\":%.2f",
+               (UA_Double)serverCpu / UA_DATETIME_SEC,
+               (total > 0) ? (UA_Double)serverCpu / UA_DATETIME_USEC /
+               (UA_Double)total : 0.0);
+    }
+    printf(",\"ops\":{");
+    for(size_t op = 0; op < OP_COUNT; op++) {
+        const OpStats *s = &results.ops[op];
+        printf("%s\"%s\":{\"count\":%lu,\"errors\":%lu,\"throughput\":%.1f,"
+               "\"p50Us\":%.1f,\"p99Us\":%.1f}", (op > 0) ? "," : "",
+               opNames[op], (unsigned long)s->count, (unsigned long)s->errors,
+               (seconds > 0.0) ? (UA_Double)s->count / seconds : 0.0,
+               quantile(s, 0.5), quantile(s, 0.99));
+    }
+    printf("}}\n");
+}
+
+/**********************/
+/* Server CPU Time    */
+/**********************/
+
+#ifndef _WIN32
+static UA_DateTime
+threadCpuTime(void) {
+    struct timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return (UA_DateTime)ts.tv_sec * UA_DATETIME_SEC +
+        (UA_DateTime)ts.tv_nsec / 100;
+}
+#endif
+
+/* The CPU time of the remote server process. Negative if unknown. */
+static UA_DateTime
+remoteCpuTime(void) {
+#ifdef __linux__
+    if(serverPid <= 0)
+        return -1;
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%ld/stat", serverPid);
+    FILE *f = fopen(path, "r");
+    if(!f)
+        return -1;
+    char buf[1024];
+    size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[len] = 0;
+    /* The process name can contain spaces. Start after its closing bracket. */
+    const char *pos = strrchr(buf, ')');
+    unsigned long utime, stime;
+    if(!pos || sscanf(pos + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                      &utime, &stime) != 2)
+        return -1;
+    long ticks = sysconf(_SC_CLK_TCK);
+    if(ticks <= 0)
+        return -1;
+    return (UA_DateTime)(utime + stime) * UA_DATETIME_SEC / ticks;
+#else
+    return -1;
+#endif
+}
+
+/* Iterate the in-process server and account its CPU time */
+static void
+iterateServer(void) {
+#ifndef _WIN32
+    UA_DateTime before = threadCpuTime();
+    UA_Server_run_iterate(server, false);
+    serverCpu += threadCpuTime() - before;
+#else
+    UA_Server_run_iterate(server, false);
+#endif
+}
+
+/*******************/
+/* Virtual Clients */
+/*******************/
+
+typedef enum {
+    ROLE_READ,
+    ROLE_BROWSE,
+    ROLE_SUBSCRIBE
+} Role;
+
+typedef struct {
+    UA_Client *client;
+    Role role;
+    UA_Boolean active;          /* Session activated */
+    UA_Boolean pending;         /* Request in flight */
+    UA_Boolean reconnecting;    /* Waiting for the close to reconnect */
+    UA_DateTime connectStarted; /* Nonzero while connecting */
+    UA_DateTime requestStarted;
+    UA_DateTime nextRequest;
+    size_t monitoredItems;
+} VirtualClient;
+
+static UA_ClientPool *pool = NULL;
+static VirtualClient *vcs = NULL;
+
+static void
+connectClient(VirtualClient *vc) {
+    vc->connectStarted = UA_DateTime_nowMonotonic();
+    vc->active = false;
+    vc->pending = false;
+    vc->monitoredItems = 0;
+    if(UA_Client_connectAsync(vc->client, url) != UA_STATUSCODE_GOOD) {
+        results.ops[OP_CONNECT].errors++;
+        vc->connectStarted = 0;
+        vc->reconnecting = true; /* Try again once closed */
+    }
+}
+
+static void
+disconnectClient(VirtualClient *vc) {
+    results.monitoredItems -= vc->monitoredItems;
+    if(vc->active)
+        results.sessions--;
+    vc->monitoredItems = 0;
+    vc->active = false;
+    vc->connectStarted = 0;
+    vc->reconnecting = true;
+    UA_Client_disconnectAsync(vc->client);
+}
+
+static void
+serviceCallback(UA_Client *client, void *userdata,
+                UA_UInt32 requestId, void *response) {
+    VirtualClient *vc = (VirtualClient*)userdata;
+    vc->pending = false;
+    if(vc->reconnecting)
+        return; /* Aborted by the reconnect */
+    size_t op = (vc->role == ROLE_READ) ? OP_READ : OP_BROWSE;
+    /* The ResponseHeader is the first member of every response */
+    const UA_ResponseHeader *rh = (const UA_ResponseHeader*)response;
+    if(rh->serviceResult != UA_STATUSCODE_GOOD) {
+        results.ops[op].errors++;
+        return;
+    }
+    recordOp(op, UA_DateTime_nowMonotonic() - vc->requestStarted);
+}
+
+static UA_ReadValueId readValueId;
+static UA_BrowseDescription browseDescription;
+
+static void
+sendRequest(VirtualClient *vc, UA_DateTime now) {
+    UA_StatusCode res;
+    if(vc->role == ROLE_READ) {
+        if(now < vc->nextRequest)
+            return;
+        vc->nextRequest += (UA_DateTime)(interval * UA_DATETIME_MSEC);
+        if(vc->nextRequest < now)
+            vc->nextRequest = now; /* Fell behind */
+        UA_ReadRequest req;
+        UA_ReadRequest_init(&req);
+        req.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+        req.nodesToRead = &readValueId;
+        req.nodesToReadSize = 1;
+        res = __UA_Client_AsyncService(vc->client, &req, &UA_TYPES[UA_TYPES_READREQUEST],
+                                       serviceCallback, &UA_TYPES[UA_TYPES_READRESPONSE],
+                                       vc, NULL);
+    } else {
+        UA_BrowseRequest req;
+        UA_BrowseRequest_init(&req);
+        req.nodesToBrowse = &browseDescription;
+        req.nodesToBrowseSize = 1;
+        res = __UA_Client_AsyncService(vc->client, &req, &UA_TYPES[UA_TYPES_BROWSEREQUEST],
+                                       serviceCallback, &UA_TYPES[UA_TYPES_BROWSERESPONSE],
+                                       vc, NULL);
+    }
+    if(res != UA_STATUSCODE_GOOD) {
+        results.ops[(vc->role == ROLE_READ) ? OP_READ : OP_BROWSE].errors++;
+        return;
+    }
+    vc->pending = true;
+    vc->requestStarted = now;
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+
+/* The latency is measured from the source timestamp. Only meaningful if the
+ * clocks of the client and the server are synchronized. */
+static void
+dataChangeCallback(UA_Client *client, UA_UInt32 subId, void *subContext,
+                   UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    if(value->hasSourceTimestamp)
+        recordOp(OP_NOTIFICATION, UA_DateTime_now() - value->sourceTimestamp);
+    else
+        recordOp(OP_NOTIFICATION, 0);
+}
+
+static void
+createItemsCallback(UA_Client *client, void *userdata,
+                    UA_UInt32 requestId, void *response) {
+    VirtualClient *vc = (VirtualClient*)userdata;
+    UA_CreateMonitoredItemsResponse *r = (UA_CreateMonitoredItemsResponse*)response;
+    if(vc->reconnecting)
+        return;
+    for(size_t i = 0; i < r->resultsSize; i++) {
+        if(r->results[i].statusCode == UA_STATUSCODE_GOOD)
+            vc->monitoredItems++;
+        else
+            results.ops[OP_NOTIFICATION].errors++;
+    }
+    results.monitoredItems += vc->monitoredItems;
+}
+
+static void
+createSubscriptionCallback(UA_Client *client, void *userdata,
+                           UA_UInt32 requestId, void *response) {
+    VirtualClient *vc = (VirtualClient*)userdata;
+    UA_CreateSubscriptionResponse *r = (UA_CreateSubscriptionResponse*)response;
+    if(vc->reconnecting)
+        return;
+    if(r->responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        results.ops[OP_NOTIFICATION].errors++;
+        return;
+    }
+
+    UA_MonitoredItemCreateRequest *mireqs = (UA_MonitoredItemCreateRequest*)
+        calloc(items, sizeof(UA_MonitoredItemCreateRequest));
+    UA_Client_DataChangeNotificationCallback *callbacks =
+        (UA_Client_DataChangeNotificationCallback*)
+        calloc(items, sizeof(UA_Client_DataChangeNotificationCallback));
+    void **contexts = (void**)calloc(items, sizeof(void*));
+    UA_Client_DeleteMonitoredItemCallback *deleteCallbacks =
+        (UA_Client_DeleteMonitoredItemCallback*)
+        calloc(items, sizeof(UA_Client_DeleteMonitoredItemCallback));
+    if(mireqs && callbacks && contexts && deleteCallbacks) {
+        for(size_t i = 0; i < items; i++) {
+            mireqs[i] = UA_MonitoredItemCreateRequest_default(
+                UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME));
+            mireqs[i].requestedParameters.samplingInterval = interval;
+            callbacks[i] = dataChangeCallback;
+        }
+        UA_CreateMonitoredItemsRequest mreq;
+        UA_CreateMonitoredItemsRequest_init(&mreq);
+        mreq.subscriptionId = r->subscriptionId;
+        mreq.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+        mreq.itemsToCreate = mireqs;
+        mreq.itemsToCreateSize = items;
+        UA_StatusCode res =
+            UA_Client_MonitoredItems_createDataChanges_async(client, mreq, contexts,
+                                                             callbacks, deleteCallbacks,
+                                                             createItemsCallback,
+                                                             vc, NULL);
+        if(res != UA_STATUSCODE_GOOD)
+            results.ops[OP_NOTIFICATION].errors++;
+    }
+    free(mireqs);
+    free(callbacks);
+    free(contexts);
+    free(deleteCallbacks);
+}
+
+static void
+subscribe(VirtualClient *vc) {
+    UA_CreateSubscriptionRequest sreq = UA_CreateSubscriptionRequest_default();
+    sreq.requestedPublishingInterval = interval;
+    UA_StatusCode res =
+        UA_Client_Subscriptions_create_async(vc->client, sreq, vc, NULL, NULL,
+                                             createSubscriptionCallback, vc, NULL);
+    if(res != UA_STATUSCODE_GOOD)
+        results.ops[OP_NOTIFICATION].errors++;
+}
+
+#endif
+
+/* Advance the state of the virtual client */
+static void
+stepClient(VirtualClient *vc, UA_DateTime now) {
+    UA_SecureChannelState cs;
+    UA_SessionState ss;
+    UA_StatusCode status;
+    UA_Client_getState(vc->client, &cs, &ss, &status);
+
+    if(vc->reconnecting) {
+        if(cs == UA_SECURECHANNELSTATE_CLOSED) {
+            vc->reconnecting = false;
+            connectClient(vc);
+        }
+        return;
+    }
+
+    if(status != UA_STATUSCODE_GOOD) {
+        /* Connection lost or the connect failed. Start over. */
+        results.ops[OP_CONNECT].errors++;
+        disconnectClient(vc);
+        return;
+    }
+
+    if(vc->connectStarted != 0) {
+        if(ss != UA_SESSIONSTATE_ACTIVATED)
+            return;
+        recordOp(OP_CONNECT, now - vc->connectStarted);
+        vc->connectStarted = 0;
+        vc->active = true;
+        vc->nextRequest = now;
+        results.sessions++;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        if(vc->role == ROLE_SUBSCRIBE)
+            subscribe(vc);
+#endif
+    }
+
+    if(vc->active && !vc->pending && vc->role != ROLE_SUBSCRIBE)
+        sendRequest(vc, now);
+}
+
+static UA_StatusCode
+createClients(void) {
+    UA_ClientConfig cc;
+    memset(&cc, 0, sizeof(UA_ClientConfig));
+    UA_StatusCode res = UA_ClientConfig_setDefault(&cc);
+    if(res != UA_STATUSCODE_GOOD)
+        return res;
+    cc.logging->context = (void*)(uintptr_t)UA_LOGLEVEL_WARNING;
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    cc.outStandingPublishRequests = 2;
+#endif
+    pool = UA_ClientPool_new(&cc, clients);
+    if(!pool) {
+        UA_ClientConfig_clear(&cc);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    vcs = (VirtualClient*)calloc(clients, sizeof(VirtualClient));
+    if(!vcs)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+
+    /* Assign the roles round-robin according to the weights */
+    size_t weights = readWeight + browseWeight + subscribeWeight;
+    for(size_t i = 0; i < clients; i++) {
+        vcs[i].client = UA_ClientPool_getClient(pool, i);
+        size_t r = (i * 7919) % weights; /* Spread the roles */
+        if(r < readWeight)
+            vcs[i].role = ROLE_READ;
+        else if(r < readWeight + browseWeight)
+            vcs[i].role = ROLE_BROWSE;
+        else
+            vcs[i].role = ROLE_SUBSCRIBE;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/* The synchronous disconnect waits for the CloseSession response. That would
+ * block the in-process server. */
+static void
+deleteClients(void) {
+    if(vcs) {
+        for(size_t i = 0; i < clients; i++)
+            UA_Client_disconnectAsync(vcs[i].client);
+        UA_Boolean closed = false;
+        while(!closed) {
+            closed = true;
+            for(size_t i = 0; i < clients; i++) {
+                UA_SecureChannelState cs;
+                UA_Client_getState(vcs[i].client, &cs, NULL, NULL);
+                if(cs != UA_SECURECHANNELSTATE_CLOSED)
+                    closed = false;
+            }
+            if(!closed) {
+                if(server)
+                    iterateServer();
+                UA_ClientPool_run_iterate(pool, server ? 0 : 10);
+            }
+        }
+    }
+    UA_ClientPool_delete(pool);
+    pool = NULL;
+    free(vcs);
+    vcs = NULL;
+}
+
+/* Run the virtual clients of this process for the duration. With an
+ * in-process server, the server is iterated in turns with the clients. */
+static int
+runClients(void) {
+    UA_StatusCode res = createClients();
+    if(res != UA_STATUSCODE_GOOD) {
+        printf("Could not create the clients: %s\n", UA_StatusCode_name(res));
+        deleteClients();
+        return -1;
+    }
+
+    UA_ReadValueId_init(&readValueId);
+    readValueId.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER_SERVERSTATUS_CURRENTTIME);
+    readValueId.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_BrowseDescription_init(&browseDescription);
+    browseDescription.nodeId = UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    browseDescription.browseDirection = UA_BROWSEDIRECTION_BOTH;
+    browseDescription.includeSubtypes = true;
+    browseDescription.resultMask = UA_BROWSERESULTMASK_ALL;
+
+    for(size_t i = 0; i < clients; i++)
+        connectClient(&vcs[i]);
+
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+    UA_DateTime end = start + (UA_DateTime)(duration * UA_DATETIME_SEC);
+    UA_DateTime waveInterval = (UA_DateTime)(reconnect * UA_DATETIME_SEC);
+    UA_DateTime nextWave = start + waveInterval;
+    size_t waveSize = (size_t)(wave * (UA_Double)clients);
+    size_t waveOffset = 0;
+    UA_DateTime now = start;
+    while(now < end) {
+        if(server)
+            iterateServer();
+        UA_ClientPool_run_iterate(pool, server ? 0 : 1);
+        now = UA_DateTime_nowMonotonic();
+        for(size_t i = 0; i < clients; i++)
+            stepClient(&vcs[i], now);
+
+        /* Reconnect wave of the next clients in turn */
+        if(waveInterval > 0 && now >= nextWave) {
+            for(size_t i = 0; i < waveSize; i++) {
+                VirtualClient *vc = &vcs[(waveOffset + i) % clients];
+                if(vc->active)
+                    disconnectClient(vc);
+            }
+            waveOffset = (waveOffset + waveSize) % clients;
+            nextWave += waveInterval;
+        }
+    }
+
+    deleteClients();
+    return 0;
+}
+
+/********/
+/* Main */
+/********/
+
+static UA_StatusCode
+startServer(void) {
+    server = UA_Server_new();
+    if(!server)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_ServerConfig *sc = UA_Server_getConfig(server);
+    sc->logging->context = (void*)(uintptr_t)UA_LOGLEVEL_WARNING;
+    sc->tcpReuseAddr = true;
+    /* Room for all clients with a margin for the reconnecting ones */
+    size_t maxClients = clients * processes * 2 + 10;
+    if(maxClients > 60000)
+        maxClients = 60000;
+    if(sc->maxSessions < maxClients)
+        sc->maxSessions = (UA_UInt16)maxClients;
+    if(sc->maxSecureChannels <= sc->maxSessions)
+        sc->maxSecureChannels = (UA_UInt16)(sc->maxSessions + 1);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+    sc->publishingIntervalLimits.min = 1.0;
+    sc->samplingIntervalLimits.min = 1.0;
+    if(sc->maxSubscriptions < maxClients)
+        sc->maxSubscriptions = maxClients;
+#endif
+    serverCpu = 0;
+    return UA_Server_run_startup(server);
+}
+
+/* Every virtual client needs a socket (two with the in-process server) */
+static void
+raiseFileLimit(void) {
+#ifndef _WIN32
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+#endif
+}
+
+#ifndef _WIN32
+
+/* Fork the client processes. The main process runs the in-process server (or
+ * waits) until all children have reported their results. */
+static int
+runProcesses(void) {
+    int fds[2];
+    if(pipe(fds) != 0)
+        return -1;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fflush(stdout);
+    size_t started = 0;
+    for(; started < processes; started++) {
+        pid_t pid = fork();
+        if(pid < 0)
+            break;
+        if(pid == 0) {
+            close(fds[0]);
+            server = NULL; /* The server belongs to the main process */
+            int ret = runClients();
+            /* Smaller than PIPE_BUF, so the write is atomic */
+            ssize_t written = write(fds[1], &results, sizeof(LoadResults));
+            _exit((ret == 0 && written == (ssize_t)sizeof(LoadResults)) ? 0 : 1);
+        }
+    }
+    close(fds[1]);
+
+    int ret = (started == processes) ? 0 : -1;
+    size_t received = 0;
+    size_t exited = 0;
+    LoadResults childResults;
+    UA_Byte *buf = (UA_Byte*)&childResults;
+    size_t bufPos = 0;
+    while(exited < started || received < exited) {
+        if(server) {
+            iterateServer();
+        } else {
+            struct timespec ts = {0, 10 * 1000 * 1000};
+            nanosleep(&ts, NULL);
+        }
+
+        /* Collect the results */
+        ssize_t n = read(fds[0], buf + bufPos, sizeof(LoadResults) - bufPos);
+        if(n > 0) {
+            bufPos += (size_t)n;
+            if(bufPos == sizeof(LoadResults)) {
+                mergeResults(&results, &childResults);
+                bufPos = 0;
+                received++;
+            }
+        } else if(n == 0 && exited == started) {
+            break; /* All write ends are closed */
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if(pid > 0) {
+            exited++;
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                ret = -1;
+        }
+    }
+    close(fds[0]);
+    if(received < started)
+        ret = -1;
+    return ret;
+}
+
+#endif
+
+static int
+parseSize(const char *arg, size_t *out) {
+    long v = atol(arg);
+    if(v < 0)
+        return -1;
+    *out = (size_t)v;
+    return 0;
+}
+
+int
+main(int argc, char **argv) {
+    if(argc < 2) {
+        usage();
+        return 0;
+    }
+    url = argv[1];
+
+    /* Process the options */
+    for(int argpos = 2; argpos < argc; argpos++) {
+        if(strcmp(argv[argpos], "--help") == 0) {
+            usage();
+            return 0;
+        }
+        if(argpos + 1 == argc) {
+            usage();
+            return -1;
+        }
+        const char *opt = argv[argpos];
+        const char *arg = argv[++argpos];
+        int ret = 0;
+        if(strcmp(opt, "--clients") == 0)
+            ret = parseSize(arg, &clients);
+#ifndef _WIN32
+        else if(strcmp(opt, "--processes") == 0)
+            ret = parseSize(arg, &processes);
+#endif
+        else if(strcmp(opt, "--read") == 0)
+            ret = parseSize(arg, &readWeight);
+        else if(strcmp(opt, "--browse") == 0)
+            ret = parseSize(arg, &browseWeight);
+#ifdef UA_ENABLE_SUBSCRIPTIONS
+        else if(strcmp(opt, "--subscribe") == 0)
+            ret = parseSize(arg, &subscribeWeight);
+        else if(strcmp(opt, "--items") == 0)
+            ret = parseSize(arg, &items);
+#endif
+        else if(strcmp(opt, "--interval") == 0)
+            ret = ((interval = atof(arg)) > 0.0) ? 0 : -1;
+        else if(strcmp(opt, "--duration") == 0)
+            ret = ((duration = atof(arg)) > 0.0) ? 0 : -1;
+        else if(strcmp(opt, "--reconnect") == 0)
+            ret = ((reconnect = atof(arg)) >= 0.0) ? 0 : -1;
+        else if(strcmp(opt, "--wave") == 0)
+            ret = ((wave = atof(arg)) >= 0.0 && wave <= 1.0) ? 0 : -1;
+#ifdef __linux__
+        else if(strcmp(opt, "--server-pid") == 0)
+            ret = ((serverPid = atol(arg)) > 0) ? 0 : -1;
+#endif
+        else
+            ret = -1;
+        if(ret != 0) {
+            usage();
+            return -1;
+        }
+    }
+#ifndef UA_ENABLE_SUBSCRIPTIONS
+    subscribeWeight = 0;
+#endif
+    if(clients == 0 || processes == 0 ||
+       readWeight + browseWeight + subscribeWeight == 0) {
+        usage();
+        return -1;
+    }
+
+    raiseFileLimit();
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    int ret = -1;
+    if(strcmp(url, "inproc") == 0) {
+        url = INPROC_URL;
+        UA_StatusCode res = startServer();
+        if(res != UA_STATUSCODE_GOOD) {
+            printf("Could not start the server: %s\n", UA_StatusCode_name(res));
+            goto cleanup;
+        }
+    } else {
+        serverCpu = remoteCpuTime();
+    }
+
+    UA_DateTime start = UA_DateTime_nowMonotonic();
+#ifndef _WIN32
+    if(processes > 1)
+        ret = runProcesses();
+    else
+#endif
+        ret = runClients();
+    UA_DateTime elapsed = UA_DateTime_nowMonotonic() - start;
+
+    if(!server && serverCpu >= 0) {
+        UA_DateTime after = remoteCpuTime();
+        serverCpu = (after >= 0) ? after - serverCpu : -1;
+    }
+    printResults(elapsed);
+
+ cleanup:
+    if(server) {
+        UA_Server_run_shutdown(server);
+        UA_Server_delete(server);
+    }
+    return ret;
+}